@@ -814,16 +814,6 @@ ULONG WINAPI TraceEvent( TRACEHANDLE SessionHandle, PEVENT_TRACE_HEADER EventTra
     return ERROR_CALL_NOT_IMPLEMENTED;
 }
 
-/******************************************************************************
- * EventProviderEnabled [ADVAPI32.@]
- *
- */
-BOOLEAN WINAPI EventProviderEnabled( REGHANDLE handle, UCHAR level, ULONGLONG keyword )
-{
-    FIXME("%s, %u, %s: stub\n", wine_dbgstr_longlong(handle), level, wine_dbgstr_longlong(keyword));
-    return FALSE;
-}
-
 /******************************************************************************
  * EventActivityIdControl [ADVAPI32.@]
  *
@@ -834,17 +824,6 @@ ULONG WINAPI EventActivityIdControl(ULONG code, GUID *guid)
     return ERROR_SUCCESS;
 }
 
-/******************************************************************************
- * EventWriteTransfer [ADVAPI32.@]
- */
-ULONG WINAPI EventWriteTransfer( REGHANDLE handle, PCEVENT_DESCRIPTOR descriptor, LPCGUID activity,
-                                 LPCGUID related, ULONG count, PEVENT_DATA_DESCRIPTOR data )
-{
-    FIXME("%s, %p, %s, %s, %u, %p: stub\n", wine_dbgstr_longlong(handle), descriptor,
-          debugstr_guid(activity), debugstr_guid(related), count, data);
-    return ERROR_SUCCESS;
-}
-
 /******************************************************************************
  * QueryTraceW [ADVAPI32.@]
  */
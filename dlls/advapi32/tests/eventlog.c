@@ -29,11 +29,17 @@
 #include "sddl.h"
 #include "wmistr.h"
 #include "evntrace.h"
+#include "evntprov.h"
 
 #include "wine/test.h"
 
 static BOOL (WINAPI *pCreateWellKnownSid)(WELL_KNOWN_SID_TYPE,PSID,PSID,DWORD*);
 static BOOL (WINAPI *pGetEventLogInformation)(HANDLE,DWORD,LPVOID,DWORD,LPDWORD);
+static BOOLEAN (WINAPI *pEventEnabled)(REGHANDLE,PCEVENT_DESCRIPTOR);
+static BOOLEAN (WINAPI *pEventProviderEnabled)(REGHANDLE,UCHAR,ULONGLONG);
+static ULONG (WINAPI *pEventRegister)(LPCGUID,PENABLECALLBACK,PVOID,PREGHANDLE);
+static ULONG (WINAPI *pEventUnregister)(REGHANDLE);
+static ULONG (WINAPI *pEventWrite)(REGHANDLE,PCEVENT_DESCRIPTOR,ULONG,PEVENT_DATA_DESCRIPTOR);
 
 static BOOL (WINAPI *pGetComputerNameExA)(COMPUTER_NAME_FORMAT,LPSTR,LPDWORD);
 static BOOL (WINAPI *pWow64DisableWow64FsRedirection)(PVOID *);
@@ -46,6 +52,11 @@ static void init_function_pointers(void)
 
     pCreateWellKnownSid = (void*)GetProcAddress(hadvapi32, "CreateWellKnownSid");
     pGetEventLogInformation = (void*)GetProcAddress(hadvapi32, "GetEventLogInformation");
+    pEventEnabled = (void*)GetProcAddress(hadvapi32, "EventEnabled");
+    pEventProviderEnabled = (void*)GetProcAddress(hadvapi32, "EventProviderEnabled");
+    pEventRegister = (void*)GetProcAddress(hadvapi32, "EventRegister");
+    pEventUnregister = (void*)GetProcAddress(hadvapi32, "EventUnregister");
+    pEventWrite = (void*)GetProcAddress(hadvapi32, "EventWrite");
 
     pGetComputerNameExA = (void*)GetProcAddress(hkernel32, "GetComputerNameExA");
     pWow64DisableWow64FsRedirection = (void*)GetProcAddress(hkernel32, "Wow64DisableWow64FsRedirection");
@@ -1238,6 +1249,49 @@ done:
     DeleteFileA(filepath);
 }
 
+static BOOL enable_callback_called;
+
+static void WINAPI enable_callback(LPCGUID source, ULONG control, UCHAR level, ULONGLONG any,
+                                   ULONGLONG all, PEVENT_FILTER_DESCRIPTOR filter, PVOID context)
+{
+    enable_callback_called = TRUE;
+}
+
+static void test_event_provider(void)
+{
+    static const GUID provider_guid = {0x8d6b2b5c,0x0b2f,0x4f0e,{0x9c,0x3a,0x57,0x41,0x5e,0x0a,0x2d,0x11}};
+    EVENT_DESCRIPTOR descriptor = { 1, 0, 0, TRACE_LEVEL_INFORMATION, 0, 0, 0x10 };
+    EVENT_DATA_DESCRIPTOR data;
+    REGHANDLE handle;
+    DWORD value = 0x1234;
+    ULONG ret;
+
+    if (!pEventRegister)
+    {
+        win_skip("EventRegister is not available\n");
+        return;
+    }
+
+    handle = 0;
+    ret = pEventRegister(&provider_guid, enable_callback, NULL, &handle);
+    ok(ret == ERROR_SUCCESS, "EventRegister failed, got %u\n", ret);
+    ok(handle != 0, "got null handle\n");
+
+    /* nobody listens to a random provider */
+    ok(!enable_callback_called, "enable callback called\n");
+    ok(!pEventEnabled(handle, &descriptor), "provider is enabled\n");
+    ok(!pEventProviderEnabled(handle, TRACE_LEVEL_INFORMATION, 0x10), "provider is enabled\n");
+
+    data.Ptr = (ULONG_PTR)&value;
+    data.Size = sizeof(value);
+    data.Reserved = 0;
+    ret = pEventWrite(handle, &descriptor, 1, &data);
+    ok(ret == ERROR_SUCCESS, "EventWrite failed, got %u\n", ret);
+
+    ret = pEventUnregister(handle);
+    ok(ret == ERROR_SUCCESS, "EventUnregister failed, got %u\n", ret);
+}
+
 START_TEST(eventlog)
 {
     SetLastError(0xdeadbeef);
@@ -1270,4 +1324,5 @@ START_TEST(eventlog)
 
     /* Trace tests */
     test_start_trace();
+    test_event_provider();
 }
@@ -237,6 +237,8 @@ typedef struct tagLISTVIEW_INFO
   HDPA hdpaItemIds;             /* array of ITEM_ID pointers */
   HDPA hdpaPosX;		/* maintains the (X, Y) coordinates of the */
   HDPA hdpaPosY;		/* items in LVS_ICON, and LVS_SMALLICON modes */
+  POINT ptIconMax;		/* cached maximum of the item positions */
+  BOOL iconMaxDirty;		/* trigger ptIconMax recomputation */
   RANGES selectionRanges;
   INT nSelectionMark;           /* item to start next multiselection from */
   INT nHotItem;
@@ -2734,7 +2736,7 @@ static void LISTVIEW_NextIconPosLeft(LISTVIEW_INFO *infoPtr, LPPOINT lpPos)
  *   Success: TRUE
  *   Failure: FALSE
  */
-static BOOL LISTVIEW_MoveIconTo(const LISTVIEW_INFO *infoPtr, INT nItem, const POINT *lppt, BOOL isNew)
+static BOOL LISTVIEW_MoveIconTo(LISTVIEW_INFO *infoPtr, INT nItem, const POINT *lppt, BOOL isNew)
 {
     POINT old;
     
@@ -2745,6 +2747,10 @@ static BOOL LISTVIEW_MoveIconTo(const LISTVIEW_INFO *infoPtr, INT nItem, const P
     
         if (lppt->x == old.x && lppt->y == old.y) return TRUE;
 	LISTVIEW_InvalidateItem(infoPtr, nItem);
+
+        /* the maximum may shrink if the item defined it */
+        if (old.x == infoPtr->ptIconMax.x || old.y == infoPtr->ptIconMax.y)
+            infoPtr->iconMaxDirty = TRUE;
     }
 
     /* Allocating a POINTER for every item is too resource intensive,
@@ -2752,6 +2758,9 @@ static BOOL LISTVIEW_MoveIconTo(const LISTVIEW_INFO *infoPtr, INT nItem, const P
     if (!DPA_SetPtr(infoPtr->hdpaPosX, nItem, (void *)(LONG_PTR)lppt->x)) return FALSE;
     if (!DPA_SetPtr(infoPtr->hdpaPosY, nItem, (void *)(LONG_PTR)lppt->y)) return FALSE;
 
+    infoPtr->ptIconMax.x = max(infoPtr->ptIconMax.x, lppt->x);
+    infoPtr->ptIconMax.y = max(infoPtr->ptIconMax.y, lppt->y);
+
     LISTVIEW_InvalidateItem(infoPtr, nItem);
 
     return TRUE;
@@ -2799,6 +2808,8 @@ static BOOL LISTVIEW_Arrange(LISTVIEW_INFO *infoPtr, INT nAlignCode)
 	next_pos(infoPtr, &pos);
 	LISTVIEW_MoveIconTo(infoPtr, i, &pos, FALSE);
     }
+    /* every item has been moved, recompute the maximum only once */
+    infoPtr->iconMaxDirty = TRUE;
 
     return TRUE;
 }
@@ -2826,13 +2837,24 @@ static void LISTVIEW_GetAreaRect(const LISTVIEW_INFO *infoPtr, LPRECT lprcView)
     {
     case LV_VIEW_ICON:
     case LV_VIEW_SMALLICON:
-	for (i = 0; i < infoPtr->nItemCount; i++)
+	/* update cached maximum position, scanning the items is too slow
+	 * to be done for every scroll bar update */
+	if (infoPtr->iconMaxDirty)
 	{
-	    x = (LONG_PTR)DPA_GetPtr(infoPtr->hdpaPosX, i);
-            y = (LONG_PTR)DPA_GetPtr(infoPtr->hdpaPosY, i);
-	    lprcView->right = max(lprcView->right, x);
-	    lprcView->bottom = max(lprcView->bottom, y);
+	    LISTVIEW_INFO *Ptr = (LISTVIEW_INFO*)infoPtr;
+
+	    Ptr->ptIconMax.x = Ptr->ptIconMax.y = 0;
+	    for (i = 0; i < infoPtr->nItemCount; i++)
+	    {
+	        x = (LONG_PTR)DPA_GetPtr(infoPtr->hdpaPosX, i);
+	        y = (LONG_PTR)DPA_GetPtr(infoPtr->hdpaPosY, i);
+	        Ptr->ptIconMax.x = max(Ptr->ptIconMax.x, x);
+	        Ptr->ptIconMax.y = max(Ptr->ptIconMax.y, y);
+	    }
+	    Ptr->iconMaxDirty = FALSE;
 	}
+	lprcView->right = infoPtr->ptIconMax.x;
+	lprcView->bottom = infoPtr->ptIconMax.y;
 	if (infoPtr->nItemCount > 0)
 	{
 	    lprcView->right += infoPtr->nItemWidth;
@@ -3262,7 +3284,6 @@ static BOOL ranges_add(RANGES ranges, RANGE range)
     else
     {
 	RANGE *chkrgn, *mrgrgn;
-	INT fromindex, mergeindex;
 
 	chkrgn = DPA_GetPtr(ranges->hdpa, index);
 	TRACE("Merge with %s @%d\n", debugrange(chkrgn), index);
@@ -3272,30 +3293,31 @@ static BOOL ranges_add(RANGES ranges, RANGE range)
 	
 	TRACE("New range %s @%d\n", debugrange(chkrgn), index);
 
-        /* merge now common ranges */
-	fromindex = 0;
-	srchrgn.lower = chkrgn->lower - 1;
-	srchrgn.upper = chkrgn->upper + 1;
-	    
-	do
+        /* merge now common ranges, the ranges are sorted and disjoint
+         * so only the neighbours can touch the grown range */
+	while (index > 0)
 	{
-	    mergeindex = DPA_Search(ranges->hdpa, &srchrgn, fromindex, ranges_cmp, 0, 0);
-	    if (mergeindex == -1) break;
-	    if (mergeindex == index) 
-	    {
-		fromindex = index + 1;
-		continue;
-	    }
-	  
-	    TRACE("Merge with index %i\n", mergeindex);
-	    
-	    mrgrgn = DPA_GetPtr(ranges->hdpa, mergeindex);
+	    mrgrgn = DPA_GetPtr(ranges->hdpa, index - 1);
+	    if (mrgrgn->upper < chkrgn->lower) break;
+
+	    TRACE("Merge with index %i\n", index - 1);
+
 	    chkrgn->lower = min(chkrgn->lower, mrgrgn->lower);
+	    Free(mrgrgn);
+	    DPA_DeletePtr(ranges->hdpa, index - 1);
+	    index--;
+	}
+	while (index + 1 < DPA_GetPtrCount(ranges->hdpa))
+	{
+	    mrgrgn = DPA_GetPtr(ranges->hdpa, index + 1);
+	    if (mrgrgn->lower > chkrgn->upper) break;
+
+	    TRACE("Merge with index %i\n", index + 1);
+
 	    chkrgn->upper = max(chkrgn->upper, mrgrgn->upper);
 	    Free(mrgrgn);
-	    DPA_DeletePtr(ranges->hdpa, mergeindex);
-	    if (mergeindex < index) index --;
-	} while(1);
+	    DPA_DeletePtr(ranges->hdpa, index + 1);
+	}
     }
 
     ranges_check(ranges, "after add");
@@ -3314,12 +3336,16 @@ static BOOL ranges_del(RANGES ranges, RANGE range)
     TRACE("(%s)\n", debugrange(&range));
     ranges_check(ranges, "before del");
 
-    /* we don't use DPAS_SORTED here, since we need *
-     * to find the first overlapping range          */
-    index = DPA_Search(ranges->hdpa, &range, 0, ranges_cmp, 0, 0);
-    while(index != -1)
+    /* the sorted search finds any overlapping range, *
+     * step back to the first one                     */
+    index = DPA_Search(ranges->hdpa, &range, 0, ranges_cmp, 0, DPAS_SORTED);
+    while (index > 0 && ((RANGE*)DPA_GetPtr(ranges->hdpa, index - 1))->upper > range.lower)
+        index--;
+
+    while (index != -1 && index < DPA_GetPtrCount(ranges->hdpa))
     {
 	chkrgn = DPA_GetPtr(ranges->hdpa, index);
+	if (ranges_cmp(chkrgn, &range, 0)) break;
 
 	TRACE("Matches range %s @%d\n", debugrange(chkrgn), index);
 
@@ -3343,6 +3369,7 @@ static BOOL ranges_del(RANGES ranges, RANGE range)
 		  (chkrgn->lower < range.lower) )
 	{
 	    chkrgn->upper = range.lower;
+	    index++;
 	}
 	/* case 4: overlap lower */
 	else if ( (chkrgn->upper > range.upper) &&
@@ -3367,8 +3394,6 @@ static BOOL ranges_del(RANGES ranges, RANGE range)
 	    }
 	    break;
 	}
-
-	index = DPA_Search(ranges->hdpa, &range, index, ranges_cmp, 0, 0);
     }
 
     ranges_check(ranges, "after del");
@@ -5542,6 +5567,7 @@ static BOOL LISTVIEW_DeleteAllItems(LISTVIEW_INFO *infoPtr, BOOL destroy)
 	DPA_DeletePtr(infoPtr->hdpaPosY, i);
 	infoPtr->nItemCount --;
     }
+    infoPtr->iconMaxDirty = TRUE;
     
     if (!destroy)
     {
@@ -5829,8 +5855,11 @@ static BOOL LISTVIEW_DeleteItem(LISTVIEW_INFO *infoPtr, INT nItem)
 
     if (is_icon)
     {
-	DPA_DeletePtr(infoPtr->hdpaPosX, nItem);
-	DPA_DeletePtr(infoPtr->hdpaPosY, nItem);
+	INT x = (LONG_PTR)DPA_DeletePtr(infoPtr->hdpaPosX, nItem);
+	INT y = (LONG_PTR)DPA_DeletePtr(infoPtr->hdpaPosY, nItem);
+
+	if (x == infoPtr->ptIconMax.x || y == infoPtr->ptIconMax.y)
+	    infoPtr->iconMaxDirty = TRUE;
     }
 
     infoPtr->nItemCount--;
@@ -8822,6 +8851,7 @@ static BOOL LISTVIEW_SetItemCount(LISTVIEW_INFO *infoPtr, INT nItems, DWORD dwFl
     {
 	INT nOldCount = infoPtr->nItemCount;
 	infoPtr->nItemCount = nItems;
+	infoPtr->iconMaxDirty = TRUE;
 
 	if (nItems < nOldCount)
 	{
@@ -25,6 +25,7 @@
 #include "wincrypt.h"
 #include "wininet.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 #include "crypt32_private.h"
 
@@ -33,6 +34,10 @@ WINE_DECLARE_DEBUG_CHANNEL(chain);
 
 #define DEFAULT_CYCLE_MODULUS 7
 
+/* The default engines keep recently built chains, see chain_cache_find() */
+#define CHAIN_CACHE_SIZE    64
+#define CHAIN_CACHE_TIMEOUT 60000 /* ms */
+
 /* This represents a subset of a certificate chain engine:  it doesn't include
  * the "hOther" store described by MSDN, because I'm not sure how that's used.
  * It also doesn't include the "hTrust" store, because I don't yet implement
@@ -47,8 +52,28 @@ typedef struct _CertificateChainEngine
     DWORD      dwUrlRetrievalTimeout;
     DWORD      MaximumCachedCertificates;
     DWORD      CycleDetectionModulus;
+    CRITICAL_SECTION cs;
+    struct list cache;
+    DWORD      cache_size;
+    DWORD      cache_count;
 } CertificateChainEngine;
 
+struct chain_cache_key
+{
+    BYTE     hash[20];  /* end certificate and additional store contents */
+    DWORD    flags;
+    FILETIME time;
+};
+
+struct chain_cache_entry
+{
+    struct list            entry;
+    struct chain_cache_key key;
+    LONG                   generation;
+    DWORD                  tick;
+    PCCERT_CHAIN_CONTEXT   chain;
+};
+
 static inline void CRYPT_AddStoresToCollection(HCERTSTORE collection,
  DWORD cStores, HCERTSTORE *stores)
 {
@@ -157,6 +182,11 @@ HCERTCHAINENGINE CRYPT_CreateChainEngine(HCERTSTORE root, DWORD system_store, co
         engine->CycleDetectionModulus = config->CycleDetectionModulus;
     else
         engine->CycleDetectionModulus = DEFAULT_CYCLE_MODULUS;
+    InitializeCriticalSection(&engine->cs);
+    engine->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": CertificateChainEngine.cs");
+    list_init(&engine->cache);
+    engine->cache_size = 0;
+    engine->cache_count = 0;
 
     return engine;
 }
@@ -173,6 +203,8 @@ static CertificateChainEngine *get_chain_engine(HCERTCHAINENGINE handle, BOOL al
 
         if(!default_cu_engine) {
             handle = CRYPT_CreateChainEngine(NULL, CERT_SYSTEM_STORE_CURRENT_USER, &config);
+            if(handle)
+                ((CertificateChainEngine*)handle)->cache_size = CHAIN_CACHE_SIZE;
             InterlockedCompareExchangePointer((void**)&default_cu_engine, handle, NULL);
             if(default_cu_engine != handle)
                 CertFreeCertificateChainEngine(handle);
@@ -187,6 +219,8 @@ static CertificateChainEngine *get_chain_engine(HCERTCHAINENGINE handle, BOOL al
 
         if(!default_lm_engine) {
             handle = CRYPT_CreateChainEngine(NULL, CERT_SYSTEM_STORE_LOCAL_MACHINE, &config);
+            if(handle)
+                ((CertificateChainEngine*)handle)->cache_size = CHAIN_CACHE_SIZE;
             InterlockedCompareExchangePointer((void**)&default_lm_engine, handle, NULL);
             if(default_lm_engine != handle)
                 CertFreeCertificateChainEngine(handle);
@@ -200,9 +234,18 @@ static CertificateChainEngine *get_chain_engine(HCERTCHAINENGINE handle, BOOL al
 
 static void free_chain_engine(CertificateChainEngine *engine)
 {
+    struct chain_cache_entry *entry, *next;
+
     if(!engine || InterlockedDecrement(&engine->ref))
         return;
 
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &engine->cache, struct chain_cache_entry, entry)
+    {
+        CertFreeCertificateChain(entry->chain);
+        CryptMemFree(entry);
+    }
+    engine->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&engine->cs);
     CertCloseStore(engine->hWorld, 0);
     CertCloseStore(engine->hRoot, 0);
     CryptMemFree(engine);
@@ -2881,14 +2924,139 @@ static void dump_chain_para(const CERT_CHAIN_PARA *pChainPara)
     }
 }
 
+static BOOL chain_cache_hash_cert(HCRYPTHASH hash, PCCERT_CONTEXT cert)
+{
+    BYTE buf[20];
+    DWORD size = sizeof(buf);
+
+    return CertGetCertificateContextProperty(cert, CERT_HASH_PROP_ID, buf,
+     &size) && CryptHashData(hash, buf, size, 0);
+}
+
+static BOOL chain_cache_hash_crl(HCRYPTHASH hash, PCCRL_CONTEXT crl)
+{
+    BYTE buf[20];
+    DWORD size = sizeof(buf);
+
+    return CertGetCRLContextProperty(crl, CERT_HASH_PROP_ID, buf, &size) &&
+     CryptHashData(hash, buf, size, 0);
+}
+
+/* Chains are only cached when the result depends on nothing but the end
+ * certificate, the engine's stores, the contents of the additional store,
+ * the flags and the time.
+ */
+static BOOL chain_cache_get_key(PCCERT_CONTEXT cert, LPFILETIME time,
+ HCERTSTORE additional, const CERT_CHAIN_PARA *para, DWORD flags,
+ struct chain_cache_key *key)
+{
+    PCCERT_CONTEXT other = NULL;
+    PCCRL_CONTEXT crl = NULL;
+    HCRYPTHASH hash;
+    DWORD size;
+    BOOL ret;
+
+    if (para->cbSize >= sizeof(CERT_CHAIN_PARA_NO_EXTRA_FIELDS) &&
+     para->RequestedUsage.Usage.cUsageIdentifier)
+        return FALSE;
+
+    memset(key, 0, sizeof(*key));
+    key->flags = flags;
+    if (time)
+        key->time = *time;
+
+    if (!CryptCreateHash(CRYPT_GetDefaultProvider(), CALG_SHA1, 0, 0, &hash))
+        return FALSE;
+    ret = chain_cache_hash_cert(hash, cert);
+    if (ret && additional)
+    {
+        while (ret && (other = CertEnumCertificatesInStore(additional, other)))
+            ret = chain_cache_hash_cert(hash, other);
+        if (other)
+            CertFreeCertificateContext(other);
+        while (ret && (crl = CertEnumCRLsInStore(additional, crl)))
+            ret = chain_cache_hash_crl(hash, crl);
+        if (crl)
+            CertFreeCRLContext(crl);
+    }
+    size = sizeof(key->hash);
+    if (ret)
+        ret = CryptGetHashParam(hash, HP_HASHVAL, key->hash, &size, 0);
+    CryptDestroyHash(hash);
+    return ret;
+}
+
+/* Returns a new reference to a cached chain. Entries go stale when one of
+ * the persistent stores changes, and after CHAIN_CACHE_TIMEOUT when the
+ * chain was checked against the current time.
+ */
+static PCCERT_CHAIN_CONTEXT chain_cache_find(CertificateChainEngine *engine,
+ const struct chain_cache_key *key)
+{
+    struct chain_cache_entry *entry, *next;
+    PCCERT_CHAIN_CONTEXT chain = NULL;
+    LONG generation = crypt_store_generation();
+    DWORD now = GetTickCount();
+
+    EnterCriticalSection(&engine->cs);
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &engine->cache, struct chain_cache_entry, entry)
+    {
+        if (memcmp(&entry->key, key, sizeof(*key)))
+            continue;
+        if (entry->generation != generation ||
+         (!key->time.dwLowDateTime && !key->time.dwHighDateTime &&
+         now - entry->tick >= CHAIN_CACHE_TIMEOUT))
+        {
+            list_remove(&entry->entry);
+            engine->cache_count--;
+            CertFreeCertificateChain(entry->chain);
+            CryptMemFree(entry);
+            break;
+        }
+        list_remove(&entry->entry);
+        list_add_head(&engine->cache, &entry->entry);
+        chain = CertDuplicateCertificateChain(entry->chain);
+        break;
+    }
+    LeaveCriticalSection(&engine->cs);
+    return chain;
+}
+
+static void chain_cache_add(CertificateChainEngine *engine,
+ const struct chain_cache_key *key, LONG generation, PCCERT_CHAIN_CONTEXT chain)
+{
+    struct chain_cache_entry *entry;
+
+    if (!(entry = CryptMemAlloc(sizeof(*entry))))
+        return;
+    entry->key = *key;
+    entry->generation = generation;
+    entry->tick = GetTickCount();
+    entry->chain = CertDuplicateCertificateChain(chain);
+
+    EnterCriticalSection(&engine->cs);
+    list_add_head(&engine->cache, &entry->entry);
+    if (++engine->cache_count > engine->cache_size)
+    {
+        entry = LIST_ENTRY(list_tail(&engine->cache), struct chain_cache_entry, entry);
+        list_remove(&entry->entry);
+        engine->cache_count--;
+        CertFreeCertificateChain(entry->chain);
+        CryptMemFree(entry);
+    }
+    LeaveCriticalSection(&engine->cs);
+}
+
 BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
  PCCERT_CONTEXT pCertContext, LPFILETIME pTime, HCERTSTORE hAdditionalStore,
  PCERT_CHAIN_PARA pChainPara, DWORD dwFlags, LPVOID pvReserved,
  PCCERT_CHAIN_CONTEXT* ppChainContext)
 {
     CertificateChainEngine *engine;
-    BOOL ret;
+    BOOL ret, cached = FALSE;
     CertificateChain *chain = NULL;
+    struct chain_cache_key key;
+    LONG generation = 0;
 
     TRACE("(%p, %p, %s, %p, %p, %08x, %p, %p)\n", hChainEngine, pCertContext,
      debugstr_filetime(pTime), hAdditionalStore, pChainPara, dwFlags,
@@ -2913,6 +3081,26 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
 
     if (TRACE_ON(chain))
         dump_chain_para(pChainPara);
+    if (engine->cache_size)
+    {
+        generation = crypt_store_generation();
+        cached = chain_cache_get_key(pCertContext, pTime, hAdditionalStore,
+         pChainPara, dwFlags, &key);
+    }
+    if (cached)
+    {
+        PCCERT_CHAIN_CONTEXT pChain = chain_cache_find(engine, &key);
+
+        if (pChain)
+        {
+            TRACE_(chain)("using cached chain %p\n", pChain);
+            if (ppChainContext)
+                *ppChainContext = pChain;
+            else
+                CertFreeCertificateChain(pChain);
+            return TRUE;
+        }
+    }
     /* FIXME: what about HCCE_LOCAL_MACHINE? */
     ret = CRYPT_BuildCandidateChainFromCert(engine, pCertContext, pTime,
      hAdditionalStore, dwFlags, &chain);
@@ -2941,6 +3129,8 @@ BOOL WINAPI CertGetCertificateChain(HCERTCHAINENGINE hChainEngine,
         CRYPT_CheckUsages(pChain, pChainPara);
         TRACE_(chain)("error status: %08x\n",
          pChain->TrustStatus.dwErrorStatus);
+        if (cached)
+            chain_cache_add(engine, &key, generation, pChain);
         if (ppChainContext)
             *ppChainContext = pChain;
         else
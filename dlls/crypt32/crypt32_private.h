@@ -159,6 +159,12 @@ void crypt_sip_free(void) DECLSPEC_HIDDEN;
 void root_store_free(void) DECLSPEC_HIDDEN;
 void default_chain_engine_free(void) DECLSPEC_HIDDEN;
 
+/* Counts changes to the persistent (provider backed) stores, so that cached
+ * chains built from them can be invalidated.
+ */
+void crypt_store_changed(void) DECLSPEC_HIDDEN;
+LONG crypt_store_generation(void) DECLSPEC_HIDDEN;
+
 /* (Internal) certificate store types and functions */
 struct WINE_CRYPTCERTSTORE;
 
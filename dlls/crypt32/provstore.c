@@ -43,6 +43,18 @@ typedef struct _WINE_PROVIDERSTORE
     PFN_CERT_STORE_PROV_CONTROL     provControl;
 } WINE_PROVIDERSTORE;
 
+static LONG store_generation;
+
+void crypt_store_changed(void)
+{
+    InterlockedIncrement(&store_generation);
+}
+
+LONG crypt_store_generation(void)
+{
+    return store_generation;
+}
+
 static void ProvStore_addref(WINECRYPT_CERTSTORE *store)
 {
     LONG ref = InterlockedIncrement(&store->ref);
@@ -103,6 +115,8 @@ static BOOL ProvStore_addCert(WINECRYPT_CERTSTORE *store, context_t *cert,
      */
     if (ret && ppStoreContext)
         (*(cert_t**)ppStoreContext)->ctx.hCertStore = store;
+    if (ret)
+        crypt_store_changed();
     return ret;
 }
 
@@ -133,6 +147,8 @@ static BOOL ProvStore_deleteCert(WINECRYPT_CERTSTORE *store, context_t *context)
         ret = ps->provDeleteCert(ps->hStoreProv, context_ptr(context), 0);
     if (ret)
         ret = ps->memStore->vtbl->certs.delete(ps->memStore, context);
+    if (ret)
+        crypt_store_changed();
     return ret;
 }
 
@@ -170,6 +186,8 @@ static BOOL ProvStore_addCRL(WINECRYPT_CERTSTORE *store, context_t *crl,
      */
     if (ret && ppStoreContext)
         (*(crl_t**)ppStoreContext)->ctx.hCertStore = store;
+    if (ret)
+        crypt_store_changed();
     return ret;
 }
 
@@ -200,6 +218,8 @@ static BOOL ProvStore_deleteCRL(WINECRYPT_CERTSTORE *store, context_t *crl)
         ret = ps->provDeleteCrl(ps->hStoreProv, context_ptr(crl), 0);
     if (ret)
         ret = ps->memStore->vtbl->crls.delete(ps->memStore, crl);
+    if (ret)
+        crypt_store_changed();
     return ret;
 }
 
@@ -281,6 +301,8 @@ static BOOL ProvStore_control(WINECRYPT_CERTSTORE *cert_store, DWORD dwFlags, DW
     if (store->provControl)
         ret = store->provControl(store->hStoreProv, dwFlags, dwCtrlType,
          pvCtrlPara);
+    if (ret)
+        crypt_store_changed();
     return ret;
 }
 
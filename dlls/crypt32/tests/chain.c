@@ -3888,7 +3888,7 @@ static void testGetCertChain(void)
     BOOL ret;
     PCCERT_CONTEXT cert;
     CERT_CHAIN_PARA para = { 0 };
-    PCCERT_CHAIN_CONTEXT chain;
+    PCCERT_CHAIN_CONTEXT chain, chain2;
     const CERT_SIMPLE_CHAIN *simple_chain;
     const CERT_CHAIN_ELEMENT *chain_elem;
     FILETIME fileTime;
@@ -4014,6 +4014,32 @@ static void testGetCertChain(void)
          "didn't expect CERT_TRUST_IS_NOT_VALID_FOR_USAGE\n");
         pCertFreeCertificateChain(chain);
     }
+
+    /* Repeated requests give the same result */
+    memset(&para, 0, sizeof(para));
+    para.cbSize = sizeof(para);
+    ret = pCertGetCertificateChain(NULL, cert, &fileTime, store, &para,
+     0, NULL, &chain);
+    ok(ret, "CertGetCertificateChain failed: %08x\n", GetLastError());
+    if (ret)
+    {
+        ret = pCertGetCertificateChain(NULL, cert, &fileTime, store, &para,
+         0, NULL, &chain2);
+        ok(ret, "CertGetCertificateChain failed: %08x\n", GetLastError());
+        if (ret)
+        {
+            ok(chain->TrustStatus.dwErrorStatus == chain2->TrustStatus.dwErrorStatus,
+             "got error status %08x and %08x\n", chain->TrustStatus.dwErrorStatus,
+             chain2->TrustStatus.dwErrorStatus);
+            ok(chain->cChain == chain2->cChain, "got %u and %u chains\n",
+             chain->cChain, chain2->cChain);
+            ok(chain->rgpChain[0]->cElement == chain2->rgpChain[0]->cElement,
+             "got %u and %u elements\n", chain->rgpChain[0]->cElement,
+             chain2->rgpChain[0]->cElement);
+            pCertFreeCertificateChain(chain2);
+        }
+        pCertFreeCertificateChain(chain);
+    }
     CertCloseStore(store, 0);
     CertFreeCertificateContext(cert);
 
@@ -442,6 +442,20 @@ struct d2d_geometry
         size_t bezier_face_count;
     } outline;
 
+    /* GPU copies of the fill and outline data, created on first draw for the
+     * first device the geometry is drawn with. */
+    struct
+    {
+        ID3D10Device *device;
+        ID3D10Buffer *fill_ib;
+        ID3D10Buffer *fill_vb;
+        ID3D10Buffer *fill_bezier_vb;
+        ID3D10Buffer *outline_ib;
+        ID3D10Buffer *outline_vb;
+        ID3D10Buffer *outline_bezier_ib;
+        ID3D10Buffer *outline_bezier_vb;
+    } buffers;
+
     union
     {
         struct
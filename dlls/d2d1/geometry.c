@@ -2336,6 +2336,25 @@ static BOOL d2d_geometry_add_figure_outline(struct d2d_geometry *geometry,
 
 static void d2d_geometry_cleanup(struct d2d_geometry *geometry)
 {
+    ID3D10Buffer **buffers[] =
+    {
+        &geometry->buffers.fill_ib,
+        &geometry->buffers.fill_vb,
+        &geometry->buffers.fill_bezier_vb,
+        &geometry->buffers.outline_ib,
+        &geometry->buffers.outline_vb,
+        &geometry->buffers.outline_bezier_ib,
+        &geometry->buffers.outline_bezier_vb,
+    };
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(buffers); ++i)
+    {
+        if (*buffers[i])
+            ID3D10Buffer_Release(*buffers[i]);
+    }
+    if (geometry->buffers.device)
+        ID3D10Device_Release(geometry->buffers.device);
     heap_free(geometry->outline.bezier_faces);
     heap_free(geometry->outline.beziers);
     heap_free(geometry->outline.faces);
@@ -619,8 +619,59 @@ static void STDMETHODCALLTYPE d2d_d3d_render_target_FillEllipse(ID2D1RenderTarge
     ID2D1EllipseGeometry_Release(geometry);
 }
 
+/* Geometry data is immutable once the geometry is usable, so the buffers are
+ * kept with the geometry instead of being created for every draw. The
+ * returned buffer holds a reference either way. */
+static HRESULT d2d_rt_get_geometry_buffer(struct d2d_d3d_render_target *render_target,
+        struct d2d_geometry *geometry, ID3D10Buffer **cached, unsigned int bind_flags,
+        const void *data, unsigned int size, ID3D10Buffer **buffer)
+{
+    ID3D10Device *device = render_target->device;
+    D3D10_SUBRESOURCE_DATA buffer_data;
+    D3D10_BUFFER_DESC buffer_desc;
+    ID3D10Buffer *old;
+    HRESULT hr;
+
+    if (!geometry->buffers.device
+            && !InterlockedCompareExchangePointer((void **)&geometry->buffers.device, device, NULL))
+        ID3D10Device_AddRef(device);
+
+    if (geometry->buffers.device == device && (*buffer = *cached))
+    {
+        ID3D10Buffer_AddRef(*buffer);
+        return S_OK;
+    }
+
+    buffer_desc.ByteWidth = size;
+    buffer_desc.Usage = D3D10_USAGE_DEFAULT;
+    buffer_desc.BindFlags = bind_flags;
+    buffer_desc.CPUAccessFlags = 0;
+    buffer_desc.MiscFlags = 0;
+
+    buffer_data.pSysMem = data;
+    buffer_data.SysMemPitch = 0;
+    buffer_data.SysMemSlicePitch = 0;
+
+    if (FAILED(hr = ID3D10Device_CreateBuffer(device, &buffer_desc, &buffer_data, buffer)))
+        return hr;
+
+    if (geometry->buffers.device != device)
+        return S_OK;
+
+    ID3D10Buffer_AddRef(*buffer);
+    if ((old = InterlockedCompareExchangePointer((void **)cached, *buffer, NULL)))
+    {
+        /* Another thread got there first. */
+        ID3D10Buffer_Release(*buffer);
+        ID3D10Buffer_Release(*buffer);
+        ID3D10Buffer_AddRef(*buffer = old);
+    }
+
+    return S_OK;
+}
+
 static void d2d_rt_draw_geometry(struct d2d_d3d_render_target *render_target,
-        const struct d2d_geometry *geometry, struct d2d_brush *brush, float stroke_width)
+        struct d2d_geometry *geometry, struct d2d_brush *brush, float stroke_width)
 {
     ID3D10Buffer *ib, *vb, *vs_cb, *ps_cb;
     D3D10_SUBRESOURCE_DATA buffer_data;
@@ -687,21 +738,17 @@ static void d2d_rt_draw_geometry(struct d2d_d3d_render_target *render_target,
 
     if (geometry->outline.face_count)
     {
-        buffer_desc.ByteWidth = geometry->outline.face_count * sizeof(*geometry->outline.faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->device, &buffer_desc, &buffer_data, &ib)))
+        if (FAILED(hr = d2d_rt_get_geometry_buffer(render_target, geometry, &geometry->buffers.outline_ib,
+                D3D10_BIND_INDEX_BUFFER, geometry->outline.faces,
+                geometry->outline.face_count * sizeof(*geometry->outline.faces), &ib)))
         {
             WARN("Failed to create index buffer, hr %#x.\n", hr);
             goto done;
         }
 
-        buffer_desc.ByteWidth = geometry->outline.vertex_count * sizeof(*geometry->outline.vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->device, &buffer_desc, &buffer_data, &vb)))
+        if (FAILED(hr = d2d_rt_get_geometry_buffer(render_target, geometry, &geometry->buffers.outline_vb,
+                D3D10_BIND_VERTEX_BUFFER, geometry->outline.vertices,
+                geometry->outline.vertex_count * sizeof(*geometry->outline.vertices), &vb)))
         {
             ERR("Failed to create vertex buffer, hr %#x.\n", hr);
             ID3D10Buffer_Release(ib);
@@ -717,21 +764,17 @@ static void d2d_rt_draw_geometry(struct d2d_d3d_render_target *render_target,
 
     if (geometry->outline.bezier_face_count)
     {
-        buffer_desc.ByteWidth = geometry->outline.bezier_face_count * sizeof(*geometry->outline.bezier_faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.bezier_faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->device, &buffer_desc, &buffer_data, &ib)))
+        if (FAILED(hr = d2d_rt_get_geometry_buffer(render_target, geometry, &geometry->buffers.outline_bezier_ib,
+                D3D10_BIND_INDEX_BUFFER, geometry->outline.bezier_faces,
+                geometry->outline.bezier_face_count * sizeof(*geometry->outline.bezier_faces), &ib)))
         {
             WARN("Failed to create beziers index buffer, hr %#x.\n", hr);
             goto done;
         }
 
-        buffer_desc.ByteWidth = geometry->outline.bezier_count * sizeof(*geometry->outline.beziers);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->outline.beziers;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->device, &buffer_desc, &buffer_data, &vb)))
+        if (FAILED(hr = d2d_rt_get_geometry_buffer(render_target, geometry, &geometry->buffers.outline_bezier_vb,
+                D3D10_BIND_VERTEX_BUFFER, geometry->outline.beziers,
+                geometry->outline.bezier_count * sizeof(*geometry->outline.beziers), &vb)))
         {
             ERR("Failed to create beziers vertex buffer, hr %#x.\n", hr);
             ID3D10Buffer_Release(ib);
@@ -753,7 +796,7 @@ done:
 static void STDMETHODCALLTYPE d2d_d3d_render_target_DrawGeometry(ID2D1RenderTarget *iface,
         ID2D1Geometry *geometry, ID2D1Brush *brush, float stroke_width, ID2D1StrokeStyle *stroke_style)
 {
-    const struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
+    struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
     struct d2d_d3d_render_target *render_target = impl_from_ID2D1RenderTarget(iface);
     struct d2d_brush *brush_impl = unsafe_impl_from_ID2D1Brush(brush);
 
@@ -767,7 +810,7 @@ static void STDMETHODCALLTYPE d2d_d3d_render_target_DrawGeometry(ID2D1RenderTarg
 }
 
 static void d2d_rt_fill_geometry(struct d2d_d3d_render_target *render_target,
-        const struct d2d_geometry *geometry, struct d2d_brush *brush, struct d2d_brush *opacity_brush)
+        struct d2d_geometry *geometry, struct d2d_brush *brush, struct d2d_brush *opacity_brush)
 {
     ID3D10Buffer *ib, *vb, *vs_cb, *ps_cb;
     D3D10_SUBRESOURCE_DATA buffer_data;
@@ -834,21 +877,17 @@ static void d2d_rt_fill_geometry(struct d2d_d3d_render_target *render_target,
 
     if (geometry->fill.face_count)
     {
-        buffer_desc.ByteWidth = geometry->fill.face_count * sizeof(*geometry->fill.faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->device, &buffer_desc, &buffer_data, &ib)))
+        if (FAILED(hr = d2d_rt_get_geometry_buffer(render_target, geometry, &geometry->buffers.fill_ib,
+                D3D10_BIND_INDEX_BUFFER, geometry->fill.faces,
+                geometry->fill.face_count * sizeof(*geometry->fill.faces), &ib)))
         {
             WARN("Failed to create index buffer, hr %#x.\n", hr);
             goto done;
         }
 
-        buffer_desc.ByteWidth = geometry->fill.vertex_count * sizeof(*geometry->fill.vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->device, &buffer_desc, &buffer_data, &vb)))
+        if (FAILED(hr = d2d_rt_get_geometry_buffer(render_target, geometry, &geometry->buffers.fill_vb,
+                D3D10_BIND_VERTEX_BUFFER, geometry->fill.vertices,
+                geometry->fill.vertex_count * sizeof(*geometry->fill.vertices), &vb)))
         {
             ERR("Failed to create vertex buffer, hr %#x.\n", hr);
             ID3D10Buffer_Release(ib);
@@ -864,10 +903,9 @@ static void d2d_rt_fill_geometry(struct d2d_d3d_render_target *render_target,
 
     if (geometry->fill.bezier_vertex_count)
     {
-        buffer_desc.ByteWidth = geometry->fill.bezier_vertex_count * sizeof(*geometry->fill.bezier_vertices);
-        buffer_data.pSysMem = geometry->fill.bezier_vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->device, &buffer_desc, &buffer_data, &vb)))
+        if (FAILED(hr = d2d_rt_get_geometry_buffer(render_target, geometry, &geometry->buffers.fill_bezier_vb,
+                D3D10_BIND_VERTEX_BUFFER, geometry->fill.bezier_vertices,
+                geometry->fill.bezier_vertex_count * sizeof(*geometry->fill.bezier_vertices), &vb)))
         {
             ERR("Failed to create beziers vertex buffer, hr %#x.\n", hr);
             goto done;
@@ -887,7 +925,7 @@ done:
 static void STDMETHODCALLTYPE d2d_d3d_render_target_FillGeometry(ID2D1RenderTarget *iface,
         ID2D1Geometry *geometry, ID2D1Brush *brush, ID2D1Brush *opacity_brush)
 {
-    const struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
+    struct d2d_geometry *geometry_impl = unsafe_impl_from_ID2D1Geometry(geometry);
     struct d2d_brush *opacity_brush_impl = unsafe_impl_from_ID2D1Brush(opacity_brush);
     struct d2d_d3d_render_target *render_target = impl_from_ID2D1RenderTarget(iface);
     struct d2d_brush *brush_impl = unsafe_impl_from_ID2D1Brush(brush);
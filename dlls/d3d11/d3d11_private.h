@@ -37,6 +37,7 @@
 #include "wine/wined3d.h"
 #include "wine/winedxgi.h"
 #include "wine/rbtree.h"
+#include "wine/list.h"
 
 #ifndef ARRAY_SIZE
 #define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
@@ -61,6 +62,8 @@ const char *debug_d3d10_primitive_topology(D3D10_PRIMITIVE_TOPOLOGY topology) DE
 const char *debug_dxgi_format(DXGI_FORMAT format) DECLSPEC_HIDDEN;
 const char *debug_float4(const float *values) DECLSPEC_HIDDEN;
 
+BOOL d3d_array_reserve(void **elements, SIZE_T *capacity, SIZE_T count, SIZE_T size) DECLSPEC_HIDDEN;
+
 DXGI_FORMAT dxgi_format_from_wined3dformat(enum wined3d_format_id format) DECLSPEC_HIDDEN;
 enum wined3d_format_id wined3dformat_from_dxgi_format(DXGI_FORMAT format) DECLSPEC_HIDDEN;
 void d3d11_primitive_topology_from_wined3d_primitive_type(enum wined3d_primitive_type primitive_type,
@@ -501,6 +504,95 @@ struct d3d11_immediate_context
     struct wined3d_private_store private_store;
 };
 
+enum d3d11_shader_stage
+{
+    D3D11_STAGE_VS,
+    D3D11_STAGE_HS,
+    D3D11_STAGE_DS,
+    D3D11_STAGE_GS,
+    D3D11_STAGE_PS,
+    D3D11_STAGE_CS,
+    D3D11_STAGE_COUNT,
+};
+
+/* The application visible state of a device context. Every non-NULL object
+ * pointer holds a reference. */
+struct d3d11_context_state
+{
+    ID3D11DeviceChild *shaders[D3D11_STAGE_COUNT];
+    ID3D11Buffer *constant_buffers[D3D11_STAGE_COUNT][D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+    ID3D11ShaderResourceView *shader_resource_views[D3D11_STAGE_COUNT][D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11SamplerState *samplers[D3D11_STAGE_COUNT][D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT];
+    ID3D11UnorderedAccessView *ps_uavs[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    ID3D11UnorderedAccessView *cs_uavs[D3D11_PS_CS_UAV_REGISTER_COUNT];
+
+    ID3D11InputLayout *input_layout;
+    ID3D11Buffer *vertex_buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vertex_buffer_strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT vertex_buffer_offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    ID3D11Buffer *index_buffer;
+    DXGI_FORMAT index_buffer_format;
+    UINT index_buffer_offset;
+    D3D11_PRIMITIVE_TOPOLOGY primitive_topology;
+
+    ID3D11Buffer *so_buffers[D3D11_SO_BUFFER_SLOT_COUNT];
+    UINT so_offsets[D3D11_SO_BUFFER_SLOT_COUNT];
+
+    ID3D11RasterizerState *rasterizer_state;
+    UINT viewport_count;
+    D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    UINT scissor_rect_count;
+    D3D11_RECT scissor_rects[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+
+    ID3D11RenderTargetView *render_target_views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    ID3D11DepthStencilView *depth_stencil_view;
+    ID3D11BlendState *blend_state;
+    float blend_factor[4];
+    UINT sample_mask;
+    ID3D11DepthStencilState *depth_stencil_state;
+    UINT stencil_ref;
+
+    ID3D11Predicate *predicate;
+    BOOL predicate_value;
+};
+
+/* ID3D11CommandList */
+struct d3d11_command_list
+{
+    ID3D11CommandList ID3D11CommandList_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    ID3D11Device *device;
+    UINT flags;
+
+    struct d3d11_context_state *initial_state;
+    BYTE *data;
+    SIZE_T data_size;
+    SIZE_T data_capacity;
+
+    IUnknown **objects;
+    SIZE_T object_count;
+    SIZE_T objects_size;
+};
+
+struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface) DECLSPEC_HIDDEN;
+
+/* ID3D11DeviceContext - deferred context */
+struct d3d11_deferred_context
+{
+    ID3D11DeviceContext ID3D11DeviceContext_iface;
+    LONG refcount;
+
+    struct wined3d_private_store private_store;
+    ID3D11Device *device;
+    UINT flags;
+
+    struct d3d11_command_list *command_list;
+    struct d3d11_context_state state;
+    struct list mapped_resources;
+};
+
 /* ID3D11Device, ID3D10Device1 */
 struct d3d_device
 {
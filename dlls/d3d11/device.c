@@ -32,1141 +32,5194 @@ static const struct wined3d_parent_ops d3d_null_wined3d_parent_ops =
     d3d_null_wined3d_object_destroyed,
 };
 
-/* ID3D11DeviceContext - immediate context methods */
-
-static inline struct d3d11_immediate_context *impl_from_ID3D11DeviceContext(ID3D11DeviceContext *iface)
-{
-    return CONTAINING_RECORD(iface, struct d3d11_immediate_context, ID3D11DeviceContext_iface);
-}
+/* Device context state */
 
-static inline struct d3d_device *device_from_immediate_ID3D11DeviceContext(ID3D11DeviceContext *iface)
+enum d3d11_binding_type
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
-    return CONTAINING_RECORD(context, struct d3d_device, immediate_context);
-}
+    D3D11_BINDING_CONSTANT_BUFFER,
+    D3D11_BINDING_SHADER_RESOURCE_VIEW,
+    D3D11_BINDING_SAMPLER,
+};
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_QueryInterface(ID3D11DeviceContext *iface,
-        REFIID riid, void **out)
+static void d3d11_objects_addref(IUnknown **objects, unsigned int count)
 {
-    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+    unsigned int i;
 
-    if (IsEqualGUID(riid, &IID_ID3D11DeviceContext)
-            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
-            || IsEqualGUID(riid, &IID_IUnknown))
+    for (i = 0; i < count; ++i)
     {
-        ID3D11DeviceContext_AddRef(iface);
-        *out = iface;
-        return S_OK;
+        if (objects[i])
+            IUnknown_AddRef(objects[i]);
     }
-
-    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
-    *out = NULL;
-    return E_NOINTERFACE;
 }
 
-static ULONG STDMETHODCALLTYPE d3d11_immediate_context_AddRef(ID3D11DeviceContext *iface)
+static void d3d11_objects_release(IUnknown **objects, unsigned int count)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    ULONG refcount = InterlockedIncrement(&context->refcount);
-
-    TRACE("%p increasing refcount to %u.\n", context, refcount);
+    unsigned int i;
 
-    if (refcount == 1)
+    for (i = 0; i < count; ++i)
     {
-        ID3D11Device_AddRef(&device->ID3D11Device_iface);
+        if (objects[i])
+            IUnknown_Release(objects[i]);
     }
-
-    return refcount;
 }
 
-static ULONG STDMETHODCALLTYPE d3d11_immediate_context_Release(ID3D11DeviceContext *iface)
+static void d3d11_objects_replace(IUnknown **dst, IUnknown *const *src, unsigned int count)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    ULONG refcount = InterlockedDecrement(&context->refcount);
-
-    TRACE("%p decreasing refcount to %u.\n", context, refcount);
+    IUnknown *object;
+    unsigned int i;
 
-    if (!refcount)
+    for (i = 0; i < count; ++i)
     {
-        ID3D11Device_Release(&device->ID3D11Device_iface);
+        if ((object = src ? src[i] : NULL))
+            IUnknown_AddRef(object);
+        if (dst[i])
+            IUnknown_Release(dst[i]);
+        dst[i] = object;
     }
-
-    return refcount;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GetDevice(ID3D11DeviceContext *iface, ID3D11Device **device)
+static void d3d11_context_state_for_each_object_array(struct d3d11_context_state *state,
+        void (*func)(IUnknown **objects, unsigned int count))
 {
-    struct d3d_device *device_object = device_from_immediate_ID3D11DeviceContext(iface);
-
-    TRACE("iface %p, device %p.\n", iface, device);
-
-    *device = &device_object->ID3D11Device_iface;
-    ID3D11Device_AddRef(*device);
+    func((IUnknown **)state->shaders, ARRAY_SIZE(state->shaders));
+    func((IUnknown **)state->constant_buffers,
+            ARRAY_SIZE(state->constant_buffers) * ARRAY_SIZE(*state->constant_buffers));
+    func((IUnknown **)state->shader_resource_views,
+            ARRAY_SIZE(state->shader_resource_views) * ARRAY_SIZE(*state->shader_resource_views));
+    func((IUnknown **)state->samplers, ARRAY_SIZE(state->samplers) * ARRAY_SIZE(*state->samplers));
+    func((IUnknown **)state->ps_uavs, ARRAY_SIZE(state->ps_uavs));
+    func((IUnknown **)state->cs_uavs, ARRAY_SIZE(state->cs_uavs));
+    func((IUnknown **)&state->input_layout, 1);
+    func((IUnknown **)state->vertex_buffers, ARRAY_SIZE(state->vertex_buffers));
+    func((IUnknown **)&state->index_buffer, 1);
+    func((IUnknown **)state->so_buffers, ARRAY_SIZE(state->so_buffers));
+    func((IUnknown **)&state->rasterizer_state, 1);
+    func((IUnknown **)state->render_target_views, ARRAY_SIZE(state->render_target_views));
+    func((IUnknown **)&state->depth_stencil_view, 1);
+    func((IUnknown **)&state->blend_state, 1);
+    func((IUnknown **)&state->depth_stencil_state, 1);
+    func((IUnknown **)&state->predicate, 1);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
-        UINT *data_size, void *data)
+static void d3d11_context_state_init(struct d3d11_context_state *state)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
-
-    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+    unsigned int i;
 
-    return d3d_get_private_data(&context->private_store, guid, data_size, data);
+    memset(state, 0, sizeof(*state));
+    state->primitive_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    for (i = 0; i < ARRAY_SIZE(state->blend_factor); ++i)
+        state->blend_factor[i] = 1.0f;
+    state->sample_mask = D3D11_DEFAULT_SAMPLE_MASK;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
-        UINT data_size, const void *data)
+static void d3d11_context_state_cleanup(struct d3d11_context_state *state)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+    d3d11_context_state_for_each_object_array(state, d3d11_objects_release);
+}
 
-    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+static void d3d11_context_state_copy(struct d3d11_context_state *dst, const struct d3d11_context_state *src)
+{
+    *dst = *src;
+    d3d11_context_state_for_each_object_array(dst, d3d11_objects_addref);
+}
 
-    return d3d_set_private_data(&context->private_store, guid, data_size, data);
+static void d3d11_context_set_shader(ID3D11DeviceContext *context,
+        enum d3d11_shader_stage stage, ID3D11DeviceChild *shader)
+{
+    switch (stage)
+    {
+        case D3D11_STAGE_VS:
+            ID3D11DeviceContext_VSSetShader(context, (ID3D11VertexShader *)shader, NULL, 0);
+            break;
+        case D3D11_STAGE_HS:
+            ID3D11DeviceContext_HSSetShader(context, (ID3D11HullShader *)shader, NULL, 0);
+            break;
+        case D3D11_STAGE_DS:
+            ID3D11DeviceContext_DSSetShader(context, (ID3D11DomainShader *)shader, NULL, 0);
+            break;
+        case D3D11_STAGE_GS:
+            ID3D11DeviceContext_GSSetShader(context, (ID3D11GeometryShader *)shader, NULL, 0);
+            break;
+        case D3D11_STAGE_PS:
+            ID3D11DeviceContext_PSSetShader(context, (ID3D11PixelShader *)shader, NULL, 0);
+            break;
+        case D3D11_STAGE_CS:
+            ID3D11DeviceContext_CSSetShader(context, (ID3D11ComputeShader *)shader, NULL, 0);
+            break;
+        default:
+            ERR("Invalid shader stage %#x.\n", stage);
+            break;
+    }
+}
+
+static void d3d11_context_get_shader(ID3D11DeviceContext *context,
+        enum d3d11_shader_stage stage, ID3D11DeviceChild **shader)
+{
+    switch (stage)
+    {
+        case D3D11_STAGE_VS:
+            ID3D11DeviceContext_VSGetShader(context, (ID3D11VertexShader **)shader, NULL, NULL);
+            break;
+        case D3D11_STAGE_HS:
+            ID3D11DeviceContext_HSGetShader(context, (ID3D11HullShader **)shader, NULL, NULL);
+            break;
+        case D3D11_STAGE_DS:
+            ID3D11DeviceContext_DSGetShader(context, (ID3D11DomainShader **)shader, NULL, NULL);
+            break;
+        case D3D11_STAGE_GS:
+            ID3D11DeviceContext_GSGetShader(context, (ID3D11GeometryShader **)shader, NULL, NULL);
+            break;
+        case D3D11_STAGE_PS:
+            ID3D11DeviceContext_PSGetShader(context, (ID3D11PixelShader **)shader, NULL, NULL);
+            break;
+        case D3D11_STAGE_CS:
+            ID3D11DeviceContext_CSGetShader(context, (ID3D11ComputeShader **)shader, NULL, NULL);
+            break;
+        default:
+            ERR("Invalid shader stage %#x.\n", stage);
+            *shader = NULL;
+            break;
+    }
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateDataInterface(ID3D11DeviceContext *iface,
-        REFGUID guid, const IUnknown *data)
+static void d3d11_context_set_bindings(ID3D11DeviceContext *context, enum d3d11_shader_stage stage,
+        enum d3d11_binding_type type, UINT start_slot, UINT count, IUnknown *const *objects)
 {
-    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+    ID3D11ShaderResourceView *const *views = (ID3D11ShaderResourceView *const *)objects;
+    ID3D11SamplerState *const *samplers = (ID3D11SamplerState *const *)objects;
+    ID3D11Buffer *const *buffers = (ID3D11Buffer *const *)objects;
 
-    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+    switch (type)
+    {
+        case D3D11_BINDING_CONSTANT_BUFFER:
+            switch (stage)
+            {
+                case D3D11_STAGE_VS: ID3D11DeviceContext_VSSetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_HS: ID3D11DeviceContext_HSSetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_DS: ID3D11DeviceContext_DSSetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_GS: ID3D11DeviceContext_GSSetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_PS: ID3D11DeviceContext_PSSetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_CS: ID3D11DeviceContext_CSSetConstantBuffers(context, start_slot, count, buffers); break;
+                default: ERR("Invalid shader stage %#x.\n", stage); break;
+            }
+            break;
 
-    return d3d_set_private_data_interface(&context->private_store, guid, data);
+        case D3D11_BINDING_SHADER_RESOURCE_VIEW:
+            switch (stage)
+            {
+                case D3D11_STAGE_VS: ID3D11DeviceContext_VSSetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_HS: ID3D11DeviceContext_HSSetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_DS: ID3D11DeviceContext_DSSetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_GS: ID3D11DeviceContext_GSSetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_PS: ID3D11DeviceContext_PSSetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_CS: ID3D11DeviceContext_CSSetShaderResources(context, start_slot, count, views); break;
+                default: ERR("Invalid shader stage %#x.\n", stage); break;
+            }
+            break;
+
+        case D3D11_BINDING_SAMPLER:
+            switch (stage)
+            {
+                case D3D11_STAGE_VS: ID3D11DeviceContext_VSSetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_HS: ID3D11DeviceContext_HSSetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_DS: ID3D11DeviceContext_DSSetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_GS: ID3D11DeviceContext_GSSetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_PS: ID3D11DeviceContext_PSSetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_CS: ID3D11DeviceContext_CSSetSamplers(context, start_slot, count, samplers); break;
+                default: ERR("Invalid shader stage %#x.\n", stage); break;
+            }
+            break;
+    }
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetConstantBuffers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void d3d11_context_get_bindings(ID3D11DeviceContext *context, enum d3d11_shader_stage stage,
+        enum d3d11_binding_type type, UINT start_slot, UINT count, IUnknown **objects)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    ID3D11ShaderResourceView **views = (ID3D11ShaderResourceView **)objects;
+    ID3D11SamplerState **samplers = (ID3D11SamplerState **)objects;
+    ID3D11Buffer **buffers = (ID3D11Buffer **)objects;
 
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
+    switch (type)
     {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+        case D3D11_BINDING_CONSTANT_BUFFER:
+            switch (stage)
+            {
+                case D3D11_STAGE_VS: ID3D11DeviceContext_VSGetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_HS: ID3D11DeviceContext_HSGetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_DS: ID3D11DeviceContext_DSGetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_GS: ID3D11DeviceContext_GSGetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_PS: ID3D11DeviceContext_PSGetConstantBuffers(context, start_slot, count, buffers); break;
+                case D3D11_STAGE_CS: ID3D11DeviceContext_CSGetConstantBuffers(context, start_slot, count, buffers); break;
+                default: ERR("Invalid shader stage %#x.\n", stage); break;
+            }
+            break;
 
-        wined3d_device_set_vs_cb(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL);
+        case D3D11_BINDING_SHADER_RESOURCE_VIEW:
+            switch (stage)
+            {
+                case D3D11_STAGE_VS: ID3D11DeviceContext_VSGetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_HS: ID3D11DeviceContext_HSGetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_DS: ID3D11DeviceContext_DSGetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_GS: ID3D11DeviceContext_GSGetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_PS: ID3D11DeviceContext_PSGetShaderResources(context, start_slot, count, views); break;
+                case D3D11_STAGE_CS: ID3D11DeviceContext_CSGetShaderResources(context, start_slot, count, views); break;
+                default: ERR("Invalid shader stage %#x.\n", stage); break;
+            }
+            break;
+
+        case D3D11_BINDING_SAMPLER:
+            switch (stage)
+            {
+                case D3D11_STAGE_VS: ID3D11DeviceContext_VSGetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_HS: ID3D11DeviceContext_HSGetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_DS: ID3D11DeviceContext_DSGetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_GS: ID3D11DeviceContext_GSGetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_PS: ID3D11DeviceContext_PSGetSamplers(context, start_slot, count, samplers); break;
+                case D3D11_STAGE_CS: ID3D11DeviceContext_CSGetSamplers(context, start_slot, count, samplers); break;
+                default: ERR("Invalid shader stage %#x.\n", stage); break;
+            }
+            break;
     }
-    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShaderResources(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+/* Reads back the complete state of "context". Used to save the immediate
+ * context state around ExecuteCommandList(). */
+static void d3d11_context_state_capture(struct d3d11_context_state *state, ID3D11DeviceContext *context)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
     unsigned int i;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    d3d11_context_state_init(state);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
+    for (i = 0; i < D3D11_STAGE_COUNT; ++i)
     {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
-
-        wined3d_device_set_ps_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
+        d3d11_context_get_shader(context, i, &state->shaders[i]);
+        d3d11_context_get_bindings(context, i, D3D11_BINDING_CONSTANT_BUFFER, 0,
+                ARRAY_SIZE(state->constant_buffers[i]), (IUnknown **)state->constant_buffers[i]);
+        d3d11_context_get_bindings(context, i, D3D11_BINDING_SHADER_RESOURCE_VIEW, 0,
+                ARRAY_SIZE(state->shader_resource_views[i]), (IUnknown **)state->shader_resource_views[i]);
+        d3d11_context_get_bindings(context, i, D3D11_BINDING_SAMPLER, 0,
+                ARRAY_SIZE(state->samplers[i]), (IUnknown **)state->samplers[i]);
     }
-    wined3d_mutex_unlock();
-}
+    ID3D11DeviceContext_CSGetUnorderedAccessViews(context, 0, ARRAY_SIZE(state->cs_uavs), state->cs_uavs);
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShader(ID3D11DeviceContext *iface,
-        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_pixel_shader *ps = unsafe_impl_from_ID3D11PixelShader(shader);
+    ID3D11DeviceContext_IAGetInputLayout(context, &state->input_layout);
+    ID3D11DeviceContext_IAGetVertexBuffers(context, 0, ARRAY_SIZE(state->vertex_buffers),
+            state->vertex_buffers, state->vertex_buffer_strides, state->vertex_buffer_offsets);
+    ID3D11DeviceContext_IAGetIndexBuffer(context, &state->index_buffer,
+            &state->index_buffer_format, &state->index_buffer_offset);
+    ID3D11DeviceContext_IAGetPrimitiveTopology(context, &state->primitive_topology);
 
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
+    /* SOGetTargets() doesn't return offsets; restored targets append. */
+    ID3D11DeviceContext_SOGetTargets(context, ARRAY_SIZE(state->so_buffers), state->so_buffers);
+    for (i = 0; i < ARRAY_SIZE(state->so_offsets); ++i)
+        state->so_offsets[i] = ~0u;
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+    ID3D11DeviceContext_RSGetState(context, &state->rasterizer_state);
+    ID3D11DeviceContext_RSGetViewports(context, &state->viewport_count, NULL);
+    state->viewport_count = min(state->viewport_count, ARRAY_SIZE(state->viewports));
+    ID3D11DeviceContext_RSGetViewports(context, &state->viewport_count, state->viewports);
+    ID3D11DeviceContext_RSGetScissorRects(context, &state->scissor_rect_count, NULL);
+    state->scissor_rect_count = min(state->scissor_rect_count, ARRAY_SIZE(state->scissor_rects));
+    ID3D11DeviceContext_RSGetScissorRects(context, &state->scissor_rect_count, state->scissor_rects);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_pixel_shader(device->wined3d_device, ps ? ps->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_OMGetRenderTargetsAndUnorderedAccessViews(context,
+            ARRAY_SIZE(state->render_target_views), state->render_target_views, &state->depth_stencil_view,
+            0, ARRAY_SIZE(state->ps_uavs), state->ps_uavs);
+    ID3D11DeviceContext_OMGetBlendState(context, &state->blend_state, state->blend_factor, &state->sample_mask);
+    ID3D11DeviceContext_OMGetDepthStencilState(context, &state->depth_stencil_state, &state->stencil_ref);
+
+    ID3D11DeviceContext_GetPredication(context, &state->predicate, &state->predicate_value);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetSamplers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void d3d11_context_state_apply(const struct d3d11_context_state *state, ID3D11DeviceContext *context)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
     unsigned int i;
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
+    for (i = 0; i < D3D11_STAGE_COUNT; ++i)
     {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
-
-        wined3d_device_set_ps_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
+        d3d11_context_set_shader(context, i, state->shaders[i]);
+        d3d11_context_set_bindings(context, i, D3D11_BINDING_CONSTANT_BUFFER, 0,
+                ARRAY_SIZE(state->constant_buffers[i]), (IUnknown *const *)state->constant_buffers[i]);
+        d3d11_context_set_bindings(context, i, D3D11_BINDING_SHADER_RESOURCE_VIEW, 0,
+                ARRAY_SIZE(state->shader_resource_views[i]), (IUnknown *const *)state->shader_resource_views[i]);
+        d3d11_context_set_bindings(context, i, D3D11_BINDING_SAMPLER, 0,
+                ARRAY_SIZE(state->samplers[i]), (IUnknown *const *)state->samplers[i]);
     }
-    wined3d_mutex_unlock();
-}
+    ID3D11DeviceContext_CSSetUnorderedAccessViews(context, 0, ARRAY_SIZE(state->cs_uavs), state->cs_uavs, NULL);
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShader(ID3D11DeviceContext *iface,
-        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_vertex_shader *vs = unsafe_impl_from_ID3D11VertexShader(shader);
+    ID3D11DeviceContext_IASetInputLayout(context, state->input_layout);
+    ID3D11DeviceContext_IASetVertexBuffers(context, 0, ARRAY_SIZE(state->vertex_buffers),
+            state->vertex_buffers, state->vertex_buffer_strides, state->vertex_buffer_offsets);
+    ID3D11DeviceContext_IASetIndexBuffer(context, state->index_buffer,
+            state->index_buffer_format, state->index_buffer_offset);
+    ID3D11DeviceContext_IASetPrimitiveTopology(context, state->primitive_topology);
 
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
+    ID3D11DeviceContext_SOSetTargets(context, ARRAY_SIZE(state->so_buffers), state->so_buffers, state->so_offsets);
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+    ID3D11DeviceContext_RSSetState(context, state->rasterizer_state);
+    ID3D11DeviceContext_RSSetViewports(context, state->viewport_count, state->viewports);
+    ID3D11DeviceContext_RSSetScissorRects(context, state->scissor_rect_count, state->scissor_rects);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_vertex_shader(device->wined3d_device, vs ? vs->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_OMSetRenderTargets(context, ARRAY_SIZE(state->render_target_views),
+            state->render_target_views, state->depth_stencil_view);
+    ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews(context,
+            D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, NULL, NULL,
+            0, ARRAY_SIZE(state->ps_uavs), state->ps_uavs, NULL);
+    ID3D11DeviceContext_OMSetBlendState(context, state->blend_state, state->blend_factor, state->sample_mask);
+    ID3D11DeviceContext_OMSetDepthStencilState(context, state->depth_stencil_state, state->stencil_ref);
+
+    ID3D11DeviceContext_SetPredication(context, state->predicate, state->predicate_value);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexed(ID3D11DeviceContext *iface,
-        UINT index_count, UINT start_index_location, INT base_vertex_location)
+/* ID3D11CommandList methods
+ *
+ * A command list is a flat stream of packets recorded by a deferred context.
+ * Each packet holds the arguments of one context method, and is replayed by
+ * calling the same method on the immediate context. The list holds a
+ * reference to every object referenced by its packets, and to the objects in
+ * "initial_state", the deferred context state carried over from the previous
+ * command list, if any. */
+
+enum d3d11_command_op
+{
+    D3D11_COMMAND_CLEAR_STATE,
+    D3D11_COMMAND_SET_SHADER,
+    D3D11_COMMAND_SET_BINDINGS,
+    D3D11_COMMAND_SET_CS_UAVS,
+    D3D11_COMMAND_SET_INPUT_LAYOUT,
+    D3D11_COMMAND_SET_VERTEX_BUFFERS,
+    D3D11_COMMAND_SET_INDEX_BUFFER,
+    D3D11_COMMAND_SET_PRIMITIVE_TOPOLOGY,
+    D3D11_COMMAND_SET_SO_TARGETS,
+    D3D11_COMMAND_SET_RASTERIZER_STATE,
+    D3D11_COMMAND_SET_VIEWPORTS,
+    D3D11_COMMAND_SET_SCISSOR_RECTS,
+    D3D11_COMMAND_SET_RENDER_TARGETS_AND_UAVS,
+    D3D11_COMMAND_SET_BLEND_STATE,
+    D3D11_COMMAND_SET_DEPTH_STENCIL_STATE,
+    D3D11_COMMAND_SET_PREDICATION,
+    D3D11_COMMAND_DRAW,
+    D3D11_COMMAND_DRAW_INDEXED,
+    D3D11_COMMAND_DRAW_INSTANCED,
+    D3D11_COMMAND_DRAW_INDEXED_INSTANCED,
+    D3D11_COMMAND_DRAW_AUTO,
+    D3D11_COMMAND_DRAW_INSTANCED_INDIRECT,
+    D3D11_COMMAND_DRAW_INDEXED_INSTANCED_INDIRECT,
+    D3D11_COMMAND_DISPATCH,
+    D3D11_COMMAND_DISPATCH_INDIRECT,
+    D3D11_COMMAND_CLEAR_RENDER_TARGET_VIEW,
+    D3D11_COMMAND_CLEAR_DEPTH_STENCIL_VIEW,
+    D3D11_COMMAND_CLEAR_UAV_UINT,
+    D3D11_COMMAND_CLEAR_UAV_FLOAT,
+    D3D11_COMMAND_COPY_SUBRESOURCE_REGION,
+    D3D11_COMMAND_COPY_RESOURCE,
+    D3D11_COMMAND_UPDATE_SUBRESOURCE,
+    D3D11_COMMAND_COPY_STRUCTURE_COUNT,
+    D3D11_COMMAND_RESOLVE_SUBRESOURCE,
+    D3D11_COMMAND_GENERATE_MIPS,
+    D3D11_COMMAND_SET_RESOURCE_MIN_LOD,
+    D3D11_COMMAND_WRITE_MAPPED,
+    D3D11_COMMAND_BEGIN,
+    D3D11_COMMAND_END,
+    D3D11_COMMAND_EXECUTE_COMMAND_LIST,
+    D3D11_COMMAND_STOP,
+};
+
+struct d3d11_command_packet
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    SIZE_T size;
+    BYTE data[1];
+};
 
-    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
-            iface, index_count, start_index_location, base_vertex_location);
+struct d3d11_command
+{
+    enum d3d11_command_op opcode;
+};
 
-    wined3d_mutex_lock();
-    wined3d_device_set_base_vertex_index(device->wined3d_device, base_vertex_location);
-    wined3d_device_draw_indexed_primitive(device->wined3d_device, start_index_location, index_count);
-    wined3d_mutex_unlock();
-}
+struct d3d11_command_set_shader
+{
+    enum d3d11_command_op opcode;
+    enum d3d11_shader_stage stage;
+    ID3D11DeviceChild *shader;
+};
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Draw(ID3D11DeviceContext *iface,
-        UINT vertex_count, UINT start_vertex_location)
+struct d3d11_command_set_bindings
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    enum d3d11_command_op opcode;
+    enum d3d11_shader_stage stage;
+    enum d3d11_binding_type type;
+    UINT start_slot;
+    UINT count;
+    IUnknown *objects[1];
+};
 
-    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
-            iface, vertex_count, start_vertex_location);
+struct d3d11_command_set_cs_uavs
+{
+    enum d3d11_command_op opcode;
+    UINT start_slot;
+    UINT count;
+    BOOL has_initial_counts;
+    ID3D11UnorderedAccessView *views[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    UINT initial_counts[D3D11_PS_CS_UAV_REGISTER_COUNT];
+};
 
-    wined3d_mutex_lock();
-    wined3d_device_draw_primitive(device->wined3d_device, start_vertex_location, vertex_count);
-    wined3d_mutex_unlock();
-}
+struct d3d11_command_set_object
+{
+    enum d3d11_command_op opcode;
+    IUnknown *object;
+};
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_Map(ID3D11DeviceContext *iface, ID3D11Resource *resource,
-        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+struct d3d11_command_set_vertex_buffers
 {
-    struct wined3d_resource *wined3d_resource;
-    struct wined3d_map_desc map_desc;
-    HRESULT hr;
+    enum d3d11_command_op opcode;
+    UINT start_slot;
+    UINT count;
+    ID3D11Buffer *buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    UINT offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+};
 
-    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
-            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
+struct d3d11_command_set_index_buffer
+{
+    enum d3d11_command_op opcode;
+    ID3D11Buffer *buffer;
+    DXGI_FORMAT format;
+    UINT offset;
+};
 
-    if (map_flags)
-        FIXME("Ignoring map_flags %#x.\n", map_flags);
+struct d3d11_command_set_primitive_topology
+{
+    enum d3d11_command_op opcode;
+    D3D11_PRIMITIVE_TOPOLOGY topology;
+};
 
-    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+struct d3d11_command_set_so_targets
+{
+    enum d3d11_command_op opcode;
+    UINT count;
+    BOOL has_offsets;
+    ID3D11Buffer *buffers[D3D11_SO_BUFFER_SLOT_COUNT];
+    UINT offsets[D3D11_SO_BUFFER_SLOT_COUNT];
+};
 
-    wined3d_mutex_lock();
-    hr = wined3d_resource_map(wined3d_resource, subresource_idx,
-            &map_desc, NULL, wined3d_map_flags_from_d3d11_map_type(map_type));
-    wined3d_mutex_unlock();
+struct d3d11_command_set_viewports
+{
+    enum d3d11_command_op opcode;
+    UINT count;
+    D3D11_VIEWPORT viewports[1];
+};
 
-    mapped_subresource->pData = map_desc.data;
-    mapped_subresource->RowPitch = map_desc.row_pitch;
-    mapped_subresource->DepthPitch = map_desc.slice_pitch;
+struct d3d11_command_set_scissor_rects
+{
+    enum d3d11_command_op opcode;
+    UINT count;
+    D3D11_RECT rects[1];
+};
 
-    return hr;
-}
+struct d3d11_command_set_render_targets_and_uavs
+{
+    enum d3d11_command_op opcode;
+    UINT rtv_count;
+    ID3D11RenderTargetView *rtvs[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    ID3D11DepthStencilView *dsv;
+    UINT uav_start_slot;
+    UINT uav_count;
+    BOOL has_initial_counts;
+    ID3D11UnorderedAccessView *uavs[D3D11_PS_CS_UAV_REGISTER_COUNT];
+    UINT initial_counts[D3D11_PS_CS_UAV_REGISTER_COUNT];
+};
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Unmap(ID3D11DeviceContext *iface, ID3D11Resource *resource,
-        UINT subresource_idx)
+struct d3d11_command_set_blend_state
 {
-    struct wined3d_resource *wined3d_resource;
+    enum d3d11_command_op opcode;
+    ID3D11BlendState *state;
+    BOOL has_blend_factor;
+    float blend_factor[4];
+    UINT sample_mask;
+};
 
-    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
+struct d3d11_command_set_depth_stencil_state
+{
+    enum d3d11_command_op opcode;
+    ID3D11DepthStencilState *state;
+    UINT stencil_ref;
+};
 
-    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+struct d3d11_command_set_predication
+{
+    enum d3d11_command_op opcode;
+    ID3D11Predicate *predicate;
+    BOOL value;
+};
 
-    wined3d_mutex_lock();
-    wined3d_resource_unmap(wined3d_resource, subresource_idx);
-    wined3d_mutex_unlock();
-}
+struct d3d11_command_draw
+{
+    enum d3d11_command_op opcode;
+    UINT count;
+    UINT instance_count;
+    UINT start_idx;
+    INT base_vertex_idx;
+    UINT start_instance;
+};
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetConstantBuffers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+struct d3d11_command_draw_indirect
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    enum d3d11_command_op opcode;
+    ID3D11Buffer *buffer;
+    UINT offset;
+};
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+struct d3d11_command_dispatch
+{
+    enum d3d11_command_op opcode;
+    UINT group_count_x;
+    UINT group_count_y;
+    UINT group_count_z;
+};
 
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
+struct d3d11_command_clear_view
+{
+    enum d3d11_command_op opcode;
+    IUnknown *view;
+    union
     {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+        float f[4];
+        UINT u[4];
+    } values;
+};
 
-        wined3d_device_set_ps_cb(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL);
-    }
-    wined3d_mutex_unlock();
-}
+struct d3d11_command_clear_depth_stencil_view
+{
+    enum d3d11_command_op opcode;
+    ID3D11DepthStencilView *view;
+    UINT flags;
+    float depth;
+    UINT8 stencil;
+};
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetInputLayout(ID3D11DeviceContext *iface,
-        ID3D11InputLayout *input_layout)
+struct d3d11_command_copy_subresource_region
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_input_layout *layout = unsafe_impl_from_ID3D11InputLayout(input_layout);
+    enum d3d11_command_op opcode;
+    ID3D11Resource *dst_resource;
+    UINT dst_subresource_idx;
+    UINT dst_x, dst_y, dst_z;
+    ID3D11Resource *src_resource;
+    UINT src_subresource_idx;
+    BOOL has_src_box;
+    D3D11_BOX src_box;
+};
 
-    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+struct d3d11_command_copy_resource
+{
+    enum d3d11_command_op opcode;
+    ID3D11Resource *dst_resource;
+    ID3D11Resource *src_resource;
+};
 
-    wined3d_mutex_lock();
-    wined3d_device_set_vertex_declaration(device->wined3d_device, layout ? layout->wined3d_decl : NULL);
-    wined3d_mutex_unlock();
-}
+struct d3d11_command_update_subresource
+{
+    enum d3d11_command_op opcode;
+    ID3D11Resource *resource;
+    UINT subresource_idx;
+    BOOL has_box;
+    D3D11_BOX box;
+    UINT row_pitch;
+    UINT depth_pitch;
+    BYTE data[1];
+};
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetVertexBuffers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+struct d3d11_command_copy_structure_count
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    enum d3d11_command_op opcode;
+    ID3D11Buffer *dst_buffer;
+    UINT dst_offset;
+    ID3D11UnorderedAccessView *src_view;
+};
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
-            iface, start_slot, buffer_count, buffers, strides, offsets);
+struct d3d11_command_resolve_subresource
+{
+    enum d3d11_command_op opcode;
+    ID3D11Resource *dst_resource;
+    UINT dst_subresource_idx;
+    ID3D11Resource *src_resource;
+    UINT src_subresource_idx;
+    DXGI_FORMAT format;
+};
 
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+struct d3d11_command_set_resource_min_lod
+{
+    enum d3d11_command_op opcode;
+    ID3D11Resource *resource;
+    float min_lod;
+};
 
-        wined3d_device_set_stream_source(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL, offsets[i], strides[i]);
-    }
-    wined3d_mutex_unlock();
+struct d3d11_command_write_mapped
+{
+    enum d3d11_command_op opcode;
+    ID3D11Resource *resource;
+    UINT subresource_idx;
+    D3D11_MAP map_type;
+    UINT row_pitch;
+    UINT depth_pitch;
+    SIZE_T size;
+    BYTE data[1];
+};
+
+struct d3d11_command_execute_command_list
+{
+    enum d3d11_command_op opcode;
+    ID3D11CommandList *command_list;
+    BOOL restore_state;
+};
+
+static void d3d11_command_exec_clear_state(ID3D11DeviceContext *context, const void *data)
+{
+    ID3D11DeviceContext_ClearState(context);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetIndexBuffer(ID3D11DeviceContext *iface,
-        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+static void d3d11_command_exec_set_shader(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_buffer *buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
+    const struct d3d11_command_set_shader *op = data;
 
-    TRACE("iface %p, buffer %p, format %s, offset %u.\n",
-            iface, buffer, debug_dxgi_format(format), offset);
+    d3d11_context_set_shader(context, op->stage, op->shader);
+}
 
-    wined3d_mutex_lock();
-    wined3d_device_set_index_buffer(device->wined3d_device,
-            buffer_impl ? buffer_impl->wined3d_buffer : NULL,
-            wined3dformat_from_dxgi_format(format), offset);
-    wined3d_mutex_unlock();
+static void d3d11_command_exec_set_bindings(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_bindings *op = data;
+
+    d3d11_context_set_bindings(context, op->stage, op->type, op->start_slot, op->count, op->objects);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstanced(ID3D11DeviceContext *iface,
-        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
-        UINT start_instance_location)
+static void d3d11_command_exec_set_cs_uavs(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    const struct d3d11_command_set_cs_uavs *op = data;
 
-    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
-            "base_vertex_location %d, start_instance_location %u.\n",
-            iface, instance_index_count, instance_count, start_index_location,
-            base_vertex_location, start_instance_location);
+    ID3D11DeviceContext_CSSetUnorderedAccessViews(context, op->start_slot, op->count,
+            op->views, op->has_initial_counts ? op->initial_counts : NULL);
+}
 
-    wined3d_mutex_lock();
-    wined3d_device_set_base_vertex_index(device->wined3d_device, base_vertex_location);
-    wined3d_device_draw_indexed_primitive_instanced(device->wined3d_device, start_index_location,
-            instance_index_count, start_instance_location, instance_count);
-    wined3d_mutex_unlock();
+static void d3d11_command_exec_set_input_layout(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_object *op = data;
+
+    ID3D11DeviceContext_IASetInputLayout(context, (ID3D11InputLayout *)op->object);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstanced(ID3D11DeviceContext *iface,
-        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
+static void d3d11_command_exec_set_vertex_buffers(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    const struct d3d11_command_set_vertex_buffers *op = data;
 
-    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
-            "start_instance_location %u.\n",
-            iface, instance_vertex_count, instance_count, start_vertex_location,
-            start_instance_location);
+    ID3D11DeviceContext_IASetVertexBuffers(context, op->start_slot, op->count,
+            op->buffers, op->strides, op->offsets);
+}
 
-    wined3d_mutex_lock();
-    wined3d_device_draw_primitive_instanced(device->wined3d_device, start_vertex_location,
-            instance_vertex_count, start_instance_location, instance_count);
-    wined3d_mutex_unlock();
+static void d3d11_command_exec_set_index_buffer(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_index_buffer *op = data;
+
+    ID3D11DeviceContext_IASetIndexBuffer(context, op->buffer, op->format, op->offset);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetConstantBuffers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+static void d3d11_command_exec_set_primitive_topology(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    const struct d3d11_command_set_primitive_topology *op = data;
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
+    ID3D11DeviceContext_IASetPrimitiveTopology(context, op->topology);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+static void d3d11_command_exec_set_so_targets(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_so_targets *op = data;
 
-        wined3d_device_set_gs_cb(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL);
-    }
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_SOSetTargets(context, op->count, op->buffers, op->has_offsets ? op->offsets : NULL);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShader(ID3D11DeviceContext *iface,
-        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+static void d3d11_command_exec_set_rasterizer_state(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_geometry_shader *gs = unsafe_impl_from_ID3D11GeometryShader(shader);
+    const struct d3d11_command_set_object *op = data;
 
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
-            iface, shader, class_instances, class_instance_count);
+    ID3D11DeviceContext_RSSetState(context, (ID3D11RasterizerState *)op->object);
+}
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
+static void d3d11_command_exec_set_viewports(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_viewports *op = data;
 
-    wined3d_mutex_lock();
-    wined3d_device_set_geometry_shader(device->wined3d_device, gs ? gs->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_RSSetViewports(context, op->count, op->viewports);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IASetPrimitiveTopology(ID3D11DeviceContext *iface,
-        D3D11_PRIMITIVE_TOPOLOGY topology)
+static void d3d11_command_exec_set_scissor_rects(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    enum wined3d_primitive_type primitive_type;
-    unsigned int patch_vertex_count;
+    const struct d3d11_command_set_scissor_rects *op = data;
 
-    TRACE("iface %p, topology %#x.\n", iface, topology);
+    ID3D11DeviceContext_RSSetScissorRects(context, op->count, op->rects);
+}
 
-    wined3d_primitive_type_from_d3d11_primitive_topology(topology, &primitive_type, &patch_vertex_count);
+static void d3d11_command_exec_set_render_targets_and_uavs(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_render_targets_and_uavs *op = data;
 
-    wined3d_mutex_lock();
-    wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, patch_vertex_count);
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_OMSetRenderTargetsAndUnorderedAccessViews(context, op->rtv_count, op->rtvs, op->dsv,
+            op->uav_start_slot, op->uav_count, op->uavs, op->has_initial_counts ? op->initial_counts : NULL);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShaderResources(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static void d3d11_command_exec_set_blend_state(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    const struct d3d11_command_set_blend_state *op = data;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+    ID3D11DeviceContext_OMSetBlendState(context, op->state,
+            op->has_blend_factor ? op->blend_factor : NULL, op->sample_mask);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+static void d3d11_command_exec_set_depth_stencil_state(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_depth_stencil_state *op = data;
 
-        wined3d_device_set_vs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
-    }
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_OMSetDepthStencilState(context, op->state, op->stencil_ref);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetSamplers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void d3d11_command_exec_set_predication(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    const struct d3d11_command_set_predication *op = data;
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    ID3D11DeviceContext_SetPredication(context, op->predicate, op->value);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+static void d3d11_command_exec_draw(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_draw *op = data;
 
-        wined3d_device_set_vs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_Draw(context, op->count, op->start_idx);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Begin(ID3D11DeviceContext *iface,
-        ID3D11Asynchronous *asynchronous)
+static void d3d11_command_exec_draw_indexed(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
-    HRESULT hr;
+    const struct d3d11_command_draw *op = data;
 
-    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+    ID3D11DeviceContext_DrawIndexed(context, op->count, op->start_idx, op->base_vertex_idx);
+}
 
-    wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_query_issue(query->wined3d_query, WINED3DISSUE_BEGIN)))
-        ERR("Failed to issue query, hr %#x.\n", hr);
-    wined3d_mutex_unlock();
+static void d3d11_command_exec_draw_instanced(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_draw *op = data;
+
+    ID3D11DeviceContext_DrawInstanced(context, op->count, op->instance_count, op->start_idx, op->start_instance);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_End(ID3D11DeviceContext *iface,
-        ID3D11Asynchronous *asynchronous)
+static void d3d11_command_exec_draw_indexed_instanced(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
-    HRESULT hr;
+    const struct d3d11_command_draw *op = data;
 
-    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+    ID3D11DeviceContext_DrawIndexedInstanced(context, op->count, op->instance_count,
+            op->start_idx, op->base_vertex_idx, op->start_instance);
+}
 
-    wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_query_issue(query->wined3d_query, WINED3DISSUE_END)))
-        ERR("Failed to issue query, hr %#x.\n", hr);
-    wined3d_mutex_unlock();
+static void d3d11_command_exec_draw_auto(ID3D11DeviceContext *context, const void *data)
+{
+    ID3D11DeviceContext_DrawAuto(context);
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetData(ID3D11DeviceContext *iface,
-        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
+static void d3d11_command_exec_draw_instanced_indirect(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
-    unsigned int wined3d_flags;
-    HRESULT hr;
+    const struct d3d11_command_draw_indirect *op = data;
 
-    TRACE("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x.\n",
-            iface, asynchronous, data, data_size, data_flags);
+    ID3D11DeviceContext_DrawInstancedIndirect(context, op->buffer, op->offset);
+}
 
-    if (!data && data_size)
-        return E_INVALIDARG;
+static void d3d11_command_exec_draw_indexed_instanced_indirect(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_draw_indirect *op = data;
 
-    wined3d_flags = wined3d_getdata_flags_from_d3d11_async_getdata_flags(data_flags);
+    ID3D11DeviceContext_DrawIndexedInstancedIndirect(context, op->buffer, op->offset);
+}
 
-    wined3d_mutex_lock();
-    if (!data_size || wined3d_query_get_data_size(query->wined3d_query) == data_size)
-    {
-        hr = wined3d_query_get_data(query->wined3d_query, data, data_size, wined3d_flags);
-        if (hr == WINED3DERR_INVALIDCALL)
-            hr = DXGI_ERROR_INVALID_CALL;
-    }
-    else
-    {
-        WARN("Invalid data size %u.\n", data_size);
-        hr = E_INVALIDARG;
-    }
-    wined3d_mutex_unlock();
+static void d3d11_command_exec_dispatch(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_dispatch *op = data;
 
-    return hr;
+    ID3D11DeviceContext_Dispatch(context, op->group_count_x, op->group_count_y, op->group_count_z);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SetPredication(ID3D11DeviceContext *iface,
-        ID3D11Predicate *predicate, BOOL value)
+static void d3d11_command_exec_dispatch_indirect(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_query *query;
+    const struct d3d11_command_draw_indirect *op = data;
 
-    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
+    ID3D11DeviceContext_DispatchIndirect(context, op->buffer, op->offset);
+}
 
-    query = unsafe_impl_from_ID3D11Query((ID3D11Query *)predicate);
+static void d3d11_command_exec_clear_render_target_view(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_clear_view *op = data;
 
-    wined3d_mutex_lock();
-    wined3d_device_set_predication(device->wined3d_device, query ? query->wined3d_query : NULL, value);
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_ClearRenderTargetView(context, (ID3D11RenderTargetView *)op->view, op->values.f);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShaderResources(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+static void d3d11_command_exec_clear_depth_stencil_view(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    const struct d3d11_command_clear_depth_stencil_view *op = data;
 
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+    ID3D11DeviceContext_ClearDepthStencilView(context, op->view, op->flags, op->depth, op->stencil);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+static void d3d11_command_exec_clear_uav_uint(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_clear_view *op = data;
 
-        wined3d_device_set_gs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
-    }
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_ClearUnorderedAccessViewUint(context,
+            (ID3D11UnorderedAccessView *)op->view, op->values.u);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetSamplers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+static void d3d11_command_exec_clear_uav_float(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    const struct d3d11_command_clear_view *op = data;
 
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    ID3D11DeviceContext_ClearUnorderedAccessViewFloat(context,
+            (ID3D11UnorderedAccessView *)op->view, op->values.f);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+static void d3d11_command_exec_copy_subresource_region(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_copy_subresource_region *op = data;
 
-        wined3d_device_set_gs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_CopySubresourceRegion(context, op->dst_resource, op->dst_subresource_idx,
+            op->dst_x, op->dst_y, op->dst_z, op->src_resource, op->src_subresource_idx,
+            op->has_src_box ? &op->src_box : NULL);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargets(ID3D11DeviceContext *iface,
-        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
-        ID3D11DepthStencilView *depth_stencil_view)
+static void d3d11_command_exec_copy_resource(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_depthstencil_view *dsv;
-    unsigned int i;
+    const struct d3d11_command_copy_resource *op = data;
 
-    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
-            iface, render_target_view_count, render_target_views, depth_stencil_view);
+    ID3D11DeviceContext_CopyResource(context, op->dst_resource, op->src_resource);
+}
 
-    wined3d_mutex_lock();
-    for (i = 0; i < render_target_view_count; ++i)
-    {
-        struct d3d_rendertarget_view *rtv = unsafe_impl_from_ID3D11RenderTargetView(render_target_views[i]);
-        wined3d_device_set_rendertarget_view(device->wined3d_device, i, rtv ? rtv->wined3d_view : NULL, FALSE);
-    }
-    for (; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
-    {
-        wined3d_device_set_rendertarget_view(device->wined3d_device, i, NULL, FALSE);
-    }
+static void d3d11_command_exec_update_subresource(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_update_subresource *op = data;
 
-    dsv = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
-    wined3d_device_set_depth_stencil_view(device->wined3d_device, dsv ? dsv->wined3d_view : NULL);
-    wined3d_mutex_unlock();
+    ID3D11DeviceContext_UpdateSubresource(context, op->resource, op->subresource_idx,
+            op->has_box ? &op->box : NULL, op->data, op->row_pitch, op->depth_pitch);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews(
-        ID3D11DeviceContext *iface, UINT render_target_view_count,
-        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
-        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
-        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
+static void d3d11_command_exec_copy_structure_count(ID3D11DeviceContext *context, const void *data)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    const struct d3d11_command_copy_structure_count *op = data;
 
-    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
-            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
-            "initial_counts %p.\n",
-            iface, render_target_view_count, render_target_views, depth_stencil_view,
-            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
-            initial_counts);
+    ID3D11DeviceContext_CopyStructureCount(context, op->dst_buffer, op->dst_offset, op->src_view);
+}
 
-    if (render_target_view_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+static void d3d11_command_exec_resolve_subresource(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_resolve_subresource *op = data;
+
+    ID3D11DeviceContext_ResolveSubresource(context, op->dst_resource, op->dst_subresource_idx,
+            op->src_resource, op->src_subresource_idx, op->format);
+}
+
+static void d3d11_command_exec_generate_mips(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_object *op = data;
+
+    ID3D11DeviceContext_GenerateMips(context, (ID3D11ShaderResourceView *)op->object);
+}
+
+static void d3d11_command_exec_set_resource_min_lod(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_resource_min_lod *op = data;
+
+    ID3D11DeviceContext_SetResourceMinLOD(context, op->resource, op->min_lod);
+}
+
+static void d3d11_command_exec_write_mapped(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_write_mapped *op = data;
+    D3D11_MAPPED_SUBRESOURCE map_desc;
+    unsigned int row_count, slice_count, row_size, y, z;
+    const BYTE *src;
+    BYTE *dst;
+    HRESULT hr;
+
+    if (FAILED(hr = ID3D11DeviceContext_Map(context, op->resource, op->subresource_idx,
+            op->map_type, 0, &map_desc)))
     {
-        d3d11_immediate_context_OMSetRenderTargets(iface, render_target_view_count, render_target_views,
-                depth_stencil_view);
+        ERR("Failed to map resource %p, hr %#x.\n", op->resource, hr);
+        return;
     }
 
-    if (unordered_access_view_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+    if (map_desc.RowPitch == op->row_pitch && map_desc.DepthPitch == op->depth_pitch)
     {
-        wined3d_mutex_lock();
-        for (i = 0; i < unordered_access_view_start_slot; ++i)
+        memcpy(map_desc.pData, op->data, op->size);
+    }
+    else
+    {
+        row_count = op->depth_pitch / op->row_pitch;
+        slice_count = op->size / op->depth_pitch;
+        row_size = min(map_desc.RowPitch, op->row_pitch);
+        for (z = 0; z < slice_count; ++z)
         {
-            wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
+            src = &op->data[z * op->depth_pitch];
+            dst = (BYTE *)map_desc.pData + z * map_desc.DepthPitch;
+            for (y = 0; y < row_count; ++y)
+            {
+                memcpy(dst, src, row_size);
+                src += op->row_pitch;
+                dst += map_desc.RowPitch;
+            }
         }
-        for (i = 0; i < unordered_access_view_count; ++i)
-        {
-            struct d3d11_unordered_access_view *view
-                    = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_views[i]);
+    }
 
-            wined3d_device_set_unordered_access_view(device->wined3d_device,
-                    unordered_access_view_start_slot + i,
-                    view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
-        }
-        for (; unordered_access_view_start_slot + i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
+    ID3D11DeviceContext_Unmap(context, op->resource, op->subresource_idx);
+}
+
+static void d3d11_command_exec_begin(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_object *op = data;
+
+    ID3D11DeviceContext_Begin(context, (ID3D11Asynchronous *)op->object);
+}
+
+static void d3d11_command_exec_end(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_set_object *op = data;
+
+    ID3D11DeviceContext_End(context, (ID3D11Asynchronous *)op->object);
+}
+
+static void d3d11_command_exec_execute_command_list(ID3D11DeviceContext *context, const void *data)
+{
+    const struct d3d11_command_execute_command_list *op = data;
+
+    ID3D11DeviceContext_ExecuteCommandList(context, op->command_list, op->restore_state);
+}
+
+static void (* const d3d11_command_handlers[])(ID3D11DeviceContext *context, const void *data) =
+{
+    /* D3D11_COMMAND_CLEAR_STATE                        */ d3d11_command_exec_clear_state,
+    /* D3D11_COMMAND_SET_SHADER                         */ d3d11_command_exec_set_shader,
+    /* D3D11_COMMAND_SET_BINDINGS                       */ d3d11_command_exec_set_bindings,
+    /* D3D11_COMMAND_SET_CS_UAVS                        */ d3d11_command_exec_set_cs_uavs,
+    /* D3D11_COMMAND_SET_INPUT_LAYOUT                   */ d3d11_command_exec_set_input_layout,
+    /* D3D11_COMMAND_SET_VERTEX_BUFFERS                 */ d3d11_command_exec_set_vertex_buffers,
+    /* D3D11_COMMAND_SET_INDEX_BUFFER                   */ d3d11_command_exec_set_index_buffer,
+    /* D3D11_COMMAND_SET_PRIMITIVE_TOPOLOGY             */ d3d11_command_exec_set_primitive_topology,
+    /* D3D11_COMMAND_SET_SO_TARGETS                     */ d3d11_command_exec_set_so_targets,
+    /* D3D11_COMMAND_SET_RASTERIZER_STATE               */ d3d11_command_exec_set_rasterizer_state,
+    /* D3D11_COMMAND_SET_VIEWPORTS                      */ d3d11_command_exec_set_viewports,
+    /* D3D11_COMMAND_SET_SCISSOR_RECTS                  */ d3d11_command_exec_set_scissor_rects,
+    /* D3D11_COMMAND_SET_RENDER_TARGETS_AND_UAVS        */ d3d11_command_exec_set_render_targets_and_uavs,
+    /* D3D11_COMMAND_SET_BLEND_STATE                    */ d3d11_command_exec_set_blend_state,
+    /* D3D11_COMMAND_SET_DEPTH_STENCIL_STATE            */ d3d11_command_exec_set_depth_stencil_state,
+    /* D3D11_COMMAND_SET_PREDICATION                    */ d3d11_command_exec_set_predication,
+    /* D3D11_COMMAND_DRAW                               */ d3d11_command_exec_draw,
+    /* D3D11_COMMAND_DRAW_INDEXED                       */ d3d11_command_exec_draw_indexed,
+    /* D3D11_COMMAND_DRAW_INSTANCED                     */ d3d11_command_exec_draw_instanced,
+    /* D3D11_COMMAND_DRAW_INDEXED_INSTANCED             */ d3d11_command_exec_draw_indexed_instanced,
+    /* D3D11_COMMAND_DRAW_AUTO                          */ d3d11_command_exec_draw_auto,
+    /* D3D11_COMMAND_DRAW_INSTANCED_INDIRECT            */ d3d11_command_exec_draw_instanced_indirect,
+    /* D3D11_COMMAND_DRAW_INDEXED_INSTANCED_INDIRECT    */ d3d11_command_exec_draw_indexed_instanced_indirect,
+    /* D3D11_COMMAND_DISPATCH                           */ d3d11_command_exec_dispatch,
+    /* D3D11_COMMAND_DISPATCH_INDIRECT                  */ d3d11_command_exec_dispatch_indirect,
+    /* D3D11_COMMAND_CLEAR_RENDER_TARGET_VIEW           */ d3d11_command_exec_clear_render_target_view,
+    /* D3D11_COMMAND_CLEAR_DEPTH_STENCIL_VIEW           */ d3d11_command_exec_clear_depth_stencil_view,
+    /* D3D11_COMMAND_CLEAR_UAV_UINT                     */ d3d11_command_exec_clear_uav_uint,
+    /* D3D11_COMMAND_CLEAR_UAV_FLOAT                    */ d3d11_command_exec_clear_uav_float,
+    /* D3D11_COMMAND_COPY_SUBRESOURCE_REGION            */ d3d11_command_exec_copy_subresource_region,
+    /* D3D11_COMMAND_COPY_RESOURCE                      */ d3d11_command_exec_copy_resource,
+    /* D3D11_COMMAND_UPDATE_SUBRESOURCE                 */ d3d11_command_exec_update_subresource,
+    /* D3D11_COMMAND_COPY_STRUCTURE_COUNT               */ d3d11_command_exec_copy_structure_count,
+    /* D3D11_COMMAND_RESOLVE_SUBRESOURCE                */ d3d11_command_exec_resolve_subresource,
+    /* D3D11_COMMAND_GENERATE_MIPS                      */ d3d11_command_exec_generate_mips,
+    /* D3D11_COMMAND_SET_RESOURCE_MIN_LOD               */ d3d11_command_exec_set_resource_min_lod,
+    /* D3D11_COMMAND_WRITE_MAPPED                       */ d3d11_command_exec_write_mapped,
+    /* D3D11_COMMAND_BEGIN                              */ d3d11_command_exec_begin,
+    /* D3D11_COMMAND_END                                */ d3d11_command_exec_end,
+    /* D3D11_COMMAND_EXECUTE_COMMAND_LIST               */ d3d11_command_exec_execute_command_list,
+};
+
+static void d3d11_command_list_execute(const struct d3d11_command_list *list, ID3D11DeviceContext *context)
+{
+    const struct d3d11_command_packet *packet;
+    enum d3d11_command_op opcode;
+    SIZE_T offset = 0;
+
+    while (offset < list->data_size)
+    {
+        packet = (const struct d3d11_command_packet *)&list->data[offset];
+        opcode = *(const enum d3d11_command_op *)packet->data;
+
+        if (opcode >= D3D11_COMMAND_STOP)
         {
-            wined3d_device_set_unordered_access_view(device->wined3d_device,
-                    unordered_access_view_start_slot + i, NULL, ~0u);
+            ERR("Invalid opcode %#x.\n", opcode);
+            break;
         }
-        wined3d_mutex_unlock();
+
+        d3d11_command_handlers[opcode](context, packet->data);
+        offset += packet->size;
     }
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetBlendState(ID3D11DeviceContext *iface,
-        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
+/* Reserves space for a packet of "size" bytes, along with room for
+ * "object_count" more object references, so that recording a command
+ * can't fail halfway through. */
+static void *d3d11_command_list_require_space(struct d3d11_command_list *list,
+        enum d3d11_command_op opcode, SIZE_T size, SIZE_T object_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    static const float default_blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    struct d3d_blend_state *blend_state_impl;
-    const D3D11_BLEND_DESC *desc;
+    struct d3d11_command_packet *packet;
+    SIZE_T packet_size;
 
-    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
-            iface, blend_state, debug_float4(blend_factor), sample_mask);
+    packet_size = FIELD_OFFSET(struct d3d11_command_packet, data[size]);
+    packet_size = (packet_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
 
-    if (!blend_factor)
-        blend_factor = default_blend_factor;
+    if (!d3d_array_reserve((void **)&list->data, &list->data_capacity,
+            list->data_size + packet_size, sizeof(*list->data))
+            || !d3d_array_reserve((void **)&list->objects, &list->objects_size,
+            list->object_count + object_count, sizeof(*list->objects)))
+    {
+        ERR("Failed to allocate %lu bytes for command %#x.\n", (ULONG_PTR)packet_size, opcode);
+        return NULL;
+    }
 
-    wined3d_mutex_lock();
-    memcpy(device->blend_factor, blend_factor, 4 * sizeof(*blend_factor));
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEMASK, sample_mask);
-    if (!(blend_state_impl = unsafe_impl_from_ID3D11BlendState(blend_state)))
+    packet = (struct d3d11_command_packet *)&list->data[list->data_size];
+    packet->size = packet_size;
+    list->data_size += packet_size;
+    *(enum d3d11_command_op *)packet->data = opcode;
+
+    return packet->data;
+}
+
+static void d3d11_command_list_add_objects(struct d3d11_command_list *list,
+        IUnknown *const *objects, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i)
     {
-        wined3d_device_set_blend_state(device->wined3d_device, NULL);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ALPHABLENDENABLE, FALSE);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE1, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE2, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_device_set_render_state(device->wined3d_device,
-                WINED3D_RS_COLORWRITEENABLE3, D3D11_COLOR_WRITE_ENABLE_ALL);
-        wined3d_mutex_unlock();
-        return;
+        if (!objects[i])
+            continue;
+        assert(list->object_count < list->objects_size);
+        IUnknown_AddRef(objects[i]);
+        list->objects[list->object_count++] = objects[i];
     }
+}
 
-    wined3d_device_set_blend_state(device->wined3d_device, blend_state_impl->wined3d_state);
-    desc = &blend_state_impl->desc;
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ALPHABLENDENABLE,
-            desc->RenderTarget[0].BlendEnable);
-    if (desc->RenderTarget[0].BlendEnable)
+static void d3d11_command_list_add_object(struct d3d11_command_list *list, void *object)
+{
+    IUnknown *unknown = object;
+
+    d3d11_command_list_add_objects(list, &unknown, 1);
+}
+
+static inline struct d3d11_command_list *impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_command_list, ID3D11CommandList_iface);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_QueryInterface(ID3D11CommandList *iface,
+        REFIID riid, void **out)
+{
+    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+
+    if (IsEqualGUID(riid, &IID_ID3D11CommandList)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(riid, &IID_IUnknown))
     {
-        const D3D11_RENDER_TARGET_BLEND_DESC *d = &desc->RenderTarget[0];
+        ID3D11CommandList_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
 
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SRCBLEND, d->SrcBlend);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DESTBLEND, d->DestBlend);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BLENDOP, d->BlendOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SEPARATEALPHABLENDENABLE, TRUE);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SRCBLENDALPHA, d->SrcBlendAlpha);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DESTBLENDALPHA, d->DestBlendAlpha);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BLENDOPALPHA, d->BlendOpAlpha);
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_AddRef(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedIncrement(&list->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
+
+    return refcount;
+}
+
+static void d3d11_command_list_destroy(struct d3d11_command_list *list)
+{
+    ID3D11Device *device = list->device;
+
+    if (list->initial_state)
+    {
+        d3d11_context_state_cleanup(list->initial_state);
+        heap_free(list->initial_state);
+    }
+    d3d11_objects_release(list->objects, list->object_count);
+    heap_free(list->objects);
+    heap_free(list->data);
+    wined3d_private_store_cleanup(&list->private_store);
+    heap_free(list);
+
+    ID3D11Device_Release(device);
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_command_list_Release(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
+        d3d11_command_list_destroy(list);
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_command_list_GetDevice(ID3D11CommandList *iface, ID3D11Device **device)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = list->device;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_GetPrivateData(ID3D11CommandList *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateData(ID3D11CommandList *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&list->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_command_list_SetPrivateDataInterface(ID3D11CommandList *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&list->private_store, guid, data);
+}
+
+static UINT STDMETHODCALLTYPE d3d11_command_list_GetContextFlags(ID3D11CommandList *iface)
+{
+    struct d3d11_command_list *list = impl_from_ID3D11CommandList(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    return list->flags;
+}
+
+static const struct ID3D11CommandListVtbl d3d11_command_list_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_command_list_QueryInterface,
+    d3d11_command_list_AddRef,
+    d3d11_command_list_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_command_list_GetDevice,
+    d3d11_command_list_GetPrivateData,
+    d3d11_command_list_SetPrivateData,
+    d3d11_command_list_SetPrivateDataInterface,
+    /* ID3D11CommandList methods */
+    d3d11_command_list_GetContextFlags,
+};
+
+static HRESULT d3d11_command_list_create(ID3D11Device *device, UINT flags, struct d3d11_command_list **list)
+{
+    struct d3d11_command_list *object;
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->ID3D11CommandList_iface.lpVtbl = &d3d11_command_list_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->flags = flags;
+    ID3D11Device_AddRef(object->device = device);
+
+    TRACE("Created command list %p.\n", object);
+    *list = object;
+
+    return S_OK;
+}
+
+struct d3d11_command_list *unsafe_impl_from_ID3D11CommandList(ID3D11CommandList *iface)
+{
+    if (!iface)
+        return NULL;
+    assert(iface->lpVtbl == &d3d11_command_list_vtbl);
+    return impl_from_ID3D11CommandList(iface);
+}
+
+/* ID3D11DeviceContext - immediate context methods */
+
+static inline struct d3d11_immediate_context *impl_from_ID3D11DeviceContext(ID3D11DeviceContext *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_immediate_context, ID3D11DeviceContext_iface);
+}
+
+static inline struct d3d_device *device_from_immediate_ID3D11DeviceContext(ID3D11DeviceContext *iface)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+    return CONTAINING_RECORD(context, struct d3d_device, immediate_context);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_QueryInterface(ID3D11DeviceContext *iface,
+        REFIID riid, void **out)
+{
+    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+
+    if (IsEqualGUID(riid, &IID_ID3D11DeviceContext)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(riid, &IID_IUnknown))
+    {
+        ID3D11DeviceContext_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_immediate_context_AddRef(ID3D11DeviceContext *iface)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    ULONG refcount = InterlockedIncrement(&context->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", context, refcount);
+
+    if (refcount == 1)
+    {
+        ID3D11Device_AddRef(&device->ID3D11Device_iface);
+    }
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_immediate_context_Release(ID3D11DeviceContext *iface)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    ULONG refcount = InterlockedDecrement(&context->refcount);
+
+    TRACE("%p decreasing refcount to %u.\n", context, refcount);
+
+    if (!refcount)
+    {
+        ID3D11Device_Release(&device->ID3D11Device_iface);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GetDevice(ID3D11DeviceContext *iface, ID3D11Device **device)
+{
+    struct d3d_device *device_object = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = &device_object->ID3D11Device_iface;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_SetPrivateDataInterface(ID3D11DeviceContext *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_immediate_context *context = impl_from_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&context->private_store, guid, data);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_vs_cb(device->wined3d_device, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+
+        wined3d_device_set_ps_resource_view(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetShader(ID3D11DeviceContext *iface,
+        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_pixel_shader *ps = unsafe_impl_from_ID3D11PixelShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    wined3d_device_set_pixel_shader(device->wined3d_device, ps ? ps->wined3d_shader : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+
+        wined3d_device_set_ps_sampler(device->wined3d_device, start_slot + i,
+                sampler ? sampler->wined3d_sampler : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShader(ID3D11DeviceContext *iface,
+        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_vertex_shader *vs = unsafe_impl_from_ID3D11VertexShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    wined3d_device_set_vertex_shader(device->wined3d_device, vs ? vs->wined3d_shader : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexed(ID3D11DeviceContext *iface,
+        UINT index_count, UINT start_index_location, INT base_vertex_location)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
+            iface, index_count, start_index_location, base_vertex_location);
+
+    wined3d_mutex_lock();
+    wined3d_device_set_base_vertex_index(device->wined3d_device, base_vertex_location);
+    wined3d_device_draw_indexed_primitive(device->wined3d_device, start_index_location, index_count);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_Draw(ID3D11DeviceContext *iface,
+        UINT vertex_count, UINT start_vertex_location)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
+            iface, vertex_count, start_vertex_location);
+
+    wined3d_mutex_lock();
+    wined3d_device_draw_primitive(device->wined3d_device, start_vertex_location, vertex_count);
+    wined3d_mutex_unlock();
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_Map(ID3D11DeviceContext *iface, ID3D11Resource *resource,
+        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+{
+    struct wined3d_resource *wined3d_resource;
+    struct wined3d_map_desc map_desc;
+    HRESULT hr;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
+            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
+
+    if (map_flags)
+        FIXME("Ignoring map_flags %#x.\n", map_flags);
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+
+    wined3d_mutex_lock();
+    hr = wined3d_resource_map(wined3d_resource, subresource_idx,
+            &map_desc, NULL, wined3d_map_flags_from_d3d11_map_type(map_type));
+    wined3d_mutex_unlock();
+
+    mapped_subresource->pData = map_desc.data;
+    mapped_subresource->RowPitch = map_desc.row_pitch;
+    mapped_subresource->DepthPitch = map_desc.slice_pitch;
+
+    return hr;
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_Unmap(ID3D11DeviceContext *iface, ID3D11Resource *resource,
+        UINT subresource_idx)
+{
+    struct wined3d_resource *wined3d_resource;
+
+    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+
+    wined3d_mutex_lock();
+    wined3d_resource_unmap(wined3d_resource, subresource_idx);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_ps_cb(device->wined3d_device, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetInputLayout(ID3D11DeviceContext *iface,
+        ID3D11InputLayout *input_layout)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_input_layout *layout = unsafe_impl_from_ID3D11InputLayout(input_layout);
+
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+
+    wined3d_mutex_lock();
+    wined3d_device_set_vertex_declaration(device->wined3d_device, layout ? layout->wined3d_decl : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetVertexBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_stream_source(device->wined3d_device, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL, offsets[i], strides[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetIndexBuffer(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_buffer *buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
+
+    TRACE("iface %p, buffer %p, format %s, offset %u.\n",
+            iface, buffer, debug_dxgi_format(format), offset);
+
+    wined3d_mutex_lock();
+    wined3d_device_set_index_buffer(device->wined3d_device,
+            buffer_impl ? buffer_impl->wined3d_buffer : NULL,
+            wined3dformat_from_dxgi_format(format), offset);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstanced(ID3D11DeviceContext *iface,
+        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
+        UINT start_instance_location)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, instance_index_count, instance_count, start_index_location,
+            base_vertex_location, start_instance_location);
+
+    wined3d_mutex_lock();
+    wined3d_device_set_base_vertex_index(device->wined3d_device, base_vertex_location);
+    wined3d_device_draw_indexed_primitive_instanced(device->wined3d_device, start_index_location,
+            instance_index_count, start_instance_location, instance_count);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstanced(ID3D11DeviceContext *iface,
+        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
+            "start_instance_location %u.\n",
+            iface, instance_vertex_count, instance_count, start_vertex_location,
+            start_instance_location);
+
+    wined3d_mutex_lock();
+    wined3d_device_draw_primitive_instanced(device->wined3d_device, start_vertex_location,
+            instance_vertex_count, start_instance_location, instance_count);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_gs_cb(device->wined3d_device, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShader(ID3D11DeviceContext *iface,
+        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_geometry_shader *gs = unsafe_impl_from_ID3D11GeometryShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    wined3d_device_set_geometry_shader(device->wined3d_device, gs ? gs->wined3d_shader : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IASetPrimitiveTopology(ID3D11DeviceContext *iface,
+        D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    enum wined3d_primitive_type primitive_type;
+    unsigned int patch_vertex_count;
+
+    TRACE("iface %p, topology %#x.\n", iface, topology);
+
+    wined3d_primitive_type_from_d3d11_primitive_topology(topology, &primitive_type, &patch_vertex_count);
+
+    wined3d_mutex_lock();
+    wined3d_device_set_primitive_type(device->wined3d_device, primitive_type, patch_vertex_count);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+
+        wined3d_device_set_vs_resource_view(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+
+        wined3d_device_set_vs_sampler(device->wined3d_device, start_slot + i,
+                sampler ? sampler->wined3d_sampler : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_Begin(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
+    HRESULT hr;
+
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    wined3d_mutex_lock();
+    if (FAILED(hr = wined3d_query_issue(query->wined3d_query, WINED3DISSUE_BEGIN)))
+        ERR("Failed to issue query, hr %#x.\n", hr);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_End(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
+    HRESULT hr;
+
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    wined3d_mutex_lock();
+    if (FAILED(hr = wined3d_query_issue(query->wined3d_query, WINED3DISSUE_END)))
+        ERR("Failed to issue query, hr %#x.\n", hr);
+    wined3d_mutex_unlock();
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_GetData(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
+{
+    struct d3d_query *query = unsafe_impl_from_ID3D11Asynchronous(asynchronous);
+    unsigned int wined3d_flags;
+    HRESULT hr;
+
+    TRACE("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x.\n",
+            iface, asynchronous, data, data_size, data_flags);
+
+    if (!data && data_size)
+        return E_INVALIDARG;
+
+    wined3d_flags = wined3d_getdata_flags_from_d3d11_async_getdata_flags(data_flags);
+
+    wined3d_mutex_lock();
+    if (!data_size || wined3d_query_get_data_size(query->wined3d_query) == data_size)
+    {
+        hr = wined3d_query_get_data(query->wined3d_query, data, data_size, wined3d_flags);
+        if (hr == WINED3DERR_INVALIDCALL)
+            hr = DXGI_ERROR_INVALID_CALL;
+    }
+    else
+    {
+        WARN("Invalid data size %u.\n", data_size);
+        hr = E_INVALIDARG;
+    }
+    wined3d_mutex_unlock();
+
+    return hr;
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_SetPredication(ID3D11DeviceContext *iface,
+        ID3D11Predicate *predicate, BOOL value)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_query *query;
+
+    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
+
+    query = unsafe_impl_from_ID3D11Query((ID3D11Query *)predicate);
+
+    wined3d_mutex_lock();
+    wined3d_device_set_predication(device->wined3d_device, query ? query->wined3d_query : NULL, value);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+
+        wined3d_device_set_gs_resource_view(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+
+        wined3d_device_set_gs_sampler(device->wined3d_device, start_slot + i,
+                sampler ? sampler->wined3d_sampler : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargets(ID3D11DeviceContext *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
+        ID3D11DepthStencilView *depth_stencil_view)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_depthstencil_view *dsv;
+    unsigned int i;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < render_target_view_count; ++i)
+    {
+        struct d3d_rendertarget_view *rtv = unsafe_impl_from_ID3D11RenderTargetView(render_target_views[i]);
+        wined3d_device_set_rendertarget_view(device->wined3d_device, i, rtv ? rtv->wined3d_view : NULL, FALSE);
+    }
+    for (; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+    {
+        wined3d_device_set_rendertarget_view(device->wined3d_device, i, NULL, FALSE);
+    }
+
+    dsv = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
+    wined3d_device_set_depth_stencil_view(device->wined3d_device, dsv ? dsv->wined3d_view : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext *iface, UINT render_target_view_count,
+        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
+            "initial_counts %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
+            initial_counts);
+
+    if (render_target_view_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+    {
+        d3d11_immediate_context_OMSetRenderTargets(iface, render_target_view_count, render_target_views,
+                depth_stencil_view);
+    }
+
+    if (unordered_access_view_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+    {
+        wined3d_mutex_lock();
+        for (i = 0; i < unordered_access_view_start_slot; ++i)
+        {
+            wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
+        }
+        for (i = 0; i < unordered_access_view_count; ++i)
+        {
+            struct d3d11_unordered_access_view *view
+                    = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_views[i]);
+
+            wined3d_device_set_unordered_access_view(device->wined3d_device,
+                    unordered_access_view_start_slot + i,
+                    view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
+        }
+        for (; unordered_access_view_start_slot + i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
+        {
+            wined3d_device_set_unordered_access_view(device->wined3d_device,
+                    unordered_access_view_start_slot + i, NULL, ~0u);
+        }
+        wined3d_mutex_unlock();
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetBlendState(ID3D11DeviceContext *iface,
+        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    static const float default_blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    struct d3d_blend_state *blend_state_impl;
+    const D3D11_BLEND_DESC *desc;
+
+    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
+            iface, blend_state, debug_float4(blend_factor), sample_mask);
+
+    if (!blend_factor)
+        blend_factor = default_blend_factor;
+
+    wined3d_mutex_lock();
+    memcpy(device->blend_factor, blend_factor, 4 * sizeof(*blend_factor));
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEMASK, sample_mask);
+    if (!(blend_state_impl = unsafe_impl_from_ID3D11BlendState(blend_state)))
+    {
+        wined3d_device_set_blend_state(device->wined3d_device, NULL);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ALPHABLENDENABLE, FALSE);
+        wined3d_device_set_render_state(device->wined3d_device,
+                WINED3D_RS_COLORWRITEENABLE, D3D11_COLOR_WRITE_ENABLE_ALL);
+        wined3d_device_set_render_state(device->wined3d_device,
+                WINED3D_RS_COLORWRITEENABLE1, D3D11_COLOR_WRITE_ENABLE_ALL);
+        wined3d_device_set_render_state(device->wined3d_device,
+                WINED3D_RS_COLORWRITEENABLE2, D3D11_COLOR_WRITE_ENABLE_ALL);
+        wined3d_device_set_render_state(device->wined3d_device,
+                WINED3D_RS_COLORWRITEENABLE3, D3D11_COLOR_WRITE_ENABLE_ALL);
+        wined3d_mutex_unlock();
+        return;
+    }
+
+    wined3d_device_set_blend_state(device->wined3d_device, blend_state_impl->wined3d_state);
+    desc = &blend_state_impl->desc;
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ALPHABLENDENABLE,
+            desc->RenderTarget[0].BlendEnable);
+    if (desc->RenderTarget[0].BlendEnable)
+    {
+        const D3D11_RENDER_TARGET_BLEND_DESC *d = &desc->RenderTarget[0];
+
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SRCBLEND, d->SrcBlend);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DESTBLEND, d->DestBlend);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BLENDOP, d->BlendOp);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SEPARATEALPHABLENDENABLE, TRUE);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SRCBLENDALPHA, d->SrcBlendAlpha);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DESTBLENDALPHA, d->DestBlendAlpha);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BLENDOPALPHA, d->BlendOpAlpha);
+
+        if (memcmp(blend_factor, default_blend_factor, sizeof(default_blend_factor))
+                && (d->SrcBlend == D3D11_BLEND_BLEND_FACTOR || d->SrcBlend == D3D11_BLEND_INV_BLEND_FACTOR
+                || d->DestBlend == D3D11_BLEND_BLEND_FACTOR || d->DestBlend == D3D11_BLEND_INV_BLEND_FACTOR
+                || d->SrcBlendAlpha == D3D11_BLEND_BLEND_FACTOR || d->SrcBlendAlpha == D3D11_BLEND_INV_BLEND_FACTOR
+                || d->DestBlendAlpha == D3D11_BLEND_BLEND_FACTOR || d->DestBlendAlpha == D3D11_BLEND_INV_BLEND_FACTOR))
+            FIXME("Ignoring blend factor %s.\n", debug_float4(blend_factor));
+    }
+    wined3d_device_set_render_state(device->wined3d_device,
+            WINED3D_RS_COLORWRITEENABLE, desc->RenderTarget[0].RenderTargetWriteMask);
+    wined3d_device_set_render_state(device->wined3d_device,
+            WINED3D_RS_COLORWRITEENABLE1, desc->RenderTarget[1].RenderTargetWriteMask);
+    wined3d_device_set_render_state(device->wined3d_device,
+            WINED3D_RS_COLORWRITEENABLE2, desc->RenderTarget[2].RenderTargetWriteMask);
+    wined3d_device_set_render_state(device->wined3d_device,
+            WINED3D_RS_COLORWRITEENABLE3, desc->RenderTarget[3].RenderTargetWriteMask);
+    wined3d_mutex_unlock();
+}
+
+static void set_default_depth_stencil_state(struct wined3d_device *wined3d_device)
+{
+    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZENABLE, TRUE);
+    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZWRITEENABLE, D3D11_DEPTH_WRITE_MASK_ALL);
+    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZFUNC, WINED3D_CMP_LESS);
+    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_STENCILENABLE, FALSE);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetDepthStencilState(ID3D11DeviceContext *iface,
+        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    const D3D11_DEPTH_STENCILOP_DESC *front, *back;
+    const D3D11_DEPTH_STENCIL_DESC *desc;
+
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    wined3d_mutex_lock();
+    device->stencil_ref = stencil_ref;
+    if (!(device->depth_stencil_state = unsafe_impl_from_ID3D11DepthStencilState(depth_stencil_state)))
+    {
+        set_default_depth_stencil_state(device->wined3d_device);
+        wined3d_mutex_unlock();
+        return;
+    }
+
+    desc = &device->depth_stencil_state->desc;
+
+    front = &desc->FrontFace;
+    back = &desc->BackFace;
+
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZENABLE, desc->DepthEnable);
+    if (desc->DepthEnable)
+    {
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZWRITEENABLE, desc->DepthWriteMask);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZFUNC, desc->DepthFunc);
+    }
+
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILENABLE, desc->StencilEnable);
+    if (desc->StencilEnable)
+    {
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILMASK, desc->StencilReadMask);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILWRITEMASK, desc->StencilWriteMask);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILREF, stencil_ref);
+
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILFAIL, front->StencilFailOp);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILZFAIL, front->StencilDepthFailOp);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILPASS, front->StencilPassOp);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILFUNC, front->StencilFunc);
+        if (front->StencilFailOp != back->StencilFailOp
+                || front->StencilDepthFailOp != back->StencilDepthFailOp
+                || front->StencilPassOp != back->StencilPassOp
+                || front->StencilFunc != back->StencilFunc)
+        {
+            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_TWOSIDEDSTENCILMODE, TRUE);
+            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILFAIL, back->StencilFailOp);
+            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILZFAIL,
+                    back->StencilDepthFailOp);
+            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILPASS, back->StencilPassOp);
+            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILFUNC, back->StencilFunc);
+        }
+        else
+        {
+            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_TWOSIDEDSTENCILMODE, FALSE);
+        }
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_SOSetTargets(ID3D11DeviceContext *iface, UINT buffer_count,
+        ID3D11Buffer *const *buffers, const UINT *offsets)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int count, i;
+
+    TRACE("iface %p, buffer_count %u, buffers %p, offsets %p.\n", iface, buffer_count, buffers, offsets);
+
+    count = min(buffer_count, D3D11_SO_BUFFER_SLOT_COUNT);
+    wined3d_mutex_lock();
+    for (i = 0; i < count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_stream_output(device->wined3d_device, i,
+                buffer ? buffer->wined3d_buffer : NULL, offsets ? offsets[i] : 0);
+    }
+    for (; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
+    {
+        wined3d_device_set_stream_output(device->wined3d_device, i, NULL, 0);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawAuto(ID3D11DeviceContext *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_buffer *d3d_buffer;
+
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    d3d_buffer = unsafe_impl_from_ID3D11Buffer(buffer);
+
+    wined3d_mutex_lock();
+    wined3d_device_draw_indexed_primitive_instanced_indirect(device->wined3d_device,
+            d3d_buffer->wined3d_buffer, offset);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstancedIndirect(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_buffer *d3d_buffer;
+
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    d3d_buffer = unsafe_impl_from_ID3D11Buffer(buffer);
+
+    wined3d_mutex_lock();
+    wined3d_device_draw_primitive_instanced_indirect(device->wined3d_device,
+            d3d_buffer->wined3d_buffer, offset);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_Dispatch(ID3D11DeviceContext *iface,
+        UINT thread_group_count_x, UINT thread_group_count_y, UINT thread_group_count_z)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, thread_group_count_x %u, thread_group_count_y %u, thread_group_count_z %u.\n",
+            iface, thread_group_count_x, thread_group_count_y, thread_group_count_z);
+
+    wined3d_mutex_lock();
+    wined3d_device_dispatch_compute(device->wined3d_device,
+            thread_group_count_x, thread_group_count_y, thread_group_count_z);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DispatchIndirect(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_buffer *buffer_impl;
+
+    TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
+
+    buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
+
+    wined3d_mutex_lock();
+    wined3d_device_dispatch_compute_indirect(device->wined3d_device,
+            buffer_impl->wined3d_buffer, offset);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetState(ID3D11DeviceContext *iface,
+        ID3D11RasterizerState *rasterizer_state)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_rasterizer_state *rasterizer_state_impl;
+    const D3D11_RASTERIZER_DESC *desc;
+    union
+    {
+        DWORD d;
+        float f;
+    } scale_bias, const_bias;
+
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    wined3d_mutex_lock();
+    if (!(rasterizer_state_impl = unsafe_impl_from_ID3D11RasterizerState(rasterizer_state)))
+    {
+        wined3d_device_set_rasterizer_state(device->wined3d_device, NULL);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_FILLMODE, WINED3D_FILL_SOLID);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_CULLMODE, WINED3D_CULL_BACK);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SLOPESCALEDEPTHBIAS, 0);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DEPTHBIAS, 0);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SCISSORTESTENABLE, FALSE);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEANTIALIAS, FALSE);
+        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ANTIALIASEDLINEENABLE, FALSE);
+        wined3d_mutex_unlock();
+        return;
+    }
+
+    wined3d_device_set_rasterizer_state(device->wined3d_device, rasterizer_state_impl->wined3d_state);
+
+    desc = &rasterizer_state_impl->desc;
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_FILLMODE, desc->FillMode);
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_CULLMODE, desc->CullMode);
+    scale_bias.f = desc->SlopeScaledDepthBias;
+    const_bias.f = desc->DepthBias;
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SLOPESCALEDEPTHBIAS, scale_bias.d);
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DEPTHBIAS, const_bias.d);
+    /* GL_DEPTH_CLAMP */
+    if (!desc->DepthClipEnable)
+        FIXME("Ignoring DepthClipEnable %#x.\n", desc->DepthClipEnable);
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SCISSORTESTENABLE, desc->ScissorEnable);
+    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEANTIALIAS, desc->MultisampleEnable);
+    wined3d_device_set_render_state(device->wined3d_device,
+            WINED3D_RS_ANTIALIASEDLINEENABLE, desc->AntialiasedLineEnable);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetViewports(ID3D11DeviceContext *iface,
+        UINT viewport_count, const D3D11_VIEWPORT *viewports)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_viewport wined3d_vp;
+
+    TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
+
+    if (viewport_count > 1)
+        FIXME("Multiple viewports not implemented.\n");
+
+    if (!viewport_count)
+        return;
+
+    wined3d_vp.x = viewports[0].TopLeftX;
+    wined3d_vp.y = viewports[0].TopLeftY;
+    wined3d_vp.width = viewports[0].Width;
+    wined3d_vp.height = viewports[0].Height;
+    wined3d_vp.min_z = viewports[0].MinDepth;
+    wined3d_vp.max_z = viewports[0].MaxDepth;
+
+    wined3d_mutex_lock();
+    wined3d_device_set_viewport(device->wined3d_device, &wined3d_vp);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetScissorRects(ID3D11DeviceContext *iface,
+        UINT rect_count, const D3D11_RECT *rects)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
+
+    if (rect_count > 1)
+        FIXME("Multiple scissor rects not implemented.\n");
+
+    if (!rect_count)
+        return;
+
+    wined3d_mutex_lock();
+    wined3d_device_set_scissor_rect(device->wined3d_device, rects);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CopySubresourceRegion(ID3D11DeviceContext *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
+    struct wined3d_box wined3d_src_box;
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box);
+
+    if (src_box)
+        wined3d_box_set(&wined3d_src_box, src_box->left, src_box->top,
+                src_box->right, src_box->bottom, src_box->front, src_box->back);
+
+    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
+    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
+    wined3d_mutex_lock();
+    wined3d_device_copy_sub_resource_region(device->wined3d_device, wined3d_dst_resource, dst_subresource_idx,
+            dst_x, dst_y, dst_z, wined3d_src_resource, src_subresource_idx, src_box ? &wined3d_src_box : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CopyResource(ID3D11DeviceContext *iface,
+        ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
+
+    TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst_resource, src_resource);
+
+    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
+    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
+    wined3d_mutex_lock();
+    wined3d_device_copy_resource(device->wined3d_device, wined3d_dst_resource, wined3d_src_resource);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_UpdateSubresource(ID3D11DeviceContext *iface,
+        ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
+        const void *data, UINT row_pitch, UINT depth_pitch)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_resource *wined3d_resource;
+    struct wined3d_box wined3d_box;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u.\n",
+            iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
+
+    if (box)
+        wined3d_box_set(&wined3d_box, box->left, box->top, box->right, box->bottom, box->front, box->back);
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+    wined3d_mutex_lock();
+    wined3d_device_update_sub_resource(device->wined3d_device, wined3d_resource,
+            subresource_idx, box ? &wined3d_box : NULL, data, row_pitch, depth_pitch);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CopyStructureCount(ID3D11DeviceContext *iface,
+        ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_unordered_access_view *uav;
+    struct d3d_buffer *buffer_impl;
+
+    TRACE("iface %p, dst_buffer %p, dst_offset %u, src_view %p.\n",
+            iface, dst_buffer, dst_offset, src_view);
+
+    buffer_impl = unsafe_impl_from_ID3D11Buffer(dst_buffer);
+    uav = unsafe_impl_from_ID3D11UnorderedAccessView(src_view);
+
+    wined3d_mutex_lock();
+    wined3d_device_copy_uav_counter(device->wined3d_device,
+            buffer_impl->wined3d_buffer, dst_offset, uav->wined3d_view);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearRenderTargetView(ID3D11DeviceContext *iface,
+        ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_rendertarget_view *view = unsafe_impl_from_ID3D11RenderTargetView(render_target_view);
+    const struct wined3d_color color = {color_rgba[0], color_rgba[1], color_rgba[2], color_rgba[3]};
+    HRESULT hr;
+
+    TRACE("iface %p, render_target_view %p, color_rgba %s.\n",
+            iface, render_target_view, debug_float4(color_rgba));
+
+    if (!view)
+        return;
+
+    wined3d_mutex_lock();
+    if (FAILED(hr = wined3d_device_clear_rendertarget_view(device->wined3d_device, view->wined3d_view, NULL,
+            WINED3DCLEAR_TARGET, &color, 0.0f, 0)))
+        ERR("Failed to clear view, hr %#x.\n", hr);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_unordered_access_view *view;
+
+    TRACE("iface %p, unordered_access_view %p, values {%u, %u, %u, %u}.\n",
+            iface, unordered_access_view, values[0], values[1], values[2], values[3]);
+
+    view = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_view);
+    wined3d_mutex_lock();
+    wined3d_device_clear_unordered_access_view_uint(device->wined3d_device,
+            view->wined3d_view, (const struct wined3d_uvec4 *)values);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext *iface,
+        ID3D11UnorderedAccessView *unordered_access_view, const float values[4])
+{
+    FIXME("iface %p, unordered_access_view %p, values %s stub!\n",
+            iface, unordered_access_view, debug_float4(values));
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearDepthStencilView(ID3D11DeviceContext *iface,
+        ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_depthstencil_view *view = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
+    DWORD wined3d_flags;
+    HRESULT hr;
+
+    TRACE("iface %p, depth_stencil_view %p, flags %#x, depth %.8e, stencil %u.\n",
+            iface, depth_stencil_view, flags, depth, stencil);
+
+    if (!view)
+        return;
+
+    wined3d_flags = wined3d_clear_flags_from_d3d11_clear_flags(flags);
+
+    wined3d_mutex_lock();
+    if (FAILED(hr = wined3d_device_clear_rendertarget_view(device->wined3d_device, view->wined3d_view, NULL,
+            wined3d_flags, NULL, depth, stencil)))
+        ERR("Failed to clear view, hr %#x.\n", hr);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GenerateMips(ID3D11DeviceContext *iface,
+        ID3D11ShaderResourceView *view)
+{
+    struct d3d_shader_resource_view *srv = unsafe_impl_from_ID3D11ShaderResourceView(view);
+
+    TRACE("iface %p, view %p.\n", iface, view);
+
+    wined3d_mutex_lock();
+    wined3d_shader_resource_view_generate_mipmaps(srv->wined3d_view);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_SetResourceMinLOD(ID3D11DeviceContext *iface,
+        ID3D11Resource *resource, FLOAT min_lod)
+{
+    FIXME("iface %p, resource %p, min_lod %f stub!\n", iface, resource, min_lod);
+}
+
+static FLOAT STDMETHODCALLTYPE d3d11_immediate_context_GetResourceMinLOD(ID3D11DeviceContext *iface,
+        ID3D11Resource *resource)
+{
+    FIXME("iface %p, resource %p stub!\n", iface, resource);
+
+    return 0.0f;
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ResolveSubresource(ID3D11DeviceContext *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx,
+        ID3D11Resource *src_resource, UINT src_subresource_idx,
+        DXGI_FORMAT format)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
+    enum wined3d_format_id wined3d_format;
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, "
+            "src_resource %p, src_subresource_idx %u, format %s.\n",
+            iface, dst_resource, dst_subresource_idx,
+            src_resource, src_subresource_idx, debug_dxgi_format(format));
+
+    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
+    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
+    wined3d_format = wined3dformat_from_dxgi_format(format);
+    wined3d_mutex_lock();
+    wined3d_device_resolve_sub_resource(device->wined3d_device,
+            wined3d_dst_resource, dst_subresource_idx,
+            wined3d_src_resource, src_subresource_idx, wined3d_format);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearState(ID3D11DeviceContext *iface);
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ExecuteCommandList(ID3D11DeviceContext *iface,
+        ID3D11CommandList *command_list, BOOL restore_state)
+{
+    struct d3d11_command_list *list = unsafe_impl_from_ID3D11CommandList(command_list);
+    struct d3d11_context_state *saved_state = NULL;
+
+    TRACE("iface %p, command_list %p, restore_state %#x.\n", iface, command_list, restore_state);
+
+    if (restore_state && !(saved_state = heap_alloc(sizeof(*saved_state))))
+    {
+        ERR("Failed to allocate context state.\n");
+        return;
+    }
+
+    /* Command lists always start from the default state, and leave the
+     * context in the default state unless "restore_state" is set. */
+    wined3d_mutex_lock();
+    if (saved_state)
+        d3d11_context_state_capture(saved_state, iface);
+    d3d11_immediate_context_ClearState(iface);
+    if (list->initial_state)
+        d3d11_context_state_apply(list->initial_state, iface);
+    d3d11_command_list_execute(list, iface);
+    if (saved_state)
+    {
+        d3d11_context_state_apply(saved_state, iface);
+        d3d11_context_state_cleanup(saved_state);
+    }
+    else
+    {
+        d3d11_immediate_context_ClearState(iface);
+    }
+    wined3d_mutex_unlock();
+
+    heap_free(saved_state);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+
+        wined3d_device_set_hs_resource_view(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShader(ID3D11DeviceContext *iface,
+        ID3D11HullShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_hull_shader *hs = unsafe_impl_from_ID3D11HullShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    wined3d_device_set_hull_shader(device->wined3d_device, hs ? hs->wined3d_shader : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+
+        wined3d_device_set_hs_sampler(device->wined3d_device, start_slot + i,
+                sampler ? sampler->wined3d_sampler : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_hs_cb(device->wined3d_device, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+
+        wined3d_device_set_ds_resource_view(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShader(ID3D11DeviceContext *iface,
+        ID3D11DomainShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_domain_shader *ds = unsafe_impl_from_ID3D11DomainShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    wined3d_device_set_domain_shader(device->wined3d_device, ds ? ds->wined3d_shader : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+
+        wined3d_device_set_ds_sampler(device->wined3d_device, start_slot + i,
+                sampler ? sampler->wined3d_sampler : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_ds_cb(device->wined3d_device, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+
+        wined3d_device_set_cs_resource_view(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetUnorderedAccessViews(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView *const *views, const UINT *initial_counts)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p, initial_counts %p.\n",
+            iface, start_slot, view_count, views, initial_counts);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct d3d11_unordered_access_view *view = unsafe_impl_from_ID3D11UnorderedAccessView(views[i]);
+
+        wined3d_device_set_cs_uav(device->wined3d_device, start_slot + i,
+                view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShader(ID3D11DeviceContext *iface,
+        ID3D11ComputeShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_compute_shader *cs = unsafe_impl_from_ID3D11ComputeShader(shader);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    wined3d_device_set_compute_shader(device->wined3d_device, cs ? cs->wined3d_shader : NULL);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+
+        wined3d_device_set_cs_sampler(device->wined3d_device, start_slot + i,
+                sampler ? sampler->wined3d_sampler : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+
+        wined3d_device_set_cs_cb(device->wined3d_device, start_slot + i,
+                buffer ? buffer->wined3d_buffer : NULL);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_vs_cb(device->wined3d_device, start_slot + i)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
+        ID3D11Buffer_AddRef(buffers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_ps_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
+        ID3D11ShaderResourceView_AddRef(views[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShader(ID3D11DeviceContext *iface,
+        ID3D11PixelShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_shader *wined3d_shader;
+    struct d3d_pixel_shader *shader_impl;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_pixel_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    *shader = &shader_impl->ID3D11PixelShader_iface;
+    ID3D11PixelShader_AddRef(*shader);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_ps_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
+        ID3D11SamplerState_AddRef(samplers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShader(ID3D11DeviceContext *iface,
+        ID3D11VertexShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_vertex_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_vertex_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    *shader = &shader_impl->ID3D11VertexShader_iface;
+    ID3D11VertexShader_AddRef(*shader);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_ps_cb(device->wined3d_device, start_slot + i)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
+        ID3D11Buffer_AddRef(buffers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetInputLayout(ID3D11DeviceContext *iface,
+        ID3D11InputLayout **input_layout)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_vertex_declaration *wined3d_declaration;
+    struct d3d_input_layout *input_layout_impl;
+
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+
+    wined3d_mutex_lock();
+    if (!(wined3d_declaration = wined3d_device_get_vertex_declaration(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *input_layout = NULL;
+        return;
+    }
+
+    input_layout_impl = wined3d_vertex_declaration_get_parent(wined3d_declaration);
+    wined3d_mutex_unlock();
+    *input_layout = &input_layout_impl->ID3D11InputLayout_iface;
+    ID3D11InputLayout_AddRef(*input_layout);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetVertexBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer = NULL;
+        struct d3d_buffer *buffer_impl;
+
+        if (FAILED(wined3d_device_get_stream_source(device->wined3d_device, start_slot + i,
+                &wined3d_buffer, &offsets[i], &strides[i])))
+        {
+            FIXME("Failed to get vertex buffer %u.\n", start_slot + i);
+            if (strides)
+                strides[i] = 0;
+            if (offsets)
+                offsets[i] = 0;
+        }
+
+        if (!wined3d_buffer)
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetIndexBuffer(ID3D11DeviceContext *iface,
+        ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    enum wined3d_format_id wined3d_format;
+    struct wined3d_buffer *wined3d_buffer;
+    struct d3d_buffer *buffer_impl;
+
+    TRACE("iface %p, buffer %p, format %p, offset %p.\n", iface, buffer, format, offset);
+
+    wined3d_mutex_lock();
+    wined3d_buffer = wined3d_device_get_index_buffer(device->wined3d_device, &wined3d_format, offset);
+    *format = dxgi_format_from_wined3dformat(wined3d_format);
+    if (!wined3d_buffer)
+    {
+        wined3d_mutex_unlock();
+        *buffer = NULL;
+        return;
+    }
+
+    buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+    wined3d_mutex_unlock();
+    ID3D11Buffer_AddRef(*buffer = &buffer_impl->ID3D11Buffer_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_gs_cb(device->wined3d_device, start_slot + i)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
+        ID3D11Buffer_AddRef(buffers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShader(ID3D11DeviceContext *iface,
+        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_geometry_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_geometry_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    *shader = &shader_impl->ID3D11GeometryShader_iface;
+    ID3D11GeometryShader_AddRef(*shader);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetPrimitiveTopology(ID3D11DeviceContext *iface,
+        D3D11_PRIMITIVE_TOPOLOGY *topology)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    enum wined3d_primitive_type primitive_type;
+    unsigned int patch_vertex_count;
+
+    TRACE("iface %p, topology %p.\n", iface, topology);
+
+    wined3d_mutex_lock();
+    wined3d_device_get_primitive_type(device->wined3d_device, &primitive_type, &patch_vertex_count);
+    wined3d_mutex_unlock();
+
+    d3d11_primitive_topology_from_wined3d_primitive_type(primitive_type, patch_vertex_count, topology);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_vs_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
+        ID3D11ShaderResourceView_AddRef(views[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_vs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
+        ID3D11SamplerState_AddRef(samplers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GetPredication(ID3D11DeviceContext *iface,
+        ID3D11Predicate **predicate, BOOL *value)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_query *wined3d_predicate;
+    struct d3d_query *predicate_impl;
+
+    TRACE("iface %p, predicate %p, value %p.\n", iface, predicate, value);
+
+    wined3d_mutex_lock();
+    if (!(wined3d_predicate = wined3d_device_get_predication(device->wined3d_device, value)))
+    {
+        wined3d_mutex_unlock();
+        *predicate = NULL;
+        return;
+    }
+
+    predicate_impl = wined3d_query_get_parent(wined3d_predicate);
+    wined3d_mutex_unlock();
+    *predicate = (ID3D11Predicate *)&predicate_impl->ID3D11Query_iface;
+    ID3D11Predicate_AddRef(*predicate);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_gs_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
+        ID3D11ShaderResourceView_AddRef(views[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct d3d_sampler_state *sampler_impl;
+        struct wined3d_sampler *wined3d_sampler;
+
+        if (!(wined3d_sampler = wined3d_device_get_gs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
+        ID3D11SamplerState_AddRef(samplers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargets(ID3D11DeviceContext *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_rendertarget_view *wined3d_view;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    wined3d_mutex_lock();
+    if (render_target_views)
+    {
+        struct d3d_rendertarget_view *view_impl;
+        unsigned int i;
+
+        for (i = 0; i < render_target_view_count; ++i)
+        {
+            if (!(wined3d_view = wined3d_device_get_rendertarget_view(device->wined3d_device, i))
+                    || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
+            {
+                render_target_views[i] = NULL;
+                continue;
+            }
+
+            render_target_views[i] = &view_impl->ID3D11RenderTargetView_iface;
+            ID3D11RenderTargetView_AddRef(render_target_views[i]);
+        }
+    }
+
+    if (depth_stencil_view)
+    {
+        struct d3d_depthstencil_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_depth_stencil_view(device->wined3d_device))
+                || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
+        {
+            *depth_stencil_view = NULL;
+        }
+        else
+        {
+            *depth_stencil_view = &view_impl->ID3D11DepthStencilView_iface;
+            ID3D11DepthStencilView_AddRef(*depth_stencil_view);
+        }
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
+        ID3D11DepthStencilView **depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView **unordered_access_views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_unordered_access_view *wined3d_view;
+    struct d3d11_unordered_access_view *view_impl;
+    unsigned int i;
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, "
+            "unordered_access_views %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views);
+
+    if (render_target_views || depth_stencil_view)
+        d3d11_immediate_context_OMGetRenderTargets(iface, render_target_view_count,
+                render_target_views, depth_stencil_view);
+
+    if (unordered_access_views)
+    {
+        wined3d_mutex_lock();
+        for (i = 0; i < unordered_access_view_count; ++i)
+        {
+            if (!(wined3d_view = wined3d_device_get_unordered_access_view(device->wined3d_device,
+                    unordered_access_view_start_slot + i)))
+            {
+                unordered_access_views[i] = NULL;
+                continue;
+            }
+
+            view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
+            unordered_access_views[i] = &view_impl->ID3D11UnorderedAccessView_iface;
+            ID3D11UnorderedAccessView_AddRef(unordered_access_views[i]);
+        }
+        wined3d_mutex_unlock();
+    }
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetBlendState(ID3D11DeviceContext *iface,
+        ID3D11BlendState **blend_state, FLOAT blend_factor[4], UINT *sample_mask)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_blend_state *wined3d_state;
+    struct d3d_blend_state *blend_state_impl;
+
+    TRACE("iface %p, blend_state %p, blend_factor %p, sample_mask %p.\n",
+            iface, blend_state, blend_factor, sample_mask);
+
+    wined3d_mutex_lock();
+    if ((wined3d_state = wined3d_device_get_blend_state(device->wined3d_device)))
+    {
+        blend_state_impl = wined3d_blend_state_get_parent(wined3d_state);
+        ID3D11BlendState_AddRef(*blend_state = &blend_state_impl->ID3D11BlendState_iface);
+    }
+    else
+    {
+        *blend_state = NULL;
+    }
+    memcpy(blend_factor, device->blend_factor, 4 * sizeof(*blend_factor));
+    *sample_mask = wined3d_device_get_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEMASK);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetDepthStencilState(ID3D11DeviceContext *iface,
+        ID3D11DepthStencilState **depth_stencil_state, UINT *stencil_ref)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %p.\n",
+            iface, depth_stencil_state, stencil_ref);
+
+    if ((*depth_stencil_state = device->depth_stencil_state
+            ? &device->depth_stencil_state->ID3D11DepthStencilState_iface : NULL))
+        ID3D11DepthStencilState_AddRef(*depth_stencil_state);
+    *stencil_ref = device->stencil_ref;
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_SOGetTargets(ID3D11DeviceContext *iface,
+        UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, buffer_count %u, buffers %p.\n", iface, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_stream_output(device->wined3d_device, i, NULL)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
+        ID3D11Buffer_AddRef(buffers[i]);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetState(ID3D11DeviceContext *iface,
+        ID3D11RasterizerState **rasterizer_state)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d_rasterizer_state *rasterizer_state_impl;
+    struct wined3d_rasterizer_state *wined3d_state;
+
+    TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
+
+    wined3d_mutex_lock();
+    if ((wined3d_state = wined3d_device_get_rasterizer_state(device->wined3d_device)))
+    {
+        rasterizer_state_impl = wined3d_rasterizer_state_get_parent(wined3d_state);
+        ID3D11RasterizerState_AddRef(*rasterizer_state = &rasterizer_state_impl->ID3D11RasterizerState_iface);
+    }
+    else
+    {
+        *rasterizer_state = NULL;
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetViewports(ID3D11DeviceContext *iface,
+        UINT *viewport_count, D3D11_VIEWPORT *viewports)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct wined3d_viewport wined3d_vp;
+
+    TRACE("iface %p, viewport_count %p, viewports %p.\n", iface, viewport_count, viewports);
+
+    if (!viewports)
+    {
+        *viewport_count = 1;
+        return;
+    }
+
+    if (!*viewport_count)
+        return;
+
+    wined3d_mutex_lock();
+    wined3d_device_get_viewport(device->wined3d_device, &wined3d_vp);
+    wined3d_mutex_unlock();
+
+    viewports[0].TopLeftX = wined3d_vp.x;
+    viewports[0].TopLeftY = wined3d_vp.y;
+    viewports[0].Width = wined3d_vp.width;
+    viewports[0].Height = wined3d_vp.height;
+    viewports[0].MinDepth = wined3d_vp.min_z;
+    viewports[0].MaxDepth = wined3d_vp.max_z;
+
+    if (*viewport_count > 1)
+        memset(&viewports[1], 0, (*viewport_count - 1) * sizeof(*viewports));
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetScissorRects(ID3D11DeviceContext *iface,
+        UINT *rect_count, D3D11_RECT *rects)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, rect_count %p, rects %p.\n", iface, rect_count, rects);
+
+    if (!rects)
+    {
+        *rect_count = 1;
+        return;
+    }
+
+    if (!*rect_count)
+        return;
+
+    wined3d_mutex_lock();
+    wined3d_device_get_scissor_rect(device->wined3d_device, rects);
+    wined3d_mutex_unlock();
+    if (*rect_count > 1)
+        memset(&rects[1], 0, (*rect_count - 1) * sizeof(*rects));
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_hs_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShader(ID3D11DeviceContext *iface,
+        ID3D11HullShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_hull_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_hull_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    ID3D11HullShader_AddRef(*shader = &shader_impl->ID3D11HullShader_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_hs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_hs_cb(device->wined3d_device, start_slot + i)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
+            iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_ds_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShader(ID3D11DeviceContext *iface,
+        ID3D11DomainShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_domain_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_domain_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    ID3D11DomainShader_AddRef(*shader = &shader_impl->ID3D11DomainShader_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_ds_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_ds_cb(device->wined3d_device, start_slot + i)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_shader_resource_view *wined3d_view;
+        struct d3d_shader_resource_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_cs_resource_view(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
+        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetUnorderedAccessViews(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11UnorderedAccessView **views)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < view_count; ++i)
+    {
+        struct wined3d_unordered_access_view *wined3d_view;
+        struct d3d11_unordered_access_view *view_impl;
+
+        if (!(wined3d_view = wined3d_device_get_cs_uav(device->wined3d_device, start_slot + i)))
+        {
+            views[i] = NULL;
+            continue;
+        }
+
+        view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
+        ID3D11UnorderedAccessView_AddRef(views[i] = &view_impl->ID3D11UnorderedAccessView_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShader(ID3D11DeviceContext *iface,
+        ID3D11ComputeShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_compute_shader *shader_impl;
+    struct wined3d_shader *wined3d_shader;
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+
+    wined3d_mutex_lock();
+    if (!(wined3d_shader = wined3d_device_get_compute_shader(device->wined3d_device)))
+    {
+        wined3d_mutex_unlock();
+        *shader = NULL;
+        return;
+    }
+
+    shader_impl = wined3d_shader_get_parent(wined3d_shader);
+    wined3d_mutex_unlock();
+    ID3D11ComputeShader_AddRef(*shader = &shader_impl->ID3D11ComputeShader_iface);
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
+            iface, start_slot, sampler_count, samplers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < sampler_count; ++i)
+    {
+        struct wined3d_sampler *wined3d_sampler;
+        struct d3d_sampler_state *sampler_impl;
+
+        if (!(wined3d_sampler = wined3d_device_get_cs_sampler(device->wined3d_device, start_slot + i)))
+        {
+            samplers[i] = NULL;
+            continue;
+        }
+
+        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
+        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    unsigned int i;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
+            iface, start_slot, buffer_count, buffers);
+
+    wined3d_mutex_lock();
+    for (i = 0; i < buffer_count; ++i)
+    {
+        struct wined3d_buffer *wined3d_buffer;
+        struct d3d_buffer *buffer_impl;
+
+        if (!(wined3d_buffer = wined3d_device_get_cs_cb(device->wined3d_device, start_slot + i)))
+        {
+            buffers[i] = NULL;
+            continue;
+        }
+
+        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
+        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
+    }
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_ClearState(ID3D11DeviceContext *iface)
+{
+    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    static const float blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    unsigned int i;
+
+    TRACE("iface %p.\n", iface);
+
+    wined3d_mutex_lock();
+    wined3d_device_set_vertex_shader(device->wined3d_device, NULL);
+    wined3d_device_set_hull_shader(device->wined3d_device, NULL);
+    wined3d_device_set_domain_shader(device->wined3d_device, NULL);
+    wined3d_device_set_geometry_shader(device->wined3d_device, NULL);
+    wined3d_device_set_pixel_shader(device->wined3d_device, NULL);
+    wined3d_device_set_compute_shader(device->wined3d_device, NULL);
+    for (i = 0; i < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; ++i)
+    {
+        wined3d_device_set_vs_sampler(device->wined3d_device, i, NULL);
+        wined3d_device_set_hs_sampler(device->wined3d_device, i, NULL);
+        wined3d_device_set_ds_sampler(device->wined3d_device, i, NULL);
+        wined3d_device_set_gs_sampler(device->wined3d_device, i, NULL);
+        wined3d_device_set_ps_sampler(device->wined3d_device, i, NULL);
+        wined3d_device_set_cs_sampler(device->wined3d_device, i, NULL);
+    }
+    for (i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; ++i)
+    {
+        wined3d_device_set_vs_resource_view(device->wined3d_device, i, NULL);
+        wined3d_device_set_hs_resource_view(device->wined3d_device, i, NULL);
+        wined3d_device_set_ds_resource_view(device->wined3d_device, i, NULL);
+        wined3d_device_set_gs_resource_view(device->wined3d_device, i, NULL);
+        wined3d_device_set_ps_resource_view(device->wined3d_device, i, NULL);
+        wined3d_device_set_cs_resource_view(device->wined3d_device, i, NULL);
+    }
+    for (i = 0; i < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; ++i)
+    {
+        wined3d_device_set_vs_cb(device->wined3d_device, i, NULL);
+        wined3d_device_set_hs_cb(device->wined3d_device, i, NULL);
+        wined3d_device_set_ds_cb(device->wined3d_device, i, NULL);
+        wined3d_device_set_gs_cb(device->wined3d_device, i, NULL);
+        wined3d_device_set_ps_cb(device->wined3d_device, i, NULL);
+        wined3d_device_set_cs_cb(device->wined3d_device, i, NULL);
+    }
+    for (i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i)
+    {
+        wined3d_device_set_stream_source(device->wined3d_device, i, NULL, 0, 0);
+    }
+    wined3d_device_set_index_buffer(device->wined3d_device, NULL, WINED3DFMT_UNKNOWN, 0);
+    wined3d_device_set_vertex_declaration(device->wined3d_device, NULL);
+    wined3d_device_set_primitive_type(device->wined3d_device, WINED3D_PT_UNDEFINED, 0);
+    for (i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+    {
+        wined3d_device_set_rendertarget_view(device->wined3d_device, i, NULL, FALSE);
+    }
+    wined3d_device_set_depth_stencil_view(device->wined3d_device, NULL);
+    for (i = 0; i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
+    {
+        wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
+        wined3d_device_set_cs_uav(device->wined3d_device, i, NULL, ~0u);
+    }
+    ID3D11DeviceContext_OMSetDepthStencilState(iface, NULL, 0);
+    ID3D11DeviceContext_OMSetBlendState(iface, NULL, blend_factor, D3D11_DEFAULT_SAMPLE_MASK);
+    ID3D11DeviceContext_RSSetViewports(iface, 0, NULL);
+    ID3D11DeviceContext_RSSetScissorRects(iface, 0, NULL);
+    ID3D11DeviceContext_RSSetState(iface, NULL);
+    for (i = 0; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
+    {
+        wined3d_device_set_stream_output(device->wined3d_device, i, NULL, 0);
+    }
+    wined3d_device_set_predication(device->wined3d_device, NULL, FALSE);
+    wined3d_mutex_unlock();
+}
+
+static void STDMETHODCALLTYPE d3d11_immediate_context_Flush(ID3D11DeviceContext *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+}
+
+static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_immediate_context_GetType(ID3D11DeviceContext *iface)
+{
+    TRACE("iface %p.\n", iface);
+
+    return D3D11_DEVICE_CONTEXT_IMMEDIATE;
+}
+
+static UINT STDMETHODCALLTYPE d3d11_immediate_context_GetContextFlags(ID3D11DeviceContext *iface)
+{
+    FIXME("iface %p stub!\n", iface);
+
+    return 0;
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_FinishCommandList(ID3D11DeviceContext *iface,
+        BOOL restore, ID3D11CommandList **command_list)
+{
+    FIXME("iface %p, restore %#x, command_list %p stub!\n", iface, restore, command_list);
+
+    return E_NOTIMPL;
+}
+
+static const struct ID3D11DeviceContextVtbl d3d11_immediate_context_vtbl =
+{
+    /* IUnknown methods */
+    d3d11_immediate_context_QueryInterface,
+    d3d11_immediate_context_AddRef,
+    d3d11_immediate_context_Release,
+    /* ID3D11DeviceChild methods */
+    d3d11_immediate_context_GetDevice,
+    d3d11_immediate_context_GetPrivateData,
+    d3d11_immediate_context_SetPrivateData,
+    d3d11_immediate_context_SetPrivateDataInterface,
+    /* ID3D11DeviceContext methods */
+    d3d11_immediate_context_VSSetConstantBuffers,
+    d3d11_immediate_context_PSSetShaderResources,
+    d3d11_immediate_context_PSSetShader,
+    d3d11_immediate_context_PSSetSamplers,
+    d3d11_immediate_context_VSSetShader,
+    d3d11_immediate_context_DrawIndexed,
+    d3d11_immediate_context_Draw,
+    d3d11_immediate_context_Map,
+    d3d11_immediate_context_Unmap,
+    d3d11_immediate_context_PSSetConstantBuffers,
+    d3d11_immediate_context_IASetInputLayout,
+    d3d11_immediate_context_IASetVertexBuffers,
+    d3d11_immediate_context_IASetIndexBuffer,
+    d3d11_immediate_context_DrawIndexedInstanced,
+    d3d11_immediate_context_DrawInstanced,
+    d3d11_immediate_context_GSSetConstantBuffers,
+    d3d11_immediate_context_GSSetShader,
+    d3d11_immediate_context_IASetPrimitiveTopology,
+    d3d11_immediate_context_VSSetShaderResources,
+    d3d11_immediate_context_VSSetSamplers,
+    d3d11_immediate_context_Begin,
+    d3d11_immediate_context_End,
+    d3d11_immediate_context_GetData,
+    d3d11_immediate_context_SetPredication,
+    d3d11_immediate_context_GSSetShaderResources,
+    d3d11_immediate_context_GSSetSamplers,
+    d3d11_immediate_context_OMSetRenderTargets,
+    d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews,
+    d3d11_immediate_context_OMSetBlendState,
+    d3d11_immediate_context_OMSetDepthStencilState,
+    d3d11_immediate_context_SOSetTargets,
+    d3d11_immediate_context_DrawAuto,
+    d3d11_immediate_context_DrawIndexedInstancedIndirect,
+    d3d11_immediate_context_DrawInstancedIndirect,
+    d3d11_immediate_context_Dispatch,
+    d3d11_immediate_context_DispatchIndirect,
+    d3d11_immediate_context_RSSetState,
+    d3d11_immediate_context_RSSetViewports,
+    d3d11_immediate_context_RSSetScissorRects,
+    d3d11_immediate_context_CopySubresourceRegion,
+    d3d11_immediate_context_CopyResource,
+    d3d11_immediate_context_UpdateSubresource,
+    d3d11_immediate_context_CopyStructureCount,
+    d3d11_immediate_context_ClearRenderTargetView,
+    d3d11_immediate_context_ClearUnorderedAccessViewUint,
+    d3d11_immediate_context_ClearUnorderedAccessViewFloat,
+    d3d11_immediate_context_ClearDepthStencilView,
+    d3d11_immediate_context_GenerateMips,
+    d3d11_immediate_context_SetResourceMinLOD,
+    d3d11_immediate_context_GetResourceMinLOD,
+    d3d11_immediate_context_ResolveSubresource,
+    d3d11_immediate_context_ExecuteCommandList,
+    d3d11_immediate_context_HSSetShaderResources,
+    d3d11_immediate_context_HSSetShader,
+    d3d11_immediate_context_HSSetSamplers,
+    d3d11_immediate_context_HSSetConstantBuffers,
+    d3d11_immediate_context_DSSetShaderResources,
+    d3d11_immediate_context_DSSetShader,
+    d3d11_immediate_context_DSSetSamplers,
+    d3d11_immediate_context_DSSetConstantBuffers,
+    d3d11_immediate_context_CSSetShaderResources,
+    d3d11_immediate_context_CSSetUnorderedAccessViews,
+    d3d11_immediate_context_CSSetShader,
+    d3d11_immediate_context_CSSetSamplers,
+    d3d11_immediate_context_CSSetConstantBuffers,
+    d3d11_immediate_context_VSGetConstantBuffers,
+    d3d11_immediate_context_PSGetShaderResources,
+    d3d11_immediate_context_PSGetShader,
+    d3d11_immediate_context_PSGetSamplers,
+    d3d11_immediate_context_VSGetShader,
+    d3d11_immediate_context_PSGetConstantBuffers,
+    d3d11_immediate_context_IAGetInputLayout,
+    d3d11_immediate_context_IAGetVertexBuffers,
+    d3d11_immediate_context_IAGetIndexBuffer,
+    d3d11_immediate_context_GSGetConstantBuffers,
+    d3d11_immediate_context_GSGetShader,
+    d3d11_immediate_context_IAGetPrimitiveTopology,
+    d3d11_immediate_context_VSGetShaderResources,
+    d3d11_immediate_context_VSGetSamplers,
+    d3d11_immediate_context_GetPredication,
+    d3d11_immediate_context_GSGetShaderResources,
+    d3d11_immediate_context_GSGetSamplers,
+    d3d11_immediate_context_OMGetRenderTargets,
+    d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews,
+    d3d11_immediate_context_OMGetBlendState,
+    d3d11_immediate_context_OMGetDepthStencilState,
+    d3d11_immediate_context_SOGetTargets,
+    d3d11_immediate_context_RSGetState,
+    d3d11_immediate_context_RSGetViewports,
+    d3d11_immediate_context_RSGetScissorRects,
+    d3d11_immediate_context_HSGetShaderResources,
+    d3d11_immediate_context_HSGetShader,
+    d3d11_immediate_context_HSGetSamplers,
+    d3d11_immediate_context_HSGetConstantBuffers,
+    d3d11_immediate_context_DSGetShaderResources,
+    d3d11_immediate_context_DSGetShader,
+    d3d11_immediate_context_DSGetSamplers,
+    d3d11_immediate_context_DSGetConstantBuffers,
+    d3d11_immediate_context_CSGetShaderResources,
+    d3d11_immediate_context_CSGetUnorderedAccessViews,
+    d3d11_immediate_context_CSGetShader,
+    d3d11_immediate_context_CSGetSamplers,
+    d3d11_immediate_context_CSGetConstantBuffers,
+    d3d11_immediate_context_ClearState,
+    d3d11_immediate_context_Flush,
+    d3d11_immediate_context_GetType,
+    d3d11_immediate_context_GetContextFlags,
+    d3d11_immediate_context_FinishCommandList,
+};
+
+static void d3d11_immediate_context_init(struct d3d11_immediate_context *context, struct d3d_device *device)
+{
+    context->ID3D11DeviceContext_iface.lpVtbl = &d3d11_immediate_context_vtbl;
+    context->refcount = 1;
+
+    ID3D11Device_AddRef(&device->ID3D11Device_iface);
+
+    wined3d_private_store_init(&context->private_store);
+}
+
+static void d3d11_immediate_context_destroy(struct d3d11_immediate_context *context)
+{
+    wined3d_private_store_cleanup(&context->private_store);
+}
+
+/* ID3D11DeviceContext - deferred context methods
+ *
+ * Deferred contexts don't touch the wined3d device; they only track their
+ * own state, which is needed for the Get*() methods and for
+ * FinishCommandList(restore = TRUE), and record the calls into a
+ * d3d11_command_list. Any resource data passed to them is copied into the
+ * command list. */
+
+struct d3d11_deferred_mapping
+{
+    struct list entry;
+    ID3D11Resource *resource;
+    UINT subresource_idx;
+    D3D11_MAP map_type;
+    BOOL mapped;
+    UINT row_pitch;
+    UINT depth_pitch;
+    SIZE_T size;
+    BYTE data[1];
+};
+
+struct d3d11_subresource_layout
+{
+    BOOL is_buffer;
+    unsigned int width;
+    unsigned int height;
+    unsigned int depth;
+    unsigned int row_pitch;
+    unsigned int slice_pitch;
+    unsigned int row_count;
+};
+
+static inline struct d3d11_deferred_context *impl_from_deferred_ID3D11DeviceContext(ID3D11DeviceContext *iface)
+{
+    return CONTAINING_RECORD(iface, struct d3d11_deferred_context, ID3D11DeviceContext_iface);
+}
+
+static HRESULT d3d11_get_subresource_layout(ID3D11Resource *resource, UINT subresource_idx,
+        struct d3d11_subresource_layout *layout)
+{
+    struct wined3d_sub_resource_desc sub_resource_desc;
+    struct wined3d_resource *wined3d_resource;
+    struct wined3d_resource_desc desc;
+    struct wined3d_texture *texture;
+    HRESULT hr = S_OK;
+
+    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
+
+    wined3d_mutex_lock();
+    wined3d_resource_get_desc(wined3d_resource, &desc);
+    if (desc.resource_type == WINED3D_RTYPE_BUFFER)
+    {
+        if (subresource_idx)
+            hr = E_INVALIDARG;
+        layout->is_buffer = TRUE;
+        layout->width = layout->row_pitch = layout->slice_pitch = desc.size;
+        layout->height = layout->depth = layout->row_count = 1;
+    }
+    else
+    {
+        texture = wined3d_texture_from_resource(wined3d_resource);
+        if (SUCCEEDED(hr = wined3d_texture_get_sub_resource_desc(texture, subresource_idx, &sub_resource_desc)))
+        {
+            layout->is_buffer = FALSE;
+            layout->width = sub_resource_desc.width;
+            layout->height = sub_resource_desc.height;
+            layout->depth = sub_resource_desc.depth;
+            wined3d_texture_get_pitch(texture, subresource_idx % wined3d_texture_get_level_count(texture),
+                    &layout->row_pitch, &layout->slice_pitch);
+            layout->row_count = layout->slice_pitch / layout->row_pitch;
+        }
+    }
+    wined3d_mutex_unlock();
+
+    return hr;
+}
+
+/* Returns the number of bytes UpdateSubresource() reads from "data". For
+ * block based formats, rows of blocks are counted rather than rows of
+ * pixels, and the last row only counts as many bytes as the box covers. */
+static SIZE_T d3d11_get_update_data_size(const struct d3d11_subresource_layout *layout,
+        const D3D11_BOX *box, UINT row_pitch, UINT depth_pitch)
+{
+    unsigned int width, height, depth, block_size, block_count, row_count;
+
+    if (layout->is_buffer)
+        return box ? box->right - box->left : layout->width;
+
+    width = box ? box->right - box->left : layout->width;
+    height = box ? box->bottom - box->top : layout->height;
+    depth = box ? box->back - box->front : layout->depth;
+    if (!width || !height || !depth)
+        return 0;
+
+    block_size = (layout->height + layout->row_count - 1) / layout->row_count;
+    row_count = (height + block_size - 1) / block_size;
+    block_count = (width + block_size - 1) / block_size;
+
+    return (depth - 1) * depth_pitch + (row_count - 1) * row_pitch
+            + block_count * (layout->row_pitch / ((layout->width + block_size - 1) / block_size));
+}
+
+static void d3d11_deferred_context_free_mappings(struct d3d11_deferred_context *context)
+{
+    struct d3d11_deferred_mapping *mapping, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(mapping, next, &context->mapped_resources, struct d3d11_deferred_mapping, entry)
+    {
+        if (mapping->mapped)
+            WARN("Resource %p, subresource %u is still mapped.\n", mapping->resource, mapping->subresource_idx);
+        ID3D11Resource_Release(mapping->resource);
+        list_remove(&mapping->entry);
+        heap_free(mapping);
+    }
+}
+
+static struct d3d11_deferred_mapping *d3d11_deferred_context_find_mapping(struct d3d11_deferred_context *context,
+        ID3D11Resource *resource, UINT subresource_idx)
+{
+    struct d3d11_deferred_mapping *mapping;
+
+    LIST_FOR_EACH_ENTRY(mapping, &context->mapped_resources, struct d3d11_deferred_mapping, entry)
+    {
+        if (mapping->resource == resource && mapping->subresource_idx == subresource_idx)
+            return mapping;
+    }
+
+    return NULL;
+}
+
+static void d3d11_deferred_context_record_object(struct d3d11_deferred_context *context,
+        enum d3d11_command_op opcode, void *object)
+{
+    struct d3d11_command_set_object *op;
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, opcode, sizeof(*op), 1)))
+        return;
+    op->object = object;
+    d3d11_command_list_add_object(context->command_list, object);
+}
+
+static void d3d11_deferred_context_set_shader(struct d3d11_deferred_context *context,
+        enum d3d11_shader_stage stage, ID3D11DeviceChild *shader, UINT class_instance_count)
+{
+    struct d3d11_command_set_shader *op;
+
+    if (class_instance_count)
+        FIXME("Dynamic linking is not implemented yet.\n");
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_SHADER, sizeof(*op), 1)))
+        return;
+    op->stage = stage;
+    op->shader = shader;
+    d3d11_command_list_add_object(context->command_list, shader);
+
+    d3d11_objects_replace((IUnknown **)&context->state.shaders[stage], (IUnknown *const *)&shader, 1);
+}
+
+static void d3d11_deferred_context_get_shader(struct d3d11_deferred_context *context,
+        enum d3d11_shader_stage stage, ID3D11DeviceChild **shader,
+        ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    if (class_instances || class_instance_count)
+        FIXME("Dynamic linking not implemented yet.\n");
+
+    if ((*shader = context->state.shaders[stage]))
+        ID3D11DeviceChild_AddRef(*shader);
+}
+
+static IUnknown **d3d11_context_state_get_bindings(struct d3d11_context_state *state,
+        enum d3d11_shader_stage stage, enum d3d11_binding_type type, unsigned int *slot_count)
+{
+    switch (type)
+    {
+        case D3D11_BINDING_CONSTANT_BUFFER:
+            *slot_count = ARRAY_SIZE(state->constant_buffers[stage]);
+            return (IUnknown **)state->constant_buffers[stage];
+
+        case D3D11_BINDING_SHADER_RESOURCE_VIEW:
+            *slot_count = ARRAY_SIZE(state->shader_resource_views[stage]);
+            return (IUnknown **)state->shader_resource_views[stage];
+
+        case D3D11_BINDING_SAMPLER:
+            *slot_count = ARRAY_SIZE(state->samplers[stage]);
+            return (IUnknown **)state->samplers[stage];
+    }
+
+    *slot_count = 0;
+    return NULL;
+}
+
+static void d3d11_deferred_context_set_bindings(struct d3d11_deferred_context *context,
+        enum d3d11_shader_stage stage, enum d3d11_binding_type type,
+        UINT start_slot, UINT count, IUnknown *const *objects)
+{
+    struct d3d11_command_set_bindings *op;
+    unsigned int slot_count;
+    IUnknown **bindings;
+
+    bindings = d3d11_context_state_get_bindings(&context->state, stage, type, &slot_count);
+    if (start_slot > slot_count || count > slot_count - start_slot)
+    {
+        WARN("Invalid slot range %u, count %u.\n", start_slot, count);
+        return;
+    }
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, D3D11_COMMAND_SET_BINDINGS,
+            FIELD_OFFSET(struct d3d11_command_set_bindings, objects[count]), count)))
+        return;
+    op->stage = stage;
+    op->type = type;
+    op->start_slot = start_slot;
+    op->count = count;
+    if (count)
+        memcpy(op->objects, objects, count * sizeof(*objects));
+    d3d11_command_list_add_objects(context->command_list, op->objects, count);
+
+    d3d11_objects_replace(&bindings[start_slot], op->objects, count);
+}
+
+static void d3d11_deferred_context_get_bindings(struct d3d11_deferred_context *context,
+        enum d3d11_shader_stage stage, enum d3d11_binding_type type,
+        UINT start_slot, UINT count, IUnknown **objects)
+{
+    unsigned int slot_count, i;
+    IUnknown **bindings;
+
+    bindings = d3d11_context_state_get_bindings(&context->state, stage, type, &slot_count);
+    for (i = 0; i < count; ++i)
+    {
+        objects[i] = start_slot + i < slot_count ? bindings[start_slot + i] : NULL;
+        if (objects[i])
+            IUnknown_AddRef(objects[i]);
+    }
+}
+
+static void d3d11_deferred_context_draw(struct d3d11_deferred_context *context, enum d3d11_command_op opcode,
+        UINT count, UINT instance_count, UINT start_idx, INT base_vertex_idx, UINT start_instance)
+{
+    struct d3d11_command_draw *op;
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, opcode, sizeof(*op), 0)))
+        return;
+    op->count = count;
+    op->instance_count = instance_count;
+    op->start_idx = start_idx;
+    op->base_vertex_idx = base_vertex_idx;
+    op->start_instance = start_instance;
+}
+
+static void d3d11_deferred_context_draw_indirect(struct d3d11_deferred_context *context,
+        enum d3d11_command_op opcode, ID3D11Buffer *buffer, UINT offset)
+{
+    struct d3d11_command_draw_indirect *op;
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, opcode, sizeof(*op), 1)))
+        return;
+    op->buffer = buffer;
+    op->offset = offset;
+    d3d11_command_list_add_object(context->command_list, buffer);
+}
+
+static void d3d11_deferred_context_clear_view(struct d3d11_deferred_context *context,
+        enum d3d11_command_op opcode, void *view, const void *values)
+{
+    struct d3d11_command_clear_view *op;
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, opcode, sizeof(*op), 1)))
+        return;
+    op->view = view;
+    memcpy(&op->values, values, sizeof(op->values));
+    d3d11_command_list_add_object(context->command_list, view);
+}
+
+static void d3d11_deferred_context_set_render_targets_and_uavs(struct d3d11_deferred_context *context,
+        UINT rtv_count, ID3D11RenderTargetView *const *rtvs, ID3D11DepthStencilView *dsv,
+        UINT uav_start_slot, UINT uav_count, ID3D11UnorderedAccessView *const *uavs, const UINT *initial_counts)
+{
+    struct d3d11_context_state *state = &context->state;
+    struct d3d11_command_set_render_targets_and_uavs *op;
+
+    if (rtv_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL && rtv_count > ARRAY_SIZE(op->rtvs))
+    {
+        WARN("Invalid render target view count %u.\n", rtv_count);
+        return;
+    }
+    if (uav_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS
+            && (uav_start_slot > ARRAY_SIZE(op->uavs) || uav_count > ARRAY_SIZE(op->uavs) - uav_start_slot))
+    {
+        WARN("Invalid unordered access view range %u, count %u.\n", uav_start_slot, uav_count);
+        return;
+    }
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, D3D11_COMMAND_SET_RENDER_TARGETS_AND_UAVS,
+            sizeof(*op), ARRAY_SIZE(op->rtvs) + 1 + ARRAY_SIZE(op->uavs))))
+        return;
+    memset(&op->rtv_count, 0, sizeof(*op) - FIELD_OFFSET(struct d3d11_command_set_render_targets_and_uavs, rtv_count));
+    op->rtv_count = rtv_count;
+    op->uav_start_slot = uav_start_slot;
+    op->uav_count = uav_count;
+
+    if (rtv_count != D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL)
+    {
+        memcpy(op->rtvs, rtvs, rtv_count * sizeof(*rtvs));
+        op->dsv = dsv;
+        d3d11_command_list_add_objects(context->command_list, (IUnknown *const *)op->rtvs, rtv_count);
+        d3d11_command_list_add_object(context->command_list, dsv);
+
+        d3d11_objects_replace((IUnknown **)state->render_target_views, (IUnknown *const *)op->rtvs,
+                ARRAY_SIZE(state->render_target_views));
+        d3d11_objects_replace((IUnknown **)&state->depth_stencil_view, (IUnknown *const *)&op->dsv, 1);
+    }
+
+    if (uav_count != D3D11_KEEP_UNORDERED_ACCESS_VIEWS)
+    {
+        memcpy(op->uavs, uavs, uav_count * sizeof(*uavs));
+        if ((op->has_initial_counts = !!initial_counts))
+            memcpy(op->initial_counts, initial_counts, uav_count * sizeof(*initial_counts));
+        d3d11_command_list_add_objects(context->command_list, (IUnknown *const *)op->uavs, uav_count);
+
+        d3d11_objects_replace((IUnknown **)state->ps_uavs, NULL, uav_start_slot);
+        d3d11_objects_replace((IUnknown **)&state->ps_uavs[uav_start_slot],
+                (IUnknown *const *)op->uavs, ARRAY_SIZE(state->ps_uavs) - uav_start_slot);
+    }
+}
+
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_QueryInterface(ID3D11DeviceContext *iface,
+        REFIID riid, void **out)
+{
+    TRACE("iface %p, riid %s, out %p.\n", iface, debugstr_guid(riid), out);
+
+    if (IsEqualGUID(riid, &IID_ID3D11DeviceContext)
+            || IsEqualGUID(riid, &IID_ID3D11DeviceChild)
+            || IsEqualGUID(riid, &IID_IUnknown))
+    {
+        ID3D11DeviceContext_AddRef(iface);
+        *out = iface;
+        return S_OK;
+    }
+
+    WARN("%s not implemented, returning E_NOINTERFACE.\n", debugstr_guid(riid));
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_AddRef(ID3D11DeviceContext *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    ULONG refcount = InterlockedIncrement(&context->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", context, refcount);
+
+    return refcount;
+}
+
+static ULONG STDMETHODCALLTYPE d3d11_deferred_context_Release(ID3D11DeviceContext *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    ULONG refcount = InterlockedDecrement(&context->refcount);
+    ID3D11Device *device;
+
+    TRACE("%p decreasing refcount to %u.\n", context, refcount);
+
+    if (!refcount)
+    {
+        device = context->device;
+        d3d11_deferred_context_free_mappings(context);
+        d3d11_context_state_cleanup(&context->state);
+        ID3D11CommandList_Release(&context->command_list->ID3D11CommandList_iface);
+        wined3d_private_store_cleanup(&context->private_store);
+        heap_free(context);
+        ID3D11Device_Release(device);
+    }
+
+    return refcount;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetDevice(ID3D11DeviceContext *iface, ID3D11Device **device)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, device %p.\n", iface, device);
+
+    *device = context->device;
+    ID3D11Device_AddRef(*device);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
+        UINT *data_size, void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data_size %p, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_get_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateData(ID3D11DeviceContext *iface, REFGUID guid,
+        UINT data_size, const void *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data_size %u, data %p.\n", iface, debugstr_guid(guid), data_size, data);
+
+    return d3d_set_private_data(&context->private_store, guid, data_size, data);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_SetPrivateDataInterface(ID3D11DeviceContext *iface,
+        REFGUID guid, const IUnknown *data)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, guid %s, data %p.\n", iface, debugstr_guid(guid), data);
+
+    return d3d_set_private_data_interface(&context->private_store, guid, data);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_VS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_PS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetShader(ID3D11DeviceContext *iface,
+        ID3D11PixelShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(context, D3D11_STAGE_PS, (ID3D11DeviceChild *)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_PS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShader(ID3D11DeviceContext *iface,
+        ID3D11VertexShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(context, D3D11_STAGE_VS, (ID3D11DeviceChild *)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexed(ID3D11DeviceContext *iface,
+        UINT index_count, UINT start_index_location, INT base_vertex_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, index_count %u, start_index_location %u, base_vertex_location %d.\n",
+            iface, index_count, start_index_location, base_vertex_location);
+
+    d3d11_deferred_context_draw(context, D3D11_COMMAND_DRAW_INDEXED,
+            index_count, 1, start_index_location, base_vertex_location, 0);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Draw(ID3D11DeviceContext *iface,
+        UINT vertex_count, UINT start_vertex_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, vertex_count %u, start_vertex_location %u.\n",
+            iface, vertex_count, start_vertex_location);
+
+    d3d11_deferred_context_draw(context, D3D11_COMMAND_DRAW,
+            vertex_count, 1, start_vertex_location, 0, 0);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_Map(ID3D11DeviceContext *iface, ID3D11Resource *resource,
+        UINT subresource_idx, D3D11_MAP map_type, UINT map_flags, D3D11_MAPPED_SUBRESOURCE *mapped_subresource)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_subresource_layout layout;
+    struct d3d11_deferred_mapping *mapping;
+    SIZE_T size;
+    HRESULT hr;
+
+    TRACE("iface %p, resource %p, subresource_idx %u, map_type %u, map_flags %#x, mapped_subresource %p.\n",
+            iface, resource, subresource_idx, map_type, map_flags, mapped_subresource);
+
+    if (map_flags)
+        FIXME("Ignoring map_flags %#x.\n", map_flags);
+
+    if (FAILED(hr = d3d11_get_subresource_layout(resource, subresource_idx, &layout)))
+        return hr;
+
+    if (map_type != D3D11_MAP_WRITE_DISCARD
+            && (map_type != D3D11_MAP_WRITE_NO_OVERWRITE || !layout.is_buffer))
+    {
+        WARN("Invalid map type %#x.\n", map_type);
+        return E_INVALIDARG;
+    }
+
+    /* The data written to a buffer is kept around until the command list is
+     * finished, so that NO_OVERWRITE maps see the data from the previous
+     * DISCARD map. */
+    if (!(mapping = d3d11_deferred_context_find_mapping(context, resource, subresource_idx)))
+    {
+        if (map_type == D3D11_MAP_WRITE_NO_OVERWRITE)
+        {
+            WARN("NO_OVERWRITE map without a previous DISCARD map.\n");
+            return E_INVALIDARG;
+        }
+
+        size = layout.slice_pitch * layout.depth;
+        if (!(mapping = heap_alloc(FIELD_OFFSET(struct d3d11_deferred_mapping, data[size]))))
+            return E_OUTOFMEMORY;
+        ID3D11Resource_AddRef(mapping->resource = resource);
+        mapping->subresource_idx = subresource_idx;
+        mapping->mapped = FALSE;
+        mapping->row_pitch = layout.row_pitch;
+        mapping->depth_pitch = layout.slice_pitch;
+        mapping->size = size;
+        list_add_tail(&context->mapped_resources, &mapping->entry);
+    }
+    else if (mapping->mapped)
+    {
+        WARN("Resource %p, subresource %u is already mapped.\n", resource, subresource_idx);
+        return E_INVALIDARG;
+    }
+
+    mapping->map_type = map_type;
+    mapping->mapped = TRUE;
+
+    mapped_subresource->pData = mapping->data;
+    mapped_subresource->RowPitch = mapping->row_pitch;
+    mapped_subresource->DepthPitch = mapping->depth_pitch;
+
+    return S_OK;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Unmap(ID3D11DeviceContext *iface, ID3D11Resource *resource,
+        UINT subresource_idx)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_deferred_mapping *mapping;
+    struct d3d11_command_write_mapped *op;
+
+    TRACE("iface %p, resource %p, subresource_idx %u.\n", iface, resource, subresource_idx);
+
+    if (!(mapping = d3d11_deferred_context_find_mapping(context, resource, subresource_idx)) || !mapping->mapped)
+    {
+        WARN("Resource %p, subresource %u is not mapped.\n", resource, subresource_idx);
+        return;
+    }
+    mapping->mapped = FALSE;
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, D3D11_COMMAND_WRITE_MAPPED,
+            FIELD_OFFSET(struct d3d11_command_write_mapped, data[mapping->size]), 1)))
+        return;
+    op->resource = resource;
+    op->subresource_idx = subresource_idx;
+    op->map_type = mapping->map_type;
+    op->row_pitch = mapping->row_pitch;
+    op->depth_pitch = mapping->depth_pitch;
+    op->size = mapping->size;
+    memcpy(op->data, mapping->data, mapping->size);
+    d3d11_command_list_add_object(context->command_list, resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_PS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetInputLayout(ID3D11DeviceContext *iface,
+        ID3D11InputLayout *input_layout)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, input_layout %p.\n", iface, input_layout);
+
+    d3d11_deferred_context_record_object(context, D3D11_COMMAND_SET_INPUT_LAYOUT, input_layout);
+    d3d11_objects_replace((IUnknown **)&context->state.input_layout, (IUnknown *const *)&input_layout, 1);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetVertexBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers, const UINT *strides, const UINT *offsets)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_context_state *state = &context->state;
+    struct d3d11_command_set_vertex_buffers *op;
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
+            iface, start_slot, buffer_count, buffers, strides, offsets);
+
+    if (start_slot > ARRAY_SIZE(op->buffers) || buffer_count > ARRAY_SIZE(op->buffers) - start_slot)
+    {
+        WARN("Invalid slot range %u, count %u.\n", start_slot, buffer_count);
+        return;
+    }
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_VERTEX_BUFFERS, sizeof(*op), buffer_count)))
+        return;
+    op->start_slot = start_slot;
+    op->count = buffer_count;
+    memcpy(op->buffers, buffers, buffer_count * sizeof(*buffers));
+    memcpy(op->strides, strides, buffer_count * sizeof(*strides));
+    memcpy(op->offsets, offsets, buffer_count * sizeof(*offsets));
+    d3d11_command_list_add_objects(context->command_list, (IUnknown *const *)op->buffers, buffer_count);
+
+    d3d11_objects_replace((IUnknown **)&state->vertex_buffers[start_slot],
+            (IUnknown *const *)op->buffers, buffer_count);
+    memcpy(&state->vertex_buffer_strides[start_slot], strides, buffer_count * sizeof(*strides));
+    memcpy(&state->vertex_buffer_offsets[start_slot], offsets, buffer_count * sizeof(*offsets));
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetIndexBuffer(ID3D11DeviceContext *iface,
+        ID3D11Buffer *buffer, DXGI_FORMAT format, UINT offset)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_index_buffer *op;
+
+    TRACE("iface %p, buffer %p, format %s, offset %u.\n", iface, buffer, debug_dxgi_format(format), offset);
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_INDEX_BUFFER, sizeof(*op), 1)))
+        return;
+    op->buffer = buffer;
+    op->format = format;
+    op->offset = offset;
+    d3d11_command_list_add_object(context->command_list, buffer);
+
+    d3d11_objects_replace((IUnknown **)&context->state.index_buffer, (IUnknown *const *)&buffer, 1);
+    context->state.index_buffer_format = format;
+    context->state.index_buffer_offset = offset;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstanced(ID3D11DeviceContext *iface,
+        UINT instance_index_count, UINT instance_count, UINT start_index_location, INT base_vertex_location,
+        UINT start_instance_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, instance_index_count %u, instance_count %u, start_index_location %u, "
+            "base_vertex_location %d, start_instance_location %u.\n",
+            iface, instance_index_count, instance_count, start_index_location,
+            base_vertex_location, start_instance_location);
+
+    d3d11_deferred_context_draw(context, D3D11_COMMAND_DRAW_INDEXED_INSTANCED, instance_index_count,
+            instance_count, start_index_location, base_vertex_location, start_instance_location);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstanced(ID3D11DeviceContext *iface,
+        UINT instance_vertex_count, UINT instance_count, UINT start_vertex_location, UINT start_instance_location)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, instance_vertex_count %u, instance_count %u, start_vertex_location %u, "
+            "start_instance_location %u.\n",
+            iface, instance_vertex_count, instance_count, start_vertex_location,
+            start_instance_location);
+
+    d3d11_deferred_context_draw(context, D3D11_COMMAND_DRAW_INSTANCED, instance_vertex_count,
+            instance_count, start_vertex_location, 0, start_instance_location);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_GS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown *const *)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShader(ID3D11DeviceContext *iface,
+        ID3D11GeometryShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_set_shader(context, D3D11_STAGE_GS, (ID3D11DeviceChild *)shader, class_instance_count);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_IASetPrimitiveTopology(ID3D11DeviceContext *iface,
+        D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_primitive_topology *op;
+
+    TRACE("iface %p, topology %#x.\n", iface, topology);
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_PRIMITIVE_TOPOLOGY, sizeof(*op), 0)))
+        return;
+    op->topology = topology;
+
+    context->state.primitive_topology = topology;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_VS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_VS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_Begin(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    d3d11_deferred_context_record_object(context, D3D11_COMMAND_BEGIN, asynchronous);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_End(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, asynchronous %p.\n", iface, asynchronous);
+
+    d3d11_deferred_context_record_object(context, D3D11_COMMAND_END, asynchronous);
+}
+
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_GetData(ID3D11DeviceContext *iface,
+        ID3D11Asynchronous *asynchronous, void *data, UINT data_size, UINT data_flags)
+{
+    TRACE("iface %p, asynchronous %p, data %p, data_size %u, data_flags %#x.\n",
+            iface, asynchronous, data, data_size, data_flags);
+
+    WARN("Not supported on deferred contexts.\n");
+
+    return DXGI_ERROR_INVALID_CALL;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetPredication(ID3D11DeviceContext *iface,
+        ID3D11Predicate *predicate, BOOL value)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_predication *op;
+
+    TRACE("iface %p, predicate %p, value %#x.\n", iface, predicate, value);
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_PREDICATION, sizeof(*op), 1)))
+        return;
+    op->predicate = predicate;
+    op->value = value;
+    d3d11_command_list_add_object(context->command_list, predicate);
+
+    d3d11_objects_replace((IUnknown **)&context->state.predicate, (IUnknown *const *)&predicate, 1);
+    context->state.predicate_value = value;
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetShaderResources(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_GS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown *const *)views);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSSetSamplers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
+
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_GS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown *const *)samplers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargets(ID3D11DeviceContext *iface,
+        UINT render_target_view_count, ID3D11RenderTargetView *const *render_target_views,
+        ID3D11DepthStencilView *depth_stencil_view)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (memcmp(blend_factor, default_blend_factor, sizeof(default_blend_factor))
-                && (d->SrcBlend == D3D11_BLEND_BLEND_FACTOR || d->SrcBlend == D3D11_BLEND_INV_BLEND_FACTOR
-                || d->DestBlend == D3D11_BLEND_BLEND_FACTOR || d->DestBlend == D3D11_BLEND_INV_BLEND_FACTOR
-                || d->SrcBlendAlpha == D3D11_BLEND_BLEND_FACTOR || d->SrcBlendAlpha == D3D11_BLEND_INV_BLEND_FACTOR
-                || d->DestBlendAlpha == D3D11_BLEND_BLEND_FACTOR || d->DestBlendAlpha == D3D11_BLEND_INV_BLEND_FACTOR))
-            FIXME("Ignoring blend factor %s.\n", debug_float4(blend_factor));
-    }
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE, desc->RenderTarget[0].RenderTargetWriteMask);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE1, desc->RenderTarget[1].RenderTargetWriteMask);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE2, desc->RenderTarget[2].RenderTargetWriteMask);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_COLORWRITEENABLE3, desc->RenderTarget[3].RenderTargetWriteMask);
-    wined3d_mutex_unlock();
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view);
+
+    d3d11_deferred_context_set_render_targets_and_uavs(context, render_target_view_count,
+            render_target_views, depth_stencil_view, 0, D3D11_KEEP_UNORDERED_ACCESS_VIEWS, NULL, NULL);
 }
 
-static void set_default_depth_stencil_state(struct wined3d_device *wined3d_device)
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews(
+        ID3D11DeviceContext *iface, UINT render_target_view_count,
+        ID3D11RenderTargetView *const *render_target_views, ID3D11DepthStencilView *depth_stencil_view,
+        UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
+        ID3D11UnorderedAccessView *const *unordered_access_views, const UINT *initial_counts)
 {
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZENABLE, TRUE);
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZWRITEENABLE, D3D11_DEPTH_WRITE_MASK_ALL);
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_ZFUNC, WINED3D_CMP_LESS);
-    wined3d_device_set_render_state(wined3d_device, WINED3D_RS_STENCILENABLE, FALSE);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
+            "unordered_access_view_start_slot %u, unordered_access_view_count %u, unordered_access_views %p, "
+            "initial_counts %p.\n",
+            iface, render_target_view_count, render_target_views, depth_stencil_view,
+            unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views,
+            initial_counts);
+
+    d3d11_deferred_context_set_render_targets_and_uavs(context, render_target_view_count,
+            render_target_views, depth_stencil_view, unordered_access_view_start_slot,
+            unordered_access_view_count, unordered_access_views, initial_counts);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMSetDepthStencilState(ID3D11DeviceContext *iface,
-        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetBlendState(ID3D11DeviceContext *iface,
+        ID3D11BlendState *blend_state, const float blend_factor[4], UINT sample_mask)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    const D3D11_DEPTH_STENCILOP_DESC *front, *back;
-    const D3D11_DEPTH_STENCIL_DESC *desc;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    static const float default_blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    struct d3d11_command_set_blend_state *op;
 
-    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
-            iface, depth_stencil_state, stencil_ref);
+    TRACE("iface %p, blend_state %p, blend_factor %s, sample_mask 0x%08x.\n",
+            iface, blend_state, debug_float4(blend_factor), sample_mask);
 
-    wined3d_mutex_lock();
-    device->stencil_ref = stencil_ref;
-    if (!(device->depth_stencil_state = unsafe_impl_from_ID3D11DepthStencilState(depth_stencil_state)))
-    {
-        set_default_depth_stencil_state(device->wined3d_device);
-        wined3d_mutex_unlock();
+    if (!blend_factor)
+        blend_factor = default_blend_factor;
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_BLEND_STATE, sizeof(*op), 1)))
         return;
-    }
+    op->state = blend_state;
+    op->has_blend_factor = TRUE;
+    memcpy(op->blend_factor, blend_factor, sizeof(op->blend_factor));
+    op->sample_mask = sample_mask;
+    d3d11_command_list_add_object(context->command_list, blend_state);
 
-    desc = &device->depth_stencil_state->desc;
+    d3d11_objects_replace((IUnknown **)&context->state.blend_state, (IUnknown *const *)&blend_state, 1);
+    memcpy(context->state.blend_factor, blend_factor, sizeof(context->state.blend_factor));
+    context->state.sample_mask = sample_mask;
+}
 
-    front = &desc->FrontFace;
-    back = &desc->BackFace;
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMSetDepthStencilState(ID3D11DeviceContext *iface,
+        ID3D11DepthStencilState *depth_stencil_state, UINT stencil_ref)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_depth_stencil_state *op;
 
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZENABLE, desc->DepthEnable);
-    if (desc->DepthEnable)
-    {
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZWRITEENABLE, desc->DepthWriteMask);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ZFUNC, desc->DepthFunc);
-    }
+    TRACE("iface %p, depth_stencil_state %p, stencil_ref %u.\n",
+            iface, depth_stencil_state, stencil_ref);
 
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILENABLE, desc->StencilEnable);
-    if (desc->StencilEnable)
-    {
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILMASK, desc->StencilReadMask);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILWRITEMASK, desc->StencilWriteMask);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILREF, stencil_ref);
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_DEPTH_STENCIL_STATE, sizeof(*op), 1)))
+        return;
+    op->state = depth_stencil_state;
+    op->stencil_ref = stencil_ref;
+    d3d11_command_list_add_object(context->command_list, depth_stencil_state);
 
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILFAIL, front->StencilFailOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILZFAIL, front->StencilDepthFailOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILPASS, front->StencilPassOp);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_STENCILFUNC, front->StencilFunc);
-        if (front->StencilFailOp != back->StencilFailOp
-                || front->StencilDepthFailOp != back->StencilDepthFailOp
-                || front->StencilPassOp != back->StencilPassOp
-                || front->StencilFunc != back->StencilFunc)
-        {
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_TWOSIDEDSTENCILMODE, TRUE);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILFAIL, back->StencilFailOp);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILZFAIL,
-                    back->StencilDepthFailOp);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILPASS, back->StencilPassOp);
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_BACK_STENCILFUNC, back->StencilFunc);
-        }
-        else
-        {
-            wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_TWOSIDEDSTENCILMODE, FALSE);
-        }
-    }
-    wined3d_mutex_unlock();
+    d3d11_objects_replace((IUnknown **)&context->state.depth_stencil_state,
+            (IUnknown *const *)&depth_stencil_state, 1);
+    context->state.stencil_ref = stencil_ref;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SOSetTargets(ID3D11DeviceContext *iface, UINT buffer_count,
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOSetTargets(ID3D11DeviceContext *iface, UINT buffer_count,
         ID3D11Buffer *const *buffers, const UINT *offsets)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int count, i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_context_state *state = &context->state;
+    struct d3d11_command_set_so_targets *op;
+    unsigned int i;
 
     TRACE("iface %p, buffer_count %u, buffers %p, offsets %p.\n", iface, buffer_count, buffers, offsets);
 
-    count = min(buffer_count, D3D11_SO_BUFFER_SLOT_COUNT);
-    wined3d_mutex_lock();
-    for (i = 0; i < count; ++i)
-    {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+    buffer_count = min(buffer_count, ARRAY_SIZE(op->buffers));
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_SO_TARGETS, sizeof(*op), buffer_count)))
+        return;
+    memset(op->buffers, 0, sizeof(op->buffers));
+    op->count = buffer_count;
+    memcpy(op->buffers, buffers, buffer_count * sizeof(*buffers));
+    if ((op->has_offsets = !!offsets))
+        memcpy(op->offsets, offsets, buffer_count * sizeof(*offsets));
+    d3d11_command_list_add_objects(context->command_list, (IUnknown *const *)op->buffers, buffer_count);
 
-        wined3d_device_set_stream_output(device->wined3d_device, i,
-                buffer ? buffer->wined3d_buffer : NULL, offsets ? offsets[i] : 0);
-    }
-    for (; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_stream_output(device->wined3d_device, i, NULL, 0);
-    }
-    wined3d_mutex_unlock();
+    d3d11_objects_replace((IUnknown **)state->so_buffers, (IUnknown *const *)op->buffers,
+            ARRAY_SIZE(state->so_buffers));
+    for (i = 0; i < ARRAY_SIZE(state->so_offsets); ++i)
+        state->so_offsets[i] = i < buffer_count && offsets ? offsets[i] : 0;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawAuto(ID3D11DeviceContext *iface)
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawAuto(ID3D11DeviceContext *iface)
 {
-    FIXME("iface %p stub!\n", iface);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p.\n", iface);
+
+    d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_DRAW_AUTO, sizeof(struct d3d11_command), 0);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawIndexedInstancedIndirect(ID3D11DeviceContext *iface,
         ID3D11Buffer *buffer, UINT offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_buffer *d3d_buffer;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
 
-    d3d_buffer = unsafe_impl_from_ID3D11Buffer(buffer);
-
-    wined3d_mutex_lock();
-    wined3d_device_draw_indexed_primitive_instanced_indirect(device->wined3d_device,
-            d3d_buffer->wined3d_buffer, offset);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_draw_indirect(context, D3D11_COMMAND_DRAW_INDEXED_INSTANCED_INDIRECT, buffer, offset);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DrawInstancedIndirect(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DrawInstancedIndirect(ID3D11DeviceContext *iface,
         ID3D11Buffer *buffer, UINT offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_buffer *d3d_buffer;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
 
-    d3d_buffer = unsafe_impl_from_ID3D11Buffer(buffer);
-
-    wined3d_mutex_lock();
-    wined3d_device_draw_primitive_instanced_indirect(device->wined3d_device,
-            d3d_buffer->wined3d_buffer, offset);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_draw_indirect(context, D3D11_COMMAND_DRAW_INSTANCED_INDIRECT, buffer, offset);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Dispatch(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_Dispatch(ID3D11DeviceContext *iface,
         UINT thread_group_count_x, UINT thread_group_count_y, UINT thread_group_count_z)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_dispatch *op;
 
     TRACE("iface %p, thread_group_count_x %u, thread_group_count_y %u, thread_group_count_z %u.\n",
             iface, thread_group_count_x, thread_group_count_y, thread_group_count_z);
 
-    wined3d_mutex_lock();
-    wined3d_device_dispatch_compute(device->wined3d_device,
-            thread_group_count_x, thread_group_count_y, thread_group_count_z);
-    wined3d_mutex_unlock();
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_DISPATCH, sizeof(*op), 0)))
+        return;
+    op->group_count_x = thread_group_count_x;
+    op->group_count_y = thread_group_count_y;
+    op->group_count_z = thread_group_count_z;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DispatchIndirect(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DispatchIndirect(ID3D11DeviceContext *iface,
         ID3D11Buffer *buffer, UINT offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, buffer %p, offset %u.\n", iface, buffer, offset);
 
-    buffer_impl = unsafe_impl_from_ID3D11Buffer(buffer);
-
-    wined3d_mutex_lock();
-    wined3d_device_dispatch_compute_indirect(device->wined3d_device,
-            buffer_impl->wined3d_buffer, offset);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_draw_indirect(context, D3D11_COMMAND_DISPATCH_INDIRECT, buffer, offset);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetState(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetState(ID3D11DeviceContext *iface,
         ID3D11RasterizerState *rasterizer_state)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_rasterizer_state *rasterizer_state_impl;
-    const D3D11_RASTERIZER_DESC *desc;
-    union
-    {
-        DWORD d;
-        float f;
-    } scale_bias, const_bias;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
 
-    wined3d_mutex_lock();
-    if (!(rasterizer_state_impl = unsafe_impl_from_ID3D11RasterizerState(rasterizer_state)))
-    {
-        wined3d_device_set_rasterizer_state(device->wined3d_device, NULL);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_FILLMODE, WINED3D_FILL_SOLID);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_CULLMODE, WINED3D_CULL_BACK);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SLOPESCALEDEPTHBIAS, 0);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DEPTHBIAS, 0);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SCISSORTESTENABLE, FALSE);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEANTIALIAS, FALSE);
-        wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_ANTIALIASEDLINEENABLE, FALSE);
-        wined3d_mutex_unlock();
-        return;
-    }
-
-    wined3d_device_set_rasterizer_state(device->wined3d_device, rasterizer_state_impl->wined3d_state);
-
-    desc = &rasterizer_state_impl->desc;
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_FILLMODE, desc->FillMode);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_CULLMODE, desc->CullMode);
-    scale_bias.f = desc->SlopeScaledDepthBias;
-    const_bias.f = desc->DepthBias;
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SLOPESCALEDEPTHBIAS, scale_bias.d);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_DEPTHBIAS, const_bias.d);
-    /* GL_DEPTH_CLAMP */
-    if (!desc->DepthClipEnable)
-        FIXME("Ignoring DepthClipEnable %#x.\n", desc->DepthClipEnable);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_SCISSORTESTENABLE, desc->ScissorEnable);
-    wined3d_device_set_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEANTIALIAS, desc->MultisampleEnable);
-    wined3d_device_set_render_state(device->wined3d_device,
-            WINED3D_RS_ANTIALIASEDLINEENABLE, desc->AntialiasedLineEnable);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_record_object(context, D3D11_COMMAND_SET_RASTERIZER_STATE, rasterizer_state);
+    d3d11_objects_replace((IUnknown **)&context->state.rasterizer_state,
+            (IUnknown *const *)&rasterizer_state, 1);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetViewports(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetViewports(ID3D11DeviceContext *iface,
         UINT viewport_count, const D3D11_VIEWPORT *viewports)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_viewport wined3d_vp;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_viewports *op;
 
     TRACE("iface %p, viewport_count %u, viewports %p.\n", iface, viewport_count, viewports);
 
-    if (viewport_count > 1)
-        FIXME("Multiple viewports not implemented.\n");
-
-    if (!viewport_count)
+    if (viewport_count > ARRAY_SIZE(context->state.viewports))
+    {
+        WARN("Invalid viewport count %u.\n", viewport_count);
         return;
+    }
 
-    wined3d_vp.x = viewports[0].TopLeftX;
-    wined3d_vp.y = viewports[0].TopLeftY;
-    wined3d_vp.width = viewports[0].Width;
-    wined3d_vp.height = viewports[0].Height;
-    wined3d_vp.min_z = viewports[0].MinDepth;
-    wined3d_vp.max_z = viewports[0].MaxDepth;
+    if (!(op = d3d11_command_list_require_space(context->command_list, D3D11_COMMAND_SET_VIEWPORTS,
+            FIELD_OFFSET(struct d3d11_command_set_viewports, viewports[viewport_count]), 0)))
+        return;
+    op->count = viewport_count;
+    memcpy(op->viewports, viewports, viewport_count * sizeof(*viewports));
 
-    wined3d_mutex_lock();
-    wined3d_device_set_viewport(device->wined3d_device, &wined3d_vp);
-    wined3d_mutex_unlock();
+    context->state.viewport_count = viewport_count;
+    memcpy(context->state.viewports, viewports, viewport_count * sizeof(*viewports));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSSetScissorRects(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSSetScissorRects(ID3D11DeviceContext *iface,
         UINT rect_count, const D3D11_RECT *rects)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_scissor_rects *op;
 
     TRACE("iface %p, rect_count %u, rects %p.\n", iface, rect_count, rects);
 
-    if (rect_count > 1)
-        FIXME("Multiple scissor rects not implemented.\n");
-
-    if (!rect_count)
+    if (rect_count > ARRAY_SIZE(context->state.scissor_rects))
+    {
+        WARN("Invalid scissor rect count %u.\n", rect_count);
         return;
+    }
 
-    wined3d_mutex_lock();
-    wined3d_device_set_scissor_rect(device->wined3d_device, rects);
-    wined3d_mutex_unlock();
-}
-
-static void STDMETHODCALLTYPE d3d11_immediate_context_CopySubresourceRegion(ID3D11DeviceContext *iface,
-        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
-        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
-    struct wined3d_box wined3d_src_box;
-
-    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
-            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
-            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
-            src_resource, src_subresource_idx, src_box);
-
-    if (src_box)
-        wined3d_box_set(&wined3d_src_box, src_box->left, src_box->top,
-                src_box->right, src_box->bottom, src_box->front, src_box->back);
-
-    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
-    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
-    wined3d_mutex_lock();
-    wined3d_device_copy_sub_resource_region(device->wined3d_device, wined3d_dst_resource, dst_subresource_idx,
-            dst_x, dst_y, dst_z, wined3d_src_resource, src_subresource_idx, src_box ? &wined3d_src_box : NULL);
-    wined3d_mutex_unlock();
+    if (!(op = d3d11_command_list_require_space(context->command_list, D3D11_COMMAND_SET_SCISSOR_RECTS,
+            FIELD_OFFSET(struct d3d11_command_set_scissor_rects, rects[rect_count]), 0)))
+        return;
+    op->count = rect_count;
+    memcpy(op->rects, rects, rect_count * sizeof(*rects));
+
+    context->state.scissor_rect_count = rect_count;
+    memcpy(context->state.scissor_rects, rects, rect_count * sizeof(*rects));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CopyResource(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopySubresourceRegion(ID3D11DeviceContext *iface,
+        ID3D11Resource *dst_resource, UINT dst_subresource_idx, UINT dst_x, UINT dst_y, UINT dst_z,
+        ID3D11Resource *src_resource, UINT src_subresource_idx, const D3D11_BOX *src_box)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_copy_subresource_region *op;
+
+    TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, dst_x %u, dst_y %u, dst_z %u, "
+            "src_resource %p, src_subresource_idx %u, src_box %p.\n",
+            iface, dst_resource, dst_subresource_idx, dst_x, dst_y, dst_z,
+            src_resource, src_subresource_idx, src_box);
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_COPY_SUBRESOURCE_REGION, sizeof(*op), 2)))
+        return;
+    op->dst_resource = dst_resource;
+    op->dst_subresource_idx = dst_subresource_idx;
+    op->dst_x = dst_x;
+    op->dst_y = dst_y;
+    op->dst_z = dst_z;
+    op->src_resource = src_resource;
+    op->src_subresource_idx = src_subresource_idx;
+    if ((op->has_src_box = !!src_box))
+        op->src_box = *src_box;
+    d3d11_command_list_add_object(context->command_list, dst_resource);
+    d3d11_command_list_add_object(context->command_list, src_resource);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyResource(ID3D11DeviceContext *iface,
         ID3D11Resource *dst_resource, ID3D11Resource *src_resource)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_copy_resource *op;
 
     TRACE("iface %p, dst_resource %p, src_resource %p.\n", iface, dst_resource, src_resource);
 
-    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
-    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
-    wined3d_mutex_lock();
-    wined3d_device_copy_resource(device->wined3d_device, wined3d_dst_resource, wined3d_src_resource);
-    wined3d_mutex_unlock();
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_COPY_RESOURCE, sizeof(*op), 2)))
+        return;
+    op->dst_resource = dst_resource;
+    op->src_resource = src_resource;
+    d3d11_command_list_add_object(context->command_list, dst_resource);
+    d3d11_command_list_add_object(context->command_list, src_resource);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_UpdateSubresource(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_UpdateSubresource(ID3D11DeviceContext *iface,
         ID3D11Resource *resource, UINT subresource_idx, const D3D11_BOX *box,
         const void *data, UINT row_pitch, UINT depth_pitch)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_resource *wined3d_resource;
-    struct wined3d_box wined3d_box;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_update_subresource *op;
+    struct d3d11_subresource_layout layout;
+    SIZE_T size;
 
     TRACE("iface %p, resource %p, subresource_idx %u, box %p, data %p, row_pitch %u, depth_pitch %u.\n",
             iface, resource, subresource_idx, box, data, row_pitch, depth_pitch);
 
-    if (box)
-        wined3d_box_set(&wined3d_box, box->left, box->top, box->right, box->bottom, box->front, box->back);
+    if (FAILED(d3d11_get_subresource_layout(resource, subresource_idx, &layout)))
+    {
+        WARN("Invalid subresource %u.\n", subresource_idx);
+        return;
+    }
 
-    wined3d_resource = wined3d_resource_from_d3d11_resource(resource);
-    wined3d_mutex_lock();
-    wined3d_device_update_sub_resource(device->wined3d_device, wined3d_resource,
-            subresource_idx, box ? &wined3d_box : NULL, data, row_pitch, depth_pitch);
-    wined3d_mutex_unlock();
+    if (!(size = d3d11_get_update_data_size(&layout, box, row_pitch, depth_pitch)))
+        return;
+
+    if (!(op = d3d11_command_list_require_space(context->command_list, D3D11_COMMAND_UPDATE_SUBRESOURCE,
+            FIELD_OFFSET(struct d3d11_command_update_subresource, data[size]), 1)))
+        return;
+    op->resource = resource;
+    op->subresource_idx = subresource_idx;
+    if ((op->has_box = !!box))
+        op->box = *box;
+    op->row_pitch = row_pitch;
+    op->depth_pitch = depth_pitch;
+    memcpy(op->data, data, size);
+    d3d11_command_list_add_object(context->command_list, resource);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CopyStructureCount(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CopyStructureCount(ID3D11DeviceContext *iface,
         ID3D11Buffer *dst_buffer, UINT dst_offset, ID3D11UnorderedAccessView *src_view)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_unordered_access_view *uav;
-    struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_copy_structure_count *op;
 
     TRACE("iface %p, dst_buffer %p, dst_offset %u, src_view %p.\n",
             iface, dst_buffer, dst_offset, src_view);
 
-    buffer_impl = unsafe_impl_from_ID3D11Buffer(dst_buffer);
-    uav = unsafe_impl_from_ID3D11UnorderedAccessView(src_view);
-
-    wined3d_mutex_lock();
-    wined3d_device_copy_uav_counter(device->wined3d_device,
-            buffer_impl->wined3d_buffer, dst_offset, uav->wined3d_view);
-    wined3d_mutex_unlock();
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_COPY_STRUCTURE_COUNT, sizeof(*op), 2)))
+        return;
+    op->dst_buffer = dst_buffer;
+    op->dst_offset = dst_offset;
+    op->src_view = src_view;
+    d3d11_command_list_add_object(context->command_list, dst_buffer);
+    d3d11_command_list_add_object(context->command_list, src_view);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearRenderTargetView(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearRenderTargetView(ID3D11DeviceContext *iface,
         ID3D11RenderTargetView *render_target_view, const float color_rgba[4])
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_rendertarget_view *view = unsafe_impl_from_ID3D11RenderTargetView(render_target_view);
-    const struct wined3d_color color = {color_rgba[0], color_rgba[1], color_rgba[2], color_rgba[3]};
-    HRESULT hr;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, render_target_view %p, color_rgba %s.\n",
             iface, render_target_view, debug_float4(color_rgba));
 
-    if (!view)
-        return;
-
-    wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_device_clear_rendertarget_view(device->wined3d_device, view->wined3d_view, NULL,
-            WINED3DCLEAR_TARGET, &color, 0.0f, 0)))
-        ERR("Failed to clear view, hr %#x.\n", hr);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_clear_view(context, D3D11_COMMAND_CLEAR_RENDER_TARGET_VIEW,
+            render_target_view, color_rgba);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewUint(ID3D11DeviceContext *iface,
         ID3D11UnorderedAccessView *unordered_access_view, const UINT values[4])
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_unordered_access_view *view;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, unordered_access_view %p, values {%u, %u, %u, %u}.\n",
             iface, unordered_access_view, values[0], values[1], values[2], values[3]);
 
-    view = unsafe_impl_from_ID3D11UnorderedAccessView(unordered_access_view);
-    wined3d_mutex_lock();
-    wined3d_device_clear_unordered_access_view_uint(device->wined3d_device,
-            view->wined3d_view, (const struct wined3d_uvec4 *)values);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_clear_view(context, D3D11_COMMAND_CLEAR_UAV_UINT, unordered_access_view, values);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearUnorderedAccessViewFloat(ID3D11DeviceContext *iface,
         ID3D11UnorderedAccessView *unordered_access_view, const float values[4])
 {
-    FIXME("iface %p, unordered_access_view %p, values %s stub!\n",
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, unordered_access_view %p, values %s.\n",
             iface, unordered_access_view, debug_float4(values));
+
+    d3d11_deferred_context_clear_view(context, D3D11_COMMAND_CLEAR_UAV_FLOAT, unordered_access_view, values);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearDepthStencilView(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearDepthStencilView(ID3D11DeviceContext *iface,
         ID3D11DepthStencilView *depth_stencil_view, UINT flags, FLOAT depth, UINT8 stencil)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_depthstencil_view *view = unsafe_impl_from_ID3D11DepthStencilView(depth_stencil_view);
-    DWORD wined3d_flags;
-    HRESULT hr;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_clear_depth_stencil_view *op;
 
     TRACE("iface %p, depth_stencil_view %p, flags %#x, depth %.8e, stencil %u.\n",
             iface, depth_stencil_view, flags, depth, stencil);
 
-    if (!view)
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_CLEAR_DEPTH_STENCIL_VIEW, sizeof(*op), 1)))
         return;
-
-    wined3d_flags = wined3d_clear_flags_from_d3d11_clear_flags(flags);
-
-    wined3d_mutex_lock();
-    if (FAILED(hr = wined3d_device_clear_rendertarget_view(device->wined3d_device, view->wined3d_view, NULL,
-            wined3d_flags, NULL, depth, stencil)))
-        ERR("Failed to clear view, hr %#x.\n", hr);
-    wined3d_mutex_unlock();
+    op->view = depth_stencil_view;
+    op->flags = flags;
+    op->depth = depth;
+    op->stencil = stencil;
+    d3d11_command_list_add_object(context->command_list, depth_stencil_view);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GenerateMips(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_GenerateMips(ID3D11DeviceContext *iface,
         ID3D11ShaderResourceView *view)
 {
-    struct d3d_shader_resource_view *srv = unsafe_impl_from_ID3D11ShaderResourceView(view);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, view %p.\n", iface, view);
 
-    wined3d_mutex_lock();
-    wined3d_shader_resource_view_generate_mipmaps(srv->wined3d_view);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_record_object(context, D3D11_COMMAND_GENERATE_MIPS, view);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SetResourceMinLOD(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_SetResourceMinLOD(ID3D11DeviceContext *iface,
         ID3D11Resource *resource, FLOAT min_lod)
 {
-    FIXME("iface %p, resource %p, min_lod %f stub!\n", iface, resource, min_lod);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_resource_min_lod *op;
+
+    TRACE("iface %p, resource %p, min_lod %f.\n", iface, resource, min_lod);
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_RESOURCE_MIN_LOD, sizeof(*op), 1)))
+        return;
+    op->resource = resource;
+    op->min_lod = min_lod;
+    d3d11_command_list_add_object(context->command_list, resource);
 }
 
-static FLOAT STDMETHODCALLTYPE d3d11_immediate_context_GetResourceMinLOD(ID3D11DeviceContext *iface,
+static FLOAT STDMETHODCALLTYPE d3d11_deferred_context_GetResourceMinLOD(ID3D11DeviceContext *iface,
         ID3D11Resource *resource)
 {
     FIXME("iface %p, resource %p stub!\n", iface, resource);
@@ -1174,801 +5227,464 @@ static FLOAT STDMETHODCALLTYPE d3d11_immediate_context_GetResourceMinLOD(ID3D11D
     return 0.0f;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ResolveSubresource(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_ResolveSubresource(ID3D11DeviceContext *iface,
         ID3D11Resource *dst_resource, UINT dst_subresource_idx,
         ID3D11Resource *src_resource, UINT src_subresource_idx,
         DXGI_FORMAT format)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_resource *wined3d_dst_resource, *wined3d_src_resource;
-    enum wined3d_format_id wined3d_format;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_resolve_subresource *op;
 
     TRACE("iface %p, dst_resource %p, dst_subresource_idx %u, "
             "src_resource %p, src_subresource_idx %u, format %s.\n",
             iface, dst_resource, dst_subresource_idx,
             src_resource, src_subresource_idx, debug_dxgi_format(format));
 
-    wined3d_dst_resource = wined3d_resource_from_d3d11_resource(dst_resource);
-    wined3d_src_resource = wined3d_resource_from_d3d11_resource(src_resource);
-    wined3d_format = wined3dformat_from_dxgi_format(format);
-    wined3d_mutex_lock();
-    wined3d_device_resolve_sub_resource(device->wined3d_device,
-            wined3d_dst_resource, dst_subresource_idx,
-            wined3d_src_resource, src_subresource_idx, wined3d_format);
-    wined3d_mutex_unlock();
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_RESOLVE_SUBRESOURCE, sizeof(*op), 2)))
+        return;
+    op->dst_resource = dst_resource;
+    op->dst_subresource_idx = dst_subresource_idx;
+    op->src_resource = src_resource;
+    op->src_subresource_idx = src_subresource_idx;
+    op->format = format;
+    d3d11_command_list_add_object(context->command_list, dst_resource);
+    d3d11_command_list_add_object(context->command_list, src_resource);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ExecuteCommandList(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_ExecuteCommandList(ID3D11DeviceContext *iface,
         ID3D11CommandList *command_list, BOOL restore_state)
 {
-    FIXME("iface %p, command_list %p, restore_state %#x stub!\n", iface, command_list, restore_state);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_execute_command_list *op;
+
+    TRACE("iface %p, command_list %p, restore_state %#x.\n", iface, command_list, restore_state);
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_EXECUTE_COMMAND_LIST, sizeof(*op), 1)))
+        return;
+    op->command_list = command_list;
+    op->restore_state = restore_state;
+    d3d11_command_list_add_object(context->command_list, command_list);
+
+    if (!restore_state)
+    {
+        d3d11_context_state_cleanup(&context->state);
+        d3d11_context_state_init(&context->state);
+    }
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-        wined3d_device_set_hs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_HS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown *const *)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetShader(ID3D11DeviceContext *iface,
         ID3D11HullShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_hull_shader *hs = unsafe_impl_from_ID3D11HullShader(shader);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    wined3d_device_set_hull_shader(device->wined3d_device, hs ? hs->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_shader(context, D3D11_STAGE_HS, (ID3D11DeviceChild *)shader, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        wined3d_device_set_hs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_HS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown *const *)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSSetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSSetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        wined3d_device_set_hs_cb(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_HS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown *const *)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-        wined3d_device_set_ds_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_DS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown *const *)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetShader(ID3D11DeviceContext *iface,
         ID3D11DomainShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_domain_shader *ds = unsafe_impl_from_ID3D11DomainShader(shader);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    wined3d_device_set_domain_shader(device->wined3d_device, ds ? ds->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_shader(context, D3D11_STAGE_DS, (ID3D11DeviceChild *)shader, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        wined3d_device_set_ds_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_DS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown *const *)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSSetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSSetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        wined3d_device_set_ds_cb(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_DS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown *const *)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView *const *views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct d3d_shader_resource_view *view = unsafe_impl_from_ID3D11ShaderResourceView(views[i]);
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-        wined3d_device_set_cs_resource_view(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_CS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown *const *)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetUnorderedAccessViews(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetUnorderedAccessViews(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11UnorderedAccessView *const *views, const UINT *initial_counts)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_set_cs_uavs *op;
 
     TRACE("iface %p, start_slot %u, view_count %u, views %p, initial_counts %p.\n",
             iface, start_slot, view_count, views, initial_counts);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
+    if (start_slot > ARRAY_SIZE(op->views) || view_count > ARRAY_SIZE(op->views) - start_slot)
     {
-        struct d3d11_unordered_access_view *view = unsafe_impl_from_ID3D11UnorderedAccessView(views[i]);
-
-        wined3d_device_set_cs_uav(device->wined3d_device, start_slot + i,
-                view ? view->wined3d_view : NULL, initial_counts ? initial_counts[i] : ~0u);
+        WARN("Invalid slot range %u, count %u.\n", start_slot, view_count);
+        return;
     }
-    wined3d_mutex_unlock();
+
+    if (!(op = d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_SET_CS_UAVS, sizeof(*op), view_count)))
+        return;
+    op->start_slot = start_slot;
+    op->count = view_count;
+    memcpy(op->views, views, view_count * sizeof(*views));
+    if ((op->has_initial_counts = !!initial_counts))
+        memcpy(op->initial_counts, initial_counts, view_count * sizeof(*initial_counts));
+    d3d11_command_list_add_objects(context->command_list, (IUnknown *const *)op->views, view_count);
+
+    d3d11_objects_replace((IUnknown **)&context->state.cs_uavs[start_slot],
+            (IUnknown *const *)op->views, view_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetShader(ID3D11DeviceContext *iface,
         ID3D11ComputeShader *shader, ID3D11ClassInstance *const *class_instances, UINT class_instance_count)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_compute_shader *cs = unsafe_impl_from_ID3D11ComputeShader(shader);
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %u.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances)
-        FIXME("Dynamic linking is not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    wined3d_device_set_compute_shader(device->wined3d_device, cs ? cs->wined3d_shader : NULL);
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_shader(context, D3D11_STAGE_CS, (ID3D11DeviceChild *)shader, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState *const *samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler = unsafe_impl_from_ID3D11SamplerState(samplers[i]);
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        wined3d_device_set_cs_sampler(device->wined3d_device, start_slot + i,
-                sampler ? sampler->wined3d_sampler : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_CS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown *const *)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSSetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSSetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer *const *buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct d3d_buffer *buffer = unsafe_impl_from_ID3D11Buffer(buffers[i]);
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        wined3d_device_set_cs_cb(device->wined3d_device, start_slot + i,
-                buffer ? buffer->wined3d_buffer : NULL);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_set_bindings(context, D3D11_STAGE_CS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown *const *)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_buffer = wined3d_device_get_vs_cb(device->wined3d_device, start_slot + i)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
-        ID3D11Buffer_AddRef(buffers[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_VS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown **)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_view = wined3d_device_get_ps_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
-        ID3D11ShaderResourceView_AddRef(views[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_PS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown **)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetShader(ID3D11DeviceContext *iface,
         ID3D11PixelShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_shader *wined3d_shader;
-    struct d3d_pixel_shader *shader_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_pixel_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    *shader = &shader_impl->ID3D11PixelShader_iface;
-    ID3D11PixelShader_AddRef(*shader);
+    d3d11_deferred_context_get_shader(context, D3D11_STAGE_PS, (ID3D11DeviceChild **)shader,
+            class_instances, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_sampler = wined3d_device_get_ps_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
-        ID3D11SamplerState_AddRef(samplers[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_PS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown **)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShader(ID3D11DeviceContext *iface,
         ID3D11VertexShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_vertex_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_vertex_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    *shader = &shader_impl->ID3D11VertexShader_iface;
-    ID3D11VertexShader_AddRef(*shader);
+    d3d11_deferred_context_get_shader(context, D3D11_STAGE_VS, (ID3D11DeviceChild **)shader,
+            class_instances, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_PSGetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_PSGetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_buffer = wined3d_device_get_ps_cb(device->wined3d_device, start_slot + i)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
-        ID3D11Buffer_AddRef(buffers[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_PS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown **)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetInputLayout(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetInputLayout(ID3D11DeviceContext *iface,
         ID3D11InputLayout **input_layout)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_vertex_declaration *wined3d_declaration;
-    struct d3d_input_layout *input_layout_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, input_layout %p.\n", iface, input_layout);
 
-    wined3d_mutex_lock();
-    if (!(wined3d_declaration = wined3d_device_get_vertex_declaration(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *input_layout = NULL;
-        return;
-    }
-
-    input_layout_impl = wined3d_vertex_declaration_get_parent(wined3d_declaration);
-    wined3d_mutex_unlock();
-    *input_layout = &input_layout_impl->ID3D11InputLayout_iface;
-    ID3D11InputLayout_AddRef(*input_layout);
+    if ((*input_layout = context->state.input_layout))
+        ID3D11InputLayout_AddRef(*input_layout);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetVertexBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetVertexBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers, UINT *strides, UINT *offsets)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_context_state *state = &context->state;
+    unsigned int i, slot;
 
     TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p, strides %p, offsets %p.\n",
             iface, start_slot, buffer_count, buffers, strides, offsets);
 
-    wined3d_mutex_lock();
     for (i = 0; i < buffer_count; ++i)
     {
-        struct wined3d_buffer *wined3d_buffer = NULL;
-        struct d3d_buffer *buffer_impl;
-
-        if (FAILED(wined3d_device_get_stream_source(device->wined3d_device, start_slot + i,
-                &wined3d_buffer, &offsets[i], &strides[i])))
+        if ((slot = start_slot + i) >= ARRAY_SIZE(state->vertex_buffers))
         {
-            FIXME("Failed to get vertex buffer %u.\n", start_slot + i);
+            if (buffers)
+                buffers[i] = NULL;
             if (strides)
                 strides[i] = 0;
             if (offsets)
                 offsets[i] = 0;
-        }
-
-        if (!wined3d_buffer)
-        {
-            buffers[i] = NULL;
             continue;
         }
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
+        if (buffers && (buffers[i] = state->vertex_buffers[slot]))
+            ID3D11Buffer_AddRef(buffers[i]);
+        if (strides)
+            strides[i] = state->vertex_buffer_strides[slot];
+        if (offsets)
+            offsets[i] = state->vertex_buffer_offsets[slot];
     }
-    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetIndexBuffer(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetIndexBuffer(ID3D11DeviceContext *iface,
         ID3D11Buffer **buffer, DXGI_FORMAT *format, UINT *offset)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    enum wined3d_format_id wined3d_format;
-    struct wined3d_buffer *wined3d_buffer;
-    struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, buffer %p, format %p, offset %p.\n", iface, buffer, format, offset);
 
-    wined3d_mutex_lock();
-    wined3d_buffer = wined3d_device_get_index_buffer(device->wined3d_device, &wined3d_format, offset);
-    *format = dxgi_format_from_wined3dformat(wined3d_format);
-    if (!wined3d_buffer)
-    {
-        wined3d_mutex_unlock();
-        *buffer = NULL;
-        return;
-    }
-
-    buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-    wined3d_mutex_unlock();
-    ID3D11Buffer_AddRef(*buffer = &buffer_impl->ID3D11Buffer_iface);
+    if ((*buffer = context->state.index_buffer))
+        ID3D11Buffer_AddRef(*buffer);
+    *format = context->state.index_buffer_format;
+    *offset = context->state.index_buffer_offset;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_buffer = wined3d_device_get_gs_cb(device->wined3d_device, start_slot + i)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
-        ID3D11Buffer_AddRef(buffers[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_GS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown **)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShader(ID3D11DeviceContext *iface,
-        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_geometry_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
-
-    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
-            iface, shader, class_instances, class_instance_count);
-
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_geometry_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShader(ID3D11DeviceContext *iface,
+        ID3D11GeometryShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    *shader = &shader_impl->ID3D11GeometryShader_iface;
-    ID3D11GeometryShader_AddRef(*shader);
+    TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
+            iface, shader, class_instances, class_instance_count);
+
+    d3d11_deferred_context_get_shader(context, D3D11_STAGE_GS, (ID3D11DeviceChild **)shader,
+            class_instances, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_IAGetPrimitiveTopology(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_IAGetPrimitiveTopology(ID3D11DeviceContext *iface,
         D3D11_PRIMITIVE_TOPOLOGY *topology)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    enum wined3d_primitive_type primitive_type;
-    unsigned int patch_vertex_count;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, topology %p.\n", iface, topology);
 
-    wined3d_mutex_lock();
-    wined3d_device_get_primitive_type(device->wined3d_device, &primitive_type, &patch_vertex_count);
-    wined3d_mutex_unlock();
-
-    d3d11_primitive_topology_from_wined3d_primitive_type(primitive_type, patch_vertex_count, topology);
+    *topology = context->state.primitive_topology;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_vs_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
-        ID3D11ShaderResourceView_AddRef(views[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_VS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown **)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_VSGetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_VSGetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_sampler = wined3d_device_get_vs_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
-        ID3D11SamplerState_AddRef(samplers[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_VS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown **)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GetPredication(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_GetPredication(ID3D11DeviceContext *iface,
         ID3D11Predicate **predicate, BOOL *value)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_query *wined3d_predicate;
-    struct d3d_query *predicate_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, predicate %p, value %p.\n", iface, predicate, value);
 
-    wined3d_mutex_lock();
-    if (!(wined3d_predicate = wined3d_device_get_predication(device->wined3d_device, value)))
-    {
-        wined3d_mutex_unlock();
-        *predicate = NULL;
-        return;
-    }
-
-    predicate_impl = wined3d_query_get_parent(wined3d_predicate);
-    wined3d_mutex_unlock();
-    *predicate = (ID3D11Predicate *)&predicate_impl->ID3D11Query_iface;
-    ID3D11Predicate_AddRef(*predicate);
+    if ((*predicate = context->state.predicate))
+        ID3D11Predicate_AddRef(*predicate);
+    if (value)
+        *value = context->state.predicate_value;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_gs_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        views[i] = &view_impl->ID3D11ShaderResourceView_iface;
-        ID3D11ShaderResourceView_AddRef(views[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_GS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown **)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_GSGetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_GSGetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct d3d_sampler_state *sampler_impl;
-        struct wined3d_sampler *wined3d_sampler;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_sampler = wined3d_device_get_gs_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        samplers[i] = &sampler_impl->ID3D11SamplerState_iface;
-        ID3D11SamplerState_AddRef(samplers[i]);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_GS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown **)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargets(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargets(ID3D11DeviceContext *iface,
         UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
         ID3D11DepthStencilView **depth_stencil_view)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_rendertarget_view *wined3d_view;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_context_state *state = &context->state;
+    unsigned int i;
 
     TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p.\n",
             iface, render_target_view_count, render_target_views, depth_stencil_view);
 
-    wined3d_mutex_lock();
     if (render_target_views)
     {
-        struct d3d_rendertarget_view *view_impl;
-        unsigned int i;
-
         for (i = 0; i < render_target_view_count; ++i)
         {
-            if (!(wined3d_view = wined3d_device_get_rendertarget_view(device->wined3d_device, i))
-                    || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
-            {
-                render_target_views[i] = NULL;
-                continue;
-            }
-
-            render_target_views[i] = &view_impl->ID3D11RenderTargetView_iface;
-            ID3D11RenderTargetView_AddRef(render_target_views[i]);
+            render_target_views[i] = i < ARRAY_SIZE(state->render_target_views)
+                    ? state->render_target_views[i] : NULL;
+            if (render_target_views[i])
+                ID3D11RenderTargetView_AddRef(render_target_views[i]);
         }
     }
 
-    if (depth_stencil_view)
-    {
-        struct d3d_depthstencil_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_depth_stencil_view(device->wined3d_device))
-                || !(view_impl = wined3d_rendertarget_view_get_parent(wined3d_view)))
-        {
-            *depth_stencil_view = NULL;
-        }
-        else
-        {
-            *depth_stencil_view = &view_impl->ID3D11DepthStencilView_iface;
-            ID3D11DepthStencilView_AddRef(*depth_stencil_view);
-        }
-    }
-    wined3d_mutex_unlock();
+    if (depth_stencil_view && (*depth_stencil_view = state->depth_stencil_view))
+        ID3D11DepthStencilView_AddRef(*depth_stencil_view);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews(
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews(
         ID3D11DeviceContext *iface,
         UINT render_target_view_count, ID3D11RenderTargetView **render_target_views,
         ID3D11DepthStencilView **depth_stencil_view,
         UINT unordered_access_view_start_slot, UINT unordered_access_view_count,
         ID3D11UnorderedAccessView **unordered_access_views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_unordered_access_view *wined3d_view;
-    struct d3d11_unordered_access_view *view_impl;
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_context_state *state = &context->state;
+    unsigned int i, slot;
 
     TRACE("iface %p, render_target_view_count %u, render_target_views %p, depth_stencil_view %p, "
             "unordered_access_view_start_slot %u, unordered_access_view_count %u, "
@@ -1977,751 +5693,497 @@ static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetRenderTargetsAndUnord
             unordered_access_view_start_slot, unordered_access_view_count, unordered_access_views);
 
     if (render_target_views || depth_stencil_view)
-        d3d11_immediate_context_OMGetRenderTargets(iface, render_target_view_count,
+        d3d11_deferred_context_OMGetRenderTargets(iface, render_target_view_count,
                 render_target_views, depth_stencil_view);
 
     if (unordered_access_views)
     {
-        wined3d_mutex_lock();
         for (i = 0; i < unordered_access_view_count; ++i)
         {
-            if (!(wined3d_view = wined3d_device_get_unordered_access_view(device->wined3d_device,
-                    unordered_access_view_start_slot + i)))
-            {
-                unordered_access_views[i] = NULL;
-                continue;
-            }
-
-            view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
-            unordered_access_views[i] = &view_impl->ID3D11UnorderedAccessView_iface;
-            ID3D11UnorderedAccessView_AddRef(unordered_access_views[i]);
+            slot = unordered_access_view_start_slot + i;
+            unordered_access_views[i] = slot < ARRAY_SIZE(state->ps_uavs) ? state->ps_uavs[slot] : NULL;
+            if (unordered_access_views[i])
+                ID3D11UnorderedAccessView_AddRef(unordered_access_views[i]);
         }
-        wined3d_mutex_unlock();
     }
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetBlendState(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetBlendState(ID3D11DeviceContext *iface,
         ID3D11BlendState **blend_state, FLOAT blend_factor[4], UINT *sample_mask)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_blend_state *wined3d_state;
-    struct d3d_blend_state *blend_state_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, blend_state %p, blend_factor %p, sample_mask %p.\n",
             iface, blend_state, blend_factor, sample_mask);
 
-    wined3d_mutex_lock();
-    if ((wined3d_state = wined3d_device_get_blend_state(device->wined3d_device)))
-    {
-        blend_state_impl = wined3d_blend_state_get_parent(wined3d_state);
-        ID3D11BlendState_AddRef(*blend_state = &blend_state_impl->ID3D11BlendState_iface);
-    }
-    else
-    {
-        *blend_state = NULL;
-    }
-    memcpy(blend_factor, device->blend_factor, 4 * sizeof(*blend_factor));
-    *sample_mask = wined3d_device_get_render_state(device->wined3d_device, WINED3D_RS_MULTISAMPLEMASK);
-    wined3d_mutex_unlock();
+    if (blend_state && (*blend_state = context->state.blend_state))
+        ID3D11BlendState_AddRef(*blend_state);
+    if (blend_factor)
+        memcpy(blend_factor, context->state.blend_factor, sizeof(context->state.blend_factor));
+    if (sample_mask)
+        *sample_mask = context->state.sample_mask;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_OMGetDepthStencilState(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_OMGetDepthStencilState(ID3D11DeviceContext *iface,
         ID3D11DepthStencilState **depth_stencil_state, UINT *stencil_ref)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, depth_stencil_state %p, stencil_ref %p.\n",
             iface, depth_stencil_state, stencil_ref);
 
-    if ((*depth_stencil_state = device->depth_stencil_state
-            ? &device->depth_stencil_state->ID3D11DepthStencilState_iface : NULL))
+    if (depth_stencil_state && (*depth_stencil_state = context->state.depth_stencil_state))
         ID3D11DepthStencilState_AddRef(*depth_stencil_state);
-    *stencil_ref = device->stencil_ref;
+    if (stencil_ref)
+        *stencil_ref = context->state.stencil_ref;
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_SOGetTargets(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_SOGetTargets(ID3D11DeviceContext *iface,
         UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
     unsigned int i;
 
     TRACE("iface %p, buffer_count %u, buffers %p.\n", iface, buffer_count, buffers);
 
-    wined3d_mutex_lock();
     for (i = 0; i < buffer_count; ++i)
     {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
-
-        if (!(wined3d_buffer = wined3d_device_get_stream_output(device->wined3d_device, i, NULL)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
-
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        buffers[i] = &buffer_impl->ID3D11Buffer_iface;
-        ID3D11Buffer_AddRef(buffers[i]);
+        buffers[i] = i < ARRAY_SIZE(context->state.so_buffers) ? context->state.so_buffers[i] : NULL;
+        if (buffers[i])
+            ID3D11Buffer_AddRef(buffers[i]);
     }
-    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetState(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetState(ID3D11DeviceContext *iface,
         ID3D11RasterizerState **rasterizer_state)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d_rasterizer_state *rasterizer_state_impl;
-    struct wined3d_rasterizer_state *wined3d_state;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, rasterizer_state %p.\n", iface, rasterizer_state);
 
-    wined3d_mutex_lock();
-    if ((wined3d_state = wined3d_device_get_rasterizer_state(device->wined3d_device)))
-    {
-        rasterizer_state_impl = wined3d_rasterizer_state_get_parent(wined3d_state);
-        ID3D11RasterizerState_AddRef(*rasterizer_state = &rasterizer_state_impl->ID3D11RasterizerState_iface);
-    }
-    else
-    {
-        *rasterizer_state = NULL;
-    }
-    wined3d_mutex_unlock();
+    if ((*rasterizer_state = context->state.rasterizer_state))
+        ID3D11RasterizerState_AddRef(*rasterizer_state);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetViewports(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetViewports(ID3D11DeviceContext *iface,
         UINT *viewport_count, D3D11_VIEWPORT *viewports)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct wined3d_viewport wined3d_vp;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    unsigned int count;
 
     TRACE("iface %p, viewport_count %p, viewports %p.\n", iface, viewport_count, viewports);
 
     if (!viewports)
     {
-        *viewport_count = 1;
+        *viewport_count = context->state.viewport_count;
         return;
     }
 
-    if (!*viewport_count)
-        return;
-
-    wined3d_mutex_lock();
-    wined3d_device_get_viewport(device->wined3d_device, &wined3d_vp);
-    wined3d_mutex_unlock();
-
-    viewports[0].TopLeftX = wined3d_vp.x;
-    viewports[0].TopLeftY = wined3d_vp.y;
-    viewports[0].Width = wined3d_vp.width;
-    viewports[0].Height = wined3d_vp.height;
-    viewports[0].MinDepth = wined3d_vp.min_z;
-    viewports[0].MaxDepth = wined3d_vp.max_z;
-
-    if (*viewport_count > 1)
-        memset(&viewports[1], 0, (*viewport_count - 1) * sizeof(*viewports));
+    count = min(*viewport_count, context->state.viewport_count);
+    memcpy(viewports, context->state.viewports, count * sizeof(*viewports));
+    if (*viewport_count > count)
+        memset(&viewports[count], 0, (*viewport_count - count) * sizeof(*viewports));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_RSGetScissorRects(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_RSGetScissorRects(ID3D11DeviceContext *iface,
         UINT *rect_count, D3D11_RECT *rects)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    unsigned int count;
 
     TRACE("iface %p, rect_count %p, rects %p.\n", iface, rect_count, rects);
 
     if (!rects)
     {
-        *rect_count = 1;
-        return;
-    }
-
-    if (!*rect_count)
-        return;
-
-    wined3d_mutex_lock();
-    wined3d_device_get_scissor_rect(device->wined3d_device, rects);
-    wined3d_mutex_unlock();
-    if (*rect_count > 1)
-        memset(&rects[1], 0, (*rect_count - 1) * sizeof(*rects));
+        *rect_count = context->state.scissor_rect_count;
+        return;
+    }
+
+    count = min(*rect_count, context->state.scissor_rect_count);
+    memcpy(rects, context->state.scissor_rects, count * sizeof(*rects));
+    if (*rect_count > count)
+        memset(&rects[count], 0, (*rect_count - count) * sizeof(*rects));
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_hs_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_HS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown **)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetShader(ID3D11DeviceContext *iface,
         ID3D11HullShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_hull_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_hull_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    ID3D11HullShader_AddRef(*shader = &shader_impl->ID3D11HullShader_iface);
+    d3d11_deferred_context_get_shader(context, D3D11_STAGE_HS, (ID3D11DeviceChild **)shader,
+            class_instances, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_sampler = wined3d_device_get_hs_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_HS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown **)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_HSGetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_HSGetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        if (!(wined3d_buffer = wined3d_device_get_hs_cb(device->wined3d_device, start_slot + i)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
-
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_HS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown **)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n",
-            iface, start_slot, view_count, views);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_ds_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_DS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown **)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetShader(ID3D11DeviceContext *iface,
         ID3D11DomainShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_domain_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_domain_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    ID3D11DomainShader_AddRef(*shader = &shader_impl->ID3D11DomainShader_iface);
+    d3d11_deferred_context_get_shader(context, D3D11_STAGE_DS, (ID3D11DeviceChild **)shader,
+            class_instances, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
-
-        if (!(wined3d_sampler = wined3d_device_get_ds_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_DS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown **)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_DSGetConstantBuffers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_DSGetConstantBuffers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_buffer = wined3d_device_get_ds_cb(device->wined3d_device, start_slot + i)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_DS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown **)buffers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShaderResources(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShaderResources(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11ShaderResourceView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    wined3d_mutex_lock();
-    for (i = 0; i < view_count; ++i)
-    {
-        struct wined3d_shader_resource_view *wined3d_view;
-        struct d3d_shader_resource_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_cs_resource_view(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_shader_resource_view_get_parent(wined3d_view);
-        ID3D11ShaderResourceView_AddRef(views[i] = &view_impl->ID3D11ShaderResourceView_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_CS, D3D11_BINDING_SHADER_RESOURCE_VIEW,
+            start_slot, view_count, (IUnknown **)views);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetUnorderedAccessViews(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetUnorderedAccessViews(ID3D11DeviceContext *iface,
         UINT start_slot, UINT view_count, ID3D11UnorderedAccessView **views)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    unsigned int i, slot;
 
     TRACE("iface %p, start_slot %u, view_count %u, views %p.\n", iface, start_slot, view_count, views);
 
-    wined3d_mutex_lock();
     for (i = 0; i < view_count; ++i)
     {
-        struct wined3d_unordered_access_view *wined3d_view;
-        struct d3d11_unordered_access_view *view_impl;
-
-        if (!(wined3d_view = wined3d_device_get_cs_uav(device->wined3d_device, start_slot + i)))
-        {
-            views[i] = NULL;
-            continue;
-        }
-
-        view_impl = wined3d_unordered_access_view_get_parent(wined3d_view);
-        ID3D11UnorderedAccessView_AddRef(views[i] = &view_impl->ID3D11UnorderedAccessView_iface);
+        slot = start_slot + i;
+        views[i] = slot < ARRAY_SIZE(context->state.cs_uavs) ? context->state.cs_uavs[slot] : NULL;
+        if (views[i])
+            ID3D11UnorderedAccessView_AddRef(views[i]);
     }
-    wined3d_mutex_unlock();
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetShader(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetShader(ID3D11DeviceContext *iface,
         ID3D11ComputeShader **shader, ID3D11ClassInstance **class_instances, UINT *class_instance_count)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    struct d3d11_compute_shader *shader_impl;
-    struct wined3d_shader *wined3d_shader;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p, shader %p, class_instances %p, class_instance_count %p.\n",
             iface, shader, class_instances, class_instance_count);
 
-    if (class_instances || class_instance_count)
-        FIXME("Dynamic linking not implemented yet.\n");
-
-    wined3d_mutex_lock();
-    if (!(wined3d_shader = wined3d_device_get_compute_shader(device->wined3d_device)))
-    {
-        wined3d_mutex_unlock();
-        *shader = NULL;
-        return;
-    }
-
-    shader_impl = wined3d_shader_get_parent(wined3d_shader);
-    wined3d_mutex_unlock();
-    ID3D11ComputeShader_AddRef(*shader = &shader_impl->ID3D11ComputeShader_iface);
+    d3d11_deferred_context_get_shader(context, D3D11_STAGE_CS, (ID3D11DeviceChild **)shader,
+            class_instances, class_instance_count);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetSamplers(ID3D11DeviceContext *iface,
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetSamplers(ID3D11DeviceContext *iface,
         UINT start_slot, UINT sampler_count, ID3D11SamplerState **samplers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n",
-            iface, start_slot, sampler_count, samplers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < sampler_count; ++i)
-    {
-        struct wined3d_sampler *wined3d_sampler;
-        struct d3d_sampler_state *sampler_impl;
-
-        if (!(wined3d_sampler = wined3d_device_get_cs_sampler(device->wined3d_device, start_slot + i)))
-        {
-            samplers[i] = NULL;
-            continue;
-        }
-
-        sampler_impl = wined3d_sampler_get_parent(wined3d_sampler);
-        ID3D11SamplerState_AddRef(samplers[i] = &sampler_impl->ID3D11SamplerState_iface);
-    }
-    wined3d_mutex_unlock();
-}
-
-static void STDMETHODCALLTYPE d3d11_immediate_context_CSGetConstantBuffers(ID3D11DeviceContext *iface,
-        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
-{
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    unsigned int i;
-
-    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n",
-            iface, start_slot, buffer_count, buffers);
-
-    wined3d_mutex_lock();
-    for (i = 0; i < buffer_count; ++i)
-    {
-        struct wined3d_buffer *wined3d_buffer;
-        struct d3d_buffer *buffer_impl;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-        if (!(wined3d_buffer = wined3d_device_get_cs_cb(device->wined3d_device, start_slot + i)))
-        {
-            buffers[i] = NULL;
-            continue;
-        }
+    TRACE("iface %p, start_slot %u, sampler_count %u, samplers %p.\n", iface, start_slot, sampler_count, samplers);
 
-        buffer_impl = wined3d_buffer_get_parent(wined3d_buffer);
-        ID3D11Buffer_AddRef(buffers[i] = &buffer_impl->ID3D11Buffer_iface);
-    }
-    wined3d_mutex_unlock();
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_CS, D3D11_BINDING_SAMPLER,
+            start_slot, sampler_count, (IUnknown **)samplers);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_ClearState(ID3D11DeviceContext *iface)
+static void STDMETHODCALLTYPE d3d11_deferred_context_CSGetConstantBuffers(ID3D11DeviceContext *iface,
+        UINT start_slot, UINT buffer_count, ID3D11Buffer **buffers)
 {
-    struct d3d_device *device = device_from_immediate_ID3D11DeviceContext(iface);
-    static const float blend_factor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-    unsigned int i;
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+
+    TRACE("iface %p, start_slot %u, buffer_count %u, buffers %p.\n", iface, start_slot, buffer_count, buffers);
+
+    d3d11_deferred_context_get_bindings(context, D3D11_STAGE_CS, D3D11_BINDING_CONSTANT_BUFFER,
+            start_slot, buffer_count, (IUnknown **)buffers);
+}
+
+static void STDMETHODCALLTYPE d3d11_deferred_context_ClearState(ID3D11DeviceContext *iface)
+{
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
     TRACE("iface %p.\n", iface);
 
-    wined3d_mutex_lock();
-    wined3d_device_set_vertex_shader(device->wined3d_device, NULL);
-    wined3d_device_set_hull_shader(device->wined3d_device, NULL);
-    wined3d_device_set_domain_shader(device->wined3d_device, NULL);
-    wined3d_device_set_geometry_shader(device->wined3d_device, NULL);
-    wined3d_device_set_pixel_shader(device->wined3d_device, NULL);
-    wined3d_device_set_compute_shader(device->wined3d_device, NULL);
-    for (i = 0; i < D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_vs_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_hs_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_ds_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_gs_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_ps_sampler(device->wined3d_device, i, NULL);
-        wined3d_device_set_cs_sampler(device->wined3d_device, i, NULL);
-    }
-    for (i = 0; i < D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_vs_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_hs_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_ds_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_gs_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_ps_resource_view(device->wined3d_device, i, NULL);
-        wined3d_device_set_cs_resource_view(device->wined3d_device, i, NULL);
-    }
-    for (i = 0; i < D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_vs_cb(device->wined3d_device, i, NULL);
-        wined3d_device_set_hs_cb(device->wined3d_device, i, NULL);
-        wined3d_device_set_ds_cb(device->wined3d_device, i, NULL);
-        wined3d_device_set_gs_cb(device->wined3d_device, i, NULL);
-        wined3d_device_set_ps_cb(device->wined3d_device, i, NULL);
-        wined3d_device_set_cs_cb(device->wined3d_device, i, NULL);
-    }
-    for (i = 0; i < D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_stream_source(device->wined3d_device, i, NULL, 0, 0);
-    }
-    wined3d_device_set_index_buffer(device->wined3d_device, NULL, WINED3DFMT_UNKNOWN, 0);
-    wined3d_device_set_vertex_declaration(device->wined3d_device, NULL);
-    wined3d_device_set_primitive_type(device->wined3d_device, WINED3D_PT_UNDEFINED, 0);
-    for (i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
-    {
-        wined3d_device_set_rendertarget_view(device->wined3d_device, i, NULL, FALSE);
-    }
-    wined3d_device_set_depth_stencil_view(device->wined3d_device, NULL);
-    for (i = 0; i < D3D11_PS_CS_UAV_REGISTER_COUNT; ++i)
-    {
-        wined3d_device_set_unordered_access_view(device->wined3d_device, i, NULL, ~0u);
-        wined3d_device_set_cs_uav(device->wined3d_device, i, NULL, ~0u);
-    }
-    ID3D11DeviceContext_OMSetDepthStencilState(iface, NULL, 0);
-    ID3D11DeviceContext_OMSetBlendState(iface, NULL, blend_factor, D3D11_DEFAULT_SAMPLE_MASK);
-    ID3D11DeviceContext_RSSetViewports(iface, 0, NULL);
-    ID3D11DeviceContext_RSSetScissorRects(iface, 0, NULL);
-    ID3D11DeviceContext_RSSetState(iface, NULL);
-    for (i = 0; i < D3D11_SO_BUFFER_SLOT_COUNT; ++i)
-    {
-        wined3d_device_set_stream_output(device->wined3d_device, i, NULL, 0);
-    }
-    wined3d_device_set_predication(device->wined3d_device, NULL, FALSE);
-    wined3d_mutex_unlock();
+    if (!d3d11_command_list_require_space(context->command_list,
+            D3D11_COMMAND_CLEAR_STATE, sizeof(struct d3d11_command), 0))
+        return;
+
+    d3d11_context_state_cleanup(&context->state);
+    d3d11_context_state_init(&context->state);
 }
 
-static void STDMETHODCALLTYPE d3d11_immediate_context_Flush(ID3D11DeviceContext *iface)
+static void STDMETHODCALLTYPE d3d11_deferred_context_Flush(ID3D11DeviceContext *iface)
 {
-    FIXME("iface %p stub!\n", iface);
+    TRACE("iface %p.\n", iface);
 }
 
-static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_immediate_context_GetType(ID3D11DeviceContext *iface)
+static D3D11_DEVICE_CONTEXT_TYPE STDMETHODCALLTYPE d3d11_deferred_context_GetType(ID3D11DeviceContext *iface)
 {
     TRACE("iface %p.\n", iface);
 
-    return D3D11_DEVICE_CONTEXT_IMMEDIATE;
+    return D3D11_DEVICE_CONTEXT_DEFERRED;
 }
 
-static UINT STDMETHODCALLTYPE d3d11_immediate_context_GetContextFlags(ID3D11DeviceContext *iface)
+static UINT STDMETHODCALLTYPE d3d11_deferred_context_GetContextFlags(ID3D11DeviceContext *iface)
 {
-    FIXME("iface %p stub!\n", iface);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
 
-    return 0;
+    TRACE("iface %p.\n", iface);
+
+    return context->flags;
 }
 
-static HRESULT STDMETHODCALLTYPE d3d11_immediate_context_FinishCommandList(ID3D11DeviceContext *iface,
+static HRESULT STDMETHODCALLTYPE d3d11_deferred_context_FinishCommandList(ID3D11DeviceContext *iface,
         BOOL restore, ID3D11CommandList **command_list)
 {
-    FIXME("iface %p, restore %#x, command_list %p stub!\n", iface, restore, command_list);
+    struct d3d11_deferred_context *context = impl_from_deferred_ID3D11DeviceContext(iface);
+    struct d3d11_command_list *list;
+    HRESULT hr;
 
-    return E_NOTIMPL;
+    TRACE("iface %p, restore %#x, command_list %p.\n", iface, restore, command_list);
+
+    if (FAILED(hr = d3d11_command_list_create(context->device, context->flags, &list)))
+    {
+        WARN("Failed to create command list, hr %#x.\n", hr);
+        return hr;
+    }
+
+    if (restore)
+    {
+        if (!(list->initial_state = heap_alloc(sizeof(*list->initial_state))))
+        {
+            ID3D11CommandList_Release(&list->ID3D11CommandList_iface);
+            return E_OUTOFMEMORY;
+        }
+        d3d11_context_state_copy(list->initial_state, &context->state);
+    }
+    else
+    {
+        d3d11_context_state_cleanup(&context->state);
+        d3d11_context_state_init(&context->state);
+    }
+
+    d3d11_deferred_context_free_mappings(context);
+
+    if (command_list)
+        *command_list = &context->command_list->ID3D11CommandList_iface;
+    else
+        ID3D11CommandList_Release(&context->command_list->ID3D11CommandList_iface);
+    context->command_list = list;
+
+    return S_OK;
 }
 
-static const struct ID3D11DeviceContextVtbl d3d11_immediate_context_vtbl =
+static const struct ID3D11DeviceContextVtbl d3d11_deferred_context_vtbl =
 {
     /* IUnknown methods */
-    d3d11_immediate_context_QueryInterface,
-    d3d11_immediate_context_AddRef,
-    d3d11_immediate_context_Release,
+    d3d11_deferred_context_QueryInterface,
+    d3d11_deferred_context_AddRef,
+    d3d11_deferred_context_Release,
     /* ID3D11DeviceChild methods */
-    d3d11_immediate_context_GetDevice,
-    d3d11_immediate_context_GetPrivateData,
-    d3d11_immediate_context_SetPrivateData,
-    d3d11_immediate_context_SetPrivateDataInterface,
+    d3d11_deferred_context_GetDevice,
+    d3d11_deferred_context_GetPrivateData,
+    d3d11_deferred_context_SetPrivateData,
+    d3d11_deferred_context_SetPrivateDataInterface,
     /* ID3D11DeviceContext methods */
-    d3d11_immediate_context_VSSetConstantBuffers,
-    d3d11_immediate_context_PSSetShaderResources,
-    d3d11_immediate_context_PSSetShader,
-    d3d11_immediate_context_PSSetSamplers,
-    d3d11_immediate_context_VSSetShader,
-    d3d11_immediate_context_DrawIndexed,
-    d3d11_immediate_context_Draw,
-    d3d11_immediate_context_Map,
-    d3d11_immediate_context_Unmap,
-    d3d11_immediate_context_PSSetConstantBuffers,
-    d3d11_immediate_context_IASetInputLayout,
-    d3d11_immediate_context_IASetVertexBuffers,
-    d3d11_immediate_context_IASetIndexBuffer,
-    d3d11_immediate_context_DrawIndexedInstanced,
-    d3d11_immediate_context_DrawInstanced,
-    d3d11_immediate_context_GSSetConstantBuffers,
-    d3d11_immediate_context_GSSetShader,
-    d3d11_immediate_context_IASetPrimitiveTopology,
-    d3d11_immediate_context_VSSetShaderResources,
-    d3d11_immediate_context_VSSetSamplers,
-    d3d11_immediate_context_Begin,
-    d3d11_immediate_context_End,
-    d3d11_immediate_context_GetData,
-    d3d11_immediate_context_SetPredication,
-    d3d11_immediate_context_GSSetShaderResources,
-    d3d11_immediate_context_GSSetSamplers,
-    d3d11_immediate_context_OMSetRenderTargets,
-    d3d11_immediate_context_OMSetRenderTargetsAndUnorderedAccessViews,
-    d3d11_immediate_context_OMSetBlendState,
-    d3d11_immediate_context_OMSetDepthStencilState,
-    d3d11_immediate_context_SOSetTargets,
-    d3d11_immediate_context_DrawAuto,
-    d3d11_immediate_context_DrawIndexedInstancedIndirect,
-    d3d11_immediate_context_DrawInstancedIndirect,
-    d3d11_immediate_context_Dispatch,
-    d3d11_immediate_context_DispatchIndirect,
-    d3d11_immediate_context_RSSetState,
-    d3d11_immediate_context_RSSetViewports,
-    d3d11_immediate_context_RSSetScissorRects,
-    d3d11_immediate_context_CopySubresourceRegion,
-    d3d11_immediate_context_CopyResource,
-    d3d11_immediate_context_UpdateSubresource,
-    d3d11_immediate_context_CopyStructureCount,
-    d3d11_immediate_context_ClearRenderTargetView,
-    d3d11_immediate_context_ClearUnorderedAccessViewUint,
-    d3d11_immediate_context_ClearUnorderedAccessViewFloat,
-    d3d11_immediate_context_ClearDepthStencilView,
-    d3d11_immediate_context_GenerateMips,
-    d3d11_immediate_context_SetResourceMinLOD,
-    d3d11_immediate_context_GetResourceMinLOD,
-    d3d11_immediate_context_ResolveSubresource,
-    d3d11_immediate_context_ExecuteCommandList,
-    d3d11_immediate_context_HSSetShaderResources,
-    d3d11_immediate_context_HSSetShader,
-    d3d11_immediate_context_HSSetSamplers,
-    d3d11_immediate_context_HSSetConstantBuffers,
-    d3d11_immediate_context_DSSetShaderResources,
-    d3d11_immediate_context_DSSetShader,
-    d3d11_immediate_context_DSSetSamplers,
-    d3d11_immediate_context_DSSetConstantBuffers,
-    d3d11_immediate_context_CSSetShaderResources,
-    d3d11_immediate_context_CSSetUnorderedAccessViews,
-    d3d11_immediate_context_CSSetShader,
-    d3d11_immediate_context_CSSetSamplers,
-    d3d11_immediate_context_CSSetConstantBuffers,
-    d3d11_immediate_context_VSGetConstantBuffers,
-    d3d11_immediate_context_PSGetShaderResources,
-    d3d11_immediate_context_PSGetShader,
-    d3d11_immediate_context_PSGetSamplers,
-    d3d11_immediate_context_VSGetShader,
-    d3d11_immediate_context_PSGetConstantBuffers,
-    d3d11_immediate_context_IAGetInputLayout,
-    d3d11_immediate_context_IAGetVertexBuffers,
-    d3d11_immediate_context_IAGetIndexBuffer,
-    d3d11_immediate_context_GSGetConstantBuffers,
-    d3d11_immediate_context_GSGetShader,
-    d3d11_immediate_context_IAGetPrimitiveTopology,
-    d3d11_immediate_context_VSGetShaderResources,
-    d3d11_immediate_context_VSGetSamplers,
-    d3d11_immediate_context_GetPredication,
-    d3d11_immediate_context_GSGetShaderResources,
-    d3d11_immediate_context_GSGetSamplers,
-    d3d11_immediate_context_OMGetRenderTargets,
-    d3d11_immediate_context_OMGetRenderTargetsAndUnorderedAccessViews,
-    d3d11_immediate_context_OMGetBlendState,
-    d3d11_immediate_context_OMGetDepthStencilState,
-    d3d11_immediate_context_SOGetTargets,
-    d3d11_immediate_context_RSGetState,
-    d3d11_immediate_context_RSGetViewports,
-    d3d11_immediate_context_RSGetScissorRects,
-    d3d11_immediate_context_HSGetShaderResources,
-    d3d11_immediate_context_HSGetShader,
-    d3d11_immediate_context_HSGetSamplers,
-    d3d11_immediate_context_HSGetConstantBuffers,
-    d3d11_immediate_context_DSGetShaderResources,
-    d3d11_immediate_context_DSGetShader,
-    d3d11_immediate_context_DSGetSamplers,
-    d3d11_immediate_context_DSGetConstantBuffers,
-    d3d11_immediate_context_CSGetShaderResources,
-    d3d11_immediate_context_CSGetUnorderedAccessViews,
-    d3d11_immediate_context_CSGetShader,
-    d3d11_immediate_context_CSGetSamplers,
-    d3d11_immediate_context_CSGetConstantBuffers,
-    d3d11_immediate_context_ClearState,
-    d3d11_immediate_context_Flush,
-    d3d11_immediate_context_GetType,
-    d3d11_immediate_context_GetContextFlags,
-    d3d11_immediate_context_FinishCommandList,
+    d3d11_deferred_context_VSSetConstantBuffers,
+    d3d11_deferred_context_PSSetShaderResources,
+    d3d11_deferred_context_PSSetShader,
+    d3d11_deferred_context_PSSetSamplers,
+    d3d11_deferred_context_VSSetShader,
+    d3d11_deferred_context_DrawIndexed,
+    d3d11_deferred_context_Draw,
+    d3d11_deferred_context_Map,
+    d3d11_deferred_context_Unmap,
+    d3d11_deferred_context_PSSetConstantBuffers,
+    d3d11_deferred_context_IASetInputLayout,
+    d3d11_deferred_context_IASetVertexBuffers,
+    d3d11_deferred_context_IASetIndexBuffer,
+    d3d11_deferred_context_DrawIndexedInstanced,
+    d3d11_deferred_context_DrawInstanced,
+    d3d11_deferred_context_GSSetConstantBuffers,
+    d3d11_deferred_context_GSSetShader,
+    d3d11_deferred_context_IASetPrimitiveTopology,
+    d3d11_deferred_context_VSSetShaderResources,
+    d3d11_deferred_context_VSSetSamplers,
+    d3d11_deferred_context_Begin,
+    d3d11_deferred_context_End,
+    d3d11_deferred_context_GetData,
+    d3d11_deferred_context_SetPredication,
+    d3d11_deferred_context_GSSetShaderResources,
+    d3d11_deferred_context_GSSetSamplers,
+    d3d11_deferred_context_OMSetRenderTargets,
+    d3d11_deferred_context_OMSetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMSetBlendState,
+    d3d11_deferred_context_OMSetDepthStencilState,
+    d3d11_deferred_context_SOSetTargets,
+    d3d11_deferred_context_DrawAuto,
+    d3d11_deferred_context_DrawIndexedInstancedIndirect,
+    d3d11_deferred_context_DrawInstancedIndirect,
+    d3d11_deferred_context_Dispatch,
+    d3d11_deferred_context_DispatchIndirect,
+    d3d11_deferred_context_RSSetState,
+    d3d11_deferred_context_RSSetViewports,
+    d3d11_deferred_context_RSSetScissorRects,
+    d3d11_deferred_context_CopySubresourceRegion,
+    d3d11_deferred_context_CopyResource,
+    d3d11_deferred_context_UpdateSubresource,
+    d3d11_deferred_context_CopyStructureCount,
+    d3d11_deferred_context_ClearRenderTargetView,
+    d3d11_deferred_context_ClearUnorderedAccessViewUint,
+    d3d11_deferred_context_ClearUnorderedAccessViewFloat,
+    d3d11_deferred_context_ClearDepthStencilView,
+    d3d11_deferred_context_GenerateMips,
+    d3d11_deferred_context_SetResourceMinLOD,
+    d3d11_deferred_context_GetResourceMinLOD,
+    d3d11_deferred_context_ResolveSubresource,
+    d3d11_deferred_context_ExecuteCommandList,
+    d3d11_deferred_context_HSSetShaderResources,
+    d3d11_deferred_context_HSSetShader,
+    d3d11_deferred_context_HSSetSamplers,
+    d3d11_deferred_context_HSSetConstantBuffers,
+    d3d11_deferred_context_DSSetShaderResources,
+    d3d11_deferred_context_DSSetShader,
+    d3d11_deferred_context_DSSetSamplers,
+    d3d11_deferred_context_DSSetConstantBuffers,
+    d3d11_deferred_context_CSSetShaderResources,
+    d3d11_deferred_context_CSSetUnorderedAccessViews,
+    d3d11_deferred_context_CSSetShader,
+    d3d11_deferred_context_CSSetSamplers,
+    d3d11_deferred_context_CSSetConstantBuffers,
+    d3d11_deferred_context_VSGetConstantBuffers,
+    d3d11_deferred_context_PSGetShaderResources,
+    d3d11_deferred_context_PSGetShader,
+    d3d11_deferred_context_PSGetSamplers,
+    d3d11_deferred_context_VSGetShader,
+    d3d11_deferred_context_PSGetConstantBuffers,
+    d3d11_deferred_context_IAGetInputLayout,
+    d3d11_deferred_context_IAGetVertexBuffers,
+    d3d11_deferred_context_IAGetIndexBuffer,
+    d3d11_deferred_context_GSGetConstantBuffers,
+    d3d11_deferred_context_GSGetShader,
+    d3d11_deferred_context_IAGetPrimitiveTopology,
+    d3d11_deferred_context_VSGetShaderResources,
+    d3d11_deferred_context_VSGetSamplers,
+    d3d11_deferred_context_GetPredication,
+    d3d11_deferred_context_GSGetShaderResources,
+    d3d11_deferred_context_GSGetSamplers,
+    d3d11_deferred_context_OMGetRenderTargets,
+    d3d11_deferred_context_OMGetRenderTargetsAndUnorderedAccessViews,
+    d3d11_deferred_context_OMGetBlendState,
+    d3d11_deferred_context_OMGetDepthStencilState,
+    d3d11_deferred_context_SOGetTargets,
+    d3d11_deferred_context_RSGetState,
+    d3d11_deferred_context_RSGetViewports,
+    d3d11_deferred_context_RSGetScissorRects,
+    d3d11_deferred_context_HSGetShaderResources,
+    d3d11_deferred_context_HSGetShader,
+    d3d11_deferred_context_HSGetSamplers,
+    d3d11_deferred_context_HSGetConstantBuffers,
+    d3d11_deferred_context_DSGetShaderResources,
+    d3d11_deferred_context_DSGetShader,
+    d3d11_deferred_context_DSGetSamplers,
+    d3d11_deferred_context_DSGetConstantBuffers,
+    d3d11_deferred_context_CSGetShaderResources,
+    d3d11_deferred_context_CSGetUnorderedAccessViews,
+    d3d11_deferred_context_CSGetShader,
+    d3d11_deferred_context_CSGetSamplers,
+    d3d11_deferred_context_CSGetConstantBuffers,
+    d3d11_deferred_context_ClearState,
+    d3d11_deferred_context_Flush,
+    d3d11_deferred_context_GetType,
+    d3d11_deferred_context_GetContextFlags,
+    d3d11_deferred_context_FinishCommandList,
 };
 
-static void d3d11_immediate_context_init(struct d3d11_immediate_context *context, struct d3d_device *device)
+static HRESULT d3d11_deferred_context_create(struct d3d_device *device, UINT flags,
+        struct d3d11_deferred_context **context)
 {
-    context->ID3D11DeviceContext_iface.lpVtbl = &d3d11_immediate_context_vtbl;
-    context->refcount = 1;
+    struct d3d11_deferred_context *object;
+    HRESULT hr;
 
-    ID3D11Device_AddRef(&device->ID3D11Device_iface);
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
 
-    wined3d_private_store_init(&context->private_store);
-}
+    object->ID3D11DeviceContext_iface.lpVtbl = &d3d11_deferred_context_vtbl;
+    object->refcount = 1;
+    wined3d_private_store_init(&object->private_store);
+    object->device = &device->ID3D11Device_iface;
+    object->flags = flags;
+    d3d11_context_state_init(&object->state);
+    list_init(&object->mapped_resources);
 
-static void d3d11_immediate_context_destroy(struct d3d11_immediate_context *context)
-{
-    wined3d_private_store_cleanup(&context->private_store);
+    if (FAILED(hr = d3d11_command_list_create(object->device, flags, &object->command_list)))
+    {
+        wined3d_private_store_cleanup(&object->private_store);
+        heap_free(object);
+        return hr;
+    }
+    ID3D11Device_AddRef(object->device);
+
+    TRACE("Created deferred context %p.\n", object);
+    *context = object;
+
+    return S_OK;
 }
 
 /* ID3D11Device methods */
@@ -3194,9 +6656,21 @@ static HRESULT STDMETHODCALLTYPE d3d11_device_CreateCounter(ID3D11Device *iface,
 static HRESULT STDMETHODCALLTYPE d3d11_device_CreateDeferredContext(ID3D11Device *iface, UINT flags,
         ID3D11DeviceContext **context)
 {
-    FIXME("iface %p, flags %#x, context %p stub!\n", iface, flags, context);
+    struct d3d_device *device = impl_from_ID3D11Device(iface);
+    struct d3d11_deferred_context *object;
+    HRESULT hr;
 
-    return E_NOTIMPL;
+    TRACE("iface %p, flags %#x, context %p.\n", iface, flags, context);
+
+    if (flags)
+        FIXME("Ignoring flags %#x.\n", flags);
+
+    if (FAILED(hr = d3d11_deferred_context_create(device, flags, &object)))
+        return hr;
+
+    *context = &object->ID3D11DeviceContext_iface;
+
+    return S_OK;
 }
 
 static HRESULT STDMETHODCALLTYPE d3d11_device_OpenSharedResource(ID3D11Device *iface, HANDLE resource, REFIID riid,
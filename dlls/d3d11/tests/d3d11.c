@@ -5729,6 +5729,61 @@ static void test_device_context_state(void)
     ok(!refcount, "Device has %u references left.\n", refcount);
 }
 
+static void test_deferred_context(void)
+{
+    static const float green[] = {0.0f, 1.0f, 0.0f, 1.0f};
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    struct d3d11_test_context test_context;
+    ID3D11DeviceContext *deferred_context;
+    ID3D11DeviceContext *immediate_context;
+    ID3D11CommandList *command_list;
+    ID3D11RenderTargetView *rtv;
+    D3D11_DEVICE_CONTEXT_TYPE type;
+    ID3D11Device *device;
+    ULONG refcount;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    device = test_context.device;
+    immediate_context = test_context.immediate_context;
+
+    hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred_context);
+    ok(SUCCEEDED(hr), "Failed to create deferred context, hr %#x.\n", hr);
+    type = ID3D11DeviceContext_GetType(deferred_context);
+    ok(type == D3D11_DEVICE_CONTEXT_DEFERRED, "Got unexpected context type %#x.\n", type);
+
+    ID3D11DeviceContext_ClearRenderTargetView(immediate_context, test_context.backbuffer_rtv, green);
+    ID3D11DeviceContext_ClearRenderTargetView(deferred_context, test_context.backbuffer_rtv, red);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+
+    ID3D11DeviceContext_OMSetRenderTargets(deferred_context, 1, &test_context.backbuffer_rtv, NULL);
+    hr = ID3D11DeviceContext_FinishCommandList(deferred_context, TRUE, &command_list);
+    ok(hr == S_OK, "Failed to finish command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_OMGetRenderTargets(deferred_context, 1, &rtv, NULL);
+    ok(rtv == test_context.backbuffer_rtv, "Got unexpected render target view %p.\n", rtv);
+    ID3D11RenderTargetView_Release(rtv);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+
+    ID3D11DeviceContext_ExecuteCommandList(immediate_context, command_list, TRUE);
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 1);
+    ID3D11DeviceContext_OMGetRenderTargets(immediate_context, 1, &rtv, NULL);
+    ok(rtv == test_context.backbuffer_rtv, "Got unexpected render target view %p.\n", rtv);
+    ID3D11RenderTargetView_Release(rtv);
+
+    ID3D11DeviceContext_ClearRenderTargetView(immediate_context, test_context.backbuffer_rtv, green);
+    ID3D11DeviceContext_ExecuteCommandList(immediate_context, command_list, FALSE);
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 1);
+    ID3D11DeviceContext_OMGetRenderTargets(immediate_context, 1, &rtv, NULL);
+    ok(!rtv, "Got unexpected render target view %p.\n", rtv);
+
+    ID3D11CommandList_Release(command_list);
+    refcount = ID3D11DeviceContext_Release(deferred_context);
+    ok(!refcount, "Got unexpected refcount %u.\n", refcount);
+    release_test_context(&test_context);
+}
+
 static void test_blend(void)
 {
     ID3D11BlendState *src_blend, *dst_blend;
@@ -25136,6 +25191,7 @@ START_TEST(d3d11)
     test_private_data();
     run_for_each_feature_level(test_state_refcounting);
     test_device_context_state();
+    test_deferred_context();
     test_blend();
     test_texture();
     test_cube_maps();
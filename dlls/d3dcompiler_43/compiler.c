@@ -24,6 +24,7 @@
 #include "wine/unicode.h"
 
 #include "d3dcompiler_private.h"
+#include "winreg.h"
 #include "wine/wpp.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3dcompiler);
@@ -589,8 +590,185 @@ static const struct target_info * get_target_info(const char *target)
     return NULL;
 }
 
+/* Optional on-disk cache of compiled shaders, shared by all the d3dcompiler
+ * versions. Entries are keyed by a hash of the preprocessed source, so
+ * defines and included files are accounted for, together with the entry
+ * point, target and flags. Only compilations without compiler messages are
+ * cached. The cache is only accessed with wpp_mutex held. */
+#define SHADER_CACHE_MAGIC   0x43584433 /* "3DXC" */
+#define SHADER_CACHE_VERSION 1
+
+struct shader_cache_key
+{
+    UINT64 hash[2];
+};
+
+struct shader_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    struct shader_cache_key key;
+    DWORD size;
+};
+
+static BOOL shader_cache_initialized;
+static char shader_cache_path[MAX_PATH];
+
+static void shader_cache_init(void)
+{
+    char buffer[MAX_PATH];
+    DWORD size, len = 0;
+    HKEY hkey;
+
+    shader_cache_initialized = TRUE;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Direct3D */
+    if (RegOpenKeyA(HKEY_CURRENT_USER, "Software\\Wine\\Direct3D", &hkey))
+        return;
+    size = sizeof(buffer);
+    if (!RegQueryValueExA(hkey, "ShaderCompilerCache", NULL, NULL, (BYTE *)buffer, &size)
+            && !strcmp(buffer, "enabled"))
+    {
+        size = sizeof(buffer);
+        if (RegQueryValueExA(hkey, "ShaderCompilerCachePath", NULL, NULL, (BYTE *)buffer, &size))
+            strcpy(buffer, "%LOCALAPPDATA%\\d3dcompiler_cache");
+        len = ExpandEnvironmentStringsA(buffer, shader_cache_path, sizeof(shader_cache_path));
+    }
+    RegCloseKey(hkey);
+
+    if (!len || len > sizeof(shader_cache_path) || strchr(shader_cache_path, '%'))
+    {
+        if (len) WARN("Failed to get the shader cache path.\n");
+        shader_cache_path[0] = 0;
+        return;
+    }
+    if (!CreateDirectoryA(shader_cache_path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        WARN("Failed to create shader cache directory %s, error %u.\n",
+                debugstr_a(shader_cache_path), GetLastError());
+        shader_cache_path[0] = 0;
+        return;
+    }
+    TRACE("Using shader cache %s.\n", debugstr_a(shader_cache_path));
+}
+
+static void shader_cache_hash(struct shader_cache_key *key, const void *data, SIZE_T size)
+{
+    const BYTE *ptr = data;
+
+    while (size--)
+    {
+        key->hash[0] = (key->hash[0] ^ *ptr) * 0x100000001b3;
+        key->hash[1] = (key->hash[1] * 0x100000001b3) ^ *ptr++;
+    }
+}
+
+static void shader_cache_hash_string(struct shader_cache_key *key, const char *str)
+{
+    if (!str) str = "";
+    shader_cache_hash(key, str, strlen(str) + 1);
+}
+
+static BOOL shader_cache_get_key(struct shader_cache_key *key, const char *entrypoint,
+        const char *target, UINT sflags, UINT eflags)
+{
+    if (!shader_cache_initialized)
+        shader_cache_init();
+    if (!shader_cache_path[0])
+        return FALSE;
+
+    key->hash[0] = 0xcbf29ce484222325;
+    key->hash[1] = 0x84222325cbf29ce4;
+    shader_cache_hash(key, wpp_output, wpp_output_size);
+    shader_cache_hash_string(key, entrypoint);
+    shader_cache_hash_string(key, target);
+    shader_cache_hash(key, &sflags, sizeof(sflags));
+    shader_cache_hash(key, &eflags, sizeof(eflags));
+    return TRUE;
+}
+
+static void shader_cache_get_name(const struct shader_cache_key *key, char *name, SIZE_T size)
+{
+    snprintf(name, size, "%s\\%08x%08x%08x%08x.bin", shader_cache_path,
+            (unsigned int)(key->hash[0] >> 32), (unsigned int)key->hash[0],
+            (unsigned int)(key->hash[1] >> 32), (unsigned int)key->hash[1]);
+}
+
+static BOOL shader_cache_load(const struct shader_cache_key *key, ID3DBlob **shader_blob)
+{
+    struct shader_cache_header header;
+    char name[MAX_PATH + 40];
+    ID3DBlob *buffer;
+    HANDLE file;
+    DWORD read;
+
+    shader_cache_get_name(key, name, sizeof(name));
+    if ((file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+            OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    if (!ReadFile(file, &header, sizeof(header), &read, NULL) || read != sizeof(header)
+            || header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION
+            || memcmp(&header.key, key, sizeof(*key)) || !header.size)
+    {
+        CloseHandle(file);
+        WARN("Ignoring invalid shader cache entry %s.\n", debugstr_a(name));
+        return FALSE;
+    }
+
+    if (FAILED(D3DCreateBlob(header.size, &buffer)))
+    {
+        CloseHandle(file);
+        return FALSE;
+    }
+    if (!ReadFile(file, ID3D10Blob_GetBufferPointer(buffer), header.size, &read, NULL)
+            || read != header.size)
+    {
+        CloseHandle(file);
+        ID3D10Blob_Release(buffer);
+        WARN("Failed to read shader cache entry %s.\n", debugstr_a(name));
+        return FALSE;
+    }
+    CloseHandle(file);
+
+    TRACE("Loaded shader from cache entry %s.\n", debugstr_a(name));
+    *shader_blob = buffer;
+    return TRUE;
+}
+
+static void shader_cache_store(const struct shader_cache_key *key, ID3DBlob *shader_blob)
+{
+    char name[MAX_PATH + 40], tmp_name[MAX_PATH + 60];
+    struct shader_cache_header header;
+    DWORD written;
+    HANDLE file;
+    BOOL ret;
+
+    header.magic = SHADER_CACHE_MAGIC;
+    header.version = SHADER_CACHE_VERSION;
+    header.key = *key;
+    header.size = ID3D10Blob_GetBufferSize(shader_blob);
+
+    /* Write to a temporary file first, so that other processes never see
+     * partially written entries. */
+    shader_cache_get_name(key, name, sizeof(name));
+    snprintf(tmp_name, sizeof(tmp_name), "%s.%04x.tmp", name, GetCurrentProcessId());
+    if ((file = CreateFileA(tmp_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return;
+    ret = WriteFile(file, &header, sizeof(header), &written, NULL) && written == sizeof(header)
+            && WriteFile(file, ID3D10Blob_GetBufferPointer(shader_blob), header.size, &written, NULL)
+            && written == header.size;
+    CloseHandle(file);
+
+    if (!ret || !MoveFileExA(tmp_name, name, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write shader cache entry %s.\n", debugstr_a(name));
+        DeleteFileA(tmp_name);
+    }
+}
+
 static HRESULT compile_shader(const char *preproc_shader, const char *target, const char *entrypoint,
-        ID3DBlob **shader_blob, ID3DBlob **error_messages)
+        ID3DBlob **shader_blob, ID3DBlob **error_messages, BOOL *has_messages)
 {
     struct bwriter_shader *shader;
     char *messages = NULL;
@@ -627,6 +805,7 @@ static HRESULT compile_shader(const char *preproc_shader, const char *target, co
 
     shader = parse_hlsl_shader(preproc_shader, shader_type, major, minor, entrypoint, &messages);
 
+    *has_messages = !!messages;
     if (messages)
     {
         TRACE("Compiler messages:\n");
@@ -698,6 +877,8 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
         const void *secondary_data, SIZE_T secondary_data_size, ID3DBlob **shader,
         ID3DBlob **error_messages)
 {
+    struct shader_cache_key key;
+    BOOL use_cache = FALSE, has_messages = TRUE;
     HRESULT hr;
 
     TRACE("data %p, data_size %lu, filename %s, defines %p, include %p, entrypoint %s, "
@@ -717,7 +898,19 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
 
     hr = preprocess_shader(data, data_size, filename, defines, include, error_messages);
     if (SUCCEEDED(hr))
-        hr = compile_shader(wpp_output, target, entrypoint, shader, error_messages);
+    {
+        if (shader && !secondary_data)
+            use_cache = shader_cache_get_key(&key, entrypoint, target, sflags, eflags);
+
+        if (use_cache && shader_cache_load(&key, shader))
+            hr = S_OK;
+        else
+        {
+            hr = compile_shader(wpp_output, target, entrypoint, shader, error_messages, &has_messages);
+            if (SUCCEEDED(hr) && use_cache && !has_messages)
+                shader_cache_store(&key, *shader);
+        }
+    }
 
     HeapFree(GetProcessHeap(), 0, wpp_output);
     LeaveCriticalSection(&wpp_mutex);
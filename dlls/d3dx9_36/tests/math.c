@@ -2474,6 +2474,21 @@ static void test_D3DXVec_Array(void)
     D3DXVec4TransformArray(&out_vec[1], sizeof(*out_vec), inp_vec, sizeof(*inp_vec), &mat, ARRAY_SIZE(inp_vec));
     expect_vec4_array(ARRAY_SIZE(exp_vec), exp_vec, out_vec, 0);
 
+    /* D3DXVec3TransformCoordArray and D3DXVec3TransformNormalArray match the single vector functions exactly */
+    memset(exp_vec, 0, sizeof(exp_vec));
+    memset(out_vec, 0, sizeof(out_vec));
+    for (i = 0; i < ARRAY_SIZE(inp_vec); ++i)
+        D3DXVec3TransformCoord((D3DXVECTOR3 *)&exp_vec[i + 1], (D3DXVECTOR3 *)&inp_vec[i], &mat);
+    D3DXVec3TransformCoordArray((D3DXVECTOR3 *)&out_vec[1], sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), &mat, ARRAY_SIZE(inp_vec));
+    expect_vec4_array(ARRAY_SIZE(exp_vec), exp_vec, out_vec, 0);
+
+    for (i = 0; i < ARRAY_SIZE(inp_vec); ++i)
+        D3DXVec3TransformNormal((D3DXVECTOR3 *)&exp_vec[i + 1], (D3DXVECTOR3 *)&inp_vec[i], &mat);
+    D3DXVec3TransformNormalArray((D3DXVECTOR3 *)&out_vec[1], sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec,
+            sizeof(*inp_vec), &mat, ARRAY_SIZE(inp_vec));
+    expect_vec4_array(ARRAY_SIZE(exp_vec), exp_vec, out_vec, 0);
+
     /* D3DXPlaneTransformArray */
     exp_plane[1].a = 90.0f; exp_plane[1].b = 100.0f; exp_plane[1].c = 110.0f; exp_plane[1].d = 120.0f;
     exp_plane[2].a = 82.0f; exp_plane[2].b = 92.0f;  exp_plane[2].c = 102.0f; exp_plane[2].d = 112.0f;
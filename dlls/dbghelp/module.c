@@ -213,6 +213,7 @@ struct module* module_new(struct process* pcs, const WCHAR* name,
     module->sortlist_valid    = FALSE;
     module->sorttab_size      = 0;
     module->addr_sorttab      = NULL;
+    module->sorttab_addr      = NULL;
     module->num_sorttab       = 0;
     module->num_symbols       = 0;
 
@@ -683,6 +684,7 @@ BOOL module_remove(struct process* pcs, struct module* module)
     hash_table_destroy(&module->ht_types);
     HeapFree(GetProcessHeap(), 0, module->sources);
     HeapFree(GetProcessHeap(), 0, module->addr_sorttab);
+    HeapFree(GetProcessHeap(), 0, module->sorttab_addr);
     pool_destroy(&module->pool);
     /* native dbghelp doesn't invoke registered callback(,CBA_SYMBOLS_UNLOADED,) here
      * so do we
@@ -1106,6 +1108,7 @@ void module_reset_debug_info(struct module* module)
     module->sortlist_valid = TRUE;
     module->sorttab_size = 0;
     module->addr_sorttab = NULL;
+    module->sorttab_addr = NULL;
     module->num_sorttab = module->num_symbols = 0;
     hash_table_destroy(&module->ht_symbols);
     module->ht_symbols.num_buckets = 0;
@@ -48,9 +48,7 @@ static inline int cmp_addr(ULONG64 a1, ULONG64 a2)
 
 static inline int cmp_sorttab_addr(struct module* module, int idx, ULONG64 addr)
 {
-    ULONG64     ref;
-    symt_get_address(&module->addr_sorttab[idx]->symt, &ref);
-    return cmp_addr(ref, addr);
+    return cmp_addr(module->sorttab_addr[idx], addr);
 }
 
 int symt_cmp_addr(const void* p1, const void* p2)
@@ -98,23 +96,26 @@ struct symt*      symt_index2ptr(struct module* module, DWORD id)
 static BOOL symt_grow_sorttab(struct module* module, unsigned sz)
 {
     struct symt_ht**    new;
+    ULONG64*            new_addr;
     unsigned int size;
 
     if (sz <= module->sorttab_size) return TRUE;
+    size = module->addr_sorttab ? module->sorttab_size * 2 : 64;
     if (module->addr_sorttab)
-    {
-        size = module->sorttab_size * 2;
         new = HeapReAlloc(GetProcessHeap(), 0, module->addr_sorttab,
                           size * sizeof(struct symt_ht*));
-    }
     else
-    {
-        size = 64;
         new = HeapAlloc(GetProcessHeap(), 0, size * sizeof(struct symt_ht*));
-    }
     if (!new) return FALSE;
-    module->sorttab_size = size;
     module->addr_sorttab = new;
+    if (module->sorttab_addr)
+        new_addr = HeapReAlloc(GetProcessHeap(), 0, module->sorttab_addr,
+                               size * sizeof(ULONG64));
+    else
+        new_addr = HeapAlloc(GetProcessHeap(), 0, size * sizeof(ULONG64));
+    if (!new_addr) return FALSE;
+    module->sorttab_addr = new_addr;
+    module->sorttab_size = size;
     return TRUE;
 }
 
@@ -755,13 +756,11 @@ static BOOL symt_enum_module(struct module_pair* pair, const WCHAR* match,
     return FALSE;
 }
 
-static inline unsigned where_to_insert(struct module* module, unsigned high, const struct symt_ht* elt)
+static inline unsigned where_to_insert(struct module* module, unsigned high, ULONG64 addr)
 {
     unsigned    low = 0, mid = high / 2;
-    ULONG64     addr;
 
     if (!high) return 0;
-    symt_get_address(&elt->symt, &addr);
     do
     {
         switch (cmp_sorttab_addr(module, mid, addr))
@@ -779,6 +778,8 @@ static inline unsigned where_to_insert(struct module* module, unsigned high, con
  *              resort_symbols
  *
  * Rebuild sorted list of symbols for a module.
+ * The addresses of the sorted symbols are kept in a separate array, so that
+ * lookups don't have to go through each symbol.
  */
 static BOOL resort_symbols(struct module* module)
 {
@@ -792,9 +793,17 @@ static BOOL resort_symbols(struct module* module)
      * (unless the first set is empty)
      */
     delta = module->num_symbols - module->num_sorttab;
-    qsort(&module->addr_sorttab[module->num_sorttab], delta, sizeof(struct symt_ht*), symt_cmp_addr);
-    if (module->num_sorttab)
+    if (!module->num_sorttab)
+    {
+        int i;
+
+        qsort(module->addr_sorttab, delta, sizeof(struct symt_ht*), symt_cmp_addr);
+        for (i = 0; i < delta; i++)
+            symt_get_address(&module->addr_sorttab[i]->symt, &module->sorttab_addr[i]);
+    }
+    else
     {
+        ULONG64 addr;
         int     i, ins_idx = module->num_sorttab, prev_ins_idx;
         static struct symt_ht** tmp;
         static unsigned num_tmp;
@@ -819,12 +828,17 @@ static BOOL resort_symbols(struct module* module)
 
         for (i = delta - 1; i >= 0; i--)
         {
+            symt_get_address(&tmp[i]->symt, &addr);
             prev_ins_idx = ins_idx;
-            ins_idx = where_to_insert(module, ins_idx, tmp[i]);
+            ins_idx = where_to_insert(module, ins_idx, addr);
             memmove(&module->addr_sorttab[ins_idx + i + 1],
                     &module->addr_sorttab[ins_idx],
                     (prev_ins_idx - ins_idx) * sizeof(struct symt_ht*));
+            memmove(&module->sorttab_addr[ins_idx + i + 1],
+                    &module->sorttab_addr[ins_idx],
+                    (prev_ins_idx - ins_idx) * sizeof(ULONG64));
             module->addr_sorttab[ins_idx + i] = tmp[i];
+            module->sorttab_addr[ins_idx + i] = addr;
         }
     }
     module->num_sorttab = module->num_symbols;
@@ -860,11 +874,10 @@ struct symt_ht* symt_find_nearest(struct module* module, DWORD_PTR addr)
     low = 0;
     high = module->num_sorttab;
 
-    symt_get_address(&module->addr_sorttab[0]->symt, &ref_addr);
-    if (addr < ref_addr) return NULL;
+    if (addr < module->sorttab_addr[0]) return NULL;
     if (high)
     {
-        symt_get_address(&module->addr_sorttab[high - 1]->symt, &ref_addr);
+        ref_addr = module->sorttab_addr[high - 1];
         symt_get_length(module, &module->addr_sorttab[high - 1]->symt, &ref_size);
         if (addr >= ref_addr + ref_size) return NULL;
     }
@@ -886,7 +899,7 @@ struct symt_ht* symt_find_nearest(struct module* module, DWORD_PTR addr)
      */
     if (module->addr_sorttab[low]->symt.tag == SymTagPublicSymbol)
     {
-        symt_get_address(&module->addr_sorttab[low]->symt, &ref_addr);
+        ref_addr = module->sorttab_addr[low];
         if (low > 0 &&
             module->addr_sorttab[low - 1]->symt.tag != SymTagPublicSymbol &&
             !cmp_sorttab_addr(module, low - 1, ref_addr))
@@ -897,7 +910,7 @@ struct symt_ht* symt_find_nearest(struct module* module, DWORD_PTR addr)
             low++;
     }
     /* finally check that we fit into the found symbol */
-    symt_get_address(&module->addr_sorttab[low]->symt, &ref_addr);
+    ref_addr = module->sorttab_addr[low];
     if (addr < ref_addr) return NULL;
     symt_get_length(module, &module->addr_sorttab[low]->symt, &ref_size);
     if (addr >= ref_addr + ref_size) return NULL;
@@ -748,8 +748,11 @@ HRESULT WINAPI JoystickWGenericImpl_GetDeviceState(LPDIRECTINPUTDEVICE8W iface,
     /* update joystick state */
     This->joy_polldev(IDirectInputDevice8A_from_impl(This));
 
-    /* convert and copy data to user supplied buffer */
+    /* convert and copy data to user supplied buffer, the state may be
+     * updated from another thread */
+    EnterCriticalSection(&This->base.crit);
     fill_DataFormat(ptr, len, &This->js, &This->base.data_format);
+    LeaveCriticalSection(&This->base.crit);
 
     return DI_OK;
 }
@@ -123,6 +123,10 @@ struct JoystickImpl
 	/* joystick private */
 	int				joyfd;
 
+	/* thread reading the events while the device is acquired */
+	HANDLE				reader_thread;
+	int				reader_pipe[2];
+
 	int                             dev_axes_to_di[ABS_MAX];
         POINTL                          povs[4];
 
@@ -155,6 +159,8 @@ static inline IDirectInputDevice8W *IDirectInputDevice8W_from_impl(JoystickImpl
 static void fake_current_js_state(JoystickImpl *ji);
 static void find_joydevs(void);
 static void joy_polldev(LPDIRECTINPUTDEVICE8A iface);
+static void start_reader_thread(JoystickImpl *This);
+static void stop_reader_thread(JoystickImpl *This);
 
 /* This GUID is slightly different from the linux joystick one. Take note. */
 static const GUID DInput_Wine_Joystick_Base_GUID = { /* 9e573eda-7734-11d2-8d4a-23903fb6bdf7 */
@@ -727,6 +733,8 @@ static HRESULT WINAPI JoystickWImpl_Acquire(LPDIRECTINPUTDEVICE8W iface)
         }
     }
 
+    start_reader_thread(This);
+
     return DI_OK;
 }
 
@@ -749,6 +757,8 @@ static HRESULT WINAPI JoystickWImpl_Unacquire(LPDIRECTINPUTDEVICE8W iface)
     if (res==DI_OK && This->joyfd!=-1) {
       struct input_event event;
 
+      stop_reader_thread(This);
+
       /* Stop and unload all effects */
       JoystickWImpl_SendForceFeedbackCommand(iface, DISFFC_RESET);
 
@@ -802,109 +812,191 @@ static void fake_current_js_state(JoystickImpl *ji)
 #undef CENTER_AXIS
 
 /* convert wine format offset to user format object index */
-static void joy_polldev(LPDIRECTINPUTDEVICE8A iface)
+static void joy_process_event(JoystickImpl *This, const struct input_event *ie, DWORD time)
 {
-    struct pollfd plfd;
-    struct input_event ie;
-    JoystickImpl *This = impl_from_IDirectInputDevice8A(iface);
-
-    if (This->joyfd==-1)
-	return;
+    LONG value = 0;
+    int inst_id = -1;
 
-    while (1)
+    TRACE("input_event: type %d, code %d, value %d\n",ie->type,ie->code,ie->value);
+    switch (ie->type) {
+    case EV_KEY:	/* button */
     {
-        LONG value = 0;
-        int inst_id = -1;
-
-	plfd.fd = This->joyfd;
-	plfd.events = POLLIN;
-
-	if (poll(&plfd,1,0) != 1)
-	    return;
+        int btn = This->buttons[ie->code];
 
-	/* we have one event, so we can read */
-	if (sizeof(ie)!=read(This->joyfd,&ie,sizeof(ie)))
-	    return;
-
-	TRACE("input_event: type %d, code %d, value %d\n",ie.type,ie.code,ie.value);
-	switch (ie.type) {
-	case EV_KEY:	/* button */
+        TRACE("(%p) %d -> %d\n", This, ie->code, btn);
+        if (btn & 0x80)
         {
-            int btn = This->buttons[ie.code];
+            btn &= 0x7F;
+            inst_id = DIDFT_MAKEINSTANCE(btn) | DIDFT_PSHBUTTON;
+            This->generic.js.rgbButtons[btn] = value = ie->value ? 0x80 : 0x00;
+        }
+        break;
+    }
+    case EV_ABS:
+    {
+        int axis = This->dev_axes_to_di[ie->code];
+
+        /* User axis remapping */
+        if (axis < 0) break;
+        axis = This->generic.axis_map[axis];
+        if (axis < 0) break;
+
+        inst_id = axis < 8 ?  DIDFT_MAKEINSTANCE(axis) | DIDFT_ABSAXIS :
+                              DIDFT_MAKEINSTANCE(axis - 8) | DIDFT_POV;
+        value = joystick_map_axis(&This->generic.props[id_to_object(This->generic.base.data_format.wine_df, inst_id)], ie->value);
+
+        switch (axis) {
+        case 0: This->generic.js.lX  = value; break;
+        case 1: This->generic.js.lY  = value; break;
+        case 2: This->generic.js.lZ  = value; break;
+        case 3: This->generic.js.lRx = value; break;
+        case 4: This->generic.js.lRy = value; break;
+        case 5: This->generic.js.lRz = value; break;
+        case 6: This->generic.js.rglSlider[0] = value; break;
+        case 7: This->generic.js.rglSlider[1] = value; break;
+        case 8: case 9: case 10: case 11:
+        {
+            int idx = axis - 8;
 
-            TRACE("(%p) %d -> %d\n", This, ie.code, btn);
-            if (btn & 0x80)
-            {
-                btn &= 0x7F;
-                inst_id = DIDFT_MAKEINSTANCE(btn) | DIDFT_PSHBUTTON;
-                This->generic.js.rgbButtons[btn] = value = ie.value ? 0x80 : 0x00;
-            }
+            if (ie->code % 2)
+                This->povs[idx].y = ie->value;
+            else
+                This->povs[idx].x = ie->value;
+
+            This->generic.js.rgdwPOV[idx] = value = joystick_map_pov(&This->povs[idx]);
             break;
         }
-	case EV_ABS:
-        {
-            int axis = This->dev_axes_to_di[ie.code];
-
-            /* User axis remapping */
-            if (axis < 0) break;
-            axis = This->generic.axis_map[axis];
-            if (axis < 0) break;
-
-            inst_id = axis < 8 ?  DIDFT_MAKEINSTANCE(axis) | DIDFT_ABSAXIS :
-                                  DIDFT_MAKEINSTANCE(axis - 8) | DIDFT_POV;
-            value = joystick_map_axis(&This->generic.props[id_to_object(This->generic.base.data_format.wine_df, inst_id)], ie.value);
-
-	    switch (axis) {
-            case 0: This->generic.js.lX  = value; break;
-            case 1: This->generic.js.lY  = value; break;
-            case 2: This->generic.js.lZ  = value; break;
-            case 3: This->generic.js.lRx = value; break;
-            case 4: This->generic.js.lRy = value; break;
-            case 5: This->generic.js.lRz = value; break;
-            case 6: This->generic.js.rglSlider[0] = value; break;
-            case 7: This->generic.js.rglSlider[1] = value; break;
-            case 8: case 9: case 10: case 11:
-            {
-                int idx = axis - 8;
-
-                if (ie.code % 2)
-                    This->povs[idx].y = ie.value;
-                else
-                    This->povs[idx].x = ie.value;
-
-                This->generic.js.rgdwPOV[idx] = value = joystick_map_pov(&This->povs[idx]);
-                break;
-            }
-	    default:
-		FIXME("unhandled joystick axis event (code %d, value %d)\n",ie.code,ie.value);
-	    }
-	    break;
+        default:
+            FIXME("unhandled joystick axis event (code %d, value %d)\n",ie->code,ie->value);
         }
+        break;
+    }
 #ifdef HAVE_STRUCT_FF_EFFECT_DIRECTION
-	case EV_FF_STATUS:
-	    This->ff_state = ie.value;
-	    break;
+    case EV_FF_STATUS:
+        This->ff_state = ie->value;
+        break;
 #endif
 #ifdef EV_SYN
-	case EV_SYN:
-	    /* there is nothing to do */
-	    break;
+    case EV_SYN:
+        /* there is nothing to do */
+        break;
 #endif
 #ifdef EV_MSC
-        case EV_MSC:
-            /* Ignore */
-            break;
+    case EV_MSC:
+        /* Ignore */
+        break;
 #endif
-	default:
-	    TRACE("skipping event\n");
-	    break;
-	}
-        if (inst_id >= 0)
-            queue_event(iface, inst_id,
-                        value, GetCurrentTime(), This->generic.base.dinput->evsequence++);
+    default:
+        TRACE("skipping event\n");
+        break;
+    }
+    if (inst_id >= 0)
+        queue_event((LPDIRECTINPUTDEVICE8A)&This->generic.base.IDirectInputDevice8A_iface, inst_id,
+                    value, time, This->generic.base.dinput->evsequence++);
+}
+
+/* drain the pending events, a whole batch per read() */
+static void joy_read_events(JoystickImpl *This)
+{
+    struct input_event ie[64];
+    struct pollfd plfd;
+    ssize_t size;
+    int i, count;
+    DWORD time;
+
+    plfd.fd = This->joyfd;
+    plfd.events = POLLIN;
+
+    do
+    {
+        if (poll(&plfd, 1, 0) != 1)
+            return;
+
+        size = read(This->joyfd, ie, sizeof(ie));
+        if (size < (ssize_t)sizeof(ie[0]))
+            return;
+
+        count = size / sizeof(ie[0]);
+        time = GetCurrentTime();
+        for (i = 0; i < count; i++)
+            joy_process_event(This, &ie[i], time);
+    }
+    while (count == sizeof(ie) / sizeof(ie[0]));
+}
+
+/* Keep the state current from a thread, so that Poll and GetDeviceState
+ * don't need any syscall and the event timestamps are accurate. */
+static DWORD WINAPI joy_reader_thread(void *arg)
+{
+    JoystickImpl *This = arg;
+    struct pollfd plfd[2];
+
+    plfd[0].fd = This->joyfd;
+    plfd[0].events = POLLIN;
+    plfd[1].fd = This->reader_pipe[0];
+    plfd[1].events = POLLIN;
+
+    for (;;)
+    {
+        if (poll(plfd, 2, -1) == -1)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (plfd[1].revents)
+            break;
+        if (plfd[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+        {
+            WARN("device %s went away\n", This->joydev->device);
+            break;
+        }
+
+        EnterCriticalSection(&This->generic.base.crit);
+        joy_read_events(This);
+        LeaveCriticalSection(&This->generic.base.crit);
+    }
+    return 0;
+}
+
+static void start_reader_thread(JoystickImpl *This)
+{
+    if (pipe(This->reader_pipe) == -1)
+    {
+        WARN("Failed to create pipe: %d %s\n", errno, strerror(errno));
+        return;
+    }
+    if (!(This->reader_thread = CreateThread(NULL, 0, joy_reader_thread, This, 0, NULL)))
+    {
+        WARN("Failed to create reader thread: %u\n", GetLastError());
+        close(This->reader_pipe[0]);
+        close(This->reader_pipe[1]);
     }
 }
 
+static void stop_reader_thread(JoystickImpl *This)
+{
+    if (!This->reader_thread)
+        return;
+
+    if (write(This->reader_pipe[1], "", 1) == -1)
+        ERR("Failed to stop reader thread: %d %s\n", errno, strerror(errno));
+    WaitForSingleObject(This->reader_thread, INFINITE);
+    CloseHandle(This->reader_thread);
+    This->reader_thread = NULL;
+    close(This->reader_pipe[0]);
+    close(This->reader_pipe[1]);
+}
+
+static void joy_polldev(LPDIRECTINPUTDEVICE8A iface)
+{
+    JoystickImpl *This = impl_from_IDirectInputDevice8A(iface);
+
+    if (This->joyfd==-1 || This->reader_thread)
+	return;
+
+    joy_read_events(This);
+}
+
 /******************************************************************************
   *     SetProperty : change input device properties
   */
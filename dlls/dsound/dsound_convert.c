@@ -153,14 +153,14 @@ static inline LONG f_to_32(float value)
 
 void putieee32(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value)
 {
-    BYTE *buf = (BYTE *)dsb->device->tmp_buffer;
+    BYTE *buf = (BYTE *)dsb->tmp_buffer;
     float *fbuf = (float*)(buf + pos + sizeof(float) * channel);
     *fbuf = value;
 }
 
 void putieee32_sum(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value)
 {
-    BYTE *buf = (BYTE *)dsb->device->tmp_buffer;
+    BYTE *buf = (BYTE *)dsb->tmp_buffer;
     float *fbuf = (float*)(buf + pos + sizeof(float) * channel);
     *fbuf += value;
 }
@@ -287,6 +287,33 @@ void mixieee32(float *src, float *dst, unsigned samples)
         *(dst++) += *(src++);
 }
 
+/* apply the per channel volume while mixing, to avoid a separate pass over the data */
+void mixieee32_vol(const float *src, float *dst, unsigned frames, unsigned channels, const float *vols)
+{
+    unsigned int chan;
+
+    TRACE("%p - %p %u\n", src, dst, frames);
+    if (channels == 2)
+    {
+        const float left = vols[0], right = vols[1];
+        while (frames--)
+        {
+            dst[0] += src[0] * left;
+            dst[1] += src[1] * right;
+            dst += 2;
+            src += 2;
+        }
+        return;
+    }
+    while (frames--)
+    {
+        for (chan = 0; chan < channels; chan++)
+            dst[chan] += src[chan] * vols[chan];
+        dst += channels;
+        src += channels;
+    }
+}
+
 static void norm8(float *src, unsigned char *dst, unsigned samples)
 {
     TRACE("%p - %p %d\n", src, dst, samples);
@@ -93,6 +93,8 @@ const WCHAR wine_vxd_drv[] = { 'w','i','n','e','m','m','.','v','x','d', 0 };
 
 /* All default settings, you most likely don't want to touch these, see wiki on UsefulRegistryKeys */
 int ds_hel_buflen = 32768 * 2;
+int ds_mix_threads = 1;
+int ds_mix_threads_min_buffers = 32;
 static HINSTANCE instance;
 
 /*
@@ -145,10 +147,18 @@ void setup_dsound_options(void)
     if (!get_config_key( hkey, appkey, "HelBuflen", buffer, MAX_PATH ))
         ds_hel_buflen = atoi(buffer);
 
+    if (!get_config_key( hkey, appkey, "MixThreads", buffer, MAX_PATH ))
+        ds_mix_threads = atoi(buffer);
+
+    if (!get_config_key( hkey, appkey, "MixThreadsMinBuffers", buffer, MAX_PATH ))
+        ds_mix_threads_min_buffers = atoi(buffer);
+
     if (appkey) RegCloseKey( appkey );
     if (hkey) RegCloseKey( hkey );
 
     TRACE("ds_hel_buflen = %d\n", ds_hel_buflen);
+    TRACE("ds_mix_threads = %d\n", ds_mix_threads);
+    TRACE("ds_mix_threads_min_buffers = %d\n", ds_mix_threads_min_buffers);
 }
 
 static const char * get_device_id(LPCGUID pGuid)
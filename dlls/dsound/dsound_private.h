@@ -36,6 +36,8 @@
 #define DS_MAX_CHANNELS 6
 
 extern int ds_hel_buflen DECLSPEC_HIDDEN;
+extern int ds_mix_threads DECLSPEC_HIDDEN;
+extern int ds_mix_threads_min_buffers DECLSPEC_HIDDEN;
 
 /*****************************************************************************
  * Predeclare the interface implementation structures
@@ -50,6 +52,7 @@ extern const bitsgetfunc getbpp[5] DECLSPEC_HIDDEN;
 void putieee32(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value) DECLSPEC_HIDDEN;
 void putieee32_sum(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value) DECLSPEC_HIDDEN;
 void mixieee32(float *src, float *dst, unsigned samples) DECLSPEC_HIDDEN;
+void mixieee32_vol(const float *src, float *dst, unsigned frames, unsigned channels, const float *vols) DECLSPEC_HIDDEN;
 typedef void (*normfunc)(const void *, void *, unsigned);
 extern const normfunc normfunctions[4] DECLSPEC_HIDDEN;
 
@@ -66,6 +69,15 @@ typedef struct DSFilter {
     IMediaObjectInPlace* inplace;
 } DSFilter;
 
+/* scratch buffers used while mixing a secondary buffer */
+struct mix_scratch
+{
+    float *tmp_buffer, *cp_buffer;
+    DWORD tmp_buffer_len, cp_buffer_len;
+};
+
+struct mix_pool;
+
 /*****************************************************************************
  * IDirectSoundDevice implementation structure
  */
@@ -89,8 +101,8 @@ struct DirectSoundDevice
     int                         speaker_num[DS_MAX_CHANNELS];
     int                         num_speakers;
     int                         lfe_channel;
-    float *tmp_buffer, *cp_buffer;
-    DWORD                       tmp_buffer_len, cp_buffer_len;
+    struct mix_scratch          scratch;
+    struct mix_pool            *mix_pool;
 
     DSVOLUMEPAN                 volpan;
 
@@ -155,6 +167,7 @@ struct IDirectSoundBufferImpl
     LONG64                      freqAccNum;
     /* used for mixing */
     DWORD                       sec_mixpos;
+    float                      *tmp_buffer; /* destination of put, set while mixing */
 
     /* IDirectSoundNotify fields */
     LPDSBPOSITIONNOTIFY         notifies;
@@ -229,6 +242,7 @@ void DSOUND_AmpFactorToVolPan(PDSVOLUMEPAN volpan) DECLSPEC_HIDDEN;
 void DSOUND_RecalcFormat(IDirectSoundBufferImpl *dsb) DECLSPEC_HIDDEN;
 DWORD DSOUND_secpos_to_bufpos(const IDirectSoundBufferImpl *dsb, DWORD secpos, DWORD secmixpos, float *overshot) DECLSPEC_HIDDEN;
 
+void DSOUND_DestroyMixPool(DirectSoundDevice *device) DECLSPEC_HIDDEN;
 DWORD CALLBACK DSOUND_mixthread(void *ptr) DECLSPEC_HIDDEN;
 
 /* sound3d.c */
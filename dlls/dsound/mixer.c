@@ -34,6 +34,7 @@
 #include "wingdi.h"
 #include "mmreg.h"
 #include "winternl.h"
+#include "wine/audiostats.h"
 #include "wine/debug.h"
 #include "dsound.h"
 #include "ks.h"
@@ -42,6 +43,7 @@
 #include "fir.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(dsound);
+WINE_DECLARE_DEBUG_CHANNEL(audiostats);
 
 void DSOUND_RecalcVolPan(PDSVOLUMEPAN volpan)
 {
@@ -290,7 +292,51 @@ static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
     return count;
 }
 
-static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
+/* convert one channel of the secondary buffer to float, without a division per sample */
+static void get_channel_samples(const IDirectSoundBufferImpl *dsb, DWORD mixpos, DWORD channel,
+        float *out, UINT count)
+{
+    UINT istride = dsb->pwfx->nBlockAlign;
+    UINT i;
+
+    if (mixpos >= dsb->buflen && (dsb->playflags & DSBPLAY_LOOPING))
+        mixpos %= dsb->buflen;
+    for (i = 0; i < count; i++, mixpos += istride)
+    {
+        if (mixpos >= dsb->buflen)
+        {
+            if (!(dsb->playflags & DSBPLAY_LOOPING))
+            {
+                memset(out + i, 0, (count - i) * sizeof(float));
+                return;
+            }
+            mixpos %= dsb->buflen;
+        }
+        out[i] = dsb->get(dsb, mixpos, channel);
+    }
+}
+
+/* dot product with independent partial sums, so that the compiler can keep
+ * several multiply-adds in flight and use packed instructions */
+static inline float fir_dot(const float *coefs, const float *samples, int len)
+{
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    int j;
+
+    for (j = 0; j + 4 <= len; j += 4)
+    {
+        sum0 += coefs[j] * samples[j];
+        sum1 += coefs[j + 1] * samples[j + 1];
+        sum2 += coefs[j + 2] * samples[j + 2];
+        sum3 += coefs[j + 3] * samples[j + 3];
+    }
+    for (; j < len; j++)
+        sum0 += coefs[j] * samples[j];
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, struct mix_scratch *scratch,
+        UINT count, LONG64 *freqAccNum)
 {
     UINT i, channel;
     UINT istride = dsb->pwfx->nBlockAlign;
@@ -310,15 +356,15 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     len += fir_cachesize;
     len *= sizeof(float);
 
-    if (!dsb->device->cp_buffer) {
-        dsb->device->cp_buffer = HeapAlloc(GetProcessHeap(), 0, len);
-        dsb->device->cp_buffer_len = len;
-    } else if (len > dsb->device->cp_buffer_len) {
-        dsb->device->cp_buffer = HeapReAlloc(GetProcessHeap(), 0, dsb->device->cp_buffer, len);
-        dsb->device->cp_buffer_len = len;
+    if (!scratch->cp_buffer) {
+        scratch->cp_buffer = HeapAlloc(GetProcessHeap(), 0, len);
+        scratch->cp_buffer_len = len;
+    } else if (len > scratch->cp_buffer_len) {
+        scratch->cp_buffer = HeapReAlloc(GetProcessHeap(), 0, scratch->cp_buffer, len);
+        scratch->cp_buffer_len = len;
     }
 
-    fir_copy = dsb->device->cp_buffer;
+    fir_copy = scratch->cp_buffer;
     intermediate = fir_copy + fir_cachesize;
 
 
@@ -327,10 +373,8 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
      * This is good for CPU cache effects, too.
      */
     itmp = intermediate;
-    for (channel = 0; channel < channels; channel++)
-        for (i = 0; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel);
+    for (channel = 0; channel < channels; channel++, itmp += required_input)
+        get_channel_samples(dsb, dsb->sec_mixpos, channel, itmp, required_input);
 
     for(i = 0; i < count; ++i) {
         UINT int_fir_steps = (freqAcc_start + i * dsb->freqAdjustNum) * dsbfirstep / dsb->freqAdjustDen;
@@ -350,11 +394,7 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
         assert(ipos + fir_used <= required_input);
 
         for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
-            float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
+            float sum = fir_dot(fir_copy, &intermediate[channel * required_input + ipos], fir_used);
             dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
         }
     }
@@ -364,14 +404,15 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
     return max_ipos;
 }
 
-static void cp_fields(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
+static void cp_fields(IDirectSoundBufferImpl *dsb, struct mix_scratch *scratch,
+        UINT count, LONG64 *freqAccNum)
 {
     DWORD ipos, adv;
 
     if (dsb->freqAdjustNum == dsb->freqAdjustDen)
         adv = cp_fields_noresample(dsb, count); /* *freqAccNum is unmodified */
     else
-        adv = cp_fields_resample(dsb, count, freqAccNum);
+        adv = cp_fields_resample(dsb, scratch, count, freqAccNum);
 
     ipos = dsb->sec_mixpos + adv * dsb->pwfx->nBlockAlign;
     if (ipos >= dsb->buflen) {
@@ -414,29 +455,30 @@ static inline DWORD DSOUND_BufPtrDiff(DWORD buflen, DWORD ptr1, DWORD ptr2)
  *
  * NOTE: writepos + len <= buflen. When called by mixer, MixOne makes sure of this.
  */
-static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
+static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, struct mix_scratch *scratch, DWORD frames)
 {
 	UINT size_bytes = frames * sizeof(float) * dsb->device->pwfx->nChannels;
 	HRESULT hr;
 	int i;
 
-	if (dsb->device->tmp_buffer_len < size_bytes || !dsb->device->tmp_buffer)
+	if (scratch->tmp_buffer_len < size_bytes || !scratch->tmp_buffer)
 	{
-		dsb->device->tmp_buffer_len = size_bytes;
-		if (dsb->device->tmp_buffer)
-			dsb->device->tmp_buffer = HeapReAlloc(GetProcessHeap(), 0, dsb->device->tmp_buffer, size_bytes);
+		scratch->tmp_buffer_len = size_bytes;
+		if (scratch->tmp_buffer)
+			scratch->tmp_buffer = HeapReAlloc(GetProcessHeap(), 0, scratch->tmp_buffer, size_bytes);
 		else
-			dsb->device->tmp_buffer = HeapAlloc(GetProcessHeap(), 0, size_bytes);
+			scratch->tmp_buffer = HeapAlloc(GetProcessHeap(), 0, size_bytes);
 	}
+	dsb->tmp_buffer = scratch->tmp_buffer;
 	if(dsb->put_aux == putieee32_sum)
-		memset(dsb->device->tmp_buffer, 0, dsb->device->tmp_buffer_len);
+		memset(scratch->tmp_buffer, 0, scratch->tmp_buffer_len);
 
-	cp_fields(dsb, frames, &dsb->freqAccNum);
+	cp_fields(dsb, scratch, frames, &dsb->freqAccNum);
 
 	if (size_bytes > 0) {
 		for (i = 0; i < dsb->num_filters; i++) {
 			if (dsb->filters[i].inplace) {
-				hr = IMediaObjectInPlace_Process(dsb->filters[i].inplace, size_bytes, (BYTE*)dsb->device->tmp_buffer, 0, DMO_INPLACE_NORMAL);
+				hr = IMediaObjectInPlace_Process(dsb->filters[i].inplace, size_bytes, (BYTE*)scratch->tmp_buffer, 0, DMO_INPLACE_NORMAL);
 
 				if (FAILED(hr))
 					WARN("IMediaObjectInPlace_Process failed for filter %u\n", i);
@@ -446,35 +488,34 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	}
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/**
+ * Compute the per channel volume factors of the secondary buffer.
+ *
+ * Returns FALSE if no volume needs to be applied. The factors are applied
+ * while mixing into the primary buffer.
+ */
+static BOOL DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, float *vols)
 {
-	INT	i;
-	float vols[DS_MAX_CHANNELS];
-	UINT channels = dsb->device->pwfx->nChannels, chan;
+	UINT channels = dsb->device->pwfx->nChannels, i;
 
-	TRACE("(%p,%d)\n",dsb,frames);
+	TRACE("(%p)\n",dsb);
 	TRACE("left = %x, right = %x\n", dsb->volpan.dwTotalAmpFactor[0],
 		dsb->volpan.dwTotalAmpFactor[1]);
 
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+		return FALSE; /* Nothing to do */
 
 	if (channels > DS_MAX_CHANNELS)
 	{
 		FIXME("There is no support for %u channels\n", channels);
-		return;
+		return FALSE;
 	}
 
 	for (i = 0; i < channels; ++i)
 		vols[i] = dsb->volpan.dwTotalAmpFactor[i] / ((float)0xFFFF);
-
-	for(i = 0; i < frames; ++i){
-		for(chan = 0; chan < channels; ++chan){
-			dsb->device->tmp_buffer[i * channels + chan] *= vols[chan];
-		}
-	}
+	return TRUE;
 }
 
 /**
@@ -489,9 +530,11 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
  * dsb  = the secondary buffer to mix from
  * fraglen = number of bytes to mix
  */
-static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD frames)
+static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, struct mix_scratch *scratch,
+		float *mix_buffer, DWORD frames)
 {
 	float *ibuf;
+	float vols[DS_MAX_CHANNELS];
 	DWORD oldpos;
 
 	TRACE("sec_mixpos=%d/%d\n", dsb->sec_mixpos, dsb->buflen);
@@ -499,13 +542,14 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer,
 
 	/* Resample buffer to temporary buffer specifically allocated for this purpose, if needed */
 	oldpos = dsb->sec_mixpos;
-	DSOUND_MixToTemporary(dsb, frames);
-	ibuf = dsb->device->tmp_buffer;
+	DSOUND_MixToTemporary(dsb, scratch, frames);
+	ibuf = scratch->tmp_buffer;
 
-	/* Apply volume if needed */
-	DSOUND_MixerVol(dsb, frames);
-
-	mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
+	/* Apply volume if needed, in the same pass as the mixing */
+	if (DSOUND_MixerVol(dsb, vols))
+		mixieee32_vol(ibuf, mix_buffer, frames, dsb->device->pwfx->nChannels, vols);
+	else
+		mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
 
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
@@ -528,7 +572,8 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer,
  *
  * Returns: the number of frames beyond the writepos that were mixed.
  */
-static DWORD DSOUND_MixOne(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD frames)
+static DWORD DSOUND_MixOne(IDirectSoundBufferImpl *dsb, struct mix_scratch *scratch,
+		float *mix_buffer, DWORD frames)
 {
 	DWORD primary_done = 0;
 
@@ -553,7 +598,7 @@ static DWORD DSOUND_MixOne(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD
 	/* First try to mix to the end of the buffer if possible
 	 * Theoretically it would allow for better optimization
 	*/
-	primary_done += DSOUND_MixInBuffer(dsb, mix_buffer, frames);
+	primary_done += DSOUND_MixInBuffer(dsb, scratch, mix_buffer, frames);
 
 	TRACE("total mixed data=%d\n", primary_done);
 
@@ -571,40 +616,200 @@ static DWORD DSOUND_MixOne(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD
  * Returns:  the length beyond the writepos that was mixed to.
  */
 
-static void DSOUND_MixToPrimary(const DirectSoundDevice *device, float *mix_buffer, DWORD frames, BOOL *all_stopped)
+/**
+ * Mix one secondary buffer into the given mix buffer if it is playing.
+ *
+ * Returns TRUE if the buffer is still playing.
+ */
+static BOOL DSOUND_MixBuffer(IDirectSoundBufferImpl *dsb, struct mix_scratch *scratch,
+		float *mix_buffer, DWORD frames)
+{
+	BOOL playing = FALSE;
+
+	TRACE("MixToPrimary for %p, state=%d\n", dsb, dsb->state);
+
+	if (dsb->buflen && dsb->state) {
+		TRACE("Checking %p, frames=%d\n", dsb, frames);
+		RtlAcquireResourceShared(&dsb->lock, TRUE);
+		/* if buffer is stopping it is stopped now */
+		if (dsb->state == STATE_STOPPING) {
+			dsb->state = STATE_STOPPED;
+			DSOUND_CheckEvent(dsb, 0, 0);
+		} else if (dsb->state != STATE_STOPPED) {
+
+			/* if the buffer was starting, it must be playing now */
+			if (dsb->state == STATE_STARTING)
+				dsb->state = STATE_PLAYING;
+
+			/* mix next buffer into the main buffer */
+			DSOUND_MixOne(dsb, scratch, mix_buffer, frames);
+
+			playing = TRUE;
+		}
+		RtlReleaseResource(&dsb->lock);
+	}
+	return playing;
+}
+
+/**
+ * Pool of helper threads used to mix the secondary buffers in parallel
+ * when there are many of them. Each worker mixes into its own buffer,
+ * the partial mixes are added to the primary mix at the end.
+ */
+struct mix_worker
+{
+	struct mix_pool *pool;
+	struct mix_scratch scratch;
+	float *mix_buffer;
+	DWORD mix_buffer_len;
+	BOOL mixed, all_stopped;
+};
+
+struct mix_pool
+{
+	DirectSoundDevice *device;
+	HANDLE done;
+	LONG next;	/* index of the next secondary buffer to mix */
+	LONG pending;	/* number of workers still running */
+	DWORD frames;
+	int count;
+	struct mix_worker workers[1];
+};
+
+static void mix_pool_run(struct mix_pool *pool, struct mix_scratch *scratch, float *mix_buffer,
+		BOOL clear, BOOL *mixed, BOOL *all_stopped)
+{
+	const DirectSoundDevice *device = pool->device;
+	LONG i;
+
+	while ((i = InterlockedIncrement(&pool->next) - 1) < device->nrofbuffers) {
+		if (clear && !*mixed)
+			memset(mix_buffer, 0, pool->frames * device->pwfx->nChannels * sizeof(float));
+		*mixed = TRUE;
+		if (DSOUND_MixBuffer(device->buffers[i], scratch, mix_buffer, pool->frames))
+			*all_stopped = FALSE;
+	}
+}
+
+static void CALLBACK mix_worker_proc(TP_CALLBACK_INSTANCE *instance, void *context)
+{
+	struct mix_worker *worker = context;
+	struct mix_pool *pool = worker->pool;
+
+	mix_pool_run(pool, &worker->scratch, worker->mix_buffer, TRUE, &worker->mixed, &worker->all_stopped);
+	if (!InterlockedDecrement(&pool->pending))
+		SetEvent(pool->done);
+}
+
+static struct mix_pool *get_mix_pool(DirectSoundDevice *device)
+{
+	struct mix_pool *pool;
+	int i, count = min(ds_mix_threads, 16) - 1;
+
+	if (device->mix_pool) return device->mix_pool;
+
+	if (!(pool = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
+			FIELD_OFFSET(struct mix_pool, workers[count]))))
+		return NULL;
+	if (!(pool->done = CreateEventW(NULL, FALSE, FALSE, NULL))) {
+		HeapFree(GetProcessHeap(), 0, pool);
+		return NULL;
+	}
+	pool->device = device;
+	pool->count = count;
+	for (i = 0; i < count; i++)
+		pool->workers[i].pool = pool;
+	TRACE("created pool of %d mixing threads for %p\n", count, device);
+	return device->mix_pool = pool;
+}
+
+void DSOUND_DestroyMixPool(DirectSoundDevice *device)
+{
+	struct mix_pool *pool = device->mix_pool;
+	int i;
+
+	if (!pool) return;
+	for (i = 0; i < pool->count; i++) {
+		HeapFree(GetProcessHeap(), 0, pool->workers[i].scratch.tmp_buffer);
+		HeapFree(GetProcessHeap(), 0, pool->workers[i].scratch.cp_buffer);
+		HeapFree(GetProcessHeap(), 0, pool->workers[i].mix_buffer);
+	}
+	CloseHandle(pool->done);
+	HeapFree(GetProcessHeap(), 0, pool);
+	device->mix_pool = NULL;
+}
+
+/**
+ * Mix the secondary buffers using the helper threads. The calling thread
+ * takes part in the mixing, directly into the primary mix buffer.
+ *
+ * Returns FALSE if the pool couldn't be used.
+ */
+static BOOL DSOUND_MixToPrimaryParallel(DirectSoundDevice *device, float *mix_buffer, DWORD frames, BOOL *all_stopped)
+{
+	DWORD len = frames * device->pwfx->nChannels * sizeof(float);
+	struct mix_pool *pool;
+	BOOL mixed = FALSE;
+	int i;
+
+	if (!(pool = get_mix_pool(device))) return FALSE;
+
+	for (i = 0; i < pool->count; i++) {
+		struct mix_worker *worker = &pool->workers[i];
+		float *buffer;
+
+		if (worker->mix_buffer_len >= len) continue;
+		if (worker->mix_buffer)
+			buffer = HeapReAlloc(GetProcessHeap(), 0, worker->mix_buffer, len);
+		else
+			buffer = HeapAlloc(GetProcessHeap(), 0, len);
+		if (!buffer) return FALSE;
+		worker->mix_buffer = buffer;
+		worker->mix_buffer_len = len;
+	}
+
+	pool->next = 0;
+	pool->frames = frames;
+	pool->pending = pool->count;
+	for (i = 0; i < pool->count; i++) {
+		struct mix_worker *worker = &pool->workers[i];
+
+		worker->mixed = FALSE;
+		worker->all_stopped = TRUE;
+		if (!TrySubmitThreadpoolCallback(mix_worker_proc, worker, NULL))
+			mix_worker_proc(NULL, worker);
+	}
+
+	mix_pool_run(pool, &device->scratch, mix_buffer, FALSE, &mixed, all_stopped);
+	WaitForSingleObject(pool->done, INFINITE);
+
+	for (i = 0; i < pool->count; i++) {
+		struct mix_worker *worker = &pool->workers[i];
+
+		if (!worker->mixed) continue;
+		mixieee32(worker->mix_buffer, mix_buffer, frames * device->pwfx->nChannels);
+		if (!worker->all_stopped) *all_stopped = FALSE;
+	}
+	return TRUE;
+}
+
+static void DSOUND_MixToPrimary(DirectSoundDevice *device, float *mix_buffer, DWORD frames, BOOL *all_stopped)
 {
 	INT i;
-	IDirectSoundBufferImpl	*dsb;
 
 	/* unless we find a running buffer, all have stopped */
 	*all_stopped = TRUE;
 
 	TRACE("(frames %d)\n", frames);
-	for (i = 0; i < device->nrofbuffers; i++) {
-		dsb = device->buffers[i];
-
-		TRACE("MixToPrimary for %p, state=%d\n", dsb, dsb->state);
-
-		if (dsb->buflen && dsb->state) {
-			TRACE("Checking %p, frames=%d\n", dsb, frames);
-			RtlAcquireResourceShared(&dsb->lock, TRUE);
-			/* if buffer is stopping it is stopped now */
-			if (dsb->state == STATE_STOPPING) {
-				dsb->state = STATE_STOPPED;
-				DSOUND_CheckEvent(dsb, 0, 0);
-			} else if (dsb->state != STATE_STOPPED) {
-
-				/* if the buffer was starting, it must be playing now */
-				if (dsb->state == STATE_STARTING)
-					dsb->state = STATE_PLAYING;
 
-				/* mix next buffer into the main buffer */
-				DSOUND_MixOne(dsb, mix_buffer, frames);
+	/* only worth the synchronization with many buffers */
+	if (ds_mix_threads > 1 && device->nrofbuffers >= ds_mix_threads_min_buffers &&
+	    DSOUND_MixToPrimaryParallel(device, mix_buffer, frames, all_stopped))
+		return;
 
-				*all_stopped = FALSE;
-			}
-			RtlReleaseResource(&dsb->lock);
-		}
+	for (i = 0; i < device->nrofbuffers; i++) {
+		if (DSOUND_MixBuffer(device->buffers[i], &device->scratch, mix_buffer, frames))
+			*all_stopped = FALSE;
 	}
 }
 
@@ -651,8 +856,8 @@ static void DSOUND_WaveQueue(DirectSoundDevice *device, LPBYTE pos, DWORD bytes)
  * The mixing procedure goes:
  *
  * secondary->buffer (secondary format)
- *   =[Resample]=> device->tmp_buffer (float format)
- *   =[Volume]=> device->tmp_buffer (float format)
+ *   =[Resample]=> scratch tmp_buffer (float format)
+ *   =[Volume]=> device->buffer or a per-thread partial mix (float format)
  *   =[Reformat]=> device->buffer (device format, skipped on float)
  */
 static void DSOUND_PerformMix(DirectSoundDevice *device)
@@ -744,6 +949,8 @@ static void DSOUND_PerformMix(DirectSoundDevice *device)
 DWORD CALLBACK DSOUND_mixthread(void *p)
 {
 	DirectSoundDevice *dev = p;
+	struct audio_stats *stats;
+	LONGLONG start;
 	TRACE("(%p)\n", dev);
 
 	while (dev->ref) {
@@ -762,9 +969,17 @@ DWORD CALLBACK DSOUND_mixthread(void *p)
 			break;
 
 		RtlAcquireResourceShared(&(dev->buffer_list_lock), TRUE);
+		start = audio_stats_time();
 		DSOUND_PerformMix(dev);
+		audio_stats_mixer(audio_stats_time() - start);
 		RtlReleaseResource(&(dev->buffer_list_lock));
 	}
+
+	if (TRACE_ON(audiostats) && (stats = audio_stats_get()) && stats->mixer_runs)
+		TRACE_(audiostats)("%d mixer runs, %s avg, %s max (100ns)\n", stats->mixer_runs,
+			wine_dbgstr_longlong(stats->mixer_time / stats->mixer_runs),
+			wine_dbgstr_longlong(stats->mixer_max_time));
+
 	SetEvent(dev->thread_finished);
 	return 0;
 }
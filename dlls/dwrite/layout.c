@@ -921,6 +921,235 @@ fatal:
     return hr;
 }
 
+/* Process-wide cache of shaped runs. UI code often creates layouts for the
+ * same short strings over and over, so glyphs, cluster maps and placements
+ * of short runs are kept and reused. Each entry holds a reference to its
+ * font face, so the face pointer can be used as part of the key. */
+#define SHAPING_CACHE_MAX_LENGTH  64
+#define SHAPING_CACHE_MAX_ENTRIES 1024
+#define SHAPING_CACHE_BUCKETS     256
+
+struct shaping_cache_key
+{
+    IDWriteFontFace *fontface;
+    FLOAT emsize;
+    BOOL is_sideways;
+    BOOL is_rtl;
+    DWRITE_SCRIPT_ANALYSIS sa;
+    BOOL gdi_compatible;
+    BOOL gdi_natural;
+    FLOAT ppdip;
+    DWRITE_MATRIX transform;
+    WCHAR locale[LOCALE_NAME_MAX_LENGTH];
+    UINT32 length;
+};
+
+struct shaping_cache_entry
+{
+    struct list entry;
+    struct list lru_entry;
+    struct shaping_cache_key key;
+    UINT32 hash;
+    UINT32 glyphcount;
+    FLOAT *advances;
+    DWRITE_GLYPH_OFFSET *offsets;
+    UINT16 *glyphs;
+    UINT16 *clustermap;
+    WCHAR *string;
+};
+
+static struct list shaping_cache[SHAPING_CACHE_BUCKETS];
+static struct list shaping_cache_lru = LIST_INIT(shaping_cache_lru);
+static UINT32 shaping_cache_count;
+
+static CRITICAL_SECTION shaping_cache_cs;
+static CRITICAL_SECTION_DEBUG shaping_cache_cs_debug =
+{
+    0, 0, &shaping_cache_cs,
+    { &shaping_cache_cs_debug.ProcessLocksList, &shaping_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": shaping_cache_cs") }
+};
+static CRITICAL_SECTION shaping_cache_cs = { &shaping_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static UINT32 shaping_cache_hash(const void *data, SIZE_T size, UINT32 hash)
+{
+    const BYTE *ptr = data;
+
+    while (size--)
+        hash = (hash ^ *ptr++) * 0x01000193;
+    return hash;
+}
+
+static BOOL shaping_cache_get_key(struct dwrite_textlayout *layout, const struct regular_layout_run *run,
+        struct shaping_cache_key *key, UINT32 *hash)
+{
+    if (run->descr.stringLength > SHAPING_CACHE_MAX_LENGTH)
+        return FALSE;
+
+    /* clear the padding too, keys are compared with memcmp() */
+    memset(key, 0, sizeof(*key));
+    key->fontface = run->run.fontFace;
+    key->emsize = run->run.fontEmSize;
+    key->is_sideways = run->run.isSideways;
+    key->is_rtl = run->run.bidiLevel & 1;
+    key->sa = run->sa;
+    if ((key->gdi_compatible = is_layout_gdi_compatible(layout)))
+    {
+        key->gdi_natural = layout->measuringmode == DWRITE_MEASURING_MODE_GDI_NATURAL;
+        key->ppdip = layout->ppdip;
+        key->transform = layout->transform;
+    }
+    lstrcpynW(key->locale, run->descr.localeName, ARRAY_SIZE(key->locale));
+    key->length = run->descr.stringLength;
+
+    *hash = shaping_cache_hash(key, sizeof(*key), 0x811c9dc5);
+    *hash = shaping_cache_hash(run->descr.string, key->length * sizeof(WCHAR), *hash);
+    return TRUE;
+}
+
+static void shaping_cache_free_entry(struct shaping_cache_entry *entry)
+{
+    list_remove(&entry->entry);
+    list_remove(&entry->lru_entry);
+    IDWriteFontFace_Release(entry->key.fontface);
+    heap_free(entry);
+    shaping_cache_count--;
+}
+
+static struct shaping_cache_entry *shaping_cache_find(const struct shaping_cache_key *key, UINT32 hash,
+        const WCHAR *string)
+{
+    struct list *bucket = &shaping_cache[hash % SHAPING_CACHE_BUCKETS];
+    struct shaping_cache_entry *entry;
+
+    if (!bucket->next) return NULL;
+    LIST_FOR_EACH_ENTRY(entry, bucket, struct shaping_cache_entry, entry)
+    {
+        if (entry->hash == hash && !memcmp(&entry->key, key, sizeof(*key))
+                && !memcmp(entry->string, string, key->length * sizeof(WCHAR)))
+            return entry;
+    }
+    return NULL;
+}
+
+/* Fills the run from the cache, returns FALSE if it has to be shaped. */
+static BOOL shaping_cache_get(struct dwrite_textlayout *layout, struct regular_layout_run *run)
+{
+    struct shaping_cache_entry *entry;
+    struct shaping_cache_key key;
+    UINT32 hash;
+    BOOL ret = FALSE;
+
+    if (!shaping_cache_get_key(layout, run, &key, &hash))
+        return FALSE;
+
+    EnterCriticalSection(&shaping_cache_cs);
+
+    if ((entry = shaping_cache_find(&key, hash, run->descr.string)))
+    {
+        run->clustermap = heap_alloc(key.length * sizeof(*run->clustermap));
+        run->glyphs = heap_alloc(entry->glyphcount * sizeof(*run->glyphs));
+        run->advances = heap_alloc(entry->glyphcount * sizeof(*run->advances));
+        run->offsets = heap_alloc(entry->glyphcount * sizeof(*run->offsets));
+        if (run->clustermap && run->glyphs && run->advances && run->offsets)
+        {
+            memcpy(run->clustermap, entry->clustermap, key.length * sizeof(*run->clustermap));
+            memcpy(run->glyphs, entry->glyphs, entry->glyphcount * sizeof(*run->glyphs));
+            memcpy(run->advances, entry->advances, entry->glyphcount * sizeof(*run->advances));
+            memcpy(run->offsets, entry->offsets, entry->glyphcount * sizeof(*run->offsets));
+            run->glyphcount = entry->glyphcount;
+            list_remove(&entry->lru_entry);
+            list_add_head(&shaping_cache_lru, &entry->lru_entry);
+            ret = TRUE;
+        }
+        else
+        {
+            heap_free(run->clustermap);
+            heap_free(run->glyphs);
+            heap_free(run->advances);
+            heap_free(run->offsets);
+            run->clustermap = run->glyphs = NULL;
+            run->advances = NULL;
+            run->offsets = NULL;
+        }
+    }
+
+    LeaveCriticalSection(&shaping_cache_cs);
+
+    return ret;
+}
+
+static void shaping_cache_add(struct dwrite_textlayout *layout, const struct regular_layout_run *run)
+{
+    struct shaping_cache_entry *entry;
+    struct shaping_cache_key key;
+    UINT32 hash, count, i;
+    BYTE *ptr;
+
+    if (!shaping_cache_get_key(layout, run, &key, &hash))
+        return;
+
+    count = run->glyphcount;
+    if (!(entry = heap_alloc(sizeof(*entry) + count * (sizeof(*entry->advances) + sizeof(*entry->offsets)
+            + sizeof(*entry->glyphs)) + key.length * (sizeof(*entry->clustermap) + sizeof(WCHAR)))))
+        return;
+
+    ptr = (BYTE *)(entry + 1);
+    entry->advances = (FLOAT *)ptr;
+    ptr += count * sizeof(*entry->advances);
+    entry->offsets = (DWRITE_GLYPH_OFFSET *)ptr;
+    ptr += count * sizeof(*entry->offsets);
+    entry->glyphs = (UINT16 *)ptr;
+    ptr += count * sizeof(*entry->glyphs);
+    entry->clustermap = (UINT16 *)ptr;
+    ptr += key.length * sizeof(*entry->clustermap);
+    entry->string = (WCHAR *)ptr;
+
+    entry->key = key;
+    entry->hash = hash;
+    entry->glyphcount = count;
+    memcpy(entry->advances, run->advances, count * sizeof(*entry->advances));
+    memcpy(entry->offsets, run->offsets, count * sizeof(*entry->offsets));
+    memcpy(entry->glyphs, run->glyphs, count * sizeof(*entry->glyphs));
+    memcpy(entry->clustermap, run->clustermap, key.length * sizeof(*entry->clustermap));
+    memcpy(entry->string, run->descr.string, key.length * sizeof(WCHAR));
+
+    EnterCriticalSection(&shaping_cache_cs);
+
+    if (shaping_cache_find(&key, hash, run->descr.string))
+    {
+        LeaveCriticalSection(&shaping_cache_cs);
+        heap_free(entry);
+        return;
+    }
+
+    if (!shaping_cache[0].next)
+    {
+        for (i = 0; i < SHAPING_CACHE_BUCKETS; i++)
+            list_init(&shaping_cache[i]);
+    }
+
+    if (shaping_cache_count == SHAPING_CACHE_MAX_ENTRIES)
+        shaping_cache_free_entry(LIST_ENTRY(list_tail(&shaping_cache_lru), struct shaping_cache_entry, lru_entry));
+
+    IDWriteFontFace_AddRef(key.fontface);
+    list_add_head(&shaping_cache[hash % SHAPING_CACHE_BUCKETS], &entry->entry);
+    list_add_head(&shaping_cache_lru, &entry->lru_entry);
+    shaping_cache_count++;
+
+    LeaveCriticalSection(&shaping_cache_cs);
+}
+
+void release_shaping_cache(void)
+{
+    struct shaping_cache_entry *entry, *next;
+
+    EnterCriticalSection(&shaping_cache_cs);
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &shaping_cache_lru, struct shaping_cache_entry, lru_entry)
+        shaping_cache_free_entry(entry);
+    LeaveCriticalSection(&shaping_cache_cs);
+}
+
 static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular_layout_run *run)
 {
     DWRITE_SHAPING_GLYPH_PROPERTIES *glyph_props;
@@ -932,6 +1161,14 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
 
     range = get_layout_range_by_pos(layout, run->descr.textPosition);
     run->descr.localeName = range->locale;
+
+    if (shaping_cache_get(layout, run))
+    {
+        run->run.glyphIndices = run->glyphs;
+        run->descr.clusterMap = run->clustermap;
+        goto done;
+    }
+
     run->clustermap = heap_alloc(run->descr.stringLength * sizeof(*run->clustermap));
 
     max_count = 3 * run->descr.stringLength / 2 + 16;
@@ -1007,7 +1244,10 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
         memset(run->offsets, 0, run->glyphcount * sizeof(*run->offsets));
         WARN("%s: failed to get glyph placement info, hr %#x.\n", debugstr_rundescr(&run->descr), hr);
     }
+    else
+        shaping_cache_add(layout, run);
 
+done:
     run->run.glyphAdvances = run->advances;
     run->run.glyphOffsets = run->offsets;
 
@@ -48,6 +48,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD reason, LPVOID reserved)
         break;
     case DLL_PROCESS_DETACH:
         if (reserved) break;
+        release_shaping_cache();
         release_shared_factory(shared_factory);
         release_freetype();
     }
@@ -270,10 +270,39 @@ static void STDMETHODCALLTYPE dxgi_adapter_UnregisterHardwareContentProtectionTe
 static HRESULT STDMETHODCALLTYPE dxgi_adapter_QueryVideoMemoryInfo(IWineDXGIAdapter *iface,
         UINT node_index, DXGI_MEMORY_SEGMENT_GROUP segment_group, DXGI_QUERY_VIDEO_MEMORY_INFO *memory_info)
 {
-    FIXME("iface %p, node_index %u, segment_group %#x, memory_info %p stub!\n",
+    struct dxgi_adapter *adapter = impl_from_IWineDXGIAdapter(iface);
+    UINT64 budget, usage;
+    HRESULT hr;
+
+    TRACE("iface %p, node_index %u, segment_group %#x, memory_info %p.\n",
             iface, node_index, segment_group, memory_info);
 
-    return E_NOTIMPL;
+    if (node_index)
+        FIXME("Ignoring node index %u.\n", node_index);
+
+    switch (segment_group)
+    {
+        case DXGI_MEMORY_SEGMENT_GROUP_LOCAL:
+            wined3d_mutex_lock();
+            hr = wined3d_get_adapter_memory_info(adapter->factory->wined3d, adapter->ordinal, &budget, &usage);
+            wined3d_mutex_unlock();
+            if (FAILED(hr))
+                return hr;
+
+            memory_info->Budget = budget;
+            memory_info->CurrentUsage = usage;
+            memory_info->AvailableForReservation = budget / 2;
+            memory_info->CurrentReservation = 0;
+            return S_OK;
+
+        case DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL:
+            memset(memory_info, 0, sizeof(*memory_info));
+            return S_OK;
+
+        default:
+            WARN("Invalid memory segment group %#x.\n", segment_group);
+            return E_INVALIDARG;
+    }
 }
 
 static HRESULT STDMETHODCALLTYPE dxgi_adapter_SetVideoMemoryReservation(IWineDXGIAdapter *iface,
@@ -128,6 +128,7 @@ struct dxgi_device
     struct wined3d_private_store private_store;
     struct wined3d_device *wined3d_device;
     IWineDXGIAdapter *adapter;
+    UINT max_frame_latency;
 };
 
 HRESULT dxgi_device_init(struct dxgi_device *device, struct dxgi_device_layer *layer,
@@ -162,7 +163,7 @@ struct dxgi_adapter *unsafe_impl_from_IDXGIAdapter(IDXGIAdapter *iface) DECLSPEC
 /* IDXGISwapChain */
 struct dxgi_swapchain
 {
-    IDXGISwapChain1 IDXGISwapChain1_iface;
+    IDXGISwapChain2 IDXGISwapChain2_iface;
     LONG refcount;
     struct wined3d_private_store private_store;
     struct wined3d_swapchain *wined3d_swapchain;
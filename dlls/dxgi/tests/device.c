@@ -591,6 +591,62 @@ static void test_adapter_luid(void)
     ok(!refcount, "Factory has %u references left.\n", refcount);
 }
 
+static void test_query_video_memory_info(void)
+{
+    DXGI_QUERY_VIDEO_MEMORY_INFO memory_info;
+    IDXGIAdapter3 *adapter3;
+    IDXGIAdapter *adapter;
+    IDXGIDevice *device;
+    ULONG refcount;
+    HRESULT hr;
+
+    if (!(device = create_device(0)))
+    {
+        skip("Failed to create device, skipping tests.\n");
+        return;
+    }
+
+    hr = IDXGIDevice_GetAdapter(device, &adapter);
+    ok(SUCCEEDED(hr), "GetAdapter failed, hr %#x.\n", hr);
+    hr = IDXGIAdapter_QueryInterface(adapter, &IID_IDXGIAdapter3, (void **)&adapter3);
+    ok(hr == S_OK || hr == E_NOINTERFACE, "Got unexpected hr %#x.\n", hr);
+    if (hr == E_NOINTERFACE)
+    {
+        skip("IDXGIAdapter3 is not available.\n");
+        goto done;
+    }
+
+    memset(&memory_info, 0xcc, sizeof(memory_info));
+    hr = IDXGIAdapter3_QueryVideoMemoryInfo(adapter3, 0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memory_info);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+    ok(memory_info.Budget > 0, "Got unexpected budget %s.\n", wine_dbgstr_longlong(memory_info.Budget));
+    ok(memory_info.AvailableForReservation <= memory_info.Budget,
+            "Got unexpected available for reservation %s, budget %s.\n",
+            wine_dbgstr_longlong(memory_info.AvailableForReservation),
+            wine_dbgstr_longlong(memory_info.Budget));
+    ok(!memory_info.CurrentReservation, "Got unexpected current reservation %s.\n",
+            wine_dbgstr_longlong(memory_info.CurrentReservation));
+    trace("Local budget %s, usage %s.\n", wine_dbgstr_longlong(memory_info.Budget),
+            wine_dbgstr_longlong(memory_info.CurrentUsage));
+
+    memset(&memory_info, 0xcc, sizeof(memory_info));
+    hr = IDXGIAdapter3_QueryVideoMemoryInfo(adapter3, 0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &memory_info);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+    ok(memory_info.CurrentUsage <= memory_info.Budget || !memory_info.Budget,
+            "Got unexpected usage %s, budget %s.\n", wine_dbgstr_longlong(memory_info.CurrentUsage),
+            wine_dbgstr_longlong(memory_info.Budget));
+
+    hr = IDXGIAdapter3_QueryVideoMemoryInfo(adapter3, 0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL + 1, &memory_info);
+    ok(hr == E_INVALIDARG, "Got unexpected hr %#x.\n", hr);
+
+    IDXGIAdapter3_Release(adapter3);
+
+done:
+    IDXGIAdapter_Release(adapter);
+    refcount = IDXGIDevice_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+}
+
 static void test_check_interface_support(void)
 {
     LARGE_INTEGER driver_version;
@@ -3370,25 +3426,25 @@ static void test_maximum_frame_latency(void)
     if (SUCCEEDED(IDXGIDevice_QueryInterface(device, &IID_IDXGIDevice1, (void **)&device1)))
     {
         hr = IDXGIDevice1_GetMaximumFrameLatency(device1, &max_latency);
-        todo_wine ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+        ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
         ok(max_latency == DEFAULT_FRAME_LATENCY, "Got unexpected maximum frame latency %u.\n", max_latency);
 
         hr = IDXGIDevice1_SetMaximumFrameLatency(device1, MAX_FRAME_LATENCY);
-        todo_wine ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+        ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
         hr = IDXGIDevice1_GetMaximumFrameLatency(device1, &max_latency);
-        todo_wine ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
-        todo_wine ok(max_latency == MAX_FRAME_LATENCY, "Got unexpected maximum frame latency %u.\n", max_latency);
+        ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+        ok(max_latency == MAX_FRAME_LATENCY, "Got unexpected maximum frame latency %u.\n", max_latency);
 
         hr = IDXGIDevice1_SetMaximumFrameLatency(device1, MAX_FRAME_LATENCY + 1);
         ok(hr == DXGI_ERROR_INVALID_CALL, "Got unexpected hr %#x.\n", hr);
         hr = IDXGIDevice1_GetMaximumFrameLatency(device1, &max_latency);
-        todo_wine ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
-        todo_wine ok(max_latency == MAX_FRAME_LATENCY, "Got unexpected maximum frame latency %u.\n", max_latency);
+        ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+        ok(max_latency == MAX_FRAME_LATENCY, "Got unexpected maximum frame latency %u.\n", max_latency);
 
         hr = IDXGIDevice1_SetMaximumFrameLatency(device1, 0);
-        todo_wine ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+        ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
         hr = IDXGIDevice1_GetMaximumFrameLatency(device1, &max_latency);
-        todo_wine ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+        ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
         /* 0 does not reset to the default frame latency on all Windows versions. */
         ok(max_latency == DEFAULT_FRAME_LATENCY || broken(!max_latency),
                 "Got unexpected maximum frame latency %u.\n", max_latency);
@@ -3404,6 +3460,120 @@ static void test_maximum_frame_latency(void)
     ok(!refcount, "Device has %u references left.\n", refcount);
 }
 
+static void test_frame_latency_waitable_object(void)
+{
+    DXGI_SWAP_CHAIN_DESC swapchain_desc;
+    IDXGISwapChain2 *swapchain2;
+    IDXGISwapChain *swapchain;
+    IDXGIAdapter *adapter;
+    IDXGIFactory *factory;
+    IDXGIDevice *device;
+    UINT max_latency;
+    HANDLE object;
+    ULONG refcount;
+    HWND window;
+    DWORD ret;
+    HRESULT hr;
+
+    if (!(device = create_device(0)))
+    {
+        skip("Failed to create device.\n");
+        return;
+    }
+    window = CreateWindowA("static", "dxgi_test", WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+            0, 0, 640, 480, NULL, NULL, NULL, NULL);
+
+    hr = IDXGIDevice_GetAdapter(device, &adapter);
+    ok(SUCCEEDED(hr), "Failed to get adapter, hr %#x.\n", hr);
+    hr = IDXGIAdapter_GetParent(adapter, &IID_IDXGIFactory, (void **)&factory);
+    ok(SUCCEEDED(hr), "Failed to get factory, hr %#x.\n", hr);
+    IDXGIAdapter_Release(adapter);
+
+    swapchain_desc.BufferDesc.Width = 640;
+    swapchain_desc.BufferDesc.Height = 480;
+    swapchain_desc.BufferDesc.RefreshRate.Numerator = 60;
+    swapchain_desc.BufferDesc.RefreshRate.Denominator = 1;
+    swapchain_desc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    swapchain_desc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+    swapchain_desc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+    swapchain_desc.SampleDesc.Count = 1;
+    swapchain_desc.SampleDesc.Quality = 0;
+    swapchain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    swapchain_desc.BufferCount = 2;
+    swapchain_desc.OutputWindow = window;
+    swapchain_desc.Windowed = TRUE;
+    swapchain_desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    swapchain_desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+
+    hr = IDXGIFactory_CreateSwapChain(factory, (IUnknown *)device, &swapchain_desc, &swapchain);
+    if (FAILED(hr) || FAILED(IDXGISwapChain_QueryInterface(swapchain, &IID_IDXGISwapChain2, (void **)&swapchain2)))
+    {
+        win_skip("Frame latency waitable objects are not supported.\n");
+        if (SUCCEEDED(hr))
+            IDXGISwapChain_Release(swapchain);
+        goto done;
+    }
+
+    hr = IDXGISwapChain_GetDesc(swapchain, &swapchain_desc);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+    ok(swapchain_desc.Flags == DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT,
+            "Got unexpected flags %#x.\n", swapchain_desc.Flags);
+
+    hr = IDXGISwapChain2_GetMaximumFrameLatency(swapchain2, &max_latency);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+    ok(max_latency == 1, "Got unexpected maximum frame latency %u.\n", max_latency);
+
+    object = IDXGISwapChain2_GetFrameLatencyWaitableObject(swapchain2);
+    ok(!!object, "Failed to get frame latency waitable object.\n");
+    ret = WaitForSingleObject(object, 0);
+    ok(ret == WAIT_OBJECT_0, "Got unexpected wait result %#x.\n", ret);
+    ret = WaitForSingleObject(object, 0);
+    ok(ret == WAIT_TIMEOUT, "Got unexpected wait result %#x.\n", ret);
+
+    hr = IDXGISwapChain2_Present(swapchain2, 0, 0);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+    ret = WaitForSingleObject(object, 1000);
+    ok(ret == WAIT_OBJECT_0, "Got unexpected wait result %#x.\n", ret);
+
+    hr = IDXGISwapChain2_SetMaximumFrameLatency(swapchain2, 0);
+    ok(hr == DXGI_ERROR_INVALID_CALL, "Got unexpected hr %#x.\n", hr);
+    hr = IDXGISwapChain2_SetMaximumFrameLatency(swapchain2, MAX_FRAME_LATENCY + 1);
+    ok(hr == DXGI_ERROR_INVALID_CALL, "Got unexpected hr %#x.\n", hr);
+    hr = IDXGISwapChain2_SetMaximumFrameLatency(swapchain2, 2);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+    hr = IDXGISwapChain2_GetMaximumFrameLatency(swapchain2, &max_latency);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+    ok(max_latency == 2, "Got unexpected maximum frame latency %u.\n", max_latency);
+    ret = WaitForSingleObject(object, 0);
+    ok(ret == WAIT_OBJECT_0, "Got unexpected wait result %#x.\n", ret);
+
+    CloseHandle(object);
+    IDXGISwapChain2_Release(swapchain2);
+    refcount = IDXGISwapChain_Release(swapchain);
+    ok(!refcount, "Swapchain has %u references left.\n", refcount);
+
+    swapchain_desc.Flags = 0;
+    hr = IDXGIFactory_CreateSwapChain(factory, (IUnknown *)device, &swapchain_desc, &swapchain);
+    ok(hr == S_OK, "Failed to create swapchain, hr %#x.\n", hr);
+    hr = IDXGISwapChain_QueryInterface(swapchain, &IID_IDXGISwapChain2, (void **)&swapchain2);
+    ok(hr == S_OK, "Got unexpected hr %#x.\n", hr);
+
+    object = IDXGISwapChain2_GetFrameLatencyWaitableObject(swapchain2);
+    ok(!object, "Got unexpected object %p.\n", object);
+    hr = IDXGISwapChain2_SetMaximumFrameLatency(swapchain2, 2);
+    ok(hr == DXGI_ERROR_INVALID_CALL, "Got unexpected hr %#x.\n", hr);
+
+    IDXGISwapChain2_Release(swapchain2);
+    refcount = IDXGISwapChain_Release(swapchain);
+    ok(!refcount, "Swapchain has %u references left.\n", refcount);
+
+done:
+    IDXGIFactory_Release(factory);
+    refcount = IDXGIDevice_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+    DestroyWindow(window);
+}
+
 static void test_output_desc(void)
 {
     IDXGIAdapter *adapter, *adapter2;
@@ -3639,6 +3809,7 @@ START_TEST(device)
 
     test_adapter_desc();
     test_adapter_luid();
+    test_query_video_memory_info();
     test_check_interface_support();
     test_create_surface();
     test_parents();
@@ -3655,6 +3826,7 @@ START_TEST(device)
     test_swapchain_resize();
     test_swapchain_parameters();
     test_maximum_frame_latency();
+    test_frame_latency_waitable_object();
     test_output_desc();
     test_object_wrapping();
 }
@@ -51,10 +51,23 @@ struct cached_font
     LOGFONTW              lf;
     XFORM                 xform;
     UINT                  aa_flags;
+    LONG                  size;    /* bytes used by the cached glyphs */
+    LONG                  hits;
+    LONG                  misses;
     struct cached_glyph **glyphs[GLYPH_NBTYPES][GLYPH_CACHE_PAGES];
 };
 
+/* Fonts are shared by all DCs and kept in most-recently used order. Unused
+ * fonts stay cached across font handle lifetimes until there are too many of
+ * them or the glyphs of all fonts exceed the budget; fonts that are still
+ * selected are never evicted, since their glyphs are read without locking. */
+#define MAX_UNUSED_FONTS 64
+
 static struct list font_cache = LIST_INIT( font_cache );
+static LONG glyph_cache_size;
+static LONG glyph_cache_budget;
+static LONG glyph_cache_hits;
+static LONG glyph_cache_misses;
 
 static CRITICAL_SECTION font_cache_cs;
 static CRITICAL_SECTION_DEBUG critsect_debug =
@@ -552,10 +565,63 @@ static int font_cache_cmp( const struct cached_font *p1, const struct cached_fon
     return ret;
 }
 
+static void free_cached_font( struct cached_font *font )
+{
+    UINT i, j, k;
+
+    TRACE( "%p: %d bytes, %d hits, %d misses\n", font, font->size, font->hits, font->misses );
+
+    for (i = 0; i < GLYPH_NBTYPES; i++)
+    {
+        for (j = 0; j < GLYPH_CACHE_PAGES; j++)
+        {
+            if (!font->glyphs[i][j]) continue;
+            for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
+                HeapFree( GetProcessHeap(), 0, font->glyphs[i][j][k] );
+            HeapFree( GetProcessHeap(), 0, font->glyphs[i][j] );
+        }
+    }
+    InterlockedExchangeAdd( &glyph_cache_size, -font->size );
+    HeapFree( GetProcessHeap(), 0, font );
+}
+
+static LONG get_glyph_cache_budget(void)
+{
+    const char *env;
+    LONG kb = 0;
+
+    if (!glyph_cache_budget)
+    {
+        if ((env = getenv( "WINEGLYPHCACHE" ))) kb = atoi( env );
+        glyph_cache_budget = (kb > 0 && kb < 0x100000 ? kb : 8192) * 1024;
+    }
+    return glyph_cache_budget;
+}
+
+/* evict the least recently used unused fonts, called with font_cache_cs held */
+static void trim_font_cache(void)
+{
+    struct cached_font *font, *next;
+    UINT unused = 0;
+
+    /* references are only taken with the lock held, so an unused font stays unused */
+    LIST_FOR_EACH_ENTRY( font, &font_cache, struct cached_font, entry )
+        if (!font->ref) unused++;
+
+    LIST_FOR_EACH_ENTRY_SAFE_REV( font, next, &font_cache, struct cached_font, entry )
+    {
+        if (unused <= MAX_UNUSED_FONTS && glyph_cache_size <= get_glyph_cache_budget()) break;
+        if (font->ref) continue;
+        list_remove( &font->entry );
+        free_cached_font( font );
+        unused--;
+    }
+    TRACE( "%d bytes cached, %d hits, %d misses\n", glyph_cache_size, glyph_cache_hits, glyph_cache_misses );
+}
+
 static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 {
-    struct cached_font font, *ptr, *last_unused = NULL;
-    UINT i = 0, j, k;
+    struct cached_font font, *ptr;
 
     GetObjectW( hfont, sizeof(font.lf), &font.lf );
     font.xform = dc->xformWorld2Vport;
@@ -577,31 +643,12 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
         {
             InterlockedIncrement( &ptr->ref );
             list_remove( &ptr->entry );
+            list_add_head( &font_cache, &ptr->entry );
             goto done;
         }
-        if (!ptr->ref)
-        {
-            i++;
-            last_unused = ptr;
-        }
     }
 
-    if (i > 5)  /* keep at least 5 of the most-recently used fonts around */
-    {
-        ptr = last_unused;
-        for (i = 0; i < GLYPH_NBTYPES; i++)
-        {
-            for (j = 0; j < GLYPH_CACHE_PAGES; j++)
-            {
-                if (!ptr->glyphs[i][j]) continue;
-                for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
-                    HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j][k] );
-                HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j] );
-            }
-        }
-        list_remove( &ptr->entry );
-    }
-    else if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
+    if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
     {
         LeaveCriticalSection( &font_cache_cs );
         return NULL;
@@ -609,9 +656,11 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 
     *ptr = font;
     ptr->ref = 1;
+    ptr->size = ptr->hits = ptr->misses = 0;
     memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
-done:
     list_add_head( &font_cache, &ptr->entry );
+    trim_font_cache();
+done:
     LeaveCriticalSection( &font_cache_cs );
     TRACE( "%d %s -> %p\n", ptr->lf.lfHeight, debugstr_w(ptr->lf.lfFaceName), ptr );
     return ptr;
@@ -623,7 +672,7 @@ void release_cached_font( struct cached_font *font )
 }
 
 static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT index, UINT flags,
-                                              struct cached_glyph *glyph )
+                                              struct cached_glyph *glyph, DWORD size )
 {
     struct cached_glyph *ret;
     enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
@@ -644,9 +693,20 @@ static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT ind
             HeapFree( GetProcessHeap(), 0, ptr );
     }
     ret = InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page][entry], glyph, NULL );
-    if (!ret) ret = glyph;
-    else HeapFree( GetProcessHeap(), 0, glyph );
-    return ret;
+    if (ret)
+    {
+        HeapFree( GetProcessHeap(), 0, glyph );
+        return ret;
+    }
+
+    InterlockedExchangeAdd( &font->size, size );
+    if (InterlockedExchangeAdd( &glyph_cache_size, size ) + size > get_glyph_cache_budget())
+    {
+        EnterCriticalSection( &font_cache_cs );
+        trim_font_cache();
+        LeaveCriticalSection( &font_cache_cs );
+    }
+    return glyph;
 }
 
 static struct cached_glyph *get_cached_glyph( struct cached_font *font, UINT index, UINT flags )
@@ -803,14 +863,14 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
 
 done:
     glyph->metrics = metrics;
-    return add_cached_glyph( font, index, flags, glyph );
+    return add_cached_glyph( font, index, flags, glyph, FIELD_OFFSET( struct cached_glyph, bits[size] ));
 }
 
 static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT x, INT y,
                            UINT flags, const WCHAR *str, UINT count, const INT *dx,
                            const struct clipped_rects *clipped_rects, RECT *bounds )
 {
-    UINT i;
+    UINT i, misses = 0;
     struct cached_glyph *glyph;
     dib_info glyph_dib;
     DWORD text_color;
@@ -829,8 +889,11 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
 
     for (i = 0; i < count; i++)
     {
-        if (!(glyph = get_cached_glyph( font, str[i], flags )) &&
-            !(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
+        if (!(glyph = get_cached_glyph( font, str[i], flags )))
+        {
+            misses++;
+            if (!(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
+        }
 
         glyph_dib.width       = glyph->metrics.gmBlackBoxX;
         glyph_dib.height      = glyph->metrics.gmBlackBoxY;
@@ -857,6 +920,11 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
             y += glyph->metrics.gmCellIncY;
         }
     }
+
+    InterlockedExchangeAdd( &font->hits, count - misses );
+    InterlockedExchangeAdd( &font->misses, misses );
+    InterlockedExchangeAdd( &glyph_cache_hits, count - misses );
+    InterlockedExchangeAdd( &glyph_cache_misses, misses );
 }
 
 BOOL render_aa_text_bitmapinfo( DC *dc, BITMAPINFO *info, struct gdi_image_bits *bits,
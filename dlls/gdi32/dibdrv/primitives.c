@@ -25,6 +25,32 @@
 
 #include "wine/debug.h"
 
+/* SSE2 versions of the hottest 32-bpp and 16-bpp loops. Functions marked
+ * DIBDRV_SSE2 may only be called when dibdrv_cpu_has_sse2() returns TRUE,
+ * and must give the same results as the scalar code. */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+#define DIBDRV_HAVE_SSE2
+#include <emmintrin.h>
+#ifdef __i386__
+#define DIBDRV_SSE2 __attribute__((target("sse2"), force_align_arg_pointer))
+#else
+#define DIBDRV_SSE2
+#endif
+
+static inline BOOL dibdrv_cpu_has_sse2(void)
+{
+#ifdef __x86_64__
+    return TRUE;
+#else
+    static int has_sse2 = -1;
+
+    if (has_sse2 == -1) has_sse2 = IsProcessorFeaturePresent( PF_XMMI64_INSTRUCTIONS_AVAILABLE );
+    return has_sse2;
+#endif
+}
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(dib);
 
 /* Bayer matrices for dithering */
@@ -142,6 +168,30 @@ static inline void do_rop_16(WORD *ptr, WORD and, WORD xor)
     *ptr = (*ptr & and) ^ xor;
 }
 
+#ifdef DIBDRV_HAVE_SSE2
+static void DIBDRV_SSE2 do_rop_row_32_sse2( DWORD *ptr, int len, DWORD and, DWORD xor )
+{
+    const __m128i and_val = _mm_set1_epi32( and ), xor_val = _mm_set1_epi32( xor );
+    int x;
+
+    for (x = 0; x + 4 <= len; x += 4)
+        _mm_storeu_si128( (__m128i *)&ptr[x], _mm_xor_si128( _mm_and_si128(
+                          _mm_loadu_si128( (const __m128i *)&ptr[x] ), and_val ), xor_val ));
+    for ( ; x < len; x++) do_rop_32( &ptr[x], and, xor );
+}
+
+static void DIBDRV_SSE2 do_rop_row_16_sse2( WORD *ptr, int len, WORD and, WORD xor )
+{
+    const __m128i and_val = _mm_set1_epi16( and ), xor_val = _mm_set1_epi16( xor );
+    int x;
+
+    for (x = 0; x + 8 <= len; x += 8)
+        _mm_storeu_si128( (__m128i *)&ptr[x], _mm_xor_si128( _mm_and_si128(
+                          _mm_loadu_si128( (const __m128i *)&ptr[x] ), and_val ), xor_val ));
+    for ( ; x < len; x++) do_rop_16( &ptr[x], and, xor );
+}
+#endif
+
 static inline void do_rop_8(BYTE *ptr, BYTE and, BYTE xor)
 {
     *ptr = (*ptr & and) ^ xor;
@@ -274,6 +324,12 @@ static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD a
         assert( !is_rect_empty( rc ));
 
         start = get_pixel_ptr_32(dib, rc->left, rc->top);
+#ifdef DIBDRV_HAVE_SSE2
+        if (and && dibdrv_cpu_has_sse2())
+            for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
+                do_rop_row_32_sse2( start, rc->right - rc->left, and, xor );
+        else
+#endif
         if (and)
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
                 for(x = rc->left, ptr = start; x < rc->right; x++)
@@ -425,6 +481,12 @@ static void solid_rects_16(const dib_info *dib, int num, const RECT *rc, DWORD a
         assert( !is_rect_empty( rc ));
 
         start = get_pixel_ptr_16(dib, rc->left, rc->top);
+#ifdef DIBDRV_HAVE_SSE2
+        if (and && dibdrv_cpu_has_sse2())
+            for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 2)
+                do_rop_row_16_sse2( start, rc->right - rc->left, and, xor );
+        else
+#endif
         if (and)
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 2)
                 for(x = rc->left, ptr = start; x < rc->right; x++)
@@ -4651,6 +4713,96 @@ static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BL
             blend_color( dst_r, src >> 16, blend.SourceConstantAlpha ) << 16);
 }
 
+#ifdef DIBDRV_HAVE_SSE2
+/* (x + 127) / 255 for each 16-bit x <= 255 * 255 */
+static inline __m128i DIBDRV_SSE2 div255_sse2( __m128i x )
+{
+    x = _mm_add_epi16( x, _mm_set1_epi16( 128 ));
+    return _mm_srli_epi16( _mm_add_epi16( x, _mm_srli_epi16( x, 8 )), 8 );
+}
+
+/* the alpha channel of two unpacked pixels, repeated in all four channels */
+static inline __m128i DIBDRV_SSE2 expand_alpha_sse2( __m128i pixels )
+{
+    return _mm_shufflehi_epi16( _mm_shufflelo_epi16( pixels, _MM_SHUFFLE(3, 3, 3, 3) ),
+                                _MM_SHUFFLE(3, 3, 3, 3) );
+}
+
+/* Packs channel values up to 510 back to bytes. blend_argb() ORs the shifted
+ * channels together, so bit 8 of each channel ends up in bit 0 of the next one
+ * when the source isn't properly premultiplied; do the same here. */
+static inline __m128i DIBDRV_SSE2 pack_argb_sse2( __m128i lo, __m128i hi )
+{
+    const __m128i mask = _mm_set1_epi16( 0xff );
+
+    lo = _mm_or_si128( _mm_and_si128( lo, mask ), _mm_slli_epi64( _mm_srli_epi16( lo, 8 ), 16 ));
+    hi = _mm_or_si128( _mm_and_si128( hi, mask ), _mm_slli_epi64( _mm_srli_epi16( hi, 8 ), 16 ));
+    return _mm_packus_epi16( lo, hi );
+}
+
+/* blend_argb() or blend_argb_alpha() on four pixels at a time */
+static void DIBDRV_SSE2 blend_rect_8888_src_alpha_sse2( DWORD *dst_ptr, int dst_stride, const DWORD *src_ptr,
+                                                        int src_stride, int width, int height, DWORD alpha )
+{
+    const __m128i zero = _mm_setzero_si128(), max = _mm_set1_epi16( 255 );
+    const __m128i const_alpha = _mm_set1_epi16( alpha );
+    __m128i src, dst, src_lo, src_hi, dst_lo, dst_hi;
+    int x, y;
+
+    for (y = 0; y < height; y++, dst_ptr += dst_stride, src_ptr += src_stride)
+    {
+        for (x = 0; x + 4 <= width; x += 4)
+        {
+            src = _mm_loadu_si128( (const __m128i *)&src_ptr[x] );
+            dst = _mm_loadu_si128( (const __m128i *)&dst_ptr[x] );
+            src_lo = _mm_unpacklo_epi8( src, zero );
+            src_hi = _mm_unpackhi_epi8( src, zero );
+            if (alpha != 255)
+            {
+                src_lo = div255_sse2( _mm_mullo_epi16( src_lo, const_alpha ));
+                src_hi = div255_sse2( _mm_mullo_epi16( src_hi, const_alpha ));
+            }
+            dst_lo = _mm_mullo_epi16( _mm_unpacklo_epi8( dst, zero ), _mm_sub_epi16( max, expand_alpha_sse2( src_lo )));
+            dst_hi = _mm_mullo_epi16( _mm_unpackhi_epi8( dst, zero ), _mm_sub_epi16( max, expand_alpha_sse2( src_hi )));
+            dst_lo = _mm_add_epi16( src_lo, div255_sse2( dst_lo ));
+            dst_hi = _mm_add_epi16( src_hi, div255_sse2( dst_hi ));
+            _mm_storeu_si128( (__m128i *)&dst_ptr[x], pack_argb_sse2( dst_lo, dst_hi ));
+        }
+        for ( ; x < width; x++)
+            dst_ptr[x] = alpha == 255 ? blend_argb( dst_ptr[x], src_ptr[x] )
+                                      : blend_argb_alpha( dst_ptr[x], src_ptr[x], alpha );
+    }
+}
+
+/* blend_argb_constant_alpha() on four pixels at a time, src_or forces the source alpha */
+static void DIBDRV_SSE2 blend_rect_8888_const_alpha_sse2( DWORD *dst_ptr, int dst_stride, const DWORD *src_ptr,
+                                                          int src_stride, int width, int height,
+                                                          DWORD alpha, DWORD src_or )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src_alpha = _mm_set1_epi16( alpha ), dst_alpha = _mm_set1_epi16( 255 - alpha );
+    const __m128i or_val = _mm_set1_epi32( src_or );
+    __m128i src, dst, lo, hi;
+    int x, y;
+
+    for (y = 0; y < height; y++, dst_ptr += dst_stride, src_ptr += src_stride)
+    {
+        for (x = 0; x + 4 <= width; x += 4)
+        {
+            src = _mm_or_si128( _mm_loadu_si128( (const __m128i *)&src_ptr[x] ), or_val );
+            dst = _mm_loadu_si128( (const __m128i *)&dst_ptr[x] );
+            lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( src, zero ), src_alpha ),
+                                _mm_mullo_epi16( _mm_unpacklo_epi8( dst, zero ), dst_alpha ));
+            hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( src, zero ), src_alpha ),
+                                _mm_mullo_epi16( _mm_unpackhi_epi8( dst, zero ), dst_alpha ));
+            _mm_storeu_si128( (__m128i *)&dst_ptr[x], _mm_packus_epi16( div255_sse2( lo ), div255_sse2( hi )));
+        }
+        for ( ; x < width; x++)
+            dst_ptr[x] = blend_argb_constant_alpha( dst_ptr[x], src_ptr[x] | src_or, alpha );
+    }
+}
+#endif
+
 static void blend_rect_8888(const dib_info *dst, const RECT *rc,
                             const dib_info *src, const POINT *origin, BLENDFUNCTION blend)
 {
@@ -4658,6 +4810,22 @@ static void blend_rect_8888(const dib_info *dst, const RECT *rc,
     DWORD *dst_ptr = get_pixel_ptr_32( dst, rc->left, rc->top );
     int x, y;
 
+#ifdef DIBDRV_HAVE_SSE2
+    if (dibdrv_cpu_has_sse2())
+    {
+        if (blend.AlphaFormat & AC_SRC_ALPHA)
+            blend_rect_8888_src_alpha_sse2( dst_ptr, dst->stride / 4, src_ptr, src->stride / 4,
+                                            rc->right - rc->left, rc->bottom - rc->top,
+                                            blend.SourceConstantAlpha );
+        else
+            blend_rect_8888_const_alpha_sse2( dst_ptr, dst->stride / 4, src_ptr, src->stride / 4,
+                                              rc->right - rc->left, rc->bottom - rc->top,
+                                              blend.SourceConstantAlpha,
+                                              src->compression == BI_RGB ? 0 : 0xff000000 );
+        return;
+    }
+#endif
+
     if (blend.AlphaFormat & AC_SRC_ALPHA)
     {
 	if (blend.SourceConstantAlpha == 255)
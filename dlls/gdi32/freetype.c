@@ -26,9 +26,14 @@
 
 #include <stdarg.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
 #ifdef HAVE_SYS_STAT_H
 # include <sys/stat.h>
 #endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
@@ -304,6 +309,15 @@ typedef struct {
     BOOL         init;
 } GM;
 
+/* ABC widths of 256 consecutive characters or glyph indices */
+#define ABC_BLOCK_SIZE 256
+
+struct abc_block
+{
+    DWORD init[ABC_BLOCK_SIZE / 32];
+    ABC   abc[ABC_BLOCK_SIZE];
+};
+
 typedef struct {
     FLOAT eM11, eM12;
     FLOAT eM21, eM22;
@@ -398,6 +412,7 @@ struct tagGdiFont {
     unsigned int refcount;
     GM **gm;
     DWORD gmsize;
+    struct abc_block *abc[2][0x10000 / ABC_BLOCK_SIZE]; /* indexed by char and by glyph index */
     OUTLINETEXTMETRICW *potm;
     DWORD total_kern_pairs;
     KERNINGPAIR *kern_pairs;
@@ -1917,14 +1932,10 @@ static void get_family_names( FT_Face ft_face, WCHAR **name, WCHAR **english, BO
     }
 }
 
-static Family *get_family( FT_Face ft_face, BOOL vertical )
+/* takes ownership of the names */
+static Family *get_family_from_names( WCHAR *name, WCHAR *english_name )
 {
-    Family *family;
-    WCHAR *name, *english_name;
-
-    get_family_names( ft_face, &name, &english_name, vertical );
-
-    family = find_family_from_name( name );
+    Family *family = find_family_from_name( name );
 
     if (!family)
     {
@@ -2133,15 +2144,8 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const char *file,
     return face;
 }
 
-static void AddFaceToList(FT_Face ft_face, const char *file, void *font_data_ptr, DWORD font_data_size,
-                          FT_Long face_index, DWORD flags )
+static void add_face_to_family( Face *face, Family *family, DWORD flags )
 {
-    Face *face;
-    Family *family;
-
-    face = create_face( ft_face, face_index, file, font_data_ptr, font_data_size, flags );
-    family = get_family( ft_face, flags & ADDFONT_VERTICAL_FONT );
-
     if (insert_face_in_family_list( face, family ))
     {
         if (flags & ADDFONT_ADD_TO_CACHE)
@@ -2154,6 +2158,460 @@ static void AddFaceToList(FT_Face ft_face, const char *file, void *font_data_ptr
     release_family( family );
 }
 
+/* The font index remembers which faces each font file yielded during a full
+ * font scan, so that the next scan in a new session doesn't need to open
+ * unchanged files with FreeType.  It is stored in the prefix and validated
+ * against the size and modification time of each file. */
+
+#define FONT_INDEX_MAGIC   0x58444e49 /* "INDX" */
+#define FONT_INDEX_VERSION 1
+
+struct font_index_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD ft_version;   /* FT_SimpleVersion the index was built with */
+    DWORD langid;       /* face names are localized */
+    DWORD count;        /* number of font_index_file records */
+    DWORD size;         /* total size of the index */
+};
+
+struct font_index_file
+{
+    DWORD     size;         /* size of the record, including path and faces */
+    DWORD     path_len;     /* including the terminating null */
+    DWORD     allow_bitmap;
+    DWORD     num_faces;
+    INT       result;       /* AddFontToList return value */
+    DWORD     reserved;
+    ULONGLONG file_size;
+    ULONGLONG mtime;
+    /* followed by the path and the face records, 8-byte aligned */
+};
+
+struct font_index_face
+{
+    DWORD         size;         /* size of the record, including strings */
+    DWORD         vertical;
+    LONG          face_index;
+    DWORD         ntm_flags;
+    LONGLONG      font_version;
+    FONTSIGNATURE fs;
+    DWORD         scalable;
+    LONG          height;
+    LONG          width;
+    LONG          internal_leading;
+    LONGLONG      bitmap_size;
+    LONGLONG      x_ppem;
+    LONGLONG      y_ppem;
+    WORD          name_len[4];  /* family, English family, style and full name lengths, 0 if NULL */
+    /* followed by the null-terminated strings */
+};
+
+static BOOL font_index_active;
+static void *font_index_view;
+static size_t font_index_view_size;
+static const struct font_index_file **font_index_table;
+static BYTE *font_index_used;
+static DWORD font_index_table_size;
+static BYTE *font_index_data;     /* records added by this scan */
+static DWORD font_index_data_size;
+static DWORD font_index_data_alloc;
+static DWORD font_index_count;
+static DWORD font_index_entry;    /* offset of the record being built */
+static BOOL font_index_failed;
+
+static inline DWORD font_index_align( DWORD size )
+{
+    return (size + 7) & ~7;
+}
+
+static DWORD font_index_hash( const char *path )
+{
+    DWORD hash = 2166136261u;
+    while (*path) hash = (hash ^ (BYTE)*path++) * 16777619;
+    return hash;
+}
+
+static char *get_font_index_path( const char *suffix )
+{
+    const char *dir = wine_get_config_dir();
+    char *path;
+
+    if (!dir || !(path = HeapAlloc( GetProcessHeap(), 0, strlen(dir) + strlen(suffix) + sizeof("/fontindex") )))
+        return NULL;
+    strcpy( path, dir );
+    strcat( path, "/fontindex" );
+    strcat( path, suffix );
+    return path;
+}
+
+static void load_font_index(void)
+{
+    const char *env = getenv( "WINEFONTINDEX" );
+    const struct font_index_header *header;
+    const struct font_index_file *file;
+    const BYTE *ptr, *end;
+    struct stat st;
+    DWORD i, slot;
+    char *path;
+    void *view;
+    int fd;
+
+    if (env && !strcmp( env, "0" )) return;
+    font_index_active = TRUE;
+
+    if (!(path = get_font_index_path( "" ))) return;
+    fd = open( path, O_RDONLY );
+    HeapFree( GetProcessHeap(), 0, path );
+    if (fd == -1) return;
+
+    if (fstat( fd, &st ) || st.st_size < sizeof(*header) || st.st_size > 0x10000000)
+    {
+        close( fd );
+        return;
+    }
+    view = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (view == MAP_FAILED) return;
+
+    header = view;
+    if (header->magic != FONT_INDEX_MAGIC || header->version != FONT_INDEX_VERSION ||
+        header->ft_version != FT_SimpleVersion || header->langid != GetSystemDefaultLangID() ||
+        header->size != st.st_size || header->count > st.st_size / sizeof(*file))
+    {
+        TRACE( "discarding outdated font index\n" );
+        munmap( view, st.st_size );
+        return;
+    }
+
+    font_index_table_size = 16;
+    while (font_index_table_size < header->count * 2) font_index_table_size *= 2;
+    font_index_table = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                  font_index_table_size * sizeof(*font_index_table) );
+    font_index_used = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, font_index_table_size );
+    if (!font_index_table || !font_index_used)
+    {
+        HeapFree( GetProcessHeap(), 0, font_index_table );
+        HeapFree( GetProcessHeap(), 0, font_index_used );
+        font_index_table = NULL;
+        font_index_used = NULL;
+        munmap( view, st.st_size );
+        return;
+    }
+    font_index_view = view;
+    font_index_view_size = st.st_size;
+
+    ptr = (const BYTE *)(header + 1);
+    end = (const BYTE *)view + st.st_size;
+    for (i = 0; i < header->count; i++)
+    {
+        file = (const struct font_index_file *)ptr;
+        if (end - ptr < sizeof(*file) || file->size > end - ptr || file->size % 8 || !file->path_len ||
+            file->size < font_index_align( sizeof(*file) + file->path_len ) ||
+            ((const char *)(file + 1))[file->path_len - 1])
+        {
+            WARN( "corrupted font index\n" );
+            break;
+        }
+        slot = font_index_hash( (const char *)(file + 1) ) & (font_index_table_size - 1);
+        while (font_index_table[slot]) slot = (slot + 1) & (font_index_table_size - 1);
+        font_index_table[slot] = file;
+        ptr += file->size;
+    }
+    TRACE( "loaded %u files from the font index\n", i );
+}
+
+static const struct font_index_file *find_font_index_file( const char *path, const struct stat *st,
+                                                           BOOL allow_bitmap )
+{
+    const struct font_index_file *file;
+    DWORD slot;
+
+    if (!font_index_table) return NULL;
+
+    slot = font_index_hash( path ) & (font_index_table_size - 1);
+    for ( ; (file = font_index_table[slot]); slot = (slot + 1) & (font_index_table_size - 1))
+    {
+        if (strcmp( (const char *)(file + 1), path ) || file->allow_bitmap != allow_bitmap) continue;
+        if (file->file_size != st->st_size || file->mtime != st->st_mtime) return NULL;
+        font_index_used[slot] = TRUE;
+        return file;
+    }
+    return NULL;
+}
+
+static WCHAR *get_font_index_string( const WCHAR **str, WORD len )
+{
+    WCHAR *ret;
+
+    if (!len) return NULL;
+    if ((ret = HeapAlloc( GetProcessHeap(), 0, len * sizeof(WCHAR) )))
+    {
+        memcpy( ret, *str, (len - 1) * sizeof(WCHAR) );
+        ret[len - 1] = 0;
+    }
+    *str += len;
+    return ret;
+}
+
+static INT add_faces_from_index( const struct font_index_file *file, const char *path,
+                                 const struct stat *st, DWORD flags )
+{
+    const BYTE *ptr = (const BYTE *)file + font_index_align( sizeof(*file) + file->path_len );
+    const BYTE *end = (const BYTE *)file + file->size;
+    const struct font_index_face *rec;
+    const WCHAR *str;
+    WCHAR *name, *english_name;
+    DWORD i, face_flags;
+    Face *face;
+
+    TRACE( "using indexed faces for %s\n", debugstr_a(path) );
+
+    for (i = 0; i < file->num_faces; i++, ptr += rec->size)
+    {
+        rec = (const struct font_index_face *)ptr;
+        if (end - ptr < sizeof(*rec) || rec->size > end - ptr || rec->size % 8 || !rec->name_len[0] ||
+            rec->size < sizeof(*rec) + (rec->name_len[0] + rec->name_len[1] + rec->name_len[2] +
+                                        rec->name_len[3]) * sizeof(WCHAR))
+        {
+            WARN( "corrupted font index entry for %s\n", debugstr_a(path) );
+            break;
+        }
+
+        face_flags = flags;
+        if (rec->vertical) face_flags |= ADDFONT_VERTICAL_FONT;
+
+        face = HeapAlloc( GetProcessHeap(), 0, sizeof(*face) );
+        face->refcount = 1;
+        str = (const WCHAR *)(rec + 1);
+        name = get_font_index_string( &str, rec->name_len[0] );
+        english_name = get_font_index_string( &str, rec->name_len[1] );
+        face->StyleName = get_font_index_string( &str, rec->name_len[2] );
+        face->FullName = get_font_index_string( &str, rec->name_len[3] );
+        face->file = towstr( CP_UNIXCP, path );
+        face->dev = st->st_dev;
+        face->ino = st->st_ino;
+        face->font_data_ptr = NULL;
+        face->font_data_size = 0;
+        face->face_index = rec->face_index;
+        face->fs = rec->fs;
+        face->ntmFlags = rec->ntm_flags;
+        face->font_version = rec->font_version;
+        face->scalable = rec->scalable;
+        face->size.height = rec->height;
+        face->size.width = rec->width;
+        face->size.size = rec->bitmap_size;
+        face->size.x_ppem = rec->x_ppem;
+        face->size.y_ppem = rec->y_ppem;
+        face->size.internal_leading = rec->internal_leading;
+        face->flags = face_flags;
+        if (!HIWORD( face->flags )) face->flags |= ADDFONT_AA_FLAGS( default_aa_flags );
+        face->family = NULL;
+        face->cached_enum_data = NULL;
+
+        add_face_to_family( face, get_family_from_names( name, english_name ), face_flags );
+    }
+    return file->result;
+}
+
+static BOOL append_font_index( const void *data, DWORD size )
+{
+    DWORD alloc = font_index_data_alloc;
+    BYTE *new_data;
+
+    if (font_index_failed) return FALSE;
+    if (font_index_data_size + size > alloc)
+    {
+        if (!alloc) alloc = 0x10000;
+        while (font_index_data_size + size > alloc) alloc *= 2;
+        if (font_index_data) new_data = HeapReAlloc( GetProcessHeap(), 0, font_index_data, alloc );
+        else new_data = HeapAlloc( GetProcessHeap(), 0, alloc );
+        if (!new_data)
+        {
+            font_index_failed = TRUE;
+            return FALSE;
+        }
+        font_index_data = new_data;
+        font_index_data_alloc = alloc;
+    }
+    if (data) memcpy( font_index_data + font_index_data_size, data, size );
+    else memset( font_index_data + font_index_data_size, 0, size );
+    font_index_data_size += size;
+    return TRUE;
+}
+
+static BOOL begin_font_index_file( const char *path, const struct stat *st, BOOL allow_bitmap )
+{
+    struct font_index_file file;
+    DWORD len = strlen( path ) + 1;
+
+    if (!font_index_active) return FALSE;
+
+    memset( &file, 0, sizeof(file) );
+    file.path_len = len;
+    file.allow_bitmap = allow_bitmap;
+    file.file_size = st->st_size;
+    file.mtime = st->st_mtime;
+
+    font_index_entry = font_index_data_size;
+    font_index_failed = FALSE;
+    append_font_index( &file, sizeof(file) );
+    append_font_index( path, len );
+    append_font_index( NULL, font_index_align( sizeof(file) + len ) - sizeof(file) - len );
+    return TRUE;
+}
+
+static void add_face_to_index( const Face *face, const WCHAR *name, const WCHAR *english_name )
+{
+    const WCHAR *strings[4];
+    struct font_index_face rec;
+    DWORD i, size;
+
+    strings[0] = name;
+    strings[1] = english_name;
+    strings[2] = face->StyleName;
+    strings[3] = face->FullName;
+
+    memset( &rec, 0, sizeof(rec) );
+    size = sizeof(rec);
+    for (i = 0; i < 4; i++)
+    {
+        if (!strings[i]) continue;
+        if (strlenW( strings[i] ) >= 0xffff) font_index_failed = TRUE;
+        rec.name_len[i] = strlenW( strings[i] ) + 1;
+        size += rec.name_len[i] * sizeof(WCHAR);
+    }
+    rec.size = font_index_align( size );
+    rec.vertical = !!(face->flags & ADDFONT_VERTICAL_FONT);
+    rec.face_index = face->face_index;
+    rec.ntm_flags = face->ntmFlags;
+    rec.font_version = face->font_version;
+    rec.fs = face->fs;
+    rec.scalable = face->scalable;
+    rec.height = face->size.height;
+    rec.width = face->size.width;
+    rec.internal_leading = face->size.internal_leading;
+    rec.bitmap_size = face->size.size;
+    rec.x_ppem = face->size.x_ppem;
+    rec.y_ppem = face->size.y_ppem;
+
+    append_font_index( &rec, sizeof(rec) );
+    for (i = 0; i < 4; i++)
+        if (strings[i]) append_font_index( strings[i], rec.name_len[i] * sizeof(WCHAR) );
+    append_font_index( NULL, rec.size - size );
+    if (!font_index_failed) ((struct font_index_file *)(font_index_data + font_index_entry))->num_faces++;
+}
+
+static void end_font_index_file( INT result )
+{
+    struct font_index_file *file;
+
+    if (font_index_failed)
+    {
+        font_index_data_size = font_index_entry;
+        return;
+    }
+    file = (struct font_index_file *)(font_index_data + font_index_entry);
+    file->size = font_index_data_size - font_index_entry;
+    file->result = result;
+    font_index_count++;
+}
+
+static BOOL write_font_index( int fd, const void *data, size_t size )
+{
+    const char *ptr = data;
+    ssize_t ret;
+
+    while (size)
+    {
+        if ((ret = write( fd, ptr, size )) < 0)
+        {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        ptr += ret;
+        size -= ret;
+    }
+    return TRUE;
+}
+
+/* write the index back if anything changed and release it */
+static void save_font_index(void)
+{
+    struct font_index_header header;
+    const struct font_index_file *file;
+    BOOL changed = font_index_count > 0, ok;
+    char *path = NULL, *tmp = NULL;
+    DWORD i;
+    int fd;
+
+    if (!font_index_active) return;
+
+    header.magic = FONT_INDEX_MAGIC;
+    header.version = FONT_INDEX_VERSION;
+    header.ft_version = FT_SimpleVersion;
+    header.langid = GetSystemDefaultLangID();
+    header.count = font_index_count;
+    header.size = sizeof(header) + font_index_data_size;
+
+    /* files that weren't seen again are dropped */
+    for (i = 0; i < font_index_table_size; i++)
+    {
+        if (!(file = font_index_table[i])) continue;
+        if (!font_index_used[i]) changed = TRUE;
+        else
+        {
+            header.count++;
+            header.size += file->size;
+        }
+    }
+
+    if (changed && (path = get_font_index_path( "" )) && (tmp = get_font_index_path( ".tmp" )))
+    {
+        if ((fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) != -1)
+        {
+            ok = write_font_index( fd, &header, sizeof(header) );
+            for (i = 0; ok && i < font_index_table_size; i++)
+                if ((file = font_index_table[i]) && font_index_used[i])
+                    ok = write_font_index( fd, file, file->size );
+            if (ok) ok = write_font_index( fd, font_index_data, font_index_data_size );
+            close( fd );
+            if (!ok || rename( tmp, path ))
+            {
+                WARN( "failed to write the font index\n" );
+                unlink( tmp );
+            }
+            else TRACE( "wrote %u files to the font index\n", header.count );
+        }
+    }
+    HeapFree( GetProcessHeap(), 0, path );
+    HeapFree( GetProcessHeap(), 0, tmp );
+
+    if (font_index_view) munmap( font_index_view, font_index_view_size );
+    HeapFree( GetProcessHeap(), 0, font_index_table );
+    HeapFree( GetProcessHeap(), 0, font_index_used );
+    HeapFree( GetProcessHeap(), 0, font_index_data );
+    font_index_view = NULL;
+    font_index_table = NULL;
+    font_index_used = NULL;
+    font_index_data = NULL;
+    font_index_data_size = font_index_data_alloc = font_index_count = 0;
+    font_index_active = FALSE;
+}
+
+static void AddFaceToList(FT_Face ft_face, const char *file, void *font_data_ptr, DWORD font_data_size,
+                          FT_Long face_index, DWORD flags, BOOL add_to_index )
+{
+    Face *face;
+    WCHAR *name, *english_name;
+
+    face = create_face( ft_face, face_index, file, font_data_ptr, font_data_size, flags );
+    get_family_names( ft_face, &name, &english_name, flags & ADDFONT_VERTICAL_FONT );
+    if (add_to_index) add_face_to_index( face, name, english_name );
+    add_face_to_family( face, get_family_from_names( name, english_name ), flags );
+}
+
 static FT_Face new_ft_face( const char *file, void *font_data_ptr, DWORD font_data_size,
                             FT_Long face_index, BOOL allow_bitmap )
 {
@@ -2235,6 +2693,8 @@ static INT AddFontToList(const char *file, void *font_data_ptr, DWORD font_data_
     FT_Face ft_face;
     FT_Long face_index = 0, num_faces;
     INT ret = 0;
+    BOOL add_to_index = FALSE;
+    struct stat st;
 
     /* we always load external fonts from files - otherwise we would get a crash in update_reg_entries */
     assert(file || !(flags & ADDFONT_EXTERNAL_FONT));
@@ -2260,34 +2720,50 @@ static INT AddFontToList(const char *file, void *font_data_ptr, DWORD font_data_
     }
 #endif /* HAVE_CARBON_CARBON_H */
 
+    if (file && font_index_active && !stat( file, &st ))
+    {
+        const struct font_index_file *indexed;
+
+        if ((indexed = find_font_index_file( file, &st, !!(flags & ADDFONT_ALLOW_BITMAP) )))
+            return add_faces_from_index( indexed, file, &st, flags );
+        add_to_index = begin_font_index_file( file, &st, !!(flags & ADDFONT_ALLOW_BITMAP) );
+    }
+
     do {
         const DWORD FS_DBCS_MASK = FS_JISJAPAN|FS_CHINESESIMP|FS_WANSUNG|FS_CHINESETRAD|FS_JOHAB;
         FONTSIGNATURE fs;
 
         ft_face = new_ft_face( file, font_data_ptr, font_data_size, face_index, flags & ADDFONT_ALLOW_BITMAP );
-        if (!ft_face) return 0;
+        if (!ft_face)
+        {
+            ret = 0;
+            break;
+        }
 
         if(ft_face->family_name[0] == '.') /* Ignore fonts with names beginning with a dot */
         {
             TRACE("Ignoring %s since its family name begins with a dot\n", debugstr_a(file));
             pFT_Done_Face(ft_face);
-            return 0;
+            ret = 0;
+            break;
         }
 
-        AddFaceToList(ft_face, file, font_data_ptr, font_data_size, face_index, flags);
+        AddFaceToList(ft_face, file, font_data_ptr, font_data_size, face_index, flags, add_to_index);
         ++ret;
 
         get_fontsig(ft_face, &fs);
         if (fs.fsCsb[0] & FS_DBCS_MASK)
         {
             AddFaceToList(ft_face, file, font_data_ptr, font_data_size, face_index,
-                          flags | ADDFONT_VERTICAL_FONT);
+                          flags | ADDFONT_VERTICAL_FONT, add_to_index);
             ++ret;
         }
 
 	num_faces = ft_face->num_faces;
 	pFT_Done_Face(ft_face);
     } while(num_faces > ++face_index);
+
+    if (add_to_index) end_font_index_file( ret );
     return ret;
 }
 
@@ -4181,6 +4657,7 @@ static void init_font_list(void)
     char *unixname;
 
     delete_external_font_keys();
+    load_font_index();
 
     /* load the system bitmap fonts */
     load_system_fonts();
@@ -4306,6 +4783,8 @@ static void init_font_list(void)
         }
         RegCloseKey(hkey);
     }
+
+    save_font_index();
 }
 
 static BOOL move_to_front(const WCHAR *name)
@@ -4673,6 +5152,11 @@ static void free_font(GdiFont *font)
     for (i = 0; i < font->gmsize; i++)
         HeapFree(GetProcessHeap(),0,font->gm[i]);
     HeapFree(GetProcessHeap(), 0, font->gm);
+    for (i = 0; i < 0x10000 / ABC_BLOCK_SIZE; i++)
+    {
+        HeapFree(GetProcessHeap(), 0, font->abc[0][i]);
+        HeapFree(GetProcessHeap(), 0, font->abc[1][i]);
+    }
     HeapFree(GetProcessHeap(), 0, font->GSUB_Table);
     HeapFree(GetProcessHeap(), 0, font);
 }
@@ -8129,14 +8613,47 @@ done:
     return FALSE;
 }
 
+/* get the unrotated ABC widths of a char or glyph index through the dense
+ * per-font tables, which are filled lazily; freetype_cs must be held */
+static void get_char_abc( GdiFont *font, UINT c, BOOL glyph_index, ABC *abc )
+{
+    static const MAT2 identity = { {0,1},{0,0},{0,0},{0,1} };
+    UINT format = glyph_index ? GGO_METRICS | GGO_GLYPH_INDEX : GGO_METRICS;
+    struct abc_block *block;
+    GLYPHMETRICS gm;
+    UINT idx;
+
+    if (c >= 0x10000)
+    {
+        get_glyph_outline( font, c, format, &gm, abc, 0, NULL, &identity );
+        return;
+    }
+
+    if (!(block = font->abc[glyph_index][c / ABC_BLOCK_SIZE]))
+    {
+        if (!(block = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*block) )))
+        {
+            get_glyph_outline( font, c, format, &gm, abc, 0, NULL, &identity );
+            return;
+        }
+        font->abc[glyph_index][c / ABC_BLOCK_SIZE] = block;
+    }
+
+    idx = c % ABC_BLOCK_SIZE;
+    if (!(block->init[idx / 32] & (1u << (idx % 32))))
+    {
+        get_glyph_outline( font, c, format, &gm, &block->abc[idx], 0, NULL, &identity );
+        block->init[idx / 32] |= 1u << (idx % 32);
+    }
+    *abc = block->abc[idx];
+}
+
 /*************************************************************
  * freetype_GetCharWidth
  */
 static BOOL freetype_GetCharWidth( PHYSDEV dev, UINT firstChar, UINT lastChar, LPINT buffer )
 {
-    static const MAT2 identity = { {0,1},{0,0},{0,0},{0,1} };
     UINT c;
-    GLYPHMETRICS gm;
     ABC abc;
     struct freetype_physdev *physdev = get_freetype_dev( dev );
 
@@ -8151,7 +8668,7 @@ static BOOL freetype_GetCharWidth( PHYSDEV dev, UINT firstChar, UINT lastChar, L
     GDI_CheckNotLock();
     EnterCriticalSection( &freetype_cs );
     for(c = firstChar; c <= lastChar; c++) {
-        get_glyph_outline( physdev->font, c, GGO_METRICS, &gm, &abc, 0, NULL, &identity );
+        get_char_abc( physdev->font, c, FALSE, &abc );
         buffer[c - firstChar] = abc.abcA + abc.abcB + abc.abcC;
     }
     LeaveCriticalSection( &freetype_cs );
@@ -8163,9 +8680,7 @@ static BOOL freetype_GetCharWidth( PHYSDEV dev, UINT firstChar, UINT lastChar, L
  */
 static BOOL freetype_GetCharABCWidths( PHYSDEV dev, UINT firstChar, UINT lastChar, LPABC buffer )
 {
-    static const MAT2 identity = { {0,1},{0,0},{0,0},{0,1} };
     UINT c;
-    GLYPHMETRICS gm;
     struct freetype_physdev *physdev = get_freetype_dev( dev );
 
     if (!physdev->font)
@@ -8180,7 +8695,7 @@ static BOOL freetype_GetCharABCWidths( PHYSDEV dev, UINT firstChar, UINT lastCha
     EnterCriticalSection( &freetype_cs );
 
     for(c = firstChar; c <= lastChar; c++, buffer++)
-        get_glyph_outline( physdev->font, c, GGO_METRICS, &gm, buffer, 0, NULL, &identity );
+        get_char_abc( physdev->font, c, FALSE, buffer );
 
     LeaveCriticalSection( &freetype_cs );
     return TRUE;
@@ -8191,9 +8706,7 @@ static BOOL freetype_GetCharABCWidths( PHYSDEV dev, UINT firstChar, UINT lastCha
  */
 static BOOL freetype_GetCharABCWidthsI( PHYSDEV dev, UINT firstChar, UINT count, LPWORD pgi, LPABC buffer )
 {
-    static const MAT2 identity = { {0,1},{0,0},{0,0},{0,1} };
     UINT c;
-    GLYPHMETRICS gm;
     struct freetype_physdev *physdev = get_freetype_dev( dev );
 
     if (!physdev->font)
@@ -8209,8 +8722,7 @@ static BOOL freetype_GetCharABCWidthsI( PHYSDEV dev, UINT firstChar, UINT count,
     EnterCriticalSection( &freetype_cs );
 
     for(c = 0; c < count; c++, buffer++)
-        get_glyph_outline( physdev->font, pgi ? pgi[c] : firstChar + c, GGO_METRICS | GGO_GLYPH_INDEX,
-                           &gm, buffer, 0, NULL, &identity );
+        get_char_abc( physdev->font, pgi ? pgi[c] : firstChar + c, TRUE, buffer );
 
     LeaveCriticalSection( &freetype_cs );
     return TRUE;
@@ -8221,10 +8733,8 @@ static BOOL freetype_GetCharABCWidthsI( PHYSDEV dev, UINT firstChar, UINT count,
  */
 static BOOL freetype_GetTextExtentExPoint( PHYSDEV dev, LPCWSTR wstr, INT count, LPINT dxs )
 {
-    static const MAT2 identity = { {0,1},{0,0},{0,0},{0,1} };
     INT idx, pos;
     ABC abc;
-    GLYPHMETRICS gm;
     struct freetype_physdev *physdev = get_freetype_dev( dev );
 
     if (!physdev->font)
@@ -8240,7 +8750,7 @@ static BOOL freetype_GetTextExtentExPoint( PHYSDEV dev, LPCWSTR wstr, INT count,
 
     for (idx = pos = 0; idx < count; idx++)
     {
-        get_glyph_outline( physdev->font, wstr[idx], GGO_METRICS, &gm, &abc, 0, NULL, &identity );
+        get_char_abc( physdev->font, wstr[idx], FALSE, &abc );
         pos += abc.abcA + abc.abcB + abc.abcC;
         dxs[idx] = pos;
     }
@@ -8254,10 +8764,8 @@ static BOOL freetype_GetTextExtentExPoint( PHYSDEV dev, LPCWSTR wstr, INT count,
  */
 static BOOL freetype_GetTextExtentExPointI( PHYSDEV dev, const WORD *indices, INT count, LPINT dxs )
 {
-    static const MAT2 identity = { {0,1},{0,0},{0,0},{0,1} };
     INT idx, pos;
     ABC abc;
-    GLYPHMETRICS gm;
     struct freetype_physdev *physdev = get_freetype_dev( dev );
 
     if (!physdev->font)
@@ -8273,8 +8781,7 @@ static BOOL freetype_GetTextExtentExPointI( PHYSDEV dev, const WORD *indices, IN
 
     for (idx = pos = 0; idx < count; idx++)
     {
-        get_glyph_outline( physdev->font, indices[idx], GGO_METRICS | GGO_GLYPH_INDEX,
-                           &gm, &abc, 0, NULL, &identity );
+        get_char_abc( physdev->font, indices[idx], TRUE, &abc );
         pos += abc.abcA + abc.abcB + abc.abcC;
         dxs[idx] = pos;
     }
@@ -125,15 +125,65 @@ static inline BOOL overlapping( const RECT *r1, const RECT *r2 )
             r1->bottom > r2->top && r1->top < r2->bottom);
 }
 
+/* Rectangle arrays with a power of two size are recycled through lock-free
+ * lists instead of going back to the heap, since clip regions are rebuilt
+ * for every paint and most operations allocate a new array. */
+#define RECT_POOL_MIN_SHIFT 3
+#define RECT_POOL_MAX_SHIFT 10
+#define RECT_POOL_DEPTH     16
+
+static SLIST_HEADER rect_pool[RECT_POOL_MAX_SHIFT - RECT_POOL_MIN_SHIFT + 1];
+
+static int get_rect_pool_index( INT size )
+{
+    int shift;
+
+    for (shift = RECT_POOL_MIN_SHIFT; shift <= RECT_POOL_MAX_SHIFT; shift++)
+        if (size == 1 << shift) return shift - RECT_POOL_MIN_SHIFT;
+    return -1;
+}
+
+/* round a requested array size up to the next pooled size */
+static INT get_rect_pool_size( INT size )
+{
+    INT pool_size = 1 << RECT_POOL_MIN_SHIFT;
+
+    if (size > 1 << RECT_POOL_MAX_SHIFT) return size;
+    while (pool_size < size) pool_size *= 2;
+    return pool_size;
+}
+
+static RECT *alloc_rects( INT size )
+{
+    int index = get_rect_pool_index( size );
+    RECT *rects;
+
+    if (index >= 0 && (rects = (RECT *)InterlockedPopEntrySList( &rect_pool[index] ))) return rects;
+    return HeapAlloc( GetProcessHeap(), 0, size * sizeof(RECT) );
+}
+
+static void free_rects( RECT *rects, INT size )
+{
+    int index;
+
+    if (!rects) return;
+    index = get_rect_pool_index( size );
+    if (index >= 0 && QueryDepthSList( &rect_pool[index] ) < RECT_POOL_DEPTH)
+        InterlockedPushEntrySList( &rect_pool[index], (SLIST_ENTRY *)rects );
+    else
+        HeapFree( GetProcessHeap(), 0, rects );
+}
+
 static BOOL grow_region( WINEREGION *rgn, int size )
 {
     RECT *new_rects;
 
     if (size <= rgn->size) return TRUE;
 
+    size = get_rect_pool_size( size );
     if (rgn->rects == rgn->rects_buf)
     {
-        new_rects = HeapAlloc( GetProcessHeap(), 0, size * sizeof(RECT) );
+        new_rects = alloc_rects( size );
         if (!new_rects) return FALSE;
         memcpy( new_rects, rgn->rects, rgn->numRects * sizeof(RECT) );
     }
@@ -452,7 +502,8 @@ static BOOL init_region( WINEREGION *pReg, INT n )
 
     if (n > RGN_DEFAULT_RECTS)
     {
-        if (!(pReg->rects = HeapAlloc( GetProcessHeap(), 0, n * sizeof( RECT ) )))
+        n = get_rect_pool_size( n );
+        if (!(pReg->rects = alloc_rects( n )))
             return FALSE;
     }
     else
@@ -469,7 +520,7 @@ static BOOL init_region( WINEREGION *pReg, INT n )
 static void destroy_region( WINEREGION *pReg )
 {
     if (pReg->rects != pReg->rects_buf)
-        HeapFree( GetProcessHeap(), 0, pReg->rects );
+        free_rects( pReg->rects, pReg->size );
 }
 
 /***********************************************************************
@@ -1643,11 +1694,12 @@ static void REGION_compact( WINEREGION *reg )
 {
     if ((reg->numRects < reg->size / 2) && (reg->numRects > RGN_DEFAULT_RECTS))
     {
-        RECT *new_rects = HeapReAlloc( GetProcessHeap(), 0, reg->rects, reg->numRects * sizeof(RECT) );
+        INT size = get_rect_pool_size( reg->numRects );
+        RECT *new_rects = HeapReAlloc( GetProcessHeap(), 0, reg->rects, size * sizeof(RECT) );
         if (new_rects)
         {
             reg->rects = new_rects;
-            reg->size = reg->numRects;
+            reg->size = size;
         }
     }
 }
@@ -1960,6 +2012,20 @@ static BOOL REGION_IntersectO(WINEREGION *pReg,  RECT *r1, RECT *r1End,
     return TRUE;
 }
 
+/***********************************************************************
+ *	     contains_region
+ *
+ * Check if a single rectangle region covers the whole of another region.
+ */
+static inline BOOL contains_region( const WINEREGION *rect, const WINEREGION *reg )
+{
+    return (rect->numRects == 1 &&
+            rect->extents.left <= reg->extents.left &&
+            rect->extents.top <= reg->extents.top &&
+            rect->extents.right >= reg->extents.right &&
+            rect->extents.bottom >= reg->extents.bottom);
+}
+
 /***********************************************************************
  *	     REGION_IntersectRegion
  */
@@ -1970,6 +2036,24 @@ static BOOL REGION_IntersectRegion(WINEREGION *newReg, WINEREGION *reg1,
     if ( (!(reg1->numRects)) || (!(reg2->numRects))  ||
 	(!overlapping(&reg1->extents, &reg2->extents)))
 	newReg->numRects = 0;
+    /* clipping against a rectangle that covers the other region */
+    else if (contains_region( reg1, reg2 ))
+        return REGION_CopyRegion( newReg, reg2 );
+    else if (contains_region( reg2, reg1 ))
+        return REGION_CopyRegion( newReg, reg1 );
+    /* two overlapping rectangles */
+    else if (reg1->numRects == 1 && reg2->numRects == 1)
+    {
+        RECT rect;
+
+        rect.left = max( reg1->extents.left, reg2->extents.left );
+        rect.top = max( reg1->extents.top, reg2->extents.top );
+        rect.right = min( reg1->extents.right, reg2->extents.right );
+        rect.bottom = min( reg1->extents.bottom, reg2->extents.bottom );
+        newReg->rects[0] = newReg->extents = rect;
+        newReg->numRects = 1;
+        return TRUE;
+    }
     else
 	if (!REGION_RegionOp (newReg, reg1, reg2, REGION_IntersectO, NULL, NULL)) return FALSE;
 
@@ -2104,11 +2188,7 @@ static BOOL REGION_UnionRegion(WINEREGION *newReg, WINEREGION *reg1, WINEREGION
     /*
      * Region 1 completely subsumes region 2
      */
-    if ((reg1->numRects == 1) &&
-	(reg1->extents.left <= reg2->extents.left) &&
-	(reg1->extents.top <= reg2->extents.top) &&
-	(reg1->extents.right >= reg2->extents.right) &&
-	(reg1->extents.bottom >= reg2->extents.bottom))
+    if (contains_region( reg1, reg2 ))
     {
 	if (newReg != reg1)
 	    ret = REGION_CopyRegion(newReg, reg1);
@@ -2118,11 +2198,7 @@ static BOOL REGION_UnionRegion(WINEREGION *newReg, WINEREGION *reg1, WINEREGION
     /*
      * Region 2 completely subsumes region 1
      */
-    if ((reg2->numRects == 1) &&
-	(reg2->extents.left <= reg1->extents.left) &&
-	(reg2->extents.top <= reg1->extents.top) &&
-	(reg2->extents.right >= reg1->extents.right) &&
-	(reg2->extents.bottom >= reg1->extents.bottom))
+    if (contains_region( reg2, reg1 ))
     {
 	if (newReg != reg2)
 	    ret = REGION_CopyRegion(newReg, reg2);
@@ -2294,6 +2370,13 @@ static BOOL REGION_SubtractRegion(WINEREGION *regD, WINEREGION *regM, WINEREGION
 	(!overlapping(&regM->extents, &regS->extents)) )
 	return REGION_CopyRegion(regD, regM);
 
+    /* the subtrahend is a rectangle covering the whole region */
+    if (contains_region( regS, regM ))
+    {
+        empty_region( regD );
+        return TRUE;
+    }
+
     if (!REGION_RegionOp (regD, regM, regS, REGION_SubtractO, REGION_SubtractNonO1, NULL))
         return FALSE;
 
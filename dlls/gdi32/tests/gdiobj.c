@@ -319,6 +319,90 @@ static void test_region(void)
     DeleteObject(hrgn);
 }
 
+static void check_region_rects( HRGN hrgn, const RECT *expect, DWORD count, int line )
+{
+    char buffer[sizeof(RGNDATAHEADER) + 8 * sizeof(RECT)];
+    RGNDATA *data = (RGNDATA *)buffer;
+    const RECT *rects = (const RECT *)data->Buffer;
+    DWORD i, size;
+
+    size = GetRegionData( hrgn, sizeof(buffer), data );
+    ok_(__FILE__, line)( size == sizeof(RGNDATAHEADER) + count * sizeof(RECT), "got size %u\n", size );
+    ok_(__FILE__, line)( data->rdh.nCount == count, "got %u rects, expected %u\n", data->rdh.nCount, count );
+    for (i = 0; i < count && i < data->rdh.nCount; i++)
+        ok_(__FILE__, line)( EqualRect( &rects[i], &expect[i] ), "rect %u: got %s, expected %s\n", i,
+                             wine_dbgstr_rect( &rects[i] ), wine_dbgstr_rect( &expect[i] ));
+}
+
+static void test_CombineRgn(void)
+{
+    static const RECT overlap[] = { { 0, 0, 100, 50 }, { 0, 50, 50, 100 } };
+    static const RECT single[] = { { 20, 20, 30, 30 } };
+    HRGN hrgn, hrgn2, hrgn3, windows[32];
+    RECT rc;
+    int i, j, ret;
+
+    /* window partially covered by another one */
+    hrgn = CreateRectRgn( 0, 0, 100, 100 );
+    hrgn2 = CreateRectRgn( 50, 50, 150, 150 );
+    ret = CombineRgn( hrgn, hrgn, hrgn2, RGN_DIFF );
+    ok( ret == COMPLEXREGION, "got %d\n", ret );
+    check_region_rects( hrgn, overlap, 2, __LINE__ );
+
+    /* clipping to a rectangle that contains the region */
+    SetRectRgn( hrgn2, -10, -10, 200, 200 );
+    ret = CombineRgn( hrgn, hrgn, hrgn2, RGN_AND );
+    ok( ret == COMPLEXREGION, "got %d\n", ret );
+    check_region_rects( hrgn, overlap, 2, __LINE__ );
+    ret = CombineRgn( hrgn, hrgn2, hrgn, RGN_AND );
+    ok( ret == COMPLEXREGION, "got %d\n", ret );
+    check_region_rects( hrgn, overlap, 2, __LINE__ );
+
+    /* subtracting a rectangle that covers the region */
+    ret = CombineRgn( hrgn, hrgn, hrgn2, RGN_DIFF );
+    ok( ret == NULLREGION, "got %d\n", ret );
+    GetRgnBox( hrgn, &rc );
+    ok( IsRectEmpty( &rc ), "got %s\n", wine_dbgstr_rect( &rc ));
+
+    /* two overlapping rectangles */
+    SetRectRgn( hrgn, 10, 10, 30, 30 );
+    SetRectRgn( hrgn2, 20, 20, 40, 40 );
+    ret = CombineRgn( hrgn, hrgn, hrgn2, RGN_AND );
+    ok( ret == SIMPLEREGION, "got %d\n", ret );
+    check_region_rects( hrgn, single, 1, __LINE__ );
+    SetRectRgn( hrgn2, 30, 10, 40, 40 );
+    ret = CombineRgn( hrgn, hrgn, hrgn2, RGN_AND );
+    ok( ret == NULLREGION, "got %d\n", ret );
+
+    /* visible region of a stack of cascaded windows */
+    hrgn3 = CreateRectRgn( 0, 0, 0, 0 );
+    for (i = 0; i < sizeof(windows) / sizeof(windows[0]); i++)
+        windows[i] = CreateRectRgn( i * 10, i * 10, i * 10 + 200, i * 10 + 150 );
+    for (j = 0; j < 10; j++)
+    {
+        SetRectRgn( hrgn, 0, 0, 200, 150 );
+        for (i = 1; i < sizeof(windows) / sizeof(windows[0]); i++)
+        {
+            ret = CombineRgn( hrgn, hrgn, windows[i], RGN_DIFF );
+            ok( ret == COMPLEXREGION, "%u: got %d\n", i, ret );
+            ret = CombineRgn( hrgn3, hrgn3, windows[i], RGN_OR );
+            ok( ret == (i == 1 ? SIMPLEREGION : COMPLEXREGION), "%u: got %d\n", i, ret );
+        }
+        GetRgnBox( hrgn, &rc );
+        ok( rc.left == 0 && rc.top == 0 && rc.right == 200 && rc.bottom == 150,
+            "got %s\n", wine_dbgstr_rect( &rc ));
+        GetRgnBox( hrgn3, &rc );
+        ok( rc.left == 10 && rc.top == 10 && rc.right == 510 && rc.bottom == 460,
+            "got %s\n", wine_dbgstr_rect( &rc ));
+        SetRectRgn( hrgn3, 0, 0, 0, 0 );
+    }
+    for (i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) DeleteObject( windows[i] );
+
+    DeleteObject( hrgn3 );
+    DeleteObject( hrgn2 );
+    DeleteObject( hrgn );
+}
+
 static void test_handles_on_win64(void)
 {
     int i;
@@ -368,5 +452,6 @@ START_TEST(gdiobj)
     test_thread_objects();
     test_GetCurrentObject();
     test_region();
+    test_CombineRgn();
     test_handles_on_win64();
 }
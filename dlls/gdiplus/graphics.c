@@ -369,6 +369,39 @@ static GpStatus alpha_blend_bmp_pixels(GpGraphics *graphics, INT dst_x, INT dst_
     GpBitmap *dst_bitmap = (GpBitmap*)graphics->image;
     INT x, y;
 
+    if (dst_bitmap->format == PixelFormat32bppARGB || dst_bitmap->format == PixelFormat32bppRGB)
+    {
+        /* Blend straight into the bits, with the same results as going through
+         * GdipBitmapGetPixel and GdipBitmapSetPixel. Pixels outside of the
+         * bitmap are skipped, as those functions would fail for them. */
+        INT start_x = max(0, -dst_x), end_x = min(src_width, (INT)dst_bitmap->width - dst_x);
+        INT start_y = max(0, -dst_y), end_y = min(src_height, (INT)dst_bitmap->height - dst_y);
+        BOOL has_alpha = dst_bitmap->format == PixelFormat32bppARGB;
+
+        for (y=start_y; y<end_y; y++)
+        {
+            const ARGB *src_row = (const ARGB*)(src + src_stride * y);
+            ARGB *dst_row = (ARGB*)(dst_bitmap->bits + dst_bitmap->stride * (y + dst_y)) + dst_x;
+
+            for (x=start_x; x<end_x; x++)
+            {
+                ARGB dst_color, src_color = src_row[x];
+
+                if (!(src_color & 0xff000000))
+                    continue;
+
+                dst_color = has_alpha ? dst_row[x] : dst_row[x] | 0xff000000;
+                if (fmt & PixelFormatPAlpha)
+                    dst_color = color_over_fgpremult(dst_color, src_color);
+                else
+                    dst_color = color_over(dst_color, src_color);
+                dst_row[x] = has_alpha ? dst_color : dst_color & 0xffffff;
+            }
+        }
+
+        return Ok;
+    }
+
     for (y=0; y<src_height; y++)
     {
         for (x=0; x<src_width; x++)
@@ -538,6 +571,15 @@ static ARGB blend_colors(ARGB start, ARGB end, REAL position)
 
     pos = gdip_round(position * 0xff);
 
+    /* With two opaque colors the alpha weights reduce to pos ^ 0xff and pos. */
+    if ((start & end & 0xff000000) == 0xff000000 && pos >= 0 && pos <= 0xff)
+    {
+        return 0xff000000 |
+            ((((start >> 16) & 0xff) * (pos ^ 0xff) + ((end >> 16) & 0xff) * pos) / 0xff) << 16 |
+            ((((start >> 8) & 0xff) * (pos ^ 0xff) + ((end >> 8) & 0xff) * pos) / 0xff) << 8 |
+            (((start & 0xff) * (pos ^ 0xff) + (end & 0xff) * pos) / 0xff);
+    }
+
     start_a = ((start >> 24) & 0xff) * (pos ^ 0xff);
     end_a = ((end >> 24) & 0xff) * pos;
 
@@ -1184,6 +1226,23 @@ static GpStatus brush_fill_pixels(GpGraphics *graphics, GpBrush *brush,
 
             for (y=0; y<fill_area->Height; y++)
             {
+                if (y > 0 && y_delta == 0.0f)
+                {
+                    /* the gradient runs along the rows, they are all the same */
+                    memcpy(argb_pixels + y*cdwStride, argb_pixels, fill_area->Width * sizeof(ARGB));
+                    continue;
+                }
+
+                if (x_delta == 0.0f)
+                {
+                    /* the gradient runs along the columns, the row has a single color */
+                    ARGB color = blend_line_gradient(fill, draw_points[0].X + y * y_delta);
+
+                    for (x=0; x<fill_area->Width; x++)
+                        argb_pixels[x + y*cdwStride] = color;
+                    continue;
+                }
+
                 for (x=0; x<fill_area->Width; x++)
                 {
                     REAL pos = draw_points[0].X + x * x_delta + y * y_delta;
@@ -3136,9 +3195,11 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
                 y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
                 y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
 
-                for (x=dst_area.left; x<dst_area.right; x++)
+                for (y=dst_area.top; y<dst_area.bottom; y++)
                 {
-                    for (y=dst_area.top; y<dst_area.bottom; y++)
+                    ARGB *dst_row = (ARGB*)(dst_data + dst_stride * (y - dst_area.top)) - dst_area.left;
+
+                    for (x=dst_area.left; x<dst_area.right; x++)
                     {
                         GpPointF src_pointf;
                         ARGB *dst_color;
@@ -3146,7 +3207,7 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
                         src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
                         src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
 
-                        dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
+                        dst_color = &dst_row[x];
 
                         if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
                             *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
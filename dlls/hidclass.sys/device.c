@@ -685,6 +685,22 @@ NTSTATUS WINAPI HID_Device_read(DEVICE_OBJECT *device, IRP *irp)
 
         rc = copy_packet_into_buffer(packet, irp->AssociatedIrp.SystemBuffer, irpsp->Parameters.Read.Length, &out_length);
         irp->IoStatus.Information = out_length;
+
+        /* like native, fill the rest of a large buffer with any other
+         * complete reports already waiting in the ring */
+        while (rc == STATUS_SUCCESS && irpsp->Parameters.Read.Length - irp->IoStatus.Information >=
+               ext->preparseData->caps.InputReportByteLength)
+        {
+            buffer_size = RingBuffer_GetBufferSize(ext->ring_buffer);
+            RingBuffer_ReadNew(ext->ring_buffer, ptr, packet, &buffer_size);
+            if (!buffer_size) break;
+            packet->reportBuffer = (BYTE *)packet + sizeof(*packet);
+            TRACE_(hid_report)("Got Packet %p %i\n", packet->reportBuffer, packet->reportBufferLen);
+            if (copy_packet_into_buffer(packet, (BYTE *)irp->AssociatedIrp.SystemBuffer + irp->IoStatus.Information,
+                    irpsp->Parameters.Read.Length - irp->IoStatus.Information, &out_length) != STATUS_SUCCESS)
+                break;
+            irp->IoStatus.Information += out_length;
+        }
         irp->IoStatus.u.Status = rc;
         IoCompleteRequest(irp, IO_NO_INCREMENT);
     }
@@ -17,6 +17,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -165,45 +166,7 @@ BOOL isIfIndexLoopback(ULONG idx)
   return ret;
 }
 
-#ifdef HAVE_IF_NAMEINDEX
-DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
-{
-    DWORD count = 0, i;
-    struct if_nameindex *p, *indices = if_nameindex();
-    InterfaceIndexTable *ret;
-
-    if (table) *table = NULL;
-    if (!indices) return 0;
-
-    for (p = indices; p->if_name; p++)
-    {
-        if (skip_loopback && isIfIndexLoopback( p->if_index )) continue;
-        count++;
-    }
-
-    if (table)
-    {
-        ret = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET(InterfaceIndexTable, indexes[count]) );
-        if (!ret)
-        {
-            count = 0;
-            goto end;
-        }
-        for (p = indices, i = 0; p->if_name && i < count; p++)
-        {
-            if (skip_loopback && isIfIndexLoopback( p->if_index )) continue;
-            ret->indexes[i++] = p->if_index;
-        }
-        ret->numIndexes = count = i;
-        *table = ret;
-    }
-
-end:
-    if_freenameindex( indices );
-    return count;
-}
-
-#elif defined(HAVE_LINUX_RTNETLINK_H)
+#ifdef HAVE_LINUX_RTNETLINK_H
 static int open_netlink( int *pid )
 {
     int fd = socket( AF_NETLINK, SOCK_RAW, NETLINK_ROUTE );
@@ -289,6 +252,7 @@ static int recv_netlink_reply( int fd, int pid, int seq, struct netlink_reply **
 
     do
     {
+        sa_len = sizeof(addr);
         left = read = recvfrom( fd, buf, bufsize, 0, (struct sockaddr *)&addr, &sa_len );
         if (read < 0) goto fail;
         if (addr.nl_pid != 0) continue; /* not from kernel */
@@ -352,7 +316,7 @@ static DWORD get_indices_from_reply( struct netlink_reply *reply, int pid, int s
     return count;
 }
 
-DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+static DWORD enum_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
 {
     int fd, pid, seq;
     struct netlink_reply *reply = NULL;
@@ -390,14 +354,242 @@ end:
     return count;
 }
 
+#elif defined(HAVE_IF_NAMEINDEX)
+static DWORD enum_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+{
+    DWORD count = 0, i;
+    struct if_nameindex *p, *indices = if_nameindex();
+    InterfaceIndexTable *ret;
+
+    if (table) *table = NULL;
+    if (!indices) return 0;
+
+    for (p = indices; p->if_name; p++)
+    {
+        if (skip_loopback && isIfIndexLoopback( p->if_index )) continue;
+        count++;
+    }
+
+    if (table)
+    {
+        ret = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET(InterfaceIndexTable, indexes[count]) );
+        if (!ret)
+        {
+            count = 0;
+            goto end;
+        }
+        for (p = indices, i = 0; p->if_name && i < count; p++)
+        {
+            if (skip_loopback && isIfIndexLoopback( p->if_index )) continue;
+            ret->indexes[i++] = p->if_index;
+        }
+        ret->numIndexes = count = i;
+        *table = ret;
+    }
+
+end:
+    if_freenameindex( indices );
+    return count;
+}
+
 #else
-DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+static DWORD enum_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
 {
     if (table) *table = NULL;
     return 0;
 }
 #endif
 
+#ifdef HAVE_LINUX_RTNETLINK_H
+int open_change_notify( DWORD events )
+{
+    struct sockaddr_nl addr;
+    int fd;
+
+    if ((fd = socket( AF_NETLINK, SOCK_RAW, NETLINK_ROUTE )) < 0) return -1;
+
+    memset( &addr, 0, sizeof(addr) );
+    addr.nl_family = AF_NETLINK;
+    if (events & CHANGE_NOTIFY_LINK) addr.nl_groups |= RTMGRP_LINK;
+    if (events & CHANGE_NOTIFY_ADDR) addr.nl_groups |= RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (events & CHANGE_NOTIFY_ROUTE) addr.nl_groups |= RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+
+    if (bind( fd, (struct sockaddr *)&addr, sizeof(addr) ) < 0)
+    {
+        close( fd );
+        return -1;
+    }
+    return fd;
+}
+
+static USHORT family_from_unix( int family )
+{
+    switch (family)
+    {
+    case AF_INET:  return WS_AF_INET;
+    case AF_INET6: return WS_AF_INET6;
+    default:       return WS_AF_UNSPEC;
+    }
+}
+
+static BOOL parse_change_notify( struct nlmsghdr *hdr, struct change_notify_event *event )
+{
+    memset( event, 0, sizeof(*event) );
+
+    switch (hdr->nlmsg_type)
+    {
+    case RTM_NEWLINK:
+    case RTM_DELLINK:
+    {
+        struct ifinfomsg *info = NLMSG_DATA(hdr);
+
+        if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*info))) return FALSE;
+        event->type = CHANGE_NOTIFY_LINK;
+        event->index = info->ifi_index;
+        event->deleted = hdr->nlmsg_type == RTM_DELLINK;
+        return TRUE;
+    }
+    case RTM_NEWADDR:
+    case RTM_DELADDR:
+    {
+        struct ifaddrmsg *ifa = NLMSG_DATA(hdr);
+
+        if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*ifa))) return FALSE;
+        event->type = CHANGE_NOTIFY_ADDR;
+        event->index = ifa->ifa_index;
+        event->family = family_from_unix( ifa->ifa_family );
+        event->deleted = hdr->nlmsg_type == RTM_DELADDR;
+        return TRUE;
+    }
+    case RTM_NEWROUTE:
+    case RTM_DELROUTE:
+    {
+        struct rtmsg *rt = NLMSG_DATA(hdr);
+        struct rtattr *attr;
+        int len;
+
+        if (hdr->nlmsg_len < NLMSG_LENGTH(sizeof(*rt))) return FALSE;
+        event->type = CHANGE_NOTIFY_ROUTE;
+        event->family = family_from_unix( rt->rtm_family );
+        event->deleted = hdr->nlmsg_type == RTM_DELROUTE;
+        len = RTM_PAYLOAD(hdr);
+        for (attr = RTM_RTA(rt); RTA_OK(attr, len); attr = RTA_NEXT(attr, len))
+        {
+            if (attr->rta_type == RTA_OIF && RTA_PAYLOAD(attr) >= sizeof(int))
+                event->index = *(int *)RTA_DATA(attr);
+        }
+        return TRUE;
+    }
+    }
+    return FALSE;
+}
+
+int read_change_notify( int fd, struct change_notify_event *events, int count )
+{
+    ULONG_PTR buf[4096 / sizeof(ULONG_PTR)];
+    struct change_notify_event event;
+    struct sockaddr_nl addr;
+    struct nlmsghdr *hdr;
+    socklen_t len;
+    int size, ret = 0;
+
+    for (;;)
+    {
+        len = sizeof(addr);
+        size = recvfrom( fd, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr *)&addr, &len );
+        if (size < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS)
+            {
+                /* the socket overflowed, report a change of unknown type */
+                if (ret < count) memset( &events[ret], 0, sizeof(events[ret]) );
+                ret++;
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK || ret) return ret;
+            return -1;
+        }
+        if (!size) return ret;
+        if (addr.nl_pid) continue; /* not from kernel */
+
+        for (hdr = (struct nlmsghdr *)buf; NLMSG_OK(hdr, size); hdr = NLMSG_NEXT(hdr, size))
+        {
+            if (!parse_change_notify( hdr, &event )) continue;
+            if (ret < count) events[ret] = event;
+            ret++;
+        }
+    }
+}
+
+#else
+int open_change_notify( DWORD events )
+{
+    return -1;
+}
+
+int read_change_notify( int fd, struct change_notify_event *events, int count )
+{
+    return -1;
+}
+#endif
+
+static CRITICAL_SECTION ifenum_cs;
+static CRITICAL_SECTION_DEBUG ifenum_cs_debug =
+{
+    0, 0, &ifenum_cs,
+    { &ifenum_cs_debug.ProcessLocksList, &ifenum_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": ifenum_cs") }
+};
+static CRITICAL_SECTION ifenum_cs = { &ifenum_cs_debug, -1, 0, 0, 0, 0 };
+
+static int generation_fd = -2;
+static DWORD generation;
+static InterfaceIndexTable *index_cache[2];
+static DWORD index_cache_generation[2];
+
+DWORD get_interface_generation(void)
+{
+    DWORD ret;
+
+    EnterCriticalSection( &ifenum_cs );
+    if (generation_fd == -2)
+        generation_fd = open_change_notify( CHANGE_NOTIFY_LINK | CHANGE_NOTIFY_ADDR | CHANGE_NOTIFY_ROUTE );
+    /* without change notifications nothing can be cached */
+    if (generation_fd == -1 || read_change_notify( generation_fd, NULL, 0 )) generation++;
+    ret = generation;
+    LeaveCriticalSection( &ifenum_cs );
+    return ret;
+}
+
+DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table )
+{
+    InterfaceIndexTable **cache = &index_cache[skip_loopback != 0];
+    DWORD count = 0, size, current;
+
+    if (table) *table = NULL;
+
+    EnterCriticalSection( &ifenum_cs );
+    current = get_interface_generation();
+    if (!*cache || index_cache_generation[skip_loopback != 0] != current)
+    {
+        HeapFree( GetProcessHeap(), 0, *cache );
+        enum_interface_indices( skip_loopback, cache );
+        index_cache_generation[skip_loopback != 0] = current;
+    }
+    if (*cache)
+    {
+        count = (*cache)->numIndexes;
+        if (table)
+        {
+            size = FIELD_OFFSET( InterfaceIndexTable, indexes[count] );
+            if ((*table = HeapAlloc( GetProcessHeap(), 0, size ))) memcpy( *table, *cache, size );
+            else count = 0;
+        }
+    }
+    LeaveCriticalSection( &ifenum_cs );
+    return count;
+}
 static DWORD getInterfaceBCastAddrByName(const char *name)
 {
   DWORD ret = INADDR_ANY;
@@ -57,6 +57,36 @@ typedef struct _InterfaceIndexTable {
  */
 DWORD get_interface_indices( BOOL skip_loopback, InterfaceIndexTable **table ) DECLSPEC_HIDDEN;
 
+/* Kinds of changes reported by open_change_notify(). */
+#define CHANGE_NOTIFY_LINK  0x1
+#define CHANGE_NOTIFY_ADDR  0x2
+#define CHANGE_NOTIFY_ROUTE 0x4
+
+struct change_notify_event
+{
+  DWORD type;      /* CHANGE_NOTIFY_*, 0 if events were lost */
+  IF_INDEX index;  /* 0 if unknown */
+  USHORT family;   /* WS_AF_INET, WS_AF_INET6 or WS_AF_UNSPEC */
+  BOOL deleted;
+};
+
+/* Returns a descriptor that becomes readable when changes of the given
+ * CHANGE_NOTIFY_* kinds happen, or -1 if change notifications aren't
+ * supported.  close() it when done.
+ */
+int open_change_notify( DWORD events ) DECLSPEC_HIDDEN;
+
+/* Reads the pending changes without blocking and stores up to count of them
+ * in events.  Returns the number of changes read, which may exceed count, or
+ * -1 on error.
+ */
+int read_change_notify( int fd, struct change_notify_event *events, int count ) DECLSPEC_HIDDEN;
+
+/* Returns a value that changes whenever interfaces, addresses or routes may
+ * have changed since the previous call, for use as a cache key.
+ */
+DWORD get_interface_generation(void) DECLSPEC_HIDDEN;
+
 /* ByName/ByIndex versions of various getter functions. */
 
 /* can be used as quick check to see if you've got a valid index, returns NULL
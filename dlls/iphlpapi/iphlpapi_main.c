@@ -19,11 +19,22 @@
  */
 
 #include "config.h"
+#include "wine/port.h"
 
+#include <errno.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/types.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_POLL_H
+# include <poll.h>
+#endif
+#ifdef HAVE_SYS_POLL_H
+# include <sys/poll.h>
+#endif
 #ifdef HAVE_NETINET_IN_H
 # include <netinet/in.h>
 #endif
@@ -37,6 +48,8 @@
 # include <resolv.h>
 #endif
 
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
 #define NONAMELESSUNION
 #define NONAMELESSSTRUCT
 #include "windef.h"
@@ -56,6 +69,7 @@
 #include "tcpestats.h"
 
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(iphlpapi);
@@ -68,6 +82,223 @@ WINE_DEFAULT_DEBUG_CHANNEL(iphlpapi);
 #define INADDR_NONE ~0UL
 #endif
 
+/* a pending NotifyAddrChange/NotifyRouteChange request or a NotifyIpInterfaceChange registration */
+struct change_request
+{
+    struct list                  entry;
+    OVERLAPPED                  *overlapped;
+    PIPINTERFACE_CHANGE_CALLBACK callback;
+    void                        *context;
+    ADDRESS_FAMILY               family;
+    BOOL                         init_notify;
+    BOOL                         cancelled;
+    BOOL                         detached;     /* the thread frees the request when it exits */
+    int                          fd;
+    int                          cancel_pipe[2];
+    HMODULE                      module;
+    HANDLE                       thread;
+    DWORD                        thread_id;
+};
+
+static struct list change_requests = LIST_INIT( change_requests );
+static HANDLE change_event;
+
+static CRITICAL_SECTION change_cs;
+static CRITICAL_SECTION_DEBUG change_cs_debug =
+{
+    0, 0, &change_cs,
+    { &change_cs_debug.ProcessLocksList, &change_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": change_cs") }
+};
+static CRITICAL_SECTION change_cs = { &change_cs_debug, -1, 0, 0, 0, 0 };
+
+static struct change_request *create_change_request( DWORD events )
+{
+    struct change_request *req;
+
+    if (!(req = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*req) ))) return NULL;
+    if ((req->fd = open_change_notify( events )) == -1)
+    {
+        HeapFree( GetProcessHeap(), 0, req );
+        return NULL;
+    }
+    if (pipe( req->cancel_pipe ) == -1)
+    {
+        close( req->fd );
+        HeapFree( GetProcessHeap(), 0, req );
+        return NULL;
+    }
+    return req;
+}
+
+static void free_change_request( struct change_request *req )
+{
+    close( req->fd );
+    close( req->cancel_pipe[0] );
+    close( req->cancel_pipe[1] );
+    if (req->thread) CloseHandle( req->thread );
+    HeapFree( GetProcessHeap(), 0, req );
+}
+
+/* waits until something changes, returns FALSE if the request was cancelled */
+static BOOL wait_change_request( struct change_request *req )
+{
+    struct pollfd pfd[2];
+
+    pfd[0].fd = req->fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = req->cancel_pipe[0];
+    pfd[1].events = POLLIN;
+
+    for (;;)
+    {
+        if (poll( pfd, 2, -1 ) < 0)
+        {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        if (pfd[1].revents) return FALSE;
+        if (pfd[0].revents) return TRUE;
+    }
+}
+
+/* called with change_cs held */
+static void cancel_change_request( struct change_request *req )
+{
+    list_remove( &req->entry );
+    req->cancelled = TRUE;
+    write( req->cancel_pipe[1], "", 1 );
+}
+
+/* called with change_cs held, the request is added to the list first since the thread may complete it right away */
+static BOOL start_change_request( struct change_request *req, LPTHREAD_START_ROUTINE func )
+{
+    list_add_tail( &change_requests, &req->entry );
+    if (GetModuleHandleExW( GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (const WCHAR *)func, &req->module ))
+    {
+        if ((req->thread = CreateThread( NULL, 0, func, req, 0, &req->thread_id ))) return TRUE;
+        FreeLibrary( req->module );
+    }
+    list_remove( &req->entry );
+    return FALSE;
+}
+
+static DWORD CALLBACK change_notify_thread( void *arg )
+{
+    struct change_request *req = arg;
+    HMODULE module = req->module;
+    OVERLAPPED *overlapped = req->overlapped;
+
+    while (wait_change_request( req ) && !read_change_notify( req->fd, NULL, 0 ))
+        ;
+
+    EnterCriticalSection( &change_cs );
+    if (!req->cancelled)
+    {
+        list_remove( &req->entry );
+        overlapped->InternalHigh = 0;
+        overlapped->Internal = STATUS_SUCCESS;
+        if (overlapped->hEvent) SetEvent( overlapped->hEvent );
+        SetEvent( change_event );
+    }
+    LeaveCriticalSection( &change_cs );
+
+    free_change_request( req );
+    FreeLibraryAndExitThread( module, 0 );
+}
+
+static DWORD notify_change( DWORD events, HANDLE *handle, OVERLAPPED *overlapped )
+{
+    struct change_request *req;
+    DWORD err;
+
+    if (!(req = create_change_request( events ))) return ERROR_NOT_SUPPORTED;
+
+    if (!overlapped)
+    {
+        while (wait_change_request( req ) && !read_change_notify( req->fd, NULL, 0 ))
+            ;
+        free_change_request( req );
+        return NO_ERROR;
+    }
+
+    EnterCriticalSection( &change_cs );
+    if (!change_event && !(change_event = CreateEventW( NULL, TRUE, FALSE, NULL )))
+    {
+        err = GetLastError();
+        LeaveCriticalSection( &change_cs );
+        free_change_request( req );
+        return err;
+    }
+    ResetEvent( change_event );
+    req->overlapped = overlapped;
+    overlapped->Internal = STATUS_PENDING;
+    overlapped->InternalHigh = 0;
+    if (!start_change_request( req, change_notify_thread ))
+    {
+        err = GetLastError();
+        LeaveCriticalSection( &change_cs );
+        free_change_request( req );
+        return err;
+    }
+    /* the thread frees the request, nobody waits for it */
+    CloseHandle( req->thread );
+    req->thread = NULL;
+    if (handle) *handle = change_event;
+    LeaveCriticalSection( &change_cs );
+
+    SetLastError( ERROR_IO_PENDING );
+    return ERROR_IO_PENDING;
+}
+
+static DWORD CALLBACK interface_change_thread( void *arg )
+{
+    struct change_request *req = arg;
+    HMODULE module = req->module;
+    struct change_notify_event events[16];
+    MIB_IPINTERFACE_ROW row;
+    MIB_NOTIFICATION_TYPE type;
+    BOOL detached;
+    int i, count;
+
+    if (req->init_notify) req->callback( req->context, NULL, MibInitialNotification );
+
+    while (wait_change_request( req ))
+    {
+        if ((count = read_change_notify( req->fd, events, sizeof(events) / sizeof(events[0]) )) < 0) break;
+        if (count > sizeof(events) / sizeof(events[0])) count = sizeof(events) / sizeof(events[0]);
+
+        for (i = 0; i < count; i++)
+        {
+            if (!events[i].index) continue;
+            if (req->family != WS_AF_UNSPEC && events[i].family != WS_AF_UNSPEC &&
+                events[i].family != req->family) continue;
+
+            memset( &row, 0, sizeof(row) );
+            if (events[i].family != WS_AF_UNSPEC) row.Family = events[i].family;
+            else row.Family = req->family != WS_AF_UNSPEC ? req->family : WS_AF_INET;
+            row.InterfaceIndex = events[i].index;
+            ConvertInterfaceIndexToLuid( row.InterfaceIndex, &row.InterfaceLuid );
+
+            if (events[i].type == CHANGE_NOTIFY_LINK && events[i].deleted) type = MibDeleteInstance;
+            else type = MibParameterNotification;
+            req->callback( req->context, &row, type );
+        }
+
+        /* the callback may cancel the registration */
+        EnterCriticalSection( &change_cs );
+        detached = req->cancelled;
+        LeaveCriticalSection( &change_cs );
+        if (detached) break;
+    }
+
+    EnterCriticalSection( &change_cs );
+    detached = req->detached;
+    LeaveCriticalSection( &change_cs );
+    if (detached) free_change_request( req );
+    FreeLibraryAndExitThread( module, 0 );
+}
+
 /******************************************************************
  *    AddIPAddress (IPHLPAPI.@)
  *
@@ -201,14 +432,27 @@ DWORD WINAPI AllocateAndGetIpAddrTableFromStack(PMIB_IPADDRTABLE *ppIpAddrTable,
  * RETURNS
  *  Success: TRUE
  *  Failure: FALSE
- *
- * FIXME
- *  Stub, returns FALSE.
  */
 BOOL WINAPI CancelIPChangeNotify(LPOVERLAPPED overlapped)
 {
-  FIXME("(overlapped %p): stub\n", overlapped);
-  return FALSE;
+    struct change_request *req;
+
+    TRACE("(overlapped %p)\n", overlapped);
+
+    if (!overlapped) return FALSE;
+
+    EnterCriticalSection( &change_cs );
+    LIST_FOR_EACH_ENTRY( req, &change_requests, struct change_request, entry )
+    {
+        if (req->overlapped != overlapped) continue;
+        cancel_change_request( req );
+        overlapped->Internal = STATUS_CANCELLED;
+        if (overlapped->hEvent) SetEvent( overlapped->hEvent );
+        LeaveCriticalSection( &change_cs );
+        return TRUE;
+    }
+    LeaveCriticalSection( &change_cs );
+    return FALSE;
 }
 
 
@@ -217,8 +461,30 @@ BOOL WINAPI CancelIPChangeNotify(LPOVERLAPPED overlapped)
  */
 DWORD WINAPI CancelMibChangeNotify2(HANDLE handle)
 {
-    FIXME("(handle %p): stub\n", handle);
-    return NO_ERROR;
+    struct change_request *req;
+
+    TRACE("(handle %p)\n", handle);
+
+    EnterCriticalSection( &change_cs );
+    LIST_FOR_EACH_ENTRY( req, &change_requests, struct change_request, entry )
+    {
+        if (req != handle || !req->callback) continue;
+        cancel_change_request( req );
+        if (req->thread_id == GetCurrentThreadId())
+        {
+            /* cancelled from the callback, the thread cleans up after it returns */
+            req->detached = TRUE;
+            LeaveCriticalSection( &change_cs );
+            return NO_ERROR;
+        }
+        LeaveCriticalSection( &change_cs );
+
+        WaitForSingleObject( req->thread, INFINITE );
+        free_change_request( req );
+        return NO_ERROR;
+    }
+    LeaveCriticalSection( &change_cs );
+    return ERROR_INVALID_HANDLE;
 }
 
 
@@ -2714,18 +2980,13 @@ DWORD WINAPI IpRenewAddress(PIP_ADAPTER_INDEX_MAP AdapterInfo)
  *  overlapped [In]  overlapped structure that notifies the caller
  *
  * RETURNS
- *  Success: NO_ERROR
+ *  Success: NO_ERROR, or ERROR_IO_PENDING if overlapped is not NULL
  *  Failure: error code from winerror.h
- *
- * FIXME
- *  Stub, returns ERROR_NOT_SUPPORTED.
  */
 DWORD WINAPI NotifyAddrChange(PHANDLE Handle, LPOVERLAPPED overlapped)
 {
-  FIXME("(Handle %p, overlapped %p): stub\n", Handle, overlapped);
-  if (Handle) *Handle = INVALID_HANDLE_VALUE;
-  if (overlapped) ((IO_STATUS_BLOCK *) overlapped)->u.Status = STATUS_PENDING;
-  return ERROR_IO_PENDING;
+    TRACE("(Handle %p, overlapped %p)\n", Handle, overlapped);
+    return notify_change( CHANGE_NOTIFY_ADDR, Handle, overlapped );
 }
 
 
@@ -2735,10 +2996,35 @@ DWORD WINAPI NotifyAddrChange(PHANDLE Handle, LPOVERLAPPED overlapped)
 DWORD WINAPI NotifyIpInterfaceChange(ADDRESS_FAMILY family, PIPINTERFACE_CHANGE_CALLBACK callback,
                                      PVOID context, BOOLEAN init_notify, PHANDLE handle)
 {
-    FIXME("(family %d, callback %p, context %p, init_notify %d, handle %p): stub\n",
+    struct change_request *req;
+    DWORD err;
+
+    TRACE("(family %d, callback %p, context %p, init_notify %d, handle %p)\n",
           family, callback, context, init_notify, handle);
-    if (handle) *handle = NULL;
-    return ERROR_NOT_SUPPORTED;
+
+    if (!callback || !handle) return ERROR_INVALID_PARAMETER;
+    if (family != WS_AF_UNSPEC && family != WS_AF_INET && family != WS_AF_INET6)
+        return ERROR_INVALID_PARAMETER;
+
+    *handle = NULL;
+    if (!(req = create_change_request( CHANGE_NOTIFY_LINK | CHANGE_NOTIFY_ADDR )))
+        return ERROR_NOT_SUPPORTED;
+    req->callback = callback;
+    req->context = context;
+    req->family = family;
+    req->init_notify = init_notify;
+
+    EnterCriticalSection( &change_cs );
+    if (!start_change_request( req, interface_change_thread ))
+    {
+        err = GetLastError();
+        LeaveCriticalSection( &change_cs );
+        free_change_request( req );
+        return err;
+    }
+    *handle = req;
+    LeaveCriticalSection( &change_cs );
+    return NO_ERROR;
 }
 
 
@@ -2752,16 +3038,13 @@ DWORD WINAPI NotifyIpInterfaceChange(ADDRESS_FAMILY family, PIPINTERFACE_CHANGE_
  *  overlapped [In]  overlapped structure that notifies the caller
  *
  * RETURNS
- *  Success: NO_ERROR
+ *  Success: NO_ERROR, or ERROR_IO_PENDING if overlapped is not NULL
  *  Failure: error code from winerror.h
- *
- * FIXME
- *  Stub, returns ERROR_NOT_SUPPORTED.
  */
 DWORD WINAPI NotifyRouteChange(PHANDLE Handle, LPOVERLAPPED overlapped)
 {
-  FIXME("(Handle %p, overlapped %p): stub\n", Handle, overlapped);
-  return ERROR_NOT_SUPPORTED;
+    TRACE("(Handle %p, overlapped %p)\n", Handle, overlapped);
+    return notify_change( CHANGE_NOTIFY_ROUTE, Handle, overlapped );
 }
 
 
@@ -1361,34 +1361,12 @@ static int compare_ipforward_rows(const void *a, const void *b)
     return rowA->dwForwardNextHop - rowB->dwForwardNextHop;
 }
 
-/******************************************************************
- *    AllocateAndGetIpForwardTableFromStack (IPHLPAPI.@)
- *
- * Get the route table.
- * Like GetIpForwardTable(), but allocate the returned table from heap.
- *
- * PARAMS
- *  ppIpForwardTable [Out] pointer into which the MIB_IPFORWARDTABLE is
- *                         allocated and returned.
- *  bOrder           [In]  whether to sort the table
- *  heap             [In]  heap from which the table is allocated
- *  flags            [In]  flags to HeapAlloc
- *
- * RETURNS
- *  ERROR_INVALID_PARAMETER if ppIfTable is NULL, other error codes
- *  on failure, NO_ERROR on success.
- */
-DWORD WINAPI AllocateAndGetIpForwardTableFromStack(PMIB_IPFORWARDTABLE *ppIpForwardTable, BOOL bOrder,
-                                                   HANDLE heap, DWORD flags)
+static DWORD enum_ipforward_table( PMIB_IPFORWARDTABLE *ppIpForwardTable, BOOL bOrder, HANDLE heap, DWORD flags )
 {
     MIB_IPFORWARDTABLE *table;
     MIB_IPFORWARDROW row;
     DWORD ret = NO_ERROR, count = 16;
 
-    TRACE("table %p, bOrder %d, heap %p, flags 0x%08x\n", ppIpForwardTable, bOrder, heap, flags);
-
-    if (!ppIpForwardTable) return ERROR_INVALID_PARAMETER;
-
     if (!(table = HeapAlloc( heap, flags, FIELD_OFFSET(MIB_IPFORWARDTABLE, table[count] ))))
         return ERROR_OUTOFMEMORY;
 
@@ -1598,6 +1576,72 @@ done:
     return ret;
 }
 
+static CRITICAL_SECTION ipforward_cs;
+static CRITICAL_SECTION_DEBUG ipforward_cs_debug =
+{
+    0, 0, &ipforward_cs,
+    { &ipforward_cs_debug.ProcessLocksList, &ipforward_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": ipforward_cs") }
+};
+static CRITICAL_SECTION ipforward_cs = { &ipforward_cs_debug, -1, 0, 0, 0, 0 };
+
+static MIB_IPFORWARDTABLE *ipforward_cache;
+static DWORD ipforward_cache_generation;
+
+/******************************************************************
+ *    AllocateAndGetIpForwardTableFromStack (IPHLPAPI.@)
+ *
+ * Get the route table.
+ * Like GetIpForwardTable(), but allocate the returned table from heap.
+ *
+ * PARAMS
+ *  ppIpForwardTable [Out] pointer into which the MIB_IPFORWARDTABLE is
+ *                         allocated and returned.
+ *  bOrder           [In]  whether to sort the table
+ *  heap             [In]  heap from which the table is allocated
+ *  flags            [In]  flags to HeapAlloc
+ *
+ * RETURNS
+ *  ERROR_INVALID_PARAMETER if ppIfTable is NULL, other error codes
+ *  on failure, NO_ERROR on success.
+ */
+DWORD WINAPI AllocateAndGetIpForwardTableFromStack(PMIB_IPFORWARDTABLE *ppIpForwardTable, BOOL bOrder,
+                                                   HANDLE heap, DWORD flags)
+{
+    MIB_IPFORWARDTABLE *table = NULL;
+    DWORD ret = NO_ERROR, size, current;
+
+    TRACE("table %p, bOrder %d, heap %p, flags 0x%08x\n", ppIpForwardTable, bOrder, heap, flags);
+
+    if (!ppIpForwardTable) return ERROR_INVALID_PARAMETER;
+
+    /* the route table is cached unsorted until the next route or address change */
+    EnterCriticalSection( &ipforward_cs );
+    current = get_interface_generation();
+    if (!ipforward_cache || ipforward_cache_generation != current)
+    {
+        HeapFree( GetProcessHeap(), 0, ipforward_cache );
+        ipforward_cache = NULL;
+        ret = enum_ipforward_table( &ipforward_cache, FALSE, GetProcessHeap(), 0 );
+        ipforward_cache_generation = current;
+    }
+    if (!ret)
+    {
+        size = FIELD_OFFSET( MIB_IPFORWARDTABLE, table[ipforward_cache->dwNumEntries] );
+        if ((table = HeapAlloc( heap, flags, size ))) memcpy( table, ipforward_cache, size );
+        else ret = ERROR_OUTOFMEMORY;
+    }
+    LeaveCriticalSection( &ipforward_cs );
+
+    if (!ret)
+    {
+        if (bOrder && table->dwNumEntries)
+            qsort( table->table, table->dwNumEntries, sizeof(MIB_IPFORWARDROW), compare_ipforward_rows );
+        *ppIpForwardTable = table;
+    }
+    return ret;
+}
+
 static MIB_IPNETTABLE *append_ipnet_row( HANDLE heap, DWORD flags, MIB_IPNETTABLE *table,
                                          DWORD *count, const MIB_IPNETROW *row )
 {
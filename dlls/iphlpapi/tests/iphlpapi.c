@@ -80,6 +80,8 @@ static DWORD (WINAPI *pGetUnicastIpAddressEntry)(MIB_UNICASTIPADDRESS_ROW*);
 static DWORD (WINAPI *pGetUnicastIpAddressTable)(ADDRESS_FAMILY,MIB_UNICASTIPADDRESS_TABLE**);
 static DWORD (WINAPI *pNotifyAddrChange)(PHANDLE,LPOVERLAPPED);
 static BOOL  (WINAPI *pCancelIPChangeNotify)(LPOVERLAPPED);
+static DWORD (WINAPI *pNotifyIpInterfaceChange)(ADDRESS_FAMILY,PIPINTERFACE_CHANGE_CALLBACK,PVOID,BOOLEAN,PHANDLE);
+static DWORD (WINAPI *pCancelMibChangeNotify2)(HANDLE);
 static DWORD (WINAPI *pGetExtendedTcpTable)(PVOID,PDWORD,BOOL,ULONG,TCP_TABLE_CLASS,ULONG);
 static DWORD (WINAPI *pGetExtendedUdpTable)(PVOID,PDWORD,BOOL,ULONG,UDP_TABLE_CLASS,ULONG);
 static DWORD (WINAPI *pSetTcpEntry)(PMIB_TCPROW);
@@ -134,6 +136,8 @@ static void loadIPHlpApi(void)
     pGetUnicastIpAddressTable = (void *)GetProcAddress(hLibrary, "GetUnicastIpAddressTable");
     pNotifyAddrChange = (void *)GetProcAddress(hLibrary, "NotifyAddrChange");
     pCancelIPChangeNotify = (void *)GetProcAddress(hLibrary, "CancelIPChangeNotify");
+    pNotifyIpInterfaceChange = (void *)GetProcAddress(hLibrary, "NotifyIpInterfaceChange");
+    pCancelMibChangeNotify2 = (void *)GetProcAddress(hLibrary, "CancelMibChangeNotify2");
     pGetExtendedTcpTable = (void *)GetProcAddress(hLibrary, "GetExtendedTcpTable");
     pGetExtendedUdpTable = (void *)GetProcAddress(hLibrary, "GetExtendedUdpTable");
     pSetTcpEntry = (void *)GetProcAddress(hLibrary, "SetTcpEntry");
@@ -1312,9 +1316,9 @@ static void testNotifyAddrChange(void)
     }
     ok(ret == ERROR_IO_PENDING, "NotifyAddrChange returned %d, expected ERROR_IO_PENDING\n", ret);
     ret = GetLastError();
-    todo_wine ok(ret == ERROR_IO_PENDING, "GetLastError returned %d, expected ERROR_IO_PENDING\n", ret);
+    ok(ret == ERROR_IO_PENDING, "GetLastError returned %d, expected ERROR_IO_PENDING\n", ret);
     success = pCancelIPChangeNotify(&overlapped);
-    todo_wine ok(success == TRUE, "CancelIPChangeNotify returned FALSE, expected TRUE\n");
+    ok(success == TRUE, "CancelIPChangeNotify returned FALSE, expected TRUE\n");
 
     ZeroMemory(&overlapped, sizeof(overlapped));
     success = pCancelIPChangeNotify(&overlapped);
@@ -1325,13 +1329,13 @@ static void testNotifyAddrChange(void)
     overlapped.hEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
     ret = pNotifyAddrChange(&handle, &overlapped);
     ok(ret == ERROR_IO_PENDING, "NotifyAddrChange returned %d, expected ERROR_IO_PENDING\n", ret);
-    todo_wine ok(handle != INVALID_HANDLE_VALUE, "NotifyAddrChange returned invalid file handle\n");
+    ok(handle != INVALID_HANDLE_VALUE, "NotifyAddrChange returned invalid file handle\n");
     success = GetOverlappedResult(handle, &overlapped, &bytes, FALSE);
     ok(success == FALSE, "GetOverlappedResult returned TRUE, expected FALSE\n");
     ret = GetLastError();
     ok(ret == ERROR_IO_INCOMPLETE, "GetLastError returned %d, expected ERROR_IO_INCOMPLETE\n", ret);
     success = pCancelIPChangeNotify(&overlapped);
-    todo_wine ok(success == TRUE, "CancelIPChangeNotify returned FALSE, expected TRUE\n");
+    ok(success == TRUE, "CancelIPChangeNotify returned FALSE, expected TRUE\n");
 
     if (winetest_interactive)
     {
@@ -1352,7 +1356,7 @@ static void testNotifyAddrChange(void)
         trace("Testing synchronous ipv4 address change notification. Please "
               "change the ipv4 address of one of your network interfaces\n");
         ret = pNotifyAddrChange(NULL, NULL);
-        todo_wine ok(ret == NO_ERROR, "NotifyAddrChange returned %d, expected NO_ERROR\n", ret);
+        ok(ret == NO_ERROR, "NotifyAddrChange returned %d, expected NO_ERROR\n", ret);
     }
 }
 
@@ -2174,6 +2178,49 @@ static void test_GetUnicastIpAddressTable(void)
     pFreeMibTable(table);
 }
 
+static void WINAPI interface_change_callback(void *context, MIB_IPINTERFACE_ROW *row,
+                                             MIB_NOTIFICATION_TYPE type)
+{
+    if (type == MibInitialNotification)
+    {
+        ok(!row, "got row %p\n", row);
+        SetEvent(context);
+    }
+}
+
+static void test_NotifyIpInterfaceChange(void)
+{
+    HANDLE handle, event;
+    DWORD ret;
+
+    if (!pNotifyIpInterfaceChange || !pCancelMibChangeNotify2)
+    {
+        win_skip("NotifyIpInterfaceChange not available\n");
+        return;
+    }
+
+    ret = pNotifyIpInterfaceChange(AF_INET, NULL, NULL, FALSE, &handle);
+    ok(ret == ERROR_INVALID_PARAMETER, "got %u\n", ret);
+
+    event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    handle = NULL;
+    ret = pNotifyIpInterfaceChange(AF_UNSPEC, interface_change_callback, event, TRUE, &handle);
+    if (ret == ERROR_NOT_SUPPORTED)
+    {
+        skip("NotifyIpInterfaceChange is not supported\n");
+        CloseHandle(event);
+        return;
+    }
+    ok(ret == NO_ERROR, "got %u\n", ret);
+    ok(handle != NULL, "got NULL handle\n");
+    ret = WaitForSingleObject(event, 5000);
+    ok(ret == WAIT_OBJECT_0, "initial notification not received\n");
+
+    ret = pCancelMibChangeNotify2(handle);
+    ok(ret == NO_ERROR, "got %u\n", ret);
+    CloseHandle(event);
+}
+
 START_TEST(iphlpapi)
 {
 
@@ -2201,6 +2248,7 @@ START_TEST(iphlpapi)
     test_GetIfTable2Ex();
     test_GetUnicastIpAddressEntry();
     test_GetUnicastIpAddressTable();
+    test_NotifyIpInterfaceChange();
     freeIPHlpApi();
   }
 }
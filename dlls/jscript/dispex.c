@@ -1051,6 +1051,18 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/*
+ * Property slots are never freed or moved within props array, so a DISPID found for a
+ * name stays valid as long as the slot is in use and still holds that name. Objects
+ * built by the same sequence of property insertions share their DISPIDs, which lets
+ * a single cached id serve all objects seen at a given bytecode site.
+ */
+BOOL jsdisp_is_cached_id(jsdisp_t *jsdisp, const WCHAR *name, DISPID id)
+{
+    dispex_prop_t *prop = get_prop(jsdisp, id);
+    return prop && !strcmpW(prop->name, name);
+}
+
 HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     HRESULT hres;
@@ -34,6 +34,13 @@
  */
 #define JSSTR_MAX_ROPE_DEPTH 100
 
+/*
+ * Short strings appended to a rope are merged into its right leaf as long as
+ * the leaf stays below this length. This keeps ropes built by appending in
+ * a loop shallow, so they rarely need to be flattened as a whole.
+ */
+#define JSSTR_ROPE_LEAF_LENGTH 1024
+
 const char *debugstr_jsstr(jsstr_t *str)
 {
     return jsstr_is_inline(str) ? debugstr_wn(jsstr_as_inline(str)->buf, jsstr_length(str))
@@ -221,6 +228,35 @@ jsstr_t *jsstr_concat(jsstr_t *str1, jsstr_t *str2)
     if(!len2)
         return jsstr_addref(str1);
 
+    if(jsstr_is_rope(str1) && !jsstr_is_rope(jsstr_as_rope(str1)->right)
+       && jsstr_length(jsstr_as_rope(str1)->right) + len2 <= JSSTR_ROPE_LEAF_LENGTH) {
+        jsstr_rope_t *rope, *left_rope = jsstr_as_rope(str1);
+        unsigned right_len = jsstr_length(left_rope->right);
+        jsstr_t *right;
+
+        if(len1+len2 > JSSTR_MAX_LENGTH)
+            return NULL;
+
+        right = jsstr_alloc_buf(right_len+len2, &ptr);
+        if(!right)
+            return NULL;
+        jsstr_flush(left_rope->right, ptr);
+        jsstr_flush(str2, ptr+right_len);
+
+        rope = heap_alloc(sizeof(*rope));
+        if(!rope) {
+            jsstr_release(right);
+            return NULL;
+        }
+
+        /* the new right leaf is flat, so the depth can't grow */
+        jsstr_init(&rope->str, len1+len2, JSSTR_ROPE);
+        rope->left = jsstr_addref(left_rope->left);
+        rope->right = right;
+        rope->depth = left_rope->depth;
+        return &rope->str;
+    }
+
     if(len1 + len2 >= JSSTR_SHORT_STRING_LENGTH) {
         unsigned depth, depth2;
         jsstr_rope_t *rope;
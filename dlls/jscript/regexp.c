@@ -3070,24 +3070,64 @@ good:
     return x;
 }
 
+/*
+ * If every match has to start with a known character, return it so that
+ * MatchRegExp can skip to candidate positions without running the matcher.
+ */
+static BOOL GetFirstChar(regexp_t *re, WCHAR *ch)
+{
+    jsbytecode *pc = re->program;
+    size_t offset;
+
+    switch ((REOp) *pc++) {
+      case REOP_FLAT:
+        ReadCompactIndex(pc, &offset);
+        *ch = re->source[offset];
+        return TRUE;
+      case REOP_FLAT1:
+        *ch = *pc;
+        return TRUE;
+      case REOP_UCFLAT1:
+        *ch = GET_ARG(pc);
+        return TRUE;
+      default:
+        return FALSE;
+    }
+}
+
 static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
 {
     match_state_t *result;
     const WCHAR *cp = x->cp;
     const WCHAR *cp2;
+    BOOL sticky = (gData->regexp->flags & REG_STICKY) != 0;
+    BOOL anchored = gData->regexp->program[0] == REOP_BOL &&
+        !(gData->regexp->flags & REG_MULTILINE);
+    BOOL has_first_char;
+    WCHAR first_char;
     UINT j;
 
+    has_first_char = !sticky && GetFirstChar(gData->regexp, &first_char);
+
     /*
      * Have to include the position beyond the last character
      * in order to detect end-of-input/line condition.
      */
     for (cp2 = cp; cp2 <= gData->cpend; cp2++) {
+        /* a non-multiline ^ can only match at the beginning of the input */
+        if (anchored && cp2 != gData->cpbegin)
+            return NULL;
+        if (has_first_char) {
+            cp2 = memchrW(cp2, first_char, gData->cpend - cp2);
+            if (!cp2)
+                return NULL;
+        }
         gData->skipped = cp2 - cp;
         x->cp = cp2;
         for (j = 0; j < gData->regexp->parenCount; j++)
             x->parens[j].index = -1;
         result = ExecuteREBytecode(gData, x);
-        if (!gData->ok || result || (gData->regexp->flags & REG_STICKY))
+        if (!gData->ok || result || sticky)
             return result;
         gData->backTrackSP = gData->backTrackStack;
         gData->cursz = 0;
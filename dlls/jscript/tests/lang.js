@@ -1830,6 +1830,48 @@ ok(Object === 1, "Object = " + Object);
 Array = 1;
 ok(Array === 1, "Array = " + Array);
 
+function testMemberCache() {
+    function getX(o) { return o.x; }
+    function P() {}
+    P.prototype.x = "proto";
+
+    var o1 = {x: 1, y: 2}, o2 = {y: 3, x: 4}, o3 = new P(), o4 = {a: 1, b: 2};
+
+    ok(getX(o1) === 1, "getX(o1) = " + getX(o1));
+    ok(getX(o2) === 4, "getX(o2) = " + getX(o2));
+    ok(getX(o1) === 1, "getX(o1) = " + getX(o1));
+    ok(getX(o3) === "proto", "getX(o3) = " + getX(o3));
+    o3.x = "own";
+    ok(getX(o3) === "own", "getX(o3) = " + getX(o3));
+    delete o3.x;
+    ok(getX(o3) === "proto", "getX(o3) = " + getX(o3));
+    ok(getX(o4) === undefined, "getX(o4) = " + getX(o4));
+    delete o1.x;
+    ok(getX(o1) === undefined, "getX(o1) = " + getX(o1));
+    o1.x = 5;
+    ok(getX(o1) === 5, "getX(o1) = " + getX(o1));
+    ok(getX(o4) === undefined, "getX(o4) = " + getX(o4));
+}
+testMemberCache();
+
+function testStringAppend() {
+    var s = "", t = "", i;
+
+    for(i = 0; i < 3000; i++) {
+        s += String.fromCharCode(0x61 + i % 26);
+        if(i % 26 == 25)
+            t += "abcdefghijklmnopqrstuvwxyz";
+    }
+    t += "abcdefghijklmnopqrstuvwxyz".substr(0, 3000 % 26);
+
+    ok(s.length === 3000, "s.length = " + s.length);
+    ok(s.charAt(2999) === "l", "s.charAt(2999) = " + s.charAt(2999));
+    ok(s.substr(1040, 3) === "abc", "s.substr(1040, 3) = " + s.substr(1040, 3));
+    ok(s === t, "s !== t");
+    ok(s + "x" > t, "s + \"x\" <= t");
+}
+testStringAppend();
+
 Date = 1;
 ok(Date === 1, "Date = " + Date);
 
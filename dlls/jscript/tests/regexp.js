@@ -677,4 +677,18 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+m = /cd/.exec("abxcdcd");
+ok(m.index === 3, "m.index = " + m.index);
+m = /c/.exec("abab");
+ok(m === null, "m = " + m);
+m = /^ab/.exec("xab");
+ok(m === null, "m = " + m);
+m = /^ab/m.exec("x\nab");
+ok(m.index === 2, "m.index = " + m.index);
+re = /b/g;
+re.lastIndex = 2;
+m = re.exec("abab");
+ok(m.index === 3, "m.index = " + m.index);
+ok("a\u1234b".search(/\u1234/) === 1, "search returned " + "a\u1234b".search(/\u1234/));
+
 reportSuccess();
@@ -4051,6 +4051,65 @@ INT WINAPI CompareStringOrdinal(const WCHAR *str1, INT len1, const WCHAR *str2,
     return CSTR_EQUAL;
 }
 
+/* version of the sort keys and of the string comparisons; this needs to be
+ * increased whenever the collation table in libs/wine changes, so that
+ * applications caching sort keys know to rebuild them */
+#define NLS_SORT_VERSION  0x00060101
+
+/******************************************************************************
+ *           GetNLSVersion    (KERNEL32.@)
+ */
+BOOL WINAPI GetNLSVersion(NLS_FUNCTION func, LCID lcid, NLSVERSIONINFO *info)
+{
+    TRACE("(%d,%04x,%p)\n", func, lcid, info);
+
+    if (func != COMPARE_STRING)
+    {
+        SetLastError(ERROR_INVALID_FLAGS);
+        return FALSE;
+    }
+    if (!info || info->dwNLSVersionInfoSize < sizeof(*info))
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+        return FALSE;
+    }
+    info->dwNLSVersion = info->dwDefinedVersion = NLS_SORT_VERSION;
+    if (info->dwNLSVersionInfoSize >= sizeof(NLSVERSIONINFOEX))
+    {
+        NLSVERSIONINFOEX *infoex = (NLSVERSIONINFOEX *)info;
+        infoex->dwEffectiveId = ConvertDefaultLocale(lcid);
+        memset(&infoex->guidCustomVersion, 0, sizeof(infoex->guidCustomVersion));
+    }
+    return TRUE;
+}
+
+/******************************************************************************
+ *           GetNLSVersionEx    (KERNEL32.@)
+ */
+BOOL WINAPI GetNLSVersionEx(NLS_FUNCTION func, LPCWSTR locale, NLSVERSIONINFOEX *info)
+{
+    LCID lcid;
+
+    TRACE("(%d,%s,%p)\n", func, debugstr_w(locale), info);
+
+    if (func != COMPARE_STRING)
+    {
+        SetLastError(ERROR_INVALID_FLAGS);
+        return FALSE;
+    }
+    if (!info || info->dwNLSVersionInfoSize < sizeof(*info))
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+        return FALSE;
+    }
+    if (!(lcid = LocaleNameToLCID(locale, 0)))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    return GetNLSVersion(func, lcid, (NLSVERSIONINFO *)info);
+}
+
 /*************************************************************************
  *           lstrcmp     (KERNEL32.@)
  *           lstrcmpA    (KERNEL32.@)
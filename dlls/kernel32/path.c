@@ -27,6 +27,16 @@
 #include <errno.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_SYS_IOCTL_H
+# include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
 
 #include "winerror.h"
 #include "ntstatus.h"
@@ -43,6 +53,10 @@ WINE_DEFAULT_DEBUG_CHANNEL(file);
 
 #define MAX_PATHNAME_LEN        1024
 
+#if defined(__linux__) && !defined(FICLONE)
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+
 static int path_safe_mode = -1;  /* path mode set by SetSearchPathMode */
 
 /* check if a file name is for an executable file (.exe or .com) */
@@ -1149,6 +1163,81 @@ BOOL WINAPI CopyFileA( LPCSTR source, LPCSTR dest, BOOL fail_if_exists)
 }
 
 
+/* call the progress routine, PROGRESS_QUIET disables further notifications */
+static DWORD copy_progress( LPPROGRESS_ROUTINE *progress, void *param, BOOL *cancel_ptr,
+                            LARGE_INTEGER size, LARGE_INTEGER total, DWORD reason,
+                            HANDLE h1, HANDLE h2 )
+{
+    DWORD ret;
+
+    if (cancel_ptr && *cancel_ptr) return PROGRESS_CANCEL;
+    if (!*progress) return PROGRESS_CONTINUE;
+    ret = (*progress)( size, total, size, total, 1, reason, h1, h2, param );
+    if (ret == PROGRESS_QUIET)
+    {
+        *progress = NULL;
+        ret = PROGRESS_CONTINUE;
+    }
+    return ret;
+}
+
+#if defined(__linux__) && defined(__NR_copy_file_range)
+
+/* copy the file data inside the kernel, either by sharing the extents with the source
+ * or with copy_file_range(); whatever is left is copied by the caller with read/write */
+static DWORD copy_file_data_unix( HANDLE h1, HANDLE h2, LARGE_INTEGER size, LARGE_INTEGER *total,
+                                  LPPROGRESS_ROUTINE *progress, void *param, BOOL *cancel_ptr )
+{
+    static const size_t chunk_size = 16 * 1024 * 1024;
+    DWORD ret = PROGRESS_CONTINUE;
+    int fd1, fd2;
+
+    if (!size.QuadPart) return ret;
+    if (wine_server_handle_to_fd( h1, FILE_READ_DATA, &fd1, NULL )) return ret;
+    if (wine_server_handle_to_fd( h2, FILE_WRITE_DATA, &fd2, NULL ))
+    {
+        wine_server_release_fd( h1, fd1 );
+        return ret;
+    }
+
+    if (!ioctl( fd2, FICLONE, fd1 ))
+    {
+        TRACE( "cloned %s bytes\n", wine_dbgstr_longlong(size.QuadPart) );
+        *total = size;
+        ret = copy_progress( progress, param, cancel_ptr, size, *total,
+                             CALLBACK_CHUNK_FINISHED, h1, h2 );
+    }
+    else while (total->QuadPart < size.QuadPart)
+    {
+        LONGLONG in_pos = total->QuadPart, out_pos = total->QuadPart;
+        size_t len = min( size.QuadPart - total->QuadPart, chunk_size );
+        long res = syscall( __NR_copy_file_range, fd1, &in_pos, fd2, &out_pos, len, 0 );
+
+        if (res <= 0)
+        {
+            if (res < 0) TRACE( "copy_file_range failed: %s\n", strerror(errno) );
+            break;
+        }
+        total->QuadPart += res;
+        if ((ret = copy_progress( progress, param, cancel_ptr, size, *total,
+                                  CALLBACK_CHUNK_FINISHED, h1, h2 )) != PROGRESS_CONTINUE)
+            break;
+    }
+
+    wine_server_release_fd( h2, fd2 );
+    wine_server_release_fd( h1, fd1 );
+
+    /* the read/write loop continues where the kernel copy stopped */
+    if (total->QuadPart)
+    {
+        SetFilePointerEx( h1, *total, NULL, FILE_BEGIN );
+        SetFilePointerEx( h2, *total, NULL, FILE_BEGIN );
+    }
+    return ret;
+}
+
+#endif
+
 /**************************************************************************
  *           CopyFileExW   (KERNEL32.@)
  */
@@ -1159,7 +1248,8 @@ BOOL WINAPI CopyFileExW(LPCWSTR source, LPCWSTR dest,
     static const int buffer_size = 65536;
     HANDLE h1, h2;
     BY_HANDLE_FILE_INFORMATION info;
-    DWORD count;
+    LARGE_INTEGER size, total;
+    DWORD count, access, status = PROGRESS_CONTINUE;
     BOOL ret = FALSE;
     char *buffer;
 
@@ -1212,16 +1302,39 @@ BOOL WINAPI CopyFileExW(LPCWSTR source, LPCWSTR dest,
         }
     }
 
-    if ((h2 = CreateFileW( dest, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
-                             (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
-                             info.dwFileAttributes, h1 )) == INVALID_HANDLE_VALUE)
+    /* a cancelled copy deletes the destination, if other openers allow it */
+    access = GENERIC_WRITE;
+    if (progress || cancel_ptr) access |= DELETE;
+    for (;;)
     {
-        WARN("Unable to open dest %s\n", debugstr_w(dest));
-        HeapFree( GetProcessHeap(), 0, buffer );
-        CloseHandle( h1 );
-        return FALSE;
+        if ((h2 = CreateFileW( dest, access, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                               (flags & COPY_FILE_FAIL_IF_EXISTS) ? CREATE_NEW : CREATE_ALWAYS,
+                               info.dwFileAttributes, h1 )) != INVALID_HANDLE_VALUE)
+            break;
+        if (!(access & DELETE) || GetLastError() != ERROR_SHARING_VIOLATION)
+        {
+            WARN("Unable to open dest %s\n", debugstr_w(dest));
+            HeapFree( GetProcessHeap(), 0, buffer );
+            CloseHandle( h1 );
+            return FALSE;
+        }
+        access &= ~DELETE;
     }
 
+    size.u.LowPart  = info.nFileSizeLow;
+    size.u.HighPart = info.nFileSizeHigh;
+    total.QuadPart  = 0;
+
+    if ((status = copy_progress( &progress, param, cancel_ptr, size, total,
+                                 CALLBACK_STREAM_SWITCH, h1, h2 )) != PROGRESS_CONTINUE)
+        goto done;
+
+#if defined(__linux__) && defined(__NR_copy_file_range)
+    if ((status = copy_file_data_unix( h1, h2, size, &total,
+                                       &progress, param, cancel_ptr )) != PROGRESS_CONTINUE)
+        goto done;
+#endif
+
     while (ReadFile( h1, buffer, buffer_size, &count, NULL ) && count)
     {
         char *p = buffer;
@@ -1231,15 +1344,28 @@ BOOL WINAPI CopyFileExW(LPCWSTR source, LPCWSTR dest,
             if (!WriteFile( h2, p, count, &res, NULL ) || !res) goto done;
             p += res;
             count -= res;
+            total.QuadPart += res;
         }
+        if ((status = copy_progress( &progress, param, cancel_ptr, size, total,
+                                     CALLBACK_CHUNK_FINISHED, h1, h2 )) != PROGRESS_CONTINUE)
+            goto done;
     }
     ret =  TRUE;
 done:
-    /* Maintain the timestamp of source file to destination file */
-    SetFileTime(h2, NULL, NULL, &info.ftLastWriteTime);
+    if (status == PROGRESS_CANCEL)
+    {
+        FILE_DISPOSITION_INFO disp = { TRUE };
+        if (access & DELETE) SetFileInformationByHandle( h2, FileDispositionInfo, &disp, sizeof(disp) );
+    }
+    else
+    {
+        /* Maintain the timestamp of source file to destination file */
+        SetFileTime(h2, NULL, NULL, &info.ftLastWriteTime);
+    }
     HeapFree( GetProcessHeap(), 0, buffer );
     CloseHandle( h1 );
     CloseHandle( h2 );
+    if (status != PROGRESS_CONTINUE) SetLastError( ERROR_REQUEST_ABORTED );
     return ret;
 }
 
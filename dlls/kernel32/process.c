@@ -27,6 +27,7 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
@@ -1545,7 +1546,8 @@ static int fork_and_exec( const char *filename, const WCHAR *cmdline, const WCHA
 
     if (!(pid = fork()))  /* child */
     {
-        if (!(pid = fork()))  /* grandchild */
+        /* the child only waits for the exec, the grandchild can borrow its address space */
+        if (!(pid = vfork()))  /* grandchild */
         {
             close( fd[0] );
 
@@ -1883,7 +1885,8 @@ static pid_t exec_loader( LPCWSTR cmd_line, unsigned int flags, int socketfd,
 
     if (exec_only || !(pid = fork()))  /* child */
     {
-        if (exec_only || !(pid = fork()))  /* grandchild */
+        /* the child only waits for the exec, the grandchild can borrow its address space */
+        if (exec_only || !(pid = vfork()))  /* grandchild */
         {
             char preloader_reserve[64], socket_env[64];
 
@@ -3735,7 +3738,7 @@ BOOL WINAPI K32QueryWorkingSetEx( HANDLE process, LPVOID buffer, DWORD size )
 
     TRACE( "(%p, %p, %d)\n", process, buffer, size );
 
-    status = NtQueryVirtualMemory( process, NULL, MemoryWorkingSetList, buffer,  size, NULL );
+    status = NtQueryVirtualMemory( process, NULL, MemoryWorkingSetExInformation, buffer,  size, NULL );
 
     if (status)
     {
@@ -3910,6 +3913,160 @@ BOOL WINAPI GetLogicalProcessorInformationEx(LOGICAL_PROCESSOR_RELATIONSHIP rela
     return TRUE;
 }
 
+/***********************************************************************
+ *           GetSystemCpuSetInformation   (KERNEL32.@)
+ */
+BOOL WINAPI GetSystemCpuSetInformation(SYSTEM_CPU_SET_INFORMATION *info, ULONG len, ULONG *ret_len,
+                                       HANDLE process, ULONG flags)
+{
+    NTSTATUS status;
+
+    TRACE("(%p,%u,%p,%p,%#x)\n", info, len, ret_len, process, flags);
+
+    if (!ret_len)
+    {
+        SetLastError( ERROR_INVALID_PARAMETER );
+        return FALSE;
+    }
+
+    status = NtQuerySystemInformationEx( SystemCpuSetInformation, &process, sizeof(process),
+                                         info, len, ret_len );
+    if (status)
+    {
+        SetLastError( RtlNtStatusToDosError( status ) );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* cpu set ids map directly to the logical processors of group 0 */
+#define CPU_SET_ID_BASE 0x100
+
+static BOOL cpu_sets_to_mask( const ULONG *ids, ULONG count, DWORD_PTR *mask )
+{
+    DWORD_PTR process_mask, system_mask;
+    ULONG i;
+
+    if (!GetProcessAffinityMask( GetCurrentProcess(), &process_mask, &system_mask )) return FALSE;
+    if (!count)
+    {
+        *mask = 0;
+        return TRUE;
+    }
+    if (!ids)
+    {
+        SetLastError( ERROR_INVALID_PARAMETER );
+        return FALSE;
+    }
+
+    *mask = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (ids[i] < CPU_SET_ID_BASE || ids[i] - CPU_SET_ID_BASE >= 8 * sizeof(DWORD_PTR) ||
+            !(system_mask & ((DWORD_PTR)1 << (ids[i] - CPU_SET_ID_BASE))))
+        {
+            SetLastError( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        *mask |= (DWORD_PTR)1 << (ids[i] - CPU_SET_ID_BASE);
+    }
+    return TRUE;
+}
+
+static BOOL mask_to_cpu_sets( DWORD_PTR mask, DWORD_PTR full_mask, ULONG *ids, ULONG count, ULONG *required )
+{
+    ULONG i, nb = 0;
+
+    /* no selection when the mask is not restricted */
+    if ((mask & full_mask) == full_mask) mask = 0;
+
+    for (i = 0; i < 8 * sizeof(DWORD_PTR); i++)
+    {
+        if (!(mask & ((DWORD_PTR)1 << i))) continue;
+        if (nb < count && ids) ids[nb] = CPU_SET_ID_BASE + i;
+        nb++;
+    }
+    *required = nb;
+    if (nb > count)
+    {
+        SetLastError( ERROR_INSUFFICIENT_BUFFER );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/***********************************************************************
+ *           GetProcessDefaultCpuSets   (KERNEL32.@)
+ */
+BOOL WINAPI GetProcessDefaultCpuSets(HANDLE process, ULONG *ids, ULONG count, ULONG *required)
+{
+    DWORD_PTR process_mask, system_mask;
+
+    TRACE("(%p,%p,%u,%p)\n", process, ids, count, required);
+
+    if (!GetProcessAffinityMask( process, &process_mask, &system_mask )) return FALSE;
+    return mask_to_cpu_sets( process_mask, system_mask, ids, count, required );
+}
+
+/***********************************************************************
+ *           SetProcessDefaultCpuSets   (KERNEL32.@)
+ *
+ * The default cpu sets are applied as the process affinity.
+ */
+BOOL WINAPI SetProcessDefaultCpuSets(HANDLE process, const ULONG *ids, ULONG count)
+{
+    DWORD_PTR mask, process_mask, system_mask;
+
+    TRACE("(%p,%p,%u)\n", process, ids, count);
+
+    if (!cpu_sets_to_mask( ids, count, &mask )) return FALSE;
+    if (!mask)
+    {
+        if (!GetProcessAffinityMask( process, &process_mask, &system_mask )) return FALSE;
+        mask = system_mask;
+    }
+    return SetProcessAffinityMask( process, mask );
+}
+
+/***********************************************************************
+ *           GetThreadSelectedCpuSets   (KERNEL32.@)
+ */
+BOOL WINAPI GetThreadSelectedCpuSets(HANDLE thread, ULONG *ids, ULONG count, ULONG *required)
+{
+    THREAD_BASIC_INFORMATION info;
+    DWORD_PTR process_mask, system_mask;
+    NTSTATUS status;
+
+    TRACE("(%p,%p,%u,%p)\n", thread, ids, count, required);
+
+    if ((status = NtQueryInformationThread( thread, ThreadBasicInformation, &info, sizeof(info), NULL )))
+    {
+        SetLastError( RtlNtStatusToDosError( status ) );
+        return FALSE;
+    }
+    if (!GetProcessAffinityMask( GetCurrentProcess(), &process_mask, &system_mask )) return FALSE;
+    return mask_to_cpu_sets( info.AffinityMask, process_mask, ids, count, required );
+}
+
+/***********************************************************************
+ *           SetThreadSelectedCpuSets   (KERNEL32.@)
+ *
+ * The selected cpu sets are applied as the thread affinity, within the process affinity.
+ */
+BOOL WINAPI SetThreadSelectedCpuSets(HANDLE thread, const ULONG *ids, ULONG count)
+{
+    DWORD_PTR mask, process_mask, system_mask;
+
+    TRACE("(%p,%p,%u)\n", thread, ids, count);
+
+    if (!cpu_sets_to_mask( ids, count, &mask )) return FALSE;
+    if (!GetProcessAffinityMask( GetCurrentProcess(), &process_mask, &system_mask )) return FALSE;
+    /* like Windows, fall back to the process cpus if the selection is not available */
+    if (!mask || !(mask & process_mask)) mask = process_mask;
+    else mask &= process_mask;
+    return SetThreadAffinityMask( thread, mask ) != 0;
+}
+
 /***********************************************************************
  *           CmdBatNotification   (KERNEL32.@)
  *
@@ -3998,13 +4155,90 @@ HRESULT WINAPI RegisterApplicationRecoveryCallback(APPLICATION_RECOVERY_CALLBACK
     return E_FAIL;
 }
 
+/**********************************************************************
+ *           get_numa_nodes
+ *
+ * Retrieve the NUMA node entries of the host topology. Returned buffer must be freed by caller.
+ */
+static SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *get_numa_nodes( DWORD *len )
+{
+    LOGICAL_PROCESSOR_RELATIONSHIP relationship = RelationNumaNode;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info = NULL;
+    NTSTATUS status;
+
+    *len = 0;
+    status = NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relationship,
+                                         sizeof(relationship), NULL, 0, len );
+    if (status != STATUS_INFO_LENGTH_MISMATCH) return NULL;
+    if (!(info = HeapAlloc( GetProcessHeap(), 0, *len ))) return NULL;
+    status = NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relationship,
+                                         sizeof(relationship), info, *len, len );
+    if (status)
+    {
+        HeapFree( GetProcessHeap(), 0, info );
+        return NULL;
+    }
+    return info;
+}
+
+/**********************************************************************
+ *           get_numa_node_affinity
+ *
+ * Find the processors of a NUMA node.
+ */
+static BOOL get_numa_node_affinity( USHORT node, GROUP_AFFINITY *affinity )
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *entry;
+    DWORD len, pos;
+    BOOL ret = FALSE;
+
+    if (!(info = get_numa_nodes( &len ))) return FALSE;
+    for (pos = 0; pos < len; pos += entry->Size)
+    {
+        entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + pos);
+        if (entry->Relationship != RelationNumaNode || entry->NumaNode.NodeNumber != node) continue;
+        *affinity = entry->NumaNode.GroupMask;
+        ret = TRUE;
+        break;
+    }
+    HeapFree( GetProcessHeap(), 0, info );
+    return ret;
+}
+
 /**********************************************************************
  *           GetNumaHighestNodeNumber     (KERNEL32.@)
  */
 BOOL WINAPI GetNumaHighestNodeNumber(PULONG highestnode)
 {
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *entry;
+    DWORD len, pos;
+
+    TRACE("(%p)\n", highestnode);
+
     *highestnode = 0;
-    FIXME("(%p): semi-stub\n", highestnode);
+    if (!(info = get_numa_nodes( &len ))) return TRUE;
+    for (pos = 0; pos < len; pos += entry->Size)
+    {
+        entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + pos);
+        if (entry->Relationship == RelationNumaNode && entry->NumaNode.NodeNumber > *highestnode)
+            *highestnode = entry->NumaNode.NodeNumber;
+    }
+    HeapFree( GetProcessHeap(), 0, info );
+    return TRUE;
+}
+
+/**********************************************************************
+ *           GetNumaNodeProcessorMaskEx     (KERNEL32.@)
+ */
+BOOL WINAPI GetNumaNodeProcessorMaskEx(USHORT node, PGROUP_AFFINITY mask)
+{
+    TRACE("(%u %p)\n", node, mask);
+
+    if (!get_numa_node_affinity( node, mask ))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
     return TRUE;
 }
 
@@ -4013,9 +4247,17 @@ BOOL WINAPI GetNumaHighestNodeNumber(PULONG highestnode)
  */
 BOOL WINAPI GetNumaNodeProcessorMask(UCHAR node, PULONGLONG mask)
 {
-    FIXME("(%c %p): stub\n", node, mask);
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    GROUP_AFFINITY affinity;
+
+    TRACE("(%u %p)\n", node, mask);
+
+    if (!get_numa_node_affinity( node, &affinity ))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    *mask = affinity.Mask;
+    return TRUE;
 }
 
 /**********************************************************************
@@ -4023,8 +4265,92 @@ BOOL WINAPI GetNumaNodeProcessorMask(UCHAR node, PULONGLONG mask)
  */
 BOOL WINAPI GetNumaAvailableMemoryNode(UCHAR node, PULONGLONG available_bytes)
 {
-    FIXME("(%c %p): stub\n", node, available_bytes);
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
+    GROUP_AFFINITY affinity;
+#ifdef __linux__
+    char name[64], line[256];
+    unsigned long long kb;
+    FILE *f;
+#endif
+
+    TRACE("(%u %p)\n", node, available_bytes);
+
+    if (!get_numa_node_affinity( node, &affinity ))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+
+#ifdef __linux__
+    sprintf( name, "/sys/devices/system/node/node%u/meminfo", node );
+    if ((f = fopen( name, "r" )))
+    {
+        while (fgets( line, sizeof(line), f ))
+        {
+            char *p = strstr( line, "MemFree:" );
+            if (p && sscanf( p + 8, "%llu", &kb ) == 1)
+            {
+                fclose( f );
+                *available_bytes = kb * 1024;
+                return TRUE;
+            }
+        }
+        fclose( f );
+    }
+#endif
+    /* single node system, or no per-node information */
+    {
+        MEMORYSTATUSEX status;
+
+        status.dwLength = sizeof(status);
+        GlobalMemoryStatusEx( &status );
+        *available_bytes = status.ullAvailPhys;
+    }
+    return TRUE;
+}
+
+/***********************************************************************
+ *           GetNumaProcessorNodeEx (KERNEL32.@)
+ */
+BOOL WINAPI GetNumaProcessorNodeEx(PPROCESSOR_NUMBER processor, PUSHORT node)
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *entry;
+    DWORD len, pos;
+
+    TRACE("(%p, %p)\n", processor, node);
+
+    if (processor->Group || processor->Number >= 8 * sizeof(KAFFINITY))
+    {
+        *node = 0xffff;
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    if (!(info = get_numa_nodes( &len )))
+    {
+        SYSTEM_INFO si;
+
+        /* no topology information, assume a single node */
+        GetSystemInfo( &si );
+        if (processor->Number < si.dwNumberOfProcessors)
+        {
+            *node = 0;
+            return TRUE;
+        }
+        *node = 0xffff;
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    for (pos = 0; pos < len; pos += entry->Size)
+    {
+        entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)info + pos);
+        if (entry->Relationship != RelationNumaNode) continue;
+        if (!(entry->NumaNode.GroupMask.Mask & ((KAFFINITY)1 << processor->Number))) continue;
+        *node = entry->NumaNode.NodeNumber;
+        HeapFree( GetProcessHeap(), 0, info );
+        return TRUE;
+    }
+    HeapFree( GetProcessHeap(), 0, info );
+    *node = 0xffff;
+    SetLastError(ERROR_INVALID_PARAMETER);
     return FALSE;
 }
 
@@ -4033,19 +4359,21 @@ BOOL WINAPI GetNumaAvailableMemoryNode(UCHAR node, PULONGLONG available_bytes)
  */
 BOOL WINAPI GetNumaProcessorNode(UCHAR processor, PUCHAR node)
 {
-    SYSTEM_INFO si;
+    PROCESSOR_NUMBER number;
+    USHORT node_ex;
 
     TRACE("(%d, %p)\n", processor, node);
 
-    GetSystemInfo( &si );
-    if (processor < si.dwNumberOfProcessors)
+    number.Group = 0;
+    number.Number = processor;
+    number.Reserved = 0;
+    if (GetNumaProcessorNodeEx( &number, &node_ex ))
     {
-        *node = 0;
+        *node = node_ex;
         return TRUE;
     }
 
     *node = 0xFF;
-    SetLastError(ERROR_INVALID_PARAMETER);
     return FALSE;
 }
 
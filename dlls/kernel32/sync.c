@@ -2298,6 +2298,46 @@ BOOL WINAPI GetQueuedCompletionStatus( HANDLE CompletionPort, LPDWORD lpNumberOf
 }
 
 
+/******************************************************************************
+ *		GetQueuedCompletionStatusEx (KERNEL32.@)
+ */
+BOOL WINAPI GetQueuedCompletionStatusEx( HANDLE port, OVERLAPPED_ENTRY *entries, ULONG count,
+                                         ULONG *written, DWORD timeout, BOOL alertable )
+{
+    FILE_IO_COMPLETION_INFORMATION *info;
+    LARGE_INTEGER time;
+    NTSTATUS status;
+    ULONG i;
+
+    TRACE( "%p %p %u %p %u %u\n", port, entries, count, written, timeout, alertable );
+
+    if (!(info = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*info) )))
+    {
+        SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+        return FALSE;
+    }
+    status = NtRemoveIoCompletionEx( port, info, count, written,
+                                     get_nt_timeout( &time, timeout ), alertable );
+    if (status == STATUS_SUCCESS)
+    {
+        for (i = 0; i < *written; i++)
+        {
+            entries[i].lpCompletionKey            = info[i].CompletionKey;
+            entries[i].lpOverlapped               = (OVERLAPPED *)info[i].CompletionValue;
+            entries[i].Internal                   = info[i].IoStatusBlock.u.Status;
+            entries[i].dwNumberOfBytesTransferred = info[i].IoStatusBlock.Information;
+        }
+    }
+    HeapFree( GetProcessHeap(), 0, info );
+    if (status == STATUS_SUCCESS) return TRUE;
+
+    if (status == STATUS_TIMEOUT) SetLastError( WAIT_TIMEOUT );
+    else if (status == STATUS_USER_APC) SetLastError( WAIT_IO_COMPLETION );
+    else SetLastError( RtlNtStatusToDosError(status) );
+    return FALSE;
+}
+
+
 /******************************************************************************
  *		PostQueuedCompletionStatus (KERNEL32.@)
  */
@@ -1290,6 +1290,60 @@ static void test_dbcs_to_widechar(void)
     }
 }
 
+static void test_utf8_ascii_runs(void)
+{
+    /* ascii runs of various lengths around the multibyte chars */
+    static const char mixed[] = "0123456789abcdefghijklmnopqrstuvwxyz\xc3\xa9"
+                                "0123456789ABCDEF\xe2\x82\xac" "0123456789abcdef0123456789ABCDEF!"
+                                "\xf0\x9f\x98\x80x\xc3\xa9yz0123456789abcdefghijklmnopq";
+    WCHAR wide[256], expect[256];
+    char back[256];
+    int i, j, len, wlen, ret;
+
+    len = strlen(mixed);
+    wlen = 0;
+    for (i = 0; i < len; i++)
+    {
+        if (!memcmp(mixed + i, "\xc3\xa9", 2)) { expect[wlen++] = 0xe9; i += 1; }
+        else if (!memcmp(mixed + i, "\xe2\x82\xac", 3)) { expect[wlen++] = 0x20ac; i += 2; }
+        else if (!memcmp(mixed + i, "\xf0\x9f\x98\x80", 4))
+        {
+            expect[wlen++] = 0xd83d;
+            expect[wlen++] = 0xde00;
+            i += 3;
+        }
+        else expect[wlen++] = mixed[i];
+    }
+
+    for (i = 0; i < len; i++)
+    {
+        /* converting every suffix moves the runs across alignment boundaries */
+        if ((mixed[i] & 0xc0) == 0x80) continue;
+        ret = MultiByteToWideChar(CP_UTF8, 0, mixed + i, len - i, NULL, 0);
+        ok(ret > 0, "%d: MultiByteToWideChar failed\n", i);
+        memset(wide, 0xcc, sizeof(wide));
+        ret = MultiByteToWideChar(CP_UTF8, 0, mixed + i, len - i, wide, sizeof(wide)/sizeof(wide[0]));
+        ok(ret > 0 && !memcmp(wide, expect + wlen - ret, ret * sizeof(WCHAR)),
+           "%d: wrong conversion, ret %d\n", i, ret);
+
+        j = wlen - ret;
+        ret = WideCharToMultiByte(CP_UTF8, 0, expect + j, wlen - j, NULL, 0, NULL, NULL);
+        ok(ret == len - i, "%d: got length %d\n", i, ret);
+        memset(back, 0xcc, sizeof(back));
+        ret = WideCharToMultiByte(CP_UTF8, 0, expect + j, wlen - j, back, sizeof(back), NULL, NULL);
+        ok(ret == len - i && !memcmp(back, mixed + i, ret), "%d: wrong conversion, ret %d\n", i, ret);
+    }
+
+    /* destination too small in the middle of an ascii run */
+    SetLastError(0xdeadbeef);
+    ret = MultiByteToWideChar(CP_UTF8, 0, mixed, len, wide, 20);
+    ok(!ret && GetLastError() == ERROR_INSUFFICIENT_BUFFER, "got %d, error %u\n", ret, GetLastError());
+    ok(!memcmp(wide, expect, 20 * sizeof(WCHAR)), "wrong partial conversion\n");
+    SetLastError(0xdeadbeef);
+    ret = WideCharToMultiByte(CP_UTF8, 0, expect, wlen, back, 20, NULL, NULL);
+    ok(!ret && GetLastError() == ERROR_INSUFFICIENT_BUFFER, "got %d, error %u\n", ret, GetLastError());
+}
+
 START_TEST(codepage)
 {
     BOOL bUsedDefaultChar;
@@ -1312,4 +1366,5 @@ START_TEST(codepage)
     test_threadcp();
 
     test_dbcs_to_widechar();
+    test_utf8_ascii_runs();
 }
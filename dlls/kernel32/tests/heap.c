@@ -892,6 +892,76 @@ static void test_HeapQueryInformation(void)
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
 }
 
+static void test_low_fragmentation_heap(void)
+{
+    BYTE *ptrs[64], *p;
+    HANDLE heap;
+    ULONG info;
+    SIZE_T size;
+    BOOL ret;
+    int i;
+
+    if (!pHeapQueryInformation)
+    {
+        win_skip("HeapQueryInformation is not available\n");
+        return;
+    }
+
+    heap = HeapCreate(0, 0, 0);
+    ok(heap != NULL, "HeapCreate failed\n");
+
+    info = 2;
+    ret = HeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(ret, "HeapSetInformation error %u\n", GetLastError());
+
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation(heap, HeapCompatibilityInformation, &info, sizeof(info), NULL);
+    ok(ret, "HeapQueryInformation error %u\n", GetLastError());
+    ok(info == 2, "expected 2, got %u\n", info);
+
+    for (i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i++)
+    {
+        ptrs[i] = HeapAlloc(heap, HEAP_ZERO_MEMORY, 1 + i * 13);
+        ok(ptrs[i] != NULL, "HeapAlloc failed\n");
+        ok(!((ULONG_PTR)ptrs[i] & (2 * sizeof(void *) - 1)), "got unaligned pointer %p\n", ptrs[i]);
+        size = HeapSize(heap, 0, ptrs[i]);
+        ok(size == 1 + i * 13, "got size %lu for block %d\n", size, i);
+        ok(!ptrs[i][i * 13], "block %d not zeroed\n", i);
+        ok(HeapValidate(heap, 0, ptrs[i]), "HeapValidate failed for block %d\n", i);
+        memset(ptrs[i], 0xcc, 1 + i * 13);
+    }
+
+    p = HeapReAlloc(heap, 0, ptrs[10], 3000);
+    ok(p != NULL, "HeapReAlloc failed\n");
+    ok(p[10 * 13] == 0xcc, "got %#x\n", p[10 * 13]);
+    size = HeapSize(heap, 0, p);
+    ok(size == 3000, "got size %lu\n", size);
+    ptrs[10] = p;
+
+    p = HeapReAlloc(heap, HEAP_ZERO_MEMORY, ptrs[20], 20 * 13);
+    ok(p == ptrs[20], "HeapReAlloc moved the block\n");
+    ok(p[20 * 12] == 0xcc, "got %#x\n", p[20 * 12]);
+    size = HeapSize(heap, 0, p);
+    ok(size == 20 * 13, "got size %lu\n", size);
+
+    for (i = 0; i < sizeof(ptrs) / sizeof(ptrs[0]); i++)
+    {
+        ret = HeapFree(heap, 0, ptrs[i]);
+        ok(ret, "HeapFree failed for block %d\n", i);
+    }
+
+    ret = HeapDestroy(heap);
+    ok(ret, "HeapDestroy failed\n");
+
+    heap = HeapCreate(HEAP_NO_SERIALIZE, 0, 0);
+    ok(heap != NULL, "HeapCreate failed\n");
+    info = 2;
+    SetLastError(0xdeadbeef);
+    ret = HeapSetInformation(heap, HeapCompatibilityInformation, &info, sizeof(info));
+    ok(!ret, "HeapSetInformation succeeded\n");
+    HeapDestroy(heap);
+}
+
 static void test_heap_checks( DWORD flags )
 {
     BYTE old, *p, *p2;
@@ -1245,6 +1315,7 @@ START_TEST(heap)
     test_sized_HeapReAlloc((1 << 20), 1);
 
     test_HeapQueryInformation();
+    test_low_fragmentation_heap();
     test_GetPhysicallyInstalledSystemMemory();
 
     if (pRtlGetNtGlobalFlags)
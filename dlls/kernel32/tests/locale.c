@@ -103,6 +103,8 @@ static BOOL (WINAPI *pGetThreadPreferredUILanguages)(DWORD, ULONG*, WCHAR*, ULON
 static BOOL (WINAPI *pGetUserPreferredUILanguages)(DWORD, ULONG*, WCHAR*, ULONG*);
 static WCHAR (WINAPI *pRtlUpcaseUnicodeChar)(WCHAR);
 static INT (WINAPI *pGetNumberFormatEx)(LPCWSTR, DWORD, LPCWSTR, const NUMBERFMTW *, LPWSTR, int);
+static BOOL (WINAPI *pGetNLSVersion)(NLS_FUNCTION, LCID, LPNLSVERSIONINFO);
+static BOOL (WINAPI *pGetNLSVersionEx)(NLS_FUNCTION, LPCWSTR, LPNLSVERSIONINFOEX);
 
 static void InitFunctionPointers(void)
 {
@@ -135,6 +137,8 @@ static void InitFunctionPointers(void)
   X(GetThreadPreferredUILanguages);
   X(GetUserPreferredUILanguages);
   X(GetNumberFormatEx);
+  X(GetNLSVersion);
+  X(GetNLSVersionEx);
 
   mod = GetModuleHandleA("ntdll");
   X(RtlUpcaseUnicodeChar);
@@ -5192,6 +5196,50 @@ static void test_GetThreadPreferredUILanguages(void)
     HeapFree(GetProcessHeap(), 0, buf);
 }
 
+static void test_GetNLSVersion(void)
+{
+    static const WCHAR enW[] = {'e','n','-','U','S',0};
+    NLSVERSIONINFOEX infoex, infoex2;
+    NLSVERSIONINFO info;
+    BOOL ret;
+
+    if (!pGetNLSVersion)
+    {
+        win_skip("GetNLSVersion not available\n");
+        return;
+    }
+
+    memset(&info, 0, sizeof(info));
+    info.dwNLSVersionInfoSize = sizeof(info);
+    ret = pGetNLSVersion(COMPARE_STRING, LOCALE_USER_DEFAULT, &info);
+    ok(ret, "GetNLSVersion failed, error %u\n", GetLastError());
+    ok(info.dwNLSVersion != 0, "got zero version\n");
+
+    SetLastError(0xdeadbeef);
+    ret = pGetNLSVersion(0, LOCALE_USER_DEFAULT, &info);
+    ok(!ret, "GetNLSVersion succeeded for an invalid function\n");
+
+    if (!pGetNLSVersionEx)
+    {
+        win_skip("GetNLSVersionEx not available\n");
+        return;
+    }
+
+    /* the version must be stable so that sort keys can be cached */
+    memset(&infoex, 0, sizeof(infoex));
+    infoex.dwNLSVersionInfoSize = sizeof(infoex);
+    ret = pGetNLSVersionEx(COMPARE_STRING, enW, &infoex);
+    ok(ret, "GetNLSVersionEx failed, error %u\n", GetLastError());
+    memset(&infoex2, 0, sizeof(infoex2));
+    infoex2.dwNLSVersionInfoSize = sizeof(infoex2);
+    ret = pGetNLSVersionEx(COMPARE_STRING, enW, &infoex2);
+    ok(ret, "GetNLSVersionEx failed, error %u\n", GetLastError());
+    ok(infoex.dwNLSVersion == infoex2.dwNLSVersion, "version changed from %x to %x\n",
+       infoex.dwNLSVersion, infoex2.dwNLSVersion);
+    ok(infoex.dwEffectiveId == MAKELCID(MAKELANGID(LANG_ENGLISH, SUBLANG_ENGLISH_US), SORT_DEFAULT),
+       "got effective id %04x\n", infoex.dwEffectiveId);
+}
+
 static void test_GetUserPreferredUILanguages(void)
 {
     BOOL ret;
@@ -5375,6 +5423,7 @@ START_TEST(locale)
   test_GetSystemPreferredUILanguages();
   test_GetThreadPreferredUILanguages();
   test_GetUserPreferredUILanguages();
+  test_GetNLSVersion();
   /* this requires collation table patch to make it MS compatible */
   if (0) test_sorting();
 }
@@ -78,6 +78,11 @@ static BOOL   (WINAPI *pQueryInformationJobObject)(HANDLE job, JOBOBJECTINFOCLAS
 static BOOL   (WINAPI *pSetInformationJobObject)(HANDLE job, JOBOBJECTINFOCLASS class, LPVOID info, DWORD len);
 static HANDLE (WINAPI *pCreateIoCompletionPort)(HANDLE file, HANDLE existing_port, ULONG_PTR key, DWORD threads);
 static BOOL   (WINAPI *pGetNumaProcessorNode)(UCHAR, PUCHAR);
+static BOOL   (WINAPI *pGetNumaHighestNodeNumber)(PULONG);
+static BOOL   (WINAPI *pGetNumaNodeProcessorMask)(UCHAR, PULONGLONG);
+static BOOL   (WINAPI *pGetSystemCpuSetInformation)(SYSTEM_CPU_SET_INFORMATION *, ULONG, ULONG *, HANDLE, ULONG);
+static BOOL   (WINAPI *pGetThreadSelectedCpuSets)(HANDLE, ULONG *, ULONG, ULONG *);
+static BOOL   (WINAPI *pSetThreadSelectedCpuSets)(HANDLE, const ULONG *, ULONG);
 static NTSTATUS (WINAPI *pNtQueryInformationProcess)(HANDLE, PROCESSINFOCLASS, PVOID, ULONG, PULONG);
 static BOOL   (WINAPI *pProcessIdToSessionId)(DWORD,DWORD*);
 static DWORD  (WINAPI *pWTSGetActiveConsoleSessionId)(void);
@@ -246,6 +251,11 @@ static BOOL init(void)
     pSetInformationJobObject = (void *)GetProcAddress(hkernel32, "SetInformationJobObject");
     pCreateIoCompletionPort = (void *)GetProcAddress(hkernel32, "CreateIoCompletionPort");
     pGetNumaProcessorNode = (void *)GetProcAddress(hkernel32, "GetNumaProcessorNode");
+    pGetNumaHighestNodeNumber = (void *)GetProcAddress(hkernel32, "GetNumaHighestNodeNumber");
+    pGetNumaNodeProcessorMask = (void *)GetProcAddress(hkernel32, "GetNumaNodeProcessorMask");
+    pGetSystemCpuSetInformation = (void *)GetProcAddress(hkernel32, "GetSystemCpuSetInformation");
+    pGetThreadSelectedCpuSets = (void *)GetProcAddress(hkernel32, "GetThreadSelectedCpuSets");
+    pSetThreadSelectedCpuSets = (void *)GetProcAddress(hkernel32, "SetThreadSelectedCpuSets");
     pProcessIdToSessionId = (void *)GetProcAddress(hkernel32, "ProcessIdToSessionId");
     pWTSGetActiveConsoleSessionId = (void *)GetProcAddress(hkernel32, "WTSGetActiveConsoleSessionId");
     pCreateToolhelp32Snapshot = (void *)GetProcAddress(hkernel32, "CreateToolhelp32Snapshot");
@@ -3442,6 +3452,101 @@ static void test_GetNumaProcessorNode(void)
     }
 }
 
+static void test_GetNumaNodeProcessorMask(void)
+{
+    ULONGLONG mask, all_mask = 0;
+    ULONG highest, i;
+    UCHAR node;
+    SYSTEM_INFO si;
+    BOOL ret;
+
+    if (!pGetNumaHighestNodeNumber || !pGetNumaNodeProcessorMask)
+    {
+        win_skip("GetNumaNodeProcessorMask is missing\n");
+        return;
+    }
+
+    ret = pGetNumaHighestNodeNumber(&highest);
+    ok(ret, "GetNumaHighestNodeNumber failed, error %u\n", GetLastError());
+
+    for (i = 0; i <= highest; i++)
+    {
+        mask = 0;
+        if (!pGetNumaNodeProcessorMask(i, &mask)) continue;
+        ok(!(mask & all_mask), "node %u shares processors with another node\n", i);
+        all_mask |= mask;
+    }
+    ok(all_mask != 0, "no processors found in any node\n");
+
+    SetLastError(0xdeadbeef);
+    ret = pGetNumaNodeProcessorMask(0xff, &mask);
+    ok(!ret, "GetNumaNodeProcessorMask succeeded for an invalid node\n");
+    ok(GetLastError() == ERROR_INVALID_PARAMETER, "expected ERROR_INVALID_PARAMETER, got %d\n", GetLastError());
+
+    GetSystemInfo(&si);
+    for (i = 0; i < si.dwNumberOfProcessors && i < 64; i++)
+    {
+        if (!(si.dwActiveProcessorMask & ((DWORD_PTR)1 << i))) continue;
+        ret = pGetNumaProcessorNode(i, &node);
+        ok(ret, "GetNumaProcessorNode failed for processor %u\n", i);
+        if (!ret) continue;
+        ret = pGetNumaNodeProcessorMask(node, &mask);
+        ok(ret, "GetNumaNodeProcessorMask failed for node %u\n", node);
+        ok(mask & ((ULONGLONG)1 << i), "processor %u not in mask %s of node %u\n", i,
+           wine_dbgstr_longlong(mask), node);
+    }
+}
+
+static void test_CpuSets(void)
+{
+    SYSTEM_CPU_SET_INFORMATION *info;
+    ULONG len = 0, ids[64], count, i;
+    SYSTEM_INFO si;
+    BOOL ret;
+
+    if (!pGetSystemCpuSetInformation)
+    {
+        win_skip("GetSystemCpuSetInformation is missing\n");
+        return;
+    }
+
+    SetLastError(0xdeadbeef);
+    ret = pGetSystemCpuSetInformation(NULL, 0, &len, GetCurrentProcess(), 0);
+    ok(!ret, "GetSystemCpuSetInformation succeeded\n");
+    ok(GetLastError() == ERROR_INSUFFICIENT_BUFFER, "got error %u\n", GetLastError());
+    ok(len && !(len % sizeof(*info)), "got len %u\n", len);
+
+    info = HeapAlloc(GetProcessHeap(), 0, len);
+    ret = pGetSystemCpuSetInformation(info, len, &len, GetCurrentProcess(), 0);
+    ok(ret, "GetSystemCpuSetInformation failed, error %u\n", GetLastError());
+    count = len / sizeof(*info);
+    GetSystemInfo(&si);
+    ok(count == si.dwNumberOfProcessors, "got %u cpu sets for %u processors\n", count, si.dwNumberOfProcessors);
+    for (i = 0; i < count; i++)
+    {
+        ok(info[i].Size == sizeof(*info), "got size %u\n", info[i].Size);
+        ok(info[i].Type == CpuSetInformation, "got type %u\n", info[i].Type);
+        ok(info[i].CpuSet.CoreIndex <= info[i].CpuSet.LogicalProcessorIndex,
+           "core index %u after processor %u\n", info[i].CpuSet.CoreIndex, info[i].CpuSet.LogicalProcessorIndex);
+    }
+
+    if (pSetThreadSelectedCpuSets && count > 1)
+    {
+        ret = pSetThreadSelectedCpuSets(GetCurrentThread(), &info[0].CpuSet.Id, 1);
+        ok(ret, "SetThreadSelectedCpuSets failed, error %u\n", GetLastError());
+        ret = pGetThreadSelectedCpuSets(GetCurrentThread(), ids, sizeof(ids)/sizeof(ids[0]), &count);
+        ok(ret, "GetThreadSelectedCpuSets failed, error %u\n", GetLastError());
+        ok(count == 1 && ids[0] == info[0].CpuSet.Id, "got %u ids, first %#x\n", count, ids[0]);
+
+        ret = pSetThreadSelectedCpuSets(GetCurrentThread(), NULL, 0);
+        ok(ret, "SetThreadSelectedCpuSets failed, error %u\n", GetLastError());
+        ret = pGetThreadSelectedCpuSets(GetCurrentThread(), ids, sizeof(ids)/sizeof(ids[0]), &count);
+        ok(ret, "GetThreadSelectedCpuSets failed, error %u\n", GetLastError());
+        ok(!count, "got %u ids\n", count);
+    }
+    HeapFree(GetProcessHeap(), 0, info);
+}
+
 static void test_session_info(void)
 {
     DWORD session_id, active_session;
@@ -3845,6 +3950,8 @@ START_TEST(process)
     test_DetachConsoleHandles();
     test_DetachStdHandles();
     test_GetNumaProcessorNode();
+    test_GetNumaNodeProcessorMask();
+    test_CpuSets();
     test_session_info();
     test_GetLogicalProcessorInformationEx();
     test_largepages();
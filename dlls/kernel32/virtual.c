@@ -101,6 +101,36 @@ LPVOID WINAPI VirtualAllocEx( HANDLE hProcess, LPVOID addr, SIZE_T size,
 }
 
 
+/***********************************************************************
+ *             VirtualAllocExNuma   (KERNEL32.@)
+ *
+ * Same as VirtualAllocEx, with the pages preferably taken from the specified NUMA node.
+ */
+LPVOID WINAPI VirtualAllocExNuma( HANDLE process, void *addr, SIZE_T size, DWORD type,
+                                  DWORD protect, DWORD node )
+{
+    LPVOID ret = addr;
+    NTSTATUS status;
+
+    /* the preferred node is passed in the low bits of the allocation type */
+    if (node != NUMA_NO_PREFERRED_NODE)
+    {
+        if (node >= 0x3f)
+        {
+            SetLastError( ERROR_INVALID_PARAMETER );
+            return NULL;
+        }
+        type |= node + 1;
+    }
+    if ((status = NtAllocateVirtualMemory( process, &ret, 0, &size, type, protect )))
+    {
+        SetLastError( RtlNtStatusToDosError(status) );
+        ret = NULL;
+    }
+    return ret;
+}
+
+
 /***********************************************************************
  *             VirtualFree   (KERNEL32.@)
  *
@@ -163,10 +163,142 @@ static UINT CDECL cabinet_read(INT_PTR hf, void *pv, UINT cb)
     return 0;
 }
 
+/* decompressed data is written out by a separate thread, so that writing a
+ * block to disk overlaps with decompressing the next one. The queue is
+ * written in order, and it is drained before a file is closed. */
+#define CABINET_WRITE_QUEUE_SIZE 16
+
+struct cabinet_write
+{
+    HANDLE handle;
+    void  *data;
+    UINT   size;
+};
+
+static CRITICAL_SECTION cabinet_write_cs;
+static CRITICAL_SECTION_DEBUG cabinet_write_cs_debug =
+{
+    0, 0, &cabinet_write_cs,
+    { &cabinet_write_cs_debug.ProcessLocksList,
+      &cabinet_write_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": cabinet_write_cs") }
+};
+static CRITICAL_SECTION cabinet_write_cs = { &cabinet_write_cs_debug, -1, 0, 0, 0, 0 };
+static CONDITION_VARIABLE cabinet_write_cv = CONDITION_VARIABLE_INIT;
+
+static struct cabinet_write cabinet_write_queue[CABINET_WRITE_QUEUE_SIZE];
+static UINT cabinet_write_head, cabinet_write_count;
+static UINT cabinet_write_users, cabinet_write_generation;
+static HANDLE cabinet_write_thread;
+
+static DWORD WINAPI cabinet_write_proc( void *arg )
+{
+    UINT generation = PtrToUlong( arg );
+    struct cabinet_write *entry;
+    DWORD written;
+
+    EnterCriticalSection( &cabinet_write_cs );
+    while (generation == cabinet_write_generation)
+    {
+        if (!cabinet_write_count)
+        {
+            SleepConditionVariableCS( &cabinet_write_cv, &cabinet_write_cs, INFINITE );
+            continue;
+        }
+
+        /* the entry stays queued while it is written, so that draining the queue waits for it */
+        entry = &cabinet_write_queue[cabinet_write_head];
+        LeaveCriticalSection( &cabinet_write_cs );
+
+        if (!WriteFile( entry->handle, entry->data, entry->size, &written, NULL ) || written != entry->size)
+            WARN("failed to write %u bytes (error %u)\n", entry->size, GetLastError());
+        msi_free( entry->data );
+
+        EnterCriticalSection( &cabinet_write_cs );
+        cabinet_write_head = (cabinet_write_head + 1) % CABINET_WRITE_QUEUE_SIZE;
+        cabinet_write_count--;
+        WakeAllConditionVariable( &cabinet_write_cv );
+    }
+    LeaveCriticalSection( &cabinet_write_cs );
+    return 0;
+}
+
+static void cabinet_write_start(void)
+{
+    EnterCriticalSection( &cabinet_write_cs );
+    if (!cabinet_write_users++)
+    {
+        cabinet_write_thread = CreateThread( NULL, 0, cabinet_write_proc,
+                                             ULongToPtr( cabinet_write_generation ), 0, NULL );
+        if (!cabinet_write_thread)
+            WARN("failed to create writer thread (error %u), writing synchronously\n", GetLastError());
+    }
+    LeaveCriticalSection( &cabinet_write_cs );
+}
+
+/* caller must hold cabinet_write_cs */
+static void cabinet_write_drain(void)
+{
+    while (cabinet_write_count)
+        SleepConditionVariableCS( &cabinet_write_cv, &cabinet_write_cs, INFINITE );
+}
+
+static void cabinet_write_flush(void)
+{
+    EnterCriticalSection( &cabinet_write_cs );
+    cabinet_write_drain();
+    LeaveCriticalSection( &cabinet_write_cs );
+}
+
+static void cabinet_write_stop(void)
+{
+    HANDLE thread = NULL;
+
+    EnterCriticalSection( &cabinet_write_cs );
+    cabinet_write_drain();
+    if (!--cabinet_write_users)
+    {
+        /* the queue is empty, a writer started after this point uses a new generation */
+        cabinet_write_generation++;
+        thread = cabinet_write_thread;
+        cabinet_write_thread = NULL;
+        WakeAllConditionVariable( &cabinet_write_cv );
+    }
+    LeaveCriticalSection( &cabinet_write_cs );
+
+    if (thread)
+    {
+        WaitForSingleObject( thread, INFINITE );
+        CloseHandle( thread );
+    }
+}
+
 static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 {
     HANDLE handle = (HANDLE)hf;
+    struct cabinet_write *entry;
     DWORD written;
+    void *data;
+
+    EnterCriticalSection( &cabinet_write_cs );
+    if (cabinet_write_thread && (data = msi_alloc( cb )))
+    {
+        memcpy( data, pv, cb );
+        while (cabinet_write_count == CABINET_WRITE_QUEUE_SIZE)
+            SleepConditionVariableCS( &cabinet_write_cv, &cabinet_write_cs, INFINITE );
+
+        entry = &cabinet_write_queue[(cabinet_write_head + cabinet_write_count) % CABINET_WRITE_QUEUE_SIZE];
+        entry->handle = handle;
+        entry->data   = data;
+        entry->size   = cb;
+        cabinet_write_count++;
+        WakeAllConditionVariable( &cabinet_write_cv );
+        LeaveCriticalSection( &cabinet_write_cs );
+        return cb;
+    }
+    /* keep the data in order with what is already queued */
+    cabinet_write_drain();
+    LeaveCriticalSection( &cabinet_write_cs );
 
     if (WriteFile(handle, pv, cb, &written, NULL))
         return written;
@@ -177,6 +309,8 @@ static UINT CDECL cabinet_write(INT_PTR hf, void *pv, UINT cb)
 static int CDECL cabinet_close(INT_PTR hf)
 {
     HANDLE handle = (HANDLE)hf;
+
+    cabinet_write_flush();
     return CloseHandle(handle) ? 0 : -1;
 }
 
@@ -513,6 +647,9 @@ static INT_PTR cabinet_close_file_info(FDINOTIFICATIONTYPE fdint,
 
     data->mi->is_continuous = FALSE;
 
+    /* make sure all the data is written before setting the time and closing */
+    cabinet_write_flush();
+
     if (!DosDateTimeToFileTime(pfdin->date, pfdin->time, &ft))
         return -1;
     if (!LocalFileTimeToFileTime(&ft, &ftLocal))
@@ -602,7 +739,9 @@ static BOOL extract_cabinet( MSIPACKAGE* package, MSIMEDIAINFO *mi, LPVOID data
     if (!cab_path)
         goto done;
 
+    cabinet_write_start();
     ret = FDICopy( hfdi, cabinet, cab_path, 0, cabinet_notify, NULL, data );
+    cabinet_write_stop();
     if (!ret)
         ERR("FDICopy failed\n");
 
@@ -637,7 +776,9 @@ static BOOL extract_cabinet_stream( MSIPACKAGE *package, MSIMEDIAINFO *mi, LPVOI
     package_disk.package = package;
     package_disk.id      = mi->disk_id;
 
+    cabinet_write_start();
     ret = FDICopy( hfdi, filename, NULL, 0, cabinet_notify_stream, NULL, data );
+    cabinet_write_stop();
     if (!ret) ERR("FDICopy failed\n");
 
     FDIDestroy( hfdi );
@@ -40,6 +40,7 @@
 WINE_DEFAULT_DEBUG_CHANNEL(msidb);
 
 #define MSITABLE_HASH_TABLE_SIZE 37
+#define MSITABLE_HASH_TABLE_MAX_SIZE 0x10000
 
 typedef struct tagMSICOLUMNHASHENTRY
 {
@@ -58,6 +59,7 @@ typedef struct tagMSICOLUMNINFO
     INT     ref_count;
     BOOL    temporary;
     MSICOLUMNHASHENTRY **hash_table;
+    UINT    hash_size;
 } MSICOLUMNINFO;
 
 struct tagMSITABLE
@@ -1672,6 +1674,13 @@ static UINT TABLE_insert_row( struct tagMSIVIEW *view, MSIRECORD *rec, UINT row,
         tv->table->data_persistent[i] = tv->table->data_persistent[i - 1];
     }
 
+    /* the rows have moved, reset the hash tables */
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        msi_free( tv->columns[i].hash_table );
+        tv->columns[i].hash_table = NULL;
+    }
+
     /* Re-set the persistence flag */
     tv->table->data_persistent[row] = !temporary;
     return TABLE_set_row( view, row, rec, (1<<tv->num_cols) - 1 );
@@ -1893,7 +1902,7 @@ static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col,
 
     if( !tv->columns[col-1].hash_table )
     {
-        UINT i;
+        UINT i, size;
         UINT num_rows = tv->table->row_count;
         MSICOLUMNHASHENTRY **hash_table;
         MSICOLUMNHASHENTRY *new_entry;
@@ -1905,42 +1914,43 @@ static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col,
             return ERROR_FUNCTION_FAILED;
         }
 
+        /* keep the chains short on big tables, the values are mostly
+         * string ids which are dense, so a plain modulo spreads them well */
+        size = MSITABLE_HASH_TABLE_SIZE;
+        while (size < num_rows && size < MSITABLE_HASH_TABLE_MAX_SIZE)
+            size = size * 2 + 1;
+
         /* allocate contiguous memory for the table and its entries so we
          * don't have to do an expensive cleanup */
-        hash_table = msi_alloc(MSITABLE_HASH_TABLE_SIZE * sizeof(MSICOLUMNHASHENTRY*) +
+        hash_table = msi_alloc(size * sizeof(MSICOLUMNHASHENTRY*) +
             num_rows * sizeof(MSICOLUMNHASHENTRY));
         if (!hash_table)
             return ERROR_OUTOFMEMORY;
 
-        memset(hash_table, 0, MSITABLE_HASH_TABLE_SIZE * sizeof(MSICOLUMNHASHENTRY*));
+        memset(hash_table, 0, size * sizeof(MSICOLUMNHASHENTRY*));
         tv->columns[col-1].hash_table = hash_table;
+        tv->columns[col-1].hash_size = size;
 
-        new_entry = (MSICOLUMNHASHENTRY *)(hash_table + MSITABLE_HASH_TABLE_SIZE);
+        new_entry = (MSICOLUMNHASHENTRY *)(hash_table + size);
 
-        for (i = 0; i < num_rows; i++, new_entry++)
+        /* insert at the head of the chains starting from the last row,
+         * so that each chain ends up in row order */
+        for (i = num_rows; i > 0; i--, new_entry++)
         {
             UINT row_value;
 
-            if (view->ops->fetch_int( view, i, col, &row_value ) != ERROR_SUCCESS)
+            if (view->ops->fetch_int( view, i - 1, col, &row_value ) != ERROR_SUCCESS)
                 continue;
 
-            new_entry->next = NULL;
             new_entry->value = row_value;
-            new_entry->row = i;
-            if (hash_table[row_value % MSITABLE_HASH_TABLE_SIZE])
-            {
-                MSICOLUMNHASHENTRY *prev_entry = hash_table[row_value % MSITABLE_HASH_TABLE_SIZE];
-                while (prev_entry->next)
-                    prev_entry = prev_entry->next;
-                prev_entry->next = new_entry;
-            }
-            else
-                hash_table[row_value % MSITABLE_HASH_TABLE_SIZE] = new_entry;
+            new_entry->row = i - 1;
+            new_entry->next = hash_table[row_value % size];
+            hash_table[row_value % size] = new_entry;
         }
     }
 
     if( !*handle )
-        entry = tv->columns[col-1].hash_table[val % MSITABLE_HASH_TABLE_SIZE];
+        entry = tv->columns[col-1].hash_table[val % tv->columns[col-1].hash_size];
     else
         entry = (*handle)->next;
 
@@ -2500,10 +2510,30 @@ static UINT msi_row_matches( MSITABLEVIEW *tv, UINT row, const UINT *data, UINT
 static UINT msi_table_find_row( MSITABLEVIEW *tv, MSIRECORD *rec, UINT *row, UINT *column )
 {
     UINT i, r = ERROR_FUNCTION_FAILED, *data;
+    MSIITERHANDLE handle = NULL;
 
     data = msi_record_to_row( tv, rec );
     if( !data )
         return r;
+
+    /* only look at the rows matching the first key column */
+    for( i = 0; i < tv->num_cols; i++ )
+        if ( tv->columns[i].type & MSITYPE_KEY ) break;
+
+    if( i < tv->num_cols &&
+        TABLE_find_matching_rows( &tv->view, i + 1, data[i], row, &handle ) != ERROR_OUTOFMEMORY )
+    {
+        while( handle )
+        {
+            r = msi_row_matches( tv, *row, data, column );
+            if( r == ERROR_SUCCESS ) break;
+            if( TABLE_find_matching_rows( &tv->view, i + 1, data[i], row, &handle ) != ERROR_SUCCESS )
+                r = ERROR_FUNCTION_FAILED;
+        }
+        msi_free( data );
+        return r;
+    }
+
     for( i = 0; i < tv->table->row_count; i++ )
     {
         r = msi_row_matches( tv, i, data, column );
@@ -54,6 +54,15 @@ typedef struct tagJOINTABLE
     UINT table_index;
 } JOINTABLE;
 
+/* an equality between a column of a table and a value that is known as soon
+ * as the tables before it in the join order are positioned on a row */
+typedef struct tagJOINKEY
+{
+    const struct expr *column;  /* column of the table being iterated */
+    const struct expr *value;   /* constant, parameter or column of an earlier table */
+    UINT rec_index;             /* record index of the value if it is a parameter */
+} JOINKEY;
+
 typedef struct tagMSIORDERINFO
 {
     UINT col_count;
@@ -599,16 +608,95 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+/* computes the value the key column must have. returns ERROR_NO_MORE_ITEMS
+ * if no row can match and ERROR_FUNCTION_FAILED if all rows must be checked */
+static UINT join_key_value( MSIWHEREVIEW *wv, const JOINKEY *key, const UINT rows[],
+                            MSIRECORD *record, UINT *val )
+{
+    const WCHAR *str;
+    UINT r;
+
+    switch (key->value->type)
+    {
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+        r = expr_fetch_value(&key->value->u.column, rows, val);
+        return r == ERROR_SUCCESS ? r : ERROR_FUNCTION_FAILED;
+
+    case EXPR_COL_NUMBER_STRING:
+        /* null and empty strings compare equal, they need a full scan */
+        r = expr_fetch_value(&key->value->u.column, rows, val);
+        if (r != ERROR_SUCCESS || !*val)
+            return ERROR_FUNCTION_FAILED;
+        str = msi_string_lookup(wv->db->strings, *val, NULL);
+        return str && *str ? ERROR_SUCCESS : ERROR_FUNCTION_FAILED;
+
+    case EXPR_UVAL:
+        *val = key->value->u.uval;
+        break;
+
+    case EXPR_SVAL:
+        str = key->value->u.sval;
+        goto string;
+
+    case EXPR_WILDCARD:
+        if (!record)
+            return ERROR_FUNCTION_FAILED;
+        if (key->column->type == EXPR_COL_NUMBER_STRING)
+        {
+            str = MSI_RecordGetString(record, key->rec_index);
+            goto string;
+        }
+        *val = MSI_RecordGetInteger(record, key->rec_index);
+        break;
+
+    default:
+        return ERROR_FUNCTION_FAILED;
+    }
+
+    /* integers are stored with an offset, see WHERE_evaluate */
+    *val += key->column->type == EXPR_COL_NUMBER ? 0x8000 : 0x80000000;
+    return ERROR_SUCCESS;
+
+string:
+    if (!str || !*str)
+        return ERROR_FUNCTION_FAILED;
+    if (msi_string2id(wv->db->strings, str, -1, val) != ERROR_SUCCESS)
+        return ERROR_NO_MORE_ITEMS;
+    return ERROR_SUCCESS;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **tables,
-                             UINT table_rows[] )
+                             const JOINKEY *keys, UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    JOINTABLE *table = *tables;
+    MSIITERHANDLE handle = NULL;
+    UINT r = ERROR_SUCCESS, row, key_val;
+    BOOL indexed = FALSE;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    if (keys->column)
+    {
+        r = join_key_value(wv, keys, table_rows, record, &key_val);
+        if (r == ERROR_NO_MORE_ITEMS)
+            return ERROR_SUCCESS;
+        indexed = (r == ERROR_SUCCESS);
+        r = ERROR_SUCCESS;
+    }
+
+    for (row = 0;; row++)
     {
+        if (indexed)
+        {
+            /* only visit the rows the key column lets through */
+            if (table->view->ops->find_matching_rows(table->view, keys->column->u.column.parsed.column,
+                                                     key_val, &row, &handle) != ERROR_SUCCESS)
+                break;
+        }
+        else if (row >= table->row_count)
+            break;
+
+        table_rows[table->table_index] = row;
         val = 0;
         wv->rec_index = 0;
         r = WHERE_evaluate( wv, table_rows, wv->cond, &val, record );
@@ -618,7 +706,7 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **ta
         {
             if (*(tables + 1))
             {
-                r = check_condition(wv, record, tables + 1, table_rows);
+                r = check_condition(wv, record, tables + 1, keys + 1, table_rows);
                 if (r != ERROR_SUCCESS)
                     break;
             }
@@ -630,7 +718,7 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, JOINTABLE **ta
             }
         }
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    table_rows[table->table_index] = INVALID_ROW_INDEX;
     return r;
 }
 
@@ -763,6 +851,99 @@ static JOINTABLE **ordertables( MSIWHEREVIEW *wv )
     return tables;
 }
 
+static int table_position( JOINTABLE **tables, const JOINTABLE *table )
+{
+    int i;
+
+    for (i = 0; tables[i]; i++)
+        if (tables[i] == table) return i;
+    return -1;
+}
+
+static void add_join_key( JOINTABLE **tables, JOINKEY *keys, const struct expr *column,
+                          const struct expr *value, UINT rec_index )
+{
+    JOINTABLE *table;
+    UINT type;
+    int pos;
+
+    if (column->type != EXPR_COL_NUMBER && column->type != EXPR_COL_NUMBER32 &&
+        column->type != EXPR_COL_NUMBER_STRING)
+        return;
+
+    table = column->u.column.parsed.table;
+    pos = table_position(tables, table);
+    if (pos < 0 || keys[pos].column)
+        return;
+
+    switch (value->type)
+    {
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        if (value->type != column->type ||
+            table_position(tables, value->u.column.parsed.table) >= pos)
+            return;
+        break;
+    case EXPR_SVAL:
+        if (column->type != EXPR_COL_NUMBER_STRING) return;
+        break;
+    case EXPR_UVAL:
+        if (column->type == EXPR_COL_NUMBER_STRING) return;
+        break;
+    case EXPR_WILDCARD:
+        break;
+    default:
+        return;
+    }
+
+    /* some views only look up their first column, and binary columns
+     * hold stream names rather than the data compared */
+    if (table->view->ops->get_column_info(table->view, column->u.column.parsed.column,
+                                          NULL, &type, NULL, NULL) != ERROR_SUCCESS ||
+        MSITYPE_IS_BINARY(type))
+        return;
+
+    keys[pos].column = column;
+    keys[pos].value = value;
+    keys[pos].rec_index = rec_index;
+}
+
+/* finds the equalities in the top level conjunction of the condition that
+ * can be used to look up rows instead of scanning each joined table */
+static void find_join_keys( const struct expr *expr, BOOL conjunct, JOINTABLE **tables,
+                            JOINKEY *keys, UINT *rec_index )
+{
+    switch (expr->type)
+    {
+    case EXPR_WILDCARD:
+        /* parameters are consumed in evaluation order, see WHERE_evaluate */
+        (*rec_index)++;
+        return;
+    case EXPR_COMPLEX:
+    case EXPR_STRCMP:
+        if (conjunct && expr->type == EXPR_COMPLEX && expr->u.expr.op == OP_AND)
+        {
+            find_join_keys(expr->u.expr.left, TRUE, tables, keys, rec_index);
+            find_join_keys(expr->u.expr.right, TRUE, tables, keys, rec_index);
+            return;
+        }
+        if (conjunct && expr->u.expr.op == OP_EQ)
+        {
+            UINT left_index = *rec_index + 1;
+            UINT right_index = left_index + (expr->u.expr.left->type == EXPR_WILDCARD);
+
+            add_join_key(tables, keys, expr->u.expr.left, expr->u.expr.right, right_index);
+            add_join_key(tables, keys, expr->u.expr.right, expr->u.expr.left, left_index);
+        }
+        find_join_keys(expr->u.expr.left, FALSE, tables, keys, rec_index);
+        find_join_keys(expr->u.expr.right, FALSE, tables, keys, rec_index);
+        return;
+    default:
+        return;
+    }
+}
+
 static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
 {
     MSIWHEREVIEW *wv = (MSIWHEREVIEW*)view;
@@ -770,6 +951,7 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
     JOINTABLE *table = wv->tables;
     UINT *rows;
     JOINTABLE **ordered_tables;
+    JOINKEY *keys;
     UINT i = 0;
 
     TRACE("%p %p\n", wv, record);
@@ -800,11 +982,18 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
 
     ordered_tables = ordertables( wv );
 
+    keys = msi_alloc_zero( wv->table_count * sizeof(*keys) );
+    if (wv->cond)
+    {
+        i = 0;
+        find_join_keys(wv->cond, TRUE, ordered_tables, keys, &i);
+    }
+
     rows = msi_alloc( wv->table_count * sizeof(*rows) );
     for (i = 0; i < wv->table_count; i++)
         rows[i] = INVALID_ROW_INDEX;
 
-    r =  check_condition(wv, record, ordered_tables, rows);
+    r =  check_condition(wv, record, ordered_tables, keys, rows);
 
     if (wv->order_info)
         wv->order_info->error = ERROR_SUCCESS;
@@ -815,6 +1004,7 @@ static UINT WHERE_execute( struct tagMSIVIEW *view, MSIRECORD *record )
         r = wv->order_info->error;
 
     msi_free( rows );
+    msi_free( keys );
     msi_free( ordered_tables );
     return r;
 }
@@ -168,8 +168,8 @@ struct SchedulerVtbl {
     unsigned int (__thiscall *Release)(Scheduler*);
     void (__thiscall *RegisterShutdownEvent)(Scheduler*,HANDLE);
     void (__thiscall *Attach)(Scheduler*);
-    /* CreateScheduleGroup */
-    /* ScheduleTask */
+    void* (__thiscall *CreateScheduleGroup)(Scheduler*);
+    void (__thiscall *ScheduleTask)(Scheduler*,void (__cdecl*)(void*),void*);
 };
 
 static int* (__cdecl *p_errno)(void);
@@ -939,8 +939,26 @@ static void test_ExternalContextBase(void)
     CloseHandle(thread);
 }
 
+struct scheduled_task
+{
+    HANDLE event;
+    Scheduler *scheduler;
+    DWORD thread_id;
+};
+
+static void __cdecl scheduled_task_proc(void *arg)
+{
+    struct scheduled_task *task = arg;
+
+    task->scheduler = p_CurrentScheduler_Get();
+    task->thread_id = GetCurrentThreadId();
+    SetEvent(task->event);
+}
+
 static void test_Scheduler(void)
 {
+    struct scheduled_task task;
+    DWORD ret;
     Scheduler *scheduler, *current_scheduler;
     SchedulerPolicy policy;
     unsigned int i;
@@ -968,6 +986,18 @@ static void test_Scheduler(void)
 
     i = call_func1(scheduler->vtable->GetNumberOfVirtualProcessors, scheduler);
     ok(i == 1, "Scheduler::GetNumberOfVirtualProcessors() = %u\n", i);
+
+    task.event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    task.scheduler = NULL;
+    task.thread_id = 0;
+    call_func3(scheduler->vtable->ScheduleTask, scheduler, scheduled_task_proc, &task);
+    ret = WaitForSingleObject(task.event, 5000);
+    ok(ret == WAIT_OBJECT_0, "scheduled task has not run: %u\n", ret);
+    ok(task.scheduler == scheduler, "task ran on scheduler %p, expected %p\n",
+            task.scheduler, scheduler);
+    ok(task.thread_id && task.thread_id != GetCurrentThreadId(),
+            "task ran on thread %x\n", task.thread_id);
+    CloseHandle(task.event);
     call_func1(scheduler->vtable->Release, scheduler);
     call_func1(p_SchedulerPolicy_dtor, &policy);
 }
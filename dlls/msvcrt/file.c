@@ -460,7 +460,7 @@ static MSVCRT_FILE* msvcrt_alloc_fp(void)
       {
           if (file<MSVCRT__iob || file>=MSVCRT__iob+_IOB_ENTRIES)
           {
-              InitializeCriticalSection(&((file_crit*)file)->crit);
+              InitializeCriticalSectionAndSpinCount(&((file_crit*)file)->crit, MSVCRT_LOCK_SPIN_COUNT);
               ((file_crit*)file)->crit.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": file_crit.crit");
           }
           MSVCRT_stream_idx++;
@@ -1311,7 +1311,7 @@ LONG CDECL MSVCRT__lseek(int fd, LONG offset, int whence)
 void CDECL MSVCRT__lock_file(MSVCRT_FILE *file)
 {
     if(file>=MSVCRT__iob && file<MSVCRT__iob+_IOB_ENTRIES)
-        _lock(_STREAM_LOCKS+(file-MSVCRT__iob));
+        EnterCriticalSection(msvcrt_get_stream_lock(file-MSVCRT__iob));
     else
         EnterCriticalSection(&((file_crit*)file)->crit);
 }
@@ -1322,7 +1322,7 @@ void CDECL MSVCRT__lock_file(MSVCRT_FILE *file)
 void CDECL MSVCRT__unlock_file(MSVCRT_FILE *file)
 {
     if(file>=MSVCRT__iob && file<MSVCRT__iob+_IOB_ENTRIES)
-        _unlock(_STREAM_LOCKS+(file-MSVCRT__iob));
+        LeaveCriticalSection(msvcrt_get_stream_lock(file-MSVCRT__iob));
     else
         LeaveCriticalSection(&((file_crit*)file)->crit);
 }
@@ -52,8 +52,127 @@ static unsigned int MSVCRT_amblksiz = 16;
 /* FIXME - According to documentation it should be 480 bytes, at runtime default is 0 */
 static MSVCRT_size_t MSVCRT_sbh_threshold = 0;
 
+/* Small blocks freed by a thread are kept in a per-thread cache and handed
+ * out again to the same thread without taking the heap lock. The cached
+ * blocks are ordinary blocks of the msvcrt heap and are only reused for
+ * requests of the same size, so _msize, HeapSize and _heapwalk still see
+ * the block sizes the application asked for. */
+#define HEAP_CACHE_GRANULARITY 16
+#define HEAP_CACHE_CLASSES     16
+#define HEAP_CACHE_MAX_SIZE    (HEAP_CACHE_CLASSES * HEAP_CACHE_GRANULARITY)
+#define HEAP_CACHE_DEPTH       32
+
+struct heap_cache_block
+{
+    struct heap_cache_block *next;
+    MSVCRT_size_t size;
+};
+
+struct heap_cache
+{
+    struct heap_cache_block *blocks[HEAP_CACHE_CLASSES];
+    unsigned int count[HEAP_CACHE_CLASSES];
+};
+
+static DWORD heap_cache_tls = TLS_OUT_OF_INDEXES;
+
+static inline BOOL heap_cache_size(MSVCRT_size_t size)
+{
+    return size >= sizeof(struct heap_cache_block) && size <= HEAP_CACHE_MAX_SIZE;
+}
+
+static struct heap_cache *heap_cache_get(BOOL create)
+{
+    struct heap_cache *cache;
+    DWORD err;
+
+    if(heap_cache_tls == TLS_OUT_OF_INDEXES)
+        return NULL;
+    err = GetLastError();
+    if(!(cache = TlsGetValue(heap_cache_tls)) && create &&
+            (cache = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cache))))
+        TlsSetValue(heap_cache_tls, cache);
+    SetLastError(err);
+    return cache;
+}
+
+/* give the oldest count blocks of a size class back to the heap at once */
+static void heap_cache_release(struct heap_cache *cache, unsigned int idx, unsigned int count)
+{
+    struct heap_cache_block *block, *next, **prev = &cache->blocks[idx];
+    unsigned int keep = cache->count[idx] - count;
+
+    while(keep--)
+        prev = &(*prev)->next;
+    block = *prev;
+    *prev = NULL;
+    cache->count[idx] -= count;
+
+    HeapLock(heap);
+    for(; block; block = next)
+    {
+        next = block->next;
+        HeapFree(heap, 0, block);
+    }
+    HeapUnlock(heap);
+}
+
+static void heap_cache_flush(struct heap_cache *cache)
+{
+    unsigned int i;
+
+    for(i = 0; i < HEAP_CACHE_CLASSES; i++)
+        if(cache->count[i]) heap_cache_release(cache, i, cache->count[i]);
+}
+
+static void* heap_cache_alloc(DWORD flags, MSVCRT_size_t size)
+{
+    struct heap_cache *cache = heap_cache_get(TRUE);
+    struct heap_cache_block *block, **prev;
+    unsigned int idx = (size - 1) / HEAP_CACHE_GRANULARITY;
+
+    if(!cache)
+        return NULL;
+
+    for(prev = &cache->blocks[idx]; (block = *prev); prev = &block->next)
+    {
+        if(block->size != size) continue;
+        *prev = block->next;
+        cache->count[idx]--;
+        if(flags & HEAP_ZERO_MEMORY)
+            memset(block, 0, size);
+        return block;
+    }
+    return NULL;
+}
+
+static BOOL heap_cache_free(void *ptr)
+{
+    struct heap_cache *cache = heap_cache_get(FALSE);
+    struct heap_cache_block *block = ptr;
+    MSVCRT_size_t size;
+    unsigned int idx;
+
+    if(!cache)
+        return FALSE;
+    size = HeapSize(heap, 0, ptr);
+    if(size == ~(MSVCRT_size_t)0 || !heap_cache_size(size))
+        return FALSE;
+
+    idx = (size - 1) / HEAP_CACHE_GRANULARITY;
+    if(cache->count[idx] == HEAP_CACHE_DEPTH)
+        heap_cache_release(cache, idx, HEAP_CACHE_DEPTH / 2);
+    block->size = size;
+    block->next = cache->blocks[idx];
+    cache->blocks[idx] = block;
+    cache->count[idx]++;
+    return TRUE;
+}
+
 static void* msvcrt_heap_alloc(DWORD flags, MSVCRT_size_t size)
 {
+    void *ret;
+
     if(size < MSVCRT_sbh_threshold)
     {
         void *memblock, *temp, **saved;
@@ -67,6 +186,8 @@ static void* msvcrt_heap_alloc(DWORD flags, MSVCRT_size_t size)
         return memblock;
     }
 
+    if(heap_cache_size(size) && (ret = heap_cache_alloc(flags, size)))
+        return ret;
     return HeapAlloc(heap, flags, size);
 }
 
@@ -110,6 +231,8 @@ static BOOL msvcrt_heap_free(void *ptr)
         return HeapFree(sb_heap, 0, *saved);
     }
 
+    if(ptr && heap_cache_free(ptr))
+        return TRUE;
     return HeapFree(heap, 0, ptr);
 }
 
@@ -268,6 +391,9 @@ int CDECL _heapchk(void)
  */
 int CDECL _heapmin(void)
 {
+  struct heap_cache *cache = heap_cache_get(FALSE);
+
+  if (cache) heap_cache_flush(cache);
   if (!HeapCompact( heap, 0 ) ||
           (sb_heap && !HeapCompact( sb_heap, 0 )))
   {
@@ -283,11 +409,16 @@ int CDECL _heapmin(void)
  */
 int CDECL _heapwalk(struct MSVCRT__heapinfo* next)
 {
+  struct heap_cache *cache;
   PROCESS_HEAP_ENTRY phe;
 
   if (sb_heap)
       FIXME("small blocks heap not supported\n");
 
+  /* show the blocks freed by this thread as free */
+  if (!next->_pentry && (cache = heap_cache_get(FALSE)))
+      heap_cache_flush(cache);
+
   LOCK_HEAP;
   phe.lpData = next->_pentry;
   phe.cbData = next->_size;
@@ -871,11 +1002,25 @@ int CDECL MSVCRT_strncpy_s(char *dest, MSVCRT_size_t numberOfElements,
 BOOL msvcrt_init_heap(void)
 {
     heap = HeapCreate(0, 0, 0);
+    if (heap) heap_cache_tls = TlsAlloc();
     return heap != NULL;
 }
 
+void msvcrt_free_heap_cache(void)
+{
+    struct heap_cache *cache = heap_cache_get(FALSE);
+
+    if (!cache) return;
+    heap_cache_flush(cache);
+    TlsSetValue(heap_cache_tls, NULL);
+    HeapFree(GetProcessHeap(), 0, cache);
+}
+
 void msvcrt_destroy_heap(void)
 {
+    msvcrt_free_heap_cache();
+    if (heap_cache_tls != TLS_OUT_OF_INDEXES)
+        TlsFree(heap_cache_tls);
     HeapDestroy(heap);
     if(sb_heap)
         HeapDestroy(sb_heap);
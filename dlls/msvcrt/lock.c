@@ -48,7 +48,7 @@ static inline void msvcrt_mlock_set_entry_initialized( int locknum, BOOL initial
 
 static inline void msvcrt_initialize_mlock( int locknum )
 {
-  InitializeCriticalSection( &(lock_table[ locknum ].crit) );
+  InitializeCriticalSectionAndSpinCount( &(lock_table[ locknum ].crit), MSVCRT_LOCK_SPIN_COUNT );
   lock_table[ locknum ].crit.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": LOCKTABLEENTRY.crit");
   msvcrt_mlock_set_entry_initialized( locknum, TRUE );
 }
@@ -63,8 +63,8 @@ static inline void msvcrt_uninitialize_mlock( int locknum )
 /**********************************************************************
  *     msvcrt_init_mt_locks (internal)
  *
- * Initialize the table lock. All other locks will be initialized
- * upon first use.
+ * Initialize the table lock and the stream locks. All other locks will
+ * be initialized upon first use.
  *
  */
 void msvcrt_init_mt_locks(void)
@@ -81,6 +81,23 @@ void msvcrt_init_mt_locks(void)
 
   /* Initialize our lock table lock */
   msvcrt_initialize_mlock( _LOCKTAB_LOCK );
+
+  /* The stream locks are taken on every stdio call, create them now
+   * so that msvcrt_get_stream_lock doesn't need to check for it */
+  for( i=_STREAM_LOCKS; i <= _LAST_STREAM_LOCK; i++ )
+  {
+    msvcrt_initialize_mlock( i );
+  }
+}
+
+/**********************************************************************
+ *     msvcrt_get_stream_lock (internal)
+ *
+ * Return the critical section protecting one of the _iob streams.
+ */
+CRITICAL_SECTION *msvcrt_get_stream_lock( int stream )
+{
+  return &lock_table[ _STREAM_LOCKS + stream ].crit;
 }
 
 /**********************************************************************
@@ -322,9 +322,13 @@ void __cdecl MSVCRT_operator_delete(void*);
 typedef void* (__cdecl *malloc_func_t)(MSVCRT_size_t);
 typedef void  (__cdecl *free_func_t)(void*);
 
+/* spin a little before sleeping on a lock, stdio locks are held only briefly */
+#define MSVCRT_LOCK_SPIN_COUNT 4000
+
 /* Setup and teardown multi threaded locks */
 extern void msvcrt_init_mt_locks(void) DECLSPEC_HIDDEN;
 extern void msvcrt_free_locks(void) DECLSPEC_HIDDEN;
+extern CRITICAL_SECTION *msvcrt_get_stream_lock(int) DECLSPEC_HIDDEN;
 
 extern void msvcrt_init_exception(void*) DECLSPEC_HIDDEN;
 extern BOOL msvcrt_init_locale(void) DECLSPEC_HIDDEN;
@@ -340,6 +344,7 @@ extern void msvcrt_free_signals(void) DECLSPEC_HIDDEN;
 extern void msvcrt_free_popen_data(void) DECLSPEC_HIDDEN;
 extern BOOL msvcrt_init_heap(void) DECLSPEC_HIDDEN;
 extern void msvcrt_destroy_heap(void) DECLSPEC_HIDDEN;
+extern void msvcrt_free_heap_cache(void) DECLSPEC_HIDDEN;
 
 #if _MSVCR_VER >= 100
 extern void msvcrt_init_scheduler(void*) DECLSPEC_HIDDEN;
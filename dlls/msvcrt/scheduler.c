@@ -25,6 +25,7 @@
 #include "windef.h"
 #include "winternl.h"
 #include "wine/debug.h"
+#include "wine/list.h"
 #include "msvcrt.h"
 #include "cppexcept.h"
 #include "cxx.h"
@@ -35,6 +36,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 static int context_id = -1;
 static int scheduler_id = -1;
+static HMODULE msvcrt_module;
 
 #ifdef __i386__
 
@@ -115,6 +117,8 @@ typedef struct {
     struct scheduler_list scheduler;
     unsigned int id;
     union allocator_cache_entry *allocator_cache[8];
+    struct ThreadScheduler *worker_scheduler;
+    unsigned int worker_vproc;
 } ExternalContextBase;
 extern const vtable_ptr MSVCRT_ExternalContextBase_vtable;
 static void ExternalContextBase_ctor(ExternalContextBase*);
@@ -146,7 +150,25 @@ typedef struct Scheduler {
         void, (Scheduler*,void (__cdecl*)(void*),void*), (this,proc,data))
 #endif
 
+/* time after which idle worker threads exit, in milliseconds */
+#define SCHEDULER_IDLE_TIMEOUT 2000
+
+typedef struct {
+    struct list entry;
+    void (__cdecl *proc)(void*);
+    void *data;
+} scheduler_task;
+
+/* Every virtual processor owns a task queue. The worker running on it pushes
+ * and pops tasks at the head, idle workers steal from the tail. */
 typedef struct {
+    CRITICAL_SECTION cs;
+    struct list tasks;
+    struct ThreadScheduler *scheduler;
+    BOOL active;
+} virtual_processor;
+
+typedef struct ThreadScheduler {
     Scheduler scheduler;
     LONG ref;
     unsigned int id;
@@ -156,6 +178,12 @@ typedef struct {
     int shutdown_size;
     HANDLE *shutdown_events;
     CRITICAL_SECTION cs;
+    virtual_processor *vprocs;
+    LONG next_vproc;
+    LONG pending;
+    unsigned int workers;
+    unsigned int idle;
+    CONDITION_VARIABLE cv;
 } ThreadScheduler;
 extern const vtable_ptr MSVCRT_ThreadScheduler_vtable;
 
@@ -181,6 +209,7 @@ static SchedulerPolicy default_scheduler_policy;
 static ThreadScheduler *default_scheduler;
 
 static void create_default_scheduler(void);
+static BOOL ThreadScheduler_run_task(ThreadScheduler*,unsigned int);
 
 static Context* try_get_current_context(void)
 {
@@ -265,7 +294,16 @@ void __cdecl Context_Block(void)
 /* ?Yield@Context@Concurrency@@SAXXZ */
 void __cdecl Context_Yield(void)
 {
-    FIXME("()\n");
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+
+    TRACE("()\n");
+
+    /* on a worker thread, run another task in place of the yielding one */
+    if(context && context->context.vtable == &MSVCRT_ExternalContextBase_vtable &&
+            context->worker_scheduler &&
+            ThreadScheduler_run_task(context->worker_scheduler, context->worker_vproc))
+        return;
+    SwitchToThread();
 }
 
 /* ?_SpinYield@Context@Concurrency@@SAXXZ */
@@ -625,7 +663,8 @@ void __thiscall SchedulerPolicy_dtor(SchedulerPolicy *this)
 
 static void ThreadScheduler_dtor(ThreadScheduler *this)
 {
-    int i;
+    scheduler_task *task, *next;
+    unsigned int i;
 
     if(this->ref != 0) WARN("ref = %d\n", this->ref);
     SchedulerPolicy_dtor(&this->policy);
@@ -634,10 +673,144 @@ static void ThreadScheduler_dtor(ThreadScheduler *this)
         SetEvent(this->shutdown_events[i]);
     MSVCRT_operator_delete(this->shutdown_events);
 
+    for(i=0; i<this->virt_proc_no; i++) {
+        virtual_processor *vproc = &this->vprocs[i];
+
+        LIST_FOR_EACH_ENTRY_SAFE(task, next, &vproc->tasks, scheduler_task, entry) {
+            WARN("(%p) task %p was never run\n", this, task->proc);
+            MSVCRT_operator_delete(task);
+        }
+        vproc->cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&vproc->cs);
+    }
+    MSVCRT_operator_delete(this->vprocs);
+
     this->cs.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection(&this->cs);
 }
 
+/* returns the next task for the worker of vproc_no: the newest one of its
+ * own queue, or the oldest one stolen from another virtual processor */
+static scheduler_task* ThreadScheduler_pop_task(ThreadScheduler *this, unsigned int vproc_no)
+{
+    scheduler_task *task = NULL;
+    struct list *entry;
+    unsigned int i;
+
+    if(this->pending <= 0)
+        return NULL;
+
+    for(i=0; i<this->virt_proc_no && !task; i++) {
+        virtual_processor *vproc = &this->vprocs[(vproc_no + i) % this->virt_proc_no];
+
+        EnterCriticalSection(&vproc->cs);
+        entry = i ? list_tail(&vproc->tasks) : list_head(&vproc->tasks);
+        if(entry) {
+            list_remove(entry);
+            task = LIST_ENTRY(entry, scheduler_task, entry);
+        }
+        LeaveCriticalSection(&vproc->cs);
+    }
+
+    if(task) InterlockedDecrement(&this->pending);
+    return task;
+}
+
+static BOOL ThreadScheduler_run_task(ThreadScheduler *this, unsigned int vproc_no)
+{
+    scheduler_task *task = ThreadScheduler_pop_task(this, vproc_no);
+    void (__cdecl *proc)(void*);
+    void *data;
+
+    if(!task)
+        return FALSE;
+
+    proc = task->proc;
+    data = task->data;
+    MSVCRT_operator_delete(task);
+
+    TRACE("(%p) running %p(%p) on virtual processor %u\n", this, proc, data, vproc_no);
+    proc(data);
+    return TRUE;
+}
+
+static DWORD WINAPI ThreadScheduler_worker(void *arg)
+{
+    virtual_processor *vproc = arg;
+    ThreadScheduler *this = vproc->scheduler;
+    unsigned int vproc_no = vproc - this->vprocs;
+    ExternalContextBase *context = (ExternalContextBase*)get_current_context();
+
+    TRACE("(%p) starting worker for virtual processor %u\n", this, vproc_no);
+
+    /* the thread context takes over the reference added by start_worker,
+     * so the scheduler stays alive until the worker has exited */
+    if(context->scheduler.scheduler == &this->scheduler) {
+        InterlockedDecrement(&this->ref);
+    } else {
+        struct scheduler_list *l = MSVCRT_operator_new(sizeof(*l));
+        *l = context->scheduler;
+        context->scheduler.next = l;
+        context->scheduler.scheduler = &this->scheduler;
+    }
+    context->worker_scheduler = this;
+    context->worker_vproc = vproc_no;
+
+    for(;;) {
+        while(ThreadScheduler_run_task(this, vproc_no));
+
+        EnterCriticalSection(&this->cs);
+        this->idle++;
+        while(this->pending <= 0) {
+            if(!SleepConditionVariableCS(&this->cv, &this->cs, SCHEDULER_IDLE_TIMEOUT) &&
+                    this->pending <= 0)
+                break;
+        }
+        this->idle--;
+        if(this->pending <= 0) {
+            vproc->active = FALSE;
+            this->workers--;
+            LeaveCriticalSection(&this->cs);
+            break;
+        }
+        LeaveCriticalSection(&this->cs);
+    }
+
+    TRACE("(%p) terminating worker for virtual processor %u\n", this, vproc_no);
+    FreeLibraryAndExitThread(msvcrt_module, 0);
+    return 0;
+}
+
+/* called with this->cs held */
+static void ThreadScheduler_start_worker(ThreadScheduler *this)
+{
+    virtual_processor *vproc;
+    HMODULE module;
+    HANDLE thread;
+    unsigned int i;
+
+    for(i=0; i<this->virt_proc_no; i++)
+        if(!this->vprocs[i].active) break;
+    if(i == this->virt_proc_no)
+        return;
+    vproc = &this->vprocs[i];
+
+    InterlockedIncrement(&this->ref);
+    GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+            (const WCHAR*)msvcrt_module, &module);
+    thread = CreateThread(NULL, 0, ThreadScheduler_worker, vproc, 0, NULL);
+    if(!thread) {
+        ERR("failed to create worker thread: %u\n", GetLastError());
+        FreeLibrary(module);
+        InterlockedDecrement(&this->ref);
+        return;
+    }
+    CloseHandle(thread);
+
+    vproc->active = TRUE;
+    this->workers++;
+}
+
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_Id, 4)
 unsigned int __thiscall ThreadScheduler_Id(const ThreadScheduler *this)
 {
@@ -742,18 +915,49 @@ DEFINE_THISCALL_WRAPPER(ThreadScheduler_CreateScheduleGroup, 4)
     return NULL;
 }
 
-DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
-void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
-        void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
-{
-    FIXME("(%p %p %p %p) stub\n", this, proc, data, placement);
-}
-
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
 void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data)
 {
-    FIXME("(%p %p %p) stub\n", this, proc, data);
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+    virtual_processor *vproc;
+    scheduler_task *task;
+
+    TRACE("(%p %p %p)\n", this, proc, data);
+
+    task = MSVCRT_operator_new(sizeof(*task));
+    task->proc = proc;
+    task->data = data;
+
+    /* tasks created by a worker are queued on its own virtual processor,
+     * others are spread over all of them */
+    if(context && context->context.vtable == &MSVCRT_ExternalContextBase_vtable &&
+            context->worker_scheduler == this) {
+        vproc = &this->vprocs[context->worker_vproc];
+        EnterCriticalSection(&vproc->cs);
+        list_add_head(&vproc->tasks, &task->entry);
+    } else {
+        vproc = &this->vprocs[(unsigned int)InterlockedIncrement(&this->next_vproc) % this->virt_proc_no];
+        EnterCriticalSection(&vproc->cs);
+        list_add_tail(&vproc->tasks, &task->entry);
+    }
+    LeaveCriticalSection(&vproc->cs);
+    InterlockedIncrement(&this->pending);
+
+    EnterCriticalSection(&this->cs);
+    if(this->idle)
+        WakeConditionVariable(&this->cv);
+    else if(this->workers < this->virt_proc_no)
+        ThreadScheduler_start_worker(this);
+    LeaveCriticalSection(&this->cs);
+}
+
+DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
+void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
+        void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
+{
+    TRACE("(%p %p %p %p) placement ignored\n", this, proc, data, placement);
+    ThreadScheduler_ScheduleTask(this, proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_IsAvailableLocation, 8)
@@ -787,6 +991,7 @@ Scheduler* __thiscall ThreadScheduler_vector_dtor(ThreadScheduler *this, unsigne
 static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
         const SchedulerPolicy *policy)
 {
+    unsigned int min_concurrency, i;
     SYSTEM_INFO si;
 
     TRACE("(%p)->()\n", this);
@@ -800,12 +1005,30 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
     this->virt_proc_no = SchedulerPolicy_GetPolicyValue(&this->policy, MaxConcurrency);
     if(this->virt_proc_no > si.dwNumberOfProcessors)
         this->virt_proc_no = si.dwNumberOfProcessors;
+    min_concurrency = SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency);
+    if(min_concurrency != -1 && this->virt_proc_no < min_concurrency)
+        this->virt_proc_no = min_concurrency;
+    if(!this->virt_proc_no)
+        this->virt_proc_no = 1;
 
     this->shutdown_count = this->shutdown_size = 0;
     this->shutdown_events = NULL;
 
     InitializeCriticalSection(&this->cs);
     this->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ThreadScheduler");
+
+    this->vprocs = MSVCRT_operator_new(this->virt_proc_no * sizeof(*this->vprocs));
+    for(i=0; i<this->virt_proc_no; i++) {
+        InitializeCriticalSection(&this->vprocs[i].cs);
+        this->vprocs[i].cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": virtual_processor");
+        list_init(&this->vprocs[i].tasks);
+        this->vprocs[i].scheduler = this;
+        this->vprocs[i].active = FALSE;
+    }
+    this->next_vproc = -1;
+    this->pending = 0;
+    this->workers = this->idle = 0;
+    InitializeConditionVariable(&this->cv);
     return this;
 }
 
@@ -1128,6 +1351,7 @@ void __asm_dummy_vtables(void) {
 
 void msvcrt_init_scheduler(void *base)
 {
+    msvcrt_module = base;
 #ifdef __x86_64__
     init_Context_rtti(base);
     init_ContextBase_rtti(base);
@@ -307,6 +307,13 @@ void CDECL MSVCRT__swab(char* src, char* dst, int len)
   }
 }
 
+/* powers of ten that can be represented exactly in a double */
+static const double exact_pow10[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
 static double strtod_helper(const char *str, char **end, MSVCRT__locale_t locale, int *err)
 {
     MSVCRT_pthreadlocinfo locinfo;
@@ -453,6 +460,15 @@ static double strtod_helper(const char *str, char **end, MSVCRT__locale_t locale
         }
     }
 
+    /* Both the mantissa and the power of ten are exact doubles, so a single
+     * multiplication or division gives the correctly rounded result. */
+    if(base == 10 && d <= (1ull << 53) && exp >= -22 && exp <= 22) {
+        ret = exp < 0 ? (double)d / exact_pow10[-exp] : (double)d * exact_pow10[exp];
+        if(end)
+            *end = (char*)p;
+        return sign * ret;
+    }
+
     fpcontrol = _control87(0, 0);
     _control87(MSVCRT__EM_DENORMAL|MSVCRT__EM_INVALID|MSVCRT__EM_ZERODIVIDE
             |MSVCRT__EM_OVERFLOW|MSVCRT__EM_UNDERFLOW|MSVCRT__EM_INEXACT, 0xffffffff);
@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <malloc.h>
 #include <errno.h>
+#include <string.h>
 #include "wine/test.h"
 
 static void (__cdecl *p_aligned_free)(void*) = NULL;
@@ -479,6 +480,70 @@ static void test_calloc(void)
     free(ptr);
 }
 
+#define HEAP_THREADS    4
+#define HEAP_ITERATIONS 20000
+#define HEAP_KEPT       256
+
+static void *heap_kept[HEAP_THREADS][HEAP_KEPT];
+
+static DWORD WINAPI heap_thread(void *arg)
+{
+    void **kept = heap_kept[(DWORD_PTR)arg];
+    unsigned int i, size, failures = 0;
+    unsigned char *mem;
+
+    for (i = 0; i < HEAP_ITERATIONS; i++)
+    {
+        size = 1 + (i * 7) % 300;
+        if (i % 3) mem = malloc(size);
+        else mem = calloc(1, size);
+        if (!mem || _msize(mem) != size || (!(i % 3) && (mem[0] || mem[size - 1])))
+        {
+            failures++;
+            free(mem);
+            continue;
+        }
+        memset(mem, 0xcc, size);
+
+        /* keep some blocks around to be freed by another thread */
+        if (i % 5) free(mem);
+        else
+        {
+            free(kept[i % HEAP_KEPT]);
+            kept[i % HEAP_KEPT] = mem;
+        }
+    }
+    return failures;
+}
+
+static void test_threads(void)
+{
+    HANDLE threads[HEAP_THREADS];
+    DWORD start, ret;
+    unsigned int i, j;
+
+    start = GetTickCount();
+    for (i = 0; i < HEAP_THREADS; i++)
+    {
+        threads[i] = CreateThread(NULL, 0, heap_thread, (void *)(DWORD_PTR)i, 0, NULL);
+        ok(threads[i] != NULL, "CreateThread failed: %u\n", GetLastError());
+    }
+    for (i = 0; i < HEAP_THREADS; i++)
+    {
+        WaitForSingleObject(threads[i], INFINITE);
+        GetExitCodeThread(threads[i], &ret);
+        ok(!ret, "thread %u: %u allocations failed\n", i, ret);
+        CloseHandle(threads[i]);
+    }
+    trace("%u threads, %u allocations each: %u ms\n", HEAP_THREADS, HEAP_ITERATIONS,
+          GetTickCount() - start);
+
+    for (i = 0; i < HEAP_THREADS; i++)
+        for (j = 0; j < HEAP_KEPT; j++)
+            free(heap_kept[i][j]);
+    ok(_heapchk() == _HEAPOK, "heap is corrupted\n");
+}
+
 START_TEST(heap)
 {
     void *mem;
@@ -504,4 +569,5 @@ START_TEST(heap)
     test_aligned();
     test_sbheap();
     test_calloc();
+    test_threads();
 }
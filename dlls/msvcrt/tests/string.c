@@ -959,6 +959,33 @@ static void test__mbscpy_s(void)
     ok(dest[1] == src[1], "incorrect dest buffer (%d)\n", dest[1]);
 }
 
+static void test_wcslen(void)
+{
+    WCHAR buffer[64], dest[64];
+    unsigned int start, len;
+    WCHAR *ret;
+
+    for (start = 0; start < 8; start++)
+    {
+        for (len = 0; len < 40; len++)
+        {
+            unsigned int i;
+
+            for (i = 0; i < sizeof(buffer)/sizeof(buffer[0]); i++)
+                buffer[i] = (i % 3) ? 0x8000 + i : 0x100;
+            buffer[start + len] = 0;
+            ok(wcslen(buffer + start) == len, "start %u: wcslen returned %u, expected %u\n",
+               start, (unsigned int)wcslen(buffer + start), len);
+
+            memset(dest, 0xcc, sizeof(dest));
+            ret = wcscpy(dest, buffer + start);
+            ok(ret == dest, "wcscpy returned %p, expected %p\n", ret, dest);
+            ok(!memcmp(dest, buffer + start, (len + 1) * sizeof(WCHAR)) && dest[len + 1] == 0xcccc,
+               "start %u, len %u: wrong wcscpy result\n", start, len);
+        }
+    }
+}
+
 static void test_wcscpy_s(void)
 {
     static const WCHAR szLongText[] = { 'T','h','i','s','A','L','o','n','g','s','t','r','i','n','g',0 };
@@ -1881,6 +1908,18 @@ static void test__strtod(void)
     d = strtod("0.1D-4736", NULL);
     ok(almost_equal(d, 0.1e-4736L), "d = %lf\n", d);
 
+    /* these values have exact representations of both mantissa and power of ten */
+    d = strtod("0.3", NULL);
+    ok(d == 0.3, "d = %.17g\n", d);
+    d = strtod("-4.35", NULL);
+    ok(d == -4.35, "d = %.17g\n", d);
+    d = strtod("123456.789e-3", NULL);
+    ok(d == 123.456789, "d = %.17g\n", d);
+    d = strtod("9007199254740992e-22", NULL);
+    ok(d == 9007199254740992e-22, "d = %.17g\n", d);
+    d = strtod("1e22", NULL);
+    ok(d == 1e22, "d = %.17g\n", d);
+
     errno = 0xdeadbeef;
     strtod(overflow, &end);
     ok(errno == ERANGE, "errno = %x\n", errno);
@@ -3437,6 +3476,7 @@ START_TEST(string)
     test_ismbclegal();
     test_strtok();
     test__mbstok();
+    test_wcslen();
     test_wcscpy_s();
     test__wcsupr_s();
     test_strtol();
@@ -35,6 +35,30 @@ WINE_DEFAULT_DEBUG_CHANNEL(msvcrt);
 
 static BOOL n_format_enabled = TRUE;
 
+/* 0x0001 and 0x8000 in every wide char of a machine word */
+#define WCS_WORD_ONES  (~(ULONG_PTR)0 / 0xffff)
+#define WCS_WORD_HIGHS (WCS_WORD_ONES << 15)
+
+/* Looks for the terminating null one machine word at a time. The word
+ * reads are aligned, so they never cross into an unmapped page. */
+static MSVCRT_size_t msvcrt_wcslen(const MSVCRT_wchar_t *str)
+{
+    const MSVCRT_wchar_t *s = str;
+    const ULONG_PTR *w;
+
+    if ((ULONG_PTR)s & 1)
+    {
+        while (*s) s++;
+        return s - str;
+    }
+
+    for (; (ULONG_PTR)s & (sizeof(ULONG_PTR) - 1); s++)
+        if (!*s) return s - str;
+    for (w = (const ULONG_PTR *)s; !((*w - WCS_WORD_ONES) & ~*w & WCS_WORD_HIGHS); w++);
+    for (s = (const MSVCRT_wchar_t *)w; *s; s++);
+    return s - str;
+}
+
 #include "printf.h"
 #define PRINTF_WIDE
 #include "printf.h"
@@ -1931,6 +1955,15 @@ INT CDECL MSVCRT_iswblank( MSVCRT_wchar_t wc )
     return wc == '\t' || MSVCRT__iswctype_l( wc, MSVCRT__BLANK, NULL );
 }
 
+/*********************************************************************
+ *		wcscpy (MSVCRT.@)
+ */
+MSVCRT_wchar_t* CDECL MSVCRT_wcscpy( MSVCRT_wchar_t *dst, const MSVCRT_wchar_t *src )
+{
+    memcpy( dst, src, (msvcrt_wcslen(src) + 1) * sizeof(MSVCRT_wchar_t) );
+    return dst;
+}
+
 /*********************************************************************
  *		wcscpy_s (MSVCRT.@)
  */
@@ -1945,7 +1978,7 @@ INT CDECL MSVCRT_wcscpy_s( MSVCRT_wchar_t* wcDest, MSVCRT_size_t numElement, con
 
     if(!MSVCRT_CHECK_PMT(wcSrc)) return MSVCRT_EINVAL;
 
-    size = strlenW(wcSrc) + 1;
+    size = msvcrt_wcslen(wcSrc) + 1;
 
     if(!MSVCRT_CHECK_PMT_ERR(size <= numElement, MSVCRT_ERANGE))
         return MSVCRT_ERANGE;
@@ -2433,7 +2466,7 @@ MSVCRT_wchar_t* CDECL MSVCRT_wcschr(const MSVCRT_wchar_t *str, MSVCRT_wchar_t ch
  */
 int CDECL MSVCRT_wcslen(const MSVCRT_wchar_t *str)
 {
-    return strlenW(str);
+    return msvcrt_wcslen(str);
 }
 
 /*********************************************************************
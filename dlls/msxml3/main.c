@@ -278,6 +278,7 @@ BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID reserved)
         xmlCleanupInputCallbacks();
         xmlRegisterDefaultInputCallbacks();
 
+        release_xpath_cache();
         xmlCleanupParser();
         schemasCleanup();
 #endif
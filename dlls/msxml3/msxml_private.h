@@ -206,6 +206,7 @@ struct xslprocessor_params
 
 extern void schemasInit(void) DECLSPEC_HIDDEN;
 extern void schemasCleanup(void) DECLSPEC_HIDDEN;
+extern void release_xpath_cache(void) DECLSPEC_HIDDEN;
 
 #ifndef HAVE_XMLFIRSTELEMENTCHILD
 static inline xmlNodePtr wine_xmlFirstElementChild(xmlNodePtr parent)
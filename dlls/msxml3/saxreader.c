@@ -149,6 +149,11 @@ static saxreader_feature get_saxreader_feature(const WCHAR *name)
     return FeatureUnknown;
 }
 
+/* Strings passed to the characters and comment handlers. They stay valid
+ * until the next parse, but once the pool is full the strings of earlier
+ * callbacks are freed instead of growing it further. */
+#define BSTR_POOL_MAX 4096
+
 struct bstrpool
 {
     BSTR *pool;
@@ -578,6 +583,14 @@ static BOOL bstr_pool_insert(struct bstrpool *pool, BSTR pool_entry)
         pool->index = 0;
         pool->len = 16;
     }
+    else if (pool->index == pool->len && pool->len >= BSTR_POOL_MAX)
+    {
+        unsigned int i;
+
+        for (i = 0; i < pool->index; i++)
+            SysFreeString(pool->pool[i]);
+        pool->index = 0;
+    }
     else if (pool->index == pool->len)
     {
         BSTR *realloc = heap_realloc(pool->pool, pool->len * 2 * sizeof(*realloc));
@@ -83,6 +83,98 @@ typedef struct
     IEnumVARIANT *enumvariant;
 } domselection;
 
+/* Compiled XPath expressions of recent queries. Only XPath mode queries are
+ * cached, XSLPattern translation depends on the namespaces of the document. */
+#define XPATH_CACHE_SIZE 32
+
+struct xpath_cache_entry
+{
+    struct list entry;
+    LONG ref;
+    xmlChar *query;
+    xmlXPathCompExprPtr comp;
+};
+
+static struct list xpath_cache = LIST_INIT(xpath_cache);
+static unsigned int xpath_cache_count;
+
+static CRITICAL_SECTION cs_xpath_cache;
+static CRITICAL_SECTION_DEBUG cs_xpath_cache_dbg =
+{
+    0, 0, &cs_xpath_cache,
+    { &cs_xpath_cache_dbg.ProcessLocksList, &cs_xpath_cache_dbg.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": xpath_cache") }
+};
+static CRITICAL_SECTION cs_xpath_cache = { &cs_xpath_cache_dbg, -1, 0, 0, 0, 0 };
+
+static void xpath_cache_entry_release(struct xpath_cache_entry *entry)
+{
+    if (InterlockedDecrement(&entry->ref))
+        return;
+
+    xmlXPathFreeCompExpr(entry->comp);
+    xmlFree(entry->query);
+    heap_free(entry);
+}
+
+static struct xpath_cache_entry *xpath_cache_get(xmlXPathContextPtr ctxt, const xmlChar *query)
+{
+    struct xpath_cache_entry *entry;
+    xmlXPathCompExprPtr comp;
+
+    EnterCriticalSection(&cs_xpath_cache);
+    LIST_FOR_EACH_ENTRY(entry, &xpath_cache, struct xpath_cache_entry, entry)
+    {
+        if (xmlStrEqual(entry->query, query))
+        {
+            list_remove(&entry->entry);
+            list_add_head(&xpath_cache, &entry->entry);
+            InterlockedIncrement(&entry->ref);
+            LeaveCriticalSection(&cs_xpath_cache);
+            return entry;
+        }
+    }
+    LeaveCriticalSection(&cs_xpath_cache);
+
+    if (!(comp = xmlXPathCtxtCompile(ctxt, query)))
+        return NULL;
+
+    if (!(entry = heap_alloc(sizeof(*entry))) || !(entry->query = xmlStrdup(query)))
+    {
+        heap_free(entry);
+        xmlXPathFreeCompExpr(comp);
+        return NULL;
+    }
+    entry->comp = comp;
+    entry->ref = 2;
+
+    EnterCriticalSection(&cs_xpath_cache);
+    list_add_head(&xpath_cache, &entry->entry);
+    if (++xpath_cache_count > XPATH_CACHE_SIZE)
+    {
+        struct xpath_cache_entry *last = LIST_ENTRY(list_tail(&xpath_cache), struct xpath_cache_entry, entry);
+
+        list_remove(&last->entry);
+        xpath_cache_count--;
+        xpath_cache_entry_release(last);
+    }
+    LeaveCriticalSection(&cs_xpath_cache);
+
+    return entry;
+}
+
+void release_xpath_cache(void)
+{
+    struct xpath_cache_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &xpath_cache, struct xpath_cache_entry, entry)
+    {
+        list_remove(&entry->entry);
+        xpath_cache_entry_release(entry);
+    }
+    xpath_cache_count = 0;
+}
+
 static HRESULT selection_get_item(IUnknown *iface, LONG index, VARIANT* item)
 {
     V_VT(item) = VT_DISPATCH;
@@ -795,8 +887,16 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
 
     if (is_xpathmode(This->node->doc))
     {
+        struct xpath_cache_entry *entry;
+
         xmlXPathRegisterAllFunctions(ctxt);
-        This->result = xmlXPathEvalExpression(query, ctxt);
+        if ((entry = xpath_cache_get(ctxt, query)))
+        {
+            This->result = xmlXPathCompiledEval(entry->comp, ctxt);
+            xpath_cache_entry_release(entry);
+        }
+        else
+            This->result = NULL;
     }
     else
     {
@@ -34,11 +34,13 @@
 #define WIN32_NO_STATUS
 #include "windef.h"
 #include "winternl.h"
+#include "wine/unicode.h"
 #include "wine/debug.h"
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
 WINE_DECLARE_DEBUG_CHANNEL(relay);
+WINE_DECLARE_DEBUG_CHANNEL(lockstats);
 
 static inline LONG interlocked_inc( PLONG dest )
 {
@@ -52,13 +54,234 @@ static inline LONG interlocked_dec( PLONG dest )
 
 static inline void small_pause(void)
 {
-#ifdef __i386__
+#if defined(__i386__) || defined(__x86_64__)
     __asm__ __volatile__( "rep;nop" : : : "memory" );
 #else
     __asm__ __volatile__( "" : : : "memory" );
 #endif
 }
 
+/* adaptive spinning for critical sections without an explicit spin count,
+ * enabled through HKCU\Software\Wine\AppDefaults\app.exe\AdaptiveSpin */
+
+#define ADAPTIVE_SPIN_MAX     2000  /* maximum number of pauses before waiting */
+#define ADAPTIVE_SPIN_BACKOFF 64    /* maximum number of pauses between two attempts */
+#define ADAPTIVE_SPIN_SLOTS   256
+
+#define IS_OPTION_TRUE(ch) ((ch) == 'y' || (ch) == 'Y' || (ch) == 't' || (ch) == 'T' || (ch) == '1')
+
+static BOOL adaptive_spin;
+/* number of pauses recently needed to get the lock, per (hashed) critical section */
+static LONG spin_estimates[ADAPTIVE_SPIN_SLOTS];
+
+static inline LONG *get_spin_estimate( RTL_CRITICAL_SECTION *crit )
+{
+    ULONG_PTR hash = (ULONG_PTR)crit / sizeof(*crit);
+    return &spin_estimates[(hash ^ (hash >> 8)) % ADAPTIVE_SPIN_SLOTS];
+}
+
+/***********************************************************************
+ *           adaptive_spin_enter
+ *
+ * Spin for about as long as the lock was recently held, backing off between attempts.
+ * Returns TRUE if the lock was acquired.
+ */
+static BOOL adaptive_spin_enter( RTL_CRITICAL_SECTION *crit )
+{
+    LONG *estimate = get_spin_estimate( crit );
+    LONG max = min( *estimate * 2 + 16, ADAPTIVE_SPIN_MAX );
+    LONG count = 0, delay = 1, i;
+
+    while (count < max)
+    {
+        if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
+        if (crit->LockCount == -1 && interlocked_cmpxchg( &crit->LockCount, 0, -1 ) == -1)
+        {
+            *estimate += (count - *estimate) / 8;
+            return TRUE;
+        }
+        for (i = 0; i < delay; i++) small_pause();
+        count += delay;
+        if (delay < ADAPTIVE_SPIN_BACKOFF) delay *= 2;
+    }
+
+    /* give the owner a last chance to release it before going to sleep */
+    if (crit->LockCount == 0)
+    {
+        NtYieldExecution();
+        if (interlocked_cmpxchg( &crit->LockCount, 0, -1 ) == -1)
+        {
+            *estimate += (max - *estimate) / 8;
+            return TRUE;
+        }
+    }
+    /* the lock is held for long, spin less next time */
+    *estimate /= 2;
+    return FALSE;
+}
+
+/***********************************************************************
+ *           init_critsection_spinning
+ */
+void init_critsection_spinning( const WCHAR *appname )
+{
+    static const WCHAR configW[] = {'S','o','f','t','w','a','r','e','\\','W','i','n','e',0};
+    static const WCHAR appdefaultsW[] = {'A','p','p','D','e','f','a','u','l','t','s','\\',0};
+    static const WCHAR adaptivespinW[] = {'A','d','a','p','t','i','v','e','S','p','i','n',0};
+    char buffer[FIELD_OFFSET( KEY_VALUE_PARTIAL_INFORMATION, Data ) + 4 * sizeof(WCHAR)];
+    KEY_VALUE_PARTIAL_INFORMATION *info = (KEY_VALUE_PARTIAL_INFORMATION *)buffer;
+    WCHAR appkey[MAX_PATH + 20];
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING nameW, valueW;
+    HANDLE root, config_key, hkey;
+    const WCHAR *p;
+    DWORD size;
+
+    if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1) return;
+
+    RtlOpenCurrentUser( KEY_ALL_ACCESS, &root );
+    attr.Length = sizeof(attr);
+    attr.RootDirectory = root;
+    attr.ObjectName = &nameW;
+    attr.Attributes = 0;
+    attr.SecurityDescriptor = NULL;
+    attr.SecurityQualityOfService = NULL;
+    RtlInitUnicodeString( &nameW, configW );
+    if (NtOpenKey( &config_key, KEY_QUERY_VALUE, &attr )) config_key = 0;
+    NtClose( root );
+    if (!config_key) return;
+
+    if ((p = strrchrW( appname, '/' ))) appname = p + 1;
+    if ((p = strrchrW( appname, '\\' ))) appname = p + 1;
+    if (strlenW( appname ) >= MAX_PATH) goto done;
+    strcpyW( appkey, appdefaultsW );
+    strcatW( appkey, appname );
+    RtlInitUnicodeString( &nameW, appkey );
+    attr.RootDirectory = config_key;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\AppDefaults\app.exe */
+    if (NtOpenKey( &hkey, KEY_QUERY_VALUE, &attr )) goto done;
+    RtlInitUnicodeString( &valueW, adaptivespinW );
+    if (!NtQueryValueKey( hkey, &valueW, KeyValuePartialInformation, buffer, sizeof(buffer), &size ))
+    {
+        if (info->Type == REG_DWORD && info->DataLength == sizeof(DWORD))
+            adaptive_spin = *(DWORD *)info->Data != 0;
+        else if (info->Type == REG_SZ)
+            adaptive_spin = IS_OPTION_TRUE( *(WCHAR *)info->Data );
+    }
+    NtClose( hkey );
+    if (adaptive_spin) TRACE( "using adaptive spinning for %s\n", debugstr_w(appname) );
+
+done:
+    NtClose( config_key );
+}
+
+/* lock contention statistics, enabled with WINEDEBUG=+lockstats */
+
+#define LOCK_STATS_SLOTS 1024
+#define LOCK_STATS_DUMP  64   /* number of locks reported on exit */
+
+struct lock_stats
+{
+    const void *lock;
+    LONG        contentions;
+    LONGLONG    total_wait;   /* in 100ns units */
+    LONGLONG    max_wait;
+    char        name[48];
+};
+
+static struct lock_stats lock_stats[LOCK_STATS_SLOTS];
+
+/***********************************************************************
+ *           get_lock_stats
+ *
+ * Find or allocate the statistics entry of a lock; NULL if the table is full.
+ */
+static struct lock_stats *get_lock_stats( const void *lock, const char *name )
+{
+    ULONG_PTR hash = (ULONG_PTR)lock / sizeof(void *);
+    unsigned int i, slot = (hash ^ (hash >> 10)) % LOCK_STATS_SLOTS;
+    struct lock_stats *stats;
+
+    for (i = 0; i < LOCK_STATS_SLOTS; i++, slot = (slot + 1) % LOCK_STATS_SLOTS)
+    {
+        stats = &lock_stats[slot];
+        if (stats->lock == lock) return stats;
+        if (stats->lock) continue;
+        if (interlocked_cmpxchg_ptr( (void **)&stats->lock, (void *)lock, NULL ))
+        {
+            if (stats->lock == lock) return stats;
+            continue;
+        }
+        /* names of Wine internal locks point into their module, keep a copy */
+        if (name) snprintf( stats->name, sizeof(stats->name), "%s", name );
+        return stats;
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           record_lock_contention
+ *
+ * Account for a wait on 'lock' that started at 'start'.
+ */
+void record_lock_contention( const void *lock, const char *name, const LARGE_INTEGER *start )
+{
+    struct lock_stats *stats;
+    LARGE_INTEGER now;
+    LONGLONG wait, max;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    if (!(stats = get_lock_stats( lock, name ))) return;
+
+    wait = now.QuadPart - start->QuadPart;
+    interlocked_xchg_add( &stats->contentions, 1 );
+    for (;;)
+    {
+        LONGLONG total = stats->total_wait;
+        if (interlocked_cmpxchg64( &stats->total_wait, total + wait, total ) == total) break;
+    }
+    while ((max = stats->max_wait) < wait)
+        if (interlocked_cmpxchg64( &stats->max_wait, wait, max ) == max) break;
+}
+
+static int compare_lock_stats( const void *p1, const void *p2 )
+{
+    const struct lock_stats *s1 = *(const struct lock_stats * const *)p1;
+    const struct lock_stats *s2 = *(const struct lock_stats * const *)p2;
+
+    if (s1->total_wait > s2->total_wait) return -1;
+    if (s1->total_wait < s2->total_wait) return 1;
+    return s2->contentions - s1->contentions;
+}
+
+/***********************************************************************
+ *           lock_dump_statistics
+ *
+ * Dump the most contended locks of the process, called on process exit.
+ */
+void lock_dump_statistics(void)
+{
+    struct lock_stats *sorted[LOCK_STATS_SLOTS];
+    unsigned int i, count = 0;
+
+    if (!TRACE_ON(lockstats)) return;
+
+    for (i = 0; i < LOCK_STATS_SLOTS; i++)
+        if (lock_stats[i].lock && lock_stats[i].contentions) sorted[count++] = &lock_stats[i];
+    qsort( sorted, count, sizeof(sorted[0]), compare_lock_stats );
+
+    TRACE_(lockstats)( "%u contended locks%s\n", count,
+                       count == LOCK_STATS_SLOTS ? ", table full" : "" );
+    for (i = 0; i < count && i < LOCK_STATS_DUMP; i++)
+        TRACE_(lockstats)( "%p %s: %u contentions, total wait %u.%06u s, max wait %u us\n",
+                           sorted[i]->lock, sorted[i]->name[0] ? sorted[i]->name : "?",
+                           sorted[i]->contentions,
+                           (unsigned int)(sorted[i]->total_wait / 10000000),
+                           (unsigned int)(sorted[i]->total_wait % 10000000) / 10,
+                           (unsigned int)(sorted[i]->max_wait / 10) );
+}
+
 #ifdef __linux__
 
 static int wait_op = 128; /*FUTEX_WAIT|FUTEX_PRIVATE_FLAG*/
@@ -436,6 +659,9 @@ NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
 NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
     LONGLONG timeout = NtCurrentTeb()->Peb->CriticalSectionTimeout.QuadPart / -10000000;
+    LARGE_INTEGER start;
+
+    if (TRACE_ON(lockstats)) NtQueryPerformanceCounter( &start, NULL );
     for (;;)
     {
         EXCEPTION_RECORD rec;
@@ -477,6 +703,8 @@ NTSTATUS WINAPI RtlpWaitForCriticalSection( RTL_CRITICAL_SECTION *crit )
         RtlRaiseException( &rec );
     }
     if (crit->DebugInfo) crit->DebugInfo->ContentionCount++;
+    if (TRACE_ON(lockstats))
+        record_lock_contention( crit, crit->DebugInfo ? (char *)crit->DebugInfo->Spare[0] : NULL, &start );
     return STATUS_SUCCESS;
 }
 
@@ -553,6 +781,15 @@ NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
             small_pause();
         }
     }
+    else if (adaptive_spin)
+    {
+        if (RtlTryEnterCriticalSection( crit )) return STATUS_SUCCESS;
+        if (adaptive_spin_enter( crit ))
+        {
+            if (crit->DebugInfo) crit->DebugInfo->EntryCount++;
+            goto done;
+        }
+    }
 
     if (interlocked_inc( &crit->LockCount ))
     {
@@ -25,9 +25,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 #include <ctype.h>
 
 #include "wine/debug.h"
@@ -36,7 +40,9 @@
 #include "wine/unicode.h"
 #include "winnt.h"
 #include "winternl.h"
+#include "evntprov.h"
 #include "ntdll_misc.h"
+#include "wine/debugtrace.h"
 
 WINE_DECLARE_DEBUG_CHANNEL(pid);
 WINE_DECLARE_DEBUG_CHANNEL(timestamp);
@@ -115,15 +121,413 @@ static const char *NTDLL_dbgstr_wn( const WCHAR *src, int n )
      return res;
 }
 
+/* binary trace sink, enabled by setting WINEDEBUGLOG to a directory */
+
+#define TRACE_STRING_HASH_SIZE 4096  /* must be a power of 2 */
+
+static const char *trace_dir;                               /* directory for the trace files */
+static int trace_strings_fd = -1;                           /* fd of the string table file */
+static LONG trace_ring_count;                               /* number of rings created so far */
+static const char *trace_strings[TRACE_STRING_HASH_SIZE];   /* strings already in the table */
+
+/* create the ring buffer of the current thread */
+static struct trace_ring_header *create_trace_ring(void)
+{
+    struct trace_ring_header *ring;
+    char *name;
+    int fd;
+
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, strlen(trace_dir) + 40 ))) return NULL;
+    sprintf( name, "%s/wine-%u-%u.trace", trace_dir, (unsigned int)getpid(),
+             (unsigned int)interlocked_xchg_add( &trace_ring_count, 1 ));
+    fd = open( name, O_RDWR | O_CREAT | O_TRUNC, 0666 );
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+    if (fd == -1) return NULL;
+
+    ring = NULL;
+    if (!ftruncate( fd, sizeof(*ring) + TRACE_RING_SIZE ))
+    {
+        ring = mmap( NULL, sizeof(*ring) + TRACE_RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        if (ring == MAP_FAILED) ring = NULL;
+    }
+    close( fd );
+    if (!ring) return NULL;
+
+    ring->magic    = TRACE_RING_MAGIC;
+    ring->version  = TRACE_VERSION;
+    ring->size     = TRACE_RING_SIZE;
+    ring->unix_pid = getpid();
+    ring->pid      = GetCurrentProcessId();
+    ring->tid      = GetCurrentThreadId();
+    ring->head     = 0;
+    ring->tail     = 0;
+    return ring;
+}
+
+/* get the ring buffer of the current thread, creating it if needed */
+static struct trace_ring_header *get_trace_ring(void)
+{
+    struct debug_info *info = get_info();
+
+    if (!info->trace_ring && !(info->trace_ring = create_trace_ring()))
+    {
+        static int once;
+        if (!once++) fprintf( stderr, "wine: cannot create trace buffer in %s, using text output\n", trace_dir );
+        trace_dir = NULL;
+        return NULL;
+    }
+    /* early records may have been written before the ids were known */
+    if (!info->trace_ring->tid)
+    {
+        info->trace_ring->pid = GetCurrentProcessId();
+        info->trace_ring->tid = GetCurrentThreadId();
+    }
+    return info->trace_ring;
+}
+
+/* add a string to the string table file, unless it's already there */
+static void trace_register_string( const char *str )
+{
+    char buffer[sizeof(struct trace_string) + TRACE_MAX_FORMAT];
+    struct trace_string *entry = (struct trace_string *)buffer;
+    ULONG_PTR hash = (ULONG_PTR)str ^ ((ULONG_PTR)str >> 12);
+    unsigned int i, len;
+
+    for (i = 0; i < TRACE_STRING_HASH_SIZE; i++)
+    {
+        const char **slot = &trace_strings[(hash + i) & (TRACE_STRING_HASH_SIZE - 1)];
+        const char *prev = *slot;
+
+        if (!prev && !(prev = interlocked_cmpxchg_ptr( (void **)slot, (void *)str, NULL ))) break;
+        if (prev == str) return;
+    }
+    /* if the table is full the string is simply written again */
+
+    len = strlen( str );
+    if (len > TRACE_MAX_FORMAT) len = TRACE_MAX_FORMAT;
+    entry->addr = (ULONG_PTR)str;
+    entry->len  = len;
+    memcpy( entry + 1, str, len );
+    write( trace_strings_fd, buffer, sizeof(*entry) + len );
+}
+
+/* store the arguments described by the format string */
+static char *trace_put_args( char *ptr, char *end, const char *format, va_list args, BOOL *truncated )
+{
+    const char *p;
+    ULONGLONG val;
+    double dbl;
+
+    for (p = format; *p; p++)
+    {
+        int size = 0;  /* 0: int, 1: long, 2: long long, 3: pointer sized */
+        char type;
+
+        if (*p != '%') continue;
+        if (*++p == '%') continue;
+
+        while (*p && strchr( "-+ #0'", *p )) p++;
+        if (*p == '*')
+        {
+            if (end - ptr < 9) goto done;
+            *ptr++ = 'i';
+            val = (LONGLONG)va_arg( args, int );
+            memcpy( ptr, &val, sizeof(val) );
+            ptr += sizeof(val);
+            p++;
+        }
+        else while (isdigit( *p )) p++;
+        if (*p == '.')
+        {
+            p++;
+            if (*p == '*')
+            {
+                if (end - ptr < 9) goto done;
+                *ptr++ = 'i';
+                val = (LONGLONG)va_arg( args, int );
+                memcpy( ptr, &val, sizeof(val) );
+                ptr += sizeof(val);
+                p++;
+            }
+            else while (isdigit( *p )) p++;
+        }
+
+        switch (*p)
+        {
+        case 'h':
+            if (*++p == 'h') p++;
+            break;
+        case 'l':
+            size = 1;
+            if (*++p == 'l') { size = 2; p++; }
+            break;
+        case 'L':
+        case 'q':
+        case 'j':
+            size = 2;
+            p++;
+            break;
+        case 'z':
+        case 't':
+            size = 3;
+            p++;
+            break;
+        case 'I':
+            if (p[1] == '6' && p[2] == '4') { size = 2; p += 3; }
+            else if (p[1] == '3' && p[2] == '2') p += 3;
+            else { size = 3; p++; }
+            break;
+        }
+
+        if (end - ptr < 9) goto done;
+        switch (*p)
+        {
+        case 'd':
+        case 'i':
+            if (size == 0) val = (LONGLONG)va_arg( args, int );
+            else if (size == 1) val = (LONGLONG)va_arg( args, long );
+            else if (size == 2) val = va_arg( args, LONGLONG );
+            else val = (LONGLONG)va_arg( args, LONG_PTR );
+            type = 'i';
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (size == 0) val = va_arg( args, unsigned int );
+            else if (size == 1) val = va_arg( args, unsigned long );
+            else if (size == 2) val = va_arg( args, ULONGLONG );
+            else val = va_arg( args, ULONG_PTR );
+            type = 'u';
+            break;
+        case 'c':
+            val = va_arg( args, int );
+            type = 'u';
+            break;
+        case 'p':
+            val = (ULONG_PTR)va_arg( args, void * );
+            type = 'p';
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (size == 2) dbl = va_arg( args, long double );
+            else dbl = va_arg( args, double );
+            memcpy( &val, &dbl, sizeof(val) );
+            type = 'f';
+            break;
+        case 's':
+        {
+            const char *str = va_arg( args, const char * );
+            unsigned short len;
+
+            if (size) str = "(wide)";  /* %ls is not used for Windows strings */
+            else if (!str) str = "(null)";
+            len = strlen( str );
+            if (len > TRACE_MAX_STRING) len = TRACE_MAX_STRING;
+            if (end - ptr < 3 + len) goto done;
+            *ptr++ = 's';
+            memcpy( ptr, &len, sizeof(len) );
+            memcpy( ptr + sizeof(len), str, len );
+            ptr += sizeof(len) + len;
+            continue;
+        }
+        case 'n':
+            va_arg( args, void * );
+            continue;
+        default:
+            /* unknown conversion, we can't tell how to fetch the remaining arguments */
+            *truncated = TRUE;
+            return ptr;
+        }
+        *ptr++ = type;
+        memcpy( ptr, &val, sizeof(val) );
+        ptr += sizeof(val);
+    }
+    return ptr;
+
+done:
+    *truncated = TRUE;
+    return ptr;
+}
+
+/* reserve space for a record of the given size, discarding the oldest records if needed */
+static struct trace_record *trace_ring_alloc( struct trace_ring_header *ring, unsigned int size )
+{
+    char *data = (char *)(ring + 1);
+    unsigned int pos = ring->head % ring->size;
+    unsigned int pad = (pos + size > ring->size) ? ring->size - pos : 0;
+    ULONGLONG new_head = ring->head + pad + size;
+
+    while (new_head - ring->tail > ring->size)
+    {
+        unsigned int tail_pos = ring->tail % ring->size;
+        struct trace_record *rec = (struct trace_record *)(data + tail_pos);
+
+        if (!rec->size) ring->tail += ring->size - tail_pos;  /* end of ring marker */
+        else ring->tail += rec->size;
+    }
+    if (pad)
+    {
+        ((struct trace_record *)(data + pos))->size = 0;
+        ring->head += pad;
+        pos = 0;
+    }
+    return (struct trace_record *)(data + pos);
+}
+
+/* write a record to the ring buffer of the current thread */
+static BOOL trace_write( unsigned char cls, const char *channel, const char *function,
+                         const char *format, va_list args )
+{
+    char buffer[TRACE_MAX_RECORD];
+    struct trace_record *rec = (struct trace_record *)buffer;
+    struct trace_ring_header *ring;
+    LARGE_INTEGER now;
+    BOOL truncated = FALSE;
+    char *end;
+
+    if (!(ring = get_trace_ring())) return FALSE;
+
+    rec->cls   = cls;
+    rec->flags = 0;
+    if (format && *format == '\1')  /* special magic to avoid standard prefix */
+    {
+        rec->flags |= TRACE_FLAG_NO_PREFIX;
+        format++;
+    }
+    NtQueryPerformanceCounter( &now, NULL );
+    rec->time     = now.QuadPart;
+    rec->channel  = (ULONG_PTR)channel;
+    rec->function = (ULONG_PTR)function;
+    rec->format   = (ULONG_PTR)format;
+    if (channel) trace_register_string( channel );
+    if (function) trace_register_string( function );
+    if (format) trace_register_string( format );
+
+    end = (char *)(rec + 1);
+    if (format) end = trace_put_args( end, buffer + sizeof(buffer), format, args, &truncated );
+    if (truncated) rec->flags |= TRACE_FLAG_TRUNCATED;
+    rec->size = (end - buffer + 7) & ~7;
+
+    memcpy( trace_ring_alloc( ring, rec->size ), buffer, rec->size );
+    ring->head += rec->size;
+    return TRUE;
+}
+
+/***********************************************************************
+ *		debug_trace_enabled
+ *
+ * Check whether the binary trace sink is available for ETW events.
+ */
+BOOL debug_trace_enabled(void)
+{
+    return trace_dir != NULL;
+}
+
+/***********************************************************************
+ *		debug_trace_event
+ *
+ * Store an ETW event in the ring buffer of the current thread. The user
+ * data is copied straight into the ring and truncated if it's too large.
+ */
+BOOL debug_trace_event( const GUID *provider, const EVENT_DESCRIPTOR *descriptor, const GUID *activity,
+                        const GUID *related, ULONG count, const EVENT_DATA_DESCRIPTOR *data )
+{
+    struct trace_ring_header *ring;
+    struct trace_record *rec;
+    struct trace_event *event;
+    LARGE_INTEGER now;
+    unsigned int i, size, data_size = 0;
+    BOOL truncated = FALSE;
+    char *ptr;
+
+    if (!trace_dir || !(ring = get_trace_ring())) return FALSE;
+
+    for (i = 0; i < count; i++) data_size += data[i].Size;
+    if (data_size > TRACE_MAX_EVENT - sizeof(*rec) - sizeof(*event))
+    {
+        data_size = TRACE_MAX_EVENT - sizeof(*rec) - sizeof(*event);
+        truncated = TRUE;
+    }
+    size = (sizeof(*rec) + sizeof(*event) + data_size + 7) & ~7;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    rec = trace_ring_alloc( ring, size );
+    rec->size     = size;
+    rec->cls      = TRACE_CLASS_EVENT;
+    rec->flags    = truncated ? TRACE_FLAG_TRUNCATED : 0;
+    rec->pad      = 0;
+    rec->time     = now.QuadPart;
+    rec->channel  = 0;
+    rec->function = 0;
+    rec->format   = 0;
+
+    event = (struct trace_event *)(rec + 1);
+    event->provider = *provider;
+    if (activity) event->activity = *activity;
+    else memset( &event->activity, 0, sizeof(event->activity) );
+    if (related) event->related = *related;
+    else memset( &event->related, 0, sizeof(event->related) );
+    event->id        = descriptor->Id;
+    event->version   = descriptor->Version;
+    event->channel   = descriptor->Channel;
+    event->level     = descriptor->Level;
+    event->opcode    = descriptor->Opcode;
+    event->task      = descriptor->Task;
+    event->keyword   = descriptor->Keyword;
+    event->data_size = data_size;
+    event->pad       = 0;
+
+    ptr = (char *)(event + 1);
+    for (i = 0; i < count && data_size; i++)
+    {
+        unsigned int len = min( data[i].Size, data_size );
+        memcpy( ptr, (const void *)(ULONG_PTR)data[i].Ptr, len );
+        ptr += len;
+        data_size -= len;
+    }
+    ring->head += size;
+    return TRUE;
+}
+
+/***********************************************************************
+ *		trace_init
+ */
+static void trace_init(void)
+{
+    char *name;
+    const char *dir = getenv( "WINEDEBUGLOG" );
+
+    if (!dir || !*dir) return;
+    if (!(name = malloc( strlen(dir) + 32 ))) return;
+    sprintf( name, "%s/wine-%u.str", dir, (unsigned int)getpid() );
+    trace_strings_fd = open( name, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666 );
+    free( name );
+    if (trace_strings_fd == -1)
+    {
+        fprintf( stderr, "wine: cannot create trace files in %s, using text output\n", dir );
+        return;
+    }
+    trace_dir = dir;
+}
+
 /***********************************************************************
  *		NTDLL_dbg_vprintf
  */
 static int NTDLL_dbg_vprintf( const char *format, va_list args )
 {
     struct debug_info *info = get_info();
-    int end;
+    int ret, end;
+
+    if (trace_dir && trace_write( TRACE_CLASS_CONT, NULL, NULL, format, args )) return 0;
 
-    int ret = vsnprintf( info->out_pos, sizeof(info->output) - (info->out_pos - info->output),
+    ret = vsnprintf( info->out_pos, sizeof(info->output) - (info->out_pos - info->output),
                          format, args );
 
     /* make sure we didn't exceed the buffer length
@@ -162,6 +566,8 @@ static int NTDLL_dbg_vlog( enum __wine_debug_class cls, struct __wine_debug_chan
     struct debug_info *info = get_info();
     int ret = 0;
 
+    if (trace_dir && trace_write( cls, channel->name, function, format, args )) return 0;
+
     /* only print header if we are at the beginning of the line */
     if (info->out_pos == info->output || info->out_pos[-1] == '\n')
     {
@@ -194,10 +600,25 @@ static const struct __wine_debug_functions funcs =
     NTDLL_dbg_vlog
 };
 
+/***********************************************************************
+ *		debug_exit_thread
+ *
+ * Release the trace buffer of the exiting thread, the file keeps its contents.
+ */
+void debug_exit_thread(void)
+{
+    struct debug_info *info = get_info();
+
+    if (!info->trace_ring) return;
+    munmap( info->trace_ring, sizeof(*info->trace_ring) + info->trace_ring->size );
+    info->trace_ring = NULL;
+}
+
 /***********************************************************************
  *		debug_init
  */
 void debug_init(void)
 {
+    trace_init();
     __wine_dbg_set_functions( &funcs, &default_funcs, sizeof(funcs) );
 }
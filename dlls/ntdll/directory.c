@@ -1499,15 +1499,19 @@ static NTSTATUS get_dir_data_entry( struct dir_data *dir_data, void *info_ptr, I
     struct stat st;
     ULONG name_len, start, dir_size, attributes;
 
-    if (get_file_info( names->unix_name, &st, &attributes ) == -1)
+    /* the names don't need any stat() call, unless some files must be hidden */
+    if (class != FileNamesInformation || ignored_files_count)
     {
-        TRACE( "file no longer exists %s\n", names->unix_name );
-        return STATUS_SUCCESS;
-    }
-    if (is_ignored_file( &st ))
-    {
-        TRACE( "ignoring file %s\n", names->unix_name );
-        return STATUS_SUCCESS;
+        if (get_file_info( names->unix_name, &st, &attributes ) == -1)
+        {
+            TRACE( "file no longer exists %s\n", names->unix_name );
+            return STATUS_SUCCESS;
+        }
+        if (is_ignored_file( &st ))
+        {
+            TRACE( "ignoring file %s\n", names->unix_name );
+            return STATUS_SUCCESS;
+        }
     }
     start = dir_info_align( io->Information );
     dir_size = dir_info_size( class, 0 );
@@ -2024,6 +2028,407 @@ NTSTATUS WINAPI NtQueryDirectoryFile( HANDLE handle, HANDLE event,
 }
 
 
+/* case-insensitive index of the names in a directory, to avoid scanning it on every lookup */
+struct dir_index_entry
+{
+    unsigned int hash;   /* hash of the upper-case Unicode name */
+    unsigned int next;   /* next entry in the same bucket */
+    unsigned int len;    /* length of the Unicode name */
+    unsigned int name;   /* offset of the Unix name in the pool */
+};
+
+struct dir_index
+{
+    struct list             entry;         /* entry in LRU list */
+    dev_t                   dev;           /* identity of the directory */
+    ino_t                   ino;
+    time_t                  mtime;         /* modification time when the index was built */
+    long                    mtime_nsec;
+    unsigned int            count;         /* number of names */
+    unsigned int            mask;          /* number of buckets - 1 */
+    unsigned int           *buckets;       /* first entry of each bucket */
+    struct dir_index_entry *entries;
+    unsigned int           *short_buckets; /* same for hashed short names, built on demand */
+    struct dir_index_entry *short_entries;
+    char                   *pool;          /* Unix names */
+};
+
+#define DIR_INDEX_MAX       64    /* max number of indexed directories */
+#define DIR_INDEX_NONE      (~0u)
+
+/* resolved Unix directory of an NT directory path, so that opening several files
+ * in the same directory only needs the last element to be looked up */
+struct path_cache_entry
+{
+    unsigned int hash;
+    int          base_len;     /* length of the Unix base the NT path is relative to */
+    int          dir_len;      /* length of the NT directory path */
+    dev_t        dev;          /* identity of the Unix directory */
+    ino_t        ino;
+    char        *unix_dir;     /* base followed by the Unix directory path */
+    WCHAR        dir[1];       /* NT directory path */
+};
+
+#define PATH_CACHE_SIZE     256
+
+static struct path_cache_entry *path_cache[PATH_CACHE_SIZE];  /* protected by dir_index_section */
+
+static struct list dir_index_list = LIST_INIT( dir_index_list );
+static unsigned int dir_index_count;
+
+static RTL_CRITICAL_SECTION dir_index_section;
+static RTL_CRITICAL_SECTION_DEBUG dir_index_critsect_debug =
+{
+    0, 0, &dir_index_section,
+    { &dir_index_critsect_debug.ProcessLocksList, &dir_index_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": dir_index_section") }
+};
+static RTL_CRITICAL_SECTION dir_index_section = { &dir_index_critsect_debug, -1, 0, 0, 0, 0 };
+
+enum dir_index_result
+{
+    DIR_INDEX_FOUND,
+    DIR_INDEX_NOT_FOUND,
+    DIR_INDEX_UNAVAILABLE
+};
+
+static inline long get_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static unsigned int hash_name_nocase( const WCHAR *name, unsigned int len )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < len; i++) hash = hash * 65599 + toupperW( name[i] );
+    return hash;
+}
+
+static void free_dir_index( struct dir_index *index )
+{
+    list_remove( &index->entry );
+    dir_index_count--;
+    RtlFreeHeap( GetProcessHeap(), 0, index->buckets );
+    RtlFreeHeap( GetProcessHeap(), 0, index->entries );
+    RtlFreeHeap( GetProcessHeap(), 0, index->short_buckets );
+    RtlFreeHeap( GetProcessHeap(), 0, index->short_entries );
+    RtlFreeHeap( GetProcessHeap(), 0, index->pool );
+    RtlFreeHeap( GetProcessHeap(), 0, index );
+}
+
+static void insert_dir_index_entry( unsigned int *buckets, struct dir_index_entry *entries,
+                                    unsigned int mask, unsigned int idx )
+{
+    unsigned int *bucket = &buckets[entries[idx].hash & mask];
+
+    entries[idx].next = *bucket;
+    *bucket = idx;
+}
+
+/* build the index of a directory; unix_name is the directory path */
+static struct dir_index *create_dir_index( const char *unix_name, const struct stat *st )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    struct dir_index *index;
+    struct dirent *de;
+    size_t pool_size = 4096, pool_pos = 0;
+    unsigned int size = 256, i;
+    DIR *dir;
+    int len;
+
+    if (!(dir = opendir( unix_name ))) return NULL;
+    if (!(index = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*index) ))) goto failed;
+    index->dev        = st->st_dev;
+    index->ino        = st->st_ino;
+    index->mtime      = st->st_mtime;
+    index->mtime_nsec = get_mtime_nsec( st );
+    if (!(index->entries = RtlAllocateHeap( GetProcessHeap(), 0, size * sizeof(*index->entries) ))) goto failed;
+    if (!(index->pool = RtlAllocateHeap( GetProcessHeap(), 0, pool_size ))) goto failed;
+
+    while ((de = readdir( dir )))
+    {
+        size_t name_len = strlen( de->d_name ) + 1;
+        struct dir_index_entry *entry;
+
+        if ((len = ntdll_umbstowcs( 0, de->d_name, name_len - 1, buffer, MAX_DIR_ENTRY_LEN )) <= 0) continue;
+        if (index->count == size)
+        {
+            void *new_entries = RtlReAllocateHeap( GetProcessHeap(), 0, index->entries,
+                                                   2 * size * sizeof(*index->entries) );
+            if (!new_entries) goto failed;
+            index->entries = new_entries;
+            size *= 2;
+        }
+        if (pool_pos + name_len > pool_size)
+        {
+            void *new_pool = RtlReAllocateHeap( GetProcessHeap(), 0, index->pool,
+                                                max( 2 * pool_size, pool_pos + name_len ));
+            if (!new_pool) goto failed;
+            index->pool = new_pool;
+            pool_size = max( 2 * pool_size, pool_pos + name_len );
+        }
+        entry = &index->entries[index->count++];
+        entry->hash = hash_name_nocase( buffer, len );
+        entry->len  = len;
+        entry->name = pool_pos;
+        memcpy( index->pool + pool_pos, de->d_name, name_len );
+        pool_pos += name_len;
+    }
+    closedir( dir );
+    dir = NULL;
+
+    for (index->mask = 15; index->mask < index->count; index->mask = index->mask * 2 + 1) /* nothing */;
+    if (!(index->buckets = RtlAllocateHeap( GetProcessHeap(), 0, (index->mask + 1) * sizeof(*index->buckets) )))
+        goto failed;
+    memset( index->buckets, 0xff, (index->mask + 1) * sizeof(*index->buckets) );
+    /* insert backwards so that each bucket is in readdir order, like a scan would find them */
+    for (i = index->count; i > 0; i--)
+        insert_dir_index_entry( index->buckets, index->entries, index->mask, i - 1 );
+
+    list_add_head( &dir_index_list, &index->entry );
+    dir_index_count++;
+    return index;
+
+failed:
+    if (dir) closedir( dir );
+    if (index)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, index->entries );
+        RtlFreeHeap( GetProcessHeap(), 0, index->pool );
+        RtlFreeHeap( GetProcessHeap(), 0, index->buckets );
+        RtlFreeHeap( GetProcessHeap(), 0, index );
+    }
+    return NULL;
+}
+
+/* build the table of hashed short names, for the names that aren't valid 8.3 names */
+static BOOL create_dir_index_short_names( struct dir_index *index )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN], short_nameW[12];
+    UNICODE_STRING str;
+    BOOLEAN spaces;
+    unsigned int i, count = 0;
+
+    if (!(index->short_entries = RtlAllocateHeap( GetProcessHeap(), 0,
+                                                  max( 1, index->count ) * sizeof(*index->short_entries) )))
+        return FALSE;
+    if (!(index->short_buckets = RtlAllocateHeap( GetProcessHeap(), 0,
+                                                  (index->mask + 1) * sizeof(*index->short_buckets) )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, index->short_entries );
+        index->short_entries = NULL;
+        return FALSE;
+    }
+    memset( index->short_buckets, 0xff, (index->mask + 1) * sizeof(*index->short_buckets) );
+
+    str.Buffer = buffer;
+    str.MaximumLength = sizeof(buffer);
+    for (i = 0; i < index->count; i++)
+    {
+        const char *name = index->pool + index->entries[i].name;
+
+        str.Length = ntdll_umbstowcs( 0, name, strlen(name), buffer, MAX_DIR_ENTRY_LEN ) * sizeof(WCHAR);
+        if (RtlIsNameLegalDOS8Dot3( &str, NULL, &spaces ) && !spaces) continue;
+        index->short_entries[count].len  = hash_short_file_name( &str, short_nameW );
+        index->short_entries[count].hash = hash_name_nocase( short_nameW, index->short_entries[count].len );
+        index->short_entries[count].name = index->entries[i].name;
+        count++;
+    }
+    for (i = count; i > 0; i--)
+        insert_dir_index_entry( index->short_buckets, index->short_entries, index->mask, i - 1 );
+    return TRUE;
+}
+
+/* look for a name in one of the index tables; the Unix name is appended to unix_name at pos */
+static BOOL find_dir_index_entry( const struct dir_index *index, const unsigned int *buckets,
+                                  const struct dir_index_entry *entries, BOOL short_names,
+                                  char *unix_name, int pos, const WCHAR *name, int length )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN];
+    unsigned int hash = hash_name_nocase( name, length ), idx;
+
+    for (idx = buckets[hash & index->mask]; idx != DIR_INDEX_NONE; idx = entries[idx].next)
+    {
+        const char *unix_entry = index->pool + entries[idx].name;
+
+        if (entries[idx].hash != hash || entries[idx].len != length) continue;
+        if (short_names)
+        {
+            UNICODE_STRING str;
+            WCHAR short_nameW[12];
+
+            str.Buffer = buffer;
+            str.Length = ntdll_umbstowcs( 0, unix_entry, strlen(unix_entry), buffer, MAX_DIR_ENTRY_LEN ) * sizeof(WCHAR);
+            str.MaximumLength = sizeof(buffer);
+            hash_short_file_name( &str, short_nameW );
+            if (memicmpW( short_nameW, name, length )) continue;
+        }
+        else
+        {
+            ntdll_umbstowcs( 0, unix_entry, strlen(unix_entry), buffer, MAX_DIR_ENTRY_LEN );
+            if (memicmpW( buffer, name, length )) continue;
+        }
+        strcpy( unix_name + pos, unix_entry );
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/***********************************************************************
+ *           lookup_dir_index
+ *
+ * Case-insensitive lookup of a name through the cached index of its directory.
+ * unix_name contains the directory path, the name found is appended at pos.
+ */
+static enum dir_index_result lookup_dir_index( char *unix_name, int pos, const WCHAR *name, int length,
+                                               BOOLEAN is_name_8_dot_3 )
+{
+    enum dir_index_result ret = DIR_INDEX_NOT_FOUND;
+    struct dir_index *index;
+    struct stat st;
+
+    if (stat( unix_name, &st ) == -1) return DIR_INDEX_UNAVAILABLE;
+
+    RtlEnterCriticalSection( &dir_index_section );
+
+    LIST_FOR_EACH_ENTRY( index, &dir_index_list, struct dir_index, entry )
+    {
+        if (index->dev != st.st_dev || index->ino != st.st_ino) continue;
+        if (index->mtime == st.st_mtime && index->mtime_nsec == get_mtime_nsec( &st ))
+        {
+            list_remove( &index->entry );
+            list_add_head( &dir_index_list, &index->entry );
+            goto found;
+        }
+        free_dir_index( index );
+        break;
+    }
+
+    /* a directory modified in the last second may change again without its mtime changing */
+    if (st.st_mtime >= time( NULL ) - 1 || !(index = create_dir_index( unix_name, &st )))
+    {
+        RtlLeaveCriticalSection( &dir_index_section );
+        return DIR_INDEX_UNAVAILABLE;
+    }
+    TRACE( "indexed %s (%u names)\n", debugstr_a(unix_name), index->count );
+    if (dir_index_count > DIR_INDEX_MAX)
+        free_dir_index( LIST_ENTRY( list_tail( &dir_index_list ), struct dir_index, entry ));
+
+found:
+    unix_name[pos - 1] = '/';
+    if (find_dir_index_entry( index, index->buckets, index->entries, FALSE, unix_name, pos, name, length ))
+        ret = DIR_INDEX_FOUND;
+    else if (is_name_8_dot_3 && (index->short_buckets || create_dir_index_short_names( index )) &&
+             find_dir_index_entry( index, index->short_buckets, index->short_entries, TRUE,
+                                   unix_name, pos, name, length ))
+        ret = DIR_INDEX_FOUND;
+    else if (is_name_8_dot_3 && !index->short_buckets)
+        ret = DIR_INDEX_UNAVAILABLE;
+
+    if (ret != DIR_INDEX_FOUND) unix_name[pos - 1] = 0;
+    RtlLeaveCriticalSection( &dir_index_section );
+    return ret;
+}
+
+
+static unsigned int hash_path( const char *base, int base_len, const WCHAR *dir, int dir_len )
+{
+    unsigned int hash = hash_name_nocase( dir, dir_len );
+    int i;
+
+    for (i = 0; i < base_len; i++) hash = hash * 65599 + (unsigned char)base[i];
+    return hash;
+}
+
+/***********************************************************************
+ *           lookup_path_cache
+ *
+ * Case-insensitive lookup of an NT directory path relative to the Unix base
+ * at the start of the buffer. On success the Unix directory replaces the
+ * end of the buffer and its length is returned.
+ */
+static int lookup_path_cache( char **buffer, int *unix_len, int pos, const WCHAR *dir, int dir_len )
+{
+    unsigned int hash = hash_path( *buffer, pos, dir, dir_len );
+    struct path_cache_entry *entry;
+    struct stat st;
+    dev_t dev = 0;
+    ino_t ino = 0;
+    int len = 0;
+
+    RtlEnterCriticalSection( &dir_index_section );
+    entry = path_cache[hash % PATH_CACHE_SIZE];
+    if (entry && entry->hash == hash && entry->base_len == pos && entry->dir_len == dir_len &&
+        !memcmp( entry->unix_dir, *buffer, pos ) && !memicmpW( entry->dir, dir, dir_len ))
+    {
+        len = strlen( entry->unix_dir );
+        if (*unix_len - len < MAX_DIR_ENTRY_LEN + 2)
+        {
+            char *new_name;
+            int new_len = len + 2 * MAX_DIR_ENTRY_LEN;
+
+            if ((new_name = RtlReAllocateHeap( GetProcessHeap(), 0, *buffer, new_len )))
+            {
+                *buffer = new_name;
+                *unix_len = new_len;
+            }
+            else len = 0;
+        }
+        if (len)
+        {
+            memcpy( *buffer + pos, entry->unix_dir + pos, len - pos + 1 );
+            dev = entry->dev;
+            ino = entry->ino;
+        }
+    }
+    RtlLeaveCriticalSection( &dir_index_section );
+
+    if (!len) return 0;
+    /* the directory may have been removed or replaced since it was cached */
+    if (stat( *buffer, &st ) == -1 || st.st_dev != dev || st.st_ino != ino)
+    {
+        (*buffer)[pos] = 0;
+        return 0;
+    }
+    return len;
+}
+
+/* remember the Unix directory that an NT directory path resolved to */
+static void add_path_cache( const char *unix_name, int base_len, int pos, const WCHAR *dir, int dir_len )
+{
+    unsigned int hash = hash_path( unix_name, base_len, dir, dir_len );
+    struct path_cache_entry *entry, *old;
+    struct stat st;
+
+    if (stat( unix_name, &st ) == -1 || !S_ISDIR( st.st_mode )) return;
+    if (!(entry = RtlAllocateHeap( GetProcessHeap(), 0,
+                                   FIELD_OFFSET( struct path_cache_entry, dir[dir_len] ) + pos + 1 )))
+        return;
+    entry->hash     = hash;
+    entry->base_len = base_len;
+    entry->dir_len  = dir_len;
+    entry->dev      = st.st_dev;
+    entry->ino      = st.st_ino;
+    entry->unix_dir = (char *)(entry->dir + dir_len);
+    memcpy( entry->dir, dir, dir_len * sizeof(WCHAR) );
+    memcpy( entry->unix_dir, unix_name, pos );
+    entry->unix_dir[pos] = 0;
+
+    RtlEnterCriticalSection( &dir_index_section );
+    old = path_cache[hash % PATH_CACHE_SIZE];
+    path_cache[hash % PATH_CACHE_SIZE] = entry;
+    RtlLeaveCriticalSection( &dir_index_section );
+    RtlFreeHeap( GetProcessHeap(), 0, old );
+}
+
+
 /***********************************************************************
  *           find_file_in_dir
  *
@@ -2134,6 +2539,13 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
     }
 #endif /* VFAT_IOCTL_READDIR_BOTH */
 
+    switch (lookup_dir_index( unix_name, pos, name, length, is_name_8_dot_3 ))
+    {
+    case DIR_INDEX_FOUND:     goto success;
+    case DIR_INDEX_NOT_FOUND: goto not_found;
+    case DIR_INDEX_UNAVAILABLE: break;  /* scan the directory */
+    }
+
     if (!(dir = opendir( unix_name )))
     {
         if (errno == ENOENT) return STATUS_OBJECT_PATH_NOT_FOUND;
@@ -2624,10 +3036,11 @@ done:
 static NTSTATUS lookup_unix_name( const WCHAR *name, int name_len, char **buffer, int unix_len, int pos,
                                   UINT disposition, BOOLEAN check_case )
 {
-    NTSTATUS status;
-    int ret, used_default, len;
+    NTSTATUS status = STATUS_SUCCESS;
+    int ret, used_default, len, base_pos = pos, dir_len = 0;
     struct stat st;
     char *unix_name = *buffer;
+    const WCHAR *dir = NULL, *last = NULL;
     const BOOL redirect = nb_redirects && ntdll_get_thread_data()->wow64_redir;
 
     /* try a shortcut first */
@@ -2663,6 +3076,26 @@ static NTSTATUS lookup_unix_name( const WCHAR *name, int name_len, char **buffer
     if (check_case && !redirect && (disposition == FILE_OPEN || disposition == FILE_OVERWRITE))
         return STATUS_OBJECT_NAME_NOT_FOUND;
 
+    /* try to find the directory in the path cache, relative names depend on the current directory */
+
+    if (!check_case && !redirect && unix_name[0] == '/')
+    {
+        dir = name;
+        for (dir_len = name_len; dir_len && !IS_SEPARATOR(name[dir_len - 1]); dir_len--) /* nothing */;
+        last = name + dir_len;
+        while (dir_len && IS_SEPARATOR(name[dir_len - 1])) dir_len--;
+        if (last == name + name_len) dir_len = 0;  /* trailing separator */
+
+        if (dir_len && (len = lookup_path_cache( buffer, &unix_len, pos, dir, dir_len )))
+        {
+            pos = len;
+            name_len -= last - name;
+            name = last;
+            dir_len = 0;
+        }
+        unix_name = *buffer;  /* the buffer may have been grown */
+    }
+
     /* now do it component by component */
 
     while (name_len)
@@ -2720,6 +3153,8 @@ static NTSTATUS lookup_unix_name( const WCHAR *name, int name_len, char **buffer
         pos += strlen( unix_name + pos );
         name = next;
 
+        if (dir_len && name == last) add_path_cache( unix_name, base_pos, pos, dir, dir_len );
+
         if (is_win_dir && (len = get_redirect_path( unix_name, pos, name, name_len, check_case )))
         {
             name += len;
@@ -0,0 +1,854 @@
+/*
+ * In-process synchronization objects
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * When WINEFASTSYNC=1 is set, unnamed and non-inheritable events, semaphores
+ * and mutexes keep their state in the process instead of in the wineserver.
+ * The server object is still created so that the handle stays valid, but
+ * signaling and waiting are resolved locally, using futexes to sleep.
+ *
+ * Whenever an object escapes the process or has to be waited on together
+ * with other server objects (mixed or alertable waits, duplication to another
+ * process, being signaled by the server on completion of an async request),
+ * its state is copied to the server object and it is "demoted": from then on
+ * every operation goes to the server as usual.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#include <time.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+#include "wine/server.h"
+#include "wine/list.h"
+#include "wine/debug.h"
+#include "ntdll_misc.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(sync);
+
+#ifdef __linux__
+
+static int wait_op = 128; /*FUTEX_WAIT|FUTEX_PRIVATE_FLAG*/
+static int wake_op = 129; /*FUTEX_WAKE|FUTEX_PRIVATE_FLAG*/
+
+static inline int futex_wait( int *addr, int val, struct timespec *timeout )
+{
+    return syscall( __NR_futex, addr, wait_op, val, timeout, 0, 0 );
+}
+
+static inline int futex_wake( int *addr, int val )
+{
+    return syscall( __NR_futex, addr, wake_op, val, NULL, 0, 0 );
+}
+
+static int use_futexes(void)
+{
+    static int supported = -1;
+
+    if (supported == -1)
+    {
+        futex_wait( &supported, 10, NULL );
+        if (errno == ENOSYS)
+        {
+            wait_op = 0; /*FUTEX_WAIT*/
+            wake_op = 1; /*FUTEX_WAKE*/
+            futex_wait( &supported, 10, NULL );
+        }
+        supported = (errno != ENOSYS);
+    }
+    return supported;
+}
+
+#else
+
+static inline int futex_wait( int *addr, int val, struct timespec *timeout ) { return -1; }
+static inline int futex_wake( int *addr, int val ) { return -1; }
+static int use_futexes(void) { return 0; }
+
+#endif
+
+enum fast_sync_type
+{
+    FAST_SYNC_EVENT,
+    FAST_SYNC_SEMAPHORE,
+    FAST_SYNC_MUTEX
+};
+
+struct fast_sync
+{
+    enum fast_sync_type type;
+    LONG                refcount;       /* handles and waiting threads referencing the object */
+    BOOL                demoted;        /* state has been moved to the server object */
+    BOOL                demote_pending; /* demote when the owning thread releases the mutex */
+    int                 serial;         /* futex bumped when the state changes */
+    int                 sleepers;       /* threads sleeping on serial */
+    struct list         entry;          /* entry in the mutex list */
+    union
+    {
+        struct
+        {
+            BOOL manual;
+            BOOL signaled;
+        } event;
+        struct
+        {
+            ULONG count;
+            ULONG max;
+            ULONG initial;        /* count of the server object */
+        } semaphore;
+        struct
+        {
+            DWORD owner;
+            ULONG count;
+            BOOL  abandoned;
+        } mutex;
+    } u;
+};
+
+static RTL_CRITICAL_SECTION fast_sync_section;
+static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
+{
+    0, 0, &fast_sync_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": fast_sync_section") }
+};
+static RTL_CRITICAL_SECTION fast_sync_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+static struct list mutex_list = LIST_INIT( mutex_list );
+
+/* futex used by threads waiting on more than one object */
+static int multi_serial;
+static int multi_sleepers;
+
+#define FAST_SYNC_BLOCK_SIZE  (65536 / sizeof(struct fast_sync *))
+#define FAST_SYNC_BLOCKS      256
+
+static struct fast_sync **handle_table[FAST_SYNC_BLOCKS];
+
+static const LARGE_INTEGER zero_timeout;
+
+static int fast_sync_enabled(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEFASTSYNC" );
+        enabled = env && atoi( env ) && use_futexes();
+        if (enabled) TRACE( "using in-process synchronization objects\n" );
+    }
+    return enabled;
+}
+
+static inline DWORD current_tid(void)
+{
+    return HandleToULong( NtCurrentTeb()->ClientId.UniqueThread );
+}
+
+static inline unsigned int handle_to_index( HANDLE handle, unsigned int *block )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+    *block = idx / FAST_SYNC_BLOCK_SIZE;
+    return idx % FAST_SYNC_BLOCK_SIZE;
+}
+
+/* caller must hold fast_sync_section */
+static struct fast_sync *get_object( HANDLE handle )
+{
+    unsigned int block, idx = handle_to_index( handle, &block );
+
+    if (block >= FAST_SYNC_BLOCKS || !handle_table[block]) return NULL;
+    return handle_table[block][idx];
+}
+
+/* caller must hold fast_sync_section */
+static BOOL set_object( HANDLE handle, struct fast_sync *obj )
+{
+    unsigned int block, idx = handle_to_index( handle, &block );
+
+    if (block >= FAST_SYNC_BLOCKS) return FALSE;
+    if (!handle_table[block])
+    {
+        if (!obj) return TRUE;
+        if (!(handle_table[block] = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                                     FAST_SYNC_BLOCK_SIZE * sizeof(struct fast_sync *) )))
+            return FALSE;
+    }
+    handle_table[block][idx] = obj;
+    return TRUE;
+}
+
+/* caller must hold fast_sync_section */
+static void release_object( struct fast_sync *obj )
+{
+    if (--obj->refcount) return;
+    if (obj->type == FAST_SYNC_MUTEX) list_remove( &obj->entry );
+    RtlFreeHeap( GetProcessHeap(), 0, obj );
+}
+
+/* caller must hold fast_sync_section */
+static void wake_waiters( struct fast_sync *obj )
+{
+    if (obj->sleepers)
+    {
+        obj->serial++;
+        futex_wake( &obj->serial, INT_MAX );
+    }
+    if (multi_sleepers)
+    {
+        multi_serial++;
+        futex_wake( &multi_serial, INT_MAX );
+    }
+}
+
+/***********************************************************************
+ *           demote_object
+ *
+ * Copy the object state to the server object; subsequent operations
+ * will go through the server. Caller must hold fast_sync_section.
+ */
+static NTSTATUS demote_object( struct fast_sync *obj, HANDLE handle )
+{
+    ULONG i;
+
+    if (obj->demoted) return STATUS_SUCCESS;
+
+    TRACE( "demoting %p\n", handle );
+
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+        obj->demoted = TRUE;
+        if (obj->u.event.signaled) NtSetEvent( handle, NULL );
+        else NtResetEvent( handle, NULL );
+        break;
+
+    case FAST_SYNC_SEMAPHORE:
+        obj->demoted = TRUE;
+        if (obj->u.semaphore.count > obj->u.semaphore.initial)
+            NtReleaseSemaphore( handle, obj->u.semaphore.count - obj->u.semaphore.initial, NULL );
+        for (i = obj->u.semaphore.count; i < obj->u.semaphore.initial; i++)
+            NtWaitForSingleObject( handle, FALSE, &zero_timeout );
+        break;
+
+    case FAST_SYNC_MUTEX:
+        /* the server mutex is created unowned; only its owner can take it */
+        if (obj->u.mutex.owner && obj->u.mutex.owner != current_tid())
+        {
+            obj->demote_pending = TRUE;
+            return STATUS_PENDING;
+        }
+        obj->demoted = TRUE;
+        for (i = 0; i < obj->u.mutex.count; i++)
+            NtWaitForSingleObject( handle, FALSE, &zero_timeout );
+        break;
+    }
+
+    wake_waiters( obj );
+    return STATUS_SUCCESS;
+}
+
+/* get the absolute deadline of a wait, in performance counter ticks */
+static BOOL get_deadline( const LARGE_INTEGER *timeout, LONGLONG *deadline )
+{
+    LARGE_INTEGER now;
+
+    if (!timeout || timeout->QuadPart == TIMEOUT_INFINITE) return FALSE;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    if (timeout->QuadPart <= 0) *deadline = now.QuadPart - timeout->QuadPart;
+    else
+    {
+        LARGE_INTEGER system_time;
+
+        NtQuerySystemTime( &system_time );
+        *deadline = now.QuadPart + max( timeout->QuadPart - system_time.QuadPart, 0 );
+    }
+    return TRUE;
+}
+
+/* get the remaining time of a wait; returns FALSE if the deadline has passed */
+static BOOL get_remaining_time( LONGLONG deadline, struct timespec *ts )
+{
+    LARGE_INTEGER now;
+    LONGLONG diff;
+
+    NtQueryPerformanceCounter( &now, NULL );
+    if ((diff = deadline - now.QuadPart) <= 0) return FALSE;
+    ts->tv_sec  = diff / 10000000;
+    ts->tv_nsec = (diff % 10000000) * 100;
+    return TRUE;
+}
+
+static BOOL object_signaled( const struct fast_sync *obj, DWORD tid )
+{
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:     return obj->u.event.signaled;
+    case FAST_SYNC_SEMAPHORE: return obj->u.semaphore.count != 0;
+    case FAST_SYNC_MUTEX:     return !obj->u.mutex.owner || obj->u.mutex.owner == tid;
+    }
+    return FALSE;
+}
+
+/* acquire a signaled object; returns TRUE if it was an abandoned mutex */
+static BOOL object_acquire( struct fast_sync *obj, DWORD tid )
+{
+    BOOL abandoned = FALSE;
+
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+        if (!obj->u.event.manual) obj->u.event.signaled = FALSE;
+        break;
+    case FAST_SYNC_SEMAPHORE:
+        obj->u.semaphore.count--;
+        break;
+    case FAST_SYNC_MUTEX:
+        obj->u.mutex.owner = tid;
+        obj->u.mutex.count++;
+        abandoned = obj->u.mutex.abandoned;
+        obj->u.mutex.abandoned = FALSE;
+        break;
+    }
+    return abandoned;
+}
+
+/* try to satisfy a wait; returns STATUS_PENDING if it can't be satisfied yet */
+static NTSTATUS try_wait( struct fast_sync **objs, DWORD count, BOOLEAN wait_any, DWORD tid )
+{
+    BOOL abandoned = FALSE;
+    DWORD i;
+
+    if (wait_any)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (!object_signaled( objs[i], tid )) continue;
+            if (object_acquire( objs[i], tid )) return STATUS_ABANDONED_WAIT_0 + i;
+            return STATUS_WAIT_0 + i;
+        }
+        return STATUS_PENDING;
+    }
+
+    for (i = 0; i < count; i++)
+        if (!object_signaled( objs[i], tid )) return STATUS_PENDING;
+    for (i = 0; i < count; i++)
+        abandoned |= object_acquire( objs[i], tid );
+    return abandoned ? STATUS_ABANDONED_WAIT_0 : STATUS_WAIT_0;
+}
+
+/* sleep until one of the objects changes state; caller must hold fast_sync_section */
+static BOOL sleep_on_objects( struct fast_sync **objs, DWORD count, BOOL infinite, LONGLONG deadline,
+                              sigset_t *sigset )
+{
+    struct timespec ts;
+    int *futex, *sleepers, val;
+    DWORD i;
+
+    if (!infinite && !get_remaining_time( deadline, &ts )) return FALSE;
+
+    if (count == 1)
+    {
+        futex = &objs[0]->serial;
+        sleepers = &objs[0]->sleepers;
+    }
+    else
+    {
+        futex = &multi_serial;
+        sleepers = &multi_sleepers;
+    }
+
+    /* keep the objects alive while sleeping, their handles may get closed */
+    for (i = 0; i < count; i++) objs[i]->refcount++;
+    (*sleepers)++;
+    val = *futex;
+    server_leave_uninterrupted_section( &fast_sync_section, sigset );
+
+    futex_wait( futex, val, infinite ? NULL : &ts );
+
+    server_enter_uninterrupted_section( &fast_sync_section, sigset );
+    (*sleepers)--;
+    for (i = 0; i < count; i++) release_object( objs[i] );
+    return TRUE;
+}
+
+/***********************************************************************
+ *           demote_handles
+ *
+ * Demote all the in-process objects of a wait that has to go to the server.
+ * Caller must hold fast_sync_section.
+ */
+static NTSTATUS demote_handles( DWORD count, const HANDLE *handles, BOOL infinite, LONGLONG deadline,
+                                sigset_t *sigset )
+{
+    struct fast_sync *obj, *pending;
+    DWORD i;
+
+    for (;;)
+    {
+        pending = NULL;
+        for (i = 0; i < count; i++)
+        {
+            if (!(obj = get_object( handles[i] ))) continue;
+            if (demote_object( obj, handles[i] ) == STATUS_PENDING) pending = obj;
+        }
+        if (!pending) return STATUS_NOT_IMPLEMENTED;
+        /* wait for the owner of the mutex to release it */
+        if (!sleep_on_objects( &pending, 1, infinite, deadline, sigset )) return STATUS_TIMEOUT;
+    }
+}
+
+
+/***********************************************************************
+ *           fast_sync_is_eligible
+ *
+ * Check whether a new object can be kept in the process.
+ */
+BOOL fast_sync_is_eligible( const OBJECT_ATTRIBUTES *attr, ACCESS_MASK access, ACCESS_MASK needed )
+{
+    if (!fast_sync_enabled()) return FALSE;
+    if (attr && attr->ObjectName && attr->ObjectName->Length) return FALSE;
+    if (attr && (attr->Attributes & OBJ_INHERIT)) return FALSE;
+    if (access & (GENERIC_ALL | MAXIMUM_ALLOWED)) return TRUE;
+    return (access & needed) == needed;
+}
+
+static void add_object( HANDLE handle, struct fast_sync *obj )
+{
+    sigset_t sigset;
+    BOOL ret;
+
+    obj->refcount = 1;
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    if ((ret = set_object( handle, obj )) && obj->type == FAST_SYNC_MUTEX)
+        list_add_tail( &mutex_list, &obj->entry );
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+    if (!ret) RtlFreeHeap( GetProcessHeap(), 0, obj );
+}
+
+void fast_sync_add_event( HANDLE handle, EVENT_TYPE type, BOOLEAN initial )
+{
+    struct fast_sync *obj;
+
+    if (!(obj = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*obj) ))) return;
+    obj->type = FAST_SYNC_EVENT;
+    obj->u.event.manual = (type == NotificationEvent);
+    obj->u.event.signaled = initial;
+    add_object( handle, obj );
+}
+
+void fast_sync_add_semaphore( HANDLE handle, ULONG initial, ULONG max )
+{
+    struct fast_sync *obj;
+
+    if (!(obj = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*obj) ))) return;
+    obj->type = FAST_SYNC_SEMAPHORE;
+    obj->u.semaphore.count = obj->u.semaphore.initial = initial;
+    obj->u.semaphore.max = max;
+    add_object( handle, obj );
+}
+
+void fast_sync_add_mutex( HANDLE handle, BOOLEAN owned )
+{
+    struct fast_sync *obj;
+
+    if (!(obj = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*obj) ))) return;
+    obj->type = FAST_SYNC_MUTEX;
+    if (owned)
+    {
+        obj->u.mutex.owner = current_tid();
+        obj->u.mutex.count = 1;
+    }
+    add_object( handle, obj );
+}
+
+
+/***********************************************************************
+ *           fast_sync_close
+ */
+void fast_sync_close( HANDLE handle )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+
+    if (!fast_sync_enabled()) return;
+
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    if ((obj = get_object( handle )))
+    {
+        set_object( handle, NULL );
+        release_object( obj );
+    }
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+}
+
+
+/***********************************************************************
+ *           fast_sync_flush
+ *
+ * Make sure that the server object holds the state of an object, before
+ * its handle is passed to the server to be signaled or used by another process.
+ */
+void fast_sync_flush( HANDLE handle )
+{
+    sigset_t sigset;
+    LONGLONG deadline = 0;
+
+    if (!fast_sync_enabled() || !handle) return;
+
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    demote_handles( 1, &handle, TRUE, deadline, &sigset );
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+}
+
+
+/***********************************************************************
+ *           wine_server_flush_sync_object   (NTDLL.@)
+ *
+ * Exported version of fast_sync_flush(), for the dlls that pass event handles to the server.
+ */
+void CDECL wine_server_flush_sync_object( HANDLE handle )
+{
+    fast_sync_flush( handle );
+}
+
+
+/***********************************************************************
+ *           fast_sync_duplicate
+ *
+ * Called after a handle has been duplicated by the server.
+ */
+void fast_sync_duplicate( HANDLE source, HANDLE dest, BOOL closed )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+
+    if (!fast_sync_enabled()) return;
+
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    if ((obj = get_object( source )))
+    {
+        if (dest && set_object( dest, obj )) obj->refcount++;
+        if (closed)
+        {
+            set_object( source, NULL );
+            release_object( obj );
+        }
+    }
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+}
+
+
+/***********************************************************************
+ *           fast_sync_thread_exit
+ *
+ * Abandon the mutexes owned by the exiting thread.
+ */
+void fast_sync_thread_exit(void)
+{
+    struct fast_sync *obj;
+    DWORD tid = current_tid();
+    sigset_t sigset;
+
+    if (!fast_sync_enabled()) return;
+
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    LIST_FOR_EACH_ENTRY( obj, &mutex_list, struct fast_sync, entry )
+    {
+        if (obj->demoted || obj->u.mutex.owner != tid) continue;
+        obj->u.mutex.owner = 0;
+        obj->u.mutex.count = 0;
+        obj->u.mutex.abandoned = TRUE;
+        if (obj->demote_pending) obj->demoted = TRUE;
+        wake_waiters( obj );
+    }
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+}
+
+
+/* get an object that is still handled in the process; caller must hold fast_sync_section */
+static struct fast_sync *get_fast_object( HANDLE handle, enum fast_sync_type type )
+{
+    struct fast_sync *obj = get_object( handle );
+
+    if (!obj || obj->demoted) return NULL;
+    if (obj->type != type) return (struct fast_sync *)-1;
+    return obj;
+}
+
+#define FAST_SYNC_BEGIN( handle, type ) \
+    if (!fast_sync_enabled()) return STATUS_NOT_IMPLEMENTED; \
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset ); \
+    if (!(obj = get_fast_object( handle, type ))) ret = STATUS_NOT_IMPLEMENTED; \
+    else if (obj == (struct fast_sync *)-1) ret = STATUS_OBJECT_TYPE_MISMATCH; \
+    else
+
+#define FAST_SYNC_END() \
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset ); \
+    return ret
+
+NTSTATUS fast_sync_set_event( HANDLE handle )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_EVENT )
+    {
+        obj->u.event.signaled = TRUE;
+        wake_waiters( obj );
+        ret = STATUS_SUCCESS;
+    }
+    FAST_SYNC_END();
+}
+
+NTSTATUS fast_sync_reset_event( HANDLE handle )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_EVENT )
+    {
+        obj->u.event.signaled = FALSE;
+        ret = STATUS_SUCCESS;
+    }
+    FAST_SYNC_END();
+}
+
+NTSTATUS fast_sync_pulse_event( HANDLE handle )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    /* pulsing needs to release the current waiters atomically, leave that to the server */
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_EVENT )
+    {
+        demote_object( obj, handle );
+        ret = STATUS_NOT_IMPLEMENTED;
+    }
+    FAST_SYNC_END();
+}
+
+NTSTATUS fast_sync_query_event( HANDLE handle, EVENT_BASIC_INFORMATION *info )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_EVENT )
+    {
+        info->EventType  = obj->u.event.manual ? NotificationEvent : SynchronizationEvent;
+        info->EventState = obj->u.event.signaled;
+        ret = STATUS_SUCCESS;
+    }
+    FAST_SYNC_END();
+}
+
+NTSTATUS fast_sync_release_semaphore( HANDLE handle, ULONG count, ULONG *previous )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_SEMAPHORE )
+    {
+        ULONG prev = obj->u.semaphore.count;
+
+        if (count > obj->u.semaphore.max - prev) ret = STATUS_SEMAPHORE_LIMIT_EXCEEDED;
+        else
+        {
+            if (previous) *previous = prev;
+            obj->u.semaphore.count += count;
+            if (count) wake_waiters( obj );
+            ret = STATUS_SUCCESS;
+        }
+    }
+    FAST_SYNC_END();
+}
+
+NTSTATUS fast_sync_query_semaphore( HANDLE handle, SEMAPHORE_BASIC_INFORMATION *info )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_SEMAPHORE )
+    {
+        info->CurrentCount = obj->u.semaphore.count;
+        info->MaximumCount = obj->u.semaphore.max;
+        ret = STATUS_SUCCESS;
+    }
+    FAST_SYNC_END();
+}
+
+NTSTATUS fast_sync_release_mutex( HANDLE handle, LONG *prev_count )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_MUTEX )
+    {
+        if (obj->u.mutex.owner != current_tid()) ret = STATUS_MUTANT_NOT_OWNED;
+        else
+        {
+            if (prev_count) *prev_count = 1 - obj->u.mutex.count;
+            if (!--obj->u.mutex.count)
+            {
+                obj->u.mutex.owner = 0;
+                /* the server mutex is unowned, there's nothing left to copy */
+                if (obj->demote_pending) obj->demoted = TRUE;
+                wake_waiters( obj );
+            }
+            ret = STATUS_SUCCESS;
+        }
+    }
+    FAST_SYNC_END();
+}
+
+NTSTATUS fast_sync_query_mutex( HANDLE handle, MUTANT_BASIC_INFORMATION *info )
+{
+    struct fast_sync *obj;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    FAST_SYNC_BEGIN( handle, FAST_SYNC_MUTEX )
+    {
+        info->CurrentCount   = 1 - obj->u.mutex.count;
+        info->OwnedByCaller  = obj->u.mutex.owner == current_tid();
+        info->AbandonedState = obj->u.mutex.abandoned;
+        ret = STATUS_SUCCESS;
+    }
+    FAST_SYNC_END();
+}
+
+
+/***********************************************************************
+ *           fast_sync_wait
+ *
+ * Wait on in-process objects. Returns STATUS_NOT_IMPLEMENTED if the wait
+ * has to be done by the server, after demoting the objects involved.
+ */
+NTSTATUS fast_sync_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any, BOOLEAN alertable,
+                         const LARGE_INTEGER *timeout )
+{
+    struct fast_sync *objs[MAXIMUM_WAIT_OBJECTS];
+    DWORD i, fast, tid = current_tid();
+    LONGLONG deadline = 0;
+    BOOL infinite;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    if (!fast_sync_enabled()) return STATUS_NOT_IMPLEMENTED;
+    if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_NOT_IMPLEMENTED;
+
+    infinite = !get_deadline( timeout, &deadline );
+
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    for (;;)
+    {
+        for (i = fast = 0; i < count; i++)
+        {
+            objs[i] = get_object( handles[i] );
+            if (objs[i] && !objs[i]->demoted) fast++;
+        }
+
+        if (!fast)
+        {
+            ret = STATUS_NOT_IMPLEMENTED;
+            break;
+        }
+        if (fast < count || alertable)
+        {
+            /* user APCs and other objects are only known to the server */
+            ret = demote_handles( count, handles, infinite, deadline, &sigset );
+            break;
+        }
+
+        if ((ret = try_wait( objs, count, wait_any, tid )) != STATUS_PENDING) break;
+
+        if (!sleep_on_objects( objs, count, infinite, deadline, &sigset ))
+        {
+            ret = STATUS_TIMEOUT;
+            break;
+        }
+    }
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           fast_sync_signal_and_wait
+ */
+NTSTATUS fast_sync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
+                                    const LARGE_INTEGER *timeout )
+{
+    struct fast_sync *obj;
+    LONGLONG deadline = 0;
+    BOOL infinite;
+    sigset_t sigset;
+    NTSTATUS ret = STATUS_SUCCESS;
+
+    if (!fast_sync_enabled()) return STATUS_NOT_IMPLEMENTED;
+
+    infinite = !get_deadline( timeout, &deadline );
+
+    server_enter_uninterrupted_section( &fast_sync_section, &sigset );
+    if (!(obj = get_object( signal )) || obj->demoted)
+    {
+        /* the server does the signaling, it needs to know the state of the waited object too */
+        ret = demote_handles( 1, &wait, infinite, deadline, &sigset );
+        server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+        return ret;
+    }
+    server_leave_uninterrupted_section( &fast_sync_section, &sigset );
+
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:     ret = fast_sync_set_event( signal ); break;
+    case FAST_SYNC_SEMAPHORE: ret = fast_sync_release_semaphore( signal, 1, NULL ); break;
+    case FAST_SYNC_MUTEX:     ret = fast_sync_release_mutex( signal, NULL ); break;
+    }
+    if (ret == STATUS_NOT_IMPLEMENTED)  /* demoted in the meantime */
+        return STATUS_NOT_IMPLEMENTED;
+    if (ret) return ret;
+
+    return NtWaitForSingleObject( wait, alertable, timeout );
+}
@@ -57,6 +57,9 @@
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 #ifdef MAJOR_IN_MKDEV
 # include <sys/mkdev.h>
 #elif defined(MAJOR_IN_SYSMACROS)
@@ -227,6 +230,7 @@ static NTSTATUS FILE_CreateFile( PHANDLE handle, ACCESS_MASK access, POBJECT_ATT
         OBJECT_ATTRIBUTES unix_attr = *attr;
         data_size_t len;
         struct object_attributes *objattr;
+        sigset_t sigset;
 
         unix_attr.ObjectName = &empty_string;  /* we send the unix name instead */
         if ((io->u.Status = alloc_object_attributes( &unix_attr, &objattr, &len )))
@@ -235,6 +239,8 @@ static NTSTATUS FILE_CreateFile( PHANDLE handle, ACCESS_MASK access, POBJECT_ATT
             return io->u.Status;
         }
 
+        /* the server sends the unix fd along with the new handle, to save a get_handle_fd request */
+        server_enter_uninterrupted_section( &fd_cache_section, &sigset );
         SERVER_START_REQ( create_file )
         {
             req->access     = access;
@@ -246,8 +252,11 @@ static NTSTATUS FILE_CreateFile( PHANDLE handle, ACCESS_MASK access, POBJECT_ATT
             wine_server_add_data( req, unix_name.Buffer, unix_name.Length );
             io->u.Status = wine_server_call( req );
             *handle = wine_server_ptr_handle( reply->handle );
+            if (!io->u.Status && reply->fd_type != FD_TYPE_INVALID)
+                server_receive_handle_fd( *handle, reply->fd_type, reply->fd_access, reply->fd_options );
         }
         SERVER_END_REQ;
+        server_leave_uninterrupted_section( &fd_cache_section, &sigset );
         RtlFreeHeap( GetProcessHeap(), 0, objattr );
         RtlFreeAnsiString( &unix_name );
     }
@@ -417,6 +426,8 @@ static async_data_t server_async( HANDLE handle, struct async_fileio *user, HAND
                                   PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *io )
 {
     async_data_t async;
+
+    fast_sync_flush( event );
     async.handle      = wine_server_obj_handle( handle );
     async.user        = wine_server_client_ptr( user );
     async.iosb        = wine_server_client_ptr( io );
@@ -866,7 +877,18 @@ NTSTATUS WINAPI NtReadFile(HANDLE hFile, HANDLE hEvent,
 
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
         {
-            /* async I/O doesn't make sense on regular files */
+            if (async_read && !apc && length)
+            {
+                struct iovec iov;
+
+                iov.iov_base = buffer;
+                iov.iov_len  = length;
+                status = uring_submit_rw( hFile, unix_handle, FALSE, &iov, 1, offset->QuadPart,
+                                          hEvent, cvalue, io_status );
+                if (status != STATUS_NOT_SUPPORTED) goto err;
+            }
+
+            /* otherwise async I/O doesn't make sense on regular files */
             while ((result = virtual_locked_pread( unix_handle, buffer, length, offset->QuadPart )) == -1)
             {
                 if (errno != EINTR)
@@ -1022,6 +1044,32 @@ err:
 }
 
 
+/* queue a scatter/gather request on page-sized segments to the io_uring */
+static NTSTATUS submit_file_segments( HANDLE file, int fd, BOOL write, FILE_SEGMENT_ELEMENT *segments,
+                                      ULONG length, ULONGLONG offset, HANDLE event, ULONG_PTR cvalue,
+                                      IO_STATUS_BLOCK *io )
+{
+    struct iovec local_iov[64], *iov = local_iov;
+    unsigned int i, count = (length + page_size - 1) / page_size;
+    NTSTATUS status;
+
+    if (!count) return STATUS_NOT_SUPPORTED;
+    if (count > sizeof(local_iov) / sizeof(local_iov[0]) &&
+        !(iov = RtlAllocateHeap( GetProcessHeap(), 0, count * sizeof(*iov) )))
+        return STATUS_NOT_SUPPORTED;
+
+    for (i = 0; i < count; i++)
+    {
+        iov[i].iov_base = segments[i].Buffer;
+        iov[i].iov_len  = min( length - i * page_size, page_size );
+    }
+    status = uring_submit_rw( file, fd, write, iov, count, offset, event, cvalue, io );
+
+    if (iov != local_iov) RtlFreeHeap( GetProcessHeap(), 0, iov );
+    return status;
+}
+
+
 /******************************************************************************
  *  NtReadFileScatter   [NTDLL.@]
  *  ZwReadFileScatter   [NTDLL.@]
@@ -1055,6 +1103,14 @@ NTSTATUS WINAPI NtReadFileScatter( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         goto error;
     }
 
+    if (offset && offset->QuadPart >= 0 && !apc && length &&
+        submit_file_segments( file, unix_handle, FALSE, segments, length, offset->QuadPart,
+                              event, cvalue, io_status ) == STATUS_PENDING)
+    {
+        if (needs_close) close( unix_handle );
+        return STATUS_PENDING;
+    }
+
     while (length)
     {
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
@@ -1269,7 +1325,18 @@ NTSTATUS WINAPI NtWriteFile(HANDLE hFile, HANDLE hEvent,
                 goto done;
             }
 
-            /* async I/O doesn't make sense on regular files */
+            if (async_write && !apc && length)
+            {
+                struct iovec iov;
+
+                iov.iov_base = (void *)buffer;
+                iov.iov_len  = length;
+                status = uring_submit_rw( hFile, unix_handle, TRUE, &iov, 1, off,
+                                          hEvent, cvalue, io_status );
+                if (status != STATUS_NOT_SUPPORTED) goto err;
+            }
+
+            /* otherwise async I/O doesn't make sense on regular files */
             while ((result = pwrite( unix_handle, buffer, length, off )) == -1)
             {
                 if (errno != EINTR)
@@ -1450,6 +1517,14 @@ NTSTATUS WINAPI NtWriteFileGather( HANDLE file, HANDLE event, PIO_APC_ROUTINE ap
         goto error;
     }
 
+    if (offset && offset->QuadPart >= 0 && !apc && length)
+    {
+        status = submit_file_segments( file, unix_handle, TRUE, segments, length, offset->QuadPart,
+                                       event, cvalue, io_status );
+        if (status != STATUS_NOT_SUPPORTED) goto error;
+        status = STATUS_SUCCESS;
+    }
+
     while (length)
     {
         if (offset && offset->QuadPart != FILE_USE_FILE_POINTER_POSITION)
@@ -45,6 +45,7 @@
 #include "wine/server.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(heap);
+WINE_DECLARE_DEBUG_CHANNEL(heapstats);
 
 /* Note: the heap data structures are loosely based on what Pietrek describes in his
  * book 'Windows 95 System Programming Secrets', with some adaptations for
@@ -69,8 +70,11 @@ typedef struct
 {
     struct list           entry;      /* entry in heap large blocks list */
     SIZE_T                data_size;  /* size of user data */
-    SIZE_T                block_size; /* total size of virtual memory block */
-    DWORD                 pad[2];     /* padding to ensure 16-byte alignment of data */
+    SIZE_T                block_size; /* committed size of virtual memory block */
+    SIZE_T                reserve_size; /* reserved size of virtual memory block */
+#ifndef _WIN64
+    DWORD                 pad;        /* padding to ensure 16-byte alignment of data */
+#endif
     DWORD                 size;       /* fields for compatibility with normal arenas */
     DWORD                 magic;      /* these must remain at the end of the structure */
 } ARENA_LARGE;
@@ -85,6 +89,8 @@ typedef struct
 #define ARENA_PENDING_MAGIC    0xbedead
 #define ARENA_FREE_MAGIC       0x45455246
 #define ARENA_LARGE_MAGIC      0x6752614c
+#define ARENA_LFH_MAGIC        0x48464c
+#define ARENA_LFH_FREE_MAGIC   0x46464c
 
 #define ARENA_INUSE_FILLER     0x55
 #define ARENA_TAIL_FILLER      0xab
@@ -110,6 +116,12 @@ C_ASSERT( sizeof(ARENA_LARGE) % LARGE_ALIGNMENT == 0 );
 #define HEAP_MIN_SHRINK_SIZE  (HEAP_MIN_DATA_SIZE+sizeof(ARENA_FREE))
 /* minimum size to start allocating large blocks */
 #define HEAP_MIN_LARGE_BLOCK_SIZE  0x7f000
+/* address space reserved past the end of large blocks so that they can grow in place */
+#ifdef _WIN64
+#define HEAP_LARGE_BLOCK_HEADROOM(size)  (size)
+#else
+#define HEAP_LARGE_BLOCK_HEADROOM(size)  ((size) / 4)  /* address space is scarce */
+#endif
 /* extra size to add at the end of block for tail checking */
 #define HEAP_TAIL_EXTRA_SIZE(flags) \
     ((flags & HEAP_TAIL_CHECKING_ENABLED) || RUNNING_ON_VALGRIND ? ALIGNMENT : 0)
@@ -134,6 +146,48 @@ typedef union
 
 struct tagHEAP;
 
+/* Low-fragmentation heap front end: small blocks are carved out of 64k slabs,
+ * one size class per slab, and recycled through lock-free free lists. */
+#define LFH_SLAB_SIZE          0x10000
+#define LFH_SLAB_MAGIC         ((DWORD)('L' | ('F'<<8) | ('H'<<16) | ('S'<<24)))
+#define LFH_MAX_BLOCK_SIZE     0x1000   /* largest request served by the LFH */
+#define LFH_NB_CLASSES         32
+#define LFH_NB_SHARDS          8        /* free lists per size class, chosen by thread id */
+#define LFH_MAX_SLABS          4096     /* size of the slab hash table */
+#define LFH_ACTIVATION_COUNT   16       /* back-end allocations before a size class switches to the LFH */
+
+static const SIZE_T lfh_block_sizes[LFH_NB_CLASSES] =
+{
+    0x10, 0x20, 0x30, 0x40, 0x50, 0x60, 0x70, 0x80,
+    0x90, 0xa0, 0xb0, 0xc0, 0xd0, 0xe0, 0xf0, 0x100,
+    0x140, 0x180, 0x1c0, 0x200, 0x280, 0x300, 0x380, 0x400,
+    0x500, 0x600, 0x700, 0x800, 0xa00, 0xc00, 0xe00, 0x1000
+};
+
+typedef struct
+{
+    DWORD               magic;      /* Magic number */
+    DWORD               class;      /* Size class of the blocks */
+    struct tagHEAP     *heap;       /* Heap owning the slab */
+    SIZE_T              stride;     /* Distance between two blocks, arena included */
+    SIZE_T              count;      /* Number of blocks in the slab */
+} LFH_SLAB;
+
+#define LFH_SLAB_HEADER_SIZE   ((sizeof(LFH_SLAB) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+struct lfh_bin
+{
+    SLIST_HEADER        free[LFH_NB_SHARDS]; /* Free blocks */
+    BOOL                enabled;    /* Allocations of this class go through the LFH */
+};
+
+struct lfh_heap
+{
+    struct lfh_bin      bins[LFH_NB_CLASSES];
+    LFH_SLAB           *slabs[LFH_MAX_SLABS]; /* Hash table of slab addresses */
+    unsigned int        slab_count; /* Number of slabs in the table */
+};
+
 typedef struct tagSUBHEAP
 {
     void               *base;       /* Base address of the sub-heap memory block */
@@ -164,6 +218,12 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    struct lfh_heap *lfh;           /* Low-fragmentation front end, if enabled */
+    DWORD            lfh_counts[LFH_NB_CLASSES]; /* Back-end allocations per LFH size class */
+    BOOL             stats;         /* Usage counters are enabled */
+    LONG             stats_realloc; /* Number of reallocations */
+    LONG             stats_alloc[WINE_HEAP_STATS_CLASSES]; /* Allocations per size class */
+    LONG             stats_free[WINE_HEAP_STATS_CLASSES];  /* Frees per size class */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
@@ -318,6 +378,31 @@ static inline unsigned int get_freelist_index( SIZE_T size )
 }
 
 /* get the memory protection type to use for a given heap */
+static inline unsigned int stats_get_class( SIZE_T size )
+{
+    unsigned int class;
+
+    for (class = 0; class < WINE_HEAP_STATS_CLASSES - 1; class++)
+        if (size <= ((SIZE_T)16 << class)) break;
+    return class;
+}
+
+/* update the usage counters of the heap; blocks can be allocated without holding the heap lock */
+static inline void stats_notify_alloc( HEAP *heap, SIZE_T size )
+{
+    if (heap->stats) interlocked_xchg_add( (int *)&heap->stats_alloc[stats_get_class( size )], 1 );
+}
+
+static inline void stats_notify_free( HEAP *heap, SIZE_T size )
+{
+    if (heap->stats) interlocked_xchg_add( (int *)&heap->stats_free[stats_get_class( size )], 1 );
+}
+
+static inline void stats_notify_realloc( HEAP *heap )
+{
+    if (heap->stats) interlocked_xchg_add( (int *)&heap->stats_realloc, 1 );
+}
+
 static inline ULONG get_protection_type( DWORD flags )
 {
     return (flags & HEAP_CREATE_ENABLE_EXECUTE) ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
@@ -723,18 +808,36 @@ static void *allocate_large_block( HEAP *heap, DWORD flags, SIZE_T size )
 {
     ARENA_LARGE *arena;
     SIZE_T block_size = sizeof(*arena) + ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE(flags);
+    SIZE_T reserve_size = block_size + HEAP_LARGE_BLOCK_HEADROOM(block_size);
     LPVOID address = NULL;
 
     if (block_size < size) return NULL;  /* overflow */
+    if (reserve_size < block_size) reserve_size = block_size;
     if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 5,
+                                 &reserve_size, MEM_RESERVE, get_protection_type( flags ) ))
+    {
+        /* try again without the headroom */
+        address = NULL;
+        reserve_size = block_size;
+        if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 5,
+                                     &reserve_size, MEM_RESERVE, get_protection_type( flags ) ))
+        {
+            WARN("Could not allocate block for %08lx bytes\n", size );
+            return NULL;
+        }
+    }
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &address, 0,
                                  &block_size, MEM_COMMIT, get_protection_type( flags ) ))
     {
-        WARN("Could not allocate block for %08lx bytes\n", size );
+        SIZE_T release_size = 0;
+        WARN("Could not commit block for %08lx bytes\n", size );
+        NtFreeVirtualMemory( NtCurrentProcess(), &address, &release_size, MEM_RELEASE );
         return NULL;
     }
     arena = address;
     arena->data_size = size;
     arena->block_size = block_size;
+    arena->reserve_size = reserve_size;
     arena->size = ARENA_LARGE_SIZE;
     arena->magic = ARENA_LARGE_MAGIC;
     mark_block_tail( (char *)(arena + 1) + size, block_size - sizeof(*arena) - size, flags );
@@ -764,8 +867,20 @@ static void free_large_block( HEAP *heap, DWORD flags, void *ptr )
 static void *realloc_large_block( HEAP *heap, DWORD flags, void *ptr, SIZE_T size )
 {
     ARENA_LARGE *arena = (ARENA_LARGE *)ptr - 1;
+    SIZE_T block_size = sizeof(*arena) + ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE(flags);
     void *new_ptr;
 
+    if (arena->block_size - sizeof(*arena) < size && block_size >= size && block_size <= arena->reserve_size)
+    {
+        /* grow the block in place into its reserved headroom */
+        void *address = (char *)arena + arena->block_size;
+        SIZE_T commit_size = block_size - arena->block_size;
+
+        if (!NtAllocateVirtualMemory( NtCurrentProcess(), &address, 0, &commit_size,
+                                      MEM_COMMIT, get_protection_type( flags ) ))
+            arena->block_size += commit_size;
+    }
+
     if (arena->block_size - sizeof(*arena) >= size)
     {
         SIZE_T unused = arena->block_size - sizeof(*arena) - size;
@@ -1447,6 +1562,305 @@ static BOOL validate_block_pointer( HEAP *heap, SUBHEAP **ret_subheap, const ARE
 }
 
 
+/***********************************************************************
+ *           lfh_heap_supported
+ *
+ * Check whether the low-fragmentation front end can be used for a heap.
+ * Heaps without serialization or with debugging enabled always use the
+ * back end, which performs all the checks.
+ */
+static inline BOOL lfh_heap_supported( const HEAP *heap )
+{
+    if (RUNNING_ON_VALGRIND) return FALSE;
+    if (!(heap->flags & HEAP_GROWABLE)) return FALSE;
+    return !(heap->flags & (HEAP_NO_SERIALIZE | HEAP_PAGE_ALLOCS | HEAP_VALIDATE_ALL | HEAP_VALIDATE_PARAMS |
+                            HEAP_TAIL_CHECKING_ENABLED | HEAP_FREE_CHECKING_ENABLED));
+}
+
+static inline unsigned int lfh_get_class( SIZE_T size )
+{
+    unsigned int class;
+
+    if (size <= 0x100) return size ? (size - 1) / 0x10 : 0;
+    for (class = 16; lfh_block_sizes[class] < size; class++);
+    return class;
+}
+
+static inline unsigned int lfh_get_shard(void)
+{
+    return ((ULONG_PTR)NtCurrentTeb()->ClientId.UniqueThread >> 2) % LFH_NB_SHARDS;
+}
+
+static inline unsigned int lfh_slab_hash( const void *base )
+{
+    return (unsigned int)((ULONG_PTR)base / LFH_SLAB_SIZE * 2654435761u) % LFH_MAX_SLABS;
+}
+
+
+/***********************************************************************
+ *           lfh_find_slab
+ *
+ * Find the LFH slab containing a pointer. This doesn't touch the pointed
+ * memory, so it is safe to call for any pointer.
+ */
+static LFH_SLAB *lfh_find_slab( const HEAP *heap, const void *ptr )
+{
+    const struct lfh_heap *lfh = heap->lfh;
+    LFH_SLAB *base = (LFH_SLAB *)((ULONG_PTR)ptr & ~(ULONG_PTR)(LFH_SLAB_SIZE - 1));
+    unsigned int i;
+
+    if (!lfh) return NULL;
+    for (i = lfh_slab_hash( base ); lfh->slabs[i]; i = (i + 1) % LFH_MAX_SLABS)
+        if (lfh->slabs[i] == base) return base;
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           lfh_get_arena
+ *
+ * Get the arena of a block inside a slab; fails if ptr doesn't point to the start of a block.
+ */
+static ARENA_INUSE *lfh_get_arena( const LFH_SLAB *slab, const void *ptr )
+{
+    SIZE_T offset = (const char *)ptr - (const char *)slab;
+
+    if (offset < LFH_SLAB_HEADER_SIZE) return NULL;
+    offset -= LFH_SLAB_HEADER_SIZE;
+    if (offset % slab->stride != slab->stride - lfh_block_sizes[slab->class]) return NULL;
+    if (offset / slab->stride >= slab->count) return NULL;
+    return (ARENA_INUSE *)ptr - 1;
+}
+
+
+/***********************************************************************
+ *           lfh_enable
+ *
+ * Enable the LFH for a size class, or for all of them if class is LFH_NB_CLASSES.
+ * The heap lock must be held.
+ */
+static BOOL lfh_enable( HEAP *heap, unsigned int class )
+{
+    struct lfh_heap *lfh = heap->lfh;
+    unsigned int i, j;
+
+    if (!lfh)
+    {
+        void *ptr = NULL;
+        SIZE_T size = sizeof(*lfh);
+
+        if (NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, 0, &size, MEM_COMMIT, PAGE_READWRITE ))
+        {
+            WARN( "Could not allocate LFH data for heap %p\n", heap );
+            return FALSE;
+        }
+        lfh = ptr;
+        for (i = 0; i < LFH_NB_CLASSES; i++)
+            for (j = 0; j < LFH_NB_SHARDS; j++) RtlInitializeSListHead( &lfh->bins[i].free[j] );
+        interlocked_xchg_ptr( (void **)&heap->lfh, lfh );
+        TRACE( "enabled LFH for heap %p\n", heap );
+    }
+
+    if (class < LFH_NB_CLASSES) lfh->bins[class].enabled = TRUE;
+    else for (i = 0; i < LFH_NB_CLASSES; i++) lfh->bins[i].enabled = TRUE;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           lfh_notify_backend_alloc
+ *
+ * Count the small allocations served by the back end, and switch their
+ * size class to the LFH once they become frequent. The heap lock must be held.
+ */
+static inline void lfh_notify_backend_alloc( HEAP *heap, SIZE_T size )
+{
+    unsigned int class;
+
+    if (size > LFH_MAX_BLOCK_SIZE || !lfh_heap_supported( heap )) return;
+    class = lfh_get_class( size );
+    if (heap->lfh_counts[class] >= LFH_ACTIVATION_COUNT) return;
+    if (++heap->lfh_counts[class] == LFH_ACTIVATION_COUNT) lfh_enable( heap, class );
+}
+
+
+/***********************************************************************
+ *           lfh_grow_bin
+ *
+ * Allocate a new slab for a size class and return its first block.
+ */
+static SLIST_ENTRY *lfh_grow_bin( HEAP *heap, unsigned int class, unsigned int shard )
+{
+    struct lfh_heap *lfh = heap->lfh;
+    SIZE_T size = LFH_SLAB_SIZE, i;
+    SLIST_ENTRY *entry, *first, *last;
+    LFH_SLAB *slab;
+    char *block;
+    void *ptr = NULL;
+    unsigned int hash;
+
+    RtlEnterCriticalSection( &heap->critSection );
+
+    /* another thread may have grown the bin in the meantime */
+    if ((entry = RtlInterlockedPopEntrySList( &lfh->bins[class].free[shard] ))) goto done;
+    if (lfh->slab_count >= LFH_MAX_SLABS / 4 * 3) goto done;
+
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &ptr, 0, &size,
+                                 MEM_RESERVE | MEM_COMMIT, get_protection_type( heap->flags ) ))
+    {
+        WARN( "Could not allocate LFH slab for heap %p\n", heap );
+        goto done;
+    }
+
+    slab = ptr;
+    slab->magic  = LFH_SLAB_MAGIC;
+    slab->class  = class;
+    slab->heap   = heap;
+    slab->stride = lfh_block_sizes[class] + ALIGNMENT;
+    slab->count  = (LFH_SLAB_SIZE - LFH_SLAB_HEADER_SIZE) / slab->stride;
+
+    /* the arena of each block is set up when it's allocated;
+     * the first block is returned and the others are added to the free list */
+    block = (char *)slab + LFH_SLAB_HEADER_SIZE + ALIGNMENT;
+    entry = (SLIST_ENTRY *)block;
+    first = last = (SLIST_ENTRY *)(block + slab->stride);
+    for (i = 2; i < slab->count; i++)
+    {
+        SLIST_ENTRY *next = (SLIST_ENTRY *)(block + i * slab->stride);
+        last->Next = next;
+        last = next;
+    }
+    last->Next = NULL;
+
+    for (hash = lfh_slab_hash( slab ); lfh->slabs[hash]; hash = (hash + 1) % LFH_MAX_SLABS);
+    interlocked_xchg_ptr( (void **)&lfh->slabs[hash], slab );
+    lfh->slab_count++;
+
+    RtlInterlockedPushListSListEx( &lfh->bins[class].free[shard], first, last, slab->count - 1 );
+
+done:
+    RtlLeaveCriticalSection( &heap->critSection );
+    return entry;
+}
+
+
+/***********************************************************************
+ *           lfh_allocate
+ *
+ * Allocate a block through the LFH. Returns NULL if the request has to go to the back end.
+ */
+static void *lfh_allocate( HEAP *heap, DWORD flags, SIZE_T size )
+{
+    struct lfh_heap *lfh = heap->lfh;
+    struct lfh_bin *bin;
+    SLIST_ENTRY *entry = NULL;
+    ARENA_INUSE *arena;
+    unsigned int class, shard, i;
+
+    if (!lfh || size > LFH_MAX_BLOCK_SIZE || !lfh_heap_supported( heap )) return NULL;
+    class = lfh_get_class( size );
+    bin = &lfh->bins[class];
+    if (!bin->enabled) return NULL;
+
+    shard = lfh_get_shard();
+    for (i = 0; i < LFH_NB_SHARDS && !entry; i++)
+        entry = RtlInterlockedPopEntrySList( &bin->free[(shard + i) % LFH_NB_SHARDS] );
+    if (!entry && !(entry = lfh_grow_bin( heap, class, shard ))) return NULL;
+
+    arena = (ARENA_INUSE *)entry - 1;
+    arena->size = size;
+    arena->magic = ARENA_LFH_MAGIC;
+    arena->unused_bytes = 0;
+
+    notify_alloc( arena + 1, size, flags & HEAP_ZERO_MEMORY );
+    initialize_block( arena + 1, size, 0, flags );
+    return arena + 1;
+}
+
+
+/***********************************************************************
+ *           lfh_free
+ *
+ * Return a block to the free list of its size class. No lock is needed.
+ */
+static BOOL lfh_free( HEAP *heap, LFH_SLAB *slab, void *ptr )
+{
+    ARENA_INUSE *arena = lfh_get_arena( slab, ptr );
+
+    if (!arena || arena->magic != ARENA_LFH_MAGIC)
+    {
+        WARN( "Heap %p: invalid LFH block %p\n", heap, ptr );
+        return FALSE;
+    }
+    notify_free( ptr );
+    stats_notify_free( heap, arena->size );
+    arena->magic = ARENA_LFH_FREE_MAGIC;
+    RtlInterlockedPushEntrySList( &heap->lfh->bins[slab->class].free[lfh_get_shard()], ptr );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           lfh_realloc
+ */
+static void *lfh_realloc( HEAP *heap, LFH_SLAB *slab, DWORD flags, void *ptr, SIZE_T size )
+{
+    ARENA_INUSE *arena = lfh_get_arena( slab, ptr );
+    void *ret;
+
+    if (!arena || arena->magic != ARENA_LFH_MAGIC)
+    {
+        WARN( "Heap %p: invalid LFH block %p\n", heap, ptr );
+        RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+        return NULL;
+    }
+
+    if (size <= lfh_block_sizes[slab->class])
+    {
+        notify_realloc( ptr, arena->size, size );
+        if (size > arena->size)
+            initialize_block( (char *)ptr + arena->size, size - arena->size, 0, flags );
+        arena->size = size;
+        return ptr;
+    }
+
+    if (!(flags & HEAP_REALLOC_IN_PLACE_ONLY) &&
+        (ret = RtlAllocateHeap( heap, flags & ~HEAP_GENERATE_EXCEPTIONS, size )))
+    {
+        memcpy( ret, ptr, arena->size );
+        lfh_free( heap, slab, ptr );
+        return ret;
+    }
+
+    if (flags & HEAP_GENERATE_EXCEPTIONS) RtlRaiseStatus( STATUS_NO_MEMORY );
+    RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_NO_MEMORY );
+    return NULL;
+}
+
+
+/***********************************************************************
+ *           lfh_destroy
+ */
+static void lfh_destroy( HEAP *heap )
+{
+    SIZE_T size;
+    void *addr;
+    unsigned int i;
+
+    if (!heap->lfh) return;
+    for (i = 0; i < LFH_MAX_SLABS; i++)
+    {
+        if (!(addr = heap->lfh->slabs[i])) continue;
+        size = 0;
+        NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    }
+    size = 0;
+    addr = heap->lfh;
+    NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
+    heap->lfh = NULL;
+}
+
+
 /***********************************************************************
  *           heap_set_debug_flags
  */
@@ -1473,6 +1887,8 @@ void heap_set_debug_flags( HANDLE handle )
 
     if (RUNNING_ON_VALGRIND) flags = 0; /* no sense in validating since Valgrind catches accesses */
 
+    if (TRACE_ON(heapstats)) heap->stats = TRUE;
+
     heap->flags |= flags;
     heap->force_flags |= flags & ~(HEAP_VALIDATE | HEAP_DISABLE_COALESCE_ON_FREE);
 
@@ -1622,6 +2038,7 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
         addr = arena;
         NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
     }
+    lfh_destroy( heapPtr );
     LIST_FOR_EACH_ENTRY_SAFE( subheap, next, &heapPtr->subheap_list, SUBHEAP, entry )
     {
         if (subheap == &heapPtr->subheap) continue;  /* do this one last */
@@ -1669,12 +2086,21 @@ PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
     SUBHEAP *subheap;
     HEAP *heapPtr = HEAP_GetPtr( heap );
     SIZE_T rounded_size;
+    void *ret;
 
     /* Validate the parameters */
 
     if (!heapPtr) return NULL;
     flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY;
     flags |= heapPtr->flags;
+
+    if ((ret = lfh_allocate( heapPtr, flags, size )))
+    {
+        stats_notify_alloc( heapPtr, size );
+        TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
+        return ret;
+    }
+
     rounded_size = ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE( flags );
     if (rounded_size < size)  /* overflow */
     {
@@ -1683,11 +2109,16 @@ PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
-    if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
+    if (!(flags & HEAP_NO_SERIALIZE))
+    {
+        RtlEnterCriticalSection( &heapPtr->critSection );
+        lfh_notify_backend_alloc( heapPtr, size );
+    }
 
     if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
     {
-        void *ret = allocate_large_block( heap, flags, size );
+        ret = allocate_large_block( heap, flags, size );
+        if (ret) stats_notify_alloc( heapPtr, size );
         if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
         if (!ret && (flags & HEAP_GENERATE_EXCEPTIONS)) RtlRaiseStatus( STATUS_NO_MEMORY );
         TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, ret );
@@ -1725,6 +2156,7 @@ PVOID WINAPI RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_T size )
 
     notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
     initialize_block( pInUse + 1, size, pInUse->unused_bytes, flags );
+    stats_notify_alloc( heapPtr, size );
 
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
 
@@ -1751,6 +2183,7 @@ BOOLEAN WINAPI RtlFreeHeap( HANDLE heap, ULONG flags, PVOID ptr )
 {
     ARENA_INUSE *pInUse;
     SUBHEAP *subheap;
+    LFH_SLAB *slab;
     HEAP *heapPtr;
 
     /* Validate the parameters */
@@ -1766,6 +2199,19 @@ BOOLEAN WINAPI RtlFreeHeap( HANDLE heap, ULONG flags, PVOID ptr )
 
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+
+    if ((slab = lfh_find_slab( heapPtr, ptr )))
+    {
+        if (!lfh_free( heapPtr, slab, ptr ))
+        {
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+            TRACE("(%p,%08x,%p): returning FALSE\n", heap, flags, ptr );
+            return FALSE;
+        }
+        TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
+        return TRUE;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     /* Inform valgrind we are trying to free memory, so it can throw up an error message */
@@ -1776,9 +2222,15 @@ BOOLEAN WINAPI RtlFreeHeap( HANDLE heap, ULONG flags, PVOID ptr )
     if (!validate_block_pointer( heapPtr, &subheap, pInUse )) goto error;
 
     if (!subheap)
+    {
+        stats_notify_free( heapPtr, ((ARENA_LARGE *)ptr - 1)->data_size );
         free_large_block( heapPtr, flags, ptr );
+    }
     else
+    {
+        stats_notify_free( heapPtr, (pInUse->size & ARENA_SIZE_MASK) - pInUse->unused_bytes );
         HEAP_MakeInUseBlockFree( subheap, pInUse );
+    }
 
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
     TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
@@ -1812,6 +2264,7 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     ARENA_INUSE *pArena;
     HEAP *heapPtr;
     SUBHEAP *subheap;
+    LFH_SLAB *slab;
     SIZE_T oldBlockSize, oldActualSize, rounded_size;
     void *ret;
 
@@ -1827,6 +2280,14 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
     flags &= HEAP_GENERATE_EXCEPTIONS | HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY |
              HEAP_REALLOC_IN_PLACE_ONLY;
     flags |= heapPtr->flags;
+
+    if ((slab = lfh_find_slab( heapPtr, ptr )))
+    {
+        if ((ret = lfh_realloc( heapPtr, slab, flags, ptr, size ))) stats_notify_realloc( heapPtr );
+        TRACE("(%p,%08x,%p,%08lx): returning %p\n", heap, flags, ptr, size, ret );
+        return ret;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     rounded_size = ROUND_SIZE(size) + HEAP_TAIL_EXTRA_SIZE(flags);
@@ -1921,6 +2382,7 @@ PVOID WINAPI RtlReAllocateHeap( HANDLE heap, ULONG flags, PVOID ptr, SIZE_T size
 
     ret = pArena + 1;
 done:
+    stats_notify_realloc( heapPtr );
     if (!(flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heapPtr->critSection );
     TRACE("(%p,%08x,%p,%08lx): returning %p\n", heap, flags, ptr, size, ret );
     return ret;
@@ -2027,6 +2489,7 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
     SIZE_T ret;
     const ARENA_INUSE *pArena;
     SUBHEAP *subheap;
+    LFH_SLAB *slab;
     HEAP *heapPtr = HEAP_GetPtr( heap );
 
     if (!heapPtr)
@@ -2036,6 +2499,20 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
     }
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+
+    if ((slab = lfh_find_slab( heapPtr, ptr )))
+    {
+        pArena = lfh_get_arena( slab, ptr );
+        if (pArena && pArena->magic == ARENA_LFH_MAGIC) ret = pArena->size;
+        else
+        {
+            RtlSetLastWin32ErrorAndNtStatusFromNtStatus( STATUS_INVALID_PARAMETER );
+            ret = ~0UL;
+        }
+        TRACE("(%p,%08x,%p): returning %08lx\n", heap, flags, ptr, ret );
+        return ret;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     pArena = (const ARENA_INUSE *)ptr - 1;
@@ -2077,7 +2554,12 @@ SIZE_T WINAPI RtlSizeHeap( HANDLE heap, ULONG flags, const void *ptr )
 BOOLEAN WINAPI RtlValidateHeap( HANDLE heap, ULONG flags, LPCVOID ptr )
 {
     HEAP *heapPtr = HEAP_GetPtr( heap );
+    LFH_SLAB *slab;
+    const ARENA_INUSE *arena;
+
     if (!heapPtr) return FALSE;
+    if (ptr && (slab = lfh_find_slab( heapPtr, ptr )))
+        return (arena = lfh_get_arena( slab, ptr )) && arena->magic == ARENA_LFH_MAGIC;
     return HEAP_IsRealArena( heapPtr, flags, ptr, QUIET );
 }
 
@@ -2240,13 +2722,147 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
     return total;
 }
 
+/***********************************************************************
+ *           heap_get_statistics
+ *
+ * Fill the usage statistics of a heap.
+ */
+static void heap_get_statistics( HEAP *heap, WINE_HEAP_STATISTICS *stats )
+{
+    SUBHEAP *subheap;
+    ARENA_LARGE *large;
+    unsigned int i;
+
+    memset( stats, 0, sizeof(*stats) );
+
+    if (!(heap->flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heap->critSection );
+
+    LIST_FOR_EACH_ENTRY( subheap, &heap->subheap_list, SUBHEAP, entry )
+    {
+        const char *ptr = (const char *)subheap->base + subheap->headerSize;
+
+        stats->ReservedSize += subheap->size;
+        stats->CommittedSize += subheap->commitSize;
+        while (ptr < (const char *)subheap->base + subheap->size)
+        {
+            if (*(const DWORD *)ptr & ARENA_FLAG_FREE)
+            {
+                const ARENA_FREE *arena = (const ARENA_FREE *)ptr;
+                ptr += sizeof(*arena) + (arena->size & ARENA_SIZE_MASK);
+            }
+            else
+            {
+                const ARENA_INUSE *arena = (const ARENA_INUSE *)ptr;
+                if (arena->magic == ARENA_INUSE_MAGIC)
+                {
+                    stats->UsedSize += (arena->size & ARENA_SIZE_MASK) - arena->unused_bytes;
+                    stats->BlockCount++;
+                }
+                ptr += sizeof(*arena) + (arena->size & ARENA_SIZE_MASK);
+            }
+        }
+    }
+
+    LIST_FOR_EACH_ENTRY( large, &heap->large_list, ARENA_LARGE, entry )
+    {
+        stats->ReservedSize += large->reserve_size;
+        stats->CommittedSize += large->block_size;
+        stats->UsedSize += large->data_size;
+        stats->BlockCount++;
+        stats->LargeBlockCount++;
+        stats->LargeBlockSize += large->data_size;
+    }
+
+    if (heap->lfh)
+    {
+        for (i = 0; i < LFH_MAX_SLABS; i++)
+        {
+            const LFH_SLAB *slab = heap->lfh->slabs[i];
+            const char *block;
+            SIZE_T j;
+
+            if (!slab) continue;
+            stats->ReservedSize += LFH_SLAB_SIZE;
+            stats->CommittedSize += LFH_SLAB_SIZE;
+            stats->LfhSlabCount++;
+            /* blocks are allocated and freed without the lock, this is only a snapshot */
+            block = (const char *)slab + LFH_SLAB_HEADER_SIZE + ALIGNMENT;
+            for (j = 0; j < slab->count; j++, block += slab->stride)
+            {
+                const ARENA_INUSE *arena = (const ARENA_INUSE *)block - 1;
+                if (arena->magic != ARENA_LFH_MAGIC) continue;
+                stats->UsedSize += arena->size;
+                stats->BlockCount++;
+            }
+        }
+    }
+
+    if (heap->critSection.DebugInfo) stats->LockContentionCount = heap->critSection.DebugInfo->ContentionCount;
+    stats->ReallocCount = heap->stats_realloc;
+    for (i = 0; i < WINE_HEAP_STATS_CLASSES; i++)
+    {
+        stats->AllocCount[i] = heap->stats_alloc[i];
+        stats->FreeCount[i] = heap->stats_free[i];
+    }
+
+    if (!(heap->flags & HEAP_NO_SERIALIZE)) RtlLeaveCriticalSection( &heap->critSection );
+}
+
+
+/***********************************************************************
+ *           heap_dump_statistics
+ */
+static void heap_dump_statistics( HEAP *heap )
+{
+    WINE_HEAP_STATISTICS stats;
+    unsigned int i;
+
+    heap_get_statistics( heap, &stats );
+    TRACE_(heapstats)( "heap %p: reserved %lu committed %lu used %lu in %lu blocks, "
+                       "%lu large blocks (%lu bytes), %lu LFH slabs, %u lock contentions, %u reallocs\n",
+                       heap, stats.ReservedSize, stats.CommittedSize, stats.UsedSize, stats.BlockCount,
+                       stats.LargeBlockCount, stats.LargeBlockSize, stats.LfhSlabCount,
+                       stats.LockContentionCount, stats.ReallocCount );
+    for (i = 0; i < WINE_HEAP_STATS_CLASSES; i++)
+    {
+        if (!stats.AllocCount[i] && !stats.FreeCount[i]) continue;
+        if (i < WINE_HEAP_STATS_CLASSES - 1)
+            TRACE_(heapstats)( "heap %p: size <= %lu: %u allocs, %u frees\n",
+                               heap, (SIZE_T)16 << i, stats.AllocCount[i], stats.FreeCount[i] );
+        else
+            TRACE_(heapstats)( "heap %p: size > %lu: %u allocs, %u frees\n",
+                               heap, (SIZE_T)16 << (i - 1), stats.AllocCount[i], stats.FreeCount[i] );
+    }
+}
+
+
+/***********************************************************************
+ *           heap_dump_all_statistics
+ *
+ * Dump the statistics of all the heaps of the process, called on process exit.
+ */
+void heap_dump_all_statistics(void)
+{
+    HEAP *heap;
+
+    if (!TRACE_ON(heapstats) || !processHeap) return;
+
+    RtlEnterCriticalSection( &processHeap->critSection );
+    heap_dump_statistics( processHeap );
+    LIST_FOR_EACH_ENTRY( heap, &processHeap->entry, HEAP, entry ) heap_dump_statistics( heap );
+    RtlLeaveCriticalSection( &processHeap->critSection );
+}
+
+
 /***********************************************************************
  *           RtlQueryHeapInformation    (NTDLL.@)
  */
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
-    switch (info_class)
+    HEAP *heapPtr;
+
+    switch ((ULONG)info_class)
     {
     case HeapCompatibilityInformation:
         if (size_out) *size_out = sizeof(ULONG);
@@ -2254,7 +2870,20 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+
+        if (heapPtr->lfh) *(ULONG *)info = 2;  /* low-fragmentation heap */
+        else *(ULONG *)info = 0;  /* standard heap */
+        return STATUS_SUCCESS;
+
+    case HeapWineStatisticsInformation:
+        if (size_out) *size_out = sizeof(WINE_HEAP_STATISTICS);
+
+        if (size_in < sizeof(WINE_HEAP_STATISTICS))
+            return STATUS_BUFFER_TOO_SMALL;
+
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+        heap_get_statistics( heapPtr, info );
         return STATUS_SUCCESS;
 
     default:
@@ -2268,6 +2897,34 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+    NTSTATUS status;
+
+    TRACE("%p %d %p %ld\n", heap, info_class, info, size);
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+
+        switch (*(ULONG *)info)
+        {
+        case 0:
+            /* the LFH can't be disabled once it's active */
+            return heapPtr->lfh ? STATUS_UNSUCCESSFUL : STATUS_SUCCESS;
+        case 2:
+            if (!lfh_heap_supported( heapPtr )) return STATUS_UNSUCCESSFUL;
+            RtlEnterCriticalSection( &heapPtr->critSection );
+            status = lfh_enable( heapPtr, LFH_NB_CLASSES ) ? STATUS_SUCCESS : STATUS_NO_MEMORY;
+            RtlLeaveCriticalSection( &heapPtr->critSection );
+            return status;
+        default:
+            return STATUS_UNSUCCESSFUL;
+        }
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
@@ -24,6 +24,17 @@
 
 #include <assert.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_DLFCN_H
+# include <dlfcn.h>
+#endif
+#include <sys/stat.h>
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
@@ -137,6 +148,78 @@ static inline void *get_rva( HMODULE module, DWORD va )
     return (void *)((char *)module + va);
 }
 
+/* startup profiling, enabled by setting WINELOADERPROFILE to a file name prefix */
+static int profile_fd = -1;
+static LARGE_INTEGER profile_start_time;
+BOOL loader_profile_enabled = FALSE;
+
+/***********************************************************************
+ *           init_loader_profile
+ *
+ * Open the profile file, in Chrome trace event format.
+ */
+static void init_loader_profile(void)
+{
+    const char *prefix = getenv( "WINELOADERPROFILE" );
+    char *name;
+
+    if (!prefix || !*prefix) return;
+    if (!(name = RtlAllocateHeap( GetProcessHeap(), 0, strlen(prefix) + 20 ))) return;
+    sprintf( name, "%s.%u.json", prefix, (unsigned int)getpid() );
+    profile_fd = open( name, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666 );
+    RtlFreeHeap( GetProcessHeap(), 0, name );
+    if (profile_fd == -1) return;
+
+    /* events are appended as they complete; the trace viewers accept
+     * a missing closing bracket and a trailing comma */
+    write( profile_fd, "[\n", 2 );
+    NtQueryPerformanceCounter( &profile_start_time, NULL );
+    loader_profile_enabled = TRUE;
+}
+
+static inline void profile_begin( LARGE_INTEGER *start )
+{
+    if (loader_profile_enabled) NtQueryPerformanceCounter( start, NULL );
+}
+
+/***********************************************************************
+ *           profile_event
+ *
+ * Write a complete event started at 'start'. Times are in microseconds
+ * since profiling was enabled; 'args' is an optional JSON members list.
+ */
+static void profile_event( const char *phase, const WCHAR *module, const char *args,
+                           const LARGE_INTEGER *start )
+{
+    char buffer[512];
+    LARGE_INTEGER now;
+    unsigned int len, i;
+    const WCHAR *p;
+
+    if (!loader_profile_enabled) return;
+    NtQueryPerformanceCounter( &now, NULL );
+
+    len = sprintf( buffer, "{\"name\":\"%s", phase );
+    if (module)
+    {
+        if ((p = strrchrW( module, '\\' ))) module = p + 1;
+        if ((p = strrchrW( module, '/' ))) module = p + 1;
+        buffer[len++] = ' ';
+        for (i = 0; module[i] && i < 256; i++)
+        {
+            WCHAR ch = module[i];
+            buffer[len++] = (ch >= 0x20 && ch < 0x80 && ch != '"' && ch != '\\') ? ch : '?';
+        }
+    }
+    len += sprintf( buffer + len, "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":%u,\"tid\":%u",
+                    phase, (unsigned int)((start->QuadPart - profile_start_time.QuadPart) / 10),
+                    (unsigned int)((now.QuadPart - start->QuadPart) / 10),
+                    (unsigned int)getpid(), GetCurrentThreadId() );
+    if (args) len += sprintf( buffer + len, ",\"args\":{%.128s}", args );
+    strcpy( buffer + len, "},\n" );
+    write( profile_fd, buffer, len + 3 );
+}
+
 /* check whether the file name contains a path */
 static inline BOOL contains_path( LPCWSTR name )
 {
@@ -449,34 +532,144 @@ static WINE_MODREF *find_fileid_module( HANDLE handle, struct stat *st )
 }
 
 
+/* persistent cache of resolved imports, enabled with WINEIMPORTCACHE=1 */
+
+#define IMPORT_CACHE_MAGIC        0x43504d49  /* "IMPC" */
+#define IMPORT_CACHE_VERSION      1
+#define IMPORT_CACHE_MAX_FORWARDS 16
+
+/* what must not change for the cached addresses to be valid */
+struct module_identity
+{
+    ULONGLONG    dev;         /* file identity */
+    ULONGLONG    ino;
+    ULONGLONG    mtime;       /* only known for builtin libraries */
+    ULONGLONG    size;
+    ULONGLONG    base;        /* load address, 0 for the importing module */
+    unsigned int timestamp;   /* PE header fields */
+    unsigned int checksum;
+    unsigned int image_size;
+    unsigned int pad;
+};
+
+struct import_cache_header
+{
+    unsigned int           magic;
+    unsigned int           version;
+    struct module_identity module;      /* importing module */
+};
+
+/* one entry per import descriptor, followed by the forward entries and the resolved addresses */
+struct import_cache_descr
+{
+    struct module_identity dep;         /* imported module, all zero if the import is unused */
+    unsigned int           nb_forwards; /* modules reached through forwarded exports */
+    unsigned int           nb_thunks;   /* number of import address table entries */
+};
+
+struct import_cache_forward
+{
+    WCHAR                  name[32];
+    struct module_identity id;
+};
+
+struct import_cache
+{
+    WCHAR        name[64];      /* file name relative to the cache directory */
+    struct module_identity id;  /* identity of the importing module */
+    char        *data;          /* contents of the cache file, if any */
+    SIZE_T       data_size;
+    SIZE_T       data_pos;      /* current descriptor in the file contents */
+    char        *out;           /* contents for the current load */
+    SIZE_T       out_size;
+    SIZE_T       out_pos;
+    BOOL         cacheable;     /* all imports could be resolved in a cacheable way */
+    BOOL         dirty;         /* the file needs to be written */
+    unsigned int nb_forwards;   /* forwarded modules used by the current descriptor */
+    WINE_MODREF *forwards[IMPORT_CACHE_MAX_FORWARDS];
+};
+
+static BOOL import_cache_enabled;
+static struct import_cache *current_import_cache;
+
 /*************************************************************************
- *		find_forwarded_export
+ *		init_import_cache
+ */
+static void init_import_cache(void)
+{
+    const char *env = getenv( "WINEIMPORTCACHE" );
+
+    /* relay and snoop thunks are allocated at run time */
+    import_cache_enabled = env && atoi( env ) && !TRACE_ON(relay) && !TRACE_ON(snoop);
+}
+
+/*************************************************************************
+ *		get_module_identity
  *
- * Find the final function pointer for a forwarded function.
- * The loader_section must be locked while calling this function.
+ * Gather what identifies a loaded module, for validating cached imports.
  */
-static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWSTR load_path )
+static BOOL get_module_identity( WINE_MODREF *wm, struct module_identity *id )
 {
-    const IMAGE_EXPORT_DIRECTORY *exports;
-    DWORD exp_size;
-    WINE_MODREF *wm;
-    WCHAR mod_name[32];
-    const char *end = strrchr(forward, '.');
-    FARPROC proc = NULL;
+    const IMAGE_NT_HEADERS *nt = RtlImageNtHeader( wm->ldr.BaseAddress );
 
-    if (!end) return NULL;
-    if ((end - forward) * sizeof(WCHAR) >= sizeof(mod_name)) return NULL;
-    ascii_to_unicode( mod_name, forward, end - forward );
-    mod_name[end - forward] = 0;
-    if (!strchrW( mod_name, '.' ))
+    memset( id, 0, sizeof(*id) );
+    id->base       = (ULONG_PTR)wm->ldr.BaseAddress;
+    id->timestamp  = nt->FileHeader.TimeDateStamp;
+    id->checksum   = nt->OptionalHeader.CheckSum;
+    id->image_size = nt->OptionalHeader.SizeOfImage;
+
+    if (wm->ldr.Flags & LDR_WINE_INTERNAL)
     {
-        if ((end - forward) * sizeof(WCHAR) >= sizeof(mod_name) - sizeof(dllW)) return NULL;
-        memcpy( mod_name + (end - forward), dllW, sizeof(dllW) );
+#ifdef HAVE_DLADDR
+        /* builtin PE headers carry no timestamp, use the library file instead */
+        Dl_info info;
+        struct stat st;
+
+        if (!dladdr( wm->ldr.BaseAddress, &info ) || stat( info.dli_fname, &st )) return FALSE;
+        id->dev   = st.st_dev;
+        id->ino   = st.st_ino;
+        id->mtime = st.st_mtime;
+        id->size  = st.st_size;
+        return TRUE;
+#else
+        return FALSE;
+#endif
     }
+    id->dev = wm->dev;
+    id->ino = wm->ino;
+    return id->dev || id->ino;
+}
+
+/*************************************************************************
+ *		import_cache_add_forward
+ *
+ * Remember a module used to resolve a forwarded import.
+ */
+static void import_cache_add_forward( WINE_MODREF *wm )
+{
+    struct import_cache *cache = current_import_cache;
+    unsigned int i;
+
+    if (!cache) return;
+    for (i = 0; i < cache->nb_forwards; i++) if (cache->forwards[i] == wm) return;
+    if (cache->nb_forwards < IMPORT_CACHE_MAX_FORWARDS) cache->forwards[cache->nb_forwards++] = wm;
+    else cache->cacheable = FALSE;
+}
+
+
+/*************************************************************************
+ *		get_forward_module
+ *
+ * Find or load the target module of a forwarded function.
+ * The loader_section must be locked while calling this function.
+ */
+static WINE_MODREF *get_forward_module( const WCHAR *mod_name, LPCWSTR load_path )
+{
+    WINE_MODREF *wm;
 
     if (!(wm = find_basename_module( mod_name )))
     {
-        TRACE( "delay loading %s for '%s'\n", debugstr_w(mod_name), forward );
+        TRACE( "delay loading %s\n", debugstr_w(mod_name) );
         if (load_dll( load_path, mod_name, 0, &wm ) == STATUS_SUCCESS &&
             !(wm->ldr.Flags & LDR_DONT_RESOLVE_REFS))
         {
@@ -500,14 +693,44 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
                 wm = NULL;
             }
         }
+    }
+    return wm;
+}
 
-        if (!wm)
-        {
-            ERR( "module not found for forward '%s' used by %s\n",
-                 forward, debugstr_w(get_modref(module)->ldr.FullDllName.Buffer) );
-            return NULL;
-        }
+
+/*************************************************************************
+ *		find_forwarded_export
+ *
+ * Find the final function pointer for a forwarded function.
+ * The loader_section must be locked while calling this function.
+ */
+static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWSTR load_path )
+{
+    const IMAGE_EXPORT_DIRECTORY *exports;
+    DWORD exp_size;
+    WINE_MODREF *wm;
+    WCHAR mod_name[32];
+    const char *end = strrchr(forward, '.');
+    FARPROC proc = NULL;
+
+    if (!end) return NULL;
+    if ((end - forward) * sizeof(WCHAR) >= sizeof(mod_name)) return NULL;
+    ascii_to_unicode( mod_name, forward, end - forward );
+    mod_name[end - forward] = 0;
+    if (!strchrW( mod_name, '.' ))
+    {
+        if ((end - forward) * sizeof(WCHAR) >= sizeof(mod_name) - sizeof(dllW)) return NULL;
+        memcpy( mod_name + (end - forward), dllW, sizeof(dllW) );
     }
+
+    if (!(wm = get_forward_module( mod_name, load_path )))
+    {
+        ERR( "module not found for forward '%s' used by %s\n",
+             forward, debugstr_w(get_modref(module)->ldr.FullDllName.Buffer) );
+        return NULL;
+    }
+    import_cache_add_forward( wm );
+
     if ((exports = RtlImageDirectoryEntryToData( wm->ldr.BaseAddress, TRUE,
                                                  IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
@@ -606,6 +829,670 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
 }
 
 
+/*************************************************************************
+ *		get_import_cache_path
+ *
+ * Build the name of a file in the import cache directory, or of the
+ * directory itself if name is NULL.
+ */
+static char *get_import_cache_path( const WCHAR *name, const char *suffix )
+{
+    const char *config_dir = wine_get_config_dir();
+    char *ret;
+    unsigned int len;
+
+    if (!(ret = RtlAllocateHeap( GetProcessHeap(), 0, strlen(config_dir) + sizeof("/importcache/") +
+                                 (name ? strlenW(name) : 0) + strlen(suffix) )))
+        return NULL;
+    strcpy( ret, config_dir );
+    strcat( ret, "/importcache" );
+    if (!name) return ret;
+    len = strlen( ret );
+    ret[len++] = '/';
+    while (*name) ret[len++] = *name++;  /* names are plain ASCII */
+    strcpy( ret + len, suffix );
+    return ret;
+}
+
+/*************************************************************************
+ *		open_import_cache
+ *
+ * Load the cached imports of a module, and prepare for recording its imports.
+ */
+static BOOL open_import_cache( struct import_cache *cache, WINE_MODREF *wm )
+{
+    static const WCHAR fmtW[] = {'%','0','8','x','%','0','8','x',0};
+    const struct import_cache_header *header;
+    struct import_cache_header *out_header;
+    ULONGLONG hash = 0xcbf29ce484222325;
+    const unsigned char *p;
+    struct stat st;
+    char *file;
+    unsigned int i;
+    int fd;
+
+    memset( cache, 0, sizeof(*cache) );
+    if (!get_module_identity( wm, &cache->id )) return FALSE;
+    cache->id.base = 0;  /* relocating the importing module doesn't change its imports */
+
+    for (i = 0, p = (const unsigned char *)&cache->id; i < sizeof(cache->id); i++)
+        hash = (hash ^ p[i]) * 0x100000001b3;
+    sprintfW( cache->name, fmtW, (unsigned int)(hash >> 32), (unsigned int)hash );
+
+    cache->out_size = 4096;
+    if (!(cache->out = RtlAllocateHeap( GetProcessHeap(), 0, cache->out_size ))) return FALSE;
+    out_header = (struct import_cache_header *)cache->out;
+    out_header->magic   = IMPORT_CACHE_MAGIC;
+    out_header->version = IMPORT_CACHE_VERSION;
+    out_header->module  = cache->id;
+    cache->out_pos = sizeof(*out_header);
+    cache->cacheable = TRUE;
+    cache->dirty = TRUE;
+
+    if (!(file = get_import_cache_path( cache->name, "" ))) return TRUE;
+    fd = open( file, O_RDONLY );
+    RtlFreeHeap( GetProcessHeap(), 0, file );
+    if (fd == -1) return TRUE;
+
+    if (!fstat( fd, &st ) && st.st_size > sizeof(*header) &&
+        (cache->data = RtlAllocateHeap( GetProcessHeap(), 0, st.st_size )))
+    {
+        if (read( fd, cache->data, st.st_size ) == st.st_size)
+        {
+            header = (const struct import_cache_header *)cache->data;
+            if (header->magic == IMPORT_CACHE_MAGIC && header->version == IMPORT_CACHE_VERSION &&
+                !memcmp( &header->module, &cache->id, sizeof(cache->id) ))
+            {
+                cache->data_size = st.st_size;
+                cache->data_pos = sizeof(*header);
+                cache->dirty = FALSE;
+            }
+        }
+        if (!cache->data_size)
+        {
+            RtlFreeHeap( GetProcessHeap(), 0, cache->data );
+            cache->data = NULL;
+        }
+    }
+    close( fd );
+    return TRUE;
+}
+
+/*************************************************************************
+ *		close_import_cache
+ *
+ * Write the recorded imports if they changed, and free the cache data.
+ */
+static void close_import_cache( struct import_cache *cache )
+{
+    char *dir = NULL, *file = NULL, *tmp = NULL;
+    char suffix[32];
+    int fd;
+
+    if (cache->cacheable && cache->dirty)
+    {
+        /* write a temporary file first so that concurrent loaders never see partial data */
+        sprintf( suffix, ".%u.tmp", (unsigned int)getpid() );
+        if ((dir = get_import_cache_path( NULL, "" )) &&
+            (file = get_import_cache_path( cache->name, "" )) &&
+            (tmp = get_import_cache_path( cache->name, suffix )))
+        {
+            mkdir( dir, 0777 );
+            if ((fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) != -1)
+            {
+                BOOL ok = (write( fd, cache->out, cache->out_pos ) == cache->out_pos);
+                close( fd );
+                if (!ok || rename( tmp, file )) unlink( tmp );
+                else TRACE( "saved imports to %s\n", debugstr_a(file) );
+            }
+        }
+        RtlFreeHeap( GetProcessHeap(), 0, dir );
+        RtlFreeHeap( GetProcessHeap(), 0, file );
+        RtlFreeHeap( GetProcessHeap(), 0, tmp );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, cache->data );
+    RtlFreeHeap( GetProcessHeap(), 0, cache->out );
+}
+
+/*************************************************************************
+ *		import_cache_next_descr
+ *
+ * Get the cached entry of the next import descriptor, if valid.
+ */
+static const struct import_cache_descr *import_cache_next_descr( struct import_cache *cache )
+{
+    const struct import_cache_descr *descr;
+    SIZE_T size;
+
+    cache->nb_forwards = 0;
+    if (!cache->data) return NULL;
+
+    descr = (const struct import_cache_descr *)(cache->data + cache->data_pos);
+    if (cache->data_size - cache->data_pos < sizeof(*descr)) goto invalid;
+    size = sizeof(*descr) + descr->nb_forwards * sizeof(struct import_cache_forward) +
+           descr->nb_thunks * sizeof(ULONGLONG);
+    if (descr->nb_forwards > IMPORT_CACHE_MAX_FORWARDS || descr->nb_thunks > 0x10000 ||
+        cache->data_size - cache->data_pos < size)
+        goto invalid;
+    cache->data_pos += size;
+    return descr;
+
+invalid:
+    RtlFreeHeap( GetProcessHeap(), 0, cache->data );
+    cache->data = NULL;
+    cache->dirty = TRUE;
+    return NULL;
+}
+
+/*************************************************************************
+ *		import_cache_apply
+ *
+ * Fill an import address table from a cached entry, if the imported module
+ * and all the modules reached through forwarded exports are unchanged.
+ */
+static BOOL import_cache_apply( struct import_cache *cache, const struct import_cache_descr *descr,
+                                WINE_MODREF *imp, IMAGE_THUNK_DATA *thunk_list, ULONG count,
+                                LPCWSTR load_path )
+{
+    const struct import_cache_forward *forward = (const struct import_cache_forward *)(descr + 1);
+    const ULONGLONG *thunks = (const ULONGLONG *)(forward + descr->nb_forwards);
+    struct module_identity id;
+    WINE_MODREF *wm;
+    WCHAR name[32];
+    ULONG i;
+
+    if (descr->nb_thunks != count) return FALSE;
+    if (!get_module_identity( imp, &id ) || memcmp( &id, &descr->dep, sizeof(id) )) return FALSE;
+
+    for (i = 0; i < descr->nb_forwards; i++)
+    {
+        memcpy( name, forward[i].name, sizeof(name) );
+        name[31] = 0;
+        if (!(wm = get_forward_module( name, load_path ))) return FALSE;
+        if (!get_module_identity( wm, &id ) || memcmp( &id, &forward[i].id, sizeof(id) )) return FALSE;
+        import_cache_add_forward( wm );
+    }
+    for (i = 0; i < count; i++) thunk_list[i].u1.Function = (ULONG_PTR)thunks[i];
+    return TRUE;
+}
+
+/*************************************************************************
+ *		import_cache_record
+ *
+ * Record the resolved import address table of an import descriptor.
+ */
+static void import_cache_record( struct import_cache *cache, WINE_MODREF *imp,
+                                 const IMAGE_THUNK_DATA *thunk_list, ULONG count )
+{
+    struct import_cache_descr *descr;
+    struct import_cache_forward *forward;
+    ULONGLONG *thunks;
+    SIZE_T size;
+    ULONG i;
+    char *new_out;
+
+    if (!cache->cacheable) return;
+
+    size = sizeof(*descr) + cache->nb_forwards * sizeof(*forward) + count * sizeof(*thunks);
+    if (cache->out_size - cache->out_pos < size)
+    {
+        SIZE_T new_size = max( cache->out_size * 2, cache->out_pos + size );
+        if (!(new_out = RtlReAllocateHeap( GetProcessHeap(), 0, cache->out, new_size )))
+        {
+            cache->cacheable = FALSE;
+            return;
+        }
+        cache->out = new_out;
+        cache->out_size = new_size;
+    }
+
+    descr = (struct import_cache_descr *)(cache->out + cache->out_pos);
+    memset( descr, 0, sizeof(*descr) );
+    if (imp && !get_module_identity( imp, &descr->dep )) cache->cacheable = FALSE;
+    descr->nb_forwards = cache->nb_forwards;
+    descr->nb_thunks = count;
+
+    forward = (struct import_cache_forward *)(descr + 1);
+    for (i = 0; i < cache->nb_forwards; i++)
+    {
+        const UNICODE_STRING *name = &cache->forwards[i]->ldr.BaseDllName;
+
+        memset( forward[i].name, 0, sizeof(forward[i].name) );
+        if (name->Length >= sizeof(forward[i].name)) cache->cacheable = FALSE;
+        else memcpy( forward[i].name, name->Buffer, name->Length );
+        if (!get_module_identity( cache->forwards[i], &forward[i].id )) cache->cacheable = FALSE;
+    }
+
+    thunks = (ULONGLONG *)(forward + cache->nb_forwards);
+    for (i = 0; i < count; i++) thunks[i] = thunk_list[i].u1.Function;
+    cache->out_pos += size;
+}
+
+
+/* loader helper threads, enabled by setting WINELOADERTHREADS to the number of threads.
+ * They are plain Unix threads without a TEB, so they must never call into Win32 code,
+ * take critical sections or fault; they only warm the page cache with the files of the
+ * dependency graph and apply relocations to pages that have already been made writable. */
+
+#define LOADER_MAX_THREADS   8
+#define PREFETCH_MAX_DIRS    32
+#define PREFETCH_MAX_NAMES   4096
+#define PREFETCH_NAME_LEN    64
+
+struct loader_job
+{
+    struct loader_job *next;
+    void             (*func)( struct loader_job *job );
+};
+
+struct prefetch_job
+{
+    struct loader_job job;
+    char              name[PREFETCH_NAME_LEN];
+};
+
+struct reloc_job
+{
+    struct loader_job      job;
+    char                  *module;
+    IMAGE_BASE_RELOCATION *rel;
+    IMAGE_BASE_RELOCATION *end;
+    INT_PTR                delta;
+};
+
+static unsigned int loader_threads;
+static pthread_mutex_t loader_job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t loader_job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t reloc_done_cond = PTHREAD_COND_INITIALIZER;
+static struct loader_job *loader_job_head;
+static struct loader_job **loader_job_tail = &loader_job_head;
+static unsigned int reloc_jobs_pending;
+
+/* Unix directories searched for native files; entries are never removed or modified */
+static char *prefetch_dirs[PREFETCH_MAX_DIRS];
+static unsigned int nb_prefetch_dirs;
+static WCHAR *prefetch_load_path;
+static char *prefetch_names[PREFETCH_MAX_NAMES];  /* open addressing hash of queued names */
+static unsigned int nb_prefetch_names;
+
+/* queue a job, at the head of the queue if it is urgent; loader_job_mutex must be held */
+static void queue_loader_job( struct loader_job *job, BOOL urgent )
+{
+    if (urgent)
+    {
+        if (!(job->next = loader_job_head)) loader_job_tail = &job->next;
+        loader_job_head = job;
+    }
+    else
+    {
+        job->next = NULL;
+        *loader_job_tail = job;
+        loader_job_tail = &job->next;
+    }
+    pthread_cond_signal( &loader_job_cond );
+}
+
+static void *loader_thread( void *arg )
+{
+    struct loader_job *job;
+
+    for (;;)
+    {
+        pthread_mutex_lock( &loader_job_mutex );
+        while (!(job = loader_job_head)) pthread_cond_wait( &loader_job_cond, &loader_job_mutex );
+        if (!(loader_job_head = job->next)) loader_job_tail = &loader_job_head;
+        pthread_mutex_unlock( &loader_job_mutex );
+        job->func( job );
+    }
+    return NULL;
+}
+
+/*************************************************************************
+ *		init_loader_threads
+ */
+static void init_loader_threads(void)
+{
+    const char *env = getenv( "WINELOADERTHREADS" );
+    unsigned int i, count = env ? atoi( env ) : 0;
+    pthread_attr_t attr;
+    pthread_t thread;
+    sigset_t sigset, old_set;
+
+    if (!count) return;
+    if (count > LOADER_MAX_THREADS) count = LOADER_MAX_THREADS;
+
+    /* the threads have no TEB, so our signal handlers must never run on them */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_SETMASK, &sigset, &old_set );
+    pthread_attr_init( &attr );
+    pthread_attr_setstacksize( &attr, 64 * 1024 );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    for (i = 0; i < count; i++)
+    {
+        if (pthread_create( &thread, &attr, loader_thread, NULL )) break;
+        loader_threads++;
+    }
+    pthread_attr_destroy( &attr );
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+    TRACE( "started %u loader threads\n", loader_threads );
+}
+
+static void prefetch_add_dir( const char *dir )
+{
+    unsigned int i;
+    char *copy;
+
+    for (i = 0; i < nb_prefetch_dirs; i++) if (!strcmp( prefetch_dirs[i], dir )) return;
+    if (nb_prefetch_dirs == PREFETCH_MAX_DIRS) return;
+    if (!(copy = malloc( strlen(dir) + 1 ))) return;
+    strcpy( copy, dir );
+    prefetch_dirs[nb_prefetch_dirs] = copy;
+    nb_prefetch_dirs++;
+}
+
+/* convert the directories of a load path to Unix names; loader_job_mutex must be held */
+static void prefetch_set_load_path( LPCWSTR load_path )
+{
+    UNICODE_STRING nt_name;
+    ANSI_STRING unix_name;
+    WCHAR *dir;
+    const WCHAR *p, *next;
+    SIZE_T len;
+
+    if (prefetch_load_path && !strcmpW( prefetch_load_path, load_path )) return;
+    RtlFreeHeap( GetProcessHeap(), 0, prefetch_load_path );
+    len = (strlenW( load_path ) + 1) * sizeof(WCHAR);
+    if (!(prefetch_load_path = RtlAllocateHeap( GetProcessHeap(), 0, len ))) return;
+    memcpy( prefetch_load_path, load_path, len );
+    if (!(dir = RtlAllocateHeap( GetProcessHeap(), 0, len ))) return;
+
+    for (p = load_path; *p; p = next)
+    {
+        if (!(next = strchrW( p, ';' ))) next = p + strlenW( p );
+        memcpy( dir, p, (next - p) * sizeof(WCHAR) );
+        dir[next - p] = 0;
+        if (*next) next++;
+        if (!dir[0] || !RtlDosPathNameToNtPathName_U( dir, &nt_name, NULL, NULL )) continue;
+        if (!wine_nt_to_unix_file_name( &nt_name, &unix_name, FILE_OPEN, FALSE ))
+        {
+            prefetch_add_dir( unix_name.Buffer );
+            RtlFreeAnsiString( &unix_name );
+        }
+        RtlFreeUnicodeString( &nt_name );
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, dir );
+}
+
+static void prefetch_run( struct loader_job *job );
+
+/* queue a file for prefetching, unless it was already seen; loader_job_mutex must be held */
+static void prefetch_queue_name( const char *name, SIZE_T len )
+{
+    struct prefetch_job *job;
+    unsigned int i, hash = 0;
+    char lower[PREFETCH_NAME_LEN];
+
+    if (!len || len >= PREFETCH_NAME_LEN || nb_prefetch_names >= PREFETCH_MAX_NAMES / 2) return;
+    for (i = 0; i < len; i++)
+    {
+        if (name[i] == '/' || name[i] == '\\') return;
+        lower[i] = (name[i] >= 'A' && name[i] <= 'Z') ? name[i] + 'a' - 'A' : name[i];
+        hash = hash * 31 + (unsigned char)lower[i];
+    }
+    lower[len] = 0;
+
+    for (i = hash % PREFETCH_MAX_NAMES; prefetch_names[i]; i = (i + 1) % PREFETCH_MAX_NAMES)
+        if (!strcmp( prefetch_names[i], lower )) return;
+
+    if (!(job = malloc( sizeof(*job) ))) return;
+    job->job.func = prefetch_run;
+    strcpy( job->name, lower );
+    prefetch_names[i] = job->name;  /* the names are never freed */
+    nb_prefetch_names++;
+    queue_loader_job( &job->job, FALSE );
+}
+
+/* translate an rva to a file offset using the section table */
+static BOOL prefetch_rva_to_offset( const IMAGE_SECTION_HEADER *sec, unsigned int nb_sections,
+                                    DWORD rva, DWORD *offset )
+{
+    unsigned int i;
+
+    for (i = 0; i < nb_sections; i++)
+    {
+        if (rva < sec[i].VirtualAddress) continue;
+        if (rva - sec[i].VirtualAddress >= max( sec[i].Misc.VirtualSize, sec[i].SizeOfRawData )) continue;
+        if (rva - sec[i].VirtualAddress >= sec[i].SizeOfRawData) return FALSE;
+        *offset = sec[i].PointerToRawData + rva - sec[i].VirtualAddress;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* queue the imports of a PE file that is being prefetched */
+static void prefetch_file_imports( int fd )
+{
+    union
+    {
+        IMAGE_NT_HEADERS32 nt32;
+        IMAGE_NT_HEADERS64 nt64;
+    } nt;
+    IMAGE_DOS_HEADER dos;
+    IMAGE_SECTION_HEADER sec[96];
+    IMAGE_IMPORT_DESCRIPTOR descr;
+    const IMAGE_DATA_DIRECTORY *dir;
+    unsigned int nb_sections;
+    DWORD offset, sec_offset, name_offset;
+    char name[PREFETCH_NAME_LEN];
+    ssize_t len;
+
+    if (pread( fd, &dos, sizeof(dos), 0 ) != sizeof(dos) || dos.e_magic != IMAGE_DOS_SIGNATURE) return;
+    if (pread( fd, &nt, sizeof(nt), dos.e_lfanew ) != sizeof(nt)) return;
+    if (nt.nt32.Signature != IMAGE_NT_SIGNATURE) return;
+
+    if (nt.nt32.OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC)
+    {
+        if (nt.nt64.OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_IMPORT) return;
+        dir = &nt.nt64.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+    }
+    else
+    {
+        if (nt.nt32.OptionalHeader.NumberOfRvaAndSizes <= IMAGE_DIRECTORY_ENTRY_IMPORT) return;
+        dir = &nt.nt32.OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+    }
+    if (!dir->VirtualAddress || !dir->Size) return;
+
+    nb_sections = min( nt.nt32.FileHeader.NumberOfSections, sizeof(sec)/sizeof(sec[0]) );
+    sec_offset = dos.e_lfanew + FIELD_OFFSET( IMAGE_NT_HEADERS32, OptionalHeader ) +
+                 nt.nt32.FileHeader.SizeOfOptionalHeader;
+    if (pread( fd, sec, nb_sections * sizeof(sec[0]), sec_offset ) != nb_sections * sizeof(sec[0])) return;
+    if (!prefetch_rva_to_offset( sec, nb_sections, dir->VirtualAddress, &offset )) return;
+
+    for (;; offset += sizeof(descr))
+    {
+        if (pread( fd, &descr, sizeof(descr), offset ) != sizeof(descr)) break;
+        if (!descr.Name || !descr.FirstThunk) break;
+        if (!prefetch_rva_to_offset( sec, nb_sections, descr.Name, &name_offset )) continue;
+        if ((len = pread( fd, name, sizeof(name), name_offset )) <= 0) continue;
+        name[len - 1] = 0;
+        pthread_mutex_lock( &loader_job_mutex );
+        prefetch_queue_name( name, strlen( name ));
+        pthread_mutex_unlock( &loader_job_mutex );
+    }
+}
+
+/* open a file and start reading it in the background */
+static int prefetch_open( const char *dir, const char *name, const char *ext )
+{
+    char path[PATH_MAX];
+    int fd;
+
+    if (snprintf( path, sizeof(path), "%s/%s%s", dir, name, ext ) >= sizeof(path)) return -1;
+    if ((fd = open( path, O_RDONLY )) == -1) return -1;
+#ifdef POSIX_FADV_WILLNEED
+    posix_fadvise( fd, 0, 0, POSIX_FADV_WILLNEED );
+#endif
+    return fd;
+}
+
+/* prefetch the native file and the builtin library of a dll, and queue its imports */
+static void prefetch_run( struct loader_job *job )
+{
+    struct prefetch_job *prefetch = CONTAINING_RECORD( job, struct prefetch_job, job );
+    const char *dir, *ext = strchr( prefetch->name, '.' ) ? "" : ".dll";
+    unsigned int i, count;
+    char name[PREFETCH_NAME_LEN + 8];
+    int fd;
+
+    pthread_mutex_lock( &loader_job_mutex );
+    count = nb_prefetch_dirs;
+    pthread_mutex_unlock( &loader_job_mutex );
+
+    for (i = 0; i < count; i++)
+    {
+        if ((fd = prefetch_open( prefetch_dirs[i], prefetch->name, ext )) == -1) continue;
+        prefetch_file_imports( fd );
+        close( fd );
+        break;
+    }
+
+    sprintf( name, "%s%s", prefetch->name, ext );
+    for (i = 0; (dir = wine_dll_enum_load_path( i )); i++)
+    {
+        if ((fd = prefetch_open( dir, name, ".so" )) == -1) continue;
+        close( fd );
+        break;
+    }
+}
+
+/*************************************************************************
+ *		prefetch_imports
+ *
+ * Queue the dlls imported by a module for prefetching, so that the
+ * helper threads pull the whole dependency graph into the page cache
+ * while the imports are loaded one by one.
+ */
+static void prefetch_imports( WINE_MODREF *wm, const IMAGE_IMPORT_DESCRIPTOR *imports,
+                              int nb_imports, LPCWSTR load_path )
+{
+    const char *name;
+    int i;
+
+    if (!loader_threads) return;
+
+    pthread_mutex_lock( &loader_job_mutex );
+    if (load_path) prefetch_set_load_path( load_path );
+    for (i = 0; i < nb_imports; i++)
+    {
+        name = get_rva( wm->ldr.BaseAddress, imports[i].Name );
+        prefetch_queue_name( name, strlen( name ));
+    }
+    pthread_mutex_unlock( &loader_job_mutex );
+}
+
+static void apply_relocations( struct reloc_job *reloc )
+{
+    IMAGE_BASE_RELOCATION *rel = reloc->rel;
+
+    while (rel < reloc->end)
+        rel = LdrProcessRelocationBlock( reloc->module + rel->VirtualAddress,
+                                         (rel->SizeOfBlock - sizeof(*rel)) / sizeof(USHORT),
+                                         (USHORT *)(rel + 1), reloc->delta );
+}
+
+static void reloc_run( struct loader_job *job )
+{
+    apply_relocations( CONTAINING_RECORD( job, struct reloc_job, job ));
+
+    pthread_mutex_lock( &loader_job_mutex );
+    if (!--reloc_jobs_pending) pthread_cond_broadcast( &reloc_done_cond );
+    pthread_mutex_unlock( &loader_job_mutex );
+}
+
+/*************************************************************************
+ *		perform_relocations_parallel
+ *
+ * Split a large relocation table between the helper threads. Returns
+ * FALSE if the table has to be processed serially, before touching
+ * anything.
+ */
+static BOOL perform_relocations_parallel( char *module, SIZE_T len, IMAGE_BASE_RELOCATION *rel,
+                                          IMAGE_BASE_RELOCATION *end, INT_PTR delta )
+{
+    struct reloc_job jobs[LOADER_MAX_THREADS + 1];
+    IMAGE_BASE_RELOCATION *block;
+    SIZE_T total, chunk, done;
+    unsigned int i, count, nb_jobs;
+    const USHORT *relocs;
+
+    total = (char *)end - (char *)rel;
+    if (!loader_threads || total < 64 * 1024) return FALSE;
+
+    /* validate everything first, the helper threads can't report errors */
+    for (block = rel; block < end - 1 && block->SizeOfBlock; block = (IMAGE_BASE_RELOCATION *)relocs)
+    {
+        if (block->VirtualAddress >= len || block->SizeOfBlock < sizeof(*block) ||
+            block->SizeOfBlock > (char *)end - (char *)block)
+            return FALSE;
+        relocs = (const USHORT *)(block + 1);
+        count = (block->SizeOfBlock - sizeof(*block)) / sizeof(USHORT);
+        for (i = 0; i < count; i++, relocs++)
+        {
+            switch (*relocs >> 12)
+            {
+            case IMAGE_REL_BASED_ABSOLUTE:
+            case IMAGE_REL_BASED_HIGH:
+            case IMAGE_REL_BASED_LOW:
+            case IMAGE_REL_BASED_HIGHLOW:
+#ifdef _WIN64
+            case IMAGE_REL_BASED_DIR64:
+#endif
+                break;
+            default:
+                return FALSE;
+            }
+        }
+    }
+    end = block;
+
+    /* cut the table at block boundaries into one chunk per thread, plus one for us */
+    chunk = total / (loader_threads + 1);
+    nb_jobs = 0;
+    jobs[0].rel = rel;
+    for (block = rel, done = 0; block < end; block = (IMAGE_BASE_RELOCATION *)((char *)block + block->SizeOfBlock))
+    {
+        done += block->SizeOfBlock;
+        if (done < chunk || nb_jobs == loader_threads) continue;
+        jobs[nb_jobs].end = (IMAGE_BASE_RELOCATION *)((char *)block + block->SizeOfBlock);
+        jobs[nb_jobs + 1].rel = jobs[nb_jobs].end;
+        nb_jobs++;
+        done = 0;
+    }
+    jobs[nb_jobs].end = end;
+
+    TRACE( "relocating %p with %u threads\n", module, nb_jobs + 1 );
+
+    for (i = 0; i <= nb_jobs; i++)
+    {
+        jobs[i].job.func = reloc_run;
+        jobs[i].module = module;
+        jobs[i].delta = delta;
+    }
+
+    pthread_mutex_lock( &loader_job_mutex );
+    reloc_jobs_pending = nb_jobs;
+    for (i = 1; i <= nb_jobs; i++) queue_loader_job( &jobs[i].job, TRUE );
+    pthread_mutex_unlock( &loader_job_mutex );
+
+    apply_relocations( &jobs[0] );
+
+    pthread_mutex_lock( &loader_job_mutex );
+    while (reloc_jobs_pending) pthread_cond_wait( &reloc_done_cond, &loader_job_mutex );
+    pthread_mutex_unlock( &loader_job_mutex );
+    return TRUE;
+}
+
+
 /*************************************************************************
  *		import_dll
  *
@@ -627,16 +1514,24 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
     PVOID protect_base;
     SIZE_T protect_size = 0;
     DWORD protect_old;
+    LARGE_INTEGER start;
+    ULONG count;
+    struct import_cache *cache = current_import_cache;
+    const struct import_cache_descr *cached = NULL;
+    IMAGE_THUNK_DATA *first_thunk;
 
-    thunk_list = get_rva( module, (DWORD)descr->FirstThunk );
+    thunk_list = first_thunk = get_rva( module, (DWORD)descr->FirstThunk );
     if (descr->u.OriginalFirstThunk)
         import_list = get_rva( module, (DWORD)descr->u.OriginalFirstThunk );
     else
         import_list = thunk_list;
 
+    if (cache) cached = import_cache_next_descr( cache );
+
     if (!import_list->u1.Ordinal)
     {
         WARN( "Skipping unused import %s\n", name );
+        if (cache) import_cache_record( cache, NULL, thunk_list, 0 );
         *pwm = NULL;
         return TRUE;
     }
@@ -667,17 +1562,33 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         else
             ERR("Loading library %s (which is needed by %s) failed (error %x).\n",
                 name, debugstr_w(current_modref->ldr.FullDllName.Buffer), status);
+        if (cache) cache->cacheable = FALSE;
         return FALSE;
     }
 
+    profile_begin( &start );
+
     /* unprotect the import address table since it can be located in
      * readonly section */
     while (import_list[protect_size].u1.Ordinal) protect_size++;
+    count = protect_size;
     protect_base = thunk_list;
     protect_size *= sizeof(*thunk_list);
     NtProtectVirtualMemory( NtCurrentProcess(), &protect_base,
                             &protect_size, PAGE_READWRITE, &protect_old );
 
+    if (cached && import_cache_apply( cache, cached, wmImp, thunk_list, count, load_path ))
+    {
+        TRACE_(imports)( "using cached imports from %s\n", name );
+        goto done;
+    }
+    if (cache)
+    {
+        /* resolve by name, and record the result */
+        cache->dirty = TRUE;
+        cache->nb_forwards = 0;
+    }
+
     imp_mod = wmImp->ldr.BaseAddress;
     exports = RtlImageDirectoryEntryToData( imp_mod, TRUE, IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size );
 
@@ -691,12 +1602,14 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
                 int ordinal = IMAGE_ORDINAL(import_list->u1.Ordinal);
                 WARN("No implementation for %s.%d", name, ordinal );
                 thunk_list->u1.Function = allocate_stub( name, IntToPtr(ordinal) );
+                if (cache) cache->cacheable = FALSE;
             }
             else
             {
                 IMAGE_IMPORT_BY_NAME *pe_name = get_rva( module, (DWORD)import_list->u1.AddressOfData );
                 WARN("No implementation for %s.%s", name, pe_name->Name );
                 thunk_list->u1.Function = allocate_stub( name, (const char*)pe_name->Name );
+                if (cache) cache->cacheable = FALSE;
             }
             WARN(" imported from %s, allocating stub %p\n",
                  debugstr_w(current_modref->ldr.FullDllName.Buffer),
@@ -718,6 +1631,7 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
             if (!thunk_list->u1.Function)
             {
                 thunk_list->u1.Function = allocate_stub( name, IntToPtr(ordinal) );
+                if (cache) cache->cacheable = FALSE;
                 WARN("No implementation for %s.%d imported from %s, setting to %p\n",
                      name, ordinal, debugstr_w(current_modref->ldr.FullDllName.Buffer),
                      (void *)thunk_list->u1.Function );
@@ -734,6 +1648,7 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
             if (!thunk_list->u1.Function)
             {
                 thunk_list->u1.Function = allocate_stub( name, (const char*)pe_name->Name );
+                if (cache) cache->cacheable = FALSE;
                 WARN("No implementation for %s.%s imported from %s, setting to %p\n",
                      name, pe_name->Name, debugstr_w(current_modref->ldr.FullDllName.Buffer),
                      (void *)thunk_list->u1.Function );
@@ -746,8 +1661,15 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
     }
 
 done:
+    if (cache) import_cache_record( cache, wmImp, first_thunk, count );
     /* restore old protection of the import address table */
     NtProtectVirtualMemory( NtCurrentProcess(), &protect_base, &protect_size, protect_old, &protect_old );
+    if (loader_profile_enabled)
+    {
+        char args[32];
+        sprintf( args, "\"imports\":%u", count );
+        profile_event( "resolve", wmImp->ldr.BaseDllName.Buffer, args, &start );
+    }
     *pwm = wmImp;
     return TRUE;
 }
@@ -974,11 +1896,15 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     DWORD size;
     NTSTATUS status;
     ULONG_PTR cookie;
+    LARGE_INTEGER start;
+    struct import_cache cache_data, *cache = NULL, *prev_cache;
 
     if (!(wm->ldr.Flags & LDR_DONT_RESOLVE_REFS)) return STATUS_SUCCESS;  /* already done */
     wm->ldr.Flags &= ~LDR_DONT_RESOLVE_REFS;
 
+    profile_begin( &start );
     wm->ldr.TlsIndex = alloc_tls_slot( &wm->ldr );
+    if (wm->ldr.TlsIndex != -1) profile_event( "tls", wm->ldr.BaseDllName.Buffer, NULL, &start );
 
     if (!(imports = RtlImageDirectoryEntryToData( wm->ldr.BaseAddress, TRUE,
                                                   IMAGE_DIRECTORY_ENTRY_IMPORT, &size )))
@@ -996,11 +1922,16 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
     wm->nDeps = nb_imports;
     wm->deps  = RtlAllocateHeap( GetProcessHeap(), 0, nb_imports*sizeof(WINE_MODREF *) );
 
+    if (import_cache_enabled && open_import_cache( &cache_data, wm )) cache = &cache_data;
+    prefetch_imports( wm, imports, nb_imports, load_path );
+
     /* load the imported modules. They are automatically
      * added to the modref list of the process.
      */
     prev = current_modref;
     current_modref = wm;
+    prev_cache = current_import_cache;
+    current_import_cache = cache;
     status = STATUS_SUCCESS;
     for (i = 0; i < nb_imports; i++)
     {
@@ -1011,12 +1942,132 @@ static NTSTATUS fixup_imports( WINE_MODREF *wm, LPCWSTR load_path )
         }
         wm->deps[i] = imp;
     }
+    current_import_cache = prev_cache;
     current_modref = prev;
+    if (cache)
+    {
+        if (status) cache->cacheable = FALSE;
+        close_import_cache( cache );
+    }
     if (wm->ldr.ActivationContext) RtlDeactivateActivationContext( 0, cookie );
     return status;
 }
 
 
+/* sorted snapshot of the loaded module ranges, for lock-free address lookups */
+struct module_range
+{
+    ULONG_PTR    base;
+    ULONG_PTR    end;
+    LDR_MODULE  *module;
+};
+
+struct module_table
+{
+    struct module_table *next;       /* next retired table */
+    unsigned int         count;
+    struct module_range  ranges[1];
+};
+
+static struct module_table * volatile module_table;  /* current table */
+static struct module_table *retired_module_tables;   /* tables waiting for readers to drain */
+static LONG module_table_readers;                    /* number of lookups in progress */
+static LONG module_table_generation;                 /* bumped on every change */
+
+/*************************************************************************
+ *		update_module_table
+ *
+ * Rebuild the module range table after the memory order list changed.
+ * The loader_section must be held.
+ */
+static void update_module_table(void)
+{
+    PLIST_ENTRY mark = &NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList, entry;
+    struct module_table *table, *old, *next;
+    unsigned int i, count = 0;
+
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink) count++;
+
+    if (!(table = RtlAllocateHeap( GetProcessHeap(), 0,
+                                   FIELD_OFFSET( struct module_table, ranges[count ? count : 1] ))))
+        return;
+    table->next = NULL;
+    table->count = 0;
+    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+    {
+        LDR_MODULE *mod = CONTAINING_RECORD( entry, LDR_MODULE, InMemoryOrderModuleList );
+        ULONG_PTR base = (ULONG_PTR)mod->BaseAddress;
+
+        /* insertion sort, the list is mostly in load order anyway */
+        for (i = table->count; i > 0 && table->ranges[i - 1].base > base; i--)
+            table->ranges[i] = table->ranges[i - 1];
+        table->ranges[i].base   = base;
+        table->ranges[i].end    = base + mod->SizeOfImage;
+        table->ranges[i].module = mod;
+        table->count++;
+    }
+
+    old = interlocked_xchg_ptr( (void **)&module_table, table );
+    interlocked_xchg_add( &module_table_generation, 1 );
+    if (old)
+    {
+        old->next = retired_module_tables;
+        retired_module_tables = old;
+    }
+    if (!module_table_readers)
+    {
+        for (old = retired_module_tables; old; old = next)
+        {
+            next = old->next;
+            RtlFreeHeap( GetProcessHeap(), 0, old );
+        }
+        retired_module_tables = NULL;
+    }
+}
+
+/*************************************************************************
+ *		find_module_range
+ *
+ * Find the module containing an address without taking the loader lock.
+ */
+static LDR_MODULE *find_module_range( const void *addr )
+{
+    struct module_table *table;
+    LDR_MODULE *ret = NULL;
+    int min, max, pos;
+
+    interlocked_xchg_add( &module_table_readers, 1 );
+    if ((table = module_table))
+    {
+        min = 0;
+        max = table->count - 1;
+        while (min <= max)
+        {
+            pos = (min + max) / 2;
+            if ((ULONG_PTR)addr < table->ranges[pos].base) max = pos - 1;
+            else if ((ULONG_PTR)addr >= table->ranges[pos].end) min = pos + 1;
+            else
+            {
+                ret = table->ranges[pos].module;
+                break;
+            }
+        }
+    }
+    interlocked_xchg_add( &module_table_readers, -1 );
+    return ret;
+}
+
+/*************************************************************************
+ *		get_module_generation
+ *
+ * Return a counter that changes whenever a module is loaded or unloaded.
+ */
+LONG get_module_generation(void)
+{
+    return module_table_generation;
+}
+
+
 /*************************************************************************
  *		alloc_module
  *
@@ -1054,6 +2105,7 @@ static WINE_MODREF *alloc_module( HMODULE hModule, LPCWSTR filename )
                    &wm->ldr.InLoadOrderModuleList);
     InsertTailList(&NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList,
                    &wm->ldr.InMemoryOrderModuleList);
+    update_module_table();
     /* wait until init is called for inserting into InInitializationOrderModuleList */
 
     if (!(nt->OptionalHeader.DllCharacteristics & IMAGE_DLLCHARACTERISTICS_NX_COMPAT))
@@ -1155,6 +2207,7 @@ static NTSTATUS MODULE_InitDLL( WINE_MODREF *wm, UINT reason, LPVOID lpReserved
     DLLENTRYPROC entry = wm->ldr.EntryPoint;
     void *module = wm->ldr.BaseAddress;
     BOOL retv = FALSE;
+    LARGE_INTEGER start;
 
     /* Skip calls for modules loaded with special load flags */
 
@@ -1162,17 +2215,19 @@ static NTSTATUS MODULE_InitDLL( WINE_MODREF *wm, UINT reason, LPVOID lpReserved
     if (wm->ldr.TlsIndex != -1) call_tls_callbacks( wm->ldr.BaseAddress, reason );
     if (!entry || !(wm->ldr.Flags & LDR_IMAGE_IS_DLL)) return STATUS_SUCCESS;
 
-    if (TRACE_ON(relay))
+    if (TRACE_ON(relay) || loader_profile_enabled)
     {
         size_t len = min( wm->ldr.BaseDllName.Length, sizeof(mod_name)-sizeof(WCHAR) );
         memcpy( mod_name, wm->ldr.BaseDllName.Buffer, len );
         mod_name[len / sizeof(WCHAR)] = 0;
+    }
+    if (TRACE_ON(relay))
         TRACE_(relay)("\1Call PE DLL (proc=%p,module=%p %s,reason=%s,res=%p)\n",
                       entry, module, debugstr_w(mod_name), reason_names[reason], lpReserved );
-    }
     else TRACE("(%p %s,%s,%p) - CALL\n", module, debugstr_w(wm->ldr.BaseDllName.Buffer),
                reason_names[reason], lpReserved );
 
+    profile_begin( &start );
     __TRY
     {
         retv = call_dll_entry_point( entry, module, reason, lpReserved );
@@ -1187,6 +2242,13 @@ static NTSTATUS MODULE_InitDLL( WINE_MODREF *wm, UINT reason, LPVOID lpReserved
     }
     __ENDTRY
 
+    if (loader_profile_enabled)
+    {
+        char args[48];
+        sprintf( args, "\"reason\":\"%s\"", reason_names[reason] );
+        profile_event( "DllMain", mod_name, args, &start );
+    }
+
     /* The state of the module list may have changed due to the call
        to the dll. We cannot assume that this module has not been
        deleted.  */
@@ -1401,28 +2463,33 @@ NTSTATUS WINAPI LdrDisableThreadCalloutsForDll(HMODULE hModule)
     return ret;
 }
 
+/***********************************************************************
+ *           loader_profile_server_call
+ *
+ * Record a server round-trip made while loading or initializing modules.
+ */
+void loader_profile_server_call( unsigned int req, const LARGE_INTEGER *start )
+{
+    char args[32];
+
+    if (loader_section.OwningThread != ULongToHandle( GetCurrentThreadId() )) return;
+    sprintf( args, "\"request\":%u", req );
+    profile_event( "server", NULL, args, start );
+}
+
+
 /******************************************************************
  *              LdrFindEntryForAddress (NTDLL.@)
  *
- * The loader_section must be locked while calling this function
+ * The loader_section doesn't need to be held, lookups use the module range table.
  */
 NTSTATUS WINAPI LdrFindEntryForAddress(const void* addr, PLDR_MODULE* pmod)
 {
-    PLIST_ENTRY mark, entry;
     PLDR_MODULE mod;
 
-    mark = &NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList;
-    for (entry = mark->Flink; entry != mark; entry = entry->Flink)
-    {
-        mod = CONTAINING_RECORD(entry, LDR_MODULE, InMemoryOrderModuleList);
-        if (mod->BaseAddress <= addr &&
-            (const char *)addr < (char*)mod->BaseAddress + mod->SizeOfImage)
-        {
-            *pmod = mod;
-            return STATUS_SUCCESS;
-        }
-    }
-    return STATUS_NO_MORE_ENTRIES;
+    if (!(mod = find_module_range( addr ))) return STATUS_NO_MORE_ENTRIES;
+    *pmod = mod;
+    return STATUS_SUCCESS;
 }
 
 /******************************************************************
@@ -1673,6 +2740,7 @@ static void load_builtin_callback( void *module, const char *filename )
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
             RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+            update_module_table();
             /* FIXME: free the modref */
             builtin_load_info->status = STATUS_DLL_NOT_FOUND;
             return;
@@ -1802,6 +2870,8 @@ static NTSTATUS perform_relocations( void *module, SIZE_T len )
     end = get_rva( module, relocs->VirtualAddress + relocs->Size );
     delta = (char *)module - base;
 
+    if (perform_relocations_parallel( module, len, rel, end, delta )) rel = end;
+
     while (rel < end - 1 && rel->SizeOfBlock)
     {
         if (rel->VirtualAddress >= len)
@@ -1870,9 +2940,12 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
     WINE_MODREF *wm;
     NTSTATUS status;
     pe_image_info_t image_info;
+    LARGE_INTEGER start;
+    BOOL relocated = FALSE;
 
     TRACE("Trying native dll %s\n", debugstr_w(name));
 
+    profile_begin( &start );
     size.QuadPart = 0;
     status = NtCreateSection( &mapping, STANDARD_RIGHTS_REQUIRED | SECTION_QUERY |
                               SECTION_MAP_READ | SECTION_MAP_EXECUTE,
@@ -1880,8 +2953,10 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
     if (status != STATUS_SUCCESS) return status;
 
     module = NULL;
-    status = virtual_map_section( mapping, &module, 0, 0, NULL, &len, PAGE_EXECUTE_READ, &image_info );
+    status = virtual_map_section( mapping, &module, 0, 0, NULL, &len, PAGE_EXECUTE_READ,
+                                  &image_info, &relocated );
     NtClose( mapping );
+    profile_event( "map", name, NULL, &start );
 
     if ((status == STATUS_SUCCESS || status == STATUS_IMAGE_NOT_AT_BASE) &&
         !is_valid_binary( module, &image_info ))
@@ -1893,7 +2968,16 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
     /* perform base relocation, if necessary */
 
     if (status == STATUS_IMAGE_NOT_AT_BASE)
-        status = perform_relocations( module, len );
+    {
+        if (relocated) status = STATUS_SUCCESS;  /* pages relocated by another process */
+        else
+        {
+            profile_begin( &start );
+            status = perform_relocations( module, len );
+            profile_event( "relocate", name, NULL, &start );
+            if (status == STATUS_SUCCESS) virtual_share_image_relocations( module );
+        }
+    }
 
     if (status != STATUS_SUCCESS)
     {
@@ -1929,6 +3013,7 @@ static NTSTATUS load_native_dll( LPCWSTR load_path, LPCWSTR name, HANDLE file,
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
             RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+            update_module_table();
 
             /* FIXME: there are several more dangling references
              * left. Including dlls loaded by this dll before the
@@ -1975,6 +3060,7 @@ static NTSTATUS load_builtin_dll( LPCWSTR load_path, LPCWSTR path, HANDLE file,
     DWORD len, i;
     void *handle;
     struct builtin_load_info info, *prev_info;
+    LARGE_INTEGER start;
 
     /* Fix the name in case we have a full path and extension */
     name = path;
@@ -2009,7 +3095,9 @@ static NTSTATUS load_builtin_dll( LPCWSTR load_path, LPCWSTR path, HANDLE file,
         prev_info = builtin_load_info;
         info.filename = nt_name.Buffer + 4;  /* skip \??\ */
         builtin_load_info = &info;
+        profile_begin( &start );
         handle = wine_dlopen( unix_name.Buffer, RTLD_NOW, error, sizeof(error) );
+        profile_event( "map", path, NULL, &start );
         builtin_load_info = prev_info;
         RtlFreeUnicodeString( &nt_name );
         RtlFreeHeap( GetProcessHeap(), 0, unix_name.Buffer );
@@ -2037,7 +3125,9 @@ static NTSTATUS load_builtin_dll( LPCWSTR load_path, LPCWSTR path, HANDLE file,
 
         prev_info = builtin_load_info;
         builtin_load_info = &info;
+        profile_begin( &start );
         handle = wine_dll_load( dllname, error, sizeof(error), &file_exists );
+        if (handle) profile_event( "map", name, NULL, &start );
         builtin_load_info = prev_info;
         if (!handle)
         {
@@ -2348,9 +3438,11 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
     struct stat st;
     HANDLE handle;
     NTSTATUS nts;
+    LARGE_INTEGER start, load_start;
 
     TRACE( "looking for %s in %s\n", debugstr_w(libname), debugstr_w(load_path) );
 
+    profile_begin( &start );
     *pwm = NULL;
     filename = buffer;
     size = sizeof(buffer);
@@ -2363,6 +3455,8 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
         /* grow the buffer and retry */
         if (!(filename = RtlAllocateHeap( GetProcessHeap(), 0, size ))) return STATUS_NO_MEMORY;
     }
+    if (!*pwm) profile_event( "search", filename, NULL, &start );
+    profile_begin( &load_start );
 
     if (*pwm)  /* found already loaded module */
     {
@@ -2433,6 +3527,8 @@ static NTSTATUS load_dll( LPCWSTR load_path, LPCWSTR libname, DWORD flags, WINE_
         TRACE("Loaded module %s (%s) at %p\n", debugstr_w(filename),
               ((*pwm)->ldr.Flags & LDR_WINE_INTERNAL) ? "builtin" : "native",
               (*pwm)->ldr.BaseAddress);
+        profile_event( "load", filename, ((*pwm)->ldr.Flags & LDR_WINE_INTERNAL) ?
+                       "\"type\":\"builtin\"" : "\"type\":\"native\"", &load_start );
         if (handle) NtClose( handle );
         if (filename != buffer) RtlFreeHeap( GetProcessHeap(), 0, filename );
         return nts;
@@ -2860,6 +3956,8 @@ void WINAPI LdrShutdownProcess(void)
     TRACE("()\n");
     process_detaching = TRUE;
     process_detach();
+    heap_dump_all_statistics();
+    lock_dump_statistics();
 }
 
 
@@ -2931,6 +4029,7 @@ static void free_modref( WINE_MODREF *wm )
 {
     RemoveEntryList(&wm->ldr.InLoadOrderModuleList);
     RemoveEntryList(&wm->ldr.InMemoryOrderModuleList);
+    update_module_table();
     if (wm->ldr.InInitializationOrderModuleList.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderModuleList);
 
@@ -3247,6 +4346,7 @@ void WINAPI LdrInitializeThunk( void *kernel_start, ULONG_PTR unknown2,
     if (!peb->ProcessParameters->WindowTitle.Buffer)
         peb->ProcessParameters->WindowTitle = wm->ldr.FullDllName;
     version_init( wm->ldr.FullDllName.Buffer );
+    init_critsection_spinning( wm->ldr.FullDllName.Buffer );
     virtual_set_large_address_space();
 
     LdrQueryImageFileExecutionOptions( &peb->ProcessParameters->ImagePathName, globalflagW,
@@ -3416,6 +4516,9 @@ void __wine_process_init(void)
     umask( FILE_umask );
 
     load_global_options();
+    init_loader_profile();
+    init_import_cache();
+    init_loader_threads();
 
     /* setup the load callback and create ntdll modref */
     wine_dll_set_callback( load_builtin_callback );
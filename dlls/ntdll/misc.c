@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <math.h>
 #ifdef HAVE_SYS_UTSNAME_H
@@ -359,15 +361,145 @@ HANDLE WINAPI WinSqmStartSession(GUID *sessionguid, DWORD sessionid, DWORD unkno
     return INVALID_HANDLE_VALUE;
 }
 
+/* ETW providers enabled through the WINEETW variable, a list of
+ * <provider guid>|*[:level[:keywords]] entries separated by commas.
+ * The events are stored in the WINEDEBUGLOG trace buffers. */
+
+struct etw_session_entry
+{
+    GUID      provider;
+    BOOL      any_provider;
+    UCHAR     level;
+    ULONGLONG keywords;
+};
+
+struct etw_provider
+{
+    GUID            guid;
+    PENABLECALLBACK callback;
+    void           *context;
+    BOOL            enabled;    /* only flag checked when the provider is disabled */
+    UCHAR           level;
+    ULONGLONG       keywords;
+};
+
+static struct etw_session_entry *etw_session;
+static unsigned int etw_session_count;
+static RTL_RUN_ONCE etw_session_once = RTL_RUN_ONCE_INIT;
+
+static BOOL parse_etw_guid( const char *str, GUID *guid )
+{
+    unsigned int data1, data2, data3, data4[8];
+    int i;
+
+    if (*str == '{') str++;
+    if (sscanf( str, "%8x-%4x-%4x-%2x%2x-%2x%2x%2x%2x%2x%2x", &data1, &data2, &data3,
+                &data4[0], &data4[1], &data4[2], &data4[3], &data4[4], &data4[5],
+                &data4[6], &data4[7] ) != 11)
+        return FALSE;
+    guid->Data1 = data1;
+    guid->Data2 = data2;
+    guid->Data3 = data3;
+    for (i = 0; i < 8; i++) guid->Data4[i] = data4[i];
+    return TRUE;
+}
+
+static DWORD WINAPI init_etw_session( RTL_RUN_ONCE *once, void *param, void **context )
+{
+    const char *env = getenv( "WINEETW" );
+    char *str, *entry, *next, *p;
+    unsigned int count = 1;
+
+    if (!env || !*env) return TRUE;
+    if (!debug_trace_enabled())
+    {
+        ERR( "WINEETW requires WINEDEBUGLOG to be set to the output directory\n" );
+        return TRUE;
+    }
+    for (p = (char *)env; *p; p++) if (*p == ',') count++;
+    if (!(str = RtlAllocateHeap( GetProcessHeap(), 0, strlen(env) + 1 ))) return TRUE;
+    if (!(etw_session = RtlAllocateHeap( GetProcessHeap(), 0, count * sizeof(*etw_session) )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, str );
+        return TRUE;
+    }
+    strcpy( str, env );
+
+    for (entry = str; entry; entry = next)
+    {
+        struct etw_session_entry *session = &etw_session[etw_session_count];
+
+        if ((next = strchr( entry, ',' ))) *next++ = 0;
+        memset( session, 0, sizeof(*session) );
+        session->level = EVENT_LEVEL_MAX;
+        session->keywords = ~(ULONGLONG)0;
+        if ((p = strchr( entry, ':' )))
+        {
+            *p++ = 0;
+            session->level = strtoul( p, &p, 0 );
+            if (*p == ':') session->keywords = strtoull( p + 1, NULL, 0 );
+        }
+        if (!strcmp( entry, "*" )) session->any_provider = TRUE;
+        else if (!parse_etw_guid( entry, &session->provider ))
+        {
+            ERR( "invalid provider %s in WINEETW\n", debugstr_a(entry) );
+            continue;
+        }
+        TRACE( "enabling %s level %u keywords %s\n", session->any_provider ? "all providers" :
+               debugstr_guid(&session->provider), session->level, wine_dbgstr_longlong(session->keywords) );
+        etw_session_count++;
+    }
+    RtlFreeHeap( GetProcessHeap(), 0, str );
+    return TRUE;
+}
+
+static inline struct etw_provider *get_etw_provider( REGHANDLE handle )
+{
+    return (struct etw_provider *)(ULONG_PTR)handle;
+}
+
+static inline BOOL etw_provider_enabled( const struct etw_provider *provider, UCHAR level, ULONGLONG keyword )
+{
+    if (!provider || !provider->enabled) return FALSE;
+    if (level && level > provider->level) return FALSE;
+    if (keyword && !(keyword & provider->keywords)) return FALSE;
+    return TRUE;
+}
+
 /******************************************************************************
  *                  EtwEventRegister (NTDLL.@)
  */
 ULONG WINAPI EtwEventRegister( LPCGUID provider, PENABLECALLBACK callback, PVOID context,
                 PREGHANDLE handle )
 {
-    FIXME("(%s, %p, %p, %p) stub.\n", debugstr_guid(provider), callback, context, handle);
+    static const GUID session_guid;
+    struct etw_provider *reg;
+    unsigned int i;
+
+    TRACE("(%s, %p, %p, %p)\n", debugstr_guid(provider), callback, context, handle);
+
+    if (!provider || !handle) return ERROR_INVALID_PARAMETER;
+    RtlRunOnceExecuteOnce( &etw_session_once, init_etw_session, NULL, NULL );
+
+    if (!(reg = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*reg) )))
+        return ERROR_NOT_ENOUGH_MEMORY;
+    reg->guid     = *provider;
+    reg->callback = callback;
+    reg->context  = context;
 
-    *handle = 0xdeadbeef;
+    for (i = 0; i < etw_session_count; i++)
+    {
+        if (!etw_session[i].any_provider && !IsEqualGUID( &etw_session[i].provider, provider )) continue;
+        reg->enabled  = TRUE;
+        reg->level    = etw_session[i].level;
+        reg->keywords = etw_session[i].keywords;
+        break;
+    }
+    *handle = (ULONG_PTR)reg;
+
+    if (reg->enabled && callback)
+        callback( &session_guid, EVENT_CONTROL_CODE_ENABLE_PROVIDER, reg->level,
+                  reg->keywords, 0, NULL, context );
     return ERROR_SUCCESS;
 }
 
@@ -376,7 +508,12 @@ ULONG WINAPI EtwEventRegister( LPCGUID provider, PENABLECALLBACK callback, PVOID
  */
 ULONG WINAPI EtwEventUnregister( REGHANDLE handle )
 {
-    FIXME("(%s) stub.\n", wine_dbgstr_longlong(handle));
+    struct etw_provider *provider = get_etw_provider( handle );
+
+    TRACE("(%s)\n", wine_dbgstr_longlong(handle));
+
+    if (!provider) return ERROR_INVALID_HANDLE;
+    RtlFreeHeap( GetProcessHeap(), 0, provider );
     return ERROR_SUCCESS;
 }
 
@@ -463,8 +600,34 @@ ULONG WINAPI EtwUnregisterTraceGuids( TRACEHANDLE RegistrationHandle )
  */
 BOOLEAN WINAPI EtwEventEnabled( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor )
 {
-    FIXME("(%s, %p): stub\n", wine_dbgstr_longlong(handle), descriptor);
-    return FALSE;
+    return etw_provider_enabled( get_etw_provider( handle ), descriptor->Level, descriptor->Keyword );
+}
+
+/******************************************************************************
+ *                  EtwEventProviderEnabled (NTDLL.@)
+ */
+BOOLEAN WINAPI EtwEventProviderEnabled( REGHANDLE handle, UCHAR level, ULONGLONG keyword )
+{
+    return etw_provider_enabled( get_etw_provider( handle ), level, keyword );
+}
+
+/******************************************************************************
+ *                  EtwEventWriteTransfer (NTDLL.@)
+ */
+ULONG WINAPI EtwEventWriteTransfer( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor,
+    const GUID *activity, const GUID *related, ULONG count, EVENT_DATA_DESCRIPTOR *data )
+{
+    struct etw_provider *provider = get_etw_provider( handle );
+
+    if (!provider) return ERROR_INVALID_HANDLE;
+    if (!etw_provider_enabled( provider, descriptor->Level, descriptor->Keyword )) return ERROR_SUCCESS;
+
+    TRACE("(%s, %p, %s, %s, %u, %p)\n", wine_dbgstr_longlong(handle), descriptor,
+          debugstr_guid(activity), debugstr_guid(related), count, data);
+
+    if (!debug_trace_event( &provider->guid, descriptor, activity, related, count, data ))
+        return ERROR_NOT_ENOUGH_MEMORY;
+    return ERROR_SUCCESS;
 }
 
 /******************************************************************************
@@ -473,6 +636,5 @@ BOOLEAN WINAPI EtwEventEnabled( REGHANDLE handle, const EVENT_DESCRIPTOR *descri
 ULONG WINAPI EtwEventWrite( REGHANDLE handle, const EVENT_DESCRIPTOR *descriptor, ULONG count,
     EVENT_DATA_DESCRIPTOR *data )
 {
-    FIXME("(%s, %p, %u, %p): stub\n", wine_dbgstr_longlong(handle), descriptor, count, data);
-    return ERROR_SUCCESS;
+    return EtwEventWriteTransfer( handle, descriptor, NULL, NULL, count, data );
 }
@@ -1493,6 +1493,75 @@ static inline BOOL logical_proc_info_add_group(SYSTEM_LOGICAL_PROCESSOR_INFORMAT
 }
 
 #ifdef linux
+/* read a cpu list like "0-3,8-11" from sysfs */
+static ULONG_PTR read_cpu_list( const char *name )
+{
+    ULONG_PTR mask = 0;
+    DWORD beg, end, i;
+    char op;
+    FILE *f;
+
+    if (!(f = fopen( name, "r" ))) return 0;
+    while (!feof( f ))
+    {
+        if (fscanf( f, "%u%c ", &beg, &op ) < 1) break;
+        if (op == '-') fscanf( f, "%u%c ", &end, &op );
+        else end = beg;
+        for (i = beg; i <= end && i < 8 * sizeof(ULONG_PTR); i++) mask |= (ULONG_PTR)1 << i;
+    }
+    fclose( f );
+    return mask;
+}
+
+/* set the SMT flag and the efficiency class of the processor cores */
+static void logical_proc_info_set_core_classes( SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *dataex, DWORD len )
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info;
+    DWORD capacity[8 * sizeof(ULONG_PTR)], pos, i;
+    ULONG_PTR big_cores = 0;
+    BOOL have_capacity = FALSE;
+    char name[MAX_PATH];
+    FILE *f;
+
+    /* asymmetric cpu capacity (ARM big.LITTLE), or Intel hybrid cpus exposing separate pmus */
+    for (i = 0; i < 8 * sizeof(ULONG_PTR); i++)
+    {
+        capacity[i] = 0;
+        sprintf( name, "/sys/devices/system/cpu/cpu%u/cpu_capacity", i );
+        if (!(f = fopen( name, "r" ))) continue;
+        if (fscanf( f, "%u", &capacity[i] ) == 1) have_capacity = TRUE;
+        fclose( f );
+    }
+    if (!have_capacity && read_cpu_list( "/sys/devices/cpu_atom/cpus" ))
+        big_cores = read_cpu_list( "/sys/devices/cpu_core/cpus" );
+
+    for (pos = 0; pos < len; pos += info->Size)
+    {
+        ULONG_PTR mask;
+        DWORD cpu, j, class = 0;
+
+        info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)dataex + pos);
+        if (info->Relationship != RelationProcessorCore) continue;
+        mask = info->u.Processor.GroupMask[0].Mask;
+        if (!mask) continue;
+        if (mask & (mask - 1)) info->u.Processor.Flags = LTP_PC_SMT;
+
+        for (cpu = 0; !(mask & ((ULONG_PTR)1 << cpu)); cpu++) ;
+        if (have_capacity)
+        {
+            /* the class is the number of distinct smaller capacities */
+            for (i = 0; i < 8 * sizeof(ULONG_PTR); i++)
+            {
+                if (!capacity[i] || capacity[i] >= capacity[cpu]) continue;
+                for (j = 0; j < i; j++) if (capacity[j] == capacity[i]) break;
+                if (j == i) class++;
+            }
+        }
+        else if (big_cores & mask) class = 1;
+        info->u.Processor.EfficiencyClass = class;
+    }
+}
+
 /* for 'data', max_len is the array count. for 'dataex', max_len is in bytes */
 static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **data,
         SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX **dataex, DWORD *max_len)
@@ -1680,7 +1749,10 @@ static NTSTATUS create_logical_proc_info(SYSTEM_LOGICAL_PROCESSOR_INFORMATION **
     }
 
     if(dataex)
+    {
+        logical_proc_info_set_core_classes(*dataex, len);
         logical_proc_info_add_group(dataex, &len, max_len, num_cpus, all_cpus_mask);
+    }
 
     if(data)
         *max_len = len * sizeof(**data);
@@ -2357,6 +2429,83 @@ NTSTATUS WINAPI NtQuerySystemInformation(
     return ret;
 }
 
+/* first processor of the mask */
+static inline BYTE first_processor( ULONG_PTR mask )
+{
+    BYTE i;
+
+    for (i = 0; i < 8 * sizeof(mask) - 1; i++) if (mask & ((ULONG_PTR)1 << i)) break;
+    return i;
+}
+
+/* build the cpu sets from the logical processor information, one set per logical processor */
+static NTSTATUS create_cpu_set_info( SYSTEM_CPU_SET_INFORMATION **info, DWORD *len )
+{
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *buf, *entry;
+    SYSTEM_CPU_SET_INFORMATION *set;
+    DWORD buf_len, pos, count = 0, i;
+    NTSTATUS ret;
+
+    buf_len = 3 * sizeof(*buf);
+    if (!(buf = RtlAllocateHeap( GetProcessHeap(), 0, buf_len ))) return STATUS_NO_MEMORY;
+    if ((ret = create_logical_proc_info( NULL, &buf, &buf_len )))
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, buf );
+        return ret;
+    }
+
+    *info = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, 8 * sizeof(ULONG_PTR) * sizeof(**info) );
+    if (!*info)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, buf );
+        return STATUS_NO_MEMORY;
+    }
+
+    for (pos = 0; pos < buf_len; pos += entry->Size)
+    {
+        entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)buf + pos);
+        if (entry->Relationship != RelationProcessorCore) continue;
+        for (i = 0; i < 8 * sizeof(ULONG_PTR); i++)
+        {
+            if (!(entry->u.Processor.GroupMask[0].Mask & ((ULONG_PTR)1 << i))) continue;
+            set = &(*info)[count++];
+            set->Size = sizeof(*set);
+            set->Type = CpuSetInformation;
+            set->u.CpuSet.Id = 0x100 + i;
+            set->u.CpuSet.Group = 0;
+            set->u.CpuSet.LogicalProcessorIndex = i;
+            set->u.CpuSet.CoreIndex = first_processor( entry->u.Processor.GroupMask[0].Mask );
+            set->u.CpuSet.LastLevelCacheIndex = i;
+            set->u.CpuSet.EfficiencyClass = entry->u.Processor.EfficiencyClass;
+        }
+    }
+
+    /* fill in the node and the last level cache of each set */
+    for (i = 0; i < count; i++)
+    {
+        ULONG_PTR bit = (ULONG_PTR)1 << (*info)[i].u.CpuSet.LogicalProcessorIndex;
+        BYTE level = 0;
+
+        set = &(*info)[i];
+        for (pos = 0; pos < buf_len; pos += entry->Size)
+        {
+            entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)buf + pos);
+            if (entry->Relationship == RelationNumaNode && (entry->u.NumaNode.GroupMask.Mask & bit))
+                set->u.CpuSet.NumaNodeIndex = entry->u.NumaNode.NodeNumber;
+            else if (entry->Relationship == RelationCache && (entry->u.Cache.GroupMask.Mask & bit) &&
+                     entry->u.Cache.Type != CacheInstruction && entry->u.Cache.Level > level)
+            {
+                level = entry->u.Cache.Level;
+                set->u.CpuSet.LastLevelCacheIndex = first_processor( entry->u.Cache.GroupMask.Mask );
+            }
+        }
+    }
+
+    RtlFreeHeap( GetProcessHeap(), 0, buf );
+    *len = count * sizeof(**info);
+    return STATUS_SUCCESS;
+}
+
 /******************************************************************************
  * NtQuerySystemInformationEx [NTDLL.@]
  * ZwQuerySystemInformationEx [NTDLL.@]
@@ -2381,9 +2530,6 @@ NTSTATUS WINAPI NtQuerySystemInformationEx(SYSTEM_INFORMATION_CLASS SystemInform
                 break;
             }
 
-            if (*(DWORD*)Query != RelationAll)
-                FIXME("Relationship filtering not implemented: 0x%x\n", *(DWORD*)Query);
-
             len = 3 * sizeof(*buf);
             buf = RtlAllocateHeap(GetProcessHeap(), 0, len);
             if (!buf)
@@ -2399,6 +2545,23 @@ NTSTATUS WINAPI NtQuerySystemInformationEx(SYSTEM_INFORMATION_CLASS SystemInform
                 break;
             }
 
+            if (*(DWORD*)Query != RelationAll)
+            {
+                /* keep only the entries of the requested relationship */
+                SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *entry;
+                ULONG pos, size, filtered = 0;
+
+                for (pos = 0; pos < len; pos += size)
+                {
+                    entry = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)buf + pos);
+                    size = entry->Size;
+                    if (entry->Relationship != *(DWORD*)Query) continue;
+                    memmove( (char *)buf + filtered, entry, size );
+                    filtered += size;
+                }
+                len = filtered;
+            }
+
             if (Length >= len)
             {
                 if (!SystemInformation)
@@ -2411,6 +2574,31 @@ NTSTATUS WINAPI NtQuerySystemInformationEx(SYSTEM_INFORMATION_CLASS SystemInform
 
             RtlFreeHeap(GetProcessHeap(), 0, buf);
 
+            break;
+        }
+    case SystemCpuSetInformation:
+        {
+            SYSTEM_CPU_SET_INFORMATION *info;
+
+            if (!Query || QueryLength < sizeof(HANDLE))
+            {
+                ret = STATUS_INVALID_PARAMETER;
+                break;
+            }
+
+            if ((ret = create_cpu_set_info( &info, &len ))) break;
+
+            if (Length >= len)
+            {
+                if (!SystemInformation)
+                    ret = STATUS_ACCESS_VIOLATION;
+                else
+                    memcpy( SystemInformation, info, len );
+            }
+            else
+                ret = STATUS_BUFFER_TOO_SMALL;
+
+            RtlFreeHeap( GetProcessHeap(), 0, info );
             break;
         }
     default:
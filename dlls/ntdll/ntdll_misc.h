@@ -72,13 +72,27 @@ extern void signal_start_process( LPTHREAD_START_ROUTINE entry, BOOL suspend ) D
 extern void DECLSPEC_NORETURN signal_exit_thread( int status ) DECLSPEC_HIDDEN;
 extern void DECLSPEC_NORETURN signal_exit_process( int status ) DECLSPEC_HIDDEN;
 extern void version_init( const WCHAR *appname ) DECLSPEC_HIDDEN;
+extern void init_critsection_spinning( const WCHAR *appname ) DECLSPEC_HIDDEN;
+extern void record_lock_contention( const void *lock, const char *name,
+                                    const LARGE_INTEGER *start ) DECLSPEC_HIDDEN;
+extern void lock_dump_statistics(void) DECLSPEC_HIDDEN;
 extern void debug_init(void) DECLSPEC_HIDDEN;
+extern void debug_exit_thread(void) DECLSPEC_HIDDEN;
+struct _EVENT_DESCRIPTOR;
+struct _EVENT_DATA_DESCRIPTOR;
+extern BOOL debug_trace_enabled(void) DECLSPEC_HIDDEN;
+extern BOOL debug_trace_event( const GUID *provider, const struct _EVENT_DESCRIPTOR *descriptor,
+                               const GUID *activity, const GUID *related, ULONG count,
+                               const struct _EVENT_DATA_DESCRIPTOR *data ) DECLSPEC_HIDDEN;
 extern HANDLE thread_init(void) DECLSPEC_HIDDEN;
 extern void actctx_init(void) DECLSPEC_HIDDEN;
 extern void virtual_init(void) DECLSPEC_HIDDEN;
 extern void virtual_init_threading(void) DECLSPEC_HIDDEN;
 extern void fill_cpu_info(void) DECLSPEC_HIDDEN;
+extern void init_performance_counter(void) DECLSPEC_HIDDEN;
+extern void init_shared_user_data_time(void) DECLSPEC_HIDDEN;
 extern void heap_set_debug_flags( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void heap_dump_all_statistics(void) DECLSPEC_HIDDEN;
 
 /* server support */
 extern timeout_t server_start_time DECLSPEC_HIDDEN;
@@ -87,6 +101,7 @@ extern BOOL is_wow64 DECLSPEC_HIDDEN;
 extern void server_init_process(void) DECLSPEC_HIDDEN;
 extern void server_init_process_done(void) DECLSPEC_HIDDEN;
 extern size_t server_init_thread( void *entry_point, BOOL *suspend ) DECLSPEC_HIDDEN;
+extern void server_exit_shm_request(void) DECLSPEC_HIDDEN;
 extern void DECLSPEC_NORETURN abort_thread( int status ) DECLSPEC_HIDDEN;
 extern void DECLSPEC_NORETURN exit_thread( int status ) DECLSPEC_HIDDEN;
 extern sigset_t server_block_set DECLSPEC_HIDDEN;
@@ -96,7 +111,10 @@ extern void server_leave_uninterrupted_section( RTL_CRITICAL_SECTION *cs, sigset
 extern unsigned int server_select( const select_op_t *select_op, data_size_t size,
                                    UINT flags, const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
 extern unsigned int server_queue_process_apc( HANDLE process, const apc_call_t *call, apc_result_t *result ) DECLSPEC_HIDDEN;
+extern RTL_CRITICAL_SECTION fd_cache_section DECLSPEC_HIDDEN;
 extern int server_remove_fd_from_cache( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void server_receive_handle_fd( HANDLE handle, enum server_fd_type type,
+                                      unsigned int access, unsigned int options ) DECLSPEC_HIDDEN;
 extern int server_get_unix_fd( HANDLE handle, unsigned int access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
 extern int server_pipe( int fd[2] ) DECLSPEC_HIDDEN;
@@ -104,9 +122,38 @@ extern NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct o
                                          data_size_t *ret_len ) DECLSPEC_HIDDEN;
 extern NTSTATUS validate_open_object_attributes( const OBJECT_ATTRIBUTES *attr ) DECLSPEC_HIDDEN;
 
+/* in-process synchronization objects */
+extern BOOL fast_sync_is_eligible( const OBJECT_ATTRIBUTES *attr, ACCESS_MASK access,
+                                   ACCESS_MASK needed ) DECLSPEC_HIDDEN;
+extern void fast_sync_add_event( HANDLE handle, EVENT_TYPE type, BOOLEAN initial ) DECLSPEC_HIDDEN;
+extern void fast_sync_add_semaphore( HANDLE handle, ULONG initial, ULONG max ) DECLSPEC_HIDDEN;
+extern void fast_sync_add_mutex( HANDLE handle, BOOLEAN owned ) DECLSPEC_HIDDEN;
+extern void fast_sync_close( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void fast_sync_flush( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void fast_sync_duplicate( HANDLE source, HANDLE dest, BOOL closed ) DECLSPEC_HIDDEN;
+extern void fast_sync_thread_exit(void) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_set_event( HANDLE handle ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_reset_event( HANDLE handle ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_pulse_event( HANDLE handle ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_query_event( HANDLE handle, EVENT_BASIC_INFORMATION *info ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_release_semaphore( HANDLE handle, ULONG count, ULONG *previous ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_query_semaphore( HANDLE handle, SEMAPHORE_BASIC_INFORMATION *info ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_release_mutex( HANDLE handle, LONG *prev_count ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_query_mutex( HANDLE handle, MUTANT_BASIC_INFORMATION *info ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any, BOOLEAN alertable,
+                                const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
+extern NTSTATUS fast_sync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
+                                           const LARGE_INTEGER *timeout ) DECLSPEC_HIDDEN;
+
+/* registry */
+extern void reg_cache_close_handle( HANDLE handle ) DECLSPEC_HIDDEN;
+
 /* module handling */
 extern LIST_ENTRY tls_links DECLSPEC_HIDDEN;
 extern NTSTATUS attach_dlls( CONTEXT *context, void **entry ) DECLSPEC_HIDDEN;
+extern LONG get_module_generation(void) DECLSPEC_HIDDEN;
+extern BOOL loader_profile_enabled DECLSPEC_HIDDEN;
+extern void loader_profile_server_call( unsigned int req, const LARGE_INTEGER *start ) DECLSPEC_HIDDEN;
 extern FARPROC RELAY_GetProcAddress( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                      DWORD exp_size, FARPROC proc, DWORD ordinal, const WCHAR *user ) DECLSPEC_HIDDEN;
 extern FARPROC SNOOP_GetProcAddress( HMODULE hmod, const IMAGE_EXPORT_DIRECTORY *exports, DWORD exp_size,
@@ -164,11 +211,19 @@ extern NTSTATUS file_id_to_unix_file_name( const OBJECT_ATTRIBUTES *attr, ANSI_S
 extern NTSTATUS nt_to_unix_file_name_attr( const OBJECT_ATTRIBUTES *attr, ANSI_STRING *unix_name_ret,
                                            UINT disposition ) DECLSPEC_HIDDEN;
 
+/* io_uring */
+struct iovec;
+extern NTSTATUS uring_submit_rw( HANDLE handle, int fd, BOOL write, const struct iovec *iov, unsigned int count,
+                                 ULONGLONG offset, HANDLE event, ULONG_PTR cvalue,
+                                 IO_STATUS_BLOCK *io ) DECLSPEC_HIDDEN;
+
 /* virtual memory */
 extern NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, SIZE_T commit_size,
                                      const LARGE_INTEGER *offset_ptr, SIZE_T *size_ptr, ULONG protect,
-                                     pe_image_info_t *image_info ) DECLSPEC_HIDDEN;
+                                     pe_image_info_t *image_info, BOOL *relocated ) DECLSPEC_HIDDEN;
+extern void virtual_share_image_relocations( void *module ) DECLSPEC_HIDDEN;
 extern void virtual_get_system_info( SYSTEM_BASIC_INFORMATION *info ) DECLSPEC_HIDDEN;
+extern SIZE_T virtual_get_large_page_size(void) DECLSPEC_HIDDEN;
 extern NTSTATUS virtual_create_builtin_view( void *base ) DECLSPEC_HIDDEN;
 extern NTSTATUS virtual_alloc_thread_stack( TEB *teb, SIZE_T reserve_size,
                                             SIZE_T commit_size, SIZE_T *pthread_size ) DECLSPEC_HIDDEN;
@@ -221,6 +276,7 @@ struct debug_info
     char *out_pos;       /* current position in output buffer */
     char  strings[1024]; /* buffer for temporary strings */
     char  output[1024];  /* current output line */
+    struct trace_ring_header *trace_ring; /* binary trace buffer */
 };
 
 /* thread private data, stored in NtCurrentTeb()->GdiTebBatch */
@@ -233,6 +289,8 @@ struct ntdll_thread_data
     int                wait_fd[2];    /* fd for sleeping server requests */
     BOOL               wow64_redir;   /* Wow64 filesystem redirection flag */
     pthread_t          pthread_id;    /* pthread thread id */
+    struct shm_request_area *shm_area; /* shared memory area for server requests */
+    int                doorbell_fd;   /* fd to wake up the server when it sleeps */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -353,7 +353,13 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
                                    HANDLE dest_process, PHANDLE dest,
                                    ACCESS_MASK access, ULONG attributes, ULONG options )
 {
+    BOOL local = (source_process == NtCurrentProcess() && dest_process == NtCurrentProcess() &&
+                  !(attributes & OBJ_INHERIT));
     NTSTATUS ret;
+
+    /* in-process objects can only be shared within the process */
+    if (source_process == NtCurrentProcess() && !local) fast_sync_flush( source );
+
     SERVER_START_REQ( dup_handle )
     {
         req->src_process = wine_server_obj_handle( source_process );
@@ -370,7 +376,10 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source,
             {
                 int fd = server_remove_fd_from_cache( source );
                 if (fd != -1) close( fd );
+                reg_cache_close_handle( source );
             }
+            if (source_process == NtCurrentProcess())
+                fast_sync_duplicate( source, local && dest ? *dest : NULL, reply->closed && reply->self );
         }
     }
     SERVER_END_REQ;
@@ -383,6 +392,9 @@ NTSTATUS close_handle( HANDLE handle )
     NTSTATUS ret;
     int fd = server_remove_fd_from_cache( handle );
 
+    fast_sync_close( handle );
+    reg_cache_close_handle( handle );
+
     SERVER_START_REQ( close_handle )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -492,6 +504,85 @@ NTSTATUS WINAPI NtCreateDirectoryObject(PHANDLE DirectoryHandle, ACCESS_MASK Des
     return ret;
 }
 
+#define DIR_ENTRY_BATCH     16   /* number of entries fetched per server round-trip */
+#define DIR_ENTRY_MAX_SIZE  1024 /* space for the names of a single entry */
+
+/* fill a buffer with as many directory entries as possible, fetching them in batches */
+static NTSTATUS query_directory_entries( HANDLE handle, DIRECTORY_BASIC_INFORMATION *buffer,
+                                         ULONG size, ULONG *context, ULONG *ret_size )
+{
+    struct __server_request_info reqs[DIR_ENTRY_BATCH];
+    char *data, *strings;
+    ULONG count = 0, used = sizeof(*buffer);  /* the terminating entry */
+    NTSTATUS ret = STATUS_SUCCESS;
+    unsigned int i;
+
+    if (!(data = RtlAllocateHeap( GetProcessHeap(), 0, DIR_ENTRY_BATCH * DIR_ENTRY_MAX_SIZE )))
+        return STATUS_NO_MEMORY;
+
+    size &= ~(sizeof(WCHAR) - 1);
+    strings = (char *)buffer + size;
+
+    for (;;)
+    {
+        for (i = 0; i < DIR_ENTRY_BATCH; i++)
+        {
+            struct get_directory_entry_request *req = wine_server_init_req( &reqs[i], REQ_get_directory_entry );
+            req->handle = wine_server_obj_handle( handle );
+            req->index  = *context + count + i;
+            wine_server_set_reply( req, data + i * DIR_ENTRY_MAX_SIZE, DIR_ENTRY_MAX_SIZE );
+        }
+        wine_server_call_batch( reqs, DIR_ENTRY_BATCH, BATCH_STOP_ON_ERROR );
+
+        for (i = 0; i < DIR_ENTRY_BATCH; i++)
+        {
+            const struct get_directory_entry_reply *reply = &reqs[i].u.reply.get_directory_entry_reply;
+            const WCHAR *name = (const WCHAR *)(data + i * DIR_ENTRY_MAX_SIZE);
+            data_size_t name_len = reply->name_len;
+            data_size_t type_len = wine_server_reply_size( reply ) - name_len;
+            ULONG needed = sizeof(*buffer) + name_len + type_len + 2 * sizeof(WCHAR);
+
+            if ((ret = reply->__header.error))
+            {
+                if (ret == STATUS_NO_MORE_ENTRIES && count) ret = STATUS_SUCCESS;
+                goto done;
+            }
+            if (used + needed > size)
+            {
+                ret = count ? STATUS_MORE_ENTRIES : STATUS_BUFFER_OVERFLOW;
+                goto done;
+            }
+            used += needed;
+
+            /* names are stored from the end of the buffer */
+            strings -= type_len + sizeof(WCHAR);
+            buffer[count].ObjectTypeName.Buffer = (WCHAR *)strings;
+            buffer[count].ObjectTypeName.Length = type_len;
+            buffer[count].ObjectTypeName.MaximumLength = type_len + sizeof(WCHAR);
+            memcpy( strings, name + name_len / sizeof(WCHAR), type_len );
+            buffer[count].ObjectTypeName.Buffer[type_len / sizeof(WCHAR)] = 0;
+
+            strings -= name_len + sizeof(WCHAR);
+            buffer[count].ObjectName.Buffer = (WCHAR *)strings;
+            buffer[count].ObjectName.Length = name_len;
+            buffer[count].ObjectName.MaximumLength = name_len + sizeof(WCHAR);
+            memcpy( strings, name, name_len );
+            buffer[count].ObjectName.Buffer[name_len / sizeof(WCHAR)] = 0;
+            count++;
+        }
+    }
+
+done:
+    RtlFreeHeap( GetProcessHeap(), 0, data );
+    if (count)
+    {
+        memset( &buffer[count], 0, sizeof(*buffer) );
+        *context += count;
+    }
+    if (ret_size) *ret_size = used;
+    return ret;
+}
+
 /******************************************************************************
  * NtQueryDirectoryObject [NTDLL.@]
  * ZwQueryDirectoryObject [NTDLL.@]
@@ -548,11 +639,7 @@ NTSTATUS WINAPI NtQueryDirectoryObject(HANDLE handle, PDIRECTORY_BASIC_INFORMATI
         if (ret_size)
             *ret_size = buffer->ObjectName.MaximumLength + buffer->ObjectTypeName.MaximumLength + sizeof(*buffer);
     }
-    else
-    {
-        FIXME("multiple entries not implemented\n");
-        ret = STATUS_NOT_IMPLEMENTED;
-    }
+    else ret = query_directory_entries( handle, buffer, size, context, ret_size );
 
     return ret;
 }
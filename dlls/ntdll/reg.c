@@ -31,7 +31,14 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -523,6 +530,195 @@ NTSTATUS WINAPI NtEnumerateValueKey( HANDLE handle, ULONG index,
 }
 
 
+/* client-side cache of registry values, enabled by setting WINEREGCACHE=1.
+ * Entries are attached to the key handle they were read through, and
+ * validated against the generation counter of the key shared by the server. */
+
+#define REG_CACHE_BUCKETS   256
+#define REG_CACHE_MAX       2048  /* max number of cached values */
+#define REG_CACHE_MAX_DATA  1024  /* max size of a cached value */
+
+struct reg_cache_entry
+{
+    struct reg_cache_entry *next;
+    HANDLE                  key;         /* handle the value was read through */
+    unsigned int            slot;        /* slot of the key in the generation area */
+    unsigned int            generation;  /* generation of the key when it was read */
+    NTSTATUS                status;      /* STATUS_SUCCESS or STATUS_OBJECT_NAME_NOT_FOUND */
+    int                     type;
+    USHORT                  name_len;    /* in bytes */
+    DWORD                   data_len;
+    WCHAR                   name[1];     /* followed by the data */
+};
+
+static struct reg_cache_entry *reg_cache[REG_CACHE_BUCKETS];
+static unsigned int reg_cache_count;
+static const volatile unsigned int *key_generations;
+static int reg_cache_state;  /* 0: not initialized yet, 1: enabled, -1: disabled */
+
+static RTL_CRITICAL_SECTION reg_cache_section;
+static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
+{
+    0, 0, &reg_cache_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": reg_cache_section") }
+};
+static RTL_CRITICAL_SECTION reg_cache_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+static inline unsigned int reg_cache_hash( HANDLE key )
+{
+    return ((ULONG_PTR)key >> 2) % REG_CACHE_BUCKETS;
+}
+
+/* map the generation counters of the server; reg_cache_section must be held */
+static void init_reg_cache(void)
+{
+    const char *env = getenv( "WINEREGCACHE" );
+    obj_handle_t handle = 0;
+    int unix_fd, needs_close;
+    void *ptr;
+
+    reg_cache_state = -1;
+    if (!env || !atoi( env )) return;
+
+    SERVER_START_REQ( get_registry_generations )
+    {
+        if (!wine_server_call( req )) handle = reply->file;
+    }
+    SERVER_END_REQ;
+    if (!handle) return;
+
+    if (!server_get_unix_fd( wine_server_ptr_handle( handle ), FILE_READ_DATA, &unix_fd, &needs_close, NULL, NULL ))
+    {
+        ptr = mmap( NULL, REGISTRY_GENERATION_SLOTS * sizeof(*key_generations), PROT_READ, MAP_SHARED, unix_fd, 0 );
+        if (ptr != MAP_FAILED)
+        {
+            key_generations = ptr;
+            reg_cache_state = 1;
+        }
+        if (needs_close) close( unix_fd );
+    }
+    close_handle( wine_server_ptr_handle( handle ));
+}
+
+static inline BOOL reg_cache_enabled(void)
+{
+    if (!reg_cache_state)
+    {
+        RtlEnterCriticalSection( &reg_cache_section );
+        if (!reg_cache_state) init_reg_cache();
+        RtlLeaveCriticalSection( &reg_cache_section );
+    }
+    return reg_cache_state > 0;
+}
+
+/* unlink and free the entries matching a key handle, and a name if not NULL;
+ * reg_cache_section must be held */
+static void reg_cache_remove( HANDLE key, const UNICODE_STRING *name )
+{
+    struct reg_cache_entry **ptr = &reg_cache[reg_cache_hash( key )], *entry;
+
+    while ((entry = *ptr))
+    {
+        if (entry->key == key && (!name || (entry->name_len == name->Length &&
+            !memicmpW( entry->name, name->Buffer, name->Length / sizeof(WCHAR) ))))
+        {
+            *ptr = entry->next;
+            RtlFreeHeap( GetProcessHeap(), 0, entry );
+            reg_cache_count--;
+        }
+        else ptr = &entry->next;
+    }
+}
+
+/* look up a value; the data is copied to 'data', which holds REG_CACHE_MAX_DATA bytes */
+static BOOL reg_cache_lookup( HANDLE key, const UNICODE_STRING *name, NTSTATUS *status,
+                              int *type, void *data, DWORD *data_len )
+{
+    struct reg_cache_entry *entry;
+    BOOL found = FALSE;
+
+    if (!reg_cache_count) return FALSE;
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    for (entry = reg_cache[reg_cache_hash( key )]; entry; entry = entry->next)
+    {
+        if (entry->key != key || entry->name_len != name->Length) continue;
+        if (memicmpW( entry->name, name->Buffer, name->Length / sizeof(WCHAR) )) continue;
+        if (key_generations[entry->slot] == entry->generation)
+        {
+            *status   = entry->status;
+            *type     = entry->type;
+            *data_len = entry->data_len;
+            memcpy( data, (char *)entry->name + entry->name_len, entry->data_len );
+            found = TRUE;
+        }
+        else reg_cache_remove( key, name );  /* the key has been modified */
+        break;
+    }
+    RtlLeaveCriticalSection( &reg_cache_section );
+    return found;
+}
+
+/* add a value read from the server */
+static void reg_cache_add( HANDLE key, const UNICODE_STRING *name, NTSTATUS status, int type,
+                           const void *data, DWORD data_len, unsigned int slot, unsigned int generation )
+{
+    struct reg_cache_entry *entry;
+    unsigned int i, bucket;
+
+    if (slot >= REGISTRY_GENERATION_SLOTS || data_len > REG_CACHE_MAX_DATA) return;
+    if (!(entry = RtlAllocateHeap( GetProcessHeap(), 0, FIELD_OFFSET( struct reg_cache_entry, name ) +
+                                   name->Length + data_len )))
+        return;
+    entry->key        = key;
+    entry->slot       = slot;
+    entry->generation = generation;
+    entry->status     = status;
+    entry->type       = type;
+    entry->name_len   = name->Length;
+    entry->data_len   = data_len;
+    memcpy( entry->name, name->Buffer, name->Length );
+    memcpy( (char *)entry->name + name->Length, data, data_len );
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    if (reg_cache_count >= REG_CACHE_MAX)
+    {
+        for (i = 0; i < REG_CACHE_BUCKETS; i++)
+        {
+            struct reg_cache_entry *next, *ptr = reg_cache[i];
+            for ( ; ptr; ptr = next)
+            {
+                next = ptr->next;
+                RtlFreeHeap( GetProcessHeap(), 0, ptr );
+            }
+            reg_cache[i] = NULL;
+        }
+        reg_cache_count = 0;
+    }
+    reg_cache_remove( key, name );
+    bucket = reg_cache_hash( key );
+    entry->next = reg_cache[bucket];
+    reg_cache[bucket] = entry;
+    reg_cache_count++;
+    RtlLeaveCriticalSection( &reg_cache_section );
+}
+
+/***********************************************************************
+ *           reg_cache_close_handle
+ *
+ * Forget the values read through a handle that is being closed.
+ */
+void reg_cache_close_handle( HANDLE handle )
+{
+    if (!reg_cache_count) return;
+
+    RtlEnterCriticalSection( &reg_cache_section );
+    reg_cache_remove( handle, NULL );
+    RtlLeaveCriticalSection( &reg_cache_section );
+}
+
+
 /******************************************************************************
  * NtQueryValueKey [NTDLL.@]
  * ZwQueryValueKey [NTDLL.@]
@@ -536,7 +732,11 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
 {
     NTSTATUS ret;
     UCHAR *data_ptr;
-    unsigned int fixed_size, min_size;
+    unsigned int fixed_size, min_size, gen_slot = 0, generation = 0;
+    BOOL use_cache;
+    char data[REG_CACHE_MAX_DATA];
+    DWORD data_len;
+    int type = 0;
 
     TRACE( "(%p,%s,%d,%p,%d)\n", handle, debugstr_us(name), info_class, info, length );
 
@@ -574,13 +774,30 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         return STATUS_INVALID_PARAMETER;
     }
 
+    if ((use_cache = reg_cache_enabled()) &&
+        reg_cache_lookup( handle, name, &ret, &type, data, &data_len ))
+    {
+        if (ret) return ret;
+        copy_key_value_info( info_class, info, length, type, name->Length, data_len );
+        if (length > fixed_size && data_ptr) memcpy( data_ptr, data, min( length - fixed_size, data_len ));
+        *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : data_len);
+        if (length < min_size) return STATUS_BUFFER_TOO_SMALL;
+        if (length < *result_len) return STATUS_BUFFER_OVERFLOW;
+        return STATUS_SUCCESS;
+    }
+
     SERVER_START_REQ( get_key_value )
     {
         req->hkey = wine_server_obj_handle( handle );
         wine_server_add_data( req, name->Buffer, name->Length );
         if (length > fixed_size && data_ptr) wine_server_set_reply( req, data_ptr, length - fixed_size );
-        if (!(ret = wine_server_call( req )))
+        ret = wine_server_call( req );
+        gen_slot   = reply->gen_slot;
+        generation = reply->generation;
+        if (!ret)
         {
+            type = reply->type;
+            data_len = reply->total;
             copy_key_value_info( info_class, info, length, reply->type,
                                  name->Length, reply->total );
             *result_len = fixed_size + (info_class == KeyValueBasicInformation ? 0 : reply->total);
@@ -589,6 +806,15 @@ NTSTATUS WINAPI NtQueryValueKey( HANDLE handle, const UNICODE_STRING *name,
         }
     }
     SERVER_END_REQ;
+
+    if (use_cache)
+    {
+        /* only remember complete values */
+        if (ret == STATUS_OBJECT_NAME_NOT_FOUND)
+            reg_cache_add( handle, name, ret, 0, NULL, 0, gen_slot, generation );
+        else if (!ret && data_ptr && length >= fixed_size && length - fixed_size >= data_len)
+            reg_cache_add( handle, name, ret, type, data_ptr, data_len, gen_slot, generation );
+    }
     return ret;
 }
 
@@ -727,6 +953,8 @@ NTSTATUS WINAPI NtNotifyChangeMultipleKeys(
             return ret;
     }
 
+    fast_sync_flush( Event );
+
     SERVER_START_REQ( set_registry_notification )
     {
         req->hkey    = wine_server_obj_handle( KeyHandle );
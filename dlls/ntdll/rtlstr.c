@@ -26,6 +26,9 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -452,6 +455,42 @@ LONG WINAPI RtlCompareString( const STRING *s1, const STRING *s2, BOOLEAN CaseIn
 }
 
 
+#ifdef __SSE2__
+/* check that 8 chars are all 7-bit ASCII */
+static inline BOOL is_ascii_block( __m128i v )
+{
+    return _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( v, _mm_set1_epi16( 0xff80 )),
+                                               _mm_setzero_si128() )) == 0xffff;
+}
+
+/* upcase a block of 7-bit ASCII chars; this matches toupperW() in that range */
+static inline __m128i upcase_ascii_block( __m128i v )
+{
+    __m128i lower = _mm_and_si128( _mm_cmpgt_epi16( v, _mm_set1_epi16( 'a' - 1 )),
+                                   _mm_cmplt_epi16( v, _mm_set1_epi16( 'z' + 1 )));
+    return _mm_sub_epi16( v, _mm_and_si128( lower, _mm_set1_epi16( 'a' - 'A' )));
+}
+
+/* number of leading chars that are known to compare equal, 8 at a time */
+static inline SIZE_T compare_blocks( const WCHAR *s1, const WCHAR *s2, SIZE_T len, BOOLEAN case_insensitive )
+{
+    SIZE_T pos;
+
+    for (pos = 0; pos + 8 <= len; pos += 8)
+    {
+        __m128i v1 = _mm_loadu_si128( (const __m128i *)(s1 + pos) );
+        __m128i v2 = _mm_loadu_si128( (const __m128i *)(s2 + pos) );
+
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( v1, v2 )) == 0xffff) continue;
+        if (!case_insensitive || !is_ascii_block( _mm_or_si128( v1, v2 ))) break;
+        v1 = upcase_ascii_block( v1 );
+        v2 = upcase_ascii_block( v2 );
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( v1, v2 )) != 0xffff) break;
+    }
+    return pos;
+}
+#endif
+
 /******************************************************************************
  *	RtlCompareUnicodeStrings   (NTDLL.@)
  */
@@ -461,6 +500,20 @@ LONG WINAPI RtlCompareUnicodeStrings( const WCHAR *s1, SIZE_T len1, const WCHAR
     LONG ret = 0;
     SIZE_T len = min( len1, len2 );
 
+#ifdef __SSE2__
+    while (len >= 8)
+    {
+        SIZE_T pos = compare_blocks( s1, s2, len, case_insensitive ), end;
+
+        s1 += pos;
+        s2 += pos;
+        len -= pos;
+        /* compare the block that failed the fast path one char at a time */
+        for (end = min( len, 8 ); !ret && end; end--, len--)
+            ret = case_insensitive ? toupperW(*s1++) - toupperW(*s2++) : *s1++ - *s2++;
+        if (ret) return ret;
+    }
+#endif
     if (case_insensitive)
     {
         while (!ret && len--) ret = toupperW(*s1++) - toupperW(*s2++);
@@ -1033,7 +1086,21 @@ NTSTATUS WINAPI RtlUpcaseUnicodeString( UNICODE_STRING *dest,
     }
     else if (len > dest->MaximumLength) return STATUS_BUFFER_OVERFLOW;
 
-    for (i = 0; i < len/sizeof(WCHAR); i++) dest->Buffer[i] = toupperW(src->Buffer[i]);
+    i = 0;
+#ifdef __SSE2__
+    for (; i + 8 <= len/sizeof(WCHAR); i += 8)
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i *)(src->Buffer + i) );
+        if (is_ascii_block( v ))
+            _mm_storeu_si128( (__m128i *)(dest->Buffer + i), upcase_ascii_block( v ));
+        else
+        {
+            DWORD j;
+            for (j = i; j < i + 8; j++) dest->Buffer[j] = toupperW(src->Buffer[j]);
+        }
+    }
+#endif
+    for (; i < len/sizeof(WCHAR); i++) dest->Buffer[i] = toupperW(src->Buffer[i]);
     dest->Length = len;
     return STATUS_SUCCESS;
 }
@@ -72,6 +72,9 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -80,6 +83,7 @@
 #include "wine/library.h"
 #include "wine/server.h"
 #include "wine/debug.h"
+#include "wine/exception.h"
 #include "ntdll_misc.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(server);
@@ -119,14 +123,14 @@ sigset_t server_block_set;  /* signals to block during server calls */
 static int fd_socket = -1;  /* socket to exchange file descriptors with the server */
 static pid_t server_pid;
 
-static RTL_CRITICAL_SECTION fd_cache_section;
+RTL_CRITICAL_SECTION fd_cache_section;
 static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 {
     0, 0, &fd_cache_section,
     { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
       0, 0, { (DWORD_PTR)(__FILE__ ": fd_cache_section") }
 };
-static RTL_CRITICAL_SECTION fd_cache_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+RTL_CRITICAL_SECTION fd_cache_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
 /* atomically exchange a 64-bit value */
 static inline LONG64 interlocked_xchg64( LONG64 *dest, LONG64 val )
@@ -277,14 +281,127 @@ static inline unsigned int wait_reply( struct __server_request_info *req )
 }
 
 
+#define SHM_REQUEST_SPIN_COUNT 1000  /* polling iterations before sleeping on a reply */
+
+#ifdef __linux__
+static inline int shm_futex_wait( int *addr, int val, struct timespec *timeout )
+{
+    return syscall( __NR_futex, addr, 0 /* FUTEX_WAIT */, val, timeout, 0, 0 );
+}
+#else
+static inline int shm_futex_wait( int *addr, int val, struct timespec *timeout )
+{
+    errno = ENOSYS;
+    return -1;
+}
+#endif
+
+
+/***********************************************************************
+ *           check_server_alive
+ *
+ * Exit the thread if the server closed our reply pipe.
+ */
+static void check_server_alive(void)
+{
+    struct pollfd pfd;
+
+    pfd.fd = ntdll_get_thread_data()->reply_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll( &pfd, 1, 0 ) > 0) abort_thread(0);
+}
+
+
+/***********************************************************************
+ *           shm_server_call
+ *
+ * Post a request in the shared memory area of the current thread and wait for the reply.
+ */
+static unsigned int shm_server_call( struct __server_request_info *req, struct shm_request_area *area )
+{
+    char *buffer = (char *)(area + 1);
+    unsigned int i;
+    int seq, val;
+
+    /* a page fault while copying the data may run a nested server call, start over if it did */
+    do
+    {
+        seq = area->client_seq + 1;
+        memcpy( buffer, &req->u.req, sizeof(req->u.req) );
+        if (req->u.req.request_header.request_size)
+        {
+            __TRY
+            {
+                char *ptr = buffer + sizeof(req->u.req);
+
+                for (i = 0; i < req->data_count; i++)
+                {
+                    memcpy( ptr, req->data[i].ptr, req->data[i].size );
+                    ptr += req->data[i].size;
+                }
+            }
+            __EXCEPT_PAGE_FAULT
+            {
+                return STATUS_ACCESS_VIOLATION;
+            }
+            __ENDTRY
+        }
+    } while (area->client_seq != seq - 1);
+
+    __sync_synchronize();
+    area->client_seq = seq;
+    __sync_synchronize();
+    if (area->server_sleeping)
+    {
+        char dummy = 0;
+        /* EAGAIN means that the server has plenty of wake ups pending already */
+        while (write( ntdll_get_thread_data()->doorbell_fd, &dummy, 1 ) == -1 && errno == EINTR);
+    }
+
+    for (i = 0; i < SHM_REQUEST_SPIN_COUNT && area->server_seq != seq; i++)
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        __asm__ __volatile__( "rep;nop" : : : "memory" );
+#endif
+    }
+
+    while ((val = area->server_seq) != seq)
+    {
+        struct timespec timeout;
+
+        area->client_waiting = 1;
+        __sync_synchronize();
+        if (area->server_seq != val) continue;
+        if (area->dead) abort_thread(0);
+        timeout.tv_sec  = 1;
+        timeout.tv_nsec = 0;
+        if (shm_futex_wait( &area->server_seq, val, &timeout ) == -1 && errno == ETIMEDOUT)
+            check_server_alive();
+    }
+    area->client_waiting = 0;
+    __sync_synchronize();
+
+    memcpy( &req->u.reply, buffer, sizeof(req->u.reply) );
+    if (req->u.reply.reply_header.reply_size)
+        memcpy( req->reply_data, buffer + sizeof(req->u.reply), req->u.reply.reply_header.reply_size );
+    return req->u.reply.reply_header.error;
+}
+
+
 /***********************************************************************
  *           server_call_unlocked
  */
 unsigned int server_call_unlocked( void *req_ptr )
 {
     struct __server_request_info * const req = req_ptr;
+    struct shm_request_area *area = ntdll_get_thread_data()->shm_area;
     unsigned int ret;
 
+    if (area && req->u.req.request_header.request_size <= SHM_REQUEST_MAX_DATA &&
+        req->u.req.request_header.reply_size <= SHM_REQUEST_MAX_DATA)
+        return shm_server_call( req, area );
+
     if ((ret = send_request( req ))) return ret;
     return wait_reply( req );
 }
@@ -314,12 +431,89 @@ unsigned int server_call_unlocked( void *req_ptr )
  */
 unsigned int wine_server_call( void *req_ptr )
 {
+    struct __server_request_info * const req = req_ptr;
     sigset_t old_set;
     unsigned int ret;
+    LARGE_INTEGER start;
 
+    if (loader_profile_enabled) NtQueryPerformanceCounter( &start, NULL );
     pthread_sigmask( SIG_BLOCK, &server_block_set, &old_set );
     ret = server_call_unlocked( req_ptr );
     pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+    if (loader_profile_enabled) loader_profile_server_call( req->u.req.request_header.req, &start );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           wine_server_call_batch (NTDLL.@)
+ *
+ * Perform several server calls in a single round-trip.
+ *
+ * PARAMS
+ *     reqs  [I/O] Requests, set up with wine_server_init_req
+ *     count [I]   Number of requests
+ *     flags [I]   BATCH_STOP_ON_ERROR to skip the remaining requests once one fails
+ *
+ * RETURNS
+ *     The status of the first request that failed, or STATUS_SUCCESS.
+ *     Each request gets its own reply; skipped requests fail with STATUS_REQUEST_ABORTED.
+ */
+unsigned int CDECL wine_server_call_batch( struct __server_request_info *reqs, unsigned int count,
+                                           unsigned int flags )
+{
+    char stack_buffer[1024];
+    char *buffer = stack_buffer, *ptr;
+    data_size_t req_size = 0, reply_size = 0, size;
+    unsigned int i, j, done = 0, ret;
+
+    for (i = 0; i < count; i++)
+    {
+        req_size += sizeof(reqs[i].u.req) + reqs[i].u.req.request_header.request_size;
+        reply_size += sizeof(reqs[i].u.reply) + reqs[i].u.req.request_header.reply_size;
+    }
+    size = max( req_size, reply_size );
+    if (size > sizeof(stack_buffer) && !(buffer = RtlAllocateHeap( GetProcessHeap(), 0, size )))
+        return STATUS_NO_MEMORY;
+
+    for (i = 0, ptr = buffer; i < count; i++)
+    {
+        memcpy( ptr, &reqs[i].u.req, sizeof(reqs[i].u.req) );
+        ptr += sizeof(reqs[i].u.req);
+        for (j = 0; j < reqs[i].data_count; j++)
+        {
+            memcpy( ptr, reqs[i].data[j].ptr, reqs[i].data[j].size );
+            ptr += reqs[i].data[j].size;
+        }
+    }
+
+    SERVER_START_REQ( batch )
+    {
+        req->flags = flags;
+        wine_server_add_data( req, buffer, req_size );
+        wine_server_set_reply( req, buffer, reply_size );
+        if (!(ret = wine_server_call( req ))) done = reply->count;
+    }
+    SERVER_END_REQ;
+
+    for (i = 0, ptr = buffer; i < done; i++)
+    {
+        memcpy( &reqs[i].u.reply, ptr, sizeof(reqs[i].u.reply) );
+        ptr += sizeof(reqs[i].u.reply);
+        if ((size = reqs[i].u.reply.reply_header.reply_size))
+        {
+            memcpy( reqs[i].reply_data, ptr, size );
+            ptr += size;
+        }
+        if (!ret) ret = reqs[i].u.reply.reply_header.error;
+    }
+    for ( ; i < count; i++)
+    {
+        reqs[i].u.reply.reply_header.error = done ? STATUS_REQUEST_ABORTED : ret;
+        reqs[i].u.reply.reply_header.reply_size = 0;
+    }
+
+    if (buffer != stack_buffer) RtlFreeHeap( GetProcessHeap(), 0, buffer );
     return ret;
 }
 
@@ -920,6 +1114,24 @@ int server_remove_fd_from_cache( HANDLE handle )
 }
 
 
+/***********************************************************************
+ *           server_receive_handle_fd
+ *
+ * Receive the fd sent by the server along with a newly created handle.
+ * Caller must hold fd_cache_section since the request was made.
+ */
+void server_receive_handle_fd( HANDLE handle, enum server_fd_type type,
+                               unsigned int access, unsigned int options )
+{
+    obj_handle_t fd_handle;
+    int fd;
+
+    if ((fd = receive_fd( &fd_handle )) == -1) return;
+    assert( wine_server_ptr_handle(fd_handle) == handle );
+    if (!add_fd_to_cache( handle, fd, type, access, options )) close( fd );
+}
+
+
 /***********************************************************************
  *           server_get_unix_fd
  *
@@ -1041,6 +1253,40 @@ int CDECL wine_server_handle_to_fd( HANDLE handle, unsigned int access, int *uni
 }
 
 
+/***********************************************************************
+ *           wine_server_get_cached_fd   (NTDLL.@)
+ *
+ * Retrieve the file descriptor cached for a file handle, without duplicating it.
+ *
+ * PARAMS
+ *     handle  [I] Wine file handle.
+ *     access  [I] Win32 file access rights requested.
+ *     unix_fd [O] Address where Unix file descriptor will be stored.
+ *     options [O] Address where the file open options will be stored. Optional.
+ *
+ * RETURNS
+ *     NTSTATUS code. STATUS_NOT_SUPPORTED if the handle can't be cached, in which
+ *     case wine_server_handle_to_fd must be used instead.
+ *
+ * NOTES
+ *     The descriptor belongs to the cache and must not be closed; it is only
+ *     valid as long as the handle stays open.
+ */
+int CDECL wine_server_get_cached_fd( HANDLE handle, unsigned int access, int *unix_fd,
+                                     unsigned int *options )
+{
+    int needs_close, ret = server_get_unix_fd( handle, access, unix_fd, &needs_close, NULL, options );
+
+    if (!ret && needs_close)
+    {
+        close( *unix_fd );
+        *unix_fd = -1;
+        ret = STATUS_NOT_SUPPORTED;
+    }
+    return ret;
+}
+
+
 /***********************************************************************
  *           wine_server_release_fd   (NTDLL.@)
  *
@@ -1465,6 +1711,85 @@ void server_init_process_done(void)
 }
 
 
+/***********************************************************************
+ *           init_shm_request
+ *
+ * Switch the current thread to the shared memory request channel if enabled.
+ */
+static void init_shm_request(void)
+{
+#if defined(__linux__) && defined(__NR_memfd_create)
+    static int enabled = -1;
+    struct shm_request_area *area;
+    int fd, doorbell[2];
+    unsigned int ret;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINESHMREQUEST" );
+        enabled = env && atoi( env );
+        if (enabled) TRACE( "using shared memory requests\n" );
+    }
+    if (!enabled) return;
+
+    if ((fd = syscall( __NR_memfd_create, "wine-request", 1 /* MFD_CLOEXEC */ )) == -1) return;
+    if (ftruncate( fd, SHM_REQUEST_AREA_SIZE ) == -1 ||
+        (area = mmap( NULL, SHM_REQUEST_AREA_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0 )) == MAP_FAILED)
+    {
+        close( fd );
+        return;
+    }
+    if (server_pipe( doorbell ) == -1)
+    {
+        munmap( area, SHM_REQUEST_AREA_SIZE );
+        close( fd );
+        return;
+    }
+    fcntl( doorbell[1], F_SETFL, O_NONBLOCK );
+    wine_server_send_fd( fd );
+    wine_server_send_fd( doorbell[0] );
+
+    SERVER_START_REQ( set_shm_request_area )
+    {
+        req->area_fd     = fd;
+        req->doorbell_fd = doorbell[0];
+        ret = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+
+    close( fd );
+    close( doorbell[0] );
+    if (ret)
+    {
+        WARN( "failed to set up shared memory requests: %08x\n", ret );
+        munmap( area, SHM_REQUEST_AREA_SIZE );
+        close( doorbell[1] );
+        return;
+    }
+    ntdll_get_thread_data()->doorbell_fd = doorbell[1];
+    ntdll_get_thread_data()->shm_area = area;
+#endif
+}
+
+
+/***********************************************************************
+ *           server_exit_shm_request
+ *
+ * Release the shared memory request channel of an exiting thread.
+ */
+void server_exit_shm_request(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+
+    if (!thread_data->shm_area) return;
+    munmap( thread_data->shm_area, SHM_REQUEST_AREA_SIZE );
+    close( thread_data->doorbell_fd );
+    thread_data->shm_area = NULL;
+    thread_data->doorbell_fd = -1;
+}
+
+
 /***********************************************************************
  *           server_init_thread
  *
@@ -1530,6 +1855,7 @@ size_t server_init_thread( void *entry_point, BOOL *suspend )
                 fatal_error( "WINEARCH set to win64 but '%s' is a 32-bit installation.\n",
                              wine_get_config_dir() );
         }
+        init_shm_request();
         return info_size;
     case STATUS_INVALID_IMAGE_WIN_64:
         fatal_error( "'%s' is a 32-bit installation, it cannot support 64-bit applications.\n",
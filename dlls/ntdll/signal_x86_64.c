@@ -359,6 +359,21 @@ static RTL_CRITICAL_SECTION_DEBUG dynamic_unwind_debug =
       0, 0, { (DWORD_PTR)(__FILE__ ": dynamic_unwind_section") }
 };
 static RTL_CRITICAL_SECTION dynamic_unwind_section = { &dynamic_unwind_debug, -1, 0, 0, 0, 0 };
+static LONG dynamic_unwind_generation;  /* bumped whenever the dynamic list changes */
+
+/* cache of the function table lookups, indexed by pc */
+struct unwind_cache_entry
+{
+    LONG               seq;     /* odd while the entry is being updated */
+    LONG               gen;     /* module and dynamic table generation at fill time */
+    ULONG64            pc;
+    ULONG64            base;
+    RUNTIME_FUNCTION  *func;
+    LDR_MODULE        *module;
+};
+
+#define UNWIND_CACHE_SIZE 1024  /* must be a power of 2 */
+static struct unwind_cache_entry unwind_cache[UNWIND_CACHE_SIZE];
 
 /***********************************************************************
  * Definitions for Win32 unwind tables
@@ -2321,6 +2336,63 @@ static RUNTIME_FUNCTION *find_function_info( ULONG64 pc, HMODULE module,
     return NULL;
 }
 
+/**********************************************************************
+ *           get_unwind_cache_entry
+ */
+static inline struct unwind_cache_entry *get_unwind_cache_entry( ULONG64 pc )
+{
+    return &unwind_cache[(pc ^ (pc >> 12)) & (UNWIND_CACHE_SIZE - 1)];
+}
+
+/**********************************************************************
+ *           get_unwind_generation
+ *
+ * Both counters only ever increase, so their sum changes whenever either does.
+ */
+static inline LONG get_unwind_generation(void)
+{
+    return get_module_generation() + dynamic_unwind_generation;
+}
+
+/**********************************************************************
+ *           lookup_unwind_cache
+ */
+static BOOL lookup_unwind_cache( ULONG64 pc, LONG gen, ULONG64 *base, RUNTIME_FUNCTION **func,
+                                 LDR_MODULE **module )
+{
+    struct unwind_cache_entry *entry = get_unwind_cache_entry( pc );
+    LONG seq = *(volatile LONG *)&entry->seq;
+
+    if (seq & 1) return FALSE;
+    __asm__ __volatile__( "" ::: "memory" );
+    if (entry->pc != pc || entry->gen != gen) return FALSE;
+    *base   = entry->base;
+    *func   = entry->func;
+    *module = entry->module;
+    __asm__ __volatile__( "" ::: "memory" );
+    return *(volatile LONG *)&entry->seq == seq;
+}
+
+/**********************************************************************
+ *           store_unwind_cache
+ */
+static void store_unwind_cache( ULONG64 pc, LONG gen, ULONG64 base, RUNTIME_FUNCTION *func,
+                                LDR_MODULE *module )
+{
+    struct unwind_cache_entry *entry = get_unwind_cache_entry( pc );
+    LONG seq = *(volatile LONG *)&entry->seq;
+
+    /* if another thread is updating the entry, simply don't cache */
+    if (seq & 1) return;
+    if (interlocked_cmpxchg( &entry->seq, seq + 1, seq ) != seq) return;
+    entry->pc     = pc;
+    entry->gen    = gen;
+    entry->base   = base;
+    entry->func   = func;
+    entry->module = module;
+    interlocked_xchg( &entry->seq, seq + 2 );
+}
+
 /**********************************************************************
  *           lookup_function_info
  */
@@ -2328,8 +2400,12 @@ static RUNTIME_FUNCTION *lookup_function_info( ULONG64 pc, ULONG64 *base, LDR_MO
 {
     RUNTIME_FUNCTION *func = NULL;
     struct dynamic_unwind_entry *entry;
+    LONG gen = get_unwind_generation();
+    BOOL cacheable = TRUE;
     ULONG size;
 
+    if (lookup_unwind_cache( pc, gen, base, &func, module )) return func;
+
     /* PE module or wine module */
     if (!LdrFindEntryForAddress( (void *)pc, module ))
     {
@@ -2354,7 +2430,10 @@ static RUNTIME_FUNCTION *lookup_function_info( ULONG64 pc, ULONG64 *base, LDR_MO
 
                 /* use callback or lookup in function table */
                 if (entry->callback)
+                {
                     func = entry->callback( pc, entry->context );
+                    cacheable = FALSE;
+                }
                 else
                     func = find_function_info( pc, (HMODULE)entry->base, entry->table, entry->table_size );
                 break;
@@ -2363,6 +2442,8 @@ static RUNTIME_FUNCTION *lookup_function_info( ULONG64 pc, ULONG64 *base, LDR_MO
         RtlLeaveCriticalSection( &dynamic_unwind_section );
     }
 
+    /* only successful lookups are cached, misses may not have set *base */
+    if (func && cacheable) store_unwind_cache( pc, gen, *base, func, *module );
     return func;
 }
 
@@ -3160,6 +3241,7 @@ BOOLEAN CDECL RtlAddFunctionTable( RUNTIME_FUNCTION *table, DWORD count, DWORD64
 
     RtlEnterCriticalSection( &dynamic_unwind_section );
     list_add_tail( &dynamic_unwind_list, &entry->entry );
+    interlocked_xchg_add( &dynamic_unwind_generation, 1 );
     RtlLeaveCriticalSection( &dynamic_unwind_section );
 
     return TRUE;
@@ -3195,6 +3277,7 @@ BOOLEAN CDECL RtlInstallFunctionTableCallback( DWORD64 table, DWORD64 base, DWOR
 
     RtlEnterCriticalSection( &dynamic_unwind_section );
     list_add_tail( &dynamic_unwind_list, &entry->entry );
+    interlocked_xchg_add( &dynamic_unwind_generation, 1 );
     RtlLeaveCriticalSection( &dynamic_unwind_section );
 
     return TRUE;
@@ -3217,6 +3300,7 @@ BOOLEAN CDECL RtlDeleteFunctionTable( RUNTIME_FUNCTION *table )
         {
             to_free = entry;
             list_remove( &entry->entry );
+            interlocked_xchg_add( &dynamic_unwind_generation, 1 );
             break;
         }
     }
@@ -58,6 +58,7 @@ static NTSTATUS (WINAPI *pNtCreateNamedPipeFile)( PHANDLE, ULONG, POBJECT_ATTRIB
                                        ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, ULONG, PLARGE_INTEGER );
 static NTSTATUS (WINAPI *pNtOpenDirectoryObject)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES);
 static NTSTATUS (WINAPI *pNtCreateDirectoryObject)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES);
+static NTSTATUS (WINAPI *pNtQueryDirectoryObject)(HANDLE, PDIRECTORY_BASIC_INFORMATION, ULONG, BOOLEAN, BOOLEAN, PULONG, PULONG);
 static NTSTATUS (WINAPI *pNtOpenSymbolicLinkObject)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES);
 static NTSTATUS (WINAPI *pNtCreateSymbolicLinkObject)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES, PUNICODE_STRING);
 static NTSTATUS (WINAPI *pNtQuerySymbolicLinkObject)(HANDLE,PUNICODE_STRING,PULONG);
@@ -1141,6 +1142,72 @@ error:
     pNtClose(dir);
 }
 
+static void test_query_directory(void)
+{
+    static const WCHAR nameW[] = {'o','m','.','c','-','e','v','e','n','t','1',0};
+    union
+    {
+        DIRECTORY_BASIC_INFORMATION info[1];
+        char data[512];
+    } buffer;
+    DIRECTORY_BASIC_INFORMATION *info = buffer.info;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    HANDLE dir, event1, event2;
+    ULONG context, size, one_entry;
+    NTSTATUS status;
+
+    if (!pNtQueryDirectoryObject)
+    {
+        win_skip( "NtQueryDirectoryObject not available\n" );
+        return;
+    }
+
+    InitializeObjectAttributes( &attr, NULL, 0, 0, NULL );
+    status = pNtCreateDirectoryObject( &dir, GENERIC_ALL, &attr );
+    ok( status == STATUS_SUCCESS, "Failed to create directory %08x\n", status );
+
+    InitializeObjectAttributes( &attr, &str, 0, dir, NULL );
+    pRtlCreateUnicodeStringFromAsciiz( &str, "om.c-event1" );
+    status = pNtCreateEvent( &event1, GENERIC_ALL, &attr, NotificationEvent, FALSE );
+    ok( status == STATUS_SUCCESS, "Failed to create event %08x\n", status );
+    pRtlFreeUnicodeString( &str );
+    pRtlCreateUnicodeStringFromAsciiz( &str, "om.c-event2" );
+    status = pNtCreateEvent( &event2, GENERIC_ALL, &attr, NotificationEvent, FALSE );
+    ok( status == STATUS_SUCCESS, "Failed to create event %08x\n", status );
+    pRtlFreeUnicodeString( &str );
+
+    context = 0xdeadbeef;
+    size = 0;
+    memset( &buffer, 0xcc, sizeof(buffer) );
+    status = pNtQueryDirectoryObject( dir, info, sizeof(buffer), FALSE, TRUE, &context, &size );
+    ok( status == STATUS_SUCCESS, "NtQueryDirectoryObject failed %08x\n", status );
+    ok( context == 2, "got context %u\n", context );
+    ok( size > 3 * sizeof(*info) && size <= sizeof(buffer), "got size %u\n", size );
+    ok( info[0].ObjectName.Length == sizeof(nameW) - sizeof(WCHAR), "got length %u\n", info[0].ObjectName.Length );
+    ok( info[1].ObjectName.Length == sizeof(nameW) - sizeof(WCHAR), "got length %u\n", info[1].ObjectName.Length );
+    ok( !memcmp( info[0].ObjectName.Buffer, nameW, sizeof(nameW) - 2 * sizeof(WCHAR) ), "wrong name %s\n",
+        wine_dbgstr_w( info[0].ObjectName.Buffer ));
+    ok( !info[2].ObjectName.Buffer && !info[2].ObjectTypeName.Buffer, "entry list not terminated\n" );
+
+    status = pNtQueryDirectoryObject( dir, info, sizeof(buffer), FALSE, FALSE, &context, &size );
+    ok( status == STATUS_NO_MORE_ENTRIES, "NtQueryDirectoryObject returned %08x\n", status );
+    ok( context == 2, "got context %u\n", context );
+
+    /* room for a single entry */
+    one_entry = 2 * sizeof(*info) + info[0].ObjectName.MaximumLength + info[0].ObjectTypeName.MaximumLength;
+    status = pNtQueryDirectoryObject( dir, info, one_entry, FALSE, TRUE, &context, &size );
+    ok( status == STATUS_MORE_ENTRIES, "NtQueryDirectoryObject returned %08x\n", status );
+    ok( context == 1, "got context %u\n", context );
+    status = pNtQueryDirectoryObject( dir, info, one_entry, FALSE, FALSE, &context, &size );
+    ok( status == STATUS_SUCCESS || status == STATUS_MORE_ENTRIES, "NtQueryDirectoryObject returned %08x\n", status );
+    ok( context == 2, "got context %u\n", context );
+
+    pNtClose( event1 );
+    pNtClose( event2 );
+    pNtClose( dir );
+}
+
 static void test_symboliclink(void)
 {
     NTSTATUS status;
@@ -2014,6 +2081,7 @@ START_TEST(om)
     pNtCreateNamedPipeFile  = (void *)GetProcAddress(hntdll, "NtCreateNamedPipeFile");
     pNtOpenDirectoryObject  = (void *)GetProcAddress(hntdll, "NtOpenDirectoryObject");
     pNtCreateDirectoryObject= (void *)GetProcAddress(hntdll, "NtCreateDirectoryObject");
+    pNtQueryDirectoryObject = (void *)GetProcAddress(hntdll, "NtQueryDirectoryObject");
     pNtOpenSymbolicLinkObject = (void *)GetProcAddress(hntdll, "NtOpenSymbolicLinkObject");
     pNtCreateSymbolicLinkObject = (void *)GetProcAddress(hntdll, "NtCreateSymbolicLinkObject");
     pNtQuerySymbolicLinkObject  = (void *)GetProcAddress(hntdll, "NtQuerySymbolicLinkObject");
@@ -2037,6 +2105,7 @@ START_TEST(om)
     test_name_collisions();
     test_name_limits();
     test_directory();
+    test_query_directory();
     test_symboliclink();
     test_query_object();
     test_type_mismatch();
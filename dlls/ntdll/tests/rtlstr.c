@@ -1887,6 +1887,34 @@ static void test_RtlCompareUnicodeString(void)
             }
         }
     }
+
+    if (pRtlCompareUnicodeStrings)
+    {
+        static const WCHAR path[] = {'\\','?','?','\\','c',':','\\','w','i','n','d','o','w','s','\\',
+                                     's','y','s','t','e','m','3','2','\\','d','r','i','v','e','r','s','\\',
+                                     'e','t','c','\\','h','o','s','t','s'};
+        WCHAR buf1[sizeof(path)/sizeof(WCHAR)], buf2[sizeof(path)/sizeof(WCHAR)];
+        unsigned int i, len = sizeof(path)/sizeof(WCHAR);
+        LONG res;
+
+        /* long strings differing at one position, with and without case differences elsewhere */
+        for (i = 0; i < len; i++)
+        {
+            for (ch1 = 0; ch1 < 512; ch1 += 7)
+            {
+                memcpy( buf1, path, sizeof(path) );
+                memcpy( buf2, path, sizeof(path) );
+                buf2[len - 1 - i] = pRtlUpcaseUnicodeChar( buf2[len - 1 - i] );
+                buf1[i] = ch1;
+                res = pRtlCompareUnicodeStrings( buf1, len, buf2, len, TRUE );
+                ok( res == (pRtlUpcaseUnicodeChar(ch1) - pRtlUpcaseUnicodeChar(path[i])),
+                    "%u: wrong result %d for %04x\n", i, res, ch1 );
+                buf2[len - 1 - i] = path[len - 1 - i];
+                res = pRtlCompareUnicodeStrings( buf1, len, buf2, len, FALSE );
+                ok( res == (ch1 - path[i]), "%u: wrong result %d for %04x\n", i, res, ch1 );
+            }
+        }
+    }
 }
 
 static const WCHAR szGuid[] = { '{','0','1','0','2','0','3','0','4','-',
@@ -117,6 +117,40 @@ static void test_NtQueryPerformanceCounter(void)
     ok(status == STATUS_SUCCESS, "expected STATUS_SUCCESS, got %08x\n", status);
 }
 
+/* read a KSYSTEM_TIME value from the shared user data */
+static LONGLONG read_shared_time(ULONG offset)
+{
+    const volatile LONG *time = (const volatile LONG *)((ULONG_PTR)0x7ffe0000 + offset);
+    ULONG low;
+    LONG high;
+
+    do
+    {
+        high = time[1];
+        low = time[0];
+    } while (high != time[2]);
+    return ((LONGLONG)high << 32) | low;
+}
+
+static void test_user_shared_data_time(void)
+{
+    LONGLONG interrupt, interrupt2, system;
+    LARGE_INTEGER now;
+    FILETIME ft;
+
+    interrupt = read_shared_time(0x08);
+    system = read_shared_time(0x14);
+    GetSystemTimeAsFileTime(&ft);
+    now.u.LowPart = ft.dwLowDateTime;
+    now.u.HighPart = ft.dwHighDateTime;
+    ok(now.QuadPart - system < 100 * TICKSPERMSEC && system - now.QuadPart < 100 * TICKSPERMSEC,
+       "shared system time %s, expected %s\n", wine_dbgstr_longlong(system), wine_dbgstr_longlong(now.QuadPart));
+
+    Sleep(100);
+    interrupt2 = read_shared_time(0x08);
+    ok(interrupt2 > interrupt, "interrupt time didn't change: %s\n", wine_dbgstr_longlong(interrupt));
+}
+
 static void test_RtlQueryTimeZoneInformation(void)
 {
     RTL_DYNAMIC_TIME_ZONE_INFORMATION tzinfo;
@@ -170,4 +204,5 @@ START_TEST(time)
         win_skip("Required time conversion functions are not available\n");
     test_NtQueryPerformanceCounter();
     test_RtlQueryTimeZoneInformation();
+    test_user_shared_data_time();
 }
@@ -280,7 +280,6 @@ HANDLE thread_init(void)
     BOOL suspend;
     SIZE_T size, info_size;
     HANDLE exe_file = 0;
-    LARGE_INTEGER now;
     NTSTATUS status;
     struct ntdll_thread_data *thread_data;
     static struct debug_info debug_info;  /* debug info for initial thread */
@@ -300,6 +299,7 @@ HANDLE thread_init(void)
     }
     user_shared_data = addr;
     memcpy( user_shared_data->NtSystemRoot, default_windirW, sizeof(default_windirW) );
+    user_shared_data->LargePageMinimum = virtual_get_large_page_size();
 
     /* allocate and initialize the PEB */
 
@@ -355,6 +355,7 @@ HANDLE thread_init(void)
     thread_data->reply_fd   = -1;
     thread_data->wait_fd[0] = -1;
     thread_data->wait_fd[1] = -1;
+    thread_data->doorbell_fd = -1;
     thread_data->debug_info = &debug_info;
 
     signal_init_thread( teb );
@@ -392,14 +393,11 @@ HANDLE thread_init(void)
             wine_server_fd_to_handle( 2, GENERIC_WRITE|SYNCHRONIZE, OBJ_INHERIT, &params.hStdError );
     }
 
+    init_performance_counter();
+
     /* initialize time values in user_shared_data */
-    NtQuerySystemTime( &now );
-    user_shared_data->SystemTime.LowPart = now.u.LowPart;
-    user_shared_data->SystemTime.High1Time = user_shared_data->SystemTime.High2Time = now.u.HighPart;
-    user_shared_data->u.TickCountQuad = (now.QuadPart - server_start_time) / 10000;
-    user_shared_data->u.TickCount.High2Time = user_shared_data->u.TickCount.High1Time;
-    user_shared_data->TickCountLowDeprecated = user_shared_data->u.TickCount.LowPart;
     user_shared_data->TickCountMultiplier = 1 << 24;
+    init_shared_user_data_time();
 
     fill_cpu_info();
 
@@ -451,6 +449,8 @@ void exit_thread( int status )
     close( ntdll_get_thread_data()->wait_fd[1] );
     close( ntdll_get_thread_data()->reply_fd );
     close( ntdll_get_thread_data()->request_fd );
+    server_exit_shm_request();
+    debug_exit_thread();
     pthread_exit( UIntToPtr(status) );
 }
 
@@ -483,6 +483,7 @@ void WINAPI RtlExitUserThread( ULONG status )
 
     LdrShutdownThread();
     RtlFreeThreadActivationContextStack();
+    fast_sync_thread_exit();
 
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
@@ -515,6 +516,7 @@ static void start_thread( struct startup_info *info )
 
     debug_info.str_pos = debug_info.strings;
     debug_info.out_pos = debug_info.output;
+    debug_info.trace_ring = NULL;
     thread_data->debug_info = &debug_info;
     thread_data->pthread_id = pthread_self();
 
@@ -630,6 +632,7 @@ NTSTATUS WINAPI RtlCreateUserThread( HANDLE process, const SECURITY_DESCRIPTOR *
     thread_data->reply_fd    = -1;
     thread_data->wait_fd[0]  = -1;
     thread_data->wait_fd[1]  = -1;
+    thread_data->doorbell_fd = -1;
     thread_data->start_stack = (char *)teb->Tib.StackBase;
 
     pthread_attr_init( &attr );
@@ -84,11 +84,28 @@ struct wait_work_item
     BOOLEAN CallbackInProgress;
 };
 
+#define TIMER_HEAP_NONE (~0u)
+
+/* binary min-heap of timers, ordered by expiration time */
+struct timer_heap_entry
+{
+    ULONGLONG key;
+    unsigned int index;         /* position in the heap, TIMER_HEAP_NONE if not queued */
+};
+
+struct timer_heap
+{
+    struct timer_heap_entry **entries;
+    unsigned int count;
+    unsigned int size;
+};
+
 struct timer_queue;
 struct queue_timer
 {
     struct timer_queue *q;
     struct list entry;
+    struct timer_heap_entry heap_entry;
     ULONG runcount;             /* number of callbacks pending execution */
     RTL_WAITORTIMERCALLBACKFUNC callback;
     PVOID param;
@@ -103,7 +120,8 @@ struct timer_queue
 {
     DWORD magic;
     RTL_CRITICAL_SECTION cs;
-    struct list timers;         /* sorted by expiration time */
+    struct list timers;         /* all timers of the queue */
+    struct timer_heap heap;     /* armed timers, by expiration time */
     BOOL quit;                  /* queue should be deleted; once set, never unset */
     HANDLE event;
     HANDLE thread;
@@ -114,7 +132,16 @@ struct timer_queue
  */
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
-#define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
+#define THREADPOOL_MAX_QUEUES     16
+#define THREADPOOL_SPIN_COUNT     4000
+
+/* queue of work items, one per CPU */
+struct threadpool_queue
+{
+    CRITICAL_SECTION        cs;
+    /* objects with pending callbacks, locked via .cs */
+    struct list             objects;
+};
 
 /* internal threadpool representation */
 struct threadpool
@@ -123,14 +150,19 @@ struct threadpool
     LONG                    objcount;
     BOOL                    shutdown;
     CRITICAL_SECTION        cs;
-    /* pool of work items, locked via .cs */
-    struct list             pool;
+    /* queues of work items, objects are spread across them when created */
+    struct threadpool_queue queues[THREADPOOL_MAX_QUEUES];
+    unsigned int            num_queues;
+    LONG                    next_queue;
+    LONG                    num_pending;
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
     int                     min_workers;
     int                     num_workers;
-    int                     num_busy_workers;
+    LONG                    num_busy_workers;
+    LONG                    num_idle_workers;
+    LONG                    next_worker;
 };
 
 enum threadpool_objtype
@@ -149,6 +181,7 @@ struct threadpool_object
     /* read-only information */
     enum threadpool_objtype type;
     struct threadpool       *pool;
+    struct threadpool_queue *queue;
     struct threadpool_group *group;
     PVOID                   userdata;
     PTP_CLEANUP_GROUP_CANCEL_CALLBACK group_cancel_callback;
@@ -158,7 +191,7 @@ struct threadpool_object
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
-    /* information about the pool, locked via .pool->cs */
+    /* information about the pool, locked via .queue->cs */
     struct list             pool_entry;
     RTL_CONDITION_VARIABLE  finished_event;
     RTL_CONDITION_VARIABLE  group_finished_event;
@@ -182,7 +215,7 @@ struct threadpool_object
             /* information about the timer, locked via timerqueue.cs */
             BOOL            timer_initialized;
             BOOL            timer_pending;
-            struct list     timer_entry;
+            struct timer_heap_entry timer_entry;
             BOOL            timer_set;
             ULONGLONG       timeout;
             LONG            period;
@@ -193,10 +226,9 @@ struct threadpool_object
             PTP_WAIT_CALLBACK callback;
             LONG            signaled;
             /* information about the wait object, locked via waitqueue.cs */
-            struct waitqueue_bucket *bucket;
+            BOOL            wait_initialized;
             BOOL            wait_pending;
-            struct list     wait_entry;
-            ULONGLONG       timeout;
+            struct timer_heap_entry timeout_entry;
             HANDLE          handle;
         } wait;
     } u;
@@ -238,7 +270,7 @@ static struct
     CRITICAL_SECTION        cs;
     LONG                    objcount;
     BOOL                    thread_running;
-    struct list             pending_timers;
+    struct timer_heap       pending_timers;
     RTL_CONDITION_VARIABLE  update_event;
 }
 timerqueue =
@@ -246,7 +278,7 @@ timerqueue =
     { &timerqueue_debug, -1, 0, 0, 0, 0 },      /* cs */
     0,                                          /* objcount */
     FALSE,                                      /* thread_running */
-    LIST_INIT( timerqueue.pending_timers ),     /* pending_timers */
+    { NULL, 0, 0 },                             /* pending_timers */
     RTL_CONDITION_VARIABLE_INIT                 /* update_event */
 };
 
@@ -263,14 +295,18 @@ static RTL_CRITICAL_SECTION_DEBUG waitqueue_debug;
 static struct
 {
     CRITICAL_SECTION        cs;
-    LONG                    num_buckets;
-    struct list             buckets;
+    LONG                    objcount;
+    BOOL                    thread_running;
+    HANDLE                  wait_set;
+    struct timer_heap       timeouts;
 }
 waitqueue =
 {
     { &waitqueue_debug, -1, 0, 0, 0, 0 },       /* cs */
-    0,                                          /* num_buckets */
-    LIST_INIT( waitqueue.buckets )              /* buckets */
+    0,                                          /* objcount */
+    FALSE,                                      /* thread_running */
+    NULL,                                       /* wait_set */
+    { NULL, 0, 0 }                              /* timeouts */
 };
 
 static RTL_CRITICAL_SECTION_DEBUG waitqueue_debug =
@@ -280,15 +316,6 @@ static RTL_CRITICAL_SECTION_DEBUG waitqueue_debug =
       0, 0, { (DWORD_PTR)(__FILE__ ": waitqueue.cs") }
 };
 
-struct waitqueue_bucket
-{
-    struct list             bucket_entry;
-    LONG                    objcount;
-    struct list             reserved;
-    struct list             waiting;
-    HANDLE                  update_event;
-};
-
 static inline struct threadpool *impl_from_TP_POOL( TP_POOL *pool )
 {
     return (struct threadpool *)pool;
@@ -341,6 +368,15 @@ static inline LONG interlocked_dec( PLONG dest )
     return interlocked_xchg_add( dest, -1 ) - 1;
 }
 
+static inline void small_pause(void)
+{
+#ifdef __i386__
+    __asm__ __volatile__( "rep;nop" : : : "memory" );
+#else
+    __asm__ __volatile__( "" : : : "memory" );
+#endif
+}
+
 static void CALLBACK process_rtl_work_item( TP_CALLBACK_INSTANCE *instance, void *userdata )
 {
     struct rtl_work_item *item = userdata;
@@ -699,8 +735,113 @@ NTSTATUS WINAPI RtlDeregisterWait(HANDLE WaitHandle)
 }
 
 
+/************************** Timer Heap **************************/
+
+static BOOL timer_heap_reserve( struct timer_heap *heap, unsigned int count )
+{
+    struct timer_heap_entry **new_entries;
+    unsigned int new_size;
+
+    if (count <= heap->size) return TRUE;
+
+    new_size = max( count, max( heap->size * 2, 16 ) );
+    if (heap->entries)
+        new_entries = RtlReAllocateHeap( GetProcessHeap(), 0, heap->entries, new_size * sizeof(*new_entries) );
+    else
+        new_entries = RtlAllocateHeap( GetProcessHeap(), 0, new_size * sizeof(*new_entries) );
+    if (!new_entries) return FALSE;
+
+    heap->entries = new_entries;
+    heap->size = new_size;
+    return TRUE;
+}
+
+static void timer_heap_free( struct timer_heap *heap )
+{
+    RtlFreeHeap( GetProcessHeap(), 0, heap->entries );
+    heap->entries = NULL;
+    heap->count = heap->size = 0;
+}
+
+static inline void timer_heap_set( struct timer_heap *heap, unsigned int index, struct timer_heap_entry *entry )
+{
+    heap->entries[index] = entry;
+    entry->index = index;
+}
+
+static void timer_heap_sift_up( struct timer_heap *heap, unsigned int index )
+{
+    struct timer_heap_entry *entry = heap->entries[index];
+    unsigned int parent;
+
+    while (index)
+    {
+        parent = (index - 1) / 2;
+        if (heap->entries[parent]->key <= entry->key) break;
+        timer_heap_set( heap, index, heap->entries[parent] );
+        index = parent;
+    }
+    timer_heap_set( heap, index, entry );
+}
+
+static void timer_heap_sift_down( struct timer_heap *heap, unsigned int index )
+{
+    struct timer_heap_entry *entry = heap->entries[index];
+    unsigned int child;
+
+    while ((child = 2 * index + 1) < heap->count)
+    {
+        if (child + 1 < heap->count && heap->entries[child + 1]->key < heap->entries[child]->key)
+            child++;
+        if (entry->key <= heap->entries[child]->key) break;
+        timer_heap_set( heap, index, heap->entries[child] );
+        index = child;
+    }
+    timer_heap_set( heap, index, entry );
+}
+
+/* space for the entry must have been reserved with timer_heap_reserve */
+static void timer_heap_insert( struct timer_heap *heap, struct timer_heap_entry *entry, ULONGLONG key )
+{
+    assert( heap->count < heap->size );
+    assert( entry->index == TIMER_HEAP_NONE );
+
+    entry->key = key;
+    heap->entries[heap->count] = entry;
+    timer_heap_sift_up( heap, heap->count++ );
+}
+
+static void timer_heap_remove( struct timer_heap *heap, struct timer_heap_entry *entry )
+{
+    unsigned int index = entry->index;
+    struct timer_heap_entry *last;
+
+    assert( index < heap->count && heap->entries[index] == entry );
+
+    entry->index = TIMER_HEAP_NONE;
+    last = heap->entries[--heap->count];
+    if (last == entry) return;
+
+    timer_heap_set( heap, index, last );
+    if (index && heap->entries[(index - 1) / 2]->key > last->key)
+        timer_heap_sift_up( heap, index );
+    else
+        timer_heap_sift_down( heap, index );
+}
+
+static inline struct timer_heap_entry *timer_heap_top( const struct timer_heap *heap )
+{
+    return heap->count ? heap->entries[0] : NULL;
+}
+
+
 /************************** Timer Queue Impl **************************/
 
+static inline struct queue_timer *queue_timer_from_entry( struct timer_heap_entry *entry )
+{
+    return entry ? CONTAINING_RECORD( entry, struct queue_timer, heap_entry ) : NULL;
+}
+
 static void queue_remove_timer(struct queue_timer *t)
 {
     /* We MUST hold the queue cs while calling this function.  This ensures
@@ -711,6 +852,8 @@ static void queue_remove_timer(struct queue_timer *t)
     assert(t->runcount == 0);
     assert(t->destroy);
 
+    if (t->heap_entry.index != TIMER_HEAP_NONE)
+        timer_heap_remove(&q->heap, &t->heap_entry);
     list_remove(&t->entry);
     if (t->event)
         NtSetEvent(t->event, NULL);
@@ -752,26 +895,21 @@ static inline ULONGLONG queue_current_time(void)
 static void queue_add_timer(struct queue_timer *t, ULONGLONG time,
                             BOOL set_event)
 {
-    /* We MUST hold the queue cs while calling this function.  */
+    /* We MUST hold the queue cs while calling this function.  The heap
+       must have room for the timer, see RtlCreateTimer.  */
     struct timer_queue *q = t->q;
-    struct list *ptr = &q->timers;
 
     assert(!q->quit || (t->destroy && time == EXPIRE_NEVER));
 
-    if (time != EXPIRE_NEVER)
-        LIST_FOR_EACH(ptr, &q->timers)
-        {
-            struct queue_timer *cur = LIST_ENTRY(ptr, struct queue_timer, entry);
-            if (time < cur->expire)
-                break;
-        }
-    list_add_before(ptr, &t->entry);
-
     t->expire = time;
+    if (time == EXPIRE_NEVER)
+        return;
+
+    timer_heap_insert(&q->heap, &t->heap_entry, time);
 
-    /* If we insert at the head of the list, we need to expire sooner
+    /* If we insert at the top of the heap, we need to expire sooner
        than expected.  */
-    if (set_event && &t->entry == list_head(&q->timers))
+    if (set_event && timer_heap_top(&q->heap) == &t->heap_entry)
         NtSetEvent(q->event, NULL);
 }
 
@@ -779,7 +917,8 @@ static inline void queue_move_timer(struct queue_timer *t, ULONGLONG time,
                                     BOOL set_event)
 {
     /* We MUST hold the queue cs while calling this function.  */
-    list_remove(&t->entry);
+    if (t->heap_entry.index != TIMER_HEAP_NONE)
+        timer_heap_remove(&t->q->heap, &t->heap_entry);
     queue_add_timer(t, time, set_event);
 }
 
@@ -788,10 +927,9 @@ static void queue_timer_expire(struct timer_queue *q)
     struct queue_timer *t = NULL;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((t = queue_timer_from_entry(timer_heap_top(&q->heap))))
     {
         ULONGLONG now, next;
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
         if (!t->destroy && t->expire <= ((now = queue_current_time())))
         {
             ++t->runcount;
@@ -834,16 +972,11 @@ static ULONG queue_get_timeout(struct timer_queue *q)
     ULONG timeout = INFINITE;
 
     RtlEnterCriticalSection(&q->cs);
-    if (list_head(&q->timers))
+    if ((t = queue_timer_from_entry(timer_heap_top(&q->heap))))
     {
-        t = LIST_ENTRY(list_head(&q->timers), struct queue_timer, entry);
-        assert(!t->destroy || t->expire == EXPIRE_NEVER);
-
-        if (t->expire != EXPIRE_NEVER)
-        {
-            ULONGLONG time = queue_current_time();
-            timeout = t->expire < time ? 0 : t->expire - time;
-        }
+        ULONGLONG time = queue_current_time();
+        assert(!t->destroy);
+        timeout = t->expire < time ? 0 : t->expire - time;
     }
     RtlLeaveCriticalSection(&q->cs);
 
@@ -887,6 +1020,7 @@ static void WINAPI timer_queue_thread_proc(LPVOID p)
 
     NtClose(q->event);
     RtlDeleteCriticalSection(&q->cs);
+    timer_heap_free(&q->heap);
     q->magic = 0;
     RtlFreeHeap(GetProcessHeap(), 0, q);
     RtlExitUserThread( 0 );
@@ -902,8 +1036,7 @@ static void queue_destroy_timer(struct queue_timer *t)
            cleanup wrapper.  */
         queue_remove_timer(t);
     else
-        /* Make sure no destroyed timer masks an active timer at the head
-           of the sorted list.  */
+        /* Disarm the timer, it will be removed once the callbacks are done.  */
         queue_move_timer(t, EXPIRE_NEVER, FALSE);
 }
 
@@ -928,6 +1061,7 @@ NTSTATUS WINAPI RtlCreateTimerQueue(PHANDLE NewTimerQueue)
 
     RtlInitializeCriticalSection(&q->cs);
     list_init(&q->timers);
+    memset(&q->heap, 0, sizeof(q->heap));
     q->quit = FALSE;
     q->magic = TIMER_QUEUE_MAGIC;
     status = NtCreateEvent(&q->event, EVENT_ALL_ACCESS, NULL, SynchronizationEvent, FALSE);
@@ -1083,13 +1217,19 @@ NTSTATUS WINAPI RtlCreateTimer(PHANDLE NewTimer, HANDLE TimerQueue,
     t->flags = Flags;
     t->destroy = FALSE;
     t->event = NULL;
+    t->heap_entry.index = TIMER_HEAP_NONE;
 
     status = STATUS_SUCCESS;
     RtlEnterCriticalSection(&q->cs);
     if (q->quit)
         status = STATUS_INVALID_HANDLE;
+    else if (!timer_heap_reserve(&q->heap, q->heap.count + 1))
+        status = STATUS_NO_MEMORY;
     else
+    {
+        list_add_tail(&q->timers, &t->entry);
         queue_add_timer(t, queue_current_time() + DueTime, TRUE);
+    }
     RtlLeaveCriticalSection(&q->cs);
 
     if (status == STATUS_SUCCESS)
@@ -1194,15 +1334,66 @@ NTSTATUS WINAPI RtlDeleteTimer(HANDLE TimerQueue, HANDLE Timer,
     return status;
 }
 
+static inline struct threadpool_object *tp_timer_from_entry( struct timer_heap_entry *entry )
+{
+    struct threadpool_object *timer = CONTAINING_RECORD( entry, struct threadpool_object, u.timer.timer_entry );
+    assert( timer->type == TP_OBJECT_TYPE_TIMER );
+    return timer;
+}
+
+/***********************************************************************
+ *           tp_timerqueue_min_deadline    (internal)
+ *
+ * Returns the earliest time by which one of the pending timers expiring
+ * before 'bound' has to run, taking the window lengths into account. Only
+ * the part of the heap with timeouts before 'bound' is visited.
+ */
+static ULONGLONG tp_timerqueue_min_deadline( unsigned int index, ULONGLONG bound )
+{
+    struct threadpool_object *timer;
+    ULONGLONG deadline;
+
+    if (index >= timerqueue.pending_timers.count) return bound;
+
+    timer = tp_timer_from_entry( timerqueue.pending_timers.entries[index] );
+    if (timer->u.timer.timeout >= bound) return bound;
+
+    deadline = timer->u.timer.timeout + (ULONGLONG)timer->u.timer.window_length * 10000;
+    if (deadline < bound) bound = deadline;
+
+    bound = tp_timerqueue_min_deadline( 2 * index + 1, bound );
+    return tp_timerqueue_min_deadline( 2 * index + 2, bound );
+}
+
+/***********************************************************************
+ *           tp_timerqueue_max_timeout    (internal)
+ *
+ * Returns the latest timeout not after 'deadline', or TIMEOUT_INFINITE.
+ */
+static ULONGLONG tp_timerqueue_max_timeout( unsigned int index, ULONGLONG deadline, ULONGLONG result )
+{
+    struct threadpool_object *timer;
+
+    if (index >= timerqueue.pending_timers.count) return result;
+
+    timer = tp_timer_from_entry( timerqueue.pending_timers.entries[index] );
+    if (timer->u.timer.timeout > deadline) return result;
+
+    if (result == TIMEOUT_INFINITE || timer->u.timer.timeout > result)
+        result = timer->u.timer.timeout;
+
+    result = tp_timerqueue_max_timeout( 2 * index + 1, deadline, result );
+    return tp_timerqueue_max_timeout( 2 * index + 2, deadline, result );
+}
+
 /***********************************************************************
  *           timerqueue_thread_proc    (internal)
  */
 static void CALLBACK timerqueue_thread_proc( void *param )
 {
-    ULONGLONG timeout_lower, timeout_upper, new_timeout;
-    struct threadpool_object *other_timer;
+    ULONGLONG timeout_lower, timeout_upper;
+    struct timer_heap_entry *entry;
     LARGE_INTEGER now, timeout;
-    struct list *ptr;
 
     TRACE( "starting timer queue thread\n" );
 
@@ -1212,16 +1403,15 @@ static void CALLBACK timerqueue_thread_proc( void *param )
         NtQuerySystemTime( &now );
 
         /* Check for expired timers. */
-        while ((ptr = list_head( &timerqueue.pending_timers )))
+        while ((entry = timer_heap_top( &timerqueue.pending_timers )))
         {
-            struct threadpool_object *timer = LIST_ENTRY( ptr, struct threadpool_object, u.timer.timer_entry );
-            assert( timer->type == TP_OBJECT_TYPE_TIMER );
+            struct threadpool_object *timer = tp_timer_from_entry( entry );
             assert( timer->u.timer.timer_pending );
             if (timer->u.timer.timeout > now.QuadPart)
                 break;
 
             /* Queue a new callback in one of the worker threads. */
-            list_remove( &timer->u.timer.timer_entry );
+            timer_heap_remove( &timerqueue.pending_timers, entry );
             timer->u.timer.timer_pending = FALSE;
             tp_object_submit( timer, FALSE );
 
@@ -1232,34 +1422,16 @@ static void CALLBACK timerqueue_thread_proc( void *param )
                 if (timer->u.timer.timeout <= now.QuadPart)
                     timer->u.timer.timeout = now.QuadPart + 1;
 
-                LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                                     struct threadpool_object, u.timer.timer_entry )
-                {
-                    assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-                    if (timer->u.timer.timeout < other_timer->u.timer.timeout)
-                        break;
-                }
-                list_add_before( &other_timer->u.timer.timer_entry, &timer->u.timer.timer_entry );
+                timer_heap_insert( &timerqueue.pending_timers, entry, timer->u.timer.timeout );
                 timer->u.timer.timer_pending = TRUE;
             }
         }
 
-        timeout_lower = TIMEOUT_INFINITE;
-        timeout_upper = TIMEOUT_INFINITE;
-
-        /* Determine next timeout and use the window length to optimize wakeup times. */
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (other_timer->u.timer.timeout >= timeout_upper)
-                break;
-
-            timeout_lower = other_timer->u.timer.timeout;
-            new_timeout   = timeout_lower + (ULONGLONG)other_timer->u.timer.window_length * 10000;
-            if (new_timeout < timeout_upper)
-                timeout_upper = new_timeout;
-        }
+        /* Determine next timeout and use the window length to optimize wakeup times:
+         * wake up at the last timeout before the earliest deadline, so that all timers
+         * expiring in between are coalesced. */
+        timeout_upper = tp_timerqueue_min_deadline( 0, TIMEOUT_INFINITE );
+        timeout_lower = tp_timerqueue_max_timeout( 0, timeout_upper, TIMEOUT_INFINITE );
 
         /* Wait for timer update events or until the next timer expires. */
         if (timerqueue.objcount)
@@ -1302,7 +1474,7 @@ static NTSTATUS tp_new_worker_thread( struct threadpool *pool )
     {
         interlocked_inc( &pool->refcount );
         pool->num_workers++;
-        pool->num_busy_workers++;
+        interlocked_inc( &pool->num_busy_workers );
         NtClose( thread );
     }
     return status;
@@ -1321,6 +1493,7 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
 
     timer->u.timer.timer_initialized    = FALSE;
     timer->u.timer.timer_pending        = FALSE;
+    timer->u.timer.timer_entry.index    = TIMER_HEAP_NONE;
     timer->u.timer.timer_set            = FALSE;
     timer->u.timer.timeout              = 0;
     timer->u.timer.period               = 0;
@@ -1341,6 +1514,10 @@ static NTSTATUS tp_timerqueue_lock( struct threadpool_object *timer )
         }
     }
 
+    /* Every timer object takes at most one heap entry, make sure arming it can't fail. */
+    if (status == STATUS_SUCCESS && !timer_heap_reserve( &timerqueue.pending_timers, timerqueue.objcount + 1 ))
+        status = STATUS_NO_MEMORY;
+
     if (status == STATUS_SUCCESS)
     {
         timer->u.timer.timer_initialized = TRUE;
@@ -1366,14 +1543,14 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
         /* If timer was pending, remove it. */
         if (timer->u.timer.timer_pending)
         {
-            list_remove( &timer->u.timer.timer_entry );
+            timer_heap_remove( &timerqueue.pending_timers, &timer->u.timer.timer_entry );
             timer->u.timer.timer_pending = FALSE;
         }
 
         /* If the last timer object was destroyed, then wake up the thread. */
         if (!--timerqueue.objcount)
         {
-            assert( list_empty( &timerqueue.pending_timers ) );
+            assert( !timerqueue.pending_timers.count );
             RtlWakeAllConditionVariable( &timerqueue.update_event );
         }
 
@@ -1382,229 +1559,196 @@ static void tp_timerqueue_unlock( struct threadpool_object *timer )
     RtlLeaveCriticalSection( &timerqueue.cs );
 }
 
+static inline struct threadpool_object *tp_wait_from_entry( struct timer_heap_entry *entry )
+{
+    struct threadpool_object *wait = CONTAINING_RECORD( entry, struct threadpool_object, u.wait.timeout_entry );
+    assert( wait->type == TP_OBJECT_TYPE_WAIT );
+    return wait;
+}
+
+/***********************************************************************
+ *           tp_waitqueue_set_member    (internal)
+ *
+ * Makes the server wait for a handle on behalf of a wait object, or stop
+ * waiting when handle is NULL. Without a wait object, this only wakes up
+ * the wait queue thread.
+ */
+static NTSTATUS tp_waitqueue_set_member( struct threadpool_object *wait, HANDLE handle )
+{
+    NTSTATUS status;
+
+    /* the server has to see the current state of the object */
+    fast_sync_flush( handle );
+
+    SERVER_START_REQ( set_wait_set_member )
+    {
+        req->handle = wine_server_obj_handle( waitqueue.wait_set );
+        req->object = wine_server_obj_handle( handle );
+        req->key    = wine_server_client_ptr( wait );
+        status = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+    return status;
+}
+
+/***********************************************************************
+ *           tp_waitqueue_disarm    (internal)
+ *
+ * Cancels the pending wait of a wait object. The caller has to hold
+ * waitqueue.cs, so that the wait queue thread can't report it anymore.
+ */
+static void tp_waitqueue_disarm( struct threadpool_object *wait, BOOL remove )
+{
+    if (!wait->u.wait.wait_pending) return;
+
+    if (remove) tp_waitqueue_set_member( wait, NULL );
+    if (wait->u.wait.timeout_entry.index != TIMER_HEAP_NONE)
+        timer_heap_remove( &waitqueue.timeouts, &wait->u.wait.timeout_entry );
+    wait->u.wait.wait_pending = FALSE;
+}
+
 /***********************************************************************
  *           waitqueue_thread_proc    (internal)
+ *
+ * Waits for all the pending wait objects at once, using a server wait set.
  */
 static void CALLBACK waitqueue_thread_proc( void *param )
 {
-    struct threadpool_object *objects[MAXIMUM_WAITQUEUE_OBJECTS];
-    HANDLE handles[MAXIMUM_WAITQUEUE_OBJECTS + 1];
-    struct waitqueue_bucket *bucket = param;
-    struct threadpool_object *wait, *next;
+    client_ptr_t keys[64];
+    struct timer_heap_entry *entry;
+    struct threadpool_object *wait;
+    select_op_t select_op;
     LARGE_INTEGER now, timeout;
-    DWORD num_handles;
+    unsigned int i, count;
     NTSTATUS status;
 
     TRACE( "starting wait queue thread\n" );
 
+    select_op.wait_set.op     = SELECT_WAIT_SET;
+    select_op.wait_set.handle = wine_server_obj_handle( waitqueue.wait_set );
+
     RtlEnterCriticalSection( &waitqueue.cs );
 
     for (;;)
     {
         NtQuerySystemTime( &now );
-        timeout.QuadPart = TIMEOUT_INFINITE;
-        num_handles = 0;
 
-        LIST_FOR_EACH_ENTRY_SAFE( wait, next, &bucket->waiting, struct threadpool_object,
-                                  u.wait.wait_entry )
+        /* Submit the wait objects that timed out. */
+        while ((entry = timer_heap_top( &waitqueue.timeouts )) && entry->key <= now.QuadPart)
         {
-            assert( wait->type == TP_OBJECT_TYPE_WAIT );
-            if (wait->u.wait.timeout <= now.QuadPart)
-            {
-                /* Wait object timed out. */
-                list_remove( &wait->u.wait.wait_entry );
-                list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-                tp_object_submit( wait, FALSE );
-            }
-            else
-            {
-                if (wait->u.wait.timeout < timeout.QuadPart)
-                    timeout.QuadPart = wait->u.wait.timeout;
-
-                assert( num_handles < MAXIMUM_WAITQUEUE_OBJECTS );
-                interlocked_inc( &wait->refcount );
-                objects[num_handles] = wait;
-                handles[num_handles] = wait->u.wait.handle;
-                num_handles++;
-            }
+            wait = tp_wait_from_entry( entry );
+            tp_waitqueue_disarm( wait, TRUE );
+            tp_object_submit( wait, FALSE );
         }
 
-        if (!bucket->objcount)
+        if (entry)
+            timeout.QuadPart = entry->key;
+        else if (waitqueue.objcount)
+            timeout.QuadPart = TIMEOUT_INFINITE;
+        else
         {
             /* All wait objects have been destroyed, if no new wait objects are created
              * within some amount of time, then we can shutdown this thread. */
-            assert( num_handles == 0 );
-            RtlLeaveCriticalSection( &waitqueue.cs );
             timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-            status = NtWaitForMultipleObjects( 1, &bucket->update_event, TRUE, FALSE, &timeout );
-            RtlEnterCriticalSection( &waitqueue.cs );
-
-            if (status == STATUS_TIMEOUT && !bucket->objcount)
-                break;
         }
-        else
-        {
-            handles[num_handles] = bucket->update_event;
-            RtlLeaveCriticalSection( &waitqueue.cs );
-            status = NtWaitForMultipleObjects( num_handles + 1, handles, TRUE, FALSE, &timeout );
-            RtlEnterCriticalSection( &waitqueue.cs );
 
-            if (status >= STATUS_WAIT_0 && status < STATUS_WAIT_0 + num_handles)
-            {
-                wait = objects[status - STATUS_WAIT_0];
-                assert( wait->type == TP_OBJECT_TYPE_WAIT );
-                if (wait->u.wait.bucket)
-                {
-                    /* Wait object signaled. */
-                    assert( wait->u.wait.bucket == bucket );
-                    list_remove( &wait->u.wait.wait_entry );
-                    list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-                    tp_object_submit( wait, TRUE );
-                }
-                else
-                    WARN("wait object %p triggered while object was destroyed\n", wait);
-            }
+        RtlLeaveCriticalSection( &waitqueue.cs );
+        status = server_select( &select_op, sizeof(select_op.wait_set), SELECT_INTERRUPTIBLE, &timeout );
+        RtlEnterCriticalSection( &waitqueue.cs );
+
+        if (status == STATUS_TIMEOUT && !waitqueue.objcount)
+            break;
+        if (status != STATUS_WAIT_0)
+            continue;
 
-            /* Release temporary references to wait objects. */
-            while (num_handles)
+        /* The server removed the signaled objects from the set already. Wait objects
+         * that were rearmed or destroyed in the meantime are not reported anymore. */
+        do
+        {
+            count = 0;
+            SERVER_START_REQ( get_wait_set_events )
             {
-                wait = objects[--num_handles];
-                assert( wait->type == TP_OBJECT_TYPE_WAIT );
-                tp_object_release( wait );
+                req->handle = wine_server_obj_handle( waitqueue.wait_set );
+                wine_server_set_reply( req, keys, sizeof(keys) );
+                if (!wine_server_call( req ))
+                    count = wine_server_reply_size( reply ) / sizeof(keys[0]);
             }
-        }
+            SERVER_END_REQ;
 
-        /* Try to merge bucket with other threads. */
-        if (waitqueue.num_buckets > 1 && bucket->objcount &&
-            bucket->objcount <= MAXIMUM_WAITQUEUE_OBJECTS * 1 / 3)
-        {
-            struct waitqueue_bucket *other_bucket;
-            LIST_FOR_EACH_ENTRY( other_bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
+            for (i = 0; i < count; i++)
             {
-                if (other_bucket != bucket && other_bucket->objcount &&
-                    other_bucket->objcount + bucket->objcount <= MAXIMUM_WAITQUEUE_OBJECTS * 2 / 3)
-                {
-                    other_bucket->objcount += bucket->objcount;
-                    bucket->objcount = 0;
-
-                    /* Update reserved list. */
-                    LIST_FOR_EACH_ENTRY( wait, &bucket->reserved, struct threadpool_object, u.wait.wait_entry )
-                    {
-                        assert( wait->type == TP_OBJECT_TYPE_WAIT );
-                        wait->u.wait.bucket = other_bucket;
-                    }
-                    list_move_tail( &other_bucket->reserved, &bucket->reserved );
-
-                    /* Update waiting list. */
-                    LIST_FOR_EACH_ENTRY( wait, &bucket->waiting, struct threadpool_object, u.wait.wait_entry )
-                    {
-                        assert( wait->type == TP_OBJECT_TYPE_WAIT );
-                        wait->u.wait.bucket = other_bucket;
-                    }
-                    list_move_tail( &other_bucket->waiting, &bucket->waiting );
-
-                    /* Move bucket to the end, to keep the probability of
-                     * newly added wait objects as small as possible. */
-                    list_remove( &bucket->bucket_entry );
-                    list_add_tail( &waitqueue.buckets, &bucket->bucket_entry );
-
-                    NtSetEvent( other_bucket->update_event, NULL );
-                    break;
-                }
+                if (!keys[i]) continue;
+                wait = wine_server_get_ptr( keys[i] );
+                assert( wait->type == TP_OBJECT_TYPE_WAIT );
+                assert( wait->u.wait.wait_pending );
+                tp_waitqueue_disarm( wait, FALSE );
+                tp_object_submit( wait, TRUE );
             }
         }
+        while (count == sizeof(keys) / sizeof(keys[0]));
     }
 
-    /* Remove this bucket from the list. */
-    list_remove( &bucket->bucket_entry );
-    if (!--waitqueue.num_buckets)
-        assert( list_empty( &waitqueue.buckets ) );
-
+    waitqueue.thread_running = FALSE;
     RtlLeaveCriticalSection( &waitqueue.cs );
 
     TRACE( "terminating wait queue thread\n" );
-
-    assert( bucket->objcount == 0 );
-    assert( list_empty( &bucket->reserved ) );
-    assert( list_empty( &bucket->waiting ) );
-    NtClose( bucket->update_event );
-
-    RtlFreeHeap( GetProcessHeap(), 0, bucket );
     RtlExitUserThread( 0 );
 }
 
 /***********************************************************************
  *           tp_waitqueue_lock    (internal)
+ *
+ * Acquires a lock on the global waitqueue. When the lock is acquired
+ * successfully, it is guaranteed that the wait queue thread is running.
  */
 static NTSTATUS tp_waitqueue_lock( struct threadpool_object *wait )
 {
-    struct waitqueue_bucket *bucket;
-    NTSTATUS status;
-    HANDLE thread;
+    NTSTATUS status = STATUS_SUCCESS;
     assert( wait->type == TP_OBJECT_TYPE_WAIT );
 
-    wait->u.wait.signaled       = 0;
-    wait->u.wait.bucket         = NULL;
-    wait->u.wait.wait_pending   = FALSE;
-    wait->u.wait.timeout        = 0;
-    wait->u.wait.handle         = INVALID_HANDLE_VALUE;
+    wait->u.wait.signaled               = 0;
+    wait->u.wait.wait_initialized       = FALSE;
+    wait->u.wait.wait_pending           = FALSE;
+    wait->u.wait.timeout_entry.index    = TIMER_HEAP_NONE;
+    wait->u.wait.handle                 = INVALID_HANDLE_VALUE;
 
     RtlEnterCriticalSection( &waitqueue.cs );
 
-    /* Try to assign to existing bucket if possible. */
-    LIST_FOR_EACH_ENTRY( bucket, &waitqueue.buckets, struct waitqueue_bucket, bucket_entry )
+    /* The wait set lives as long as the process. */
+    if (!waitqueue.wait_set)
     {
-        if (bucket->objcount < MAXIMUM_WAITQUEUE_OBJECTS)
+        SERVER_START_REQ( create_wait_set )
         {
-            list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-            wait->u.wait.bucket = bucket;
-            bucket->objcount++;
-
-            status = STATUS_SUCCESS;
-            goto out;
+            req->access = SYNCHRONIZE;
+            if (!(status = wine_server_call( req )))
+                waitqueue.wait_set = wine_server_ptr_handle( reply->handle );
         }
+        SERVER_END_REQ;
     }
 
-    /* Create a new bucket and corresponding worker thread. */
-    bucket = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*bucket) );
-    if (!bucket)
+    /* Make sure that the wait queue thread is running. */
+    if (status == STATUS_SUCCESS && !waitqueue.thread_running)
     {
-        status = STATUS_NO_MEMORY;
-        goto out;
+        HANDLE thread;
+        status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                                      waitqueue_thread_proc, NULL, &thread, NULL );
+        if (status == STATUS_SUCCESS)
+        {
+            waitqueue.thread_running = TRUE;
+            NtClose( thread );
+        }
     }
 
-    bucket->objcount = 0;
-    list_init( &bucket->reserved );
-    list_init( &bucket->waiting );
-
-    status = NtCreateEvent( &bucket->update_event, EVENT_ALL_ACCESS,
-                            NULL, SynchronizationEvent, FALSE );
-    if (status)
-    {
-        RtlFreeHeap( GetProcessHeap(), 0, bucket );
-        goto out;
-    }
+    /* Every wait object takes at most one heap entry, make sure arming it can't fail. */
+    if (status == STATUS_SUCCESS && !timer_heap_reserve( &waitqueue.timeouts, waitqueue.objcount + 1 ))
+        status = STATUS_NO_MEMORY;
 
-    status = RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
-                                  waitqueue_thread_proc, bucket, &thread, NULL );
     if (status == STATUS_SUCCESS)
     {
-        list_add_tail( &waitqueue.buckets, &bucket->bucket_entry );
-        waitqueue.num_buckets++;
-
-        list_add_tail( &bucket->reserved, &wait->u.wait.wait_entry );
-        wait->u.wait.bucket = bucket;
-        bucket->objcount++;
-
-        NtClose( thread );
-    }
-    else
-    {
-        NtClose( bucket->update_event );
-        RtlFreeHeap( GetProcessHeap(), 0, bucket );
+        wait->u.wait.wait_initialized = TRUE;
+        waitqueue.objcount++;
     }
 
-out:
     RtlLeaveCriticalSection( &waitqueue.cs );
     return status;
 }
@@ -1617,16 +1761,16 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
     assert( wait->type == TP_OBJECT_TYPE_WAIT );
 
     RtlEnterCriticalSection( &waitqueue.cs );
-    if (wait->u.wait.bucket)
+    if (wait->u.wait.wait_initialized)
     {
-        struct waitqueue_bucket *bucket = wait->u.wait.bucket;
-        assert( bucket->objcount > 0 );
+        tp_waitqueue_disarm( wait, TRUE );
 
-        list_remove( &wait->u.wait.wait_entry );
-        wait->u.wait.bucket = NULL;
-        bucket->objcount--;
+        /* Wake up the wait queue thread so that it can shut down. */
+        assert( waitqueue.objcount > 0 );
+        if (!--waitqueue.objcount)
+            tp_waitqueue_set_member( NULL, NULL );
 
-        NtSetEvent( bucket->update_event, NULL );
+        wait->u.wait.wait_initialized = FALSE;
     }
     RtlLeaveCriticalSection( &waitqueue.cs );
 }
@@ -1639,6 +1783,7 @@ static void tp_waitqueue_unlock( struct threadpool_object *wait )
 static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
 {
     struct threadpool *pool;
+    unsigned int i;
 
     pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
     if (!pool)
@@ -1651,13 +1796,25 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     RtlInitializeCriticalSection( &pool->cs );
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
-    list_init( &pool->pool );
+    pool->num_queues            = min( max( NtCurrentTeb()->Peb->NumberOfProcessors, 1 ), THREADPOOL_MAX_QUEUES );
+    pool->next_queue            = 0;
+    pool->num_pending           = 0;
+
+    for (i = 0; i < pool->num_queues; i++)
+    {
+        RtlInitializeCriticalSection( &pool->queues[i].cs );
+        pool->queues[i].cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool_queue.cs");
+        list_init( &pool->queues[i].objects );
+    }
+
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers           = 500;
     pool->min_workers           = 0;
     pool->num_workers           = 0;
     pool->num_busy_workers      = 0;
+    pool->num_idle_workers      = 0;
+    pool->next_worker           = 0;
 
     TRACE( "allocated threadpool %p\n", pool );
 
@@ -1687,6 +1844,8 @@ static void tp_threadpool_shutdown( struct threadpool *pool )
  */
 static BOOL tp_threadpool_release( struct threadpool *pool )
 {
+    unsigned int i;
+
     if (interlocked_dec( &pool->refcount ))
         return FALSE;
 
@@ -1694,7 +1853,14 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
 
     assert( pool->shutdown );
     assert( !pool->objcount );
-    assert( list_empty( &pool->pool ) );
+    assert( !pool->num_pending );
+
+    for (i = 0; i < pool->num_queues; i++)
+    {
+        assert( list_empty( &pool->queues[i].objects ) );
+        pool->queues[i].cs.DebugInfo->Spare[0] = 0;
+        RtlDeleteCriticalSection( &pool->queues[i].cs );
+    }
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1845,6 +2011,7 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->shutdown                = FALSE;
 
     object->pool                    = pool;
+    object->queue                   = &pool->queues[(ULONG)interlocked_inc( &pool->next_queue ) % pool->num_queues];
     object->group                   = NULL;
     object->userdata                = userdata;
     object->group_cancel_callback   = NULL;
@@ -1916,35 +2083,46 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
 {
     struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
     NTSTATUS status = STATUS_UNSUCCESSFUL;
 
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
-    RtlEnterCriticalSection( &pool->cs );
-
-    /* Start new worker threads if required. */
+    /* Start new worker threads if required. The pool lock is only taken
+     * when all workers appear to be busy. */
     if (pool->num_busy_workers >= pool->num_workers &&
         pool->num_workers < pool->max_workers)
-        status = tp_new_worker_thread( pool );
+    {
+        RtlEnterCriticalSection( &pool->cs );
+        if (pool->num_busy_workers >= pool->num_workers &&
+            pool->num_workers < pool->max_workers)
+            status = tp_new_worker_thread( pool );
+        RtlLeaveCriticalSection( &pool->cs );
+    }
+
+    RtlEnterCriticalSection( &queue->cs );
 
     /* Queue work item and increment refcount. */
     interlocked_inc( &object->refcount );
     if (!object->num_pending_callbacks++)
-        list_add_tail( &pool->pool, &object->pool_entry );
+        list_add_tail( &queue->objects, &object->pool_entry );
+    interlocked_inc( &pool->num_pending );
 
     /* Count how often the object was signaled. */
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
+    RtlLeaveCriticalSection( &queue->cs );
+
+    /* No new thread started - wake up one parked thread. Spinning threads
+     * pick up the work item by themselves. */
+    if (status != STATUS_SUCCESS && pool->num_idle_workers)
     {
-        assert( pool->num_workers > 0 );
+        RtlEnterCriticalSection( &pool->cs );
         RtlWakeConditionVariable( &pool->update_event );
+        RtlLeaveCriticalSection( &pool->cs );
     }
-
-    RtlLeaveCriticalSection( &pool->cs );
 }
 
 /***********************************************************************
@@ -1957,17 +2135,18 @@ static void tp_object_cancel( struct threadpool_object *object )
     struct threadpool *pool = object->pool;
     LONG pending_callbacks = 0;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &object->queue->cs );
     if (object->num_pending_callbacks)
     {
         pending_callbacks = object->num_pending_callbacks;
         object->num_pending_callbacks = 0;
         list_remove( &object->pool_entry );
+        interlocked_xchg_add( &pool->num_pending, -pending_callbacks );
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &object->queue->cs );
 
     while (pending_callbacks--)
         tp_object_release( object );
@@ -1981,20 +2160,20 @@ static void tp_object_cancel( struct threadpool_object *object )
  */
 static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
 {
-    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue = object->queue;
 
-    RtlEnterCriticalSection( &pool->cs );
+    RtlEnterCriticalSection( &queue->cs );
     if (group_wait)
     {
         while (object->num_pending_callbacks || object->num_running_callbacks)
-            RtlSleepConditionVariableCS( &object->group_finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->group_finished_event, &queue->cs, NULL );
     }
     else
     {
         while (object->num_pending_callbacks || object->num_associated_callbacks)
-            RtlSleepConditionVariableCS( &object->finished_event, &pool->cs, NULL );
+            RtlSleepConditionVariableCS( &object->finished_event, &queue->cs, NULL );
     }
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
 }
 
 /***********************************************************************
@@ -2052,6 +2231,90 @@ static BOOL tp_object_release( struct threadpool_object *object )
     return TRUE;
 }
 
+/***********************************************************************
+ *           tp_queue_pop    (internal)
+ *
+ * Returns the next object with pending callbacks, starting with the home
+ * queue of the worker and stealing from the other queues when it is empty.
+ * On success the object queue lock is held.
+ */
+static struct threadpool_object *tp_queue_pop( struct threadpool *pool, unsigned int home )
+{
+    struct threadpool_queue *queue;
+    struct list *ptr;
+    unsigned int i;
+
+    for (i = 0; i < pool->num_queues; i++)
+    {
+        queue = &pool->queues[(home + i) % pool->num_queues];
+        if (list_empty( &queue->objects )) continue;
+
+        RtlEnterCriticalSection( &queue->cs );
+        if ((ptr = list_head( &queue->objects )))
+            return LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+        RtlLeaveCriticalSection( &queue->cs );
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           tp_worker_park    (internal)
+ *
+ * Spins for a while waiting for new work items, then sleeps on the pool
+ * condition variable. Returns FALSE when the worker thread should terminate,
+ * in which case the pool lock is held.
+ */
+static BOOL tp_worker_park( struct threadpool *pool )
+{
+    LARGE_INTEGER timeout;
+    NTSTATUS status;
+    int i;
+
+    if (NtCurrentTeb()->Peb->NumberOfProcessors > 1)
+    {
+        for (i = 0; i < THREADPOOL_SPIN_COUNT; i++)
+        {
+            if (pool->num_pending || pool->shutdown) return TRUE;
+            small_pause();
+        }
+    }
+
+    RtlEnterCriticalSection( &pool->cs );
+
+    /* Shutdown worker thread if requested. */
+    if (pool->shutdown)
+        return FALSE;
+
+    /* Submitters only wake parked workers, make sure nothing was queued
+     * before we registered as idle. */
+    interlocked_inc( &pool->num_idle_workers );
+    if (pool->num_pending)
+    {
+        interlocked_dec( &pool->num_idle_workers );
+        RtlLeaveCriticalSection( &pool->cs );
+        return TRUE;
+    }
+
+    /* Wait for new tasks or until the timeout expires. A thread only terminates
+     * when no new tasks are available, and the number of threads can be
+     * decreased without violating the min_workers limit. An exception is when
+     * min_workers == 0, then objcount is used to detect if the last thread
+     * can be terminated. */
+    timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
+    status = RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout );
+    interlocked_dec( &pool->num_idle_workers );
+
+    if (status == STATUS_TIMEOUT && !pool->num_pending &&
+        (pool->num_workers > max( pool->min_workers, 1 ) ||
+        (!pool->min_workers && !pool->objcount)))
+    {
+        return FALSE;
+    }
+
+    RtlLeaveCriticalSection( &pool->cs );
+    return TRUE;
+}
+
 /***********************************************************************
  *           threadpool_worker_proc    (internal)
  */
@@ -2060,27 +2323,29 @@ static void CALLBACK threadpool_worker_proc( void *param )
     TP_CALLBACK_INSTANCE *callback_instance;
     struct threadpool_instance instance;
     struct threadpool *pool = param;
+    struct threadpool_object *object;
+    struct threadpool_queue *queue;
     TP_WAIT_RESULT wait_result = 0;
-    LARGE_INTEGER timeout;
-    struct list *ptr;
+    unsigned int home;
     NTSTATUS status;
 
     TRACE( "starting worker thread for pool %p\n", pool );
 
-    RtlEnterCriticalSection( &pool->cs );
-    pool->num_busy_workers--;
+    home = (ULONG)interlocked_inc( &pool->next_worker ) % pool->num_queues;
+    interlocked_dec( &pool->num_busy_workers );
     for (;;)
     {
-        while ((ptr = list_head( &pool->pool )))
+        while ((object = tp_queue_pop( pool, home )))
         {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+            queue = object->queue;
             assert( object->num_pending_callbacks > 0 );
 
             /* If further pending callbacks are queued, move the work item to
-             * the end of the pool list. Otherwise remove it from the pool. */
+             * the end of the queue. Otherwise remove it from the queue. */
             list_remove( &object->pool_entry );
             if (--object->num_pending_callbacks)
-                list_add_tail( &pool->pool, &object->pool_entry );
+                list_add_tail( &queue->objects, &object->pool_entry );
+            interlocked_dec( &pool->num_pending );
 
             /* For wait objects check if they were signaled or have timed out. */
             if (object->type == TP_OBJECT_TYPE_WAIT)
@@ -2092,8 +2357,8 @@ static void CALLBACK threadpool_worker_proc( void *param )
             /* Leave critical section and do the actual callback. */
             object->num_associated_callbacks++;
             object->num_running_callbacks++;
-            pool->num_busy_workers++;
-            RtlLeaveCriticalSection( &pool->cs );
+            interlocked_inc( &pool->num_busy_workers );
+            RtlLeaveCriticalSection( &queue->cs );
 
             /* Initialize threadpool instance struct. */
             callback_instance = (TP_CALLBACK_INSTANCE *)&instance;
@@ -2186,8 +2451,8 @@ static void CALLBACK threadpool_worker_proc( void *param )
             }
 
         skip_cleanup:
-            RtlEnterCriticalSection( &pool->cs );
-            pool->num_busy_workers--;
+            interlocked_dec( &pool->num_busy_workers );
+            RtlEnterCriticalSection( &queue->cs );
 
             /* Simple callbacks are automatically shutdown after execution. */
             if (object->type == TP_OBJECT_TYPE_SIMPLE)
@@ -2207,25 +2472,12 @@ static void CALLBACK threadpool_worker_proc( void *param )
                     RtlWakeAllConditionVariable( &object->finished_event );
             }
 
+            RtlLeaveCriticalSection( &queue->cs );
             tp_object_release( object );
         }
 
-        /* Shutdown worker thread if requested. */
-        if (pool->shutdown)
+        if (!tp_worker_park( pool ))
             break;
-
-        /* Wait for new tasks or until the timeout expires. A thread only terminates
-         * when no new tasks are available, and the number of threads can be
-         * decreased without violating the min_workers limit. An exception is when
-         * min_workers == 0, then objcount is used to detect if the last thread
-         * can be terminated. */
-        timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !list_head( &pool->pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
-            (!pool->min_workers && !pool->objcount)))
-        {
-            break;
-        }
     }
     pool->num_workers--;
     RtlLeaveCriticalSection( &pool->cs );
@@ -2486,7 +2738,7 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
 {
     struct threadpool_instance *this = impl_from_TP_CALLBACK_INSTANCE( instance );
     struct threadpool_object *object = this->object;
-    struct threadpool *pool;
+    struct threadpool_queue *queue;
 
     TRACE( "%p\n", instance );
 
@@ -2499,14 +2751,14 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     if (!this->associated)
         return;
 
-    pool = object->pool;
-    RtlEnterCriticalSection( &pool->cs );
+    queue = object->queue;
+    RtlEnterCriticalSection( &queue->cs );
 
     object->num_associated_callbacks--;
     if (!object->num_pending_callbacks && !object->num_associated_callbacks)
         RtlWakeAllConditionVariable( &object->finished_event );
 
-    RtlLeaveCriticalSection( &pool->cs );
+    RtlLeaveCriticalSection( &queue->cs );
     this->associated = FALSE;
 }
 
@@ -2725,7 +2977,6 @@ BOOL WINAPI TpSetPoolMinThreads( TP_POOL *pool, DWORD minimum )
 VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LONG window_length )
 {
     struct threadpool_object *this = impl_from_TP_TIMER( timer );
-    struct threadpool_object *other_timer;
     BOOL submit_timer = FALSE;
     ULONGLONG timestamp;
 
@@ -2764,7 +3015,7 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
     /* First remove existing timeout. */
     if (this->u.timer.timer_pending)
     {
-        list_remove( &this->u.timer.timer_entry );
+        timer_heap_remove( &timerqueue.pending_timers, &this->u.timer.timer_entry );
         this->u.timer.timer_pending = FALSE;
     }
 
@@ -2775,17 +3026,10 @@ VOID WINAPI TpSetTimer( TP_TIMER *timer, LARGE_INTEGER *timeout, LONG period, LO
         this->u.timer.period        = period;
         this->u.timer.window_length = window_length;
 
-        LIST_FOR_EACH_ENTRY( other_timer, &timerqueue.pending_timers,
-                             struct threadpool_object, u.timer.timer_entry )
-        {
-            assert( other_timer->type == TP_OBJECT_TYPE_TIMER );
-            if (this->u.timer.timeout < other_timer->u.timer.timeout)
-                break;
-        }
-        list_add_before( &other_timer->u.timer.timer_entry, &this->u.timer.timer_entry );
+        timer_heap_insert( &timerqueue.pending_timers, &this->u.timer.timer_entry, timestamp );
 
         /* Wake up the timer thread when the timeout has to be updated. */
-        if (list_head( &timerqueue.pending_timers ) == &this->u.timer.timer_entry )
+        if (timer_heap_top( &timerqueue.pending_timers ) == &this->u.timer.timer_entry)
             RtlWakeAllConditionVariable( &timerqueue.update_event );
 
         this->u.timer.timer_pending = TRUE;
@@ -2810,14 +3054,11 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
 
     RtlEnterCriticalSection( &waitqueue.cs );
 
-    assert( this->u.wait.bucket );
+    assert( this->u.wait.wait_initialized );
     this->u.wait.handle = handle;
 
     if (handle || this->u.wait.wait_pending)
     {
-        struct waitqueue_bucket *bucket = this->u.wait.bucket;
-        list_remove( &this->u.wait.wait_entry );
-
         /* Convert relative timeout to absolute timestamp. */
         if (handle && timeout)
         {
@@ -2835,21 +3076,19 @@ VOID WINAPI TpSetWait( TP_WAIT *wait, HANDLE handle, LARGE_INTEGER *timeout )
             }
         }
 
-        /* Add wait object back into one of the queues. */
+        /* Replacing the member of the wait set also drops a pending signal of the old handle. */
+        tp_waitqueue_disarm( this, !handle );
+
         if (handle)
         {
-            list_add_tail( &bucket->waiting, &this->u.wait.wait_entry );
+            NTSTATUS status = tp_waitqueue_set_member( this, handle );
+            if (status)
+                WARN( "failed to wait for %p, status %x\n", handle, status );
+
             this->u.wait.wait_pending = TRUE;
-            this->u.wait.timeout = timestamp;
+            if (timestamp != TIMEOUT_INFINITE)
+                timer_heap_insert( &waitqueue.timeouts, &this->u.wait.timeout_entry, timestamp );
         }
-        else
-        {
-            list_add_tail( &bucket->reserved, &this->u.wait.wait_entry );
-            this->u.wait.wait_pending = FALSE;
-        }
-
-        /* Wake up the wait queue thread. */
-        NtSetEvent( bucket->update_event, NULL );
     }
 
     RtlLeaveCriticalSection( &waitqueue.cs );
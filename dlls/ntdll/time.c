@@ -32,6 +32,8 @@
 #include <string.h>
 #include <limits.h>
 #include <time.h>
+#include <fcntl.h>
+#include <signal.h>
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
@@ -50,6 +52,7 @@
 #include "wine/unicode.h"
 #include "wine/debug.h"
 #include "ntdll_misc.h"
+#include "ddk/wdm.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
 
@@ -126,6 +129,123 @@ static ULONGLONG monotonic_counter(void)
     return now.tv_sec * (ULONGLONG)TICKSPERSEC + now.tv_usec * 10 + TICKS_1601_TO_1970 - server_start_time;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+/* performance counter based on the invariant TSC, when its frequency is known */
+static BOOL use_tsc;
+static ULONGLONG tsc_start;    /* TSC value when the counter was initialized */
+static ULONGLONG tsc_origin;   /* monotonic counter value at that time */
+static ULONGLONG tsc_mult;     /* TICKSPERSEC / TSC frequency, as a 0.64 fixed point value */
+
+static inline void tsc_cpuid( unsigned int ax, unsigned int *p )
+{
+#ifdef __i386__
+    __asm__( "pushl %%ebx\n\t"
+             "cpuid\n\t"
+             "movl %%ebx, %%esi\n\t"
+             "popl %%ebx"
+             : "=a" (p[0]), "=S" (p[1]), "=c" (p[2]), "=d" (p[3])
+             : "0" (ax), "2" (0) );
+#else
+    __asm__( "push %%rbx\n\t"
+             "cpuid\n\t"
+             "movq %%rbx, %%rsi\n\t"
+             "pop %%rbx"
+             : "=a" (p[0]), "=S" (p[1]), "=c" (p[2]), "=d" (p[3])
+             : "0" (ax), "2" (0) );
+#endif
+}
+
+static inline ULONGLONG rdtsc(void)
+{
+    unsigned int lo, hi;
+    __asm__ __volatile__( "rdtsc" : "=a" (lo), "=d" (hi) );
+    return ((ULONGLONG)hi << 32) | lo;
+}
+
+/* return (a * b) >> 64 */
+static inline ULONGLONG mul_shr64( ULONGLONG a, ULONGLONG b )
+{
+    ULONGLONG al = (ULONG)a, ah = a >> 32, bl = (ULONG)b, bh = b >> 32;
+    ULONGLONG lo_lo = al * bl, hi_lo = ah * bl, lo_hi = al * bh, hi_hi = ah * bh;
+    ULONGLONG cross = (lo_lo >> 32) + (ULONG)hi_lo + (ULONG)lo_hi;
+
+    return hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + (cross >> 32);
+}
+
+/* check that the kernel considers the TSC reliable enough to be its clock source */
+static BOOL is_tsc_clocksource(void)
+{
+    static const char tsc[] = "tsc\n";
+    char buffer[16];
+    int fd, len;
+
+    if ((fd = open( "/sys/devices/system/clocksource/clocksource0/current_clocksource", O_RDONLY )) == -1)
+        return FALSE;
+    len = read( fd, buffer, sizeof(buffer) );
+    close( fd );
+    return len == sizeof(tsc) - 1 && !memcmp( buffer, tsc, len );
+}
+
+/***********************************************************************
+ *           init_performance_counter
+ *
+ * Use the TSC for the performance counter if it is invariant and the CPU
+ * reports its exact frequency; otherwise clock_gettime() is used, which
+ * normally doesn't need a syscall either.
+ */
+void init_performance_counter(void)
+{
+    unsigned int regs[4], max_level, i;
+    ULONGLONG freq, rem;
+    const char *env = getenv( "WINEQPCTSC" );
+
+    if (env && !atoi( env )) return;
+
+    tsc_cpuid( 0x80000000, regs );
+    if (regs[0] < 0x80000007) return;
+    tsc_cpuid( 0x80000007, regs );
+    if (!(regs[3] & (1 << 8))) return;  /* no invariant TSC */
+
+    /* leaf 0x15 gives the TSC/crystal clock ratio and the crystal frequency */
+    tsc_cpuid( 0, regs );
+    max_level = regs[0];
+    if (max_level < 0x15) return;
+    tsc_cpuid( 0x15, regs );
+    if (!regs[0] || !regs[1] || !regs[2]) return;
+    freq = (ULONGLONG)regs[2] * regs[1] / regs[0];
+    if (freq <= TICKSPERSEC) return;
+
+    if (!is_tsc_clocksource()) return;
+
+    /* compute TICKSPERSEC * 2^64 / freq by long division */
+    tsc_mult = 0;
+    rem = TICKSPERSEC;
+    for (i = 0; i < 64; i++)
+    {
+        rem <<= 1;
+        tsc_mult <<= 1;
+        if (rem >= freq)
+        {
+            rem -= freq;
+            tsc_mult |= 1;
+        }
+    }
+
+    tsc_origin = monotonic_counter();
+    tsc_start = rdtsc();
+    use_tsc = TRUE;
+    TRACE( "using TSC at %s Hz for the performance counter\n", wine_dbgstr_longlong(freq) );
+}
+
+#else  /* __i386__ || __x86_64__ */
+
+void init_performance_counter(void)
+{
+}
+
+#endif  /* __i386__ || __x86_64__ */
+
 /******************************************************************************
  *       RtlTimeToTimeFields [NTDLL.@]
  *
@@ -481,6 +601,10 @@ NTSTATUS WINAPI NtQueryPerformanceCounter( LARGE_INTEGER *counter, LARGE_INTEGER
 {
     __TRY
     {
+#if defined(__i386__) || defined(__x86_64__)
+        if (use_tsc) counter->QuadPart = tsc_origin + mul_shr64( rdtsc() - tsc_start, tsc_mult );
+        else
+#endif
         counter->QuadPart = monotonic_counter();
         if (frequency) frequency->QuadPart = TICKSPERSEC;
     }
@@ -503,6 +627,75 @@ ULONG WINAPI NtGetTickCount(void)
     return monotonic_counter() / TICKSPERMSEC;
 }
 
+/* readers check that High1Time and High2Time match to detect a torn value */
+static inline void set_ksystem_time( volatile KSYSTEM_TIME *time, LONGLONG value )
+{
+    time->High2Time = value >> 32;
+    time->LowPart   = value;
+    time->High1Time = value >> 32;
+}
+
+static void update_shared_user_data_time(void)
+{
+    ULONGLONG interrupt = monotonic_counter();
+    LARGE_INTEGER now;
+
+    NtQuerySystemTime( &now );
+    set_ksystem_time( &user_shared_data->SystemTime, now.QuadPart );
+    set_ksystem_time( &user_shared_data->InterruptTime, interrupt );
+    set_ksystem_time( &user_shared_data->TickCount, interrupt / TICKSPERMSEC );
+    user_shared_data->TickCountLowDeprecated = interrupt / TICKSPERMSEC;
+}
+
+static void *shared_user_data_thread( void *arg )
+{
+    static const struct timespec delay = { 0, 15625000 };  /* the default timer resolution */
+
+    for (;;)
+    {
+        update_shared_user_data_time();
+        nanosleep( &delay, NULL );
+    }
+    return NULL;
+}
+
+/***********************************************************************
+ *           init_shared_user_data_time
+ *
+ * Start a thread that keeps the time values in the shared user data moving,
+ * some applications read them directly instead of calling the time functions.
+ */
+void init_shared_user_data_time(void)
+{
+    pthread_attr_t attr;
+    pthread_t thread;
+    sigset_t sigset, old_set;
+    SIZE_T size = 0x10000;
+    void *stack = NULL;
+
+    update_shared_user_data_time();
+
+    /* allocate the stack ourselves so that it is accounted for in the address space */
+    if (NtAllocateVirtualMemory( NtCurrentProcess(), &stack, 0, &size,
+                                 MEM_COMMIT | MEM_TOP_DOWN, PAGE_READWRITE ))
+        return;
+
+    /* the thread doesn't have a TEB, it must not receive any signal */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_BLOCK, &sigset, &old_set );
+    pthread_attr_init( &attr );
+    pthread_attr_setstack( &attr, stack, size );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    if (pthread_create( &thread, &attr, shared_user_data_thread, NULL ))
+    {
+        WARN( "failed to start the shared user data thread\n" );
+        size = 0;
+        NtFreeVirtualMemory( NtCurrentProcess(), &stack, &size, MEM_RELEASE );
+    }
+    pthread_attr_destroy( &attr );
+    pthread_sigmask( SIG_SETMASK, &old_set, NULL );
+}
+
 /* calculate the mday of dst change date, so that for instance Sun 5 Oct 2007
  * (last Sunday in October of 2007) becomes Sun Oct 28 2007
  *
@@ -0,0 +1,386 @@
+/*
+ * Asynchronous file I/O through io_uring
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/*
+ * When WINEURING=1 is set and the kernel supports it, overlapped reads and
+ * writes at an explicit offset on regular files are submitted to a process-wide
+ * io_uring instead of being performed synchronously. A dedicated thread reaps
+ * the completions, fills the IO_STATUS_BLOCK, signals the event and posts to
+ * the completion port, without involving the wineserver.
+ *
+ * Requests with an APC routine are not handled here since the APC has to be
+ * queued to the issuing thread; they keep using the synchronous path.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#define NONAMELESSUNION
+#include "windef.h"
+#include "winternl.h"
+#include "wine/server.h"
+#include "wine/debug.h"
+#include "ntdll_misc.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(ntdll);
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+
+#define URING_ENTRIES 256
+#define URING_MAX_IOV 1024
+
+struct uring_request
+{
+    IO_STATUS_BLOCK *io;       /* status block to fill on completion */
+    HANDLE           handle;   /* file handle, for the completion port */
+    HANDLE           event;    /* event to signal */
+    ULONG_PTR        cvalue;   /* completion port value */
+    BOOL             write;
+    ULONGLONG        offset;   /* file offset of the remaining data */
+    ULONG            total;    /* size of the whole transfer */
+    ULONG            done;     /* bytes transferred so far */
+    unsigned int     first;    /* first iovec with remaining data */
+    unsigned int     count;
+    struct iovec     iov[1];
+};
+
+struct uring_queue
+{
+    unsigned int *head;
+    unsigned int *tail;
+    unsigned int *mask;
+    unsigned int *entries;
+};
+
+static int ring_fd = -1;
+static struct uring_queue sq, cq;
+static unsigned int *sq_array;
+static struct io_uring_sqe *sqes;
+static struct io_uring_cqe *cqes;
+static unsigned int in_flight, max_in_flight;
+
+static RTL_CRITICAL_SECTION uring_section;
+static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
+{
+    0, 0, &uring_section,
+    { &critsect_debug.ProcessLocksList, &critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": uring_section") }
+};
+static RTL_CRITICAL_SECTION uring_section = { &critsect_debug, -1, 0, 0, 0, 0 };
+
+static inline int io_uring_setup( unsigned int entries, struct io_uring_params *params )
+{
+    return syscall( __NR_io_uring_setup, entries, params );
+}
+
+static inline int io_uring_enter( unsigned int to_submit, unsigned int min_complete, unsigned int flags )
+{
+    return syscall( __NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0 );
+}
+
+static void complete_request( struct uring_request *req, int res );
+
+/* thread reaping the completion queue */
+static void CALLBACK uring_completion_thread( void *arg )
+{
+    for (;;)
+    {
+        unsigned int head = *cq.head;
+        struct uring_request *req;
+        int res;
+
+        if (head == __atomic_load_n( cq.tail, __ATOMIC_ACQUIRE ))
+        {
+            io_uring_enter( 0, 1, IORING_ENTER_GETEVENTS );
+            continue;
+        }
+        req = (struct uring_request *)(ULONG_PTR)cqes[head & *cq.mask].user_data;
+        res = cqes[head & *cq.mask].res;
+        __atomic_store_n( cq.head, head + 1, __ATOMIC_RELEASE );
+        complete_request( req, res );
+    }
+}
+
+static BOOL init_ring(void)
+{
+    struct io_uring_params params;
+    size_t sq_size, cq_size;
+    char *sq_ptr, *cq_ptr;
+    HANDLE thread;
+
+    memset( &params, 0, sizeof(params) );
+    if ((ring_fd = io_uring_setup( URING_ENTRIES, &params )) == -1)
+    {
+        WARN( "io_uring not available, errno %d\n", errno );
+        return FALSE;
+    }
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) sq_size = cq_size = max( sq_size, cq_size );
+
+    sq_ptr = mmap( NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd, IORING_OFF_SQ_RING );
+    if (sq_ptr == MAP_FAILED) goto failed;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) cq_ptr = sq_ptr;
+    else
+    {
+        cq_ptr = mmap( NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring_fd, IORING_OFF_CQ_RING );
+        if (cq_ptr == MAP_FAILED) goto failed;
+    }
+    sqes = mmap( NULL, params.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES );
+    if (sqes == MAP_FAILED) goto failed;
+
+    sq.head    = (unsigned int *)(sq_ptr + params.sq_off.head);
+    sq.tail    = (unsigned int *)(sq_ptr + params.sq_off.tail);
+    sq.mask    = (unsigned int *)(sq_ptr + params.sq_off.ring_mask);
+    sq.entries = (unsigned int *)(sq_ptr + params.sq_off.ring_entries);
+    sq_array   = (unsigned int *)(sq_ptr + params.sq_off.array);
+    cq.head    = (unsigned int *)(cq_ptr + params.cq_off.head);
+    cq.tail    = (unsigned int *)(cq_ptr + params.cq_off.tail);
+    cq.mask    = (unsigned int *)(cq_ptr + params.cq_off.ring_mask);
+    cq.entries = (unsigned int *)(cq_ptr + params.cq_off.ring_entries);
+    cqes       = (struct io_uring_cqe *)(cq_ptr + params.cq_off.cqes);
+
+    /* never let the completion queue overflow */
+    max_in_flight = params.cq_entries;
+
+    if (RtlCreateUserThread( GetCurrentProcess(), NULL, FALSE, NULL, 0, 0,
+                             uring_completion_thread, NULL, &thread, NULL ))
+        goto failed;
+    NtClose( thread );
+    TRACE( "using io_uring for asynchronous file I/O\n" );
+    return TRUE;
+
+failed:
+    WARN( "failed to set up io_uring, errno %d\n", errno );
+    close( ring_fd );
+    ring_fd = -1;
+    return FALSE;
+}
+
+static BOOL uring_enabled(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEURING" );
+
+        RtlEnterCriticalSection( &uring_section );
+        if (enabled == -1) enabled = env && atoi( env ) && init_ring();
+        RtlLeaveCriticalSection( &uring_section );
+    }
+    return enabled;
+}
+
+/* queue the remaining part of a request; caller must hold uring_section */
+static BOOL submit_request( struct uring_request *req, int fd )
+{
+    unsigned int tail = *sq.tail, idx = tail & *sq.mask;
+    struct io_uring_sqe *sqe = &sqes[idx];
+    int ret;
+
+    memset( sqe, 0, sizeof(*sqe) );
+    sqe->opcode    = req->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd        = fd;
+    sqe->off       = req->offset;
+    sqe->addr      = (ULONG_PTR)&req->iov[req->first];
+    sqe->len       = req->count - req->first;
+    sqe->user_data = (ULONG_PTR)req;
+    sq_array[idx]  = idx;
+    __atomic_store_n( sq.tail, tail + 1, __ATOMIC_RELEASE );
+
+    while ((ret = io_uring_enter( 1, 0, 0 )) == -1 && errno == EINTR);
+    if (ret != 1)
+    {
+        /* the entry was not consumed, take it back */
+        __atomic_store_n( sq.tail, tail, __ATOMIC_RELEASE );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* consume the data transferred from the iovecs, return FALSE once the request is finished */
+static BOOL advance_request( struct uring_request *req, ULONG size )
+{
+    req->done += size;
+    req->offset += size;
+    while (req->first < req->count && size >= req->iov[req->first].iov_len)
+        size -= req->iov[req->first++].iov_len;
+    if (req->first == req->count) return FALSE;
+    req->iov[req->first].iov_base = (char *)req->iov[req->first].iov_base + size;
+    req->iov[req->first].iov_len -= size;
+    return TRUE;
+}
+
+/* read into the remaining iovecs synchronously, handling faults on the user buffers */
+static int read_request_sync( struct uring_request *req )
+{
+    int fd, needs_close, ret = 0;
+
+    if (server_get_unix_fd( req->handle, FILE_READ_DATA, &fd, &needs_close, NULL, NULL ))
+        return -EBADF;
+    while (req->first < req->count)
+    {
+        if ((ret = virtual_locked_pread( fd, req->iov[req->first].iov_base,
+                                         req->iov[req->first].iov_len, req->offset )) <= 0)
+        {
+            if (ret == -1) ret = -errno;
+            break;
+        }
+        advance_request( req, ret );
+    }
+    if (needs_close) close( fd );
+    return ret;
+}
+
+static void complete_request( struct uring_request *req, int res )
+{
+    NTSTATUS status;
+
+    if (res > 0 && advance_request( req, res ))
+    {
+        /* short transfer, queue the rest */
+        int fd, needs_close;
+        BOOL queued = FALSE;
+
+        if (!server_get_unix_fd( req->handle, req->write ? FILE_WRITE_DATA : FILE_READ_DATA,
+                                 &fd, &needs_close, NULL, NULL ))
+        {
+            RtlEnterCriticalSection( &uring_section );
+            queued = submit_request( req, fd );
+            RtlLeaveCriticalSection( &uring_section );
+            if (needs_close) close( fd );
+        }
+        if (queued) return;
+        res = 0;
+    }
+    if (res == -EFAULT && !req->write) res = read_request_sync( req );
+
+    if (res < 0 && !req->done)
+    {
+        if (res == -EFAULT) status = STATUS_INVALID_USER_BUFFER;
+        else
+        {
+            errno = -res;
+            status = FILE_GetNtStatus();
+        }
+    }
+    else if (!req->write && !req->done && req->total) status = STATUS_END_OF_FILE;
+    else status = STATUS_SUCCESS;
+
+    TRACE( "%p: status %08x (%u)\n", req->io, status, req->done );
+    req->io->Information = req->done;
+    __atomic_store_n( &req->io->u.Status, status, __ATOMIC_RELEASE );
+    if (req->event) NtSetEvent( req->event, NULL );
+    if (req->cvalue) NTDLL_AddCompletion( req->handle, req->cvalue, status, req->done );
+
+    RtlEnterCriticalSection( &uring_section );
+    in_flight--;
+    RtlLeaveCriticalSection( &uring_section );
+    RtlFreeHeap( GetProcessHeap(), 0, req );
+}
+
+/***********************************************************************
+ *           uring_submit_rw
+ *
+ * Queue an asynchronous read or write on a regular file.
+ * Returns STATUS_NOT_SUPPORTED if the caller has to perform the I/O itself.
+ */
+NTSTATUS uring_submit_rw( HANDLE handle, int fd, BOOL write, const struct iovec *iov, unsigned int count,
+                          ULONGLONG offset, HANDLE event, ULONG_PTR cvalue, IO_STATUS_BLOCK *io )
+{
+    struct uring_request *req;
+    unsigned int i;
+    BOOL queued = FALSE;
+
+    if (!count || count > URING_MAX_IOV || !uring_enabled()) return STATUS_NOT_SUPPORTED;
+
+    if (!(req = RtlAllocateHeap( GetProcessHeap(), 0, offsetof( struct uring_request, iov[count] ))))
+        return STATUS_NOT_SUPPORTED;
+    req->io     = io;
+    req->handle = handle;
+    req->event  = event;
+    req->cvalue = cvalue;
+    req->write  = write;
+    req->offset = offset;
+    req->total  = 0;
+    req->done   = 0;
+    req->first  = 0;
+    req->count  = count;
+    for (i = 0; i < count; i++)
+    {
+        req->iov[i] = iov[i];
+        req->total += iov[i].iov_len;
+    }
+
+    if (event) NtResetEvent( event, NULL );
+    io->u.Status = STATUS_PENDING;
+    io->Information = 0;
+
+    RtlEnterCriticalSection( &uring_section );
+    if (in_flight < max_in_flight && (queued = submit_request( req, fd ))) in_flight++;
+    RtlLeaveCriticalSection( &uring_section );
+
+    if (!queued)
+    {
+        RtlFreeHeap( GetProcessHeap(), 0, req );
+        return STATUS_NOT_SUPPORTED;
+    }
+    TRACE( "%p: queued %s of %u bytes at %s\n", io, write ? "write" : "read", req->total,
+           wine_dbgstr_longlong( offset ));
+    return STATUS_PENDING;
+}
+
+#else  /* HAVE_LINUX_IO_URING_H */
+
+NTSTATUS uring_submit_rw( HANDLE handle, int fd, BOOL write, const struct iovec *iov, unsigned int count,
+                          ULONGLONG offset, HANDLE event, ULONG_PTR cvalue, IO_STATUS_BLOCK *io )
+{
+    return STATUS_NOT_SUPPORTED;
+}
+
+#endif  /* HAVE_LINUX_IO_URING_H */
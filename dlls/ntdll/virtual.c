@@ -44,6 +44,15 @@
 #ifdef HAVE_SYS_SYSINFO_H
 # include <sys/sysinfo.h>
 #endif
+#ifdef HAVE_SYS_IOCTL_H
+# include <sys/ioctl.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
+#ifdef HAVE_LINUX_USERFAULTFD_H
+# include <linux/userfaultfd.h>
+#endif
 #ifdef HAVE_VALGRIND_VALGRIND_H
 # include <valgrind/valgrind.h>
 #endif
@@ -67,6 +76,9 @@ WINE_DECLARE_DEBUG_CHANNEL(module);
 #define MAP_NORESERVE 0
 #endif
 
+/* low bits of the allocation type holding the preferred NUMA node + 1 */
+#define NUMA_NODE_MASK 0x3f
+
 /* File view */
 struct file_view
 {
@@ -169,6 +181,9 @@ static void *preload_reserve_start;
 static void *preload_reserve_end;
 static BOOL use_locks;
 static BOOL force_exec_prot;  /* whether to force PROT_EXEC on all PROT_READ mmaps */
+static SIZE_T large_page_size;  /* size of large pages, 0 if not supported */
+static BOOL use_thp;  /* whether to use transparent huge pages for big allocations */
+static BOOL share_relocs;  /* whether to share relocated image pages with other processes */
 
 static inline int is_view_valloc( const struct file_view *view )
 {
@@ -926,6 +941,297 @@ static NTSTATUS set_protection( struct file_view *view, void *base, SIZE_T size,
 }
 
 
+#if defined(HAVE_LINUX_USERFAULTFD_H) && defined(__NR_userfaultfd) && defined(UFFDIO_WRITEPROTECT)
+
+/* write watches are tracked by the kernel through asynchronous userfaultfd write protection,
+ * and queried with the PAGEMAP_SCAN ioctl, so that writes don't cause any faults */
+
+#ifndef UFFD_FEATURE_WP_UNPOPULATED
+#define UFFD_FEATURE_WP_UNPOPULATED (1 << 13)
+#endif
+#ifndef UFFD_FEATURE_WP_ASYNC
+#define UFFD_FEATURE_WP_ASYNC (1 << 15)
+#endif
+
+#ifndef PAGEMAP_SCAN
+struct page_region
+{
+    unsigned __int64 start;
+    unsigned __int64 end;
+    unsigned __int64 categories;
+};
+
+struct pm_scan_arg
+{
+    unsigned __int64 size;
+    unsigned __int64 flags;
+    unsigned __int64 start;
+    unsigned __int64 end;
+    unsigned __int64 walk_end;
+    unsigned __int64 vec;
+    unsigned __int64 vec_len;
+    unsigned __int64 max_pages;
+    unsigned __int64 category_inverted;
+    unsigned __int64 category_mask;
+    unsigned __int64 category_anyof_mask;
+    unsigned __int64 return_mask;
+};
+
+#define PAGE_IS_WRITTEN       (1 << 1)
+#define PM_SCAN_WP_MATCHING   (1 << 0)
+#define PM_SCAN_CHECK_WPASYNC (1 << 1)
+#define PAGEMAP_SCAN          _IOWR('f', 16, struct pm_scan_arg)
+#endif
+
+static int uffd_fd = -1;
+static int pagemap_fd = -1;
+
+static inline BOOL use_kernel_write_watches(void)
+{
+    return pagemap_fd != -1;
+}
+
+/***********************************************************************
+ *           kernel_write_protect
+ */
+static BOOL kernel_write_protect( void *base, size_t size )
+{
+    struct uffdio_writeprotect wp;
+
+    wp.range.start = (ULONG_PTR)base;
+    wp.range.len   = size;
+    wp.mode        = UFFDIO_WRITEPROTECT_MODE_WP;
+    return !ioctl( uffd_fd, UFFDIO_WRITEPROTECT, &wp );
+}
+
+/***********************************************************************
+ *           kernel_watch_range
+ *
+ * Register a range for write watching and mark all its pages as not written.
+ */
+static BOOL kernel_watch_range( void *base, size_t size )
+{
+    struct uffdio_register reg;
+
+    reg.range.start = (ULONG_PTR)base;
+    reg.range.len   = size;
+    reg.mode        = UFFDIO_REGISTER_MODE_WP;
+    if (ioctl( uffd_fd, UFFDIO_REGISTER, &reg ) || !kernel_write_protect( base, size ))
+    {
+        ERR( "failed to watch %p-%p, errno %d\n", base, (char *)base + size, errno );
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/***********************************************************************
+ *           kernel_get_write_watches
+ *
+ * Retrieve the addresses of written pages, optionally resetting them at the same time.
+ */
+static void kernel_get_write_watches( void *base, size_t size, void **addresses,
+                                      ULONG_PTR *count, BOOL reset )
+{
+    struct page_region regions[64];
+    struct pm_scan_arg arg;
+    ULONG_PTR pos = 0, page;
+    char *end = (char *)base + size;
+    int i, ret;
+
+    memset( &arg, 0, sizeof(arg) );
+    arg.size          = sizeof(arg);
+    arg.flags         = PM_SCAN_CHECK_WPASYNC | (reset ? PM_SCAN_WP_MATCHING : 0);
+    arg.start         = (ULONG_PTR)base;
+    arg.end           = (ULONG_PTR)end;
+    arg.vec           = (ULONG_PTR)regions;
+    arg.vec_len       = sizeof(regions) / sizeof(regions[0]);
+    arg.category_mask = PAGE_IS_WRITTEN;
+    arg.return_mask   = PAGE_IS_WRITTEN;
+
+    while (pos < *count && arg.start < arg.end)
+    {
+        arg.max_pages = *count - pos;
+        if ((ret = ioctl( pagemap_fd, PAGEMAP_SCAN, &arg )) == -1)
+        {
+            ERR( "PAGEMAP_SCAN failed for %p-%p, errno %d\n", base, end, errno );
+            break;
+        }
+        for (i = 0; i < ret; i++)
+            for (page = regions[i].start; page < regions[i].end && pos < *count; page += page_size)
+                addresses[pos++] = (void *)page;
+        if (arg.walk_end <= arg.start) break;
+        arg.start = arg.walk_end;
+    }
+    *count = pos;
+}
+
+/***********************************************************************
+ *           init_kernel_write_watches
+ */
+static void init_kernel_write_watches(void)
+{
+    static const unsigned __int64 features = UFFD_FEATURE_WP_ASYNC | UFFD_FEATURE_WP_UNPOPULATED;
+    struct page_region region;
+    struct pm_scan_arg arg;
+    struct uffdio_api api;
+    void *page;
+
+    if ((uffd_fd = syscall( __NR_userfaultfd, O_CLOEXEC | O_NONBLOCK )) == -1) return;
+
+    api.api      = UFFD_API;
+    api.features = features;
+    if (ioctl( uffd_fd, UFFDIO_API, &api ) || (api.features & features) != features) goto failed;
+    if ((pagemap_fd = open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC )) == -1) goto failed;
+
+    /* make sure that PAGEMAP_SCAN works on a watched range */
+    if ((page = wine_anon_mmap( NULL, page_size, PROT_READ | PROT_WRITE, 0 )) == (void *)-1) goto failed;
+    memset( &arg, 0, sizeof(arg) );
+    arg.size          = sizeof(arg);
+    arg.flags         = PM_SCAN_CHECK_WPASYNC;
+    arg.start         = (ULONG_PTR)page;
+    arg.end           = (ULONG_PTR)page + page_size;
+    arg.vec           = (ULONG_PTR)&region;
+    arg.vec_len       = 1;
+    arg.category_mask = PAGE_IS_WRITTEN;
+    arg.return_mask   = PAGE_IS_WRITTEN;
+    if (!kernel_watch_range( page, page_size ) || ioctl( pagemap_fd, PAGEMAP_SCAN, &arg ) == -1)
+    {
+        munmap( page, page_size );
+        goto failed;
+    }
+    munmap( page, page_size );
+    TRACE( "using kernel write watches\n" );
+    return;
+
+failed:
+    WARN( "kernel write watches not supported, errno %d\n", errno );
+    if (pagemap_fd != -1) close( pagemap_fd );
+    close( uffd_fd );
+    uffd_fd = pagemap_fd = -1;
+}
+
+#else  /* HAVE_LINUX_USERFAULTFD_H */
+
+static inline BOOL use_kernel_write_watches(void) { return FALSE; }
+static inline BOOL kernel_write_protect( void *base, size_t size ) { return FALSE; }
+static inline BOOL kernel_watch_range( void *base, size_t size ) { return FALSE; }
+static inline void kernel_get_write_watches( void *base, size_t size, void **addresses,
+                                             ULONG_PTR *count, BOOL reset ) { *count = 0; }
+static inline void init_kernel_write_watches(void) { }
+
+#endif  /* HAVE_LINUX_USERFAULTFD_H */
+
+
+/***********************************************************************
+ *           init_large_pages
+ *
+ * Retrieve the size of the large pages provided by the kernel.
+ */
+static void init_large_pages(void)
+{
+#ifdef linux
+    char buffer[64];
+    FILE *f;
+
+    if ((f = fopen( "/proc/meminfo", "r" )))
+    {
+        while (fgets( buffer, sizeof(buffer), f ))
+        {
+            unsigned long kb;
+            if (sscanf( buffer, "Hugepagesize: %lu kB", &kb ) == 1)
+            {
+                large_page_size = (SIZE_T)kb * 1024;
+                break;
+            }
+        }
+        fclose( f );
+    }
+#endif
+#if defined(__i386__) || defined(__x86_64__)
+    if (!large_page_size) large_page_size = 2 * 1024 * 1024;
+#endif
+    /* large pages must be a multiple of the allocation granularity */
+    if (large_page_size & 0xffff) large_page_size = 0;
+    use_thp = large_page_size && getenv( "WINETHP" ) && atoi( getenv( "WINETHP" ) );
+    TRACE( "large page size %lx%s\n", large_page_size, use_thp ? ", using transparent huge pages" : "" );
+    share_relocs = getenv( "WINESHAREDRELOCS" ) && atoi( getenv( "WINESHAREDRELOCS" ) );
+}
+
+
+/***********************************************************************
+ *           virtual_get_large_page_size
+ */
+SIZE_T virtual_get_large_page_size(void)
+{
+    return large_page_size;
+}
+
+
+/***********************************************************************
+ *           map_large_pages
+ *
+ * Back a newly mapped view with large pages. Try hugetlbfs pages first, and fall back
+ * to transparent huge pages if none are available.
+ * The csVirtual section must be held by caller.
+ */
+static void map_large_pages( struct file_view *view, unsigned int vprot )
+{
+    int unix_prot = VIRTUAL_GetUnixProt( vprot );
+
+#ifdef MAP_HUGETLB
+    if (mmap( view->base, view->size, unix_prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB,
+              -1, 0 ) != (void *)-1)
+    {
+        TRACE( "using hugetlb pages for %p-%p\n", view->base, (char *)view->base + view->size );
+        view->protect |= SEC_LARGE_PAGES;
+        return;
+    }
+    /* make sure the range is still mapped if the kernel gave up after unmapping it */
+    wine_anon_mmap( view->base, view->size, unix_prot, MAP_FIXED );
+#endif
+#ifdef MADV_HUGEPAGE
+    madvise( view->base, view->size, MADV_HUGEPAGE );
+    TRACE( "using transparent huge pages for %p-%p\n", view->base, (char *)view->base + view->size );
+#endif
+}
+
+
+/***********************************************************************
+ *           set_preferred_node
+ *
+ * Ask the kernel to back a range with pages from the specified NUMA node if possible.
+ */
+static void set_preferred_node( void *base, size_t size, unsigned int node )
+{
+#if defined(__linux__) && defined(__NR_mbind)
+    static const int mpol_preferred = 1;  /* MPOL_PREFERRED */
+    unsigned long nodemask[64 / sizeof(unsigned long)];
+
+    if (node >= sizeof(nodemask) * 8) return;
+    memset( nodemask, 0, sizeof(nodemask) );
+    nodemask[node / (sizeof(unsigned long) * 8)] |= 1ul << (node % (sizeof(unsigned long) * 8));
+    if (syscall( __NR_mbind, base, size, mpol_preferred, nodemask, sizeof(nodemask) * 8 + 1, 0 ))
+        WARN( "failed to set preferred node %u for %p-%p: %s\n",
+              node, base, (char *)base + size, strerror(errno) );
+#endif
+}
+
+
+/***********************************************************************
+ *           watch_view_range
+ *
+ * Start watching writes on a range of a newly mapped or remapped write watch view.
+ * With kernel write watches, the pages don't need to be write-protected in the page table.
+ */
+static void watch_view_range( void *base, size_t size )
+{
+    if (!use_kernel_write_watches()) return;
+    set_page_vprot_bits( base, size, 0, VPROT_WRITEWATCH );
+    mprotect_range( base, size, 0, 0 );
+    kernel_watch_range( base, size );
+}
+
+
 /***********************************************************************
  *           update_write_watches
  */
@@ -946,6 +1252,11 @@ static void update_write_watches( void *base, size_t size, size_t accessed_size
  */
 static void reset_write_watches( void *base, SIZE_T size )
 {
+    if (use_kernel_write_watches())
+    {
+        kernel_write_protect( base, size );
+        return;
+    }
     set_page_vprot_bits( base, size, VPROT_WRITEWATCH, 0 );
     mprotect_range( base, size, 0, 0 );
 }
@@ -1253,6 +1564,8 @@ static NTSTATUS decommit_pages( struct file_view *view, size_t start, size_t siz
     if (wine_anon_mmap( (char *)view->base + start, size, PROT_NONE, MAP_FIXED ) != (void *)-1)
     {
         set_page_vprot_bits( (char *)view->base + start, size, 0, VPROT_COMMITTED );
+        /* the new mapping isn't registered for write watching */
+        if (view->protect & VPROT_WRITEWATCH) watch_view_range( (char *)view->base + start, size );
         return STATUS_SUCCESS;
     }
     return FILE_GetNtStatus();
@@ -1352,13 +1665,82 @@ static NTSTATUS map_pe_header( void *ptr, size_t size, int fd, BOOL *removable )
 }
 
 
+/***********************************************************************
+ *           get_section_sizes
+ *
+ * Return the size of the memory mapping and file range of a given section.
+ */
+static void get_section_sizes( const IMAGE_SECTION_HEADER *sec, SIZE_T *map_size,
+                               SIZE_T *file_start, SIZE_T *file_size )
+{
+    static const SIZE_T sector_align = 0x1ff;
+
+    if (!sec->Misc.VirtualSize)
+        *map_size = ROUND_SIZE( 0, sec->SizeOfRawData );
+    else
+        *map_size = ROUND_SIZE( 0, sec->Misc.VirtualSize );
+
+    /* file positions are rounded to sector boundaries regardless of OptionalHeader.FileAlignment */
+    *file_start = sec->PointerToRawData & ~sector_align;
+    *file_size = (sec->SizeOfRawData + (sec->PointerToRawData & sector_align) + sector_align) & ~sector_align;
+    if (*file_size > *map_size) *file_size = *map_size;
+}
+
+
+/***********************************************************************
+ *           has_shared_sections
+ */
+static BOOL has_shared_sections( const IMAGE_SECTION_HEADER *sec, unsigned int count )
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++)
+        if ((sec[i].Characteristics & IMAGE_SCN_MEM_SHARED) && (sec[i].Characteristics & IMAGE_SCN_MEM_WRITE))
+            return TRUE;
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *           get_image_relocation
+ *
+ * Get the file holding the relocated pages of an image mapped at 'base'
+ * by another process, if any.
+ */
+static int get_image_relocation( HANDLE hmapping, void *base )
+{
+    obj_handle_t handle = 0;
+    int unix_fd = -1, needs_close;
+
+    SERVER_START_REQ( get_image_relocation )
+    {
+        req->mapping = wine_server_obj_handle( hmapping );
+        req->base    = wine_server_client_ptr( base );
+        if (!wine_server_call( req )) handle = reply->file;
+    }
+    SERVER_END_REQ;
+    if (!handle) return -1;
+
+    if (server_get_unix_fd( wine_server_ptr_handle( handle ), FILE_READ_DATA,
+                            &unix_fd, &needs_close, NULL, NULL ))
+        unix_fd = -1;
+    else if (!needs_close)
+        unix_fd = dup( unix_fd );
+    close_handle( wine_server_ptr_handle( handle ));
+    return unix_fd;
+}
+
+
 /***********************************************************************
  *           map_image
  *
- * Map an executable (PE format) image into memory.
+ * Map an executable (PE format) image into memory. If 'relocated' is
+ * not NULL, the relocated pages of another process may be used when the
+ * image can't be mapped at its preferred base.
  */
 static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T mask,
-                           pe_image_info_t *image_info, int shared_fd, BOOL removable, PVOID *addr_ptr )
+                           pe_image_info_t *image_info, int shared_fd, BOOL removable, PVOID *addr_ptr,
+                           BOOL *relocated )
 {
     IMAGE_DOS_HEADER *dos;
     IMAGE_NT_HEADERS *nt;
@@ -1367,7 +1749,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
     IMAGE_DATA_DIRECTORY *imports;
     NTSTATUS status = STATUS_CONFLICTING_ADDRESSES;
     SIZE_T header_size, total_size = image_info->map_size;
-    int i;
+    int i, reloc_fd = -1;
     off_t pos;
     sigset_t sigset;
     struct stat st;
@@ -1453,6 +1835,12 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
     }
 
 
+    /* use the pages relocated by another process if it mapped the image at the same address */
+
+    if (relocated && share_relocs && ptr != base &&
+        !has_shared_sections( sections, nt->FileHeader.NumberOfSections ))
+        reloc_fd = get_image_relocation( hmapping, ptr );
+
     /* map all the sections */
 
     for (i = pos = 0; i < nt->FileHeader.NumberOfSections; i++, sec++)
@@ -1460,15 +1848,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
         static const SIZE_T sector_align = 0x1ff;
         SIZE_T map_size, file_start, file_size, end;
 
-        if (!sec->Misc.VirtualSize)
-            map_size = ROUND_SIZE( 0, sec->SizeOfRawData );
-        else
-            map_size = ROUND_SIZE( 0, sec->Misc.VirtualSize );
-
-        /* file positions are rounded to sector boundaries regardless of OptionalHeader.FileAlignment */
-        file_start = sec->PointerToRawData & ~sector_align;
-        file_size = (sec->SizeOfRawData + (sec->PointerToRawData & sector_align) + sector_align) & ~sector_align;
-        if (file_size > map_size) file_size = map_size;
+        get_section_sizes( sec, &map_size, &file_start, &file_size );
 
         /* a few sanity checks */
         end = sec->VirtualAddress + ROUND_SIZE( sec->VirtualAddress, map_size );
@@ -1516,6 +1896,19 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
 
         if (!sec->PointerToRawData || !file_size) continue;
 
+        if (reloc_fd != -1)
+        {
+            /* the relocated file has the image layout, with the section tails already cleared */
+            end = min( ROUND_SIZE( 0, file_size ), map_size );
+            if (map_file_into_view( view, reloc_fd, sec->VirtualAddress, end, sec->VirtualAddress,
+                                    VPROT_COMMITTED | VPROT_READ | VPROT_WRITECOPY, FALSE ) != STATUS_SUCCESS)
+            {
+                ERR_(module)( "Could not map relocated section %.8s\n", sec->Name );
+                goto error;
+            }
+            continue;
+        }
+
         /* Note: if the section is not aligned properly map_file_into_view will magically
          *       fall back to read(), so we don't need to check anything here.
          */
@@ -1588,6 +1981,12 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
     VIRTUAL_DEBUG_DUMP_VIEW( view );
     server_leave_uninterrupted_section( &csVirtual, &sigset );
 
+    if (reloc_fd != -1)
+    {
+        TRACE_(module)( "using shared relocated pages at %p\n", ptr );
+        close( reloc_fd );
+        *relocated = TRUE;
+    }
     *addr_ptr = ptr;
 #ifdef VALGRIND_LOAD_PDB_DEBUGINFO
     VALGRIND_LOAD_PDB_DEBUGINFO(fd, ptr, total_size, ptr - base);
@@ -1598,10 +1997,75 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
  error:
     if (view) delete_view( view );
     server_leave_uninterrupted_section( &csVirtual, &sigset );
+    if (reloc_fd != -1) close( reloc_fd );
     return status;
 }
 
 
+/***********************************************************************
+ *           virtual_share_image_relocations
+ *
+ * Make the pages of a freshly relocated image available to the other
+ * processes that map it at the same address. Must be called before
+ * anything else is written to the image.
+ */
+void virtual_share_image_relocations( void *module )
+{
+    IMAGE_NT_HEADERS *nt = RtlImageNtHeader( module );
+    const IMAGE_SECTION_HEADER *sec;
+    SIZE_T map_size, file_start, file_size, end;
+    obj_handle_t handle = 0;
+    int i, unix_fd, needs_close;
+    BOOL ok = TRUE;
+
+    if (!share_relocs || !nt) return;
+
+    sec = (const IMAGE_SECTION_HEADER *)((char *)&nt->OptionalHeader + nt->FileHeader.SizeOfOptionalHeader);
+    if (has_shared_sections( sec, nt->FileHeader.NumberOfSections )) return;
+    for (i = 0; i < nt->FileHeader.NumberOfSections; i++)
+    {
+        if (!sec[i].PointerToRawData || !sec[i].SizeOfRawData) continue;
+        if (!(sec[i].Characteristics & IMAGE_SCN_MEM_READ)) return;
+        if (sec[i].VirtualAddress & page_mask) return;
+    }
+
+    SERVER_START_REQ( create_image_relocation )
+    {
+        req->base = wine_server_client_ptr( module );
+        if (!wine_server_call( req )) handle = reply->file;
+    }
+    SERVER_END_REQ;
+    if (!handle) return;
+
+    if (server_get_unix_fd( wine_server_ptr_handle( handle ), FILE_WRITE_DATA,
+                            &unix_fd, &needs_close, NULL, NULL ))
+    {
+        close_handle( wine_server_ptr_handle( handle ));
+        return;
+    }
+
+    for (i = 0; ok && i < nt->FileHeader.NumberOfSections; i++)
+    {
+        get_section_sizes( &sec[i], &map_size, &file_start, &file_size );
+        if (!sec[i].PointerToRawData || !file_size) continue;
+        end = min( ROUND_SIZE( 0, file_size ), map_size );
+        ok = (pwrite( unix_fd, (char *)module + sec[i].VirtualAddress, end,
+                      sec[i].VirtualAddress ) == end);
+    }
+    if (needs_close) close( unix_fd );
+    close_handle( wine_server_ptr_handle( handle ));
+    if (!ok) return;
+
+    SERVER_START_REQ( commit_image_relocation )
+    {
+        req->base = wine_server_client_ptr( module );
+        wine_server_call( req );
+    }
+    SERVER_END_REQ;
+    TRACE_(module)( "shared relocated pages of %p\n", module );
+}
+
+
 /***********************************************************************
  *             virtual_map_section
  *
@@ -1609,7 +2073,7 @@ static NTSTATUS map_image( HANDLE hmapping, ACCESS_MASK access, int fd, SIZE_T m
  */
 NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, SIZE_T commit_size,
                               const LARGE_INTEGER *offset_ptr, SIZE_T *size_ptr, ULONG protect,
-                              pe_image_info_t *image_info )
+                              pe_image_info_t *image_info, BOOL *relocated )
 {
     NTSTATUS res;
     mem_size_t full_size;
@@ -1670,13 +2134,14 @@ NTSTATUS virtual_map_section( HANDLE handle, PVOID *addr_ptr, ULONG zero_bits, S
             if ((res = server_get_unix_fd( shared_file, FILE_READ_DATA|FILE_WRITE_DATA,
                                            &shared_fd, &shared_needs_close, NULL, NULL ))) goto done;
             res = map_image( handle, access, unix_handle, mask, image_info,
-                             shared_fd, needs_close, addr_ptr );
+                             shared_fd, needs_close, addr_ptr, relocated );
             if (shared_needs_close) close( shared_fd );
             close_handle( shared_file );
         }
         else
         {
-            res = map_image( handle, access, unix_handle, mask, image_info, -1, needs_close, addr_ptr );
+            res = map_image( handle, access, unix_handle, mask, image_info, -1, needs_close,
+                             addr_ptr, relocated );
         }
         if (needs_close) close( unix_handle );
         if (res >= 0) *size_ptr = image_info->map_size;
@@ -1831,6 +2296,8 @@ void virtual_init(void)
     view_block_end = view_block_start + view_block_size / sizeof(*view_block_start);
     pages_vprot = (void *)((char *)alloc_views.base + view_block_size);
     wine_rb_init( &views_tree, compare_view );
+    init_kernel_write_watches();
+    init_large_pages();
 
     /* make the DOS area accessible (except the low 64K) to hide bugs in broken apps like Excel 2003 */
     size = (char *)address_space_start - (char *)0x10000;
@@ -2462,6 +2929,7 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
     NTSTATUS status = STATUS_SUCCESS;
     BOOL is_dos_memory = FALSE;
     struct file_view *view;
+    unsigned int node;
     sigset_t sigset;
 
     TRACE("%p %p %08lx %x %08x\n", process, *ret, size, type, protect );
@@ -2523,13 +2991,28 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
 
     /* Compute the alloc type flags */
 
+    node = type & NUMA_NODE_MASK;  /* preferred node + 1, as passed by VirtualAllocExNuma */
+    type &= ~NUMA_NODE_MASK;
+
     if (!(type & (MEM_COMMIT | MEM_RESERVE | MEM_RESET)) ||
-        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET)))
+        (type & ~(MEM_COMMIT | MEM_RESERVE | MEM_TOP_DOWN | MEM_WRITE_WATCH | MEM_RESET | MEM_LARGE_PAGES)))
     {
         WARN("called with wrong alloc type flags (%08x) !\n", type);
         return STATUS_INVALID_PARAMETER;
     }
 
+    if (type & MEM_LARGE_PAGES)
+    {
+        /* large pages must be reserved and committed at once, in whole large pages */
+        if (!large_page_size || (type & (MEM_COMMIT | MEM_RESERVE)) != (MEM_COMMIT | MEM_RESERVE) ||
+            (type & MEM_WRITE_WATCH) || (size & (large_page_size - 1)) ||
+            ((UINT_PTR)base & (large_page_size - 1)))
+            return STATUS_INVALID_PARAMETER;
+        mask |= large_page_size - 1;
+    }
+    else if (use_thp && !base && (type & MEM_COMMIT) && size >= 2 * large_page_size)
+        mask |= large_page_size - 1;  /* align so that the range can be backed by huge pages */
+
     /* Reserve the memory */
 
     if (use_locks) server_enter_uninterrupted_section( &csVirtual, &sigset );
@@ -2546,7 +3029,16 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
             else if (is_dos_memory) status = allocate_dos_memory( &view, vprot );
             else status = map_view( &view, base, size, mask, type & MEM_TOP_DOWN, vprot );
 
-            if (status == STATUS_SUCCESS) base = view->base;
+            if (status == STATUS_SUCCESS)
+            {
+                base = view->base;
+                if (vprot & VPROT_WRITEWATCH) watch_view_range( view->base, view->size );
+                if (type & MEM_LARGE_PAGES) map_large_pages( view, vprot );
+#ifdef MADV_HUGEPAGE
+                else if (use_thp && (type & MEM_COMMIT) && size >= 2 * large_page_size)
+                    madvise( view->base, view->size, MADV_HUGEPAGE );
+#endif
+            }
         }
     }
     else if (type & MEM_RESET)
@@ -2571,7 +3063,11 @@ NTSTATUS WINAPI NtAllocateVirtualMemory( HANDLE process, PVOID *ret, ULONG zero_
         }
     }
 
-    if (!status) VIRTUAL_DEBUG_DUMP_VIEW( view );
+    if (!status)
+    {
+        if (node && !is_dos_memory) set_preferred_node( base, size, node - 1 );
+        VIRTUAL_DEBUG_DUMP_VIEW( view );
+    }
 
     if (use_locks) server_leave_uninterrupted_section( &csVirtual, &sigset );
 
@@ -2785,6 +3281,63 @@ static int get_free_mem_state_callback( void *start, size_t size, void *arg )
         FIXME("(process=%p,addr=%p) Unimplemented information class: " #c "\n", process, addr); \
         return STATUS_INVALID_INFO_CLASS
 
+/***********************************************************************
+ *           get_working_set_ex
+ *
+ * Fill the MemoryWorkingSetExInformation entries for the current process.
+ */
+static NTSTATUS get_working_set_ex( MEMORY_WORKING_SET_EX_INFORMATION *info, SIZE_T len, SIZE_T *res_len )
+{
+    MEMORY_WORKING_SET_EX_INFORMATION *p;
+    struct file_view *view;
+    sigset_t sigset;
+    int fd;
+
+    if (len < sizeof(*info)) return STATUS_INFO_LENGTH_MISMATCH;
+
+    fd = open( "/proc/self/pagemap", O_RDONLY | O_CLOEXEC );
+
+    server_enter_uninterrupted_section( &csVirtual, &sigset );
+    for (p = info; (char *)(p + 1) <= (char *)info + len; p++)
+    {
+        char *addr = ROUND_ADDR( p->VirtualAddress, page_mask );
+        BYTE vprot;
+
+        p->VirtualAttributes.Flags = 0;
+        if (!(view = VIRTUAL_FindView( addr, 0 ))) continue;
+        vprot = get_page_vprot( addr );
+        if (!(vprot & VPROT_COMMITTED)) continue;
+
+        if (fd != -1)
+        {
+            unsigned __int64 entry;
+
+            if (pread( fd, &entry, sizeof(entry), ((UINT_PTR)addr >> page_shift) * sizeof(entry) ) == sizeof(entry))
+                p->VirtualAttributes.Valid = entry >> 63;
+        }
+        else p->VirtualAttributes.Valid = 1;
+
+        if (p->VirtualAttributes.Valid)
+        {
+            p->VirtualAttributes.Win32Protection = VIRTUAL_GetWin32Prot( vprot, view->protect );
+            p->VirtualAttributes.Shared = !is_view_valloc( view );
+            p->VirtualAttributes.ShareCount = p->VirtualAttributes.Shared;
+            if (view->protect & SEC_LARGE_PAGES)
+            {
+                /* hugetlb pages can't be swapped out */
+                p->VirtualAttributes.Locked = 1;
+                p->VirtualAttributes.LargePage = 1;
+            }
+        }
+    }
+    server_leave_uninterrupted_section( &csVirtual, &sigset );
+
+    if (fd != -1) close( fd );
+    if (res_len) *res_len = (char *)p - (char *)info;
+    return STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *             NtQueryVirtualMemory   (NTDLL.@)
  *             ZwQueryVirtualMemory   (NTDLL.@)
@@ -2799,6 +3352,17 @@ NTSTATUS WINAPI NtQueryVirtualMemory( HANDLE process, LPCVOID addr,
     MEMORY_BASIC_INFORMATION *info = buffer;
     sigset_t sigset;
 
+    if (info_class == MemoryWorkingSetExInformation)
+    {
+        if (process != NtCurrentProcess())
+        {
+            FIXME( "(%p,%p,info_class=%d,%p,%ld,%p) not supported for other processes\n",
+                   process, addr, info_class, buffer, len, res_len );
+            return STATUS_NOT_IMPLEMENTED;
+        }
+        return get_working_set_ex( buffer, len, res_len );
+    }
+
     if (info_class != MemoryBasicInformation)
     {
         switch(info_class)
@@ -3122,7 +3686,7 @@ NTSTATUS WINAPI NtMapViewOfSection( HANDLE handle, HANDLE process, PVOID *addr_p
     }
 
     return virtual_map_section( handle, addr_ptr, zero_bits, commit_size,
-                                offset_ptr, size_ptr, protect, &image_info );
+                                offset_ptr, size_ptr, protect, &image_info, NULL );
 }
 
 
@@ -3325,7 +3889,12 @@ NTSTATUS WINAPI NtGetWriteWatch( HANDLE process, ULONG flags, PVOID base, SIZE_T
 
     server_enter_uninterrupted_section( &csVirtual, &sigset );
 
-    if (is_write_watch_range( base, size ))
+    if (is_write_watch_range( base, size ) && use_kernel_write_watches())
+    {
+        kernel_get_write_watches( base, size, addresses, count, flags & WRITE_WATCH_FLAG_RESET );
+        *granularity = page_size;
+    }
+    else if (is_write_watch_range( base, size ))
     {
         ULONG_PTR pos = 0;
         char *addr = base;
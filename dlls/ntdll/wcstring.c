@@ -28,6 +28,9 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "windef.h"
 #include "winternl.h"
@@ -101,6 +104,26 @@ LPWSTR __cdecl NTDLL_wcscat( LPWSTR dst, LPCWSTR src )
  */
 LPWSTR __cdecl NTDLL_wcschr( LPCWSTR str, WCHAR ch )
 {
+#ifdef __SSE2__
+    /* only use aligned loads so that we never read past the page containing the terminator */
+    if (!((ULONG_PTR)str & 1))
+    {
+        const __m128i zero = _mm_setzero_si128(), chars = _mm_set1_epi16( ch );
+
+        for (; (ULONG_PTR)str & 15; str++)
+        {
+            if (*str == ch) return (WCHAR *)str;
+            if (!*str) return NULL;
+        }
+        for (;;)
+        {
+            __m128i v = _mm_load_si128( (const __m128i *)str );
+            if (_mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi16( v, zero ),
+                                                 _mm_cmpeq_epi16( v, chars )))) break;
+            str += 8;
+        }
+    }
+#endif
     return strchrW( str, ch );
 }
 
@@ -137,7 +160,26 @@ INT __cdecl NTDLL_wcscspn( LPCWSTR str, LPCWSTR reject )
  */
 INT __cdecl NTDLL_wcslen( LPCWSTR str )
 {
+#ifdef __SSE2__
+    const WCHAR *s = str;
+
+    /* only use aligned loads so that we never read past the page containing the terminator */
+    if (!((ULONG_PTR)s & 1))
+    {
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; (ULONG_PTR)s & 15; s++) if (!*s) return s - str;
+        for (;;)
+        {
+            __m128i v = _mm_load_si128( (const __m128i *)s );
+            if (_mm_movemask_epi8( _mm_cmpeq_epi16( v, zero ))) break;
+            s += 8;
+        }
+    }
+    return s - str + strlenW( s );
+#else
     return strlenW( str );
+#endif
 }
 
 
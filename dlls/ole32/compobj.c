@@ -632,7 +632,7 @@ static APARTMENT *apartment_construct(DWORD model)
     apt->tid = GetCurrentThreadId();
 
     list_init(&apt->proxies);
-    list_init(&apt->stubmgrs);
+    apartment_init_stub_managers(apt);
     list_init(&apt->loaded_dlls);
     apt->ipidc = 0;
     apt->refs = 1;
@@ -31,6 +31,7 @@
 
 #include "wine/list.h"
 #include "wine/heap.h"
+#include "wine/rbtree.h"
 
 #include "windef.h"
 #include "winbase.h"
@@ -74,6 +75,8 @@ typedef enum ifstub_state
 struct ifstub   
 {
     struct list       entry;      /* entry in stub_manager->ifstubs list (CS stub_manager->lock) */
+    struct wine_rb_entry ipid_entry; /* entry in apartment ifstub_ipids tree (CS apt->cs) */
+    struct stub_manager *manager; /* owning stub manager (RO) */
     IRpcStubBuffer   *stubbuffer; /* RO */
     IID               iid;        /* RO */
     IPID              ipid;       /* RO */
@@ -87,6 +90,8 @@ struct ifstub
 struct stub_manager
 {
     struct list       entry;      /* entry in apartment stubmgr list (CS apt->cs) */
+    struct wine_rb_entry oid_entry;    /* entry in apartment stubmgr_oids tree (CS apt->cs) */
+    struct wine_rb_entry object_entry; /* entry in apartment stubmgr_objects tree (CS apt->cs) */
     struct list       ifstubs;    /* list of active ifstubs for the object (CS lock) */
     CRITICAL_SECTION  lock;
     APARTMENT        *apt;        /* owning apt (RO) */
@@ -136,6 +141,9 @@ struct apartment
   CRITICAL_SECTION cs;     /* thread safety */
   struct list proxies;     /* imported objects (CS cs) */
   struct list stubmgrs;    /* stub managers for exported objects (CS cs) */
+  struct wine_rb_tree stubmgr_oids;    /* stub managers indexed by OID (CS cs) */
+  struct wine_rb_tree stubmgr_objects; /* stub managers indexed by object (CS cs) */
+  struct wine_rb_tree ifstub_ipids;    /* ifstubs of all stub managers indexed by IPID (CS cs) */
   BOOL remunk_exported;    /* has the IRemUnknown interface for this apartment been created yet? (CS cs) */
   LONG remoting_started;   /* has the RPC system been started for this apartment? (LOCK) */
   struct list loaded_dlls; /* list of dlls loaded by this apartment (CS cs) */
@@ -185,6 +193,7 @@ HRESULT FTMarshalCF_Create(REFIID riid, LPVOID *ppv) DECLSPEC_HIDDEN;
 
 /* Stub Manager */
 
+void apartment_init_stub_managers(APARTMENT *apt) DECLSPEC_HIDDEN;
 ULONG stub_manager_int_release(struct stub_manager *This) DECLSPEC_HIDDEN;
 ULONG stub_manager_ext_addref(struct stub_manager *m, ULONG refs, BOOL tableweak) DECLSPEC_HIDDEN;
 ULONG stub_manager_ext_release(struct stub_manager *m, ULONG refs, BOOL tableweak, BOOL last_unlock_releases) DECLSPEC_HIDDEN;
@@ -4030,6 +4030,7 @@ static HRESULT StorageImpl_GetNextBlockInChain(
   BYTE depotBuffer[MAX_BIG_BLOCK_SIZE];
   ULONG read;
   ULONG depotBlockIndexPos;
+  struct BlockDepotCacheEntry *entry;
   int index, num_blocks;
 
   *nextBlockIndex   = BLOCK_SPECIAL;
@@ -4042,12 +4043,23 @@ static HRESULT StorageImpl_GetNextBlockInChain(
   }
 
   /*
-   * Cache the currently accessed depot block.
+   * Look for the depot block in the cache, replacing the least recently
+   * used entry if it's not there.
    */
-  if (depotBlockCount != This->indexBlockDepotCached)
+  entry = &This->blockDepotCache[0];
+  for (index = 0; index < BLOCKDEPOT_CACHE_SIZE; index++)
   {
-    This->indexBlockDepotCached = depotBlockCount;
+    if (This->blockDepotCache[index].index == depotBlockCount)
+    {
+      entry = &This->blockDepotCache[index];
+      break;
+    }
+    if (This->blockDepotCache[index].lastUse < entry->lastUse)
+      entry = &This->blockDepotCache[index];
+  }
 
+  if (entry->index != depotBlockCount)
+  {
     if (depotBlockCount < COUNT_BBDEPOTINHEADER)
     {
       depotBlockIndexPos = This->bigBlockDepotStart[depotBlockCount];
@@ -4060,6 +4072,7 @@ static HRESULT StorageImpl_GetNextBlockInChain(
       depotBlockIndexPos = Storage32Impl_GetExtDepotBlock(This, depotBlockCount);
     }
 
+    entry->index = 0xFFFFFFFF;
     StorageImpl_ReadBigBlock(This, depotBlockIndexPos, depotBuffer, &read);
 
     if (!read)
@@ -4068,13 +4081,12 @@ static HRESULT StorageImpl_GetNextBlockInChain(
     num_blocks = This->bigBlockSize / 4;
 
     for (index = 0; index < num_blocks; index++)
-    {
-      StorageUtl_ReadDWord(depotBuffer, index*sizeof(ULONG), nextBlockIndex);
-      This->blockDepotCached[index] = *nextBlockIndex;
-    }
+      StorageUtl_ReadDWord(depotBuffer, index*sizeof(ULONG), &entry->data[index]);
+    entry->index = depotBlockCount;
   }
 
-  *nextBlockIndex = This->blockDepotCached[depotBlockOffset/sizeof(ULONG)];
+  entry->lastUse = ++This->blockDepotCacheUse;
+  *nextBlockIndex = entry->data[depotBlockOffset/sizeof(ULONG)];
 
   return S_OK;
 }
@@ -4128,6 +4140,7 @@ static void StorageImpl_SetNextBlockInChain(
   ULONG depotBlockCount  = offsetInDepot / This->bigBlockSize;
   ULONG depotBlockOffset = offsetInDepot % This->bigBlockSize;
   ULONG depotBlockIndexPos;
+  int i;
 
   assert(depotBlockCount < This->bigBlockDepotCount);
   assert(blockIndex != nextBlock);
@@ -4156,9 +4169,13 @@ static void StorageImpl_SetNextBlockInChain(
   /*
    * Update the cached block depot, if necessary.
    */
-  if (depotBlockCount == This->indexBlockDepotCached)
+  for (i = 0; i < BLOCKDEPOT_CACHE_SIZE; i++)
   {
-    This->blockDepotCached[depotBlockOffset/sizeof(ULONG)] = nextBlock;
+    if (This->blockDepotCache[i].index == depotBlockCount)
+    {
+      This->blockDepotCache[i].data[depotBlockOffset/sizeof(ULONG)] = nextBlock;
+      break;
+    }
   }
 }
 
@@ -4627,6 +4644,7 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
   DirEntry currentEntry;
   DirRef      currentEntryRef;
   BlockChainStream *blockChainStream;
+  int i;
 
   if (create)
   {
@@ -4693,8 +4711,14 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
   /*
    * There is no block depot cached yet.
    */
-  This->indexBlockDepotCached = 0xFFFFFFFF;
+  for (i = 0; i < BLOCKDEPOT_CACHE_SIZE; i++)
+  {
+    This->blockDepotCache[i].index = 0xFFFFFFFF;
+    This->blockDepotCache[i].lastUse = 0;
+  }
+  This->blockDepotCacheUse = 0;
   This->indexExtBlockDepotCached = 0xFFFFFFFF;
+  This->smallBlockCursorHead = BLOCK_END_OF_CHAIN;
 
   /*
    * Start searching for free blocks with block 0.
@@ -7212,6 +7236,11 @@ static ULONG BlockChainStream_GetSectorOfOffset(BlockChainStream *This, ULONG of
   return This->indexCache[min_run].firstSector + offset - This->indexCache[min_run].firstOffset;
 }
 
+static BOOL BlockChainStream_IsBlockCached(BlockChainStream *This, ULONG index)
+{
+  return This->cachedBlocks[0].index == index || This->cachedBlocks[1].index == index;
+}
+
 static HRESULT BlockChainStream_GetBlockAtOffset(BlockChainStream *This,
     ULONG index, BlockChainBlock **block, ULONG *sector, BOOL create)
 {
@@ -7642,6 +7671,7 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
   {
     ULARGE_INTEGER ulOffset;
     DWORD bytesReadAt;
+    ULONG blockCount = 1;
 
     /*
      * Calculate how many bytes we can copy from this big block.
@@ -7656,7 +7686,17 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
 
     if (!cachedBlock)
     {
-      /* Not in cache, and we're going to read past the end of the block. */
+      /* Not in cache, and we're going to read past the end of the block.
+       * Extend the read over the following blocks while they are stored in
+       * consecutive sectors, except for the last one that goes to the cache. */
+      while (size - bytesToReadInBuffer > This->parentStorage->bigBlockSize &&
+             BlockChainStream_GetSectorOfOffset(This, blockNoInSequence + blockCount) == blockIndex + blockCount &&
+             !BlockChainStream_IsBlockCached(This, blockNoInSequence + blockCount))
+      {
+        bytesToReadInBuffer += This->parentStorage->bigBlockSize;
+        blockCount++;
+      }
+
       ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex) +
                                offsetInBlock;
 
@@ -7681,7 +7721,7 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
       bytesReadAt = bytesToReadInBuffer;
     }
 
-    blockNoInSequence++;
+    blockNoInSequence += blockCount;
     bufferWalker += bytesReadAt;
     size         -= bytesReadAt;
     *bytesRead   += bytesReadAt;
@@ -7899,6 +7939,9 @@ static void SmallBlockChainStream_SetNextBlockInChain(
 
   StorageUtl_WriteDWord((BYTE *)&buffer, 0, nextBlock);
 
+  /* The chain layout changes, forget the last read position. */
+  This->parentStorage->smallBlockCursorHead = BLOCK_END_OF_CHAIN;
+
   /*
    * Read those bytes in the buffer from the small block file.
    */
@@ -8050,10 +8093,11 @@ HRESULT SmallBlockChainStream_ReadAt(
 
   ULONG offsetInBlock = offset.u.LowPart % This->parentStorage->smallBlockSize;
   ULONG bytesToReadInBuffer;
-  ULONG blockIndex;
+  ULONG blockIndex, headIndex, blockNo;
   ULONG bytesReadFromBigBlockFile;
   BYTE* bufferWalker;
   ULARGE_INTEGER stream_size;
+  StorageImpl* storage = This->parentStorage;
 
   /*
    * This should never happen on a small block file.
@@ -8069,16 +8113,25 @@ HRESULT SmallBlockChainStream_ReadAt(
     return S_OK;
 
   /*
-   * Find the first block in the stream that contains part of the buffer.
+   * Find the first block in the stream that contains part of the buffer,
+   * starting from where the previous read of this chain stopped if possible.
    */
-  blockIndex = SmallBlockChainStream_GetHeadOfChain(This);
+  headIndex = blockIndex = SmallBlockChainStream_GetHeadOfChain(This);
+  blockNo = 0;
 
-  while ( (blockNoInSequence > 0) &&  (blockIndex != BLOCK_END_OF_CHAIN))
+  if (headIndex != BLOCK_END_OF_CHAIN && storage->smallBlockCursorHead == headIndex &&
+      storage->smallBlockCursorOffset <= blockNoInSequence)
+  {
+    blockIndex = storage->smallBlockCursorBlock;
+    blockNo = storage->smallBlockCursorOffset;
+  }
+
+  while ( (blockNo < blockNoInSequence) &&  (blockIndex != BLOCK_END_OF_CHAIN))
   {
     rc = SmallBlockChainStream_GetNextBlockInChain(This, blockIndex, &blockIndex);
     if(FAILED(rc))
       return rc;
-    blockNoInSequence--;
+    blockNo++;
   }
 
   /*
@@ -8119,17 +8172,22 @@ HRESULT SmallBlockChainStream_ReadAt(
     if (!bytesReadFromBigBlockFile)
       return STG_E_DOCFILECORRUPT;
 
+    bufferWalker += bytesReadFromBigBlockFile;
+    size         -= bytesReadFromBigBlockFile;
+    *bytesRead   += bytesReadFromBigBlockFile;
+    offsetInBlock = (offsetInBlock + bytesReadFromBigBlockFile) % This->parentStorage->smallBlockSize;
+
+    storage->smallBlockCursorHead   = headIndex;
+    storage->smallBlockCursorOffset = blockNo;
+    storage->smallBlockCursorBlock  = blockIndex;
+
     /*
-     * Step to the next big block.
+     * Step to the next small block.
      */
     rc = SmallBlockChainStream_GetNextBlockInChain(This, blockIndex, &blockIndex);
     if(FAILED(rc))
       return STG_E_DOCFILECORRUPT;
-
-    bufferWalker += bytesReadFromBigBlockFile;
-    size         -= bytesReadFromBigBlockFile;
-    *bytesRead   += bytesReadFromBigBlockFile;
-    offsetInBlock = (offsetInBlock + bytesReadFromBigBlockFile) % This->parentStorage->smallBlockSize;
+    blockNo++;
   }
 
   return S_OK;
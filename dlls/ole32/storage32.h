@@ -360,7 +360,17 @@ void StorageBaseImpl_AddStream(StorageBaseImpl * stg, StgStreamImpl * strm) DECL
 void StorageBaseImpl_RemoveStream(StorageBaseImpl * stg, StgStreamImpl * strm) DECLSPEC_HIDDEN;
 
 /* Number of BlockChainStream objects to cache in a StorageImpl */
-#define BLOCKCHAIN_CACHE_SIZE 4
+#define BLOCKCHAIN_CACHE_SIZE 16
+
+/* Number of big block depot sectors to cache in a StorageImpl */
+#define BLOCKDEPOT_CACHE_SIZE 8
+
+struct BlockDepotCacheEntry
+{
+  ULONG index;      /* depot block number, 0xffffffff if unused */
+  ULONG lastUse;
+  ULONG data[MAX_BIG_BLOCK_SIZE / 4];
+};
 
 /****************************************************************************
  * StorageImpl definitions.
@@ -393,13 +403,19 @@ struct StorageImpl
   ULONG extBlockDepotCached[MAX_BIG_BLOCK_SIZE / 4];
   ULONG indexExtBlockDepotCached;
 
-  ULONG blockDepotCached[MAX_BIG_BLOCK_SIZE / 4];
-  ULONG indexBlockDepotCached;
+  struct BlockDepotCacheEntry blockDepotCache[BLOCKDEPOT_CACHE_SIZE];
+  ULONG blockDepotCacheUse;
   ULONG prevFreeBlock;
 
   /* All small blocks before this one are known to be in use. */
   ULONG firstFreeSmallBlock;
 
+  /* Last position reached in a small block chain, so that sequential reads
+   * don't walk the chain from its head. Reset when the small depot changes. */
+  ULONG smallBlockCursorHead;
+  ULONG smallBlockCursorOffset;
+  ULONG smallBlockCursorBlock;
+
   /*
    * Abstraction of the big block chains for the chains of the header.
    */
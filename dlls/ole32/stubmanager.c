@@ -42,6 +42,46 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(ole);
 
+static int stubmgr_oid_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct stub_manager *m = WINE_RB_ENTRY_VALUE(entry, const struct stub_manager, oid_entry);
+    OID oid = *(const OID *)key;
+
+    if (oid < m->oid) return -1;
+    return oid > m->oid;
+}
+
+static int stubmgr_object_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct stub_manager *m = WINE_RB_ENTRY_VALUE(entry, const struct stub_manager, object_entry);
+    const IUnknown *object = key;
+
+    if (object < m->object) return -1;
+    return object > m->object;
+}
+
+static int ifstub_ipid_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct ifstub *ifstub = WINE_RB_ENTRY_VALUE(entry, const struct ifstub, ipid_entry);
+
+    return memcmp(key, &ifstub->ipid, sizeof(IPID));
+}
+
+void apartment_init_stub_managers(APARTMENT *apt)
+{
+    list_init(&apt->stubmgrs);
+    wine_rb_init(&apt->stubmgr_oids, stubmgr_oid_compare);
+    wine_rb_init(&apt->stubmgr_objects, stubmgr_object_compare);
+    wine_rb_init(&apt->ifstub_ipids, ifstub_ipid_compare);
+}
+
+/* the trees only keep the first entry registered with a given key, so only
+ * remove an entry if it is the one that is actually in the tree */
+static void stub_tree_remove(struct wine_rb_tree *tree, const void *key, struct wine_rb_entry *entry)
+{
+    if (wine_rb_get(tree, key) == entry)
+        wine_rb_remove(tree, entry);
+}
 
 /* generates an ipid in the following format (similar to native version):
  * Data1 = apartment-local ipid counter
@@ -98,6 +138,7 @@ struct ifstub *stub_manager_new_ifstub(struct stub_manager *m, IRpcStubBuffer *s
 
     stub->flags = flags;
     stub->iid = *iid;
+    stub->manager = m;
 
     /* FIXME: find a cleaner way of identifying that we are creating an ifstub
      * for the remunknown interface */
@@ -112,6 +153,10 @@ struct ifstub *stub_manager_new_ifstub(struct stub_manager *m, IRpcStubBuffer *s
     if (flags & MSHLFLAGS_NORMAL) m->norm_refs++;
     LeaveCriticalSection(&m->lock);
 
+    EnterCriticalSection(&m->apt->cs);
+    wine_rb_put(&m->apt->ifstub_ipids, &stub->ipid, &stub->ipid_entry);
+    LeaveCriticalSection(&m->apt->cs);
+
     TRACE("ifstub %p created with ipid %s\n", stub, debugstr_guid(&stub->ipid));
 
     return stub;
@@ -133,23 +178,23 @@ static void stub_manager_delete_ifstub(struct stub_manager *m, struct ifstub *if
     HeapFree(GetProcessHeap(), 0, ifstub);
 }
 
-static struct ifstub *stub_manager_ipid_to_ifstub(struct stub_manager *m, const IPID *ipid)
+/* caller must hold apt->cs */
+static struct ifstub *apartment_ipid_to_ifstub(APARTMENT *apt, const IPID *ipid)
 {
-    struct list    *cursor;
-    struct ifstub  *result = NULL;
+    struct wine_rb_entry *entry;
 
-    EnterCriticalSection(&m->lock);
-    LIST_FOR_EACH( cursor, &m->ifstubs )
-    {
-        struct ifstub *ifstub = LIST_ENTRY( cursor, struct ifstub, entry );
+    if (!(entry = wine_rb_get(&apt->ifstub_ipids, ipid))) return NULL;
+    return WINE_RB_ENTRY_VALUE(entry, struct ifstub, ipid_entry);
+}
 
-        if (IsEqualGUID(ipid, &ifstub->ipid))
-        {
-            result = ifstub;
-            break;
-        }
-    }
-    LeaveCriticalSection(&m->lock);
+static struct ifstub *stub_manager_ipid_to_ifstub(struct stub_manager *m, const IPID *ipid)
+{
+    struct ifstub  *result;
+
+    EnterCriticalSection(&m->apt->cs);
+    result = apartment_ipid_to_ifstub(m->apt, ipid);
+    if (result && result->manager != m) result = NULL;
+    LeaveCriticalSection(&m->apt->cs);
 
     return result;
 }
@@ -233,6 +278,8 @@ static struct stub_manager *new_stub_manager(APARTMENT *apt, IUnknown *object)
     EnterCriticalSection(&apt->cs);
     sm->oid = apt->oidc++;
     list_add_head(&apt->stubmgrs, &sm->entry);
+    wine_rb_put(&apt->stubmgr_oids, &sm->oid, &sm->oid_entry);
+    wine_rb_put(&apt->stubmgr_objects, sm->object, &sm->object_entry);
     LeaveCriticalSection(&apt->cs);
 
     TRACE("Created new stub manager (oid=%s) at %p for object with IUnknown %p\n", wine_dbgstr_longlong(sm->oid), sm, object);
@@ -319,7 +366,18 @@ ULONG stub_manager_int_release(struct stub_manager *This)
 
     /* remove from apartment so no other thread can access it... */
     if (!refs)
+    {
+        struct ifstub *ifstub;
+
         list_remove(&This->entry);
+        stub_tree_remove(&apt->stubmgr_oids, &This->oid, &This->oid_entry);
+        stub_tree_remove(&apt->stubmgr_objects, This->object, &This->object_entry);
+
+        EnterCriticalSection(&This->lock);
+        LIST_FOR_EACH_ENTRY(ifstub, &This->ifstubs, struct ifstub, entry)
+            stub_tree_remove(&apt->ifstub_ipids, &ifstub->ipid, &ifstub->ipid_entry);
+        LeaveCriticalSection(&This->lock);
+    }
 
     LeaveCriticalSection(&apt->cs);
 
@@ -336,7 +394,7 @@ ULONG stub_manager_int_release(struct stub_manager *This)
 struct stub_manager *get_stub_manager_from_object(APARTMENT *apt, IUnknown *obj, BOOL alloc)
 {
     struct stub_manager *result = NULL;
-    struct list         *cursor;
+    struct wine_rb_entry *entry;
     IUnknown *object;
     HRESULT hres;
 
@@ -347,16 +405,10 @@ struct stub_manager *get_stub_manager_from_object(APARTMENT *apt, IUnknown *obj,
     }
 
     EnterCriticalSection(&apt->cs);
-    LIST_FOR_EACH( cursor, &apt->stubmgrs )
+    if ((entry = wine_rb_get(&apt->stubmgr_objects, object)))
     {
-        struct stub_manager *m = LIST_ENTRY( cursor, struct stub_manager, entry );
-
-        if (m->object == object)
-        {
-            result = m;
-            stub_manager_int_addref(result);
-            break;
-        }
+        result = WINE_RB_ENTRY_VALUE(entry, struct stub_manager, object_entry);
+        stub_manager_int_addref(result);
     }
     LeaveCriticalSection(&apt->cs);
 
@@ -379,19 +431,13 @@ struct stub_manager *get_stub_manager_from_object(APARTMENT *apt, IUnknown *obj,
 struct stub_manager *get_stub_manager(APARTMENT *apt, OID oid)
 {
     struct stub_manager *result = NULL;
-    struct list         *cursor;
+    struct wine_rb_entry *entry;
 
     EnterCriticalSection(&apt->cs);
-    LIST_FOR_EACH( cursor, &apt->stubmgrs )
+    if ((entry = wine_rb_get(&apt->stubmgr_oids, &oid)))
     {
-        struct stub_manager *m = LIST_ENTRY( cursor, struct stub_manager, entry );
-
-        if (m->oid == oid)
-        {
-            result = m;
-            stub_manager_int_addref(result);
-            break;
-        }
+        result = WINE_RB_ENTRY_VALUE(entry, struct stub_manager, oid_entry);
+        stub_manager_int_addref(result);
     }
     LeaveCriticalSection(&apt->cs);
 
@@ -473,19 +519,13 @@ ULONG stub_manager_ext_release(struct stub_manager *m, ULONG refs, BOOL tablewea
 static struct stub_manager *get_stub_manager_from_ipid(APARTMENT *apt, const IPID *ipid)
 {
     struct stub_manager *result = NULL;
-    struct list         *cursor;
+    struct ifstub       *ifstub;
 
     EnterCriticalSection(&apt->cs);
-    LIST_FOR_EACH( cursor, &apt->stubmgrs )
+    if ((ifstub = apartment_ipid_to_ifstub(apt, ipid)))
     {
-        struct stub_manager *m = LIST_ENTRY( cursor, struct stub_manager, entry );
-
-        if (stub_manager_ipid_to_ifstub(m, ipid))
-        {
-            result = m;
-            stub_manager_int_addref(result);
-            break;
-        }
+        result = ifstub->manager;
+        stub_manager_int_addref(result);
     }
     LeaveCriticalSection(&apt->cs);
 
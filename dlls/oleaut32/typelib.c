@@ -1226,6 +1226,14 @@ typedef struct tagTLBImplType
     struct list custdata_list;
 } TLBImplType;
 
+/* hash of function names, see TLB_get_funcdesc_by_name */
+typedef struct tagTLBNameHash
+{
+    UINT func_cnt;          /* cFuncs when the hash was built */
+    UINT size;              /* number of slots, 0 if names can't be hashed */
+    UINT slots[1];          /* index into funcdescs + 1, 0 if free */
+} TLBNameHash;
+
 /* internal TypeInfo data */
 typedef struct tagITypeInfoImpl
 {
@@ -1255,6 +1263,7 @@ typedef struct tagITypeInfoImpl
 
     /* functions  */
     TLBFuncDesc *funcdescs;
+    TLBNameHash *func_hash;
 
     /* variables  */
     TLBVarDesc *vardescs;
@@ -1691,6 +1700,92 @@ static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid(TLBFuncDesc *funcdescs,
     return NULL;
 }
 
+/* Case insensitive hash of a name made only of ASCII letters, digits and
+ * underscores. Other names fall back to lstrcmpiW, which folds case
+ * according to the locale. */
+static BOOL TLB_hash_name(const OLECHAR *name, UINT *hash)
+{
+    UINT h = 0;
+
+    for (; *name; name++)
+    {
+        WCHAR c = *name;
+        if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        else if (!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9') && c != '_') return FALSE;
+        h = h * 31 + c;
+    }
+    *hash = h;
+    return TRUE;
+}
+
+static void TLB_invalidate_func_hash(ITypeInfoImpl *This)
+{
+    heap_free(This->func_hash);
+    This->func_hash = NULL;
+}
+
+static TLBNameHash *TLB_build_func_hash(ITypeInfoImpl *This)
+{
+    TLBNameHash *hash, *old;
+    UINT size = 16, i, h, slot;
+    const OLECHAR *name;
+
+    while (size < This->typeattr.cFuncs * 2) size *= 2;
+    hash = heap_alloc_zero(FIELD_OFFSET(TLBNameHash, slots[size]));
+    if (!hash) return NULL;
+    hash->func_cnt = This->typeattr.cFuncs;
+    hash->size = size;
+
+    /* insert in order, so that probing finds the first function of a given name first */
+    for (i = 0; i < This->typeattr.cFuncs; i++)
+    {
+        if (!(name = TLB_get_bstr(This->funcdescs[i].Name))) continue;
+        if (!TLB_hash_name(name, &h))
+        {
+            hash->size = 0;
+            break;
+        }
+        for (slot = h & (size - 1); hash->slots[slot]; slot = (slot + 1) & (size - 1));
+        hash->slots[slot] = i + 1;
+    }
+
+    /* a stale hash only exists while the type info is being created */
+    if ((old = This->func_hash) && old->func_cnt != This->typeattr.cFuncs)
+        TLB_invalidate_func_hash(This);
+
+    if ((old = InterlockedCompareExchangePointer((void **)&This->func_hash, hash, NULL)))
+    {
+        heap_free(hash);
+        return old;
+    }
+    return hash;
+}
+
+static TLBFuncDesc *TLB_get_funcdesc_by_name(ITypeInfoImpl *This, const OLECHAR *name)
+{
+    TLBNameHash *hash = This->func_hash;
+    UINT i, h;
+
+    if (!hash || hash->func_cnt != This->typeattr.cFuncs)
+        hash = TLB_build_func_hash(This);
+
+    if (hash && hash->size && TLB_hash_name(name, &h))
+    {
+        for (i = h & (hash->size - 1); hash->slots[i]; i = (i + 1) & (hash->size - 1))
+        {
+            TLBFuncDesc *func = &This->funcdescs[hash->slots[i] - 1];
+            if (!lstrcmpiW(name, TLB_get_bstr(func->Name)))
+                return func;
+        }
+        return NULL;
+    }
+
+    for (i = 0; i < This->typeattr.cFuncs; i++)
+        if (!lstrcmpiW(name, TLB_get_bstr(This->funcdescs[i].Name)))
+            return &This->funcdescs[i];
+    return NULL;
+}
+
 static inline TLBVarDesc *TLB_get_vardesc_by_memberid(TLBVarDesc *vardescs,
         UINT n, MEMBERID memid)
 {
@@ -5611,6 +5706,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
         TLB_FreeCustData(&pFInfo->custdata_list);
     }
     heap_free(This->funcdescs);
+    heap_free(This->func_hash);
 
     for(i = 0; i < This->typeattr.cVars; ++i)
     {
@@ -5652,7 +5748,10 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
         BOOL not_attached_to_typelib = This->not_attached_to_typelib;
         ITypeLib2_Release(&This->pTypeLib->ITypeLib2_iface);
         if (not_attached_to_typelib)
+        {
+            heap_free(This->func_hash);
             heap_free(This);
+        }
         /* otherwise This will be freed when typelib is freed */
     }
 
@@ -6252,9 +6351,10 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         LPOLESTR  *rgszNames, UINT cNames, MEMBERID  *pMemId)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    const TLBFuncDesc *pFDesc;
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i;
 
     TRACE("(%p) Name %s cNames %d\n", This, debugstr_w(*rgszNames),
             cNames);
@@ -6263,23 +6363,21 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
+    pFDesc = TLB_get_funcdesc_by_name(This, *rgszNames);
+    if (pFDesc) {
         int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- 0x%08x\n", ret);
-            return ret;
-        }
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- 0x%08x\n", ret);
+        return ret;
     }
     pVDesc = TLB_get_vardesc_by_name(This->vardescs, This->typeattr.cVars, *rgszNames);
     if(pVDesc){
@@ -7798,6 +7896,7 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
 
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
+        pTypeInfoImpl->func_hash = NULL;
         list_init(&pTypeInfoImpl->custdata_list);
 
         if (This->typeattr.typekind == TKIND_INTERFACE)
@@ -10908,6 +11007,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
     }
 
     func_desc->Name = TLB_append_str(&This->pTypeLib->name_list, *names);
+    TLB_invalidate_func_hash(This);
 
     for (i = 1; i < numNames; ++i) {
         TLBParDesc *par_desc = func_desc->pParamDesc + i - 1;
@@ -154,6 +154,25 @@ static void free_handle_ptr( struct wgl_handle *ptr )
     LeaveCriticalSection( &wgl_section );
 }
 
+/* reserve a context for the current thread; a context that is in use by a thread
+ * can't be deleted or made current elsewhere, so the driver can then be called
+ * without holding the lock */
+static struct wgl_handle *reserve_context( HGLRC hglrc, BOOL *reserved )
+{
+    struct wgl_handle *ptr;
+    DWORD tid = GetCurrentThreadId();
+
+    if (!(ptr = get_handle_ptr( hglrc, HANDLE_CONTEXT ))) return NULL;
+    if ((*reserved = !ptr->u.context->tid)) ptr->u.context->tid = tid;
+    release_handle_ptr( ptr );
+    if (!*reserved && ptr->u.context->tid != tid)
+    {
+        SetLastError( ERROR_BUSY );
+        return NULL;
+    }
+    return ptr;
+}
+
 static inline enum wgl_handle_type get_current_context_type(void)
 {
     if (!NtCurrentTeb()->glCurrentRC) return HANDLE_CONTEXT;
@@ -214,26 +233,19 @@ BOOL WINAPI wglMakeCurrent(HDC hdc, HGLRC hglrc)
 
     if (hglrc)
     {
-        if (!(ptr = get_handle_ptr( hglrc, HANDLE_CONTEXT ))) return FALSE;
-        if (!ptr->u.context->tid || ptr->u.context->tid == GetCurrentThreadId())
-        {
-            ret = ptr->funcs->wgl.p_wglMakeCurrent( hdc, ptr->u.context->drv_ctx );
-            if (ret)
-            {
-                if (prev) prev->u.context->tid = 0;
-                ptr->u.context->tid = GetCurrentThreadId();
-                ptr->u.context->draw_dc = hdc;
-                ptr->u.context->read_dc = hdc;
-                NtCurrentTeb()->glCurrentRC = hglrc;
-                NtCurrentTeb()->glTable = ptr->funcs;
-            }
-        }
-        else
+        BOOL reserved;
+
+        if (!(ptr = reserve_context( hglrc, &reserved ))) return FALSE;
+        ret = ptr->funcs->wgl.p_wglMakeCurrent( hdc, ptr->u.context->drv_ctx );
+        if (ret)
         {
-            SetLastError( ERROR_BUSY );
-            ret = FALSE;
+            if (prev && prev != ptr) prev->u.context->tid = 0;
+            ptr->u.context->draw_dc = hdc;
+            ptr->u.context->read_dc = hdc;
+            NtCurrentTeb()->glCurrentRC = hglrc;
+            NtCurrentTeb()->glTable = ptr->funcs;
         }
-        release_handle_ptr( ptr );
+        else if (reserved) ptr->u.context->tid = 0;
     }
     else if (prev)
     {
@@ -318,28 +330,21 @@ BOOL WINAPI wglMakeContextCurrentARB( HDC draw_hdc, HDC read_hdc, HGLRC hglrc )
 
     if (hglrc)
     {
-        if (!(ptr = get_handle_ptr( hglrc, HANDLE_CONTEXT ))) return FALSE;
-        if (!ptr->u.context->tid || ptr->u.context->tid == GetCurrentThreadId())
-        {
-            ret = (ptr->funcs->ext.p_wglMakeContextCurrentARB &&
-                   ptr->funcs->ext.p_wglMakeContextCurrentARB( draw_hdc, read_hdc,
-                                                               ptr->u.context->drv_ctx ));
-            if (ret)
-            {
-                if (prev) prev->u.context->tid = 0;
-                ptr->u.context->tid = GetCurrentThreadId();
-                ptr->u.context->draw_dc = draw_hdc;
-                ptr->u.context->read_dc = read_hdc;
-                NtCurrentTeb()->glCurrentRC = hglrc;
-                NtCurrentTeb()->glTable = ptr->funcs;
-            }
-        }
-        else
+        BOOL reserved;
+
+        if (!(ptr = reserve_context( hglrc, &reserved ))) return FALSE;
+        ret = (ptr->funcs->ext.p_wglMakeContextCurrentARB &&
+               ptr->funcs->ext.p_wglMakeContextCurrentARB( draw_hdc, read_hdc,
+                                                           ptr->u.context->drv_ctx ));
+        if (ret)
         {
-            SetLastError( ERROR_BUSY );
-            ret = FALSE;
+            if (prev && prev != ptr) prev->u.context->tid = 0;
+            ptr->u.context->draw_dc = draw_hdc;
+            ptr->u.context->read_dc = read_hdc;
+            NtCurrentTeb()->glCurrentRC = hglrc;
+            NtCurrentTeb()->glTable = ptr->funcs;
         }
-        release_handle_ptr( ptr );
+        else if (reserved) ptr->u.context->tid = 0;
     }
     else if (prev)
     {
@@ -34,6 +34,7 @@
 #include "wine/debug.h"
 #include "wine/heap.h"
 #include "wine/list.h"
+#include "wine/perfcounters.h"
 #include "wine/unicode.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(pdh);
@@ -110,6 +111,8 @@ struct counter
     void (CALLBACK *collect)( struct counter * );   /* collect callback */
     union value     one;                            /* first value */
     union value     two;                            /* second value */
+    DWORD           pid;                            /* Wine counters: process id */
+    char           *name;                           /* Wine counters: counter name */
 };
 
 #define PDH_MAGIC_COUNTER   0x50444831 /* 'PDH1' */
@@ -130,6 +133,7 @@ static void destroy_counter( struct counter *counter )
 {
     counter->magic = 0;
     heap_free( counter->path );
+    heap_free( counter->name );
     heap_free( counter );
 }
 
@@ -216,20 +220,93 @@ static BOOL is_local_machine( const WCHAR *name, DWORD len )
     return len == buflen && !memicmpW( name, buf, buflen );
 }
 
-static BOOL pdh_match_path( LPCWSTR fullpath, LPCWSTR path )
+static const WCHAR *skip_local_machine( const WCHAR *path )
 {
     const WCHAR *p;
 
     if (path[0] == '\\' && path[1] == '\\' && (p = strchrW( path + 2, '\\' )) &&
         is_local_machine( path + 2, p - path - 2 ))
-    {
-        path += p - path;
-    }
+        return p;
+    return path;
+}
+
+static BOOL pdh_match_path( LPCWSTR fullpath, LPCWSTR path )
+{
+    const WCHAR *p;
+
+    path = skip_local_machine( path );
     if (strchrW( path, '\\' )) p = fullpath;
     else p = strrchrW( fullpath, '\\' ) + 1;
     return !strcmpW( p, path );
 }
 
+/* Wine internal counters, \Wine(<pid>)\<name> or \Wine\<name> for the current process */
+static const WCHAR wine_objectW[] = {'W','i','n','e'};
+
+#define TYPE_WINE_COUNTER \
+    (PERF_SIZE_LARGE | PERF_TYPE_NUMBER | PERF_NUMBER_DECIMAL | PERF_DISPLAY_NO_SUFFIX)
+
+static void CALLBACK collect_wine_counter( struct counter *counter )
+{
+    struct wine_perf_counters *block;
+    LONGLONG value = 0;
+    HANDLE mapping;
+    char name[32];
+    unsigned int i;
+
+    wine_perf_counters_name( name, counter->pid );
+    if (!(mapping = OpenFileMappingA( FILE_MAP_READ, FALSE, name )))
+    {
+        counter->status = PDH_CSTATUS_NO_INSTANCE;
+        return;
+    }
+    if ((block = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, sizeof(*block) )))
+    {
+        if (block->version == WINE_PERF_COUNTERS_VERSION)
+        {
+            for (i = 0; i < WINE_PERF_COUNTERS_MAX; i++)
+            {
+                const struct wine_perf_counter *c = &block->counters[i];
+                if (c->state == WINE_PERF_COUNTER_READY && !strcmp( c->name, counter->name ))
+                    value += c->value;
+            }
+            counter->two.largevalue = value;
+            counter->status = PDH_CSTATUS_VALID_DATA;
+        }
+        else counter->status = PDH_CSTATUS_INVALID_DATA;
+        UnmapViewOfFile( block );
+    }
+    else counter->status = PDH_CSTATUS_INVALID_DATA;
+    CloseHandle( mapping );
+}
+
+static BOOL parse_wine_path( const WCHAR *path, DWORD *pid, char **name )
+{
+    const WCHAR *p;
+    WCHAR *end;
+    int len;
+
+    path = skip_local_machine( path );
+    if (path[0] != '\\' || memicmpW( path + 1, wine_objectW, sizeof(wine_objectW) / sizeof(WCHAR) ))
+        return FALSE;
+    p = path + 1 + sizeof(wine_objectW) / sizeof(WCHAR);
+    if (*p == '(')
+    {
+        *pid = strtoulW( p + 1, &end, 10 );
+        if (end == p + 1 || *end != ')') return FALSE;
+        p = end + 1;
+    }
+    else *pid = GetCurrentProcessId();
+    if (*p++ != '\\' || !*p || strchrW( p, '\\' )) return FALSE;
+
+    len = WideCharToMultiByte( CP_UTF8, 0, p, -1, NULL, 0, NULL, NULL );
+    if (!len || len > WINE_PERF_COUNTER_NAME_LEN) return FALSE;
+    if (!name) return TRUE;
+    if (!(*name = heap_alloc( len ))) return FALSE;
+    WideCharToMultiByte( CP_UTF8, 0, p, -1, *name, len, NULL, NULL );
+    return TRUE;
+}
+
 /***********************************************************************
  *              PdhAddCounterA   (PDH.@)
  */
@@ -298,6 +375,24 @@ PDH_STATUS WINAPI PdhAddCounterW( PDH_HQUERY hquery, LPCWSTR path,
             return PDH_MEMORY_ALLOCATION_FAILURE;
         }
     }
+    if ((counter = create_counter()))
+    {
+        if (parse_wine_path( path, &counter->pid, &counter->name ))
+        {
+            counter->path      = pdh_strdup( path );
+            counter->collect   = collect_wine_counter;
+            counter->type      = TYPE_WINE_COUNTER;
+            counter->queryuser = query->user;
+            counter->user      = userdata;
+
+            list_add_tail( &query->counters, &counter->entry );
+            *hcounter = counter;
+
+            LeaveCriticalSection( &pdh_handle_cs );
+            return ERROR_SUCCESS;
+        }
+        destroy_counter( counter );
+    }
     LeaveCriticalSection( &pdh_handle_cs );
     return PDH_CSTATUS_NO_COUNTER;
 }
@@ -1072,6 +1167,7 @@ PDH_STATUS WINAPI PdhValidatePathW( LPCWSTR path )
 {
     PDH_STATUS ret;
     unsigned int i;
+    DWORD pid;
 
     TRACE("%s\n", debugstr_w(path));
 
@@ -1079,6 +1175,7 @@ PDH_STATUS WINAPI PdhValidatePathW( LPCWSTR path )
 
     for (i = 0; i < sizeof(counter_sources) / sizeof(counter_sources[0]); i++)
         if (pdh_match_path( counter_sources[i].path, path )) return ERROR_SUCCESS;
+    if (parse_wine_path( path, &pid, NULL )) return ERROR_SUCCESS;
 
     return PDH_CSTATUS_NO_COUNTER;
 }
@@ -48,6 +48,7 @@ typedef struct AVIDecImpl
     BITMAPINFOHEADER* pBihIn;
     BITMAPINFOHEADER* pBihOut;
     REFERENCE_TIME late;
+    OutputQueue *queue;
 } AVIDecImpl;
 
 static const IBaseFilterVtbl AVIDec_Vtbl;
@@ -57,6 +58,10 @@ static inline AVIDecImpl *impl_from_TransformFilter( TransformFilter *iface )
     return CONTAINING_RECORD(iface, AVIDecImpl, tf);
 }
 
+static const OutputQueueFuncTable AVIDec_OutputQueueFuncTable = {
+    OutputQueueImpl_ThreadProc
+};
+
 static HRESULT WINAPI AVIDec_StartStreaming(TransformFilter* pTransformFilter)
 {
     AVIDecImpl* This = impl_from_TransformFilter(pTransformFilter);
@@ -71,6 +76,32 @@ static HRESULT WINAPI AVIDec_StartStreaming(TransformFilter* pTransformFilter)
         ERR("Cannot start processing (%d)\n", result);
 	return E_FAIL;
     }
+
+    /* Deliver the decoded frames from a separate thread, so that the next frame
+     * is decoded while the renderer waits for the presentation time of the
+     * previous one. The queue keeps the samples in order. */
+    if (FAILED(OutputQueue_Construct((BaseOutputPin *)This->tf.ppPins[1], TRUE, TRUE, 1, FALSE,
+                                     THREAD_PRIORITY_NORMAL, &AVIDec_OutputQueueFuncTable, &This->queue)))
+        This->queue = NULL;
+    return S_OK;
+}
+
+static HRESULT WINAPI AVIDec_EndOfStream(TransformFilter *pTransformFilter) {
+    AVIDecImpl* This = impl_from_TransformFilter(pTransformFilter);
+
+    if (!This->queue)
+        return S_OK;
+
+    /* send it after the queued samples */
+    OutputQueue_EOS(This->queue);
+    return S_FALSE;
+}
+
+static HRESULT WINAPI AVIDec_BeginFlush(TransformFilter *pTransformFilter) {
+    AVIDecImpl* This = impl_from_TransformFilter(pTransformFilter);
+
+    if (This->queue)
+        OutputQueue_BeginFlush(This->queue);
     return S_OK;
 }
 
@@ -197,7 +228,10 @@ static HRESULT WINAPI AVIDec_Receive(TransformFilter *tf, IMediaSample *pSample)
         IMediaSample_SetMediaTime(pOutSample, NULL, NULL);
 
     LeaveCriticalSection(&This->tf.csReceive);
-    hr = BaseOutputPinImpl_Deliver((BaseOutputPin*)This->tf.ppPins[1], pOutSample);
+    if (This->queue)
+        hr = OutputQueue_Receive(This->queue, pOutSample);
+    else
+        hr = BaseOutputPinImpl_Deliver((BaseOutputPin*)This->tf.ppPins[1], pOutSample);
     EnterCriticalSection(&This->tf.csReceive);
     if (hr != S_OK && hr != VFW_E_NOT_CONNECTED)
         ERR("Error sending sample (%x)\n", hr);
@@ -217,6 +251,12 @@ static HRESULT WINAPI AVIDec_StopStreaming(TransformFilter* pTransformFilter)
 
     TRACE("(%p)->()\n", This);
 
+    if (This->queue)
+    {
+        OutputQueue_Destroy(This->queue);
+        This->queue = NULL;
+    }
+
     if (!This->hvid)
         return S_OK;
 
@@ -370,8 +410,9 @@ static HRESULT WINAPI AVIDec_DecideBufferSize(TransformFilter *tf, IMemAllocator
     if (ppropInputRequest->cbBuffer < pAVI->pBihOut->biSizeImage)
             ppropInputRequest->cbBuffer = pAVI->pBihOut->biSizeImage;
 
+    /* leave room for a frame being decoded while others wait in the output queue */
     if (!ppropInputRequest->cBuffers)
-        ppropInputRequest->cBuffers = 1;
+        ppropInputRequest->cBuffers = 3;
 
     return IMemAllocator_SetProperties(pAlloc, ppropInputRequest, &actual);
 }
@@ -385,8 +426,8 @@ static const TransformFilterFuncTable AVIDec_FuncsTable = {
     AVIDec_SetMediaType,
     AVIDec_CompleteConnect,
     AVIDec_BreakConnect,
-    NULL,
-    NULL,
+    AVIDec_EndOfStream,
+    AVIDec_BeginFlush,
     AVIDec_EndFlush,
     NULL,
     AVIDec_NotifyDrop
@@ -412,6 +453,7 @@ HRESULT AVIDec_create(IUnknown * pUnkOuter, LPVOID * ppv)
     This->hvid = NULL;
     This->pBihIn = NULL;
     This->pBihOut = NULL;
+    This->queue = NULL;
 
     *ppv = &This->tf.filter.IBaseFilter_iface;
 
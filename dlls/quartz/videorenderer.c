@@ -204,29 +204,28 @@ static void VideoRenderer_AutoShowWindow(VideoRendererImpl *This)
 
 static DWORD VideoRenderer_SendSampleData(VideoRendererImpl* This, LPBYTE data, DWORD size)
 {
-    AM_MEDIA_TYPE amt;
-    HRESULT hr = S_OK;
+    /* use the connection media type in place, this runs for every frame */
+    const AM_MEDIA_TYPE *amt = &This->renderer.pInputPin->pin.mtCurrent;
     BITMAPINFOHEADER *bmiHeader;
 
     TRACE("(%p)->(%p, %d)\n", This, data, size);
 
-    hr = IPin_ConnectionMediaType(&This->renderer.pInputPin->pin.IPin_iface, &amt);
-    if (FAILED(hr)) {
+    if (!This->renderer.pInputPin->pin.pConnectedTo) {
         ERR("Unable to retrieve media type\n");
-        return hr;
+        return VFW_E_NOT_CONNECTED;
     }
 
-    if (IsEqualIID(&amt.formattype, &FORMAT_VideoInfo))
+    if (IsEqualIID(&amt->formattype, &FORMAT_VideoInfo))
     {
-        bmiHeader = &((VIDEOINFOHEADER *)amt.pbFormat)->bmiHeader;
+        bmiHeader = &((VIDEOINFOHEADER *)amt->pbFormat)->bmiHeader;
     }
-    else if (IsEqualIID(&amt.formattype, &FORMAT_VideoInfo2))
+    else if (IsEqualIID(&amt->formattype, &FORMAT_VideoInfo2))
     {
-        bmiHeader = &((VIDEOINFOHEADER2 *)amt.pbFormat)->bmiHeader;
+        bmiHeader = &((VIDEOINFOHEADER2 *)amt->pbFormat)->bmiHeader;
     }
     else
     {
-        FIXME("Unknown type %s\n", debugstr_guid(&amt.subtype));
+        FIXME("Unknown type %s\n", debugstr_guid(&amt->subtype));
         return VFW_E_RUNTIME_ERROR;
     }
 
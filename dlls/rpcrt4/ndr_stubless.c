@@ -55,14 +55,82 @@ static inline BOOL is_oicf_stubdesc(const PMIDL_STUB_DESC pStubDesc)
     return pStubDesc->Version >= 0x20000;
 }
 
+/* Size of the base types that are copied as is between memory and the
+ * buffer. These are handled inline, without going through the generic
+ * NdrBaseType* routines. */
+static inline unsigned int simple_base_type_size(unsigned char fc)
+{
+    switch (fc)
+    {
+    case RPC_FC_BYTE:
+    case RPC_FC_CHAR:
+    case RPC_FC_SMALL:
+    case RPC_FC_USMALL:
+        return 1;
+    case RPC_FC_WCHAR:
+    case RPC_FC_SHORT:
+    case RPC_FC_USHORT:
+        return 2;
+    case RPC_FC_LONG:
+    case RPC_FC_ULONG:
+    case RPC_FC_ERROR_STATUS_T:
+    case RPC_FC_ENUM32:
+    case RPC_FC_FLOAT:
+        return 4;
+    case RPC_FC_DOUBLE:
+    case RPC_FC_HYPER:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+static inline void simple_base_type_buffer_size(PMIDL_STUB_MESSAGE pStubMsg, unsigned int size)
+{
+    ULONG len = (pStubMsg->BufferLength + size - 1) & ~(size - 1);
+
+    if (len + size < len) RpcRaiseException(RPC_X_BAD_STUB_DATA);
+    pStubMsg->BufferLength = len + size;
+}
+
+static inline void simple_base_type_marshall(PMIDL_STUB_MESSAGE pStubMsg, const unsigned char *pMemory,
+                                             unsigned int size)
+{
+    unsigned char *buffer = (unsigned char *)(((ULONG_PTR)pStubMsg->Buffer + size - 1) & ~(ULONG_PTR)(size - 1));
+
+    if (buffer + size < buffer ||
+        buffer + size > (unsigned char *)pStubMsg->RpcMsg->Buffer + pStubMsg->BufferLength)
+        RpcRaiseException(RPC_X_BAD_STUB_DATA);
+    memset(pStubMsg->Buffer, 0, buffer - pStubMsg->Buffer);
+    memcpy(buffer, pMemory, size);
+    pStubMsg->Buffer = buffer + size;
+}
+
+static inline void simple_base_type_unmarshall(PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
+                                               unsigned int size)
+{
+    unsigned char *buffer = (unsigned char *)(((ULONG_PTR)pStubMsg->Buffer + size - 1) & ~(ULONG_PTR)(size - 1));
+
+    if (buffer + size < buffer || buffer + size > pStubMsg->BufferEnd)
+        RpcRaiseException(RPC_X_BAD_STUB_DATA);
+    memcpy(pMemory, buffer, size);
+    pStubMsg->Buffer = buffer + size;
+}
+
 static inline void call_buffer_sizer(PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
                                      const NDR_PARAM_OIF *param)
 {
     PFORMAT_STRING pFormat;
     NDR_BUFFERSIZE m;
+    unsigned int size;
 
     if (param->attr.IsBasetype)
     {
+        if ((size = simple_base_type_size(param->u.type_format_char)))
+        {
+            simple_base_type_buffer_size(pStubMsg, size);
+            return;
+        }
         pFormat = &param->u.type_format_char;
         if (param->attr.IsSimpleRef) pMemory = *(unsigned char **)pMemory;
     }
@@ -86,11 +154,17 @@ static inline unsigned char *call_marshaller(PMIDL_STUB_MESSAGE pStubMsg, unsign
 {
     PFORMAT_STRING pFormat;
     NDR_MARSHALL m;
+    unsigned int size;
 
     if (param->attr.IsBasetype)
     {
-        pFormat = &param->u.type_format_char;
         if (param->attr.IsSimpleRef) pMemory = *(unsigned char **)pMemory;
+        if ((size = simple_base_type_size(param->u.type_format_char)))
+        {
+            simple_base_type_marshall(pStubMsg, pMemory, size);
+            return NULL;
+        }
+        pFormat = &param->u.type_format_char;
     }
     else
     {
@@ -113,11 +187,18 @@ static inline unsigned char *call_unmarshaller(PMIDL_STUB_MESSAGE pStubMsg, unsi
 {
     PFORMAT_STRING pFormat;
     NDR_UNMARSHALL m;
+    unsigned int size;
 
     if (param->attr.IsBasetype)
     {
         pFormat = &param->u.type_format_char;
         if (param->attr.IsSimpleRef) ppMemory = (unsigned char **)*ppMemory;
+        /* the server may point the argument into the buffer instead, leave that to the generic code */
+        if (!fMustAlloc && *ppMemory && (size = simple_base_type_size(*pFormat)))
+        {
+            simple_base_type_unmarshall(pStubMsg, *ppMemory, size);
+            return NULL;
+        }
     }
     else
     {
@@ -71,8 +71,15 @@ typedef struct _RpcConnection_np
     IO_STATUS_BLOCK io_status;
     HANDLE event_cache;
     BOOL read_closed;
+    char *read_buf;
+    unsigned int read_buf_pos;
+    unsigned int read_buf_len;
 } RpcConnection_np;
 
+/* size of the read-ahead buffer, reads smaller than this go through it so that
+ * the fragment header and body are usually fetched from the pipe at once */
+#define NP_READ_BUFFER_SIZE 0x2000
+
 static RpcConnection *rpcrt4_conn_np_alloc(void)
 {
   RpcConnection_np *npc = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(RpcConnection_np));
@@ -375,9 +382,8 @@ static RPC_STATUS rpcrt4_ncalrpc_handoff(RpcConnection *old_conn, RpcConnection
   return status;
 }
 
-static int rpcrt4_conn_np_read(RpcConnection *conn, void *buffer, unsigned int count)
+static int rpcrt4_conn_np_read_pipe(RpcConnection_np *connection, void *buffer, unsigned int count)
 {
-    RpcConnection_np *connection = (RpcConnection_np *) conn;
     HANDLE event;
     NTSTATUS status;
 
@@ -404,6 +410,44 @@ static int rpcrt4_conn_np_read(RpcConnection *conn, void *buffer, unsigned int c
     return status && status != STATUS_BUFFER_OVERFLOW ? -1 : connection->io_status.Information;
 }
 
+static int rpcrt4_conn_np_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_np *connection = (RpcConnection_np *) conn;
+    unsigned int copied = 0, len;
+    int ret;
+
+    if (connection->read_buf_len)
+    {
+        len = min(count, connection->read_buf_len);
+        memcpy(buffer, connection->read_buf + connection->read_buf_pos, len);
+        connection->read_buf_pos += len;
+        connection->read_buf_len -= len;
+        if (len == count)
+            return count;
+        copied = len;
+    }
+
+    /* at most one read from the pipe per call, like an unbuffered read */
+    if (count - copied >= NP_READ_BUFFER_SIZE)
+    {
+        ret = rpcrt4_conn_np_read_pipe(connection, (char *)buffer + copied, count - copied);
+        return ret < 0 ? ret : copied + ret;
+    }
+
+    if (!connection->read_buf &&
+        !(connection->read_buf = HeapAlloc(GetProcessHeap(), 0, NP_READ_BUFFER_SIZE)))
+        return rpcrt4_conn_np_read_pipe(connection, (char *)buffer + copied, count - copied);
+
+    ret = rpcrt4_conn_np_read_pipe(connection, connection->read_buf, NP_READ_BUFFER_SIZE);
+    if (ret < 0)
+        return ret;
+    len = min(count - copied, ret);
+    memcpy((char *)buffer + copied, connection->read_buf, len);
+    connection->read_buf_pos = len;
+    connection->read_buf_len = ret - len;
+    return copied + len;
+}
+
 static int rpcrt4_conn_np_write(RpcConnection *conn, const void *buffer, unsigned int count)
 {
     RpcConnection_np *connection = (RpcConnection_np *) conn;
@@ -448,6 +492,9 @@ static int rpcrt4_conn_np_close(RpcConnection *conn)
         CloseHandle(connection->event_cache);
         connection->event_cache = 0;
     }
+    HeapFree(GetProcessHeap(), 0, connection->read_buf);
+    connection->read_buf = NULL;
+    connection->read_buf_len = 0;
     return 0;
 }
 
@@ -30,6 +30,58 @@
 
 #include "tomcrypt.h"
 
+/* AES-NI versions of the block functions. They use the same key schedule
+ * as the table code, stored in byte order, and may only be called when
+ * aes_cpu_has_aesni() returns nonzero. */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+#define AES_HAVE_AESNI
+#include <cpuid.h>
+#include <wmmintrin.h>
+#ifdef __i386__
+#define AES_AESNI __attribute__((target("aes,sse2"), force_align_arg_pointer))
+#else
+#define AES_AESNI __attribute__((target("aes")))
+#endif
+
+static int aes_cpu_has_aesni(void)
+{
+    static int has_aesni = -1;
+    unsigned int eax, ebx, ecx, edx;
+
+    if (has_aesni == -1)
+        has_aesni = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES);
+    return has_aesni;
+}
+
+static void AES_AESNI aesni_ecb_encrypt(const unsigned char *pt, unsigned char *ct, const aes_key *skey)
+{
+    const unsigned char *rk = skey->ni_eK;
+    __m128i s;
+    int r;
+
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)pt), _mm_loadu_si128((const __m128i *)rk));
+    for (r = 1; r < skey->Nr; r++)
+        s = _mm_aesenc_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16 * r)));
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16 * r)));
+    _mm_storeu_si128((__m128i *)ct, s);
+}
+
+/* dK already holds the equivalent inverse cipher schedule that AESDEC expects */
+static void AES_AESNI aesni_ecb_decrypt(const unsigned char *ct, unsigned char *pt, const aes_key *skey)
+{
+    const unsigned char *rk = skey->ni_dK;
+    __m128i s;
+    int r;
+
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)ct), _mm_loadu_si128((const __m128i *)rk));
+    for (r = 1; r < skey->Nr; r++)
+        s = _mm_aesdec_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16 * r)));
+    s = _mm_aesdeclast_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16 * r)));
+    _mm_storeu_si128((__m128i *)pt, s);
+}
+#endif
+
 static const ulong32 TE0[256] = {
     0xc66363a5UL, 0xf87c7c84UL, 0xee777799UL, 0xf67b7b8dUL,
     0xfff2f20dUL, 0xd66b6bbdUL, 0xde6f6fb1UL, 0x91c5c554UL,
@@ -1058,6 +1110,11 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+    for (i = 0; i < 4 * (skey->Nr + 1); i++) {
+        STORE32H(skey->eK[i], skey->ni_eK + 4 * i);
+        STORE32H(skey->dK[i], skey->ni_dK + 4 * i);
+    }
+
     return CRYPT_OK;
 }
 
@@ -1066,6 +1123,13 @@ void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef AES_HAVE_AESNI
+    if (aes_cpu_has_aesni()) {
+        aesni_ecb_encrypt(pt, ct, skey);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->eK;
 
@@ -1167,6 +1231,13 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#ifdef AES_HAVE_AESNI
+    if (aes_cpu_has_aesni()) {
+        aesni_ecb_decrypt(ct, pt, skey);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->dK;
 
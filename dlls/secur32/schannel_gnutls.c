@@ -71,6 +71,11 @@ MAKE_FUNCPTR(gnutls_record_get_max_size);
 MAKE_FUNCPTR(gnutls_record_recv);
 MAKE_FUNCPTR(gnutls_record_send);
 MAKE_FUNCPTR(gnutls_server_name_set);
+MAKE_FUNCPTR(gnutls_session_get_data);
+MAKE_FUNCPTR(gnutls_session_get_ptr);
+MAKE_FUNCPTR(gnutls_session_is_resumed);
+MAKE_FUNCPTR(gnutls_session_set_data);
+MAKE_FUNCPTR(gnutls_session_set_ptr);
 MAKE_FUNCPTR(gnutls_transport_get_ptr);
 MAKE_FUNCPTR(gnutls_transport_set_errno);
 MAKE_FUNCPTR(gnutls_transport_set_ptr);
@@ -157,6 +162,114 @@ static const struct {
     /* {SP_PROT_SSL2_CLIENT} is not supported by GnuTLS */
 };
 
+/* client sessions are cached per target name and credentials, like native schannel does */
+struct session_cache_entry
+{
+    struct list entry;
+    void *credentials;
+    char *target;
+    void *data;
+    size_t size;
+};
+
+#define SESSION_CACHE_MAX_ENTRIES 64
+
+static struct list session_cache = LIST_INIT( session_cache );
+static unsigned int session_cache_count;
+
+static CRITICAL_SECTION session_cache_cs;
+static CRITICAL_SECTION_DEBUG session_cache_debug =
+{
+    0, 0, &session_cache_cs,
+    { &session_cache_debug.ProcessLocksList, &session_cache_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": session_cache_cs") }
+};
+static CRITICAL_SECTION session_cache_cs = { &session_cache_debug, -1, 0, 0, 0, 0 };
+
+struct session_info
+{
+    void *credentials;
+    char *target;
+};
+
+static void free_cache_entry( struct session_cache_entry *cache )
+{
+    list_remove( &cache->entry );
+    session_cache_count--;
+    heap_free( cache->target );
+    heap_free( cache->data );
+    heap_free( cache );
+}
+
+static struct session_cache_entry *find_cache_entry( void *credentials, const char *target )
+{
+    struct session_cache_entry *cache;
+
+    LIST_FOR_EACH_ENTRY( cache, &session_cache, struct session_cache_entry, entry )
+        if (cache->credentials == credentials && !strcasecmp( cache->target, target )) return cache;
+    return NULL;
+}
+
+static void resume_session( gnutls_session_t s, struct session_info *info )
+{
+    struct session_cache_entry *cache;
+    int err;
+
+    EnterCriticalSection( &session_cache_cs );
+    if ((cache = find_cache_entry( info->credentials, info->target )))
+    {
+        TRACE("resuming session for %s\n", debugstr_a(info->target));
+        if ((err = pgnutls_session_set_data( s, cache->data, cache->size )) != GNUTLS_E_SUCCESS)
+        {
+            pgnutls_perror( err );
+            free_cache_entry( cache );
+        }
+    }
+    LeaveCriticalSection( &session_cache_cs );
+}
+
+static void cache_session( gnutls_session_t s, struct session_info *info )
+{
+    struct session_cache_entry *cache;
+    size_t size = 0;
+    void *data;
+
+    if (pgnutls_session_get_data( s, NULL, &size ) != GNUTLS_E_SUCCESS || !size) return;
+    if (!(data = heap_alloc( size ))) return;
+    if (pgnutls_session_get_data( s, data, &size ) != GNUTLS_E_SUCCESS)
+    {
+        heap_free( data );
+        return;
+    }
+
+    EnterCriticalSection( &session_cache_cs );
+    if ((cache = find_cache_entry( info->credentials, info->target )))
+    {
+        heap_free( cache->data );
+        list_remove( &cache->entry );
+    }
+    else if ((cache = heap_alloc( sizeof(*cache) )) && (cache->target = heap_alloc( strlen(info->target) + 1 )))
+    {
+        cache->credentials = info->credentials;
+        strcpy( cache->target, info->target );
+        session_cache_count++;
+    }
+    else
+    {
+        LeaveCriticalSection( &session_cache_cs );
+        heap_free( cache );
+        heap_free( data );
+        return;
+    }
+    cache->data = data;
+    cache->size = size;
+    list_add_head( &session_cache, &cache->entry );
+
+    if (session_cache_count > SESSION_CACHE_MAX_ENTRIES)
+        free_cache_entry( LIST_ENTRY( list_tail( &session_cache ), struct session_cache_entry, entry ) );
+    LeaveCriticalSection( &session_cache_cs );
+}
+
 DWORD schan_imp_enabled_protocols(void)
 {
     /* NOTE: No support for SSL 2.0 */
@@ -167,6 +280,7 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
 {
     gnutls_session_t *s = (gnutls_session_t*)session;
     char priority[128] = "NORMAL:%LATEST_RECORD_VERSION", *p;
+    struct session_info *info;
     unsigned i;
 
     int err = pgnutls_init(s, cred->credential_use == SECPKG_CRED_INBOUND ? GNUTLS_SERVER : GNUTLS_CLIENT);
@@ -176,6 +290,17 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
         return FALSE;
     }
 
+    if (cred->credential_use != SECPKG_CRED_INBOUND)
+    {
+        if (!(info = heap_alloc_zero(sizeof(*info))))
+        {
+            pgnutls_deinit(*s);
+            return FALSE;
+        }
+        info->credentials = cred->credentials;
+        pgnutls_session_set_ptr(*s, info);
+    }
+
     p = priority + strlen(priority);
     for(i=0; i < sizeof(protocol_priority_flags)/sizeof(*protocol_priority_flags); i++) {
         *p++ = ':';
@@ -211,6 +336,13 @@ BOOL schan_imp_create_session(schan_imp_session *session, schan_credentials *cre
 void schan_imp_dispose_session(schan_imp_session session)
 {
     gnutls_session_t s = (gnutls_session_t)session;
+    struct session_info *info = pgnutls_session_get_ptr(s);
+
+    if (info)
+    {
+        heap_free(info->target);
+        heap_free(info);
+    }
     pgnutls_deinit(s);
 }
 
@@ -224,8 +356,15 @@ void schan_imp_set_session_transport(schan_imp_session session,
 void schan_imp_set_session_target(schan_imp_session session, const char *target)
 {
     gnutls_session_t s = (gnutls_session_t)session;
+    struct session_info *info = pgnutls_session_get_ptr( s );
 
     pgnutls_server_name_set( s, GNUTLS_NAME_DNS, target, strlen(target) );
+
+    if (info && !info->target && (info->target = heap_alloc( strlen(target) + 1 )))
+    {
+        strcpy( info->target, target );
+        resume_session( s, info );
+    }
 }
 
 SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
@@ -237,8 +376,13 @@ SECURITY_STATUS schan_imp_handshake(schan_imp_session session)
         err = pgnutls_handshake(s);
         switch(err) {
         case GNUTLS_E_SUCCESS:
-            TRACE("Handshake completed\n");
+        {
+            struct session_info *info = pgnutls_session_get_ptr(s);
+
+            TRACE("Handshake completed%s\n", pgnutls_session_is_resumed(s) ? ", session resumed" : "");
+            if (info && info->target) cache_session(s, info);
             return SEC_E_OK;
+        }
 
         case GNUTLS_E_AGAIN:
             TRACE("Continue...\n");
@@ -515,6 +659,13 @@ BOOL schan_imp_allocate_certificate_credentials(schan_credentials *c)
 
 void schan_imp_free_certificate_credentials(schan_credentials *c)
 {
+    struct session_cache_entry *cache, *next;
+
+    EnterCriticalSection(&session_cache_cs);
+    LIST_FOR_EACH_ENTRY_SAFE(cache, next, &session_cache, struct session_cache_entry, entry)
+        if (cache->credentials == c->credentials) free_cache_entry(cache);
+    LeaveCriticalSection(&session_cache_cs);
+
     pgnutls_certificate_free_credentials(c->credentials);
 }
 
@@ -566,6 +717,11 @@ BOOL schan_imp_init(void)
     LOAD_FUNCPTR(gnutls_record_recv);
     LOAD_FUNCPTR(gnutls_record_send);
     LOAD_FUNCPTR(gnutls_server_name_set)
+    LOAD_FUNCPTR(gnutls_session_get_data)
+    LOAD_FUNCPTR(gnutls_session_get_ptr)
+    LOAD_FUNCPTR(gnutls_session_is_resumed)
+    LOAD_FUNCPTR(gnutls_session_set_data)
+    LOAD_FUNCPTR(gnutls_session_set_ptr)
     LOAD_FUNCPTR(gnutls_transport_get_ptr)
     LOAD_FUNCPTR(gnutls_transport_set_errno)
     LOAD_FUNCPTR(gnutls_transport_set_ptr)
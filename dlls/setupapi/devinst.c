@@ -34,6 +34,7 @@
 #include "setupapi.h"
 #include "wine/debug.h"
 #include "wine/list.h"
+#include "wine/perfcounters.h"
 #include "wine/unicode.h"
 #include "cfgmgr32.h"
 #include "winioctl.h"
@@ -2035,6 +2036,335 @@ static void SETUPDI_AddDeviceInterfaces(SP_DEVINFO_DATA *dev, HKEY key,
     /* FIXME: find and add all the device's interfaces to the device */
 }
 
+/* Process-wide cache of the devices and device interfaces registered under
+ * the Enum and DeviceClasses keys, so that repeated enumerations don't walk
+ * the registry again. It is rebuilt after any change to either tree.
+ */
+struct CachedInterfaceRef
+{
+    struct list entry;
+    LPWSTR      referenceString;
+    LPWSTR      symbolicLink;
+};
+
+struct CachedDevice
+{
+    struct list entry;
+    GUID        class;          /* device setup class */
+    GUID        interfaceClass; /* only for interface entries */
+    LPWSTR      instanceId;
+    struct list refs;           /* only for interface entries */
+};
+
+static struct list cachedDevices = LIST_INIT(cachedDevices);
+static struct list cachedInterfaces = LIST_INIT(cachedInterfaces);
+static HANDLE deviceCacheEvent;
+static HKEY deviceCacheEnumKey, deviceCacheClassesKey;
+static BOOL deviceCacheValid;
+
+static CRITICAL_SECTION device_cache_cs;
+static CRITICAL_SECTION_DEBUG device_cache_cs_debug =
+{
+    0, 0, &device_cache_cs,
+    { &device_cache_cs_debug.ProcessLocksList, &device_cache_cs_debug.ProcessLocksList },
+    0, 0, { (DWORD_PTR)(__FILE__ ": device_cache_cs") }
+};
+static CRITICAL_SECTION device_cache_cs = { &device_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static void SETUPDI_FreeCachedDevices(struct list *list)
+{
+    struct CachedDevice *device, *next;
+    struct CachedInterfaceRef *ref, *nextRef;
+
+    LIST_FOR_EACH_ENTRY_SAFE(device, next, list, struct CachedDevice, entry)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE(ref, nextRef, &device->refs,
+                struct CachedInterfaceRef, entry)
+        {
+            HeapFree(GetProcessHeap(), 0, ref->referenceString);
+            HeapFree(GetProcessHeap(), 0, ref->symbolicLink);
+            HeapFree(GetProcessHeap(), 0, ref);
+        }
+        list_remove(&device->entry);
+        HeapFree(GetProcessHeap(), 0, device->instanceId);
+        HeapFree(GetProcessHeap(), 0, device);
+    }
+}
+
+static struct CachedDevice *SETUPDI_AddCachedDevice(struct list *list,
+        const GUID *class, const GUID *interfaceClass, LPCWSTR instanceId)
+{
+    struct CachedDevice *device = HeapAlloc(GetProcessHeap(), 0,
+            sizeof(*device));
+
+    if (!device) return NULL;
+    if (!(device->instanceId = strdupW(instanceId)))
+    {
+        HeapFree(GetProcessHeap(), 0, device);
+        return NULL;
+    }
+    device->class = *class;
+    device->interfaceClass = interfaceClass ? *interfaceClass : GUID_NULL;
+    list_init(&device->refs);
+    list_add_tail(list, &device->entry);
+    return device;
+}
+
+static BOOL SETUPDI_GetKeyClassGuid(HKEY key, GUID *class)
+{
+    WCHAR classGuid[40];
+    DWORD dataType, len = sizeof(classGuid);
+
+    if (RegQueryValueExW(key, ClassGUID, NULL, &dataType, (BYTE *)classGuid,
+            &len) || dataType != REG_SZ)
+        return FALSE;
+    if (classGuid[0] != '{' || classGuid[37] != '}')
+        return FALSE;
+    classGuid[37] = 0;
+    UuidFromStringW(&classGuid[1], class);
+    return TRUE;
+}
+
+static void SETUPDI_CacheDeviceInstances(LPCWSTR enumerator,
+        LPCWSTR deviceName, HKEY deviceKey)
+{
+    static const WCHAR fmt[] = {'%','s','\\','%','s','\\','%','s',0};
+    WCHAR deviceInstance[MAX_PATH], instanceId[3 * MAX_PATH];
+    DWORD i, len;
+    GUID class;
+    HKEY subKey;
+
+    for (i = 0; ; i++)
+    {
+        len = sizeof(deviceInstance) / sizeof(deviceInstance[0]);
+        if (RegEnumKeyExW(deviceKey, i, deviceInstance, &len, NULL, NULL,
+                NULL, NULL))
+            break;
+        if (RegOpenKeyExW(deviceKey, deviceInstance, 0, KEY_READ, &subKey))
+            continue;
+        if (SETUPDI_GetKeyClassGuid(subKey, &class))
+        {
+            sprintfW(instanceId, fmt, enumerator, deviceName, deviceInstance);
+            SETUPDI_AddCachedDevice(&cachedDevices, &class, NULL, instanceId);
+        }
+        RegCloseKey(subKey);
+    }
+}
+
+static void SETUPDI_CacheDevices(HKEY enumKey)
+{
+    WCHAR enumerator[MAX_PATH], deviceName[MAX_PATH];
+    HKEY enumeratorKey, deviceKey;
+    DWORD i, j, len;
+
+    for (i = 0; ; i++)
+    {
+        len = sizeof(enumerator) / sizeof(enumerator[0]);
+        if (RegEnumKeyExW(enumKey, i, enumerator, &len, NULL, NULL, NULL,
+                NULL))
+            break;
+        if (RegOpenKeyExW(enumKey, enumerator, 0, KEY_READ, &enumeratorKey))
+            continue;
+        for (j = 0; ; j++)
+        {
+            len = sizeof(deviceName) / sizeof(deviceName[0]);
+            if (RegEnumKeyExW(enumeratorKey, j, deviceName, &len, NULL, NULL,
+                    NULL, NULL))
+                break;
+            if (RegOpenKeyExW(enumeratorKey, deviceName, 0, KEY_READ,
+                    &deviceKey))
+                continue;
+            SETUPDI_CacheDeviceInstances(enumerator, deviceName, deviceKey);
+            RegCloseKey(deviceKey);
+        }
+        RegCloseKey(enumeratorKey);
+    }
+}
+
+static void SETUPDI_CacheInterfaceRefs(struct CachedDevice *device, HKEY key)
+{
+    struct CachedInterfaceRef *ref;
+    WCHAR subKeyName[MAX_PATH], symbolicLink[MAX_PATH];
+    DWORD i, len, dataType;
+    HKEY subKey;
+
+    for (i = 0; ; i++)
+    {
+        len = sizeof(subKeyName) / sizeof(subKeyName[0]);
+        if (RegEnumKeyExW(key, i, subKeyName, &len, NULL, NULL, NULL, NULL))
+            break;
+        /* The subkey name is the reference string, with a '#' prepended */
+        if (*subKeyName != '#') continue;
+        if (!(ref = HeapAlloc(GetProcessHeap(), 0, sizeof(*ref)))) break;
+        ref->referenceString = strdupW(subKeyName + 1);
+        ref->symbolicLink = NULL;
+        if (!RegOpenKeyExW(key, subKeyName, 0, KEY_READ, &subKey))
+        {
+            len = sizeof(symbolicLink);
+            if (!RegQueryValueExW(subKey, SymbolicLink, NULL, &dataType,
+                    (BYTE *)symbolicLink, &len) && dataType == REG_SZ)
+                ref->symbolicLink = strdupW(symbolicLink);
+            RegCloseKey(subKey);
+        }
+        list_add_tail(&device->refs, &ref->entry);
+    }
+}
+
+static void SETUPDI_CacheInterfaces(HKEY classesKey, HKEY enumKey)
+{
+    WCHAR interfaceGuidStr[40], subKeyName[MAX_PATH];
+    WCHAR deviceInst[MAX_PATH * 3];
+    struct CachedDevice *device;
+    HKEY interfaceKey, subKey, deviceKey;
+    DWORD i, j, len, dataType;
+    GUID interfaceGuid, class;
+
+    for (i = 0; ; i++)
+    {
+        len = sizeof(interfaceGuidStr) / sizeof(interfaceGuidStr[0]);
+        if (RegEnumKeyExW(classesKey, i, interfaceGuidStr, &len, NULL, NULL,
+                NULL, NULL))
+            break;
+        if (interfaceGuidStr[0] != '{' || interfaceGuidStr[37] != '}')
+            continue;
+        if (RegOpenKeyExW(classesKey, interfaceGuidStr, 0, KEY_READ,
+                &interfaceKey))
+            continue;
+        interfaceGuidStr[37] = 0;
+        UuidFromStringW(&interfaceGuidStr[1], &interfaceGuid);
+
+        for (j = 0; ; j++)
+        {
+            len = sizeof(subKeyName) / sizeof(subKeyName[0]);
+            if (RegEnumKeyExW(interfaceKey, j, subKeyName, &len, NULL, NULL,
+                    NULL, NULL))
+                break;
+            if (RegOpenKeyExW(interfaceKey, subKeyName, 0, KEY_READ, &subKey))
+                continue;
+            len = sizeof(deviceInst);
+            if (!RegQueryValueExW(subKey, DeviceInstance, NULL, &dataType,
+                    (BYTE *)deviceInst, &len) && dataType == REG_SZ &&
+                    !RegOpenKeyExW(enumKey, deviceInst, 0, KEY_READ,
+                    &deviceKey))
+            {
+                if (SETUPDI_GetKeyClassGuid(deviceKey, &class) &&
+                        (device = SETUPDI_AddCachedDevice(&cachedInterfaces,
+                        &class, &interfaceGuid, deviceInst)))
+                    SETUPDI_CacheInterfaceRefs(device, subKey);
+                RegCloseKey(deviceKey);
+            }
+            RegCloseKey(subKey);
+        }
+        RegCloseKey(interfaceKey);
+    }
+}
+
+/* Check that the cache is up to date, and rebuild it otherwise.
+ * Caller must hold device_cache_cs.
+ */
+static BOOL SETUPDI_UpdateDeviceCache(void)
+{
+    static const DWORD filter = REG_NOTIFY_CHANGE_NAME |
+        REG_NOTIFY_CHANGE_LAST_SET;
+    static LONGLONG *rebuilds;
+
+    if (!deviceCacheEvent &&
+            !(deviceCacheEvent = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        return FALSE;
+    if (!deviceCacheEnumKey && RegCreateKeyExW(HKEY_LOCAL_MACHINE, Enum, 0,
+            NULL, 0, KEY_READ, NULL, &deviceCacheEnumKey, NULL))
+        return FALSE;
+    if (!deviceCacheClassesKey && RegCreateKeyExW(HKEY_LOCAL_MACHINE,
+            DeviceClasses, 0, NULL, 0, KEY_READ, NULL, &deviceCacheClassesKey,
+            NULL))
+        return FALSE;
+
+    if (deviceCacheValid &&
+            WaitForSingleObject(deviceCacheEvent, 0) == WAIT_TIMEOUT)
+        return TRUE;
+
+    deviceCacheValid = FALSE;
+    SETUPDI_FreeCachedDevices(&cachedDevices);
+    SETUPDI_FreeCachedDevices(&cachedInterfaces);
+
+    /* watch for changes before reading, so that none of them is missed */
+    if (RegNotifyChangeKeyValue(deviceCacheEnumKey, TRUE, filter,
+            deviceCacheEvent, TRUE) ||
+            RegNotifyChangeKeyValue(deviceCacheClassesKey, TRUE, filter,
+            deviceCacheEvent, TRUE))
+        return FALSE;
+
+    SETUPDI_CacheDevices(deviceCacheEnumKey);
+    SETUPDI_CacheInterfaces(deviceCacheClassesKey, deviceCacheEnumKey);
+    deviceCacheValid = TRUE;
+    if (!rebuilds)
+        rebuilds = wine_perf_counter_register("setupapi.device_cache_rebuilds");
+    wine_perf_counter_inc(rebuilds);
+    TRACE("device cache rebuilt\n");
+    return TRUE;
+}
+
+static BOOL SETUPDI_EnumerateCachedInterfaces(struct DeviceInfoSet *set,
+        const GUID *guid, LPCWSTR enumstr, DWORD flags)
+{
+    struct CachedDevice *device;
+    struct CachedInterfaceRef *ref;
+
+    EnterCriticalSection(&device_cache_cs);
+    if (!SETUPDI_UpdateDeviceCache())
+    {
+        LeaveCriticalSection(&device_cache_cs);
+        return FALSE;
+    }
+    LIST_FOR_EACH_ENTRY(device, &cachedInterfaces, struct CachedDevice, entry)
+    {
+        SP_DEVINFO_DATA *dev;
+
+        if (!(flags & DIGCF_ALLCLASSES) &&
+                !IsEqualGUID(guid, &device->interfaceClass))
+            continue;
+        if (enumstr && lstrcmpiW(enumstr, device->instanceId))
+            continue;
+        if (!SETUPDI_AddDeviceToSet(set, &device->class, 0 /* FIXME: DevInst */,
+                device->instanceId, FALSE, &dev))
+            continue;
+        LIST_FOR_EACH_ENTRY(ref, &device->refs, struct CachedInterfaceRef,
+                entry)
+        {
+            SP_DEVICE_INTERFACE_DATA *iface = NULL;
+
+            if (!ref->referenceString) continue;
+            SETUPDI_AddInterfaceInstance(dev, &device->interfaceClass,
+                    ref->referenceString, &iface);
+            if (iface && ref->symbolicLink)
+                SETUPDI_SetInterfaceSymbolicLink(iface, ref->symbolicLink);
+        }
+    }
+    LeaveCriticalSection(&device_cache_cs);
+    return TRUE;
+}
+
+static BOOL SETUPDI_EnumerateCachedDevices(struct DeviceInfoSet *set,
+        const GUID *class, DWORD flags)
+{
+    struct CachedDevice *device;
+
+    EnterCriticalSection(&device_cache_cs);
+    if (!SETUPDI_UpdateDeviceCache())
+    {
+        LeaveCriticalSection(&device_cache_cs);
+        return FALSE;
+    }
+    LIST_FOR_EACH_ENTRY(device, &cachedDevices, struct CachedDevice, entry)
+    {
+        if ((flags & DIGCF_ALLCLASSES) || IsEqualGUID(class, &device->class))
+            SETUPDI_AddDeviceToSet(set, &device->class, 0 /* FIXME: DevInst */,
+                    device->instanceId, FALSE, NULL);
+    }
+    LeaveCriticalSection(&device_cache_cs);
+    return TRUE;
+}
+
 static void SETUPDI_EnumerateMatchingInterfaces(HDEVINFO DeviceInfoSet,
         HKEY key, const GUID *guid, LPCWSTR enumstr)
 {
@@ -2364,8 +2694,13 @@ HDEVINFO WINAPI SetupDiGetClassDevsExW(const GUID *class, PCWSTR enumstr, HWND p
             FIXME("%s: unimplemented for remote machines\n",
                     debugstr_w(machine));
         else if (flags & DIGCF_DEVICEINTERFACE)
-            SETUPDI_EnumerateInterfaces(set, class, enumstr, flags);
-        else
+        {
+            if (!SETUPDI_EnumerateCachedInterfaces(set, class, enumstr, flags))
+                SETUPDI_EnumerateInterfaces(set, class, enumstr, flags);
+        }
+        /* the cached instance IDs don't keep the case of an enumerator
+         * passed by the caller */
+        else if (enumstr || !SETUPDI_EnumerateCachedDevices(set, class, flags))
             SETUPDI_EnumerateDevices(set, class, enumstr, flags);
     }
     return set;
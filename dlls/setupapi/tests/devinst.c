@@ -961,6 +961,16 @@ static void testRegisterAndGetDetail(void)
     /* remove once Wine is fixed */
     devinst_RegDeleteTreeW(HKEY_LOCAL_MACHINE, bogus);
     devinst_RegDeleteTreeW(HKEY_LOCAL_MACHINE, classKey);
+
+    /* the removed device must not be enumerated anymore */
+    set = pSetupDiGetClassDevsA(&guid, NULL, 0, DIGCF_DEVICEINTERFACE);
+    ok(set != INVALID_HANDLE_VALUE, "SetupDiGetClassDevsA failed: %08x\n",
+     GetLastError());
+    SetLastError(0xdeadbeef);
+    ret = pSetupDiEnumDeviceInterfaces(set, NULL, &guid, 0, &interfaceData2);
+    ok(!ret && GetLastError() == ERROR_NO_MORE_ITEMS,
+     "Expected ERROR_NO_MORE_ITEMS, got %d/%08x\n", ret, GetLastError());
+    pSetupDiDestroyDeviceInfoList(set);
 }
 
 static void testDeviceRegistryPropertyA(void)
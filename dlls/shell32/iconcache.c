@@ -36,6 +36,8 @@
 #include "winuser.h"
 #include "winreg.h"
 #include "wine/debug.h"
+#include "wine/perfcounters.h"
+#include "wine/rbtree.h"
 
 #include "shellapi.h"
 #include "objbase.h"
@@ -80,6 +82,340 @@ static const WCHAR ShellIconSize[] = {'S','h','e','l','l',' ','I','c','o','n','
 
 #define SIC_COMPARE_LISTINDEX 1
 
+/********************** THE DISK ICON CACHE ***************************/
+
+/* Icons extracted from files are also stored in a file in the local
+ * application data folder, one per pair of icon sizes, so that other
+ * processes don't have to parse the same resources again. The file is
+ * only appended to; each process maps the existing contents read-only
+ * when its icon cache is initialized and looks icons up by full path,
+ * resource index, last write time and size of the source file. */
+
+#define DISK_CACHE_MAGIC    0x43494857  /* "WHIC" */
+#define DISK_CACHE_VERSION  1
+#define DISK_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+struct disk_cache_header
+{
+    DWORD magic;
+    DWORD version;
+};
+
+struct disk_cache_entry
+{
+    DWORD     size;          /* size of the entry including the data, multiple of 8 */
+    INT       source_index;
+    FILETIME  write_time;
+    ULONGLONG file_size;
+    DWORD     name_len;      /* length of the name including the terminator */
+    DWORD     pad;
+    /* followed by the name, padded to a multiple of 8 bytes, then the
+     * large and small icons as top-down 32bpp rows with alpha */
+};
+
+struct disk_icon
+{
+    struct wine_rb_entry entry;
+    const WCHAR *name;
+    INT source_index;
+    const struct disk_cache_entry *data;
+};
+
+static const struct disk_cache_header *disk_cache;
+static SIZE_T disk_cache_size;
+static struct wine_rb_tree disk_cache_index;
+static WCHAR disk_cache_path[MAX_PATH];
+static SIZE disk_cache_large, disk_cache_small;
+
+static int disk_icon_compare( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct disk_icon *icon1 = key, *icon2 = WINE_RB_ENTRY_VALUE( entry, const struct disk_icon, entry );
+
+    if (icon1->source_index != icon2->source_index) return icon1->source_index < icon2->source_index ? -1 : 1;
+    return strcmpiW( icon1->name, icon2->name );
+}
+
+static void disk_icon_free( struct wine_rb_entry *entry, void *context )
+{
+    heap_free( WINE_RB_ENTRY_VALUE( entry, struct disk_icon, entry ) );
+}
+
+static inline DWORD disk_cache_name_size( DWORD name_len )
+{
+    return (name_len * sizeof(WCHAR) + 7) & ~7;
+}
+
+static inline DWORD disk_cache_entry_size( DWORD name_len )
+{
+    return sizeof(struct disk_cache_entry) + disk_cache_name_size( name_len ) +
+           (disk_cache_large.cx * disk_cache_large.cy + disk_cache_small.cx * disk_cache_small.cy) * sizeof(DWORD);
+}
+
+/* map the existing cache file and index its entries */
+static void disk_cache_init( int cx_large, int cy_large, int cx_small, int cy_small )
+{
+    static const WCHAR fmtW[] = {'%','s','\\','w','i','n','e','_','i','c','o','n','c','a','c','h','e','_',
+                                 '%','u','x','%','u','_','%','u','x','%','u','.','d','b',0};
+    WCHAR dir[MAX_PATH];
+    HANDLE file, mapping;
+    LARGE_INTEGER size;
+    SIZE_T pos;
+    void *view = NULL;
+
+    wine_rb_init( &disk_cache_index, disk_icon_compare );
+    disk_cache_large.cx = cx_large;
+    disk_cache_large.cy = cy_large;
+    disk_cache_small.cx = cx_small;
+    disk_cache_small.cy = cy_small;
+
+    if (FAILED(SHGetFolderPathW( NULL, CSIDL_LOCAL_APPDATA | CSIDL_FLAG_CREATE, NULL, SHGFP_TYPE_CURRENT, dir )))
+        return;
+    if (strlenW( dir ) > MAX_PATH - 40) return;
+    sprintfW( disk_cache_path, fmtW, dir, cx_large, cy_large, cx_small, cy_small );
+
+    file = CreateFileW( disk_cache_path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        NULL, OPEN_EXISTING, 0, NULL );
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    if (!GetFileSizeEx( file, &size ) || size.QuadPart < sizeof(*disk_cache))
+    {
+        CloseHandle( file );
+        return;
+    }
+    if (size.QuadPart > DISK_CACHE_MAX_SIZE)
+    {
+        /* start again from scratch, most of it is probably stale */
+        CloseHandle( file );
+        DeleteFileW( disk_cache_path );
+        return;
+    }
+
+    if ((mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL )))
+    {
+        view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, size.QuadPart );
+        CloseHandle( mapping );
+    }
+    CloseHandle( file );
+    if (!view) return;
+
+    disk_cache = view;
+    disk_cache_size = size.QuadPart;
+    if (disk_cache->magic != DISK_CACHE_MAGIC || disk_cache->version != DISK_CACHE_VERSION)
+    {
+        UnmapViewOfFile( view );
+        disk_cache = NULL;
+        DeleteFileW( disk_cache_path );
+        return;
+    }
+
+    for (pos = sizeof(*disk_cache); pos + sizeof(struct disk_cache_entry) <= disk_cache_size; )
+    {
+        const struct disk_cache_entry *data = (const struct disk_cache_entry *)((const char *)disk_cache + pos);
+        const WCHAR *name = (const WCHAR *)(data + 1);
+        struct disk_icon *icon;
+
+        if (!data->name_len || data->name_len > MAX_PATH || data->size != disk_cache_entry_size( data->name_len ) ||
+            data->size > disk_cache_size - pos || name[data->name_len - 1])
+        {
+            WARN( "corrupted entry at offset %lu\n", pos );
+            break;
+        }
+        pos += data->size;
+
+        if (!(icon = heap_alloc( sizeof(*icon) ))) break;
+        icon->name = name;
+        icon->source_index = data->source_index;
+        icon->data = data;
+        /* later entries replace the earlier ones for the same icon */
+        if (wine_rb_put( &disk_cache_index, icon, &icon->entry ))
+        {
+            struct wine_rb_entry *entry = wine_rb_get( &disk_cache_index, icon );
+            WINE_RB_ENTRY_VALUE( entry, struct disk_icon, entry )->data = data;
+            heap_free( icon );
+        }
+    }
+    TRACE( "mapped %s, %lu bytes\n", debugstr_w(disk_cache_path), disk_cache_size );
+}
+
+static void disk_cache_destroy(void)
+{
+    wine_rb_destroy( &disk_cache_index, disk_icon_free, NULL );
+    if (disk_cache) UnmapViewOfFile( disk_cache );
+    disk_cache = NULL;
+}
+
+static HICON create_icon_from_bits( const DWORD *bits, int cx, int cy )
+{
+    BITMAPINFO info;
+    ICONINFO iconinfo;
+    HBITMAP color, mask;
+    HICON icon = NULL;
+    BYTE *mask_bits;
+    void *color_bits;
+    int x, y, stride = ((cx + 15) / 16) * 2;
+
+    memset( &info, 0, sizeof(info) );
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = cx;
+    info.bmiHeader.biHeight = -cy;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    if (!(color = CreateDIBSection( 0, &info, DIB_RGB_COLORS, &color_bits, NULL, 0 ))) return NULL;
+    memcpy( color_bits, bits, cx * cy * sizeof(DWORD) );
+
+    if (!(mask_bits = heap_alloc_zero( stride * cy )))
+    {
+        DeleteObject( color );
+        return NULL;
+    }
+    for (y = 0; y < cy; y++)
+        for (x = 0; x < cx; x++)
+            if (!(bits[y * cx + x] >> 24)) mask_bits[y * stride + x / 8] |= 0x80 >> (x % 8);
+    mask = CreateBitmap( cx, cy, 1, 1, mask_bits );
+    heap_free( mask_bits );
+
+    if (mask)
+    {
+        iconinfo.fIcon = TRUE;
+        iconinfo.xHotspot = iconinfo.yHotspot = 0;
+        iconinfo.hbmMask = mask;
+        iconinfo.hbmColor = color;
+        icon = CreateIconIndirect( &iconinfo );
+        DeleteObject( mask );
+    }
+    DeleteObject( color );
+    return icon;
+}
+
+/* retrieve the icon as 32bpp pixels with alpha, taking the alpha from the mask if needed */
+static BOOL get_icon_bits( HICON icon, DWORD *bits, int cx, int cy )
+{
+    BITMAPINFO info;
+    ICONINFO iconinfo;
+    BITMAP bm;
+    DWORD *mask_bits;
+    BOOL ret = FALSE, has_alpha = FALSE;
+    HDC hdc;
+    int i;
+
+    if (!GetIconInfo( icon, &iconinfo )) return FALSE;
+    if (!iconinfo.hbmColor || !GetObjectW( iconinfo.hbmColor, sizeof(bm), &bm ) ||
+        bm.bmWidth != cx || bm.bmHeight != cy || !(mask_bits = heap_alloc( cx * cy * sizeof(DWORD) )))
+        goto done;
+
+    memset( &info, 0, sizeof(info) );
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = cx;
+    info.bmiHeader.biHeight = -cy;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    hdc = CreateCompatibleDC( 0 );
+    if (GetDIBits( hdc, iconinfo.hbmColor, 0, cy, bits, &info, DIB_RGB_COLORS ) == cy &&
+        GetDIBits( hdc, iconinfo.hbmMask, 0, cy, mask_bits, &info, DIB_RGB_COLORS ) == cy)
+    {
+        for (i = 0; i < cx * cy; i++) if (bits[i] >> 24) has_alpha = TRUE;
+        if (!has_alpha)
+            for (i = 0; i < cx * cy; i++)
+                bits[i] = (mask_bits[i] & 0xffffff) ? 0 : bits[i] | 0xff000000;
+        ret = TRUE;
+    }
+    DeleteDC( hdc );
+    heap_free( mask_bits );
+
+done:
+    if (iconinfo.hbmColor) DeleteObject( iconinfo.hbmColor );
+    DeleteObject( iconinfo.hbmMask );
+    return ret;
+}
+
+static BOOL disk_cache_lookup( const WCHAR *path, INT source_index, const WIN32_FILE_ATTRIBUTE_DATA *attr,
+                               HICON *large, HICON *small )
+{
+    const struct disk_cache_entry *data;
+    struct wine_rb_entry *entry;
+    struct disk_icon key;
+    const DWORD *bits;
+
+    if (!disk_cache) return FALSE;
+
+    key.name = path;
+    key.source_index = source_index;
+    if (!(entry = wine_rb_get( &disk_cache_index, &key ))) return FALSE;
+    data = WINE_RB_ENTRY_VALUE( entry, struct disk_icon, entry )->data;
+
+    if (CompareFileTime( &data->write_time, &attr->ftLastWriteTime ) ||
+        data->file_size != (((ULONGLONG)attr->nFileSizeHigh << 32) | attr->nFileSizeLow))
+        return FALSE;
+
+    bits = (const DWORD *)((const char *)(data + 1) + disk_cache_name_size( data->name_len ));
+    *large = create_icon_from_bits( bits, disk_cache_large.cx, disk_cache_large.cy );
+    *small = create_icon_from_bits( bits + disk_cache_large.cx * disk_cache_large.cy,
+                                    disk_cache_small.cx, disk_cache_small.cy );
+    if (*large && *small) return TRUE;
+
+    if (*large) DestroyIcon( *large );
+    if (*small) DestroyIcon( *small );
+    *large = *small = NULL;
+    return FALSE;
+}
+
+static void disk_cache_store( const WCHAR *path, INT source_index, const WIN32_FILE_ATTRIBUTE_DATA *attr,
+                              HICON large, HICON small )
+{
+    struct disk_cache_header header;
+    struct disk_cache_entry *data;
+    LARGE_INTEGER size;
+    DWORD *bits, written;
+    HANDLE file;
+
+    if (!disk_cache_path[0]) return;
+
+    data = heap_alloc_zero( disk_cache_entry_size( strlenW( path ) + 1 ));
+    if (!data) return;
+    data->size = disk_cache_entry_size( strlenW( path ) + 1 );
+    data->source_index = source_index;
+    data->write_time = attr->ftLastWriteTime;
+    data->file_size = ((ULONGLONG)attr->nFileSizeHigh << 32) | attr->nFileSizeLow;
+    data->name_len = strlenW( path ) + 1;
+    strcpyW( (WCHAR *)(data + 1), path );
+    bits = (DWORD *)((char *)(data + 1) + disk_cache_name_size( data->name_len ));
+
+    if (!get_icon_bits( large, bits, disk_cache_large.cx, disk_cache_large.cy ) ||
+        !get_icon_bits( small, bits + disk_cache_large.cx * disk_cache_large.cy,
+                        disk_cache_small.cx, disk_cache_small.cy ))
+    {
+        heap_free( data );
+        return;
+    }
+
+    file = CreateFileW( disk_cache_path, FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                        NULL, OPEN_ALWAYS, 0, NULL );
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        /* serialize with the other processes, entries are written in one go */
+        if (LockFile( file, 0, 0, 1, 0 ))
+        {
+            if (GetFileSizeEx( file, &size ) && size.QuadPart < DISK_CACHE_MAX_SIZE)
+            {
+                if (!size.QuadPart)
+                {
+                    header.magic = DISK_CACHE_MAGIC;
+                    header.version = DISK_CACHE_VERSION;
+                    WriteFile( file, &header, sizeof(header), &written, NULL );
+                }
+                WriteFile( file, data, data->size, &written, NULL );
+            }
+            UnlockFile( file, 0, 0, 1, 0 );
+        }
+        CloseHandle( file );
+    }
+    heap_free( data );
+}
+
 /*****************************************************************************
  * SIC_CompareEntries
  *
@@ -370,20 +706,46 @@ static INT SIC_LoadIcon (LPCWSTR sSourceFile, INT dwSourceIndex, DWORD dwFlags)
 	HICON	hiconSmall=0;
 	HICON 	hiconLargeShortcut;
 	HICON	hiconSmallShortcut;
+        WIN32_FILE_ATTRIBUTE_DATA attr;
+        WCHAR path[MAX_PATH];
+        BOOL cached = FALSE;
         int ret;
         SIZE size;
+        static LONGLONG *disk_cache_hits, *disk_cache_misses;
+
+        if (!disk_cache_hits)
+        {
+            disk_cache_misses = wine_perf_counter_register( "shell32.icon_disk_cache_misses" );
+            disk_cache_hits = wine_perf_counter_register( "shell32.icon_disk_cache_hits" );
+        }
 
-        get_imagelist_icon_size( SHIL_LARGE, &size );
-        PrivateExtractIconsW( sSourceFile, dwSourceIndex, size.cx, size.cy, &hiconLarge, 0, 1, 0 );
-        get_imagelist_icon_size( SHIL_SMALL, &size );
-        PrivateExtractIconsW( sSourceFile, dwSourceIndex, size.cx, size.cy, &hiconSmall, 0, 1, 0 );
+        /* try the disk cache first, parsing the resources is much slower */
+        if (GetFullPathNameW( sSourceFile, MAX_PATH, path, NULL ) &&
+            GetFileAttributesExW( path, GetFileExInfoStandard, &attr ))
+            cached = disk_cache_lookup( path, dwSourceIndex, &attr, &hiconLarge, &hiconSmall );
+        else
+            path[0] = 0;
+        wine_perf_counter_inc( cached ? disk_cache_hits : disk_cache_misses );
+
+        if (!cached)
+        {
+            get_imagelist_icon_size( SHIL_LARGE, &size );
+            PrivateExtractIconsW( sSourceFile, dwSourceIndex, size.cx, size.cy, &hiconLarge, 0, 1, 0 );
+            get_imagelist_icon_size( SHIL_SMALL, &size );
+            PrivateExtractIconsW( sSourceFile, dwSourceIndex, size.cx, size.cy, &hiconSmall, 0, 1, 0 );
+        }
 
 	if ( !hiconLarge ||  !hiconSmall)
 	{
 	  WARN("failure loading icon %i from %s (%p %p)\n", dwSourceIndex, debugstr_w(sSourceFile), hiconLarge, hiconSmall);
+	  if (hiconLarge) DestroyIcon( hiconLarge );
+	  if (hiconSmall) DestroyIcon( hiconSmall );
 	  return -1;
 	}
 
+        if (!cached && path[0])
+            disk_cache_store( path, dwSourceIndex, &attr, hiconLarge, hiconSmall );
+
 	if (0 != (dwFlags & GIL_FORSHORTCUT))
 	{
 	  hiconLargeShortcut = SIC_OverlayShortcutImage(hiconLarge, TRUE);
@@ -466,6 +828,8 @@ static BOOL WINAPI SIC_Initialize( INIT_ONCE *once, void *param, void **context
         ImageList_SetBkColor(ShellSmallIconList, CLR_NONE);
         ImageList_SetBkColor(ShellBigIconList, CLR_NONE);
 
+        disk_cache_init( cx_large, cy_large, cx_small, cy_small );
+
         /* Load the document icon, which is used as the default if an icon isn't found. */
         hSm = LoadImageA(shell32_hInstance, MAKEINTRESOURCEA(IDI_SHELL_DOCUMENT),
                                 IMAGE_ICON, cx_small, cy_small, LR_SHARED);
@@ -510,6 +874,8 @@ void SIC_Destroy(void)
 	if (ShellBigIconList)
 	    ImageList_Destroy(ShellBigIconList);
 
+	disk_cache_destroy();
+
 	LeaveCriticalSection(&SHELL32_SicCS);
 	DeleteCriticalSection(&SHELL32_SicCS);
 }
@@ -53,6 +53,8 @@ static void OutputQueue_FreeSamples(OutputQueue *pOutputQueue)
     {
         QueuedEvent *qev = LIST_ENTRY(cursor, QueuedEvent, entry);
         list_remove(cursor);
+        if (qev->type == SAMPLE_PACKET)
+            IMediaSample_Release(qev->pSample);
         HeapFree(GetProcessHeap(),0,qev);
     }
 }
@@ -119,6 +121,13 @@ HRESULT WINAPI OutputQueue_Destroy(OutputQueue *pOutputQueue)
     SetEvent(pOutputQueue->hProcessQueue);
     LeaveCriticalSection(&pOutputQueue->csQueue);
 
+    /* the thread may still be delivering a batch */
+    if (pOutputQueue->hThread)
+    {
+        WaitForSingleObject(pOutputQueue->hThread, INFINITE);
+        CloseHandle(pOutputQueue->hThread);
+    }
+
     pOutputQueue->csQueue.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection(&pOutputQueue->csQueue);
     CloseHandle(pOutputQueue->hProcessQueue);
@@ -176,6 +185,13 @@ HRESULT WINAPI OutputQueue_Receive(OutputQueue *pOutputQueue, IMediaSample *pSam
     return OutputQueue_ReceiveMultiple(pOutputQueue,&pSample,1,&processed);
 }
 
+VOID WINAPI OutputQueue_BeginFlush(OutputQueue *pOutputQueue)
+{
+    EnterCriticalSection(&pOutputQueue->csQueue);
+    OutputQueue_FreeSamples(pOutputQueue);
+    LeaveCriticalSection(&pOutputQueue->csQueue);
+}
+
 VOID WINAPI OutputQueue_SendAnyway(OutputQueue *pOutputQueue)
 {
     if (pOutputQueue->hThread)
@@ -447,10 +447,14 @@ static HRESULT WINAPI TransformFilter_InputPin_EndOfStream(IPin * iface)
 
     TRACE("(%p)->()\n", iface);
 
-    /* Since we process samples synchronously, just forward notification downstream */
+    /* Since we process samples synchronously, just forward notification downstream,
+     * unless the filter queues its output and forwards it itself (S_FALSE) */
     pTransform = impl_from_IBaseFilter(This->pin.pinInfo.pFilter);
     if (!pTransform)
         hr = E_FAIL;
+    else if (pTransform->pFuncsTable->pfnEndOfStream &&
+             (hr = pTransform->pFuncsTable->pfnEndOfStream(pTransform)) != S_OK)
+        return hr;
     else
         hr = IPin_ConnectedTo(pTransform->ppPins[1], &ppin);
     if (SUCCEEDED(hr))
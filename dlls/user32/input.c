@@ -130,6 +130,17 @@ BOOL CDECL __wine_send_input( HWND hwnd, const INPUT *input )
 }
 
 
+/***********************************************************************
+ *		__wine_send_inputs  (USER32.@)
+ *
+ * Same as __wine_send_input for several events, batched into fewer server calls.
+ */
+UINT CDECL __wine_send_inputs( const HWND *hwnds, const INPUT *inputs, UINT count )
+{
+    return send_hardware_messages( hwnds, inputs, count, 0 );
+}
+
+
 /***********************************************************************
  *		update_mouse_coords
  *
@@ -451,6 +462,7 @@ SHORT WINAPI DECLSPEC_HOTPATCH GetAsyncKeyState( INT key )
  */
 DWORD WINAPI GetQueueStatus( UINT flags )
 {
+    const struct queue_shared_memory *shared;
     DWORD ret;
 
     if (flags & ~(QS_ALLINPUT | QS_ALLPOSTMESSAGE | QS_SMRESULT))
@@ -461,6 +473,10 @@ DWORD WINAPI GetQueueStatus( UINT flags )
 
     check_for_events( flags );
 
+    /* nothing to clear, the shared status is enough */
+    if ((shared = get_user_thread_info()->queue_shared) && !(shared->changed_bits & flags))
+        return MAKELONG( 0, shared->wake_bits & flags );
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = flags;
@@ -477,10 +493,14 @@ DWORD WINAPI GetQueueStatus( UINT flags )
  */
 BOOL WINAPI GetInputState(void)
 {
+    const struct queue_shared_memory *shared;
     DWORD ret;
 
     check_for_events( QS_INPUT );
 
+    if ((shared = get_user_thread_info()->queue_shared))
+        return shared->wake_bits & (QS_KEY | QS_MOUSEBUTTON);
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = 0;
@@ -56,6 +56,8 @@ WINE_DECLARE_DEBUG_CHANNEL(key);
 
 #define MAX_PACK_COUNT 4
 
+#define HARDWARE_MESSAGE_BATCH 16  /* max number of hardware messages per server round-trip */
+
 /* the various structures that can be sent in messages, in platform-independent layout */
 struct packed_CREATESTRUCTW
 {
@@ -2725,6 +2727,56 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+/***********************************************************************
+ *           get_queue_shared_memory
+ *
+ * Map the queue status that the server shares with the current thread.
+ */
+static const struct queue_shared_memory *get_queue_shared_memory(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    HANDLE file = 0, mapping;
+
+    if (thread_info->queue_shared) return thread_info->queue_shared;
+
+    SERVER_START_REQ( get_queue_shared_memory )
+    {
+        if (!wine_server_call( req )) file = wine_server_ptr_handle( reply->file );
+    }
+    SERVER_END_REQ;
+    if (!file) return NULL;
+
+    if ((mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL )))
+    {
+        thread_info->queue_shared = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+        CloseHandle( mapping );
+    }
+    CloseHandle( file );
+    return thread_info->queue_shared;
+}
+
+
+/***********************************************************************
+ *           is_queue_empty
+ *
+ * Check from the shared queue status whether get_message would return nothing,
+ * so that polling an empty queue doesn't need a server round-trip.
+ */
+static BOOL is_queue_empty( struct user_thread_info *thread_info, UINT flags )
+{
+    const struct queue_shared_memory *shared;
+    UINT filter = flags >> 16;
+
+    /* still call the server regularly, it uses the last call time to detect hung queues */
+    if (GetTickCount() - thread_info->last_get_msg > 1000) return FALSE;
+    if (!(shared = get_queue_shared_memory())) return FALSE;
+
+    if (!filter) filter = QS_ALLINPUT;
+    if (filter & QS_POSTMESSAGE) filter |= QS_ALLPOSTMESSAGE;
+    return !(shared->wake_bits & (filter | QS_SENDMESSAGE));
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2751,6 +2803,12 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
         size_t size = 0;
         const message_data_t *msg_data = buffer;
 
+        if (is_queue_empty( thread_info, flags ))
+        {
+            HeapFree( GetProcessHeap(), 0, buffer );
+            return FALSE;
+        }
+
         SERVER_START_REQ( get_message )
         {
             req->flags     = flags;
@@ -2778,6 +2836,7 @@ static BOOL peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags
             else buffer_size = reply->total;
         }
         SERVER_END_REQ;
+        thread_info->last_get_msg = GetTickCount();
 
         if (res)
         {
@@ -3006,6 +3065,7 @@ static HANDLE get_server_queue_handle(void)
 static void wait_message_reply( UINT flags )
 {
     struct user_thread_info *thread_info = get_user_thread_info();
+    const struct queue_shared_memory *shared = get_queue_shared_memory();
     HANDLE server_queue = get_server_queue_handle();
     unsigned int wake_mask = QS_SMRESULT | ((flags & SMTO_BLOCK) ? 0 : QS_SENDMESSAGE);
 
@@ -3013,16 +3073,23 @@ static void wait_message_reply( UINT flags )
     {
         unsigned int wake_bits = 0;
 
-        SERVER_START_REQ( set_queue_mask )
+        /* a reply or sent message that is already there doesn't need the server,
+         * which is usually the case right after being woken up */
+        if (shared) wake_bits = shared->wake_bits & wake_mask;
+
+        if (!wake_bits)
         {
-            req->wake_mask    = wake_mask;
-            req->changed_mask = wake_mask;
-            req->skip_wait    = 1;
-            if (!wine_server_call( req )) wake_bits = reply->wake_bits & wake_mask;
-        }
-        SERVER_END_REQ;
+            SERVER_START_REQ( set_queue_mask )
+            {
+                req->wake_mask    = wake_mask;
+                req->changed_mask = wake_mask;
+                req->skip_wait    = 1;
+                if (!wine_server_call( req )) wake_bits = reply->wake_bits & wake_mask;
+            }
+            SERVER_END_REQ;
 
-        thread_info->wake_mask = thread_info->changed_mask = 0;
+            thread_info->wake_mask = thread_info->changed_mask = 0;
+        }
 
         if (wake_bits & QS_SMRESULT) return;  /* got a result */
         if (wake_bits & QS_SENDMESSAGE)
@@ -3288,16 +3355,47 @@ static BOOL send_message( struct send_message_info *info, DWORD_PTR *res_ptr, BO
 
 
 /***********************************************************************
- *		send_hardware_message
+ *		init_hardware_message_req
  */
-NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags )
+static void init_hardware_message_req( struct send_hardware_message_request *req, HWND hwnd,
+                                       const INPUT *input, UINT flags )
+{
+    req->win        = wine_server_user_handle( hwnd );
+    req->flags      = flags;
+    req->input.type = input->type;
+    switch (input->type)
+    {
+    case INPUT_MOUSE:
+        req->input.mouse.x     = input->u.mi.dx;
+        req->input.mouse.y     = input->u.mi.dy;
+        req->input.mouse.data  = input->u.mi.mouseData;
+        req->input.mouse.flags = input->u.mi.dwFlags;
+        req->input.mouse.time  = input->u.mi.time;
+        req->input.mouse.info  = input->u.mi.dwExtraInfo;
+        break;
+    case INPUT_KEYBOARD:
+        req->input.kbd.vkey  = input->u.ki.wVk;
+        req->input.kbd.scan  = input->u.ki.wScan;
+        req->input.kbd.flags = input->u.ki.dwFlags;
+        req->input.kbd.time  = input->u.ki.time;
+        req->input.kbd.info  = input->u.ki.dwExtraInfo;
+        break;
+    case INPUT_HARDWARE:
+        req->input.hw.msg    = input->u.hi.uMsg;
+        req->input.hw.lparam = MAKELONG( input->u.hi.wParamL, input->u.hi.wParamH );
+        break;
+    }
+}
+
+/***********************************************************************
+ *		wait_hardware_message_reply
+ *
+ * Wait for the low-level hooks to process a hardware message.
+ */
+static void wait_hardware_message_reply( HWND hwnd )
 {
-    struct user_key_state_info *key_state_info = get_user_thread_info()->key_state;
     struct send_message_info info;
-    int prev_x, prev_y, new_x, new_y;
-    INT counter = global_key_state_counter;
-    NTSTATUS ret;
-    BOOL wait;
+    LRESULT ignored;
 
     info.type     = MSG_HARDWARE;
     info.dest_tid = 0;
@@ -3305,33 +3403,24 @@ NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags )
     info.flags    = 0;
     info.timeout  = 0;
 
+    wait_message_reply( 0 );
+    retrieve_reply( &info, 0, &ignored );
+}
+
+/***********************************************************************
+ *		send_hardware_message
+ */
+NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags )
+{
+    struct user_key_state_info *key_state_info = get_user_thread_info()->key_state;
+    int prev_x, prev_y, new_x, new_y;
+    INT counter = global_key_state_counter;
+    NTSTATUS ret;
+    BOOL wait;
+
     SERVER_START_REQ( send_hardware_message )
     {
-        req->win        = wine_server_user_handle( hwnd );
-        req->flags      = flags;
-        req->input.type = input->type;
-        switch (input->type)
-        {
-        case INPUT_MOUSE:
-            req->input.mouse.x     = input->u.mi.dx;
-            req->input.mouse.y     = input->u.mi.dy;
-            req->input.mouse.data  = input->u.mi.mouseData;
-            req->input.mouse.flags = input->u.mi.dwFlags;
-            req->input.mouse.time  = input->u.mi.time;
-            req->input.mouse.info  = input->u.mi.dwExtraInfo;
-            break;
-        case INPUT_KEYBOARD:
-            req->input.kbd.vkey  = input->u.ki.wVk;
-            req->input.kbd.scan  = input->u.ki.wScan;
-            req->input.kbd.flags = input->u.ki.dwFlags;
-            req->input.kbd.time  = input->u.ki.time;
-            req->input.kbd.info  = input->u.ki.dwExtraInfo;
-            break;
-        case INPUT_HARDWARE:
-            req->input.hw.msg    = input->u.hi.uMsg;
-            req->input.hw.lparam = MAKELONG( input->u.hi.wParamL, input->u.hi.wParamH );
-            break;
-        }
+        init_hardware_message_req( req, hwnd, input, flags );
         if (key_state_info) wine_server_set_reply( req, key_state_info->state,
                                                    sizeof(key_state_info->state) );
         ret = wine_server_call( req );
@@ -3354,13 +3443,56 @@ NTSTATUS send_hardware_message( HWND hwnd, const INPUT *input, UINT flags )
             USER_Driver->pSetCursorPos( new_x, new_y );
     }
 
-    if (wait)
+    if (wait) wait_hardware_message_reply( hwnd );
+    return ret;
+}
+
+/***********************************************************************
+ *		send_hardware_messages
+ *
+ * Send several hardware messages in a single server round-trip.
+ * Return the number of messages that were sent successfully.
+ */
+UINT send_hardware_messages( const HWND *hwnds, const INPUT *inputs, UINT count, UINT flags )
+{
+    struct __server_request_info reqs[HARDWARE_MESSAGE_BATCH];
+    struct user_key_state_info *key_state_info = get_user_thread_info()->key_state;
+    const struct send_hardware_message_reply *reply;
+    INT counter = global_key_state_counter;
+    UINT i, done = 0, batch;
+
+    for ( ; count; count -= batch, hwnds += batch, inputs += batch)
     {
-        LRESULT ignored;
-        wait_message_reply( 0 );
-        retrieve_reply( &info, 0, &ignored );
+        batch = min( count, HARDWARE_MESSAGE_BATCH );
+        for (i = 0; i < batch; i++)
+        {
+            struct send_hardware_message_request *req;
+
+            req = wine_server_init_req( &reqs[i], REQ_send_hardware_message );
+            init_hardware_message_req( req, hwnds[i], &inputs[i], flags );
+            if (key_state_info) wine_server_set_reply( req, key_state_info->state,
+                                                       sizeof(key_state_info->state) );
+        }
+        wine_server_call_batch( reqs, batch, 0 );
+
+        for (i = 0; i < batch; i++)
+        {
+            reply = &reqs[i].u.reply.send_hardware_message_reply;
+            if (!reply->__header.error)
+            {
+                done++;
+                if (key_state_info)
+                {
+                    key_state_info->time    = GetTickCount();
+                    key_state_info->counter = counter;
+                }
+                if ((flags & SEND_HWMSG_INJECTED) && (reply->prev_x != reply->new_x || reply->prev_y != reply->new_y))
+                    USER_Driver->pSetCursorPos( reply->new_x, reply->new_y );
+                if (reply->wait) wait_hardware_message_reply( hwnds[i] );
+            }
+        }
     }
-    return ret;
+    return done;
 }
 
 
@@ -807,4 +807,5 @@
 # or 'wine_' (for user-visible functions) to avoid namespace conflicts.
 #
 @ cdecl __wine_send_input(long ptr)
+@ cdecl __wine_send_inputs(ptr ptr long)
 @ cdecl __wine_set_pixel_format(long long)
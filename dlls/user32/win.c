@@ -58,6 +58,8 @@ static CRITICAL_SECTION surfaces_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
 /**********************************************************************/
 
+static const struct shared_window_info *shared_windows;
+
 /* helper for Get/SetWindowLong */
 static inline LONG_PTR get_win_data( const void *ptr, UINT size )
 {
@@ -345,6 +347,180 @@ static HWND *list_window_children( HDESK desktop, HWND hwnd, LPCWSTR class, DWOR
 }
 
 
+/*******************************************************************
+ *           list_existing_window_children
+ *
+ * Check that a window exists and build the array of its children, using a
+ * single server round-trip. Return FALSE if the window doesn't exist.
+ * The array must be freed with HeapFree.
+ */
+static BOOL list_existing_window_children( HWND hwnd, HWND **children )
+{
+    struct __server_request_info reqs[2];
+    struct get_window_info_request *info_req;
+    struct get_window_children_request *children_req;
+    HWND *list;
+    int i, count = 0, size = 128;
+
+    *children = NULL;
+    if (!(list = HeapAlloc( GetProcessHeap(), 0, size * sizeof(HWND) ))) return IsWindow( hwnd );
+
+    info_req = wine_server_init_req( &reqs[0], REQ_get_window_info );
+    info_req->handle = wine_server_user_handle( hwnd );
+    children_req = wine_server_init_req( &reqs[1], REQ_get_window_children );
+    children_req->parent = wine_server_user_handle( hwnd );
+    wine_server_set_reply( children_req, list, (size - 1) * sizeof(user_handle_t) );
+
+    if (wine_server_call_batch( reqs, 2, BATCH_STOP_ON_ERROR ))
+    {
+        HeapFree( GetProcessHeap(), 0, list );
+        return !reqs[0].u.reply.reply_header.error;
+    }
+    count = reqs[1].u.reply.get_window_children_reply.count;
+
+    if (count && count < size)
+    {
+        /* start from the end since HWND is potentially larger than user_handle_t */
+        for (i = count - 1; i >= 0; i--)
+            list[i] = wine_server_ptr_handle( ((user_handle_t *)list)[i] );
+        list[count] = 0;
+        *children = list;
+        return TRUE;
+    }
+    HeapFree( GetProcessHeap(), 0, list );
+    if (count) *children = list_window_children( 0, hwnd, NULL, 0 );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           get_shared_windows
+ *
+ * Map the window information that the server shares with all the clients.
+ */
+static const struct shared_window_info *get_shared_windows(void)
+{
+    static BOOL failed;
+    HANDLE file = 0, mapping;
+    void *ptr = NULL;
+
+    if (shared_windows || failed) return shared_windows;
+
+    SERVER_START_REQ( get_shared_windows )
+    {
+        if (!wine_server_call( req )) file = wine_server_ptr_handle( reply->file );
+    }
+    SERVER_END_REQ;
+    if (file)
+    {
+        if ((mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL )))
+        {
+            ptr = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+            CloseHandle( mapping );
+        }
+        CloseHandle( file );
+    }
+    if (!ptr) failed = TRUE;
+    else if (InterlockedCompareExchangePointer( (void **)&shared_windows, ptr, NULL ))
+        UnmapViewOfFile( ptr );  /* another thread mapped it first */
+    return shared_windows;
+}
+
+
+/***********************************************************************
+ *           get_shared_window_info
+ *
+ * Get a consistent copy of the information the server shares about a window.
+ * Used to avoid server round-trips for windows of other processes.
+ */
+static BOOL get_shared_window_info( HWND hwnd, struct shared_window_info *info )
+{
+    const volatile struct shared_window_info *entry;
+    WORD index = LOWORD(hwnd), generation = HIWORD(hwnd);
+    unsigned int seq, i;
+
+    if (index < FIRST_USER_HANDLE || index > LAST_USER_HANDLE) return FALSE;
+    if (!get_shared_windows()) return FALSE;
+    entry = &shared_windows[(index - FIRST_USER_HANDLE) >> 1];
+
+    for (i = 0; i < 100; i++)
+    {
+        if ((seq = entry->seq) & 1) continue;  /* being updated */
+        __sync_synchronize();
+        *info = *(const struct shared_window_info *)entry;
+        __sync_synchronize();
+        if (entry->seq != seq) continue;
+
+        if (!info->handle || LOWORD(info->handle) != index) return FALSE;
+        if (generation && generation != 0xffff && generation != HIWORD(info->handle)) return FALSE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+
+/***********************************************************************
+ *           get_shared_window_rectangles
+ *
+ * Same as WIN_GetRectangles, using the shared window information.
+ */
+static BOOL get_shared_window_rectangles( HWND hwnd, enum coords_relative relative,
+                                          RECT *rectWindow, RECT *rectClient )
+{
+    struct shared_window_info info;
+    RECT window_rect, client_rect, rect;
+    int depth = 0;
+
+    if (!get_shared_window_info( hwnd, &info )) return FALSE;
+    SetRect( &window_rect, info.window_rect.left, info.window_rect.top,
+             info.window_rect.right, info.window_rect.bottom );
+    SetRect( &client_rect, info.client_rect.left, info.client_rect.top,
+             info.client_rect.right, info.client_rect.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        rect = client_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &window_rect );
+        break;
+    case COORDS_WINDOW:
+        rect = window_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &client_rect );
+        break;
+    case COORDS_PARENT:
+        if (!info.parent) break;
+        if (!get_shared_window_info( wine_server_ptr_handle( info.parent ), &info )) return FALSE;
+        if (info.ex_style & WS_EX_LAYOUTRTL)
+        {
+            SetRect( &rect, info.client_rect.left, info.client_rect.top,
+                     info.client_rect.right, info.client_rect.bottom );
+            mirror_rect( &rect, &window_rect );
+            mirror_rect( &rect, &client_rect );
+        }
+        break;
+    case COORDS_SCREEN:
+        while (info.parent)
+        {
+            if (++depth > 256) return FALSE;  /* the tree changed while we walked it */
+            if (!get_shared_window_info( wine_server_ptr_handle( info.parent ), &info )) return FALSE;
+            if (!info.parent) break;  /* desktop window */
+            OffsetRect( &window_rect, info.client_rect.left, info.client_rect.top );
+            OffsetRect( &client_rect, info.client_rect.left, info.client_rect.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    return TRUE;
+}
+
+
 /*******************************************************************
  *           list_window_parents
  *
@@ -353,6 +529,7 @@ static HWND *list_window_children( HDESK desktop, HWND hwnd, LPCWSTR class, DWOR
  */
 static HWND *list_window_parents( HWND hwnd )
 {
+    struct shared_window_info info;
     WND *win;
     HWND current, *list;
     int i, pos = 0, size = 16, count;
@@ -383,7 +560,22 @@ static HWND *list_window_parents( HWND hwnd )
         }
     }
 
-    /* at least one parent belongs to another process, have to query the server */
+    /* at least one parent belongs to another process, try the shared information first */
+
+    while (get_shared_window_info( current, &info ))
+    {
+        list[pos] = current = wine_server_ptr_handle( info.parent );
+        if (!current) return list;
+        if (++pos == size - 1)
+        {
+            HWND *new_list = HeapReAlloc( GetProcessHeap(), 0, list, (size+16) * sizeof(HWND) );
+            if (!new_list) goto empty;
+            list = new_list;
+            size += 16;
+        }
+    }
+
+    /* have to query the server */
 
     for (;;)
     {
@@ -915,6 +1107,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shared_window_rectangles( hwnd, relative, rectWindow, rectClient )) return TRUE;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2256,11 +2450,24 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
 
     if (wndPtr == WND_OTHER_PROCESS)
     {
+        struct shared_window_info info;
+
         if (offset == GWLP_WNDPROC)
         {
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if (offset < 0 && get_shared_window_info( hwnd, &info ))
+        {
+            switch (offset)
+            {
+            case GWL_STYLE:      return info.style;
+            case GWL_EXSTYLE:    return info.ex_style;
+            case GWLP_ID:        return info.id;
+            case GWLP_HINSTANCE: return (ULONG_PTR)wine_server_get_ptr( info.instance );
+            case GWLP_USERDATA:  return info.user_data;
+            }
+        }
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -2924,7 +3131,17 @@ HWND WINAPI GetParent( HWND hwnd )
     if (wndPtr == WND_DESKTOP) return 0;
     if (wndPtr == WND_OTHER_PROCESS)
     {
-        LONG style = GetWindowLongW( hwnd, GWL_STYLE );
+        struct shared_window_info info;
+        LONG style;
+
+        if (get_shared_window_info( hwnd, &info ))
+        {
+            if (!info.parent) return 0;
+            if (info.style & WS_POPUP) return wine_server_ptr_handle( info.owner );
+            if (info.style & WS_CHILD) return wine_server_ptr_handle( info.parent );
+            return 0;
+        }
+        style = GetWindowLongW( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
         {
             SERVER_START_REQ( get_window_tree )
@@ -2954,6 +3171,7 @@ HWND WINAPI GetParent( HWND hwnd )
  */
 HWND WINAPI GetAncestor( HWND hwnd, UINT type )
 {
+    struct shared_window_info info;
     WND *win;
     HWND *list, ret = 0;
 
@@ -2971,6 +3189,7 @@ HWND WINAPI GetAncestor( HWND hwnd, UINT type )
             ret = win->parent;
             WIN_ReleasePtr( win );
         }
+        else if (get_shared_window_info( hwnd, &info )) ret = wine_server_ptr_handle( info.parent );
         else /* need to query the server */
         {
             SERVER_START_REQ( get_window_tree )
@@ -3421,10 +3640,8 @@ static BOOL WIN_EnumChildWindows( HWND *list, WNDENUMPROC func, LPARAM lParam )
 
     for ( ; *list; list++)
     {
-        /* Make sure that the window still exists */
-        if (!IsWindow( *list )) continue;
-        /* Build children list first */
-        childList = WIN_ListChildren( *list );
+        /* Make sure that the window still exists and build children list first */
+        if (!list_existing_window_children( *list, &childList )) continue;
 
         ret = enum_callback_wrapper( func, *list, lParam );
 
@@ -1324,6 +1324,75 @@ static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_d
     return S_OK;
 }
 
+/* Local variables and arguments index vars first, then args. */
+static BOOL lookup_local(function_t *func, const WCHAR *name, BOOL let, unsigned *ret)
+{
+    unsigned i;
+
+    /* assigning to the function name sets its return value */
+    if(let && (func->type == FUNC_FUNCTION || func->type == FUNC_PROPGET || func->type == FUNC_DEFGET)
+            && !strcmpiW(name, func->name))
+        return FALSE;
+
+    for(i = 0; i < func->var_cnt; i++) {
+        if(!strcmpiW(func->vars[i].name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    for(i = 0; i < func->arg_cnt; i++) {
+        if(!strcmpiW(func->args[i].name, name)) {
+            *ret = func->var_cnt + i;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*
+ * Local variables and arguments take precedence over any other identifier,
+ * so references to them can be bound once the function is compiled instead
+ * of being looked up by name on every execution.
+ */
+static void resolve_locals(compile_ctx_t *ctx, function_t *func)
+{
+    instr_t *instr;
+    unsigned idx;
+
+    for(instr = ctx->code->instrs + func->code_off; instr < ctx->code->instrs + ctx->instr_cnt; instr++) {
+        switch(instr->op) {
+        case OP_icall:
+            if(!instr->arg2.uint && lookup_local(func, instr->arg1.bstr, FALSE, &idx)) {
+                instr->op = OP_local;
+                instr->arg1.uint = idx;
+            }
+            break;
+        case OP_assign_ident:
+            if(lookup_local(func, instr->arg1.bstr, TRUE, &idx)) {
+                instr->op = OP_assign_local;
+                instr->arg1.uint = idx;
+            }
+            break;
+        case OP_incc:
+            if(lookup_local(func, instr->arg1.bstr, TRUE, &idx)) {
+                instr->op = OP_incc_local;
+                instr->arg1.uint = idx;
+            }
+            break;
+        case OP_step:
+            if(lookup_local(func, instr->arg2.bstr, FALSE, &idx)) {
+                instr->op = OP_step_local;
+                instr->arg2.uint = idx;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *func)
 {
     HRESULT hres;
@@ -1417,6 +1486,9 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         }
     }
 
+    if(func->type != FUNC_GLOBAL)
+        resolve_locals(ctx, func);
+
     if(func->array_cnt) {
         unsigned array_id = 0;
         dim_decl_t *dim_decl;
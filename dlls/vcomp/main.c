@@ -54,6 +54,10 @@ static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static RTL_CRITICAL_SECTION vcomp_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+/* number of polls before a waiting thread goes to sleep, spinning is only
+ * done when each thread of the team can have a processor of its own */
+#define VCOMP_SPIN_COUNT 4000
+
 #define VCOMP_DYNAMIC_FLAGS_STATIC      0x01
 #define VCOMP_DYNAMIC_FLAGS_CHUNKED     0x02
 #define VCOMP_DYNAMIC_FLAGS_GUIDED      0x03
@@ -82,6 +86,11 @@ struct vcomp_thread_data
     unsigned int            dynamic_type;
     unsigned int            dynamic_begin;
     unsigned int            dynamic_end;
+    unsigned int            dynamic_first;
+    unsigned int            dynamic_last;
+    unsigned int            dynamic_iterations;
+    int                     dynamic_step;
+    unsigned int            dynamic_chunksize;
 };
 
 struct vcomp_team_data
@@ -97,7 +106,8 @@ struct vcomp_team_data
 
     /* barrier */
     unsigned int            barrier;
-    int                     barrier_count;
+    LONG                    barrier_count;
+    LONG                    barrier_sleepers;
 };
 
 struct vcomp_task_data
@@ -110,13 +120,10 @@ struct vcomp_task_data
     int                     num_sections;
     int                     section_index;
 
-    /* dynamic */
-    unsigned int            dynamic;
-    unsigned int            dynamic_first;
-    unsigned int            dynamic_last;
-    unsigned int            dynamic_iterations;
-    int                     dynamic_step;
-    unsigned int            dynamic_chunksize;
+    /* dynamic, the loop generation in the high and the number of
+     * iterations handed out in the low 32 bits, so a chunk can be taken
+     * with a single compare-exchange */
+    LONGLONG DECLSPEC_ALIGN(8) dynamic;
 };
 
 #if defined(__i386__)
@@ -379,6 +386,22 @@ static short interlocked_xchg_add16(short *dest, short incr)
 
 #endif  /* __GNUC__ */
 
+static inline void vcomp_spin_pause(void)
+{
+#ifdef __GNUC__
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__( "rep;nop" : : : "memory" );
+#else
+    __asm__ __volatile__( "" : : : "memory" );
+#endif
+#endif
+}
+
+static inline BOOL vcomp_can_spin(int num_threads)
+{
+    return num_threads <= vcomp_max_threads;
+}
+
 static inline struct vcomp_thread_data *vcomp_get_thread_data(void)
 {
     return (struct vcomp_thread_data *)TlsGetValue(vcomp_context_tls);
@@ -1057,22 +1080,43 @@ void CDECL _vcomp_barrier(void)
 
     TRACE("()\n");
 
+    unsigned int barrier;
+    int i;
+
     if (!team_data)
         return;
 
-    EnterCriticalSection(&vcomp_section);
-    if (++team_data->barrier_count >= team_data->num_threads)
+    /* the generation can only change once this thread has arrived */
+    barrier = team_data->barrier;
+    if (InterlockedIncrement(&team_data->barrier_count) >= team_data->num_threads)
     {
-        team_data->barrier++;
         team_data->barrier_count = 0;
-        WakeAllConditionVariable(&team_data->cond);
+        InterlockedIncrement((LONG *)&team_data->barrier);
+        if (team_data->barrier_sleepers)
+        {
+            EnterCriticalSection(&vcomp_section);
+            WakeAllConditionVariable(&team_data->cond);
+            LeaveCriticalSection(&vcomp_section);
+        }
+        return;
     }
-    else
+
+    if (vcomp_can_spin(team_data->num_threads))
     {
-        unsigned int barrier = team_data->barrier;
-        while (team_data->barrier == barrier)
-            SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
+        for (i = 0; i < VCOMP_SPIN_COUNT; i++)
+        {
+            if (*(volatile unsigned int *)&team_data->barrier != barrier) return;
+            vcomp_spin_pause();
+        }
     }
+
+    /* the last thread checks for sleepers after changing the generation,
+     * and a sleeper checks the generation after registering */
+    EnterCriticalSection(&vcomp_section);
+    InterlockedIncrement(&team_data->barrier_sleepers);
+    while (*(volatile unsigned int *)&team_data->barrier == barrier)
+        SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
+    InterlockedDecrement(&team_data->barrier_sleepers);
     LeaveCriticalSection(&vcomp_section);
 }
 
@@ -1339,19 +1383,26 @@ void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsig
             type = VCOMP_DYNAMIC_FLAGS_GUIDED;
         }
 
-        EnterCriticalSection(&vcomp_section);
+        LONGLONG state, prev;
+
+        /* every thread of the team is called with the same loop, so each
+         * one keeps its own copy and only the progress is shared */
         thread_data->dynamic++;
-        thread_data->dynamic_type = type;
-        if ((int)(thread_data->dynamic - task_data->dynamic) > 0)
+        thread_data->dynamic_type       = type;
+        thread_data->dynamic_first      = first;
+        thread_data->dynamic_last       = last;
+        thread_data->dynamic_iterations = iterations;
+        thread_data->dynamic_step       = step;
+        thread_data->dynamic_chunksize  = chunksize;
+
+        state = task_data->dynamic;
+        while ((int)(thread_data->dynamic - (unsigned int)((ULONGLONG)state >> 32)) > 0)
         {
-            task_data->dynamic              = thread_data->dynamic;
-            task_data->dynamic_first        = first;
-            task_data->dynamic_last         = last;
-            task_data->dynamic_iterations   = iterations;
-            task_data->dynamic_step         = step;
-            task_data->dynamic_chunksize    = chunksize;
+            prev = InterlockedCompareExchange64(&task_data->dynamic,
+                                                (LONGLONG)((ULONGLONG)thread_data->dynamic << 32), state);
+            if (prev == state) break;
+            state = prev;
         }
-        LeaveCriticalSection(&vcomp_section);
     }
 }
 
@@ -1374,26 +1425,37 @@ int CDECL _vcomp_for_dynamic_next(unsigned int *begin, unsigned int *end)
     else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_CHUNKED ||
              thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED)
     {
-        unsigned int iterations = 0;
-        EnterCriticalSection(&vcomp_section);
-        if (thread_data->dynamic == task_data->dynamic &&
-            task_data->dynamic_iterations != 0)
+        unsigned int iterations, done, remaining;
+        LONGLONG state;
+
+        do
         {
-            iterations = min(task_data->dynamic_iterations, task_data->dynamic_chunksize);
+            /* a newer loop has been started if the generation changed */
+            state = *(volatile LONGLONG *)&task_data->dynamic;
+            if ((unsigned int)((ULONGLONG)state >> 32) != thread_data->dynamic)
+                return 0;
+
+            done = (unsigned int)state;
+            if (done >= thread_data->dynamic_iterations)
+                return 0;
+
+            remaining  = thread_data->dynamic_iterations - done;
+            iterations = min(remaining, thread_data->dynamic_chunksize);
             if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED &&
-                task_data->dynamic_iterations > num_threads * task_data->dynamic_chunksize)
+                remaining > num_threads * thread_data->dynamic_chunksize)
             {
-                iterations = (task_data->dynamic_iterations + num_threads - 1) / num_threads;
+                iterations = (remaining + num_threads - 1) / num_threads;
             }
-            *begin = task_data->dynamic_first;
-            *end   = task_data->dynamic_first + (iterations - 1) * task_data->dynamic_step;
-            task_data->dynamic_iterations -= iterations;
-            task_data->dynamic_first      += iterations * task_data->dynamic_step;
-            if (!task_data->dynamic_iterations)
-                *end = task_data->dynamic_last;
+            if (!iterations)
+                return 0;
         }
-        LeaveCriticalSection(&vcomp_section);
-        return iterations != 0;
+        while (InterlockedCompareExchange64(&task_data->dynamic, state + iterations, state) != state);
+
+        *begin = thread_data->dynamic_first + done * thread_data->dynamic_step;
+        *end   = *begin + (iterations - 1) * thread_data->dynamic_step;
+        if (iterations == remaining)
+            *end = thread_data->dynamic_last;
+        return 1;
     }
 
     return 0;
@@ -1427,6 +1489,22 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
             list_add_tail(&vcomp_idle_threads, &thread_data->entry);
             if (++team->finished_threads >= team->num_threads)
                 WakeAllConditionVariable(&team->cond);
+
+            /* parallel regions often follow each other closely, so stay
+             * ready for a little while before going to sleep */
+            if (vcomp_can_spin(team->num_threads))
+            {
+                int i;
+
+                LeaveCriticalSection(&vcomp_section);
+                for (i = 0; i < VCOMP_SPIN_COUNT; i++)
+                {
+                    if (*(struct vcomp_team_data * volatile *)&thread_data->team) break;
+                    vcomp_spin_pause();
+                }
+                EnterCriticalSection(&vcomp_section);
+                if (thread_data->team) continue;
+            }
         }
 
         if (!SleepConditionVariableCS(&thread_data->cond, &vcomp_section, 5000) &&
@@ -1474,6 +1552,7 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     __ms_va_start(team_data.valist, wrapper);
     team_data.barrier           = 0;
     team_data.barrier_count     = 0;
+    team_data.barrier_sleepers  = 0;
 
     task_data.single            = 0;
     task_data.section           = 0;
@@ -1562,6 +1641,19 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
         EnterCriticalSection(&vcomp_section);
 
         team_data.finished_threads++;
+        if (team_data.finished_threads < team_data.num_threads &&
+            vcomp_can_spin(team_data.num_threads))
+        {
+            int i;
+
+            LeaveCriticalSection(&vcomp_section);
+            for (i = 0; i < VCOMP_SPIN_COUNT; i++)
+            {
+                if (*(volatile int *)&team_data.finished_threads >= team_data.num_threads) break;
+                vcomp_spin_pause();
+            }
+            EnterCriticalSection(&vcomp_section);
+        }
         while (team_data.finished_threads < team_data.num_threads)
             SleepConditionVariableCS(&team_data.cond, &vcomp_section, INFINITE);
 
@@ -129,6 +129,69 @@ static void to_sRGB(BYTE *bgr)
 }
 #endif
 
+/* Undoing premultiplied alpha divides every color component by the alpha
+ * value. c * 255 / alpha is computed exactly as (c * 255 * recip[alpha]) >> 24,
+ * with recip[alpha] = ceil(2^24 / alpha), since c * 255 is below 2^16. */
+static DWORD unpremultiply_recip[256];
+static LONG unpremultiply_recip_init;
+
+static const DWORD *get_unpremultiply_recip(void)
+{
+    unsigned int alpha;
+
+    if (!unpremultiply_recip_init)
+    {
+        for (alpha = 1; alpha < 256; alpha++)
+            unpremultiply_recip[alpha] = ((1 << 24) + alpha - 1) / alpha;
+        InterlockedExchange(&unpremultiply_recip_init, TRUE);
+    }
+    return unpremultiply_recip;
+}
+
+static void unpremultiply_32bpp(BYTE *bits, UINT width, UINT height, UINT stride)
+{
+    const DWORD *recip = get_unpremultiply_recip();
+    UINT x, y;
+
+    for (y = 0; y < height; y++)
+    {
+        BYTE *pixel = bits + stride * y;
+
+        for (x = 0; x < width; x++, pixel += 4)
+        {
+            BYTE alpha = pixel[3];
+            if (alpha != 0 && alpha != 255)
+            {
+                UINT64 r = recip[alpha];
+                pixel[0] = (pixel[0] * 255 * r) >> 24;
+                pixel[1] = (pixel[1] * 255 * r) >> 24;
+                pixel[2] = (pixel[2] * 255 * r) >> 24;
+            }
+        }
+    }
+}
+
+static void premultiply_32bpp(BYTE *bits, UINT width, UINT height, UINT stride)
+{
+    UINT x, y;
+
+    for (y = 0; y < height; y++)
+    {
+        BYTE *pixel = bits + stride * y;
+
+        for (x = 0; x < width; x++, pixel += 4)
+        {
+            BYTE alpha = pixel[3];
+            if (alpha != 255)
+            {
+                pixel[0] = pixel[0] * alpha / 255;
+                pixel[1] = pixel[1] * alpha / 255;
+                pixel[2] = pixel[2] * alpha / 255;
+            }
+        }
+    }
+}
+
 static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter *iface)
 {
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
@@ -621,7 +684,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             const BYTE *srcrow;
             const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
+            DWORD *dstpixel;
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -637,12 +700,10 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
                     srcpixel=srcrow;
-                    dstpixel=dstrow;
+                    dstpixel=(DWORD*)dstrow;
                     for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
+                        dstpixel[x] = 0xff000000|(srcpixel[2]<<16)|(srcpixel[1]<<8)|srcpixel[0];
+                        srcpixel += 3;
                     }
                     srcrow += srcstride;
                     dstrow += cbStride;
@@ -664,8 +725,7 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             const BYTE *srcrow;
             const BYTE *srcpixel;
             BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
+            DWORD *dstpixel;
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -681,16 +741,10 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
                 dstrow = pbBuffer;
                 for (y=0; y<prc->Height; y++) {
                     srcpixel=srcrow;
-                    dstpixel=dstrow;
+                    dstpixel=(DWORD*)dstrow;
                     for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* red */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* blue */
-
-                        *dstpixel++=tmppixel[2]; /* blue */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* red */
-                        *dstpixel++=255; /* alpha */
+                        dstpixel[x] = 0xff000000|(srcpixel[0]<<16)|(srcpixel[1]<<8)|srcpixel[2];
+                        srcpixel += 3;
                     }
                     srcrow += srcstride;
                     dstrow += cbStride;
@@ -713,8 +767,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
 
             /* set all alpha values to 255 */
             for (y=0; y<prc->Height; y++)
+            {
+                DWORD *dstpixel = (DWORD*)(pbBuffer + cbStride * y);
                 for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+                    dstpixel[x] |= 0xff000000;
+            }
         }
         return S_OK;
     case format_32bppBGRA:
@@ -725,22 +782,11 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+            unpremultiply_32bpp(pbBuffer, prc->Width, prc->Height, cbStride);
         }
         return S_OK;
     case format_48bppRGB:
@@ -888,21 +934,7 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            premultiply_32bpp(pbBuffer, prc->Width, prc->Height, cbStride);
         return hr;
     }
 }
@@ -156,6 +156,7 @@ typedef struct {
     struct jpeg_source_mgr source_mgr;
     BYTE source_buffer[1024];
     BYTE *image_data;
+    UINT allocated_rows;
     CRITICAL_SECTION lock;
 } JpegDecoder;
 
@@ -599,7 +600,6 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
     UINT bpp;
     UINT stride;
-    UINT data_size;
     UINT max_row_needed;
     jmp_buf jmpbuf;
     WICRect rect;
@@ -624,22 +624,31 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     else if (This->cinfo.out_color_space == JCS_CMYK) bpp = 32;
     else bpp = 24;
 
-    stride = bpp * This->cinfo.output_width;
-    data_size = stride * This->cinfo.output_height;
+    stride = (bpp * This->cinfo.output_width + 7) / 8;
 
     max_row_needed = prc->Y + prc->Height;
     if (max_row_needed > This->cinfo.output_height) return E_INVALIDARG;
 
     EnterCriticalSection(&This->lock);
 
-    if (!This->image_data)
+    /* Scanlines are decoded in order, so only keep room for the ones
+     * decoded so far and grow the buffer as more are needed. */
+    if (max_row_needed > This->allocated_rows)
     {
-        This->image_data = HeapAlloc(GetProcessHeap(), 0, data_size);
-        if (!This->image_data)
+        UINT rows = max(max_row_needed, min(This->allocated_rows * 2, This->cinfo.output_height));
+        BYTE *data;
+
+        if (This->image_data)
+            data = HeapReAlloc(GetProcessHeap(), 0, This->image_data, stride * rows);
+        else
+            data = HeapAlloc(GetProcessHeap(), 0, stride * rows);
+        if (!data)
         {
             LeaveCriticalSection(&This->lock);
             return E_OUTOFMEMORY;
         }
+        This->image_data = data;
+        This->allocated_rows = rows;
     }
 
     This->cinfo.client_data = jmpbuf;
@@ -832,6 +841,7 @@ HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
     This->cinfo_initialized = FALSE;
     This->stream = NULL;
     This->image_data = NULL;
+    This->allocated_rows = 0;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": JpegDecoder.lock");
 
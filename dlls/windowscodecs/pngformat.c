@@ -313,6 +313,7 @@ MAKE_FUNCPTR(png_get_error_ptr);
 MAKE_FUNCPTR(png_get_iCCP);
 MAKE_FUNCPTR(png_get_image_height);
 MAKE_FUNCPTR(png_get_image_width);
+MAKE_FUNCPTR(png_get_interlace_type);
 MAKE_FUNCPTR(png_get_io_ptr);
 MAKE_FUNCPTR(png_get_pHYs);
 MAKE_FUNCPTR(png_get_PLTE);
@@ -332,9 +333,9 @@ MAKE_FUNCPTR(png_set_strip_16);
 MAKE_FUNCPTR(png_set_tRNS);
 MAKE_FUNCPTR(png_set_tRNS_to_alpha);
 MAKE_FUNCPTR(png_set_write_fn);
-MAKE_FUNCPTR(png_read_end);
 MAKE_FUNCPTR(png_read_image);
 MAKE_FUNCPTR(png_read_info);
+MAKE_FUNCPTR(png_read_row);
 MAKE_FUNCPTR(png_write_end);
 MAKE_FUNCPTR(png_write_info);
 MAKE_FUNCPTR(png_write_rows);
@@ -379,6 +380,7 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_get_iCCP);
         LOAD_FUNCPTR(png_get_image_height);
         LOAD_FUNCPTR(png_get_image_width);
+        LOAD_FUNCPTR(png_get_interlace_type);
         LOAD_FUNCPTR(png_get_io_ptr);
         LOAD_FUNCPTR(png_get_pHYs);
         LOAD_FUNCPTR(png_get_PLTE);
@@ -398,9 +400,9 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_set_tRNS);
         LOAD_FUNCPTR(png_set_tRNS_to_alpha);
         LOAD_FUNCPTR(png_set_write_fn);
-        LOAD_FUNCPTR(png_read_end);
         LOAD_FUNCPTR(png_read_image);
         LOAD_FUNCPTR(png_read_info);
+        LOAD_FUNCPTR(png_read_row);
         LOAD_FUNCPTR(png_write_end);
         LOAD_FUNCPTR(png_write_info);
         LOAD_FUNCPTR(png_write_rows);
@@ -452,6 +454,9 @@ typedef struct {
     UINT stride;
     const WICPixelFormatGUID *format;
     BYTE *image_bits;
+    UINT decoded_rows, allocated_rows;
+    BOOL interlaced;
+    ULARGE_INTEGER data_pos; /* stream position of the next image data to decode */
     CRITICAL_SECTION lock; /* must be held when png structures are accessed or initialized is set */
     ULONG metadata_count;
     metadata_block_info* metadata_blocks;
@@ -572,9 +577,6 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
     PngDecoder *This = impl_from_IWICBitmapDecoder(iface);
     LARGE_INTEGER seek;
     HRESULT hr=S_OK;
-    png_bytep *row_pointers=NULL;
-    UINT image_size;
-    UINT i;
     int color_type, bit_depth;
     png_bytep trans;
     int num_trans;
@@ -620,7 +622,6 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
     if (setjmp(jmpbuf))
     {
         ppng_destroy_read_struct(&This->png_ptr, &This->info_ptr, &This->end_info);
-        HeapFree(GetProcessHeap(), 0, row_pointers);
         This->png_ptr = NULL;
         hr = E_FAIL;
         goto end;
@@ -731,35 +732,15 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         goto end;
     }
 
-    /* read the image data */
     This->width = ppng_get_image_width(This->png_ptr, This->info_ptr);
     This->height = ppng_get_image_height(This->png_ptr, This->info_ptr);
     This->stride = (This->width * This->bpp + 7) / 8;
-    image_size = This->stride * This->height;
-
-    This->image_bits = HeapAlloc(GetProcessHeap(), 0, image_size);
-    if (!This->image_bits)
-    {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
-
-    row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep)*This->height);
-    if (!row_pointers)
-    {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
-
-    for (i=0; i<This->height; i++)
-        row_pointers[i] = This->image_bits + i * This->stride;
+    This->interlaced = ppng_get_interlace_type(This->png_ptr, This->info_ptr) != PNG_INTERLACE_NONE;
 
-    ppng_read_image(This->png_ptr, row_pointers);
-
-    HeapFree(GetProcessHeap(), 0, row_pointers);
-    row_pointers = NULL;
-
-    ppng_read_end(This->png_ptr, This->end_info);
+    /* The image data is decoded on demand by CopyPixels. */
+    seek.QuadPart = 0;
+    hr = IStream_Seek(pIStream, seek, STREAM_SEEK_CUR, &This->data_pos);
+    if (FAILED(hr)) goto end;
 
     /* Find the metadata chunks in the file. */
     seek.QuadPart = 8;
@@ -1101,15 +1082,95 @@ end:
     return hr;
 }
 
+/* Decode the image up to the given row. Rows are decoded sequentially, and
+ * the buffer only grows to hold the rows decoded so far. Interlaced images
+ * are decoded at once. Must be called with the lock held. */
+static HRESULT PngDecoder_DecodeRows(PngDecoder *This, UINT rows)
+{
+    png_bytep *row_pointers = NULL;
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    HRESULT hr;
+    BYTE *bits;
+    UINT i;
+
+    if (rows <= This->decoded_rows) return S_OK;
+    if (This->interlaced) rows = This->height;
+
+    if (rows > This->allocated_rows)
+    {
+        UINT count = max(rows, min(This->allocated_rows * 2, This->height));
+
+        if (This->image_bits)
+            bits = HeapReAlloc(GetProcessHeap(), 0, This->image_bits, count * This->stride);
+        else
+            bits = HeapAlloc(GetProcessHeap(), 0, count * This->stride);
+        if (!bits) return E_OUTOFMEMORY;
+        This->image_bits = bits;
+        This->allocated_rows = count;
+    }
+
+    if (This->interlaced)
+    {
+        row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep)*This->height);
+        if (!row_pointers) return E_OUTOFMEMORY;
+        for (i=0; i<This->height; i++)
+            row_pointers[i] = This->image_bits + i * This->stride;
+    }
+
+    seek.QuadPart = This->data_pos.QuadPart;
+    hr = IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+    if (FAILED(hr))
+    {
+        HeapFree(GetProcessHeap(), 0, row_pointers);
+        return hr;
+    }
+
+    if (setjmp(jmpbuf))
+    {
+        HeapFree(GetProcessHeap(), 0, row_pointers);
+        return E_FAIL;
+    }
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+
+    if (This->interlaced)
+        ppng_read_image(This->png_ptr, row_pointers);
+    else
+    {
+        for (i=This->decoded_rows; i<rows; i++)
+            ppng_read_row(This->png_ptr, This->image_bits + i * This->stride, NULL);
+    }
+    This->decoded_rows = rows;
+
+    HeapFree(GetProcessHeap(), 0, row_pointers);
+
+    seek.QuadPart = 0;
+    return IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->data_pos);
+}
+
 static HRESULT WINAPI PngDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     PngDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    UINT rows = This->height;
+    HRESULT hr;
+
     TRACE("(%p,%p,%u,%u,%p)\n", iface, prc, cbStride, cbBufferSize, pbBuffer);
 
-    return copy_pixels(This->bpp, This->image_bits,
-        This->width, This->height, This->stride,
-        prc, cbStride, cbBufferSize, pbBuffer);
+    if (prc && prc->Y >= 0 && prc->Height >= 0 && prc->Y + prc->Height <= This->height)
+        rows = prc->Y + prc->Height;
+
+    EnterCriticalSection(&This->lock);
+
+    hr = PngDecoder_DecodeRows(This, rows);
+    if (SUCCEEDED(hr))
+        hr = copy_pixels(This->bpp, This->image_bits,
+            This->width, This->height, This->stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
+
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
 }
 
 static HRESULT WINAPI PngDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -1323,6 +1384,7 @@ HRESULT PngDecoder_CreateInstance(REFIID iid, void** ppv)
     This->stream = NULL;
     This->initialized = FALSE;
     This->image_bits = NULL;
+    This->decoded_rows = This->allocated_rows = 0;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": PngDecoder.lock");
     This->metadata_count = 0;
@@ -190,6 +190,125 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+/* Bilinear filtering, used for formats with 8-bit channels. Source positions
+ * are in 16.16 fixed point, with pixel centers at half coordinates. */
+static inline UINT64 Linear_GetSourcePos(UINT dst, UINT dst_size, UINT src_size)
+{
+    INT64 pos = ((UINT64)(2 * dst + 1) * src_size << 16) / (2 * dst_size) - 0x8000;
+
+    if (pos < 0) return 0;
+    if (pos >= (INT64)(src_size - 1) << 16) return (UINT64)(src_size - 1) << 16;
+    return pos;
+}
+
+static void Linear_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    src_rect->X = Linear_GetSourcePos(x, This->width, This->src_width) >> 16;
+    src_rect->Y = Linear_GetSourcePos(y, This->height, This->src_height) >> 16;
+    src_rect->Width = src_rect->X + 1 < This->src_width ? 2 : 1;
+    src_rect->Height = src_rect->Y + 1 < This->src_height ? 2 : 1;
+}
+
+static void Linear_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    UINT bytesperpixel = This->bpp/8;
+    UINT64 pos;
+    UINT i, c, x0, x1, wx, wy;
+    const BYTE *row0, *row1;
+
+    pos = Linear_GetSourcePos(dst_y, This->height, This->src_height);
+    row0 = src_data[(pos >> 16) - src_data_y];
+    row1 = (pos >> 16) + 1 < This->src_height ? src_data[(pos >> 16) + 1 - src_data_y] : row0;
+    wy = (pos >> 8) & 0xff;
+
+    for (i=0; i<dst_width; i++)
+    {
+        pos = Linear_GetSourcePos(dst_x + i, This->width, This->src_width);
+        x0 = ((pos >> 16) - src_data_x) * bytesperpixel;
+        x1 = (pos >> 16) + 1 < This->src_width ? x0 + bytesperpixel : x0;
+        wx = (pos >> 8) & 0xff;
+
+        for (c=0; c<bytesperpixel; c++)
+        {
+            UINT top = row0[x0 + c] * (256 - wx) + row0[x1 + c] * wx;
+            UINT bottom = row1[x0 + c] * (256 - wx) + row1[x1 + c] * wx;
+            *pbBuffer++ = (top * (256 - wy) + bottom * wy + 0x8000) >> 16;
+        }
+    }
+}
+
+/* Box filtering, used when shrinking formats with 8-bit channels. Each
+ * destination pixel is the average of the source pixels it covers. */
+static inline void Box_GetSourceRange(UINT dst, UINT dst_size, UINT src_size, UINT *start, UINT *end)
+{
+    *start = (UINT64)dst * src_size / dst_size;
+    *end = ((UINT64)(dst + 1) * src_size + dst_size - 1) / dst_size;
+}
+
+static void Box_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    UINT start, end;
+
+    Box_GetSourceRange(x, This->width, This->src_width, &start, &end);
+    src_rect->X = start;
+    src_rect->Width = end - start;
+    Box_GetSourceRange(y, This->height, This->src_height, &start, &end);
+    src_rect->Y = start;
+    src_rect->Height = end - start;
+}
+
+static void Box_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    UINT bytesperpixel = This->bpp/8;
+    UINT i, c, x, y, x0, x1, y0, y1, count;
+    UINT sum[4];
+
+    Box_GetSourceRange(dst_y, This->height, This->src_height, &y0, &y1);
+
+    for (i=0; i<dst_width; i++)
+    {
+        Box_GetSourceRange(dst_x + i, This->width, This->src_width, &x0, &x1);
+        count = (x1 - x0) * (y1 - y0);
+
+        for (c=0; c<bytesperpixel; c++) sum[c] = 0;
+        for (y=y0; y<y1; y++)
+        {
+            const BYTE *src = src_data[y - src_data_y] + (x0 - src_data_x) * bytesperpixel;
+            for (x=x0; x<x1; x++)
+                for (c=0; c<bytesperpixel; c++)
+                    sum[c] += *src++;
+        }
+        for (c=0; c<bytesperpixel; c++)
+            *pbBuffer++ = (sum[c] + count / 2) / count;
+    }
+}
+
+static BOOL is_8bit_channel_format(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    UINT i;
+
+    for (i=0; i<sizeof(formats)/sizeof(formats[0]); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -331,7 +450,26 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
         hr = get_pixelformat_bpp(&src_pixelformat, &This->bpp);
     }
 
-    if (SUCCEEDED(hr))
+    if (SUCCEEDED(hr) && mode != WICBitmapInterpolationModeNearestNeighbor
+            && is_8bit_channel_format(&src_pixelformat) && This->src_width && This->src_height)
+    {
+        IWICBitmapSource_AddRef(pISource);
+        This->source = pISource;
+        if (mode == WICBitmapInterpolationModeFant
+                && This->width <= This->src_width && This->height <= This->src_height)
+        {
+            This->fn_get_required_source_rect = Box_GetRequiredSourceRect;
+            This->fn_copy_scanline = Box_CopyScanline;
+        }
+        else
+        {
+            if (mode != WICBitmapInterpolationModeLinear && mode != WICBitmapInterpolationModeFant)
+                FIXME("unsupported mode %i, using bilinear filtering\n", mode);
+            This->fn_get_required_source_rect = Linear_GetRequiredSourceRect;
+            This->fn_copy_scanline = Linear_CopyScanline;
+        }
+    }
+    else if (SUCCEEDED(hr))
     {
         switch (mode)
         {
@@ -28,6 +28,7 @@
 #include "winbase.h"
 #include "winnls.h"
 #include "winreg.h"
+#include "wine/audiostats.h"
 #include "wine/debug.h"
 #include "wine/unicode.h"
 #include "wine/list.h"
@@ -50,6 +51,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(alsa);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
+WINE_DECLARE_DEBUG_CHANNEL(audiostats);
 
 #define NULL_PTR_ERR MAKE_HRESULT(SEVERITY_ERROR, FACILITY_WIN32, RPC_X_NULL_REF_POINTER)
 
@@ -103,6 +105,7 @@ struct ACImpl {
     snd_pcm_format_t alsa_format;
 
     LARGE_INTEGER last_period_time;
+    struct audio_stream_stats *stats;
 
     IMMDevice *parent;
     IUnknown *pUnkFTMarshal;
@@ -115,6 +118,7 @@ struct ACImpl {
     float *vols;
 
     BOOL need_remapping;
+    BOOL use_mmap; /* write straight into the ALSA ring buffer */
     int alsa_channels;
     int alsa_channel_map[32];
 
@@ -265,6 +269,30 @@ int WINAPI AUDDRV_GetPriority(void)
     return Priority_Neutral;
 }
 
+static BOOL use_mmap_access(void)
+{
+    static const WCHAR UseMMapW[] = {'U','s','e','M','M','a','p',0};
+    static int use_mmap = -1;
+    WCHAR buffer[8];
+    DWORD size = sizeof(buffer), type;
+    HKEY key;
+
+    if(use_mmap != -1)
+        return use_mmap;
+
+    use_mmap = 0;
+    /* @@ Wine registry key: HKCU\Software\Wine\Drivers\winealsa.drv */
+    if(RegOpenKeyW(HKEY_CURRENT_USER, drv_keyW, &key) == ERROR_SUCCESS){
+        if(RegQueryValueExW(key, UseMMapW, 0, &type, (BYTE*)buffer, &size) == ERROR_SUCCESS &&
+                type == REG_SZ)
+            use_mmap = (buffer[0] == 'y' || buffer[0] == 'Y' || buffer[0] == 't' ||
+                    buffer[0] == 'T' || buffer[0] == '1');
+        RegCloseKey(key);
+    }
+    TRACE("mmap access %s\n", use_mmap ? "enabled" : "disabled");
+    return use_mmap;
+}
+
 static void set_device_guid(EDataFlow flow, HKEY drv_key, const WCHAR *key_name,
         GUID *guid)
 {
@@ -889,6 +917,23 @@ static ULONG WINAPI AudioClient_AddRef(IAudioClient *iface)
     return ref;
 }
 
+static void dump_stream_stats(ACImpl *This)
+{
+    const struct audio_stream_stats *s = This->stats;
+
+    if(!s || !TRACE_ON(audiostats))
+        return;
+
+    TRACE_(audiostats)("%p %s: %d periods, %d underruns, %d overruns, "
+            "latency %s/%s max (100ns)\n", This,
+            This->dataflow == eRender ? "render" : "capture",
+            s->periods, s->underruns, s->overruns,
+            wine_dbgstr_longlong(s->latency), wine_dbgstr_longlong(s->max_latency));
+    TRACE_(audiostats)("%p jitter: %d %d %d %d %d %d %d %d\n", This,
+            s->jitter[0], s->jitter[1], s->jitter[2], s->jitter[3],
+            s->jitter[4], s->jitter[5], s->jitter[6], s->jitter[7]);
+}
+
 static ULONG WINAPI AudioClient_Release(IAudioClient *iface)
 {
     ACImpl *This = impl_from_IAudioClient(iface);
@@ -909,6 +954,8 @@ static ULONG WINAPI AudioClient_Release(IAudioClient *iface)
         }
 
         IAudioClient_Stop(iface);
+        dump_stream_stats(This);
+        audio_stats_free_stream(This->stats);
         IMMDevice_Release(This->parent);
         IUnknown_Release(This->pUnkFTMarshal);
         This->lock.DebugInfo->Spare[0] = 0;
@@ -1315,8 +1362,12 @@ static HRESULT WINAPI AudioClient_Initialize(IAudioClient *iface,
         goto exit;
     }
 
+    This->use_mmap = This->dataflow == eRender && use_mmap_access() &&
+        !snd_pcm_hw_params_test_access(This->pcm_handle, This->hw_params,
+                SND_PCM_ACCESS_MMAP_INTERLEAVED);
+
     if((err = snd_pcm_hw_params_set_access(This->pcm_handle, This->hw_params,
-                SND_PCM_ACCESS_RW_INTERLEAVED)) < 0){
+                This->use_mmap ? SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED)) < 0){
         WARN("Unable to set access: %d (%s)\n", err, snd_strerror(err));
         hr = AUDCLNT_E_ENDPOINT_CREATE_FAILED;
         goto exit;
@@ -1505,6 +1556,8 @@ static HRESULT WINAPI AudioClient_Initialize(IAudioClient *iface,
     LeaveCriticalSection(&g_sessions_lock);
 
     This->initted = TRUE;
+    This->stats = audio_stats_alloc_stream("alsa", This->dataflow,
+            fmt->nSamplesPerSec, This->mmdev_period_rt);
 
     TRACE("ALSA period: %lu frames\n", This->alsa_period_frames);
     TRACE("ALSA buffer: %lu frames\n", This->alsa_bufsize_frames);
@@ -1895,32 +1948,19 @@ static HRESULT WINAPI AudioClient_GetDevicePeriod(IAudioClient *iface,
     return S_OK;
 }
 
-static BYTE *remap_channels(ACImpl *This, BYTE *buf, snd_pcm_uframes_t frames)
+/* copy the frames to the ALSA channel layout in dst */
+static void copy_remapped_channels(ACImpl *This, BYTE *dst, BYTE *buf, snd_pcm_uframes_t frames)
 {
     snd_pcm_uframes_t i;
     UINT c;
     UINT bytes_per_sample = This->fmt->wBitsPerSample / 8;
 
-    if(!This->need_remapping)
-        return buf;
-
-    if(!This->remapping_buf){
-        This->remapping_buf = HeapAlloc(GetProcessHeap(), 0,
-                bytes_per_sample * This->alsa_channels * frames);
-        This->remapping_buf_frames = frames;
-    }else if(This->remapping_buf_frames < frames){
-        This->remapping_buf = HeapReAlloc(GetProcessHeap(), 0, This->remapping_buf,
-                bytes_per_sample * This->alsa_channels * frames);
-        This->remapping_buf_frames = frames;
-    }
-
-    snd_pcm_format_set_silence(This->alsa_format, This->remapping_buf,
-            frames * This->alsa_channels);
+    snd_pcm_format_set_silence(This->alsa_format, dst, frames * This->alsa_channels);
 
     switch(This->fmt->wBitsPerSample){
     case 8: {
             UINT8 *tgt_buf, *src_buf;
-            tgt_buf = This->remapping_buf;
+            tgt_buf = dst;
             src_buf = buf;
             for(i = 0; i < frames; ++i){
                 for(c = 0; c < This->fmt->nChannels; ++c)
@@ -1932,7 +1972,7 @@ static BYTE *remap_channels(ACImpl *This, BYTE *buf, snd_pcm_uframes_t frames)
         }
     case 16: {
             UINT16 *tgt_buf, *src_buf;
-            tgt_buf = (UINT16*)This->remapping_buf;
+            tgt_buf = (UINT16*)dst;
             src_buf = (UINT16*)buf;
             for(i = 0; i < frames; ++i){
                 for(c = 0; c < This->fmt->nChannels; ++c)
@@ -1944,7 +1984,7 @@ static BYTE *remap_channels(ACImpl *This, BYTE *buf, snd_pcm_uframes_t frames)
         break;
     case 32: {
             UINT32 *tgt_buf, *src_buf;
-            tgt_buf = (UINT32*)This->remapping_buf;
+            tgt_buf = (UINT32*)dst;
             src_buf = (UINT32*)buf;
             for(i = 0; i < frames; ++i){
                 for(c = 0; c < This->fmt->nChannels; ++c)
@@ -1956,7 +1996,7 @@ static BYTE *remap_channels(ACImpl *This, BYTE *buf, snd_pcm_uframes_t frames)
         break;
     default: {
             BYTE *tgt_buf, *src_buf;
-            tgt_buf = This->remapping_buf;
+            tgt_buf = dst;
             src_buf = buf;
             for(i = 0; i < frames; ++i){
                 for(c = 0; c < This->fmt->nChannels; ++c)
@@ -1968,15 +2008,100 @@ static BYTE *remap_channels(ACImpl *This, BYTE *buf, snd_pcm_uframes_t frames)
         }
         break;
     }
+}
+
+static BYTE *remap_channels(ACImpl *This, BYTE *buf, snd_pcm_uframes_t frames)
+{
+    UINT bytes_per_sample = This->fmt->wBitsPerSample / 8;
 
+    if(!This->need_remapping)
+        return buf;
+
+    if(!This->remapping_buf){
+        This->remapping_buf = HeapAlloc(GetProcessHeap(), 0,
+                bytes_per_sample * This->alsa_channels * frames);
+        This->remapping_buf_frames = frames;
+    }else if(This->remapping_buf_frames < frames){
+        This->remapping_buf = HeapReAlloc(GetProcessHeap(), 0, This->remapping_buf,
+                bytes_per_sample * This->alsa_channels * frames);
+        This->remapping_buf_frames = frames;
+    }
+
+    copy_remapped_channels(This, This->remapping_buf, buf, frames);
     return This->remapping_buf;
 }
 
+/* Write directly into the mmapped ALSA ring buffer, remapping the channels
+ * or writing silence on the way, instead of going through a temporary
+ * buffer and snd_pcm_writei. */
+static snd_pcm_sframes_t alsa_write_mmap(ACImpl *This, BYTE *buf,
+        snd_pcm_uframes_t frames, BOOL mute)
+{
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset, count, done = 0;
+    snd_pcm_sframes_t avail, committed;
+    int err;
+
+    avail = snd_pcm_avail_update(This->pcm_handle);
+    if(avail < 0){
+        WARN("avail_update failed, recovering: %ld (%s)\n", avail,
+                snd_strerror(avail));
+
+        if((err = snd_pcm_recover(This->pcm_handle, avail, 0)) < 0){
+            WARN("Could not recover: %d (%s)\n", err, snd_strerror(err));
+            return err;
+        }
+        if((avail = snd_pcm_avail_update(This->pcm_handle)) < 0)
+            return avail;
+    }
+    if(frames > avail)
+        frames = avail;
+
+    while(done < frames){
+        BYTE *dst;
+
+        count = frames - done;
+        if((err = snd_pcm_mmap_begin(This->pcm_handle, &areas, &offset, &count)) < 0){
+            WARN("mmap_begin failed: %d (%s)\n", err, snd_strerror(err));
+            break;
+        }
+        if(!count)
+            break;
+
+        dst = (BYTE*)areas[0].addr + (areas[0].first + offset * areas[0].step) / 8;
+        if(mute)
+            snd_pcm_areas_silence(areas, offset, This->alsa_channels, count, This->alsa_format);
+        else if(This->need_remapping)
+            copy_remapped_channels(This, dst, buf + done * This->fmt->nBlockAlign, count);
+        else
+            memcpy(dst, buf + done * This->fmt->nBlockAlign, count * This->fmt->nBlockAlign);
+
+        committed = snd_pcm_mmap_commit(This->pcm_handle, offset, count);
+        if(committed < 0){
+            WARN("mmap_commit failed: %ld (%s)\n", committed, snd_strerror(committed));
+            break;
+        }
+        done += committed;
+        if(committed != count)
+            break;
+    }
+
+    /* unlike writei, committing doesn't start the stream */
+    if(done && snd_pcm_state(This->pcm_handle) == SND_PCM_STATE_PREPARED &&
+            (err = snd_pcm_start(This->pcm_handle)) < 0)
+        WARN("Start failed: %d (%s)\n", err, snd_strerror(err));
+
+    return done;
+}
+
 static snd_pcm_sframes_t alsa_write_best_effort(ACImpl *This, BYTE *buf,
         snd_pcm_uframes_t frames, BOOL mute)
 {
     snd_pcm_sframes_t written;
 
+    if(This->use_mmap)
+        return alsa_write_mmap(This, buf, frames, mute);
+
     if(mute){
         int err;
         if((err = snd_pcm_format_set_silence(This->alsa_format, buf,
@@ -2087,6 +2212,9 @@ static void alsa_write_data(ACImpl *This)
     if(snd_pcm_state(This->pcm_handle) == SND_PCM_STATE_XRUN){
         TRACE("XRun state, recovering\n");
 
+        if(This->stats)
+            This->stats->underruns++;
+
         avail = This->alsa_bufsize_frames;
 
         if((err = snd_pcm_recover(This->pcm_handle, -EPIPE, 1)) < 0)
@@ -2137,6 +2265,9 @@ static void alsa_write_data(ACImpl *This)
         max_copy_frames -= written;
     }
 
+    audio_stats_latency(This->stats,
+            (LONGLONG)This->held_frames * 10000000 / This->fmt->nSamplesPerSec);
+
     if(This->event)
         SetEvent(This->event);
 }
@@ -2164,6 +2295,9 @@ static void alsa_read_data(ACImpl *This)
 
         WARN("read failed, recovering: %ld (%s)\n", nread, snd_strerror(nread));
 
+        if(nread == -EPIPE && This->stats)
+            This->stats->overruns++;
+
         ret = snd_pcm_recover(This->pcm_handle, nread, 0);
         if(ret < 0){
             WARN("Recover failed: %d (%s)\n", ret, snd_strerror(ret));
@@ -2203,6 +2337,7 @@ static void CALLBACK alsa_push_buffer_data(void *user, BOOLEAN timer)
     EnterCriticalSection(&This->lock);
 
     QueryPerformanceCounter(&This->last_period_time);
+    audio_stats_period(This->stats);
 
     if(This->dataflow == eRender)
         alsa_write_data(This);
@@ -2305,6 +2440,9 @@ static HRESULT WINAPI AudioClient_Start(IAudioClient *iface)
         }
     }
 
+    if(This->stats)
+        This->stats->last_period = 0;
+
     if(!This->timer){
         if(!CreateTimerQueueTimer(&This->timer, g_timer_q, alsa_push_buffer_data,
                 This, 0, This->mmdev_period_rt / 10000, WT_EXECUTEINTIMERTHREAD)){
@@ -65,6 +65,16 @@ struct pnp_device
     DEVICE_OBJECT *device;
 };
 
+/* number of input reports kept for IOCTL_HID_READ_REPORT when they arrive in bursts */
+#define REPORT_QUEUE_SIZE 32
+
+struct queued_report
+{
+    BYTE *data;
+    DWORD size;
+    DWORD alloc;
+};
+
 struct device_extension
 {
     struct pnp_device *pnp_device;
@@ -79,8 +89,10 @@ struct device_extension
 
     BYTE *last_report;
     DWORD last_report_size;
-    BOOL last_report_read;
     DWORD buffer_size;
+    struct queued_report report_queue[REPORT_QUEUE_SIZE];
+    UINT report_queue_head;
+    UINT report_queue_count;
     LIST_ENTRY irp_queue;
     CRITICAL_SECTION report_cs;
 
@@ -241,8 +253,10 @@ DEVICE_OBJECT *bus_create_hid_device(DRIVER_OBJECT *driver, const WCHAR *busidW,
     ext->vtbl               = vtbl;
     ext->last_report        = NULL;
     ext->last_report_size   = 0;
-    ext->last_report_read   = TRUE;
     ext->buffer_size        = 0;
+    memset(ext->report_queue, 0, sizeof(ext->report_queue));
+    ext->report_queue_head  = 0;
+    ext->report_queue_count = 0;
 
     memset(ext->platform_private, 0, platform_data_size);
 
@@ -331,6 +345,7 @@ void bus_remove_hid_device(DEVICE_OBJECT *device)
     struct pnp_device *pnp_device = ext->pnp_device;
     LIST_ENTRY *entry;
     IRP *irp;
+    UINT i;
 
     TRACE("(%p)\n", device);
 
@@ -354,6 +369,8 @@ void bus_remove_hid_device(DEVICE_OBJECT *device)
 
     HeapFree(GetProcessHeap(), 0, ext->serial);
     HeapFree(GetProcessHeap(), 0, ext->last_report);
+    for (i = 0; i < REPORT_QUEUE_SIZE; i++)
+        HeapFree(GetProcessHeap(), 0, ext->report_queue[i].data);
     IoDeleteDevice(device);
 
     /* pnp_device must be released after the device is gone */
@@ -438,6 +455,53 @@ static NTSTATUS deliver_last_report(struct device_extension *ext, DWORD buffer_l
     }
 }
 
+static NTSTATUS deliver_queued_report(struct device_extension *ext, DWORD buffer_length, BYTE *buffer, ULONG_PTR *out_length)
+{
+    struct queued_report *report = &ext->report_queue[ext->report_queue_head];
+
+    ext->report_queue_head = (ext->report_queue_head + 1) % REPORT_QUEUE_SIZE;
+    ext->report_queue_count--;
+
+    if (buffer_length < report->size)
+    {
+        *out_length = 0;
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+    memcpy(buffer, report->data, report->size);
+    *out_length = report->size;
+    return STATUS_SUCCESS;
+}
+
+static BOOL queue_report(struct device_extension *ext, const BYTE *data, DWORD length)
+{
+    struct queued_report *report;
+
+    if (ext->report_queue_count == REPORT_QUEUE_SIZE)
+    {
+        WARN_(hid_report)("Report queue full, dropping oldest report\n");
+        ext->report_queue_head = (ext->report_queue_head + 1) % REPORT_QUEUE_SIZE;
+        ext->report_queue_count--;
+    }
+
+    report = &ext->report_queue[(ext->report_queue_head + ext->report_queue_count) % REPORT_QUEUE_SIZE];
+    if (length > report->alloc)
+    {
+        BYTE *new_data = HeapAlloc(GetProcessHeap(), 0, length);
+        if (!new_data)
+        {
+            ERR_(hid_report)("Failed to alloc queued report\n");
+            return FALSE;
+        }
+        HeapFree(GetProcessHeap(), 0, report->data);
+        report->data = new_data;
+        report->alloc = length;
+    }
+    memcpy(report->data, data, length);
+    report->size = length;
+    ext->report_queue_count++;
+    return TRUE;
+}
+
 NTSTATUS WINAPI hid_internal_dispatch(DEVICE_OBJECT *device, IRP *irp)
 {
     NTSTATUS status = irp->IoStatus.u.Status;
@@ -555,12 +619,11 @@ NTSTATUS WINAPI hid_internal_dispatch(DEVICE_OBJECT *device, IRP *irp)
                 LeaveCriticalSection(&ext->report_cs);
                 break;
             }
-            if (!ext->last_report_read)
+            if (ext->report_queue_count)
             {
-                irp->IoStatus.u.Status = status = deliver_last_report(ext,
+                irp->IoStatus.u.Status = status = deliver_queued_report(ext,
                     irpsp->Parameters.DeviceIoControl.OutputBufferLength,
                     irp->UserBuffer, &irp->IoStatus.Information);
-                ext->last_report_read = TRUE;
             }
             else
             {
@@ -633,7 +696,6 @@ void process_hid_report(DEVICE_OBJECT *device, BYTE *report, DWORD length)
             ERR_(hid_report)("Failed to alloc last report\n");
             ext->buffer_size = 0;
             ext->last_report_size = 0;
-            ext->last_report_read = TRUE;
             LeaveCriticalSection(&ext->report_cs);
             return;
         }
@@ -641,14 +703,12 @@ void process_hid_report(DEVICE_OBJECT *device, BYTE *report, DWORD length)
             ext->buffer_size = length;
     }
 
-    if (!ext->last_report_read)
-        ERR_(hid_report)("Device reports coming in too fast, last report not read yet!\n");
-
     memcpy(ext->last_report, report, length);
     ext->last_report_size = length;
-    ext->last_report_read = FALSE;
 
-    while ((entry = RemoveHeadList(&ext->irp_queue)) != &ext->irp_queue)
+    /* hand the report straight to a waiting reader, or keep it until the
+     * next IOCTL_HID_READ_REPORT so that bursts are not lost */
+    if ((entry = RemoveHeadList(&ext->irp_queue)) != &ext->irp_queue)
     {
         IO_STACK_LOCATION *irpsp;
         TRACE_(hid_report)("Processing Request\n");
@@ -657,9 +717,10 @@ void process_hid_report(DEVICE_OBJECT *device, BYTE *report, DWORD length)
         irp->IoStatus.u.Status = deliver_last_report(ext,
             irpsp->Parameters.DeviceIoControl.OutputBufferLength,
             irp->UserBuffer, &irp->IoStatus.Information);
-        ext->last_report_read = TRUE;
         IoCompleteRequest(irp, IO_NO_INCREMENT);
     }
+    else
+        queue_report(ext, report, length);
     LeaveCriticalSection(&ext->report_cs);
 }
 
@@ -34,6 +34,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 #define WINED3D_BUFFER_PIN_SYSMEM   0x04    /* Keep a system memory copy for this buffer. */
 #define WINED3D_BUFFER_DISCARD      0x08    /* A DISCARD lock has occurred since the last preload. */
 #define WINED3D_BUFFER_APPLESYNC    0x10    /* Using sync as in GL_APPLE_flush_buffer_range. */
+#define WINED3D_BUFFER_PERSISTENT   0x20    /* Use a ring of persistently mapped BOs. */
 
 #define VB_MAXDECLCHANGES     100     /* After that number of decl changes we stop converting */
 #define VB_RESETDECLCHANGE    1000    /* Reset the decl changecount after that number of draws */
@@ -138,11 +139,36 @@ static void buffer_bind(struct wined3d_buffer *buffer, struct wined3d_context *c
     context_bind_bo(context, buffer->buffer_type_hint, buffer->buffer_object);
 }
 
+static void buffer_invalidate_bound_state(struct wined3d_buffer *buffer)
+{
+    struct wined3d_resource *resource = &buffer->resource;
+
+    if (!resource->bind_count)
+        return;
+
+    if (buffer->bind_flags & WINED3D_BIND_VERTEX_BUFFER)
+        device_invalidate_state(resource->device, STATE_STREAMSRC);
+    if (buffer->bind_flags & WINED3D_BIND_INDEX_BUFFER)
+        device_invalidate_state(resource->device, STATE_INDEXBUFFER);
+    if (buffer->bind_flags & WINED3D_BIND_CONSTANT_BUFFER)
+    {
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_VERTEX));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_HULL));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_DOMAIN));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_GEOMETRY));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_PIXEL));
+        device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_COMPUTE));
+    }
+    if (buffer->bind_flags & WINED3D_BIND_STREAM_OUTPUT)
+        device_invalidate_state(resource->device, STATE_STREAM_OUTPUT);
+}
+
 /* Context activation is done by the caller. */
 static void buffer_destroy_buffer_object(struct wined3d_buffer *buffer, struct wined3d_context *context)
 {
     const struct wined3d_gl_info *gl_info = context->gl_info;
     struct wined3d_resource *resource = &buffer->resource;
+    unsigned int i;
 
     if (!buffer->buffer_object)
         return;
@@ -152,33 +178,32 @@ static void buffer_destroy_buffer_object(struct wined3d_buffer *buffer, struct w
      * valid any longer. Dirtify the stream source to force a reload. This
      * happens only once per changed vertexbuffer and should occur rather
      * rarely. */
-    if (resource->bind_count)
+    buffer_invalidate_bound_state(buffer);
+    if (resource->bind_count && buffer->bind_flags & WINED3D_BIND_STREAM_OUTPUT
+            && context->transform_feedback_active)
     {
-        if (buffer->bind_flags & WINED3D_BIND_VERTEX_BUFFER)
-            device_invalidate_state(resource->device, STATE_STREAMSRC);
-        if (buffer->bind_flags & WINED3D_BIND_INDEX_BUFFER)
-            device_invalidate_state(resource->device, STATE_INDEXBUFFER);
-        if (buffer->bind_flags & WINED3D_BIND_CONSTANT_BUFFER)
-        {
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_VERTEX));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_HULL));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_DOMAIN));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_GEOMETRY));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_PIXEL));
-            device_invalidate_state(resource->device, STATE_CONSTANT_BUFFER(WINED3D_SHADER_TYPE_COMPUTE));
-        }
-        if (buffer->bind_flags & WINED3D_BIND_STREAM_OUTPUT)
+        /* We have to make sure that transform feedback is not active
+         * when deleting a potentially bound transform feedback buffer.
+         * This may happen when the device is being destroyed. */
+        WARN("Deleting buffer object for buffer %p, disabling transform feedback.\n", buffer);
+        context_end_transform_feedback(context);
+    }
+
+    if (buffer->ring)
+    {
+        for (i = 0; i < buffer->ring_count; ++i)
         {
-            device_invalidate_state(resource->device, STATE_STREAM_OUTPUT);
-            if (context->transform_feedback_active)
-            {
-                /* We have to make sure that transform feedback is not active
-                 * when deleting a potentially bound transform feedback buffer.
-                 * This may happen when the device is being destroyed. */
-                WARN("Deleting buffer object for buffer %p, disabling transform feedback.\n", buffer);
-                context_end_transform_feedback(context);
-            }
+            GL_EXTCALL(glDeleteBuffers(1, &buffer->ring[i].id));
+            wined3d_fence_destroy(buffer->ring[i].fence);
         }
+        checkGLcall("glDeleteBuffers");
+        heap_free(buffer->ring);
+        buffer->ring = NULL;
+        buffer->ring_count = 0;
+        buffer->ring_idx = 0;
+        buffer->buffer_object = 0;
+        buffer->fence = NULL;
+        return;
     }
 
     GL_EXTCALL(glDeleteBuffers(1, &buffer->buffer_object));
@@ -193,6 +218,143 @@ static void buffer_destroy_buffer_object(struct wined3d_buffer *buffer, struct w
     buffer->flags &= ~WINED3D_BUFFER_APPLESYNC;
 }
 
+/* Context activation is done by the caller. */
+static BOOL buffer_create_ring_bo(struct wined3d_buffer *buffer, struct wined3d_context *context,
+        struct wined3d_buffer_ring_bo *bo)
+{
+    static const GLbitfield map_flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT
+            | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    GLenum error;
+    HRESULT hr;
+
+    if (FAILED(hr = wined3d_fence_create(buffer->resource.device, &bo->fence)))
+    {
+        ERR("Failed to create fence, hr %#x.\n", hr);
+        return FALSE;
+    }
+
+    while (gl_info->gl_ops.gl.p_glGetError() != GL_NO_ERROR);
+
+    /* The buffer is never unmapped, so all map flags have to be requested
+     * upfront. GL_DYNAMIC_STORAGE_BIT keeps glBufferSubData() usable for
+     * buffer to buffer copies out of system memory. */
+    GL_EXTCALL(glGenBuffers(1, &bo->id));
+    context_bind_bo(context, buffer->buffer_type_hint, bo->id);
+    GL_EXTCALL(glBufferStorage(buffer->buffer_type_hint, buffer->resource.size,
+            NULL, map_flags | GL_DYNAMIC_STORAGE_BIT));
+    bo->ptr = GL_EXTCALL(glMapBufferRange(buffer->buffer_type_hint, 0, buffer->resource.size, map_flags));
+    error = gl_info->gl_ops.gl.p_glGetError();
+    if (!bo->ptr || error != GL_NO_ERROR || ((DWORD_PTR)bo->ptr & (RESOURCE_ALIGNMENT - 1)))
+    {
+        WARN("Failed to create a persistently mapped BO, error %s (%#x), pointer %p.\n",
+                debug_glerror(error), error, bo->ptr);
+        GL_EXTCALL(glDeleteBuffers(1, &bo->id));
+        wined3d_fence_destroy(bo->fence);
+        memset(bo, 0, sizeof(*bo));
+        return FALSE;
+    }
+
+    TRACE("Created persistently mapped BO %u at %p for buffer %p.\n", bo->id, bo->ptr, buffer);
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static BOOL buffer_create_ring(struct wined3d_buffer *buffer, struct wined3d_context *context)
+{
+    if (!(buffer->ring = heap_calloc(WINED3D_BUFFER_RING_SIZE, sizeof(*buffer->ring))))
+        return FALSE;
+
+    if (!buffer_create_ring_bo(buffer, context, &buffer->ring[0]))
+    {
+        heap_free(buffer->ring);
+        buffer->ring = NULL;
+        return FALSE;
+    }
+
+    buffer->ring_count = 1;
+    buffer->ring_idx = 0;
+    buffer->buffer_object = buffer->ring[0].id;
+    buffer->fence = buffer->ring[0].fence;
+    buffer->buffer_object_usage = GL_STREAM_DRAW_ARB;
+    buffer_invalidate_bo_range(buffer, 0, 0);
+
+    return TRUE;
+}
+
+static BOOL buffer_ring_bo_idle(const struct wined3d_buffer *buffer, unsigned int idx)
+{
+    switch (wined3d_fence_test(buffer->ring[idx].fence, buffer->resource.device, WINED3DGETDATA_FLUSH))
+    {
+        case WINED3D_FENCE_NOT_STARTED:
+        case WINED3D_FENCE_OK:
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+/* Context activation is done by the caller. */
+static void buffer_sync_ring_bo(struct wined3d_buffer *buffer, struct wined3d_context *context, unsigned int idx)
+{
+    enum wined3d_fence_result ret;
+
+    TRACE("Synchronizing BO %u of buffer %p.\n", buffer->ring[idx].id, buffer);
+
+    switch (ret = wined3d_fence_wait(buffer->ring[idx].fence, buffer->resource.device))
+    {
+        case WINED3D_FENCE_NOT_STARTED:
+        case WINED3D_FENCE_OK:
+            return;
+
+        default:
+            ERR("wined3d_fence_wait() returned %u, finishing.\n", ret);
+            context->gl_info->gl_ops.gl.p_glFinish();
+            return;
+    }
+}
+
+/* Context activation is done by the caller. DISCARD maps switch to a BO
+ * the GPU is done with, instead of waiting for the current one. */
+static void buffer_rename_ring_bo(struct wined3d_buffer *buffer, struct wined3d_context *context)
+{
+    unsigned int i, idx;
+
+    for (i = 1; i < buffer->ring_count; ++i)
+    {
+        idx = (buffer->ring_idx + i) % buffer->ring_count;
+        if (buffer_ring_bo_idle(buffer, idx))
+            break;
+    }
+
+    if (i == buffer->ring_count)
+    {
+        if (buffer->ring_count < WINED3D_BUFFER_RING_SIZE
+                && buffer_create_ring_bo(buffer, context, &buffer->ring[buffer->ring_count]))
+        {
+            idx = buffer->ring_count++;
+        }
+        else
+        {
+            /* Every BO is still in use, wait for the oldest one. */
+            idx = (buffer->ring_idx + 1) % buffer->ring_count;
+            buffer_sync_ring_bo(buffer, context, idx);
+        }
+    }
+
+    if (idx == buffer->ring_idx)
+        return;
+
+    TRACE("Renaming buffer %p from BO %u to BO %u.\n", buffer, buffer->buffer_object, buffer->ring[idx].id);
+
+    buffer->ring_idx = idx;
+    buffer->buffer_object = buffer->ring[idx].id;
+    buffer->fence = buffer->ring[idx].fence;
+    buffer_invalidate_bound_state(buffer);
+}
+
 /* Context activation is done by the caller. */
 static BOOL buffer_create_buffer_object(struct wined3d_buffer *buffer, struct wined3d_context *context)
 {
@@ -203,6 +365,15 @@ static BOOL buffer_create_buffer_object(struct wined3d_buffer *buffer, struct wi
     TRACE("Creating an OpenGL buffer object for wined3d_buffer %p with usage %s.\n",
             buffer, debug_d3dusage(buffer->resource.usage));
 
+    if (buffer->flags & WINED3D_BUFFER_PERSISTENT)
+    {
+        if (buffer_create_ring(buffer, context))
+            return TRUE;
+
+        WARN("Failed to create a persistently mapped BO ring, falling back to a regular BO.\n");
+        buffer->flags &= ~WINED3D_BUFFER_PERSISTENT;
+    }
+
     /* Make sure that the gl error is cleared. Do not use checkGLcall
      * here because checkGLcall just prints a fixme and continues. However,
      * if an error during VBO creation occurs we can fall back to non-VBO operation
@@ -538,6 +709,19 @@ static void wined3d_buffer_upload_ranges(struct wined3d_buffer *buffer, struct w
     const struct wined3d_gl_info *gl_info = context->gl_info;
     const struct wined3d_map_range *range;
 
+    /* Avoid stalling on BOs that are still in use, glBufferSubData() works
+     * on those too. */
+    if (buffer->ring && buffer_ring_bo_idle(buffer, buffer->ring_idx))
+    {
+        while (range_count--)
+        {
+            range = &ranges[range_count];
+            memcpy(buffer->ring[buffer->ring_idx].ptr + range->offset,
+                    (BYTE *)data + range->offset - data_offset, range->size);
+        }
+        return;
+    }
+
     buffer_bind(buffer, context);
 
     while (range_count--)
@@ -1056,7 +1240,22 @@ static HRESULT wined3d_buffer_map(struct wined3d_buffer *buffer, UINT offset, UI
             if ((flags & WINED3D_MAP_DISCARD) && buffer->resource.heap_memory)
                 wined3d_buffer_evict_sysmem(buffer);
 
-            if (count == 1)
+            if (count == 1 && buffer->ring)
+            {
+                /* The BOs stay mapped. DISCARD maps rename the buffer, and
+                 * only other maps without NOOVERWRITE need to synchronise. */
+                if (flags & WINED3D_MAP_DISCARD)
+                {
+                    if (!(buffer->flags & WINED3D_BUFFER_DISCARD))
+                        buffer_rename_ring_bo(buffer, context);
+                }
+                else if (!(flags & WINED3D_MAP_NOOVERWRITE))
+                {
+                    buffer_sync_ring_bo(buffer, context, buffer->ring_idx);
+                }
+                buffer->map_ptr = buffer->ring[buffer->ring_idx].ptr;
+            }
+            else if (count == 1)
             {
                 buffer_bind(buffer, context);
 
@@ -1152,6 +1351,14 @@ static void wined3d_buffer_unmap(struct wined3d_buffer *buffer)
         return;
     }
 
+    if (buffer->map_ptr && buffer->ring)
+    {
+        /* Coherent mappings don't need explicit flushes. */
+        buffer_clear_dirty_areas(buffer);
+        buffer->map_ptr = NULL;
+        return;
+    }
+
     if (buffer->map_ptr)
     {
         struct wined3d_device *device = buffer->resource.device;
@@ -1211,6 +1418,11 @@ void wined3d_buffer_copy(struct wined3d_buffer *dst_buffer, unsigned int dst_off
     context = context_acquire(dst_buffer->resource.device, NULL, 0);
     context_copy_bo_address(context, &dst, dst_buffer->buffer_type_hint,
             &src, src_buffer->buffer_type_hint, size);
+    /* Ring BOs are only reused once their fence has been signalled. */
+    if (dst_buffer->ring && dst.buffer_object)
+        wined3d_fence_issue(dst_buffer->fence, dst_buffer->resource.device);
+    if (src_buffer->ring && src.buffer_object)
+        wined3d_fence_issue(src_buffer->fence, src_buffer->resource.device);
     context_release(context);
 
     wined3d_buffer_invalidate_range(dst_buffer, ~dst_location, dst_offset, size);
@@ -1397,6 +1609,17 @@ static HRESULT buffer_init(struct wined3d_buffer *buffer, struct wined3d_device
         buffer->flags |= WINED3D_BUFFER_USE_BO;
     }
 
+    /* Draws only fence vertex and index buffers, which is what allows
+     * reusing the BOs of the ring. */
+    if ((buffer->flags & WINED3D_BUFFER_USE_BO) && !(buffer->flags & WINED3D_BUFFER_PIN_SYSMEM)
+            && (buffer->resource.usage & WINED3DUSAGE_DYNAMIC)
+            && gl_info->supported[ARB_BUFFER_STORAGE] && gl_info->supported[ARB_SYNC]
+            && !(bind_flags & ~(WINED3D_BIND_VERTEX_BUFFER | WINED3D_BIND_INDEX_BUFFER)))
+    {
+        TRACE("Using persistently mapped BOs.\n");
+        buffer->flags |= WINED3D_BUFFER_PERSISTENT;
+    }
+
     if (!(buffer->maps = heap_alloc(sizeof(*buffer->maps))))
     {
         ERR("Out of memory.\n");
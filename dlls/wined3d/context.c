@@ -507,7 +507,20 @@ static void context_generate_fbo_key(const struct wined3d_context *context,
     memset(&key->objects[buffers + 1], 0, (ARRAY_SIZE(key->objects) - buffers - 1) * sizeof(*key->objects));
 }
 
-static struct fbo_entry *context_create_fbo_entry(const struct wined3d_context *context,
+static struct list *context_get_fbo_bucket(struct wined3d_context *context,
+        const struct wined3d_fbo_entry_key *key)
+{
+    const DWORD *k = (const DWORD *)key;
+    unsigned int hash = 2166136261u, i;
+
+    for (i = 0; i < sizeof(*key) / sizeof(*k); ++i)
+        hash = (hash ^ k[i]) * 16777619u;
+    hash ^= hash >> 16;
+
+    return &context->fbo_hash[hash & (WINED3D_FBO_HASH_SIZE - 1)];
+}
+
+static struct fbo_entry *context_create_fbo_entry(struct wined3d_context *context,
         const struct wined3d_rendertarget_info *render_targets, const struct wined3d_rendertarget_info *depth_stencil,
         DWORD color_location, DWORD ds_location)
 {
@@ -516,6 +529,7 @@ static struct fbo_entry *context_create_fbo_entry(const struct wined3d_context *
 
     entry = heap_alloc(sizeof(*entry));
     context_generate_fbo_key(context, &entry->key, render_targets, depth_stencil, color_location, ds_location);
+    list_add_head(context_get_fbo_bucket(context, &entry->key), &entry->hash_entry);
     entry->flags = 0;
     if (depth_stencil->resource)
     {
@@ -542,7 +556,9 @@ static void context_reuse_fbo_entry(struct wined3d_context *context, GLenum targ
     context_bind_fbo(context, target, entry->id);
     context_clean_fbo_attachments(gl_info, target);
 
+    list_remove(&entry->hash_entry);
     context_generate_fbo_key(context, &entry->key, render_targets, depth_stencil, color_location, ds_location);
+    list_add_head(context_get_fbo_bucket(context, &entry->key), &entry->hash_entry);
     entry->flags = 0;
     if (depth_stencil->resource)
     {
@@ -563,6 +579,7 @@ static void context_destroy_fbo_entry(struct wined3d_context *context, struct fb
     }
     --context->fbo_entry_count;
     list_remove(&entry->entry);
+    list_remove(&entry->hash_entry);
     heap_free(entry);
 }
 
@@ -577,6 +594,7 @@ static struct fbo_entry *context_find_fbo_entry(struct wined3d_context *context,
     struct wined3d_fbo_entry_key fbo_key;
     unsigned int i, ds_level, rt_level;
     struct fbo_entry *entry;
+    struct list *bucket;
 
     if (depth_stencil->resource && depth_stencil->resource->type != WINED3D_RTYPE_BUFFER
             && render_targets[0].resource && render_targets[0].resource->type != WINED3D_RTYPE_BUFFER)
@@ -669,7 +687,8 @@ static struct fbo_entry *context_find_fbo_entry(struct wined3d_context *context,
         }
     }
 
-    LIST_FOR_EACH_ENTRY(entry, &context->fbo_list, struct fbo_entry, entry)
+    bucket = context_get_fbo_bucket(context, &fbo_key);
+    LIST_FOR_EACH_ENTRY(entry, bucket, struct fbo_entry, hash_entry)
     {
         if (memcmp(&fbo_key, &entry->key, sizeof(fbo_key)))
             continue;
@@ -1056,6 +1075,8 @@ static void context_enum_fbo_entries(const struct wined3d_device *device,
 static void context_queue_fbo_entry_destruction(struct wined3d_context *context, struct fbo_entry *entry)
 {
     list_remove(&entry->entry);
+    list_remove(&entry->hash_entry);
+    list_init(&entry->hash_entry);
     list_add_head(&context->fbo_destroy_list, &entry->entry);
 }
 
@@ -1640,16 +1661,7 @@ void context_invalidate_compute_state(struct wined3d_context *context, DWORD sta
 
 void context_invalidate_state(struct wined3d_context *context, DWORD state)
 {
-    DWORD rep = context->state_table[state].representative;
-    DWORD idx;
-    BYTE shift;
-
-    if (isStateDirty(context, rep)) return;
-
-    context->dirtyArray[context->numDirtyEntries++] = rep;
-    idx = rep / (sizeof(*context->isStateDirty) * CHAR_BIT);
-    shift = rep & ((sizeof(*context->isStateDirty) * CHAR_BIT) - 1);
-    context->isStateDirty[idx] |= (1u << shift);
+    context_set_state_dirty(context, context->state_table[state].representative);
 }
 
 /* This function takes care of wined3d pixel format selection. */
@@ -1917,6 +1929,8 @@ struct wined3d_context *context_create(struct wined3d_swapchain *swapchain,
     list_init(&ret->pipeline_statistics_queries);
 
     list_init(&ret->fbo_list);
+    for (i = 0; i < ARRAY_SIZE(ret->fbo_hash); ++i)
+        list_init(&ret->fbo_hash[i]);
     list_init(&ret->fbo_destroy_list);
 
     if (!device->shader_backend->shader_allocate_context_data(ret))
@@ -3914,11 +3928,43 @@ static void context_load_stream_output_buffers(struct wined3d_context *context,
     }
 }
 
+/* Dirty states are applied in state order. A state is only marked clean right
+ * before its handler is called, so handlers can still use isStateDirty() to
+ * find out if a state will be applied later. Handlers may also invalidate
+ * other states, including ones in words that were already scanned. */
+static void context_apply_dirty_graphics_states(struct wined3d_context *context, const struct wined3d_state *state)
+{
+    const struct StateEntry *state_table = context->state_table;
+    unsigned int i, idx, dirty_words, dirty_states, state_id;
+    BOOL rescan;
+
+    do
+    {
+        rescan = FALSE;
+        for (i = 0; i < ARRAY_SIZE(context->dirty_graphics_words); ++i)
+        {
+            while ((dirty_words = context->dirty_graphics_words[i]))
+            {
+                idx = i * sizeof(dirty_words) * CHAR_BIT + wined3d_bit_scan(&dirty_words);
+                context->dirty_graphics_words[i] = dirty_words;
+
+                while ((dirty_states = context->dirty_graphics_states[idx]))
+                {
+                    state_id = idx * sizeof(dirty_states) * CHAR_BIT + wined3d_bit_scan(&dirty_states);
+                    context->dirty_graphics_states[idx] = dirty_states;
+                    state_table[state_id].apply(context, state, state_id);
+                }
+            }
+        }
+        for (i = 0; i < ARRAY_SIZE(context->dirty_graphics_words); ++i)
+            rescan |= !!context->dirty_graphics_words[i];
+    } while (rescan);
+}
+
 /* Context activation is done by the caller. */
 static BOOL context_apply_draw_state(struct wined3d_context *context,
         const struct wined3d_device *device, const struct wined3d_state *state)
 {
-    const struct StateEntry *state_table = context->state_table;
     const struct wined3d_gl_info *gl_info = context->gl_info;
     const struct wined3d_fb_state *fb = state->fb;
     unsigned int i;
@@ -3978,19 +4024,14 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
             wined3d_buffer_load_sysmem(state->index_buffer, context);
     }
 
-    for (i = 0; i < context->numDirtyEntries; ++i)
-    {
-        DWORD rep = context->dirtyArray[i];
-        DWORD idx = rep / (sizeof(*context->isStateDirty) * CHAR_BIT);
-        BYTE shift = rep & ((sizeof(*context->isStateDirty) * CHAR_BIT) - 1);
-        context->isStateDirty[idx] &= ~(1u << shift);
-        state_table[rep].apply(context, state, rep);
-    }
+    context_apply_dirty_graphics_states(context, state);
 
     if (context->shader_update_mask & ~(1u << WINED3D_SHADER_TYPE_COMPUTE))
     {
         device->shader_backend->shader_select(device->shader_priv, context, state);
-        context->shader_update_mask &= 1u << WINED3D_SHADER_TYPE_COMPUTE;
+        /* Keep selecting programs that are still being compiled. */
+        if (!context->shader_pending)
+            context->shader_update_mask &= 1u << WINED3D_SHADER_TYPE_COMPUTE;
     }
 
     if (context->constant_update_mask)
@@ -4022,7 +4063,6 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
         context_check_fbo_status(context, GL_FRAMEBUFFER);
     }
 
-    context->numDirtyEntries = 0; /* This makes the whole list clean */
     context->last_was_blit = FALSE;
 
     return TRUE;
@@ -4496,6 +4536,46 @@ static unsigned int get_stride_idx(const void *idx_data, unsigned int idx_size,
 }
 
 /* Context activation is done by the caller. */
+/* Context activation is done by the caller. */
+static void draw_primitive_arrays_multi(struct wined3d_context *context, const struct wined3d_state *state,
+        const void *idx_data, unsigned int idx_size, const struct wined3d_draw_parameters *parameters,
+        unsigned int draw_count)
+{
+    GLenum idx_type = idx_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    const void *indices[WINED3D_MAX_DRAW_BATCH];
+    GLsizei counts[WINED3D_MAX_DRAW_BATCH];
+    GLint starts[WINED3D_MAX_DRAW_BATCH];
+    GLenum mode = state->gl_primitive_type;
+    unsigned int i;
+
+    for (i = 0; i < draw_count; ++i)
+    {
+        const struct wined3d_direct_draw_parameters *direct = &parameters[i].u.direct;
+
+        counts[i] = direct->index_count;
+        if (idx_size)
+        {
+            indices[i] = (const char *)idx_data + idx_size * direct->start_idx;
+            starts[i] = direct->base_vertex_idx;
+        }
+        else
+        {
+            starts[i] = direct->start_idx;
+        }
+    }
+
+    if (!idx_size)
+    {
+        GL_EXTCALL(glMultiDrawArrays(mode, starts, counts, draw_count));
+        checkGLcall("glMultiDrawArrays");
+        return;
+    }
+
+    GL_EXTCALL(glMultiDrawElementsBaseVertex(mode, counts, idx_type, indices, draw_count, starts));
+    checkGLcall("glMultiDrawElementsBaseVertex");
+}
+
 static void draw_primitive_immediate_mode(struct wined3d_context *context, const struct wined3d_state *state,
         const struct wined3d_stream_info *si, const void *idx_data, unsigned int idx_size,
         int base_vertex_idx, unsigned int start_idx, unsigned int vertex_count, unsigned int instance_count)
@@ -4797,8 +4877,11 @@ static GLenum gl_tfb_primitive_type_from_d3d(enum wined3d_primitive_type primiti
 }
 
 /* Routine common to the draw primitive and draw indexed primitive routines */
+/* Multiple draws can be passed at once, as long as they are direct and only
+ * differ in their index and vertex ranges. Such draws are merged into a single
+ * multi-draw call where possible. */
 void draw_primitive(struct wined3d_device *device, const struct wined3d_state *state,
-        const struct wined3d_draw_parameters *parameters)
+        const struct wined3d_draw_parameters *parameters, unsigned int draw_count)
 {
     BOOL emulation = FALSE, rasterizer_discard = FALSE;
     const struct wined3d_fb_state *fb = state->fb;
@@ -4811,7 +4894,7 @@ void draw_primitive(struct wined3d_device *device, const struct wined3d_state *s
     unsigned int i, idx_size = 0;
     const void *idx_data = NULL;
 
-    if (!parameters->indirect && !parameters->u.direct.index_count)
+    if (draw_count == 1 && !parameters->indirect && !parameters->u.direct.index_count)
         return;
 
     if (!(rtv = fb->render_targets[0]))
@@ -4872,6 +4955,13 @@ void draw_primitive(struct wined3d_device *device, const struct wined3d_state *s
         return;
     }
 
+    if (context->shader_pending)
+    {
+        context_release(context);
+        TRACE("Shaders are still being compiled, skipping draw.\n");
+        return;
+    }
+
     if (dsv && state->render_states[WINED3D_RS_ZWRITEENABLE])
     {
         DWORD location = context->render_offscreen ? dsv->resource->draw_binding : WINED3D_LOCATION_DRAWABLE;
@@ -4976,20 +5066,36 @@ void draw_primitive(struct wined3d_device *device, const struct wined3d_state *s
         else
             FIXME("Indirect draws with immediate mode/emulation are not supported.\n");
     }
+    else if (draw_count > 1 && !context->instance_count && !context->use_immediate_mode_draw && !emulation
+            && !context->uses_uavs && gl_info->supported[ARB_DRAW_ELEMENTS_BASE_VERTEX])
+    {
+        draw_primitive_arrays_multi(context, state, idx_data, idx_size, parameters, draw_count);
+    }
     else
     {
-        unsigned int instance_count = parameters->u.direct.instance_count;
-        if (context->instance_count)
-            instance_count = context->instance_count;
+        for (i = 0; i < draw_count; ++i)
+        {
+            const struct wined3d_direct_draw_parameters *direct = &parameters[i].u.direct;
+            unsigned int instance_count = direct->instance_count;
 
-        if (context->use_immediate_mode_draw || emulation)
-            draw_primitive_immediate_mode(context, state, stream_info, idx_data,
-                    idx_size, parameters->u.direct.base_vertex_idx,
-                    parameters->u.direct.start_idx, parameters->u.direct.index_count, instance_count);
-        else
-            draw_primitive_arrays(context, state, idx_data, idx_size, parameters->u.direct.base_vertex_idx,
-                    parameters->u.direct.start_idx, parameters->u.direct.index_count,
-                    parameters->u.direct.start_instance, instance_count);
+            if (context->instance_count)
+                instance_count = context->instance_count;
+
+            if (i && context->uses_uavs)
+            {
+                GL_EXTCALL(glMemoryBarrier(GL_ALL_BARRIER_BITS));
+                checkGLcall("glMemoryBarrier");
+            }
+
+            if (context->use_immediate_mode_draw || emulation)
+                draw_primitive_immediate_mode(context, state, stream_info, idx_data,
+                        idx_size, direct->base_vertex_idx,
+                        direct->start_idx, direct->index_count, instance_count);
+            else
+                draw_primitive_arrays(context, state, idx_data, idx_size, direct->base_vertex_idx,
+                        direct->start_idx, direct->index_count,
+                        direct->start_instance, instance_count);
+        }
     }
 
     if (context->uses_uavs)
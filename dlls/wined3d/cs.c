@@ -18,6 +18,13 @@
 
 #include "config.h"
 #include "wine/port.h"
+
+#include <errno.h>
+#include <stdio.h>
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
@@ -95,6 +102,9 @@ struct wined3d_cs_present
     RECT src_rect;
     RECT dst_rect;
     DWORD flags;
+    ULONGLONG require_space_time;
+    ULONGLONG finish_time;
+    ULONGLONG present_time;
 };
 
 struct wined3d_cs_clear
@@ -440,10 +450,96 @@ struct wined3d_cs_stop
     enum wined3d_cs_op opcode;
 };
 
+#define WINED3D_CS_PROFILE_QUERY_COUNT 4
+#define WINED3D_CS_PROFILE_HISTORY 64
+
+struct wined3d_cs_profile
+{
+    HANDLE file;
+    BOOL overlay;
+    LARGE_INTEGER frequency;
+    unsigned int frame;
+
+    /* Producer side. These are passed to the CS thread in the present
+     * packet. */
+    ULONGLONG require_space_time;
+    ULONGLONG finish_time;
+    ULONGLONG present_time;
+
+    /* CS side. */
+    ULONGLONG frame_start;
+    unsigned int op_count[WINED3D_CS_OP_STOP];
+    ULONGLONG op_time[WINED3D_CS_OP_STOP];
+    unsigned int draw_batch_count;
+    unsigned int batched_draw_count;
+
+    struct wined3d_timestamp_query queries[WINED3D_CS_PROFILE_QUERY_COUNT];
+    unsigned int query_idx;
+    UINT64 gpu_timestamp;
+    UINT64 gpu_time;
+
+    float cs_history[WINED3D_CS_PROFILE_HISTORY];
+    float gpu_history[WINED3D_CS_PROFILE_HISTORY];
+    unsigned int history_idx;
+};
+
+static inline ULONGLONG wined3d_cs_profile_ticks(void)
+{
+    LARGE_INTEGER counter;
+
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static unsigned int wined3d_cs_profile_us(const struct wined3d_cs_profile *profile, ULONGLONG ticks)
+{
+    return ticks * 1000000 / profile->frequency.QuadPart;
+}
+
 static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
 
+struct wined3d_cs_query_batch
+{
+    struct list entry;
+    struct list queries;
+    struct wined3d_fence *fence;
+    BOOL flushed;
+};
+
+/* Puts all queries ended since the previous call behind a single fence, so
+ * that poll_queries() only needs to test the fence. */
+static void wined3d_cs_close_query_batch(struct wined3d_cs *cs, BOOL flushed)
+{
+    struct wined3d_cs_query_batch *batch;
+
+    if (!cs->query_batching || list_empty(&cs->query_poll_list))
+        return;
+
+    if (!list_empty(&cs->free_query_batches))
+    {
+        batch = LIST_ENTRY(list_head(&cs->free_query_batches), struct wined3d_cs_query_batch, entry);
+        list_remove(&batch->entry);
+    }
+    else
+    {
+        if (!(batch = heap_alloc(sizeof(*batch))))
+            return;
+        if (FAILED(wined3d_fence_create(cs->device, &batch->fence)))
+        {
+            heap_free(batch);
+            return;
+        }
+    }
+
+    list_init(&batch->queries);
+    list_move_tail(&batch->queries, &cs->query_poll_list);
+    wined3d_fence_issue(batch->fence, cs->device);
+    batch->flushed = flushed;
+    list_add_tail(&cs->query_batches, &batch->entry);
+}
+
 static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_present *op = data;
@@ -461,13 +557,22 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
         wined3d_resource_release(&swapchain->back_buffers[i]->resource);
     }
 
+    if (cs->thread)
+        wined3d_cs_close_query_batch(cs, TRUE);
+
+    if (swapchain->frame_latency_event)
+        ReleaseSemaphore(swapchain->frame_latency_event, 1, NULL);
+
+    ++cs->present_count;
     InterlockedDecrement(&cs->pending_presents);
 }
 
 void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *swapchain,
         const RECT *src_rect, const RECT *dst_rect, HWND dst_window_override, DWORD flags)
 {
+    struct wined3d_cs_profile *profile;
     struct wined3d_cs_present *op;
+    ULONGLONG wait_start = 0;
     unsigned int i;
     LONG pending;
 
@@ -478,6 +583,13 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
     op->src_rect = *src_rect;
     op->dst_rect = *dst_rect;
     op->flags = flags;
+    if ((profile = cs->profile))
+    {
+        op->require_space_time = profile->require_space_time;
+        op->finish_time = profile->finish_time;
+        op->present_time = profile->present_time;
+        profile->require_space_time = profile->finish_time = profile->present_time = 0;
+    }
 
     pending = InterlockedIncrement(&cs->pending_presents);
 
@@ -490,13 +602,17 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
     cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 
     /* Limit input latency by limiting the number of presents that we can get
-     * ahead of the worker thread. We have a constant limit here, but
-     * IDXGIDevice1 allows tuning this. */
-    while (pending > 1)
+     * ahead of the worker thread. IDXGIDevice1 allows tuning this through
+     * wined3d_device_set_max_frame_latency(). */
+    if (pending > cs->device->max_frame_latency && profile)
+        wait_start = wined3d_cs_profile_ticks();
+    while (pending > cs->device->max_frame_latency)
     {
         wined3d_pause();
         pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
     }
+    if (wait_start)
+        profile->present_time += wined3d_cs_profile_ticks() - wait_start;
 }
 
 static void wined3d_cs_exec_clear(struct wined3d_cs *cs, const void *data)
@@ -759,36 +875,12 @@ void wined3d_cs_emit_dispatch_indirect(struct wined3d_cs *cs,
     cs->ops->submit(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void wined3d_cs_exec_draw(struct wined3d_cs *cs, const void *data)
+static void wined3d_cs_release_draw_resources(struct wined3d_cs *cs, const struct wined3d_cs_draw *op)
 {
     const struct wined3d_gl_info *gl_info = &cs->device->adapter->gl_info;
     struct wined3d_state *state = &cs->state;
-    const struct wined3d_cs_draw *op = data;
-    int load_base_vertex_idx;
     unsigned int i;
 
-    /* ARB_draw_indirect always supports a base vertex offset. */
-    if (!op->parameters.indirect && !gl_info->supported[ARB_DRAW_ELEMENTS_BASE_VERTEX])
-        load_base_vertex_idx = op->parameters.u.direct.base_vertex_idx;
-    else
-        load_base_vertex_idx = 0;
-
-    if (state->load_base_vertex_index != load_base_vertex_idx)
-    {
-        state->load_base_vertex_index = load_base_vertex_idx;
-        device_invalidate_state(cs->device, STATE_BASEVERTEXINDEX);
-    }
-
-    if (state->gl_primitive_type != op->primitive_type)
-    {
-        if (state->gl_primitive_type == GL_POINTS || op->primitive_type == GL_POINTS)
-            device_invalidate_state(cs->device, STATE_POINT_ENABLE);
-        state->gl_primitive_type = op->primitive_type;
-    }
-    state->gl_patch_vertices = op->patch_vertex_count;
-
-    draw_primitive(cs->device, state, &op->parameters);
-
     if (op->parameters.indirect)
     {
         struct wined3d_buffer *buffer = op->parameters.u.indirect.buffer;
@@ -824,6 +916,60 @@ static void wined3d_cs_exec_draw(struct wined3d_cs *cs, const void *data)
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
+/* The draws in a batch are consecutive in the command stream, so they share
+ * all state. See wined3d_cs_draw_can_batch(). */
+static void wined3d_cs_exec_draw_batch(struct wined3d_cs *cs,
+        const struct wined3d_cs_draw * const *ops, unsigned int count)
+{
+    struct wined3d_draw_parameters parameters[WINED3D_MAX_DRAW_BATCH];
+    const struct wined3d_gl_info *gl_info = &cs->device->adapter->gl_info;
+    struct wined3d_state *state = &cs->state;
+    const struct wined3d_cs_draw *op = ops[0];
+    int load_base_vertex_idx;
+    unsigned int i;
+
+    /* ARB_draw_indirect always supports a base vertex offset. */
+    if (!op->parameters.indirect && !gl_info->supported[ARB_DRAW_ELEMENTS_BASE_VERTEX])
+        load_base_vertex_idx = op->parameters.u.direct.base_vertex_idx;
+    else
+        load_base_vertex_idx = 0;
+
+    if (state->load_base_vertex_index != load_base_vertex_idx)
+    {
+        state->load_base_vertex_index = load_base_vertex_idx;
+        device_invalidate_state(cs->device, STATE_BASEVERTEXINDEX);
+    }
+
+    if (state->gl_primitive_type != op->primitive_type)
+    {
+        if (state->gl_primitive_type == GL_POINTS || op->primitive_type == GL_POINTS)
+            device_invalidate_state(cs->device, STATE_POINT_ENABLE);
+        state->gl_primitive_type = op->primitive_type;
+    }
+    state->gl_patch_vertices = op->patch_vertex_count;
+
+    if (count == 1)
+    {
+        draw_primitive(cs->device, state, &op->parameters, 1);
+    }
+    else
+    {
+        for (i = 0; i < count; ++i)
+            parameters[i] = ops[i]->parameters;
+        draw_primitive(cs->device, state, parameters, count);
+    }
+
+    for (i = 0; i < count; ++i)
+        wined3d_cs_release_draw_resources(cs, ops[i]);
+}
+
+static void wined3d_cs_exec_draw(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_draw *op = data;
+
+    wined3d_cs_exec_draw_batch(cs, &op, 1);
+}
+
 static void acquire_graphics_pipeline_resources(const struct wined3d_state *state,
         BOOL indexed, const struct wined3d_gl_info *gl_info)
 {
@@ -909,6 +1055,9 @@ static void wined3d_cs_exec_flush(struct wined3d_cs *cs, const void *data)
 {
     struct wined3d_context *context;
 
+    if (cs->thread)
+        wined3d_cs_close_query_batch(cs, TRUE);
+
     context = context_acquire(cs->device, NULL, 0);
     if (context->valid)
         context->gl_info->gl_ops.gl.p_glFlush();
@@ -2444,6 +2593,274 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_GENERATE_MIPMAPS            */ wined3d_cs_exec_generate_mipmaps,
 };
 
+static const char * const wined3d_cs_op_names[] =
+{
+    /* WINED3D_CS_OP_NOP                         */ "nop",
+    /* WINED3D_CS_OP_PRESENT                     */ "present",
+    /* WINED3D_CS_OP_CLEAR                       */ "clear",
+    /* WINED3D_CS_OP_DISPATCH                    */ "dispatch",
+    /* WINED3D_CS_OP_DRAW                        */ "draw",
+    /* WINED3D_CS_OP_FLUSH                       */ "flush",
+    /* WINED3D_CS_OP_SET_PREDICATION             */ "set_predication",
+    /* WINED3D_CS_OP_SET_VIEWPORT                */ "set_viewport",
+    /* WINED3D_CS_OP_SET_SCISSOR_RECT            */ "set_scissor_rect",
+    /* WINED3D_CS_OP_SET_RENDERTARGET_VIEW       */ "set_rendertarget_view",
+    /* WINED3D_CS_OP_SET_DEPTH_STENCIL_VIEW      */ "set_depth_stencil_view",
+    /* WINED3D_CS_OP_SET_VERTEX_DECLARATION      */ "set_vertex_declaration",
+    /* WINED3D_CS_OP_SET_STREAM_SOURCE           */ "set_stream_source",
+    /* WINED3D_CS_OP_SET_STREAM_SOURCE_FREQ      */ "set_stream_source_freq",
+    /* WINED3D_CS_OP_SET_STREAM_OUTPUT           */ "set_stream_output",
+    /* WINED3D_CS_OP_SET_INDEX_BUFFER            */ "set_index_buffer",
+    /* WINED3D_CS_OP_SET_CONSTANT_BUFFER         */ "set_constant_buffer",
+    /* WINED3D_CS_OP_SET_TEXTURE                 */ "set_texture",
+    /* WINED3D_CS_OP_SET_SHADER_RESOURCE_VIEW    */ "set_shader_resource_view",
+    /* WINED3D_CS_OP_SET_UNORDERED_ACCESS_VIEW   */ "set_unordered_access_view",
+    /* WINED3D_CS_OP_SET_SAMPLER                 */ "set_sampler",
+    /* WINED3D_CS_OP_SET_SHADER                  */ "set_shader",
+    /* WINED3D_CS_OP_SET_BLEND_STATE             */ "set_blend_state",
+    /* WINED3D_CS_OP_SET_RASTERIZER_STATE        */ "set_rasterizer_state",
+    /* WINED3D_CS_OP_SET_RENDER_STATE            */ "set_render_state",
+    /* WINED3D_CS_OP_SET_TEXTURE_STATE           */ "set_texture_state",
+    /* WINED3D_CS_OP_SET_SAMPLER_STATE           */ "set_sampler_state",
+    /* WINED3D_CS_OP_SET_TRANSFORM               */ "set_transform",
+    /* WINED3D_CS_OP_SET_CLIP_PLANE              */ "set_clip_plane",
+    /* WINED3D_CS_OP_SET_COLOR_KEY               */ "set_color_key",
+    /* WINED3D_CS_OP_SET_MATERIAL                */ "set_material",
+    /* WINED3D_CS_OP_SET_LIGHT                   */ "set_light",
+    /* WINED3D_CS_OP_SET_LIGHT_ENABLE            */ "set_light_enable",
+    /* WINED3D_CS_OP_PUSH_CONSTANTS              */ "push_constants",
+    /* WINED3D_CS_OP_RESET_STATE                 */ "reset_state",
+    /* WINED3D_CS_OP_CALLBACK                    */ "callback",
+    /* WINED3D_CS_OP_QUERY_ISSUE                 */ "query_issue",
+    /* WINED3D_CS_OP_PRELOAD_RESOURCE            */ "preload_resource",
+    /* WINED3D_CS_OP_UNLOAD_RESOURCE             */ "unload_resource",
+    /* WINED3D_CS_OP_MAP                         */ "map",
+    /* WINED3D_CS_OP_UNMAP                       */ "unmap",
+    /* WINED3D_CS_OP_BLT_SUB_RESOURCE            */ "blt_sub_resource",
+    /* WINED3D_CS_OP_UPDATE_SUB_RESOURCE         */ "update_sub_resource",
+    /* WINED3D_CS_OP_ADD_DIRTY_TEXTURE_REGION    */ "add_dirty_texture_region",
+    /* WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW */ "clear_unordered_access_view",
+    /* WINED3D_CS_OP_COPY_UAV_COUNTER            */ "copy_uav_counter",
+    /* WINED3D_CS_OP_GENERATE_MIPMAPS            */ "generate_mipmaps",
+};
+
+static void wined3d_cs_profile_end_frame(struct wined3d_cs *cs, const struct wined3d_cs_present *op)
+{
+    struct wined3d_cs_profile *profile = cs->profile;
+    ULONGLONG now, busy_time = 0;
+    char buffer[4096], *p;
+    unsigned int i;
+    DWORD written;
+
+    now = wined3d_cs_profile_ticks();
+    for (i = 0; i < ARRAY_SIZE(profile->op_time); ++i)
+        busy_time += profile->op_time[i];
+
+    if (profile->file != INVALID_HANDLE_VALUE)
+    {
+        p = buffer;
+        p += sprintf(p, "%u %u %u %u %u %u %u", profile->frame,
+                wined3d_cs_profile_us(profile, now - profile->frame_start),
+                wined3d_cs_profile_us(profile, busy_time),
+                wined3d_cs_profile_us(profile, op->require_space_time),
+                wined3d_cs_profile_us(profile, op->finish_time),
+                wined3d_cs_profile_us(profile, op->present_time),
+                (unsigned int)(profile->gpu_time / 1000));
+        for (i = 0; i < ARRAY_SIZE(profile->op_count); ++i)
+        {
+            if (profile->op_count[i])
+                p += sprintf(p, " %s:%u:%u", wined3d_cs_op_names[i], profile->op_count[i],
+                        wined3d_cs_profile_us(profile, profile->op_time[i]));
+        }
+        if (profile->draw_batch_count)
+            p += sprintf(p, " draw_batches:%u:%u", profile->draw_batch_count, profile->batched_draw_count);
+        *p++ = '\n';
+        if (!WriteFile(profile->file, buffer, p - buffer, &written, NULL))
+            WARN("Failed to write profile data, error %#x.\n", GetLastError());
+    }
+
+    profile->cs_history[profile->history_idx] = busy_time * 1000.0f / profile->frequency.QuadPart;
+    profile->gpu_history[profile->history_idx] = profile->gpu_time / 1000000.0f;
+    profile->history_idx = (profile->history_idx + 1) % WINED3D_CS_PROFILE_HISTORY;
+
+    memset(profile->op_count, 0, sizeof(profile->op_count));
+    memset(profile->op_time, 0, sizeof(profile->op_time));
+    profile->draw_batch_count = 0;
+    profile->batched_draw_count = 0;
+    profile->frame_start = now;
+    ++profile->frame;
+}
+
+static void wined3d_cs_execute(struct wined3d_cs *cs, enum wined3d_cs_op opcode, const void *data)
+{
+    struct wined3d_cs_profile *profile;
+    ULONGLONG start;
+
+    if (!(profile = cs->profile))
+    {
+        wined3d_cs_op_handlers[opcode](cs, data);
+        return;
+    }
+
+    start = wined3d_cs_profile_ticks();
+    wined3d_cs_op_handlers[opcode](cs, data);
+    ++profile->op_count[opcode];
+    profile->op_time[opcode] += wined3d_cs_profile_ticks() - start;
+
+    if (opcode == WINED3D_CS_OP_PRESENT)
+        wined3d_cs_profile_end_frame(cs, data);
+}
+
+/* Context activation is done by the caller. */
+static void wined3d_cs_profile_fill(const struct wined3d_gl_info *gl_info,
+        int x, int y, int width, int height, float r, float g, float b)
+{
+    gl_info->gl_ops.gl.p_glScissor(x, y, width, height);
+    gl_info->gl_ops.gl.p_glClearColor(r, g, b, 1.0f);
+    gl_info->gl_ops.gl.p_glClear(GL_COLOR_BUFFER_BIT);
+}
+
+/* Draws two bar graphs into the lower left corner of the drawable, CS time
+ * below GPU time, at 4 pixels per millisecond. The grey line marks 16.7 ms.
+ *
+ * Context activation is done by the caller. */
+static void wined3d_cs_profile_draw_overlay(const struct wined3d_cs_profile *profile,
+        struct wined3d_context *context, struct wined3d_texture *back_buffer)
+{
+    static const int bar_width = 3, graph_height = 128;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    int graph_width, x, y, height;
+    unsigned int i, j, idx;
+    const float *history;
+
+    context_apply_fbo_state_blit(context, GL_DRAW_FRAMEBUFFER,
+            back_buffer->sub_resources[0].u.surface, NULL, WINED3D_LOCATION_DRAWABLE);
+    context_set_draw_buffer(context, wined3d_texture_get_gl_buffer(back_buffer));
+    context_invalidate_state(context, STATE_FRAMEBUFFER);
+
+    gl_info->gl_ops.gl.p_glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    context_invalidate_state(context, STATE_RENDER(WINED3D_RS_COLORWRITEENABLE));
+    context_invalidate_state(context, STATE_RENDER(WINED3D_RS_COLORWRITEENABLE1));
+    context_invalidate_state(context, STATE_RENDER(WINED3D_RS_COLORWRITEENABLE2));
+    context_invalidate_state(context, STATE_RENDER(WINED3D_RS_COLORWRITEENABLE3));
+    gl_info->gl_ops.gl.p_glEnable(GL_SCISSOR_TEST);
+    context_invalidate_state(context, STATE_RENDER(WINED3D_RS_SCISSORTESTENABLE));
+    context_invalidate_state(context, STATE_SCISSORRECT);
+
+    graph_width = WINED3D_CS_PROFILE_HISTORY * bar_width;
+    for (j = 0; j < 2; ++j)
+    {
+        history = j ? profile->gpu_history : profile->cs_history;
+        y = 8 + j * (graph_height + 8);
+
+        wined3d_cs_profile_fill(gl_info, 8, y, graph_width, graph_height, 0.0f, 0.0f, 0.0f);
+        for (i = 0; i < WINED3D_CS_PROFILE_HISTORY; ++i)
+        {
+            idx = (profile->history_idx + i) % WINED3D_CS_PROFILE_HISTORY;
+            x = 8 + i * bar_width;
+            if (!(height = min(history[idx] * 4.0f, graph_height)))
+                continue;
+            if (j)
+                wined3d_cs_profile_fill(gl_info, x, y, bar_width - 1, height, 0.9f, 0.2f, 0.2f);
+            else
+                wined3d_cs_profile_fill(gl_info, x, y, bar_width - 1, height, 0.2f, 0.9f, 0.2f);
+        }
+        wined3d_cs_profile_fill(gl_info, 8, y + 67, graph_width, 1, 0.6f, 0.6f, 0.6f);
+    }
+    checkGLcall("draw profile overlay");
+}
+
+/* Called by the swapchain right before swapping buffers. The GPU frame time
+ * is the difference between the timestamps of two consecutive presents.
+ * Results are read back WINED3D_CS_PROFILE_QUERY_COUNT presents later to
+ * avoid stalling on the GPU, so the reported time lags a few frames behind.
+ *
+ * Context activation is done by the caller. */
+void wined3d_cs_profile_present(struct wined3d_cs *cs, struct wined3d_context *context,
+        struct wined3d_texture *back_buffer)
+{
+    struct wined3d_cs_profile *profile = cs->profile;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    struct wined3d_timestamp_query *query;
+    GLuint available = GL_FALSE;
+    GLuint64 timestamp;
+
+    if (profile->overlay)
+        wined3d_cs_profile_draw_overlay(profile, context, back_buffer);
+
+    if (!gl_info->supported[ARB_TIMER_QUERY])
+        return;
+
+    query = &profile->queries[profile->query_idx];
+    if (query->context)
+    {
+        if (query->context == context)
+        {
+            GL_EXTCALL(glGetQueryObjectuiv(query->id, GL_QUERY_RESULT_AVAILABLE, &available));
+            if (available)
+            {
+                GL_EXTCALL(glGetQueryObjectui64v(query->id, GL_QUERY_RESULT, &timestamp));
+                if (profile->gpu_timestamp)
+                    profile->gpu_time = timestamp - profile->gpu_timestamp;
+                profile->gpu_timestamp = timestamp;
+            }
+            checkGLcall("read profile timestamp");
+        }
+        context_free_timestamp_query(query);
+    }
+    /* Don't compute a frame time across a gap in the timestamps. */
+    if (!available)
+        profile->gpu_timestamp = 0;
+
+    context_alloc_timestamp_query(context, query);
+    GL_EXTCALL(glQueryCounter(query->id, GL_TIMESTAMP));
+    checkGLcall("glQueryCounter()");
+    profile->query_idx = (profile->query_idx + 1) % WINED3D_CS_PROFILE_QUERY_COUNT;
+}
+
+static struct wined3d_cs_profile *wined3d_cs_profile_create(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_profile *profile;
+    char buffer[128];
+    DWORD written;
+    int len;
+
+    if (!(profile = heap_alloc_zero(sizeof(*profile))))
+    {
+        ERR("Failed to allocate profile memory.\n");
+        return NULL;
+    }
+
+    profile->file = INVALID_HANDLE_VALUE;
+    if (wined3d_settings.cs_profile_path)
+    {
+        if ((profile->file = CreateFileA(wined3d_settings.cs_profile_path, FILE_APPEND_DATA,
+                FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+        {
+            ERR("Failed to open profile log %s, error %#x.\n",
+                    debugstr_a(wined3d_settings.cs_profile_path), GetLastError());
+        }
+        else
+        {
+            len = sprintf(buffer, "# device %p: frame frame_us cs_us require_space_us "
+                    "finish_us present_us gpu_us [op:count:us]...\n", cs->device);
+            WriteFile(profile->file, buffer, len, &written, NULL);
+        }
+    }
+    profile->overlay = wined3d_settings.cs_profile_overlay;
+    QueryPerformanceFrequency(&profile->frequency);
+    profile->frame_start = wined3d_cs_profile_ticks();
+
+    return profile;
+}
+
+static void wined3d_cs_profile_destroy(struct wined3d_cs_profile *profile)
+{
+    if (profile->file != INVALID_HANDLE_VALUE)
+        CloseHandle(profile->file);
+    heap_free(profile);
+}
+
 static void *wined3d_cs_st_require_space(struct wined3d_cs *cs, size_t size, enum wined3d_cs_queue_id queue_id)
 {
     if (size > (cs->data_size - cs->end))
@@ -2483,7 +2900,7 @@ static void wined3d_cs_st_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id
     if (opcode >= WINED3D_CS_OP_STOP)
         ERR("Invalid opcode %#x.\n", opcode);
     else
-        wined3d_cs_op_handlers[opcode](cs, &data[start]);
+        wined3d_cs_execute(cs, opcode, &data[start]);
 
     if (cs->data == data)
         cs->start = cs->end = start;
@@ -2503,6 +2920,60 @@ static const struct wined3d_cs_ops wined3d_cs_st_ops =
     wined3d_cs_st_push_constants,
 };
 
+/* Waking the CS thread through an event is a wineserver round trip. On Linux,
+ * wait on "waiting_for_event" directly with a process private futex instead. */
+#if defined(__linux__) && defined(__NR_futex)
+
+static int futex_wait_op = 128; /* FUTEX_WAIT | FUTEX_PRIVATE_FLAG */
+static int futex_wake_op = 129; /* FUTEX_WAKE | FUTEX_PRIVATE_FLAG */
+
+static inline int wined3d_futex_wait(LONG *addr, LONG val)
+{
+    return syscall(__NR_futex, addr, futex_wait_op, val, NULL, 0, 0);
+}
+
+static inline int wined3d_futex_wake(LONG *addr)
+{
+    return syscall(__NR_futex, addr, futex_wake_op, 1, NULL, 0, 0);
+}
+
+static BOOL wined3d_use_futexes(void)
+{
+    static LONG supported = -1;
+
+    if (supported == -1)
+    {
+        wined3d_futex_wait(&supported, 10);
+        if (errno == ENOSYS)
+        {
+            futex_wait_op = 0; /* FUTEX_WAIT */
+            futex_wake_op = 1; /* FUTEX_WAKE */
+            wined3d_futex_wait(&supported, 10);
+        }
+        supported = errno != ENOSYS;
+    }
+    return supported;
+}
+
+#else
+
+static inline int wined3d_futex_wait(LONG *addr, LONG val)
+{
+    return -1;
+}
+
+static inline int wined3d_futex_wake(LONG *addr)
+{
+    return -1;
+}
+
+static BOOL wined3d_use_futexes(void)
+{
+    return FALSE;
+}
+
+#endif
+
 static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
 {
     wined3d_from_cs(cs);
@@ -2519,7 +2990,12 @@ static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined
     InterlockedExchange(&queue->head, (queue->head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1));
 
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
-        SetEvent(cs->event);
+    {
+        if (cs->event)
+            SetEvent(cs->event);
+        else
+            wined3d_futex_wake(&cs->waiting_for_event);
+    }
 }
 
 static void wined3d_cs_mt_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
@@ -2535,6 +3011,7 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
     size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
     struct wined3d_cs_packet *packet;
+    ULONGLONG wait_start = 0;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     size = (size + header_size - 1) & ~(header_size - 1);
@@ -2584,7 +3061,12 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
 
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
                 head, tail, (unsigned long)packet_size);
+        if (cs->profile && !wait_start)
+            wait_start = wined3d_cs_profile_ticks();
+        wined3d_pause();
     }
+    if (wait_start)
+        cs->profile->require_space_time += wined3d_cs_profile_ticks() - wait_start;
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
     packet->size = size;
@@ -2601,11 +3083,17 @@ static void *wined3d_cs_mt_require_space(struct wined3d_cs *cs, size_t size, enu
 
 static void wined3d_cs_mt_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
+    ULONGLONG wait_start = 0;
+
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(cs, queue_id);
 
+    if (cs->profile && cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
+        wait_start = wined3d_cs_profile_ticks();
     while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
         wined3d_pause();
+    if (wait_start)
+        cs->profile->finish_time += wined3d_cs_profile_ticks() - wait_start;
 }
 
 static const struct wined3d_cs_ops wined3d_cs_mt_ops =
@@ -2618,16 +3106,66 @@ static const struct wined3d_cs_ops wined3d_cs_mt_ops =
 
 static void poll_queries(struct wined3d_cs *cs)
 {
+    struct wined3d_cs_query_batch *batch, *batch_cursor;
     struct wined3d_query *query, *cursor;
 
-    LIST_FOR_EACH_ENTRY_SAFE(query, cursor, &cs->query_poll_list, struct wined3d_query, poll_list_entry)
+    if (!cs->query_batching)
     {
-        if (!query->query_ops->query_poll(query, 0))
-            continue;
+        LIST_FOR_EACH_ENTRY_SAFE(query, cursor, &cs->query_poll_list, struct wined3d_query, poll_list_entry)
+        {
+            if (!query->query_ops->query_poll(query, 0))
+                continue;
 
-        list_remove(&query->poll_list_entry);
-        list_init(&query->poll_list_entry);
-        InterlockedIncrement(&query->counter_retrieved);
+            list_remove(&query->poll_list_entry);
+            list_init(&query->poll_list_entry);
+            InterlockedIncrement(&query->counter_retrieved);
+        }
+        return;
+    }
+
+    LIST_FOR_EACH_ENTRY_SAFE(batch, batch_cursor, &cs->query_batches, struct wined3d_cs_query_batch, entry)
+    {
+        /* Queries can be destroyed or restarted while their batch is
+         * pending, so the batch may be empty by now. */
+        if (!list_empty(&batch->queries))
+        {
+            /* Fences signal in order, so newer batches can't be done either. */
+            if (wined3d_fence_test(batch->fence, cs->device,
+                    batch->flushed ? 0 : WINED3DGETDATA_FLUSH) == WINED3D_FENCE_WAITING)
+            {
+                batch->flushed = TRUE;
+                break;
+            }
+
+            LIST_FOR_EACH_ENTRY_SAFE(query, cursor, &batch->queries, struct wined3d_query, poll_list_entry)
+            {
+                list_remove(&query->poll_list_entry);
+                if (!query->query_ops->query_poll(query, 0))
+                {
+                    TRACE("Query %p was reissued after its batch was closed.\n", query);
+                    list_add_tail(&cs->query_poll_list, &query->poll_list_entry);
+                    continue;
+                }
+
+                list_init(&query->poll_list_entry);
+                InterlockedIncrement(&query->counter_retrieved);
+            }
+        }
+
+        list_remove(&batch->entry);
+        list_add_tail(&cs->free_query_batches, &batch->entry);
+    }
+}
+
+static void wined3d_cs_free_query_batches(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_query_batch *batch, *cursor;
+
+    list_move_tail(&cs->free_query_batches, &cs->query_batches);
+    LIST_FOR_EACH_ENTRY_SAFE(batch, cursor, &cs->free_query_batches, struct wined3d_cs_query_batch, entry)
+    {
+        wined3d_fence_destroy(batch->fence);
+        heap_free(batch);
     }
 }
 
@@ -2647,7 +3185,83 @@ static void wined3d_cs_wait_event(struct wined3d_cs *cs)
             && InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         return;
 
-    WaitForSingleObject(cs->event, INFINITE);
+    if (cs->event)
+    {
+        WaitForSingleObject(cs->event, INFINITE);
+        return;
+    }
+
+    /* The futex wait returns immediately if the main thread already reset
+     * "waiting_for_event", and may return spuriously. */
+    while (*(volatile LONG *)&cs->waiting_for_event)
+        wined3d_futex_wait(&cs->waiting_for_event, TRUE);
+}
+
+static BOOL wined3d_cs_draw_can_batch(const struct wined3d_cs_draw *first, const struct wined3d_cs_packet *packet)
+{
+    const struct wined3d_cs_draw *op = (const struct wined3d_cs_draw *)packet->data;
+
+    return packet->size && op->opcode == WINED3D_CS_OP_DRAW
+            && !op->parameters.indirect && op->parameters.indexed == first->parameters.indexed
+            && op->primitive_type == first->primitive_type
+            && op->patch_vertex_count == first->patch_vertex_count
+            && !op->parameters.u.direct.instance_count && !op->parameters.u.direct.start_instance;
+}
+
+/* Executes the draw at "tail" together with the compatible draws directly
+ * following it in the queue, and returns the last packet consumed. Nothing
+ * but draws can be between them, so they all use the same state. */
+static struct wined3d_cs_packet *wined3d_cs_exec_draws(struct wined3d_cs *cs,
+        struct wined3d_cs_queue *queue, LONG tail)
+{
+    const struct wined3d_gl_info *gl_info = &cs->device->adapter->gl_info;
+    const struct wined3d_cs_draw *ops[WINED3D_MAX_DRAW_BATCH];
+    struct wined3d_cs_packet *packet, *last;
+    struct wined3d_cs_profile *profile;
+    unsigned int count = 0;
+    ULONGLONG start;
+    LONG head;
+
+    last = (struct wined3d_cs_packet *)&queue->data[tail];
+    ops[count++] = (const struct wined3d_cs_draw *)last->data;
+
+    if (gl_info->supported[ARB_DRAW_ELEMENTS_BASE_VERTEX] && wined3d_cs_draw_can_batch(ops[0], last))
+    {
+        head = *(volatile LONG *)&queue->head;
+        while (count < ARRAY_SIZE(ops))
+        {
+            tail = (tail + FIELD_OFFSET(struct wined3d_cs_packet, data[last->size])) & (WINED3D_CS_QUEUE_SIZE - 1);
+            if (tail == head)
+                break;
+            packet = (struct wined3d_cs_packet *)&queue->data[tail];
+            if (!wined3d_cs_draw_can_batch(ops[0], packet))
+                break;
+            ops[count++] = (const struct wined3d_cs_draw *)packet->data;
+            last = packet;
+        }
+    }
+
+    if (count == 1)
+    {
+        wined3d_cs_execute(cs, WINED3D_CS_OP_DRAW, ops[0]);
+        return last;
+    }
+
+    TRACE("Merging %u draws.\n", count);
+    if (!(profile = cs->profile))
+    {
+        wined3d_cs_exec_draw_batch(cs, ops, count);
+        return last;
+    }
+
+    start = wined3d_cs_profile_ticks();
+    wined3d_cs_exec_draw_batch(cs, ops, count);
+    profile->op_count[WINED3D_CS_OP_DRAW] += count;
+    profile->op_time[WINED3D_CS_OP_DRAW] += wined3d_cs_profile_ticks() - start;
+    ++profile->draw_batch_count;
+    profile->batched_draw_count += count;
+
+    return last;
 }
 
 static DWORD WINAPI wined3d_cs_run(void *ctx)
@@ -2668,6 +3282,8 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
     wined3d_module = cs->wined3d_module;
 
     list_init(&cs->query_poll_list);
+    list_init(&cs->query_batches);
+    list_init(&cs->free_query_batches);
     cs->thread_id = GetCurrentThreadId();
     for (;;)
     {
@@ -2683,12 +3299,27 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
             if (wined3d_cs_queue_is_empty(cs, queue))
             {
-                if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
+                /* Don't keep the results of the last queries waiting for
+                 * the next present when there is nothing else to do. */
+                wined3d_cs_close_query_batch(cs, FALSE);
+                if (++spin_count >= cs->spin_count && list_empty(&cs->query_poll_list)
+                        && list_empty(&cs->query_batches))
+                {
+                    /* Spinning didn't pay off, give up sooner next time. */
                     wined3d_cs_wait_event(cs);
+                    cs->spin_count = max(cs->spin_count / 2, WINED3D_CS_SPIN_COUNT_MIN);
+                    spin_count = 0;
+                }
+                wined3d_pause();
                 continue;
             }
         }
-        spin_count = 0;
+        if (spin_count)
+        {
+            /* New work showed up while spinning, which saved a wakeup. */
+            cs->spin_count = min(cs->spin_count * 2, WINED3D_CS_SPIN_COUNT);
+            spin_count = 0;
+        }
 
         tail = queue->tail;
         packet = (struct wined3d_cs_packet *)&queue->data[tail];
@@ -2703,7 +3334,15 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
                 break;
             }
 
-            wined3d_cs_op_handlers[opcode](cs, packet->data);
+            if (opcode == WINED3D_CS_OP_DRAW)
+            {
+                packet = wined3d_cs_exec_draws(cs, queue, tail);
+                tail = (BYTE *)packet - queue->data;
+            }
+            else
+            {
+                wined3d_cs_execute(cs, opcode, packet->data);
+            }
         }
 
         tail += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
@@ -2711,6 +3350,7 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
         InterlockedExchange(&queue->tail, tail);
     }
 
+    wined3d_cs_free_query_batches(cs);
     cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
     cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail = cs->queue[WINED3D_CS_QUEUE_DEFAULT].head;
     TRACE("Stopped.\n");
@@ -2731,6 +3371,10 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     state_init(&cs->state, &cs->fb, gl_info, &device->adapter->d3d_info,
             WINED3D_STATE_NO_REF | WINED3D_STATE_INIT_DEFAULT);
 
+    if ((wined3d_settings.cs_profile_path || wined3d_settings.cs_profile_overlay)
+            && !(cs->profile = wined3d_cs_profile_create(cs)))
+        goto fail;
+
     cs->data_size = WINED3D_INITIAL_CS_SIZE;
     if (!(cs->data = heap_alloc(cs->data_size)))
         goto fail;
@@ -2739,8 +3383,10 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
             && !RtlIsCriticalSectionLockedByThread(NtCurrentTeb()->Peb->LoaderLock))
     {
         cs->ops = &wined3d_cs_mt_ops;
+        cs->spin_count = WINED3D_CS_SPIN_COUNT;
+        cs->query_batching = gl_info->supported[ARB_SYNC];
 
-        if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        if (!wined3d_use_futexes() && !(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
             heap_free(cs->data);
@@ -2751,7 +3397,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
                 (const WCHAR *)wined3d_cs_run, &cs->wined3d_module)))
         {
             ERR("Failed to get wined3d module handle.\n");
-            CloseHandle(cs->event);
+            if (cs->event)
+                CloseHandle(cs->event);
             heap_free(cs->data);
             goto fail;
         }
@@ -2760,7 +3407,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
         {
             ERR("Failed to create wined3d command stream thread.\n");
             FreeLibrary(cs->wined3d_module);
-            CloseHandle(cs->event);
+            if (cs->event)
+                CloseHandle(cs->event);
             heap_free(cs->data);
             goto fail;
         }
@@ -2769,6 +3417,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     return cs;
 
 fail:
+    if (cs->profile)
+        wined3d_cs_profile_destroy(cs->profile);
     state_cleanup(&cs->state);
     heap_free(cs);
     return NULL;
@@ -2780,10 +3430,12 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
     {
         wined3d_cs_emit_stop(cs);
         CloseHandle(cs->thread);
-        if (!CloseHandle(cs->event))
+        if (cs->event && !CloseHandle(cs->event))
             ERR("Closing event failed.\n");
     }
 
+    if (cs->profile)
+        wined3d_cs_profile_destroy(cs->profile);
     state_cleanup(&cs->state);
     heap_free(cs->data);
     heap_free(cs);
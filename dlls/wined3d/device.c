@@ -1277,6 +1277,24 @@ void CDECL wined3d_device_set_multithreaded(struct wined3d_device *device)
     device->create_parms.flags |= WINED3DCREATE_MULTITHREADED;
 }
 
+/* The maximum number of presents the application can queue before
+ * wined3d_swapchain_present() waits for the CS to catch up. */
+void CDECL wined3d_device_set_max_frame_latency(struct wined3d_device *device, unsigned int max_frame_latency)
+{
+    TRACE("device %p, max_frame_latency %u.\n", device, max_frame_latency);
+
+    if (!max_frame_latency)
+        max_frame_latency = 1;
+    device->max_frame_latency = max_frame_latency;
+}
+
+unsigned int CDECL wined3d_device_get_max_frame_latency(const struct wined3d_device *device)
+{
+    TRACE("device %p.\n", device);
+
+    return device->max_frame_latency;
+}
+
 UINT CDECL wined3d_device_get_available_texture_mem(const struct wined3d_device *device)
 {
     TRACE("device %p.\n", device);
@@ -1332,6 +1350,15 @@ struct wined3d_buffer * CDECL wined3d_device_get_stream_output(struct wined3d_de
     return device->state.stream_output[idx].buffer;
 }
 
+/* Called when a setter finds the new value already in device->state and
+ * doesn't emit a CS packet for it. The count is reported on the "fps"
+ * channel. */
+static void device_elide_state(struct wined3d_device *device)
+{
+    if (!device->recording)
+        InterlockedIncrement(&device->elided_state_count);
+}
+
 HRESULT CDECL wined3d_device_set_stream_source(struct wined3d_device *device, UINT stream_idx,
         struct wined3d_buffer *buffer, UINT offset, UINT stride)
 {
@@ -1363,6 +1390,7 @@ HRESULT CDECL wined3d_device_set_stream_source(struct wined3d_device *device, UI
             && stream->offset == offset)
     {
        TRACE("Application is setting the old values over, nothing to do.\n");
+       device_elide_state(device);
        return WINED3D_OK;
     }
 
@@ -1487,6 +1515,7 @@ void CDECL wined3d_device_set_transform(struct wined3d_device *device,
     if (!memcmp(&device->state.transforms[d3dts], matrix, sizeof(*matrix)))
     {
         TRACE("The application is setting the same matrix over again.\n");
+        device_elide_state(device);
         return;
     }
 
@@ -1754,6 +1783,7 @@ HRESULT CDECL wined3d_device_set_clip_plane(struct wined3d_device *device,
     if (!memcmp(&device->update_state->clip_planes[plane_idx], plane, sizeof(*plane)))
     {
         TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
         return WINED3D_OK;
     }
 
@@ -1850,7 +1880,10 @@ void CDECL wined3d_device_set_index_buffer(struct wined3d_device *device,
         device->recording->changed.indices = TRUE;
 
     if (prev_buffer == buffer && prev_format == format_id && prev_offset == offset)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (buffer)
         wined3d_buffer_incref(buffer);
@@ -1891,16 +1924,24 @@ void CDECL wined3d_device_set_viewport(struct wined3d_device *device, const stru
     TRACE("x %.8e, y %.8e, w %.8e, h %.8e, min_z %.8e, max_z %.8e.\n",
           viewport->x, viewport->y, viewport->width, viewport->height, viewport->min_z, viewport->max_z);
 
-    device->update_state->viewport = *viewport;
-
     /* Handle recording of state blocks */
     if (device->recording)
     {
         TRACE("Recording... not performing anything\n");
+        device->update_state->viewport = *viewport;
         device->recording->changed.viewport = TRUE;
         return;
     }
 
+    if (!memcmp(&device->state.viewport, viewport, sizeof(*viewport)))
+    {
+        TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
+        return;
+    }
+
+    device->state.viewport = *viewport;
+
     wined3d_cs_emit_set_viewport(device->cs, viewport);
 }
 
@@ -1938,7 +1979,10 @@ void CDECL wined3d_device_set_blend_state(struct wined3d_device *device, struct
 
     prev = device->update_state->blend_state;
     if (prev == blend_state)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (blend_state)
         wined3d_blend_state_incref(blend_state);
@@ -1964,7 +2008,10 @@ void CDECL wined3d_device_set_rasterizer_state(struct wined3d_device *device,
 
     prev = device->update_state->rasterizer_state;
     if (prev == rasterizer_state)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (rasterizer_state)
         wined3d_rasterizer_state_incref(rasterizer_state);
@@ -2007,7 +2054,10 @@ void CDECL wined3d_device_set_render_state(struct wined3d_device *device,
 
     /* Compared here and not before the assignment to allow proper stateblock recording. */
     if (value == old_value)
+    {
         TRACE("Application is setting the old value over, nothing to do.\n");
+        device_elide_state(device);
+    }
     else
         wined3d_cs_emit_set_render_state(device->cs, state, value);
 
@@ -2056,6 +2106,7 @@ void CDECL wined3d_device_set_sampler_state(struct wined3d_device *device,
     if (old_value == value)
     {
         TRACE("Application is setting the old value over, nothing to do.\n");
+        device_elide_state(device);
         return;
     }
 
@@ -2090,6 +2141,7 @@ void CDECL wined3d_device_set_scissor_rect(struct wined3d_device *device, const
     if (EqualRect(&device->update_state->scissor_rect, rect))
     {
         TRACE("App is setting the old scissor rectangle over, nothing to do.\n");
+        device_elide_state(device);
         return;
     }
     CopyRect(&device->update_state->scissor_rect, rect);
@@ -2122,7 +2174,10 @@ void CDECL wined3d_device_set_vertex_declaration(struct wined3d_device *device,
         device->recording->changed.vertexDecl = TRUE;
 
     if (declaration == prev)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (declaration)
         wined3d_vertex_declaration_incref(declaration);
@@ -2150,7 +2205,10 @@ void CDECL wined3d_device_set_vertex_shader(struct wined3d_device *device, struc
         device->recording->changed.vertexShader = TRUE;
 
     if (shader == prev)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (shader)
         wined3d_shader_incref(shader);
@@ -2181,7 +2239,10 @@ static void wined3d_device_set_constant_buffer(struct wined3d_device *device,
 
     prev = device->update_state->cb[type][idx];
     if (buffer == prev)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (buffer)
         wined3d_buffer_incref(buffer);
@@ -2231,7 +2292,10 @@ static void wined3d_device_set_shader_resource_view(struct wined3d_device *devic
 
     prev = device->update_state->shader_resource_view[type][idx];
     if (view == prev)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (view)
         wined3d_shader_resource_view_incref(view);
@@ -2283,7 +2347,10 @@ static void wined3d_device_set_sampler(struct wined3d_device *device,
 
     prev = device->update_state->sampler[type][idx];
     if (sampler == prev)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (sampler)
         wined3d_sampler_incref(sampler);
@@ -2333,6 +2400,13 @@ HRESULT CDECL wined3d_device_set_vs_consts_b(struct wined3d_device *device,
 
     if (count > WINED3D_MAX_CONSTS_B - start_idx)
         count = WINED3D_MAX_CONSTS_B - start_idx;
+    if (!device->recording && !memcmp(&device->state.vs_consts_b[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
+        return WINED3D_OK;
+    }
+
     memcpy(&device->update_state->vs_consts_b[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2382,6 +2456,13 @@ HRESULT CDECL wined3d_device_set_vs_consts_i(struct wined3d_device *device,
 
     if (count > WINED3D_MAX_CONSTS_I - start_idx)
         count = WINED3D_MAX_CONSTS_I - start_idx;
+    if (!device->recording && !memcmp(&device->state.vs_consts_i[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
+        return WINED3D_OK;
+    }
+
     memcpy(&device->update_state->vs_consts_i[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2430,6 +2511,13 @@ HRESULT CDECL wined3d_device_set_vs_consts_f(struct wined3d_device *device,
             || count > d3d_info->limits.vs_uniform_count - start_idx)
         return WINED3DERR_INVALIDCALL;
 
+    if (!device->recording && !memcmp(&device->state.vs_consts_f[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
+        return WINED3D_OK;
+    }
+
     memcpy(&device->update_state->vs_consts_f[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2473,7 +2561,10 @@ void CDECL wined3d_device_set_pixel_shader(struct wined3d_device *device, struct
         device->recording->changed.pixelShader = TRUE;
 
     if (shader == prev)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (shader)
         wined3d_shader_incref(shader);
@@ -2548,6 +2639,13 @@ HRESULT CDECL wined3d_device_set_ps_consts_b(struct wined3d_device *device,
 
     if (count > WINED3D_MAX_CONSTS_B - start_idx)
         count = WINED3D_MAX_CONSTS_B - start_idx;
+    if (!device->recording && !memcmp(&device->state.ps_consts_b[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
+        return WINED3D_OK;
+    }
+
     memcpy(&device->update_state->ps_consts_b[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2597,6 +2695,13 @@ HRESULT CDECL wined3d_device_set_ps_consts_i(struct wined3d_device *device,
 
     if (count > WINED3D_MAX_CONSTS_I - start_idx)
         count = WINED3D_MAX_CONSTS_I - start_idx;
+    if (!device->recording && !memcmp(&device->state.ps_consts_i[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
+        return WINED3D_OK;
+    }
+
     memcpy(&device->update_state->ps_consts_i[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2646,6 +2751,13 @@ HRESULT CDECL wined3d_device_set_ps_consts_f(struct wined3d_device *device,
             || count > d3d_info->limits.ps_uniform_count - start_idx)
         return WINED3DERR_INVALIDCALL;
 
+    if (!device->recording && !memcmp(&device->state.ps_consts_f[start_idx], constants, count * sizeof(*constants)))
+    {
+        TRACE("Application is setting old values over, nothing to do.\n");
+        device_elide_state(device);
+        return WINED3D_OK;
+    }
+
     memcpy(&device->update_state->ps_consts_f[start_idx], constants, count * sizeof(*constants));
     if (TRACE_ON(d3d))
     {
@@ -2687,7 +2799,10 @@ void CDECL wined3d_device_set_hull_shader(struct wined3d_device *device, struct
 
     prev = device->update_state->shader[WINED3D_SHADER_TYPE_HULL];
     if (shader == prev)
+    {
+        device_elide_state(device);
         return;
+    }
     if (shader)
         wined3d_shader_incref(shader);
     device->update_state->shader[WINED3D_SHADER_TYPE_HULL] = shader;
@@ -2756,7 +2871,10 @@ void CDECL wined3d_device_set_domain_shader(struct wined3d_device *device, struc
 
     prev = device->update_state->shader[WINED3D_SHADER_TYPE_DOMAIN];
     if (shader == prev)
+    {
+        device_elide_state(device);
         return;
+    }
     if (shader)
         wined3d_shader_incref(shader);
     device->update_state->shader[WINED3D_SHADER_TYPE_DOMAIN] = shader;
@@ -2824,7 +2942,10 @@ void CDECL wined3d_device_set_geometry_shader(struct wined3d_device *device, str
     TRACE("device %p, shader %p.\n", device, shader);
 
     if (device->recording || shader == prev)
+    {
+        device_elide_state(device);
         return;
+    }
     if (shader)
         wined3d_shader_incref(shader);
     device->update_state->shader[WINED3D_SHADER_TYPE_GEOMETRY] = shader;
@@ -2892,7 +3013,10 @@ void CDECL wined3d_device_set_compute_shader(struct wined3d_device *device, stru
 
     prev = device->update_state->shader[WINED3D_SHADER_TYPE_COMPUTE];
     if (device->recording || shader == prev)
+    {
+        device_elide_state(device);
         return;
+    }
     if (shader)
         wined3d_shader_incref(shader);
     device->update_state->shader[WINED3D_SHADER_TYPE_COMPUTE] = shader;
@@ -2967,7 +3091,10 @@ static void wined3d_device_set_pipeline_unordered_access_view(struct wined3d_dev
 
     prev = device->update_state->unordered_access_view[pipeline][idx];
     if (uav == prev && initial_count == ~0u)
+    {
+        device_elide_state(device);
         return;
+    }
 
     if (uav)
         wined3d_unordered_access_view_incref(uav);
@@ -3395,6 +3522,7 @@ void CDECL wined3d_device_set_texture_stage_state(struct wined3d_device *device,
     if (old_value == value)
     {
         TRACE("Application is setting the old value over, nothing to do.\n");
+        device_elide_state(device);
         return;
     }
 
@@ -3448,6 +3576,7 @@ HRESULT CDECL wined3d_device_set_texture(struct wined3d_device *device,
     if (texture == prev)
     {
         TRACE("App is setting the same texture again, nothing to do.\n");
+        device_elide_state(device);
         return WINED3D_OK;
     }
 
@@ -4450,7 +4579,10 @@ HRESULT CDECL wined3d_device_set_rendertarget_view(struct wined3d_device *device
 
     prev = device->fb.render_targets[view_idx];
     if (view == prev)
+    {
+        device_elide_state(device);
         return WINED3D_OK;
+    }
 
     if (view)
         wined3d_rendertarget_view_incref(view);
@@ -4474,6 +4606,7 @@ void CDECL wined3d_device_set_depth_stencil_view(struct wined3d_device *device,
     if (prev == view)
     {
         TRACE("Trying to do a NOP SetRenderTarget operation.\n");
+        device_elide_state(device);
         return;
     }
 
@@ -4693,6 +4826,64 @@ BOOL CDECL wined3d_device_show_cursor(struct wined3d_device *device, BOOL show)
     return oldVisible;
 }
 
+static int wined3d_resource_last_use_compare(const void *a, const void *b)
+{
+    const struct wined3d_resource *r1 = *(const struct wined3d_resource * const *)a;
+    const struct wined3d_resource *r2 = *(const struct wined3d_resource * const *)b;
+
+    return (r1->last_use > r2->last_use) - (r1->last_use < r2->last_use);
+}
+
+static BOOL wined3d_resource_is_evictable(const struct wined3d_resource *resource, unsigned int frame)
+{
+    return resource->type != WINED3D_RTYPE_BUFFER && resource->resident
+            && wined3d_resource_access_is_managed(resource->access) && !resource->map_count
+            && frame - resource->last_use > 2;
+}
+
+/* When the textures loaded by all devices on the adapter exceed the video
+ * memory budget, unload the least recently used managed textures of this
+ * device. The CS thread may be a frame behind, so textures used in the last
+ * couple of frames are left alone. */
+void device_manage_residency(struct wined3d_device *device)
+{
+    UINT64 budget = (UINT64)wined3d_settings.vram_budget << 20, resident;
+    struct wined3d_resource **resources, *resource;
+    unsigned int count = 0, frame, i;
+
+    if (!budget || (resident = adapter_get_resident_memory(device->adapter)) <= budget)
+        return;
+
+    frame = *(volatile unsigned int *)&device->cs->present_count;
+    LIST_FOR_EACH_ENTRY(resource, &device->resources, struct wined3d_resource, resource_list_entry)
+    {
+        if (wined3d_resource_is_evictable(resource, frame))
+            ++count;
+    }
+    if (!count || !(resources = heap_calloc(count, sizeof(*resources))))
+        return;
+
+    i = 0;
+    LIST_FOR_EACH_ENTRY(resource, &device->resources, struct wined3d_resource, resource_list_entry)
+    {
+        if (i < count && wined3d_resource_is_evictable(resource, frame))
+            resources[i++] = resource;
+    }
+    count = i;
+    qsort(resources, count, sizeof(*resources), wined3d_resource_last_use_compare);
+
+    TRACE("%s bytes resident, budget %s bytes, %u candidates.\n",
+            wine_dbgstr_longlong(resident), wine_dbgstr_longlong(budget), count);
+    for (i = 0; i < count && resident > budget; ++i)
+    {
+        TRACE("Evicting %p, last used in frame %u.\n", resources[i], resources[i]->last_use);
+        wined3d_cs_emit_unload_resource(device->cs, resources[i]);
+        resident -= min(resident, resources[i]->size);
+    }
+
+    heap_free(resources);
+}
+
 void CDECL wined3d_device_evict_managed_resources(struct wined3d_device *device)
 {
     struct wined3d_resource *resource, *cursor;
@@ -5158,6 +5349,7 @@ HRESULT device_init(struct wined3d_device *device, struct wined3d *wined3d,
     device->create_parms.device_type = device_type;
     device->create_parms.focus_window = focus_window;
     device->create_parms.flags = flags;
+    device->max_frame_latency = 1;
 
     device->shader_backend = adapter->shader_backend;
 
@@ -5205,9 +5397,6 @@ err:
 void device_invalidate_state(const struct wined3d_device *device, DWORD state)
 {
     DWORD rep = device->StateTable[state].representative;
-    struct wined3d_context *context;
-    DWORD idx;
-    BYTE shift;
     UINT i;
 
     wined3d_from_cs(device->cs);
@@ -5220,15 +5409,7 @@ void device_invalidate_state(const struct wined3d_device *device, DWORD state)
     }
 
     for (i = 0; i < device->context_count; ++i)
-    {
-        context = device->contexts[i];
-        if(isStateDirty(context, rep)) continue;
-
-        context->dirtyArray[context->numDirtyEntries++] = rep;
-        idx = rep / (sizeof(*context->isStateDirty) * CHAR_BIT);
-        shift = rep & ((sizeof(*context->isStateDirty) * CHAR_BIT) - 1);
-        context->isStateDirty[idx] |= (1u << shift);
-    }
+        context_set_state_dirty(device->contexts[i], rep);
 }
 
 LRESULT device_process_message(struct wined3d_device *device, HWND window, BOOL unicode,
@@ -111,6 +111,7 @@ static const struct wined3d_extension_map gl_extension_map[] =
     /* ARB */
     {"GL_ARB_base_instance",                ARB_BASE_INSTANCE             },
     {"GL_ARB_blend_func_extended",          ARB_BLEND_FUNC_EXTENDED       },
+    {"GL_ARB_buffer_storage",               ARB_BUFFER_STORAGE            },
     {"GL_ARB_clear_buffer_object",          ARB_CLEAR_BUFFER_OBJECT       },
     {"GL_ARB_clear_texture",                ARB_CLEAR_TEXTURE             },
     {"GL_ARB_clip_control",                 ARB_CLIP_CONTROL              },
@@ -139,6 +140,7 @@ static const struct wined3d_extension_map gl_extension_map[] =
     {"GL_ARB_framebuffer_object",           ARB_FRAMEBUFFER_OBJECT        },
     {"GL_ARB_framebuffer_sRGB",             ARB_FRAMEBUFFER_SRGB          },
     {"GL_ARB_geometry_shader4",             ARB_GEOMETRY_SHADER4          },
+    {"GL_ARB_get_program_binary",           ARB_GET_PROGRAM_BINARY        },
     {"GL_ARB_gpu_shader5",                  ARB_GPU_SHADER5               },
     {"GL_ARB_half_float_pixel",             ARB_HALF_FLOAT_PIXEL          },
     {"GL_ARB_half_float_vertex",            ARB_HALF_FLOAT_VERTEX         },
@@ -150,6 +152,7 @@ static const struct wined3d_extension_map gl_extension_map[] =
     {"GL_ARB_multisample",                  ARB_MULTISAMPLE               },
     {"GL_ARB_multitexture",                 ARB_MULTITEXTURE              },
     {"GL_ARB_occlusion_query",              ARB_OCCLUSION_QUERY           },
+    {"GL_ARB_parallel_shader_compile",      ARB_PARALLEL_SHADER_COMPILE   },
     {"GL_ARB_pipeline_statistics_query",    ARB_PIPELINE_STATISTICS_QUERY },
     {"GL_ARB_pixel_buffer_object",          ARB_PIXEL_BUFFER_OBJECT       },
     {"GL_ARB_point_parameters",             ARB_POINT_PARAMETERS          },
@@ -251,6 +254,9 @@ static const struct wined3d_extension_map gl_extension_map[] =
     {"GL_EXT_texture_sRGB_decode",          EXT_TEXTURE_SRGB_DECODE       },
     {"GL_EXT_vertex_array_bgra",            EXT_VERTEX_ARRAY_BGRA         },
 
+    /* KHR */
+    {"GL_KHR_parallel_shader_compile",      KHR_PARALLEL_SHADER_COMPILE   },
+
     /* NV */
     {"GL_NV_fence",                         NV_FENCE                      },
     {"GL_NV_fog_distance",                  NV_FOG_DISTANCE               },
@@ -444,6 +450,23 @@ UINT64 adapter_adjust_memory(struct wined3d_adapter *adapter, INT64 amount)
     return adapter->vram_bytes_used;
 }
 
+/* Adjust the amount of memory used by textures that are currently loaded into
+ * GL. This is called from the CS threads of all devices on the adapter. */
+void adapter_adjust_resident_memory(struct wined3d_adapter *adapter, INT64 amount)
+{
+    LONGLONG old;
+
+    do
+    {
+        old = adapter->vram_bytes_resident;
+    } while (InterlockedCompareExchange64(&adapter->vram_bytes_resident, old + amount, old) != old);
+}
+
+UINT64 adapter_get_resident_memory(struct wined3d_adapter *adapter)
+{
+    return InterlockedCompareExchange64(&adapter->vram_bytes_resident, 0, 0);
+}
+
 static void wined3d_adapter_cleanup(struct wined3d_adapter *adapter)
 {
     heap_free(adapter->gl_info.formats);
@@ -2697,6 +2720,8 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     /* GL_ARB_blend_func_extended */
     USE_GL_FUNC(glBindFragDataLocationIndexed)
     USE_GL_FUNC(glGetFragDataIndex)
+    /* GL_ARB_buffer_storage */
+    USE_GL_FUNC(glBufferStorage)
     /* GL_ARB_clear_buffer_object */
     USE_GL_FUNC(glClearBufferData)
     USE_GL_FUNC(glClearBufferSubData)
@@ -2767,6 +2792,10 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     USE_GL_FUNC(glFramebufferTextureFaceARB)
     USE_GL_FUNC(glFramebufferTextureLayerARB)
     USE_GL_FUNC(glProgramParameteriARB)
+    /* GL_ARB_get_program_binary */
+    USE_GL_FUNC(glGetProgramBinary)
+    USE_GL_FUNC(glProgramBinary)
+    USE_GL_FUNC(glProgramParameteri)
     /* GL_ARB_instanced_arrays */
     USE_GL_FUNC(glVertexAttribDivisorARB)
     /* GL_ARB_internalformat_query */
@@ -2800,6 +2829,8 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     USE_GL_FUNC(glGetQueryObjectivARB)
     USE_GL_FUNC(glGetQueryObjectuivARB)
     USE_GL_FUNC(glIsQueryARB)
+    /* GL_ARB_parallel_shader_compile */
+    USE_GL_FUNC(glMaxShaderCompilerThreadsARB)
     /* GL_ARB_point_parameters */
     USE_GL_FUNC(glPointParameterfARB)
     USE_GL_FUNC(glPointParameterfvARB)
@@ -3131,6 +3162,8 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     USE_GL_FUNC(glTexImage3DEXT)
     USE_GL_FUNC(glTexSubImage3D)
     USE_GL_FUNC(glTexSubImage3DEXT)
+    /* GL_KHR_parallel_shader_compile */
+    USE_GL_FUNC(glMaxShaderCompilerThreadsKHR)
     /* GL_NV_fence */
     USE_GL_FUNC(glDeleteFencesNV)
     USE_GL_FUNC(glFinishFenceNV)
@@ -3278,6 +3311,7 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     USE_GL_FUNC(glIsEnabledi)                                  /* OpenGL 3.0 */
     USE_GL_FUNC(glLinkProgram)                                 /* OpenGL 2.0 */
     USE_GL_FUNC(glMapBuffer)                                   /* OpenGL 1.5 */
+    USE_GL_FUNC(glMultiDrawArrays)                             /* OpenGL 1.4 */
     USE_GL_FUNC(glPointParameteri)                             /* OpenGL 1.4 */
     USE_GL_FUNC(glPointParameteriv)                            /* OpenGL 1.4 */
     USE_GL_FUNC(glShaderSource)                                /* OpenGL 2.0 */
@@ -3737,7 +3771,11 @@ static void wined3d_adapter_init_limits(struct wined3d_gl_info *gl_info)
         gl_info->gl_ops.gl.p_glGetIntegerv(GL_MAX_COMBINED_UNIFORM_BLOCKS, &gl_max);
         TRACE("Max combined uniform blocks: %d.\n", gl_max);
         gl_info->gl_ops.gl.p_glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &gl_max);
+        gl_info->limits.uniform_buffer_bindings = gl_max;
         TRACE("Max uniform buffer bindings: %d.\n", gl_max);
+        gl_info->gl_ops.gl.p_glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &gl_max);
+        gl_info->limits.uniform_buffer_offset_alignment = gl_max;
+        TRACE("Uniform buffer offset alignment: %d.\n", gl_max);
     }
     if (gl_info->supported[ARB_TEXTURE_BUFFER_RANGE])
     {
@@ -3915,6 +3953,7 @@ static BOOL wined3d_adapter_init_gl_caps(struct wined3d_adapter *adapter,
         {ARB_TRANSFORM_FEEDBACK3,          MAKEDWORD_VERSION(4, 0)},
 
         {ARB_ES2_COMPATIBILITY,            MAKEDWORD_VERSION(4, 1)},
+        {ARB_GET_PROGRAM_BINARY,           MAKEDWORD_VERSION(4, 1)},
         {ARB_VIEWPORT_ARRAY,               MAKEDWORD_VERSION(4, 1)},
 
         {ARB_BASE_INSTANCE,                MAKEDWORD_VERSION(4, 2)},
@@ -3944,6 +3983,7 @@ static BOOL wined3d_adapter_init_gl_caps(struct wined3d_adapter *adapter,
         {ARB_TEXTURE_STORAGE_MULTISAMPLE,  MAKEDWORD_VERSION(4, 2)},
         {ARB_TEXTURE_VIEW,                 MAKEDWORD_VERSION(4, 3)},
 
+        {ARB_BUFFER_STORAGE,               MAKEDWORD_VERSION(4, 4)},
         {ARB_CLEAR_TEXTURE,                MAKEDWORD_VERSION(4, 4)},
 
         {ARB_CLIP_CONTROL,                 MAKEDWORD_VERSION(4, 5)},
@@ -4905,6 +4945,25 @@ HRESULT CDECL wined3d_set_adapter_display_mode(struct wined3d *wined3d,
     return WINED3D_OK;
 }
 
+HRESULT CDECL wined3d_get_adapter_memory_info(const struct wined3d *wined3d,
+        UINT adapter_idx, UINT64 *budget, UINT64 *usage)
+{
+    struct wined3d_adapter *adapter;
+
+    TRACE("wined3d %p, adapter_idx %u, budget %p, usage %p.\n", wined3d, adapter_idx, budget, usage);
+
+    if (adapter_idx >= wined3d->adapter_count)
+        return WINED3DERR_INVALIDCALL;
+
+    adapter = (struct wined3d_adapter *)&wined3d->adapters[adapter_idx];
+    *budget = adapter->vram_bytes;
+    if (wined3d_settings.vram_budget)
+        *budget = min(*budget, (UINT64)wined3d_settings.vram_budget << 20);
+    *usage = adapter_get_resident_memory(adapter);
+
+    return WINED3D_OK;
+}
+
 /* NOTE: due to structure differences between dx8 and dx9 D3DADAPTER_IDENTIFIER,
    and fields being inserted in the middle, a new structure is used in place    */
 HRESULT CDECL wined3d_get_adapter_identifier(const struct wined3d *wined3d,
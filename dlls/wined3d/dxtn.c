@@ -0,0 +1,536 @@
+/*
+ * Software BC1-BC5 (DXTn / RGTC) compression and decompression
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+#include "wined3d_private.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+
+/* Images with at least this many blocks are split across the thread pool. */
+#define WINED3D_DXTN_THREAD_BLOCK_COUNT (128 * 128)
+#define WINED3D_DXTN_MAX_THREADS        8
+
+enum wined3d_dxtn_type
+{
+    WINED3D_DXTN_BC1,
+    WINED3D_DXTN_BC2,
+    WINED3D_DXTN_BC3,
+    WINED3D_DXTN_BC4,
+    WINED3D_DXTN_BC5,
+};
+
+struct wined3d_dxtn_job
+{
+    enum wined3d_dxtn_type type;
+    BOOL encode;
+    const BYTE *src;
+    BYTE *dst;
+    unsigned int src_row_pitch, src_slice_pitch;
+    unsigned int dst_row_pitch, dst_slice_pitch;
+    unsigned int width, height;
+    /* Rows of blocks per slice. */
+    unsigned int row_count;
+};
+
+struct wined3d_dxtn_task
+{
+    const struct wined3d_dxtn_job *job;
+    unsigned int start, end;
+    LONG *pending;
+    HANDLE event;
+};
+
+/* Texels are stored as B8G8R8A8_UNORM, i.e. 0xAARRGGBB. */
+static inline DWORD dxtn_expand_565(WORD c)
+{
+    DWORD r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+
+    return 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+/* Computes (a * wa + b * wb) / div for the three colour channels at once.
+ * Each channel gets 16 bits of headroom, which is plenty for weights up
+ * to 3. */
+static inline DWORD dxtn_lerp_rgb(DWORD a, DWORD b, unsigned int wa, unsigned int wb, unsigned int div)
+{
+    UINT64 ea = (a & 0xff) | ((UINT64)(a & 0xff00) << 8) | ((UINT64)(a & 0xff0000) << 16);
+    UINT64 eb = (b & 0xff) | ((UINT64)(b & 0xff00) << 8) | ((UINT64)(b & 0xff0000) << 16);
+    UINT64 sum = ea * wa + eb * wb;
+
+    return 0xff000000 | ((sum & 0xffff) / div)
+            | ((((sum >> 16) & 0xffff) / div) << 8)
+            | ((((sum >> 32) & 0xffff) / div) << 16);
+}
+
+static void dxtn_colour_palette(const BYTE *block, BOOL allow_3_colour, DWORD palette[4])
+{
+    WORD c0 = block[0] | (block[1] << 8);
+    WORD c1 = block[2] | (block[3] << 8);
+
+    palette[0] = dxtn_expand_565(c0);
+    palette[1] = dxtn_expand_565(c1);
+    if (c0 > c1 || !allow_3_colour)
+    {
+        palette[2] = dxtn_lerp_rgb(palette[0], palette[1], 2, 1, 3);
+        palette[3] = dxtn_lerp_rgb(palette[0], palette[1], 1, 2, 3);
+    }
+    else
+    {
+        palette[2] = dxtn_lerp_rgb(palette[0], palette[1], 1, 1, 2);
+        palette[3] = 0x00000000;
+    }
+}
+
+static void dxtn_alpha_palette(const BYTE *block, BYTE palette[8])
+{
+    unsigned int a0 = block[0], a1 = block[1], i;
+
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1)
+    {
+        for (i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    }
+    else
+    {
+        for (i = 1; i < 5; ++i)
+            palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        palette[6] = 0x00;
+        palette[7] = 0xff;
+    }
+}
+
+static inline UINT64 dxtn_alpha_indices(const BYTE *block)
+{
+    return block[2] | ((UINT64)block[3] << 8) | ((UINT64)block[4] << 16)
+            | ((UINT64)block[5] << 24) | ((UINT64)block[6] << 32) | ((UINT64)block[7] << 40);
+}
+
+/* Decodes a single block into a 4x4 array of texels. */
+static void dxtn_decode_block(enum wined3d_dxtn_type type, const BYTE *block, DWORD texels[16])
+{
+    DWORD colours[4];
+    BYTE alphas[8];
+    UINT64 bits;
+    DWORD idx;
+    unsigned int i;
+
+    switch (type)
+    {
+        case WINED3D_DXTN_BC1:
+            dxtn_colour_palette(block, TRUE, colours);
+            idx = block[4] | (block[5] << 8) | (block[6] << 16) | ((DWORD)block[7] << 24);
+            for (i = 0; i < 16; ++i, idx >>= 2)
+                texels[i] = colours[idx & 3];
+            break;
+
+        case WINED3D_DXTN_BC2:
+            dxtn_colour_palette(block + 8, FALSE, colours);
+            idx = block[12] | (block[13] << 8) | (block[14] << 16) | ((DWORD)block[15] << 24);
+            for (i = 0; i < 16; ++i, idx >>= 2)
+            {
+                DWORD a = (block[i / 2] >> ((i & 1) * 4)) & 0xf;
+                texels[i] = (colours[idx & 3] & 0x00ffffff) | ((a * 0x11) << 24);
+            }
+            break;
+
+        case WINED3D_DXTN_BC3:
+            dxtn_alpha_palette(block, alphas);
+            bits = dxtn_alpha_indices(block);
+            dxtn_colour_palette(block + 8, FALSE, colours);
+            idx = block[12] | (block[13] << 8) | (block[14] << 16) | ((DWORD)block[15] << 24);
+            for (i = 0; i < 16; ++i, idx >>= 2, bits >>= 3)
+                texels[i] = (colours[idx & 3] & 0x00ffffff) | ((DWORD)alphas[bits & 7] << 24);
+            break;
+
+        case WINED3D_DXTN_BC4:
+            dxtn_alpha_palette(block, alphas);
+            bits = dxtn_alpha_indices(block);
+            for (i = 0; i < 16; ++i, bits >>= 3)
+                texels[i] = 0xff000000 | ((DWORD)alphas[bits & 7] << 16);
+            break;
+
+        case WINED3D_DXTN_BC5:
+            dxtn_alpha_palette(block, alphas);
+            bits = dxtn_alpha_indices(block);
+            for (i = 0; i < 16; ++i, bits >>= 3)
+                texels[i] = 0xff000000 | ((DWORD)alphas[bits & 7] << 16);
+            dxtn_alpha_palette(block + 8, alphas);
+            bits = dxtn_alpha_indices(block + 8);
+            for (i = 0; i < 16; ++i, bits >>= 3)
+                texels[i] |= (DWORD)alphas[bits & 7] << 8;
+            break;
+    }
+}
+
+static inline WORD dxtn_pack_565(DWORD c)
+{
+    return ((c >> 8) & 0xf800) | ((c >> 5) & 0x07e0) | ((c >> 3) & 0x001f);
+}
+
+static inline unsigned int dxtn_colour_distance(DWORD a, DWORD b)
+{
+    int dr = (int)((a >> 16) & 0xff) - (int)((b >> 16) & 0xff);
+    int dg = (int)((a >> 8) & 0xff) - (int)((b >> 8) & 0xff);
+    int db = (int)(a & 0xff) - (int)(b & 0xff);
+
+    return dr * dr + dg * dg + db * db;
+}
+
+/* Bounding box encoder, in the spirit of the well known "real-time DXT
+ * compression" approach. The box is inset slightly to reduce the error
+ * introduced by outliers. */
+static void dxtn_encode_colour_block(const DWORD texels[16], BOOL allow_3_colour, BYTE *block)
+{
+    unsigned int min[3] = {0xff, 0xff, 0xff}, max[3] = {0, 0, 0};
+    unsigned int i, j, c, best, distance, best_distance;
+    BOOL transparent = FALSE;
+    DWORD palette[4], lo, hi;
+    WORD c0, c1, tmp;
+    DWORD idx = 0;
+
+    for (i = 0; i < 16; ++i)
+    {
+        if (allow_3_colour && texels[i] >> 24 < 0x80)
+        {
+            transparent = TRUE;
+            continue;
+        }
+        for (c = 0; c < 3; ++c)
+        {
+            unsigned int v = (texels[i] >> (c * 8)) & 0xff;
+            if (v < min[c]) min[c] = v;
+            if (v > max[c]) max[c] = v;
+        }
+    }
+
+    if (min[0] > max[0])
+    {
+        /* Fully transparent. */
+        memset(block, 0, 4);
+        memset(block + 4, 0xff, 4);
+        return;
+    }
+
+    for (c = 0; c < 3; ++c)
+    {
+        unsigned int inset = (max[c] - min[c]) >> 4;
+        min[c] += inset;
+        max[c] -= inset;
+    }
+    lo = (min[2] << 16) | (min[1] << 8) | min[0];
+    hi = (max[2] << 16) | (max[1] << 8) | max[0];
+    c0 = dxtn_pack_565(hi);
+    c1 = dxtn_pack_565(lo);
+
+    /* The 4 colour mode requires c0 > c1, the 3 colour mode c0 <= c1. */
+    if (transparent ? c0 > c1 : c0 < c1)
+    {
+        tmp = c0;
+        c0 = c1;
+        c1 = tmp;
+    }
+    else if (!transparent && c0 == c1)
+    {
+        block[0] = block[2] = c0 & 0xff;
+        block[1] = block[3] = c0 >> 8;
+        memset(block + 4, 0, 4);
+        return;
+    }
+
+    block[0] = c0 & 0xff;
+    block[1] = c0 >> 8;
+    block[2] = c1 & 0xff;
+    block[3] = c1 >> 8;
+    dxtn_colour_palette(block, allow_3_colour, palette);
+
+    for (i = 0; i < 16; ++i)
+    {
+        if (transparent && texels[i] >> 24 < 0x80)
+        {
+            idx |= 3u << (i * 2);
+            continue;
+        }
+
+        best = 0;
+        best_distance = ~0u;
+        for (j = 0; j < (transparent ? 3 : 4); ++j)
+        {
+            if ((distance = dxtn_colour_distance(texels[i], palette[j])) < best_distance)
+            {
+                best_distance = distance;
+                best = j;
+            }
+        }
+        idx |= best << (i * 2);
+    }
+
+    block[4] = idx & 0xff;
+    block[5] = (idx >> 8) & 0xff;
+    block[6] = (idx >> 16) & 0xff;
+    block[7] = idx >> 24;
+}
+
+static void dxtn_encode_alpha_block(const DWORD texels[16], unsigned int shift, BYTE *block)
+{
+    unsigned int min = 0xff, max = 0, i, j, best, distance, best_distance;
+    UINT64 bits = 0;
+    BYTE palette[8];
+
+    for (i = 0; i < 16; ++i)
+    {
+        unsigned int v = (texels[i] >> shift) & 0xff;
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+
+    block[0] = max;
+    block[1] = min;
+    if (max != min)
+    {
+        dxtn_alpha_palette(block, palette);
+        for (i = 0; i < 16; ++i)
+        {
+            unsigned int v = (texels[i] >> shift) & 0xff;
+
+            best = 0;
+            best_distance = ~0u;
+            for (j = 0; j < 8; ++j)
+            {
+                distance = abs((int)v - (int)palette[j]);
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best = j;
+                }
+            }
+            bits |= (UINT64)best << (i * 3);
+        }
+    }
+
+    for (i = 0; i < 6; ++i)
+        block[i + 2] = (bits >> (i * 8)) & 0xff;
+}
+
+static void dxtn_encode_block(enum wined3d_dxtn_type type, const DWORD texels[16], BYTE *block)
+{
+    unsigned int i;
+
+    switch (type)
+    {
+        case WINED3D_DXTN_BC1:
+            dxtn_encode_colour_block(texels, TRUE, block);
+            break;
+
+        case WINED3D_DXTN_BC2:
+            for (i = 0; i < 8; ++i)
+                block[i] = (texels[i * 2] >> 28) | ((texels[i * 2 + 1] >> 24) & 0xf0);
+            dxtn_encode_colour_block(texels, FALSE, block + 8);
+            break;
+
+        case WINED3D_DXTN_BC3:
+            dxtn_encode_alpha_block(texels, 24, block);
+            dxtn_encode_colour_block(texels, FALSE, block + 8);
+            break;
+
+        case WINED3D_DXTN_BC4:
+            dxtn_encode_alpha_block(texels, 16, block);
+            break;
+
+        case WINED3D_DXTN_BC5:
+            dxtn_encode_alpha_block(texels, 16, block);
+            dxtn_encode_alpha_block(texels, 8, block + 8);
+            break;
+    }
+}
+
+/* Processes the block rows [start, end), counted across all slices. */
+static void wined3d_dxtn_process_rows(const struct wined3d_dxtn_job *job, unsigned int start, unsigned int end)
+{
+    unsigned int block_size = job->type == WINED3D_DXTN_BC1 || job->type == WINED3D_DXTN_BC4 ? 8 : 16;
+    unsigned int row, slice, bx, by, x, y, w, h;
+    const BYTE *src_row;
+    BYTE *dst_row;
+    DWORD texels[16];
+
+    for (row = start; row < end; ++row)
+    {
+        slice = row / job->row_count;
+        by = row % job->row_count;
+        h = min(job->height - by * 4, 4);
+        src_row = job->src + slice * job->src_slice_pitch;
+        dst_row = job->dst + slice * job->dst_slice_pitch;
+
+        if (job->encode)
+        {
+            src_row += by * 4 * job->src_row_pitch;
+            dst_row += by * job->dst_row_pitch;
+        }
+        else
+        {
+            src_row += by * job->src_row_pitch;
+            dst_row += by * 4 * job->dst_row_pitch;
+        }
+
+        for (bx = 0; bx * 4 < job->width; ++bx)
+        {
+            w = min(job->width - bx * 4, 4);
+
+            if (job->encode)
+            {
+                /* Replicate the edge texels into the unused part of partial
+                 * blocks, so that they don't affect the endpoints. */
+                for (y = 0; y < 4; ++y)
+                {
+                    const DWORD *src = (const DWORD *)(src_row + min(y, h - 1) * job->src_row_pitch) + bx * 4;
+                    for (x = 0; x < 4; ++x)
+                        texels[y * 4 + x] = src[min(x, w - 1)];
+                }
+                dxtn_encode_block(job->type, texels, dst_row + bx * block_size);
+            }
+            else
+            {
+                dxtn_decode_block(job->type, src_row + bx * block_size, texels);
+                for (y = 0; y < h; ++y)
+                    memcpy((DWORD *)(dst_row + y * job->dst_row_pitch) + bx * 4,
+                            &texels[y * 4], w * sizeof(*texels));
+            }
+        }
+    }
+}
+
+static void CALLBACK wined3d_dxtn_task_cb(TP_CALLBACK_INSTANCE *instance, void *ctx)
+{
+    struct wined3d_dxtn_task *task = ctx;
+
+    wined3d_dxtn_process_rows(task->job, task->start, task->end);
+    if (!InterlockedDecrement(task->pending))
+        SetEvent(task->event);
+}
+
+static unsigned int wined3d_dxtn_get_thread_count(void)
+{
+    static unsigned int thread_count;
+    SYSTEM_INFO info;
+
+    if (!thread_count)
+    {
+        GetSystemInfo(&info);
+        thread_count = max(1, min(info.dwNumberOfProcessors, WINED3D_DXTN_MAX_THREADS));
+    }
+
+    return thread_count;
+}
+
+static void wined3d_dxtn_run(const struct wined3d_dxtn_job *job, unsigned int depth)
+{
+    struct wined3d_dxtn_task tasks[WINED3D_DXTN_MAX_THREADS];
+    unsigned int total = job->row_count * depth, thread_count, chunk, i;
+    unsigned int blocks_per_row = (job->width + 3) / 4;
+    HANDLE event;
+    LONG pending;
+
+    thread_count = wined3d_dxtn_get_thread_count();
+    if (thread_count < 2 || total < 2 || total * blocks_per_row < WINED3D_DXTN_THREAD_BLOCK_COUNT
+            || !(event = CreateEventW(NULL, TRUE, FALSE, NULL)))
+    {
+        wined3d_dxtn_process_rows(job, 0, total);
+        return;
+    }
+
+    thread_count = min(thread_count, total);
+    chunk = (total + thread_count - 1) / thread_count;
+    thread_count = (total + chunk - 1) / chunk;
+    pending = thread_count - 1;
+
+    TRACE("Splitting %u block rows across %u threads.\n", total, thread_count);
+
+    /* The calling thread takes the first chunk. */
+    for (i = 1; i < thread_count; ++i)
+    {
+        tasks[i].job = job;
+        tasks[i].start = i * chunk;
+        tasks[i].end = min(total, (i + 1) * chunk);
+        tasks[i].pending = &pending;
+        tasks[i].event = event;
+        if (!TrySubmitThreadpoolCallback(wined3d_dxtn_task_cb, &tasks[i], NULL))
+        {
+            WARN("Failed to submit thread pool callback.\n");
+            wined3d_dxtn_task_cb(NULL, &tasks[i]);
+        }
+    }
+    wined3d_dxtn_process_rows(job, 0, min(total, chunk));
+
+    WaitForSingleObject(event, INFINITE);
+    CloseHandle(event);
+}
+
+static void wined3d_dxtn_convert(enum wined3d_dxtn_type type, BOOL encode, const BYTE *src, BYTE *dst,
+        unsigned int src_row_pitch, unsigned int src_slice_pitch, unsigned int dst_row_pitch,
+        unsigned int dst_slice_pitch, unsigned int width, unsigned int height, unsigned int depth)
+{
+    struct wined3d_dxtn_job job;
+
+    if (!width || !height || !depth)
+        return;
+
+    job.type = type;
+    job.encode = encode;
+    job.src = src;
+    job.dst = dst;
+    job.src_row_pitch = src_row_pitch;
+    job.src_slice_pitch = src_slice_pitch;
+    job.dst_row_pitch = dst_row_pitch;
+    job.dst_slice_pitch = dst_slice_pitch;
+    job.width = width;
+    job.height = height;
+    job.row_count = (height + 3) / 4;
+
+    wined3d_dxtn_run(&job, depth);
+}
+
+#define WINED3D_DXTN_FUNCS(name, type) \
+void wined3d_##name##_decode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, \
+        unsigned int src_slice_pitch, unsigned int dst_row_pitch, unsigned int dst_slice_pitch, \
+        unsigned int width, unsigned int height, unsigned int depth) \
+{ \
+    wined3d_dxtn_convert(type, FALSE, src, dst, src_row_pitch, src_slice_pitch, \
+            dst_row_pitch, dst_slice_pitch, width, height, depth); \
+} \
+\
+void wined3d_##name##_encode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, \
+        unsigned int src_slice_pitch, unsigned int dst_row_pitch, unsigned int dst_slice_pitch, \
+        unsigned int width, unsigned int height, unsigned int depth) \
+{ \
+    wined3d_dxtn_convert(type, TRUE, src, dst, src_row_pitch, src_slice_pitch, \
+            dst_row_pitch, dst_slice_pitch, width, height, depth); \
+}
+
+WINED3D_DXTN_FUNCS(bc1, WINED3D_DXTN_BC1)
+WINED3D_DXTN_FUNCS(bc2, WINED3D_DXTN_BC2)
+WINED3D_DXTN_FUNCS(bc3, WINED3D_DXTN_BC3)
+WINED3D_DXTN_FUNCS(bc4, WINED3D_DXTN_BC4)
+WINED3D_DXTN_FUNCS(bc5, WINED3D_DXTN_BC5)
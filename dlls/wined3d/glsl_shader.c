@@ -34,6 +34,7 @@
 
 #include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #ifdef HAVE_FLOAT_H
 # include <float.h>
 #endif
@@ -125,12 +126,21 @@ struct shader_glsl_priv
     unsigned char *stack;
     UINT next_constant_version;
 
+    /* Float constants of shaders using shader_glsl_use_constant_ubo(),
+     * indexed by shader_glsl_constant_ubo_idx(). */
+    GLuint constant_ring_bo;
+    unsigned int constant_ring_offset;
+    unsigned int constant_ubo_offset[2];
+    BOOL constant_ubo_dirty[2];
+
     const struct wined3d_vertex_pipe_ops *vertex_pipe;
     const struct fragment_pipeline *fragment_pipe;
     struct wine_rb_tree ffp_vertex_shaders;
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
     BOOL legacy_lighting;
+    BOOL ffp_cache_loaded;
+    BOOL ffp_cache_loading;
 };
 
 struct glsl_vs_program
@@ -244,7 +254,12 @@ struct glsl_shader_prog_link
     unsigned int constant_version;
     DWORD shader_controlled_clip_distances : 1;
     DWORD clip_distance_mask : 8; /* MAX_CLIP_DISTANCES, 8 */
-    DWORD padding : 23;
+    DWORD link_pending : 1;
+    DWORD init_pending : 1;
+    DWORD cacheable : 1;
+    DWORD padding : 20;
+    /* Only valid while init_pending is set. */
+    struct wined3d_shader *shaders[WINED3D_SHADER_TYPE_GRAPHICS_COUNT];
 };
 
 struct glsl_program_key
@@ -270,6 +285,7 @@ struct glsl_context_data
     struct glsl_shader_prog_link *glsl_program;
     GLenum vertex_color_clamp;
     BOOL rasterization_disabled;
+    unsigned int constant_ubo_offset[2];
 };
 
 struct glsl_ps_compiled_shader
@@ -500,6 +516,18 @@ void print_glsl_info_log(const struct wined3d_gl_info *gl_info, GLuint id, BOOL
     }
 }
 
+static BOOL shader_glsl_use_parallel_compile(const struct wined3d_gl_info *gl_info)
+{
+    return wined3d_settings.async_shader_compile != WINED3D_ASYNC_SHADER_COMPILE_DISABLED
+            && (gl_info->supported[ARB_PARALLEL_SHADER_COMPILE] || gl_info->supported[KHR_PARALLEL_SHADER_COMPILE]);
+}
+
+static BOOL shader_glsl_skip_pending_programs(const struct wined3d_gl_info *gl_info)
+{
+    return wined3d_settings.async_shader_compile == WINED3D_ASYNC_SHADER_COMPILE_SKIP
+            && shader_glsl_use_parallel_compile(gl_info);
+}
+
 /* Context activation is done by the caller. */
 static void shader_glsl_compile(const struct wined3d_gl_info *gl_info, GLuint shader, const char *src)
 {
@@ -517,7 +545,10 @@ static void shader_glsl_compile(const struct wined3d_gl_info *gl_info, GLuint sh
     checkGLcall("glShaderSource");
     GL_EXTCALL(glCompileShader(shader));
     checkGLcall("glCompileShader");
-    print_glsl_info_log(gl_info, shader, FALSE);
+    /* Retrieving the info log would wait for the compiler threads. Errors
+     * still show up when the program is linked. */
+    if (!shader_glsl_use_parallel_compile(gl_info))
+        print_glsl_info_log(gl_info, shader, FALSE);
 }
 
 /* Context activation is done by the caller. */
@@ -590,6 +621,567 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+/* On-disk cache for linked GLSL programs. Programs are keyed by the hash
+ * of their attached shader sources and the GL implementation, and stored as
+ * one file per program. File times track the last use, and the least
+ * recently used programs are removed when the cache grows too large. */
+#define GLSL_PROGRAM_CACHE_MAGIC            MAKEFOURCC('W', 'G', 'P', 'C')
+#define GLSL_PROGRAM_CACHE_VERSION          1
+#define GLSL_PROGRAM_CACHE_MAX_BINARY_SIZE  (16 * 1024 * 1024)
+
+struct glsl_program_cache_key
+{
+    UINT64 hash[2];
+    DWORD source_size;
+};
+
+struct glsl_program_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    struct glsl_program_cache_key key;
+    GLenum binary_format;
+    DWORD binary_size;
+};
+
+struct glsl_program_cache_file
+{
+    FILETIME time;
+    DWORD size;
+    char name[MAX_PATH];
+};
+
+static struct
+{
+    BOOL initialised;
+    BOOL enabled;
+    char path[MAX_PATH];
+    ULONGLONG size;
+    ULONGLONG max_size;
+} glsl_program_cache;
+
+static CRITICAL_SECTION glsl_program_cache_cs;
+static CRITICAL_SECTION_DEBUG glsl_program_cache_cs_debug =
+{
+    0, 0, &glsl_program_cache_cs,
+    {&glsl_program_cache_cs_debug.ProcessLocksList,
+    &glsl_program_cache_cs_debug.ProcessLocksList},
+    0, 0, {(DWORD_PTR)(__FILE__ ": glsl_program_cache_cs")}
+};
+static CRITICAL_SECTION glsl_program_cache_cs = {&glsl_program_cache_cs_debug, -1, 0, 0, 0, 0};
+
+static void glsl_program_cache_hash(UINT64 *hash, const void *data, SIZE_T size)
+{
+    const BYTE *ptr = data;
+
+    while (size--)
+    {
+        hash[0] = (hash[0] ^ *ptr) * 0x100000001b3;
+        hash[1] = (hash[1] * 0x100000001b3) ^ *ptr++;
+    }
+}
+
+static void glsl_program_cache_hash_string(UINT64 *hash, const char *str)
+{
+    if (!str)
+        str = "";
+    glsl_program_cache_hash(hash, str, strlen(str) + 1);
+}
+
+static int glsl_program_cache_compare_hash(const void *a, const void *b)
+{
+    const UINT64 *h1 = a, *h2 = b;
+
+    if (h1[0] != h2[0])
+        return h1[0] < h2[0] ? -1 : 1;
+    if (h1[1] != h2[1])
+        return h1[1] < h2[1] ? -1 : 1;
+    return 0;
+}
+
+static int glsl_program_cache_compare_file(const void *a, const void *b)
+{
+    const struct glsl_program_cache_file *f1 = a, *f2 = b;
+
+    return CompareFileTime(&f1->time, &f2->time);
+}
+
+static void glsl_program_cache_get_filename(const struct glsl_program_cache_key *key,
+        const char *extension, char *name, SIZE_T size)
+{
+    snprintf(name, size, "%s\\%08x%08x%08x%08x%s", glsl_program_cache.path,
+            (unsigned int)(key->hash[0] >> 32), (unsigned int)key->hash[0],
+            (unsigned int)(key->hash[1] >> 32), (unsigned int)key->hash[1], extension);
+}
+
+/* Removes the least recently used programs until the cache is at three
+ * quarters of its maximum size. The cache lock should be held. */
+static void glsl_program_cache_prune(void)
+{
+    struct glsl_program_cache_file *files = NULL;
+    SIZE_T files_size = 0, file_count = 0, i;
+    ULONGLONG size = 0;
+    WIN32_FIND_DATAA data;
+    char pattern[MAX_PATH];
+    HANDLE find;
+
+    snprintf(pattern, sizeof(pattern), "%s\\*.bin", glsl_program_cache.path);
+    if ((find = FindFirstFileA(pattern, &data)) == INVALID_HANDLE_VALUE)
+    {
+        glsl_program_cache.size = 0;
+        return;
+    }
+
+    do
+    {
+        if (!wined3d_array_reserve((void **)&files, &files_size, file_count + 1, sizeof(*files)))
+        {
+            ERR("Failed to allocate file array memory.\n");
+            break;
+        }
+        files[file_count].time = data.ftLastWriteTime;
+        files[file_count].size = data.nFileSizeLow;
+        snprintf(files[file_count].name, sizeof(files[file_count].name), "%s\\%s",
+                glsl_program_cache.path, data.cFileName);
+        size += data.nFileSizeLow;
+        ++file_count;
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+
+    if (size > glsl_program_cache.max_size)
+    {
+        qsort(files, file_count, sizeof(*files), glsl_program_cache_compare_file);
+        for (i = 0; i < file_count && size > glsl_program_cache.max_size / 4 * 3; ++i)
+        {
+            TRACE("Removing %s from the program cache.\n", debugstr_a(files[i].name));
+            if (DeleteFileA(files[i].name))
+                size -= files[i].size;
+        }
+    }
+
+    glsl_program_cache.size = size;
+    heap_free(files);
+}
+
+/* Context activation is done by the caller. The cache lock should be held. */
+static BOOL glsl_program_cache_init(const struct wined3d_gl_info *gl_info)
+{
+    GLint format_count = 0;
+    DWORD len;
+
+    if (glsl_program_cache.initialised)
+        return glsl_program_cache.enabled;
+    glsl_program_cache.initialised = TRUE;
+
+    if (!wined3d_settings.shader_cache || !gl_info->supported[ARB_GET_PROGRAM_BINARY])
+        return FALSE;
+
+    gl_info->gl_ops.gl.p_glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    checkGLcall("glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS)");
+    if (!format_count)
+    {
+        WARN("No program binary formats supported, disabling the program cache.\n");
+        return FALSE;
+    }
+
+    if (wined3d_settings.shader_cache_path)
+    {
+        len = ExpandEnvironmentStringsA(wined3d_settings.shader_cache_path,
+                glsl_program_cache.path, sizeof(glsl_program_cache.path));
+    }
+    else
+    {
+        len = ExpandEnvironmentStringsA("%LOCALAPPDATA%\\wined3d_shader_cache",
+                glsl_program_cache.path, sizeof(glsl_program_cache.path));
+        if (len && strchr(glsl_program_cache.path, '%'))
+        {
+            len = GetTempPathA(sizeof(glsl_program_cache.path), glsl_program_cache.path);
+            if (len && len + strlen("wined3d_shader_cache") < sizeof(glsl_program_cache.path))
+                strcat(glsl_program_cache.path, "wined3d_shader_cache");
+            else
+                len = 0;
+        }
+    }
+    if (!len || len > sizeof(glsl_program_cache.path))
+    {
+        WARN("Failed to get the program cache path.\n");
+        return FALSE;
+    }
+
+    if (!CreateDirectoryA(glsl_program_cache.path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        WARN("Failed to create program cache directory %s, error %u.\n",
+                debugstr_a(glsl_program_cache.path), GetLastError());
+        return FALSE;
+    }
+
+    glsl_program_cache.max_size = (ULONGLONG)wined3d_settings.shader_cache_size << 20;
+    glsl_program_cache_prune();
+
+    TRACE("Using program cache %s, size %s.\n", debugstr_a(glsl_program_cache.path),
+            wine_dbgstr_longlong(glsl_program_cache.size));
+
+    return glsl_program_cache.enabled = TRUE;
+}
+
+/* Context activation is done by the caller. */
+static BOOL glsl_program_cache_get_key(const struct wined3d_gl_info *gl_info,
+        GLuint program, struct glsl_program_cache_key *key)
+{
+    UINT64 shader_hashes[WINED3D_SHADER_TYPE_COUNT + 1][2];
+    GLint i, shader_count, length, source_size = 0;
+    GLuint shaders[ARRAY_SIZE(shader_hashes)];
+    char *source = NULL;
+    GLint type;
+
+    GL_EXTCALL(glGetAttachedShaders(program, ARRAY_SIZE(shaders), &shader_count, shaders));
+    checkGLcall("glGetAttachedShaders");
+
+    key->source_size = 0;
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length));
+        if (length > source_size)
+        {
+            heap_free(source);
+            if (!(source = heap_alloc(length)))
+            {
+                ERR("Failed to allocate %d bytes for shader source.\n", length);
+                return FALSE;
+            }
+            source_size = length;
+        }
+        GL_EXTCALL(glGetShaderSource(shaders[i], source_size, &length, source));
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type));
+
+        shader_hashes[i][0] = 0xcbf29ce484222325;
+        shader_hashes[i][1] = 0x84222325cbf29ce4;
+        glsl_program_cache_hash(shader_hashes[i], &type, sizeof(type));
+        glsl_program_cache_hash(shader_hashes[i], source, length);
+        key->source_size += length;
+    }
+    checkGLcall("get shader sources");
+    heap_free(source);
+
+    /* The order in which shaders are attached doesn't matter. */
+    qsort(shader_hashes, shader_count, sizeof(*shader_hashes), glsl_program_cache_compare_hash);
+
+    key->hash[0] = 0xcbf29ce484222325;
+    key->hash[1] = 0x84222325cbf29ce4;
+    glsl_program_cache_hash_string(key->hash, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_VENDOR));
+    glsl_program_cache_hash_string(key->hash, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_RENDERER));
+    glsl_program_cache_hash_string(key->hash, (const char *)gl_info->gl_ops.gl.p_glGetString(GL_VERSION));
+    glsl_program_cache_hash(key->hash, shader_hashes, shader_count * sizeof(*shader_hashes));
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static BOOL glsl_program_cache_load(const struct wined3d_gl_info *gl_info,
+        GLuint program, const struct glsl_program_cache_key *key)
+{
+    struct glsl_program_cache_header header;
+    char name[MAX_PATH];
+    FILETIME now;
+    GLint status;
+    void *data;
+    HANDLE file;
+    DWORD read;
+
+    glsl_program_cache_get_filename(key, ".bin", name, sizeof(name));
+    if ((file = CreateFileA(name, GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    if (!ReadFile(file, &header, sizeof(header), &read, NULL) || read != sizeof(header)
+            || header.magic != GLSL_PROGRAM_CACHE_MAGIC || header.version != GLSL_PROGRAM_CACHE_VERSION
+            || memcmp(&header.key, key, sizeof(*key))
+            || !header.binary_size || header.binary_size > GLSL_PROGRAM_CACHE_MAX_BINARY_SIZE)
+    {
+        WARN("Invalid program cache entry %s.\n", debugstr_a(name));
+        CloseHandle(file);
+        return FALSE;
+    }
+
+    if (!(data = heap_alloc(header.binary_size)))
+    {
+        ERR("Failed to allocate %u bytes for program binary.\n", header.binary_size);
+        CloseHandle(file);
+        return FALSE;
+    }
+
+    if (!ReadFile(file, data, header.binary_size, &read, NULL) || read != header.binary_size)
+    {
+        WARN("Failed to read program binary from %s.\n", debugstr_a(name));
+        heap_free(data);
+        CloseHandle(file);
+        return FALSE;
+    }
+
+    GL_EXTCALL(glProgramBinary(program, header.binary_format, data, header.binary_size));
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    checkGLcall("glProgramBinary");
+    heap_free(data);
+
+    if (status)
+    {
+        /* Update the last write time, which is what pruning uses. */
+        GetSystemTimeAsFileTime(&now);
+        SetFileTime(file, NULL, NULL, &now);
+    }
+    CloseHandle(file);
+
+    if (!status)
+    {
+        /* The driver changed without changing its version string. */
+        WARN("Failed to load program binary %s, removing it.\n", debugstr_a(name));
+        DeleteFileA(name);
+    }
+
+    return status;
+}
+
+/* Context activation is done by the caller. */
+static void glsl_program_cache_store(const struct wined3d_gl_info *gl_info,
+        GLuint program, const struct glsl_program_cache_key *key)
+{
+    struct glsl_program_cache_header header;
+    char name[MAX_PATH], tmp_name[MAX_PATH];
+    GLint status, length;
+    DWORD written;
+    HANDLE file;
+    BOOL ret;
+    void *data;
+
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    GL_EXTCALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    checkGLcall("glGetProgramiv");
+    if (!status || length <= 0 || length > GLSL_PROGRAM_CACHE_MAX_BINARY_SIZE)
+        return;
+
+    if (!(data = heap_alloc(length)))
+    {
+        ERR("Failed to allocate %d bytes for program binary.\n", length);
+        return;
+    }
+
+    GL_EXTCALL(glGetProgramBinary(program, length, &length, &header.binary_format, data));
+    checkGLcall("glGetProgramBinary");
+
+    header.magic = GLSL_PROGRAM_CACHE_MAGIC;
+    header.version = GLSL_PROGRAM_CACHE_VERSION;
+    header.key = *key;
+    header.binary_size = length;
+
+    /* Write to a temporary file first, so that other processes never see
+     * incomplete entries. */
+    glsl_program_cache_get_filename(key, ".bin", name, sizeof(name));
+    glsl_program_cache_get_filename(key, ".tmp", tmp_name, sizeof(tmp_name));
+    if ((file = CreateFileA(tmp_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_a(tmp_name), GetLastError());
+        heap_free(data);
+        return;
+    }
+
+    ret = WriteFile(file, &header, sizeof(header), &written, NULL) && written == sizeof(header)
+            && WriteFile(file, data, length, &written, NULL) && written == length;
+    CloseHandle(file);
+    heap_free(data);
+
+    if (!ret || !MoveFileExA(tmp_name, name, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write program cache entry %s.\n", debugstr_a(name));
+        DeleteFileA(tmp_name);
+        return;
+    }
+
+    TRACE("Stored program %u in program cache entry %s.\n", program, debugstr_a(name));
+
+    glsl_program_cache.size += sizeof(header) + length;
+    if (glsl_program_cache.size > glsl_program_cache.max_size)
+        glsl_program_cache_prune();
+}
+
+/* Fixed-function shader settings seen by previous runs of the application
+ * are recorded in a file next to the program cache, and the corresponding
+ * shaders are generated when the first context of a device is created.
+ * With parallel shader compilation the driver then compiles them in the
+ * background, and their linked programs come from the program cache. */
+#define GLSL_FFP_CACHE_MAGIC        MAKEFOURCC('W', 'G', 'F', 'S')
+#define GLSL_FFP_CACHE_VERSION      1
+#define GLSL_FFP_CACHE_MAX_ENTRIES  16384
+
+struct glsl_ffp_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD vs_settings_size;
+    DWORD fs_settings_size;
+};
+
+struct glsl_ffp_cache_record
+{
+    DWORD type;
+    union
+    {
+        struct wined3d_ffp_vs_settings vs;
+        struct ffp_frag_settings fs;
+    } u;
+};
+
+static struct
+{
+    BOOL initialised;
+    HANDLE file;
+    unsigned int entry_count;
+} glsl_ffp_cache = {FALSE, INVALID_HANDLE_VALUE};
+
+static DWORD glsl_ffp_cache_record_size(DWORD type)
+{
+    if (type == WINED3D_SHADER_TYPE_VERTEX)
+        return FIELD_OFFSET(struct glsl_ffp_cache_record, u) + sizeof(struct wined3d_ffp_vs_settings);
+    if (type == WINED3D_SHADER_TYPE_PIXEL)
+        return FIELD_OFFSET(struct glsl_ffp_cache_record, u) + sizeof(struct ffp_frag_settings);
+    return 0;
+}
+
+/* Context activation is done by the caller. The cache lock should be held. */
+static BOOL glsl_ffp_cache_init(const struct wined3d_gl_info *gl_info)
+{
+    static const struct glsl_ffp_cache_header expected =
+    {
+        GLSL_FFP_CACHE_MAGIC,
+        GLSL_FFP_CACHE_VERSION,
+        sizeof(struct wined3d_ffp_vs_settings),
+        sizeof(struct ffp_frag_settings),
+    };
+    struct glsl_ffp_cache_header header;
+    char module[MAX_PATH], name[MAX_PATH];
+    const char *exe;
+    DWORD size;
+    HANDLE file;
+
+    if (glsl_ffp_cache.initialised)
+        return glsl_ffp_cache.file != INVALID_HANDLE_VALUE;
+    glsl_ffp_cache.initialised = TRUE;
+
+    if (!glsl_program_cache_init(gl_info))
+        return FALSE;
+
+    size = GetModuleFileNameA(NULL, module, sizeof(module));
+    if (!size || size >= sizeof(module))
+        return FALSE;
+    exe = (exe = strrchr(module, '\\')) ? exe + 1 : module;
+    snprintf(name, sizeof(name), "%s\\%s.ffp", glsl_program_cache.path, exe);
+
+    if ((file = CreateFileA(name, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+            NULL, OPEN_ALWAYS, 0, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to open %s, error %u.\n", debugstr_a(name), GetLastError());
+        return FALSE;
+    }
+
+    if (!ReadFile(file, &header, sizeof(header), &size, NULL) || size != sizeof(header)
+            || memcmp(&header, &expected, sizeof(header)))
+    {
+        if (size)
+            WARN("Invalid fixed-function shader cache %s, resetting it.\n", debugstr_a(name));
+        SetFilePointer(file, 0, NULL, FILE_BEGIN);
+        if (!SetEndOfFile(file) || !WriteFile(file, &expected, sizeof(expected), &size, NULL)
+                || size != sizeof(expected))
+        {
+            WARN("Failed to write %s, error %u.\n", debugstr_a(name), GetLastError());
+            CloseHandle(file);
+            return FALSE;
+        }
+    }
+
+    TRACE("Using fixed-function shader cache %s.\n", debugstr_a(name));
+    glsl_ffp_cache.file = file;
+    return TRUE;
+}
+
+/* The cache lock should be held. */
+static void glsl_ffp_cache_store(DWORD type, const void *settings, SIZE_T size)
+{
+    struct glsl_ffp_cache_record record;
+    DWORD written;
+
+    if (glsl_ffp_cache.entry_count >= GLSL_FFP_CACHE_MAX_ENTRIES)
+        return;
+
+    memset(&record, 0, sizeof(record));
+    record.type = type;
+    memcpy(&record.u, settings, size);
+
+    SetFilePointer(glsl_ffp_cache.file, 0, NULL, FILE_END);
+    if (!WriteFile(glsl_ffp_cache.file, &record, glsl_ffp_cache_record_size(type), &written, NULL))
+        WARN("Failed to write fixed-function shader cache entry, error %u.\n", GetLastError());
+    else
+        ++glsl_ffp_cache.entry_count;
+}
+
+static void shader_glsl_record_ffp_shader(struct shader_glsl_priv *priv,
+        const struct wined3d_gl_info *gl_info, DWORD type, const void *settings, SIZE_T size)
+{
+    if (priv->ffp_cache_loading)
+        return;
+
+    EnterCriticalSection(&glsl_program_cache_cs);
+    if (glsl_ffp_cache_init(gl_info))
+        glsl_ffp_cache_store(type, settings, size);
+    LeaveCriticalSection(&glsl_program_cache_cs);
+}
+
+/* Context activation is done by the caller. Programs whose link result
+ * depends on more than the attached shaders, like transform feedback
+ * varyings, should not be cached. Returns TRUE if the program was linked,
+ * in which case shader_glsl_finish_link() should be called once it's used,
+ * and FALSE if it was loaded from the program cache. */
+static BOOL shader_glsl_link_program(const struct wined3d_gl_info *gl_info, GLuint program, BOOL cacheable)
+{
+    struct glsl_program_cache_key key;
+    BOOL use_cache;
+
+    EnterCriticalSection(&glsl_program_cache_cs);
+
+    use_cache = cacheable && glsl_program_cache_init(gl_info)
+            && glsl_program_cache_get_key(gl_info, program, &key);
+    LeaveCriticalSection(&glsl_program_cache_cs);
+
+    if (use_cache && glsl_program_cache_load(gl_info, program, &key))
+    {
+        TRACE("Loaded GLSL shader program %u from the program cache.\n", program);
+        return FALSE;
+    }
+
+    if (use_cache)
+    {
+        GL_EXTCALL(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+        checkGLcall("glProgramParameteri");
+    }
+
+    TRACE("Linking GLSL shader program %u.\n", program);
+    GL_EXTCALL(glLinkProgram(program));
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. This waits for the link to
+ * complete. */
+static void shader_glsl_finish_link(const struct wined3d_gl_info *gl_info, GLuint program, BOOL cacheable)
+{
+    struct glsl_program_cache_key key;
+
+    shader_glsl_validate_link(gl_info, program);
+
+    EnterCriticalSection(&glsl_program_cache_cs);
+    if (cacheable && glsl_program_cache_init(gl_info) && glsl_program_cache_get_key(gl_info, program, &key))
+        glsl_program_cache_store(gl_info, program, &key);
+    LeaveCriticalSection(&glsl_program_cache_cs);
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -603,6 +1195,64 @@ static BOOL shader_glsl_use_layout_binding_qualifier(const struct wined3d_gl_inf
     return gl_info->supported[ARB_SHADING_LANGUAGE_420PACK] && shader_glsl_use_layout_qualifier(gl_info);
 }
 
+#define WINED3D_GLSL_CONSTANT_RING_SIZE (4 * 1024 * 1024)
+
+/* The uniform buffers holding the float constants of legacy shaders are bound
+ * after the ones used for D3D10+ constant buffers. */
+static unsigned int shader_glsl_constant_ubo_idx(enum wined3d_shader_type shader_type)
+{
+    return shader_type == WINED3D_SHADER_TYPE_PIXEL;
+}
+
+static unsigned int shader_glsl_constant_ubo_binding(const struct wined3d_gl_info *gl_info,
+        enum wined3d_shader_type shader_type)
+{
+    unsigned int base, count;
+
+    wined3d_gl_limits_get_uniform_block_range(&gl_info->limits, WINED3D_SHADER_TYPE_COMPUTE, &base, &count);
+    return base + count + shader_glsl_constant_ubo_idx(shader_type);
+}
+
+static BOOL shader_glsl_use_constant_ubo(const struct wined3d_gl_info *gl_info, const struct wined3d_shader *shader)
+{
+    const struct wined3d_shader_version *version = &shader->reg_maps.shader_version;
+
+    if (!wined3d_settings.constant_ubo || !gl_info->supported[ARB_UNIFORM_BUFFER_OBJECT]
+            || !gl_info->supported[ARB_MAP_BUFFER_RANGE])
+        return FALSE;
+    if (shader_glsl_constant_ubo_binding(gl_info, WINED3D_SHADER_TYPE_PIXEL)
+            >= gl_info->limits.uniform_buffer_bindings)
+        return FALSE;
+    if (version->major >= 4 || !shader->limits->constant_float)
+        return FALSE;
+    /* Pixel shader 1.x constants are clamped, and local constants that are
+     * loaded through uniforms overwrite parts of the constant array. Both
+     * are specific to the program, unlike the contents of the buffer. */
+    if (version->type == WINED3D_SHADER_TYPE_PIXEL && version->major == 1)
+        return FALSE;
+    return !shader->load_local_constsF;
+}
+
+static void shader_glsl_init_constant_ubo_binding(const struct wined3d_gl_info *gl_info,
+        struct shader_glsl_priv *priv, GLuint program_id, const struct wined3d_shader *shader)
+{
+    enum wined3d_shader_type shader_type = shader->reg_maps.shader_version.type;
+    struct wined3d_string_buffer *name;
+    GLuint block_idx;
+
+    if (!shader_glsl_use_constant_ubo(gl_info, shader) || shader_glsl_use_layout_binding_qualifier(gl_info))
+        return;
+
+    name = string_buffer_get(&priv->string_buffers);
+    string_buffer_sprintf(name, "block_%s_c", shader_glsl_get_prefix(shader_type));
+    block_idx = GL_EXTCALL(glGetUniformBlockIndex(program_id, name->buffer));
+    if (block_idx != GL_INVALID_INDEX)
+        GL_EXTCALL(glUniformBlockBinding(program_id, block_idx,
+                shader_glsl_constant_ubo_binding(gl_info, shader_type)));
+    checkGLcall("glUniformBlockBinding");
+    string_buffer_release(&priv->string_buffers, name);
+}
+
 static void shader_glsl_init_uniform_block_bindings(const struct wined3d_gl_info *gl_info,
         struct shader_glsl_priv *priv, GLuint program_id,
         const struct wined3d_shader_reg_maps *reg_maps)
@@ -761,6 +1411,7 @@ static void shader_glsl_load_program_resources(const struct wined3d_context *con
     const struct wined3d_shader_reg_maps *reg_maps = &shader->reg_maps;
 
     shader_glsl_init_uniform_block_bindings(context->gl_info, priv, program_id, reg_maps);
+    shader_glsl_init_constant_ubo_binding(context->gl_info, priv, program_id, shader);
     shader_glsl_load_icb(context->gl_info, priv, program_id, reg_maps);
     /* Texture unit mapping is set up to be the same each time the shader
      * program is used so we can hardcode the sampler uniform values. */
@@ -1747,7 +2398,93 @@ static void shader_glsl_load_color_key_constant(const struct glsl_ps_program *ps
     GL_EXTCALL(glUniform4fv(ps->color_key_location, 2, &float_key[0].r));
 }
 
-/* Context activation is done by the caller (state handler). */
+/* Context activation is done by the caller. */
+static void shader_glsl_upload_constant_ubo(struct shader_glsl_priv *priv, struct wined3d_context *context,
+        struct wined3d_device *device, unsigned int idx, const void *constants, unsigned int size)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    unsigned int alignment, offset, i;
+    GLbitfield access;
+    void *data;
+
+    alignment = max(gl_info->limits.uniform_buffer_offset_alignment, 16);
+    offset = (priv->constant_ring_offset + alignment - 1) & ~(alignment - 1);
+    access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (offset + size > WINED3D_GLSL_CONSTANT_RING_SIZE)
+    {
+        /* Orphan the buffer. The other contexts need to rebind their ranges,
+         * and the data of the other shader type has to be uploaded again. */
+        TRACE("Constant ring wrapped.\n");
+        offset = 0;
+        access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+        priv->constant_ubo_dirty[!idx] = TRUE;
+        for (i = 0; i < device->context_count; ++i)
+        {
+            if (device->contexts[i] != context)
+                device->contexts[i]->constant_update_mask |= WINED3D_SHADER_CONST_VS_F | WINED3D_SHADER_CONST_PS_F;
+        }
+    }
+
+    GL_EXTCALL(glBindBuffer(GL_UNIFORM_BUFFER, priv->constant_ring_bo));
+    if ((data = GL_EXTCALL(glMapBufferRange(GL_UNIFORM_BUFFER, offset, size, access))))
+    {
+        memcpy(data, constants, size);
+        GL_EXTCALL(glUnmapBuffer(GL_UNIFORM_BUFFER));
+    }
+    checkGLcall("upload constant ring");
+
+    priv->constant_ring_offset = offset + size;
+    priv->constant_ubo_offset[idx] = offset;
+    priv->constant_ubo_dirty[idx] = FALSE;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_load_constant_ubos(struct shader_glsl_priv *priv, struct wined3d_context *context,
+        const struct wined3d_state *state)
+{
+    static const unsigned int sizes[] =
+    {
+        WINED3D_MAX_VS_CONSTS_F * sizeof(struct wined3d_vec4),
+        WINED3D_MAX_PS_CONSTS_F * sizeof(struct wined3d_vec4),
+    };
+    struct glsl_context_data *ctx_data = context->shader_backend_data;
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    const void *constants[ARRAY_SIZE(sizes)];
+    unsigned int i;
+
+    if (!priv->constant_ring_bo)
+    {
+        GL_EXTCALL(glGenBuffers(1, &priv->constant_ring_bo));
+        GL_EXTCALL(glBindBuffer(GL_UNIFORM_BUFFER, priv->constant_ring_bo));
+        GL_EXTCALL(glBufferData(GL_UNIFORM_BUFFER, WINED3D_GLSL_CONSTANT_RING_SIZE, NULL, GL_STREAM_DRAW));
+        checkGLcall("create constant ring");
+    }
+
+    constants[shader_glsl_constant_ubo_idx(WINED3D_SHADER_TYPE_VERTEX)] = state->vs_consts_f;
+    constants[shader_glsl_constant_ubo_idx(WINED3D_SHADER_TYPE_PIXEL)] = state->ps_consts_f;
+    for (i = 0; i < ARRAY_SIZE(sizes); ++i)
+    {
+        if (priv->constant_ubo_dirty[i])
+            shader_glsl_upload_constant_ubo(priv, context, context->device, i, constants[i], sizes[i]);
+    }
+    /* A wrap while uploading the second buffer invalidates the first. */
+    if (priv->constant_ubo_dirty[0])
+        shader_glsl_upload_constant_ubo(priv, context, context->device, 0, constants[0], sizes[0]);
+
+    for (i = 0; i < ARRAY_SIZE(sizes); ++i)
+    {
+        if (ctx_data->constant_ubo_offset[i] == priv->constant_ubo_offset[i])
+            continue;
+
+        GL_EXTCALL(glBindBufferRange(GL_UNIFORM_BUFFER, shader_glsl_constant_ubo_binding(gl_info, i
+                ? WINED3D_SHADER_TYPE_PIXEL : WINED3D_SHADER_TYPE_VERTEX), priv->constant_ring_bo,
+                priv->constant_ubo_offset[i], sizes[i]));
+        ctx_data->constant_ubo_offset[i] = priv->constant_ubo_offset[i];
+    }
+    checkGLcall("bind constant ring");
+}
+
+/* Context activation is done by the caller (state handler). */
 static void shader_glsl_load_constants(void *shader_priv, struct wined3d_context *context,
         const struct wined3d_state *state)
 {
@@ -1770,7 +2507,11 @@ static void shader_glsl_load_constants(void *shader_priv, struct wined3d_context
     constant_version = prog->constant_version;
     update_mask = context->constant_update_mask & prog->constant_update_mask;
 
-    if (update_mask & WINED3D_SHADER_CONST_VS_F)
+    if (((update_mask & WINED3D_SHADER_CONST_VS_F) && shader_glsl_use_constant_ubo(gl_info, vshader))
+            || ((update_mask & WINED3D_SHADER_CONST_PS_F) && shader_glsl_use_constant_ubo(gl_info, pshader)))
+        shader_glsl_load_constant_ubos(priv, context, state);
+
+    if ((update_mask & WINED3D_SHADER_CONST_VS_F) && !shader_glsl_use_constant_ubo(gl_info, vshader))
         shader_glsl_load_constants_f(vshader, gl_info, state->vs_consts_f,
                 prog->vs.uniform_f_locations, &priv->vconst_heap, priv->stack, constant_version);
 
@@ -1915,7 +2656,7 @@ static void shader_glsl_load_constants(void *shader_priv, struct wined3d_context
         }
     }
 
-    if (update_mask & WINED3D_SHADER_CONST_PS_F)
+    if ((update_mask & WINED3D_SHADER_CONST_PS_F) && !shader_glsl_use_constant_ubo(gl_info, pshader))
         shader_glsl_load_constants_f(pshader, gl_info, state->ps_consts_f,
                 prog->ps.uniform_f_locations, &priv->pconst_heap, priv->stack, constant_version);
 
@@ -2060,6 +2801,7 @@ static void shader_glsl_update_float_vertex_constants(struct wined3d_device *dev
     {
         update_heap_entry(heap, i, priv->next_constant_version);
     }
+    priv->constant_ubo_dirty[shader_glsl_constant_ubo_idx(WINED3D_SHADER_TYPE_VERTEX)] = TRUE;
 }
 
 static void shader_glsl_update_float_pixel_constants(struct wined3d_device *device, UINT start, UINT count)
@@ -2072,6 +2814,7 @@ static void shader_glsl_update_float_pixel_constants(struct wined3d_device *devi
     {
         update_heap_entry(heap, i, priv->next_constant_version);
     }
+    priv->constant_ubo_dirty[shader_glsl_constant_ubo_idx(WINED3D_SHADER_TYPE_PIXEL)] = TRUE;
 }
 
 static unsigned int vec4_varyings(DWORD shader_major, const struct wined3d_gl_info *gl_info)
@@ -2392,7 +3135,15 @@ static void shader_generate_glsl_declarations(const struct wined3d_context *cont
     }
 
     /* Declare the constants (aka uniforms) */
-    if (shader->limits->constant_float > 0)
+    if (shader_glsl_use_constant_ubo(gl_info, shader))
+    {
+        shader_addline(buffer, "layout(std140");
+        if (shader_glsl_use_layout_binding_qualifier(gl_info))
+            shader_addline(buffer, ", binding = %u", shader_glsl_constant_ubo_binding(gl_info, version->type));
+        shader_addline(buffer, ") uniform block_%s_c { vec4 %s_c[%u]; };\n",
+                prefix, prefix, shader->limits->constant_float);
+    }
+    else if (shader->limits->constant_float > 0)
     {
         unsigned max_constantsF;
 
@@ -9723,6 +10474,7 @@ static struct glsl_ffp_vertex_shader *shader_glsl_find_ffp_vertex_shader(struct
     list_init(&shader->linked_programs);
     if (wine_rb_put(&priv->ffp_vertex_shaders, &shader->desc.settings, &shader->desc.entry) == -1)
         ERR("Failed to insert ffp vertex shader.\n");
+    shader_glsl_record_ffp_shader(priv, gl_info, WINED3D_SHADER_TYPE_VERTEX, settings, sizeof(*settings));
 
     return shader;
 }
@@ -9743,10 +10495,75 @@ static struct glsl_ffp_fragment_shader *shader_glsl_find_ffp_fragment_shader(str
     glsl_desc->id = shader_glsl_generate_ffp_fragment_shader(priv, args, context);
     list_init(&glsl_desc->linked_programs);
     add_ffp_frag_shader(&priv->ffp_fragment_shaders, &glsl_desc->entry);
+    shader_glsl_record_ffp_shader(priv, context->gl_info, WINED3D_SHADER_TYPE_PIXEL, args, sizeof(*args));
 
     return glsl_desc;
 }
 
+/* Context activation is done by the caller. */
+static void shader_glsl_load_ffp_cache(struct shader_glsl_priv *priv, struct wined3d_context *context)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    struct wined3d_device *device = context->device;
+    struct glsl_ffp_cache_record record;
+    unsigned int vs_count = 0, fs_count = 0;
+    BOOL vs, fs;
+    DWORD size;
+
+    vs = device->vertex_priv == priv;
+    fs = device->fragment_priv == priv;
+    if (priv->ffp_cache_loaded || (!vs && !fs))
+        return;
+    priv->ffp_cache_loaded = TRUE;
+
+    EnterCriticalSection(&glsl_program_cache_cs);
+    if (!glsl_ffp_cache_init(gl_info))
+    {
+        LeaveCriticalSection(&glsl_program_cache_cs);
+        return;
+    }
+
+    priv->ffp_cache_loading = TRUE;
+    glsl_ffp_cache.entry_count = 0;
+    SetFilePointer(glsl_ffp_cache.file, sizeof(struct glsl_ffp_cache_header), NULL, FILE_BEGIN);
+    while (ReadFile(glsl_ffp_cache.file, &record.type, sizeof(record.type), &size, NULL)
+            && size == sizeof(record.type))
+    {
+        DWORD record_size = glsl_ffp_cache_record_size(record.type);
+
+        if (record_size)
+            record_size -= FIELD_OFFSET(struct glsl_ffp_cache_record, u);
+        if (!record_size || !ReadFile(glsl_ffp_cache.file, &record.u, record_size, &size, NULL) || size != record_size)
+        {
+            WARN("Truncated or invalid fixed-function shader cache entry.\n");
+            break;
+        }
+        ++glsl_ffp_cache.entry_count;
+
+        if (record.type == WINED3D_SHADER_TYPE_VERTEX && vs)
+        {
+            if (!wine_rb_get(&priv->ffp_vertex_shaders, &record.u.vs))
+            {
+                shader_glsl_find_ffp_vertex_shader(priv, gl_info, &record.u.vs);
+                ++vs_count;
+            }
+        }
+        else if (record.type == WINED3D_SHADER_TYPE_PIXEL && fs)
+        {
+            if (!find_ffp_frag_shader(&priv->ffp_fragment_shaders, &record.u.fs))
+            {
+                shader_glsl_find_ffp_fragment_shader(priv, &record.u.fs, context);
+                ++fs_count;
+            }
+        }
+    }
+    priv->ffp_cache_loading = FALSE;
+    LeaveCriticalSection(&glsl_program_cache_cs);
+
+    TRACE("Generated %u fixed-function vertex shaders and %u fragment shaders from the cache.\n",
+            vs_count, fs_count);
+}
+
 
 static void shader_glsl_init_vs_uniform_locations(const struct wined3d_gl_info *gl_info,
         struct shader_glsl_priv *priv, GLuint program_id, struct glsl_vs_program *vs, unsigned int vs_c_count)
@@ -9952,6 +10769,9 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     entry->cs.id = shader_id;
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
+    entry->link_pending = 0;
+    entry->init_pending = 0;
+    entry->cacheable = 0;
     entry->ps.np2_fixup_info = NULL;
     add_glsl_program_entry(priv, entry);
 
@@ -9961,9 +10781,8 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     list_add_head(&shader->linked_programs, &entry->cs.shader_entry);
 
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    if (shader_glsl_link_program(gl_info, program_id, TRUE))
+        shader_glsl_finish_link(gl_info, program_id, TRUE);
 
     GL_EXTCALL(glUseProgram(program_id));
     checkGLcall("glUseProgram");
@@ -10023,12 +10842,209 @@ static void set_glsl_compute_shader_program(const struct wined3d_context *contex
 }
 
 /* Context activation is done by the caller. */
-static void set_glsl_shader_program(const struct wined3d_context *context, const struct wined3d_state *state,
+/* Context activation is done by the caller. */
+static void shader_glsl_init_program(const struct wined3d_context *context,
+        struct shader_glsl_priv *priv, struct glsl_shader_prog_link *entry)
+{
+    const struct wined3d_shader *vshader = entry->shaders[WINED3D_SHADER_TYPE_VERTEX];
+    const struct wined3d_shader *hshader = entry->shaders[WINED3D_SHADER_TYPE_HULL];
+    const struct wined3d_shader *dshader = entry->shaders[WINED3D_SHADER_TYPE_DOMAIN];
+    const struct wined3d_shader *gshader = entry->shaders[WINED3D_SHADER_TYPE_GEOMETRY];
+    const struct wined3d_shader *pshader = entry->shaders[WINED3D_SHADER_TYPE_PIXEL];
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    const struct wined3d_shader *pre_rasterization_shader;
+    unsigned int i;
+
+    shader_glsl_init_vs_uniform_locations(gl_info, priv, entry->id, &entry->vs,
+            vshader && !shader_glsl_use_constant_ubo(gl_info, vshader) ? vshader->limits->constant_float : 0);
+    shader_glsl_init_ds_uniform_locations(gl_info, priv, entry->id, &entry->ds);
+    shader_glsl_init_gs_uniform_locations(gl_info, priv, entry->id, &entry->gs);
+    shader_glsl_init_ps_uniform_locations(gl_info, priv, entry->id, &entry->ps,
+            pshader && !shader_glsl_use_constant_ubo(gl_info, pshader) ? pshader->limits->constant_float : 0);
+    checkGLcall("find glsl program uniform locations");
+
+    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
+    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
+    {
+        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
+        entry->shader_controlled_clip_distances = 1;
+        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
+    }
+
+    if (needs_legacy_glsl_syntax(gl_info))
+    {
+        if (pshader && pshader->reg_maps.shader_version.major >= 3
+                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
+        {
+            TRACE("Shader %d needs vertex color clamping disabled.\n", entry->id);
+            entry->vs.vertex_color_clamp = GL_FALSE;
+        }
+        else
+        {
+            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+        }
+    }
+    else
+    {
+        /* With core profile we never change vertex_color_clamp from
+         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
+         * glClampColorARB(). */
+        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+    }
+
+    /* Set the shader to allow uniform loading on it */
+    GL_EXTCALL(glUseProgram(entry->id));
+    checkGLcall("glUseProgram");
+
+    entry->constant_update_mask = 0;
+    if (vshader)
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
+        if (vshader->reg_maps.integer_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
+        if (vshader->reg_maps.boolean_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
+        if (entry->vs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context, priv, entry->id, vshader);
+    }
+    else
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
+                | WINED3D_SHADER_CONST_FFP_PROJ;
+
+        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
+        {
+            if (entry->vs.modelview_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
+                break;
+            }
+        }
+
+        for (i = 0; i < MAX_TEXTURES; ++i)
+        {
+            if (entry->vs.texture_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
+                break;
+            }
+        }
+        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
+                || entry->vs.material_specular_location != -1
+                || entry->vs.material_emissive_location != -1
+                || entry->vs.material_shininess_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
+        if (entry->vs.light_ambient_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
+    }
+    if (entry->vs.clip_planes_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
+    if (entry->vs.pointsize_min_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
+
+    if (hshader)
+        shader_glsl_load_program_resources(context, priv, entry->id, hshader);
+
+    if (dshader)
+    {
+        if (entry->ds.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context, priv, entry->id, dshader);
+    }
+
+    if (gshader)
+    {
+        if (entry->gs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context, priv, entry->id, gshader);
+    }
+
+    if (entry->ps.id)
+    {
+        if (pshader)
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
+            if (pshader->reg_maps.integer_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
+            if (pshader->reg_maps.boolean_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
+            if (entry->ps.ycorrection_location != -1)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
+
+            shader_glsl_load_program_resources(context, priv, entry->id, pshader);
+            shader_glsl_load_images(gl_info, priv, entry->id, &pshader->reg_maps);
+        }
+        else
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
+
+            shader_glsl_load_samplers(context, priv, entry->id, NULL);
+        }
+
+        for (i = 0; i < MAX_TEXTURES; ++i)
+        {
+            if (entry->ps.bumpenv_mat_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
+                break;
+            }
+        }
+
+        if (entry->ps.fog_color_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
+        if (entry->ps.alpha_test_ref_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
+        if (entry->ps.np2_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
+        if (entry->ps.color_key_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
+    }
+}
+
+/* Context activation is done by the caller. Returns FALSE if the program is
+ * still being compiled, and draws using it should be skipped. */
+static BOOL shader_glsl_complete_program(const struct wined3d_context *context,
+        struct shader_glsl_priv *priv, struct glsl_shader_prog_link *entry)
+{
+    const struct wined3d_gl_info *gl_info = context->gl_info;
+    GLint status;
+
+    if (!entry->init_pending)
+        return TRUE;
+
+    if (entry->link_pending && shader_glsl_skip_pending_programs(gl_info))
+    {
+        GL_EXTCALL(glGetProgramiv(entry->id, GL_COMPLETION_STATUS_KHR, &status));
+        checkGLcall("glGetProgramiv(GL_COMPLETION_STATUS_KHR)");
+        if (!status)
+        {
+            TRACE("Program %u is still being compiled.\n", entry->id);
+            return FALSE;
+        }
+    }
+
+    if (entry->link_pending)
+    {
+        shader_glsl_finish_link(gl_info, entry->id, entry->cacheable);
+        entry->link_pending = 0;
+    }
+    shader_glsl_init_program(context, priv, entry);
+    entry->init_pending = 0;
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. Returns FALSE if the program
+ * for the current state is still being compiled. */
+static BOOL set_glsl_shader_program(const struct wined3d_context *context, const struct wined3d_state *state,
         struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
 {
     const struct wined3d_d3d_info *d3d_info = context->d3d_info;
     const struct wined3d_gl_info *gl_info = context->gl_info;
-    const struct wined3d_shader *pre_rasterization_shader;
     const struct ps_np2fixup_info *np2fixup_info = NULL;
     struct wined3d_shader *hshader, *dshader, *gshader;
     struct glsl_shader_prog_link *entry = NULL;
@@ -10151,8 +11167,13 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     key.cs_id = 0;
     if ((!vs_id && !hs_id && !ds_id && !gs_id && !ps_id) || (entry = get_glsl_program_entry(priv, &key)))
     {
+        if (entry && !shader_glsl_complete_program(context, priv, entry))
+        {
+            ctx_data->glsl_program = NULL;
+            return FALSE;
+        }
         ctx_data->glsl_program = entry;
-        return;
+        return TRUE;
     }
 
     /* If we get to this point, then no matching program exists, so we create one */
@@ -10170,7 +11191,15 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     entry->cs.id = 0;
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
+    entry->link_pending = 0;
+    entry->init_pending = 0;
+    entry->cacheable = 0;
     entry->ps.np2_fixup_info = np2fixup_info;
+    entry->shaders[WINED3D_SHADER_TYPE_PIXEL] = pshader;
+    entry->shaders[WINED3D_SHADER_TYPE_VERTEX] = vshader;
+    entry->shaders[WINED3D_SHADER_TYPE_GEOMETRY] = gshader;
+    entry->shaders[WINED3D_SHADER_TYPE_HULL] = hshader;
+    entry->shaders[WINED3D_SHADER_TYPE_DOMAIN] = dshader;
     /* Add the hash table entry */
     add_glsl_program_entry(priv, entry);
 
@@ -10286,158 +11315,17 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     }
 
     /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
-
-    shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
-            vshader ? vshader->limits->constant_float : 0);
-    shader_glsl_init_ds_uniform_locations(gl_info, priv, program_id, &entry->ds);
-    shader_glsl_init_gs_uniform_locations(gl_info, priv, program_id, &entry->gs);
-    shader_glsl_init_ps_uniform_locations(gl_info, priv, program_id, &entry->ps,
-            pshader ? pshader->limits->constant_float : 0);
-    checkGLcall("find glsl program uniform locations");
-
-    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
-    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
-    {
-        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
-        entry->shader_controlled_clip_distances = 1;
-        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
-    }
-
-    if (needs_legacy_glsl_syntax(gl_info))
-    {
-        if (pshader && pshader->reg_maps.shader_version.major >= 3
-                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
-        {
-            TRACE("Shader %d needs vertex color clamping disabled.\n", program_id);
-            entry->vs.vertex_color_clamp = GL_FALSE;
-        }
-        else
-        {
-            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-        }
-    }
-    else
-    {
-        /* With core profile we never change vertex_color_clamp from
-         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
-         * glClampColorARB(). */
-        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-    }
-
-    /* Set the shader to allow uniform loading on it */
-    GL_EXTCALL(glUseProgram(program_id));
-    checkGLcall("glUseProgram");
+    entry->cacheable = !gshader || !gshader->u.gs.so_desc.element_count;
+    entry->link_pending = shader_glsl_link_program(gl_info, program_id, entry->cacheable);
+    entry->init_pending = 1;
 
-    entry->constant_update_mask = 0;
-    if (vshader)
+    if (!shader_glsl_complete_program(context, priv, entry))
     {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
-        if (vshader->reg_maps.integer_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
-        if (vshader->reg_maps.boolean_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
-        if (entry->vs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context, priv, program_id, vshader);
-    }
-    else
-    {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
-                | WINED3D_SHADER_CONST_FFP_PROJ;
-
-        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
-        {
-            if (entry->vs.modelview_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
-                break;
-            }
-        }
-
-        for (i = 0; i < MAX_TEXTURES; ++i)
-        {
-            if (entry->vs.texture_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
-                break;
-            }
-        }
-        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
-                || entry->vs.material_specular_location != -1
-                || entry->vs.material_emissive_location != -1
-                || entry->vs.material_shininess_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
-        if (entry->vs.light_ambient_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
-    }
-    if (entry->vs.clip_planes_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
-    if (entry->vs.pointsize_min_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
-
-    if (hshader)
-        shader_glsl_load_program_resources(context, priv, program_id, hshader);
-
-    if (dshader)
-    {
-        if (entry->ds.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context, priv, program_id, dshader);
-    }
-
-    if (gshader)
-    {
-        if (entry->gs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context, priv, program_id, gshader);
+        ctx_data->glsl_program = NULL;
+        return FALSE;
     }
 
-    if (ps_id)
-    {
-        if (pshader)
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
-            if (pshader->reg_maps.integer_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
-            if (pshader->reg_maps.boolean_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
-            if (entry->ps.ycorrection_location != -1)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
-
-            shader_glsl_load_program_resources(context, priv, program_id, pshader);
-            shader_glsl_load_images(gl_info, priv, program_id, &pshader->reg_maps);
-        }
-        else
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
-
-            shader_glsl_load_samplers(context, priv, program_id, NULL);
-        }
-
-        for (i = 0; i < MAX_TEXTURES; ++i)
-        {
-            if (entry->ps.bumpenv_mat_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
-                break;
-            }
-        }
-
-        if (entry->ps.fog_color_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
-        if (entry->ps.alpha_test_ref_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
-        if (entry->ps.np2_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
-        if (entry->ps.color_key_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
-    }
+    return TRUE;
 }
 
 static void shader_glsl_precompile(void *shader_priv, struct wined3d_shader *shader)
@@ -10468,7 +11356,7 @@ static void shader_glsl_select(void *shader_priv, struct wined3d_context *contex
     priv->fragment_pipe->enable_extension(gl_info, !use_ps(state));
 
     prev_id = ctx_data->glsl_program ? ctx_data->glsl_program->id : 0;
-    set_glsl_shader_program(context, state, priv, ctx_data);
+    context->shader_pending = !set_glsl_shader_program(context, state, priv, ctx_data);
     glsl_program = ctx_data->glsl_program;
 
     if (glsl_program)
@@ -10876,6 +11764,7 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     wine_rb_init(&priv->program_lookup, glsl_program_key_compare);
 
     priv->next_constant_version = 1;
+    priv->constant_ubo_dirty[0] = priv->constant_ubo_dirty[1] = TRUE;
     priv->vertex_pipe = vertex_pipe;
     priv->fragment_pipe = fragment_pipe;
     fragment_pipe->get_caps(gl_info, &fragment_caps);
@@ -10903,7 +11792,13 @@ fail:
 static void shader_glsl_free(struct wined3d_device *device)
 {
     struct shader_glsl_priv *priv = device->shader_priv;
+    const struct wined3d_gl_info *gl_info = &device->adapter->gl_info;
 
+    if (priv->constant_ring_bo)
+    {
+        GL_EXTCALL(glDeleteBuffers(1, &priv->constant_ring_bo));
+        checkGLcall("delete constant ring");
+    }
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
@@ -10924,6 +11819,7 @@ static BOOL shader_glsl_allocate_context_data(struct wined3d_context *context)
     if (!(ctx_data = heap_alloc_zero(sizeof(*ctx_data))))
         return FALSE;
     ctx_data->vertex_color_clamp = GL_FIXED_ONLY_ARB;
+    ctx_data->constant_ubo_offset[0] = ctx_data->constant_ubo_offset[1] = ~0u;
     context->shader_backend_data = ctx_data;
     return TRUE;
 }
@@ -10939,6 +11835,18 @@ static void shader_glsl_init_context_state(struct wined3d_context *context)
 
     gl_info->gl_ops.gl.p_glEnable(GL_PROGRAM_POINT_SIZE);
     checkGLcall("GL_PROGRAM_POINT_SIZE");
+
+    if (shader_glsl_use_parallel_compile(gl_info))
+    {
+        /* Let the driver pick the number of compiler threads. */
+        if (gl_info->supported[ARB_PARALLEL_SHADER_COMPILE])
+            GL_EXTCALL(glMaxShaderCompilerThreadsARB(~0u));
+        else
+            GL_EXTCALL(glMaxShaderCompilerThreadsKHR(~0u));
+        checkGLcall("glMaxShaderCompilerThreads");
+    }
+
+    shader_glsl_load_ffp_cache(context->device->shader_priv, context);
 }
 
 static unsigned int shader_glsl_get_shader_model(const struct wined3d_gl_info *gl_info)
@@ -3263,11 +3263,419 @@ const struct wined3d_shader_backend_ops none_shader_backend =
     shader_none_has_ffp_proj_control,
 };
 
+/* The results of parsing shader byte code are shared between all devices in
+ * the process, so that creating the same shader again, e.g. on another
+ * device or after a device reset, doesn't have to parse it again. Entries
+ * are kept until wined3d is unloaded; loaded shaders may point into them. */
+#define WINED3D_SHADER_REFLECTION_MAX_ENTRIES 4096
+
+struct wined3d_shader_reflection_key
+{
+    DWORD hash;
+    const DWORD *byte_code;
+    SIZE_T byte_code_size;
+    DWORD float_const_count;
+    const struct wined3d_shader_signature *input_signature;
+    const struct wined3d_shader_signature *output_signature;
+};
+
+struct wined3d_shader_reflection
+{
+    struct wine_rb_entry entry;
+    struct wined3d_shader_reflection_key key;
+    struct wined3d_shader_immediate_constant_buffer *icb;
+    /* Only the fields set by shader_get_registers_used() are valid. */
+    struct wined3d_shader shader;
+};
+
+static const struct wined3d_shader_signature shader_reflection_empty_signature;
+
+static int shader_signature_compare(const struct wined3d_shader_signature *a,
+        const struct wined3d_shader_signature *b)
+{
+    const struct wined3d_shader_signature_element *e1, *e2;
+    unsigned int i;
+    int ret;
+
+    if (a->element_count != b->element_count)
+        return a->element_count < b->element_count ? -1 : 1;
+
+    for (i = 0; i < a->element_count; ++i)
+    {
+        e1 = &a->elements[i];
+        e2 = &b->elements[i];
+
+        if (e1->semantic_idx != e2->semantic_idx)
+            return e1->semantic_idx < e2->semantic_idx ? -1 : 1;
+        if (e1->stream_idx != e2->stream_idx)
+            return e1->stream_idx < e2->stream_idx ? -1 : 1;
+        if (e1->sysval_semantic != e2->sysval_semantic)
+            return e1->sysval_semantic < e2->sysval_semantic ? -1 : 1;
+        if (e1->component_type != e2->component_type)
+            return e1->component_type < e2->component_type ? -1 : 1;
+        if (e1->register_idx != e2->register_idx)
+            return e1->register_idx < e2->register_idx ? -1 : 1;
+        if (e1->mask != e2->mask)
+            return e1->mask < e2->mask ? -1 : 1;
+        if ((ret = strcmp(e1->semantic_name, e2->semantic_name)))
+            return ret;
+    }
+
+    return 0;
+}
+
+static int wined3d_shader_reflection_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct wined3d_shader_reflection *r = WINE_RB_ENTRY_VALUE(entry, struct wined3d_shader_reflection, entry);
+    const struct wined3d_shader_reflection_key *k = key;
+    int ret;
+
+    if (k->hash != r->key.hash)
+        return k->hash < r->key.hash ? -1 : 1;
+    if (k->byte_code_size != r->key.byte_code_size)
+        return k->byte_code_size < r->key.byte_code_size ? -1 : 1;
+    if (k->float_const_count != r->key.float_const_count)
+        return k->float_const_count < r->key.float_const_count ? -1 : 1;
+    if ((ret = memcmp(k->byte_code, r->key.byte_code, k->byte_code_size)))
+        return ret;
+    if ((ret = shader_signature_compare(k->input_signature, r->key.input_signature)))
+        return ret;
+    return shader_signature_compare(k->output_signature, r->key.output_signature);
+}
+
+static struct wine_rb_tree shader_reflection_tree = {wined3d_shader_reflection_compare};
+static unsigned int shader_reflection_count;
+
+static CRITICAL_SECTION shader_reflection_cs;
+static CRITICAL_SECTION_DEBUG shader_reflection_cs_debug =
+{
+    0, 0, &shader_reflection_cs,
+    {&shader_reflection_cs_debug.ProcessLocksList,
+    &shader_reflection_cs_debug.ProcessLocksList},
+    0, 0, {(DWORD_PTR)(__FILE__ ": shader_reflection_cs")}
+};
+static CRITICAL_SECTION shader_reflection_cs = {&shader_reflection_cs_debug, -1, 0, 0, 0, 0};
+
+static void shader_reflection_init_key(struct wined3d_shader_reflection_key *key,
+        const struct wined3d_shader *shader, DWORD float_const_count)
+{
+    const BYTE *data = (const BYTE *)shader->function;
+    DWORD hash = 2166136261u;
+    SIZE_T i;
+
+    for (i = 0; i < shader->functionLength; ++i)
+        hash = (hash ^ data[i]) * 16777619u;
+
+    key->hash = hash;
+    key->byte_code = shader->function;
+    key->byte_code_size = shader->functionLength;
+    key->float_const_count = float_const_count;
+    key->input_signature = &shader->input_signature;
+    key->output_signature = &shader->output_signature;
+}
+
+static const DWORD *shader_reflection_rebase(const DWORD *ptr,
+        const struct wined3d_shader *dst, const struct wined3d_shader *src)
+{
+    return ptr ? dst->function + (ptr - src->function) : NULL;
+}
+
+static BOOL shader_reflection_copy_phases(struct wined3d_shader_phase **dst, const struct wined3d_shader_phase *src,
+        unsigned int count, const struct wined3d_shader *dst_shader, const struct wined3d_shader *src_shader)
+{
+    unsigned int i;
+
+    if (!src)
+    {
+        *dst = NULL;
+        return TRUE;
+    }
+
+    if (!(*dst = heap_calloc(max(count, 1), sizeof(**dst))))
+        return FALSE;
+
+    for (i = 0; i < count; ++i)
+    {
+        (*dst)[i] = src[i];
+        (*dst)[i].start = shader_reflection_rebase(src[i].start, dst_shader, src_shader);
+        (*dst)[i].end = shader_reflection_rebase(src[i].end, dst_shader, src_shader);
+    }
+
+    return TRUE;
+}
+
+static BOOL shader_reflection_copy_constants(struct list *dst, const struct list *src)
+{
+    struct wined3d_shader_lconst *lconst, *copy;
+
+    LIST_FOR_EACH_ENTRY(lconst, src, struct wined3d_shader_lconst, entry)
+    {
+        if (!(copy = heap_alloc(sizeof(*copy))))
+            return FALSE;
+        *copy = *lconst;
+        list_add_tail(dst, &copy->entry);
+    }
+
+    return TRUE;
+}
+
+/* Copies everything shader_get_registers_used() computes, except the
+ * signatures, from "src" to "dst". "dst" is expected to be in the state
+ * shader_init() leaves it in. */
+static HRESULT shader_reflection_copy(struct wined3d_shader *dst, const struct wined3d_shader *src,
+        const struct wined3d_shader_immediate_constant_buffer *icb, DWORD float_const_count)
+{
+    const struct wined3d_shader_reg_maps *src_maps = &src->reg_maps;
+    struct wined3d_shader_reg_maps *dst_maps = &dst->reg_maps;
+    const struct wined3d_shader_indexable_temp *temp;
+    struct wined3d_shader_indexable_temp *copy;
+    unsigned int constf_count;
+
+    *dst_maps = *src_maps;
+    dst_maps->constf = NULL;
+    list_init(&dst_maps->indexable_temps);
+    dst_maps->icb = icb;
+    dst_maps->sampler_map.entries = NULL;
+    dst_maps->sampler_map.size = dst_maps->sampler_map.count = 0;
+    dst_maps->tgsm = NULL;
+    dst_maps->tgsm_capacity = dst_maps->tgsm_count = 0;
+
+    dst->limits = src->limits;
+    dst->lconst_inf_or_nan = src->lconst_inf_or_nan;
+    dst->u = src->u;
+    if (src_maps->shader_version.type == WINED3D_SHADER_TYPE_HULL)
+    {
+        dst->u.hs.phases.control_point = NULL;
+        dst->u.hs.phases.fork = dst->u.hs.phases.join = NULL;
+        dst->u.hs.phases.fork_size = dst->u.hs.phases.fork_count;
+        dst->u.hs.phases.join_size = dst->u.hs.phases.join_count;
+        if (!shader_reflection_copy_phases(&dst->u.hs.phases.control_point,
+                src->u.hs.phases.control_point, 1, dst, src)
+                || !shader_reflection_copy_phases(&dst->u.hs.phases.fork,
+                src->u.hs.phases.fork, src->u.hs.phases.fork_count, dst, src)
+                || !shader_reflection_copy_phases(&dst->u.hs.phases.join,
+                src->u.hs.phases.join, src->u.hs.phases.join_count, dst, src))
+            return E_OUTOFMEMORY;
+    }
+
+    constf_count = (min(src->limits->constant_float, float_const_count) + 31) / 32;
+    if (!(dst_maps->constf = heap_calloc(constf_count, sizeof(*dst_maps->constf))))
+        return E_OUTOFMEMORY;
+    memcpy(dst_maps->constf, src_maps->constf, constf_count * sizeof(*dst_maps->constf));
+
+    LIST_FOR_EACH_ENTRY(temp, &src_maps->indexable_temps, struct wined3d_shader_indexable_temp, entry)
+    {
+        if (!(copy = heap_alloc(sizeof(*copy))))
+            return E_OUTOFMEMORY;
+        *copy = *temp;
+        list_add_tail(&dst_maps->indexable_temps, &copy->entry);
+    }
+
+    if (src_maps->sampler_map.count)
+    {
+        if (!(dst_maps->sampler_map.entries = heap_calloc(src_maps->sampler_map.count,
+                sizeof(*dst_maps->sampler_map.entries))))
+            return E_OUTOFMEMORY;
+        memcpy(dst_maps->sampler_map.entries, src_maps->sampler_map.entries,
+                src_maps->sampler_map.count * sizeof(*dst_maps->sampler_map.entries));
+        dst_maps->sampler_map.size = dst_maps->sampler_map.count = src_maps->sampler_map.count;
+    }
+
+    if (src_maps->tgsm_count)
+    {
+        if (!(dst_maps->tgsm = heap_calloc(src_maps->tgsm_count, sizeof(*dst_maps->tgsm))))
+            return E_OUTOFMEMORY;
+        memcpy(dst_maps->tgsm, src_maps->tgsm, src_maps->tgsm_count * sizeof(*dst_maps->tgsm));
+        dst_maps->tgsm_capacity = dst_maps->tgsm_count = src_maps->tgsm_count;
+    }
+
+    if (!shader_reflection_copy_constants(&dst->constantsF, &src->constantsF)
+            || !shader_reflection_copy_constants(&dst->constantsI, &src->constantsI)
+            || !shader_reflection_copy_constants(&dst->constantsB, &src->constantsB))
+        return E_OUTOFMEMORY;
+
+    return WINED3D_OK;
+}
+
+/* The copy owns its semantic name strings, they're stored after the elements. */
+static BOOL shader_reflection_copy_signature(struct wined3d_shader_signature *dst,
+        const struct wined3d_shader_signature *src)
+{
+    SIZE_T size = src->element_count * sizeof(*src->elements);
+    unsigned int i;
+    SIZE_T len;
+    char *ptr;
+
+    dst->element_count = 0;
+    dst->elements = NULL;
+    if (!src->element_count)
+        return TRUE;
+
+    for (i = 0; i < src->element_count; ++i)
+        size += strlen(src->elements[i].semantic_name) + 1;
+    if (!(dst->elements = heap_alloc(size)))
+        return FALSE;
+    dst->element_count = src->element_count;
+
+    ptr = (char *)&dst->elements[dst->element_count];
+    for (i = 0; i < src->element_count; ++i)
+    {
+        dst->elements[i] = src->elements[i];
+        len = strlen(src->elements[i].semantic_name) + 1;
+        memcpy(ptr, src->elements[i].semantic_name, len);
+        dst->elements[i].semantic_name = ptr;
+        ptr += len;
+    }
+
+    return TRUE;
+}
+
+static void shader_reflection_free(struct wined3d_shader_reflection *reflection)
+{
+    struct wined3d_shader *shader = &reflection->shader;
+
+    if (shader->reg_maps.shader_version.type == WINED3D_SHADER_TYPE_HULL)
+    {
+        heap_free(shader->u.hs.phases.control_point);
+        heap_free(shader->u.hs.phases.fork);
+        heap_free(shader->u.hs.phases.join);
+    }
+    heap_free(shader->output_signature.elements);
+    heap_free(shader->input_signature.elements);
+    shader_cleanup_reg_maps(&shader->reg_maps);
+    shader_delete_constant_list(&shader->constantsF);
+    shader_delete_constant_list(&shader->constantsB);
+    shader_delete_constant_list(&shader->constantsI);
+    heap_free(shader->function);
+    heap_free(reflection->icb);
+    heap_free(reflection);
+}
+
+/* Fills in the parse results of "shader" from the cache. Called with the
+ * signatures passed to shader_init(). Returns S_FALSE if the shader isn't
+ * in the cache. */
+static HRESULT shader_reflection_load(struct wined3d_shader *shader, DWORD float_const_count)
+{
+    const struct wined3d_shader_reflection *reflection;
+    struct wined3d_shader_reflection_key key;
+    struct wine_rb_entry *entry;
+    unsigned int i;
+    HRESULT hr;
+
+    shader_reflection_init_key(&key, shader, float_const_count);
+
+    EnterCriticalSection(&shader_reflection_cs);
+    entry = wine_rb_get(&shader_reflection_tree, &key);
+    LeaveCriticalSection(&shader_reflection_cs);
+    if (!entry)
+        return S_FALSE;
+
+    /* Entries don't change once they're in the tree. */
+    reflection = WINE_RB_ENTRY_VALUE(entry, struct wined3d_shader_reflection, entry);
+    TRACE("Using cached reflection %p for shader %p.\n", reflection, shader);
+
+    if (FAILED(hr = shader_reflection_copy(shader, &reflection->shader, reflection->icb, float_const_count)))
+        return hr;
+
+    /* Signatures generated from the shader's declarations. */
+    for (i = 0; i < 2; ++i)
+    {
+        const struct wined3d_shader_signature *src = i ? &reflection->shader.output_signature
+                : &reflection->shader.input_signature;
+        struct wined3d_shader_signature *dst = i ? &shader->output_signature : &shader->input_signature;
+
+        if (dst->element_count || !src->element_count)
+            continue;
+        if (!(dst->elements = heap_calloc(src->element_count, sizeof(*dst->elements))))
+            return E_OUTOFMEMORY;
+        memcpy(dst->elements, src->elements, src->element_count * sizeof(*dst->elements));
+        dst->element_count = src->element_count;
+    }
+
+    return WINED3D_OK;
+}
+
+static void shader_reflection_store(struct wined3d_shader *shader, DWORD float_const_count,
+        BOOL input_generated, BOOL output_generated)
+{
+    struct wined3d_shader_reflection *reflection;
+    struct wined3d_shader *copy;
+
+    if (shader_reflection_count >= WINED3D_SHADER_REFLECTION_MAX_ENTRIES)
+        return;
+
+    if (!(reflection = heap_alloc_zero(sizeof(*reflection))))
+        return;
+    copy = &reflection->shader;
+    list_init(&copy->constantsF);
+    list_init(&copy->constantsB);
+    list_init(&copy->constantsI);
+    list_init(&copy->reg_maps.indexable_temps);
+
+    if (!(copy->function = heap_alloc(shader->functionLength)))
+    {
+        heap_free(reflection);
+        return;
+    }
+    memcpy(copy->function, shader->function, shader->functionLength);
+    copy->functionLength = shader->functionLength;
+
+    if (shader->reg_maps.icb)
+    {
+        if (!(reflection->icb = heap_alloc(sizeof(*reflection->icb))))
+        {
+            shader_reflection_free(reflection);
+            return;
+        }
+        *reflection->icb = *shader->reg_maps.icb;
+    }
+
+    if (FAILED(shader_reflection_copy(copy, shader, reflection->icb, float_const_count))
+            || !shader_reflection_copy_signature(&copy->input_signature, &shader->input_signature)
+            || !shader_reflection_copy_signature(&copy->output_signature, &shader->output_signature))
+    {
+        shader_reflection_free(reflection);
+        return;
+    }
+
+    shader_reflection_init_key(&reflection->key, copy, float_const_count);
+    if (input_generated)
+        reflection->key.input_signature = &shader_reflection_empty_signature;
+    if (output_generated)
+        reflection->key.output_signature = &shader_reflection_empty_signature;
+
+    EnterCriticalSection(&shader_reflection_cs);
+    if (wine_rb_put(&shader_reflection_tree, &reflection->key, &reflection->entry) == -1)
+    {
+        /* Another thread got there first. */
+        LeaveCriticalSection(&shader_reflection_cs);
+        shader_reflection_free(reflection);
+        return;
+    }
+    ++shader_reflection_count;
+    LeaveCriticalSection(&shader_reflection_cs);
+
+    TRACE("Stored reflection %p for shader %p.\n", reflection, shader);
+}
+
+static void shader_reflection_destroy(struct wine_rb_entry *entry, void *context)
+{
+    shader_reflection_free(WINE_RB_ENTRY_VALUE(entry, struct wined3d_shader_reflection, entry));
+}
+
+void wined3d_shader_cleanup_reflection_cache(void)
+{
+    wine_rb_destroy(&shader_reflection_tree, shader_reflection_destroy, NULL);
+    shader_reflection_count = 0;
+    DeleteCriticalSection(&shader_reflection_cs);
+}
+
 static HRESULT shader_set_function(struct wined3d_shader *shader, DWORD float_const_count,
         enum wined3d_shader_type type, unsigned int max_version)
 {
     struct wined3d_shader_reg_maps *reg_maps = &shader->reg_maps;
     const struct wined3d_shader_frontend *fe;
+    BOOL input_generated, output_generated;
     HRESULT hr;
     unsigned int backend_version;
     const struct wined3d_d3d_info *d3d_info = &shader->device->adapter->d3d_info;
@@ -3288,9 +3696,19 @@ static HRESULT shader_set_function(struct wined3d_shader *shader, DWORD float_co
         shader_trace_init(fe, shader->frontend_data);
 
     /* Second pass: figure out which registers are used, what the semantics are, etc. */
-    if (FAILED(hr = shader_get_registers_used(shader, fe, reg_maps, &shader->input_signature,
-            &shader->output_signature, float_const_count)))
+    if ((hr = shader_reflection_load(shader, float_const_count)) == S_FALSE)
+    {
+        input_generated = !shader->input_signature.element_count;
+        output_generated = !shader->output_signature.element_count;
+        if (FAILED(hr = shader_get_registers_used(shader, fe, reg_maps, &shader->input_signature,
+                &shader->output_signature, float_const_count)))
+            return hr;
+        shader_reflection_store(shader, float_const_count, input_generated, output_generated);
+    }
+    else if (FAILED(hr))
+    {
         return hr;
+    }
 
     if (reg_maps->shader_version.type != type)
     {
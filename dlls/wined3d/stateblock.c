@@ -957,10 +957,21 @@ static void apply_lights(struct wined3d_device *device, const struct wined3d_sta
     }
 }
 
+/* Returns the number of consecutive constant indices starting at contained[i],
+ * so that each range can be applied with a single call. */
+static unsigned int get_constant_run(const DWORD *contained, unsigned int i, unsigned int contained_count)
+{
+    unsigned int count = 1;
+
+    while (i + count < contained_count && contained[i + count] == contained[i] + count)
+        ++count;
+    return count;
+}
+
 void CDECL wined3d_stateblock_apply(const struct wined3d_stateblock *stateblock)
 {
     struct wined3d_device *device = stateblock->device;
-    unsigned int i;
+    unsigned int i, start, count;
     DWORD map;
 
     TRACE("Applying stateblock %p to device %p.\n", stateblock, device);
@@ -969,20 +980,23 @@ void CDECL wined3d_stateblock_apply(const struct wined3d_stateblock *stateblock)
         wined3d_device_set_vertex_shader(device, stateblock->state.shader[WINED3D_SHADER_TYPE_VERTEX]);
 
     /* Vertex Shader Constants. */
-    for (i = 0; i < stateblock->num_contained_vs_consts_f; ++i)
+    for (i = 0; i < stateblock->num_contained_vs_consts_f; i += count)
     {
-        wined3d_device_set_vs_consts_f(device, stateblock->contained_vs_consts_f[i],
-                1, &stateblock->state.vs_consts_f[stateblock->contained_vs_consts_f[i]]);
+        start = stateblock->contained_vs_consts_f[i];
+        count = get_constant_run(stateblock->contained_vs_consts_f, i, stateblock->num_contained_vs_consts_f);
+        wined3d_device_set_vs_consts_f(device, start, count, &stateblock->state.vs_consts_f[start]);
     }
-    for (i = 0; i < stateblock->num_contained_vs_consts_i; ++i)
+    for (i = 0; i < stateblock->num_contained_vs_consts_i; i += count)
     {
-        wined3d_device_set_vs_consts_i(device, stateblock->contained_vs_consts_i[i],
-                1, &stateblock->state.vs_consts_i[stateblock->contained_vs_consts_i[i]]);
+        start = stateblock->contained_vs_consts_i[i];
+        count = get_constant_run(stateblock->contained_vs_consts_i, i, stateblock->num_contained_vs_consts_i);
+        wined3d_device_set_vs_consts_i(device, start, count, &stateblock->state.vs_consts_i[start]);
     }
-    for (i = 0; i < stateblock->num_contained_vs_consts_b; ++i)
+    for (i = 0; i < stateblock->num_contained_vs_consts_b; i += count)
     {
-        wined3d_device_set_vs_consts_b(device, stateblock->contained_vs_consts_b[i],
-                1, &stateblock->state.vs_consts_b[stateblock->contained_vs_consts_b[i]]);
+        start = stateblock->contained_vs_consts_b[i];
+        count = get_constant_run(stateblock->contained_vs_consts_b, i, stateblock->num_contained_vs_consts_b);
+        wined3d_device_set_vs_consts_b(device, start, count, &stateblock->state.vs_consts_b[start]);
     }
 
     apply_lights(device, &stateblock->state);
@@ -991,20 +1005,23 @@ void CDECL wined3d_stateblock_apply(const struct wined3d_stateblock *stateblock)
         wined3d_device_set_pixel_shader(device, stateblock->state.shader[WINED3D_SHADER_TYPE_PIXEL]);
 
     /* Pixel Shader Constants. */
-    for (i = 0; i < stateblock->num_contained_ps_consts_f; ++i)
+    for (i = 0; i < stateblock->num_contained_ps_consts_f; i += count)
     {
-        wined3d_device_set_ps_consts_f(device, stateblock->contained_ps_consts_f[i],
-                1, &stateblock->state.ps_consts_f[stateblock->contained_ps_consts_f[i]]);
+        start = stateblock->contained_ps_consts_f[i];
+        count = get_constant_run(stateblock->contained_ps_consts_f, i, stateblock->num_contained_ps_consts_f);
+        wined3d_device_set_ps_consts_f(device, start, count, &stateblock->state.ps_consts_f[start]);
     }
-    for (i = 0; i < stateblock->num_contained_ps_consts_i; ++i)
+    for (i = 0; i < stateblock->num_contained_ps_consts_i; i += count)
     {
-        wined3d_device_set_ps_consts_i(device, stateblock->contained_ps_consts_i[i],
-                1, &stateblock->state.ps_consts_i[stateblock->contained_ps_consts_i[i]]);
+        start = stateblock->contained_ps_consts_i[i];
+        count = get_constant_run(stateblock->contained_ps_consts_i, i, stateblock->num_contained_ps_consts_i);
+        wined3d_device_set_ps_consts_i(device, start, count, &stateblock->state.ps_consts_i[start]);
     }
-    for (i = 0; i < stateblock->num_contained_ps_consts_b; ++i)
+    for (i = 0; i < stateblock->num_contained_ps_consts_b; i += count)
     {
-        wined3d_device_set_ps_consts_b(device, stateblock->contained_ps_consts_b[i],
-                1, &stateblock->state.ps_consts_b[stateblock->contained_ps_consts_b[i]]);
+        start = stateblock->contained_ps_consts_b[i];
+        count = get_constant_run(stateblock->contained_ps_consts_b, i, stateblock->num_contained_ps_consts_b);
+        wined3d_device_set_ps_consts_b(device, start, count, &stateblock->state.ps_consts_b[start]);
     }
 
     /* Render states. */
@@ -30,6 +30,10 @@
 #include "wine/port.h"
 #include "wined3d_private.h"
 
+#ifdef WINED3D_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
@@ -636,6 +640,7 @@ static void surface_download_data(struct wined3d_surface *surface, const struct
 
         f = *format;
         f.byte_count = format->conv_byte_count;
+        f.flags[WINED3D_GL_RES_TYPE_TEX_2D] &= ~WINED3DFMT_FLAG_BLOCKS;
         wined3d_texture_get_pitch(texture, level, &dst_row_pitch, &dst_slice_pitch);
         wined3d_format_calculate_pitch(&f, texture->resource.device->surface_alignment,
                 wined3d_texture_get_level_width(texture, level),
@@ -1142,6 +1147,50 @@ static void convert_r32_float_r16_float(const BYTE *src, BYTE *dst,
     }
 }
 
+#ifdef WINED3D_HAVE_SSE2
+/* The scalar version's lookup tables round x * 255 / 31 and x * 255 / 63,
+ * which is the same as (x * 527 + 23) >> 6 and (x * 259 + 33) >> 6. */
+static void WINED3D_SSE2 convert_r5g6b5_x8r8g8b8_sse2(const BYTE *src, BYTE *dst,
+        DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
+{
+    const __m128i mask5 = _mm_set1_epi16(0x1f), mask6 = _mm_set1_epi16(0x3f);
+    const __m128i mul5 = _mm_set1_epi16(527), mul6 = _mm_set1_epi16(259);
+    const __m128i round5 = _mm_set1_epi16(23), round6 = _mm_set1_epi16(33);
+    const __m128i alpha = _mm_set1_epi16(0xff00);
+    __m128i pixels, r, g, b, bg, ra;
+    unsigned int x, y;
+
+    for (y = 0; y < h; ++y)
+    {
+        const WORD *src_line = (const WORD *)(src + y * pitch_in);
+        DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
+
+        for (x = 0; x + 8 <= w; x += 8)
+        {
+            pixels = _mm_loadu_si128((const __m128i *)&src_line[x]);
+            r = _mm_srli_epi16(pixels, 11);
+            g = _mm_and_si128(_mm_srli_epi16(pixels, 5), mask6);
+            b = _mm_and_si128(pixels, mask5);
+            r = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(r, mul5), round5), 6);
+            g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, mul6), round6), 6);
+            b = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(b, mul5), round5), 6);
+            bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+            ra = _mm_or_si128(r, alpha);
+            _mm_storeu_si128((__m128i *)&dst_line[x], _mm_unpacklo_epi16(bg, ra));
+            _mm_storeu_si128((__m128i *)&dst_line[x + 4], _mm_unpackhi_epi16(bg, ra));
+        }
+        for (; x < w; ++x)
+        {
+            WORD pixel = src_line[x];
+            dst_line[x] = 0xff000000u
+                    | (((pixel >> 11) * 527 + 23) >> 6) << 16
+                    | ((((pixel >> 5) & 0x3f) * 259 + 33) >> 6) << 8
+                    | (((pixel & 0x1f) * 527 + 23) >> 6);
+        }
+    }
+}
+#endif
+
 static void convert_r5g6b5_x8r8g8b8(const BYTE *src, BYTE *dst,
         DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
 {
@@ -1167,6 +1216,14 @@ static void convert_r5g6b5_x8r8g8b8(const BYTE *src, BYTE *dst,
 
     TRACE("Converting %ux%u pixels, pitches %u %u.\n", w, h, pitch_in, pitch_out);
 
+#ifdef WINED3D_HAVE_SSE2
+    if (wined3d_cpu_has_sse2())
+    {
+        convert_r5g6b5_x8r8g8b8_sse2(src, dst, pitch_in, pitch_out, w, h);
+        return;
+    }
+#endif
+
     for (y = 0; y < h; ++y)
     {
         const WORD *src_line = (const WORD *)(src + y * pitch_in);
@@ -1182,6 +1239,31 @@ static void convert_r5g6b5_x8r8g8b8(const BYTE *src, BYTE *dst,
     }
 }
 
+#ifdef WINED3D_HAVE_SSE2
+static void WINED3D_SSE2 convert_a8r8g8b8_x8r8g8b8_sse2(const BYTE *src, BYTE *dst,
+        DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
+{
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    unsigned int x, y;
+
+    for (y = 0; y < h; ++y)
+    {
+        const DWORD *src_line = (const DWORD *)(src + y * pitch_in);
+        DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
+
+        for (x = 0; x + 4 <= w; x += 4)
+        {
+            _mm_storeu_si128((__m128i *)&dst_line[x],
+                    _mm_or_si128(_mm_loadu_si128((const __m128i *)&src_line[x]), alpha));
+        }
+        for (; x < w; ++x)
+        {
+            dst_line[x] = 0xff000000 | src_line[x];
+        }
+    }
+}
+#endif
+
 /* We use this for both B8G8R8A8 -> B8G8R8X8 and B8G8R8X8 -> B8G8R8A8, since
  * in both cases we're just setting the X / Alpha channel to 0xff. */
 static void convert_a8r8g8b8_x8r8g8b8(const BYTE *src, BYTE *dst,
@@ -1191,6 +1273,14 @@ static void convert_a8r8g8b8_x8r8g8b8(const BYTE *src, BYTE *dst,
 
     TRACE("Converting %ux%u pixels, pitches %u %u.\n", w, h, pitch_in, pitch_out);
 
+#ifdef WINED3D_HAVE_SSE2
+    if (wined3d_cpu_has_sse2())
+    {
+        convert_a8r8g8b8_x8r8g8b8_sse2(src, dst, pitch_in, pitch_out, w, h);
+        return;
+    }
+#endif
+
     for (y = 0; y < h; ++y)
     {
         const DWORD *src_line = (const DWORD *)(src + y * pitch_in);
@@ -1208,6 +1298,77 @@ static inline BYTE cliptobyte(int x)
     return (BYTE)((x < 0) ? 0 : ((x > 255) ? 255 : x));
 }
 
+#ifdef WINED3D_HAVE_SSE2
+/* Same as the scalar version below, four pixels at a time. The U and V values
+ * are paired with the Y values and a constant 1 so that each channel can be
+ * computed with two _mm_madd_epi16() calls. */
+static void WINED3D_SSE2 convert_yuy2_x8r8g8b8_sse2(const BYTE *src, BYTE *dst,
+        DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
+{
+    const __m128i bias = _mm_setr_epi16(16, 128, 16, 128, 16, 128, 16, 128);
+    const __m128i v_mask = _mm_setr_epi16(-1, 0, -1, 0, -1, 0, -1, 0);
+    const __m128i one = _mm_setr_epi16(0, 1, 0, 1, 0, 1, 0, 1);
+    const __m128i r_yu = _mm_setr_epi16(298, 0, 298, 0, 298, 0, 298, 0);
+    const __m128i r_v1 = _mm_setr_epi16(409, 128, 409, 128, 409, 128, 409, 128);
+    const __m128i g_yu = _mm_setr_epi16(298, -100, 298, -100, 298, -100, 298, -100);
+    const __m128i g_v1 = _mm_setr_epi16(-208, 128, -208, 128, -208, 128, -208, 128);
+    const __m128i b_yu = _mm_setr_epi16(298, 516, 298, 516, 298, 516, 298, 516);
+    const __m128i b_v1 = _mm_setr_epi16(0, 128, 0, 128, 0, 128, 0, 128);
+    const __m128i alpha = _mm_set1_epi32(0xff);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i yuyv, yu, v1, r, g, b, t;
+    int c2, d, e, r2 = 0, g2 = 0, b2 = 0;
+    unsigned int x, y;
+
+    for (y = 0; y < h; ++y)
+    {
+        const BYTE *src_line = src + y * pitch_in;
+        DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
+
+        for (x = 0; x + 4 <= w; x += 4)
+        {
+            /* C0 D0 C1 E0 C2 D1 C3 E1 */
+            yuyv = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src_line), zero), bias);
+            /* C0 D0 C1 D0 C2 D1 C3 D1 */
+            yu = _mm_shufflehi_epi16(_mm_shufflelo_epi16(yuyv, _MM_SHUFFLE(1, 2, 1, 0)), _MM_SHUFFLE(1, 2, 1, 0));
+            /* E0 1 E0 1 E1 1 E1 1 */
+            v1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(yuyv, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            v1 = _mm_or_si128(_mm_and_si128(v1, v_mask), one);
+
+            r = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu, r_yu), _mm_madd_epi16(v1, r_v1)), 8);
+            g = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu, g_yu), _mm_madd_epi16(v1, g_v1)), 8);
+            b = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu, b_yu), _mm_madd_epi16(v1, b_v1)), 8);
+
+            /* Saturating to bytes does the clipping. We get B0-B3 G0-G3 R0-R3
+             * A0-A3, and interleave that twice to get B0 G0 R0 A0 B1 ... */
+            t = _mm_packus_epi16(_mm_packs_epi32(b, g), _mm_packs_epi32(r, alpha));
+            t = _mm_unpacklo_epi8(t, _mm_srli_si128(t, 8));
+            t = _mm_unpacklo_epi8(t, _mm_srli_si128(t, 8));
+            _mm_storeu_si128((__m128i *)&dst_line[x], t);
+
+            src_line += 8;
+        }
+        for (; x < w; ++x)
+        {
+            if (!(x & 1))
+            {
+                d = (int) src_line[1] - 128;
+                e = (int) src_line[3] - 128;
+                r2 = 409 * e + 128;
+                g2 = - 100 * d - 208 * e + 128;
+                b2 = 516 * d + 128;
+            }
+            c2 = 298 * ((int) src_line[0] - 16);
+            dst_line[x] = 0xff000000
+                | cliptobyte((c2 + r2) >> 8) << 16
+                | cliptobyte((c2 + g2) >> 8) << 8
+                | cliptobyte((c2 + b2) >> 8);
+            src_line += 2;
+        }
+    }
+}
+#endif
+
 static void convert_yuy2_x8r8g8b8(const BYTE *src, BYTE *dst,
         DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
 {
@@ -1216,6 +1377,14 @@ static void convert_yuy2_x8r8g8b8(const BYTE *src, BYTE *dst,
 
     TRACE("Converting %ux%u pixels, pitches %u %u.\n", w, h, pitch_in, pitch_out);
 
+#ifdef WINED3D_HAVE_SSE2
+    if (wined3d_cpu_has_sse2())
+    {
+        convert_yuy2_x8r8g8b8_sse2(src, dst, pitch_in, pitch_out, w, h);
+        return;
+    }
+#endif
+
     for (y = 0; y < h; ++y)
     {
         const BYTE *src_line = src + y * pitch_in;
@@ -2383,6 +2552,8 @@ static BOOL surface_load_texture(struct wined3d_surface *surface,
     {
         /* This code is entered for texture formats which need a fixup. */
         format.byte_count = format.conv_byte_count;
+        /* Block based formats get decompressed. */
+        format.flags[WINED3D_GL_RES_TYPE_TEX_2D] &= ~WINED3DFMT_FLAG_BLOCKS;
         wined3d_format_calculate_pitch(&format, 1, width, height, &dst_row_pitch, &dst_slice_pitch);
 
         src_mem = context_map_bo_address(context, &data, src_slice_pitch,
@@ -2428,6 +2599,16 @@ static BOOL surface_load_texture(struct wined3d_surface *surface,
         data.addr = dst_mem;
     }
 
+    else if (!srgb && sub_resource->partial_upload)
+    {
+        /* Only the dirty region of the system memory copy differs from the
+         * texture. */
+        TRACE("Uploading dirty region %s of surface %p.\n", wine_dbgstr_rect(&sub_resource->dirty_rect), surface);
+        src_rect = sub_resource->dirty_rect;
+        dst_point.x = src_rect.left;
+        dst_point.y = src_rect.top;
+    }
+
     wined3d_surface_upload_data(surface, gl_info, &format, &src_rect,
             src_row_pitch, &dst_point, srgb, wined3d_const_bo_address(&data));
 
@@ -3177,6 +3358,7 @@ static HRESULT surface_cpu_blt(struct wined3d_texture *dst_texture, unsigned int
         texture_level = dst_sub_resource_idx % dst_texture->level_count;
         if (!wined3d_texture_load_location(dst_texture, dst_sub_resource_idx, context, map_binding))
             ERR("Failed to load the destination sub-resource into %s.\n", wined3d_debug_location(map_binding));
+        wined3d_texture_add_sysmem_dirty_region(dst_texture, dst_sub_resource_idx, dst_box, 0);
         wined3d_texture_invalidate_location(dst_texture, dst_sub_resource_idx, ~map_binding);
         wined3d_texture_get_pitch(dst_texture, texture_level, &dst_map.row_pitch, &dst_map.slice_pitch);
         wined3d_texture_get_memory(dst_texture, dst_sub_resource_idx, &dst_data, map_binding);
@@ -3224,6 +3406,7 @@ static HRESULT surface_cpu_blt(struct wined3d_texture *dst_texture, unsigned int
         texture_level = dst_sub_resource_idx % dst_texture->level_count;
         if (!wined3d_texture_load_location(dst_texture, dst_sub_resource_idx, context, map_binding))
             ERR("Failed to load the destination sub-resource into %s.\n", wined3d_debug_location(map_binding));
+        wined3d_texture_add_sysmem_dirty_region(dst_texture, dst_sub_resource_idx, dst_box, 0);
         wined3d_texture_invalidate_location(dst_texture, dst_sub_resource_idx, ~map_binding);
         wined3d_texture_get_pitch(dst_texture, texture_level, &dst_map.row_pitch, &dst_map.slice_pitch);
         wined3d_texture_get_memory(dst_texture, dst_sub_resource_idx, &dst_data, map_binding);
@@ -3664,6 +3847,7 @@ static void surface_cpu_blt_colour_fill(struct wined3d_rendertarget_view *view,
     map_binding = texture->resource.map_binding;
     if (!wined3d_texture_load_location(texture, view->sub_resource_idx, context, map_binding))
         ERR("Failed to load the sub-resource into %s.\n", wined3d_debug_location(map_binding));
+    wined3d_texture_add_sysmem_dirty_region(texture, view->sub_resource_idx, box, 0);
     wined3d_texture_invalidate_location(texture, view->sub_resource_idx, ~map_binding);
     wined3d_texture_get_pitch(texture, view->sub_resource_idx % texture->level_count,
             &map.row_pitch, &map.slice_pitch);
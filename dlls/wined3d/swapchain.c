@@ -95,6 +95,9 @@ static void swapchain_cleanup(struct wined3d_swapchain *swapchain)
         wined3d_release_dc(swapchain->backup_wnd, swapchain->backup_dc);
         DestroyWindow(swapchain->backup_wnd);
     }
+
+    if (swapchain->frame_latency_event)
+        CloseHandle(swapchain->frame_latency_event);
 }
 
 ULONG CDECL wined3d_swapchain_incref(struct wined3d_swapchain *swapchain)
@@ -176,6 +179,7 @@ HRESULT CDECL wined3d_swapchain_present(struct wined3d_swapchain *swapchain,
         dst_rect = &d;
     }
 
+    device_manage_residency(swapchain->device);
     wined3d_cs_emit_present(swapchain->device->cs, swapchain, src_rect,
             dst_rect, dst_window_override, flags);
 
@@ -259,6 +263,41 @@ struct wined3d_device * CDECL wined3d_swapchain_get_device(const struct wined3d_
     return swapchain->device;
 }
 
+/* The returned semaphore is released by the CS each time a present of the
+ * swapchain completes. It's only available for swapchains created with
+ * WINED3D_SWAPCHAIN_FRAME_LATENCY_WAITABLE. */
+HANDLE CDECL wined3d_swapchain_get_frame_latency_event(const struct wined3d_swapchain *swapchain)
+{
+    TRACE("swapchain %p.\n", swapchain);
+
+    return swapchain->frame_latency_event;
+}
+
+HRESULT CDECL wined3d_swapchain_set_max_frame_latency(struct wined3d_swapchain *swapchain,
+        unsigned int max_frame_latency)
+{
+    TRACE("swapchain %p, max_frame_latency %u.\n", swapchain, max_frame_latency);
+
+    if (!swapchain->frame_latency_event || !max_frame_latency || max_frame_latency > WINED3D_MAX_FRAME_LATENCY)
+        return WINED3DERR_INVALIDCALL;
+
+    /* Like on Windows, lowering the latency only takes effect once the
+     * application has consumed the frames it was already allowed. */
+    if (max_frame_latency > swapchain->max_frame_latency)
+        ReleaseSemaphore(swapchain->frame_latency_event,
+                max_frame_latency - swapchain->max_frame_latency, NULL);
+    swapchain->max_frame_latency = max_frame_latency;
+
+    return WINED3D_OK;
+}
+
+unsigned int CDECL wined3d_swapchain_get_max_frame_latency(const struct wined3d_swapchain *swapchain)
+{
+    TRACE("swapchain %p.\n", swapchain);
+
+    return swapchain->max_frame_latency;
+}
+
 void CDECL wined3d_swapchain_get_desc(const struct wined3d_swapchain *swapchain,
         struct wined3d_swapchain_desc *desc)
 {
@@ -471,6 +510,9 @@ static void swapchain_gl_present(struct wined3d_swapchain *swapchain,
     if (swapchain->render_to_fbo)
         swapchain_blit(swapchain, context, src_rect, dst_rect);
 
+    if (swapchain->device->cs->profile)
+        wined3d_cs_profile_present(swapchain->device->cs, context, back_buffer);
+
     if (swapchain->num_contexts > 1)
         gl_info->gl_ops.gl.p_glFinish();
 
@@ -491,6 +533,8 @@ static void swapchain_gl_present(struct wined3d_swapchain *swapchain,
         {
             TRACE_(fps)("%p @ approx %.2ffps\n",
                     swapchain, 1000.0 * swapchain->frames / (time - swapchain->prev_time));
+            TRACE_(fps)("%p %u redundant state changes elided\n",
+                    swapchain, InterlockedExchange(&swapchain->device->elided_state_count, 0));
             swapchain->prev_time = time;
             swapchain->frames = 0;
         }
@@ -502,9 +546,11 @@ static void swapchain_gl_present(struct wined3d_swapchain *swapchain,
      * and INTEXTURE copies can keep their old content if they have any defined content.
      * If the swapeffect is COPY, the content remains the same.
      *
-     * The FLIP swap effect is not implemented yet. We could mark WINED3D_LOCATION_DRAWABLE
-     * up to date and hope WGL flipped front and back buffers and read this data into
-     * the FBO. Don't bother about this for now. */
+     * FLIP_DISCARD swapchains usually render to the drawable directly, whose
+     * contents are undefined after wglSwapBuffers(). FLIP_SEQUENTIAL is still
+     * rendered through an FBO. We could mark WINED3D_LOCATION_DRAWABLE up to
+     * date and hope WGL flipped front and back buffers, but don't bother about
+     * this for now. */
     if (swapchain->desc.swap_effect == WINED3D_SWAP_EFFECT_DISCARD
             || swapchain->desc.swap_effect == WINED3D_SWAP_EFFECT_FLIP_DISCARD)
         wined3d_texture_validate_location(swapchain->back_buffers[swapchain->desc.backbuffer_count - 1],
@@ -618,6 +664,8 @@ static void swapchain_gdi_present(struct wined3d_swapchain *swapchain,
         if (time - prev_time > 1500)
         {
             TRACE_(fps)("@ approx %.2ffps\n", 1000.0 * frames / (time - prev_time));
+            TRACE_(fps)("%u redundant state changes elided\n",
+                    InterlockedExchange(&swapchain->device->elided_state_count, 0));
             prev_time = time;
             frames = 0;
         }
@@ -647,6 +695,21 @@ static void swapchain_update_render_to_fbo(struct wined3d_swapchain *swapchain)
         return;
     }
 
+    /* Flip-discard back buffers have undefined contents after a present, so
+     * they can be rendered to the drawable directly and presented without the
+     * intermediate blit. swapchain_gl_present() still switches to the FBO if
+     * the presented rectangles don't cover the whole back buffer. Only back
+     * buffer 0 is writable in this model, so there's nothing to rotate. */
+    if (swapchain->desc.swap_effect == WINED3D_SWAP_EFFECT_FLIP_DISCARD
+            && swapchain->desc.multisample_type == WINED3D_MULTISAMPLE_NONE
+            && !is_complex_fixup(wined3d_get_format(&swapchain->device->adapter->gl_info,
+            swapchain->desc.backbuffer_format, WINED3DUSAGE_RENDERTARGET)->color_fixup))
+    {
+        TRACE("Rendering flip-discard swapchain to the drawable.\n");
+        swapchain->render_to_fbo = FALSE;
+        return;
+    }
+
     TRACE("Rendering to FBO.\n");
     swapchain->render_to_fbo = TRUE;
 }
@@ -780,6 +843,7 @@ static HRESULT swapchain_init(struct wined3d_swapchain *swapchain, struct wined3
 
     if (desc->swap_effect != WINED3D_SWAP_EFFECT_DISCARD
             && desc->swap_effect != WINED3D_SWAP_EFFECT_SEQUENTIAL
+            && desc->swap_effect != WINED3D_SWAP_EFFECT_FLIP_DISCARD
             && desc->swap_effect != WINED3D_SWAP_EFFECT_COPY)
         FIXME("Unimplemented swap effect %#x.\n", desc->swap_effect);
 
@@ -831,6 +895,18 @@ static HRESULT swapchain_init(struct wined3d_swapchain *swapchain, struct wined3
             &swapchain->desc.multisample_type, &swapchain->desc.multisample_quality);
     swapchain_update_render_to_fbo(swapchain);
 
+    if (swapchain->desc.flags & WINED3D_SWAPCHAIN_FRAME_LATENCY_WAITABLE)
+    {
+        swapchain->max_frame_latency = 1;
+        if (!(swapchain->frame_latency_event = CreateSemaphoreW(NULL,
+                swapchain->max_frame_latency, WINED3D_MAX_FRAME_LATENCY, NULL)))
+        {
+            ERR("Failed to create frame latency semaphore, error %u.\n", GetLastError());
+            hr = HRESULT_FROM_WIN32(GetLastError());
+            goto err;
+        }
+    }
+
     TRACE("Creating front buffer.\n");
 
     texture_desc.resource_type = WINED3D_RTYPE_TEXTURE_2D;
@@ -1004,6 +1080,9 @@ err:
         wined3d_texture_decref(swapchain->front_buffer);
     }
 
+    if (swapchain->frame_latency_event)
+        CloseHandle(swapchain->frame_latency_event);
+
     return hr;
 }
 
@@ -139,6 +139,8 @@ void wined3d_texture_validate_location(struct wined3d_texture *texture,
     sub_resource = &texture->sub_resources[sub_resource_idx];
     previous_locations = sub_resource->locations;
     sub_resource->locations |= location;
+    if (location & WINED3D_LOCATION_TEXTURE_RGB)
+        sub_resource->partial_upload = FALSE;
     if (previous_locations == WINED3D_LOCATION_SYSMEM && location != WINED3D_LOCATION_SYSMEM
             && !--texture->sysmem_count)
         wined3d_texture_evict_sysmem(texture);
@@ -166,6 +168,8 @@ void wined3d_texture_invalidate_location(struct wined3d_texture *texture,
     sub_resource = &texture->sub_resources[sub_resource_idx];
     previous_locations = sub_resource->locations;
     sub_resource->locations &= ~location;
+    if (location & WINED3D_LOCATION_SYSMEM)
+        sub_resource->partial_upload = FALSE;
     if (previous_locations != WINED3D_LOCATION_SYSMEM && sub_resource->locations == WINED3D_LOCATION_SYSMEM)
         ++texture->sysmem_count;
 
@@ -176,6 +180,47 @@ void wined3d_texture_invalidate_location(struct wined3d_texture *texture,
                 sub_resource_idx, texture);
 }
 
+/* Called before the CPU writes "box" of the system memory copy of a
+ * sub-resource, and before the other locations get invalidated. As long as
+ * the texture keeps its system memory copy, the next upload only needs to
+ * cover the accumulated dirty region. */
+void wined3d_texture_add_sysmem_dirty_region(struct wined3d_texture *texture,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, DWORD flags)
+{
+    struct wined3d_texture_sub_resource *sub_resource = &texture->sub_resources[sub_resource_idx];
+    unsigned int level = sub_resource_idx % texture->level_count;
+    RECT rect;
+
+    if (!(texture->flags & WINED3D_TEXTURE_PIN_SYSMEM) || !(texture->flags & WINED3D_TEXTURE_RGB_ALLOCATED)
+            || texture->resource.type != WINED3D_RTYPE_TEXTURE_2D
+            || texture->resource.map_binding != WINED3D_LOCATION_SYSMEM
+            || (flags & WINED3D_MAP_DISCARD) || !(sub_resource->locations & WINED3D_LOCATION_SYSMEM)
+            || !(sub_resource->partial_upload || (sub_resource->locations & WINED3D_LOCATION_TEXTURE_RGB)))
+    {
+        sub_resource->partial_upload = FALSE;
+        return;
+    }
+
+    if (box)
+        SetRect(&rect, box->left, box->top, box->right, box->bottom);
+    else
+        SetRect(&rect, 0, 0, wined3d_texture_get_level_width(texture, level),
+                wined3d_texture_get_level_height(texture, level));
+
+    if (sub_resource->partial_upload)
+    {
+        UnionRect(&sub_resource->dirty_rect, &sub_resource->dirty_rect, &rect);
+    }
+    else
+    {
+        sub_resource->dirty_rect = rect;
+        sub_resource->partial_upload = TRUE;
+    }
+
+    TRACE("Dirty region of sub-resource %u of texture %p is %s.\n",
+            sub_resource_idx, texture, wine_dbgstr_rect(&sub_resource->dirty_rect));
+}
+
 static BOOL wined3d_texture_copy_sysmem_location(struct wined3d_texture *texture,
         unsigned int sub_resource_idx, struct wined3d_context *context, DWORD location)
 {
@@ -566,9 +611,14 @@ static void wined3d_texture_allocate_gl_immutable_storage(struct wined3d_texture
 
 static void wined3d_texture_unload_gl_texture(struct wined3d_texture *texture)
 {
+    unsigned int sub_count = texture->level_count * texture->layer_count;
     struct wined3d_device *device = texture->resource.device;
     const struct wined3d_gl_info *gl_info = NULL;
     struct wined3d_context *context = NULL;
+    unsigned int i;
+
+    for (i = 0; i < sub_count; ++i)
+        texture->sub_resources[i].partial_upload = FALSE;
 
     if (texture->texture_rgb.name || texture->texture_srgb.name
             || texture->rb_multisample || texture->rb_resolved)
@@ -601,6 +651,12 @@ static void wined3d_texture_unload_gl_texture(struct wined3d_texture *texture)
 
     if (context) context_release(context);
 
+    if (texture->resource.resident)
+    {
+        adapter_adjust_resident_memory(device->adapter, -(INT64)texture->resource.size);
+        texture->resource.resident = FALSE;
+    }
+
     wined3d_texture_set_dirty(texture);
 
     resource_unload(&texture->resource);
@@ -1057,6 +1113,13 @@ void wined3d_texture_load(struct wined3d_texture *texture,
         texture->async.gl_color_key = texture->async.src_blt_color_key;
     }
 
+    texture->resource.last_use = context->device->cs->present_count;
+    if (!texture->resource.resident)
+    {
+        adapter_adjust_resident_memory(context->device->adapter, texture->resource.size);
+        texture->resource.resident = TRUE;
+    }
+
     if (texture->flags & flag)
     {
         TRACE("Texture %p not dirty, nothing to do.\n", texture);
@@ -1635,7 +1698,11 @@ static void texture2d_upload_data(struct wined3d_texture *texture, unsigned int
         const struct wined3d_context *context, const struct wined3d_box *box,
         const struct wined3d_const_bo_address *data, unsigned int row_pitch, unsigned int slice_pitch)
 {
+    const struct wined3d_format *format = texture->resource.format;
+    struct wined3d_const_bo_address converted;
     unsigned int texture_level;
+    void *converted_mem = NULL;
+    struct wined3d_format f;
     POINT dst_point;
     RECT src_rect;
 
@@ -1656,8 +1723,36 @@ static void texture2d_upload_data(struct wined3d_texture *texture, unsigned int
         src_rect.bottom = wined3d_texture_get_level_height(texture, texture_level);
     }
 
+    if (format->conv_byte_count)
+    {
+        unsigned int dst_row_pitch, dst_slice_pitch;
+
+        if (data->buffer_object)
+            ERR("Loading a converted texture from a PBO.\n");
+
+        f = *format;
+        f.byte_count = format->conv_byte_count;
+        f.flags[WINED3D_GL_RES_TYPE_TEX_2D] &= ~WINED3DFMT_FLAG_BLOCKS;
+        wined3d_format_calculate_pitch(&f, 1, src_rect.right, src_rect.bottom, &dst_row_pitch, &dst_slice_pitch);
+        if (!(converted_mem = heap_alloc(dst_slice_pitch)))
+        {
+            ERR("Failed to allocate conversion memory.\n");
+            return;
+        }
+        format->upload(data->addr, converted_mem, row_pitch, slice_pitch, dst_row_pitch, dst_slice_pitch,
+                src_rect.right, src_rect.bottom, 1);
+
+        converted.buffer_object = 0;
+        converted.addr = converted_mem;
+        data = &converted;
+        row_pitch = dst_row_pitch;
+        format = &f;
+    }
+
     wined3d_surface_upload_data(texture->sub_resources[sub_resource_idx].u.surface, context->gl_info,
-            texture->resource.format, &src_rect, row_pitch, &dst_point, FALSE, data);
+            format, &src_rect, row_pitch, &dst_point, FALSE, data);
+
+    heap_free(converted_mem);
 }
 
 static BOOL texture2d_load_location(struct wined3d_texture *texture, unsigned int sub_resource_idx,
@@ -1886,6 +1981,21 @@ static HRESULT texture_resource_sub_resource_map(struct wined3d_resource *resour
         return WINED3DERR_INVALIDCALL;
     }
 
+    /* Render targets that keep getting read back by the CPU, typically by 2D
+     * applications locking their back buffer every frame, keep their system
+     * memory copy. CPU blits and clears then don't need to go through GL
+     * either, and only the dirty region is uploaded again. */
+    if (!(texture->flags & WINED3D_TEXTURE_PIN_SYSMEM) && resource->type == WINED3D_RTYPE_TEXTURE_2D
+            && (resource->usage & WINED3DUSAGE_RENDERTARGET) && !resource->multisample_type
+            && resource->map_binding != WINED3D_LOCATION_USER_MEMORY
+            && texture->download_count > WINED3D_TEXTURE_DYNAMIC_MAP_THRESHOLD)
+    {
+        WARN_(d3d_perf)("Keeping a system memory copy of frequently mapped texture %p.\n", texture);
+        texture->flags |= WINED3D_TEXTURE_PIN_SYSMEM;
+        if (resource->map_binding != WINED3D_LOCATION_SYSMEM)
+            wined3d_texture_set_map_binding(texture, WINED3D_LOCATION_SYSMEM);
+    }
+
     if (device->d3d_initialized)
         context = context_acquire(device, NULL, 0);
 
@@ -1912,7 +2022,10 @@ static HRESULT texture_resource_sub_resource_map(struct wined3d_resource *resour
 
     if (flags & WINED3D_MAP_WRITE
             && (!(flags & WINED3D_MAP_NO_DIRTY_UPDATE) || (resource->usage & WINED3DUSAGE_DYNAMIC)))
+    {
+        wined3d_texture_add_sysmem_dirty_region(texture, sub_resource_idx, box, flags);
         wined3d_texture_invalidate_location(texture, sub_resource_idx, ~resource->map_binding);
+    }
 
     wined3d_texture_get_memory(texture, sub_resource_idx, &data, resource->map_binding);
     base_memory = context_map_bo_address(context, &data, sub_resource->size, GL_PIXEL_UNPACK_BUFFER, flags);
@@ -2305,8 +2418,6 @@ static void texture3d_upload_data(struct wined3d_texture *texture, unsigned int
     {
         if (data->buffer_object)
             ERR("Loading a converted texture from a PBO.\n");
-        if (texture->resource.format_flags & WINED3DFMT_FLAG_BLOCKS)
-            ERR("Converting a block-based format.\n");
 
         dst_row_pitch = update_w * format->conv_byte_count;
         dst_slice_pitch = dst_row_pitch * update_h;
@@ -31,6 +31,10 @@
 
 #include "wined3d_private.h"
 
+#ifdef WINED3D_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 
 #define WINED3D_FORMAT_FOURCC_BASE (WINED3DFMT_BC7_UNORM_SRGB + 1)
@@ -998,6 +1002,84 @@ static void convert_b8g8r8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, unsig
     }
 }
 
+#ifdef WINED3D_HAVE_SSE2
+/* color_in_range() compares unsigned 32-bit values, SSE2 only has signed
+ * compares. Flipping the top bit of both sides works around that. */
+static inline __m128i WINED3D_SSE2 color_out_of_range_sse2(__m128i color, __m128i low, __m128i high)
+{
+    const __m128i sign = _mm_set1_epi32(0x80000000);
+
+    color = _mm_xor_si128(color, sign);
+    return _mm_or_si128(_mm_cmplt_epi32(color, low), _mm_cmpgt_epi32(color, high));
+}
+
+static void WINED3D_SSE2 convert_b8g8r8x8_unorm_b8g8r8a8_unorm_color_key_sse2(const BYTE *src,
+        unsigned int src_pitch, BYTE *dst, unsigned int dst_pitch, unsigned int width, unsigned int height,
+        const struct wined3d_color_key *color_key)
+{
+    const __m128i low = _mm_set1_epi32(color_key->color_space_low_value ^ 0x80000000);
+    const __m128i high = _mm_set1_epi32(color_key->color_space_high_value ^ 0x80000000);
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    const DWORD *src_row;
+    unsigned int x, y;
+    __m128i color;
+    DWORD *dst_row;
+
+    for (y = 0; y < height; ++y)
+    {
+        src_row = (DWORD *)&src[src_pitch * y];
+        dst_row = (DWORD *)&dst[dst_pitch * y];
+        for (x = 0; x + 4 <= width; x += 4)
+        {
+            color = _mm_loadu_si128((const __m128i *)&src_row[x]);
+            color = _mm_or_si128(_mm_andnot_si128(alpha, color),
+                    _mm_and_si128(color_out_of_range_sse2(color, low, high), alpha));
+            _mm_storeu_si128((__m128i *)&dst_row[x], color);
+        }
+        for (; x < width; ++x)
+        {
+            DWORD src_color = src_row[x];
+            if (color_in_range(color_key, src_color))
+                dst_row[x] = src_color & ~0xff000000;
+            else
+                dst_row[x] = src_color | 0xff000000;
+        }
+    }
+}
+
+static void WINED3D_SSE2 convert_b8g8r8a8_unorm_b8g8r8a8_unorm_color_key_sse2(const BYTE *src,
+        unsigned int src_pitch, BYTE *dst, unsigned int dst_pitch, unsigned int width, unsigned int height,
+        const struct wined3d_color_key *color_key)
+{
+    const __m128i low = _mm_set1_epi32(color_key->color_space_low_value ^ 0x80000000);
+    const __m128i high = _mm_set1_epi32(color_key->color_space_high_value ^ 0x80000000);
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    const DWORD *src_row;
+    unsigned int x, y;
+    __m128i color;
+    DWORD *dst_row;
+
+    for (y = 0; y < height; ++y)
+    {
+        src_row = (DWORD *)&src[src_pitch * y];
+        dst_row = (DWORD *)&dst[dst_pitch * y];
+        for (x = 0; x + 4 <= width; x += 4)
+        {
+            color = _mm_loadu_si128((const __m128i *)&src_row[x]);
+            color = _mm_andnot_si128(_mm_andnot_si128(color_out_of_range_sse2(color, low, high), alpha), color);
+            _mm_storeu_si128((__m128i *)&dst_row[x], color);
+        }
+        for (; x < width; ++x)
+        {
+            DWORD src_color = src_row[x];
+            if (color_in_range(color_key, src_color))
+                src_color &= ~0xff000000;
+            dst_row[x] = src_color;
+        }
+    }
+}
+#endif
+
 static void convert_b8g8r8x8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, unsigned int src_pitch,
         BYTE *dst, unsigned int dst_pitch, unsigned int width, unsigned int height,
         const struct wined3d_palette *palette, const struct wined3d_color_key *color_key)
@@ -1006,6 +1088,15 @@ static void convert_b8g8r8x8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, uns
     unsigned int x, y;
     DWORD *dst_row;
 
+#ifdef WINED3D_HAVE_SSE2
+    if (wined3d_cpu_has_sse2())
+    {
+        convert_b8g8r8x8_unorm_b8g8r8a8_unorm_color_key_sse2(src, src_pitch,
+                dst, dst_pitch, width, height, color_key);
+        return;
+    }
+#endif
+
     for (y = 0; y < height; ++y)
     {
         src_row = (DWORD *)&src[src_pitch * y];
@@ -1029,6 +1120,15 @@ static void convert_b8g8r8a8_unorm_b8g8r8a8_unorm_color_key(const BYTE *src, uns
     unsigned int x, y;
     DWORD *dst_row;
 
+#ifdef WINED3D_HAVE_SSE2
+    if (wined3d_cpu_has_sse2())
+    {
+        convert_b8g8r8a8_unorm_b8g8r8a8_unorm_color_key_sse2(src, src_pitch,
+                dst, dst_pitch, width, height, color_key);
+        return;
+    }
+#endif
+
     for (y = 0; y < height; ++y)
     {
         src_row = (DWORD *)&src[src_pitch * y];
@@ -1164,6 +1264,54 @@ static const struct wined3d_format_texture_info format_texture_info[] =
             GL_ALPHA,                   GL_UNSIGNED_BYTE,                 0,
             WINED3DFMT_FLAG_FILTERING,
             WINED3D_GL_LEGACY_CONTEXT,  NULL},
+    /* Decompressed on upload when the GL implementation can't sample
+     * the compressed format. These need to come before the native
+     * entries, which replace them when available. */
+    {WINED3DFMT_DXT1,                   GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
+            | WINED3DFMT_FLAG_SRGB_READ,
+            WINED3D_GL_EXT_NONE,        wined3d_bc1_decode, wined3d_bc1_encode},
+    {WINED3DFMT_DXT2,                   GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
+            | WINED3DFMT_FLAG_SRGB_READ,
+            WINED3D_GL_EXT_NONE,        wined3d_bc2_decode, wined3d_bc2_encode},
+    {WINED3DFMT_DXT3,                   GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
+            | WINED3DFMT_FLAG_SRGB_READ,
+            WINED3D_GL_EXT_NONE,        wined3d_bc2_decode, wined3d_bc2_encode},
+    {WINED3DFMT_DXT4,                   GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
+            | WINED3DFMT_FLAG_SRGB_READ,
+            WINED3D_GL_EXT_NONE,        wined3d_bc3_decode, wined3d_bc3_encode},
+    {WINED3DFMT_DXT5,                   GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
+            | WINED3DFMT_FLAG_SRGB_READ,
+            WINED3D_GL_EXT_NONE,        wined3d_bc3_decode, wined3d_bc3_encode},
+    {WINED3DFMT_BC1_UNORM,              GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING,
+            WINED3D_GL_EXT_NONE,        wined3d_bc1_decode, wined3d_bc1_encode},
+    {WINED3DFMT_BC2_UNORM,              GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING,
+            WINED3D_GL_EXT_NONE,        wined3d_bc2_decode, wined3d_bc2_encode},
+    {WINED3DFMT_BC3_UNORM,              GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING,
+            WINED3D_GL_EXT_NONE,        wined3d_bc3_decode, wined3d_bc3_encode},
+    {WINED3DFMT_BC4_UNORM,              GL_RGBA8,                         GL_RGBA8,                               0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING,
+            WINED3D_GL_EXT_NONE,        wined3d_bc4_decode, wined3d_bc4_encode},
+    {WINED3DFMT_BC5_UNORM,              GL_RGBA8,                         GL_RGBA8,                               0,
+            GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      4,
+            WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING,
+            WINED3D_GL_EXT_NONE,        wined3d_bc5_decode, wined3d_bc5_encode},
     {WINED3DFMT_DXT1,                   GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0,
             GL_RGBA,                    GL_UNSIGNED_BYTE,                 0,
             WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
@@ -1304,7 +1452,7 @@ static const struct wined3d_format_texture_info format_texture_info[] =
             GL_BGR,                     GL_UNSIGNED_BYTE,                 0,
             WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING | WINED3DFMT_FLAG_RENDERTARGET,
             WINED3D_GL_EXT_NONE,        NULL},
-    {WINED3DFMT_B8G8R8A8_UNORM,         GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+    {WINED3DFMT_B8G8R8A8_UNORM,        GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
             GL_BGRA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      0,
             WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
             | WINED3DFMT_FLAG_RENDERTARGET | WINED3DFMT_FLAG_SRGB_READ | WINED3DFMT_FLAG_SRGB_WRITE
@@ -1365,7 +1513,7 @@ static const struct wined3d_format_texture_info format_texture_info[] =
             WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
             | WINED3DFMT_FLAG_RENDERTARGET,
             WINED3D_GL_EXT_NONE,        NULL},
-    {WINED3DFMT_R8G8B8A8_UNORM,         GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
+    {WINED3DFMT_R8G8B8A8_UNORM,        GL_RGBA8,                         GL_SRGB8_ALPHA8_EXT,                    0,
             GL_RGBA,                    GL_UNSIGNED_INT_8_8_8_8_REV,      0,
             WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
             | WINED3DFMT_FLAG_RENDERTARGET |  WINED3DFMT_FLAG_SRGB_READ | WINED3DFMT_FLAG_SRGB_WRITE
@@ -1545,7 +1693,7 @@ static const struct wined3d_format_texture_info format_texture_info[] =
             WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
             | WINED3DFMT_FLAG_BUMPMAP,
             NV_TEXTURE_SHADER,          convert_r8g8_snorm_l8x8_unorm_nv},
-    {WINED3DFMT_R8G8B8A8_SNORM,         GL_RGBA8,                         GL_RGBA8,                               0,
+    {WINED3DFMT_R8G8B8A8_SNORM,        GL_RGBA8,                         GL_RGBA8,                               0,
             GL_BGRA,                    GL_UNSIGNED_BYTE,                 4,
             WINED3DFMT_FLAG_TEXTURE | WINED3DFMT_FLAG_POSTPIXELSHADER_BLENDING | WINED3DFMT_FLAG_FILTERING
             | WINED3DFMT_FLAG_BUMPMAP,
@@ -92,6 +92,14 @@ struct wined3d_settings wined3d_settings =
     ~0U,            /* No PS shader model limit by default. */
     ~0u,            /* No CS shader model limit by default. */
     FALSE,          /* 3D support enabled by default. */
+    TRUE,           /* On-disk GLSL program cache enabled by default. */
+    NULL,           /* Default shader cache location. */
+    256,            /* 256 MiB shader cache size limit. */
+    WINED3D_ASYNC_SHADER_COMPILE_WAIT, /* Compile in parallel, draws wait for their programs. */
+    NULL,           /* No CS profile log by default. */
+    FALSE,          /* No CS profile overlay by default. */
+    0,              /* No video memory budget by default. */
+    FALSE,          /* Load D3D9 float constants through uniforms. */
 };
 
 struct wined3d * CDECL wined3d_create(DWORD flags)
@@ -321,6 +329,61 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Disabling 3D support.\n");
             wined3d_settings.no_3d = TRUE;
         }
+        if (!get_config_key(hkey, appkey, "ShaderCache", buffer, size)
+                && !strcmp(buffer, "disabled"))
+        {
+            TRACE("Disabling the on-disk shader cache.\n");
+            wined3d_settings.shader_cache = FALSE;
+        }
+        if (!get_config_key(hkey, appkey, "ShaderCachePath", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+        }
+        if (!get_config_key_dword(hkey, appkey, "ShaderCacheSize", &wined3d_settings.shader_cache_size))
+            TRACE("Limiting the shader cache to %u MiB.\n", wined3d_settings.shader_cache_size);
+        if (!get_config_key(hkey, appkey, "AsyncShaderCompile", buffer, size))
+        {
+            if (!strcmp(buffer, "disabled"))
+            {
+                TRACE("Disabling parallel shader compilation.\n");
+                wined3d_settings.async_shader_compile = WINED3D_ASYNC_SHADER_COMPILE_DISABLED;
+            }
+            else if (!strcmp(buffer, "skip"))
+            {
+                TRACE("Skipping draws while their shaders are being compiled.\n");
+                wined3d_settings.async_shader_compile = WINED3D_ASYNC_SHADER_COMPILE_SKIP;
+            }
+        }
+        if (!get_config_key(hkey, appkey, "CSProfile", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            ERR_(winediag)("Writing command stream profile data to %s.\n", debugstr_a(buffer));
+            if (!(wined3d_settings.cs_profile_path = heap_alloc(len)))
+                ERR("Failed to allocate CS profile path memory.\n");
+            else
+                memcpy(wined3d_settings.cs_profile_path, buffer, len);
+        }
+        if (!get_config_key_dword(hkey, appkey, "VideoMemoryBudget", &wined3d_settings.vram_budget))
+            ERR_(winediag)("Evicting managed textures above %u MiB of video memory.\n",
+                    wined3d_settings.vram_budget);
+        if (!get_config_key(hkey, appkey, "ConstantBufferRing", buffer, size)
+                && !strcmp(buffer, "enabled"))
+        {
+            ERR_(winediag)("Loading float shader constants through uniform buffers.\n");
+            wined3d_settings.constant_ubo = TRUE;
+        }
+        if (!get_config_key(hkey, appkey, "CSProfileOverlay", buffer, size)
+                && !strcmp(buffer, "enabled"))
+        {
+            ERR_(winediag)("Showing the command stream profile overlay.\n");
+            wined3d_settings.cs_profile_overlay = TRUE;
+        }
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -353,6 +416,9 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(wndproc_table.entries);
 
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.shader_cache_path);
+    heap_free(wined3d_settings.cs_profile_path);
+    wined3d_shader_cleanup_reflection_cache();
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_wndproc_cs);
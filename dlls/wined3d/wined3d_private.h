@@ -373,9 +373,36 @@ static inline void wined3d_pause(void)
 #endif
 }
 
+/* SSE2 versions of some of the CPU format conversions. Users need to include
+ * <emmintrin.h> themselves, and check wined3d_cpu_has_sse2() before calling
+ * functions marked WINED3D_SSE2, since we may be running on an i386 CPU
+ * without SSE2. The incoming stack may only be 4 byte aligned on i386. */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+#define WINED3D_HAVE_SSE2
+#ifdef __i386__
+#define WINED3D_SSE2 __attribute__((target("sse2"), force_align_arg_pointer))
+#else
+#define WINED3D_SSE2
+#endif
+
+static inline BOOL wined3d_cpu_has_sse2(void)
+{
+#ifdef __x86_64__
+    return TRUE;
+#else
+    return IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE);
+#endif
+}
+#endif
+
 #define ORM_BACKBUFFER  0
 #define ORM_FBO         1
 
+#define WINED3D_ASYNC_SHADER_COMPILE_DISABLED   0
+#define WINED3D_ASYNC_SHADER_COMPILE_WAIT       1
+#define WINED3D_ASYNC_SHADER_COMPILE_SKIP       2
+
 #define PCI_VENDOR_NONE 0xffff /* e.g. 0x8086 for Intel and 0x10de for Nvidia */
 #define PCI_DEVICE_NONE 0xffff /* e.g. 0x14f for a Geforce6200 */
 
@@ -404,6 +431,14 @@ struct wined3d_settings
     unsigned int max_sm_ps;
     unsigned int max_sm_cs;
     BOOL no_3d;
+    BOOL shader_cache;
+    char *shader_cache_path;
+    unsigned int shader_cache_size;
+    unsigned int async_shader_compile;
+    char *cs_profile_path;
+    BOOL cs_profile_overlay;
+    unsigned int vram_budget;
+    BOOL constant_ubo;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
@@ -1549,8 +1584,10 @@ struct wined3d_draw_parameters
     BOOL indexed;
 };
 
+#define WINED3D_MAX_DRAW_BATCH 64
+
 void draw_primitive(struct wined3d_device *device, const struct wined3d_state *state,
-        const struct wined3d_draw_parameters *draw_parameters) DECLSPEC_HIDDEN;
+        const struct wined3d_draw_parameters *draw_parameters, unsigned int draw_count) DECLSPEC_HIDDEN;
 void dispatch_compute(struct wined3d_device *device, const struct wined3d_state *state,
         const struct wined3d_dispatch_parameters *dispatch_parameters) DECLSPEC_HIDDEN;
 DWORD get_flexible_vertex_size(DWORD d3dvtVertexType) DECLSPEC_HIDDEN;
@@ -1668,6 +1705,8 @@ enum wined3d_pipeline
 #define STATE_IS_COMPUTE(a) ((a) >= STATE_COMPUTE_OFFSET && (a) <= STATE_COMPUTE_HIGHEST)
 #define STATE_COMPUTE_COUNT (STATE_COMPUTE_HIGHEST - STATE_COMPUTE_OFFSET + 1)
 
+#define WINED3D_DIRTY_STATE_WORDS (STATE_HIGHEST / (sizeof(unsigned int) * CHAR_BIT) + 1)
+
 #define STATE_SHADER(a) ((a) != WINED3D_SHADER_TYPE_COMPUTE ? STATE_GRAPHICS_SHADER(a) : STATE_COMPUTE_SHADER)
 #define STATE_CONSTANT_BUFFER(a) \
     ((a) != WINED3D_SHADER_TYPE_COMPUTE ? STATE_GRAPHICS_CONSTANT_BUFFER(a) : STATE_COMPUTE_CONSTANT_BUFFER)
@@ -1705,6 +1744,8 @@ struct wined3d_fence
 HRESULT wined3d_fence_create(struct wined3d_device *device, struct wined3d_fence **fence) DECLSPEC_HIDDEN;
 void wined3d_fence_destroy(struct wined3d_fence *fence) DECLSPEC_HIDDEN;
 void wined3d_fence_issue(struct wined3d_fence *fence, const struct wined3d_device *device) DECLSPEC_HIDDEN;
+enum wined3d_fence_result wined3d_fence_test(const struct wined3d_fence *fence,
+        const struct wined3d_device *device, DWORD flags) DECLSPEC_HIDDEN;
 enum wined3d_fence_result wined3d_fence_wait(const struct wined3d_fence *fence,
         const struct wined3d_device *device) DECLSPEC_HIDDEN;
 
@@ -1850,20 +1891,20 @@ struct wined3d_rendertarget_info
 
 #define MAX_GL_FRAGMENT_SAMPLERS 32
 
+#define WINED3D_FBO_HASH_SIZE 64
+
 struct wined3d_context
 {
     const struct wined3d_gl_info *gl_info;
     const struct wined3d_d3d_info *d3d_info;
     const struct StateEntry *state_table;
     /* State dirtification
-     * dirtyArray is an array that contains markers for dirty states. numDirtyEntries states are dirty, their numbers are in indices
-     * 0...numDirtyEntries - 1. isStateDirty is a redundant copy of the dirtyArray. Technically only one of them would be needed,
-     * but with the help of both it is easy to find out if a state is dirty(just check the array index), and for applying dirty states
-     * only numDirtyEntries array elements have to be checked, not STATE_HIGHEST states.
-     */
-    DWORD                   dirtyArray[STATE_HIGHEST + 1]; /* Won't get bigger than that, a state is never marked dirty 2 times */
-    DWORD                   numDirtyEntries;
-    DWORD isStateDirty[STATE_HIGHEST / (sizeof(DWORD) * CHAR_BIT) + 1]; /* Bitmap to find out quickly if a state is dirty */
+     * dirty_graphics_states is a bitmap of the dirty representative states.
+     * dirty_graphics_words has a bit set for each non-zero word of
+     * dirty_graphics_states, so that applying the dirty states only needs to
+     * look at the words that contain dirty states. */
+    unsigned int dirty_graphics_states[WINED3D_DIRTY_STATE_WORDS];
+    unsigned int dirty_graphics_words[WINED3D_DIRTY_STATE_WORDS / (sizeof(unsigned int) * CHAR_BIT) + 1];
     unsigned int dirty_compute_states[STATE_COMPUTE_COUNT / (sizeof(unsigned int) * CHAR_BIT) + 1];
 
     struct wined3d_device *device;
@@ -1911,7 +1952,8 @@ struct wined3d_context
     DWORD transform_feedback_paused : 1;
     DWORD shader_update_mask : 6; /* WINED3D_SHADER_TYPE_COUNT, 6 */
     DWORD clip_distance_mask : 8; /* MAX_CLIP_DISTANCES, 8 */
-    DWORD padding : 9;
+    DWORD shader_pending : 1;
+    DWORD padding : 8;
     DWORD constant_update_mask;
     DWORD                   numbered_array_mask;
     GLenum                  tracking_parm;     /* Which source is tracking current colour         */
@@ -1941,6 +1983,7 @@ struct wined3d_context
     /* FBOs */
     UINT                    fbo_entry_count;
     struct list             fbo_list;
+    struct list             fbo_hash[WINED3D_FBO_HASH_SIZE];
     struct list             fbo_destroy_list;
     struct fbo_entry        *current_fbo;
     GLuint                  fbo_read_binding;
@@ -2532,6 +2575,8 @@ struct wined3d_gl_limits
     UINT vertex_attribs;
 
     unsigned int texture_buffer_offset_alignment;
+    unsigned int uniform_buffer_bindings;
+    unsigned int uniform_buffer_offset_alignment;
 
     unsigned int framebuffer_width;
     unsigned int framebuffer_height;
@@ -2600,6 +2645,7 @@ struct wined3d_adapter
     struct wined3d_pixel_format *cfgs;
     UINT64 vram_bytes;
     UINT64 vram_bytes_used;
+    LONGLONG vram_bytes_resident;
     LUID luid;
 
     const struct wined3d_vertex_pipe_ops *vertex_pipe;
@@ -2623,6 +2669,8 @@ struct wined3d_caps_gl_ctx
 BOOL wined3d_adapter_init_format_info(struct wined3d_adapter *adapter,
         struct wined3d_caps_gl_ctx *ctx) DECLSPEC_HIDDEN;
 UINT64 adapter_adjust_memory(struct wined3d_adapter *adapter, INT64 amount) DECLSPEC_HIDDEN;
+void adapter_adjust_resident_memory(struct wined3d_adapter *adapter, INT64 amount) DECLSPEC_HIDDEN;
+UINT64 adapter_get_resident_memory(struct wined3d_adapter *adapter) DECLSPEC_HIDDEN;
 
 BOOL wined3d_caps_gl_ctx_test_viewport_subpixel_bits(struct wined3d_caps_gl_ctx *ctx) DECLSPEC_HIDDEN;
 
@@ -2914,10 +2962,12 @@ struct wined3d_device
     struct wined3d_state state;
     struct wined3d_state *update_state;
     struct wined3d_stateblock *recording;
+    LONG elided_state_count;
 
     /* Internal use fields  */
     struct wined3d_device_creation_parameters create_parms;
     HWND focus_window;
+    unsigned int max_frame_latency;
 
     struct wined3d_rendertarget_view *back_buffer_view;
     struct wined3d_swapchain **swapchains;
@@ -2968,15 +3018,28 @@ HRESULT device_init(struct wined3d_device *device, struct wined3d *wined3d,
         BYTE surface_alignment, struct wined3d_device_parent *device_parent) DECLSPEC_HIDDEN;
 LRESULT device_process_message(struct wined3d_device *device, HWND window, BOOL unicode,
         UINT message, WPARAM wparam, LPARAM lparam, WNDPROC proc) DECLSPEC_HIDDEN;
+void device_manage_residency(struct wined3d_device *device) DECLSPEC_HIDDEN;
 void device_resource_add(struct wined3d_device *device, struct wined3d_resource *resource) DECLSPEC_HIDDEN;
 void device_resource_released(struct wined3d_device *device, struct wined3d_resource *resource) DECLSPEC_HIDDEN;
 void device_invalidate_state(const struct wined3d_device *device, DWORD state) DECLSPEC_HIDDEN;
 
 static inline BOOL isStateDirty(const struct wined3d_context *context, DWORD state)
 {
-    DWORD idx = state / (sizeof(*context->isStateDirty) * CHAR_BIT);
-    BYTE shift = state & ((sizeof(*context->isStateDirty) * CHAR_BIT) - 1);
-    return context->isStateDirty[idx] & (1u << shift);
+    unsigned int idx = state / (sizeof(*context->dirty_graphics_states) * CHAR_BIT);
+    unsigned int shift = state & ((sizeof(*context->dirty_graphics_states) * CHAR_BIT) - 1);
+    return context->dirty_graphics_states[idx] & (1u << shift);
+}
+
+/* Marks a representative state dirty. */
+static inline void context_set_state_dirty(struct wined3d_context *context, DWORD rep)
+{
+    unsigned int idx = rep / (sizeof(*context->dirty_graphics_states) * CHAR_BIT);
+    unsigned int shift = rep & ((sizeof(*context->dirty_graphics_states) * CHAR_BIT) - 1);
+
+    context->dirty_graphics_states[idx] |= 1u << shift;
+    shift = idx & ((sizeof(*context->dirty_graphics_words) * CHAR_BIT) - 1);
+    idx /= sizeof(*context->dirty_graphics_words) * CHAR_BIT;
+    context->dirty_graphics_words[idx] |= 1u << shift;
 }
 
 const char *wined3d_debug_resource_access(DWORD access) DECLSPEC_HIDDEN;
@@ -3026,6 +3089,11 @@ struct wined3d_resource
     const struct wined3d_resource_ops *resource_ops;
 
     struct list resource_list_entry;
+
+    /* Residency tracking. Updated by the CS thread, read by the residency
+     * manager in device_manage_residency(). */
+    BOOL resident;
+    unsigned int last_use;
 };
 
 static inline ULONG wined3d_resource_incref(struct wined3d_resource *resource)
@@ -3169,6 +3237,12 @@ struct wined3d_texture
         unsigned int map_count;
         DWORD locations;
         GLuint buffer_object;
+
+        /* For WINED3D_TEXTURE_PIN_SYSMEM textures, whether
+         * WINED3D_LOCATION_TEXTURE_RGB is only out of date inside
+         * "dirty_rect". */
+        BOOL partial_upload;
+        RECT dirty_rect;
     } sub_resources[1];
 };
 
@@ -3236,6 +3310,8 @@ void wined3d_texture_bind(struct wined3d_texture *texture,
         struct wined3d_context *context, BOOL srgb) DECLSPEC_HIDDEN;
 void wined3d_texture_bind_and_dirtify(struct wined3d_texture *texture,
         struct wined3d_context *context, BOOL srgb) DECLSPEC_HIDDEN;
+void wined3d_texture_add_sysmem_dirty_region(struct wined3d_texture *texture,
+        unsigned int sub_resource_idx, const struct wined3d_box *box, DWORD flags) DECLSPEC_HIDDEN;
 HRESULT wined3d_texture_check_box_dimensions(const struct wined3d_texture *texture,
         unsigned int level, const struct wined3d_box *box) DECLSPEC_HIDDEN;
 GLenum wined3d_texture_get_gl_buffer(const struct wined3d_texture *texture) DECLSPEC_HIDDEN;
@@ -3294,6 +3370,7 @@ struct wined3d_fbo_resource
 struct fbo_entry
 {
     struct list entry;
+    struct list hash_entry;
     DWORD flags;
     DWORD rt_mask;
     GLuint id;
@@ -3484,10 +3561,18 @@ enum wined3d_push_constants
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
 #define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_SPIN_COUNT_MIN       1000u
+#define WINED3D_CACHE_LINE_SIZE         64u
 
+/* Single producer, single consumer ring. The producer only writes "head", the
+ * consumer only writes "tail"; keep them on separate cache lines so the two
+ * threads don't bounce a shared line on every packet. */
 struct wined3d_cs_queue
 {
-    LONG head, tail;
+    LONG head;
+    BYTE head_padding[WINED3D_CACHE_LINE_SIZE - sizeof(LONG)];
+    LONG tail;
+    BYTE tail_padding[WINED3D_CACHE_LINE_SIZE - sizeof(LONG)];
     BYTE data[WINED3D_CS_QUEUE_SIZE];
 };
 
@@ -3513,12 +3598,22 @@ struct wined3d_cs
     struct wined3d_cs_queue queue[WINED3D_CS_QUEUE_COUNT];
     size_t data_size, start, end;
     void *data;
+    /* Queries waiting for their results. With ARB_sync, queries ended since
+     * the last wined3d_cs_close_query_batch() are on query_poll_list, while
+     * the older ones wait behind a fence in one of the query_batches. */
     struct list query_poll_list;
+    struct list query_batches;
+    struct list free_query_batches;
+    BOOL query_batching;
     BOOL queries_flushed;
 
     HANDLE event;
-    BOOL waiting_for_event;
+    LONG waiting_for_event;
+    unsigned int spin_count;
     LONG pending_presents;
+    unsigned int present_count;
+
+    struct wined3d_cs_profile *profile;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device) DECLSPEC_HIDDEN;
@@ -3607,6 +3702,8 @@ void wined3d_cs_emit_unload_resource(struct wined3d_cs *cs, struct wined3d_resou
 void wined3d_cs_emit_update_sub_resource(struct wined3d_cs *cs, struct wined3d_resource *resource,
         unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data, unsigned int row_pitch,
         unsigned int slice_pitch) DECLSPEC_HIDDEN;
+void wined3d_cs_profile_present(struct wined3d_cs *cs, struct wined3d_context *context,
+        struct wined3d_texture *back_buffer) DECLSPEC_HIDDEN;
 void wined3d_cs_init_object(struct wined3d_cs *cs,
         void (*callback)(void *object), void *object) DECLSPEC_HIDDEN;
 HRESULT wined3d_cs_map(struct wined3d_cs *cs, struct wined3d_resource *resource, unsigned int sub_resource_idx,
@@ -3646,6 +3743,16 @@ struct wined3d_map_range
     UINT size;
 };
 
+#define WINED3D_BUFFER_RING_SIZE 4
+
+/* A persistently mapped buffer object backing a dynamic buffer. */
+struct wined3d_buffer_ring_bo
+{
+    GLuint id;
+    BYTE *ptr;
+    struct wined3d_fence *fence;
+};
+
 struct wined3d_buffer
 {
     struct wined3d_resource resource;
@@ -3664,6 +3771,9 @@ struct wined3d_buffer
     SIZE_T maps_size, modified_areas;
     struct wined3d_fence *fence;
 
+    struct wined3d_buffer_ring_bo *ring;
+    unsigned int ring_count, ring_idx;
+
     /* conversion stuff */
     UINT decl_change_count, full_conversion_count;
     UINT draw_count;
@@ -3783,6 +3893,8 @@ struct wined3d_swapchain_ops
     void (*swapchain_frontbuffer_updated)(struct wined3d_swapchain *swapchain);
 };
 
+#define WINED3D_MAX_FRAME_LATENCY   16
+
 struct wined3d_swapchain
 {
     LONG ref;
@@ -3812,6 +3924,9 @@ struct wined3d_swapchain
 
     HDC backup_dc;
     HWND backup_wnd;
+
+    HANDLE frame_latency_event;
+    unsigned int max_frame_latency;
 };
 
 void wined3d_swapchain_activate(struct wined3d_swapchain *swapchain, BOOL activate) DECLSPEC_HIDDEN;
@@ -4050,6 +4165,7 @@ struct wined3d_shader
 };
 
 void pixelshader_update_resource_types(struct wined3d_shader *shader, WORD tex_types) DECLSPEC_HIDDEN;
+void wined3d_shader_cleanup_reflection_cache(void) DECLSPEC_HIDDEN;
 void find_ps_compile_args(const struct wined3d_state *state, const struct wined3d_shader *shader,
         BOOL position_transformed, struct ps_compile_args *args,
         const struct wined3d_context *context) DECLSPEC_HIDDEN;
@@ -4308,6 +4424,37 @@ const struct wined3d_color_key_conversion * wined3d_format_get_color_key_convers
 BOOL wined3d_formats_are_srgb_variants(enum wined3d_format_id format1,
         enum wined3d_format_id format2) DECLSPEC_HIDDEN;
 
+void wined3d_bc1_decode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc1_encode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc2_decode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc2_encode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc3_decode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc3_encode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc4_decode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc4_encode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc5_decode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+void wined3d_bc5_encode(const BYTE *src, BYTE *dst, unsigned int src_row_pitch, unsigned int src_slice_pitch,
+        unsigned int dst_row_pitch, unsigned int dst_slice_pitch,
+        unsigned int width, unsigned int height, unsigned int depth) DECLSPEC_HIDDEN;
+
 BOOL wined3d_array_reserve(void **elements, SIZE_T *capacity, SIZE_T count, SIZE_T size) DECLSPEC_HIDDEN;
 
 static inline BOOL wined3d_format_is_typeless(const struct wined3d_format *format)
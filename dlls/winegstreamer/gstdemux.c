@@ -72,6 +72,10 @@ typedef struct GSTImpl {
     HANDLE no_more_pads_event, push_event;
 
     HANDLE push_thread;
+
+    /* video decoded in hardware, for the statistics dumped on destruction */
+    BOOL hw_decoder;
+    LONG video_frames, hw_frames;
 } GSTImpl;
 
 struct GSTOutPin {
@@ -644,10 +648,18 @@ static GstFlowReturn got_data_sink(GstPad *pad, GstObject *parent, GstBuffer *bu
 
     IMediaSample_GetPointer(sample, &ptr);
 
+    /* The renderers only take system memory, so a frame held in GPU memory
+     * by a hardware decoder is downloaded here, once. */
     memcpy(ptr, info.data, info.size);
 
     gst_buffer_unmap(buf, &info);
 
+    if (pin->isvid) {
+        This->video_frames++;
+        if (This->hw_decoder)
+            This->hw_frames++;
+    }
+
     if (GST_BUFFER_PTS_IS_VALID(buf)) {
         REFERENCE_TIME rtStart = gst_segment_to_running_time(pin->segment, GST_FORMAT_TIME, buf->pts);
         if (rtStart >= 0)
@@ -1054,6 +1066,7 @@ static void no_more_pads(GstElement *decodebin, gpointer user)
 
 static GstAutoplugSelectResult autoplug_blacklist(GstElement *bin, GstPad *pad, GstCaps *caps, GstElementFactory *fact, gpointer user)
 {
+    GSTImpl *This = (GSTImpl*)user;
     const char *name = gst_element_factory_get_longname(fact);
 
     if (strstr(name, "Player protection")) {
@@ -1064,6 +1077,8 @@ static GstAutoplugSelectResult autoplug_blacklist(GstElement *bin, GstPad *pad,
         WARN("Disabled video acceleration since it breaks in wine\n");
         return GST_AUTOPLUG_SELECT_SKIP;
     }
+    if (is_hardware_decoder(fact))
+        This->hw_decoder = TRUE;
     TRACE("using \"%s\"\n", name);
     return GST_AUTOPLUG_SELECT_TRY;
 }
@@ -1287,6 +1302,10 @@ static void GST_Destroy(GSTImpl *This)
 
     TRACE("Destroying %p\n", This);
 
+    if (This->video_frames)
+        TRACE("%d of %d video frames decoded in hardware (%d%%)\n", This->hw_frames,
+              This->video_frames, MulDiv(This->hw_frames, 100, This->video_frames));
+
     CloseHandle(This->no_more_pads_event);
     CloseHandle(This->push_event);
 
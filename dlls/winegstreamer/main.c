@@ -21,6 +21,7 @@
 #include "config.h"
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <gst/gst.h>
 
@@ -257,6 +258,51 @@ void dump_AM_MEDIA_TYPE(const AM_MEDIA_TYPE * pmt)
     TRACE("\t%s\n\t%s\n\t...\n\t%s\n", debugstr_guid(&pmt->majortype), debugstr_guid(&pmt->subtype), debugstr_guid(&pmt->formattype));
 }
 
+BOOL is_hardware_decoder(GstElementFactory *fact)
+{
+    const char *klass = gst_element_factory_get_metadata(fact, GST_ELEMENT_METADATA_KLASS);
+
+    return klass && strstr(klass, "Decoder") && strstr(klass, "Hardware");
+}
+
+static BOOL hardware_decode_enabled(void)
+{
+    static const WCHAR keyW[] = {'S','o','f','t','w','a','r','e','\\','W','i','n','e','\\',
+                                 'D','i','r','e','c','t','S','h','o','w',0};
+    static const WCHAR valueW[] = {'H','a','r','d','w','a','r','e','D','e','c','o','d','e',0};
+    WCHAR buffer[8];
+    DWORD type, size = sizeof(buffer);
+    BOOL ret = FALSE;
+    HKEY key;
+
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, keyW, 0, KEY_READ, &key))
+        return FALSE;
+    if (!RegQueryValueExW(key, valueW, NULL, &type, (BYTE *)buffer, &size) && type == REG_SZ)
+        ret = buffer[0] == 'y' || buffer[0] == 'Y' || buffer[0] == 't' || buffer[0] == 'T' || buffer[0] == '1';
+    RegCloseKey(key);
+    return ret;
+}
+
+/* Rank the VA-API, NVDEC, ... video decoders above the software ones, so that
+ * decodebin tries them first. decodebin falls back to the next candidate by
+ * itself when a hardware decoder fails to start. */
+static void prefer_hardware_decoders(void)
+{
+    GList *list, *l;
+
+    list = gst_element_factory_list_get_elements(GST_ELEMENT_FACTORY_TYPE_DECODER |
+            GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO, GST_RANK_NONE);
+    for (l = list; l; l = l->next) {
+        GstElementFactory *fact = l->data;
+
+        if (!is_hardware_decoder(fact))
+            continue;
+        TRACE("preferring %s\n", gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(fact)));
+        gst_plugin_feature_set_rank(GST_PLUGIN_FEATURE(fact), GST_RANK_PRIMARY + 1);
+    }
+    gst_plugin_feature_list_free(list);
+}
+
 DWORD Gstreamer_init(void)
 {
     static int inited;
@@ -288,6 +334,9 @@ DWORD Gstreamer_init(void)
             if (!newhandle)
                 ERR("Could not pin module %p\n", hInst);
 
+            if (hardware_decode_enabled())
+                prefer_hardware_decoders();
+
             start_dispatch_thread();
         }
     }
@@ -31,6 +31,8 @@
 #include <math.h>
 #include <stdio.h>
 #include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
 
 #include <pulse/pulseaudio.h>
 
@@ -38,6 +40,7 @@
 #include "winbase.h"
 #include "winnls.h"
 #include "winreg.h"
+#include "wine/audiostats.h"
 #include "wine/debug.h"
 #include "wine/unicode.h"
 #include "wine/list.h"
@@ -57,6 +60,7 @@
 #include "audiopolicy.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(pulse);
+WINE_DECLARE_DEBUG_CHANNEL(audiostats);
 
 #define NULL_PTR_ERR MAKE_HRESULT(SEVERITY_ERROR, FACILITY_WIN32, RPC_X_NULL_REF_POINTER)
 
@@ -85,6 +89,14 @@ static UINT g_phys_speakers_mask = 0;
 static WAVEFORMATEXTENSIBLE pulse_fmt[2];
 static REFERENCE_TIME pulse_min_period[2], pulse_def_period[2];
 
+/* Low latency mode: honor the requested period and let the server adjust its latency */
+static BOOL pulse_low_latency;
+
+static const WCHAR drv_keyW[] = {'S','o','f','t','w','a','r','e','\\',
+    'W','i','n','e','\\','D','r','i','v','e','r','s','\\',
+    'w','i','n','e','p','u','l','s','e','.','d','r','v',0};
+static const WCHAR LowLatencyW[] = {'L','o','w','L','a','t','e','n','c','y',0};
+
 static GUID pulse_render_guid =
 { 0xfd47d9cc, 0x4218, 0x4135, { 0x9c, 0xe2, 0x0c, 0x19, 0x5c, 0x87, 0x40, 0x5b } };
 static GUID pulse_capture_guid =
@@ -183,6 +195,7 @@ struct ACImpl {
     pa_buffer_attr attr;
 
     INT64 clock_lastpos, clock_written;
+    struct audio_stream_stats *stats;
 
     AudioSession *session;
     AudioSessionWrapper *session_wrapper;
@@ -272,8 +285,32 @@ static int pulse_poll_func(struct pollfd *ufds, unsigned long nfds, int timeout,
     return r;
 }
 
+/* The audio thread needs real-time scheduling to meet short periods; this
+ * only works if the user was granted RLIMIT_RTPRIO (e.g. by rtkit or the
+ * audio group), SetThreadPriority doesn't map to a real-time class. */
+static void pulse_set_realtime(void)
+{
+#if defined(SCHED_RR) && defined(RLIMIT_RTPRIO)
+    struct sched_param param;
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_RTPRIO, &limit) || !limit.rlim_cur) {
+        WARN("No real-time priority allowed for the audio thread.\n");
+        return;
+    }
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = min(limit.rlim_cur, sched_get_priority_max(SCHED_RR));
+    if (pthread_setschedparam(pthread_self(), SCHED_RR, &param))
+        WARN("Failed to set real-time priority %d.\n", param.sched_priority);
+    else
+        TRACE("Audio thread running with real-time priority %d.\n", param.sched_priority);
+#endif
+}
+
 static DWORD CALLBACK pulse_mainloop_thread(void *tmp) {
     int ret;
+    if (pulse_low_latency)
+        pulse_set_realtime();
     pulse_ml = pa_mainloop_new();
     pa_mainloop_set_poll_func(pulse_ml, pulse_poll_func, NULL);
     pthread_mutex_lock(&pulse_lock);
@@ -664,6 +701,8 @@ static void pulse_wr_callback(pa_stream *s, size_t bytes, void *userdata)
     ACImpl *This = userdata;
     UINT32 oldpad = This->pad;
 
+    audio_stats_period(This->stats);
+
     if(This->local_buffer){
         UINT32 to_write;
         BYTE *buf = This->local_buffer + This->lcl_offs_bytes;
@@ -709,13 +748,19 @@ static void pulse_wr_callback(pa_stream *s, size_t bytes, void *userdata)
         TRACE("New pad: %zu (-%zu)\n", This->pad / pa_frame_size(&This->ss), (oldpad - This->pad) / pa_frame_size(&This->ss));
     }
 
+    audio_stats_latency(This->stats, pa_bytes_to_usec(This->pad, &This->ss) * 10);
+
     if (This->event)
         SetEvent(This->event);
 }
 
 static void pulse_underflow_callback(pa_stream *s, void *userdata)
 {
+    ACImpl *This = userdata;
+
     WARN("Underflow\n");
+    if (This->stats)
+        This->stats->underruns++;
 }
 
 /* Latency is periodically updated even when nothing is played,
@@ -744,6 +789,8 @@ static void pulse_rd_loop(ACImpl *This, size_t bytes)
         size_t src_len, copy, rem = This->capture_period;
         if (!(p = (ACPacket*)list_head(&This->packet_free_head))) {
             p = (ACPacket*)list_head(&This->packet_filled_head);
+            if (This->stats)
+                This->stats->overruns++;
             if (!p->discont) {
                 next = (ACPacket*)p->entry.next;
                 next->discont = 1;
@@ -843,6 +890,8 @@ static void pulse_rd_callback(pa_stream *s, size_t bytes, void *userdata)
     if (bytes < This->capture_period)
         return;
 
+    audio_stats_period(This->stats);
+
     if (This->started)
         pulse_rd_loop(This, bytes);
     else
@@ -857,6 +906,7 @@ static HRESULT pulse_stream_connect(ACImpl *This, UINT32 period_bytes) {
     char buffer[64];
     static LONG number;
     pa_buffer_attr attr;
+    pa_stream_flags_t flags;
     if (This->stream) {
         pa_stream_disconnect(This->stream);
         while (pa_stream_get_state(This->stream) == PA_STREAM_READY)
@@ -881,12 +931,17 @@ static HRESULT pulse_stream_connect(ACImpl *This, UINT32 period_bytes) {
     attr.maxlength = attr.tlength = This->bufsize_bytes;
     attr.prebuf = pa_frame_size(&This->ss);
     dump_attr(&attr);
+    flags = PA_STREAM_START_CORKED|PA_STREAM_START_UNMUTED|PA_STREAM_AUTO_TIMING_UPDATE|PA_STREAM_INTERPOLATE_TIMING;
+    /* ask the server to configure the device latency from tlength and fragsize,
+     * instead of sending early requests from its default buffering */
+    if (pulse_low_latency)
+        flags |= PA_STREAM_ADJUST_LATENCY;
+    else
+        flags |= PA_STREAM_EARLY_REQUESTS;
     if (This->dataflow == eRender)
-        ret = pa_stream_connect_playback(This->stream, NULL, &attr,
-        PA_STREAM_START_CORKED|PA_STREAM_START_UNMUTED|PA_STREAM_AUTO_TIMING_UPDATE|PA_STREAM_INTERPOLATE_TIMING|PA_STREAM_EARLY_REQUESTS, NULL, NULL);
+        ret = pa_stream_connect_playback(This->stream, NULL, &attr, flags, NULL, NULL);
     else
-        ret = pa_stream_connect_record(This->stream, NULL, &attr,
-        PA_STREAM_START_CORKED|PA_STREAM_START_UNMUTED|PA_STREAM_AUTO_TIMING_UPDATE|PA_STREAM_INTERPOLATE_TIMING|PA_STREAM_EARLY_REQUESTS);
+        ret = pa_stream_connect_record(This->stream, NULL, &attr, flags);
     if (ret < 0) {
         WARN("Returns %i\n", ret);
         return AUDCLNT_E_ENDPOINT_CREATE_FAILED;
@@ -940,9 +995,25 @@ HRESULT WINAPI AUDDRV_GetEndpointIDs(EDataFlow flow, const WCHAR ***ids, GUID **
     return S_OK;
 }
 
+static void pulse_read_config(void)
+{
+    WCHAR buffer[8];
+    DWORD size = sizeof(buffer), type;
+    HKEY key;
+
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, drv_keyW, 0, KEY_READ, &key))
+        return;
+    if (!RegQueryValueExW(key, LowLatencyW, NULL, &type, (BYTE *)buffer, &size) && type == REG_SZ)
+        pulse_low_latency = (buffer[0] == 'y' || buffer[0] == 'Y' || buffer[0] == 't' ||
+                             buffer[0] == 'T' || buffer[0] == '1');
+    RegCloseKey(key);
+    TRACE("low latency mode %u\n", pulse_low_latency);
+}
+
 int WINAPI AUDDRV_GetPriority(void)
 {
     HRESULT hr;
+    pulse_read_config();
     pthread_mutex_lock(&pulse_lock);
     hr = pulse_test_connect();
     pthread_mutex_unlock(&pulse_lock);
@@ -1028,6 +1099,23 @@ static ULONG WINAPI AudioClient_AddRef(IAudioClient *iface)
     return ref;
 }
 
+static void dump_stream_stats(ACImpl *This)
+{
+    const struct audio_stream_stats *s = This->stats;
+
+    if (!s || !TRACE_ON(audiostats))
+        return;
+
+    TRACE_(audiostats)("%p %s: %d periods, %d underruns, %d overruns, "
+                       "latency %s/%s max (100ns)\n", This,
+                       This->dataflow == eRender ? "render" : "capture",
+                       s->periods, s->underruns, s->overruns,
+                       wine_dbgstr_longlong(s->latency), wine_dbgstr_longlong(s->max_latency));
+    TRACE_(audiostats)("%p jitter: %d %d %d %d %d %d %d %d\n", This,
+                       s->jitter[0], s->jitter[1], s->jitter[2], s->jitter[3],
+                       s->jitter[4], s->jitter[5], s->jitter[6], s->jitter[7]);
+}
+
 static ULONG WINAPI AudioClient_Release(IAudioClient *iface)
 {
     ACImpl *This = impl_from_IAudioClient(iface);
@@ -1047,6 +1135,8 @@ static ULONG WINAPI AudioClient_Release(IAudioClient *iface)
             list_remove(&This->entry);
             pthread_mutex_unlock(&pulse_lock);
         }
+        dump_stream_stats(This);
+        audio_stats_free_stream(This->stats);
         IUnknown_Release(This->marshal);
         IMMDevice_Release(This->parent);
         HeapFree(GetProcessHeap(), 0, This->tmp_buffer);
@@ -1386,16 +1476,25 @@ static HRESULT WINAPI AudioClient_Initialize(IAudioClient *iface,
          * managed to get a total latency of ~8ms, which is well below
          * default
          */
-        if (duration < 2 * def)
-            period = min;
-        else
-            period = def;
-        if (duration < 2 * period)
-            duration = 2 * period;
+        if (pulse_low_latency) {
+            /* use the period the application asked for, the write
+             * callbacks of the server drive the event */
+            if (period < min)
+                period = min;
+            if (duration < 2 * period)
+                duration = 2 * period;
+        } else {
+            if (duration < 2 * def)
+                period = min;
+            else
+                period = def;
+            if (duration < 2 * period)
+                duration = 2 * period;
 
-        /* Uh oh, really low latency requested.. */
-        if (duration <= 2 * period)
-            period /= 2;
+            /* Uh oh, really low latency requested.. */
+            if (duration <= 2 * period)
+                period /= 2;
+        }
     }
     period_bytes = pa_frame_size(&This->ss) * MulDiv(period, This->ss.rate, 10000000);
 
@@ -1453,8 +1552,10 @@ static HRESULT WINAPI AudioClient_Initialize(IAudioClient *iface,
     }
     if (SUCCEEDED(hr))
         hr = get_audio_session(sessionguid, This->parent, fmt->nChannels, &This->session);
-    if (SUCCEEDED(hr))
+    if (SUCCEEDED(hr)) {
         list_add_tail(&This->session->clients, &This->entry);
+        This->stats = audio_stats_alloc_stream("pulse", This->dataflow, This->ss.rate, period);
+    }
 
 exit:
     if (FAILED(hr)) {
@@ -1510,14 +1611,15 @@ static HRESULT WINAPI AudioClient_GetStreamLatency(IAudioClient *iface,
         return hr;
     }
     attr = pa_stream_get_buffer_attr(This->stream);
-    if (This->dataflow == eRender){
+    if (This->dataflow == eRender)
         lat = attr->minreq / pa_frame_size(&This->ss);
-        lat += pulse_def_period[0];
-    }else
+    else
         lat = attr->fragsize / pa_frame_size(&This->ss);
     *latency = 10000000;
     *latency *= lat;
     *latency /= This->ss.rate;
+    if (This->dataflow == eRender && !pulse_low_latency)
+        *latency += pulse_def_period[0];
     pthread_mutex_unlock(&pulse_lock);
     TRACE("Latency: %u ms\n", (DWORD)(*latency / 10000));
     return S_OK;
@@ -1797,6 +1899,8 @@ static HRESULT WINAPI AudioClient_Start(IAudioClient *iface)
 
     if (SUCCEEDED(hr)) {
         This->started = TRUE;
+        if (This->stats)
+            This->stats->last_period = 0;
         if (This->dataflow == eRender && This->event)
             pa_stream_set_latency_update_callback(This->stream, pulse_latency_callback, This);
     }
@@ -2449,6 +2553,18 @@ static HRESULT WINAPI AudioClock_GetPosition(IAudioClock *iface, UINT64 *pos,
 
     *pos = This->clock_written;
 
+    /* account for what is still queued in the server, so that the
+     * position follows what was actually played */
+    if (pulse_low_latency && This->dataflow == eRender) {
+        pa_usec_t lat;
+        int negative;
+
+        if (!pa_stream_get_latency(This->stream, &lat, &negative) && !negative) {
+            UINT64 queued = pa_usec_to_bytes(lat, &This->ss);
+            *pos = *pos > queued ? *pos - queued : 0;
+        }
+    }
+
     if (This->share == AUDCLNT_SHAREMODE_EXCLUSIVE)
         *pos /= pa_frame_size(&This->ss);
 
@@ -18,6 +18,7 @@
  */
 
 #include <stdarg.h>
+#include <stdio.h>
 
 #include "windef.h"
 #include "winbase.h"
@@ -25,6 +26,7 @@
 
 #include "wine/debug.h"
 #include "wine/heap.h"
+#include "wine/unicode.h"
 #include "wine/vulkan.h"
 #include "wine/vulkan_driver.h"
 #include "vulkan_private.h"
@@ -44,6 +46,665 @@ static struct VkPhysicalDevice_T *wine_vk_physical_device_alloc(struct VkInstanc
 static void wine_vk_physical_device_free(struct VkPhysicalDevice_T *phys_dev);
 
 static const struct vulkan_funcs *vk_funcs = NULL;
+static DWORD arena_tls_index = TLS_OUT_OF_INDEXES;
+
+/* Maximum number of frames in flight when presenting asynchronously,
+ * 0 to present from the calling thread.
+ */
+static unsigned int async_present_frames;
+#define WINE_VK_ASYNC_PRESENT_MAX_FRAMES 16
+
+/* Initial size of the per-thread conversion arena. It grows to the largest
+ * amount of memory used by a single call.
+ */
+#define WINE_VK_ARENA_INITIAL_SIZE 4096
+
+/* Allocations which didn't fit into the arena, released on reset. */
+struct wine_vk_arena_block
+{
+    struct wine_vk_arena_block *next;
+    ULONGLONG data[1];
+};
+
+struct wine_vk_arena
+{
+    BYTE *base;
+    SIZE_T size;
+    SIZE_T used;
+    SIZE_T wanted; /* total bytes requested since the last reset */
+    struct wine_vk_arena_block *overflow;
+};
+
+static struct wine_vk_arena *wine_vk_get_arena(void)
+{
+    struct wine_vk_arena *arena;
+
+    if ((arena = TlsGetValue(arena_tls_index)))
+        return arena;
+
+    if (!(arena = heap_alloc_zero(sizeof(*arena))))
+        return NULL;
+
+    if ((arena->base = heap_alloc(WINE_VK_ARENA_INITIAL_SIZE)))
+        arena->size = WINE_VK_ARENA_INITIAL_SIZE;
+
+    TlsSetValue(arena_tls_index, arena);
+    return arena;
+}
+
+static void wine_vk_arena_free(struct wine_vk_arena *arena)
+{
+    if (!arena)
+        return;
+
+    wine_vk_arena_reset();
+    heap_free(arena->base);
+    heap_free(arena);
+}
+
+void *wine_vk_arena_alloc(SIZE_T size)
+{
+    struct wine_vk_arena_block *block;
+    struct wine_vk_arena *arena;
+    void *ptr;
+
+    if (!(arena = wine_vk_get_arena()))
+        return NULL;
+
+    /* Keep allocations aligned for 64-bit members. */
+    size = (size + 7) & ~7;
+    arena->wanted += size;
+
+    if (arena->size - arena->used >= size)
+    {
+        ptr = arena->base + arena->used;
+        arena->used += size;
+        return ptr;
+    }
+
+    if (!(block = heap_alloc(FIELD_OFFSET(struct wine_vk_arena_block, data[0]) + size)))
+        return NULL;
+
+    block->next = arena->overflow;
+    arena->overflow = block;
+    return block->data;
+}
+
+void wine_vk_arena_reset(void)
+{
+    struct wine_vk_arena *arena = TlsGetValue(arena_tls_index);
+    struct wine_vk_arena_block *block, *next;
+    BYTE *base;
+
+    if (!arena)
+        return;
+
+    for (block = arena->overflow; block; block = next)
+    {
+        next = block->next;
+        heap_free(block);
+    }
+    arena->overflow = NULL;
+
+    /* Grow the arena so the same call fits without overflow next time. */
+    if (arena->wanted > arena->size && (base = heap_alloc(arena->wanted)))
+    {
+        heap_free(arena->base);
+        arena->base = base;
+        arena->size = arena->wanted;
+    }
+
+    arena->used = 0;
+    arena->wanted = 0;
+}
+
+BOOL wine_vk_profile_enabled = FALSE;
+
+/* Latency histogram buckets, bucket n counts calls taking less than 2^n microseconds. */
+#define WINE_VK_PROFILE_BUCKETS 16
+
+struct wine_vk_profile_entry
+{
+    LONGLONG calls;
+    LONGLONG conversion_ticks;
+    LONGLONG host_ticks;
+    LONG histogram[WINE_VK_PROFILE_BUCKETS];
+};
+
+static struct wine_vk_profile_entry profile_entries[WINE_VK_PROFILE_COUNT];
+static LARGE_INTEGER profile_frequency;
+
+static void wine_vk_profile_add(LONGLONG volatile *dest, LONGLONG value)
+{
+    LONGLONG old;
+
+    do
+    {
+        old = *dest;
+    } while (InterlockedCompareExchange64(dest, old + value, old) != old);
+}
+
+void wine_vk_profile_record(unsigned int index, const LARGE_INTEGER *start,
+        const LARGE_INTEGER *host_start, const LARGE_INTEGER *host_end)
+{
+    struct wine_vk_profile_entry *entry = &profile_entries[index];
+    unsigned int bucket = 0;
+    LARGE_INTEGER end;
+    ULONGLONG usec;
+
+    QueryPerformanceCounter(&end);
+
+    wine_vk_profile_add(&entry->calls, 1);
+    wine_vk_profile_add(&entry->conversion_ticks, (host_start->QuadPart - start->QuadPart)
+            + (end.QuadPart - host_end->QuadPart));
+    wine_vk_profile_add(&entry->host_ticks, host_end->QuadPart - host_start->QuadPart);
+
+    usec = (end.QuadPart - start->QuadPart) * 1000000 / profile_frequency.QuadPart;
+    while (usec && bucket < WINE_VK_PROFILE_BUCKETS - 1)
+    {
+        usec >>= 1;
+        bucket++;
+    }
+    InterlockedIncrement(&entry->histogram[bucket]);
+}
+
+static void wine_vk_profile_dump(void)
+{
+    char histogram[WINE_VK_PROFILE_BUCKETS * 12 + 1], *ptr;
+    unsigned int i, j;
+
+    MESSAGE("winevulkan: %-40s %10s %12s %12s  histogram (<2^n us)\n", "function", "calls",
+            "conv us", "host us");
+
+    for (i = 0; i < WINE_VK_PROFILE_COUNT; i++)
+    {
+        const struct wine_vk_profile_entry *entry = &profile_entries[i];
+
+        if (!entry->calls)
+            continue;
+
+        ptr = histogram;
+        for (j = 0; j < WINE_VK_PROFILE_BUCKETS; j++)
+        {
+            if (entry->histogram[j])
+                ptr += sprintf(ptr, " %u:%u", j, (unsigned int)entry->histogram[j]);
+        }
+        *ptr = 0;
+
+        MESSAGE("winevulkan: %-40s %10s %12s %12s %s\n", wine_vk_profile_names[i],
+                wine_dbgstr_longlong(entry->calls),
+                wine_dbgstr_longlong(entry->conversion_ticks * 1000000 / profile_frequency.QuadPart),
+                wine_dbgstr_longlong(entry->host_ticks * 1000000 / profile_frequency.QuadPart),
+                histogram);
+    }
+}
+
+/* Interval in milliseconds at which the implicit pipeline cache is written back. */
+#define WINE_VK_PIPELINE_CACHE_SAVE_INTERVAL 30000
+
+static void wine_vk_pipeline_cache_save(struct VkDevice_T *device, size_t *saved_size)
+{
+    static const WCHAR tmpW[] = {'.','t','m','p',0};
+    WCHAR *tmp_path;
+    size_t size = 0;
+    HANDLE file;
+    void *data;
+    DWORD written;
+    BOOL ret;
+
+    if (device->funcs.p_vkGetPipelineCacheData(device->device, device->pipeline_cache,
+            &size, NULL) != VK_SUCCESS || !size || size == *saved_size)
+        return;
+
+    if (!(data = heap_alloc(size)))
+        return;
+
+    if (device->funcs.p_vkGetPipelineCacheData(device->device, device->pipeline_cache,
+            &size, data) != VK_SUCCESS)
+    {
+        heap_free(data);
+        return;
+    }
+
+    if (!(tmp_path = heap_alloc((strlenW(device->pipeline_cache_path) + ARRAY_SIZE(tmpW)) * sizeof(WCHAR))))
+    {
+        heap_free(data);
+        return;
+    }
+    strcpyW(tmp_path, device->pipeline_cache_path);
+    strcatW(tmp_path, tmpW);
+
+    /* Write to a temporary file first, so a crash never leaves a truncated cache behind. */
+    file = CreateFileW(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        ret = WriteFile(file, data, size, &written, NULL) && written == size;
+        CloseHandle(file);
+
+        if (ret && MoveFileExW(tmp_path, device->pipeline_cache_path, MOVEFILE_REPLACE_EXISTING))
+        {
+            TRACE("Saved %lu bytes of pipeline cache to %s.\n", (unsigned long)size,
+                    debugstr_w(device->pipeline_cache_path));
+            *saved_size = size;
+        }
+        else
+        {
+            WARN("Failed to write pipeline cache %s.\n", debugstr_w(device->pipeline_cache_path));
+            DeleteFileW(tmp_path);
+        }
+    }
+
+    heap_free(tmp_path);
+    heap_free(data);
+}
+
+static DWORD WINAPI wine_vk_pipeline_cache_thread(void *arg)
+{
+    struct VkDevice_T *device = arg;
+    size_t saved_size = 0;
+    DWORD ret;
+
+    do
+    {
+        ret = WaitForSingleObject(device->pipeline_cache_event, WINE_VK_PIPELINE_CACHE_SAVE_INTERVAL);
+        wine_vk_pipeline_cache_save(device, &saved_size);
+    } while (ret == WAIT_TIMEOUT);
+
+    return 0;
+}
+
+/* Builds the cache file name from the executable name and the pipeline cache UUID
+ * of the physical device, so caches from different drivers never get mixed up.
+ */
+static WCHAR *wine_vk_pipeline_cache_path(struct VkPhysicalDevice_T *phys_dev)
+{
+    static const WCHAR env_nameW[] = {'W','I','N','E','_','V','K','_','P','I','P','E','L','I','N','E','_',
+            'C','A','C','H','E',0};
+    static const WCHAR formatW[] = {'%','s','\\','%','s','.','%','s','.','v','k','c','a','c','h','e',0};
+    static const WCHAR hexW[] = {'%','0','2','x',0};
+#if defined(USE_STRUCT_CONVERSION)
+    VkPhysicalDeviceProperties_host properties;
+#else
+    VkPhysicalDeviceProperties properties;
+#endif
+    WCHAR dir[MAX_PATH], exe_path[MAX_PATH], uuid[VK_UUID_SIZE * 2 + 1], *exe_name, *path;
+    unsigned int i;
+
+    if (!GetEnvironmentVariableW(env_nameW, dir, ARRAY_SIZE(dir)))
+        return NULL;
+
+    if (!GetModuleFileNameW(NULL, exe_path, ARRAY_SIZE(exe_path)))
+        return NULL;
+    exe_name = strrchrW(exe_path, '\\');
+    exe_name = exe_name ? exe_name + 1 : exe_path;
+
+    phys_dev->instance->funcs.p_vkGetPhysicalDeviceProperties(phys_dev->phys_dev, &properties);
+    for (i = 0; i < VK_UUID_SIZE; i++)
+        sprintfW(&uuid[i * 2], hexW, properties.pipelineCacheUUID[i]);
+
+    if (!(path = heap_alloc((strlenW(dir) + strlenW(exe_name) + ARRAY_SIZE(uuid) + 10) * sizeof(WCHAR))))
+        return NULL;
+
+    sprintfW(path, formatW, dir, exe_name, uuid);
+    return path;
+}
+
+/* Sets up the implicit pipeline cache of a device if enabled through WINE_VK_PIPELINE_CACHE,
+ * which names a directory to store cache files in.
+ */
+static void wine_vk_device_init_pipeline_cache(struct VkDevice_T *device)
+{
+    VkPipelineCacheCreateInfo create_info;
+    void *data = NULL;
+    DWORD size = 0, read;
+    HANDLE file;
+    VkResult res;
+
+    if (!(device->pipeline_cache_path = wine_vk_pipeline_cache_path(device->phys_dev)))
+        return;
+
+    TRACE("Using pipeline cache %s.\n", debugstr_w(device->pipeline_cache_path));
+
+    file = CreateFileW(device->pipeline_cache_path, GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        size = GetFileSize(file, NULL);
+        if (size != INVALID_FILE_SIZE && (data = heap_alloc(size)))
+        {
+            if (!ReadFile(file, data, size, &read, NULL) || read != size)
+                size = 0;
+        }
+        else
+        {
+            size = 0;
+        }
+        CloseHandle(file);
+    }
+
+    /* The driver validates the header and ignores data from a different device or driver. */
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    create_info.pNext = NULL;
+    create_info.flags = 0;
+    create_info.initialDataSize = size;
+    create_info.pInitialData = size ? data : NULL;
+
+    res = device->funcs.p_vkCreatePipelineCache(device->device, &create_info, NULL, &device->pipeline_cache);
+    heap_free(data);
+    if (res != VK_SUCCESS)
+    {
+        WARN("Failed to create implicit pipeline cache, res=%d.\n", res);
+        device->pipeline_cache = VK_NULL_HANDLE;
+        return;
+    }
+
+    if (!(device->pipeline_cache_event = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        return;
+
+    if (!(device->pipeline_cache_thread = CreateThread(NULL, 0, wine_vk_pipeline_cache_thread,
+            device, 0, NULL)))
+    {
+        CloseHandle(device->pipeline_cache_event);
+        device->pipeline_cache_event = NULL;
+    }
+}
+
+static void wine_vk_device_free_pipeline_cache(struct VkDevice_T *device)
+{
+    size_t saved_size = 0;
+
+    if (device->pipeline_cache_thread)
+    {
+        /* The thread writes back the cache one last time before exiting. */
+        SetEvent(device->pipeline_cache_event);
+        WaitForSingleObject(device->pipeline_cache_thread, INFINITE);
+        CloseHandle(device->pipeline_cache_thread);
+    }
+    else if (device->pipeline_cache)
+    {
+        wine_vk_pipeline_cache_save(device, &saved_size);
+    }
+
+    if (device->pipeline_cache_event)
+        CloseHandle(device->pipeline_cache_event);
+
+    if (device->pipeline_cache)
+        device->funcs.p_vkDestroyPipelineCache(device->device, device->pipeline_cache, NULL);
+
+    heap_free(device->pipeline_cache_path);
+}
+
+/* A copy of the application's VkPresentInfoKHR, followed by its arrays. */
+struct wine_vk_present_request
+{
+    struct list entry;
+    VkPresentInfoKHR info;
+};
+
+static LARGE_INTEGER present_frequency;
+
+static DWORD WINAPI wine_vk_present_thread(void *arg)
+{
+    struct VkQueue_T *queue = arg;
+    struct wine_vk_present_queue *present = queue->present;
+    struct wine_vk_present_request *request;
+    LARGE_INTEGER start, end;
+    ULONGLONG ticks;
+    VkResult res;
+
+    for (;;)
+    {
+        EnterCriticalSection(&present->cs);
+        if (list_empty(&present->requests))
+        {
+            SetEvent(present->idle_event);
+            if (present->shutdown)
+            {
+                LeaveCriticalSection(&present->cs);
+                break;
+            }
+            LeaveCriticalSection(&present->cs);
+            WaitForSingleObject(present->request_event, INFINITE);
+            continue;
+        }
+        request = LIST_ENTRY(list_head(&present->requests), struct wine_vk_present_request, entry);
+        list_remove(&request->entry);
+        LeaveCriticalSection(&present->cs);
+
+        QueryPerformanceCounter(&start);
+        EnterCriticalSection(&present->queue_lock);
+        res = vk_funcs->p_vkQueuePresentKHR(queue->queue, &request->info);
+        LeaveCriticalSection(&present->queue_lock);
+        QueryPerformanceCounter(&end);
+
+        heap_free(request);
+        ReleaseSemaphore(present->frame_semaphore, 1, NULL);
+
+        ticks = end.QuadPart - start.QuadPart;
+        EnterCriticalSection(&present->cs);
+        if (res != VK_SUCCESS && present->result == VK_SUCCESS)
+            present->result = res;
+        present->presents++;
+        present->present_ticks += ticks;
+        present->max_present_ticks = max(present->max_present_ticks, ticks);
+        LeaveCriticalSection(&present->cs);
+    }
+
+    return 0;
+}
+
+/* Sets up asynchronous presentation for a queue on its first present. */
+static BOOL wine_vk_present_queue_init(struct VkQueue_T *queue)
+{
+    struct wine_vk_present_queue *present;
+
+    if (!(present = heap_alloc_zero(sizeof(*present))))
+        return FALSE;
+
+    list_init(&present->requests);
+    present->result = VK_SUCCESS;
+    if (!(present->request_event = CreateEventW(NULL, FALSE, FALSE, NULL))
+            || !(present->idle_event = CreateEventW(NULL, TRUE, TRUE, NULL))
+            || !(present->frame_semaphore = CreateSemaphoreW(NULL, async_present_frames,
+            async_present_frames, NULL)))
+        goto err;
+
+    InitializeCriticalSection(&present->queue_lock);
+    present->queue_lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": wine_vk_present_queue.queue_lock");
+    InitializeCriticalSection(&present->cs);
+    present->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": wine_vk_present_queue.cs");
+
+    /* The application synchronizes access to the queue, so nothing else uses it yet. */
+    queue->present = present;
+    if (!(present->thread = CreateThread(NULL, 0, wine_vk_present_thread, queue, 0, NULL)))
+    {
+        ERR("Failed to create present thread.\n");
+        queue->present = NULL;
+        present->queue_lock.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&present->queue_lock);
+        present->cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&present->cs);
+        goto err;
+    }
+
+    QueryPerformanceFrequency(&present_frequency);
+    TRACE("Created present thread for queue %p.\n", queue);
+    return TRUE;
+
+err:
+    if (present->frame_semaphore) CloseHandle(present->frame_semaphore);
+    if (present->idle_event) CloseHandle(present->idle_event);
+    if (present->request_event) CloseHandle(present->request_event);
+    heap_free(present);
+
+    /* Don't try again for every frame. */
+    WARN("Falling back to synchronous presents.\n");
+    async_present_frames = 0;
+    return FALSE;
+}
+
+/* Hands a present over to the present thread, after waiting for a frame to retire
+ * when the maximum number of frames is in flight. Failures of earlier presents are
+ * reported from the next call.
+ */
+static VkResult wine_vk_present_queue_submit(struct VkQueue_T *queue, const VkPresentInfoKHR *present_info)
+{
+    struct wine_vk_present_queue *present = queue->present;
+    struct wine_vk_present_request *request;
+    VkSwapchainKHR *swapchains;
+    VkSemaphore *semaphores;
+    LARGE_INTEGER start, end;
+    uint32_t *indices;
+    unsigned int i;
+    VkResult res;
+
+    QueryPerformanceCounter(&start);
+    WaitForSingleObject(present->frame_semaphore, INFINITE);
+    QueryPerformanceCounter(&end);
+
+    if (!(request = heap_alloc(sizeof(*request)
+            + present_info->swapchainCount * (sizeof(*swapchains) + sizeof(*indices))
+            + present_info->waitSemaphoreCount * sizeof(*semaphores))))
+    {
+        ReleaseSemaphore(present->frame_semaphore, 1, NULL);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    swapchains = (VkSwapchainKHR *)(request + 1);
+    semaphores = (VkSemaphore *)(swapchains + present_info->swapchainCount);
+    indices = (uint32_t *)(semaphores + present_info->waitSemaphoreCount);
+    memcpy(swapchains, present_info->pSwapchains, present_info->swapchainCount * sizeof(*swapchains));
+    memcpy(semaphores, present_info->pWaitSemaphores, present_info->waitSemaphoreCount * sizeof(*semaphores));
+    memcpy(indices, present_info->pImageIndices, present_info->swapchainCount * sizeof(*indices));
+
+    request->info = *present_info;
+    request->info.pSwapchains = swapchains;
+    request->info.pWaitSemaphores = semaphores;
+    request->info.pImageIndices = indices;
+    request->info.pResults = NULL;
+
+    EnterCriticalSection(&present->cs);
+    list_add_tail(&present->requests, &request->entry);
+    ResetEvent(present->idle_event);
+    present->throttle_ticks += end.QuadPart - start.QuadPart;
+    res = present->result;
+    present->result = VK_SUCCESS;
+    LeaveCriticalSection(&present->cs);
+
+    SetEvent(present->request_event);
+
+    if (present_info->pResults)
+    {
+        for (i = 0; i < present_info->swapchainCount; i++)
+            present_info->pResults[i] = res;
+    }
+    return res;
+}
+
+/* Waits until all presents queued on a queue have been handed to the driver. */
+static void wine_vk_queue_drain_presents(struct VkQueue_T *queue)
+{
+    if (queue->present)
+        WaitForSingleObject(queue->present->idle_event, INFINITE);
+}
+
+static void wine_vk_device_drain_presents(struct VkDevice_T *device)
+{
+    int i, j;
+
+    for (i = 0; i < device->max_queue_families; i++)
+    {
+        for (j = 0; j < device->queue_count[i]; j++)
+            wine_vk_queue_drain_presents(&device->queues[i][j]);
+    }
+}
+
+static void wine_vk_present_queue_free(struct VkQueue_T *queue)
+{
+    struct wine_vk_present_queue *present = queue->present;
+
+    if (!present)
+        return;
+
+    EnterCriticalSection(&present->cs);
+    present->shutdown = TRUE;
+    LeaveCriticalSection(&present->cs);
+    SetEvent(present->request_event);
+    WaitForSingleObject(present->thread, INFINITE);
+    CloseHandle(present->thread);
+
+    TRACE("Queue %p: %s presents, %s us average, %s us max, %s us throttled.\n", queue,
+            wine_dbgstr_longlong(present->presents),
+            wine_dbgstr_longlong(present->presents ? present->present_ticks * 1000000
+                    / present_frequency.QuadPart / present->presents : 0),
+            wine_dbgstr_longlong(present->max_present_ticks * 1000000 / present_frequency.QuadPart),
+            wine_dbgstr_longlong(present->throttle_ticks * 1000000 / present_frequency.QuadPart));
+
+    CloseHandle(present->frame_semaphore);
+    CloseHandle(present->idle_event);
+    CloseHandle(present->request_event);
+    present->queue_lock.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&present->queue_lock);
+    present->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&present->cs);
+    heap_free(present);
+    queue->present = NULL;
+}
+
+static int wine_vk_memory_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    VkDeviceMemory memory = *(const VkDeviceMemory *)key;
+    const struct wine_vk_memory *object = WINE_RB_ENTRY_VALUE(entry, const struct wine_vk_memory, entry);
+
+    if (memory < object->memory) return -1;
+    if (memory > object->memory) return 1;
+    return 0;
+}
+
+static void wine_vk_memory_destroy(struct wine_rb_entry *entry, void *context)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct wine_vk_memory, entry));
+}
+
+/* Records the memory heap of each memory type and the allocation limits of the device. */
+static void wine_vk_device_init_memory_stats(struct VkDevice_T *device)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkPhysicalDeviceMemoryProperties_host memory_properties;
+    VkPhysicalDeviceProperties_host properties;
+#else
+    VkPhysicalDeviceMemoryProperties memory_properties;
+    VkPhysicalDeviceProperties properties;
+#endif
+    struct VkPhysicalDevice_T *phys_dev = device->phys_dev;
+    unsigned int i;
+
+    phys_dev->instance->funcs.p_vkGetPhysicalDeviceProperties(phys_dev->phys_dev, &properties);
+    device->max_memory_count = properties.limits.maxMemoryAllocationCount;
+
+    phys_dev->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties(phys_dev->phys_dev, &memory_properties);
+    device->memory_heap_count = min(memory_properties.memoryHeapCount, VK_MAX_MEMORY_HEAPS);
+    for (i = 0; i < device->memory_heap_count; i++)
+        device->memory_heap_sizes[i] = memory_properties.memoryHeaps[i].size;
+    for (i = 0; i < min(memory_properties.memoryTypeCount, VK_MAX_MEMORY_TYPES); i++)
+        device->memory_type_heaps[i] = min(memory_properties.memoryTypes[i].heapIndex, VK_MAX_MEMORY_HEAPS - 1);
+}
+
+static void wine_vk_device_dump_memory_stats(const struct VkDevice_T *device)
+{
+    unsigned int i;
+
+    MESSAGE("winevulkan: device %p, %u live memory allocations, limit %u\n", device,
+            device->memory_count, device->max_memory_count);
+    for (i = 0; i < device->memory_heap_count; i++)
+    {
+        const struct wine_vk_heap_stats *stats = &device->heap_stats[i];
+
+        MESSAGE("winevulkan: heap %u: %u allocations, %s bytes, peak %s of %s bytes\n", i, stats->count,
+                wine_dbgstr_longlong(stats->size), wine_dbgstr_longlong(stats->max_size),
+                wine_dbgstr_longlong(device->memory_heap_sizes[i]));
+    }
+}
 
 /* Helper function used for freeing a device structure. This function supports full
  * and partial object cleanups and can thus be used vkCreateDevice failures.
@@ -53,13 +714,29 @@ static void wine_vk_device_free(struct VkDevice_T *device)
     if (!device)
         return;
 
+    wine_vk_device_free_pipeline_cache(device);
+
+    /* Allocations the application didn't release go away with the device. */
+    wine_rb_destroy(&device->memory_tree, wine_vk_memory_destroy, NULL);
+    device->memory_lock.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&device->memory_lock);
+
     if (device->queues)
     {
         int i;
         for (i = 0; i < device->max_queue_families; i++)
         {
-            if (device->queues[i])
-                heap_free(device->queues[i]);
+            int j;
+
+            if (!device->queues[i])
+                continue;
+
+            for (j = 0; j < device->queue_count[i]; j++)
+            {
+                wine_vk_present_queue_free(&device->queues[i][j]);
+                heap_free(device->queues[i][j].scratch);
+            }
+            heap_free(device->queues[i]);
         }
         heap_free(device->queues);
         device->queues = NULL;
@@ -76,8 +753,10 @@ static void wine_vk_device_free(struct VkDevice_T *device)
     heap_free(device);
 }
 
-/* Helper function for release command buffers. */
-static void wine_vk_device_free_command_buffers(VkDevice device, VkCommandPool pool,
+/* Helper function for release command buffers. Wrappers are returned to the
+ * free list of their pool for reuse.
+ */
+static void wine_vk_device_free_command_buffers(VkDevice device, struct wine_cmd_pool *pool,
         uint32_t count, const VkCommandBuffer *buffers)
 {
     int i;
@@ -85,16 +764,67 @@ static void wine_vk_device_free_command_buffers(VkDevice device, VkCommandPool p
     /* To avoid have to wrap all command buffers just loop over them one by one. */
     for (i = 0; i < count; i++)
     {
+        if (!buffers[i])
+            continue;
+
         if (buffers[i]->command_buffer)
-            device->funcs.p_vkFreeCommandBuffers(device->device, pool, 1, &buffers[i]->command_buffer);
+            device->funcs.p_vkFreeCommandBuffers(device->device, pool->command_pool, 1, &buffers[i]->command_buffer);
+
+        list_add_head(&pool->free_buffers, &buffers[i]->pool_entry);
+    }
+}
+
+/* Helper function to fetch an unused command buffer wrapper from a pool. */
+static struct VkCommandBuffer_T *wine_vk_cmd_pool_get_buffer(struct wine_cmd_pool *pool)
+{
+    struct wine_cmd_buffer_slab *slab;
+    struct list *entry;
+    int i;
+
+    if (list_empty(&pool->free_buffers))
+    {
+        if (!(slab = heap_alloc(sizeof(*slab))))
+            return NULL;
 
-        heap_free(buffers[i]);
+        list_add_tail(&pool->slabs, &slab->entry);
+        for (i = 0; i < ARRAY_SIZE(slab->buffers); i++)
+            list_add_tail(&pool->free_buffers, &slab->buffers[i].pool_entry);
     }
+
+    entry = list_head(&pool->free_buffers);
+    list_remove(entry);
+    return LIST_ENTRY(entry, struct VkCommandBuffer_T, pool_entry);
 }
 
 static BOOL wine_vk_init(void)
 {
-    HDC hdc = GetDC(0);
+    HDC hdc;
+
+    static const WCHAR profileW[] = {'W','I','N','E','_','V','K','_','P','R','O','F','I','L','E',0};
+    static const WCHAR async_presentW[] = {'W','I','N','E','_','V','K','_','A','S','Y','N','C','_',
+            'P','R','E','S','E','N','T',0};
+    WCHAR value[2], frames[4];
+
+    if ((arena_tls_index = TlsAlloc()) == TLS_OUT_OF_INDEXES)
+    {
+        ERR("Failed to allocate TLS index.\n");
+        return FALSE;
+    }
+
+    if (GetEnvironmentVariableW(profileW, value, ARRAY_SIZE(value)) && value[0] != '0')
+    {
+        TRACE("Profiling thunks.\n");
+        QueryPerformanceFrequency(&profile_frequency);
+        wine_vk_profile_enabled = TRUE;
+    }
+
+    if (GetEnvironmentVariableW(async_presentW, frames, ARRAY_SIZE(frames)))
+    {
+        async_present_frames = min(max(atoiW(frames), 0), WINE_VK_ASYNC_PRESENT_MAX_FRAMES);
+        TRACE("Presenting asynchronously with up to %u frames in flight.\n", async_present_frames);
+    }
+
+    hdc = GetDC(0);
 
     vk_funcs =  __wine_get_vulkan_driver(hdc, WINE_VULKAN_DRIVER_VERSION);
     if (!vk_funcs)
@@ -125,6 +855,9 @@ static struct VkQueue_T *wine_vk_device_alloc_queues(struct VkDevice_T *device,
     {
         struct VkQueue_T *queue = &queues[i];
         queue->device = device;
+        queue->present = NULL;
+        queue->scratch = NULL;
+        queue->scratch_size = 0;
 
         /* The native device was already allocated with the required number of queues, 
          * so just fetch them from there.
@@ -238,36 +971,57 @@ static void wine_vk_instance_free(struct VkInstance_T *instance)
     heap_free(instance);
 }
 
-static struct VkPhysicalDevice_T *wine_vk_physical_device_alloc(struct VkInstance_T *instance,
+/* Process-wide cache of the device extension lists we expose. Native physical
+ * device handles are tied to their instance and have to be enumerated again for
+ * each instance, but the extension lists only change along with the driver. Entries
+ * are therefore keyed on the device identity and driver version, so a driver update
+ * results in a fresh entry.
+ */
+struct wine_vk_phys_dev_cache_entry
+{
+    struct list entry;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+
+    uint32_t num_properties;
+    VkExtensionProperties properties[1];
+};
+
+static struct list phys_dev_cache = LIST_INIT(phys_dev_cache);
+
+static CRITICAL_SECTION phys_dev_cache_section;
+static CRITICAL_SECTION_DEBUG phys_dev_cache_debug =
+{
+    0, 0, &phys_dev_cache_section,
+    { &phys_dev_cache_debug.ProcessLocksList, &phys_dev_cache_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": phys_dev_cache_section") }
+};
+static CRITICAL_SECTION phys_dev_cache_section = { &phys_dev_cache_debug, -1, 0, 0, 0, 0 };
+
+static struct wine_vk_phys_dev_cache_entry *wine_vk_phys_dev_cache_create(struct VkInstance_T *instance,
         VkPhysicalDevice phys_dev)
 {
-    struct VkPhysicalDevice_T *object;
+    struct wine_vk_phys_dev_cache_entry *cached;
     uint32_t num_host_properties, num_properties = 0;
     VkExtensionProperties *host_properties = NULL;
     VkResult res;
     int i, j;
 
-    object = heap_alloc_zero(sizeof(*object));
-    if (!object)
-        return NULL;
-
-    object->base.loader_magic = VULKAN_ICD_MAGIC_VALUE;
-    object->instance = instance;
-    object->phys_dev = phys_dev;
-
     res = instance->funcs.p_vkEnumerateDeviceExtensionProperties(phys_dev,
             NULL, &num_host_properties, NULL);
     if (res != VK_SUCCESS)
     {
         ERR("Failed to enumerate device extensions, res=%d\n", res);
-        goto err;
+        return NULL;
     }
 
     host_properties = heap_calloc(num_host_properties, sizeof(*host_properties));
     if (!host_properties)
     {
         ERR("Failed to allocate memory for device properties!\n");
-        goto err;
+        return NULL;
     }
 
     res = instance->funcs.p_vkEnumerateDeviceExtensionProperties(phys_dev,
@@ -275,7 +1029,8 @@ static struct VkPhysicalDevice_T *wine_vk_physical_device_alloc(struct VkInstanc
     if (res != VK_SUCCESS)
     {
         ERR("Failed to enumerate device extensions, res=%d\n", res);
-        goto err;
+        heap_free(host_properties);
+        return NULL;
     }
 
     /* Count list of extensions for which we have an implementation.
@@ -285,7 +1040,7 @@ static struct VkPhysicalDevice_T *wine_vk_physical_device_alloc(struct VkInstanc
     {
         if (wine_vk_device_extension_supported(host_properties[i].extensionName))
         {
-            TRACE("Enabling extension '%s' for physical device %p\n", host_properties[i].extensionName, object);
+            TRACE("Enabling extension '%s' for physical device %p\n", host_properties[i].extensionName, phys_dev);
             num_properties++;
         }
         else
@@ -294,41 +1049,104 @@ static struct VkPhysicalDevice_T *wine_vk_physical_device_alloc(struct VkInstanc
 
     TRACE("Host supported extensions %d, Wine supported extensions %d\n", num_host_properties, num_properties);
 
-    object->properties = heap_calloc(num_properties, sizeof(*object->properties));
-    if (!object->properties)
+    cached = heap_alloc(FIELD_OFFSET(struct wine_vk_phys_dev_cache_entry, properties[num_properties]));
+    if (!cached)
     {
         ERR("Failed to allocate memory for device properties!\n");
-        goto err;
+        heap_free(host_properties);
+        return NULL;
     }
 
     for (i = 0, j = 0; i < num_host_properties; i++)
     {
         if (wine_vk_device_extension_supported(host_properties[i].extensionName))
         {
-            memcpy(&object->properties[j], &host_properties[i], sizeof(*object->properties));
+            memcpy(&cached->properties[j], &host_properties[i], sizeof(cached->properties[j]));
             j++;
         }
     }
-    object->num_properties = num_properties;
+    cached->num_properties = num_properties;
 
     heap_free(host_properties);
-    return object;
+    return cached;
+}
 
-err:
-    wine_vk_physical_device_free(object);
-    if (host_properties) heap_free(host_properties);
+/* Returns the cached extension list for a native physical device, creating it on first use. */
+static const struct wine_vk_phys_dev_cache_entry *wine_vk_phys_dev_cache_get(struct VkInstance_T *instance,
+        VkPhysicalDevice phys_dev)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkPhysicalDeviceProperties_host properties;
+#else
+    VkPhysicalDeviceProperties properties;
+#endif
+    struct wine_vk_phys_dev_cache_entry *cached;
 
-    return NULL;
+    instance->funcs.p_vkGetPhysicalDeviceProperties(phys_dev, &properties);
+
+    EnterCriticalSection(&phys_dev_cache_section);
+
+    LIST_FOR_EACH_ENTRY(cached, &phys_dev_cache, struct wine_vk_phys_dev_cache_entry, entry)
+    {
+        if (cached->vendor_id == properties.vendorID && cached->device_id == properties.deviceID
+                && cached->driver_version == properties.driverVersion
+                && !memcmp(cached->pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE))
+        {
+            TRACE("Using cached extensions for physical device %p\n", phys_dev);
+            LeaveCriticalSection(&phys_dev_cache_section);
+            return cached;
+        }
+    }
+
+    if ((cached = wine_vk_phys_dev_cache_create(instance, phys_dev)))
+    {
+        cached->vendor_id = properties.vendorID;
+        cached->device_id = properties.deviceID;
+        cached->driver_version = properties.driverVersion;
+        memcpy(cached->pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        list_add_tail(&phys_dev_cache, &cached->entry);
+    }
+
+    LeaveCriticalSection(&phys_dev_cache_section);
+    return cached;
 }
 
-static void wine_vk_physical_device_free(struct VkPhysicalDevice_T *phys_dev)
+static void wine_vk_phys_dev_cache_free(void)
 {
-    if (!phys_dev)
-        return;
+    struct wine_vk_phys_dev_cache_entry *cached, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(cached, next, &phys_dev_cache, struct wine_vk_phys_dev_cache_entry, entry)
+    {
+        list_remove(&cached->entry);
+        heap_free(cached);
+    }
+}
+
+static struct VkPhysicalDevice_T *wine_vk_physical_device_alloc(struct VkInstance_T *instance,
+        VkPhysicalDevice phys_dev)
+{
+    const struct wine_vk_phys_dev_cache_entry *cached;
+    struct VkPhysicalDevice_T *object;
 
-    if (phys_dev->properties)
-        heap_free(phys_dev->properties);
+    if (!(cached = wine_vk_phys_dev_cache_get(instance, phys_dev)))
+        return NULL;
+
+    object = heap_alloc_zero(sizeof(*object));
+    if (!object)
+        return NULL;
+
+    object->base.loader_magic = VULKAN_ICD_MAGIC_VALUE;
+    object->instance = instance;
+    object->phys_dev = phys_dev;
+    object->num_properties = cached->num_properties;
+    object->properties = cached->properties;
+
+    return object;
+}
 
+static void wine_vk_physical_device_free(struct VkPhysicalDevice_T *phys_dev)
+{
+    /* The extension list is owned by the process-wide cache. */
     heap_free(phys_dev);
 }
 
@@ -346,32 +1164,32 @@ VkResult WINAPI wine_vkAcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapc
 VkResult WINAPI wine_vkAllocateCommandBuffers(VkDevice device,
         const VkCommandBufferAllocateInfo *allocate_info, VkCommandBuffer *buffers)
 {
+    struct wine_cmd_pool *pool;
     VkResult res = VK_SUCCESS;
     int i;
 
     TRACE("%p %p %p\n", device, allocate_info, buffers);
 
+    pool = wine_cmd_pool_from_handle(allocate_info->commandPool);
+
     /* The application provides an array of buffers, we just clear it for error handling reasons. */
     memset(buffers, 0, allocate_info->commandBufferCount * sizeof(*buffers));
 
     for (i = 0; i < allocate_info->commandBufferCount; i++)
     {
-#if defined(USE_STRUCT_CONVERSION)
-        VkCommandBufferAllocateInfo_host allocate_info_host;
-#else
         VkCommandBufferAllocateInfo allocate_info_host;
-#endif
+
         /* TODO: future extensions (none yet) may require pNext conversion. */
         allocate_info_host.pNext = allocate_info->pNext;
         allocate_info_host.sType = allocate_info->sType;
-        allocate_info_host.commandPool = allocate_info->commandPool;
+        allocate_info_host.commandPool = pool->command_pool;
         allocate_info_host.level = allocate_info->level;
         allocate_info_host.commandBufferCount = 1;
 
         TRACE("Creating command buffer %d, pool 0x%s, level %d\n", i,
                 wine_dbgstr_longlong(allocate_info_host.commandPool),
                 allocate_info_host.level);
-        buffers[i] = heap_alloc(sizeof(struct VkCommandBuffer_T));
+        buffers[i] = wine_vk_cmd_pool_get_buffer(pool);
         if (!buffers[i])
         {
             res = VK_ERROR_OUT_OF_HOST_MEMORY;
@@ -380,24 +1198,86 @@ VkResult WINAPI wine_vkAllocateCommandBuffers(VkDevice device,
 
         buffers[i]->base.loader_magic = VULKAN_ICD_MAGIC_VALUE;
         buffers[i]->device = device;
+#define USE_VK_FUNC(name) buffers[i]->funcs.p_##name = device->funcs.p_##name;
+        ALL_VK_COMMAND_BUFFER_FUNCS()
+#undef USE_VK_FUNC
         res = device->funcs.p_vkAllocateCommandBuffers(device->device,
                 &allocate_info_host, &buffers[i]->command_buffer);
         if (res != VK_SUCCESS)
         {
             ERR("Failed to allocate command buffer, res=%d\n", res);
+            buffers[i]->command_buffer = VK_NULL_HANDLE;
             break;
         }
     }
 
     if (res != VK_SUCCESS)
     {
-        wine_vk_device_free_command_buffers(device, allocate_info->commandPool, i, buffers);
+        wine_vk_device_free_command_buffers(device, pool, i + 1, buffers);
+        memset(buffers, 0, allocate_info->commandBufferCount * sizeof(*buffers));
         return res;
     }
 
     return VK_SUCCESS;
 }
 
+VkResult WINAPI wine_vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo *allocate_info,
+        const VkAllocationCallbacks *allocator, VkDeviceMemory *memory)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkMemoryAllocateInfo_host allocate_info_host;
+#endif
+    struct wine_vk_heap_stats *stats;
+    struct wine_vk_memory *object;
+    VkResult res;
+
+    TRACE("%p, %p, %p, %p\n", device, allocate_info, allocator, memory);
+
+    if (allocator)
+        FIXME("Support for allocation callbacks not implemented yet\n");
+
+    if (!(object = heap_alloc(sizeof(*object))))
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+#if defined(USE_STRUCT_CONVERSION)
+    allocate_info_host.sType = allocate_info->sType;
+    allocate_info_host.pNext = allocate_info->pNext;
+    allocate_info_host.allocationSize = allocate_info->allocationSize;
+    allocate_info_host.memoryTypeIndex = allocate_info->memoryTypeIndex;
+    res = device->funcs.p_vkAllocateMemory(device->device, &allocate_info_host, NULL, memory);
+#else
+    res = device->funcs.p_vkAllocateMemory(device->device, allocate_info, NULL, memory);
+#endif
+    if (res != VK_SUCCESS)
+    {
+        WARN("Failed to allocate %s bytes of memory type %u, res=%d, %u allocations.\n",
+                wine_dbgstr_longlong(allocate_info->allocationSize), allocate_info->memoryTypeIndex,
+                res, device->memory_count);
+        heap_free(object);
+        return res;
+    }
+
+    object->memory = *memory;
+    object->size = allocate_info->allocationSize;
+    object->heap = allocate_info->memoryTypeIndex < VK_MAX_MEMORY_TYPES
+            ? device->memory_type_heaps[allocate_info->memoryTypeIndex] : 0;
+
+    EnterCriticalSection(&device->memory_lock);
+    wine_rb_put(&device->memory_tree, &object->memory, &object->entry);
+    stats = &device->heap_stats[object->heap];
+    stats->count++;
+    stats->size += object->size;
+    if (stats->size > stats->max_size)
+        stats->max_size = stats->size;
+    /* Warn once when getting close to the driver limit on the number of allocations. */
+    if (++device->memory_count == device->max_memory_count - device->max_memory_count / 16)
+        WARN("%u live memory allocations, the device limit is %u.\n",
+                device->memory_count, device->max_memory_count);
+    LeaveCriticalSection(&device->memory_lock);
+
+    return res;
+}
+
 void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
         const VkCommandBuffer *buffers)
 {
@@ -428,6 +1308,34 @@ void WINAPI wine_vkCmdExecuteCommands(VkCommandBuffer buffer, uint32_t count,
     heap_free(tmp_buffers);
 }
 
+VkResult WINAPI wine_vkCreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo *create_info,
+        const VkAllocationCallbacks *allocator, VkCommandPool *command_pool)
+{
+    struct wine_cmd_pool *object;
+    VkResult res;
+
+    TRACE("%p, %p, %p, %p\n", device, create_info, allocator, command_pool);
+
+    if (allocator)
+        FIXME("Support for allocation callbacks not implemented yet\n");
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    list_init(&object->slabs);
+    list_init(&object->free_buffers);
+
+    res = device->funcs.p_vkCreateCommandPool(device->device, create_info, NULL, &object->command_pool);
+    if (res != VK_SUCCESS)
+    {
+        heap_free(object);
+        return res;
+    }
+
+    *command_pool = wine_cmd_pool_to_handle(object);
+    return VK_SUCCESS;
+}
+
 VkResult WINAPI wine_vkCreateDevice(VkPhysicalDevice phys_dev,
         const VkDeviceCreateInfo *create_info,
         const VkAllocationCallbacks *allocator, VkDevice *device)
@@ -447,6 +1355,9 @@ VkResult WINAPI wine_vkCreateDevice(VkPhysicalDevice phys_dev,
         return VK_ERROR_OUT_OF_HOST_MEMORY;
 
     object->base.loader_magic = VULKAN_ICD_MAGIC_VALUE;
+    InitializeCriticalSection(&object->memory_lock);
+    object->memory_lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": VkDevice_T.memory_lock");
+    wine_rb_init(&object->memory_tree, wine_vk_memory_compare);
 
     /* At least for now we can directly pass create_info through. All extensions we report
      * should be compatible. In addition the loader is supposed to santize values e.g. layers.
@@ -511,6 +1422,9 @@ VkResult WINAPI wine_vkCreateDevice(VkPhysicalDevice phys_dev,
         object->queue_count[fam_index] = queue_count;
     }
 
+    wine_vk_device_init_pipeline_cache(object);
+    wine_vk_device_init_memory_stats(object);
+
     *device = object;
     return VK_SUCCESS;
 
@@ -614,6 +1528,10 @@ VkResult WINAPI wine_vkCreateSwapchainKHR(VkDevice device,
     if (allocator)
         FIXME("Support allocation allocators\n");
 
+    /* The old swapchain gets retired, flush presents still targeting it. */
+    if (create_info->oldSwapchain)
+        wine_vk_device_drain_presents(device);
+
     convert_VkSwapchainCreateInfoKHR_win_to_host(create_info, &create_info_host);
 
     /* Wine graphics driver layer only uses structs in host format. */
@@ -625,6 +1543,10 @@ VkResult WINAPI wine_vkCreateSwapchainKHR(VkDevice device,
     if (allocator)
         FIXME("Support allocation allocators\n");
 
+    /* The old swapchain gets retired, flush presents still targeting it. */
+    if (create_info->oldSwapchain)
+        wine_vk_device_drain_presents(device);
+
     return vk_funcs->p_vkCreateSwapchainKHR(device->device, create_info, allocator, swapchain);
 #endif
 }
@@ -642,6 +1564,30 @@ VkResult WINAPI wine_vkCreateWin32SurfaceKHR(VkInstance instance,
             NULL /* allocator */, surface);
 }
 
+void WINAPI wine_vkDestroyCommandPool(VkDevice device, VkCommandPool handle,
+        const VkAllocationCallbacks *allocator)
+{
+    struct wine_cmd_pool *pool = wine_cmd_pool_from_handle(handle);
+    struct wine_cmd_buffer_slab *slab, *next;
+
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(handle), allocator);
+
+    if (!handle)
+        return;
+
+    if (allocator)
+        FIXME("Support for allocation callbacks not implemented yet\n");
+
+    /* Destroying the pool frees all of its command buffers, so release the wrappers in bulk. */
+    device->funcs.p_vkDestroyCommandPool(device->device, pool->command_pool, NULL);
+
+    LIST_FOR_EACH_ENTRY_SAFE(slab, next, &pool->slabs, struct wine_cmd_buffer_slab, entry)
+    {
+        heap_free(slab);
+    }
+    heap_free(pool);
+}
+
 void WINAPI wine_vkDestroyDevice(VkDevice device, const VkAllocationCallbacks *allocator)
 {
     TRACE("%p %p\n", device, allocator);
@@ -649,7 +1595,13 @@ void WINAPI wine_vkDestroyDevice(VkDevice device, const VkAllocationCallbacks *a
     if (allocator)
         FIXME("Support for allocation callbacks not implemented yet\n");
 
+    if (device && wine_vk_profile_enabled)
+        wine_vk_device_dump_memory_stats(device);
+
     wine_vk_device_free(device);
+
+    if (wine_vk_profile_enabled)
+        wine_vk_profile_dump();
 }
 
 void WINAPI wine_vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks *allocator)
@@ -681,9 +1633,36 @@ void WINAPI wine_vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain
     if (allocator)
         FIXME("Support allocation allocators\n");
 
+    wine_vk_device_drain_presents(device);
     vk_funcs->p_vkDestroySwapchainKHR(device->device, swapchain, NULL /* allocator */);
 }
 
+VkResult WINAPI wine_vkDeviceWaitIdle(VkDevice device)
+{
+    VkResult res;
+    int i, j;
+
+    TRACE("%p\n", device);
+
+    wine_vk_device_drain_presents(device);
+
+    for (i = 0; i < device->max_queue_families; i++)
+    {
+        for (j = 0; j < device->queue_count[i]; j++)
+            wine_vk_queue_lock(&device->queues[i][j]);
+    }
+
+    res = device->funcs.p_vkDeviceWaitIdle(device->device);
+
+    for (i = 0; i < device->max_queue_families; i++)
+    {
+        for (j = 0; j < device->queue_count[i]; j++)
+            wine_vk_queue_unlock(&device->queues[i][j]);
+    }
+
+    return res;
+}
+
 VkResult WINAPI wine_vkEnumerateDeviceExtensionProperties(VkPhysicalDevice phys_dev,
         const char *layer_name, uint32_t *count, VkExtensionProperties *properties)
 {
@@ -844,7 +1823,38 @@ void WINAPI wine_vkFreeCommandBuffers(VkDevice device, VkCommandPool pool, uint3
 {
     TRACE("%p 0x%s %d %p\n", device, wine_dbgstr_longlong(pool), count, buffers);
 
-    wine_vk_device_free_command_buffers(device, pool, count, buffers);
+    wine_vk_device_free_command_buffers(device, wine_cmd_pool_from_handle(pool), count, buffers);
+}
+
+void WINAPI wine_vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks *allocator)
+{
+    struct wine_vk_heap_stats *stats;
+    struct wine_vk_memory *object;
+    struct wine_rb_entry *entry;
+
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(memory), allocator);
+
+    if (allocator)
+        FIXME("Support for allocation callbacks not implemented yet\n");
+
+    if (!memory)
+        return;
+
+    /* Forget the allocation before the handle value can be reused. */
+    EnterCriticalSection(&device->memory_lock);
+    if ((entry = wine_rb_get(&device->memory_tree, &memory)))
+    {
+        object = WINE_RB_ENTRY_VALUE(entry, struct wine_vk_memory, entry);
+        wine_rb_remove(&device->memory_tree, entry);
+        stats = &device->heap_stats[object->heap];
+        stats->count--;
+        stats->size -= object->size;
+        device->memory_count--;
+        heap_free(object);
+    }
+    LeaveCriticalSection(&device->memory_lock);
+
+    device->funcs.p_vkFreeMemory(device->device, memory, NULL);
 }
 
 PFN_vkVoidFunction WINAPI wine_vkGetDeviceProcAddr(VkDevice device, const char *name)
@@ -976,8 +1986,60 @@ VkResult WINAPI wine_vkGetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swa
 
 VkResult WINAPI wine_vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR *present_info)
 {
+    VkResult res;
+
     TRACE("%p, %p\n", queue, present_info);
-    return vk_funcs->p_vkQueuePresentKHR(queue->queue, present_info);
+
+    if (async_present_frames && (queue->present || wine_vk_present_queue_init(queue)))
+    {
+        if (!present_info->pNext)
+            return wine_vk_present_queue_submit(queue, present_info);
+
+        /* Extension structures would need a deep copy, present those synchronously. */
+        FIXME("Unhandled pNext chain, presenting synchronously.\n");
+        wine_vk_queue_drain_presents(queue);
+    }
+
+    wine_vk_queue_lock(queue);
+    res = vk_funcs->p_vkQueuePresentKHR(queue->queue, present_info);
+    wine_vk_queue_unlock(queue);
+    return res;
+}
+
+VkResult WINAPI wine_vkQueueWaitIdle(VkQueue queue)
+{
+    VkResult res;
+
+    TRACE("%p\n", queue);
+
+    /* Presents are part of the queue's work as far as the application is concerned. */
+    wine_vk_queue_drain_presents(queue);
+
+    wine_vk_queue_lock(queue);
+    res = queue->device->funcs.p_vkQueueWaitIdle(queue->queue);
+    wine_vk_queue_unlock(queue);
+    return res;
+}
+
+VkResult WINAPI wine_vkResetCommandPool(VkDevice device, VkCommandPool handle,
+        VkCommandPoolResetFlags flags)
+{
+    struct wine_cmd_pool *pool = wine_cmd_pool_from_handle(handle);
+
+    TRACE("%p, 0x%s, %#x\n", device, wine_dbgstr_longlong(handle), flags);
+
+    /* Command buffers stay allocated across a reset, so their wrappers remain in use. */
+    return device->funcs.p_vkResetCommandPool(device->device, pool->command_pool, flags);
+}
+
+void WINAPI wine_vkTrimCommandPoolKHR(VkDevice device, VkCommandPool handle,
+        VkCommandPoolTrimFlagsKHR flags)
+{
+    struct wine_cmd_pool *pool = wine_cmd_pool_from_handle(handle);
+
+    TRACE("%p, 0x%s, %#x\n", device, wine_dbgstr_longlong(handle), flags);
+
+    device->funcs.p_vkTrimCommandPoolKHR(device->device, pool->command_pool, flags);
 }
 
 void * WINAPI wine_vk_icdGetInstanceProcAddr(VkInstance instance, const char *name)
@@ -1011,75 +2073,111 @@ VkResult WINAPI wine_vk_icdNegotiateLoaderICDInterfaceVersion(uint32_t *supporte
     return VK_SUCCESS;
 }
 
+/* Returns per-queue scratch memory of at least 'size' bytes. The buffer is kept
+ * around between calls, so after warming up submits don't touch the heap.
+ */
+static void *wine_vk_queue_get_scratch(struct VkQueue_T *queue, SIZE_T size)
+{
+    SIZE_T new_size;
+    void *scratch;
+
+    if (size <= queue->scratch_size)
+        return queue->scratch;
+
+    new_size = max(size, queue->scratch_size * 2);
+    if (!(scratch = heap_realloc(queue->scratch, new_size)))
+        return NULL;
+
+    queue->scratch = scratch;
+    queue->scratch_size = new_size;
+    return scratch;
+}
+
+/* Most submits contain only a handful of command buffers, unwrap those on the stack. */
+#define WINE_VK_SUBMIT_STACK_COMMAND_BUFFERS 8
+
 VkResult WINAPI wine_vkQueueSubmit(VkQueue queue, uint32_t count,
         const VkSubmitInfo *submits, VkFence fence)
 {
+    VkCommandBuffer stack_command_buffers[WINE_VK_SUBMIT_STACK_COMMAND_BUFFERS];
+    VkCommandBuffer *command_buffers;
     VkSubmitInfo *submits_host;
+    VkSubmitInfo submit_host;
+    SIZE_T num_command_buffers = 0;
+    unsigned int i, j;
     VkResult res;
-    VkCommandBuffer *command_buffers;
-    int i, num_command_buffers;
 
     TRACE("%p %u %p 0x%s\n", queue, count, submits, wine_dbgstr_longlong(fence));
 
     if (count == 0)
     {
-        return queue->device->funcs.p_vkQueueSubmit(queue->queue, 0, NULL, fence);
+        wine_vk_queue_lock(queue);
+        res = queue->device->funcs.p_vkQueueSubmit(queue->queue, 0, NULL, fence);
+        wine_vk_queue_unlock(queue);
+        return res;
+    }
+
+    if (count == 1 && submits[0].commandBufferCount <= ARRAY_SIZE(stack_command_buffers))
+    {
+        submit_host = submits[0];
+        for (j = 0; j < submits[0].commandBufferCount; j++)
+            stack_command_buffers[j] = submits[0].pCommandBuffers[j]->command_buffer;
+        submit_host.pCommandBuffers = stack_command_buffers;
+
+        wine_vk_queue_lock(queue);
+        res = queue->device->funcs.p_vkQueueSubmit(queue->queue, 1, &submit_host, fence);
+        wine_vk_queue_unlock(queue);
+        TRACE("Returning %d\n", res);
+        return res;
     }
 
-    submits_host = heap_calloc(count, sizeof(*submits_host));
+    for (i = 0; i < count; i++)
+        num_command_buffers += submits[i].commandBufferCount;
+
+    /* Lay out the submit array followed by all unwrapped command buffers in one block. */
+    submits_host = wine_vk_queue_get_scratch(queue, count * sizeof(*submits_host)
+            + num_command_buffers * sizeof(*command_buffers));
     if (!submits_host)
     {
         ERR("Unable to allocate memory for submit buffers!\n");
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
+    command_buffers = (VkCommandBuffer *)(submits_host + count);
 
     for (i = 0; i < count; i++)
     {
-        int j;
-
-        memcpy(&submits_host[i], &submits[i], sizeof(*submits_host));
-
-        num_command_buffers = submits[i].commandBufferCount;
-        command_buffers = heap_calloc(num_command_buffers, sizeof(*submits_host));
-        if (!command_buffers)
-        {
-            ERR("Unable to allocate memory for comman buffers!\n");
-            res = VK_ERROR_OUT_OF_HOST_MEMORY;
-            goto err;
-        }
-
-        for (j = 0; j < num_command_buffers; j++)
-        {
+        submits_host[i] = submits[i];
+        for (j = 0; j < submits[i].commandBufferCount; j++)
             command_buffers[j] = submits[i].pCommandBuffers[j]->command_buffer;
-        }
         submits_host[i].pCommandBuffers = command_buffers;
+        command_buffers += submits[i].commandBufferCount;
     }
 
+    wine_vk_queue_lock(queue);
     res = queue->device->funcs.p_vkQueueSubmit(queue->queue, count, submits_host, fence);
-
-err:
-    if (submits_host)
-    {
-        for (i = 0; i < count; i++)
-        {
-            if (submits_host[i].pCommandBuffers)
-                heap_free((void*)submits_host[i].pCommandBuffers);
-        }
-        heap_free(submits_host);
-    }
+    wine_vk_queue_unlock(queue);
 
     TRACE("Returning %d\n", res);
     return res;
 }
 
-
 BOOL WINAPI DllMain(HINSTANCE hinst, DWORD reason, void *reserved)
 {
     switch (reason)
     {
         case DLL_PROCESS_ATTACH:
-            DisableThreadLibraryCalls(hinst);
             return wine_vk_init();
+
+        case DLL_THREAD_DETACH:
+            wine_vk_arena_free(TlsGetValue(arena_tls_index));
+            break;
+
+        case DLL_PROCESS_DETACH:
+            if (reserved) break;
+            wine_vk_phys_dev_cache_free();
+            wine_vk_arena_free(TlsGetValue(arena_tls_index));
+            TlsFree(arena_tls_index);
+            break;
     }
     return TRUE;
 }
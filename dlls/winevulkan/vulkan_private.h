@@ -20,6 +20,9 @@
 #ifndef __WINE_VULKAN_PRIVATE_H
 #define __WINE_VULKAN_PRIVATE_H
 
+#include "wine/list.h"
+#include "wine/rbtree.h"
+
 #include "vulkan_thunks.h"
 
 /* Magic value defined by Vulkan ICD / Loader spec */
@@ -51,8 +54,56 @@ struct wine_vk_base
 struct VkCommandBuffer_T
 {
     struct wine_vk_base base;
-    VkDevice device; /* parent */
     VkCommandBuffer command_buffer; /* native command buffer */
+    struct vulkan_command_buffer_funcs funcs; /* hot subset of device->funcs */
+    VkDevice device; /* parent */
+    struct list pool_entry; /* entry in the parent pool's free list when unused */
+};
+
+/* Command buffer wrappers are carved out of slabs owned by their command pool. */
+#define WINE_VK_COMMAND_BUFFER_SLAB_SIZE 32
+
+struct wine_cmd_buffer_slab
+{
+    struct list entry;
+    struct VkCommandBuffer_T buffers[WINE_VK_COMMAND_BUFFER_SLAB_SIZE];
+};
+
+/* Wrapper for VkCommandPool. Command pools are externally synchronized per the
+ * Vulkan spec, which covers the slab and free list bookkeeping as well.
+ */
+struct wine_cmd_pool
+{
+    VkCommandPool command_pool; /* native command pool */
+    struct list slabs;
+    struct list free_buffers;
+};
+
+static inline struct wine_cmd_pool *wine_cmd_pool_from_handle(VkCommandPool handle)
+{
+    return (struct wine_cmd_pool *)(uintptr_t)handle;
+}
+
+static inline VkCommandPool wine_cmd_pool_to_handle(struct wine_cmd_pool *cmd_pool)
+{
+    return (VkCommandPool)(uintptr_t)cmd_pool;
+}
+
+/* Device memory statistics of a memory heap, sizes in bytes. */
+struct wine_vk_heap_stats
+{
+    uint32_t count;
+    VkDeviceSize size;
+    VkDeviceSize max_size;
+};
+
+/* A live device memory allocation, to account for its release. */
+struct wine_vk_memory
+{
+    struct wine_rb_entry entry;
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    uint32_t heap;
 };
 
 struct VkDevice_T
@@ -66,9 +117,32 @@ struct VkDevice_T
     /* Stores number of queues per queue family */
     int *queue_count;
 
+    /* Implicit pipeline cache used by pipeline creation without an application
+     * cache, see WINE_VK_PIPELINE_CACHE. VK_NULL_HANDLE when disabled.
+     */
+    VkPipelineCache pipeline_cache;
+    WCHAR *pipeline_cache_path;
+    HANDLE pipeline_cache_thread;
+    HANDLE pipeline_cache_event; /* signaled on device destruction */
+
+    /* Device memory allocations, tracked per heap against the driver limits. */
+    CRITICAL_SECTION memory_lock;
+    struct wine_rb_tree memory_tree;
+    uint32_t memory_count;
+    uint32_t max_memory_count; /* maxMemoryAllocationCount of the physical device */
+    uint32_t memory_heap_count;
+    uint32_t memory_type_heaps[VK_MAX_MEMORY_TYPES];
+    VkDeviceSize memory_heap_sizes[VK_MAX_MEMORY_HEAPS];
+    struct wine_vk_heap_stats heap_stats[VK_MAX_MEMORY_HEAPS];
+
     VkDevice device; /* native device */
 };
 
+static inline VkPipelineCache wine_vk_device_pipeline_cache(VkDevice device, VkPipelineCache cache)
+{
+    return cache ? cache : device->pipeline_cache;
+}
+
 struct VkInstance_T
 {
     struct wine_vk_base base;
@@ -88,17 +162,76 @@ struct VkPhysicalDevice_T
     struct wine_vk_base base;
     struct VkInstance_T *instance; /* parent */
 
+    /* Supported extensions, owned by the process-wide physical device cache. */
     uint32_t num_properties;
-    VkExtensionProperties *properties;
+    const VkExtensionProperties *properties;
 
     VkPhysicalDevice phys_dev; /* native physical device */
 };
 
+/* Asynchronous presentation state of a queue, see WINE_VK_ASYNC_PRESENT. */
+struct wine_vk_present_queue
+{
+    /* Serializes access to the native queue between the application threads and
+     * the present thread, which breaks the external synchronization otherwise
+     * provided by the application.
+     */
+    CRITICAL_SECTION queue_lock;
+
+    CRITICAL_SECTION cs; /* protects the fields below */
+    struct list requests;
+    VkResult result; /* first failure not yet reported to the application */
+    BOOL shutdown;
+
+    HANDLE thread;
+    HANDLE request_event; /* signaled when a request was queued */
+    HANDLE idle_event; /* set while no request is queued or in flight */
+    HANDLE frame_semaphore; /* limits the number of frames in flight */
+
+    /* Statistics, in performance counter ticks. */
+    ULONGLONG presents;
+    ULONGLONG present_ticks;
+    ULONGLONG max_present_ticks;
+    ULONGLONG throttle_ticks;
+};
+
 struct VkQueue_T
 {
     struct wine_vk_base base;
     VkDevice device; /* parent */
     VkQueue queue; /* native queue */
+    struct wine_vk_present_queue *present; /* NULL unless presenting asynchronously */
+
+    /* Scratch memory for unwrapping vkQueueSubmit parameters. It only grows and is
+     * reused across submits. Access to a queue is externally synchronized per the
+     * Vulkan spec, so no locking is needed.
+     */
+    void *scratch;
+    SIZE_T scratch_size;
 };
 
+static inline void wine_vk_queue_lock(struct VkQueue_T *queue)
+{
+    if (queue->present)
+        EnterCriticalSection(&queue->present->queue_lock);
+}
+
+static inline void wine_vk_queue_unlock(struct VkQueue_T *queue)
+{
+    if (queue->present)
+        LeaveCriticalSection(&queue->present->queue_lock);
+}
+
+/* Per-thread bump allocator for temporary memory needed by struct conversions
+ * in the thunks. Allocations stay valid until wine_vk_arena_reset(), which
+ * every thunk using the arena calls before returning.
+ */
+void *wine_vk_arena_alloc(SIZE_T size) DECLSPEC_HIDDEN;
+void wine_vk_arena_reset(void) DECLSPEC_HIDDEN;
+
+/* Set through WINE_VK_PROFILE, selects the instrumented thunks at load time. */
+extern BOOL wine_vk_profile_enabled DECLSPEC_HIDDEN;
+void wine_vk_profile_record(unsigned int index, const LARGE_INTEGER *start,
+        const LARGE_INTEGER *host_start, const LARGE_INTEGER *host_end) DECLSPEC_HIDDEN;
+
 #endif /* __WINE_VULKAN_PRIVATE_H */
@@ -3,6 +3,8 @@
 #include "config.h"
 #include "wine/port.h"
 
+#include <stdlib.h>
+
 #include "wine/debug.h"
 #include "wine/heap.h"
 #include "wine/vulkan.h"
@@ -12,28 +14,6 @@
 WINE_DEFAULT_DEBUG_CHANNEL(vulkan);
 
 #if defined(USE_STRUCT_CONVERSION)
-static inline void convert_VkCommandBufferAllocateInfo_win_to_host(const VkCommandBufferAllocateInfo *in, VkCommandBufferAllocateInfo_host *out)
-{
-    if (!in) return;
-
-    out->sType = in->sType;
-    out->pNext = in->pNext;
-    out->commandPool = in->commandPool;
-    out->level = in->level;
-    out->commandBufferCount = in->commandBufferCount;
-}
-
-static inline void convert_VkDescriptorSetAllocateInfo_win_to_host(const VkDescriptorSetAllocateInfo *in, VkDescriptorSetAllocateInfo_host *out)
-{
-    if (!in) return;
-
-    out->sType = in->sType;
-    out->pNext = in->pNext;
-    out->descriptorPool = in->descriptorPool;
-    out->descriptorSetCount = in->descriptorSetCount;
-    out->pSetLayouts = in->pSetLayouts;
-}
-
 static inline void convert_VkMemoryAllocateInfo_win_to_host(const VkMemoryAllocateInfo *in, VkMemoryAllocateInfo_host *out)
 {
     if (!in) return;
@@ -51,7 +31,7 @@ static inline VkCommandBufferInheritanceInfo_host * convert_VkCommandBufferInher
 
     if (!in) return NULL;
 
-    out = (VkCommandBufferInheritanceInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkCommandBufferInheritanceInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sType = in[i].sType;
@@ -67,13 +47,6 @@ static inline VkCommandBufferInheritanceInfo_host * convert_VkCommandBufferInher
     return out;
 }
 
-static inline void free_VkCommandBufferInheritanceInfo_array(VkCommandBufferInheritanceInfo_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline void convert_VkCommandBufferBeginInfo_win_to_host(const VkCommandBufferBeginInfo *in, VkCommandBufferBeginInfo_host *out)
 {
     if (!in) return;
@@ -84,108 +57,6 @@ static inline void convert_VkCommandBufferBeginInfo_win_to_host(const VkCommandB
     out->pInheritanceInfo = convert_VkCommandBufferInheritanceInfo_array_win_to_host(in->pInheritanceInfo, 1);
 }
 
-static inline void free_VkCommandBufferBeginInfo(VkCommandBufferBeginInfo_host *in)
-{
-    free_VkCommandBufferInheritanceInfo_array((VkCommandBufferInheritanceInfo_host *)in->pInheritanceInfo, 1);
-}
-
-static inline void convert_VkRenderPassBeginInfo_win_to_host(const VkRenderPassBeginInfo *in, VkRenderPassBeginInfo_host *out)
-{
-    if (!in) return;
-
-    out->sType = in->sType;
-    out->pNext = in->pNext;
-    out->renderPass = in->renderPass;
-    out->framebuffer = in->framebuffer;
-    out->renderArea = in->renderArea;
-    out->clearValueCount = in->clearValueCount;
-    out->pClearValues = in->pClearValues;
-}
-
-static inline VkBufferCopy_host * convert_VkBufferCopy_array_win_to_host(const VkBufferCopy *in, uint32_t count)
-{
-    VkBufferCopy_host *out;
-    unsigned int i;
-
-    if (!in) return NULL;
-
-    out = (VkBufferCopy_host *)heap_alloc(count * sizeof(*out));
-    for (i = 0; i < count; i++)
-    {
-        out[i].srcOffset = in[i].srcOffset;
-        out[i].dstOffset = in[i].dstOffset;
-        out[i].size = in[i].size;
-    }
-
-    return out;
-}
-
-static inline void free_VkBufferCopy_array(VkBufferCopy_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
-static inline VkBufferImageCopy_host * convert_VkBufferImageCopy_array_win_to_host(const VkBufferImageCopy *in, uint32_t count)
-{
-    VkBufferImageCopy_host *out;
-    unsigned int i;
-
-    if (!in) return NULL;
-
-    out = (VkBufferImageCopy_host *)heap_alloc(count * sizeof(*out));
-    for (i = 0; i < count; i++)
-    {
-        out[i].bufferOffset = in[i].bufferOffset;
-        out[i].bufferRowLength = in[i].bufferRowLength;
-        out[i].bufferImageHeight = in[i].bufferImageHeight;
-        out[i].imageSubresource = in[i].imageSubresource;
-        out[i].imageOffset = in[i].imageOffset;
-        out[i].imageExtent = in[i].imageExtent;
-    }
-
-    return out;
-}
-
-static inline void free_VkBufferImageCopy_array(VkBufferImageCopy_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
-static inline VkBufferMemoryBarrier_host * convert_VkBufferMemoryBarrier_array_win_to_host(const VkBufferMemoryBarrier *in, uint32_t count)
-{
-    VkBufferMemoryBarrier_host *out;
-    unsigned int i;
-
-    if (!in) return NULL;
-
-    out = (VkBufferMemoryBarrier_host *)heap_alloc(count * sizeof(*out));
-    for (i = 0; i < count; i++)
-    {
-        out[i].sType = in[i].sType;
-        out[i].pNext = in[i].pNext;
-        out[i].srcAccessMask = in[i].srcAccessMask;
-        out[i].dstAccessMask = in[i].dstAccessMask;
-        out[i].srcQueueFamilyIndex = in[i].srcQueueFamilyIndex;
-        out[i].dstQueueFamilyIndex = in[i].dstQueueFamilyIndex;
-        out[i].buffer = in[i].buffer;
-        out[i].offset = in[i].offset;
-        out[i].size = in[i].size;
-    }
-
-    return out;
-}
-
-static inline void free_VkBufferMemoryBarrier_array(VkBufferMemoryBarrier_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline VkImageMemoryBarrier_host * convert_VkImageMemoryBarrier_array_win_to_host(const VkImageMemoryBarrier *in, uint32_t count)
 {
     VkImageMemoryBarrier_host *out;
@@ -193,7 +64,7 @@ static inline VkImageMemoryBarrier_host * convert_VkImageMemoryBarrier_array_win
 
     if (!in) return NULL;
 
-    out = (VkImageMemoryBarrier_host *)heap_alloc(count * sizeof(*out));
+    out = (VkImageMemoryBarrier_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sType = in[i].sType;
@@ -211,13 +82,6 @@ static inline VkImageMemoryBarrier_host * convert_VkImageMemoryBarrier_array_win
     return out;
 }
 
-static inline void free_VkImageMemoryBarrier_array(VkImageMemoryBarrier_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline VkDescriptorImageInfo_host * convert_VkDescriptorImageInfo_array_win_to_host(const VkDescriptorImageInfo *in, uint32_t count)
 {
     VkDescriptorImageInfo_host *out;
@@ -225,7 +89,7 @@ static inline VkDescriptorImageInfo_host * convert_VkDescriptorImageInfo_array_w
 
     if (!in) return NULL;
 
-    out = (VkDescriptorImageInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkDescriptorImageInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sampler = in[i].sampler;
@@ -236,38 +100,6 @@ static inline VkDescriptorImageInfo_host * convert_VkDescriptorImageInfo_array_w
     return out;
 }
 
-static inline void free_VkDescriptorImageInfo_array(VkDescriptorImageInfo_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
-static inline VkDescriptorBufferInfo_host * convert_VkDescriptorBufferInfo_array_win_to_host(const VkDescriptorBufferInfo *in, uint32_t count)
-{
-    VkDescriptorBufferInfo_host *out;
-    unsigned int i;
-
-    if (!in) return NULL;
-
-    out = (VkDescriptorBufferInfo_host *)heap_alloc(count * sizeof(*out));
-    for (i = 0; i < count; i++)
-    {
-        out[i].buffer = in[i].buffer;
-        out[i].offset = in[i].offset;
-        out[i].range = in[i].range;
-    }
-
-    return out;
-}
-
-static inline void free_VkDescriptorBufferInfo_array(VkDescriptorBufferInfo_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline VkWriteDescriptorSet_host * convert_VkWriteDescriptorSet_array_win_to_host(const VkWriteDescriptorSet *in, uint32_t count)
 {
     VkWriteDescriptorSet_host *out;
@@ -275,7 +107,7 @@ static inline VkWriteDescriptorSet_host * convert_VkWriteDescriptorSet_array_win
 
     if (!in) return NULL;
 
-    out = (VkWriteDescriptorSet_host *)heap_alloc(count * sizeof(*out));
+    out = (VkWriteDescriptorSet_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sType = in[i].sType;
@@ -286,27 +118,13 @@ static inline VkWriteDescriptorSet_host * convert_VkWriteDescriptorSet_array_win
         out[i].descriptorCount = in[i].descriptorCount;
         out[i].descriptorType = in[i].descriptorType;
         out[i].pImageInfo = convert_VkDescriptorImageInfo_array_win_to_host(in[i].pImageInfo, in[i].descriptorCount);
-        out[i].pBufferInfo = convert_VkDescriptorBufferInfo_array_win_to_host(in[i].pBufferInfo, in[i].descriptorCount);
+        out[i].pBufferInfo = in[i].pBufferInfo;
         out[i].pTexelBufferView = in[i].pTexelBufferView;
     }
 
     return out;
 }
 
-static inline void free_VkWriteDescriptorSet_array(VkWriteDescriptorSet_host *in, uint32_t count)
-{
-    unsigned int i;
-
-    if (!in) return;
-
-    for (i = 0; i < count; i++)
-    {
-        free_VkDescriptorImageInfo_array((VkDescriptorImageInfo_host *)in[i].pImageInfo, in[i].descriptorCount);
-        free_VkDescriptorBufferInfo_array((VkDescriptorBufferInfo_host *)in[i].pBufferInfo, in[i].descriptorCount);
-    }
-    heap_free(in);
-}
-
 static inline void convert_VkBufferCreateInfo_win_to_host(const VkBufferCreateInfo *in, VkBufferCreateInfo_host *out)
 {
     if (!in) return;
@@ -334,19 +152,6 @@ static inline void convert_VkBufferViewCreateInfo_win_to_host(const VkBufferView
     out->range = in->range;
 }
 
-static inline void convert_VkPipelineShaderStageCreateInfo_win_to_host(const VkPipelineShaderStageCreateInfo *in, VkPipelineShaderStageCreateInfo_host *out)
-{
-    if (!in) return;
-
-    out->sType = in->sType;
-    out->pNext = in->pNext;
-    out->flags = in->flags;
-    out->stage = in->stage;
-    out->module = in->module;
-    out->pName = in->pName;
-    out->pSpecializationInfo = in->pSpecializationInfo;
-}
-
 static inline VkComputePipelineCreateInfo_host * convert_VkComputePipelineCreateInfo_array_win_to_host(const VkComputePipelineCreateInfo *in, uint32_t count)
 {
     VkComputePipelineCreateInfo_host *out;
@@ -354,13 +159,13 @@ static inline VkComputePipelineCreateInfo_host * convert_VkComputePipelineCreate
 
     if (!in) return NULL;
 
-    out = (VkComputePipelineCreateInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkComputePipelineCreateInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sType = in[i].sType;
         out[i].pNext = in[i].pNext;
         out[i].flags = in[i].flags;
-        convert_VkPipelineShaderStageCreateInfo_win_to_host(&in[i].stage, &out[i].stage);
+        out[i].stage = in[i].stage;
         out[i].layout = in[i].layout;
         out[i].basePipelineHandle = in[i].basePipelineHandle;
         out[i].basePipelineIndex = in[i].basePipelineIndex;
@@ -369,13 +174,6 @@ static inline VkComputePipelineCreateInfo_host * convert_VkComputePipelineCreate
     return out;
 }
 
-static inline void free_VkComputePipelineCreateInfo_array(VkComputePipelineCreateInfo_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline void convert_VkDescriptorUpdateTemplateCreateInfoKHR_win_to_host(const VkDescriptorUpdateTemplateCreateInfoKHR *in, VkDescriptorUpdateTemplateCreateInfoKHR_host *out)
 {
     if (!in) return;
@@ -407,35 +205,6 @@ static inline void convert_VkFramebufferCreateInfo_win_to_host(const VkFramebuff
     out->layers = in->layers;
 }
 
-static inline VkPipelineShaderStageCreateInfo_host * convert_VkPipelineShaderStageCreateInfo_array_win_to_host(const VkPipelineShaderStageCreateInfo *in, uint32_t count)
-{
-    VkPipelineShaderStageCreateInfo_host *out;
-    unsigned int i;
-
-    if (!in) return NULL;
-
-    out = (VkPipelineShaderStageCreateInfo_host *)heap_alloc(count * sizeof(*out));
-    for (i = 0; i < count; i++)
-    {
-        out[i].sType = in[i].sType;
-        out[i].pNext = in[i].pNext;
-        out[i].flags = in[i].flags;
-        out[i].stage = in[i].stage;
-        out[i].module = in[i].module;
-        out[i].pName = in[i].pName;
-        out[i].pSpecializationInfo = in[i].pSpecializationInfo;
-    }
-
-    return out;
-}
-
-static inline void free_VkPipelineShaderStageCreateInfo_array(VkPipelineShaderStageCreateInfo_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline VkGraphicsPipelineCreateInfo_host * convert_VkGraphicsPipelineCreateInfo_array_win_to_host(const VkGraphicsPipelineCreateInfo *in, uint32_t count)
 {
     VkGraphicsPipelineCreateInfo_host *out;
@@ -443,14 +212,14 @@ static inline VkGraphicsPipelineCreateInfo_host * convert_VkGraphicsPipelineCrea
 
     if (!in) return NULL;
 
-    out = (VkGraphicsPipelineCreateInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkGraphicsPipelineCreateInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sType = in[i].sType;
         out[i].pNext = in[i].pNext;
         out[i].flags = in[i].flags;
         out[i].stageCount = in[i].stageCount;
-        out[i].pStages = convert_VkPipelineShaderStageCreateInfo_array_win_to_host(in[i].pStages, in[i].stageCount);
+        out[i].pStages = in[i].pStages;
         out[i].pVertexInputState = in[i].pVertexInputState;
         out[i].pInputAssemblyState = in[i].pInputAssemblyState;
         out[i].pTessellationState = in[i].pTessellationState;
@@ -470,19 +239,6 @@ static inline VkGraphicsPipelineCreateInfo_host * convert_VkGraphicsPipelineCrea
     return out;
 }
 
-static inline void free_VkGraphicsPipelineCreateInfo_array(VkGraphicsPipelineCreateInfo_host *in, uint32_t count)
-{
-    unsigned int i;
-
-    if (!in) return;
-
-    for (i = 0; i < count; i++)
-    {
-        free_VkPipelineShaderStageCreateInfo_array((VkPipelineShaderStageCreateInfo_host *)in[i].pStages, in[i].stageCount);
-    }
-    heap_free(in);
-}
-
 static inline void convert_VkImageViewCreateInfo_win_to_host(const VkImageViewCreateInfo *in, VkImageViewCreateInfo_host *out)
 {
     if (!in) return;
@@ -497,33 +253,6 @@ static inline void convert_VkImageViewCreateInfo_win_to_host(const VkImageViewCr
     out->subresourceRange = in->subresourceRange;
 }
 
-static inline VkMappedMemoryRange_host * convert_VkMappedMemoryRange_array_win_to_host(const VkMappedMemoryRange *in, uint32_t count)
-{
-    VkMappedMemoryRange_host *out;
-    unsigned int i;
-
-    if (!in) return NULL;
-
-    out = (VkMappedMemoryRange_host *)heap_alloc(count * sizeof(*out));
-    for (i = 0; i < count; i++)
-    {
-        out[i].sType = in[i].sType;
-        out[i].pNext = in[i].pNext;
-        out[i].memory = in[i].memory;
-        out[i].offset = in[i].offset;
-        out[i].size = in[i].size;
-    }
-
-    return out;
-}
-
-static inline void free_VkMappedMemoryRange_array(VkMappedMemoryRange_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline void convert_VkMemoryRequirements_host_to_win(const VkMemoryRequirements_host *in, VkMemoryRequirements *out)
 {
     if (!in) return;
@@ -533,45 +262,6 @@ static inline void convert_VkMemoryRequirements_host_to_win(const VkMemoryRequir
     out->memoryTypeBits = in->memoryTypeBits;
 }
 
-static inline void convert_VkSubresourceLayout_host_to_win(const VkSubresourceLayout_host *in, VkSubresourceLayout *out)
-{
-    if (!in) return;
-
-    out->offset = in->offset;
-    out->size = in->size;
-    out->rowPitch = in->rowPitch;
-    out->arrayPitch = in->arrayPitch;
-    out->depthPitch = in->depthPitch;
-}
-
-static inline void convert_VkImageFormatProperties_host_to_win(const VkImageFormatProperties_host *in, VkImageFormatProperties *out)
-{
-    if (!in) return;
-
-    out->maxExtent = in->maxExtent;
-    out->maxMipLevels = in->maxMipLevels;
-    out->maxArrayLayers = in->maxArrayLayers;
-    out->sampleCounts = in->sampleCounts;
-    out->maxResourceSize = in->maxResourceSize;
-}
-
-static inline void convert_VkImageFormatProperties2KHR_win_to_host(const VkImageFormatProperties2KHR *in, VkImageFormatProperties2KHR_host *out)
-{
-    if (!in) return;
-
-    out->pNext = in->pNext;
-    out->sType = in->sType;
-}
-
-static inline void convert_VkImageFormatProperties2KHR_host_to_win(const VkImageFormatProperties2KHR_host *in, VkImageFormatProperties2KHR *out)
-{
-    if (!in) return;
-
-    out->sType = in->sType;
-    out->pNext = in->pNext;
-    convert_VkImageFormatProperties_host_to_win(&in->imageFormatProperties, &out->imageFormatProperties);
-}
-
 static inline void convert_VkMemoryHeap_static_array_host_to_win(const VkMemoryHeap_host *in, VkMemoryHeap *out, uint32_t count)
 {
     unsigned int i;
@@ -763,7 +453,7 @@ static inline VkSparseMemoryBind_host * convert_VkSparseMemoryBind_array_win_to_
 
     if (!in) return NULL;
 
-    out = (VkSparseMemoryBind_host *)heap_alloc(count * sizeof(*out));
+    out = (VkSparseMemoryBind_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].resourceOffset = in[i].resourceOffset;
@@ -776,13 +466,6 @@ static inline VkSparseMemoryBind_host * convert_VkSparseMemoryBind_array_win_to_
     return out;
 }
 
-static inline void free_VkSparseMemoryBind_array(VkSparseMemoryBind_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline VkSparseBufferMemoryBindInfo_host * convert_VkSparseBufferMemoryBindInfo_array_win_to_host(const VkSparseBufferMemoryBindInfo *in, uint32_t count)
 {
     VkSparseBufferMemoryBindInfo_host *out;
@@ -790,7 +473,7 @@ static inline VkSparseBufferMemoryBindInfo_host * convert_VkSparseBufferMemoryBi
 
     if (!in) return NULL;
 
-    out = (VkSparseBufferMemoryBindInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkSparseBufferMemoryBindInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].buffer = in[i].buffer;
@@ -801,19 +484,6 @@ static inline VkSparseBufferMemoryBindInfo_host * convert_VkSparseBufferMemoryBi
     return out;
 }
 
-static inline void free_VkSparseBufferMemoryBindInfo_array(VkSparseBufferMemoryBindInfo_host *in, uint32_t count)
-{
-    unsigned int i;
-
-    if (!in) return;
-
-    for (i = 0; i < count; i++)
-    {
-        free_VkSparseMemoryBind_array((VkSparseMemoryBind_host *)in[i].pBinds, in[i].bindCount);
-    }
-    heap_free(in);
-}
-
 static inline VkSparseImageOpaqueMemoryBindInfo_host * convert_VkSparseImageOpaqueMemoryBindInfo_array_win_to_host(const VkSparseImageOpaqueMemoryBindInfo *in, uint32_t count)
 {
     VkSparseImageOpaqueMemoryBindInfo_host *out;
@@ -821,7 +491,7 @@ static inline VkSparseImageOpaqueMemoryBindInfo_host * convert_VkSparseImageOpaq
 
     if (!in) return NULL;
 
-    out = (VkSparseImageOpaqueMemoryBindInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkSparseImageOpaqueMemoryBindInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].image = in[i].image;
@@ -832,19 +502,6 @@ static inline VkSparseImageOpaqueMemoryBindInfo_host * convert_VkSparseImageOpaq
     return out;
 }
 
-static inline void free_VkSparseImageOpaqueMemoryBindInfo_array(VkSparseImageOpaqueMemoryBindInfo_host *in, uint32_t count)
-{
-    unsigned int i;
-
-    if (!in) return;
-
-    for (i = 0; i < count; i++)
-    {
-        free_VkSparseMemoryBind_array((VkSparseMemoryBind_host *)in[i].pBinds, in[i].bindCount);
-    }
-    heap_free(in);
-}
-
 static inline VkSparseImageMemoryBind_host * convert_VkSparseImageMemoryBind_array_win_to_host(const VkSparseImageMemoryBind *in, uint32_t count)
 {
     VkSparseImageMemoryBind_host *out;
@@ -852,7 +509,7 @@ static inline VkSparseImageMemoryBind_host * convert_VkSparseImageMemoryBind_arr
 
     if (!in) return NULL;
 
-    out = (VkSparseImageMemoryBind_host *)heap_alloc(count * sizeof(*out));
+    out = (VkSparseImageMemoryBind_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].subresource = in[i].subresource;
@@ -866,13 +523,6 @@ static inline VkSparseImageMemoryBind_host * convert_VkSparseImageMemoryBind_arr
     return out;
 }
 
-static inline void free_VkSparseImageMemoryBind_array(VkSparseImageMemoryBind_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 static inline VkSparseImageMemoryBindInfo_host * convert_VkSparseImageMemoryBindInfo_array_win_to_host(const VkSparseImageMemoryBindInfo *in, uint32_t count)
 {
     VkSparseImageMemoryBindInfo_host *out;
@@ -880,7 +530,7 @@ static inline VkSparseImageMemoryBindInfo_host * convert_VkSparseImageMemoryBind
 
     if (!in) return NULL;
 
-    out = (VkSparseImageMemoryBindInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkSparseImageMemoryBindInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].image = in[i].image;
@@ -891,27 +541,14 @@ static inline VkSparseImageMemoryBindInfo_host * convert_VkSparseImageMemoryBind
     return out;
 }
 
-static inline void free_VkSparseImageMemoryBindInfo_array(VkSparseImageMemoryBindInfo_host *in, uint32_t count)
+static inline VkBindSparseInfo_host * convert_VkBindSparseInfo_array_win_to_host(const VkBindSparseInfo *in, uint32_t count)
 {
-    unsigned int i;
-
-    if (!in) return;
-
-    for (i = 0; i < count; i++)
-    {
-        free_VkSparseImageMemoryBind_array((VkSparseImageMemoryBind_host *)in[i].pBinds, in[i].bindCount);
-    }
-    heap_free(in);
-}
-
-static inline VkBindSparseInfo_host * convert_VkBindSparseInfo_array_win_to_host(const VkBindSparseInfo *in, uint32_t count)
-{
-    VkBindSparseInfo_host *out;
+    VkBindSparseInfo_host *out;
     unsigned int i;
 
     if (!in) return NULL;
 
-    out = (VkBindSparseInfo_host *)heap_alloc(count * sizeof(*out));
+    out = (VkBindSparseInfo_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sType = in[i].sType;
@@ -931,21 +568,6 @@ static inline VkBindSparseInfo_host * convert_VkBindSparseInfo_array_win_to_host
     return out;
 }
 
-static inline void free_VkBindSparseInfo_array(VkBindSparseInfo_host *in, uint32_t count)
-{
-    unsigned int i;
-
-    if (!in) return;
-
-    for (i = 0; i < count; i++)
-    {
-        free_VkSparseBufferMemoryBindInfo_array((VkSparseBufferMemoryBindInfo_host *)in[i].pBufferBinds, in[i].bufferBindCount);
-        free_VkSparseImageOpaqueMemoryBindInfo_array((VkSparseImageOpaqueMemoryBindInfo_host *)in[i].pImageOpaqueBinds, in[i].imageOpaqueBindCount);
-        free_VkSparseImageMemoryBindInfo_array((VkSparseImageMemoryBindInfo_host *)in[i].pImageBinds, in[i].imageBindCount);
-    }
-    heap_free(in);
-}
-
 static inline VkCopyDescriptorSet_host * convert_VkCopyDescriptorSet_array_win_to_host(const VkCopyDescriptorSet *in, uint32_t count)
 {
     VkCopyDescriptorSet_host *out;
@@ -953,7 +575,7 @@ static inline VkCopyDescriptorSet_host * convert_VkCopyDescriptorSet_array_win_t
 
     if (!in) return NULL;
 
-    out = (VkCopyDescriptorSet_host *)heap_alloc(count * sizeof(*out));
+    out = (VkCopyDescriptorSet_host *)wine_vk_arena_alloc(count * sizeof(*out));
     for (i = 0; i < count; i++)
     {
         out[i].sType = in[i].sType;
@@ -970,47 +592,12 @@ static inline VkCopyDescriptorSet_host * convert_VkCopyDescriptorSet_array_win_t
     return out;
 }
 
-static inline void free_VkCopyDescriptorSet_array(VkCopyDescriptorSet_host *in, uint32_t count)
-{
-    if (!in) return;
-
-    heap_free(in);
-}
-
 #endif /* USE_STRUCT_CONVERSION */
 
 static VkResult WINAPI wine_vkAllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo *pAllocateInfo, VkDescriptorSet *pDescriptorSets)
 {
-#if defined(USE_STRUCT_CONVERSION)
-    VkResult result;
-    VkDescriptorSetAllocateInfo_host pAllocateInfo_host;
-    TRACE("%p, %p, %p\n", device, pAllocateInfo, pDescriptorSets);
-
-    convert_VkDescriptorSetAllocateInfo_win_to_host(pAllocateInfo, &pAllocateInfo_host);
-    result = device->funcs.p_vkAllocateDescriptorSets(device->device, &pAllocateInfo_host, pDescriptorSets);
-
-    return result;
-#else
     TRACE("%p, %p, %p\n", device, pAllocateInfo, pDescriptorSets);
     return device->funcs.p_vkAllocateDescriptorSets(device->device, pAllocateInfo, pDescriptorSets);
-#endif
-}
-
-static VkResult WINAPI wine_vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo *pAllocateInfo, const VkAllocationCallbacks *pAllocator, VkDeviceMemory *pMemory)
-{
-#if defined(USE_STRUCT_CONVERSION)
-    VkResult result;
-    VkMemoryAllocateInfo_host pAllocateInfo_host;
-    TRACE("%p, %p, %p, %p\n", device, pAllocateInfo, pAllocator, pMemory);
-
-    convert_VkMemoryAllocateInfo_win_to_host(pAllocateInfo, &pAllocateInfo_host);
-    result = device->funcs.p_vkAllocateMemory(device->device, &pAllocateInfo_host, NULL, pMemory);
-
-    return result;
-#else
-    TRACE("%p, %p, %p, %p\n", device, pAllocateInfo, pAllocator, pMemory);
-    return device->funcs.p_vkAllocateMemory(device->device, pAllocateInfo, NULL, pMemory);
-#endif
 }
 
 static VkResult WINAPI wine_vkBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo *pBeginInfo)
@@ -1023,7 +610,7 @@ static VkResult WINAPI wine_vkBeginCommandBuffer(VkCommandBuffer commandBuffer,
     convert_VkCommandBufferBeginInfo_win_to_host(pBeginInfo, &pBeginInfo_host);
     result = commandBuffer->device->funcs.p_vkBeginCommandBuffer(commandBuffer->command_buffer, &pBeginInfo_host);
 
-    free_VkCommandBufferBeginInfo(&pBeginInfo_host);
+    wine_vk_arena_reset();
     return result;
 #else
     TRACE("%p, %p\n", commandBuffer, pBeginInfo);
@@ -1051,41 +638,32 @@ static void WINAPI wine_vkCmdBeginQuery(VkCommandBuffer commandBuffer, VkQueryPo
 
 static void WINAPI wine_vkCmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo *pRenderPassBegin, VkSubpassContents contents)
 {
-#if defined(USE_STRUCT_CONVERSION)
-    VkRenderPassBeginInfo_host pRenderPassBegin_host;
-    TRACE("%p, %p, %d\n", commandBuffer, pRenderPassBegin, contents);
-
-    convert_VkRenderPassBeginInfo_win_to_host(pRenderPassBegin, &pRenderPassBegin_host);
-    commandBuffer->device->funcs.p_vkCmdBeginRenderPass(commandBuffer->command_buffer, &pRenderPassBegin_host, contents);
-
-#else
     TRACE("%p, %p, %d\n", commandBuffer, pRenderPassBegin, contents);
     commandBuffer->device->funcs.p_vkCmdBeginRenderPass(commandBuffer->command_buffer, pRenderPassBegin, contents);
-#endif
 }
 
 static void WINAPI wine_vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t *pDynamicOffsets)
 {
     TRACE("%p, %d, 0x%s, %u, %u, %p, %u, %p\n", commandBuffer, pipelineBindPoint, wine_dbgstr_longlong(layout), firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
-    commandBuffer->device->funcs.p_vkCmdBindDescriptorSets(commandBuffer->command_buffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+    commandBuffer->funcs.p_vkCmdBindDescriptorSets(commandBuffer->command_buffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
 }
 
 static void WINAPI wine_vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
 {
     TRACE("%p, 0x%s, 0x%s, %d\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), indexType);
-    commandBuffer->device->funcs.p_vkCmdBindIndexBuffer(commandBuffer->command_buffer, buffer, offset, indexType);
+    commandBuffer->funcs.p_vkCmdBindIndexBuffer(commandBuffer->command_buffer, buffer, offset, indexType);
 }
 
 static void WINAPI wine_vkCmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
 {
     TRACE("%p, %d, 0x%s\n", commandBuffer, pipelineBindPoint, wine_dbgstr_longlong(pipeline));
-    commandBuffer->device->funcs.p_vkCmdBindPipeline(commandBuffer->command_buffer, pipelineBindPoint, pipeline);
+    commandBuffer->funcs.p_vkCmdBindPipeline(commandBuffer->command_buffer, pipelineBindPoint, pipeline);
 }
 
 static void WINAPI wine_vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *pBuffers, const VkDeviceSize *pOffsets)
 {
     TRACE("%p, %u, %u, %p, %p\n", commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
-    commandBuffer->device->funcs.p_vkCmdBindVertexBuffers(commandBuffer->command_buffer, firstBinding, bindingCount, pBuffers, pOffsets);
+    commandBuffer->funcs.p_vkCmdBindVertexBuffers(commandBuffer->command_buffer, firstBinding, bindingCount, pBuffers, pOffsets);
 }
 
 static void WINAPI wine_vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageBlit *pRegions, VkFilter filter)
@@ -1114,34 +692,14 @@ static void WINAPI wine_vkCmdClearDepthStencilImage(VkCommandBuffer commandBuffe
 
 static void WINAPI wine_vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy *pRegions)
 {
-#if defined(USE_STRUCT_CONVERSION)
-    VkBufferCopy_host *pRegions_host;
-    TRACE("%p, 0x%s, 0x%s, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcBuffer), wine_dbgstr_longlong(dstBuffer), regionCount, pRegions);
-
-    pRegions_host = convert_VkBufferCopy_array_win_to_host(pRegions, regionCount);
-    commandBuffer->device->funcs.p_vkCmdCopyBuffer(commandBuffer->command_buffer, srcBuffer, dstBuffer, regionCount, pRegions_host);
-
-    free_VkBufferCopy_array(pRegions_host, regionCount);
-#else
     TRACE("%p, 0x%s, 0x%s, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcBuffer), wine_dbgstr_longlong(dstBuffer), regionCount, pRegions);
     commandBuffer->device->funcs.p_vkCmdCopyBuffer(commandBuffer->command_buffer, srcBuffer, dstBuffer, regionCount, pRegions);
-#endif
 }
 
 static void WINAPI wine_vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy *pRegions)
 {
-#if defined(USE_STRUCT_CONVERSION)
-    VkBufferImageCopy_host *pRegions_host;
-    TRACE("%p, 0x%s, 0x%s, %d, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcBuffer), wine_dbgstr_longlong(dstImage), dstImageLayout, regionCount, pRegions);
-
-    pRegions_host = convert_VkBufferImageCopy_array_win_to_host(pRegions, regionCount);
-    commandBuffer->device->funcs.p_vkCmdCopyBufferToImage(commandBuffer->command_buffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions_host);
-
-    free_VkBufferImageCopy_array(pRegions_host, regionCount);
-#else
     TRACE("%p, 0x%s, 0x%s, %d, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcBuffer), wine_dbgstr_longlong(dstImage), dstImageLayout, regionCount, pRegions);
     commandBuffer->device->funcs.p_vkCmdCopyBufferToImage(commandBuffer->command_buffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions);
-#endif
 }
 
 static void WINAPI wine_vkCmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageCopy *pRegions)
@@ -1152,18 +710,8 @@ static void WINAPI wine_vkCmdCopyImage(VkCommandBuffer commandBuffer, VkImage sr
 
 static void WINAPI wine_vkCmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferImageCopy *pRegions)
 {
-#if defined(USE_STRUCT_CONVERSION)
-    VkBufferImageCopy_host *pRegions_host;
-    TRACE("%p, 0x%s, %d, 0x%s, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcImage), srcImageLayout, wine_dbgstr_longlong(dstBuffer), regionCount, pRegions);
-
-    pRegions_host = convert_VkBufferImageCopy_array_win_to_host(pRegions, regionCount);
-    commandBuffer->device->funcs.p_vkCmdCopyImageToBuffer(commandBuffer->command_buffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions_host);
-
-    free_VkBufferImageCopy_array(pRegions_host, regionCount);
-#else
     TRACE("%p, 0x%s, %d, 0x%s, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcImage), srcImageLayout, wine_dbgstr_longlong(dstBuffer), regionCount, pRegions);
     commandBuffer->device->funcs.p_vkCmdCopyImageToBuffer(commandBuffer->command_buffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions);
-#endif
 }
 
 static void WINAPI wine_vkCmdCopyQueryPoolResults(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize stride, VkQueryResultFlags flags)
@@ -1175,7 +723,7 @@ static void WINAPI wine_vkCmdCopyQueryPoolResults(VkCommandBuffer commandBuffer,
 static void WINAPI wine_vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
 {
     TRACE("%p, %u, %u, %u\n", commandBuffer, groupCountX, groupCountY, groupCountZ);
-    commandBuffer->device->funcs.p_vkCmdDispatch(commandBuffer->command_buffer, groupCountX, groupCountY, groupCountZ);
+    commandBuffer->funcs.p_vkCmdDispatch(commandBuffer->command_buffer, groupCountX, groupCountY, groupCountZ);
 }
 
 static void WINAPI wine_vkCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset)
@@ -1187,19 +735,19 @@ static void WINAPI wine_vkCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkB
 static void WINAPI wine_vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
 {
     TRACE("%p, %u, %u, %u, %u\n", commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
-    commandBuffer->device->funcs.p_vkCmdDraw(commandBuffer->command_buffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    commandBuffer->funcs.p_vkCmdDraw(commandBuffer->command_buffer, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
 static void WINAPI wine_vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
 {
     TRACE("%p, %u, %u, %u, %d, %u\n", commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
-    commandBuffer->device->funcs.p_vkCmdDrawIndexed(commandBuffer->command_buffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    commandBuffer->funcs.p_vkCmdDrawIndexed(commandBuffer->command_buffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 }
 
 static void WINAPI wine_vkCmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
 {
     TRACE("%p, 0x%s, 0x%s, %u, %u\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), drawCount, stride);
-    commandBuffer->device->funcs.p_vkCmdDrawIndexedIndirect(commandBuffer->command_buffer, buffer, offset, drawCount, stride);
+    commandBuffer->funcs.p_vkCmdDrawIndexedIndirect(commandBuffer->command_buffer, buffer, offset, drawCount, stride);
 }
 
 static void WINAPI wine_vkCmdDrawIndexedIndirectCountAMD(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
@@ -1211,7 +759,7 @@ static void WINAPI wine_vkCmdDrawIndexedIndirectCountAMD(VkCommandBuffer command
 static void WINAPI wine_vkCmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
 {
     TRACE("%p, 0x%s, 0x%s, %u, %u\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), drawCount, stride);
-    commandBuffer->device->funcs.p_vkCmdDrawIndirect(commandBuffer->command_buffer, buffer, offset, drawCount, stride);
+    commandBuffer->funcs.p_vkCmdDrawIndirect(commandBuffer->command_buffer, buffer, offset, drawCount, stride);
 }
 
 static void WINAPI wine_vkCmdDrawIndirectCountAMD(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
@@ -1247,26 +795,23 @@ static void WINAPI wine_vkCmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpas
 static void WINAPI wine_vkCmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
 {
 #if defined(USE_STRUCT_CONVERSION)
-    VkBufferMemoryBarrier_host *pBufferMemoryBarriers_host;
     VkImageMemoryBarrier_host *pImageMemoryBarriers_host;
     TRACE("%p, %#x, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
 
-    pBufferMemoryBarriers_host = convert_VkBufferMemoryBarrier_array_win_to_host(pBufferMemoryBarriers, bufferMemoryBarrierCount);
     pImageMemoryBarriers_host = convert_VkImageMemoryBarrier_array_win_to_host(pImageMemoryBarriers, imageMemoryBarrierCount);
-    commandBuffer->device->funcs.p_vkCmdPipelineBarrier(commandBuffer->command_buffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers_host, imageMemoryBarrierCount, pImageMemoryBarriers_host);
+    commandBuffer->funcs.p_vkCmdPipelineBarrier(commandBuffer->command_buffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers_host);
 
-    free_VkBufferMemoryBarrier_array(pBufferMemoryBarriers_host, bufferMemoryBarrierCount);
-    free_VkImageMemoryBarrier_array(pImageMemoryBarriers_host, imageMemoryBarrierCount);
+    wine_vk_arena_reset();
 #else
     TRACE("%p, %#x, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
-    commandBuffer->device->funcs.p_vkCmdPipelineBarrier(commandBuffer->command_buffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+    commandBuffer->funcs.p_vkCmdPipelineBarrier(commandBuffer->command_buffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
 #endif
 }
 
 static void WINAPI wine_vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void *pValues)
 {
     TRACE("%p, 0x%s, %#x, %u, %u, %p\n", commandBuffer, wine_dbgstr_longlong(layout), stageFlags, offset, size, pValues);
-    commandBuffer->device->funcs.p_vkCmdPushConstants(commandBuffer->command_buffer, layout, stageFlags, offset, size, pValues);
+    commandBuffer->funcs.p_vkCmdPushConstants(commandBuffer->command_buffer, layout, stageFlags, offset, size, pValues);
 }
 
 static void WINAPI wine_vkCmdPushDescriptorSetKHR(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t set, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites)
@@ -1278,7 +823,7 @@ static void WINAPI wine_vkCmdPushDescriptorSetKHR(VkCommandBuffer commandBuffer,
     pDescriptorWrites_host = convert_VkWriteDescriptorSet_array_win_to_host(pDescriptorWrites, descriptorWriteCount);
     commandBuffer->device->funcs.p_vkCmdPushDescriptorSetKHR(commandBuffer->command_buffer, pipelineBindPoint, layout, set, descriptorWriteCount, pDescriptorWrites_host);
 
-    free_VkWriteDescriptorSet_array(pDescriptorWrites_host, descriptorWriteCount);
+    wine_vk_arena_reset();
 #else
     TRACE("%p, %d, 0x%s, %u, %u, %p\n", commandBuffer, pipelineBindPoint, wine_dbgstr_longlong(layout), set, descriptorWriteCount, pDescriptorWrites);
     commandBuffer->device->funcs.p_vkCmdPushDescriptorSetKHR(commandBuffer->command_buffer, pipelineBindPoint, layout, set, descriptorWriteCount, pDescriptorWrites);
@@ -1348,7 +893,7 @@ static void WINAPI wine_vkCmdSetLineWidth(VkCommandBuffer commandBuffer, float l
 static void WINAPI wine_vkCmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t scissorCount, const VkRect2D *pScissors)
 {
     TRACE("%p, %u, %u, %p\n", commandBuffer, firstScissor, scissorCount, pScissors);
-    commandBuffer->device->funcs.p_vkCmdSetScissor(commandBuffer->command_buffer, firstScissor, scissorCount, pScissors);
+    commandBuffer->funcs.p_vkCmdSetScissor(commandBuffer->command_buffer, firstScissor, scissorCount, pScissors);
 }
 
 static void WINAPI wine_vkCmdSetStencilCompareMask(VkCommandBuffer commandBuffer, VkStencilFaceFlags faceMask, uint32_t compareMask)
@@ -1372,7 +917,7 @@ static void WINAPI wine_vkCmdSetStencilWriteMask(VkCommandBuffer commandBuffer,
 static void WINAPI wine_vkCmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewport *pViewports)
 {
     TRACE("%p, %u, %u, %p\n", commandBuffer, firstViewport, viewportCount, pViewports);
-    commandBuffer->device->funcs.p_vkCmdSetViewport(commandBuffer->command_buffer, firstViewport, viewportCount, pViewports);
+    commandBuffer->funcs.p_vkCmdSetViewport(commandBuffer->command_buffer, firstViewport, viewportCount, pViewports);
 }
 
 static void WINAPI wine_vkCmdSetViewportWScalingNV(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewportWScalingNV *pViewportWScalings)
@@ -1390,16 +935,13 @@ static void WINAPI wine_vkCmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffe
 static void WINAPI wine_vkCmdWaitEvents(VkCommandBuffer commandBuffer, uint32_t eventCount, const VkEvent *pEvents, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
 {
 #if defined(USE_STRUCT_CONVERSION)
-    VkBufferMemoryBarrier_host *pBufferMemoryBarriers_host;
     VkImageMemoryBarrier_host *pImageMemoryBarriers_host;
     TRACE("%p, %u, %p, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
 
-    pBufferMemoryBarriers_host = convert_VkBufferMemoryBarrier_array_win_to_host(pBufferMemoryBarriers, bufferMemoryBarrierCount);
     pImageMemoryBarriers_host = convert_VkImageMemoryBarrier_array_win_to_host(pImageMemoryBarriers, imageMemoryBarrierCount);
-    commandBuffer->device->funcs.p_vkCmdWaitEvents(commandBuffer->command_buffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers_host, imageMemoryBarrierCount, pImageMemoryBarriers_host);
+    commandBuffer->device->funcs.p_vkCmdWaitEvents(commandBuffer->command_buffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers_host);
 
-    free_VkBufferMemoryBarrier_array(pBufferMemoryBarriers_host, bufferMemoryBarrierCount);
-    free_VkImageMemoryBarrier_array(pImageMemoryBarriers_host, imageMemoryBarrierCount);
+    wine_vk_arena_reset();
 #else
     TRACE("%p, %u, %p, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
     commandBuffer->device->funcs.p_vkCmdWaitEvents(commandBuffer->command_buffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
@@ -1446,12 +988,6 @@ static VkResult WINAPI wine_vkCreateBufferView(VkDevice device, const VkBufferVi
 #endif
 }
 
-static VkResult WINAPI wine_vkCreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkCommandPool *pCommandPool)
-{
-    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pCommandPool);
-    return device->funcs.p_vkCreateCommandPool(device->device, pCreateInfo, NULL, pCommandPool);
-}
-
 static VkResult WINAPI wine_vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
 {
 #if defined(USE_STRUCT_CONVERSION)
@@ -1460,13 +996,13 @@ static VkResult WINAPI wine_vkCreateComputePipelines(VkDevice device, VkPipeline
     TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
 
     pCreateInfos_host = convert_VkComputePipelineCreateInfo_array_win_to_host(pCreateInfos, createInfoCount);
-    result = device->funcs.p_vkCreateComputePipelines(device->device, pipelineCache, createInfoCount, pCreateInfos_host, NULL, pPipelines);
+    result = device->funcs.p_vkCreateComputePipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos_host, NULL, pPipelines);
 
-    free_VkComputePipelineCreateInfo_array(pCreateInfos_host, createInfoCount);
+    wine_vk_arena_reset();
     return result;
 #else
     TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
-    return device->funcs.p_vkCreateComputePipelines(device->device, pipelineCache, createInfoCount, pCreateInfos, NULL, pPipelines);
+    return device->funcs.p_vkCreateComputePipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos, NULL, pPipelines);
 #endif
 }
 
@@ -1536,13 +1072,13 @@ static VkResult WINAPI wine_vkCreateGraphicsPipelines(VkDevice device, VkPipelin
     TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
 
     pCreateInfos_host = convert_VkGraphicsPipelineCreateInfo_array_win_to_host(pCreateInfos, createInfoCount);
-    result = device->funcs.p_vkCreateGraphicsPipelines(device->device, pipelineCache, createInfoCount, pCreateInfos_host, NULL, pPipelines);
+    result = device->funcs.p_vkCreateGraphicsPipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos_host, NULL, pPipelines);
 
-    free_VkGraphicsPipelineCreateInfo_array(pCreateInfos_host, createInfoCount);
+    wine_vk_arena_reset();
     return result;
 #else
     TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
-    return device->funcs.p_vkCreateGraphicsPipelines(device->device, pipelineCache, createInfoCount, pCreateInfos, NULL, pPipelines);
+    return device->funcs.p_vkCreateGraphicsPipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos, NULL, pPipelines);
 #endif
 }
 
@@ -1623,12 +1159,6 @@ static void WINAPI wine_vkDestroyBufferView(VkDevice device, VkBufferView buffer
     device->funcs.p_vkDestroyBufferView(device->device, bufferView, NULL);
 }
 
-static void WINAPI wine_vkDestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks *pAllocator)
-{
-    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(commandPool), pAllocator);
-    device->funcs.p_vkDestroyCommandPool(device->device, commandPool, NULL);
-}
-
 static void WINAPI wine_vkDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks *pAllocator)
 {
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(descriptorPool), pAllocator);
@@ -1665,485 +1195,2642 @@ static void WINAPI wine_vkDestroyFramebuffer(VkDevice device, VkFramebuffer fram
     device->funcs.p_vkDestroyFramebuffer(device->device, framebuffer, NULL);
 }
 
-static void WINAPI wine_vkDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_vkDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(image), pAllocator);
+    device->funcs.p_vkDestroyImage(device->device, image, NULL);
+}
+
+static void WINAPI wine_vkDestroyImageView(VkDevice device, VkImageView imageView, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(imageView), pAllocator);
+    device->funcs.p_vkDestroyImageView(device->device, imageView, NULL);
+}
+
+static void WINAPI wine_vkDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(pipeline), pAllocator);
+    device->funcs.p_vkDestroyPipeline(device->device, pipeline, NULL);
+}
+
+static void WINAPI wine_vkDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(pipelineCache), pAllocator);
+    device->funcs.p_vkDestroyPipelineCache(device->device, pipelineCache, NULL);
+}
+
+static void WINAPI wine_vkDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(pipelineLayout), pAllocator);
+    device->funcs.p_vkDestroyPipelineLayout(device->device, pipelineLayout, NULL);
+}
+
+static void WINAPI wine_vkDestroyQueryPool(VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(queryPool), pAllocator);
+    device->funcs.p_vkDestroyQueryPool(device->device, queryPool, NULL);
+}
+
+static void WINAPI wine_vkDestroyRenderPass(VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(renderPass), pAllocator);
+    device->funcs.p_vkDestroyRenderPass(device->device, renderPass, NULL);
+}
+
+static void WINAPI wine_vkDestroySampler(VkDevice device, VkSampler sampler, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(sampler), pAllocator);
+    device->funcs.p_vkDestroySampler(device->device, sampler, NULL);
+}
+
+static void WINAPI wine_vkDestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(semaphore), pAllocator);
+    device->funcs.p_vkDestroySemaphore(device->device, semaphore, NULL);
+}
+
+static void WINAPI wine_vkDestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks *pAllocator)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(shaderModule), pAllocator);
+    device->funcs.p_vkDestroyShaderModule(device->device, shaderModule, NULL);
+}
+
+static VkResult WINAPI wine_vkEndCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    TRACE("%p\n", commandBuffer);
+    return commandBuffer->device->funcs.p_vkEndCommandBuffer(commandBuffer->command_buffer);
+}
+
+static VkResult WINAPI wine_vkEnumerateDeviceLayerProperties(VkPhysicalDevice physicalDevice, uint32_t *pPropertyCount, VkLayerProperties *pProperties)
+{
+    TRACE("%p, %p, %p\n", physicalDevice, pPropertyCount, pProperties);
+    return physicalDevice->instance->funcs.p_vkEnumerateDeviceLayerProperties(physicalDevice->phys_dev, pPropertyCount, pProperties);
+}
+
+static VkResult WINAPI wine_vkFlushMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+{
+    TRACE("%p, %u, %p\n", device, memoryRangeCount, pMemoryRanges);
+    return device->funcs.p_vkFlushMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges);
+}
+
+static VkResult WINAPI wine_vkFreeDescriptorSets(VkDevice device, VkDescriptorPool descriptorPool, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets)
+{
+    TRACE("%p, 0x%s, %u, %p\n", device, wine_dbgstr_longlong(descriptorPool), descriptorSetCount, pDescriptorSets);
+    return device->funcs.p_vkFreeDescriptorSets(device->device, descriptorPool, descriptorSetCount, pDescriptorSets);
+}
+
+static void WINAPI wine_vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements *pMemoryRequirements)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkMemoryRequirements_host pMemoryRequirements_host;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(buffer), pMemoryRequirements);
+
+    device->funcs.p_vkGetBufferMemoryRequirements(device->device, buffer, &pMemoryRequirements_host);
+
+    convert_VkMemoryRequirements_host_to_win(&pMemoryRequirements_host, pMemoryRequirements);
+#else
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(buffer), pMemoryRequirements);
+    device->funcs.p_vkGetBufferMemoryRequirements(device->device, buffer, pMemoryRequirements);
+#endif
+}
+
+static void WINAPI wine_vkGetDeviceMemoryCommitment(VkDevice device, VkDeviceMemory memory, VkDeviceSize *pCommittedMemoryInBytes)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(memory), pCommittedMemoryInBytes);
+    device->funcs.p_vkGetDeviceMemoryCommitment(device->device, memory, pCommittedMemoryInBytes);
+}
+
+static VkResult WINAPI wine_vkGetEventStatus(VkDevice device, VkEvent event)
+{
+    TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(event));
+    return device->funcs.p_vkGetEventStatus(device->device, event);
+}
+
+static VkResult WINAPI wine_vkGetFenceStatus(VkDevice device, VkFence fence)
+{
+    TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(fence));
+    return device->funcs.p_vkGetFenceStatus(device->device, fence);
+}
+
+static void WINAPI wine_vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements *pMemoryRequirements)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkMemoryRequirements_host pMemoryRequirements_host;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(image), pMemoryRequirements);
+
+    device->funcs.p_vkGetImageMemoryRequirements(device->device, image, &pMemoryRequirements_host);
+
+    convert_VkMemoryRequirements_host_to_win(&pMemoryRequirements_host, pMemoryRequirements);
+#else
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(image), pMemoryRequirements);
+    device->funcs.p_vkGetImageMemoryRequirements(device->device, image, pMemoryRequirements);
+#endif
+}
+
+static void WINAPI wine_vkGetImageSparseMemoryRequirements(VkDevice device, VkImage image, uint32_t *pSparseMemoryRequirementCount, VkSparseImageMemoryRequirements *pSparseMemoryRequirements)
+{
+    TRACE("%p, 0x%s, %p, %p\n", device, wine_dbgstr_longlong(image), pSparseMemoryRequirementCount, pSparseMemoryRequirements);
+    device->funcs.p_vkGetImageSparseMemoryRequirements(device->device, image, pSparseMemoryRequirementCount, pSparseMemoryRequirements);
+}
+
+static void WINAPI wine_vkGetImageSubresourceLayout(VkDevice device, VkImage image, const VkImageSubresource *pSubresource, VkSubresourceLayout *pLayout)
+{
+    TRACE("%p, 0x%s, %p, %p\n", device, wine_dbgstr_longlong(image), pSubresource, pLayout);
+    device->funcs.p_vkGetImageSubresourceLayout(device->device, image, pSubresource, pLayout);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceFeatures(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures *pFeatures)
+{
+    TRACE("%p, %p\n", physicalDevice, pFeatures);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFeatures(physicalDevice->phys_dev, pFeatures);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceFeatures2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2KHR *pFeatures)
+{
+    TRACE("%p, %p\n", physicalDevice, pFeatures);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFeatures2KHR(physicalDevice->phys_dev, pFeatures);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties *pFormatProperties)
+{
+    TRACE("%p, %d, %p\n", physicalDevice, format, pFormatProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFormatProperties(physicalDevice->phys_dev, format, pFormatProperties);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceFormatProperties2KHR(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties2KHR *pFormatProperties)
+{
+    TRACE("%p, %d, %p\n", physicalDevice, format, pFormatProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFormatProperties2KHR(physicalDevice->phys_dev, format, pFormatProperties);
+}
+
+static VkResult WINAPI wine_vkGetPhysicalDeviceImageFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkImageType type, VkImageTiling tiling, VkImageUsageFlags usage, VkImageCreateFlags flags, VkImageFormatProperties *pImageFormatProperties)
+{
+    TRACE("%p, %d, %d, %d, %#x, %#x, %p\n", physicalDevice, format, type, tiling, usage, flags, pImageFormatProperties);
+    return physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties(physicalDevice->phys_dev, format, type, tiling, usage, flags, pImageFormatProperties);
+}
+
+static VkResult WINAPI wine_vkGetPhysicalDeviceImageFormatProperties2KHR(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceImageFormatInfo2KHR *pImageFormatInfo, VkImageFormatProperties2KHR *pImageFormatProperties)
+{
+    TRACE("%p, %p, %p\n", physicalDevice, pImageFormatInfo, pImageFormatProperties);
+    return physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties2KHR(physicalDevice->phys_dev, pImageFormatInfo, pImageFormatProperties);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties *pMemoryProperties)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkPhysicalDeviceMemoryProperties_host pMemoryProperties_host;
+    TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
+
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties(physicalDevice->phys_dev, &pMemoryProperties_host);
+
+    convert_VkPhysicalDeviceMemoryProperties_host_to_win(&pMemoryProperties_host, pMemoryProperties);
+#else
+    TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties(physicalDevice->phys_dev, pMemoryProperties);
+#endif
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceMemoryProperties2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2KHR *pMemoryProperties)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkPhysicalDeviceMemoryProperties2KHR_host pMemoryProperties_host;
+    TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
+
+    convert_VkPhysicalDeviceMemoryProperties2KHR_win_to_host(pMemoryProperties, &pMemoryProperties_host);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties2KHR(physicalDevice->phys_dev, &pMemoryProperties_host);
+
+    convert_VkPhysicalDeviceMemoryProperties2KHR_host_to_win(&pMemoryProperties_host, pMemoryProperties);
+#else
+    TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties2KHR(physicalDevice->phys_dev, pMemoryProperties);
+#endif
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkPhysicalDeviceProperties_host pProperties_host;
+    TRACE("%p, %p\n", physicalDevice, pProperties);
+
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties(physicalDevice->phys_dev, &pProperties_host);
+
+    convert_VkPhysicalDeviceProperties_host_to_win(&pProperties_host, pProperties);
+#else
+    TRACE("%p, %p\n", physicalDevice, pProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties(physicalDevice->phys_dev, pProperties);
+#endif
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceProperties2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2KHR *pProperties)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkPhysicalDeviceProperties2KHR_host pProperties_host;
+    TRACE("%p, %p\n", physicalDevice, pProperties);
+
+    convert_VkPhysicalDeviceProperties2KHR_win_to_host(pProperties, &pProperties_host);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties2KHR(physicalDevice->phys_dev, &pProperties_host);
+
+    convert_VkPhysicalDeviceProperties2KHR_host_to_win(&pProperties_host, pProperties);
+#else
+    TRACE("%p, %p\n", physicalDevice, pProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties2KHR(physicalDevice->phys_dev, pProperties);
+#endif
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties *pQueueFamilyProperties)
+{
+    TRACE("%p, %p, %p\n", physicalDevice, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice->phys_dev, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceQueueFamilyProperties2KHR(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties2KHR *pQueueFamilyProperties)
+{
+    TRACE("%p, %p, %p\n", physicalDevice, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceQueueFamilyProperties2KHR(physicalDevice->phys_dev, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceSparseImageFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkImageType type, VkSampleCountFlagBits samples, VkImageUsageFlags usage, VkImageTiling tiling, uint32_t *pPropertyCount, VkSparseImageFormatProperties *pProperties)
+{
+    TRACE("%p, %d, %d, %d, %#x, %d, %p, %p\n", physicalDevice, format, type, samples, usage, tiling, pPropertyCount, pProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceSparseImageFormatProperties(physicalDevice->phys_dev, format, type, samples, usage, tiling, pPropertyCount, pProperties);
+}
+
+static void WINAPI wine_vkGetPhysicalDeviceSparseImageFormatProperties2KHR(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceSparseImageFormatInfo2KHR *pFormatInfo, uint32_t *pPropertyCount, VkSparseImageFormatProperties2KHR *pProperties)
+{
+    TRACE("%p, %p, %p, %p\n", physicalDevice, pFormatInfo, pPropertyCount, pProperties);
+    physicalDevice->instance->funcs.p_vkGetPhysicalDeviceSparseImageFormatProperties2KHR(physicalDevice->phys_dev, pFormatInfo, pPropertyCount, pProperties);
+}
+
+static VkResult WINAPI wine_vkGetPipelineCacheData(VkDevice device, VkPipelineCache pipelineCache, size_t *pDataSize, void *pData)
+{
+    TRACE("%p, 0x%s, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), pDataSize, pData);
+    return device->funcs.p_vkGetPipelineCacheData(device->device, pipelineCache, pDataSize, pData);
+}
+
+static VkResult WINAPI wine_vkGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void *pData, VkDeviceSize stride, VkQueryResultFlags flags)
+{
+    TRACE("%p, 0x%s, %u, %u, 0x%s, %p, 0x%s, %#x\n", device, wine_dbgstr_longlong(queryPool), firstQuery, queryCount, wine_dbgstr_longlong(dataSize), pData, wine_dbgstr_longlong(stride), flags);
+    return device->funcs.p_vkGetQueryPoolResults(device->device, queryPool, firstQuery, queryCount, dataSize, pData, stride, flags);
+}
+
+static void WINAPI wine_vkGetRenderAreaGranularity(VkDevice device, VkRenderPass renderPass, VkExtent2D *pGranularity)
+{
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(renderPass), pGranularity);
+    device->funcs.p_vkGetRenderAreaGranularity(device->device, renderPass, pGranularity);
+}
+
+static VkResult WINAPI wine_vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+{
+    TRACE("%p, %u, %p\n", device, memoryRangeCount, pMemoryRanges);
+    return device->funcs.p_vkInvalidateMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges);
+}
+
+static VkResult WINAPI wine_vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void **ppData)
+{
+    TRACE("%p, 0x%s, 0x%s, 0x%s, %#x, %p\n", device, wine_dbgstr_longlong(memory), wine_dbgstr_longlong(offset), wine_dbgstr_longlong(size), flags, ppData);
+    return device->funcs.p_vkMapMemory(device->device, memory, offset, size, flags, ppData);
+}
+
+static VkResult WINAPI wine_vkMergePipelineCaches(VkDevice device, VkPipelineCache dstCache, uint32_t srcCacheCount, const VkPipelineCache *pSrcCaches)
+{
+    TRACE("%p, 0x%s, %u, %p\n", device, wine_dbgstr_longlong(dstCache), srcCacheCount, pSrcCaches);
+    return device->funcs.p_vkMergePipelineCaches(device->device, dstCache, srcCacheCount, pSrcCaches);
+}
+
+static VkResult WINAPI wine_vkQueueBindSparse(VkQueue queue, uint32_t bindInfoCount, const VkBindSparseInfo *pBindInfo, VkFence fence)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkResult result;
+    VkBindSparseInfo_host *pBindInfo_host;
+    TRACE("%p, %u, %p, 0x%s\n", queue, bindInfoCount, pBindInfo, wine_dbgstr_longlong(fence));
+
+    pBindInfo_host = convert_VkBindSparseInfo_array_win_to_host(pBindInfo, bindInfoCount);
+    wine_vk_queue_lock(queue);
+    result = queue->device->funcs.p_vkQueueBindSparse(queue->queue, bindInfoCount, pBindInfo_host, fence);
+    wine_vk_queue_unlock(queue);
+
+    wine_vk_arena_reset();
+    return result;
+#else
+    VkResult result;
+    TRACE("%p, %u, %p, 0x%s\n", queue, bindInfoCount, pBindInfo, wine_dbgstr_longlong(fence));
+    wine_vk_queue_lock(queue);
+    result = queue->device->funcs.p_vkQueueBindSparse(queue->queue, bindInfoCount, pBindInfo, fence);
+    wine_vk_queue_unlock(queue);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_vkResetCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferResetFlags flags)
+{
+    TRACE("%p, %#x\n", commandBuffer, flags);
+    return commandBuffer->device->funcs.p_vkResetCommandBuffer(commandBuffer->command_buffer, flags);
+}
+
+static VkResult WINAPI wine_vkResetDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, VkDescriptorPoolResetFlags flags)
+{
+    TRACE("%p, 0x%s, %#x\n", device, wine_dbgstr_longlong(descriptorPool), flags);
+    return device->funcs.p_vkResetDescriptorPool(device->device, descriptorPool, flags);
+}
+
+static VkResult WINAPI wine_vkResetEvent(VkDevice device, VkEvent event)
+{
+    TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(event));
+    return device->funcs.p_vkResetEvent(device->device, event);
+}
+
+static VkResult WINAPI wine_vkResetFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences)
+{
+    TRACE("%p, %u, %p\n", device, fenceCount, pFences);
+    return device->funcs.p_vkResetFences(device->device, fenceCount, pFences);
+}
+
+static VkResult WINAPI wine_vkSetEvent(VkDevice device, VkEvent event)
+{
+    TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(event));
+    return device->funcs.p_vkSetEvent(device->device, event);
+}
+
+static void WINAPI wine_vkSetHdrMetadataEXT(VkDevice device, uint32_t swapchainCount, const VkSwapchainKHR *pSwapchains, const VkHdrMetadataEXT *pMetadata)
+{
+    TRACE("%p, %u, %p, %p\n", device, swapchainCount, pSwapchains, pMetadata);
+    device->funcs.p_vkSetHdrMetadataEXT(device->device, swapchainCount, pSwapchains, pMetadata);
+}
+
+static void WINAPI wine_vkUnmapMemory(VkDevice device, VkDeviceMemory memory)
+{
+    TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(memory));
+    device->funcs.p_vkUnmapMemory(device->device, memory);
+}
+
+static void WINAPI wine_vkUpdateDescriptorSetWithTemplateKHR(VkDevice device, VkDescriptorSet descriptorSet, VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate, const void *pData)
+{
+    TRACE("%p, 0x%s, 0x%s, %p\n", device, wine_dbgstr_longlong(descriptorSet), wine_dbgstr_longlong(descriptorUpdateTemplate), pData);
+    device->funcs.p_vkUpdateDescriptorSetWithTemplateKHR(device->device, descriptorSet, descriptorUpdateTemplate, pData);
+}
+
+static void WINAPI wine_vkUpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet *pDescriptorCopies)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    VkWriteDescriptorSet_host *pDescriptorWrites_host;
+    VkCopyDescriptorSet_host *pDescriptorCopies_host;
+    TRACE("%p, %u, %p, %u, %p\n", device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+
+    pDescriptorWrites_host = convert_VkWriteDescriptorSet_array_win_to_host(pDescriptorWrites, descriptorWriteCount);
+    pDescriptorCopies_host = convert_VkCopyDescriptorSet_array_win_to_host(pDescriptorCopies, descriptorCopyCount);
+    device->funcs.p_vkUpdateDescriptorSets(device->device, descriptorWriteCount, pDescriptorWrites_host, descriptorCopyCount, pDescriptorCopies_host);
+
+    wine_vk_arena_reset();
+#else
+    TRACE("%p, %u, %p, %u, %p\n", device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+    device->funcs.p_vkUpdateDescriptorSets(device->device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+#endif
+}
+
+static VkResult WINAPI wine_vkWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences, VkBool32 waitAll, uint64_t timeout)
+{
+    TRACE("%p, %u, %p, %u, 0x%s\n", device, fenceCount, pFences, waitAll, wine_dbgstr_longlong(timeout));
+    return device->funcs.p_vkWaitForFences(device->device, fenceCount, pFences, waitAll, timeout);
+}
+
+static VkResult WINAPI wine_profile_vkAllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo *pAllocateInfo, VkDescriptorSet *pDescriptorSets)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p\n", device, pAllocateInfo, pDescriptorSets);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkAllocateDescriptorSets(device->device, pAllocateInfo, pDescriptorSets);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(0, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo *pBeginInfo)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkCommandBufferBeginInfo_host pBeginInfo_host;
+    TRACE("%p, %p\n", commandBuffer, pBeginInfo);
+
+    QueryPerformanceCounter(&start);
+    convert_VkCommandBufferBeginInfo_win_to_host(pBeginInfo, &pBeginInfo_host);
+    QueryPerformanceCounter(&host_start);
+    result = commandBuffer->device->funcs.p_vkBeginCommandBuffer(commandBuffer->command_buffer, &pBeginInfo_host);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_arena_reset();
+    wine_vk_profile_record(1, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p\n", commandBuffer, pBeginInfo);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = commandBuffer->device->funcs.p_vkBeginCommandBuffer(commandBuffer->command_buffer, pBeginInfo);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(1, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkBindBufferMemory(VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, 0x%s, 0x%s, 0x%s\n", device, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(memory), wine_dbgstr_longlong(memoryOffset));
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkBindBufferMemory(device->device, buffer, memory, memoryOffset);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(2, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkBindImageMemory(VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, 0x%s, 0x%s, 0x%s\n", device, wine_dbgstr_longlong(image), wine_dbgstr_longlong(memory), wine_dbgstr_longlong(memoryOffset));
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkBindImageMemory(device->device, image, memory, memoryOffset);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(3, &start, &host_start, &host_end);
+    return result;
+}
+
+static void WINAPI wine_profile_vkCmdBeginQuery(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t query, VkQueryControlFlags flags)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %u, %#x\n", commandBuffer, wine_dbgstr_longlong(queryPool), query, flags);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdBeginQuery(commandBuffer->command_buffer, queryPool, query, flags);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(4, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo *pRenderPassBegin, VkSubpassContents contents)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %p, %d\n", commandBuffer, pRenderPassBegin, contents);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdBeginRenderPass(commandBuffer->command_buffer, pRenderPassBegin, contents);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(5, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t *pDynamicOffsets)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %d, 0x%s, %u, %u, %p, %u, %p\n", commandBuffer, pipelineBindPoint, wine_dbgstr_longlong(layout), firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdBindDescriptorSets(commandBuffer->command_buffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(6, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, %d\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), indexType);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdBindIndexBuffer(commandBuffer->command_buffer, buffer, offset, indexType);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(7, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %d, 0x%s\n", commandBuffer, pipelineBindPoint, wine_dbgstr_longlong(pipeline));
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdBindPipeline(commandBuffer->command_buffer, pipelineBindPoint, pipeline);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(8, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *pBuffers, const VkDeviceSize *pOffsets)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %p, %p\n", commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdBindVertexBuffers(commandBuffer->command_buffer, firstBinding, bindingCount, pBuffers, pOffsets);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(9, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageBlit *pRegions, VkFilter filter)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %d, 0x%s, %d, %u, %p, %d\n", commandBuffer, wine_dbgstr_longlong(srcImage), srcImageLayout, wine_dbgstr_longlong(dstImage), dstImageLayout, regionCount, pRegions, filter);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdBlitImage(commandBuffer->command_buffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions, filter);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(10, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdClearAttachments(VkCommandBuffer commandBuffer, uint32_t attachmentCount, const VkClearAttachment *pAttachments, uint32_t rectCount, const VkClearRect *pRects)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %p, %u, %p\n", commandBuffer, attachmentCount, pAttachments, rectCount, pRects);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdClearAttachments(commandBuffer->command_buffer, attachmentCount, pAttachments, rectCount, pRects);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(11, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdClearColorImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout, const VkClearColorValue *pColor, uint32_t rangeCount, const VkImageSubresourceRange *pRanges)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %d, %p, %u, %p\n", commandBuffer, wine_dbgstr_longlong(image), imageLayout, pColor, rangeCount, pRanges);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdClearColorImage(commandBuffer->command_buffer, image, imageLayout, pColor, rangeCount, pRanges);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(12, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdClearDepthStencilImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout imageLayout, const VkClearDepthStencilValue *pDepthStencil, uint32_t rangeCount, const VkImageSubresourceRange *pRanges)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %d, %p, %u, %p\n", commandBuffer, wine_dbgstr_longlong(image), imageLayout, pDepthStencil, rangeCount, pRanges);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdClearDepthStencilImage(commandBuffer->command_buffer, image, imageLayout, pDepthStencil, rangeCount, pRanges);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(13, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy *pRegions)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcBuffer), wine_dbgstr_longlong(dstBuffer), regionCount, pRegions);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdCopyBuffer(commandBuffer->command_buffer, srcBuffer, dstBuffer, regionCount, pRegions);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(14, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy *pRegions)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, %d, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcBuffer), wine_dbgstr_longlong(dstImage), dstImageLayout, regionCount, pRegions);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdCopyBufferToImage(commandBuffer->command_buffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(15, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdCopyImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageCopy *pRegions)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %d, 0x%s, %d, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcImage), srcImageLayout, wine_dbgstr_longlong(dstImage), dstImageLayout, regionCount, pRegions);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdCopyImage(commandBuffer->command_buffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(16, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferImageCopy *pRegions)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %d, 0x%s, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcImage), srcImageLayout, wine_dbgstr_longlong(dstBuffer), regionCount, pRegions);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdCopyImageToBuffer(commandBuffer->command_buffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(17, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdCopyQueryPoolResults(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize stride, VkQueryResultFlags flags)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %u, %u, 0x%s, 0x%s, 0x%s, %#x\n", commandBuffer, wine_dbgstr_longlong(queryPool), firstQuery, queryCount, wine_dbgstr_longlong(dstBuffer), wine_dbgstr_longlong(dstOffset), wine_dbgstr_longlong(stride), flags);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdCopyQueryPoolResults(commandBuffer->command_buffer, queryPool, firstQuery, queryCount, dstBuffer, dstOffset, stride, flags);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(18, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %u\n", commandBuffer, groupCountX, groupCountY, groupCountZ);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdDispatch(commandBuffer->command_buffer, groupCountX, groupCountY, groupCountZ);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(19, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset));
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdDispatchIndirect(commandBuffer->command_buffer, buffer, offset);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(20, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %u, %u\n", commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdDraw(commandBuffer->command_buffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(21, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %u, %d, %u\n", commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdDrawIndexed(commandBuffer->command_buffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(22, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, %u, %u\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), drawCount, stride);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdDrawIndexedIndirect(commandBuffer->command_buffer, buffer, offset, drawCount, stride);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(23, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDrawIndexedIndirectCountAMD(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, 0x%s, 0x%s, %u, %u\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), wine_dbgstr_longlong(countBuffer), wine_dbgstr_longlong(countBufferOffset), maxDrawCount, stride);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdDrawIndexedIndirectCountAMD(commandBuffer->command_buffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(24, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, %u, %u\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), drawCount, stride);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdDrawIndirect(commandBuffer->command_buffer, buffer, offset, drawCount, stride);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(25, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdDrawIndirectCountAMD(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, 0x%s, 0x%s, %u, %u\n", commandBuffer, wine_dbgstr_longlong(buffer), wine_dbgstr_longlong(offset), wine_dbgstr_longlong(countBuffer), wine_dbgstr_longlong(countBufferOffset), maxDrawCount, stride);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdDrawIndirectCountAMD(commandBuffer->command_buffer, buffer, offset, countBuffer, countBufferOffset, maxDrawCount, stride);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(26, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdEndQuery(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t query)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %u\n", commandBuffer, wine_dbgstr_longlong(queryPool), query);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdEndQuery(commandBuffer->command_buffer, queryPool, query);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(27, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p\n", commandBuffer);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdEndRenderPass(commandBuffer->command_buffer);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(28, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize size, uint32_t data)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, 0x%s, %u\n", commandBuffer, wine_dbgstr_longlong(dstBuffer), wine_dbgstr_longlong(dstOffset), wine_dbgstr_longlong(size), data);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdFillBuffer(commandBuffer->command_buffer, dstBuffer, dstOffset, size, data);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(29, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %d\n", commandBuffer, contents);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdNextSubpass(commandBuffer->command_buffer, contents);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(30, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkImageMemoryBarrier_host *pImageMemoryBarriers_host;
+    TRACE("%p, %#x, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+
+    QueryPerformanceCounter(&start);
+    pImageMemoryBarriers_host = convert_VkImageMemoryBarrier_array_win_to_host(pImageMemoryBarriers, imageMemoryBarrierCount);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdPipelineBarrier(commandBuffer->command_buffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers_host);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_arena_reset();
+    wine_vk_profile_record(31, &start, &host_start, &host_end);
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %#x, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdPipelineBarrier(commandBuffer->command_buffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(31, &start, &host_start, &host_end);
+#endif
+}
+
+static void WINAPI wine_profile_vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void *pValues)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %#x, %u, %u, %p\n", commandBuffer, wine_dbgstr_longlong(layout), stageFlags, offset, size, pValues);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdPushConstants(commandBuffer->command_buffer, layout, stageFlags, offset, size, pValues);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(32, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdPushDescriptorSetKHR(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t set, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkWriteDescriptorSet_host *pDescriptorWrites_host;
+    TRACE("%p, %d, 0x%s, %u, %u, %p\n", commandBuffer, pipelineBindPoint, wine_dbgstr_longlong(layout), set, descriptorWriteCount, pDescriptorWrites);
+
+    QueryPerformanceCounter(&start);
+    pDescriptorWrites_host = convert_VkWriteDescriptorSet_array_win_to_host(pDescriptorWrites, descriptorWriteCount);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdPushDescriptorSetKHR(commandBuffer->command_buffer, pipelineBindPoint, layout, set, descriptorWriteCount, pDescriptorWrites_host);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_arena_reset();
+    wine_vk_profile_record(33, &start, &host_start, &host_end);
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %d, 0x%s, %u, %u, %p\n", commandBuffer, pipelineBindPoint, wine_dbgstr_longlong(layout), set, descriptorWriteCount, pDescriptorWrites);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdPushDescriptorSetKHR(commandBuffer->command_buffer, pipelineBindPoint, layout, set, descriptorWriteCount, pDescriptorWrites);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(33, &start, &host_start, &host_end);
+#endif
+}
+
+static void WINAPI wine_profile_vkCmdPushDescriptorSetWithTemplateKHR(VkCommandBuffer commandBuffer, VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate, VkPipelineLayout layout, uint32_t set, const void *pData)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, %u, %p\n", commandBuffer, wine_dbgstr_longlong(descriptorUpdateTemplate), wine_dbgstr_longlong(layout), set, pData);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdPushDescriptorSetWithTemplateKHR(commandBuffer->command_buffer, descriptorUpdateTemplate, layout, set, pData);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(34, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdResetEvent(VkCommandBuffer commandBuffer, VkEvent event, VkPipelineStageFlags stageMask)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %#x\n", commandBuffer, wine_dbgstr_longlong(event), stageMask);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdResetEvent(commandBuffer->command_buffer, event, stageMask);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(35, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %u, %u\n", commandBuffer, wine_dbgstr_longlong(queryPool), firstQuery, queryCount);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdResetQueryPool(commandBuffer->command_buffer, queryPool, firstQuery, queryCount);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(36, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdResolveImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageResolve *pRegions)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %d, 0x%s, %d, %u, %p\n", commandBuffer, wine_dbgstr_longlong(srcImage), srcImageLayout, wine_dbgstr_longlong(dstImage), dstImageLayout, regionCount, pRegions);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdResolveImage(commandBuffer->command_buffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(37, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetBlendConstants(VkCommandBuffer commandBuffer, const float blendConstants[4])
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %p\n", commandBuffer, blendConstants);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetBlendConstants(commandBuffer->command_buffer, blendConstants);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(38, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetDepthBias(VkCommandBuffer commandBuffer, float depthBiasConstantFactor, float depthBiasClamp, float depthBiasSlopeFactor)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %f, %f, %f\n", commandBuffer, depthBiasConstantFactor, depthBiasClamp, depthBiasSlopeFactor);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetDepthBias(commandBuffer->command_buffer, depthBiasConstantFactor, depthBiasClamp, depthBiasSlopeFactor);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(39, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetDepthBounds(VkCommandBuffer commandBuffer, float minDepthBounds, float maxDepthBounds)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %f, %f\n", commandBuffer, minDepthBounds, maxDepthBounds);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetDepthBounds(commandBuffer->command_buffer, minDepthBounds, maxDepthBounds);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(40, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetDiscardRectangleEXT(VkCommandBuffer commandBuffer, uint32_t firstDiscardRectangle, uint32_t discardRectangleCount, const VkRect2D *pDiscardRectangles)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %p\n", commandBuffer, firstDiscardRectangle, discardRectangleCount, pDiscardRectangles);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetDiscardRectangleEXT(commandBuffer->command_buffer, firstDiscardRectangle, discardRectangleCount, pDiscardRectangles);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(41, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetEvent(VkCommandBuffer commandBuffer, VkEvent event, VkPipelineStageFlags stageMask)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %#x\n", commandBuffer, wine_dbgstr_longlong(event), stageMask);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetEvent(commandBuffer->command_buffer, event, stageMask);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(42, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetLineWidth(VkCommandBuffer commandBuffer, float lineWidth)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %f\n", commandBuffer, lineWidth);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetLineWidth(commandBuffer->command_buffer, lineWidth);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(43, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t scissorCount, const VkRect2D *pScissors)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %p\n", commandBuffer, firstScissor, scissorCount, pScissors);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdSetScissor(commandBuffer->command_buffer, firstScissor, scissorCount, pScissors);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(44, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetStencilCompareMask(VkCommandBuffer commandBuffer, VkStencilFaceFlags faceMask, uint32_t compareMask)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %#x, %u\n", commandBuffer, faceMask, compareMask);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetStencilCompareMask(commandBuffer->command_buffer, faceMask, compareMask);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(45, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetStencilReference(VkCommandBuffer commandBuffer, VkStencilFaceFlags faceMask, uint32_t reference)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %#x, %u\n", commandBuffer, faceMask, reference);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetStencilReference(commandBuffer->command_buffer, faceMask, reference);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(46, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetStencilWriteMask(VkCommandBuffer commandBuffer, VkStencilFaceFlags faceMask, uint32_t writeMask)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %#x, %u\n", commandBuffer, faceMask, writeMask);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetStencilWriteMask(commandBuffer->command_buffer, faceMask, writeMask);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(47, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewport *pViewports)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %p\n", commandBuffer, firstViewport, viewportCount, pViewports);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->funcs.p_vkCmdSetViewport(commandBuffer->command_buffer, firstViewport, viewportCount, pViewports);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(48, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdSetViewportWScalingNV(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewportWScalingNV *pViewportWScalings)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %u, %p\n", commandBuffer, firstViewport, viewportCount, pViewportWScalings);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdSetViewportWScalingNV(commandBuffer->command_buffer, firstViewport, viewportCount, pViewportWScalings);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(49, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer, VkDeviceSize dstOffset, VkDeviceSize dataSize, const void *pData)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, 0x%s, 0x%s, %p\n", commandBuffer, wine_dbgstr_longlong(dstBuffer), wine_dbgstr_longlong(dstOffset), wine_dbgstr_longlong(dataSize), pData);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdUpdateBuffer(commandBuffer->command_buffer, dstBuffer, dstOffset, dataSize, pData);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(50, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkCmdWaitEvents(VkCommandBuffer commandBuffer, uint32_t eventCount, const VkEvent *pEvents, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkImageMemoryBarrier_host *pImageMemoryBarriers_host;
+    TRACE("%p, %u, %p, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+
+    QueryPerformanceCounter(&start);
+    pImageMemoryBarriers_host = convert_VkImageMemoryBarrier_array_win_to_host(pImageMemoryBarriers, imageMemoryBarrierCount);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdWaitEvents(commandBuffer->command_buffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers_host);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_arena_reset();
+    wine_vk_profile_record(51, &start, &host_start, &host_end);
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %u, %p, %#x, %#x, %u, %p, %u, %p, %u, %p\n", commandBuffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdWaitEvents(commandBuffer->command_buffer, eventCount, pEvents, srcStageMask, dstStageMask, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, imageMemoryBarrierCount, pImageMemoryBarriers);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(51, &start, &host_start, &host_end);
+#endif
+}
+
+static void WINAPI wine_profile_vkCmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, %d, 0x%s, %u\n", commandBuffer, pipelineStage, wine_dbgstr_longlong(queryPool), query);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    commandBuffer->device->funcs.p_vkCmdWriteTimestamp(commandBuffer->command_buffer, pipelineStage, queryPool, query);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(52, &start, &host_start, &host_end);
+}
+
+static VkResult WINAPI wine_profile_vkCreateBuffer(VkDevice device, const VkBufferCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkBuffer *pBuffer)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkBufferCreateInfo_host pCreateInfo_host;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pBuffer);
+
+    QueryPerformanceCounter(&start);
+    convert_VkBufferCreateInfo_win_to_host(pCreateInfo, &pCreateInfo_host);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateBuffer(device->device, &pCreateInfo_host, NULL, pBuffer);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(53, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pBuffer);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateBuffer(device->device, pCreateInfo, NULL, pBuffer);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(53, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkCreateBufferView(VkDevice device, const VkBufferViewCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkBufferView *pView)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkBufferViewCreateInfo_host pCreateInfo_host;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pView);
+
+    QueryPerformanceCounter(&start);
+    convert_VkBufferViewCreateInfo_win_to_host(pCreateInfo, &pCreateInfo_host);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateBufferView(device->device, &pCreateInfo_host, NULL, pView);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(54, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pView);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateBufferView(device->device, pCreateInfo, NULL, pView);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(54, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkComputePipelineCreateInfo_host *pCreateInfos_host;
+    TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
+
+    QueryPerformanceCounter(&start);
+    pCreateInfos_host = convert_VkComputePipelineCreateInfo_array_win_to_host(pCreateInfos, createInfoCount);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateComputePipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos_host, NULL, pPipelines);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_arena_reset();
+    wine_vk_profile_record(55, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateComputePipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos, NULL, pPipelines);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(55, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkCreateDescriptorPool(VkDevice device, const VkDescriptorPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDescriptorPool *pDescriptorPool)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pDescriptorPool);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateDescriptorPool(device->device, pCreateInfo, NULL, pDescriptorPool);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(56, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateDescriptorSetLayout(VkDevice device, const VkDescriptorSetLayoutCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDescriptorSetLayout *pSetLayout)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pSetLayout);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateDescriptorSetLayout(device->device, pCreateInfo, NULL, pSetLayout);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(57, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateDescriptorUpdateTemplateKHR(VkDevice device, const VkDescriptorUpdateTemplateCreateInfoKHR *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDescriptorUpdateTemplateKHR *pDescriptorUpdateTemplate)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkDescriptorUpdateTemplateCreateInfoKHR_host pCreateInfo_host;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pDescriptorUpdateTemplate);
+
+    QueryPerformanceCounter(&start);
+    convert_VkDescriptorUpdateTemplateCreateInfoKHR_win_to_host(pCreateInfo, &pCreateInfo_host);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateDescriptorUpdateTemplateKHR(device->device, &pCreateInfo_host, NULL, pDescriptorUpdateTemplate);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(58, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pDescriptorUpdateTemplate);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateDescriptorUpdateTemplateKHR(device->device, pCreateInfo, NULL, pDescriptorUpdateTemplate);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(58, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkCreateEvent(VkDevice device, const VkEventCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkEvent *pEvent)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pEvent);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateEvent(device->device, pCreateInfo, NULL, pEvent);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(59, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateFence(VkDevice device, const VkFenceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkFence *pFence)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pFence);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateFence(device->device, pCreateInfo, NULL, pFence);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(60, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateFramebuffer(VkDevice device, const VkFramebufferCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkFramebuffer *pFramebuffer)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkFramebufferCreateInfo_host pCreateInfo_host;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pFramebuffer);
+
+    QueryPerformanceCounter(&start);
+    convert_VkFramebufferCreateInfo_win_to_host(pCreateInfo, &pCreateInfo_host);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateFramebuffer(device->device, &pCreateInfo_host, NULL, pFramebuffer);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(61, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pFramebuffer);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateFramebuffer(device->device, pCreateInfo, NULL, pFramebuffer);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(61, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkGraphicsPipelineCreateInfo_host *pCreateInfos_host;
+    TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
+
+    QueryPerformanceCounter(&start);
+    pCreateInfos_host = convert_VkGraphicsPipelineCreateInfo_array_win_to_host(pCreateInfos, createInfoCount);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateGraphicsPipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos_host, NULL, pPipelines);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_arena_reset();
+    wine_vk_profile_record(62, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, 0x%s, %u, %p, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), createInfoCount, pCreateInfos, pAllocator, pPipelines);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateGraphicsPipelines(device->device, wine_vk_device_pipeline_cache(device, pipelineCache), createInfoCount, pCreateInfos, NULL, pPipelines);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(62, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkCreateImage(VkDevice device, const VkImageCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkImage *pImage)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pImage);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateImage(device->device, pCreateInfo, NULL, pImage);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(63, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateImageView(VkDevice device, const VkImageViewCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkImageView *pView)
+{
+#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    VkImageViewCreateInfo_host pCreateInfo_host;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pView);
+
+    QueryPerformanceCounter(&start);
+    convert_VkImageViewCreateInfo_win_to_host(pCreateInfo, &pCreateInfo_host);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateImageView(device->device, &pCreateInfo_host, NULL, pView);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(64, &start, &host_start, &host_end);
+    return result;
+#else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pView);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateImageView(device->device, pCreateInfo, NULL, pView);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(64, &start, &host_start, &host_end);
+    return result;
+#endif
+}
+
+static VkResult WINAPI wine_profile_vkCreatePipelineCache(VkDevice device, const VkPipelineCacheCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkPipelineCache *pPipelineCache)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pPipelineCache);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreatePipelineCache(device->device, pCreateInfo, NULL, pPipelineCache);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(65, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreatePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkPipelineLayout *pPipelineLayout)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pPipelineLayout);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreatePipelineLayout(device->device, pCreateInfo, NULL, pPipelineLayout);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(66, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateQueryPool(VkDevice device, const VkQueryPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkQueryPool *pQueryPool)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pQueryPool);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateQueryPool(device->device, pCreateInfo, NULL, pQueryPool);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(67, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateRenderPass(VkDevice device, const VkRenderPassCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkRenderPass *pRenderPass)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pRenderPass);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateRenderPass(device->device, pCreateInfo, NULL, pRenderPass);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(68, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateSampler(VkDevice device, const VkSamplerCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSampler *pSampler)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pSampler);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateSampler(device->device, pCreateInfo, NULL, pSampler);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(69, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateSemaphore(VkDevice device, const VkSemaphoreCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSemaphore *pSemaphore)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pSemaphore);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateSemaphore(device->device, pCreateInfo, NULL, pSemaphore);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(70, &start, &host_start, &host_end);
+    return result;
+}
+
+static VkResult WINAPI wine_profile_vkCreateShaderModule(VkDevice device, const VkShaderModuleCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkShaderModule *pShaderModule)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
+    TRACE("%p, %p, %p, %p\n", device, pCreateInfo, pAllocator, pShaderModule);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkCreateShaderModule(device->device, pCreateInfo, NULL, pShaderModule);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(71, &start, &host_start, &host_end);
+    return result;
+}
+
+static void WINAPI wine_profile_vkDestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(buffer), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyBuffer(device->device, buffer, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(72, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyBufferView(VkDevice device, VkBufferView bufferView, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(bufferView), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyBufferView(device->device, bufferView, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(73, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(descriptorPool), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyDescriptorPool(device->device, descriptorPool, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(74, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout descriptorSetLayout, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(descriptorSetLayout), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyDescriptorSetLayout(device->device, descriptorSetLayout, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(75, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyDescriptorUpdateTemplateKHR(VkDevice device, VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(descriptorUpdateTemplate), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyDescriptorUpdateTemplateKHR(device->device, descriptorUpdateTemplate, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(76, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyEvent(VkDevice device, VkEvent event, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(event), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyEvent(device->device, event, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(77, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyFence(VkDevice device, VkFence fence, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(fence), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyFence(device->device, fence, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(78, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyFramebuffer(VkDevice device, VkFramebuffer framebuffer, const VkAllocationCallbacks *pAllocator)
+{
+    LARGE_INTEGER start, host_start, host_end;
+    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(framebuffer), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    device->funcs.p_vkDestroyFramebuffer(device->device, framebuffer, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(79, &start, &host_start, &host_end);
+}
+
+static void WINAPI wine_profile_vkDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(image), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyImage(device->device, image, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(80, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroyImageView(VkDevice device, VkImageView imageView, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroyImageView(VkDevice device, VkImageView imageView, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(imageView), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyImageView(device->device, imageView, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(81, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(pipeline), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyPipeline(device->device, pipeline, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(82, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(pipelineCache), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyPipelineCache(device->device, pipelineCache, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(83, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(pipelineLayout), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyPipelineLayout(device->device, pipelineLayout, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(84, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroyQueryPool(VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroyQueryPool(VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(queryPool), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyQueryPool(device->device, queryPool, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(85, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroyRenderPass(VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroyRenderPass(VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(renderPass), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyRenderPass(device->device, renderPass, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(86, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroySampler(VkDevice device, VkSampler sampler, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroySampler(VkDevice device, VkSampler sampler, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(sampler), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroySampler(device->device, sampler, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(87, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(semaphore), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroySemaphore(device->device, semaphore, NULL);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(88, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkDestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks *pAllocator)
+static void WINAPI wine_profile_vkDestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks *pAllocator)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(shaderModule), pAllocator);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkDestroyShaderModule(device->device, shaderModule, NULL);
-}
+    QueryPerformanceCounter(&host_end);
 
-static VkResult WINAPI wine_vkDeviceWaitIdle(VkDevice device)
-{
-    TRACE("%p\n", device);
-    return device->funcs.p_vkDeviceWaitIdle(device->device);
+    wine_vk_profile_record(89, &start, &host_start, &host_end);
 }
 
-static VkResult WINAPI wine_vkEndCommandBuffer(VkCommandBuffer commandBuffer)
+static VkResult WINAPI wine_profile_vkEndCommandBuffer(VkCommandBuffer commandBuffer)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p\n", commandBuffer);
-    return commandBuffer->device->funcs.p_vkEndCommandBuffer(commandBuffer->command_buffer);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = commandBuffer->device->funcs.p_vkEndCommandBuffer(commandBuffer->command_buffer);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(90, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkEnumerateDeviceLayerProperties(VkPhysicalDevice physicalDevice, uint32_t *pPropertyCount, VkLayerProperties *pProperties)
+static VkResult WINAPI wine_profile_vkEnumerateDeviceLayerProperties(VkPhysicalDevice physicalDevice, uint32_t *pPropertyCount, VkLayerProperties *pProperties)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, %p, %p\n", physicalDevice, pPropertyCount, pProperties);
-    return physicalDevice->instance->funcs.p_vkEnumerateDeviceLayerProperties(physicalDevice->phys_dev, pPropertyCount, pProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = physicalDevice->instance->funcs.p_vkEnumerateDeviceLayerProperties(physicalDevice->phys_dev, pPropertyCount, pProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(91, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkFlushMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+static VkResult WINAPI wine_profile_vkFlushMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
 {
-#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkResult result;
-    VkMappedMemoryRange_host *pMemoryRanges_host;
     TRACE("%p, %u, %p\n", device, memoryRangeCount, pMemoryRanges);
 
-    pMemoryRanges_host = convert_VkMappedMemoryRange_array_win_to_host(pMemoryRanges, memoryRangeCount);
-    result = device->funcs.p_vkFlushMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges_host);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkFlushMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges);
+    QueryPerformanceCounter(&host_end);
 
-    free_VkMappedMemoryRange_array(pMemoryRanges_host, memoryRangeCount);
+    wine_vk_profile_record(92, &start, &host_start, &host_end);
     return result;
-#else
-    TRACE("%p, %u, %p\n", device, memoryRangeCount, pMemoryRanges);
-    return device->funcs.p_vkFlushMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges);
-#endif
 }
 
-static VkResult WINAPI wine_vkFreeDescriptorSets(VkDevice device, VkDescriptorPool descriptorPool, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets)
+static VkResult WINAPI wine_profile_vkFreeDescriptorSets(VkDevice device, VkDescriptorPool descriptorPool, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s, %u, %p\n", device, wine_dbgstr_longlong(descriptorPool), descriptorSetCount, pDescriptorSets);
-    return device->funcs.p_vkFreeDescriptorSets(device->device, descriptorPool, descriptorSetCount, pDescriptorSets);
-}
 
-static void WINAPI wine_vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks *pAllocator)
-{
-    TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(memory), pAllocator);
-    device->funcs.p_vkFreeMemory(device->device, memory, NULL);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkFreeDescriptorSets(device->device, descriptorPool, descriptorSetCount, pDescriptorSets);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(93, &start, &host_start, &host_end);
+    return result;
 }
 
-static void WINAPI wine_vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements *pMemoryRequirements)
+static void WINAPI wine_profile_vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements *pMemoryRequirements)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkMemoryRequirements_host pMemoryRequirements_host;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(buffer), pMemoryRequirements);
 
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetBufferMemoryRequirements(device->device, buffer, &pMemoryRequirements_host);
+    QueryPerformanceCounter(&host_end);
 
     convert_VkMemoryRequirements_host_to_win(&pMemoryRequirements_host, pMemoryRequirements);
+    wine_vk_profile_record(94, &start, &host_start, &host_end);
 #else
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(buffer), pMemoryRequirements);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetBufferMemoryRequirements(device->device, buffer, pMemoryRequirements);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(94, &start, &host_start, &host_end);
 #endif
 }
 
-static void WINAPI wine_vkGetDeviceMemoryCommitment(VkDevice device, VkDeviceMemory memory, VkDeviceSize *pCommittedMemoryInBytes)
+static void WINAPI wine_profile_vkGetDeviceMemoryCommitment(VkDevice device, VkDeviceMemory memory, VkDeviceSize *pCommittedMemoryInBytes)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(memory), pCommittedMemoryInBytes);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetDeviceMemoryCommitment(device->device, memory, pCommittedMemoryInBytes);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(95, &start, &host_start, &host_end);
 }
 
-static VkResult WINAPI wine_vkGetEventStatus(VkDevice device, VkEvent event)
+static VkResult WINAPI wine_profile_vkGetEventStatus(VkDevice device, VkEvent event)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(event));
-    return device->funcs.p_vkGetEventStatus(device->device, event);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkGetEventStatus(device->device, event);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(96, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkGetFenceStatus(VkDevice device, VkFence fence)
+static VkResult WINAPI wine_profile_vkGetFenceStatus(VkDevice device, VkFence fence)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(fence));
-    return device->funcs.p_vkGetFenceStatus(device->device, fence);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkGetFenceStatus(device->device, fence);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(97, &start, &host_start, &host_end);
+    return result;
 }
 
-static void WINAPI wine_vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements *pMemoryRequirements)
+static void WINAPI wine_profile_vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements *pMemoryRequirements)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkMemoryRequirements_host pMemoryRequirements_host;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(image), pMemoryRequirements);
 
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetImageMemoryRequirements(device->device, image, &pMemoryRequirements_host);
+    QueryPerformanceCounter(&host_end);
 
     convert_VkMemoryRequirements_host_to_win(&pMemoryRequirements_host, pMemoryRequirements);
+    wine_vk_profile_record(98, &start, &host_start, &host_end);
 #else
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(image), pMemoryRequirements);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetImageMemoryRequirements(device->device, image, pMemoryRequirements);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(98, &start, &host_start, &host_end);
 #endif
 }
 
-static void WINAPI wine_vkGetImageSparseMemoryRequirements(VkDevice device, VkImage image, uint32_t *pSparseMemoryRequirementCount, VkSparseImageMemoryRequirements *pSparseMemoryRequirements)
+static void WINAPI wine_profile_vkGetImageSparseMemoryRequirements(VkDevice device, VkImage image, uint32_t *pSparseMemoryRequirementCount, VkSparseImageMemoryRequirements *pSparseMemoryRequirements)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p, %p\n", device, wine_dbgstr_longlong(image), pSparseMemoryRequirementCount, pSparseMemoryRequirements);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetImageSparseMemoryRequirements(device->device, image, pSparseMemoryRequirementCount, pSparseMemoryRequirements);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(99, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetImageSubresourceLayout(VkDevice device, VkImage image, const VkImageSubresource *pSubresource, VkSubresourceLayout *pLayout)
+static void WINAPI wine_profile_vkGetImageSubresourceLayout(VkDevice device, VkImage image, const VkImageSubresource *pSubresource, VkSubresourceLayout *pLayout)
 {
-#if defined(USE_STRUCT_CONVERSION)
-    VkSubresourceLayout_host pLayout_host;
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p, %p\n", device, wine_dbgstr_longlong(image), pSubresource, pLayout);
 
-    device->funcs.p_vkGetImageSubresourceLayout(device->device, image, pSubresource, &pLayout_host);
-
-    convert_VkSubresourceLayout_host_to_win(&pLayout_host, pLayout);
-#else
-    TRACE("%p, 0x%s, %p, %p\n", device, wine_dbgstr_longlong(image), pSubresource, pLayout);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetImageSubresourceLayout(device->device, image, pSubresource, pLayout);
-#endif
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(100, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceFeatures(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures *pFeatures)
+static void WINAPI wine_profile_vkGetPhysicalDeviceFeatures(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures *pFeatures)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p\n", physicalDevice, pFeatures);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFeatures(physicalDevice->phys_dev, pFeatures);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(101, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceFeatures2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2KHR *pFeatures)
+static void WINAPI wine_profile_vkGetPhysicalDeviceFeatures2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2KHR *pFeatures)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p\n", physicalDevice, pFeatures);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFeatures2KHR(physicalDevice->phys_dev, pFeatures);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(102, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties *pFormatProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties *pFormatProperties)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %d, %p\n", physicalDevice, format, pFormatProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFormatProperties(physicalDevice->phys_dev, format, pFormatProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(103, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceFormatProperties2KHR(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties2KHR *pFormatProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceFormatProperties2KHR(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties2KHR *pFormatProperties)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %d, %p\n", physicalDevice, format, pFormatProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceFormatProperties2KHR(physicalDevice->phys_dev, format, pFormatProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(104, &start, &host_start, &host_end);
 }
 
-static VkResult WINAPI wine_vkGetPhysicalDeviceImageFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkImageType type, VkImageTiling tiling, VkImageUsageFlags usage, VkImageCreateFlags flags, VkImageFormatProperties *pImageFormatProperties)
+static VkResult WINAPI wine_profile_vkGetPhysicalDeviceImageFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkImageType type, VkImageTiling tiling, VkImageUsageFlags usage, VkImageCreateFlags flags, VkImageFormatProperties *pImageFormatProperties)
 {
-#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkResult result;
-    VkImageFormatProperties_host pImageFormatProperties_host;
     TRACE("%p, %d, %d, %d, %#x, %#x, %p\n", physicalDevice, format, type, tiling, usage, flags, pImageFormatProperties);
 
-    result = physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties(physicalDevice->phys_dev, format, type, tiling, usage, flags, &pImageFormatProperties_host);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties(physicalDevice->phys_dev, format, type, tiling, usage, flags, pImageFormatProperties);
+    QueryPerformanceCounter(&host_end);
 
-    convert_VkImageFormatProperties_host_to_win(&pImageFormatProperties_host, pImageFormatProperties);
+    wine_vk_profile_record(105, &start, &host_start, &host_end);
     return result;
-#else
-    TRACE("%p, %d, %d, %d, %#x, %#x, %p\n", physicalDevice, format, type, tiling, usage, flags, pImageFormatProperties);
-    return physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties(physicalDevice->phys_dev, format, type, tiling, usage, flags, pImageFormatProperties);
-#endif
 }
 
-static VkResult WINAPI wine_vkGetPhysicalDeviceImageFormatProperties2KHR(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceImageFormatInfo2KHR *pImageFormatInfo, VkImageFormatProperties2KHR *pImageFormatProperties)
+static VkResult WINAPI wine_profile_vkGetPhysicalDeviceImageFormatProperties2KHR(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceImageFormatInfo2KHR *pImageFormatInfo, VkImageFormatProperties2KHR *pImageFormatProperties)
 {
-#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkResult result;
-    VkImageFormatProperties2KHR_host pImageFormatProperties_host;
     TRACE("%p, %p, %p\n", physicalDevice, pImageFormatInfo, pImageFormatProperties);
 
-    convert_VkImageFormatProperties2KHR_win_to_host(pImageFormatProperties, &pImageFormatProperties_host);
-    result = physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties2KHR(physicalDevice->phys_dev, pImageFormatInfo, &pImageFormatProperties_host);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties2KHR(physicalDevice->phys_dev, pImageFormatInfo, pImageFormatProperties);
+    QueryPerformanceCounter(&host_end);
 
-    convert_VkImageFormatProperties2KHR_host_to_win(&pImageFormatProperties_host, pImageFormatProperties);
+    wine_vk_profile_record(106, &start, &host_start, &host_end);
     return result;
-#else
-    TRACE("%p, %p, %p\n", physicalDevice, pImageFormatInfo, pImageFormatProperties);
-    return physicalDevice->instance->funcs.p_vkGetPhysicalDeviceImageFormatProperties2KHR(physicalDevice->phys_dev, pImageFormatInfo, pImageFormatProperties);
-#endif
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties *pMemoryProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties *pMemoryProperties)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkPhysicalDeviceMemoryProperties_host pMemoryProperties_host;
     TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
 
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties(physicalDevice->phys_dev, &pMemoryProperties_host);
+    QueryPerformanceCounter(&host_end);
 
     convert_VkPhysicalDeviceMemoryProperties_host_to_win(&pMemoryProperties_host, pMemoryProperties);
+    wine_vk_profile_record(107, &start, &host_start, &host_end);
 #else
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties(physicalDevice->phys_dev, pMemoryProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(107, &start, &host_start, &host_end);
 #endif
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceMemoryProperties2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2KHR *pMemoryProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceMemoryProperties2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2KHR *pMemoryProperties)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkPhysicalDeviceMemoryProperties2KHR_host pMemoryProperties_host;
     TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
 
+    QueryPerformanceCounter(&start);
     convert_VkPhysicalDeviceMemoryProperties2KHR_win_to_host(pMemoryProperties, &pMemoryProperties_host);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties2KHR(physicalDevice->phys_dev, &pMemoryProperties_host);
+    QueryPerformanceCounter(&host_end);
 
     convert_VkPhysicalDeviceMemoryProperties2KHR_host_to_win(&pMemoryProperties_host, pMemoryProperties);
+    wine_vk_profile_record(108, &start, &host_start, &host_end);
 #else
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p\n", physicalDevice, pMemoryProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceMemoryProperties2KHR(physicalDevice->phys_dev, pMemoryProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(108, &start, &host_start, &host_end);
 #endif
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkPhysicalDeviceProperties_host pProperties_host;
     TRACE("%p, %p\n", physicalDevice, pProperties);
 
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties(physicalDevice->phys_dev, &pProperties_host);
+    QueryPerformanceCounter(&host_end);
 
     convert_VkPhysicalDeviceProperties_host_to_win(&pProperties_host, pProperties);
+    wine_vk_profile_record(109, &start, &host_start, &host_end);
 #else
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p\n", physicalDevice, pProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties(physicalDevice->phys_dev, pProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(109, &start, &host_start, &host_end);
 #endif
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceProperties2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2KHR *pProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceProperties2KHR(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2KHR *pProperties)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkPhysicalDeviceProperties2KHR_host pProperties_host;
     TRACE("%p, %p\n", physicalDevice, pProperties);
 
+    QueryPerformanceCounter(&start);
     convert_VkPhysicalDeviceProperties2KHR_win_to_host(pProperties, &pProperties_host);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties2KHR(physicalDevice->phys_dev, &pProperties_host);
+    QueryPerformanceCounter(&host_end);
 
     convert_VkPhysicalDeviceProperties2KHR_host_to_win(&pProperties_host, pProperties);
+    wine_vk_profile_record(110, &start, &host_start, &host_end);
 #else
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p\n", physicalDevice, pProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceProperties2KHR(physicalDevice->phys_dev, pProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(110, &start, &host_start, &host_end);
 #endif
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties *pQueueFamilyProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties *pQueueFamilyProperties)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p, %p\n", physicalDevice, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice->phys_dev, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(111, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceQueueFamilyProperties2KHR(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties2KHR *pQueueFamilyProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceQueueFamilyProperties2KHR(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties2KHR *pQueueFamilyProperties)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p, %p\n", physicalDevice, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceQueueFamilyProperties2KHR(physicalDevice->phys_dev, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(112, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceSparseImageFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkImageType type, VkSampleCountFlagBits samples, VkImageUsageFlags usage, VkImageTiling tiling, uint32_t *pPropertyCount, VkSparseImageFormatProperties *pProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceSparseImageFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkImageType type, VkSampleCountFlagBits samples, VkImageUsageFlags usage, VkImageTiling tiling, uint32_t *pPropertyCount, VkSparseImageFormatProperties *pProperties)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %d, %d, %d, %#x, %d, %p, %p\n", physicalDevice, format, type, samples, usage, tiling, pPropertyCount, pProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceSparseImageFormatProperties(physicalDevice->phys_dev, format, type, samples, usage, tiling, pPropertyCount, pProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(113, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkGetPhysicalDeviceSparseImageFormatProperties2KHR(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceSparseImageFormatInfo2KHR *pFormatInfo, uint32_t *pPropertyCount, VkSparseImageFormatProperties2KHR *pProperties)
+static void WINAPI wine_profile_vkGetPhysicalDeviceSparseImageFormatProperties2KHR(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceSparseImageFormatInfo2KHR *pFormatInfo, uint32_t *pPropertyCount, VkSparseImageFormatProperties2KHR *pProperties)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %p, %p, %p\n", physicalDevice, pFormatInfo, pPropertyCount, pProperties);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     physicalDevice->instance->funcs.p_vkGetPhysicalDeviceSparseImageFormatProperties2KHR(physicalDevice->phys_dev, pFormatInfo, pPropertyCount, pProperties);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(114, &start, &host_start, &host_end);
 }
 
-static VkResult WINAPI wine_vkGetPipelineCacheData(VkDevice device, VkPipelineCache pipelineCache, size_t *pDataSize, void *pData)
+static VkResult WINAPI wine_profile_vkGetPipelineCacheData(VkDevice device, VkPipelineCache pipelineCache, size_t *pDataSize, void *pData)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s, %p, %p\n", device, wine_dbgstr_longlong(pipelineCache), pDataSize, pData);
-    return device->funcs.p_vkGetPipelineCacheData(device->device, pipelineCache, pDataSize, pData);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkGetPipelineCacheData(device->device, pipelineCache, pDataSize, pData);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(115, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void *pData, VkDeviceSize stride, VkQueryResultFlags flags)
+static VkResult WINAPI wine_profile_vkGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void *pData, VkDeviceSize stride, VkQueryResultFlags flags)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s, %u, %u, 0x%s, %p, 0x%s, %#x\n", device, wine_dbgstr_longlong(queryPool), firstQuery, queryCount, wine_dbgstr_longlong(dataSize), pData, wine_dbgstr_longlong(stride), flags);
-    return device->funcs.p_vkGetQueryPoolResults(device->device, queryPool, firstQuery, queryCount, dataSize, pData, stride, flags);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkGetQueryPoolResults(device->device, queryPool, firstQuery, queryCount, dataSize, pData, stride, flags);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(116, &start, &host_start, &host_end);
+    return result;
 }
 
-static void WINAPI wine_vkGetRenderAreaGranularity(VkDevice device, VkRenderPass renderPass, VkExtent2D *pGranularity)
+static void WINAPI wine_profile_vkGetRenderAreaGranularity(VkDevice device, VkRenderPass renderPass, VkExtent2D *pGranularity)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, %p\n", device, wine_dbgstr_longlong(renderPass), pGranularity);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkGetRenderAreaGranularity(device->device, renderPass, pGranularity);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(117, &start, &host_start, &host_end);
 }
 
-static VkResult WINAPI wine_vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+static VkResult WINAPI wine_profile_vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
 {
-#if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkResult result;
-    VkMappedMemoryRange_host *pMemoryRanges_host;
     TRACE("%p, %u, %p\n", device, memoryRangeCount, pMemoryRanges);
 
-    pMemoryRanges_host = convert_VkMappedMemoryRange_array_win_to_host(pMemoryRanges, memoryRangeCount);
-    result = device->funcs.p_vkInvalidateMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges_host);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkInvalidateMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges);
+    QueryPerformanceCounter(&host_end);
 
-    free_VkMappedMemoryRange_array(pMemoryRanges_host, memoryRangeCount);
+    wine_vk_profile_record(118, &start, &host_start, &host_end);
     return result;
-#else
-    TRACE("%p, %u, %p\n", device, memoryRangeCount, pMemoryRanges);
-    return device->funcs.p_vkInvalidateMappedMemoryRanges(device->device, memoryRangeCount, pMemoryRanges);
-#endif
 }
 
-static VkResult WINAPI wine_vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void **ppData)
+static VkResult WINAPI wine_profile_vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void **ppData)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s, 0x%s, 0x%s, %#x, %p\n", device, wine_dbgstr_longlong(memory), wine_dbgstr_longlong(offset), wine_dbgstr_longlong(size), flags, ppData);
-    return device->funcs.p_vkMapMemory(device->device, memory, offset, size, flags, ppData);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkMapMemory(device->device, memory, offset, size, flags, ppData);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(119, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkMergePipelineCaches(VkDevice device, VkPipelineCache dstCache, uint32_t srcCacheCount, const VkPipelineCache *pSrcCaches)
+static VkResult WINAPI wine_profile_vkMergePipelineCaches(VkDevice device, VkPipelineCache dstCache, uint32_t srcCacheCount, const VkPipelineCache *pSrcCaches)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s, %u, %p\n", device, wine_dbgstr_longlong(dstCache), srcCacheCount, pSrcCaches);
-    return device->funcs.p_vkMergePipelineCaches(device->device, dstCache, srcCacheCount, pSrcCaches);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkMergePipelineCaches(device->device, dstCache, srcCacheCount, pSrcCaches);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(120, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkQueueBindSparse(VkQueue queue, uint32_t bindInfoCount, const VkBindSparseInfo *pBindInfo, VkFence fence)
+static VkResult WINAPI wine_profile_vkQueueBindSparse(VkQueue queue, uint32_t bindInfoCount, const VkBindSparseInfo *pBindInfo, VkFence fence)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkResult result;
     VkBindSparseInfo_host *pBindInfo_host;
     TRACE("%p, %u, %p, 0x%s\n", queue, bindInfoCount, pBindInfo, wine_dbgstr_longlong(fence));
 
+    QueryPerformanceCounter(&start);
     pBindInfo_host = convert_VkBindSparseInfo_array_win_to_host(pBindInfo, bindInfoCount);
+    QueryPerformanceCounter(&host_start);
+    wine_vk_queue_lock(queue);
     result = queue->device->funcs.p_vkQueueBindSparse(queue->queue, bindInfoCount, pBindInfo_host, fence);
+    wine_vk_queue_unlock(queue);
+    QueryPerformanceCounter(&host_end);
 
-    free_VkBindSparseInfo_array(pBindInfo_host, bindInfoCount);
+    wine_vk_arena_reset();
+    wine_vk_profile_record(121, &start, &host_start, &host_end);
     return result;
 #else
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, %u, %p, 0x%s\n", queue, bindInfoCount, pBindInfo, wine_dbgstr_longlong(fence));
-    return queue->device->funcs.p_vkQueueBindSparse(queue->queue, bindInfoCount, pBindInfo, fence);
-#endif
-}
 
-static VkResult WINAPI wine_vkQueueWaitIdle(VkQueue queue)
-{
-    TRACE("%p\n", queue);
-    return queue->device->funcs.p_vkQueueWaitIdle(queue->queue);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    wine_vk_queue_lock(queue);
+    result = queue->device->funcs.p_vkQueueBindSparse(queue->queue, bindInfoCount, pBindInfo, fence);
+    wine_vk_queue_unlock(queue);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(121, &start, &host_start, &host_end);
+    return result;
+#endif
 }
 
-static VkResult WINAPI wine_vkResetCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferResetFlags flags)
+static VkResult WINAPI wine_profile_vkResetCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferResetFlags flags)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, %#x\n", commandBuffer, flags);
-    return commandBuffer->device->funcs.p_vkResetCommandBuffer(commandBuffer->command_buffer, flags);
-}
 
-static VkResult WINAPI wine_vkResetCommandPool(VkDevice device, VkCommandPool commandPool, VkCommandPoolResetFlags flags)
-{
-    TRACE("%p, 0x%s, %#x\n", device, wine_dbgstr_longlong(commandPool), flags);
-    return device->funcs.p_vkResetCommandPool(device->device, commandPool, flags);
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = commandBuffer->device->funcs.p_vkResetCommandBuffer(commandBuffer->command_buffer, flags);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(122, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkResetDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, VkDescriptorPoolResetFlags flags)
+static VkResult WINAPI wine_profile_vkResetDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, VkDescriptorPoolResetFlags flags)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s, %#x\n", device, wine_dbgstr_longlong(descriptorPool), flags);
-    return device->funcs.p_vkResetDescriptorPool(device->device, descriptorPool, flags);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkResetDescriptorPool(device->device, descriptorPool, flags);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(123, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkResetEvent(VkDevice device, VkEvent event)
+static VkResult WINAPI wine_profile_vkResetEvent(VkDevice device, VkEvent event)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(event));
-    return device->funcs.p_vkResetEvent(device->device, event);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkResetEvent(device->device, event);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(124, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkResetFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences)
+static VkResult WINAPI wine_profile_vkResetFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, %u, %p\n", device, fenceCount, pFences);
-    return device->funcs.p_vkResetFences(device->device, fenceCount, pFences);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkResetFences(device->device, fenceCount, pFences);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(125, &start, &host_start, &host_end);
+    return result;
 }
 
-static VkResult WINAPI wine_vkSetEvent(VkDevice device, VkEvent event)
+static VkResult WINAPI wine_profile_vkSetEvent(VkDevice device, VkEvent event)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(event));
-    return device->funcs.p_vkSetEvent(device->device, event);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkSetEvent(device->device, event);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(126, &start, &host_start, &host_end);
+    return result;
 }
 
-static void WINAPI wine_vkSetHdrMetadataEXT(VkDevice device, uint32_t swapchainCount, const VkSwapchainKHR *pSwapchains, const VkHdrMetadataEXT *pMetadata)
+static void WINAPI wine_profile_vkSetHdrMetadataEXT(VkDevice device, uint32_t swapchainCount, const VkSwapchainKHR *pSwapchains, const VkHdrMetadataEXT *pMetadata)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %u, %p, %p\n", device, swapchainCount, pSwapchains, pMetadata);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkSetHdrMetadataEXT(device->device, swapchainCount, pSwapchains, pMetadata);
-}
+    QueryPerformanceCounter(&host_end);
 
-static void WINAPI wine_vkTrimCommandPoolKHR(VkDevice device, VkCommandPool commandPool, VkCommandPoolTrimFlagsKHR flags)
-{
-    TRACE("%p, 0x%s, %#x\n", device, wine_dbgstr_longlong(commandPool), flags);
-    device->funcs.p_vkTrimCommandPoolKHR(device->device, commandPool, flags);
+    wine_vk_profile_record(127, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkUnmapMemory(VkDevice device, VkDeviceMemory memory)
+static void WINAPI wine_profile_vkUnmapMemory(VkDevice device, VkDeviceMemory memory)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s\n", device, wine_dbgstr_longlong(memory));
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkUnmapMemory(device->device, memory);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(128, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkUpdateDescriptorSetWithTemplateKHR(VkDevice device, VkDescriptorSet descriptorSet, VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate, const void *pData)
+static void WINAPI wine_profile_vkUpdateDescriptorSetWithTemplateKHR(VkDevice device, VkDescriptorSet descriptorSet, VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate, const void *pData)
 {
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, 0x%s, 0x%s, %p\n", device, wine_dbgstr_longlong(descriptorSet), wine_dbgstr_longlong(descriptorUpdateTemplate), pData);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkUpdateDescriptorSetWithTemplateKHR(device->device, descriptorSet, descriptorUpdateTemplate, pData);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(129, &start, &host_start, &host_end);
 }
 
-static void WINAPI wine_vkUpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet *pDescriptorCopies)
+static void WINAPI wine_profile_vkUpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet *pDescriptorCopies)
 {
 #if defined(USE_STRUCT_CONVERSION)
+    LARGE_INTEGER start, host_start, host_end;
     VkWriteDescriptorSet_host *pDescriptorWrites_host;
     VkCopyDescriptorSet_host *pDescriptorCopies_host;
     TRACE("%p, %u, %p, %u, %p\n", device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
 
+    QueryPerformanceCounter(&start);
     pDescriptorWrites_host = convert_VkWriteDescriptorSet_array_win_to_host(pDescriptorWrites, descriptorWriteCount);
     pDescriptorCopies_host = convert_VkCopyDescriptorSet_array_win_to_host(pDescriptorCopies, descriptorCopyCount);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkUpdateDescriptorSets(device->device, descriptorWriteCount, pDescriptorWrites_host, descriptorCopyCount, pDescriptorCopies_host);
+    QueryPerformanceCounter(&host_end);
 
-    free_VkWriteDescriptorSet_array(pDescriptorWrites_host, descriptorWriteCount);
-    free_VkCopyDescriptorSet_array(pDescriptorCopies_host, descriptorCopyCount);
+    wine_vk_arena_reset();
+    wine_vk_profile_record(130, &start, &host_start, &host_end);
 #else
+    LARGE_INTEGER start, host_start, host_end;
     TRACE("%p, %u, %p, %u, %p\n", device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
     device->funcs.p_vkUpdateDescriptorSets(device->device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(130, &start, &host_start, &host_end);
 #endif
 }
 
-static VkResult WINAPI wine_vkWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences, VkBool32 waitAll, uint64_t timeout)
+static VkResult WINAPI wine_profile_vkWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences, VkBool32 waitAll, uint64_t timeout)
 {
+    LARGE_INTEGER start, host_start, host_end;
+    VkResult result;
     TRACE("%p, %u, %p, %u, 0x%s\n", device, fenceCount, pFences, waitAll, wine_dbgstr_longlong(timeout));
-    return device->funcs.p_vkWaitForFences(device->device, fenceCount, pFences, waitAll, timeout);
+
+    QueryPerformanceCounter(&start);
+    QueryPerformanceCounter(&host_start);
+    result = device->funcs.p_vkWaitForFences(device->device, fenceCount, pFences, waitAll, timeout);
+    QueryPerformanceCounter(&host_end);
+
+    wine_vk_profile_record(131, &start, &host_start, &host_end);
+    return result;
 }
 
+const char * const wine_vk_profile_names[WINE_VK_PROFILE_COUNT] =
+{
+    "vkAllocateDescriptorSets",
+    "vkBeginCommandBuffer",
+    "vkBindBufferMemory",
+    "vkBindImageMemory",
+    "vkCmdBeginQuery",
+    "vkCmdBeginRenderPass",
+    "vkCmdBindDescriptorSets",
+    "vkCmdBindIndexBuffer",
+    "vkCmdBindPipeline",
+    "vkCmdBindVertexBuffers",
+    "vkCmdBlitImage",
+    "vkCmdClearAttachments",
+    "vkCmdClearColorImage",
+    "vkCmdClearDepthStencilImage",
+    "vkCmdCopyBuffer",
+    "vkCmdCopyBufferToImage",
+    "vkCmdCopyImage",
+    "vkCmdCopyImageToBuffer",
+    "vkCmdCopyQueryPoolResults",
+    "vkCmdDispatch",
+    "vkCmdDispatchIndirect",
+    "vkCmdDraw",
+    "vkCmdDrawIndexed",
+    "vkCmdDrawIndexedIndirect",
+    "vkCmdDrawIndexedIndirectCountAMD",
+    "vkCmdDrawIndirect",
+    "vkCmdDrawIndirectCountAMD",
+    "vkCmdEndQuery",
+    "vkCmdEndRenderPass",
+    "vkCmdFillBuffer",
+    "vkCmdNextSubpass",
+    "vkCmdPipelineBarrier",
+    "vkCmdPushConstants",
+    "vkCmdPushDescriptorSetKHR",
+    "vkCmdPushDescriptorSetWithTemplateKHR",
+    "vkCmdResetEvent",
+    "vkCmdResetQueryPool",
+    "vkCmdResolveImage",
+    "vkCmdSetBlendConstants",
+    "vkCmdSetDepthBias",
+    "vkCmdSetDepthBounds",
+    "vkCmdSetDiscardRectangleEXT",
+    "vkCmdSetEvent",
+    "vkCmdSetLineWidth",
+    "vkCmdSetScissor",
+    "vkCmdSetStencilCompareMask",
+    "vkCmdSetStencilReference",
+    "vkCmdSetStencilWriteMask",
+    "vkCmdSetViewport",
+    "vkCmdSetViewportWScalingNV",
+    "vkCmdUpdateBuffer",
+    "vkCmdWaitEvents",
+    "vkCmdWriteTimestamp",
+    "vkCreateBuffer",
+    "vkCreateBufferView",
+    "vkCreateComputePipelines",
+    "vkCreateDescriptorPool",
+    "vkCreateDescriptorSetLayout",
+    "vkCreateDescriptorUpdateTemplateKHR",
+    "vkCreateEvent",
+    "vkCreateFence",
+    "vkCreateFramebuffer",
+    "vkCreateGraphicsPipelines",
+    "vkCreateImage",
+    "vkCreateImageView",
+    "vkCreatePipelineCache",
+    "vkCreatePipelineLayout",
+    "vkCreateQueryPool",
+    "vkCreateRenderPass",
+    "vkCreateSampler",
+    "vkCreateSemaphore",
+    "vkCreateShaderModule",
+    "vkDestroyBuffer",
+    "vkDestroyBufferView",
+    "vkDestroyDescriptorPool",
+    "vkDestroyDescriptorSetLayout",
+    "vkDestroyDescriptorUpdateTemplateKHR",
+    "vkDestroyEvent",
+    "vkDestroyFence",
+    "vkDestroyFramebuffer",
+    "vkDestroyImage",
+    "vkDestroyImageView",
+    "vkDestroyPipeline",
+    "vkDestroyPipelineCache",
+    "vkDestroyPipelineLayout",
+    "vkDestroyQueryPool",
+    "vkDestroyRenderPass",
+    "vkDestroySampler",
+    "vkDestroySemaphore",
+    "vkDestroyShaderModule",
+    "vkEndCommandBuffer",
+    "vkEnumerateDeviceLayerProperties",
+    "vkFlushMappedMemoryRanges",
+    "vkFreeDescriptorSets",
+    "vkGetBufferMemoryRequirements",
+    "vkGetDeviceMemoryCommitment",
+    "vkGetEventStatus",
+    "vkGetFenceStatus",
+    "vkGetImageMemoryRequirements",
+    "vkGetImageSparseMemoryRequirements",
+    "vkGetImageSubresourceLayout",
+    "vkGetPhysicalDeviceFeatures",
+    "vkGetPhysicalDeviceFeatures2KHR",
+    "vkGetPhysicalDeviceFormatProperties",
+    "vkGetPhysicalDeviceFormatProperties2KHR",
+    "vkGetPhysicalDeviceImageFormatProperties",
+    "vkGetPhysicalDeviceImageFormatProperties2KHR",
+    "vkGetPhysicalDeviceMemoryProperties",
+    "vkGetPhysicalDeviceMemoryProperties2KHR",
+    "vkGetPhysicalDeviceProperties",
+    "vkGetPhysicalDeviceProperties2KHR",
+    "vkGetPhysicalDeviceQueueFamilyProperties",
+    "vkGetPhysicalDeviceQueueFamilyProperties2KHR",
+    "vkGetPhysicalDeviceSparseImageFormatProperties",
+    "vkGetPhysicalDeviceSparseImageFormatProperties2KHR",
+    "vkGetPipelineCacheData",
+    "vkGetQueryPoolResults",
+    "vkGetRenderAreaGranularity",
+    "vkInvalidateMappedMemoryRanges",
+    "vkMapMemory",
+    "vkMergePipelineCaches",
+    "vkQueueBindSparse",
+    "vkResetCommandBuffer",
+    "vkResetDescriptorPool",
+    "vkResetEvent",
+    "vkResetFences",
+    "vkSetEvent",
+    "vkSetHdrMetadataEXT",
+    "vkUnmapMemory",
+    "vkUpdateDescriptorSetWithTemplateKHR",
+    "vkUpdateDescriptorSets",
+    "vkWaitForFences",
+};
+
 static const struct vulkan_func vk_device_dispatch_table[] =
 {
     {"vkAcquireNextImageKHR", &wine_vkAcquireNextImageKHR},
@@ -2315,35 +4002,213 @@ static const struct vulkan_func vk_instance_dispatch_table[] =
     {"vkGetPhysicalDeviceWin32PresentationSupportKHR", &wine_vkGetPhysicalDeviceWin32PresentationSupportKHR},
 };
 
+static void * const vk_device_profile_table[] =
+{
+    &wine_vkAcquireNextImageKHR,
+    &wine_vkAllocateCommandBuffers,
+    &wine_profile_vkAllocateDescriptorSets,
+    &wine_vkAllocateMemory,
+    &wine_profile_vkBeginCommandBuffer,
+    &wine_profile_vkBindBufferMemory,
+    &wine_profile_vkBindImageMemory,
+    &wine_profile_vkCmdBeginQuery,
+    &wine_profile_vkCmdBeginRenderPass,
+    &wine_profile_vkCmdBindDescriptorSets,
+    &wine_profile_vkCmdBindIndexBuffer,
+    &wine_profile_vkCmdBindPipeline,
+    &wine_profile_vkCmdBindVertexBuffers,
+    &wine_profile_vkCmdBlitImage,
+    &wine_profile_vkCmdClearAttachments,
+    &wine_profile_vkCmdClearColorImage,
+    &wine_profile_vkCmdClearDepthStencilImage,
+    &wine_profile_vkCmdCopyBuffer,
+    &wine_profile_vkCmdCopyBufferToImage,
+    &wine_profile_vkCmdCopyImage,
+    &wine_profile_vkCmdCopyImageToBuffer,
+    &wine_profile_vkCmdCopyQueryPoolResults,
+    &wine_profile_vkCmdDispatch,
+    &wine_profile_vkCmdDispatchIndirect,
+    &wine_profile_vkCmdDraw,
+    &wine_profile_vkCmdDrawIndexed,
+    &wine_profile_vkCmdDrawIndexedIndirect,
+    &wine_profile_vkCmdDrawIndexedIndirectCountAMD,
+    &wine_profile_vkCmdDrawIndirect,
+    &wine_profile_vkCmdDrawIndirectCountAMD,
+    &wine_profile_vkCmdEndQuery,
+    &wine_profile_vkCmdEndRenderPass,
+    &wine_vkCmdExecuteCommands,
+    &wine_profile_vkCmdFillBuffer,
+    &wine_profile_vkCmdNextSubpass,
+    &wine_profile_vkCmdPipelineBarrier,
+    &wine_profile_vkCmdPushConstants,
+    &wine_profile_vkCmdPushDescriptorSetKHR,
+    &wine_profile_vkCmdPushDescriptorSetWithTemplateKHR,
+    &wine_profile_vkCmdResetEvent,
+    &wine_profile_vkCmdResetQueryPool,
+    &wine_profile_vkCmdResolveImage,
+    &wine_profile_vkCmdSetBlendConstants,
+    &wine_profile_vkCmdSetDepthBias,
+    &wine_profile_vkCmdSetDepthBounds,
+    &wine_profile_vkCmdSetDiscardRectangleEXT,
+    &wine_profile_vkCmdSetEvent,
+    &wine_profile_vkCmdSetLineWidth,
+    &wine_profile_vkCmdSetScissor,
+    &wine_profile_vkCmdSetStencilCompareMask,
+    &wine_profile_vkCmdSetStencilReference,
+    &wine_profile_vkCmdSetStencilWriteMask,
+    &wine_profile_vkCmdSetViewport,
+    &wine_profile_vkCmdSetViewportWScalingNV,
+    &wine_profile_vkCmdUpdateBuffer,
+    &wine_profile_vkCmdWaitEvents,
+    &wine_profile_vkCmdWriteTimestamp,
+    &wine_profile_vkCreateBuffer,
+    &wine_profile_vkCreateBufferView,
+    &wine_vkCreateCommandPool,
+    &wine_profile_vkCreateComputePipelines,
+    &wine_profile_vkCreateDescriptorPool,
+    &wine_profile_vkCreateDescriptorSetLayout,
+    &wine_profile_vkCreateDescriptorUpdateTemplateKHR,
+    &wine_profile_vkCreateEvent,
+    &wine_profile_vkCreateFence,
+    &wine_profile_vkCreateFramebuffer,
+    &wine_profile_vkCreateGraphicsPipelines,
+    &wine_profile_vkCreateImage,
+    &wine_profile_vkCreateImageView,
+    &wine_profile_vkCreatePipelineCache,
+    &wine_profile_vkCreatePipelineLayout,
+    &wine_profile_vkCreateQueryPool,
+    &wine_profile_vkCreateRenderPass,
+    &wine_profile_vkCreateSampler,
+    &wine_profile_vkCreateSemaphore,
+    &wine_profile_vkCreateShaderModule,
+    &wine_vkCreateSwapchainKHR,
+    &wine_profile_vkDestroyBuffer,
+    &wine_profile_vkDestroyBufferView,
+    &wine_vkDestroyCommandPool,
+    &wine_profile_vkDestroyDescriptorPool,
+    &wine_profile_vkDestroyDescriptorSetLayout,
+    &wine_profile_vkDestroyDescriptorUpdateTemplateKHR,
+    &wine_vkDestroyDevice,
+    &wine_profile_vkDestroyEvent,
+    &wine_profile_vkDestroyFence,
+    &wine_profile_vkDestroyFramebuffer,
+    &wine_profile_vkDestroyImage,
+    &wine_profile_vkDestroyImageView,
+    &wine_profile_vkDestroyPipeline,
+    &wine_profile_vkDestroyPipelineCache,
+    &wine_profile_vkDestroyPipelineLayout,
+    &wine_profile_vkDestroyQueryPool,
+    &wine_profile_vkDestroyRenderPass,
+    &wine_profile_vkDestroySampler,
+    &wine_profile_vkDestroySemaphore,
+    &wine_profile_vkDestroyShaderModule,
+    &wine_vkDestroySwapchainKHR,
+    &wine_vkDeviceWaitIdle,
+    &wine_profile_vkEndCommandBuffer,
+    &wine_profile_vkFlushMappedMemoryRanges,
+    &wine_vkFreeCommandBuffers,
+    &wine_profile_vkFreeDescriptorSets,
+    &wine_vkFreeMemory,
+    &wine_profile_vkGetBufferMemoryRequirements,
+    &wine_profile_vkGetDeviceMemoryCommitment,
+    &wine_vkGetDeviceProcAddr,
+    &wine_vkGetDeviceQueue,
+    &wine_profile_vkGetEventStatus,
+    &wine_profile_vkGetFenceStatus,
+    &wine_profile_vkGetImageMemoryRequirements,
+    &wine_profile_vkGetImageSparseMemoryRequirements,
+    &wine_profile_vkGetImageSubresourceLayout,
+    &wine_profile_vkGetPipelineCacheData,
+    &wine_profile_vkGetQueryPoolResults,
+    &wine_profile_vkGetRenderAreaGranularity,
+    &wine_vkGetSwapchainImagesKHR,
+    &wine_profile_vkInvalidateMappedMemoryRanges,
+    &wine_profile_vkMapMemory,
+    &wine_profile_vkMergePipelineCaches,
+    &wine_profile_vkQueueBindSparse,
+    &wine_vkQueuePresentKHR,
+    &wine_vkQueueSubmit,
+    &wine_vkQueueWaitIdle,
+    &wine_profile_vkResetCommandBuffer,
+    &wine_vkResetCommandPool,
+    &wine_profile_vkResetDescriptorPool,
+    &wine_profile_vkResetEvent,
+    &wine_profile_vkResetFences,
+    &wine_profile_vkSetEvent,
+    &wine_profile_vkSetHdrMetadataEXT,
+    &wine_vkTrimCommandPoolKHR,
+    &wine_profile_vkUnmapMemory,
+    &wine_profile_vkUpdateDescriptorSetWithTemplateKHR,
+    &wine_profile_vkUpdateDescriptorSets,
+    &wine_profile_vkWaitForFences,
+};
+
+static void * const vk_instance_profile_table[] =
+{
+    &wine_vkCreateDevice,
+    &wine_vkCreateWin32SurfaceKHR,
+    &wine_vkDestroyInstance,
+    &wine_vkDestroySurfaceKHR,
+    &wine_vkEnumerateDeviceExtensionProperties,
+    &wine_profile_vkEnumerateDeviceLayerProperties,
+    &wine_vkEnumeratePhysicalDevices,
+    &wine_profile_vkGetPhysicalDeviceFeatures,
+    &wine_profile_vkGetPhysicalDeviceFeatures2KHR,
+    &wine_profile_vkGetPhysicalDeviceFormatProperties,
+    &wine_profile_vkGetPhysicalDeviceFormatProperties2KHR,
+    &wine_profile_vkGetPhysicalDeviceImageFormatProperties,
+    &wine_profile_vkGetPhysicalDeviceImageFormatProperties2KHR,
+    &wine_profile_vkGetPhysicalDeviceMemoryProperties,
+    &wine_profile_vkGetPhysicalDeviceMemoryProperties2KHR,
+    &wine_profile_vkGetPhysicalDeviceProperties,
+    &wine_profile_vkGetPhysicalDeviceProperties2KHR,
+    &wine_profile_vkGetPhysicalDeviceQueueFamilyProperties,
+    &wine_profile_vkGetPhysicalDeviceQueueFamilyProperties2KHR,
+    &wine_profile_vkGetPhysicalDeviceSparseImageFormatProperties,
+    &wine_profile_vkGetPhysicalDeviceSparseImageFormatProperties2KHR,
+    &wine_vkGetPhysicalDeviceSurfaceCapabilitiesKHR,
+    &wine_vkGetPhysicalDeviceSurfaceFormatsKHR,
+    &wine_vkGetPhysicalDeviceSurfacePresentModesKHR,
+    &wine_vkGetPhysicalDeviceSurfaceSupportKHR,
+    &wine_vkGetPhysicalDeviceWin32PresentationSupportKHR,
+};
+
+static int wine_vk_func_compare(const void *name, const void *entry)
+{
+    return strcmp(name, ((const struct vulkan_func *)entry)->name);
+}
+
 void *wine_vk_get_device_proc_addr(const char *name)
 {
-    unsigned int i;
-    for (i = 0; i < ARRAY_SIZE(vk_device_dispatch_table); i++)
-    {
-        if (strcmp(vk_device_dispatch_table[i].name, name) == 0)
-        {
-            TRACE("Found pName=%s in device table\n", name);
-            return vk_device_dispatch_table[i].func;
-        }
-    }
-    return NULL;
+    const struct vulkan_func *func;
+
+    func = bsearch(name, vk_device_dispatch_table, ARRAY_SIZE(vk_device_dispatch_table),
+            sizeof(vk_device_dispatch_table[0]), wine_vk_func_compare);
+    if (!func)
+        return NULL;
+
+    TRACE("Found pName=%s in device table\n", name);
+    if (wine_vk_profile_enabled)
+        return vk_device_profile_table[func - vk_device_dispatch_table];
+    return func->func;
 }
 
 void *wine_vk_get_instance_proc_addr(const char *name)
 {
-    unsigned int i;
-    for (i = 0; i < ARRAY_SIZE(vk_instance_dispatch_table); i++)
-    {
-        if (strcmp(vk_instance_dispatch_table[i].name, name) == 0)
-        {
-            TRACE("Found pName=%s in instance table\n", name);
-            return vk_instance_dispatch_table[i].func;
-        }
-    }
-    return NULL;
+    const struct vulkan_func *func;
+
+    func = bsearch(name, vk_instance_dispatch_table, ARRAY_SIZE(vk_instance_dispatch_table),
+            sizeof(vk_instance_dispatch_table[0]), wine_vk_func_compare);
+    if (!func)
+        return NULL;
+
+    TRACE("Found pName=%s in instance table\n", name);
+    if (wine_vk_profile_enabled)
+        return vk_instance_profile_table[func - vk_instance_dispatch_table];
+    return func->func;
 }
 
-static const char *vk_device_extensions[] =
+static const char * const vk_device_extensions[] =
 {
     "VK_AMD_draw_indirect_count",
     "VK_AMD_gcn_shader",
@@ -2377,31 +4242,26 @@ static const char *vk_device_extensions[] =
     "VK_NV_viewport_swizzle",
 };
 
-static const char *vk_instance_extensions[] =
+static const char * const vk_instance_extensions[] =
 {
     "VK_KHR_get_physical_device_properties2",
     "VK_KHR_surface",
     "VK_KHR_win32_surface",
 };
 
+static int wine_vk_extension_compare(const void *name, const void *entry)
+{
+    return strcmp(name, *(const char * const *)entry);
+}
+
 BOOL wine_vk_device_extension_supported(const char *name)
 {
-    unsigned int i;
-    for (i = 0; i < ARRAY_SIZE(vk_device_extensions); i++)
-    {
-        if (strcmp(vk_device_extensions[i], name) == 0)
-            return TRUE;
-    }
-    return FALSE;
+    return bsearch(name, vk_device_extensions, ARRAY_SIZE(vk_device_extensions),
+            sizeof(vk_device_extensions[0]), wine_vk_extension_compare) != NULL;
 }
 
 BOOL wine_vk_instance_extension_supported(const char *name)
 {
-    unsigned int i;
-    for (i = 0; i < ARRAY_SIZE(vk_instance_extensions); i++)
-    {
-        if (strcmp(vk_instance_extensions[i], name) == 0)
-            return TRUE;
-    }
-    return FALSE;
+    return bsearch(name, vk_instance_extensions, ARRAY_SIZE(vk_instance_extensions),
+            sizeof(vk_instance_extensions[0]), wine_vk_extension_compare) != NULL;
 }
@@ -1556,6 +1556,11 @@ DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisualInfo
 }
 
 
+/* damage is tracked by comparing hashes of tiles of the surface bits */
+#define DAMAGE_TILE_WIDTH  64
+#define DAMAGE_TILE_HEIGHT 16
+#define MAX_DAMAGE_RECTS   32
+
 struct x11drv_window_surface
 {
     struct window_surface header;
@@ -1569,8 +1574,15 @@ struct x11drv_window_surface
     COLORREF              color_key;
     HRGN                  region;
     void                 *bits;
+    ULONGLONG            *tile_hashes;  /* hash of each tile at the last flush, 0 if unknown */
+    int                   tiles_x;
+    int                   tiles_y;
 #ifdef HAVE_LIBXXSHM
     XShmSegmentInfo       shminfo;
+    int                   shm_pending;       /* puts from the image not completed yet */
+    XImage               *back_image;        /* second image when double buffering */
+    XShmSegmentInfo       back_shminfo;
+    int                   back_shm_pending;
 #endif
     CRITICAL_SECTION      crit;
     BITMAPINFO            info;   /* variable size, must be last */
@@ -1809,8 +1821,160 @@ failed:
     XDestroyImage( image );
     return NULL;
 }
+
+static void destroy_shm_image( XImage *image, XShmSegmentInfo *shminfo )
+{
+    XShmDetach( gdi_display, shminfo );
+    shmdt( shminfo->shmaddr );
+    image->data = NULL;
+    XDestroyImage( image );
+}
+
+static int shm_completion_event = -1;
+
+static Bool is_shm_completion( Display *display, XEvent *event, XPointer arg )
+{
+    return (event->type == shm_completion_event &&
+            ((XShmCompletionEvent *)event)->shmseg == *(ShmSeg *)arg);
+}
+
+/* wait until the server has finished reading the pending puts of an image */
+static void wait_shm_completion( XShmSegmentInfo *shminfo, int *pending )
+{
+    XEvent event;
+
+    while (*pending && XCheckIfEvent( gdi_display, &event, is_shm_completion, (XPointer)&shminfo->shmseg ))
+        (*pending)--;
+    if (!*pending) return;
+
+    /* all the completion events are queued once the requests have been processed */
+    TRACE( "waiting for %d puts from segment %lx\n", *pending, shminfo->shmseg );
+    XSync( gdi_display, False );
+    while (XCheckIfEvent( gdi_display, &event, is_shm_completion, (XPointer)&shminfo->shmseg )) ;
+    *pending = 0;
+}
 #endif /* HAVE_LIBXXSHM */
 
+static inline ULONGLONG hash_bytes( ULONGLONG hash, const unsigned char *ptr, int len )
+{
+    ULONGLONG val;
+
+    /* every step is a bijection of the hash, so a single modified word is always detected */
+    for ( ; len >= sizeof(val); ptr += sizeof(val), len -= sizeof(val))
+    {
+        memcpy( &val, ptr, sizeof(val) );
+        hash = (((hash << 31) | (hash >> 33)) ^ val) * 0x100000001b3ull;
+    }
+    if (len)
+    {
+        val = 0;
+        memcpy( &val, ptr, len );
+        hash = (((hash << 31) | (hash >> 33)) ^ val) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static void invalidate_tiles( struct x11drv_window_surface *surface, const RECT *rect )
+{
+    int x, y, left, top, right, bottom;
+
+    if (!surface->tile_hashes) return;
+    left   = max( 0, rect->left / DAMAGE_TILE_WIDTH );
+    top    = max( 0, rect->top / DAMAGE_TILE_HEIGHT );
+    right  = min( surface->tiles_x, (rect->right + DAMAGE_TILE_WIDTH - 1) / DAMAGE_TILE_WIDTH );
+    bottom = min( surface->tiles_y, (rect->bottom + DAMAGE_TILE_HEIGHT - 1) / DAMAGE_TILE_HEIGHT );
+    for (y = top; y < bottom; y++)
+        for (x = left; x < right; x++)
+            surface->tile_hashes[y * surface->tiles_x + x] = 0;
+}
+
+struct damage
+{
+    RECT *rects;
+    int   count;
+    RECT  extents;   /* bounding box of the rectangles that didn't fit */
+};
+
+static void add_damage_span( struct damage *damage, const RECT *span )
+{
+    int i;
+
+    /* merge with a span of the same width in the previous tile row */
+    for (i = 0; i < damage->count; i++)
+    {
+        if (damage->rects[i].bottom != span->top) continue;
+        if (damage->rects[i].left != span->left || damage->rects[i].right != span->right) continue;
+        damage->rects[i].bottom = span->bottom;
+        return;
+    }
+    if (damage->count < MAX_DAMAGE_RECTS - 1) damage->rects[damage->count++] = *span;
+    else add_bounds_rect( &damage->extents, span );
+}
+
+/***********************************************************************
+ *           get_damaged_rects
+ *
+ * Find the tiles within the bounds whose contents changed since the last
+ * flush, and merge them into a list of rectangles.
+ */
+static int get_damaged_rects( struct x11drv_window_surface *surface, const RECT *bounds, RECT *rects )
+{
+    int bpp = surface->info.bmiHeader.biBitCount;
+    int width = surface->header.rect.right - surface->header.rect.left;
+    int height = surface->header.rect.bottom - surface->header.rect.top;
+    int stride = surface->image->bytes_per_line;
+    const unsigned char *bits = surface->bits;
+    int x, y, i, row, top, bottom;
+    struct damage damage;
+    ULONGLONG hash, *tile;
+    RECT span;
+
+    if (!surface->tile_hashes)
+    {
+        rects[0] = *bounds;
+        return 1;
+    }
+
+    damage.rects = rects;
+    damage.count = 0;
+    reset_bounds( &damage.extents );
+
+    for (y = bounds->top / DAMAGE_TILE_HEIGHT; y * DAMAGE_TILE_HEIGHT < bounds->bottom; y++)
+    {
+        top = y * DAMAGE_TILE_HEIGHT;
+        bottom = min( top + DAMAGE_TILE_HEIGHT, height );
+        SetRectEmpty( &span );
+
+        for (x = bounds->left / DAMAGE_TILE_WIDTH; x * DAMAGE_TILE_WIDTH < bounds->right; x++)
+        {
+            int left = x * DAMAGE_TILE_WIDTH, right = min( left + DAMAGE_TILE_WIDTH, width );
+
+            tile = &surface->tile_hashes[y * surface->tiles_x + x];
+            hash = 0xcbf29ce484222325ull;
+            for (row = top; row < bottom; row++)
+                hash = hash_bytes( hash, bits + row * stride + left * bpp / 8, (right - left) * bpp / 8 );
+            hash |= 1;
+            if (hash == *tile) continue;
+            *tile = hash;
+
+            if (!IsRectEmpty( &span ) && span.right == left)
+            {
+                span.right = right;
+                continue;
+            }
+            if (!IsRectEmpty( &span )) add_damage_span( &damage, &span );
+            SetRect( &span, left, top, right, bottom );
+        }
+        if (!IsRectEmpty( &span )) add_damage_span( &damage, &span );
+    }
+
+    /* the rectangles that didn't fit are sent as their bounding box */
+    if (!IsRectEmpty( &damage.extents )) rects[damage.count++] = damage.extents;
+
+    for (i = 0; i < damage.count; i++) IntersectRect( &rects[i], &rects[i], bounds );
+    return damage.count;
+}
+
 /***********************************************************************
  *           x11drv_surface_lock
  */
@@ -1880,6 +2044,9 @@ static void x11drv_surface_set_region( struct window_surface *window_surface, HR
             HeapFree( GetProcessHeap(), 0, data );
         }
     }
+    /* parts of the window may become visible without changing the bits */
+    if (surface->tile_hashes)
+        memset( surface->tile_hashes, 0, surface->tiles_x * surface->tiles_y * sizeof(*surface->tile_hashes) );
     window_surface->funcs->unlock( window_surface );
 }
 
@@ -1891,62 +2058,91 @@ static void x11drv_surface_flush( struct window_surface *window_surface )
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
     unsigned char *src = surface->bits;
     unsigned char *dst = (unsigned char *)surface->image->data;
-    struct bitblt_coords coords;
+    RECT visrect, rects[MAX_DAMAGE_RECTS];
+    int i, count;
 
     window_surface->funcs->lock( window_surface );
-    coords.x = 0;
-    coords.y = 0;
-    coords.width  = surface->header.rect.right - surface->header.rect.left;
-    coords.height = surface->header.rect.bottom - surface->header.rect.top;
-    SetRect( &coords.visrect, 0, 0, coords.width, coords.height );
-    if (IntersectRect( &coords.visrect, &coords.visrect, &surface->bounds ))
+    SetRect( &visrect, 0, 0, surface->header.rect.right - surface->header.rect.left,
+             surface->header.rect.bottom - surface->header.rect.top );
+    if (IntersectRect( &visrect, &visrect, &surface->bounds ))
     {
-        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
-               surface, coords.width, coords.height,
+        TRACE( "flushing %p %s bounds %s bits %p\n",
+               surface, wine_dbgstr_rect( &surface->header.rect ),
                wine_dbgstr_rect( &surface->bounds ), surface->bits );
 
         if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
 
-        if (src != dst)
+        if (src == dst && surface->alpha_bits)
         {
-            const int *mapping = NULL;
-            int width_bytes = surface->image->bytes_per_line;
-
-            if (surface->image->bits_per_pixel == 4 || surface->image->bits_per_pixel == 8)
-                mapping = X11DRV_PALETTE_PaletteToXPixel;
+            int x, y, stride = surface->image->bytes_per_line / sizeof(ULONG);
+            ULONG *ptr = (ULONG *)dst + visrect.top * stride;
 
-            src += coords.visrect.top * width_bytes;
-            dst += coords.visrect.top * width_bytes;
-            copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
-                                 coords.visrect.bottom - coords.visrect.top,
-                                 surface->byteswap, mapping, ~0u, surface->alpha_bits );
+            for (y = visrect.top; y < visrect.bottom; y++, ptr += stride)
+                for (x = visrect.left; x < visrect.right; x++)
+                    ptr[x] |= surface->alpha_bits;
         }
-        else if (surface->alpha_bits)
+
+        count = get_damaged_rects( surface, &visrect, rects );
+        TRACE( "%d damaged rects\n", count );
+
+#ifdef HAVE_LIBXXSHM
+        /* the image we are about to fill may still be read by the server */
+        if (surface->back_image) wait_shm_completion( &surface->shminfo, &surface->shm_pending );
+#endif
+
+        for (i = 0; i < count; i++)
         {
-            int x, y, stride = surface->image->bytes_per_line / sizeof(ULONG);
-            ULONG *ptr = (ULONG *)dst + coords.visrect.top * stride;
+            if (src != dst)
+            {
+                const int *mapping = NULL;
+                int width_bytes = surface->image->bytes_per_line;
 
-            for (y = coords.visrect.top; y < coords.visrect.bottom; y++, ptr += stride)
-                for (x = coords.visrect.left; x < coords.visrect.right; x++)
-                    ptr[x] |= surface->alpha_bits;
+                if (surface->image->bits_per_pixel == 4 || surface->image->bits_per_pixel == 8)
+                    mapping = X11DRV_PALETTE_PaletteToXPixel;
+
+                copy_image_byteswap( &surface->info, src + rects[i].top * width_bytes,
+                                     dst + rects[i].top * width_bytes, width_bytes, width_bytes,
+                                     rects[i].bottom - rects[i].top,
+                                     surface->byteswap, mapping, ~0u, surface->alpha_bits );
+            }
+
+#ifdef HAVE_LIBXXSHM
+            if (surface->shminfo.shmid != -1)
+            {
+                XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                              rects[i].left, rects[i].top,
+                              surface->header.rect.left + rects[i].left,
+                              surface->header.rect.top + rects[i].top,
+                              rects[i].right - rects[i].left,
+                              rects[i].bottom - rects[i].top, surface->back_image != NULL );
+                if (surface->back_image) surface->shm_pending++;
+            }
+            else
+#endif
+            XPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                       rects[i].left, rects[i].top,
+                       surface->header.rect.left + rects[i].left,
+                       surface->header.rect.top + rects[i].top,
+                       rects[i].right - rects[i].left,
+                       rects[i].bottom - rects[i].top );
         }
 
 #ifdef HAVE_LIBXXSHM
-        if (surface->shminfo.shmid != -1)
-            XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                          coords.visrect.left, coords.visrect.top,
-                          surface->header.rect.left + coords.visrect.left,
-                          surface->header.rect.top + coords.visrect.top,
-                          coords.visrect.right - coords.visrect.left,
-                          coords.visrect.bottom - coords.visrect.top, False );
-        else
+        /* fill the other image next time while the server reads this one */
+        if (surface->back_image && count)
+        {
+            XImage *image = surface->image;
+            XShmSegmentInfo shminfo = surface->shminfo;
+            int pending = surface->shm_pending;
+
+            surface->image = surface->back_image;
+            surface->shminfo = surface->back_shminfo;
+            surface->shm_pending = surface->back_shm_pending;
+            surface->back_image = image;
+            surface->back_shminfo = shminfo;
+            surface->back_shm_pending = pending;
+        }
 #endif
-        XPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                   coords.visrect.left, coords.visrect.top,
-                   surface->header.rect.left + coords.visrect.left,
-                   surface->header.rect.top + coords.visrect.top,
-                   coords.visrect.right - coords.visrect.left,
-                   coords.visrect.bottom - coords.visrect.top );
         XFlush( gdi_display );
     }
     reset_bounds( &surface->bounds );
@@ -1966,17 +2162,24 @@ static void x11drv_surface_destroy( struct window_surface *window_surface )
     {
         if (surface->image->data != surface->bits) HeapFree( GetProcessHeap(), 0, surface->bits );
 #ifdef HAVE_LIBXXSHM
-        if (surface->shminfo.shmid != -1)
+        if (surface->back_image)
         {
-            XShmDetach( gdi_display, &surface->shminfo );
-            shmdt( surface->shminfo.shmaddr );
+            /* don't leave completion events in the queue */
+            wait_shm_completion( &surface->shminfo, &surface->shm_pending );
+            wait_shm_completion( &surface->back_shminfo, &surface->back_shm_pending );
+            destroy_shm_image( surface->back_image, &surface->back_shminfo );
         }
+        if (surface->shminfo.shmid != -1)
+            destroy_shm_image( surface->image, &surface->shminfo );
         else
 #endif
-        HeapFree( GetProcessHeap(), 0, surface->image->data );
-        surface->image->data = NULL;
-        XDestroyImage( surface->image );
+        {
+            HeapFree( GetProcessHeap(), 0, surface->image->data );
+            surface->image->data = NULL;
+            XDestroyImage( surface->image );
+        }
     }
+    HeapFree( GetProcessHeap(), 0, surface->tile_hashes );
     surface->crit.DebugInfo->Spare[0] = 0;
     DeleteCriticalSection( &surface->crit );
     if (surface->region) DeleteObject( surface->region );
@@ -2028,7 +2231,14 @@ struct window_surface *create_surface( Window window, const XVisualInfo *vis, co
     reset_bounds( &surface->bounds );
 
 #ifdef HAVE_LIBXXSHM
+    surface->shminfo.shmid = -1;
     surface->image = create_shm_image( vis, width, height, &surface->shminfo );
+    if (surface->image && use_shm_double_buffer)
+    {
+        if (shm_completion_event == -1)
+            shm_completion_event = XShmGetEventBase( gdi_display ) + ShmCompletion;
+        surface->back_image = create_shm_image( vis, width, height, &surface->back_shminfo );
+    }
     if (!surface->image)
 #endif
     {
@@ -2046,15 +2256,28 @@ struct window_surface *create_surface( Window window, const XVisualInfo *vis, co
     if (vis->depth == 32 && !surface->is_argb)
         surface->alpha_bits = ~(vis->red_mask | vis->green_mask | vis->blue_mask);
 
-    if (surface->byteswap || format->bits_per_pixel == 4 || format->bits_per_pixel == 8)
+    if (surface->byteswap || format->bits_per_pixel == 4 || format->bits_per_pixel == 8
+#ifdef HAVE_LIBXXSHM
+        || surface->back_image
+#endif
+        )
     {
-        /* allocate separate surface bits if byte swapping or palette mapping is required */
+        /* allocate separate surface bits if byte swapping or palette mapping is required,
+         * or if the images are double buffered */
         if (!(surface->bits  = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
                                           surface->info.bmiHeader.biSizeImage )))
             goto failed;
     }
     else surface->bits = surface->image->data;
 
+    if (format->bits_per_pixel >= 16)
+    {
+        surface->tiles_x = (width + DAMAGE_TILE_WIDTH - 1) / DAMAGE_TILE_WIDTH;
+        surface->tiles_y = (height + DAMAGE_TILE_HEIGHT - 1) / DAMAGE_TILE_HEIGHT;
+        surface->tile_hashes = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                                          surface->tiles_x * surface->tiles_y * sizeof(*surface->tile_hashes) );
+    }
+
     TRACE( "created %p for %lx %s bits %p-%p image %p\n", surface, window, wine_dbgstr_rect(rect),
            surface->bits, (char *)surface->bits + surface->info.bmiHeader.biSizeImage,
            surface->image->data );
@@ -2095,6 +2318,7 @@ HRGN expose_surface( struct window_surface *window_surface, const RECT *rect )
 
     window_surface->funcs->lock( window_surface );
     add_bounds_rect( &surface->bounds, rect );
+    invalidate_tiles( surface, rect );
     if (surface->region)
     {
         region = CreateRectRgnIndirect( rect );
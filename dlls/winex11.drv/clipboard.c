@@ -1588,14 +1588,17 @@ static BOOL export_timestamp( Display *display, Window win, Atom prop, Atom targ
 
 /**************************************************************************
  *		X11DRV_CLIPBOARD_GetProperty
- *  Gets type, data and size.
+ *  Gets type and data, and appends the data to the buffer.
+ *
+ * The buffer grows geometrically, so that INCR transfers can be accumulated
+ * chunk by chunk without keeping a separate copy of each chunk.
  */
 static BOOL X11DRV_CLIPBOARD_GetProperty(Display *display, Window w, Atom prop,
     Atom *atype, unsigned char** data, unsigned long* datasize)
 {
     int aformat;
-    unsigned long pos = 0, nitems, remain, count;
-    unsigned char *val = NULL, *buffer;
+    unsigned long pos = 0, nitems, remain, count, alloc;
+    unsigned char *val = *data, *buffer;
 
     for (;;)
     {
@@ -1603,31 +1606,30 @@ static BOOL X11DRV_CLIPBOARD_GetProperty(Display *display, Window w, Atom prop,
                                AnyPropertyType, atype, &aformat, &nitems, &remain, &buffer))
         {
             WARN("Failed to read property\n");
-            HeapFree( GetProcessHeap(), 0, val );
             return FALSE;
         }
 
         count = get_property_size( aformat, nitems );
-        if (!val) *data = HeapAlloc( GetProcessHeap(), 0, pos * sizeof(int) + count + 1 );
-        else *data = HeapReAlloc( GetProcessHeap(), 0, val, pos * sizeof(int) + count + 1 );
-
-        if (!*data)
+        alloc = val ? HeapSize( GetProcessHeap(), 0, val ) : 0;
+        if (*datasize + count + 1 > alloc)
         {
-            XFree( buffer );
-            HeapFree( GetProcessHeap(), 0, val );
-            return FALSE;
+            alloc = max( *datasize + count + 1, alloc * 2 );
+            if (!val) val = HeapAlloc( GetProcessHeap(), 0, alloc );
+            else val = HeapReAlloc( GetProcessHeap(), 0, *data, alloc );
+            if (!val)
+            {
+                XFree( buffer );
+                return FALSE;
+            }
+            *data = val;
         }
-        val = *data;
-        memcpy( (int *)val + pos, buffer, count );
+        memcpy( val + *datasize, buffer, count );
+        *datasize += count;
         XFree( buffer );
-        if (!remain)
-        {
-            *datasize = pos * sizeof(int) + count;
-            val[*datasize] = 0;
-            break;
-        }
+        if (!remain) break;
         pos += count / sizeof(int);
     }
+    val[*datasize] = 0;
 
     TRACE( "got property %s type %s format %u len %lu from window %lx\n",
            debugstr_xatom( prop ), debugstr_xatom( *atype ), aformat, *datasize, w );
@@ -1639,12 +1641,6 @@ static BOOL X11DRV_CLIPBOARD_GetProperty(Display *display, Window w, Atom prop,
 }
 
 
-struct clipboard_data_packet {
-    struct list entry;
-    unsigned long size;
-    unsigned char *data;
-};
-
 /**************************************************************************
  *		read_property
  *
@@ -1655,6 +1651,9 @@ static BOOL read_property( Display *display, Window w, Atom prop,
 {
     XEvent xe;
 
+    *data = NULL;
+    *datasize = 0;
+
     if (prop == None)
         return FALSE;
 
@@ -1662,26 +1661,23 @@ static BOOL read_property( Display *display, Window w, Atom prop,
         ;
 
     if (!X11DRV_CLIPBOARD_GetProperty(display, w, prop, type, data, datasize))
-        return FALSE;
+        goto failed;
 
     if (*type == x11drv_atom(INCR))
     {
         unsigned char *buf;
-        unsigned long bufsize = 0;
-        struct list packets;
-        struct clipboard_data_packet *packet, *packet2;
-        BOOL res;
-
-        HeapFree(GetProcessHeap(), 0, *data);
-        *data = NULL;
+        unsigned long hint = 0;
 
-        list_init(&packets);
+        /* the INCR property holds a lower bound of the data size, use it to
+         * size the buffer that the chunks are appended to as they arrive */
+        if (*datasize >= sizeof(long)) hint = min( *(unsigned long *)*data, 64 * 1024 * 1024 );
+        if (hint && (buf = HeapReAlloc( GetProcessHeap(), 0, *data, hint + 1 ))) *data = buf;
+        *datasize = 0;
 
         for (;;)
         {
+            unsigned long prev_size = *datasize;
             int i;
-            unsigned char *prop_data;
-            unsigned long prop_size;
 
             /* Wait until PropertyNotify is received */
             for (i = 0; i < SELECTION_RETRIES; i++)
@@ -1696,63 +1692,20 @@ static BOOL read_property( Display *display, Window w, Atom prop,
             }
 
             if (i >= SELECTION_RETRIES ||
-                !X11DRV_CLIPBOARD_GetProperty(display, w, prop, type, &prop_data, &prop_size))
-            {
-                res = FALSE;
-                break;
-            }
+                !X11DRV_CLIPBOARD_GetProperty(display, w, prop, type, data, datasize))
+                goto failed;
 
             /* Retrieved entire data. */
-            if (prop_size == 0)
-            {
-                HeapFree(GetProcessHeap(), 0, prop_data);
-                res = TRUE;
-                break;
-            }
-
-            packet = HeapAlloc(GetProcessHeap(), 0, sizeof(*packet));
-            if (!packet)
-            {
-                HeapFree(GetProcessHeap(), 0, prop_data);
-                res = FALSE;
-                break;
-            }
-
-            packet->size = prop_size;
-            packet->data = prop_data;
-            list_add_tail(&packets, &packet->entry);
-            bufsize += prop_size;
+            if (*datasize == prev_size) break;
         }
-
-        if (res)
-        {
-            buf = HeapAlloc(GetProcessHeap(), 0, bufsize + 1);
-            if (buf)
-            {
-                unsigned long bytes_copied = 0;
-                *datasize = bufsize;
-                LIST_FOR_EACH_ENTRY( packet, &packets, struct clipboard_data_packet, entry)
-                {
-                    memcpy(&buf[bytes_copied], packet->data, packet->size);
-                    bytes_copied += packet->size;
-                }
-                buf[bufsize] = 0;
-                *data = buf;
-            }
-            else
-                res = FALSE;
-        }
-
-        LIST_FOR_EACH_ENTRY_SAFE( packet, packet2, &packets, struct clipboard_data_packet, entry)
-        {
-            HeapFree(GetProcessHeap(), 0, packet->data);
-            HeapFree(GetProcessHeap(), 0, packet);
-        }
-
-        return res;
     }
 
     return TRUE;
+
+failed:
+    HeapFree( GetProcessHeap(), 0, *data );
+    *data = NULL;
+    return FALSE;
 }
 
 
@@ -371,6 +371,27 @@ static enum event_merge_action merge_events( XEvent *prev, XEvent *next )
 }
 
 
+/***********************************************************************
+ *           is_motion_event
+ *
+ * Check for the events that only queue a mouse motion.
+ */
+static inline BOOL is_motion_event( const XEvent *event )
+{
+    switch (event->type)
+    {
+    case MotionNotify:
+    case EnterNotify:
+        return TRUE;
+#ifdef HAVE_X11_EXTENSIONS_XINPUT2_H
+    case GenericEvent:
+        return (event->xcookie.extension == xinput2_opcode && event->xcookie.evtype == XI_RawMotion);
+#endif
+    }
+    return FALSE;
+}
+
+
 /***********************************************************************
  *           call_event_handler
  */
@@ -394,6 +415,8 @@ static inline BOOL call_event_handler( Display *display, XEvent *event )
     TRACE( "%lu %s for hwnd/window %p/%lx\n",
            event->xany.serial, dbgstr_event( event->type ), hwnd, event->xany.window );
     thread_data = x11drv_thread_data();
+    /* queued motions must be sent before anything else is processed */
+    if (!is_motion_event( event )) flush_pending_input( thread_data );
     prev = thread_data->current_event;
     thread_data->current_event = event;
     ret = handlers[event->type]( hwnd, event );
@@ -467,6 +490,7 @@ static BOOL process_events( Display *display, Bool (*filter)(Display*, XEvent*,X
     }
     if (prev_event.type) queued |= call_event_handler( display, &prev_event );
     free_event_data( &prev_event );
+    flush_pending_input( x11drv_thread_data() );
     XFlush( gdi_display );
     if (count) TRACE( "processed %d events, returning %d\n", count, queued );
     return queued;
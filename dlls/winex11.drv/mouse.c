@@ -554,6 +554,85 @@ static BOOL is_old_motion_event( unsigned long serial )
 }
 
 
+/***********************************************************************
+ *		flush_pending_input
+ *
+ * Send the mouse motions queued by queue_mouse_motion.
+ */
+void flush_pending_input( struct x11drv_thread_data *data )
+{
+    UINT count = data->pending_input_count;
+
+    if (!count) return;
+    data->pending_input_count = 0;
+    if (count == 1) __wine_send_input( data->pending_hwnds[0], &data->pending_inputs[0] );
+    else
+    {
+        TRACE( "sending %u queued motions\n", count );
+        __wine_send_inputs( data->pending_hwnds, data->pending_inputs, count );
+    }
+}
+
+/***********************************************************************
+ *		queue_mouse_motion
+ *
+ * Queue a mouse motion while processing a batch of X events, so that the
+ * motions can be sent in a single server call. Consecutive motions of the
+ * same kind are merged.
+ */
+static void queue_mouse_motion( HWND hwnd, const INPUT *input )
+{
+    struct x11drv_thread_data *data = x11drv_thread_data();
+    INPUT *last;
+
+    if (!data->current_event)
+    {
+        __wine_send_input( hwnd, input );
+        return;
+    }
+
+    if (data->pending_input_count)
+    {
+        last = &data->pending_inputs[data->pending_input_count - 1];
+        if (data->pending_hwnds[data->pending_input_count - 1] == hwnd &&
+            last->u.mi.dwFlags == input->u.mi.dwFlags && !last->u.mi.dwExtraInfo)
+        {
+            if (input->u.mi.dwFlags & MOUSEEVENTF_ABSOLUTE)
+            {
+                last->u.mi.dx = input->u.mi.dx;
+                last->u.mi.dy = input->u.mi.dy;
+            }
+            else
+            {
+                last->u.mi.dx += input->u.mi.dx;
+                last->u.mi.dy += input->u.mi.dy;
+            }
+            last->u.mi.time = input->u.mi.time;
+            return;
+        }
+    }
+
+    if (data->pending_input_count == sizeof(data->pending_inputs) / sizeof(data->pending_inputs[0]))
+        flush_pending_input( data );
+    data->pending_hwnds[data->pending_input_count] = hwnd;
+    data->pending_inputs[data->pending_input_count++] = *input;
+}
+
+/* plain motions can be queued, anything else must be sent right away */
+static inline void send_or_queue_input( HWND hwnd, const INPUT *input )
+{
+    if (input->u.mi.dwFlags == (MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE) ||
+        input->u.mi.dwFlags == MOUSEEVENTF_MOVE)
+        queue_mouse_motion( hwnd, input );
+    else
+    {
+        struct x11drv_thread_data *data = x11drv_thread_data();
+
+        if (data) flush_pending_input( data );
+        __wine_send_input( hwnd, input );
+    }
+}
+
 /***********************************************************************
  *		send_mouse_input
  *
@@ -581,7 +660,7 @@ static void send_mouse_input( HWND hwnd, Window window, unsigned int state, INPU
         }
         input->u.mi.dx += clip_rect.left;
         input->u.mi.dy += clip_rect.top;
-        __wine_send_input( hwnd, input );
+        send_or_queue_input( hwnd, input );
         return;
     }
 
@@ -643,7 +722,7 @@ static void send_mouse_input( HWND hwnd, Window window, unsigned int state, INPU
 
     input->u.mi.dx = pt.x;
     input->u.mi.dy = pt.y;
-    __wine_send_input( hwnd, input );
+    send_or_queue_input( hwnd, input );
 }
 
 #ifdef SONAME_LIBXCURSOR
@@ -1787,7 +1866,7 @@ static BOOL X11DRV_RawMotion( XGenericEventCookie *xev )
     TRACE( "pos %d,%d (event %f,%f)\n", input.u.mi.dx, input.u.mi.dy, dx, dy );
 
     input.type = INPUT_MOUSE;
-    __wine_send_input( 0, &input );
+    queue_mouse_motion( 0, &input );
     return TRUE;
 }
 
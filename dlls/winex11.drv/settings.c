@@ -47,6 +47,7 @@ static const unsigned int depths_32[]  = {8, 16, 32};
 /* pointers to functions that actually do the hard stuff */
 static int (*pGetCurrentMode)(void);
 static LONG (*pSetCurrentMode)(int mode);
+static void (*pRefreshModes)(void);
 static const char *handler_name;
 
 /*
@@ -62,6 +63,7 @@ struct x11drv_mode_info *X11DRV_Settings_SetHandlers(const char *name,
     handler_name = name;
     pGetCurrentMode = pNewGCM;
     pSetCurrentMode = pNewSCM;
+    pRefreshModes = NULL;
     TRACE("Resolution settings now handled by: %s\n", name);
     if (reserve_depths)
         /* leave room for other depths */
@@ -80,6 +82,15 @@ struct x11drv_mode_info *X11DRV_Settings_SetHandlers(const char *name,
     return dd_modes;
 }
 
+/*
+ * Set the function that rebuilds the mode list if the display configuration
+ * changed; it is called before the list is used.
+ */
+void X11DRV_Settings_SetRefreshHandler(void (*refresh)(void))
+{
+    pRefreshModes = refresh;
+}
+
 /* Add one mode to the master list */
 void X11DRV_Settings_AddOneMode(unsigned int width, unsigned int height, unsigned int bpp, unsigned int freq)
 {
@@ -273,6 +284,8 @@ BOOL CDECL X11DRV_EnumDisplaySettingsEx( LPCWSTR name, DWORD n, LPDEVMODEW devmo
     devmode->u1.s2.dmDisplayOrientation = 0;
     devmode->u1.s2.dmDisplayFixedOutput = 0;
 
+    if (pRefreshModes) pRefreshModes();
+
     if (n == ENUM_CURRENT_SETTINGS)
     {
         TRACE("mode %d (current) -- getting current mode (%s)\n", n, handler_name);
@@ -348,6 +361,9 @@ LONG CDECL X11DRV_ChangeDisplaySettingsEx( LPCWSTR devname, LPDEVMODEW devmode,
 
     TRACE("(%s,%p,%p,0x%08x,%p)\n",debugstr_w(devname),devmode,hwnd,flags,lpvoid);
     TRACE("flags=%s\n",_CDS_flags(flags));
+
+    if (pRefreshModes) pRefreshModes();
+
     if (devmode)
     {
         /* this is the minimal dmSize that XP accepts */
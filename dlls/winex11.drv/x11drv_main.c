@@ -80,6 +80,7 @@ int primary_monitor = 0;
 BOOL client_side_graphics = TRUE;
 BOOL client_side_with_render = TRUE;
 BOOL shape_layered_windows = TRUE;
+BOOL use_shm_double_buffer = TRUE;
 int copy_default_colors = 128;
 int alloc_system_colors = 256;
 DWORD thread_data_tls_index = TLS_OUT_OF_INDEXES;
@@ -401,6 +402,9 @@ static void setup_options(void)
     if (!get_config_key( hkey, appkey, "ShapeLayeredWindows", buffer, sizeof(buffer) ))
         shape_layered_windows = IS_OPTION_TRUE( buffer[0] );
 
+    if (!get_config_key( hkey, appkey, "ShmDoubleBuffer", buffer, sizeof(buffer) ))
+        use_shm_double_buffer = IS_OPTION_TRUE( buffer[0] );
+
     if (!get_config_key( hkey, appkey, "PrivateColorMap", buffer, sizeof(buffer) ))
         private_color_map = IS_OPTION_TRUE( buffer[0] );
 
@@ -46,6 +46,7 @@ MAKE_FUNCPTR(XRRGetScreenInfo)
 MAKE_FUNCPTR(XRRQueryExtension)
 MAKE_FUNCPTR(XRRQueryVersion)
 MAKE_FUNCPTR(XRRRates)
+MAKE_FUNCPTR(XRRSelectInput)
 MAKE_FUNCPTR(XRRSetScreenConfig)
 MAKE_FUNCPTR(XRRSetScreenConfigAndRate)
 MAKE_FUNCPTR(XRRSizes)
@@ -60,6 +61,7 @@ MAKE_FUNCPTR(XRRGetScreenResources)
 MAKE_FUNCPTR(XRRSetCrtcConfig)
 static typeof(XRRGetScreenResources) *pXRRGetScreenResourcesCurrent;
 static RRMode *xrandr12_modes;
+static XRRScreenResources *xrandr12_resources;  /* cached until the configuration changes */
 static int primary_crtc;
 #endif
 
@@ -69,6 +71,7 @@ static struct x11drv_mode_info *dd_modes;
 static SizeID *xrandr10_modes;
 static unsigned int xrandr_mode_count;
 static int xrandr_current_mode = -1;
+static int xrandr_event_base;
 
 static int load_xrandr(void)
 {
@@ -89,6 +92,7 @@ static int load_xrandr(void)
         LOAD_FUNCPTR(XRRQueryExtension)
         LOAD_FUNCPTR(XRRQueryVersion)
         LOAD_FUNCPTR(XRRRates)
+        LOAD_FUNCPTR(XRRSelectInput)
         LOAD_FUNCPTR(XRRSetScreenConfig)
         LOAD_FUNCPTR(XRRSetScreenConfigAndRate)
         LOAD_FUNCPTR(XRRSizes)
@@ -192,6 +196,8 @@ static LONG xrandr10_set_current_mode( int mode )
     return DISP_CHANGE_FAILED;
 }
 
+static void xrandr_refresh_modes(void);
+
 static void xrandr10_init_modes(void)
 {
     XRRScreenSize *sizes;
@@ -264,6 +270,7 @@ static void xrandr10_init_modes(void)
     }
 
     X11DRV_Settings_AddDepthModes();
+    X11DRV_Settings_SetRefreshHandler( xrandr_refresh_modes );
     nmodes = X11DRV_Settings_GetModeCount();
 
     TRACE("Available DD modes: count=%d\n", nmodes);
@@ -272,6 +279,19 @@ static void xrandr10_init_modes(void)
 
 #ifdef HAVE_XRRGETSCREENRESOURCES
 
+static XRRScreenResources *xrandr12_get_resources(void)
+{
+    if (!xrandr12_resources)
+        xrandr12_resources = pXRRGetScreenResourcesCurrent( gdi_display, root_window );
+    return xrandr12_resources;
+}
+
+static void xrandr12_free_resources(void)
+{
+    if (xrandr12_resources) pXRRFreeScreenResources( xrandr12_resources );
+    xrandr12_resources = NULL;
+}
+
 static int xrandr12_get_current_mode(void)
 {
     XRRScreenResources *resources;
@@ -281,7 +301,7 @@ static int xrandr12_get_current_mode(void)
     if (xrandr_current_mode != -1)
         return xrandr_current_mode;
 
-    if (!(resources = pXRRGetScreenResourcesCurrent( gdi_display, root_window )))
+    if (!(resources = xrandr12_get_resources()))
     {
         ERR("Failed to get screen resources.\n");
         return 0;
@@ -290,7 +310,6 @@ static int xrandr12_get_current_mode(void)
     if (resources->ncrtc <= primary_crtc ||
         !(crtc_info = pXRRGetCrtcInfo( gdi_display, resources, resources->crtcs[primary_crtc] )))
     {
-        pXRRFreeScreenResources( resources );
         ERR("Failed to get CRTC info.\n");
         return 0;
     }
@@ -308,7 +327,6 @@ static int xrandr12_get_current_mode(void)
     }
 
     pXRRFreeCrtcInfo( crtc_info );
-    pXRRFreeScreenResources( resources );
 
     if (ret == -1)
     {
@@ -328,7 +346,7 @@ static LONG xrandr12_set_current_mode( int mode )
 
     mode = mode % xrandr_mode_count;
 
-    if (!(resources = pXRRGetScreenResourcesCurrent( gdi_display, root_window )))
+    if (!(resources = xrandr12_get_resources()))
     {
         ERR("Failed to get screen resources.\n");
         return DISP_CHANGE_FAILED;
@@ -337,7 +355,6 @@ static LONG xrandr12_set_current_mode( int mode )
     if (resources->ncrtc <= primary_crtc ||
         !(crtc_info = pXRRGetCrtcInfo( gdi_display, resources, resources->crtcs[primary_crtc] )))
     {
-        pXRRFreeScreenResources( resources );
         ERR("Failed to get CRTC info.\n");
         return DISP_CHANGE_FAILED;
     }
@@ -350,11 +367,11 @@ static LONG xrandr12_set_current_mode( int mode )
                                 crtc_info->rotation, crtc_info->outputs, crtc_info->noutput );
 
     pXRRFreeCrtcInfo( crtc_info );
-    pXRRFreeScreenResources( resources );
 
     if (status != RRSetConfigSuccess)
     {
         ERR("Resolution change not successful -- perhaps display has changed?\n");
+        xrandr12_free_resources();
         return DISP_CHANGE_FAILED;
     }
 
@@ -399,6 +416,7 @@ static int xrandr12_init_modes(void)
         return ret;
     }
 
+    /* the cached resources don't list any CRTC until the outputs have been probed once */
     if (!resources->ncrtc)
     {
         pXRRFreeScreenResources( resources );
@@ -489,10 +507,12 @@ static int xrandr12_init_modes(void)
                        "Please consider using the Nouveau driver instead.\n");
         ret = -1;
         HeapFree( GetProcessHeap(), 0, xrandr12_modes );
+        xrandr12_modes = NULL;
         goto done;
     }
 
     X11DRV_Settings_AddDepthModes();
+    X11DRV_Settings_SetRefreshHandler( xrandr_refresh_modes );
     ret = 0;
 
 done:
@@ -504,9 +524,41 @@ done:
 
 #endif /* HAVE_XRRGETSCREENRESOURCES */
 
+/* check for screen change notifications, rebuild the mode list if there are any */
+static void xrandr_refresh_modes(void)
+{
+    XEvent event;
+    BOOL changed = FALSE;
+
+    while (XCheckTypedEvent( gdi_display, xrandr_event_base + RRScreenChangeNotify, &event ))
+        changed = TRUE;
+#ifdef HAVE_XRRGETSCREENRESOURCES
+    while (XCheckTypedEvent( gdi_display, xrandr_event_base + RRNotify, &event ))
+        changed = TRUE;
+#endif
+    if (!changed) return;
+
+    TRACE("Screen configuration changed, rebuilding mode list.\n");
+    xrandr_current_mode = -1;
+
+#ifdef HAVE_XRRGETSCREENRESOURCES
+    if (xrandr12_modes)
+    {
+        xrandr12_free_resources();
+        HeapFree( GetProcessHeap(), 0, xrandr12_modes );
+        xrandr12_modes = NULL;
+        if (xrandr12_init_modes() >= 0) return;
+    }
+#endif
+    HeapFree( GetProcessHeap(), 0, xrandr10_modes );
+    xrandr10_modes = NULL;
+    xrandr10_init_modes();
+    if (!xrandr10_modes) X11DRV_Settings_Init();
+}
+
 void X11DRV_XRandR_Init(void)
 {
-    int event_base, error_base, minor, ret;
+    int event_base, error_base, minor, ret, mask;
     static int major;
     Bool ok;
 
@@ -523,6 +575,14 @@ void X11DRV_XRandR_Init(void)
 
     TRACE("Found XRandR %d.%d.\n", major, minor);
 
+    /* the notifications are only checked for, never dispatched, when the modes are queried */
+    xrandr_event_base = event_base;
+    mask = RRScreenChangeNotifyMask;
+#ifdef HAVE_XRRGETSCREENRESOURCES
+    if (major > 1 || (major == 1 && minor >= 2)) mask |= RRCrtcChangeNotifyMask | RROutputChangeNotifyMask;
+#endif
+    pXRRSelectInput( gdi_display, root_window, mask );
+
 #ifdef HAVE_XRRGETSCREENRESOURCES
     if (ret >= 2 && (major > 1 || (major == 1 && minor >= 2)))
     {
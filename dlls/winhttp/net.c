@@ -343,7 +343,8 @@ netconn_t *netconn_create( hostdata_t *host, const struct sockaddr_storage *sock
     {
         WARN("unable to connect to host (%d)\n", res);
         set_last_error( res );
-        netconn_close( conn );
+        closesocket( conn->socket );
+        heap_free( conn );
         return NULL;
     }
     return conn;
@@ -361,7 +362,7 @@ BOOL netconn_close( netconn_t *conn )
         DeleteSecurityContext(&conn->ssl_ctx);
     }
     res = closesocket( conn->socket );
-    release_host( conn->host );
+    release_host_connection( conn->host );
     heap_free(conn);
     if (res == -1)
     {
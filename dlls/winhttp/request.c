@@ -1530,9 +1530,40 @@ void release_host( hostdata_t *host )
 
     assert( list_empty( &host->connections ) );
     heap_free( host->hostname );
+    heap_free( host->tunnel_host );
     heap_free( host );
 }
 
+/* called when a connection to the host is closed, frees up a slot for waiting requests */
+void release_host_connection( hostdata_t *host )
+{
+    EnterCriticalSection( &connection_pool_cs );
+    host->conns--;
+    WakeAllConditionVariable( &host->cond );
+    LeaveCriticalSection( &connection_pool_cs );
+    release_host( host );
+}
+
+/* idle connections hold on to the session credentials, close them along with the session */
+void close_session_connections( session_t *session )
+{
+    netconn_t *netconn, *next_netconn;
+    hostdata_t *host, *next_host;
+
+    EnterCriticalSection( &connection_pool_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( host, next_host, &connection_pool, hostdata_t, entry )
+    {
+        if (host->session != session) continue;
+        LIST_FOR_EACH_ENTRY_SAFE( netconn, next_netconn, &host->connections, netconn_t, entry )
+        {
+            TRACE("freeing %p\n", netconn);
+            list_remove( &netconn->entry );
+            netconn_close( netconn );
+        }
+    }
+    LeaveCriticalSection( &connection_pool_cs );
+}
+
 static BOOL connection_collector_running;
 
 static DWORD WINAPI connection_collector(void *arg)
@@ -1584,6 +1615,7 @@ static void cache_connection( netconn_t *netconn )
 
     netconn->keep_until = GetTickCount64() + DEFAULT_KEEP_ALIVE_TIMEOUT;
     list_add_head( &netconn->host->connections, &netconn->entry );
+    WakeAllConditionVariable( &netconn->host->cond );
 
     if (!connection_collector_running)
     {
@@ -1638,26 +1670,53 @@ static BOOL ensure_cred_handle( session_t *session )
     return TRUE;
 }
 
+static BOOL host_matches( const hostdata_t *host, const session_t *session, const WCHAR *hostname,
+                          INTERNET_PORT port, BOOL secure, const WCHAR *tunnel_host,
+                          INTERNET_PORT tunnel_port, DWORD security_flags )
+{
+    if (host->session != session || host->port != port || !host->secure != !secure) return FALSE;
+    if (strcmpW( host->hostname, hostname )) return FALSE;
+    if (host->security_flags != security_flags || host->tunnel_port != tunnel_port) return FALSE;
+    if (!host->tunnel_host || !tunnel_host) return host->tunnel_host == tunnel_host;
+    return !strcmpiW( host->tunnel_host, tunnel_host );
+}
+
 static BOOL open_connection( request_t *request )
 {
     BOOL is_secure = request->hdr.flags & WINHTTP_FLAG_SECURE;
     hostdata_t *host = NULL, *iter;
     netconn_t *netconn = NULL;
     connect_t *connect;
-    WCHAR *addressW = NULL;
-    INTERNET_PORT port;
-    DWORD len;
+    session_t *session;
+    WCHAR *addressW = NULL, *tunnel_host = NULL;
+    INTERNET_PORT port, tunnel_port = 0;
+    DWORD len, security_flags = 0, max_conns, timeout;
 
     if (request->netconn) goto done;
 
     connect = request->connect;
+    session = connect->session;
     port = connect->serverport ? connect->serverport : (request->hdr.flags & WINHTTP_FLAG_SECURE ? 443 : 80);
+    if (is_secure)
+    {
+        /* secure connections are bound to the certificate checks they were set up with */
+        security_flags = request->security_flags & (SECURITY_FLAG_IGNORE_UNKNOWN_CA |
+                                                    SECURITY_FLAG_IGNORE_CERT_DATE_INVALID |
+                                                    SECURITY_FLAG_IGNORE_CERT_CN_INVALID |
+                                                    SECURITY_FLAG_IGNORE_CERT_WRONG_USAGE);
+        if (session->proxy_server && strcmpiW( connect->hostname, connect->servername ))
+        {
+            tunnel_host = connect->hostname;
+            tunnel_port = connect->hostport;
+        }
+    }
 
     EnterCriticalSection( &connection_pool_cs );
 
     LIST_FOR_EACH_ENTRY( iter, &connection_pool, hostdata_t, entry )
     {
-        if (iter->port == port && !strcmpW( connect->servername, iter->hostname ) && !is_secure == !iter->secure)
+        if (host_matches( iter, session, connect->servername, port, is_secure, tunnel_host, tunnel_port,
+                          security_flags ))
         {
             host = iter;
             host->ref++;
@@ -1667,18 +1726,24 @@ static BOOL open_connection( request_t *request )
 
     if (!host)
     {
-        if ((host = heap_alloc( sizeof(*host) )))
+        if ((host = heap_alloc_zero( sizeof(*host) )))
         {
             host->ref = 1;
+            host->session = session;
             host->secure = is_secure;
             host->port = port;
+            host->tunnel_port = tunnel_port;
+            host->security_flags = security_flags;
+            InitializeConditionVariable( &host->cond );
             list_init( &host->connections );
-            if ((host->hostname = strdupW( connect->servername )))
+            if ((host->hostname = strdupW( connect->servername )) &&
+                (!tunnel_host || (host->tunnel_host = strdupW( tunnel_host ))))
             {
                 list_add_head( &connection_pool, &host->entry );
             }
             else
             {
+                heap_free( host->hostname );
                 heap_free( host );
                 host = NULL;
             }
@@ -1689,14 +1754,28 @@ static BOOL open_connection( request_t *request )
 
     if (!host) return FALSE;
 
+    max_conns = session->max_conns_per_server;
+    timeout = request->connect_timeout > 0 ? request->connect_timeout : INFINITE;
     for (;;)
     {
         EnterCriticalSection( &connection_pool_cs );
+        while (list_empty( &host->connections ) && host->conns >= max_conns)
+        {
+            TRACE("waiting for a connection to %s:%u\n", debugstr_w(host->hostname), port);
+            if (!SleepConditionVariableCS( &host->cond, &connection_pool_cs, timeout ))
+            {
+                LeaveCriticalSection( &connection_pool_cs );
+                release_host( host );
+                set_last_error( ERROR_WINHTTP_TIMEOUT );
+                return FALSE;
+            }
+        }
         if (!list_empty( &host->connections ))
         {
             netconn = LIST_ENTRY( list_head( &host->connections ), netconn_t, entry );
             list_remove( &netconn->entry );
         }
+        else host->conns++;  /* reserve a slot for the new connection */
         LeaveCriticalSection( &connection_pool_cs );
         if (!netconn) break;
 
@@ -1719,14 +1798,14 @@ static BOOL open_connection( request_t *request )
 
         if (!netconn_resolve( host->hostname, port, &connect->sockaddr, request->resolve_timeout ))
         {
-            release_host( host );
+            release_host_connection( host );
             return FALSE;
         }
         connect->resolved = TRUE;
 
         if (!(addressW = addr_to_str( &connect->sockaddr )))
         {
-            release_host( host );
+            release_host_connection( host );
             return FALSE;
         }
         len = strlenW( addressW ) + 1;
@@ -1737,7 +1816,7 @@ static BOOL open_connection( request_t *request )
     {
         if (!addressW && !(addressW = addr_to_str( &connect->sockaddr )))
         {
-            release_host( host );
+            release_host_connection( host );
             return FALSE;
         }
 
@@ -1748,7 +1827,7 @@ static BOOL open_connection( request_t *request )
         if (!(netconn = netconn_create( host, &connect->sockaddr, request->connect_timeout )))
         {
             heap_free( addressW );
-            release_host( host );
+            release_host_connection( host );
             return FALSE;
         }
         netconn_set_timeout( netconn, TRUE, request->send_timeout );
@@ -1758,12 +1837,15 @@ static BOOL open_connection( request_t *request )
             if (connect->session->proxy_server &&
                 strcmpiW( connect->hostname, connect->servername ))
             {
+                request->netconn = netconn;
                 if (!secure_proxy_connect( request ))
                 {
+                    request->netconn = NULL;
                     heap_free( addressW );
                     netconn_close( netconn );
                     return FALSE;
                 }
+                request->netconn = NULL;
             }
             if (!ensure_cred_handle( connect->session ) ||
                 !netconn_secure_connect( netconn, connect->hostname, request->security_flags,
@@ -2127,7 +2209,13 @@ static BOOL send_request( request_t *request, LPCWSTR headers, DWORD headers_len
 
     send_callback( &request->hdr, WINHTTP_CALLBACK_STATUS_SENDING_REQUEST, NULL, 0 );
 
-    ret = netconn_send( request->netconn, req_ascii, len, &bytes_sent );
+    while (!(ret = netconn_send( request->netconn, req_ascii, len, &bytes_sent )) && request->netconn->keep_until)
+    {
+        /* the server may have dropped a pooled connection while it was idle, retry on another one */
+        TRACE("send on reused connection %p failed, retrying\n", request->netconn);
+        close_connection( request );
+        if (!(ret = open_connection( request ))) break;
+    }
     heap_free( req_ascii );
     if (!ret) goto end;
 
@@ -99,6 +99,7 @@ static void session_destroy( object_header_t *hdr )
     TRACE("%p\n", session);
 
     if (session->unload_event) SetEvent( session->unload_event );
+    close_session_connections( session );
     if (session->cred_handle_initialized) FreeCredentialsHandle( &session->cred_handle );
 
     LIST_FOR_EACH_SAFE( item, next, &session->cookie_cache )
@@ -149,6 +150,20 @@ static BOOL session_query_option( object_header_t *hdr, DWORD option, LPVOID buf
         *(DWORD *)buffer = session->recv_timeout;
         *buflen = sizeof(DWORD);
         return TRUE;
+    case WINHTTP_OPTION_MAX_CONNS_PER_SERVER:
+    case WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER:
+        if (!buffer || *buflen < sizeof(DWORD))
+        {
+            *buflen = sizeof(DWORD);
+            set_last_error( ERROR_INSUFFICIENT_BUFFER );
+            return FALSE;
+        }
+        if (option == WINHTTP_OPTION_MAX_CONNS_PER_SERVER)
+            *(DWORD *)buffer = session->max_conns_per_server;
+        else
+            *(DWORD *)buffer = session->max_conns_per_1_0_server;
+        *buflen = sizeof(DWORD);
+        return TRUE;
     default:
         FIXME("unimplemented option %u\n", option);
         set_last_error( ERROR_INVALID_PARAMETER );
@@ -218,10 +233,27 @@ static BOOL session_set_option( object_header_t *hdr, DWORD option, LPVOID buffe
         session->unload_event = *(HANDLE *)buffer;
         return TRUE;
     case WINHTTP_OPTION_MAX_CONNS_PER_SERVER:
-        FIXME("WINHTTP_OPTION_MAX_CONNS_PER_SERVER: %d\n", *(DWORD *)buffer);
-        return TRUE;
     case WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER:
-        FIXME("WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER: %d\n", *(DWORD *)buffer);
+        if (buflen != sizeof(DWORD))
+        {
+            set_last_error( ERROR_INSUFFICIENT_BUFFER );
+            return FALSE;
+        }
+        if (!*(DWORD *)buffer)
+        {
+            set_last_error( ERROR_INVALID_PARAMETER );
+            return FALSE;
+        }
+        if (option == WINHTTP_OPTION_MAX_CONNS_PER_SERVER)
+        {
+            TRACE("WINHTTP_OPTION_MAX_CONNS_PER_SERVER: %u\n", *(DWORD *)buffer);
+            session->max_conns_per_server = *(DWORD *)buffer;
+        }
+        else
+        {
+            TRACE("WINHTTP_OPTION_MAX_CONNS_PER_1_0_SERVER: %u\n", *(DWORD *)buffer);
+            session->max_conns_per_1_0_server = *(DWORD *)buffer;
+        }
         return TRUE;
     default:
         FIXME("unimplemented option %u\n", option);
@@ -259,6 +291,8 @@ HINTERNET WINAPI WinHttpOpen( LPCWSTR agent, DWORD access, LPCWSTR proxy, LPCWST
     session->connect_timeout = DEFAULT_CONNECT_TIMEOUT;
     session->send_timeout = DEFAULT_SEND_TIMEOUT;
     session->recv_timeout = DEFAULT_RECEIVE_TIMEOUT;
+    session->max_conns_per_server = ~0u;
+    session->max_conns_per_1_0_server = ~0u;
     list_init( &session->cookie_cache );
 
     if (agent && !(session->agent = strdupW( agent ))) goto end;
@@ -141,6 +141,19 @@ static void test_QueryOption(void)
     ok(feature == WINHTTP_OPTION_REDIRECT_POLICY_ALWAYS,
        "expected WINHTTP_OPTION_REDIRECT_POLICY_ALWAYS, got %#x\n", feature);
 
+    feature = 4;
+    SetLastError(0xdeadbeef);
+    ret = WinHttpSetOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, sizeof(feature));
+    ok(ret, "failed to set max connections %u\n", GetLastError());
+
+    feature = 0xdeadbeef;
+    size = sizeof(feature);
+    SetLastError(0xdeadbeef);
+    ret = WinHttpQueryOption(session, WINHTTP_OPTION_MAX_CONNS_PER_SERVER, &feature, &size);
+    ok(ret, "failed to query max connections %u\n", GetLastError());
+    ok(feature == 4, "expected 4, got %u\n", feature);
+    ok(size == sizeof(feature), "got %u\n", size);
+
     feature = WINHTTP_DISABLE_COOKIES;
     SetLastError(0xdeadbeef);
     ret = WinHttpSetOption(session, WINHTTP_OPTION_DISABLE_FEATURE, &feature, sizeof(feature));
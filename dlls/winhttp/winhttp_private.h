@@ -97,15 +97,6 @@ typedef struct
     WCHAR *path;
 } cookie_t;
 
-typedef struct {
-    struct list entry;
-    LONG ref;
-    WCHAR *hostname;
-    INTERNET_PORT port;
-    BOOL secure;
-    struct list connections;
-} hostdata_t;
-
 typedef struct
 {
     object_header_t hdr;
@@ -124,8 +115,25 @@ typedef struct
     CredHandle cred_handle;
     BOOL cred_handle_initialized;
     DWORD secure_protocols;
+    DWORD max_conns_per_server;
+    DWORD max_conns_per_1_0_server;
 } session_t;
 
+typedef struct {
+    struct list entry;
+    LONG ref;
+    session_t *session;
+    WCHAR *hostname;
+    INTERNET_PORT port;
+    BOOL secure;
+    WCHAR *tunnel_host;         /* destination of a secure connection through a proxy */
+    INTERNET_PORT tunnel_port;
+    DWORD security_flags;
+    unsigned int conns;         /* open connections, idle ones included */
+    CONDITION_VARIABLE cond;
+    struct list connections;
+} hostdata_t;
+
 typedef struct
 {
     object_header_t hdr;
@@ -319,6 +327,8 @@ BOOL set_server_for_hostname( connect_t *, LPCWSTR, INTERNET_PORT ) DECLSPEC_HID
 void destroy_authinfo( struct authinfo * ) DECLSPEC_HIDDEN;
 
 void release_host( hostdata_t *host ) DECLSPEC_HIDDEN;
+void release_host_connection( hostdata_t *host ) DECLSPEC_HIDDEN;
+void close_session_connections( session_t *session ) DECLSPEC_HIDDEN;
 
 extern HRESULT WinHttpRequest_create( void ** ) DECLSPEC_HIDDEN;
 void release_typelib( void ) DECLSPEC_HIDDEN;
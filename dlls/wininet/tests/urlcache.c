@@ -1100,6 +1100,46 @@ static void test_trailing_slash(void)
     DeleteFileA(filename);
 }
 
+static void test_many_entries(void)
+{
+    static const FILETIME filetime_zero;
+    char url[64], buffer[1024];
+    INTERNET_CACHE_ENTRY_INFOA *info = (INTERNET_CACHE_ENTRY_INFOA *)buffer;
+    DWORD i, size;
+    BOOL ret;
+
+    /* enough entries to need more than one hash table */
+    for (i = 0; i < 600; i++)
+    {
+        sprintf(url, "Visited: http://testing.cache.com/many/%u", i);
+        ret = CommitUrlCacheEntryA(url, NULL, filetime_zero, filetime_zero,
+                NORMAL_CACHE_ENTRY, NULL, 0, NULL, NULL);
+        ok(ret, "CommitUrlCacheEntry(%s) failed with error %d\n", url, GetLastError());
+    }
+
+    for (i = 0; i < 600; i++)
+    {
+        sprintf(url, "Visited: http://testing.cache.com/many/%u", i);
+        size = sizeof(buffer);
+        ret = GetUrlCacheEntryInfoA(url, info, &size);
+        ok(ret, "GetUrlCacheEntryInfo(%s) failed with error %d\n", url, GetLastError());
+        if (ret)
+            ok(!strcmp(info->lpszSourceUrlName, url), "got %s, expected %s\n", info->lpszSourceUrlName, url);
+    }
+
+    for (i = 0; i < 600; i++)
+    {
+        sprintf(url, "Visited: http://testing.cache.com/many/%u", i);
+        ret = DeleteUrlCacheEntryA(url);
+        ok(ret, "DeleteUrlCacheEntry(%s) failed with error %d\n", url, GetLastError());
+    }
+
+    SetLastError(0xdeadbeef);
+    ret = GetUrlCacheEntryInfoA("Visited: http://testing.cache.com/many/0", NULL, NULL);
+    ok(!ret, "GetUrlCacheEntryInfo succeeded\n");
+    ok(GetLastError() == ERROR_FILE_NOT_FOUND, "got %d\n", GetLastError());
+}
+
 START_TEST(urlcache)
 {
     HMODULE hdll;
@@ -1124,4 +1164,5 @@ START_TEST(urlcache)
     test_FindCloseUrlCache();
     test_GetDiskInfoA();
     test_trailing_slash();
+    test_many_entries();
 }
@@ -64,6 +64,7 @@ static const char urlcache_ver[] = "0.2012001";
 #define HASHTABLE_SIZE          448
 #define HASHTABLE_NUM_ENTRIES   64 /* this needs to be power of 2, that divides HASHTABLE_SIZE */
 #define HASHTABLE_BLOCKSIZE     (HASHTABLE_SIZE / HASHTABLE_NUM_ENTRIES)
+#define HASHTABLE_BLOCKS_NO     0x20 /* number of blocks allocated for a hash table */
 #define ALLOCATION_TABLE_OFFSET 0x250
 #define ALLOCATION_TABLE_SIZE   (ENTRY_START_OFFSET - ALLOCATION_TABLE_OFFSET)
 #define MIN_BLOCK_NO            0x80
@@ -160,7 +161,7 @@ typedef struct
     DWORD hash_table_off;
     DWORD capacity_in_blocks;
     DWORD blocks_in_use;
-    DWORD unk1;
+    LONG sequence; /* odd while the index is being modified */
     ULARGE_INTEGER cache_limit;
     ULARGE_INTEGER cache_usage;
     ULARGE_INTEGER exempt_usage;
@@ -187,6 +188,9 @@ typedef struct
     LPWSTR path; /* path to url container directory */
     HANDLE mapping; /* handle of file mapping */
     DWORD file_size; /* size of file when mapping was opened */
+    urlcache_header *view; /* view of the mapping, kept while the mapping is open */
+    SRWLOCK view_lock; /* protects view against lookups done without the mutex */
+    DWORD lock_depth; /* number of nested cache_container_lock_index calls */
     HANDLE mutex; /* handle of mutex */
     DWORD default_entry_type;
 } cache_container;
@@ -282,14 +286,31 @@ static inline void urlcache_block_alloc(BYTE *allocation_table, DWORD block_numb
  */
 static DWORD urlcache_entry_alloc(urlcache_header *header, DWORD blocks_needed, entry_header **entry)
 {
+    const DWORD *words = (const DWORD*)header->allocation_table;
     DWORD block, block_size;
 
     for(block=0; block<header->capacity_in_blocks; block+=block_size+1)
     {
+        /* skip fully allocated words of the table */
+        while(!(block%32) && block+32<=header->capacity_in_blocks && words[block/32]==~0u)
+            block += 32;
+
         block_size = 0;
-        while(block_size<blocks_needed && block_size+block<header->capacity_in_blocks
-                && urlcache_block_is_free(header->allocation_table, block+block_size))
+        while(block_size<blocks_needed && block_size+block<header->capacity_in_blocks)
+        {
+            DWORD next = block+block_size;
+
+            /* whole free words can be taken at once */
+            if(!(next%32) && blocks_needed-block_size>=32 && next+32<=header->capacity_in_blocks
+                    && !words[next/32])
+            {
+                block_size += 32;
+                continue;
+            }
+            if(!urlcache_block_is_free(header->allocation_table, next))
+                break;
             block_size++;
+        }
 
         if(block_size == blocks_needed)
         {
@@ -352,7 +373,7 @@ static DWORD urlcache_create_hash_table(urlcache_header *header, entry_hash_tabl
     DWORD dwOffset, error;
     int i;
 
-    if((error = urlcache_entry_alloc(header, 0x20, (entry_header**)hash_table)) != ERROR_SUCCESS)
+    if((error = urlcache_entry_alloc(header, HASHTABLE_BLOCKS_NO, (entry_header**)hash_table)) != ERROR_SUCCESS)
         return error;
 
     dwOffset = (BYTE*)*hash_table-(BYTE*)header;
@@ -413,6 +434,23 @@ static HANDLE cache_container_map_index(HANDLE file, const WCHAR *path, DWORD si
     return CreateFileMappingW(file, NULL, PAGE_READWRITE, 0, 0, mapping_name);
 }
 
+/***********************************************************************
+ *           urlcache_initial_hash_tables (Internal)
+ *
+ *  Number of hash tables to create with a new index. Each table holds 448
+ * entries, WINEURLCACHEHASHTABLES can be used to size large caches up front
+ * instead of growing the chain of tables as entries are added.
+ */
+static DWORD urlcache_initial_hash_tables(void)
+{
+    const char *env = getenv("WINEURLCACHEHASHTABLES");
+    DWORD count = env ? strtoul(env, NULL, 0) : 0;
+
+    if(!count)
+        return 1;
+    return min(count, (MAX_BLOCK_NO-MIN_BLOCK_NO) / HASHTABLE_BLOCKS_NO);
+}
+
 /* Caller must hold container lock */
 static DWORD cache_container_set_size(cache_container *container, HANDLE file, DWORD blocks_no)
 {
@@ -423,7 +461,8 @@ static DWORD cache_container_set_size(cache_container *container, HANDLE file, D
         'C','a','c','h','e','\\','C','o','n','t','e','n','t',0};
     static const WCHAR cache_limit[] = {'C','a','c','h','e','L','i','m','i','t',0};
 
-    DWORD file_size = FILE_SIZE(blocks_no);
+    BOOL init = (blocks_no == MIN_BLOCK_NO);
+    DWORD file_size, hash_tables = 1;
     WCHAR dir_path[MAX_PATH], *dir_name;
     entry_hash_table *hashtable_entry;
     urlcache_header *header;
@@ -432,6 +471,12 @@ static DWORD cache_container_set_size(cache_container *container, HANDLE file, D
     HKEY key;
     int i, j;
 
+    if(init) {
+        hash_tables = urlcache_initial_hash_tables();
+        blocks_no = max(blocks_no, hash_tables * HASHTABLE_BLOCKS_NO + MIN_BLOCK_NO);
+    }
+    file_size = FILE_SIZE(blocks_no);
+
     if(SetFilePointer(file, file_size, NULL, FILE_BEGIN) == INVALID_SET_FILE_POINTER)
         return GetLastError();
 
@@ -448,7 +493,7 @@ static DWORD cache_container_set_size(cache_container *container, HANDLE file, D
         return GetLastError();
     }
 
-    if(blocks_no != MIN_BLOCK_NO) {
+    if(!init) {
         if(file_size > header->size)
             memset((char*)header+header->size, 0, file_size-header->size);
         header->size = file_size;
@@ -483,6 +528,10 @@ static DWORD cache_container_set_size(cache_container *container, HANDLE file, D
     }
 
     urlcache_create_hash_table(header, NULL, &hashtable_entry);
+    for(i=1; i<hash_tables; i++) {
+        if(urlcache_create_hash_table(header, hashtable_entry, &hashtable_entry) != ERROR_SUCCESS)
+            break;
+    }
 
     /* Last step - create the directories */
     strcpyW(dir_path, container->path);
@@ -684,6 +733,12 @@ static DWORD cache_container_open_index(cache_container *container, DWORD blocks
  */
 static void cache_container_close_index(cache_container *pContainer)
 {
+    AcquireSRWLockExclusive(&pContainer->view_lock);
+    if (pContainer->view)
+        UnmapViewOfFile(pContainer->view);
+    pContainer->view = NULL;
+    ReleaseSRWLockExclusive(&pContainer->view_lock);
+
     CloseHandle(pContainer->mapping);
     pContainer->mapping = NULL;
 }
@@ -701,6 +756,9 @@ static BOOL cache_containers_add(const char *cache_prefix, LPCWSTR path,
 
     pContainer->mapping = NULL;
     pContainer->file_size = 0;
+    pContainer->view = NULL;
+    InitializeSRWLock(&pContainer->view_lock);
+    pContainer->lock_depth = 0;
     pContainer->default_entry_type = default_entry_type;
 
     pContainer->path = heap_strdupW(path);
@@ -886,6 +944,28 @@ static BOOL cache_containers_enum(char *search_pattern, DWORD index, cache_conta
     return FALSE;
 }
 
+/***********************************************************************
+ *           cache_container_map_view (Internal)
+ *
+ * Returns the view of the index, mapping it if needed.
+ * Caller must hold container lock.
+ */
+static urlcache_header *cache_container_map_view(cache_container *container)
+{
+    urlcache_header *header;
+
+    if (container->view)
+        return container->view;
+
+    if (!(header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0)))
+        return NULL;
+
+    AcquireSRWLockExclusive(&container->view_lock);
+    container->view = header;
+    ReleaseSRWLockExclusive(&container->view_lock);
+    return header;
+}
+
 /***********************************************************************
  *           cache_container_lock_index (Internal)
  *
@@ -898,29 +978,24 @@ static BOOL cache_containers_enum(char *search_pattern, DWORD index, cache_conta
 static urlcache_header* cache_container_lock_index(cache_container *pContainer)
 {
     BYTE index;
-    LPVOID pIndexData;
     urlcache_header* pHeader;
     DWORD error;
 
     /* acquire mutex */
     WaitForSingleObject(pContainer->mutex, INFINITE);
 
-    pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
-
-    if (!pIndexData)
+    if (!(pHeader = cache_container_map_view(pContainer)))
     {
         ReleaseMutex(pContainer->mutex);
         ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
         return NULL;
     }
-    pHeader = (urlcache_header*)pIndexData;
 
     /* file has grown - we need to remap to prevent us getting
      * access violations when we try and access beyond the end
      * of the memory mapped file */
     if (pHeader->size != pContainer->file_size)
     {
-        UnmapViewOfFile( pHeader );
         cache_container_close_index(pContainer);
         error = cache_container_open_index(pContainer, MIN_BLOCK_NO);
         if (error != ERROR_SUCCESS)
@@ -929,17 +1004,20 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
             SetLastError(error);
             return NULL;
         }
-        pIndexData = MapViewOfFile(pContainer->mapping, FILE_MAP_WRITE, 0, 0, 0);
 
-        if (!pIndexData)
+        if (!(pHeader = cache_container_map_view(pContainer)))
         {
             ReleaseMutex(pContainer->mutex);
             ERR("Couldn't MapViewOfFile. Error: %d\n", GetLastError());
             return NULL;
         }
-        pHeader = (urlcache_header*)pIndexData;
     }
 
+    /* make lookups done without the mutex retry until we are done,
+     * an odd value left behind by a crashed process is kept as is */
+    if (!pContainer->lock_depth++ && !(pHeader->sequence & 1))
+        InterlockedIncrement(&pHeader->sequence);
+
     TRACE("Signature: %s, file size: %d bytes\n", pHeader->signature, pHeader->size);
 
     for (index = 0; index < pHeader->dirs_no; index++)
@@ -956,9 +1034,13 @@ static urlcache_header* cache_container_lock_index(cache_container *pContainer)
  */
 static BOOL cache_container_unlock_index(cache_container *pContainer, urlcache_header *pHeader)
 {
-    /* release mutex */
+    /* the view may have been replaced or dropped if the index failed to grow */
+    if (!--pContainer->lock_depth && pContainer->view)
+        InterlockedIncrement(&pContainer->view->sequence);
+
+    /* release mutex, the view stays mapped until the index is closed */
     ReleaseMutex(pContainer->mutex);
-    return UnmapViewOfFile(pHeader);
+    return TRUE;
 }
 
 /***********************************************************************
@@ -1175,7 +1257,7 @@ static BOOL urlcache_clean_leaked_entries(cache_container *container, urlcache_h
 static DWORD cache_container_clean_index(cache_container *container, urlcache_header **file_view)
 {
     urlcache_header *header = *file_view;
-    DWORD ret;
+    DWORD ret, blocks_no;
 
     TRACE("(%s %s)\n", debugstr_a(container->cache_prefix), debugstr_w(container->path));
 
@@ -1187,11 +1269,17 @@ static DWORD cache_container_clean_index(cache_container *container, urlcache_he
         return ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    /* detach the current view, the caller keeps using it if growing fails */
+    AcquireSRWLockExclusive(&container->view_lock);
+    container->view = NULL;
+    ReleaseSRWLockExclusive(&container->view_lock);
+
+    blocks_no = header->capacity_in_blocks*2;
     cache_container_close_index(container);
-    ret = cache_container_open_index(container, header->capacity_in_blocks*2);
+    ret = cache_container_open_index(container, blocks_no);
     if(ret != ERROR_SUCCESS)
         return ret;
-    header = MapViewOfFile(container->mapping, FILE_MAP_WRITE, 0, 0, 0);
+    header = cache_container_map_view(container);
     if(!header)
         return GetLastError();
 
@@ -1771,12 +1859,121 @@ static BOOL urlcache_hash_entry_is_locked(struct hash_entry *hash_entry, entry_u
     return TRUE;
 }
 
+static DWORD urlcache_copy_entry_info(cache_container *container, const urlcache_header *header,
+        const entry_url *url_entry, void *entry_info, DWORD *size, DWORD flags, BOOL unicode)
+{
+    DWORD error;
+
+    if(url_entry->header.signature != URL_SIGNATURE) {
+        FIXME("Trying to retrieve entry of unknown format %s\n",
+                debugstr_an((LPCSTR)&url_entry->header.signature, sizeof(DWORD)));
+        return ERROR_FILE_NOT_FOUND;
+    }
+
+    TRACE("Found URL: %s\n", debugstr_a((LPCSTR)url_entry + url_entry->url_off));
+    TRACE("Header info: %s\n", debugstr_an((LPCSTR)url_entry +
+                url_entry->header_info_off, url_entry->header_info_size));
+
+    if((flags & GET_INSTALLED_ENTRY) && !(url_entry->cache_entry_type & INSTALLED_CACHE_ENTRY))
+        return ERROR_FILE_NOT_FOUND;
+
+    if(size) {
+        if(!entry_info)
+            *size = 0;
+
+        error = urlcache_copy_entry(container, header, entry_info, size, url_entry, unicode);
+        if(error != ERROR_SUCCESS)
+            return error;
+        if(url_entry->local_name_off)
+            TRACE("Local File Name: %s\n", debugstr_a((LPCSTR)url_entry + url_entry->local_name_off));
+    }
+    return ERROR_SUCCESS;
+}
+
+/***********************************************************************
+ *           urlcache_get_entry_info_unlocked (Internal)
+ *
+ *  Looks up an entry without taking the index mutex. Every change to the
+ * index is bracketed by increments of the header sequence, a copy of the
+ * entry is only used if the sequence was even and did not change while it
+ * was taken.
+ *
+ * RETURNS
+ *    ERROR_RETRY if the lookup has to be done with the index locked
+ *    the result of the lookup otherwise
+ *
+ */
+static DWORD urlcache_get_entry_info_unlocked(cache_container *container, const char *url,
+        void *entry_info, DWORD *size, DWORD flags, BOOL unicode)
+{
+    const entry_hash_table *hash_table;
+    const entry_header *entry;
+    urlcache_header *header;
+    entry_url *url_entry = NULL;
+    DWORD key, bucket, table_off, entry_off = 0, entry_size, id = 0, error = ERROR_RETRY;
+    LONG sequence = 0;
+    int i;
+
+    AcquireSRWLockShared(&container->view_lock);
+
+    if(!(header = container->view))
+        goto done;
+    sequence = InterlockedCompareExchange(&header->sequence, 0, 0);
+    if((sequence & 1) || header->size != container->file_size)
+        goto done;
+
+    /* same walk as urlcache_find_hash_entry, but without trusting any offset */
+    key = urlcache_hash_key(url);
+    bucket = (key & (HASHTABLE_NUM_ENTRIES-1)) * HASHTABLE_BLOCKSIZE;
+    key >>= HASHTABLE_FLAG_BITS;
+
+    for(table_off = header->hash_table_off; table_off && !entry_off; table_off = hash_table->next) {
+        if(table_off < ENTRY_START_OFFSET || table_off > container->file_size - sizeof(*hash_table))
+            goto done;
+        hash_table = (const entry_hash_table*)((const BYTE*)header + table_off);
+        if(hash_table->id != id++ || hash_table->header.signature != HASH_SIGNATURE)
+            goto done;
+
+        for(i = 0; i < HASHTABLE_BLOCKSIZE; i++) {
+            if(key == hash_table->hash_table[bucket + i].key>>HASHTABLE_FLAG_BITS) {
+                entry_off = hash_table->hash_table[bucket + i].offset;
+                break;
+            }
+        }
+    }
+
+    if(!entry_off) {
+        error = ERROR_FILE_NOT_FOUND;
+        goto done;
+    }
+
+    if(entry_off < ENTRY_START_OFFSET || entry_off > container->file_size - sizeof(entry_url))
+        goto done;
+    entry = (const entry_header*)((const BYTE*)header + entry_off);
+    entry_size = entry->blocks_used * BLOCKSIZE;
+    if(entry_size < sizeof(entry_url) || entry_size > container->file_size - entry_off)
+        goto done;
+    if(!(url_entry = heap_alloc(entry_size)))
+        goto done;
+    memcpy(url_entry, entry, entry_size);
+    error = ERROR_SUCCESS;
+
+done:
+    if(error != ERROR_RETRY && InterlockedCompareExchange(&header->sequence, 0, 0) != sequence)
+        error = ERROR_RETRY;
+    if(error == ERROR_SUCCESS)
+        error = urlcache_copy_entry_info(container, header, url_entry, entry_info, size, flags, unicode);
+
+    ReleaseSRWLockShared(&container->view_lock);
+    heap_free(url_entry);
+    return error;
+}
+
 static BOOL urlcache_get_entry_info(const char *url, void *entry_info,
         DWORD *size, DWORD flags, BOOL unicode)
 {
     urlcache_header *header;
     struct hash_entry *hash_entry;
-    const entry_url *url_entry;
     cache_container *container;
     DWORD error;
 
@@ -1797,6 +1994,16 @@ static BOOL urlcache_get_entry_info(const char *url, void *entry_info,
         return FALSE;
     }
 
+    error = urlcache_get_entry_info_unlocked(container, url, entry_info, size, flags, unicode);
+    if(error == ERROR_SUCCESS)
+        return TRUE;
+    if(error != ERROR_RETRY) {
+        if(error == ERROR_FILE_NOT_FOUND)
+            WARN("entry %s not found!\n", debugstr_a(url));
+        SetLastError(error);
+        return FALSE;
+    }
+
     if(!(header = cache_container_lock_index(container)))
         return FALSE;
 
@@ -1807,40 +2014,13 @@ static BOOL urlcache_get_entry_info(const char *url, void *entry_info,
         return FALSE;
     }
 
-    url_entry = (const entry_url*)((LPBYTE)header + hash_entry->offset);
-    if(url_entry->header.signature != URL_SIGNATURE) {
-        cache_container_unlock_index(container, header);
-        FIXME("Trying to retrieve entry of unknown format %s\n",
-                debugstr_an((LPCSTR)&url_entry->header.signature, sizeof(DWORD)));
-        SetLastError(ERROR_FILE_NOT_FOUND);
-        return FALSE;
-    }
-
-    TRACE("Found URL: %s\n", debugstr_a((LPCSTR)url_entry + url_entry->url_off));
-    TRACE("Header info: %s\n", debugstr_an((LPCSTR)url_entry +
-                url_entry->header_info_off, url_entry->header_info_size));
-
-    if((flags & GET_INSTALLED_ENTRY) && !(url_entry->cache_entry_type & INSTALLED_CACHE_ENTRY)) {
-        cache_container_unlock_index(container, header);
-        SetLastError(ERROR_FILE_NOT_FOUND);
+    error = urlcache_copy_entry_info(container, header, (const entry_url*)((LPBYTE)header + hash_entry->offset),
+            entry_info, size, flags, unicode);
+    cache_container_unlock_index(container, header);
+    if(error != ERROR_SUCCESS) {
+        SetLastError(error);
         return FALSE;
     }
-
-    if(size) {
-        if(!entry_info)
-            *size = 0;
-
-        error = urlcache_copy_entry(container, header, entry_info, size, url_entry, unicode);
-        if(error != ERROR_SUCCESS) {
-            cache_container_unlock_index(container, header);
-            SetLastError(error);
-            return FALSE;
-        }
-        if(url_entry->local_name_off)
-            TRACE("Local File Name: %s\n", debugstr_a((LPCSTR)url_entry + url_entry->local_name_off));
-    }
-
-    cache_container_unlock_index(container, header);
     return TRUE;
 }
 
@@ -38,6 +38,12 @@
 #ifdef HAVE_SYS_POLL_H
 #include <sys/poll.h>
 #endif
+#ifdef HAVE_SYS_TIMERFD_H
+#include <sys/timerfd.h>
+#endif
+#ifdef HAVE_SYS_PRCTL_H
+#include <sys/prctl.h>
+#endif
 
 #include "windef.h"
 #include "winbase.h"
@@ -45,23 +51,25 @@
 
 #include "winemm.h"
 
-#include "wine/list.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(mmtime);
 
 typedef struct tagWINE_TIMERENTRY {
-    struct list                 entry;
     UINT                        wDelay;
     UINT                        wResol;
     LPTIMECALLBACK              lpFunc; /* can be lots of things */
     DWORD_PTR                   dwUser;
     UINT16                      wFlags;
     UINT16                      wTimerID;
-    DWORD                       dwTriggerTime;
+    LONGLONG                    trigger_time;   /* absolute deadline in 100ns units */
+    unsigned int                heap_index;     /* position in timer_heap */
 } WINE_TIMERENTRY, *LPWINE_TIMERENTRY;
 
-static struct list timer_list = LIST_INIT(timer_list);
+/* pending timers, kept as a binary min-heap ordered by deadline */
+static WINE_TIMERENTRY **timer_heap;
+static unsigned int timer_count;
+static unsigned int timer_heap_size;
 
 static CRITICAL_SECTION TIME_cbcrst;
 static CRITICAL_SECTION_DEBUG critsect_debug =
@@ -75,16 +83,79 @@ static CRITICAL_SECTION TIME_cbcrst = { &critsect_debug, -1, 0, 0, 0, 0 };
 static    HANDLE                TIME_hMMTimer;
 static    BOOL                  TIME_TimeToDie = TRUE;
 static    int                   TIME_fdWake[2] = { -1, -1 };
+static    int                   TIME_fdTimer = -1;
+static    LONG                  TIME_PeriodRequests;
+
+#if defined(HAVE_SYS_TIMERFD_H) && defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+#define USE_TIMERFD
+#endif
 
-/* link timer at the appropriate spot in the list */
-static inline void link_timer( WINE_TIMERENTRY *timer )
+/* current time in 100ns units, on the clock used by timerfd when available */
+static LONGLONG get_time(void)
 {
-    WINE_TIMERENTRY *next;
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
 
-    LIST_FOR_EACH_ENTRY( next, &timer_list, WINE_TIMERENTRY, entry )
-        if ((int)(next->dwTriggerTime - timer->dwTriggerTime) >= 0) break;
+    if (!clock_gettime( CLOCK_MONOTONIC, &ts ))
+        return ts.tv_sec * (LONGLONG)10000000 + ts.tv_nsec / 100;
+#endif
+    return GetTickCount64() * 10000;
+}
 
-    list_add_before( &next->entry, &timer->entry );
+static void heap_move( WINE_TIMERENTRY *timer, unsigned int index )
+{
+    timer_heap[index] = timer;
+    timer->heap_index = index;
+}
+
+/* restore the heap order after the deadline of a timer changed */
+static void heap_update( WINE_TIMERENTRY *timer )
+{
+    unsigned int index = timer->heap_index, child;
+
+    while (index && timer_heap[(index - 1) / 2]->trigger_time > timer->trigger_time)
+    {
+        heap_move( timer_heap[(index - 1) / 2], index );
+        index = (index - 1) / 2;
+    }
+    while ((child = 2 * index + 1) < timer_count)
+    {
+        if (child + 1 < timer_count && timer_heap[child + 1]->trigger_time < timer_heap[child]->trigger_time)
+            child++;
+        if (timer_heap[child]->trigger_time >= timer->trigger_time) break;
+        heap_move( timer_heap[child], index );
+        index = child;
+    }
+    heap_move( timer, index );
+}
+
+static BOOL link_timer( WINE_TIMERENTRY *timer )
+{
+    if (timer_count == timer_heap_size)
+    {
+        unsigned int new_size = max( 16, timer_heap_size * 2 );
+        WINE_TIMERENTRY **new_heap;
+
+        if (timer_heap)
+            new_heap = HeapReAlloc( GetProcessHeap(), 0, timer_heap, new_size * sizeof(*new_heap) );
+        else
+            new_heap = HeapAlloc( GetProcessHeap(), 0, new_size * sizeof(*new_heap) );
+        if (!new_heap) return FALSE;
+        timer_heap = new_heap;
+        timer_heap_size = new_size;
+    }
+    timer->heap_index = timer_count++;
+    heap_update( timer );
+    return TRUE;
+}
+
+static void unlink_timer( WINE_TIMERENTRY *timer )
+{
+    WINE_TIMERENTRY *last = timer_heap[--timer_count];
+
+    if (last == timer) return;
+    last->heap_index = timer->heap_index;
+    heap_update( last );
 }
 
 /*
@@ -120,11 +191,13 @@ static inline void link_timer( WINE_TIMERENTRY *timer )
 
 /**************************************************************************
  *           TIME_MMSysTimeCallback
+ *
+ * Fires the expired timers, returns FALSE when no timer is left, otherwise
+ * the deadline of the next one.
  */
-static int TIME_MMSysTimeCallback(void)
+static BOOL TIME_MMSysTimeCallback(LONGLONG *deadline)
 {
     WINE_TIMERENTRY *timer, *to_free;
-    int delta_time;
 
     /* since timeSetEvent() and timeKillEvent() can be called
      * from 16 bit code, there are cases where win16 lock is
@@ -140,25 +213,23 @@ static int TIME_MMSysTimeCallback(void)
 
     for (;;)
     {
-        struct list *ptr = list_head( &timer_list );
-        if (!ptr)
-        {
-            delta_time = -1;
-            break;
-        }
+        if (!timer_count) return FALSE;
 
-        timer = LIST_ENTRY( ptr, WINE_TIMERENTRY, entry );
-        delta_time = timer->dwTriggerTime - GetTickCount();
-        if (delta_time > 0) break;
+        timer = timer_heap[0];
+        *deadline = timer->trigger_time;
+        if (*deadline > get_time()) return TRUE;
 
-        list_remove( &timer->entry );
         if (timer->wFlags & TIME_PERIODIC)
         {
-            timer->dwTriggerTime += timer->wDelay;
-            link_timer( timer );  /* restart it */
+            timer->trigger_time += timer->wDelay * (LONGLONG)10000;
+            heap_update( timer );  /* restart it */
             to_free = NULL;
         }
-        else to_free = timer;
+        else
+        {
+            unlink_timer( timer );
+            to_free = timer;
+        }
 
         switch(timer->wFlags & (TIME_CALLBACK_EVENT_SET|TIME_CALLBACK_EVENT_PULSE))
         {
@@ -187,7 +258,38 @@ static int TIME_MMSysTimeCallback(void)
         }
         HeapFree( GetProcessHeap(), 0, to_free );
     }
-    return delta_time;
+}
+
+/* sleep until the deadline or until woken up through the pipe */
+static int TIME_WaitDeadline(struct pollfd *pfd, LONGLONG deadline, LONGLONG now)
+{
+#ifdef USE_TIMERFD
+    if (TIME_fdTimer != -1)
+    {
+        struct itimerspec its;
+
+        /* the deadline is absolute, so the wakeup doesn't drift with scheduling delays */
+        its.it_interval.tv_sec = its.it_interval.tv_nsec = 0;
+        its.it_value.tv_sec = deadline / 10000000;
+        its.it_value.tv_nsec = (deadline % 10000000) * 100;
+        if (!timerfd_settime(TIME_fdTimer, TFD_TIMER_ABSTIME, &its, NULL))
+            return poll(pfd, 2, -1);
+    }
+#endif
+    return poll(pfd, 1, (deadline - now + 9999) / 10000);
+}
+
+/* the thread timer slack follows the timeBeginPeriod requests */
+static void TIME_UpdateTimerSlack(BOOL *fine)
+{
+#if defined(HAVE_PRCTL) && defined(PR_SET_TIMERSLACK)
+    BOOL requested = TIME_PeriodRequests > 0;
+
+    if (requested == *fine) return;
+    /* a slack of 0 restores the default one */
+    prctl(PR_SET_TIMERSLACK, requested ? 1000 : 0);
+    *fine = requested;
+#endif
 }
 
 /**************************************************************************
@@ -195,27 +297,34 @@ static int TIME_MMSysTimeCallback(void)
  */
 static DWORD CALLBACK TIME_MMSysTimeThread(LPVOID arg)
 {
-    int sleep_time, ret;
+    LONGLONG deadline, now;
+    BOOL fine_slack = FALSE;
     char readme[16];
-    struct pollfd pfd;
+    UINT64 expirations;
+    struct pollfd pfd[2];
+    int ret;
 
-    pfd.fd = TIME_fdWake[0];
-    pfd.events = POLLIN;
+    pfd[0].fd = TIME_fdWake[0];
+    pfd[0].events = POLLIN;
+    pfd[1].fd = TIME_fdTimer;
+    pfd[1].events = POLLIN;
 
     TRACE("Starting main winmm thread\n");
 
     EnterCriticalSection(&WINMM_cs);
     while (! TIME_TimeToDie) 
     {
-        sleep_time = TIME_MMSysTimeCallback();
-
-        if (sleep_time < 0)
+        if (!TIME_MMSysTimeCallback(&deadline))
             break;
-        if (sleep_time == 0)
+        now = get_time();
+        if (deadline <= now)
             continue;
 
+        TIME_UpdateTimerSlack(&fine_slack);
+
         LeaveCriticalSection(&WINMM_cs);
-        ret = poll(&pfd, 1, sleep_time);
+        pfd[0].revents = pfd[1].revents = 0;
+        ret = TIME_WaitDeadline(pfd, deadline, now);
         EnterCriticalSection(&WINMM_cs);
 
         if (ret < 0)
@@ -227,7 +336,9 @@ static DWORD CALLBACK TIME_MMSysTimeThread(LPVOID arg)
             }
          }
 
-        while (ret > 0) ret = read(TIME_fdWake[0], readme, sizeof(readme));
+        if (pfd[1].revents & POLLIN) read(TIME_fdTimer, &expirations, sizeof(expirations));
+        if (pfd[0].revents & POLLIN)
+            while (read(TIME_fdWake[0], readme, sizeof(readme)) > 0);
     }
     CloseHandle(TIME_hMMTimer);
     TIME_hMMTimer = NULL;
@@ -254,6 +365,12 @@ static void TIME_MMTimeStart(void)
         }
     }
 
+#ifdef USE_TIMERFD
+    if (TIME_fdTimer < 0 &&
+        (TIME_fdTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0)
+        WARN("Cannot create timerfd, using poll timeouts: %s\n", strerror(errno));
+#endif
+
     if (!TIME_hMMTimer) {
         HMODULE mod;
         GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCWSTR)TIME_MMSysTimeThread, &mod);
@@ -284,6 +401,7 @@ void	TIME_MMTimeStop(void)
         }
         close(TIME_fdWake[0]);
         close(TIME_fdWake[1]);
+        if (TIME_fdTimer != -1) close(TIME_fdTimer);
         DeleteCriticalSection(&TIME_cbcrst);
     }
 }
@@ -311,7 +429,7 @@ MMRESULT WINAPI timeSetEvent(UINT wDelay, UINT wResol, LPTIMECALLBACK lpFunc,
 {
     WORD 		wNewID = 0;
     LPWINE_TIMERENTRY	lpNewTimer;
-    LPWINE_TIMERENTRY	lpTimer;
+    unsigned int	i;
     const char c = 'c';
 
     TRACE("(%u, %u, %p, %08lX, %04X);\n", wDelay, wResol, lpFunc, dwUser, wFlags);
@@ -324,7 +442,7 @@ MMRESULT WINAPI timeSetEvent(UINT wDelay, UINT wResol, LPTIMECALLBACK lpFunc,
 	return 0;
 
     lpNewTimer->wDelay = wDelay;
-    lpNewTimer->dwTriggerTime = GetTickCount() + wDelay;
+    lpNewTimer->trigger_time = get_time() + wDelay * (LONGLONG)10000;
 
     /* FIXME - wResol is not respected, although it is not clear
                that we could change our precision meaningfully  */
@@ -335,10 +453,15 @@ MMRESULT WINAPI timeSetEvent(UINT wDelay, UINT wResol, LPTIMECALLBACK lpFunc,
 
     EnterCriticalSection(&WINMM_cs);
 
-    LIST_FOR_EACH_ENTRY( lpTimer, &timer_list, WINE_TIMERENTRY, entry )
-        wNewID = max(wNewID, lpTimer->wTimerID);
+    for (i = 0; i < timer_count; i++)
+        wNewID = max(wNewID, timer_heap[i]->wTimerID);
 
-    link_timer( lpNewTimer );
+    if (!link_timer( lpNewTimer ))
+    {
+        LeaveCriticalSection(&WINMM_cs);
+        HeapFree(GetProcessHeap(), 0, lpNewTimer);
+        return 0;
+    }
     lpNewTimer->wTimerID = wNewID + 1;
 
     TIME_MMTimeStart();
@@ -358,21 +481,22 @@ MMRESULT WINAPI timeSetEvent(UINT wDelay, UINT wResol, LPTIMECALLBACK lpFunc,
  */
 MMRESULT WINAPI timeKillEvent(UINT wID)
 {
-    WINE_TIMERENTRY *lpSelf = NULL, *lpTimer;
+    WINE_TIMERENTRY *lpSelf = NULL;
+    unsigned int i;
     DWORD wFlags;
 
     TRACE("(%u)\n", wID);
     EnterCriticalSection(&WINMM_cs);
-    /* remove WINE_TIMERENTRY from list */
-    LIST_FOR_EACH_ENTRY( lpTimer, &timer_list, WINE_TIMERENTRY, entry )
+    /* remove WINE_TIMERENTRY from the heap */
+    for (i = 0; i < timer_count; i++)
     {
-	if (wID == lpTimer->wTimerID) {
-            lpSelf = lpTimer;
-            list_remove( &lpTimer->entry );
+	if (wID == timer_heap[i]->wTimerID) {
+            lpSelf = timer_heap[i];
+            unlink_timer( lpSelf );
 	    break;
 	}
     }
-    if (list_empty(&timer_list)) {
+    if (!timer_count) {
         char c = 'q';
         TIME_TimeToDie = 1;
         write(TIME_fdWake[1], &c, sizeof(c));
@@ -428,6 +552,8 @@ MMRESULT WINAPI timeBeginPeriod(UINT wPeriod)
         WARN("Stub; we set our timer resolution at minimum\n");
     }
 
+    /* tightens the timer slack of the timer thread */
+    InterlockedIncrement(&TIME_PeriodRequests);
     return 0;
 }
 
@@ -443,5 +569,8 @@ MMRESULT WINAPI timeEndPeriod(UINT wPeriod)
     {
         WARN("Stub; we set our timer resolution at minimum\n");
     }
+
+    if (InterlockedDecrement(&TIME_PeriodRequests) < 0)
+        InterlockedIncrement(&TIME_PeriodRequests);
     return 0;
 }
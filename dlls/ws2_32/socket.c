@@ -64,6 +64,9 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
@@ -128,6 +131,9 @@
 #ifdef HAVE_SYS_POLL_H
 # include <sys/poll.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
@@ -157,6 +163,7 @@
 #include "wine/server.h"
 #include "wine/debug.h"
 #include "wine/exception.h"
+#include "wine/list.h"
 #include "wine/unicode.h"
 
 #if defined(linux) && !defined(IP_UNICAST_IF)
@@ -534,6 +541,10 @@ struct ws2_transmitfile_async
     TRANSMIT_FILE_BUFFERS buffers;
     DWORD                 flags;
     LARGE_INTEGER         offset;
+    TRANSMIT_PACKETS_ELEMENT *elements;
+    DWORD                 element_count;
+    DWORD                 next_element;
+    BOOL                  no_sendfile;
     struct ws2_async      write;
 };
 
@@ -572,6 +583,8 @@ static NTSTATUS register_async( int type, HANDLE handle, struct ws2_async_io *as
 {
     NTSTATUS status;
 
+    if (event) wine_server_flush_sync_object( event );
+
     SERVER_START_REQ( register_async )
     {
         req->type              = type;
@@ -615,7 +628,9 @@ struct per_thread_data
     struct WS_servent *se_buffer;
     struct WS_protoent *pe_buffer;
     struct pollfd *fd_cache;
+    BYTE *fd_dup;          /* whether the fd_cache entries were duplicated */
     unsigned int fd_count;
+    struct select_epoll *epoll;
     int he_len;
     int se_len;
     int pe_len;
@@ -1099,6 +1114,76 @@ static inline void release_sock_fd( SOCKET s, int fd )
     wine_server_release_fd( SOCKET2HANDLE(s), fd );
 }
 
+/* cache of the socket properties needed to build poll sets, indexed by handle
+ * like the ntdll fd cache; an entry holds the unix fd + 1 in the low 32 bits,
+ * so that it is only used as long as the handle maps to the same fd */
+
+#define SOCK_CACHE_BLOCK_SIZE  (65536 / sizeof(LONG64))
+#define SOCK_CACHE_ENTRIES     128
+
+#define SOCK_CACHE_BOUND       0x01  /* a socket can't be unbound again */
+#define SOCK_CACHE_TYPE_KNOWN  0x02
+#define SOCK_CACHE_DGRAM       0x04
+#define SOCK_CACHE_OOB_KNOWN   0x08
+#define SOCK_CACHE_OOBINLINE   0x10
+
+static LONG64 *sock_cache[SOCK_CACHE_ENTRIES];
+static LONG sock_generation;  /* incremented whenever a socket handle is created or closed */
+
+static LONG64 *get_sock_cache_entry( SOCKET s, BOOL alloc )
+{
+    unsigned int idx = (s >> 2) - 1, entry = idx / SOCK_CACHE_BLOCK_SIZE;
+    LONG64 *block;
+
+    if (entry >= SOCK_CACHE_ENTRIES) return NULL;
+    if (!(block = sock_cache[entry]))
+    {
+        if (!alloc) return NULL;
+        if (!(block = VirtualAlloc( NULL, SOCK_CACHE_BLOCK_SIZE * sizeof(LONG64),
+                                    MEM_COMMIT, PAGE_READWRITE ))) return NULL;
+        if (InterlockedCompareExchangePointer( (void **)&sock_cache[entry], block, NULL ))
+        {
+            VirtualFree( block, 0, MEM_RELEASE );
+            block = sock_cache[entry];
+        }
+    }
+    return &block[idx % SOCK_CACHE_BLOCK_SIZE];
+}
+
+static unsigned int get_sock_cache_flags( SOCKET s, int fd )
+{
+    LONG64 *entry, data;
+
+    if (!(entry = get_sock_cache_entry( s, FALSE ))) return 0;
+    data = InterlockedCompareExchange64( entry, 0, 0 );
+    if ((unsigned int)data != fd + 1) return 0;
+    return data >> 32;
+}
+
+static void set_sock_cache_flags( SOCKET s, int fd, unsigned int flags )
+{
+    LONG64 *entry, data, prev;
+
+    if (!(entry = get_sock_cache_entry( s, TRUE ))) return;
+    do
+    {
+        prev = *entry;
+        data = (unsigned int)(fd + 1);
+        if ((unsigned int)prev == fd + 1) flags |= prev >> 32;
+        data |= (LONG64)flags << 32;
+    } while (InterlockedCompareExchange64( entry, data, prev ) != prev);
+}
+
+/* forget the cached properties of a socket handle that is created, closed or changed */
+static void invalidate_sock_cache( SOCKET s, BOOL new_handle )
+{
+    LONG64 *entry, data;
+
+    if (new_handle) InterlockedIncrement( &sock_generation );
+    if (!(entry = get_sock_cache_entry( s, FALSE ))) return;
+    do data = *entry; while (InterlockedCompareExchange64( entry, 0, data ) != data);
+}
+
 static void _enable_event( HANDLE s, unsigned int event,
                            unsigned int sstate, unsigned int cstate )
 {
@@ -1113,6 +1198,17 @@ static void _enable_event( HANDLE s, unsigned int event,
     SERVER_END_REQ;
 }
 
+/* set once event selection has been requested on any socket of the process */
+static BOOL event_select_used;
+
+/* re-enable a network event after a successful data transfer; the event can
+ * only be held by the server if event selection has been used, so avoid the
+ * server round-trip on the direct recv/send path otherwise */
+static inline void reenable_event_after_io( SOCKET s, unsigned int event )
+{
+    if (event_select_used) _enable_event( SOCKET2HANDLE(s), event, 0, 0 );
+}
+
 static NTSTATUS _is_blocking(SOCKET s, BOOL *ret)
 {
     NTSTATUS status;
@@ -1281,6 +1377,32 @@ static BOOL get_dont_fragment(SOCKET s, int level, BOOL *out)
     return value;
 }
 
+/* persistent epoll set used by select and WSAPoll, see do_epoll */
+struct select_epoll
+{
+    int                 fd;
+    LONG                generation;  /* sock_generation when the set was registered */
+    unsigned int        count;       /* number of entries in the registered poll set */
+    unsigned int        size;        /* allocated size of the arrays */
+    struct pollfd      *set;         /* registered poll set */
+    int                *next;        /* next entry registered with the same unix fd */
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event *events;
+#endif
+};
+
+static void free_select_epoll( struct select_epoll *epoll )
+{
+    if (!epoll) return;
+    if (epoll->fd != -1) close( epoll->fd );
+    HeapFree( GetProcessHeap(), 0, epoll->set );
+    HeapFree( GetProcessHeap(), 0, epoll->next );
+#ifdef HAVE_SYS_EPOLL_H
+    HeapFree( GetProcessHeap(), 0, epoll->events );
+#endif
+    HeapFree( GetProcessHeap(), 0, epoll );
+}
+
 static struct per_thread_data *get_per_thread_data(void)
 {
     struct per_thread_data * ptb = NtCurrentTeb()->WinSockData;
@@ -1304,6 +1426,8 @@ static void free_per_thread_data(void)
     HeapFree( GetProcessHeap(), 0, ptb->se_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->pe_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->fd_cache );
+    HeapFree( GetProcessHeap(), 0, ptb->fd_dup );
+    free_select_epoll( ptb->epoll );
 
     HeapFree( GetProcessHeap(), 0, ptb );
     NtCurrentTeb()->WinSockData = NULL;
@@ -2749,6 +2873,7 @@ SOCKET WINAPI WS_accept(SOCKET s, struct WS_sockaddr *addr, int *addrlen32)
         SERVER_END_REQ;
         if (!status)
         {
+            invalidate_sock_cache( as, TRUE );
             if (addr && addrlen32 && WS_getpeername(as, addr, addrlen32))
             {
                 WS_closesocket(as);
@@ -2922,6 +3047,56 @@ static NTSTATUS WS2_ReadFile(HANDLE hFile, PIO_STATUS_BLOCK io_status, char* buf
     return status;
 }
 
+/***********************************************************************
+ *     WS2_transmitfile_sendfile        (INTERNAL)
+ *
+ * Send the next part of the file directly from the file descriptor.
+ * Returns STATUS_NOT_SUPPORTED if the data has to go through a buffer.
+ */
+static NTSTATUS WS2_transmitfile_sendfile( int fd, struct ws2_transmitfile_async *wsa )
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
+    size_t count = 0x7ffff000;  /* maximum size of a single transfer */
+    ssize_t ret;
+    int file_fd;
+
+    if (wsa->no_sendfile) return STATUS_NOT_SUPPORTED;
+    if (wine_server_handle_to_fd( wsa->file, FILE_READ_DATA, &file_fd, NULL ))
+        return STATUS_NOT_SUPPORTED;
+
+    if (wsa->file_bytes != 0)
+        count = min( count, wsa->file_bytes - wsa->file_read );
+    if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+    {
+        off_t pos = wsa->offset.QuadPart;
+        ret = sendfile( fd, file_fd, &pos, count );
+    }
+    else ret = sendfile( fd, file_fd, NULL, count );
+    wine_server_release_fd( wsa->file, file_fd );
+
+    if (ret == -1)
+    {
+        if (errno == EAGAIN || errno == EINTR) return STATUS_PENDING;
+        if (errno != EINVAL && errno != ENOSYS) return wsaErrStatus();
+        /* not supported for this kind of file, read it into the buffer instead */
+        wsa->no_sendfile = TRUE;
+        return STATUS_NOT_SUPPORTED;
+    }
+    if (!ret) return STATUS_END_OF_FILE;
+
+    if (iosb) iosb->Information += ret;
+    if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+        wsa->offset.QuadPart += ret;
+    wsa->file_read += ret;
+    if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
+        wsa->file = NULL;
+    return STATUS_PENDING;
+#else
+    return STATUS_NOT_SUPPORTED;
+#endif
+}
+
 /***********************************************************************
  *     WS2_transmitfile_getbuffer       (INTERNAL)
  *
@@ -2944,38 +3119,69 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
         return STATUS_PENDING;
     }
 
-    /* process the main file */
-    if (wsa->file)
+    for (;;)
     {
-        DWORD bytes_per_send = wsa->bytes_per_send;
-        IO_STATUS_BLOCK iosb;
-        NTSTATUS status;
+        TRANSMIT_PACKETS_ELEMENT *element;
 
-        iosb.Information = 0;
-        /* when the size of the transfer is limited ensure that we don't go past that limit */
-        if (wsa->file_bytes != 0)
-            bytes_per_send = min(bytes_per_send, wsa->file_bytes - wsa->file_read);
-        status = WS2_ReadFile( wsa->file, &iosb, wsa->buffer, bytes_per_send, &wsa->offset );
-        if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
-            wsa->offset.QuadPart += iosb.Information;
-        if (status == STATUS_END_OF_FILE)
-            wsa->file = NULL; /* continue on to the footer */
-        else if (status != STATUS_SUCCESS)
-            return status;
-        else
+        /* process the main file */
+        if (wsa->file)
         {
-            if (iosb.Information)
+            DWORD bytes_per_send = wsa->bytes_per_send;
+            IO_STATUS_BLOCK iosb;
+            NTSTATUS status;
+
+            status = WS2_transmitfile_sendfile( fd, wsa );
+            if (status == STATUS_NOT_SUPPORTED)
             {
-                wsa->write.first_iovec       = 0;
-                wsa->write.n_iovecs          = 1;
-                wsa->write.iovec[0].iov_base = wsa->buffer;
-                wsa->write.iovec[0].iov_len  = iosb.Information;
-                wsa->file_read += iosb.Information;
-            }
+                iosb.Information = 0;
+                /* when the size of the transfer is limited ensure that we don't go past that limit */
+                if (wsa->file_bytes != 0)
+                    bytes_per_send = min(bytes_per_send, wsa->file_bytes - wsa->file_read);
+                status = WS2_ReadFile( wsa->file, &iosb, wsa->buffer, bytes_per_send, &wsa->offset );
+                if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+                    wsa->offset.QuadPart += iosb.Information;
+                if (status == STATUS_SUCCESS)
+                {
+                    if (iosb.Information)
+                    {
+                        wsa->write.first_iovec       = 0;
+                        wsa->write.n_iovecs          = 1;
+                        wsa->write.iovec[0].iov_base = wsa->buffer;
+                        wsa->write.iovec[0].iov_len  = iosb.Information;
+                        wsa->file_read += iosb.Information;
+                    }
 
-            if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
-                wsa->file = NULL;
+                    if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
+                        wsa->file = NULL;
+
+                    return STATUS_PENDING;
+                }
+            }
+            if (status == STATUS_END_OF_FILE)
+                wsa->file = NULL; /* continue on to the next element or the footer */
+            else
+                return status;
+        }
 
+        /* process the next TransmitPackets element (if applicable) */
+        if (wsa->next_element >= wsa->element_count) break;
+        element = &wsa->elements[wsa->next_element++];
+        if (element->dwElFlags & TP_ELEMENT_FILE)
+        {
+            wsa->file       = element->u.s.hFile;
+            wsa->file_read  = 0;
+            wsa->file_bytes = element->cLength;
+            wsa->offset     = element->u.s.nFileOffset;
+            if (wsa->offset.QuadPart == -1)
+                wsa->offset.QuadPart = FILE_USE_FILE_POINTER_POSITION;
+            wsa->no_sendfile = FALSE;
+        }
+        else if (element->cLength)
+        {
+            wsa->write.first_iovec       = 0;
+            wsa->write.n_iovecs          = 1;
+            wsa->write.iovec[0].iov_base = element->u.pBuffer;
+            wsa->write.iovec[0].iov_len  = element->cLength;
             return STATUS_PENDING;
         }
     }
@@ -3004,7 +3210,7 @@ static NTSTATUS WS2_transmitfile_base( int fd, struct ws2_transmitfile_async *ws
     NTSTATUS status;
 
     status = WS2_transmitfile_getbuffer( fd, wsa );
-    if (status == STATUS_PENDING)
+    if (status == STATUS_PENDING && wsa->write.first_iovec < wsa->write.n_iovecs)
     {
         IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
         int n;
@@ -3022,135 +3228,1181 @@ static NTSTATUS WS2_transmitfile_base( int fd, struct ws2_transmitfile_async *ws
 }
 
 /***********************************************************************
- *     WS2_async_transmitfile           (INTERNAL)
+ *     WS2_async_transmitfile           (INTERNAL)
+ *
+ * Asynchronous callback for overlapped TransmitFile operations.
+ */
+static NTSTATUS WS2_async_transmitfile( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS status )
+{
+    struct ws2_transmitfile_async *wsa = user;
+    int fd;
+
+    if (status == STATUS_ALERTED)
+    {
+        if (!(status = wine_server_handle_to_fd( wsa->write.hSocket, FILE_WRITE_DATA, &fd, NULL )))
+        {
+            status = WS2_transmitfile_base( fd, wsa );
+            wine_server_release_fd( wsa->write.hSocket, fd );
+        }
+        if (status == STATUS_PENDING)
+            return status;
+    }
+
+    iosb->u.Status = status;
+    release_async_io( &wsa->io );
+    return status;
+}
+
+/***********************************************************************
+ *     WS2_transmit_base                (INTERNAL)
+ *
+ * Shared implementation of TransmitFile and TransmitPackets.
+ */
+static BOOL WS2_transmit_base( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
+                               LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
+                               LPTRANSMIT_PACKETS_ELEMENT elements, DWORD element_count, DWORD flags )
+{
+    union generic_unix_sockaddr uaddr;
+    socklen_t uaddrlen = sizeof(uaddr);
+    struct ws2_transmitfile_async *wsa;
+    NTSTATUS status;
+    DWORD i;
+    int fd;
+
+    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
+    if (fd == -1)
+    {
+        WSASetLastError( WSAENOTSOCK );
+        return FALSE;
+    }
+    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAENOTCONN );
+        return FALSE;
+    }
+    if (flags)
+        FIXME("Flags are not currently supported (0x%x).\n", flags);
+
+    for (i = 0; i <= element_count; i++)
+    {
+        HANDLE file = i < element_count ? elements[i].u.s.hFile : h;
+
+        if (i < element_count && !(elements[i].dwElFlags & TP_ELEMENT_FILE)) continue;
+        if (file && GetFileType( file ) != FILE_TYPE_DISK)
+        {
+            FIXME("Non-disk file handles are not currently supported.\n");
+            release_sock_fd( s, fd );
+            WSASetLastError( WSAEOPNOTSUPP );
+            return FALSE;
+        }
+    }
+
+    /* set reasonable defaults when requested */
+    if (!bytes_per_send)
+        bytes_per_send = (1 << 16); /* Depends on OS version: PAGE_SIZE, 2*PAGE_SIZE, or 2^16 */
+
+    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + bytes_per_send +
+                                                                 element_count * sizeof(*elements),
+                                                                 WS2_async_transmitfile )))
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEFAULT );
+        return FALSE;
+    }
+    if (buffers)
+        wsa->buffers = *buffers;
+    else
+        memset(&wsa->buffers, 0x0, sizeof(wsa->buffers));
+    wsa->elements              = (TRANSMIT_PACKETS_ELEMENT *)(wsa + 1);
+    wsa->element_count         = element_count;
+    wsa->next_element          = 0;
+    if (element_count) memcpy( wsa->elements, elements, element_count * sizeof(*elements) );
+    wsa->buffer                = (char *)(wsa->elements + element_count);
+    wsa->file                  = h;
+    wsa->file_read             = 0;
+    wsa->file_bytes            = file_bytes;
+    wsa->bytes_per_send        = bytes_per_send;
+    wsa->flags                 = flags;
+    wsa->offset.QuadPart       = FILE_USE_FILE_POINTER_POSITION;
+    wsa->no_sendfile           = FALSE;
+    wsa->write.hSocket         = SOCKET2HANDLE(s);
+    wsa->write.addr            = NULL;
+    wsa->write.addrlen.val     = 0;
+    wsa->write.flags           = 0;
+    wsa->write.lpFlags         = &wsa->flags;
+    wsa->write.control         = NULL;
+    wsa->write.n_iovecs        = 0;
+    wsa->write.first_iovec     = 0;
+    wsa->write.user_overlapped = overlapped;
+    if (overlapped)
+    {
+        IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)overlapped;
+        int status;
+
+        if (h)
+        {
+            wsa->offset.u.LowPart  = overlapped->u.s.Offset;
+            wsa->offset.u.HighPart = overlapped->u.s.OffsetHigh;
+        }
+        iosb->u.Status = STATUS_PENDING;
+        iosb->Information = 0;
+        status = register_async( ASYNC_TYPE_WRITE, SOCKET2HANDLE(s), &wsa->io,
+                                 overlapped->hEvent, NULL, NULL, iosb );
+        if(status != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
+        release_sock_fd( s, fd );
+        WSASetLastError( NtStatusToWSAError(status) );
+        return FALSE;
+    }
+
+    do
+    {
+        status = WS2_transmitfile_base( fd, wsa );
+        if (status == STATUS_PENDING)
+        {
+            /* block here */
+            do_block(fd, POLLOUT, -1);
+            _sync_sock_state(s); /* let wineserver notice connection */
+        }
+    }
+    while (status == STATUS_PENDING);
+    release_sock_fd( s, fd );
+
+    if (status != STATUS_SUCCESS)
+        WSASetLastError( NtStatusToWSAError(status) );
+    HeapFree( GetProcessHeap(), 0, wsa );
+    return (status == STATUS_SUCCESS);
+}
+
+/***********************************************************************
+ *     TransmitFile
+ */
+static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
+                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
+                                     DWORD flags )
+{
+    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
+            buffers, flags );
+
+    return WS2_transmit_base( s, h, file_bytes, bytes_per_send, overlapped, buffers, NULL, 0, flags );
+}
+
+/***********************************************************************
+ *     TransmitPackets
+ */
+static BOOL WINAPI WS2_TransmitPackets( SOCKET s, LPTRANSMIT_PACKETS_ELEMENT elements, DWORD count,
+                                        DWORD send_size, LPOVERLAPPED overlapped, DWORD flags )
+{
+    TRACE("(%lx, %p, %d, %d, %p, %d)\n", s, elements, count, send_size, overlapped, flags );
+
+    if (count && !elements)
+    {
+        WSASetLastError( WSAEINVAL );
+        return FALSE;
+    }
+    return WS2_transmit_base( s, NULL, 0, send_size, overlapped, NULL, elements, count, flags );
+}
+
+/***********************************************************************
+ *     Registered I/O
+ *
+ * The request queues are processed directly in the calling thread with
+ * non-blocking recvmsg/sendmsg calls, batched through recvmmsg/sendmmsg
+ * when several requests are committed at once.  Requests that would block
+ * are picked up by a single worker thread polling the sockets.  Completion
+ * queues are plain ring buffers, dequeuing them never enters the kernel.
+ */
+
+#if !defined(HAVE_RECVMMSG) || !defined(HAVE_SENDMMSG)
+#define mmsghdr rio_mmsghdr
+struct mmsghdr
+{
+    struct msghdr msg_hdr;
+    unsigned int  msg_len;
+};
+#endif
+
+#define RIO_BATCH_SIZE 16
+
+struct rio_buffer
+{
+    char  *data;
+    DWORD  size;
+};
+
+struct rio_cq
+{
+    RIORESULT                  *results;
+    ULONG                       size;      /* size of the results ring */
+    ULONG                       head;      /* first pending result */
+    ULONG                       count;     /* number of pending results */
+    ULONG                       reserved;  /* space reserved by the request queues */
+    RIO_NOTIFICATION_COMPLETION notify;
+    BOOL                        has_notify;
+    BOOL                        armed;     /* RIONotify has been called */
+};
+
+struct rio_request
+{
+    ULONG_PTR                    context;
+    char                        *data;
+    ULONG                        len;
+    ULONG                        done;      /* bytes already transferred */
+    DWORD                        flags;
+    struct WS_sockaddr          *remote;    /* RIOReceiveEx remote address buffer */
+    int                          remote_len;
+    union generic_unix_sockaddr  addr;
+    unsigned int                 addr_len;
+};
+
+struct rio_queue
+{
+    struct rio_request *reqs;
+    ULONG               max;        /* maximum number of outstanding requests */
+    ULONG               head;       /* first queued request */
+    ULONG               count;      /* number of queued requests */
+    ULONG               committed;  /* number of queued requests not deferred */
+};
+
+struct rio_rq
+{
+    struct list      entry;
+    unsigned int     id;
+    SOCKET           socket;
+    ULONG_PTR        context;
+    BOOL             stream;
+    struct rio_cq   *recv_cq;
+    struct rio_cq   *send_cq;
+    struct rio_queue recv;
+    struct rio_queue send;
+};
+
+static CRITICAL_SECTION rio_cs;
+static CRITICAL_SECTION_DEBUG rio_cs_debug =
+{
+    0, 0, &rio_cs,
+    { &rio_cs_debug.ProcessLocksList, &rio_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": rio_cs") }
+};
+static CRITICAL_SECTION rio_cs = { &rio_cs_debug, -1, 0, 0, 0, 0 };
+
+static struct list rio_queues = LIST_INIT( rio_queues );
+static unsigned int rio_next_id;
+static HANDLE rio_thread;
+static int rio_wake_pipe[2] = { -1, -1 };
+
+/* fire the completion notification of a queue; rio_cs must be held */
+static void rio_notify( struct rio_cq *cq )
+{
+    if (!cq->armed) return;
+    cq->armed = FALSE;
+    if (cq->notify.Type == RIO_EVENT_COMPLETION)
+        SetEvent( cq->notify.u.Event.EventHandle );
+    else
+        PostQueuedCompletionStatus( cq->notify.u.Iocp.IocpHandle, 0,
+                                    (ULONG_PTR)cq->notify.u.Iocp.CompletionKey,
+                                    cq->notify.u.Iocp.Overlapped );
+}
+
+/* complete the first request of a queue; rio_cs must be held */
+static void rio_complete( struct rio_rq *rq, BOOL send, LONG status )
+{
+    struct rio_queue *queue = send ? &rq->send : &rq->recv;
+    struct rio_cq *cq = send ? rq->send_cq : rq->recv_cq;
+    struct rio_request *req = &queue->reqs[queue->head];
+    RIORESULT *result;
+
+    result = &cq->results[(cq->head + cq->count++) % cq->size];
+    result->Status           = status;
+    result->BytesTransferred = req->done;
+    result->SocketContext    = rq->context;
+    result->RequestContext   = req->context;
+
+    queue->head = (queue->head + 1) % queue->max;
+    queue->count--;
+    if (queue->committed) queue->committed--;
+
+    if (!(req->flags & RIO_MSG_DONT_NOTIFY)) rio_notify( cq );
+}
+
+static int rio_transfer( int fd, struct mmsghdr *msgs, unsigned int count, BOOL send )
+{
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+    if (count > 1)
+        return send ? sendmmsg( fd, msgs, count, 0 ) : recvmmsg( fd, msgs, count, 0, NULL );
+#endif
+    {
+        ssize_t ret = send ? sendmsg( fd, &msgs[0].msg_hdr, 0 ) : recvmsg( fd, &msgs[0].msg_hdr, 0 );
+        if (ret == -1) return -1;
+        msgs[0].msg_len = ret;
+        return 1;
+    }
+}
+
+/* process the committed requests of a queue until the socket would block; rio_cs must be held */
+static void rio_process_queue( struct rio_rq *rq, int fd, BOOL send )
+{
+    struct rio_queue *queue = send ? &rq->send : &rq->recv;
+    struct mmsghdr msgs[RIO_BATCH_SIZE];
+    struct iovec iov[RIO_BATCH_SIZE];
+    struct rio_request *req;
+    unsigned int i, count;
+    int ret;
+
+    while (queue->committed)
+    {
+        for (count = 0; count < queue->committed && count < RIO_BATCH_SIZE; count++)
+        {
+            req = &queue->reqs[(queue->head + count) % queue->max];
+            iov[count].iov_base = req->data + req->done;
+            iov[count].iov_len  = req->len - req->done;
+            memset( &msgs[count], 0, sizeof(msgs[count]) );
+            msgs[count].msg_hdr.msg_iov    = &iov[count];
+            msgs[count].msg_hdr.msg_iovlen = 1;
+            if (send && req->addr_len)
+            {
+                msgs[count].msg_hdr.msg_name    = &req->addr;
+                msgs[count].msg_hdr.msg_namelen = req->addr_len;
+            }
+            else if (!send && req->remote)
+            {
+                msgs[count].msg_hdr.msg_name    = &req->addr;
+                msgs[count].msg_hdr.msg_namelen = sizeof(req->addr);
+            }
+            /* data following a partial transfer would be out of order on a stream */
+            if (rq->stream && (send || (req->flags & RIO_MSG_WAITALL))) { count++; break; }
+        }
+
+        if ((ret = rio_transfer( fd, msgs, count, send )) == -1)
+        {
+            if (errno == EAGAIN || errno == EINTR) return;
+            rio_complete( rq, send, wsaErrno() );
+            continue;
+        }
+
+        for (i = 0; i < ret; i++)
+        {
+            req = &queue->reqs[queue->head];
+            req->done += msgs[i].msg_len;
+
+            if (req->done < req->len && msgs[i].msg_len && rq->stream &&
+                (send || (req->flags & RIO_MSG_WAITALL)))
+                return;  /* wait for the rest */
+
+            if (!send && req->remote && msgs[i].msg_hdr.msg_namelen)
+            {
+                int len = req->remote_len;
+                if (ws_sockaddr_u2ws( &req->addr.addr, req->remote, &len ) == -1)
+                {
+                    rio_complete( rq, send, WSAEFAULT );
+                    continue;
+                }
+            }
+            rio_complete( rq, send, (!send && (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)) ? WSAEMSGSIZE : 0 );
+        }
+        if (ret < count) return;
+    }
+}
+
+static struct rio_rq *rio_find_queue( unsigned int id )
+{
+    struct rio_rq *rq;
+
+    LIST_FOR_EACH_ENTRY( rq, &rio_queues, struct rio_rq, entry )
+        if (rq->id == id) return rq;
+    return NULL;
+}
+
+/* worker thread completing the requests that would have blocked */
+static DWORD WINAPI rio_thread_proc( void *arg )
+{
+    unsigned int i, count, size = 16;
+    struct pollfd *pfds = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*pfds) );
+    unsigned int *ids = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*ids) );
+    struct rio_rq *rq;
+    char buffer[64];
+
+    if (!pfds || !ids) return 1;
+
+    for (;;)
+    {
+        EnterCriticalSection( &rio_cs );
+        count = 1;
+        LIST_FOR_EACH_ENTRY( rq, &rio_queues, struct rio_rq, entry )
+        {
+            if (!rq->recv.committed && !rq->send.committed) continue;
+            if (count >= size)
+            {
+                unsigned int new_size = size * 2;
+                struct pollfd *new_pfds = HeapReAlloc( GetProcessHeap(), 0, pfds, new_size * sizeof(*pfds) );
+                unsigned int *new_ids;
+
+                if (!new_pfds) break;
+                pfds = new_pfds;
+                if (!(new_ids = HeapReAlloc( GetProcessHeap(), 0, ids, new_size * sizeof(*ids) ))) break;
+                ids = new_ids;
+                size = new_size;
+            }
+            if ((pfds[count].fd = get_sock_fd( rq->socket, 0, NULL )) == -1) continue;
+            pfds[count].events = (rq->recv.committed ? POLLIN : 0) | (rq->send.committed ? POLLOUT : 0);
+            pfds[count].revents = 0;
+            ids[count++] = rq->id;
+        }
+        LeaveCriticalSection( &rio_cs );
+
+        pfds[0].fd = rio_wake_pipe[0];
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+
+        poll( pfds, count, -1 );
+        if (pfds[0].revents) while (read( rio_wake_pipe[0], buffer, sizeof(buffer) ) > 0) /* nothing */;
+
+        EnterCriticalSection( &rio_cs );
+        for (i = 1; i < count; i++)
+        {
+            if (pfds[i].revents && (rq = rio_find_queue( ids[i] )))
+            {
+                if (pfds[i].revents & (POLLIN | POLLERR | POLLHUP)) rio_process_queue( rq, pfds[i].fd, FALSE );
+                if (pfds[i].revents & (POLLOUT | POLLERR | POLLHUP)) rio_process_queue( rq, pfds[i].fd, TRUE );
+            }
+            if ((rq = rio_find_queue( ids[i] ))) release_sock_fd( rq->socket, pfds[i].fd );
+        }
+        LeaveCriticalSection( &rio_cs );
+    }
+    return 0;
+}
+
+static void rio_wake_thread(void)
+{
+    static const char byte;
+    write( rio_wake_pipe[1], &byte, 1 );
+}
+
+/* try the committed requests right away, and hand the rest over to the worker thread */
+static void rio_start_queue( struct rio_rq *rq )
+{
+    int fd = get_sock_fd( rq->socket, 0, NULL );
+
+    if (fd == -1) return;
+    if (rq->recv.committed) rio_process_queue( rq, fd, FALSE );
+    if (rq->send.committed) rio_process_queue( rq, fd, TRUE );
+    release_sock_fd( rq->socket, fd );
+    if (rq->recv.committed || rq->send.committed) rio_wake_thread();
+}
+
+/* cancel the requests of the queues associated to a closed socket */
+static void rio_close_socket( SOCKET s )
+{
+    struct rio_rq *rq, *next;
+
+    EnterCriticalSection( &rio_cs );
+    LIST_FOR_EACH_ENTRY_SAFE( rq, next, &rio_queues, struct rio_rq, entry )
+    {
+        if (rq->socket != s) continue;
+        while (rq->recv.count) rio_complete( rq, FALSE, WSA_OPERATION_ABORTED );
+        while (rq->send.count) rio_complete( rq, TRUE, WSA_OPERATION_ABORTED );
+        rq->recv_cq->reserved -= rq->recv.max;
+        rq->send_cq->reserved -= rq->send.max;
+        list_remove( &rq->entry );
+        HeapFree( GetProcessHeap(), 0, rq->recv.reqs );
+        HeapFree( GetProcessHeap(), 0, rq->send.reqs );
+        HeapFree( GetProcessHeap(), 0, rq );
+    }
+    LeaveCriticalSection( &rio_cs );
+}
+
+static BOOL rio_resize_queue( struct rio_queue *queue, ULONG max )
+{
+    struct rio_request *reqs;
+    ULONG i;
+
+    if (max == queue->max) return TRUE;
+    if (max < queue->count || !max) return FALSE;
+    if (!(reqs = HeapAlloc( GetProcessHeap(), 0, max * sizeof(*reqs) ))) return FALSE;
+    for (i = 0; i < queue->count; i++)
+        reqs[i] = queue->reqs[(queue->head + i) % queue->max];
+    HeapFree( GetProcessHeap(), 0, queue->reqs );
+    queue->reqs = reqs;
+    queue->max  = max;
+    queue->head = 0;
+    return TRUE;
+}
+
+static BOOL rio_get_buffer( const RIO_BUF *buf, char **data, ULONG *len )
+{
+    const struct rio_buffer *buffer = (const struct rio_buffer *)buf->BufferId;
+
+    if (!buffer || buf->BufferId == RIO_INVALID_BUFFERID) return FALSE;
+    if (buf->Offset > buffer->size || buf->Length > buffer->size - buf->Offset) return FALSE;
+    *data = buffer->data + buf->Offset;
+    *len  = buf->Length;
+    return TRUE;
+}
+
+/* queue a send or receive request */
+static BOOL rio_queue_request( RIO_RQ queue_id, PRIO_BUF data, ULONG count, PRIO_BUF remote,
+                               DWORD flags, PVOID context, BOOL send )
+{
+    struct rio_rq *rq = (struct rio_rq *)queue_id;
+    struct rio_queue *queue;
+    struct rio_request *req;
+    DWORD err = 0;
+
+    if (!rq)
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    EnterCriticalSection( &rio_cs );
+    queue = send ? &rq->send : &rq->recv;
+
+    if (flags & RIO_MSG_COMMIT_ONLY)
+    {
+        if (data || count) err = WSAEINVAL;
+        else queue->committed = queue->count;
+        goto done;
+    }
+    if (count > 1 || (!data && count))
+    {
+        err = WSAEINVAL;
+        goto done;
+    }
+    if (queue->count == queue->max)
+    {
+        err = WSAENOBUFS;
+        goto done;
+    }
+
+    req = &queue->reqs[(queue->head + queue->count) % queue->max];
+    req->context    = (ULONG_PTR)context;
+    req->data       = NULL;
+    req->len        = 0;
+    req->done       = 0;
+    req->flags      = flags;
+    req->remote     = NULL;
+    req->remote_len = 0;
+    req->addr_len   = 0;
+    if (count && !rio_get_buffer( data, &req->data, &req->len ))
+    {
+        err = WSAEINVAL;
+        goto done;
+    }
+    if (remote)
+    {
+        char *addr;
+        ULONG len;
+
+        if (!rio_get_buffer( remote, &addr, &len ))
+        {
+            err = WSAEINVAL;
+            goto done;
+        }
+        if (send)
+        {
+            if (!(req->addr_len = ws_sockaddr_ws2u( (struct WS_sockaddr *)addr, len, &req->addr )))
+            {
+                err = WSAEFAULT;
+                goto done;
+            }
+        }
+        else
+        {
+            req->remote     = (struct WS_sockaddr *)addr;
+            req->remote_len = len;
+        }
+    }
+    queue->count++;
+    if (!(flags & RIO_MSG_DEFER)) queue->committed = queue->count;
+
+done:
+    if (!err && queue->committed) rio_start_queue( rq );
+    LeaveCriticalSection( &rio_cs );
+    if (err) SetLastError( err );
+    return !err;
+}
+
+static BOOL WINAPI WS2_RIOReceive( RIO_RQ rq, PRIO_BUF data, ULONG count, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %#x, %p)\n", rq, data, count, flags, context );
+    return rio_queue_request( rq, data, count, NULL, flags, context, FALSE );
+}
+
+static int WINAPI WS2_RIOReceiveEx( RIO_RQ rq, PRIO_BUF data, ULONG count, PRIO_BUF local, PRIO_BUF remote,
+                                    PRIO_BUF control, PRIO_BUF flags_buf, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %p, %p, %p, %p, %#x, %p)\n", rq, data, count, local, remote, control,
+           flags_buf, flags, context );
+    if (local || control || flags_buf) FIXME( "local address, control and flags buffers not supported\n" );
+    return rio_queue_request( rq, data, count, remote, flags, context, FALSE );
+}
+
+static BOOL WINAPI WS2_RIOSend( RIO_RQ rq, PRIO_BUF data, ULONG count, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %#x, %p)\n", rq, data, count, flags, context );
+    return rio_queue_request( rq, data, count, NULL, flags, context, TRUE );
+}
+
+static BOOL WINAPI WS2_RIOSendEx( RIO_RQ rq, PRIO_BUF data, ULONG count, PRIO_BUF local, PRIO_BUF remote,
+                                  PRIO_BUF control, PRIO_BUF flags_buf, DWORD flags, PVOID context )
+{
+    TRACE( "(%p, %p, %u, %p, %p, %p, %p, %#x, %p)\n", rq, data, count, local, remote, control,
+           flags_buf, flags, context );
+    if (local || control || flags_buf) FIXME( "local address, control and flags buffers not supported\n" );
+    return rio_queue_request( rq, data, count, remote, flags, context, TRUE );
+}
+
+static RIO_CQ WINAPI WS2_RIOCreateCompletionQueue( DWORD size, PRIO_NOTIFICATION_COMPLETION notify )
+{
+    struct rio_cq *cq;
+
+    TRACE( "(%u, %p)\n", size, notify );
+
+    if (!size || size > RIO_MAX_CQ_SIZE ||
+        (notify && notify->Type != RIO_EVENT_COMPLETION && notify->Type != RIO_IOCP_COMPLETION))
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_CQ;
+    }
+    if (!(cq = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*cq) )) ||
+        !(cq->results = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*cq->results) )))
+    {
+        HeapFree( GetProcessHeap(), 0, cq );
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_CQ;
+    }
+    cq->size = size;
+    if (notify)
+    {
+        cq->notify = *notify;
+        cq->has_notify = TRUE;
+    }
+    return (RIO_CQ)cq;
+}
+
+static VOID WINAPI WS2_RIOCloseCompletionQueue( RIO_CQ cq_id )
+{
+    struct rio_cq *cq = (struct rio_cq *)cq_id;
+
+    TRACE( "(%p)\n", cq );
+
+    if (!cq) return;
+    HeapFree( GetProcessHeap(), 0, cq->results );
+    HeapFree( GetProcessHeap(), 0, cq );
+}
+
+static BOOL WINAPI WS2_RIOResizeCompletionQueue( RIO_CQ cq_id, DWORD size )
+{
+    struct rio_cq *cq = (struct rio_cq *)cq_id;
+    RIORESULT *results;
+    ULONG i;
+    DWORD err = 0;
+
+    TRACE( "(%p, %u)\n", cq, size );
+
+    if (!cq || !size || size > RIO_MAX_CQ_SIZE)
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    EnterCriticalSection( &rio_cs );
+    if (size < cq->count || size < cq->reserved) err = WSAEINVAL;
+    else if (!(results = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*results) ))) err = WSAENOBUFS;
+    else
+    {
+        for (i = 0; i < cq->count; i++) results[i] = cq->results[(cq->head + i) % cq->size];
+        HeapFree( GetProcessHeap(), 0, cq->results );
+        cq->results = results;
+        cq->size    = size;
+        cq->head    = 0;
+    }
+    LeaveCriticalSection( &rio_cs );
+    if (err) SetLastError( err );
+    return !err;
+}
+
+static RIO_RQ WINAPI WS2_RIOCreateRequestQueue( SOCKET s, ULONG max_recv, ULONG max_recv_bufs,
+                                                ULONG max_send, ULONG max_send_bufs,
+                                                RIO_CQ recv_cq, RIO_CQ send_cq, PVOID context )
+{
+    struct rio_cq *rcq = (struct rio_cq *)recv_cq, *scq = (struct rio_cq *)send_cq;
+    struct rio_rq *rq;
+    int fd, type;
+    socklen_t len = sizeof(type);
+    DWORD err = 0;
+
+    TRACE( "(%04lx, %u, %u, %u, %u, %p, %p, %p)\n", s, max_recv, max_recv_bufs, max_send,
+           max_send_bufs, recv_cq, send_cq, context );
+
+    if (!rcq || !scq || !max_recv || !max_send || max_recv_bufs > 1 || max_send_bufs > 1)
+    {
+        SetLastError( WSAEINVAL );
+        return RIO_INVALID_RQ;
+    }
+    if ((fd = get_sock_fd( s, 0, NULL )) == -1) return RIO_INVALID_RQ;
+    if (getsockopt( fd, SOL_SOCKET, SO_TYPE, &type, &len )) type = SOCK_STREAM;
+    release_sock_fd( s, fd );
+
+    if (!(rq = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*rq) )) ||
+        !(rq->recv.reqs = HeapAlloc( GetProcessHeap(), 0, max_recv * sizeof(*rq->recv.reqs) )) ||
+        !(rq->send.reqs = HeapAlloc( GetProcessHeap(), 0, max_send * sizeof(*rq->send.reqs) )))
+    {
+        if (rq) HeapFree( GetProcessHeap(), 0, rq->recv.reqs );
+        HeapFree( GetProcessHeap(), 0, rq );
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_RQ;
+    }
+    rq->socket   = s;
+    rq->context  = (ULONG_PTR)context;
+    rq->stream   = (type == SOCK_STREAM);
+    rq->recv_cq  = rcq;
+    rq->send_cq  = scq;
+    rq->recv.max = max_recv;
+    rq->send.max = max_send;
+
+    EnterCriticalSection( &rio_cs );
+    /* every request must be guaranteed a place in its completion queue */
+    if (rcq->reserved + max_recv > rcq->size ||
+        scq->reserved + (rcq == scq ? max_recv : 0) + max_send > scq->size)
+        err = WSAENOBUFS;
+    else if (!rio_thread)
+    {
+        if (pipe( rio_wake_pipe ) == -1) err = wsaErrno();
+        else
+        {
+            fcntl( rio_wake_pipe[0], F_SETFL, O_NONBLOCK );
+            fcntl( rio_wake_pipe[1], F_SETFL, O_NONBLOCK );
+            if (!(rio_thread = CreateThread( NULL, 0, rio_thread_proc, NULL, 0, NULL )))
+            {
+                close( rio_wake_pipe[0] );
+                close( rio_wake_pipe[1] );
+                err = WSAENOBUFS;
+            }
+        }
+    }
+    if (!err)
+    {
+        rcq->reserved += max_recv;
+        scq->reserved += max_send;
+        rq->id = ++rio_next_id;
+        list_add_tail( &rio_queues, &rq->entry );
+    }
+    LeaveCriticalSection( &rio_cs );
+
+    if (err)
+    {
+        HeapFree( GetProcessHeap(), 0, rq->recv.reqs );
+        HeapFree( GetProcessHeap(), 0, rq->send.reqs );
+        HeapFree( GetProcessHeap(), 0, rq );
+        SetLastError( err );
+        return RIO_INVALID_RQ;
+    }
+    return (RIO_RQ)rq;
+}
+
+static BOOL WINAPI WS2_RIOResizeRequestQueue( RIO_RQ rq_id, DWORD max_recv, DWORD max_send )
+{
+    struct rio_rq *rq = (struct rio_rq *)rq_id;
+    ULONG old_recv, old_send;
+    DWORD err = 0;
+
+    TRACE( "(%p, %u, %u)\n", rq, max_recv, max_send );
+
+    if (!rq)
+    {
+        SetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    EnterCriticalSection( &rio_cs );
+    old_recv = rq->recv.max;
+    old_send = rq->send.max;
+    if (rq->recv_cq->reserved - old_recv + max_recv > rq->recv_cq->size ||
+        rq->send_cq->reserved - old_send + max_send +
+        (rq->recv_cq == rq->send_cq ? max_recv - old_recv : 0) > rq->send_cq->size)
+        err = WSAENOBUFS;
+    else if (!rio_resize_queue( &rq->recv, max_recv ) || !rio_resize_queue( &rq->send, max_send ))
+    {
+        rio_resize_queue( &rq->recv, old_recv );
+        err = WSAEINVAL;
+    }
+    else
+    {
+        rq->recv_cq->reserved += max_recv - old_recv;
+        rq->send_cq->reserved += max_send - old_send;
+    }
+    LeaveCriticalSection( &rio_cs );
+    if (err) SetLastError( err );
+    return !err;
+}
+
+static ULONG WINAPI WS2_RIODequeueCompletion( RIO_CQ cq_id, PRIORESULT results, ULONG size )
+{
+    struct rio_cq *cq = (struct rio_cq *)cq_id;
+    ULONG i, count;
+
+    TRACE( "(%p, %p, %u)\n", cq, results, size );
+
+    if (!cq || !results) return RIO_CORRUPT_CQ;
+
+    EnterCriticalSection( &rio_cs );
+    count = min( size, cq->count );
+    for (i = 0; i < count; i++)
+        results[i] = cq->results[(cq->head + i) % cq->size];
+    cq->head = (cq->head + count) % cq->size;
+    cq->count -= count;
+    LeaveCriticalSection( &rio_cs );
+    return count;
+}
+
+static INT WINAPI WS2_RIONotify( RIO_CQ cq_id )
+{
+    struct rio_cq *cq = (struct rio_cq *)cq_id;
+    INT ret = ERROR_SUCCESS;
+
+    TRACE( "(%p)\n", cq );
+
+    if (!cq || !cq->has_notify) return WSAEINVAL;
+
+    EnterCriticalSection( &rio_cs );
+    if (cq->armed) ret = WSAEALREADY;
+    else
+    {
+        if (cq->notify.Type == RIO_EVENT_COMPLETION && cq->notify.u.Event.NotifyReset)
+            ResetEvent( cq->notify.u.Event.EventHandle );
+        cq->armed = TRUE;
+        if (cq->count) rio_notify( cq );
+    }
+    LeaveCriticalSection( &rio_cs );
+    return ret;
+}
+
+static RIO_BUFFERID WINAPI WS2_RIORegisterBuffer( PCHAR data, DWORD size )
+{
+    struct rio_buffer *buffer;
+
+    TRACE( "(%p, %u)\n", data, size );
+
+    if (!data || !size)
+    {
+        SetLastError( WSAEFAULT );
+        return RIO_INVALID_BUFFERID;
+    }
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, sizeof(*buffer) )))
+    {
+        SetLastError( WSAENOBUFS );
+        return RIO_INVALID_BUFFERID;
+    }
+    buffer->data = data;
+    buffer->size = size;
+    return (RIO_BUFFERID)buffer;
+}
+
+static VOID WINAPI WS2_RIODeregisterBuffer( RIO_BUFFERID id )
+{
+    TRACE( "(%p)\n", id );
+
+    if (id != RIO_INVALID_BUFFERID) HeapFree( GetProcessHeap(), 0, id );
+}
+
+static const RIO_EXTENSION_FUNCTION_TABLE rio_function_table =
+{
+    sizeof(RIO_EXTENSION_FUNCTION_TABLE),
+    WS2_RIOReceive,
+    WS2_RIOReceiveEx,
+    WS2_RIOSend,
+    WS2_RIOSendEx,
+    WS2_RIOCloseCompletionQueue,
+    WS2_RIOCreateCompletionQueue,
+    WS2_RIOCreateRequestQueue,
+    WS2_RIODequeueCompletion,
+    WS2_RIODeregisterBuffer,
+    WS2_RIONotify,
+    WS2_RIORegisterBuffer,
+    WS2_RIOResizeCompletionQueue,
+    WS2_RIOResizeRequestQueue
+};
+
+/***********************************************************************
+ *     Datagram receive prefetching
+ *
+ * Applications polling non-blocking datagram sockets usually drain them
+ * with one recvfrom per datagram.  Once a socket has delivered enough
+ * datagrams in a row without running dry, receives fetch all the pending
+ * datagrams at once with recvmmsg and queue them in userspace, so that
+ * the following receives don't need a system call.  select, WSAPoll and
+ * FIONREAD take the queued datagrams into account.  Prefetching stops
+ * again when the batches don't pay off, and is never started once event
+ * selection is used, as the server can't see the queued data.
+ */
+
+#define PREFETCH_BATCH      16       /* datagrams fetched at once */
+#define PREFETCH_MSG_SIZE   0x10000  /* large enough for any UDP datagram */
+#define PREFETCH_THRESHOLD  32       /* datagrams received in a row before prefetching */
+#define PREFETCH_MAX_MISSES 8        /* single datagram batches before giving up */
+#define PREFETCH_HASH_SIZE  64
+
+struct prefetch_msg
+{
+    unsigned int                len;
+    unsigned int                addr_len;
+    union generic_unix_sockaddr addr;
+};
+
+struct recv_prefetch
+{
+    struct list         entry;
+    SOCKET              socket;
+    BOOL                dgram;
+    BOOL                active;
+    unsigned int        streak;   /* datagrams received since the socket last ran dry */
+    unsigned int        misses;   /* batches in a row that returned a single datagram */
+    unsigned int        head;     /* first queued datagram */
+    unsigned int        count;    /* number of queued datagrams */
+    char               *data;     /* PREFETCH_BATCH buffers of PREFETCH_MSG_SIZE bytes */
+    struct prefetch_msg msgs[PREFETCH_BATCH];
+};
+
+static CRITICAL_SECTION prefetch_cs;
+static CRITICAL_SECTION_DEBUG prefetch_cs_debug =
+{
+    0, 0, &prefetch_cs,
+    { &prefetch_cs_debug.ProcessLocksList, &prefetch_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": prefetch_cs") }
+};
+static CRITICAL_SECTION prefetch_cs = { &prefetch_cs_debug, -1, 0, 0, 0, 0 };
+
+static struct list prefetch_hash[PREFETCH_HASH_SIZE];
+static LONG prefetch_queued;  /* number of sockets with queued datagrams */
+
+/* find the prefetch state of a socket; prefetch_cs must be held */
+static struct recv_prefetch *prefetch_find( SOCKET s, int fd )
+{
+    struct list *bucket = &prefetch_hash[(s >> 2) % PREFETCH_HASH_SIZE];
+    struct recv_prefetch *pf;
+
+    if (!bucket->next) list_init( bucket );
+    LIST_FOR_EACH_ENTRY( pf, bucket, struct recv_prefetch, entry )
+        if (pf->socket == s) return pf;
+
+    if (fd == -1) return NULL;
+    if (!(pf = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*pf) ))) return NULL;
+    pf->socket = s;
+    pf->dgram  = _get_fd_type( fd ) == SOCK_DGRAM;
+    list_add_head( bucket, &pf->entry );
+    return pf;
+}
+
+/* release the buffers once prefetching has stopped and the queue is drained; prefetch_cs must be held */
+static void prefetch_release( struct recv_prefetch *pf )
+{
+    if (pf->active || pf->count || !pf->data) return;
+    VirtualFree( pf->data, 0, MEM_RELEASE );
+    pf->data = NULL;
+}
+
+/* fetch the pending datagrams of a socket; prefetch_cs must be held */
+static int prefetch_fill( struct recv_prefetch *pf, int fd )
+{
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgs[PREFETCH_BATCH];
+    struct iovec iov[PREFETCH_BATCH];
+    int i, ret;
+
+    for (i = 0; i < PREFETCH_BATCH; i++)
+    {
+        iov[i].iov_base = pf->data + i * PREFETCH_MSG_SIZE;
+        iov[i].iov_len  = PREFETCH_MSG_SIZE;
+        memset( &msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr) );
+        msgs[i].msg_hdr.msg_name    = &pf->msgs[i].addr;
+        msgs[i].msg_hdr.msg_namelen = sizeof(pf->msgs[i].addr);
+        msgs[i].msg_hdr.msg_iov     = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen  = 1;
+    }
+    while ((ret = recvmmsg( fd, msgs, PREFETCH_BATCH, MSG_DONTWAIT, NULL )) == -1 && errno == EINTR);
+    if (ret <= 0) return ret;
+
+    for (i = 0; i < ret; i++)
+    {
+        pf->msgs[i].len      = msgs[i].msg_len;
+        pf->msgs[i].addr_len = msgs[i].msg_hdr.msg_namelen;
+    }
+    pf->head  = 0;
+    pf->count = ret;
+    prefetch_queued++;
+
+    if (ret > 1) pf->misses = 0;
+    else if (++pf->misses >= PREFETCH_MAX_MISSES)
+    {
+        TRACE( "socket %04lx: stopping prefetch\n", pf->socket );
+        pf->active = FALSE;
+        pf->streak = 0;
+    }
+    return ret;
+#else
+    errno = EAGAIN;
+    return -1;
+#endif
+}
+
+/***********************************************************************
+ *              prefetch_recv                (INTERNAL)
  *
- * Asynchronous callback for overlapped TransmitFile operations.
+ * Receive a datagram from the prefetch queue of a socket, refilling it
+ * if needed. Returns -2 if the socket isn't prefetching.
  */
-static NTSTATUS WS2_async_transmitfile( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS status )
+static int prefetch_recv( SOCKET s, int fd, struct ws2_async *wsa, int flags )
 {
-    struct ws2_transmitfile_async *wsa = user;
-    int fd;
+    struct recv_prefetch *pf;
+    struct prefetch_msg *msg;
+    const char *data;
+    unsigned int i, len;
+    int ret = -2, err = 0;
 
-    if (status == STATUS_ALERTED)
+    if (wsa->control || (flags & ~MSG_PEEK)) return -2;
+
+    EnterCriticalSection( &prefetch_cs );
+    if (!(pf = prefetch_find( s, -1 )) || (!pf->count && !pf->active)) goto done;
+
+    if (!pf->count && prefetch_fill( pf, fd ) <= 0)
     {
-        if (!(status = wine_server_handle_to_fd( wsa->write.hSocket, FILE_WRITE_DATA, &fd, NULL )))
+        err = errno;
+        ret = -1;
+        goto done;
+    }
+
+    msg  = &pf->msgs[pf->head];
+    data = pf->data + pf->head * PREFETCH_MSG_SIZE;
+    for (i = wsa->first_iovec, ret = 0; i < wsa->n_iovecs && ret < msg->len; i++)
+    {
+        len = min( wsa->iovec[i].iov_len, msg->len - ret );
+        memcpy( wsa->iovec[i].iov_base, data + ret, len );
+        ret += len;
+    }
+    if (wsa->addr && msg->addr_len)
+        ws_sockaddr_u2ws( &msg->addr.addr, wsa->addr, wsa->addrlen.ptr );
+
+    if (!(flags & MSG_PEEK))
+    {
+        pf->head++;
+        if (!--pf->count)
         {
-            status = WS2_transmitfile_base( fd, wsa );
-            wine_server_release_fd( wsa->write.hSocket, fd );
+            prefetch_queued--;
+            prefetch_release( pf );
         }
-        if (status == STATUS_PENDING)
-            return status;
     }
 
-    iosb->u.Status = status;
-    release_async_io( &wsa->io );
-    return status;
+done:
+    LeaveCriticalSection( &prefetch_cs );
+    if (ret == -1) errno = err;
+    return ret;
 }
 
-/***********************************************************************
- *     TransmitFile
- */
-static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
-                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
-                                     DWORD flags )
+/* update the receive streak of a socket after a direct receive */
+static void prefetch_update( SOCKET s, int fd, BOOL received )
 {
-    union generic_unix_sockaddr uaddr;
-    socklen_t uaddrlen = sizeof(uaddr);
-    struct ws2_transmitfile_async *wsa;
-    NTSTATUS status;
-    int fd;
+#ifdef HAVE_RECVMMSG
+    struct recv_prefetch *pf;
 
-    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
-            buffers, flags );
+    if (event_select_used) return;
 
-    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
-    if (fd == -1)
+    EnterCriticalSection( &prefetch_cs );
+    if (!(pf = prefetch_find( s, received ? fd : -1 ))) goto done;
+    if (!received)
+        pf->streak = 0;
+    else if (pf->dgram && !pf->active && ++pf->streak >= PREFETCH_THRESHOLD)
     {
-        WSASetLastError( WSAENOTSOCK );
-        return FALSE;
+        if (!pf->data && !(pf->data = VirtualAlloc( NULL, PREFETCH_BATCH * PREFETCH_MSG_SIZE,
+                                                    MEM_COMMIT, PAGE_READWRITE )))
+            goto done;
+        TRACE( "socket %04lx: starting prefetch\n", s );
+        pf->active = TRUE;
+        pf->misses = 0;
     }
-    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+done:
+    LeaveCriticalSection( &prefetch_cs );
+#endif
+}
+
+/* retrieve the size of the next queued datagram, for FIONREAD */
+static BOOL prefetch_get_next_size( SOCKET s, WS_u_long *size )
+{
+    struct recv_prefetch *pf;
+    BOOL ret = FALSE;
+
+    if (!prefetch_queued) return FALSE;
+
+    EnterCriticalSection( &prefetch_cs );
+    if ((pf = prefetch_find( s, -1 )) && pf->count)
     {
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAENOTCONN );
-        return FALSE;
+        *size = pf->msgs[pf->head].len;
+        ret = TRUE;
     }
-    if (flags)
-        FIXME("Flags are not currently supported (0x%x).\n", flags);
+    LeaveCriticalSection( &prefetch_cs );
+    return ret;
+}
+
+static BOOL prefetch_is_queued( SOCKET s )
+{
+    struct recv_prefetch *pf;
+    BOOL ret;
+
+    EnterCriticalSection( &prefetch_cs );
+    ret = (pf = prefetch_find( s, -1 )) && pf->count;
+    LeaveCriticalSection( &prefetch_cs );
+    return ret;
+}
+
+/* mark the sockets of a select read set with queued datagrams as readable */
+static BOOL prefetch_select_readable( const WS_fd_set *readfds, struct pollfd *fds )
+{
+    unsigned int i;
+    BOOL ret = FALSE;
 
-    if (h && GetFileType( h ) != FILE_TYPE_DISK)
+    if (!prefetch_queued || !readfds) return FALSE;
+
+    for (i = 0; i < readfds->fd_count; i++)
     {
-        FIXME("Non-disk file handles are not currently supported.\n");
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAEOPNOTSUPP );
-        return FALSE;
+        if (fds[i].fd == -1 || !prefetch_is_queued( readfds->fd_array[i] )) continue;
+        fds[i].revents |= POLLIN;
+        ret = TRUE;
     }
+    return ret;
+}
 
-    /* set reasonable defaults when requested */
-    if (!bytes_per_send)
-        bytes_per_send = (1 << 16); /* Depends on OS version: PAGE_SIZE, 2*PAGE_SIZE, or 2^16 */
+/* mark the WSAPoll entries of sockets with queued datagrams as readable,
+ * returns the number of entries that weren't signaled yet */
+static int prefetch_poll_readable( const WSAPOLLFD *wfds, struct pollfd *fds, ULONG count )
+{
+    ULONG i;
+    int ret = 0;
 
-    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + bytes_per_send,
-                                                                 WS2_async_transmitfile )))
+    if (!prefetch_queued) return 0;
+
+    for (i = 0; i < count; i++)
     {
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAEFAULT );
-        return FALSE;
+        if (fds[i].fd == -1 || !(fds[i].events & POLLIN) || !prefetch_is_queued( wfds[i].fd )) continue;
+        if (!fds[i].revents) ret++;
+        fds[i].revents |= POLLIN;
     }
-    if (buffers)
-        wsa->buffers = *buffers;
-    else
-        memset(&wsa->buffers, 0x0, sizeof(wsa->buffers));
-    wsa->buffer                = (char *)(wsa + 1);
-    wsa->file                  = h;
-    wsa->file_read             = 0;
-    wsa->file_bytes            = file_bytes;
-    wsa->bytes_per_send        = bytes_per_send;
-    wsa->flags                 = flags;
-    wsa->offset.QuadPart       = FILE_USE_FILE_POINTER_POSITION;
-    wsa->write.hSocket         = SOCKET2HANDLE(s);
-    wsa->write.addr            = NULL;
-    wsa->write.addrlen.val     = 0;
-    wsa->write.flags           = 0;
-    wsa->write.lpFlags         = &wsa->flags;
-    wsa->write.control         = NULL;
-    wsa->write.n_iovecs        = 0;
-    wsa->write.first_iovec     = 0;
-    wsa->write.user_overlapped = overlapped;
-    if (overlapped)
-    {
-        IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)overlapped;
-        int status;
+    return ret;
+}
 
-        wsa->offset.u.LowPart  = overlapped->u.s.Offset;
-        wsa->offset.u.HighPart = overlapped->u.s.OffsetHigh;
-        iosb->u.Status = STATUS_PENDING;
-        iosb->Information = 0;
-        status = register_async( ASYNC_TYPE_WRITE, SOCKET2HANDLE(s), &wsa->io,
-                                 overlapped->hEvent, NULL, NULL, iosb );
-        if(status != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
-        release_sock_fd( s, fd );
-        WSASetLastError( NtStatusToWSAError(status) );
-        return FALSE;
-    }
+/* free the prefetch state of a closed socket */
+static void prefetch_close_socket( SOCKET s )
+{
+    struct recv_prefetch *pf;
 
-    do
+    EnterCriticalSection( &prefetch_cs );
+    if ((pf = prefetch_find( s, -1 )))
     {
-        status = WS2_transmitfile_base( fd, wsa );
-        if (status == STATUS_PENDING)
-        {
-            /* block here */
-            do_block(fd, POLLOUT, -1);
-            _sync_sock_state(s); /* let wineserver notice connection */
-        }
+        if (pf->count) prefetch_queued--;
+        if (pf->data) VirtualFree( pf->data, 0, MEM_RELEASE );
+        list_remove( &pf->entry );
+        HeapFree( GetProcessHeap(), 0, pf );
     }
-    while (status == STATUS_PENDING);
-    release_sock_fd( s, fd );
-
-    if (status != STATUS_SUCCESS)
-        WSASetLastError( NtStatusToWSAError(status) );
-    HeapFree( GetProcessHeap(), 0, wsa );
-    return (status == STATUS_SUCCESS);
+    LeaveCriticalSection( &prefetch_cs );
 }
 
 /***********************************************************************
@@ -3384,8 +4636,11 @@ int WINAPI WS_closesocket(SOCKET s)
         if (fd >= 0)
         {
             release_sock_fd(s, fd);
+            rio_close_socket(s);
+            prefetch_close_socket(s);
             if (CloseHandle(SOCKET2HANDLE(s)))
                 res = 0;
+            invalidate_sock_cache(s, TRUE);
         }
         else
             SetLastError(WSAENOTSOCK);
@@ -4477,6 +5732,7 @@ static const char *debugstr_wsaioctl(DWORD code)
         IOCTL_NAME(WS_SIO_GET_GROUP_QOS);
         IOCTL_NAME(WS_SIO_GET_INTERFACE_LIST);
         /* IOCTL_NAME(WS_SIO_GET_INTERFACE_LIST_EX); */
+        IOCTL_NAME(WS_SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER);
         IOCTL_NAME(WS_SIO_GET_QOS);
         /* IOCTL_NAME(WS_SIO_IDEAL_SEND_BACKLOG_CHANGE);
         IOCTL_NAME(WS_SIO_IDEAL_SEND_BACKLOG_QUERY); */
@@ -4666,7 +5922,7 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
             (*(WS_u_long *) out_buff) = 0;
         else
 #endif
-        if (ioctl(fd, FIONREAD, out_buff ) == -1)
+        if (!prefetch_get_next_size( s, out_buff ) && ioctl(fd, FIONREAD, out_buff ) == -1)
             status = wsaErrno();
         release_sock_fd( s, fd );
         break;
@@ -4906,7 +6162,7 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
             EXTENSION_FUNCTION(WSAID_ACCEPTEX, WS2_AcceptEx)
             EXTENSION_FUNCTION(WSAID_GETACCEPTEXSOCKADDRS, WS2_GetAcceptExSockaddrs)
             EXTENSION_FUNCTION(WSAID_TRANSMITFILE, WS2_TransmitFile)
-            /* EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets) */
+            EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets)
             EXTENSION_FUNCTION(WSAID_WSARECVMSG, WS2_WSARecvMsg)
             EXTENSION_FUNCTION(WSAID_WSASENDMSG, WSASendMsg)
         };
@@ -4935,6 +6191,26 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
         status = WSAEOPNOTSUPP;
         break;
     }
+    case WS_SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER:
+    {
+        static const GUID rio_guid = WSAID_MULTIPLE_RIO;
+
+        if (!in_buff || in_size < sizeof(GUID) || !IsEqualGUID( &rio_guid, in_buff ))
+        {
+            FIXME("SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER %s: stub\n",
+                  in_buff ? debugstr_guid(in_buff) : "(null)");
+            status = WSAEOPNOTSUPP;
+            break;
+        }
+        if (!out_buff || out_size < sizeof(rio_function_table))
+        {
+            status = WSAEFAULT;
+            break;
+        }
+        memcpy( out_buff, &rio_function_table, sizeof(rio_function_table) );
+        total = sizeof(rio_function_table);
+        break;
+    }
     case WS_SIO_KEEPALIVE_VALS:
     {
         struct tcp_keepalive *k;
@@ -5171,12 +6447,69 @@ int WINAPI WS_recvfrom(SOCKET s, char *buf, INT len, int flags,
         return n;
 }
 
+/* get the unix fd of a socket for polling; the fd of the ntdll cache is used
+ * directly when possible, *dup is set if it had to be duplicated instead */
+static int get_poll_sock_fd( SOCKET s, DWORD access, BYTE *dup )
+{
+    int fd;
+
+    *dup = FALSE;
+    if (!wine_server_get_cached_fd( SOCKET2HANDLE(s), access, &fd, NULL )) return fd;
+    *dup = TRUE;
+    return get_sock_fd( s, access, NULL );
+}
+
+static inline void release_poll_sock_fd( SOCKET s, int fd, BYTE dup )
+{
+    if (dup) release_sock_fd( s, fd );
+}
+
+/* check if a socket is bound, caching the result once it is */
+static BOOL is_sock_bound( SOCKET s, int fd )
+{
+    if (get_sock_cache_flags( s, fd ) & SOCK_CACHE_BOUND) return TRUE;
+    if (is_fd_bound( fd, NULL, NULL ) != 1) return FALSE;
+    set_sock_cache_flags( s, fd, SOCK_CACHE_BOUND );
+    return TRUE;
+}
+
+static BOOL is_sock_dgram( SOCKET s, int fd )
+{
+    unsigned int flags = get_sock_cache_flags( s, fd );
+
+    if (!(flags & SOCK_CACHE_TYPE_KNOWN))
+    {
+        flags = SOCK_CACHE_TYPE_KNOWN;
+        if (_get_fd_type( fd ) == SOCK_DGRAM) flags |= SOCK_CACHE_DGRAM;
+        set_sock_cache_flags( s, fd, flags );
+    }
+    return (flags & SOCK_CACHE_DGRAM) != 0;
+}
+
+static BOOL is_sock_oob_inline( SOCKET s, int fd )
+{
+    unsigned int flags = get_sock_cache_flags( s, fd );
+
+    if (!(flags & SOCK_CACHE_OOB_KNOWN))
+    {
+        int oob_inlined = 0;
+        socklen_t olen = sizeof(oob_inlined);
+
+        getsockopt( fd, SOL_SOCKET, SO_OOBINLINE, (char *)&oob_inlined, &olen );
+        flags = SOCK_CACHE_OOB_KNOWN;
+        if (oob_inlined) flags |= SOCK_CACHE_OOBINLINE;
+        set_sock_cache_flags( s, fd, flags );
+    }
+    return (flags & SOCK_CACHE_OOBINLINE) != 0;
+}
+
 /* allocate a poll array for the corresponding fd sets */
 static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set *writefds,
                                        const WS_fd_set *exceptfds, int *count_ptr )
 {
     unsigned int i, j = 0, count = 0;
     struct pollfd *fds;
+    BYTE *dup;
     struct per_thread_data *ptb = get_per_thread_data();
 
     if (readfds) count += readfds->fd_count;
@@ -5192,31 +6525,40 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
     /* check if the cache can hold all descriptors, if not do the resizing */
     if (ptb->fd_count < count)
     {
-        if (!(fds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(fds[0]))))
+        fds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(fds[0]));
+        dup = HeapAlloc(GetProcessHeap(), 0, count * sizeof(dup[0]));
+        if (!fds || !dup)
         {
+            HeapFree(GetProcessHeap(), 0, fds);
+            HeapFree(GetProcessHeap(), 0, dup);
             SetLastError( ERROR_NOT_ENOUGH_MEMORY );
             return NULL;
         }
         HeapFree(GetProcessHeap(), 0, ptb->fd_cache);
+        HeapFree(GetProcessHeap(), 0, ptb->fd_dup);
         ptb->fd_cache = fds;
+        ptb->fd_dup = dup;
         ptb->fd_count = count;
     }
     else
+    {
         fds = ptb->fd_cache;
+        dup = ptb->fd_dup;
+    }
 
     if (readfds)
         for (i = 0; i < readfds->fd_count; i++, j++)
         {
-            fds[j].fd = get_sock_fd( readfds->fd_array[i], FILE_READ_DATA, NULL );
+            fds[j].fd = get_poll_sock_fd( readfds->fd_array[i], FILE_READ_DATA, &dup[j] );
             if (fds[j].fd == -1) goto failed;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
+            if (is_sock_bound( readfds->fd_array[i], fds[j].fd ))
             {
                 fds[j].events = POLLIN;
             }
             else
             {
-                release_sock_fd( readfds->fd_array[i], fds[j].fd );
+                release_poll_sock_fd( readfds->fd_array[i], fds[j].fd, dup[j] );
                 fds[j].fd = -1;
                 fds[j].events = 0;
             }
@@ -5224,17 +6566,17 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
     if (writefds)
         for (i = 0; i < writefds->fd_count; i++, j++)
         {
-            fds[j].fd = get_sock_fd( writefds->fd_array[i], FILE_WRITE_DATA, NULL );
+            fds[j].fd = get_poll_sock_fd( writefds->fd_array[i], FILE_WRITE_DATA, &dup[j] );
             if (fds[j].fd == -1) goto failed;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1 ||
-                _get_fd_type(fds[j].fd) == SOCK_DGRAM)
+            if (is_sock_bound( writefds->fd_array[i], fds[j].fd ) ||
+                is_sock_dgram( writefds->fd_array[i], fds[j].fd ))
             {
                 fds[j].events = POLLOUT;
             }
             else
             {
-                release_sock_fd( writefds->fd_array[i], fds[j].fd );
+                release_poll_sock_fd( writefds->fd_array[i], fds[j].fd, dup[j] );
                 fds[j].fd = -1;
                 fds[j].events = 0;
             }
@@ -5242,24 +6584,20 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
     if (exceptfds)
         for (i = 0; i < exceptfds->fd_count; i++, j++)
         {
-            fds[j].fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
+            fds[j].fd = get_poll_sock_fd( exceptfds->fd_array[i], 0, &dup[j] );
             if (fds[j].fd == -1) goto failed;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
+            if (is_sock_bound( exceptfds->fd_array[i], fds[j].fd ))
             {
-                int oob_inlined = 0;
-                socklen_t olen = sizeof(oob_inlined);
-
                 fds[j].events = POLLHUP;
 
                 /* Check if we need to test for urgent data or not */
-                getsockopt(fds[j].fd, SOL_SOCKET, SO_OOBINLINE, (char*) &oob_inlined, &olen);
-                if (!oob_inlined)
+                if (!is_sock_oob_inline( exceptfds->fd_array[i], fds[j].fd ))
                     fds[j].events |= POLLPRI;
             }
             else
             {
-                release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
+                release_poll_sock_fd( exceptfds->fd_array[i], fds[j].fd, dup[j] );
                 fds[j].fd = -1;
                 fds[j].events = 0;
             }
@@ -5271,13 +6609,13 @@ failed:
     j = 0;
     if (readfds)
         for (i = 0; i < readfds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
+            if (fds[j].fd != -1) release_poll_sock_fd( readfds->fd_array[i], fds[j].fd, dup[j] );
     if (writefds)
         for (i = 0; i < writefds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
+            if (fds[j].fd != -1) release_poll_sock_fd( writefds->fd_array[i], fds[j].fd, dup[j] );
     if (exceptfds)
         for (i = 0; i < exceptfds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
+            if (fds[j].fd != -1) release_poll_sock_fd( exceptfds->fd_array[i], fds[j].fd, dup[j] );
     return NULL;
 }
 
@@ -5286,24 +6624,25 @@ failed:
 static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefds,
                               const WS_fd_set *exceptfds, struct pollfd *fds )
 {
+    const BYTE *dup = get_per_thread_data()->fd_dup;
     unsigned int i, j = 0;
 
     if (readfds)
     {
         for (i = 0; i < readfds->fd_count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
+            if (fds[j].fd != -1) release_poll_sock_fd( readfds->fd_array[i], fds[j].fd, dup[j] );
     }
     if (writefds)
     {
         for (i = 0; i < writefds->fd_count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
+            if (fds[j].fd != -1) release_poll_sock_fd( writefds->fd_array[i], fds[j].fd, dup[j] );
     }
     if (exceptfds)
     {
         for (i = 0; i < exceptfds->fd_count; i++, j++)
         {
             if (fds[j].fd == -1) continue;
-            release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
+            release_poll_sock_fd( exceptfds->fd_array[i], fds[j].fd, dup[j] );
             if (fds[j].revents & POLLHUP)
             {
                 int fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
@@ -5345,6 +6684,164 @@ static int do_poll(struct pollfd *pollfds, int count, int timeout)
     return ret;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+
+static BOOL use_select_epoll(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINESELECTEPOLL" );
+        enabled = env && atoi( env );
+    }
+    return enabled;
+}
+
+/* register a poll set into the epoll set of the thread; entries sharing the
+ * same unix fd are chained and registered once with the union of their events */
+static BOOL register_select_epoll( struct select_epoll *epoll, const struct pollfd *fds, int count )
+{
+    struct epoll_event ev;
+    int i, j, *first = NULL, max_fd = -1;
+
+    if (epoll->size < count)
+    {
+        unsigned int size = max( count, 64 );
+        struct pollfd *set = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*set) );
+        int *next = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*next) );
+        struct epoll_event *events = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*events) );
+
+        if (!set || !next || !events)
+        {
+            HeapFree( GetProcessHeap(), 0, set );
+            HeapFree( GetProcessHeap(), 0, next );
+            HeapFree( GetProcessHeap(), 0, events );
+            return FALSE;
+        }
+        HeapFree( GetProcessHeap(), 0, epoll->set );
+        HeapFree( GetProcessHeap(), 0, epoll->next );
+        HeapFree( GetProcessHeap(), 0, epoll->events );
+        epoll->set    = set;
+        epoll->next   = next;
+        epoll->events = events;
+        epoll->size   = size;
+    }
+
+    /* starting over with a new epoll fd is cheaper than removing the old entries */
+    epoll->count = 0;
+    if (epoll->fd != -1) close( epoll->fd );
+    if ((epoll->fd = epoll_create( count )) == -1) return FALSE;
+    fcntl( epoll->fd, F_SETFD, FD_CLOEXEC );
+
+    for (i = 0; i < count; i++) if (fds[i].fd > max_fd) max_fd = fds[i].fd;
+    if (max_fd >= 0 && !(first = HeapAlloc( GetProcessHeap(), 0, (max_fd + 1) * sizeof(*first) )))
+        return FALSE;
+    for (i = 0; i <= max_fd; i++) first[i] = -1;
+
+    for (i = 0; i < count; i++)
+    {
+        epoll->set[i] = fds[i];
+        epoll->next[i] = -1;
+        if (fds[i].fd == -1 || !fds[i].events) continue;
+        if ((j = first[fds[i].fd]) == -1) first[fds[i].fd] = i;
+        else
+        {
+            epoll->next[i] = epoll->next[j];
+            epoll->next[j] = i;
+            epoll->set[j].events |= fds[i].events;
+        }
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (fds[i].fd == -1 || !fds[i].events || first[fds[i].fd] != i) continue;
+        ev.events = epoll->set[i].events;
+        ev.data.u32 = i;
+        if (epoll_ctl( epoll->fd, EPOLL_CTL_ADD, fds[i].fd, &ev ) == -1)
+        {
+            WARN( "failed to add fd %d: %s\n", fds[i].fd, strerror(errno) );
+            HeapFree( GetProcessHeap(), 0, first );
+            return FALSE;
+        }
+    }
+    /* keep the original events, they are used to match the set on the next call */
+    for (i = 0; i < count; i++) epoll->set[i].events = fds[i].events;
+
+    HeapFree( GetProcessHeap(), 0, first );
+    epoll->count = count;
+    epoll->generation = sock_generation;
+    return TRUE;
+}
+
+/***********************************************************************
+ *              do_epoll                (INTERNAL)
+ *
+ * Wait on a poll set through a persistent per-thread epoll set, enabled
+ * with WINESELECTEPOLL=1. Servers calling select in a loop usually pass
+ * the same sockets every time, so the epoll set is only registered again
+ * when the poll set or any socket handle changes. Returns -2 when the
+ * epoll set can't be used.
+ */
+static int do_epoll( struct pollfd *fds, int count, int timeout )
+{
+    struct per_thread_data *ptb = get_per_thread_data();
+    struct select_epoll *epoll = ptb->epoll;
+    DWORD start = GetTickCount();
+    int i, j, n, ret, wait = timeout;
+
+    if (!use_select_epoll()) return -2;
+
+    if (!epoll)
+    {
+        if (!(epoll = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*epoll) ))) return -2;
+        epoll->fd = -1;
+        ptb->epoll = epoll;
+    }
+
+    if (epoll->count == count && epoll->generation == sock_generation)
+    {
+        for (i = 0; i < count; i++)
+            if (epoll->set[i].fd != fds[i].fd || epoll->set[i].events != fds[i].events) break;
+    }
+    else i = -1;
+    if (i != count)
+    {
+        TRACE( "registering %d fds\n", count );
+        if (!register_select_epoll( epoll, fds, count )) return -2;
+    }
+
+    while ((n = epoll_wait( epoll->fd, epoll->events, count, wait )) == -1)
+    {
+        if (errno != EINTR) return -1;
+        if (timeout < 0) continue;
+        if ((wait = timeout - (GetTickCount() - start)) <= 0)
+        {
+            n = 0;
+            break;
+        }
+    }
+
+    for (i = 0; i < count; i++) fds[i].revents = 0;
+    for (i = ret = 0; i < n; i++)
+    {
+        for (j = epoll->events[i].data.u32; j != -1; j = epoll->next[j])
+        {
+            fds[j].revents = epoll->events[i].events & (fds[j].events | POLLERR | POLLHUP);
+            if (fds[j].revents) ret++;
+        }
+    }
+    return ret;
+}
+
+#else  /* HAVE_SYS_EPOLL_H */
+
+static int do_epoll( struct pollfd *fds, int count, int timeout )
+{
+    return -2;
+}
+
+#endif  /* HAVE_SYS_EPOLL_H */
+
 /* map the poll results back into the Windows fd sets */
 static int get_poll_results( WS_fd_set *readfds, WS_fd_set *writefds, WS_fd_set *exceptfds,
                              const struct pollfd *fds )
@@ -5404,8 +6901,11 @@ int WINAPI WS_select(int nfds, WS_fd_set *ws_readfds,
 
     if (ws_timeout)
         timeout = (ws_timeout->tv_sec * 1000) + (ws_timeout->tv_usec + 999) / 1000;
+    if (prefetch_select_readable( ws_readfds, pollfds )) timeout = 0;
 
-    ret = do_poll(pollfds, count, timeout);
+    if ((ret = do_epoll( pollfds, count, timeout )) == -2)
+        ret = do_poll(pollfds, count, timeout);
+    if (ret != -1) prefetch_select_readable( ws_readfds, pollfds );
     release_poll_fds( ws_readfds, ws_writefds, ws_exceptfds, pollfds );
 
     if (ret == -1) SetLastError(wsaErrno());
@@ -5420,6 +6920,7 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
 {
     int i, ret;
     struct pollfd *ufds;
+    BYTE *dup;
 
     if (!count)
     {
@@ -5432,26 +6933,30 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
         return SOCKET_ERROR;
     }
 
-    if (!(ufds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(ufds[0]))))
+    if (!(ufds = HeapAlloc(GetProcessHeap(), 0, count * (sizeof(ufds[0]) + sizeof(dup[0])))))
     {
         SetLastError(WSAENOBUFS);
         return SOCKET_ERROR;
     }
+    dup = (BYTE *)(ufds + count);
 
     for (i = 0; i < count; i++)
     {
-        ufds[i].fd = get_sock_fd(wfds[i].fd, 0, NULL);
+        ufds[i].fd = get_poll_sock_fd(wfds[i].fd, 0, &dup[i]);
         ufds[i].events = convert_poll_w2u(wfds[i].events);
         ufds[i].revents = 0;
     }
+    if (prefetch_poll_readable( wfds, ufds, count )) timeout = 0;
 
-    ret = do_poll(ufds, count, timeout);
+    if ((ret = do_epoll( ufds, count, timeout )) == -2)
+        ret = do_poll(ufds, count, timeout);
+    if (ret != -1) ret += prefetch_poll_readable( wfds, ufds, count );
 
     for (i = 0; i < count; i++)
     {
         if (ufds[i].fd != -1)
         {
-            release_sock_fd(wfds[i].fd, ufds[i].fd);
+            release_poll_sock_fd(wfds[i].fd, ufds[i].fd, dup[i]);
             if (ufds[i].revents & POLLHUP)
             {
                 /* Check if the socket still exists */
@@ -5822,7 +7327,6 @@ int WINAPI WS_setsockopt(SOCKET s, int level, int optname,
         case WS_SO_BROADCAST:
         case WS_SO_ERROR:
         case WS_SO_KEEPALIVE:
-        case WS_SO_OOBINLINE:
         /* BSD socket SO_REUSEADDR is not 100% compatible to winsock semantics.
          * however, using it the BSD way fixes bug 8513 and seems to be what
          * most programmers assume, anyway */
@@ -5832,6 +7336,12 @@ int WINAPI WS_setsockopt(SOCKET s, int level, int optname,
             convert_sockopt(&level, &optname);
             break;
 
+        /* the urgent data check of select depends on it */
+        case WS_SO_OOBINLINE:
+            invalidate_sock_cache(s, FALSE);
+            convert_sockopt(&level, &optname);
+            break;
+
         /* SO_DEBUG is a privileged operation, ignore it. */
         case WS_SO_DEBUG:
             TRACE("Ignoring SO_DEBUG\n");
@@ -7234,6 +8744,8 @@ int WINAPI WSAEnumNetworkEvents(SOCKET s, WSAEVENT hEvent, LPWSANETWORKEVENTS lp
 
     TRACE("%04lx, hEvent %p, lpEvent %p\n", s, hEvent, lpEvent );
 
+    if (hEvent) wine_server_flush_sync_object( hEvent );
+
     SERVER_START_REQ( get_socket_event )
     {
         req->handle  = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -7265,6 +8777,10 @@ int WINAPI WSAEventSelect(SOCKET s, WSAEVENT hEvent, LONG lEvent)
 
     TRACE("%04lx, hEvent %p, event %08x\n", s, hEvent, lEvent);
 
+    if (lEvent) event_select_used = TRUE;
+
+    if (hEvent) wine_server_flush_sync_object( hEvent );
+
     SERVER_START_REQ( set_socket_event )
     {
         req->handle = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -7334,6 +8850,8 @@ INT WINAPI WSAAsyncSelect(SOCKET s, HWND hWnd, UINT uMsg, LONG lEvent)
 
     TRACE("%04lx, hWnd %p, uMsg %08x, event %08x\n", s, hWnd, uMsg, lEvent);
 
+    if (lEvent) event_select_used = TRUE;
+
     SERVER_START_REQ( set_socket_event )
     {
         req->handle = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -7429,6 +8947,8 @@ SOCKET WINAPI WSASocketW(int af, int type, int protocol,
 
     /* hack for WSADuplicateSocket */
     if (lpProtocolInfo && lpProtocolInfo->dwServiceFlags4 == 0xff00ff00) {
+      /* the original socket may have event selection enabled in another process */
+      event_select_used = TRUE;
       ret = lpProtocolInfo->dwServiceFlags3;
       TRACE("\tgot duplicate %04lx\n", ret);
       return ret;
@@ -7529,6 +9049,7 @@ SOCKET WINAPI WSASocketW(int af, int type, int protocol,
     if (ret)
     {
         TRACE("\tcreated %04lx\n", ret );
+        invalidate_sock_cache( ret, TRUE );
         if (ipxptype > 0)
             set_ipx_packettype(ret, ipxptype);
 
@@ -7930,7 +9451,11 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
     flags = convert_flags(wsa->flags);
     for (;;)
     {
-        n = WS2_recv( fd, wsa, flags );
+        if ((n = prefetch_recv( s, fd, wsa, flags )) == -2)
+        {
+            n = WS2_recv( fd, wsa, flags );
+            if (!overlapped && !flags && !wsa->control) prefetch_update( s, fd, n != -1 );
+        }
         if (n == -1)
         {
             /* Unix-like systems return EINVAL when attempting to read OOB data from
@@ -7981,7 +9506,7 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
             }
             else NtQueueApcThread( GetCurrentThread(), (PNTAPCFUNC)ws2_async_apc,
                                    (ULONG_PTR)wsa, (ULONG_PTR)iosb, 0 );
-            _enable_event(SOCKET2HANDLE(s), FD_READ, 0, 0);
+            reenable_event_after_io( s, FD_READ );
             return 0;
         }
 
@@ -8029,7 +9554,7 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
     TRACE(" -> %i bytes\n", n);
     if (wsa != &localwsa) HeapFree( GetProcessHeap(), 0, wsa );
     release_sock_fd( s, fd );
-    _enable_event(SOCKET2HANDLE(s), FD_READ, 0, 0);
+    reenable_event_after_io( s, FD_READ );
     SetLastError(ERROR_SUCCESS);
 
     return 0;
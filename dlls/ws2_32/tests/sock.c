@@ -2334,6 +2334,104 @@ static void test_UDP(void)
     }
 }
 
+static void test_UDP_burst(void)
+{
+    /* A burst of datagrams drained with non-blocking recvfrom() must come out
+       intact and in order, with select(), WSAPoll(), FIONREAD and MSG_PEEK
+       agreeing about the pending data. */
+    struct sockaddr_in addr, from;
+    struct timeval timeout = {1, 0};
+    char buf[256], expect[256];
+    int i, ret, len, fromlen;
+    SOCKET src, dst;
+    WSAPOLLFD pfd;
+    fd_set readfds;
+    u_long arg = 1;
+
+    src = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(src != INVALID_SOCKET, "socket failed, error %d\n", WSAGetLastError());
+    dst = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(dst != INVALID_SOCKET, "socket failed, error %d\n", WSAGetLastError());
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ret = bind(dst, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %d\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(dst, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+    ret = ioctlsocket(dst, FIONBIO, &arg);
+    ok(!ret, "ioctlsocket failed, error %d\n", WSAGetLastError());
+
+    for (i = 0; i < 100; i++)
+    {
+        len = 1 + i * 2;
+        memset(buf, i, len);
+        ret = sendto(src, buf, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+        ok(ret == len, "sendto returned %d, error %d\n", ret, WSAGetLastError());
+    }
+
+    for (i = 0; i < 100; i++)
+    {
+        len = 1 + i * 2;
+        memset(expect, i, len);
+
+        FD_ZERO(&readfds);
+        FD_SET(dst, &readfds);
+        ret = select(0, &readfds, NULL, NULL, &timeout);
+        ok(ret == 1, "datagram %d: select returned %d\n", i, ret);
+        if (ret != 1) break;
+
+        if (pWSAPoll)
+        {
+            pfd.fd = dst;
+            pfd.events = POLLRDNORM;
+            pfd.revents = 0;
+            ret = pWSAPoll(&pfd, 1, 0);
+            ok(ret == 1, "datagram %d: WSAPoll returned %d\n", i, ret);
+            ok(pfd.revents & POLLRDNORM, "datagram %d: got revents %#x\n", i, pfd.revents);
+        }
+
+        arg = 0;
+        ret = ioctlsocket(dst, FIONREAD, &arg);
+        ok(!ret, "ioctlsocket failed, error %d\n", WSAGetLastError());
+        ok(arg >= len, "datagram %d: FIONREAD returned %u\n", i, arg);
+
+        if (i % 3 == 0)
+        {
+            memset(buf, 0xcc, sizeof(buf));
+            ret = recv(dst, buf, sizeof(buf), MSG_PEEK);
+            ok(ret == len, "datagram %d: peek returned %d, error %d\n", i, ret, WSAGetLastError());
+            ok(!memcmp(buf, expect, len), "datagram %d: wrong peeked data\n", i);
+        }
+
+        memset(buf, 0xcc, sizeof(buf));
+        memset(&from, 0, sizeof(from));
+        fromlen = sizeof(from);
+        ret = recvfrom(dst, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fromlen);
+        ok(ret == len, "datagram %d: recvfrom returned %d, error %d\n", i, ret, WSAGetLastError());
+        ok(!memcmp(buf, expect, len), "datagram %d: wrong data\n", i);
+        ok(fromlen == sizeof(from), "datagram %d: got address length %d\n", i, fromlen);
+        ok(from.sin_addr.s_addr == inet_addr("127.0.0.1"), "datagram %d: got address %s\n",
+           i, inet_ntoa(from.sin_addr));
+    }
+
+    timeout.tv_sec = 0;
+    FD_ZERO(&readfds);
+    FD_SET(dst, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &timeout);
+    ok(!ret, "select returned %d\n", ret);
+
+    WSASetLastError(0xdeadbeef);
+    ret = recvfrom(dst, buf, sizeof(buf), 0, NULL, NULL);
+    ok(ret == SOCKET_ERROR, "recvfrom returned %d\n", ret);
+    ok(WSAGetLastError() == WSAEWOULDBLOCK, "got error %d\n", WSAGetLastError());
+
+    closesocket(src);
+    closesocket(dst);
+}
+
 static DWORD WINAPI do_getservbyname( void *param )
 {
     struct {
@@ -8783,7 +8881,10 @@ static void test_TransmitFile(void)
 {
     DWORD num_bytes, err, file_size, total_sent;
     GUID transmitFileGuid = WSAID_TRANSMITFILE;
+    GUID transmitPacketsGuid = WSAID_TRANSMITPACKETS;
     LPFN_TRANSMITFILE pTransmitFile = NULL;
+    LPFN_TRANSMITPACKETS pTransmitPackets = NULL;
+    TRANSMIT_PACKETS_ELEMENT elements[3];
     HANDLE file = INVALID_HANDLE_VALUE;
     char header_msg[] = "hello world";
     char footer_msg[] = "goodbye!!!";
@@ -8987,6 +9088,34 @@ static void test_TransmitFile(void)
     ok(memcmp(buf, &footer_msg[0], sizeof(footer_msg)) == 0,
        "TransmitFile footer buffer did not match!\n");
 
+    /* Test TransmitPackets with memory and file elements */
+    iret = WSAIoctl(client, SIO_GET_EXTENSION_FUNCTION_POINTER, &transmitPacketsGuid, sizeof(transmitPacketsGuid),
+                    &pTransmitPackets, sizeof(pTransmitPackets), &num_bytes, NULL, NULL);
+    ok(!iret, "WSAIoctl failed to get TransmitPackets with ret %d + errno %d\n", iret, WSAGetLastError());
+    if (!iret)
+    {
+        memset(elements, 0, sizeof(elements));
+        elements[0].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[0].cLength = sizeof(header_msg);
+        elements[0].pBuffer = header_msg;
+        elements[1].dwElFlags = TP_ELEMENT_FILE;
+        elements[1].cLength = 0;
+        elements[1].hFile = file;
+        elements[1].nFileOffset.QuadPart = 0;
+        elements[2].dwElFlags = TP_ELEMENT_MEMORY;
+        elements[2].cLength = sizeof(footer_msg);
+        elements[2].pBuffer = footer_msg;
+        bret = pTransmitPackets(client, elements, 3, 0, NULL, 0);
+        ok(bret, "TransmitPackets failed unexpectedly, error %d.\n", WSAGetLastError());
+        iret = recv(dest, buf, sizeof(header_msg), 0);
+        ok(memcmp(buf, &header_msg[0], sizeof(header_msg)) == 0,
+           "TransmitPackets header buffer did not match!\n");
+        compare_file(file, dest, 0);
+        iret = recv(dest, buf, sizeof(footer_msg), 0);
+        ok(memcmp(buf, &footer_msg[0], sizeof(footer_msg)) == 0,
+           "TransmitPackets footer buffer did not match!\n");
+    }
+
     /* Test TransmitFile with a UDP datagram socket */
     closesocket(client);
     client = socket(AF_INET, SOCK_DGRAM, 0);
@@ -9002,6 +9131,107 @@ cleanup:
     closesocket(server);
 }
 
+static void test_rio(void)
+{
+    GUID rio_guid = WSAID_MULTIPLE_RIO;
+    RIO_EXTENSION_FUNCTION_TABLE rio;
+    struct sockaddr_in addr;
+    SOCKET src, dst;
+    RIO_BUFFERID buffer_id;
+    RIO_CQ cq;
+    RIO_RQ src_rq, dst_rq;
+    RIO_BUF send_buf, recv_buf;
+    RIORESULT results[2];
+    char buffer[64];
+    DWORD size, start;
+    ULONG count, total = 0;
+    int ret, len;
+    BOOL bret;
+
+    src = WSASocketA(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_REGISTERED_IO);
+    dst = WSASocketA(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_REGISTERED_IO);
+    ok(src != INVALID_SOCKET && dst != INVALID_SOCKET, "failed to create sockets, error %d\n", WSAGetLastError());
+
+    memset(&rio, 0, sizeof(rio));
+    ret = WSAIoctl(src, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &rio_guid, sizeof(rio_guid),
+                   &rio, sizeof(rio), &size, NULL, NULL);
+    if (ret)
+    {
+        win_skip("RIO is not supported\n");
+        closesocket(src);
+        closesocket(dst);
+        return;
+    }
+    ok(rio.cbSize == sizeof(rio), "got size %u\n", rio.cbSize);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    ret = bind(dst, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "bind failed, error %d\n", WSAGetLastError());
+    len = sizeof(addr);
+    ret = getsockname(dst, (struct sockaddr *)&addr, &len);
+    ok(!ret, "getsockname failed, error %d\n", WSAGetLastError());
+    ret = connect(src, (struct sockaddr *)&addr, sizeof(addr));
+    ok(!ret, "connect failed, error %d\n", WSAGetLastError());
+
+    memset(buffer, 0, sizeof(buffer));
+    strcpy(buffer, "registered");
+    buffer_id = rio.RIORegisterBuffer(buffer, sizeof(buffer));
+    ok(buffer_id != RIO_INVALID_BUFFERID, "RIORegisterBuffer failed, error %d\n", WSAGetLastError());
+
+    cq = rio.RIOCreateCompletionQueue(8, NULL);
+    ok(cq != RIO_INVALID_CQ, "RIOCreateCompletionQueue failed, error %d\n", WSAGetLastError());
+    dst_rq = rio.RIOCreateRequestQueue(dst, 1, 1, 1, 1, cq, cq, (void *)0xdead);
+    ok(dst_rq != RIO_INVALID_RQ, "RIOCreateRequestQueue failed, error %d\n", WSAGetLastError());
+    src_rq = rio.RIOCreateRequestQueue(src, 1, 1, 1, 1, cq, cq, (void *)0xbeef);
+    ok(src_rq != RIO_INVALID_RQ, "RIOCreateRequestQueue failed, error %d\n", WSAGetLastError());
+
+    recv_buf.BufferId = buffer_id;
+    recv_buf.Offset = 32;
+    recv_buf.Length = 32;
+    bret = rio.RIOReceive(dst_rq, &recv_buf, 1, 0, (void *)1);
+    ok(bret, "RIOReceive failed, error %d\n", WSAGetLastError());
+    bret = rio.RIOReceive(dst_rq, &recv_buf, 1, 0, (void *)2);
+    ok(!bret, "RIOReceive succeeded with a full queue\n");
+    ok(WSAGetLastError() == WSAENOBUFS, "got error %d\n", WSAGetLastError());
+
+    send_buf.BufferId = buffer_id;
+    send_buf.Offset = 0;
+    send_buf.Length = 11;
+    bret = rio.RIOSend(src_rq, &send_buf, 1, 0, (void *)3);
+    ok(bret, "RIOSend failed, error %d\n", WSAGetLastError());
+
+    start = GetTickCount();
+    while (total < 2 && GetTickCount() - start < 2000)
+    {
+        count = rio.RIODequeueCompletion(cq, results + total, 2 - total);
+        ok(count != RIO_CORRUPT_CQ, "RIODequeueCompletion failed\n");
+        if (count == RIO_CORRUPT_CQ) break;
+        total += count;
+        if (total < 2) Sleep(10);
+    }
+    ok(total == 2, "got %u completions\n", total);
+    while (total--)
+    {
+        ok(!results[total].Status, "got status %d\n", results[total].Status);
+        ok(results[total].BytesTransferred == 11, "got %u bytes\n", results[total].BytesTransferred);
+        if (results[total].RequestContext == 1)
+            ok(results[total].SocketContext == 0xdead, "got context %s\n",
+               wine_dbgstr_longlong(results[total].SocketContext));
+        else
+            ok(results[total].RequestContext == 3 && results[total].SocketContext == 0xbeef,
+               "got contexts %s %s\n", wine_dbgstr_longlong(results[total].RequestContext),
+               wine_dbgstr_longlong(results[total].SocketContext));
+    }
+    ok(!strcmp(buffer + 32, "registered"), "got %s\n", buffer + 32);
+
+    closesocket(src);
+    closesocket(dst);
+    rio.RIOCloseCompletionQueue(cq);
+    rio.RIODeregisterBuffer(buffer_id);
+}
+
 static void test_getpeername(void)
 {
     SOCKET sock;
@@ -11459,6 +11689,7 @@ START_TEST( sock )
     }
 
     test_UDP();
+    test_UDP_burst();
 
     test_getservbyname();
     test_WSASocket();
@@ -11497,6 +11728,7 @@ START_TEST( sock )
 
     test_ipv6only();
     test_TransmitFile();
+    test_rio();
     test_GetAddrInfoW();
     test_GetAddrInfoExW();
     test_getaddrinfo();
@@ -1904,10 +1904,47 @@ static void WINAPI IXAudio2Impl_GetPerformanceData(IXAudio2 *iface,
         XAUDIO2_PERFORMANCE_DATA *pPerfData)
 {
     IXAudio2Impl *This = impl_from_IXAudio2(iface);
+    XA2SourceImpl *src;
+    XA2SubmixImpl *sub;
+    LARGE_INTEGER now;
 
-    TRACE("(%p)->(%p): stub!\n", This, pPerfData);
+    TRACE("(%p)->(%p)\n", This, pPerfData);
 
     memset(pPerfData, 0, sizeof(*pPerfData));
+
+    EnterCriticalSection(&This->lock);
+
+    /* cycles are reported in performance counter ticks */
+    QueryPerformanceCounter(&now);
+    if(This->last_query.QuadPart)
+        pPerfData->TotalCyclesSinceLastQuery = now.QuadPart - This->last_query.QuadPart;
+    This->last_query = now;
+
+    pPerfData->AudioCyclesSinceLastQuery = This->pass_ticks;
+    pPerfData->MinimumCyclesPerQuantum = This->min_pass_ticks;
+    pPerfData->MaximumCyclesPerQuantum = This->max_pass_ticks;
+    This->pass_ticks = 0;
+    This->min_pass_ticks = This->max_pass_ticks = 0;
+
+    pPerfData->CurrentLatencyInSamples = This->latency_frames;
+    pPerfData->GlitchesSinceEngineStarted = This->glitches;
+
+    LIST_FOR_EACH_ENTRY(src, &This->source_voices, XA2SourceImpl, entry){
+        EnterCriticalSection(&src->lock);
+        if(src->in_use){
+            ++pPerfData->TotalSourceVoiceCount;
+            if(src->running)
+                ++pPerfData->ActiveSourceVoiceCount;
+        }
+        LeaveCriticalSection(&src->lock);
+    }
+
+    LIST_FOR_EACH_ENTRY(sub, &This->submix_voices, XA2SubmixImpl, entry){
+        if(sub->in_use)
+            ++pPerfData->ActiveSubmixVoiceCount;
+    }
+
+    LeaveCriticalSection(&This->lock);
 }
 
 static void WINAPI IXAudio2Impl_SetDebugConfiguration(IXAudio2 *iface,
@@ -2404,7 +2441,8 @@ static void do_engine_tick(IXAudio2Impl *This)
     BYTE *buf;
     XA2SourceImpl *src;
     HRESULT hr;
-    UINT32 nframes, i, pad;
+    UINT32 nframes, i, pad, ticks;
+    LARGE_INTEGER start, end;
 
     /* maintain up to 3 periods in mmdevapi */
     hr = IAudioClient_GetCurrentPadding(This->aclient, &pad);
@@ -2423,6 +2461,12 @@ static void do_engine_tick(IXAudio2Impl *This)
     if(!nframes)
         return;
 
+    QueryPerformanceCounter(&start);
+
+    /* mmdevapi ran dry since the last pass */
+    if(!pad && This->passes)
+        ++This->glitches;
+
     for(i = 0; i < This->ncbs && This->cbs[i]; ++i)
         IXAudio2EngineCallback_OnProcessingPassStart(This->cbs[i]);
 
@@ -2474,6 +2518,16 @@ static void do_engine_tick(IXAudio2Impl *This)
 
     for(i = 0; i < This->ncbs && This->cbs[i]; ++i)
         IXAudio2EngineCallback_OnProcessingPassEnd(This->cbs[i]);
+
+    QueryPerformanceCounter(&end);
+    ticks = end.QuadPart - start.QuadPart;
+    This->pass_ticks += ticks;
+    if(!This->min_pass_ticks || ticks < This->min_pass_ticks)
+        This->min_pass_ticks = ticks;
+    if(ticks > This->max_pass_ticks)
+        This->max_pass_ticks = ticks;
+    This->latency_frames = pad + nframes;
+    ++This->passes;
 }
 
 static DWORD WINAPI engine_threadproc(void *arg)
@@ -157,6 +157,13 @@ struct _IXAudio2Impl {
     IXAudio2EngineCallback **cbs;
 
     BOOL running;
+
+    /* performance data, in performance counter ticks; the per-query values
+     * are reset by GetPerformanceData */
+    LARGE_INTEGER last_query;
+    UINT64 pass_ticks, passes;
+    UINT32 min_pass_ticks, max_pass_ticks;
+    UINT32 latency_frames, glitches;
 };
 
 #if XAUDIO2_VER == 0
@@ -38,6 +38,10 @@ extern "C" {
 #define TRACE_LEVEL_INFORMATION       4
 #define TRACE_LEVEL_VERBOSE           5
 
+#define EVENT_CONTROL_CODE_DISABLE_PROVIDER 0
+#define EVENT_CONTROL_CODE_ENABLE_PROVIDER  1
+#define EVENT_CONTROL_CODE_CAPTURE_STATE    2
+
 #define EVENT_TRACE_FILE_MODE_NONE             0x00000000
 #define EVENT_TRACE_FILE_MODE_SEQUENTIAL       0x00000001
 #define EVENT_TRACE_FILE_MODE_CIRCULAR         0x00000002
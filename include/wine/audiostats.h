@@ -0,0 +1,169 @@
+/*
+ * Audio stream statistics shared between the audio modules
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_AUDIOSTATS_H
+#define __WINE_WINE_AUDIOSTATS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <windef.h>
+#include <winbase.h>
+
+/* The audio drivers and dsound keep per-stream counters in a block of
+ * shared memory named __wine_audio_stats_<process id in hex>, so that an
+ * external tool can watch a running process. Each counter is only written
+ * by the thread servicing its stream; readers must tolerate torn values.
+ * All times are in 100ns units. */
+
+#define AUDIO_STATS_VERSION        1
+#define AUDIO_STATS_MAX_STREAMS    32
+#define AUDIO_STATS_JITTER_BUCKETS 8
+
+/* the jitter histogram counts the distance between the actual and the
+ * expected period callback time: < 0.25ms, < 0.5ms, < 1ms, ... >= 16ms */
+#define AUDIO_STATS_JITTER_BASE    2500
+
+struct audio_stream_stats
+{
+    LONG     in_use;
+    DWORD    flow;           /* eRender or eCapture */
+    char     driver[16];
+    DWORD    rate;
+    LONG     periods;
+    LONG     underruns;
+    LONG     overruns;
+    LONG     jitter[AUDIO_STATS_JITTER_BUCKETS];
+    LONGLONG period;         /* expected period length */
+    LONGLONG last_period;    /* time of the last period callback */
+    LONGLONG latency;        /* last time from application write to device */
+    LONGLONG max_latency;
+};
+
+struct audio_stats
+{
+    DWORD    version;
+    DWORD    size;
+    LONG     mixer_runs;     /* dsound software mixer */
+    LONGLONG mixer_time;
+    LONGLONG mixer_max_time;
+    struct audio_stream_stats streams[AUDIO_STATS_MAX_STREAMS];
+};
+
+static inline LONGLONG audio_stats_time(void)
+{
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+
+    if (!freq.QuadPart) QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &now );
+    return now.QuadPart * 10000000 / freq.QuadPart;
+}
+
+/* map the statistics block of the current process, the mapping stays alive until exit */
+static inline struct audio_stats *audio_stats_get(void)
+{
+    static struct audio_stats *stats;
+    struct audio_stats *ptr;
+    HANDLE mapping;
+    char name[32];
+
+    if (stats) return stats;
+    sprintf( name, "__wine_audio_stats_%08x", GetCurrentProcessId() );
+    if (!(mapping = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        0, sizeof(*stats), name )))
+        return NULL;
+    if (!(ptr = MapViewOfFile( mapping, FILE_MAP_WRITE, 0, 0, sizeof(*ptr) )))
+    {
+        CloseHandle( mapping );
+        return NULL;
+    }
+    if (!InterlockedCompareExchange( (LONG *)&ptr->version, AUDIO_STATS_VERSION, 0 ))
+        ptr->size = sizeof(*ptr);
+    return stats = ptr;
+}
+
+static inline struct audio_stream_stats *audio_stats_alloc_stream( const char *driver, DWORD flow,
+                                                                   DWORD rate, LONGLONG period )
+{
+    struct audio_stats *stats = audio_stats_get();
+    struct audio_stream_stats *s;
+    unsigned int i;
+
+    if (!stats) return NULL;
+    for (i = 0; i < AUDIO_STATS_MAX_STREAMS; i++)
+    {
+        s = &stats->streams[i];
+        if (InterlockedCompareExchange( &s->in_use, 1, 0 )) continue;
+        memset( (char *)s + sizeof(s->in_use), 0, sizeof(*s) - sizeof(s->in_use) );
+        lstrcpynA( s->driver, driver, sizeof(s->driver) );
+        s->flow = flow;
+        s->rate = rate;
+        s->period = period;
+        return s;
+    }
+    return NULL;
+}
+
+static inline void audio_stats_free_stream( struct audio_stream_stats *s )
+{
+    if (s) InterlockedExchange( &s->in_use, 0 );
+}
+
+/* record a period callback and its deviation from the expected period */
+static inline void audio_stats_period( struct audio_stream_stats *s )
+{
+    LONGLONG now, delta, limit = AUDIO_STATS_JITTER_BASE;
+    unsigned int bucket = 0;
+
+    if (!s) return;
+    now = audio_stats_time();
+    if (s->last_period)
+    {
+        delta = now - s->last_period - s->period;
+        if (delta < 0) delta = -delta;
+        while (bucket < AUDIO_STATS_JITTER_BUCKETS - 1 && delta >= limit)
+        {
+            bucket++;
+            limit *= 2;
+        }
+        s->jitter[bucket]++;
+    }
+    s->last_period = now;
+    s->periods++;
+}
+
+static inline void audio_stats_latency( struct audio_stream_stats *s, LONGLONG latency )
+{
+    if (!s) return;
+    s->latency = latency;
+    if (latency > s->max_latency) s->max_latency = latency;
+}
+
+static inline void audio_stats_mixer( LONGLONG time )
+{
+    struct audio_stats *stats = audio_stats_get();
+
+    if (!stats) return;
+    stats->mixer_runs++;
+    stats->mixer_time += time;
+    if (time > stats->mixer_max_time) stats->mixer_max_time = time;
+}
+
+#endif  /* __WINE_WINE_AUDIOSTATS_H */
@@ -0,0 +1,104 @@
+/*
+ * Binary debug trace file format
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_DEBUGTRACE_H
+#define __WINE_WINE_DEBUGTRACE_H
+
+#include <windef.h>
+
+/* When WINEDEBUGLOG is set to a directory, debug messages are not formatted
+ * but stored as binary records in a per-thread ring buffer file named
+ * wine-<unix pid>-<n>.trace. The strings referenced by the records are
+ * appended once to wine-<unix pid>.str in the same directory.
+ * winedump decodes the ring buffer files back to text.
+ *
+ * Events written by ETW providers that are enabled through WINEETW are
+ * stored in the same ring buffers, see struct trace_event. */
+
+#define TRACE_RING_MAGIC    0x43525457  /* "WTRC" */
+#define TRACE_VERSION       2
+#define TRACE_RING_SIZE     (1024 * 1024)
+#define TRACE_MAX_RECORD    2048
+#define TRACE_MAX_STRING    256
+#define TRACE_MAX_FORMAT    1024
+#define TRACE_MAX_EVENT     16384
+
+/* header at the start of a ring buffer file, followed by the data area */
+struct trace_ring_header
+{
+    unsigned int magic;      /* TRACE_RING_MAGIC */
+    unsigned int version;    /* TRACE_VERSION */
+    unsigned int size;       /* size of the data area */
+    unsigned int unix_pid;   /* Unix process id, used to locate the string file */
+    unsigned int pid;        /* Windows process id */
+    unsigned int tid;        /* Windows thread id */
+    ULONGLONG    head;       /* logical offset of the next record */
+    ULONGLONG    tail;       /* logical offset of the oldest record */
+};
+
+#define TRACE_CLASS_EVENT     0xfe  /* ETW event, the arguments are a struct trace_event */
+#define TRACE_CLASS_CONT      0xff  /* continuation of the previous message */
+
+#define TRACE_FLAG_NO_PREFIX  0x01  /* message doesn't have the standard prefix */
+#define TRACE_FLAG_TRUNCATED  0x02  /* some arguments could not be stored */
+
+/* a message record; records never wrap around the end of the data area,
+ * a zero size marks the end of the used part of the data area */
+struct trace_record
+{
+    unsigned short size;     /* size of the record including arguments, multiple of 8 */
+    unsigned char  cls;      /* enum __wine_debug_class or TRACE_CLASS_CONT */
+    unsigned char  flags;    /* TRACE_FLAG_* */
+    unsigned int   pad;
+    ULONGLONG      time;     /* performance counter value */
+    ULONGLONG      channel;  /* address of the channel name */
+    ULONGLONG      function; /* address of the function name */
+    ULONGLONG      format;   /* address of the format string */
+    /* followed by the arguments, each a type character followed by its value:
+     * 'i', 'u', 'p': 64-bit integer, 'f': double, 's': 16-bit length and characters */
+};
+
+/* ETW event stored after a TRACE_CLASS_EVENT record header; the channel,
+ * function and format fields of the record are unused */
+struct trace_event
+{
+    GUID           provider;  /* provider GUID */
+    GUID           activity;  /* activity id, or zero */
+    GUID           related;   /* related activity id, or zero */
+    unsigned short id;        /* EVENT_DESCRIPTOR fields */
+    unsigned char  version;
+    unsigned char  channel;
+    unsigned char  level;
+    unsigned char  opcode;
+    unsigned short task;
+    ULONGLONG      keyword;
+    unsigned int   data_size; /* size of the user data, followed by the data */
+    unsigned int   pad;
+};
+
+/* an entry of the string file */
+struct trace_string
+{
+    ULONGLONG    addr;       /* address of the string in the traced process */
+    unsigned int len;        /* length of the string, followed by the characters */
+    unsigned int pad;
+};
+
+#endif  /* __WINE_WINE_DEBUGTRACE_H */
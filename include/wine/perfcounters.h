@@ -0,0 +1,123 @@
+/*
+ * Named performance counters shared with external tools
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_PERFCOUNTERS_H
+#define __WINE_WINE_PERFCOUNTERS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <windef.h>
+#include <winbase.h>
+
+/* Each process keeps its counters in a block of shared memory named
+ * __wine_perf_counters_<process id in hex>, where an external tool or
+ * pdh.dll can read them. A module registers a counter by name once and
+ * keeps the returned pointer; the same name may appear more than once
+ * if two threads register it at the same time, readers add them up. */
+
+#define WINE_PERF_COUNTERS_VERSION  1
+#define WINE_PERF_COUNTERS_MAX      256
+#define WINE_PERF_COUNTER_NAME_LEN  52
+
+#define WINE_PERF_COUNTER_FREE      0
+#define WINE_PERF_COUNTER_BUSY      1  /* being registered */
+#define WINE_PERF_COUNTER_READY     2
+
+struct wine_perf_counter
+{
+    LONG     state;
+    char     name[WINE_PERF_COUNTER_NAME_LEN];
+    LONGLONG value;
+};
+
+struct wine_perf_counters
+{
+    DWORD    version;
+    DWORD    size;
+    DWORD    reserved[14];   /* keep the counters on their own cache lines */
+    struct wine_perf_counter counters[WINE_PERF_COUNTERS_MAX];
+};
+
+static inline void wine_perf_counters_name( char *buffer, DWORD pid )
+{
+    sprintf( buffer, "__wine_perf_counters_%08x", pid );
+}
+
+/* map the counters block of the current process, the mapping stays alive until exit */
+static inline struct wine_perf_counters *wine_perf_counters_get(void)
+{
+    static struct wine_perf_counters *counters;
+    struct wine_perf_counters *ptr;
+    HANDLE mapping;
+    char name[32];
+
+    if (counters) return counters;
+    wine_perf_counters_name( name, GetCurrentProcessId() );
+    if (!(mapping = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        0, sizeof(*counters), name )))
+        return NULL;
+    if (!(ptr = MapViewOfFile( mapping, FILE_MAP_WRITE, 0, 0, sizeof(*ptr) )))
+    {
+        CloseHandle( mapping );
+        return NULL;
+    }
+    if (!InterlockedCompareExchange( (LONG *)&ptr->version, WINE_PERF_COUNTERS_VERSION, 0 ))
+        ptr->size = sizeof(*ptr);
+    return counters = ptr;
+}
+
+/* find or add a counter; returns NULL when no more counters are available */
+static inline LONGLONG *wine_perf_counter_register( const char *name )
+{
+    struct wine_perf_counters *block = wine_perf_counters_get();
+    struct wine_perf_counter *c;
+    unsigned int i;
+
+    if (!block) return NULL;
+    for (i = 0; i < WINE_PERF_COUNTERS_MAX; i++)
+    {
+        c = &block->counters[i];
+        if (c->state == WINE_PERF_COUNTER_READY && !strcmp( c->name, name )) return &c->value;
+        if (c->state != WINE_PERF_COUNTER_FREE) continue;
+        if (InterlockedCompareExchange( &c->state, WINE_PERF_COUNTER_BUSY, WINE_PERF_COUNTER_FREE ))
+            continue;
+        lstrcpynA( c->name, name, sizeof(c->name) );
+        InterlockedExchange( &c->state, WINE_PERF_COUNTER_READY );
+        return &c->value;
+    }
+    return NULL;
+}
+
+/* the counter value is read without a barrier, only the update itself is atomic */
+static inline void wine_perf_counter_add( LONGLONG *counter, LONGLONG delta )
+{
+    LONGLONG old;
+
+    if (!counter) return;
+    do old = *(volatile LONGLONG *)counter;
+    while (InterlockedCompareExchange64( counter, old + delta, old ) != old);
+}
+
+static inline void wine_perf_counter_inc( LONGLONG *counter )
+{
+    wine_perf_counter_add( counter, 1 );
+}
+
+#endif  /* __WINE_WINE_PERFCOUNTERS_H */
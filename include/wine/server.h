@@ -50,8 +50,12 @@ struct __server_request_info
 };
 
 extern unsigned int wine_server_call( void *req_ptr );
+extern unsigned int CDECL wine_server_call_batch( struct __server_request_info *reqs, unsigned int count,
+                                                  unsigned int flags );
 extern void CDECL wine_server_send_fd( int fd );
 extern int CDECL wine_server_fd_to_handle( int fd, unsigned int access, unsigned int attributes, HANDLE *handle );
+extern void CDECL wine_server_flush_sync_object( HANDLE handle );
+extern int CDECL wine_server_get_cached_fd( HANDLE handle, unsigned int access, int *unix_fd, unsigned int *options );
 extern int CDECL wine_server_handle_to_fd( HANDLE handle, unsigned int access, int *unix_fd, unsigned int *options );
 extern void CDECL wine_server_release_fd( HANDLE handle, int unix_fd );
 
@@ -89,6 +93,16 @@ static inline void wine_server_set_reply( void *req_ptr, void *ptr, data_size_t
     req->u.req.request_header.reply_size = max_size;
 }
 
+/* initialize a request for wine_server_call_batch and return the request structure */
+static inline void *wine_server_init_req( struct __server_request_info *req, enum request type )
+{
+    memset( &req->u.req, 0, sizeof(req->u.req) );
+    req->u.req.request_header.req = type;
+    req->data_count = 0;
+    req->reply_data = NULL;
+    return &req->u.req;
+}
+
 /* convert an object handle to a server handle */
 static inline obj_handle_t wine_server_obj_handle( HANDLE handle )
 {
@@ -50,6 +50,31 @@ struct request_max_size
     int pad[16];
 };
 
+
+
+struct shm_request_area
+{
+    int          client_seq;
+    int          server_seq;
+    int          client_waiting;
+    int          server_sleeping;
+    int          dead;
+    int          pad[11];
+};
+
+#define SHM_REQUEST_AREA_SIZE 0x10000
+#define SHM_REQUEST_MAX_DATA  (SHM_REQUEST_AREA_SIZE - sizeof(struct shm_request_area) - sizeof(struct request_max_size))
+
+
+struct queue_shared_memory
+{
+    unsigned int wake_bits;
+    unsigned int changed_bits;
+};
+
+
+#define REGISTRY_GENERATION_SLOTS 4096
+
 #define FIRST_USER_HANDLE 0x0020
 #define LAST_USER_HANDLE  0xffef
 
@@ -252,6 +277,25 @@ typedef struct
 } rectangle_t;
 
 
+struct shared_window_info
+{
+    unsigned int     seq;
+    user_handle_t    handle;
+    user_handle_t    parent;
+    user_handle_t    owner;
+    unsigned int     style;
+    unsigned int     ex_style;
+    unsigned int     id;
+    unsigned int     __pad;
+    mod_handle_t     instance;
+    lparam_t         user_data;
+    rectangle_t      window_rect;
+    rectangle_t      client_rect;
+};
+
+#define SHARED_WINDOW_SLOTS ((LAST_USER_HANDLE - FIRST_USER_HANDLE) / 2 + 1)
+
+
 typedef struct
 {
     obj_handle_t    handle;
@@ -402,7 +446,8 @@ enum select_op
     SELECT_WAIT_ALL,
     SELECT_SIGNAL_AND_WAIT,
     SELECT_KEYED_EVENT_WAIT,
-    SELECT_KEYED_EVENT_RELEASE
+    SELECT_KEYED_EVENT_RELEASE,
+    SELECT_WAIT_SET
 };
 
 typedef union
@@ -425,6 +470,11 @@ typedef union
         obj_handle_t    handle;
         client_ptr_t    key;
     } keyed_event;
+    struct
+    {
+        enum select_op  op;
+        obj_handle_t    handle;
+    } wait_set;
 } select_op_t;
 
 enum apc_type
@@ -715,6 +765,15 @@ struct rawinput_device
     user_handle_t  target;
 };
 
+struct completion_entry
+{
+    apc_param_t    ckey;
+    apc_param_t    cvalue;
+    apc_param_t    information;
+    unsigned int   status;
+    int            __pad;
+};
+
 
 
 
@@ -841,6 +900,37 @@ struct init_thread_reply
 
 
 
+struct set_shm_request_area_request
+{
+    struct request_header __header;
+    int          area_fd;
+    int          doorbell_fd;
+    char __pad_20[4];
+};
+struct set_shm_request_area_reply
+{
+    struct reply_header __header;
+};
+
+
+
+struct batch_request
+{
+    struct request_header __header;
+    unsigned int flags;
+    /* VARARG(requests,bytes); */
+};
+struct batch_reply
+{
+    struct reply_header __header;
+    unsigned int count;
+    /* VARARG(replies,bytes); */
+    char __pad_12[4];
+};
+#define BATCH_STOP_ON_ERROR 0x01
+
+
+
 struct terminate_process_request
 {
     struct request_header __header;
@@ -1432,7 +1522,9 @@ struct create_file_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
-    char __pad_12[4];
+    int          fd_type;
+    unsigned int fd_access;
+    unsigned int fd_options;
 };
 
 
@@ -2322,6 +2414,49 @@ struct add_mapping_committed_range_reply
 
 
 
+struct get_image_relocation_request
+{
+    struct request_header __header;
+    obj_handle_t mapping;
+    client_ptr_t base;
+};
+struct get_image_relocation_reply
+{
+    struct reply_header __header;
+    obj_handle_t file;
+    char __pad_12[4];
+};
+
+
+
+struct create_image_relocation_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+    client_ptr_t base;
+};
+struct create_image_relocation_reply
+{
+    struct reply_header __header;
+    obj_handle_t file;
+    char __pad_12[4];
+};
+
+
+
+struct commit_image_relocation_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+    client_ptr_t base;
+};
+struct commit_image_relocation_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct is_same_mapping_request
 {
     struct request_header __header;
@@ -2641,11 +2776,27 @@ struct get_key_value_reply
     struct reply_header __header;
     int          type;
     data_size_t  total;
+    unsigned int gen_slot;
+    unsigned int generation;
     /* VARARG(data,bytes); */
 };
 
 
 
+struct get_registry_generations_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_registry_generations_reply
+{
+    struct reply_header __header;
+    obj_handle_t file;
+    char __pad_12[4];
+};
+
+
+
 struct enum_key_value_request
 {
     struct request_header __header;
@@ -2984,6 +3135,20 @@ struct get_msg_queue_reply
 
 
 
+struct get_queue_shared_memory_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_queue_shared_memory_reply
+{
+    struct reply_header __header;
+    obj_handle_t file;
+    char __pad_12[4];
+};
+
+
+
 struct set_queue_fd_request
 {
     struct request_header __header;
@@ -3569,6 +3734,20 @@ struct set_parent_reply
 
 
 
+struct get_shared_windows_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_shared_windows_reply
+{
+    struct reply_header __header;
+    obj_handle_t file;
+    char __pad_12[4];
+};
+
+
+
 struct get_window_parents_request
 {
     struct request_header __header;
@@ -5312,6 +5491,19 @@ struct remove_completion_reply
 
 
 
+struct remove_completions_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct remove_completions_reply
+{
+    struct reply_header __header;
+    /* VARARG(entries,completion_entries); */
+};
+
+
+
 struct query_completion_request
 {
     struct request_header __header;
@@ -5618,6 +5810,48 @@ struct terminate_job_reply
 };
 
 
+
+struct create_wait_set_request
+{
+    struct request_header __header;
+    unsigned int access;
+};
+struct create_wait_set_reply
+{
+    struct reply_header __header;
+    obj_handle_t handle;
+    char __pad_12[4];
+};
+
+
+
+struct set_wait_set_member_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    obj_handle_t object;
+    char __pad_20[4];
+    client_ptr_t key;
+};
+struct set_wait_set_member_reply
+{
+    struct reply_header __header;
+};
+
+
+
+struct get_wait_set_events_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+};
+struct get_wait_set_events_reply
+{
+    struct reply_header __header;
+    /* VARARG(keys,uints64); */
+};
+
+
 enum request
 {
     REQ_new_process,
@@ -5626,6 +5860,8 @@ enum request
     REQ_get_startup_info,
     REQ_init_process_done,
     REQ_init_thread,
+    REQ_set_shm_request_area,
+    REQ_batch,
     REQ_terminate_process,
     REQ_terminate_thread,
     REQ_get_process_info,
@@ -5710,6 +5946,9 @@ enum request
     REQ_unmap_view,
     REQ_get_mapping_committed_range,
     REQ_add_mapping_committed_range,
+    REQ_get_image_relocation,
+    REQ_create_image_relocation,
+    REQ_commit_image_relocation,
     REQ_is_same_mapping,
     REQ_create_snapshot,
     REQ_next_process,
@@ -5730,6 +5969,7 @@ enum request
     REQ_enum_key,
     REQ_set_key_value,
     REQ_get_key_value,
+    REQ_get_registry_generations,
     REQ_enum_key_value,
     REQ_delete_key_value,
     REQ_load_registry,
@@ -5752,6 +5992,7 @@ enum request
     REQ_empty_atom_table,
     REQ_init_atom_table,
     REQ_get_msg_queue,
+    REQ_get_queue_shared_memory,
     REQ_set_queue_fd,
     REQ_set_queue_mask,
     REQ_get_queue_status,
@@ -5785,6 +6026,7 @@ enum request
     REQ_get_window_info,
     REQ_set_window_info,
     REQ_set_parent,
+    REQ_get_shared_windows,
     REQ_get_window_parents,
     REQ_get_window_children,
     REQ_get_window_children_from_point,
@@ -5889,6 +6131,7 @@ enum request
     REQ_open_completion,
     REQ_add_completion,
     REQ_remove_completion,
+    REQ_remove_completions,
     REQ_query_completion,
     REQ_set_completion_info,
     REQ_add_fd_completion,
@@ -5909,6 +6152,9 @@ enum request
     REQ_set_job_limits,
     REQ_set_job_completion_port,
     REQ_terminate_job,
+    REQ_create_wait_set,
+    REQ_set_wait_set_member,
+    REQ_get_wait_set_events,
     REQ_NB_REQUESTS
 };
 
@@ -5922,6 +6168,8 @@ union generic_request
     struct get_startup_info_request get_startup_info_request;
     struct init_process_done_request init_process_done_request;
     struct init_thread_request init_thread_request;
+    struct set_shm_request_area_request set_shm_request_area_request;
+    struct batch_request batch_request;
     struct terminate_process_request terminate_process_request;
     struct terminate_thread_request terminate_thread_request;
     struct get_process_info_request get_process_info_request;
@@ -6006,6 +6254,9 @@ union generic_request
     struct unmap_view_request unmap_view_request;
     struct get_mapping_committed_range_request get_mapping_committed_range_request;
     struct add_mapping_committed_range_request add_mapping_committed_range_request;
+    struct get_image_relocation_request get_image_relocation_request;
+    struct create_image_relocation_request create_image_relocation_request;
+    struct commit_image_relocation_request commit_image_relocation_request;
     struct is_same_mapping_request is_same_mapping_request;
     struct create_snapshot_request create_snapshot_request;
     struct next_process_request next_process_request;
@@ -6026,6 +6277,7 @@ union generic_request
     struct enum_key_request enum_key_request;
     struct set_key_value_request set_key_value_request;
     struct get_key_value_request get_key_value_request;
+    struct get_registry_generations_request get_registry_generations_request;
     struct enum_key_value_request enum_key_value_request;
     struct delete_key_value_request delete_key_value_request;
     struct load_registry_request load_registry_request;
@@ -6048,6 +6300,7 @@ union generic_request
     struct empty_atom_table_request empty_atom_table_request;
     struct init_atom_table_request init_atom_table_request;
     struct get_msg_queue_request get_msg_queue_request;
+    struct get_queue_shared_memory_request get_queue_shared_memory_request;
     struct set_queue_fd_request set_queue_fd_request;
     struct set_queue_mask_request set_queue_mask_request;
     struct get_queue_status_request get_queue_status_request;
@@ -6081,6 +6334,7 @@ union generic_request
     struct get_window_info_request get_window_info_request;
     struct set_window_info_request set_window_info_request;
     struct set_parent_request set_parent_request;
+    struct get_shared_windows_request get_shared_windows_request;
     struct get_window_parents_request get_window_parents_request;
     struct get_window_children_request get_window_children_request;
     struct get_window_children_from_point_request get_window_children_from_point_request;
@@ -6185,6 +6439,7 @@ union generic_request
     struct open_completion_request open_completion_request;
     struct add_completion_request add_completion_request;
     struct remove_completion_request remove_completion_request;
+    struct remove_completions_request remove_completions_request;
     struct query_completion_request query_completion_request;
     struct set_completion_info_request set_completion_info_request;
     struct add_fd_completion_request add_fd_completion_request;
@@ -6205,6 +6460,9 @@ union generic_request
     struct set_job_limits_request set_job_limits_request;
     struct set_job_completion_port_request set_job_completion_port_request;
     struct terminate_job_request terminate_job_request;
+    struct create_wait_set_request create_wait_set_request;
+    struct set_wait_set_member_request set_wait_set_member_request;
+    struct get_wait_set_events_request get_wait_set_events_request;
 };
 union generic_reply
 {
@@ -6216,6 +6474,8 @@ union generic_reply
     struct get_startup_info_reply get_startup_info_reply;
     struct init_process_done_reply init_process_done_reply;
     struct init_thread_reply init_thread_reply;
+    struct set_shm_request_area_reply set_shm_request_area_reply;
+    struct batch_reply batch_reply;
     struct terminate_process_reply terminate_process_reply;
     struct terminate_thread_reply terminate_thread_reply;
     struct get_process_info_reply get_process_info_reply;
@@ -6300,6 +6560,9 @@ union generic_reply
     struct unmap_view_reply unmap_view_reply;
     struct get_mapping_committed_range_reply get_mapping_committed_range_reply;
     struct add_mapping_committed_range_reply add_mapping_committed_range_reply;
+    struct get_image_relocation_reply get_image_relocation_reply;
+    struct create_image_relocation_reply create_image_relocation_reply;
+    struct commit_image_relocation_reply commit_image_relocation_reply;
     struct is_same_mapping_reply is_same_mapping_reply;
     struct create_snapshot_reply create_snapshot_reply;
     struct next_process_reply next_process_reply;
@@ -6320,6 +6583,7 @@ union generic_reply
     struct enum_key_reply enum_key_reply;
     struct set_key_value_reply set_key_value_reply;
     struct get_key_value_reply get_key_value_reply;
+    struct get_registry_generations_reply get_registry_generations_reply;
     struct enum_key_value_reply enum_key_value_reply;
     struct delete_key_value_reply delete_key_value_reply;
     struct load_registry_reply load_registry_reply;
@@ -6342,6 +6606,7 @@ union generic_reply
     struct empty_atom_table_reply empty_atom_table_reply;
     struct init_atom_table_reply init_atom_table_reply;
     struct get_msg_queue_reply get_msg_queue_reply;
+    struct get_queue_shared_memory_reply get_queue_shared_memory_reply;
     struct set_queue_fd_reply set_queue_fd_reply;
     struct set_queue_mask_reply set_queue_mask_reply;
     struct get_queue_status_reply get_queue_status_reply;
@@ -6375,6 +6640,7 @@ union generic_reply
     struct get_window_info_reply get_window_info_reply;
     struct set_window_info_reply set_window_info_reply;
     struct set_parent_reply set_parent_reply;
+    struct get_shared_windows_reply get_shared_windows_reply;
     struct get_window_parents_reply get_window_parents_reply;
     struct get_window_children_reply get_window_children_reply;
     struct get_window_children_from_point_reply get_window_children_from_point_reply;
@@ -6479,6 +6745,7 @@ union generic_reply
     struct open_completion_reply open_completion_reply;
     struct add_completion_reply add_completion_reply;
     struct remove_completion_reply remove_completion_reply;
+    struct remove_completions_reply remove_completions_reply;
     struct query_completion_reply query_completion_reply;
     struct set_completion_info_reply set_completion_info_reply;
     struct add_fd_completion_reply add_fd_completion_reply;
@@ -6499,8 +6766,11 @@ union generic_reply
     struct set_job_limits_reply set_job_limits_reply;
     struct set_job_completion_port_reply set_job_completion_port_reply;
     struct terminate_job_reply terminate_job_reply;
+    struct create_wait_set_reply create_wait_set_reply;
+    struct set_wait_set_member_reply set_wait_set_member_reply;
+    struct get_wait_set_events_reply get_wait_set_events_reply;
 };
 
-#define SERVER_PROTOCOL_VERSION 548
+#define SERVER_PROTOCOL_VERSION 557
 
 #endif /* __WINE_WINE_SERVER_PROTOCOL_H */
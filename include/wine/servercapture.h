@@ -0,0 +1,58 @@
+/*
+ * Wine server request capture file format
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef __WINE_WINE_SERVERCAPTURE_H
+#define __WINE_WINE_SERVERCAPTURE_H
+
+#include <windef.h>
+
+/* When started with --capture=file, the wineserver appends every request it
+ * handles to the file, with its arguments and timings. winedump prints the
+ * requests and the per-request latency statistics of a capture file. */
+
+#define SERVER_CAPTURE_MAGIC    0x50414357  /* "WCAP" */
+#define SERVER_CAPTURE_VERSION  1
+
+/* header at the start of the file, followed by the names of the nb_requests
+ * request codes as consecutive null-terminated strings, padded to names_size */
+struct server_capture_header
+{
+    unsigned int magic;        /* SERVER_CAPTURE_MAGIC */
+    unsigned int version;      /* SERVER_CAPTURE_VERSION */
+    unsigned int protocol;     /* server protocol version */
+    unsigned int nb_requests;  /* number of request codes */
+    unsigned int names_size;   /* size of the names, multiple of 8 */
+    unsigned int pad;
+};
+
+/* a handled request, followed by the fixed size request and its variable data */
+struct server_capture_record
+{
+    unsigned int size;         /* size of the record including the request, multiple of 8 */
+    unsigned int req;          /* request code */
+    unsigned int pid;          /* client process id */
+    unsigned int tid;          /* client thread id */
+    unsigned int error;        /* returned status */
+    unsigned int reply_size;   /* size of the variable reply data */
+    ULONGLONG    time;         /* start time in 100ns units since the capture started */
+    ULONGLONG    duration;     /* time spent in the request handler, in 100ns units */
+};
+
+#endif  /* __WINE_WINE_SERVERCAPTURE_H */
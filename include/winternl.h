@@ -941,6 +941,7 @@ typedef enum _SYSTEM_INFORMATION_CLASS {
     Unknown72,
     SystemLogicalProcessorInformation = 73,
     SystemLogicalProcessorInformationEx = 107,
+    SystemCpuSetInformation = 175,
     SystemInformationClassMax
 } SYSTEM_INFORMATION_CLASS, *PSYSTEM_INFORMATION_CLASS;
 
@@ -1013,9 +1014,28 @@ typedef enum _MEMORY_INFORMATION_CLASS {
     MemoryBasicInformation,
     MemoryWorkingSetList,
     MemorySectionName,
-    MemoryBasicVlmInformation
+    MemoryBasicVlmInformation,
+    MemoryWorkingSetExInformation
 } MEMORY_INFORMATION_CLASS;
 
+typedef union _MEMORY_WORKING_SET_EX_BLOCK {
+    ULONG_PTR Flags;
+    struct {
+        ULONG_PTR Valid : 1;
+        ULONG_PTR ShareCount : 3;
+        ULONG_PTR Win32Protection : 11;
+        ULONG_PTR Shared : 1;
+        ULONG_PTR Node : 6;
+        ULONG_PTR Locked : 1;
+        ULONG_PTR LargePage : 1;
+    } DUMMYSTRUCTNAME;
+} MEMORY_WORKING_SET_EX_BLOCK, *PMEMORY_WORKING_SET_EX_BLOCK;
+
+typedef struct _MEMORY_WORKING_SET_EX_INFORMATION {
+    PVOID VirtualAddress;
+    MEMORY_WORKING_SET_EX_BLOCK VirtualAttributes;
+} MEMORY_WORKING_SET_EX_INFORMATION, *PMEMORY_WORKING_SET_EX_INFORMATION;
+
 typedef struct _MEMORY_SECTION_NAME
 {
     UNICODE_STRING SectionFileName;
@@ -1636,6 +1656,27 @@ typedef struct _DEBUG_HEAP_INFORMATION {
   PVOID  Blocks;
 } DEBUG_HEAP_INFORMATION, *PDEBUG_HEAP_INFORMATION;
 
+/* Wine specific heap information class, returns a WINE_HEAP_STATISTICS structure */
+#define HeapWineStatisticsInformation ((HEAP_INFORMATION_CLASS)0x1000)
+
+/* size class n counts the allocations of up to 16 << n bytes, the last one counts all the bigger ones */
+#define WINE_HEAP_STATS_CLASSES 24
+
+typedef struct _WINE_HEAP_STATISTICS {
+  SIZE_T ReservedSize;
+  SIZE_T CommittedSize;
+  SIZE_T UsedSize;
+  SIZE_T BlockCount;
+  SIZE_T LargeBlockCount;
+  SIZE_T LargeBlockSize;
+  SIZE_T LfhSlabCount;
+  ULONG  LockContentionCount;
+  /* the counters below are only maintained when the heapstats debug channel is enabled */
+  ULONG  ReallocCount;
+  ULONG  AllocCount[WINE_HEAP_STATS_CLASSES];
+  ULONG  FreeCount[WINE_HEAP_STATS_CLASSES];
+} WINE_HEAP_STATISTICS, *PWINE_HEAP_STATISTICS;
+
 typedef struct _DEBUG_LOCK_INFORMATION {
   PVOID  Address;
   USHORT Type;
@@ -2073,6 +2114,12 @@ typedef enum _IO_COMPLETION_INFORMATION_CLASS {
   IoCompletionBasicInformation
 } IO_COMPLETION_INFORMATION_CLASS, *PIO_COMPLETION_INFORMATION_CLASS;
 
+typedef struct _FILE_IO_COMPLETION_INFORMATION {
+    ULONG_PTR CompletionKey;
+    ULONG_PTR CompletionValue;
+    IO_STATUS_BLOCK IoStatusBlock;
+} FILE_IO_COMPLETION_INFORMATION, *PFILE_IO_COMPLETION_INFORMATION;
+
 typedef struct _FILE_COMPLETION_INFORMATION {
     HANDLE CompletionPort;
     ULONG_PTR CompletionKey;
@@ -2387,6 +2434,7 @@ NTSYSAPI NTSTATUS  WINAPI NtReleaseKeyedEvent(HANDLE,const void*,BOOLEAN,const L
 NTSYSAPI NTSTATUS  WINAPI NtReleaseMutant(HANDLE,PLONG);
 NTSYSAPI NTSTATUS  WINAPI NtReleaseSemaphore(HANDLE,ULONG,PULONG);
 NTSYSAPI NTSTATUS  WINAPI NtRemoveIoCompletion(HANDLE,PULONG_PTR,PULONG_PTR,PIO_STATUS_BLOCK,PLARGE_INTEGER);
+NTSYSAPI NTSTATUS  WINAPI NtRemoveIoCompletionEx(HANDLE,FILE_IO_COMPLETION_INFORMATION*,ULONG,ULONG*,LARGE_INTEGER*,BOOLEAN);
 NTSYSAPI NTSTATUS  WINAPI NtRenameKey(HANDLE,UNICODE_STRING*);
 NTSYSAPI NTSTATUS  WINAPI NtReplaceKey(POBJECT_ATTRIBUTES,HANDLE,POBJECT_ATTRIBUTES);
 NTSYSAPI NTSTATUS  WINAPI NtReplyPort(HANDLE,PLPC_MESSAGE);
@@ -4240,6 +4240,7 @@ WORD        WINAPI SYSTEM_KillSystemTimer( WORD );
 
 #ifdef __WINESRC__
 WINUSERAPI BOOL CDECL __wine_send_input( HWND hwnd, const INPUT *input );
+WINUSERAPI UINT CDECL __wine_send_inputs( const HWND *hwnds, const INPUT *inputs, UINT count );
 #endif
 
 #ifdef __cplusplus
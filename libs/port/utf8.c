@@ -19,6 +19,12 @@
  */
 
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __aarch64__
+#include <arm_neon.h>
+#endif
 
 #include "wine/unicode.h"
 
@@ -44,6 +50,109 @@ static const unsigned char utf8_mask[4] = { 0x7f, 0x1f, 0x0f, 0x07 };
 static const unsigned int utf8_minval[4] = { 0x0, 0x80, 0x800, 0x10000 };
 
 
+/* copy the leading 7-bit ASCII chars of src, up to len; return the number of chars copied */
+static inline unsigned int copy_ascii_mbstowcs( WCHAR *dst, const char *src, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; pos + 16 <= len; pos += 16)
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i *)(src + pos) );
+        if (_mm_movemask_epi8( v )) break;
+        _mm_storeu_si128( (__m128i *)(dst + pos), _mm_unpacklo_epi8( v, zero ));
+        _mm_storeu_si128( (__m128i *)(dst + pos + 8), _mm_unpackhi_epi8( v, zero ));
+    }
+#elif defined(__aarch64__)
+    for (; pos + 16 <= len; pos += 16)
+    {
+        uint8x16_t v = vld1q_u8( (const uint8_t *)src + pos );
+        if (vmaxvq_u8( v ) >= 0x80) break;
+        vst1q_u16( dst + pos, vmovl_u8( vget_low_u8( v )));
+        vst1q_u16( dst + pos + 8, vmovl_high_u8( v ));
+    }
+#endif
+    for (; pos < len; pos++)
+    {
+        if ((unsigned char)src[pos] >= 0x80) break;
+        dst[pos] = (unsigned char)src[pos];
+    }
+    return pos;
+}
+
+/* count the leading 7-bit ASCII chars of src, up to len */
+static inline unsigned int count_ascii_mbs( const char *src, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#ifdef __SSE2__
+    for (; pos + 16 <= len; pos += 16)
+        if (_mm_movemask_epi8( _mm_loadu_si128( (const __m128i *)(src + pos) ))) break;
+#elif defined(__aarch64__)
+    for (; pos + 16 <= len; pos += 16)
+        if (vmaxvq_u8( vld1q_u8( (const uint8_t *)src + pos )) >= 0x80) break;
+#endif
+    while (pos < len && (unsigned char)src[pos] < 0x80) pos++;
+    return pos;
+}
+
+/* copy the leading 7-bit ASCII chars of src, up to len; return the number of chars copied */
+static inline unsigned int copy_ascii_wcstombs( char *dst, const WCHAR *src, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#ifdef __SSE2__
+    const __m128i high = _mm_set1_epi16( 0xff80 );
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; pos + 16 <= len; pos += 16)
+    {
+        __m128i lo = _mm_loadu_si128( (const __m128i *)(src + pos) );
+        __m128i hi = _mm_loadu_si128( (const __m128i *)(src + pos + 8) );
+        __m128i test = _mm_and_si128( _mm_or_si128( lo, hi ), high );
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( test, zero )) != 0xffff) break;
+        _mm_storeu_si128( (__m128i *)(dst + pos), _mm_packus_epi16( lo, hi ));
+    }
+#elif defined(__aarch64__)
+    for (; pos + 16 <= len; pos += 16)
+    {
+        uint16x8_t lo = vld1q_u16( src + pos ), hi = vld1q_u16( src + pos + 8 );
+        if (vmaxvq_u16( vorrq_u16( lo, hi )) >= 0x80) break;
+        vst1q_u8( (uint8_t *)dst + pos, vcombine_u8( vmovn_u16( lo ), vmovn_u16( hi )));
+    }
+#endif
+    for (; pos < len; pos++)
+    {
+        if (src[pos] >= 0x80) break;
+        dst[pos] = src[pos];
+    }
+    return pos;
+}
+
+/* count the leading 7-bit ASCII chars of src, up to len */
+static inline unsigned int count_ascii_wcs( const WCHAR *src, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#ifdef __SSE2__
+    const __m128i high = _mm_set1_epi16( 0xff80 );
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; pos + 8 <= len; pos += 8)
+    {
+        __m128i test = _mm_and_si128( _mm_loadu_si128( (const __m128i *)(src + pos) ), high );
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( test, zero )) != 0xffff) break;
+    }
+#elif defined(__aarch64__)
+    for (; pos + 8 <= len; pos += 8)
+        if (vmaxvq_u16( vld1q_u16( src + pos )) >= 0x80) break;
+#endif
+    while (pos < len && src[pos] < 0x80) pos++;
+    return pos;
+}
+
 /* get the next char value taking surrogates into account */
 static inline unsigned int get_surrogate_value( const WCHAR *src, unsigned int srclen )
 {
@@ -68,7 +177,10 @@ static inline int get_length_wcs_utf8( int flags, const WCHAR *src, unsigned int
     {
         if (*src < 0x80)  /* 0x00-0x7f: 1 byte */
         {
-            len++;
+            unsigned int count = count_ascii_wcs( src, srclen );
+            len += count;
+            src += count - 1;
+            srclen -= count - 1;
             continue;
         }
         if (*src < 0x800)  /* 0x80-0x7ff: 2 bytes */
@@ -108,8 +220,14 @@ int wine_utf8_wcstombs( int flags, const WCHAR *src, int srclen, char *dst, int
 
         if (ch < 0x80)  /* 0x00-0x7f: 1 byte */
         {
-            if (!len--) return -1;  /* overflow */
-            *dst++ = ch;
+            unsigned int count;
+
+            if (!len) return -1;  /* overflow */
+            count = copy_ascii_wcstombs( dst, src, srclen < len ? srclen : len );
+            len -= count;
+            dst += count;
+            src += count - 1;
+            srclen -= count - 1;
             continue;
         }
 
@@ -285,7 +403,9 @@ static inline int get_length_mbs_utf8( int flags, const char *src, int srclen )
         unsigned char ch = *src++;
         if (ch < 0x80)  /* special fast case for 7-bit ASCII */
         {
-            ret++;
+            unsigned int count = count_ascii_mbs( src, srcend - src );
+            ret += count + 1;
+            src += count;
             continue;
         }
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0x10ffff)
@@ -316,7 +436,12 @@ int wine_utf8_mbstowcs( int flags, const char *src, int srclen, WCHAR *dst, int
         unsigned char ch = *src++;
         if (ch < 0x80)  /* special fast case for 7-bit ASCII */
         {
+            unsigned int count;
+
             *dst++ = ch;
+            count = copy_ascii_mbstowcs( dst, src, srcend - src < dstend - dst ? srcend - src : dstend - dst );
+            dst += count;
+            src += count;
             continue;
         }
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0xffff)
@@ -17,6 +17,10 @@
  * License along with this library; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  */
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "wine/unicode.h"
 
 extern unsigned int wine_decompose( WCHAR ch, WCHAR *dst, unsigned int dstlen );
@@ -352,10 +356,35 @@ static inline int compare_case_weights(int flags, const WCHAR *str1, int len1,
     return len1 - len2;
 }
 
+/* length of the common prefix of two strings */
+static inline int common_prefix_len(const WCHAR *str1, const WCHAR *str2, int len)
+{
+    int pos = 0;
+
+#ifdef __SSE2__
+    for (; pos + 8 <= len; pos += 8)
+    {
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(str1 + pos));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(str2 + pos));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(v1, v2)) != 0xffff) break;
+    }
+#endif
+    while (pos < len && str1[pos] == str2[pos]) pos++;
+    return pos;
+}
+
 int wine_compare_string(int flags, const WCHAR *str1, int len1,
                         const WCHAR *str2, int len2)
 {
-    int ret;
+    int ret, prefix;
+
+    /* identical chars are handled in the same way by all the passes,
+     * so the common prefix never affects the result */
+    prefix = common_prefix_len(str1, str2, min(len1, len2));
+    str1 += prefix;
+    str2 += prefix;
+    len1 -= prefix;
+    len2 -= prefix;
 
     ret = compare_unicode_weights(flags, str1, len1, str2, len2);
     if (!ret)
@@ -326,9 +326,79 @@ static int compare_tags(const void *a, const void *b)
     return service_a->config.dwTagId - service_b->config.dwTagId;
 }
 
+struct autostart_context
+{
+    struct service_entry **services;
+    HANDLE                *done_events;
+    unsigned int           count;
+    DWORD                  start_time;
+};
+
+struct autostart_param
+{
+    struct autostart_context *context;
+    unsigned int              index;
+};
+
+static BOOL is_driver(const struct service_entry *service)
+{
+    return service->config.dwServiceType == SERVICE_KERNEL_DRIVER ||
+           service->config.dwServiceType == SERVICE_FILE_SYSTEM_DRIVER;
+}
+
+/* check whether 'service' has to wait for 'other' to be started */
+static BOOL autostart_depends_on(const struct service_entry *service, const struct service_entry *other)
+{
+    const WCHAR *ptr;
+
+    if (service->dependOnServices)
+    {
+        for (ptr = service->dependOnServices; *ptr; ptr += strlenW(ptr) + 1)
+            if (!strcmpiW(ptr, other->name)) return TRUE;
+    }
+    if (service->dependOnGroups && other->config.lpLoadOrderGroup)
+    {
+        for (ptr = service->dependOnGroups; *ptr; ptr += strlenW(ptr) + 1)
+            if (!strcmpiW(ptr, other->config.lpLoadOrderGroup)) return TRUE;
+    }
+    /* drivers of the same group are loaded into the same winedevice process */
+    return is_driver(service) && is_driver(other) &&
+           service->config.lpLoadOrderGroup && other->config.lpLoadOrderGroup &&
+           !strcmpW(service->config.lpLoadOrderGroup, other->config.lpLoadOrderGroup);
+}
+
+static DWORD WINAPI autostart_thread(void *arg)
+{
+    struct autostart_param *param = arg;
+    struct autostart_context *context = param->context;
+    struct service_entry *service = context->services[param->index];
+    unsigned int i;
+    DWORD err, start;
+
+    /* only wait for the services sorted before this one, this keeps the
+     * ordering of the sequential startup and can't deadlock */
+    for (i = 0; i < param->index; i++)
+        if (autostart_depends_on(service, context->services[i]))
+            WaitForSingleObject(context->done_events[i], INFINITE);
+
+    start = GetTickCount();
+    err = service_start(service, 0, NULL);
+    if (err != ERROR_SUCCESS)
+        WINE_FIXME("Auto-start service %s failed to start: %d\n",
+                   wine_dbgstr_w(service->name), err);
+    WINE_TRACE("service %s started at %u ms, took %u ms\n", wine_dbgstr_w(service->name),
+               start - context->start_time, GetTickCount() - start);
+
+    SetEvent(context->done_events[param->index]);
+    return 0;
+}
+
 static void scmdatabase_autostart_services(struct scmdatabase *db)
 {
     struct service_entry **services_list;
+    struct autostart_context context;
+    struct autostart_param *params;
+    HANDLE *threads;
     unsigned int i = 0;
     unsigned int size = 32;
     struct service_entry *service;
@@ -363,18 +433,43 @@ static void scmdatabase_autostart_services(struct scmdatabase *db)
     qsort(services_list, size, sizeof(services_list[0]), compare_tags);
     while (!scmdatabase_lock_startup(db)) Sleep(10);
 
+    context.services    = services_list;
+    context.count       = size;
+    context.start_time  = GetTickCount();
+    context.done_events = HeapAlloc(GetProcessHeap(), 0, size * sizeof(context.done_events[0]));
+    params  = HeapAlloc(GetProcessHeap(), 0, size * sizeof(params[0]));
+    threads = HeapAlloc(GetProcessHeap(), 0, size * sizeof(threads[0]));
+    if (!context.done_events || !params || !threads)
+    {
+        for (i = 0; i < size; i++) release_service(services_list[i]);
+        size = 0;
+    }
+
+    /* start the services concurrently, each one waits for its own dependencies */
     for (i = 0; i < size; i++)
     {
-        DWORD err;
-        service = services_list[i];
-        err = service_start(service, 0, NULL);
-        if (err != ERROR_SUCCESS)
-            WINE_FIXME("Auto-start service %s failed to start: %d\n",
-                       wine_dbgstr_w(service->name), err);
-        release_service(service);
+        params[i].context = &context;
+        params[i].index   = i;
+        context.done_events[i] = CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (!(threads[i] = CreateThread(NULL, 0, autostart_thread, &params[i], 0, NULL)))
+            autostart_thread(&params[i]);
+    }
+    for (i = 0; i < size; i++)
+    {
+        if (threads[i])
+        {
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+        }
+        CloseHandle(context.done_events[i]);
+        release_service(services_list[i]);
     }
+    WINE_TRACE("%u services started in %u ms\n", size, GetTickCount() - context.start_time);
 
     scmdatabase_unlock_startup(db);
+    HeapFree(GetProcessHeap(), 0, threads);
+    HeapFree(GetProcessHeap(), 0, params);
+    HeapFree(GetProcessHeap(), 0, context.done_events);
     HeapFree(GetProcessHeap(), 0, services_list);
 }
 
@@ -649,7 +744,7 @@ void service_unlock(struct service_entry *service)
     LeaveCriticalSection(&service->db->cs);
 }
 
-/* only one service started at a time, so there is no race on the registry
+/* called with the database lock held, so there is no race on the registry
  * value here */
 static LPWSTR service_get_pipe_name(void)
 {
@@ -939,13 +939,15 @@ static HWND show_wait_window(void)
     return hwnd;
 }
 
-static HANDLE start_rundll32( const char *inf_path, BOOL wow64 )
+static const WCHAR definstall[] = {' ','D','e','f','a','u','l','t','I','n','s','t','a','l','l',0};
+static const WCHAR wowinstall[] = {' ','W','o','w','6','4','I','n','s','t','a','l','l',0};
+static const WCHAR wowpreinstall[] = {' ','W','o','w','6','4','P','r','e','I','n','s','t','a','l','l',0};
+
+static HANDLE start_rundll32( const char *inf_path, const WCHAR *section, BOOL wow64 )
 {
     static const WCHAR rundll[] = {'\\','r','u','n','d','l','l','3','2','.','e','x','e',0};
     static const WCHAR setupapi[] = {' ','s','e','t','u','p','a','p','i',',',
                                      'I','n','s','t','a','l','l','H','i','n','f','S','e','c','t','i','o','n',0};
-    static const WCHAR definstall[] = {' ','D','e','f','a','u','l','t','I','n','s','t','a','l','l',0};
-    static const WCHAR wowinstall[] = {' ','W','o','w','6','4','I','n','s','t','a','l','l',0};
     static const WCHAR inf[] = {' ','1','2','8',' ','\\','\\','?','\\','u','n','i','x',0 };
 
     WCHAR app[MAX_PATH + sizeof(rundll)/sizeof(WCHAR)];
@@ -965,14 +967,14 @@ static HANDLE start_rundll32( const char *inf_path, BOOL wow64 )
 
     strcatW( app, rundll );
 
-    cmd_len = strlenW(app) * sizeof(WCHAR) + sizeof(setupapi) + sizeof(definstall) + sizeof(inf);
+    cmd_len = (strlenW(app) + strlenW(section)) * sizeof(WCHAR) + sizeof(setupapi) + sizeof(inf);
     inf_len = MultiByteToWideChar( CP_UNIXCP, 0, inf_path, -1, NULL, 0 );
 
     if (!(buffer = HeapAlloc( GetProcessHeap(), 0, cmd_len + inf_len * sizeof(WCHAR) ))) return 0;
 
     strcpyW( buffer, app );
     strcatW( buffer, setupapi );
-    strcatW( buffer, wow64 ? wowinstall : definstall );
+    strcatW( buffer, section );
     strcatW( buffer, inf );
     MultiByteToWideChar( CP_UNIXCP, 0, inf_path, -1, buffer + strlenW(buffer), inf_len );
 
@@ -985,6 +987,28 @@ static HANDLE start_rundll32( const char *inf_path, BOOL wow64 )
     return pi.hProcess;
 }
 
+/* wait for the processes to exit while processing messages for the wait window */
+static void wait_for_processes( HANDLE *processes, DWORD count )
+{
+    while (count)
+    {
+        MSG msg;
+        DWORD res = MsgWaitForMultipleObjects( count, processes, FALSE, INFINITE, QS_ALLINPUT );
+
+        if (res < WAIT_OBJECT_0 + count)
+        {
+            CloseHandle( processes[res - WAIT_OBJECT_0] );
+            processes[res - WAIT_OBJECT_0] = processes[--count];
+        }
+        else if (res == WAIT_OBJECT_0 + count)
+        {
+            while (PeekMessageW( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageW( &msg );
+        }
+        else break;
+    }
+    while (count) CloseHandle( processes[--count] );
+}
+
 /* execute rundll32 on the wine.inf file if necessary */
 static void update_wineprefix( BOOL force )
 {
@@ -1009,25 +1033,27 @@ static void update_wineprefix( BOOL force )
 
     if (update_timestamp( config_dir, st.st_mtime ) || force)
     {
-        HANDLE process;
+        WCHAR wow64_dir[MAX_PATH];
+        HANDLE processes[2];
         DWORD count = 0;
+        HWND hwnd = 0;
 
-        if ((process = start_rundll32( inf_path, FALSE )))
+        /* the 32-bit install needs the Wow64 registry links, create them first;
+         * after that both architectures are installed at the same time */
+        if (GetSystemWow64DirectoryW( wow64_dir, MAX_PATH ) &&
+            (processes[0] = start_rundll32( inf_path, wowpreinstall, FALSE )))
         {
-            HWND hwnd = show_wait_window();
-            for (;;)
-            {
-                MSG msg;
-                DWORD res = MsgWaitForMultipleObjects( 1, &process, FALSE, INFINITE, QS_ALLINPUT );
-                if (res == WAIT_OBJECT_0)
-                {
-                    CloseHandle( process );
-                    if (count++ || !(process = start_rundll32( inf_path, TRUE ))) break;
-                }
-                else while (PeekMessageW( &msg, 0, 0, 0, PM_REMOVE )) DispatchMessageW( &msg );
-            }
-            DestroyWindow( hwnd );
+            hwnd = show_wait_window();
+            wait_for_processes( processes, 1 );
+        }
+        if ((processes[count] = start_rundll32( inf_path, definstall, FALSE )))
+        {
+            count++;
+            if ((processes[count] = start_rundll32( inf_path, wowinstall, TRUE ))) count++;
+            if (!hwnd) hwnd = show_wait_window();
+            wait_for_processes( processes, count );
         }
+        if (hwnd) DestroyWindow( hwnd );
         WINE_MESSAGE( "wine: configuration in '%s' has been updated.\n", config_dir );
     }
 
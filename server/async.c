@@ -280,6 +280,34 @@ struct async *create_request_async( struct fd *fd, const async_data_t *data )
     return async;
 }
 
+/* same as create_request_async, but the iosb takes over the request data buffer
+ * instead of copying it; the caller must not access the request data afterwards */
+struct async *create_request_async_take_data( struct fd *fd, const async_data_t *data )
+{
+    struct async *async;
+    struct iosb *iosb;
+
+    if (!(iosb = create_iosb( NULL, 0, get_reply_max_size() ))) return NULL;
+    if ((iosb->in_size = get_req_data_size()))
+    {
+        iosb->in_data = current->req_data;
+        current->req_data = NULL;
+    }
+
+    async = create_async( fd, current, data, iosb );
+    release_object( iosb );
+    if (async)
+    {
+        if (!(async->wait_handle = alloc_handle( current->process, async, SYNCHRONIZE, 0 )))
+        {
+            release_object( async );
+            return NULL;
+        }
+        async->direct_result = 1;
+    }
+    return async;
+}
+
 /* return async object status and wait handle to client */
 obj_handle_t async_handoff( struct async *async, int success, data_size_t *result )
 {
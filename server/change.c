@@ -121,6 +121,10 @@ static void free_inode( struct inode *inode );
 
 static struct fd *inotify_fd;
 
+/* limits on the queued change records of a directory */
+#define MAX_CHANGE_RECORDS   65536
+#define MAX_COALESCE_RECORDS 64
+
 struct change_record {
     struct list entry;
     unsigned int cookie;
@@ -139,6 +143,8 @@ struct dir
     int            want_data; /* return change data */
     int            subtree;  /* do we want to watch subdirectories? */
     struct list    change_records;   /* data for the change */
+    unsigned int   records_count;    /* number of queued change records */
+    int            overflow;         /* records were dropped, client must rescan */
     struct list    in_entry; /* entry in the inode dirs list */
     struct inode  *inode;    /* inode of the associated directory */
     struct process *client_process;  /* client process that has a cache for this directory */
@@ -710,6 +716,21 @@ static int inotify_get_poll_events( struct fd *fd )
     return POLLIN;
 }
 
+/* check whether a modification of the same file is still waiting to be read */
+static int is_modify_queued( struct dir *dir, const char *name, size_t len )
+{
+    struct change_record *record;
+    unsigned int count = 0;
+
+    LIST_FOR_EACH_ENTRY_REV( record, &dir->change_records, struct change_record, entry )
+    {
+        if (++count > MAX_COALESCE_RECORDS) break;
+        if (record->event.len != len || memcmp( record->event.name, name, len )) continue;
+        return record->event.action == FILE_ACTION_MODIFIED;
+    }
+    return 0;
+}
+
 static void inotify_do_change_notify( struct dir *dir, unsigned int action,
                                       unsigned int cookie, const char *relpath )
 {
@@ -717,9 +738,22 @@ static void inotify_do_change_notify( struct dir *dir, unsigned int action,
 
     assert( dir->obj.ops == &dir_ops );
 
-    if (dir->want_data)
+    if (dir->want_data && !dir->overflow)
     {
         size_t len = strlen(relpath);
+
+        if (action == FILE_ACTION_MODIFIED && is_modify_queued( dir, relpath, len ))
+            goto done;
+
+        if (dir->records_count >= MAX_CHANGE_RECORDS)
+        {
+            /* nobody is reading, drop everything and let the client rescan the directory */
+            while ((record = get_first_change_record( dir ))) free( record );
+            dir->records_count = 0;
+            dir->overflow = 1;
+            goto done;
+        }
+
         record = malloc( offsetof(struct change_record, event.name[len]) );
         if (!record)
             return;
@@ -730,8 +764,10 @@ static void inotify_do_change_notify( struct dir *dir, unsigned int action,
         record->event.len = len;
 
         list_add_tail( &dir->change_records, &record->entry );
+        dir->records_count++;
     }
 
+done:
     fd_async_wake_up( dir->fd, ASYNC_TYPE_WAIT, STATUS_ALERTED );
 }
 
@@ -935,7 +971,7 @@ static void inotify_notify_all( struct inotify_event *ie )
 static void inotify_poll_event( struct fd *fd, int event )
 {
     int r, ofs, unix_fd;
-    char buffer[0x1000];
+    static char buffer[0x10000];  /* large enough to drain a burst of events in one read */
     struct inotify_event *ie;
 
     unix_fd = get_unix_fd( fd );
@@ -1189,6 +1225,8 @@ struct object *create_dir_obj( struct fd *fd, unsigned int access, mode_t mode )
         return NULL;
 
     list_init( &dir->change_records );
+    dir->records_count = 0;
+    dir->overflow = 0;
     dir->filter = 0;
     dir->notified = 0;
     dir->want_data = 0;
@@ -1262,7 +1300,7 @@ DECL_HANDLER(read_directory_changes)
     }
 
     /* if there's already a change in the queue, send it */
-    if (!list_empty( &dir->change_records ))
+    if (!list_empty( &dir->change_records ) || dir->overflow)
         fd_async_wake_up( dir->fd, ASYNC_TYPE_WAIT, STATUS_ALERTED );
 
     /* setup the real notification */
@@ -1282,31 +1320,63 @@ DECL_HANDLER(read_change)
     struct dir *dir;
     struct list events;
     char *data, *event;
-    int size = 0;
+    data_size_t size = 0, max_size = get_reply_max_size();
+    unsigned int count = 0;
 
     dir = get_dir_obj( current->process, req->handle, 0 );
     if (!dir)
         return;
 
+    if (dir->overflow)
+    {
+        dir->overflow = 0;
+        release_object( dir );
+        set_error( STATUS_NOTIFY_ENUM_DIR );
+        return;
+    }
+
+    /* return as many records as fit, the rest stays queued for the next read */
     list_init( &events );
-    list_move_tail( &events, &dir->change_records );
-    release_object( dir );
+    LIST_FOR_EACH_ENTRY_SAFE( record, next, &dir->change_records, struct change_record, entry )
+    {
+        data_size_t len = (offsetof(struct filesystem_event, name[record->event.len])
+                           + sizeof(int)-1) / sizeof(int) * sizeof(int);
+
+        if (size + len > max_size) break;
+        /* don't split a rename pair */
+        if (record->event.action == FILE_ACTION_RENAMED_OLD_NAME && count &&
+            list_next( &dir->change_records, &record->entry ) &&
+            size + len + (offsetof(struct filesystem_event, name[next->event.len])
+                          + sizeof(int)-1) / sizeof(int) * sizeof(int) > max_size)
+            break;
+        list_remove( &record->entry );
+        list_add_tail( &events, &record->entry );
+        size += len;
+        count++;
+    }
+    dir->records_count -= count;
 
     if (list_empty( &events ))
     {
-        set_error( STATUS_NO_DATA_DETECTED );
+        if (list_empty( &dir->change_records ))
+            set_error( STATUS_NO_DATA_DETECTED );
+        else
+        {
+            /* not even a single record fits, drop them */
+            while ((record = get_first_change_record( dir ))) free( record );
+            dir->records_count = 0;
+            set_error( STATUS_BUFFER_TOO_SMALL );
+        }
+        release_object( dir );
         return;
     }
 
-    LIST_FOR_EACH_ENTRY( record, &events, struct change_record, entry )
-    {
-        size += (offsetof(struct filesystem_event, name[record->event.len])
-                + sizeof(int)-1) / sizeof(int) * sizeof(int);
-    }
+    /* wake up the next waiter for the remaining records */
+    if (!list_empty( &dir->change_records ))
+        fd_async_wake_up( dir->fd, ASYNC_TYPE_WAIT, STATUS_ALERTED );
+    release_object( dir );
 
-    if (size > get_reply_max_size())
-        set_error( STATUS_BUFFER_TOO_SMALL );
-    else if ((data = mem_alloc( size )) != NULL)
+    if ((data = mem_alloc( size )) != NULL)
     {
         event = data;
         LIST_FOR_EACH_ENTRY( record, &events, struct change_record, entry )
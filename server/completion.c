@@ -240,6 +240,42 @@ DECL_HANDLER(remove_completion)
     release_object( completion );
 }
 
+/* get several messages from completion port queue */
+DECL_HANDLER(remove_completions)
+{
+    struct completion* completion = get_completion_obj( current->process, req->handle, IO_COMPLETION_MODIFY_STATE );
+    struct completion_entry *entries;
+    data_size_t count, i;
+    struct comp_msg *msg;
+
+    if (!completion) return;
+
+    if (list_empty( &completion->queue ))
+        set_error( STATUS_PENDING );
+    else
+    {
+        count = min( completion->depth, get_reply_max_size() / sizeof(*entries) );
+        if (count && (entries = set_reply_data_size( count * sizeof(*entries) )))
+        {
+            for (i = 0; i < count; i++)
+            {
+                msg = LIST_ENTRY( list_head( &completion->queue ), struct comp_msg, queue_entry );
+                list_remove( &msg->queue_entry );
+                completion->depth--;
+                entries[i].ckey        = msg->ckey;
+                entries[i].cvalue      = msg->cvalue;
+                entries[i].information = msg->information;
+                entries[i].status      = msg->status;
+                entries[i].__pad       = 0;
+                free( msg );
+            }
+        }
+        else if (!count) set_error( STATUS_BUFFER_TOO_SMALL );
+    }
+
+    release_object( completion );
+}
+
 /* get queue depth for completion port */
 DECL_HANDLER(query_completion)
 {
@@ -189,6 +189,8 @@ struct fd
     unsigned int         signaled :1; /* is the fd signaled? */
     unsigned int         fs_locks :1; /* can we use filesystem locks for this fd? */
     int                  poll_index;  /* index of fd in poll array */
+    int                  epoll_events;/* events currently registered with epoll */
+    struct list          epoll_entry; /* entry in list of fds with pending epoll changes */
     struct async_queue   read_q;      /* async readers of this fd */
     struct async_queue   write_q;     /* async writers of this fd */
     struct async_queue   wait_q;      /* other async waiters of this fd */
@@ -358,13 +360,20 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    int                   index;      /* index in the timeout heap, -1 once expired */
+    struct list           entry;      /* entry in expired list */
     timeout_t             when;       /* timeout expiry (absolute time) */
+    unsigned int          seq;        /* insertion order, for timeouts expiring at the same time */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list timeout_list = LIST_INIT(timeout_list);   /* sorted timeouts list */
+/* pending timeouts, in a binary min-heap ordered by expiry time */
+static struct timeout_user **timeout_heap;
+static unsigned int timeout_count;
+static unsigned int timeout_size;
+static unsigned int timeout_seq;
+static struct list expired_list = LIST_INIT(expired_list);  /* expired timeouts not called yet */
 timeout_t current_time;
 
 static inline void set_current_time(void)
@@ -375,32 +384,85 @@ static inline void set_current_time(void)
     current_time = (timeout_t)now.tv_sec * TICKS_PER_SEC + now.tv_usec * 10 + ticks_1601_to_1970;
 }
 
+static inline int timeout_before( const struct timeout_user *a, const struct timeout_user *b )
+{
+    if (a->when != b->when) return a->when < b->when;
+    return (int)(a->seq - b->seq) < 0;
+}
+
+static inline void set_heap_entry( unsigned int index, struct timeout_user *user )
+{
+    timeout_heap[index] = user;
+    user->index = index;
+}
+
+/* move a heap entry up or down until the heap order is restored */
+static void fix_timeout_heap( unsigned int index )
+{
+    struct timeout_user *user = timeout_heap[index];
+    unsigned int child;
+
+    while (index && timeout_before( user, timeout_heap[(index - 1) / 2] ))
+    {
+        set_heap_entry( index, timeout_heap[(index - 1) / 2] );
+        index = (index - 1) / 2;
+    }
+    while ((child = 2 * index + 1) < timeout_count)
+    {
+        if (child + 1 < timeout_count && timeout_before( timeout_heap[child + 1], timeout_heap[child] ))
+            child++;
+        if (!timeout_before( timeout_heap[child], user )) break;
+        set_heap_entry( index, timeout_heap[child] );
+        index = child;
+    }
+    set_heap_entry( index, user );
+}
+
+/* remove an entry from the timeout heap */
+static void remove_from_timeout_heap( struct timeout_user *user )
+{
+    unsigned int index = user->index;
+
+    user->index = -1;
+    if (index == --timeout_count) return;
+    set_heap_entry( index, timeout_heap[timeout_count] );
+    fix_timeout_heap( index );
+}
+
 /* add a timeout user */
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
 
+    if (timeout_count == timeout_size)
+    {
+        unsigned int new_size = max( 64, timeout_size * 2 );
+        struct timeout_user **new_heap = realloc( timeout_heap, new_size * sizeof(*new_heap) );
+
+        if (!new_heap)
+        {
+            set_error( STATUS_NO_MEMORY );
+            return NULL;
+        }
+        timeout_heap = new_heap;
+        timeout_size = new_size;
+    }
     if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
     user->when     = (when > 0) ? when : current_time - when;
+    user->seq      = timeout_seq++;
     user->callback = func;
     user->private  = private;
 
-    /* Now insert it in the linked list */
-
-    LIST_FOR_EACH( ptr, &timeout_list )
-    {
-        struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-        if (timeout->when >= user->when) break;
-    }
-    list_add_before( ptr, &user->entry );
+    set_heap_entry( timeout_count++, user );
+    fix_timeout_heap( user->index );
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
+    if (user->index == -1) list_remove( &user->entry );  /* expired but not called yet */
+    else remove_from_timeout_heap( user );
     free( user );
 }
 
@@ -447,6 +509,9 @@ static struct fd **poll_users;              /* users array */
 static struct pollfd *pollfd;               /* poll fd array */
 static int nb_users;                        /* count of array entries actually in use */
 static int active_users;                    /* current number of active users */
+static unsigned int poll_wait_count;        /* number of calls waiting for events */
+static unsigned int poll_ctl_count;         /* number of calls changing the waited events */
+static unsigned int poll_ctl_coalesced;     /* number of event changes that didn't need a call */
 static int allocated_users;                 /* count of allocated entries in the array */
 static struct fd **freelist;                /* list of free entries in the array */
 
@@ -460,66 +525,108 @@ static inline void fd_poll_event( struct fd *fd, int event )
 #ifdef USE_EPOLL
 
 static int epoll_fd = -1;
+static struct list epoll_changes = LIST_INIT( epoll_changes );  /* fds with pending event changes */
 
 static inline void init_epoll(void)
 {
     epoll_fd = epoll_create( 128 );
 }
 
-/* set the events that epoll waits for on this fd; helper for set_fd_events */
-static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
+static void do_epoll_ctl( struct fd *fd, int ctl, int user, int events )
 {
     struct epoll_event ev;
-    int ctl;
 
+    ev.events = events;
+    memset(&ev.data, 0, sizeof(ev.data));
+    ev.data.u32 = user;
+
+    poll_ctl_count++;
+    if (epoll_ctl( epoll_fd, ctl, fd->unix_fd, &ev ) == -1)
+    {
+        if (errno == ENOMEM)  /* not enough memory, give up on epoll */
+        {
+            close( epoll_fd );
+            epoll_fd = -1;
+        }
+        else perror( "epoll_ctl" );  /* should not happen */
+    }
+    else fd->epoll_events = events;
+}
+
+/* set the events that epoll waits for on this fd; helper for set_fd_events */
+static inline void set_fd_epoll_events( struct fd *fd, int user, int events )
+{
     if (epoll_fd == -1) return;
 
     if (events == -1)  /* stop waiting on this fd completely */
     {
         if (pollfd[user].fd == -1) return;  /* already removed */
-        ctl = EPOLL_CTL_DEL;
+        list_remove( &fd->epoll_entry );
+        list_init( &fd->epoll_entry );
+        do_epoll_ctl( fd, EPOLL_CTL_DEL, user, 0 );
     }
     else if (pollfd[user].fd == -1)
     {
         if (pollfd[user].events) return;  /* stopped waiting on it, don't restart */
-        ctl = EPOLL_CTL_ADD;
+        do_epoll_ctl( fd, EPOLL_CTL_ADD, user, events );
     }
-    else
+    else if (list_empty( &fd->epoll_entry ))
     {
-        if (pollfd[user].events == events) return;  /* nothing to do */
-        ctl = EPOLL_CTL_MOD;
+        /* modifications are applied right before the next wait, so that an fd
+         * whose events change several times while handling a batch costs at most one call */
+        if (fd->epoll_events != events) list_add_tail( &epoll_changes, &fd->epoll_entry );
     }
+    else poll_ctl_coalesced++;
+}
 
-    ev.events = events;
-    memset(&ev.data, 0, sizeof(ev.data));
-    ev.data.u32 = user;
+/* apply the pending event changes before waiting */
+static void flush_epoll_changes(void)
+{
+    struct list *ptr;
 
-    if (epoll_ctl( epoll_fd, ctl, fd->unix_fd, &ev ) == -1)
+    while ((ptr = list_head( &epoll_changes )))
     {
-        if (errno == ENOMEM)  /* not enough memory, give up on epoll */
+        struct fd *fd = LIST_ENTRY( ptr, struct fd, epoll_entry );
+        int user = fd->poll_index;
+
+        list_remove( &fd->epoll_entry );
+        list_init( &fd->epoll_entry );
+        if (epoll_fd == -1) continue;
+        if (pollfd[user].fd == -1 || pollfd[user].events == fd->epoll_events)
         {
-            close( epoll_fd );
-            epoll_fd = -1;
+            poll_ctl_coalesced++;
+            continue;
         }
-        else perror( "epoll_ctl" );  /* should not happen */
+        do_epoll_ctl( fd, EPOLL_CTL_MOD, user, pollfd[user].events );
     }
 }
 
 static inline void remove_epoll_user( struct fd *fd, int user )
 {
+    list_remove( &fd->epoll_entry );
+    list_init( &fd->epoll_entry );
+
     if (epoll_fd == -1) return;
 
     if (pollfd[user].fd != -1)
     {
         struct epoll_event dummy;
+        poll_ctl_count++;
         epoll_ctl( epoll_fd, EPOLL_CTL_DEL, fd->unix_fd, &dummy );
     }
 }
 
 static inline void main_loop_epoll(void)
 {
+    static struct epoll_event *events;
+    static int max_events;
     int i, ret, timeout;
-    struct epoll_event events[128];
+
+    if (!events)
+    {
+        max_events = 128;
+        if (!(events = malloc( max_events * sizeof(*events) ))) return;
+    }
 
     assert( POLLIN == EPOLLIN );
     assert( POLLOUT == EPOLLOUT );
@@ -535,7 +642,15 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (epoll_fd == -1) break;  /* an error occurred with epoll */
 
-        ret = epoll_wait( epoll_fd, events, sizeof(events)/sizeof(events[0]), timeout );
+        flush_epoll_changes();
+        if (epoll_fd == -1) break;
+
+        if (!shm_requests_prepare_sleep()) timeout = 0;
+        stats_sleep_begin();
+        poll_wait_count++;
+        ret = epoll_wait( epoll_fd, events, max_events, timeout );
+        stats_sleep_end();
+        shm_requests_end_sleep();
         set_current_time();
 
         /* put the events into the pollfd array first, like poll does */
@@ -551,6 +666,17 @@ static inline void main_loop_epoll(void)
             int user = events[i].data.u32;
             if (pollfd[user].revents) fd_poll_event( poll_users[user], pollfd[user].revents );
         }
+
+        /* the array was full, get more events at once next time */
+        if (ret == max_events && max_events < 4096)
+        {
+            struct epoll_event *new_events = realloc( events, 2 * max_events * sizeof(*events) );
+            if (new_events)
+            {
+                events = new_events;
+                max_events *= 2;
+            }
+        }
     }
 }
 
@@ -640,6 +766,8 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (kqueue_fd == -1) break;  /* an error occurred with kqueue */
 
+        if (!shm_requests_prepare_sleep()) timeout = 0;
+        stats_sleep_begin();
         if (timeout != -1)
         {
             struct timespec ts;
@@ -649,6 +777,8 @@ static inline void main_loop_epoll(void)
             ret = kevent( kqueue_fd, NULL, 0, events, sizeof(events)/sizeof(events[0]), &ts );
         }
         else ret = kevent( kqueue_fd, NULL, 0, events, sizeof(events)/sizeof(events[0]), NULL );
+        stats_sleep_end();
+        shm_requests_end_sleep();
 
         set_current_time();
 
@@ -744,6 +874,8 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (port_fd == -1) break;  /* an error occurred with event completion */
 
+        if (!shm_requests_prepare_sleep()) timeout = 0;
+        stats_sleep_begin();
         if (timeout != -1)
         {
             struct timespec ts;
@@ -753,6 +885,8 @@ static inline void main_loop_epoll(void)
             ret = port_getn( port_fd, events, sizeof(events)/sizeof(events[0]), &nget, &ts );
         }
         else ret = port_getn( port_fd, events, sizeof(events)/sizeof(events[0]), &nget, NULL );
+        stats_sleep_end();
+        shm_requests_end_sleep();
 
 	if (ret == -1) break;  /* an error occurred with event completion */
 
@@ -824,6 +958,8 @@ static int add_poll_user( struct fd *fd )
     pollfd[ret].events = 0;
     pollfd[ret].revents = 0;
     poll_users[ret] = fd;
+    fd->epoll_events = 0;
+    list_init( &fd->epoll_entry );
     active_users++;
     return ret;
 }
@@ -846,23 +982,17 @@ static void remove_poll_user( struct fd *fd, int user )
 /* process pending timeouts and return the time until the next timeout, in milliseconds */
 static int get_next_timeout(void)
 {
-    if (!list_empty( &timeout_list ))
+    if (timeout_count)
     {
-        struct list expired_list, *ptr;
+        struct list *ptr;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the heap, in expiry order */
 
-        list_init( &expired_list );
-        while ((ptr = list_head( &timeout_list )) != NULL)
+        while (timeout_count && timeout_heap[0]->when <= current_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            struct timeout_user *timeout = timeout_heap[0];
+            remove_from_timeout_heap( timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
 
         /* now call the callback for all the removed timers */
@@ -875,10 +1005,9 @@ static int get_next_timeout(void)
             free( timeout );
         }
 
-        if ((ptr = list_head( &timeout_list )) != NULL)
+        if (timeout_count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            int diff = (timeout->when - current_time + 9999) / 10000;
+            int diff = (timeout_heap[0]->when - current_time + 9999) / 10000;
             if (diff < 0) diff = 0;
             return diff;
         }
@@ -903,7 +1032,12 @@ void main_loop(void)
 
         if (!active_users) break;  /* last user removed by a timeout */
 
+        if (!shm_requests_prepare_sleep()) timeout = 0;
+        stats_sleep_begin();
+        poll_wait_count++;
         ret = poll( pollfd, nb_users, timeout );
+        stats_sleep_end();
+        shm_requests_end_sleep();
         set_current_time();
 
         if (ret > 0)
@@ -920,6 +1054,13 @@ void main_loop(void)
     }
 }
 
+/* dump the event loop statistics */
+void dump_poll_stats(void)
+{
+    fprintf( stderr, "poll: %u waits, %u event changes, %u changes coalesced, %d active fds\n",
+             poll_wait_count, poll_ctl_count, poll_ctl_coalesced, active_users );
+}
+
 
 /****************************************************************/
 /* device functions */
@@ -1940,6 +2081,19 @@ int get_unix_fd( struct fd *fd )
     return fd->unix_fd;
 }
 
+/* send the unix fd of a new handle to the client, if it can be cached there */
+/* returns the fd type, or FD_TYPE_INVALID if nothing was sent */
+int send_handle_fd( struct fd *fd, obj_handle_t handle )
+{
+    if (!fd->cacheable || fd->unix_fd == -1) return FD_TYPE_INVALID;
+    if (send_client_fd( current->process, fd->unix_fd, handle ) == -1)
+    {
+        clear_error();
+        return FD_TYPE_INVALID;
+    }
+    return fd->fd_ops->get_fd_type( fd );
+}
+
 /* check if two file descriptors point to the same file */
 int is_same_file_fd( struct fd *fd1, struct fd *fd2 )
 {
@@ -2498,7 +2652,8 @@ DECL_HANDLER(write)
 
     if (!fd) return;
 
-    if ((async = create_request_async( fd, &req->async )))
+    /* the written data is only accessed through the iosb, no need to copy it */
+    if ((async = create_request_async_take_data( fd, &req->async )))
     {
         reply->wait    = async_handoff( async, fd->fd_ops->write( fd, async, req->pos ), &reply->size );
         reply->options = fd->options;
@@ -727,7 +727,23 @@ DECL_HANDLER(create_file)
     if ((file = create_file( root_fd, name, name_len, req->access, req->sharing,
                              req->create, req->options, req->attrs, sd )))
     {
+        struct fd *fd;
+
         reply->handle = alloc_handle( current->process, file, req->access, objattr->attributes );
+        /* send the fd right away, the client would ask for it on the first use of the handle */
+        if (reply->handle)
+        {
+            if ((fd = get_obj_fd( file )))
+            {
+                if ((reply->fd_type = send_handle_fd( fd, reply->handle )) != FD_TYPE_INVALID)
+                {
+                    reply->fd_access  = get_handle_access( current->process, reply->handle );
+                    reply->fd_options = get_fd_options( fd );
+                }
+                release_object( fd );
+            }
+            else clear_error();
+        }
         release_object( file );
     }
     if (root_fd) release_object( root_fd );
@@ -41,8 +41,8 @@
 
 struct handle_entry
 {
-    struct object *ptr;       /* object */
-    unsigned int   access;    /* access rights */
+    struct object *ptr;       /* object, NULL for a free entry */
+    unsigned int   access;    /* access rights, or index of the next free entry */
 };
 
 struct handle_table
@@ -50,8 +50,9 @@ struct handle_table
     struct object        obj;         /* object header */
     struct process      *process;     /* process owning this table */
     int                  count;       /* number of allocated entries */
-    int                  last;        /* last used entry */
-    int                  free;        /* first entry that may be free */
+    int                  last;        /* last initialized entry */
+    int                  free;        /* first entry of the free list, or -1 */
+    int                  used;        /* number of entries in use */
     struct handle_entry *entries;     /* handle entries */
 };
 
@@ -146,8 +147,8 @@ static void handle_table_dump( struct object *obj, int verbose )
 
     assert( obj->ops == &handle_table_ops );
 
-    fprintf( stderr, "Handle table last=%d count=%d process=%p\n",
-             table->last, table->count, table->process );
+    fprintf( stderr, "Handle table last=%d count=%d used=%d process=%p\n",
+             table->last, table->count, table->used, table->process );
     if (!verbose) return;
     entry = table->entries;
     for (i = 0; i <= table->last; i++, entry++)
@@ -208,7 +209,8 @@ struct handle_table *alloc_handle_table( struct process *process, int count )
     table->process = process;
     table->count   = count;
     table->last    = -1;
-    table->free    = 0;
+    table->free    = -1;
+    table->used    = 0;
     if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
     release_object( table );
     return NULL;
@@ -231,21 +233,26 @@ static int grow_handle_table( struct handle_table *table )
     return 1;
 }
 
-/* allocate the first free entry in the handle table */
+/* allocate an entry in the handle table */
+/* like on Windows, the most recently freed entry is reused first */
 static obj_handle_t alloc_entry( struct handle_table *table, void *obj, unsigned int access )
 {
-    struct handle_entry *entry = table->entries + table->free;
-    int i;
+    struct handle_entry *entry;
+    int i = table->free;
 
-    for (i = table->free; i <= table->last; i++, entry++) if (!entry->ptr) goto found;
-    if (i >= table->count)
+    if (i != -1)
+    {
+        entry = table->entries + i;
+        table->free = entry->access;
+    }
+    else
     {
-        if (!grow_handle_table( table )) return 0;
-        entry = table->entries + i;  /* the entries may have moved */
+        i = table->last + 1;
+        if (i >= table->count && !grow_handle_table( table )) return 0;
+        table->last = i;
+        entry = table->entries + i;
     }
-    table->last = i;
- found:
-    table->free = i + 1;
+    table->used++;
     entry->ptr    = grab_object_for_handle( obj );
     entry->access = access;
     return index_to_handle(i);
@@ -331,19 +338,34 @@ static struct handle_entry *get_handle( struct process *process, obj_handle_t ha
     return entry;
 }
 
+/* drop the free entries at the end of the table and rebuild the free list, lowest entries first */
+static void rebuild_free_list( struct handle_table *table )
+{
+    struct handle_entry *entry;
+    int i;
+
+    while (table->last >= 0 && !table->entries[table->last].ptr) table->last--;
+    table->free = -1;
+    table->used = 0;
+    for (i = table->last, entry = table->entries + i; i >= 0; i--, entry--)
+    {
+        if (entry->ptr)
+        {
+            table->used++;
+            continue;
+        }
+        entry->access = table->free;
+        table->free = i;
+    }
+}
+
 /* attempt to shrink a table */
 static void shrink_handle_table( struct handle_table *table )
 {
-    struct handle_entry *entry = table->entries + table->last;
     struct handle_entry *new_entries;
     int count = table->count;
 
-    while (table->last >= 0)
-    {
-        if (entry->ptr) break;
-        table->last--;
-        entry--;
-    }
+    rebuild_free_list( table );
     if (table->last >= count / 4) return;  /* no need to shrink */
     if (count < MIN_HANDLE_ENTRIES * 2) return;  /* too small to shrink */
     count /= 2;
@@ -395,8 +417,11 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
     entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
-    if (entry < table->entries + table->free) table->free = entry - table->entries;
-    if (entry == table->entries + table->last) shrink_handle_table( table );
+    entry->access = table->free;
+    table->free = entry - table->entries;
+    /* the free list is only rebuilt when the table is mostly empty */
+    if (--table->used < table->count / 4 && entry == table->entries + table->last)
+        shrink_handle_table( table );
     release_object_from_handle( obj );
     return STATUS_SUCCESS;
 }
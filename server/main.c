@@ -50,11 +50,13 @@ static void usage( FILE *fh )
 {
     fprintf(fh, "Usage: %s [options]\n\n", server_argv0);
     fprintf(fh, "Options:\n");
+    fprintf(fh, "   -c file, --capture=file  record all the requests to a file\n");
     fprintf(fh, "   -d[n], --debug[=n]       set debug level to n or +1 if n not specified\n");
     fprintf(fh, "   -f,    --foreground      remain in the foreground for debugging\n");
     fprintf(fh, "   -h,    --help            display this help message\n");
     fprintf(fh, "   -k[n], --kill[=n]        kill the current wineserver, optionally with signal n\n");
     fprintf(fh, "   -p[n], --persistent[=n]  make server persistent, optionally for n seconds\n");
+    fprintf(fh, "   -s,    --stats           make the current wineserver dump its request statistics\n");
     fprintf(fh, "   -v,    --version         display version information and exit\n");
     fprintf(fh, "   -w,    --wait            wait until the current wineserver terminates\n");
     fprintf(fh, "\n");
@@ -66,11 +68,13 @@ static void parse_args( int argc, char *argv[] )
 
     static struct option long_options[] =
     {
+        {"capture",     1, NULL, 'c'},
         {"debug",       2, NULL, 'd'},
         {"foreground",  0, NULL, 'f'},
         {"help",        0, NULL, 'h'},
         {"kill",        2, NULL, 'k'},
         {"persistent",  2, NULL, 'p'},
+        {"stats",       0, NULL, 's'},
         {"version",     0, NULL, 'v'},
         {"wait",        0, NULL, 'w'},
         { NULL,         0, NULL, 0}
@@ -78,10 +82,13 @@ static void parse_args( int argc, char *argv[] )
 
     server_argv0 = argv[0];
 
-    while ((optc = getopt_long( argc, argv, "d::fhk::p::vw", long_options, NULL )) != -1)
+    while ((optc = getopt_long( argc, argv, "c:d::fhk::p::svw", long_options, NULL )) != -1)
     {
         switch(optc)
         {
+            case 'c':
+                open_request_capture( optarg );
+                break;
             case 'd':
                 if (optarg && isdigit(*optarg))
                     debug_level = atoi( optarg );
@@ -107,6 +114,8 @@ static void parse_args( int argc, char *argv[] )
                 else
                     master_socket_timeout = TIMEOUT_INFINITE;
                 break;
+            case 's':
+                exit( !kill_lock_owner( SIGUSR1 ));
             case 'v':
                 fprintf( stderr, "%s\n", wine_get_build_id());
                 exit(0);
@@ -29,6 +29,9 @@
 #ifdef HAVE_SYS_MMAN_H
 # include <sys/mman.h>
 #endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -117,6 +120,44 @@ static const struct object_ops shared_map_ops =
 
 static struct list shared_map_list = LIST_INIT( shared_map_list );
 
+/* file holding the relocated pages of a PE image mapped at a given address */
+struct image_reloc
+{
+    struct object   obj;             /* object header */
+    struct fd      *fd;              /* file descriptor of the mapped PE file */
+    struct file    *file;            /* temp file holding the relocated sections */
+    client_ptr_t    base;            /* address the image has been relocated to */
+    int             ready;           /* whether the relocated data has been written */
+    struct list     entry;           /* entry in global image relocations list */
+};
+
+static void image_reloc_dump( struct object *obj, int verbose );
+static void image_reloc_destroy( struct object *obj );
+
+static const struct object_ops image_reloc_ops =
+{
+    sizeof(struct image_reloc), /* size */
+    image_reloc_dump,          /* dump */
+    no_get_type,               /* get_type */
+    no_add_queue,              /* add_queue */
+    NULL,                      /* remove_queue */
+    NULL,                      /* signaled */
+    NULL,                      /* satisfied */
+    no_signal,                 /* signal */
+    no_get_fd,                 /* get_fd */
+    no_map_access,             /* map_access */
+    default_get_sd,            /* get_sd */
+    default_set_sd,            /* set_sd */
+    no_lookup_name,            /* lookup_name */
+    no_link_name,              /* link_name */
+    NULL,                      /* unlink_name */
+    no_open_file,              /* open_file */
+    no_close_handle,           /* close_handle */
+    image_reloc_destroy        /* destroy */
+};
+
+static struct list image_reloc_list = LIST_INIT( image_reloc_list );
+
 /* memory view mapped in client address space */
 struct memory_view
 {
@@ -124,6 +165,7 @@ struct memory_view
     struct fd      *fd;              /* fd for mapped file */
     struct ranges  *committed;       /* list of committed ranges in this mapping */
     struct shared_map *shared;       /* temp file for shared PE mapping */
+    struct image_reloc *reloc;       /* relocated pages for PE mapping */
     unsigned int    flags;           /* SEC_* flags */
     client_ptr_t    base;            /* view base address (in process addr space) */
     mem_size_t      size;            /* view size */
@@ -217,6 +259,23 @@ static void shared_map_destroy( struct object *obj )
     list_remove( &shared->entry );
 }
 
+static void image_reloc_dump( struct object *obj, int verbose )
+{
+    struct image_reloc *reloc = (struct image_reloc *)obj;
+    fprintf( stderr, "Image relocation fd=%p file=%p base=%08x%08x ready=%d\n",
+             reloc->fd, reloc->file, (unsigned int)(reloc->base >> 32), (unsigned int)reloc->base,
+             reloc->ready );
+}
+
+static void image_reloc_destroy( struct object *obj )
+{
+    struct image_reloc *reloc = (struct image_reloc *)obj;
+
+    release_object( reloc->fd );
+    release_object( reloc->file );
+    list_remove( &reloc->entry );
+}
+
 /* extend a file beyond the current end of file */
 static int grow_file( int unix_fd, file_pos_t new_size )
 {
@@ -258,13 +317,56 @@ static int check_current_dir_for_exec(void)
     return (ret != MAP_FAILED);
 }
 
+/* create an anonymous memory file, which doesn't need a directory entry or disk space */
+static int create_memfd(void)
+{
+#ifdef __NR_memfd_create
+    static int memfd_works = -1;
+    void *ret = MAP_FAILED;
+    int fd;
+
+    if (!memfd_works) return -1;
+    fd = syscall( __NR_memfd_create, "wine-anonmap", 1 /* MFD_CLOEXEC */ );
+    if (fd == -1)
+    {
+        memfd_works = 0;
+        return -1;
+    }
+    if (memfd_works == -1)
+    {
+        /* the memory files may be sealed against exec mappings */
+        if (grow_file( fd, 1 ))
+        {
+            ret = mmap( NULL, get_page_size(), PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0 );
+            if (ret != MAP_FAILED) munmap( ret, get_page_size() );
+        }
+        if (!(memfd_works = (ret != MAP_FAILED)))
+        {
+            clear_error();
+            close( fd );
+            return -1;
+        }
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
 /* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+int create_temp_file( file_pos_t size )
 {
     static int temp_dir_fd = -1;
     char tmpfn[] = "anonmap.XXXXXX";
     int fd;
 
+    if ((fd = create_memfd()) != -1)
+    {
+        if (grow_file( fd, size )) return fd;
+        close( fd );
+        return -1;
+    }
+
     if (temp_dir_fd == -1)
     {
         temp_dir_fd = server_dir_fd;
@@ -313,6 +415,7 @@ static void free_memory_view( struct memory_view *view )
     if (view->fd) release_object( view->fd );
     if (view->committed) release_object( view->committed );
     if (view->shared) release_object( view->shared );
+    if (view->reloc) release_object( view->reloc );
     list_remove( &view->entry );
     free( view );
 }
@@ -337,6 +440,17 @@ static struct shared_map *get_shared_file( struct fd *fd )
     return NULL;
 }
 
+/* find the relocated pages of a PE file at a given address */
+static struct image_reloc *get_image_reloc( struct fd *fd, client_ptr_t base )
+{
+    struct image_reloc *ptr;
+
+    LIST_FOR_EACH_ENTRY( ptr, &image_reloc_list, struct image_reloc, entry )
+        if (ptr->base == base && is_same_file_fd( ptr->fd, fd ))
+            return ptr;
+    return NULL;
+}
+
 /* return the size of the memory mapping and file range of a given section */
 static inline void get_section_sizes( const IMAGE_SECTION_HEADER *sec, size_t *map_size,
                                       off_t *file_start, size_t *file_size )
@@ -1020,6 +1134,12 @@ DECL_HANDLER(map_view)
         view->fd        = !is_fd_removable( mapping->fd ) ? (struct fd *)grab_object( mapping->fd ) : NULL;
         view->committed = mapping->committed ? (struct ranges *)grab_object( mapping->committed ) : NULL;
         view->shared    = mapping->shared ? (struct shared_map *)grab_object( mapping->shared ) : NULL;
+        view->reloc     = NULL;
+        if ((mapping->flags & SEC_IMAGE) && view->fd)
+        {
+            struct image_reloc *reloc = get_image_reloc( view->fd, view->base );
+            if (reloc && reloc->ready) view->reloc = (struct image_reloc *)grab_object( reloc );
+        }
         list_add_tail( &current->process->views, &view->entry );
     }
 
@@ -1063,3 +1183,67 @@ DECL_HANDLER(is_same_mapping)
         !is_same_file_fd( view1->fd, view2->fd ))
         set_error( STATUS_NOT_SAME_DEVICE );
 }
+
+/* get the relocated pages of an image that is being mapped at a given address */
+DECL_HANDLER(get_image_relocation)
+{
+    struct mapping *mapping;
+    struct image_reloc *reloc;
+
+    if (!(mapping = get_mapping_obj( current->process, req->mapping, SECTION_MAP_READ ))) return;
+
+    if (!(mapping->flags & SEC_IMAGE) || is_fd_removable( mapping->fd ))
+        set_error( STATUS_INVALID_PARAMETER );
+    else if ((reloc = get_image_reloc( mapping->fd, req->base )) && reloc->ready)
+        reply->file = alloc_handle( current->process, reloc->file, GENERIC_READ, 0 );
+    else
+        set_error( STATUS_OBJECT_NAME_NOT_FOUND );
+    release_object( mapping );
+}
+
+/* create the file holding the relocated pages of an image view */
+DECL_HANDLER(create_image_relocation)
+{
+    struct memory_view *view = find_mapped_view( current->process, req->base );
+    struct image_reloc *reloc;
+    struct file *file;
+    int unix_fd;
+
+    if (!view) return;
+    if (!(view->flags & SEC_IMAGE) || !view->fd || view->reloc)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        return;
+    }
+    if (get_image_reloc( view->fd, view->base ))
+    {
+        set_error( STATUS_OBJECT_NAME_EXISTS );
+        return;
+    }
+
+    if ((unix_fd = create_temp_file( view->size )) == -1) return;
+    if (!(file = create_file_for_fd( unix_fd, FILE_GENERIC_READ|FILE_GENERIC_WRITE, 0 ))) return;
+    if (!(reloc = alloc_object( &image_reloc_ops )))
+    {
+        release_object( file );
+        return;
+    }
+    reloc->fd    = (struct fd *)grab_object( view->fd );
+    reloc->file  = file;
+    reloc->base  = view->base;
+    reloc->ready = 0;
+    list_add_head( &image_reloc_list, &reloc->entry );
+    view->reloc = reloc;
+
+    reply->file = alloc_handle( current->process, file, GENERIC_READ|GENERIC_WRITE, 0 );
+}
+
+/* make the relocated pages of an image view available to other processes */
+DECL_HANDLER(commit_image_relocation)
+{
+    struct memory_view *view = find_mapped_view( current->process, req->base );
+
+    if (!view) return;
+    if (!view->reloc || view->reloc->ready) set_error( STATUS_INVALID_PARAMETER );
+    else view->reloc->ready = 1;
+}
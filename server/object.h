@@ -190,6 +190,11 @@ extern void reset_event( struct event *event );
 
 extern void abandon_mutexes( struct thread *thread );
 
+/* wait set functions */
+
+extern struct object **get_wait_set_objects( struct process *process, obj_handle_t handle, unsigned int *count );
+extern void wait_set_satisfied( struct wait_queue_entry *entries, unsigned int count );
+
 /* serial functions */
 
 int get_serial_async_timeout(struct object *obj, int type, int count);
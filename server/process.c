@@ -533,6 +533,8 @@ struct thread *create_process( int fd, struct thread *parent_thread, int inherit
     process->trace_data      = 0;
     process->rawinput_mouse  = NULL;
     process->rawinput_kbd    = NULL;
+    process->req_count       = 0;
+    process->req_time        = 0;
     list_init( &process->thread_list );
     list_init( &process->locks );
     list_init( &process->asyncs );
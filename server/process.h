@@ -95,6 +95,8 @@ struct process
     struct list          rawinput_devices;/* list of registered rawinput devices */
     const struct rawinput_device *rawinput_mouse; /* rawinput mouse device, if any */
     const struct rawinput_device *rawinput_kbd;   /* rawinput keyboard device, if any */
+    unsigned int         req_count;       /* number of requests, for the server statistics */
+    timeout_t            req_time;        /* time spent handling its requests */
 };
 
 struct process_snapshot
@@ -28,6 +28,10 @@
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -140,6 +144,8 @@ struct msg_queue
     struct thread_input   *input;           /* thread input descriptor */
     struct hook_table     *hooks;           /* hook table */
     timeout_t              last_get_msg;    /* time of last get message call */
+    struct file           *shared_file;     /* file holding the status shared with the client */
+    struct queue_shared_memory *shared;     /* status shared with the client, if mapped */
 };
 
 struct hotkey
@@ -298,6 +304,8 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->input           = (struct thread_input *)grab_object( input );
         queue->hooks           = NULL;
         queue->last_get_msg    = current_time;
+        queue->shared_file     = NULL;
+        queue->shared          = NULL;
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
@@ -435,11 +443,21 @@ static inline int is_signaled( struct msg_queue *queue )
     return ((queue->wake_bits & queue->wake_mask) || (queue->changed_bits & queue->changed_mask));
 }
 
+/* mirror the queue bits into the memory shared with the client */
+static inline void update_shared_bits( struct msg_queue *queue )
+{
+    if (!queue->shared) return;
+    queue->shared->wake_bits    = queue->wake_bits;
+    queue->shared->changed_bits = queue->changed_bits;
+    if (queue->quit_message) queue->shared->wake_bits |= QS_POSTMESSAGE | QS_ALLPOSTMESSAGE;
+}
+
 /* set some queue bits */
 static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
 {
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    update_shared_bits( queue );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -448,6 +466,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
 {
     queue->wake_bits &= ~bits;
     queue->changed_bits &= ~bits;
+    update_shared_bits( queue );
 }
 
 /* check whether msg is a keyboard message */
@@ -995,6 +1014,8 @@ static void msg_queue_destroy( struct object *obj )
     release_object( queue->input );
     if (queue->hooks) release_object( queue->hooks );
     if (queue->fd) release_object( queue->fd );
+    if (queue->shared) munmap( queue->shared, sizeof(*queue->shared) );
+    if (queue->shared_file) release_object( queue->shared_file );
 }
 
 static void msg_queue_poll_event( struct fd *fd, int event )
@@ -2071,6 +2092,7 @@ void queue_cleanup_window( struct thread *thread, user_handle_t win )
                 {
                     queue->quit_message = 1;
                     queue->exit_code = msg->wparam;
+                    update_shared_bits( queue );
                 }
                 remove_queue_message( queue, msg, i );
             }
@@ -2222,6 +2244,36 @@ DECL_HANDLER(get_msg_queue)
 }
 
 
+/* get the memory holding the status of the current thread queue */
+DECL_HANDLER(get_queue_shared_memory)
+{
+    struct msg_queue *queue = get_current_queue();
+    void *ptr;
+    int unix_fd;
+
+    if (!queue) return;
+    if (!queue->shared_file)
+    {
+        if ((unix_fd = create_temp_file( sizeof(*queue->shared) )) == -1) return;
+        if ((ptr = mmap( NULL, sizeof(*queue->shared), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, unix_fd, 0 )) == MAP_FAILED)
+        {
+            file_set_error();
+            close( unix_fd );
+            return;
+        }
+        if (!(queue->shared_file = create_file_for_fd( unix_fd, FILE_GENERIC_READ, 0 )))
+        {
+            munmap( ptr, sizeof(*queue->shared) );
+            return;
+        }
+        queue->shared = ptr;
+        update_shared_bits( queue );
+    }
+    reply->file = alloc_handle( current->process, queue->shared_file, GENERIC_READ, 0 );
+}
+
+
 /* set the file descriptor associated to the current thread queue */
 DECL_HANDLER(set_queue_fd)
 {
@@ -2277,6 +2329,7 @@ DECL_HANDLER(get_queue_status)
         reply->wake_bits    = queue->wake_bits;
         reply->changed_bits = queue->changed_bits;
         queue->changed_bits &= ~req->clear_bits;
+        update_shared_bits( queue );
     }
     else reply->wake_bits = reply->changed_bits = 0;
 }
@@ -2452,6 +2505,7 @@ DECL_HANDLER(get_message)
     }
     if (filter & QS_INPUT) queue->changed_bits &= ~QS_INPUT;
     if (filter & QS_PAINT) queue->changed_bits &= ~QS_PAINT;
+    update_shared_bits( queue );
 
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
@@ -30,11 +30,18 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <signal.h>
 #include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 #include <unistd.h>
 
 #include "ntstatus.h"
@@ -71,7 +78,9 @@ struct key
     struct key       *parent;      /* parent key */
     int               last_subkey; /* last in use subkey */
     int               nb_subkeys;  /* count of allocated subkeys */
-    struct key      **subkeys;     /* subkeys array */
+    struct key      **subkeys;     /* subkeys array, sorted by name */
+    struct key      **subkey_hash; /* hash index of the subkeys for keys with many children */
+    unsigned int      hash_size;   /* size of the hash index (power of 2) */
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
@@ -100,6 +109,7 @@ struct key_value
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
+#define SUBKEY_HASH_THRESHOLD 128  /* number of subkeys above which a hash index is used */
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
@@ -117,6 +127,10 @@ static const WCHAR wow6432node[] = {'W','o','w','6','4','3','2','N','o','d','e'}
 static const WCHAR symlink_value[] = {'S','y','m','b','o','l','i','c','L','i','n','k','V','a','l','u','e'};
 static const struct unicode_str symlink_str = { symlink_value, sizeof(symlink_value) };
 
+/* generation counters shared with the clients, bumped when the values of a key change */
+static unsigned int *key_generations;
+static struct file *key_generations_file;
+
 static void set_periodic_save_timer(void);
 static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index );
 
@@ -131,17 +145,30 @@ struct save_branch_info
 static int save_branch_count;
 static struct save_branch_info save_branch_info[MAX_SAVE_BRANCH_INFO];
 
+/* periodic saves are done by a child process working on a snapshot of the registry */
+static int save_child_pipe = -1;   /* pipe receiving the result of the save child */
+static unsigned int save_child_branches;  /* mask of the branches it is saving */
+
+
+#define MAX_LOAD_DEPTH 32  /* max. depth of the cached key path while loading */
 
 /* information about a file being loaded */
 struct file_load_info
 {
     const char *filename; /* input file name */
-    FILE       *file;     /* input file */
-    char       *buffer;   /* line buffer */
-    int         len;      /* buffer length */
+    char       *data;     /* file contents, parsed in place */
+    size_t      size;     /* size of the file contents */
+    int         mapped;   /* whether the contents are a file mapping */
+    char       *pos;      /* start of the next line */
+    char       *buffer;   /* current line */
     int         line;     /* current input line */
     WCHAR      *tmp;      /* temp buffer to use while parsing input */
     size_t      tmplen;   /* length of temp buffer */
+    WCHAR      *last_name;     /* name of the last loaded key */
+    data_size_t last_len;      /* length of the name in chars */
+    data_size_t last_size;     /* size of the name buffer in chars */
+    int         path_depth;    /* number of valid entries in path */
+    struct key *path[MAX_LOAD_DEPTH + 1];  /* keys along the last loaded path, path[0] is the base */
 };
 
 
@@ -424,6 +451,7 @@ static void key_destroy( struct object *obj )
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_hash );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -487,6 +515,8 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->last_subkey = -1;
         key->nb_subkeys  = 0;
         key->subkeys     = NULL;
+        key->subkey_hash = NULL;
+        key->hash_size   = 0;
         key->nb_values   = 0;
         key->last_value  = -1;
         key->values      = NULL;
@@ -537,11 +567,32 @@ static void check_notify( struct key *key, unsigned int change, int not_subtree
     }
 }
 
+/* slot of a key in the generation area */
+static inline unsigned int get_key_gen_slot( const struct key *key )
+{
+    return ((unsigned long)key / sizeof(*key)) % REGISTRY_GENERATION_SLOTS;
+}
+
+/* invalidate the values of a key cached by the clients */
+static inline void bump_key_generation( const struct key *key )
+{
+    if (key_generations) key_generations[get_key_gen_slot( key )]++;
+}
+
+/* invalidate all the values cached by the clients */
+static void bump_all_key_generations(void)
+{
+    unsigned int i;
+
+    if (key_generations) for (i = 0; i < REGISTRY_GENERATION_SLOTS; i++) key_generations[i]++;
+}
+
 /* update key modification time */
 static void touch_key( struct key *key, unsigned int change )
 {
     struct key *k;
 
+    bump_key_generation( key );
     key->modif = current_time;
     make_dirty( key );
 
@@ -551,6 +602,62 @@ static void touch_key( struct key *key, unsigned int change )
         check_notify( k, change & ~REG_NOTIFY_CHANGE_LAST_SET, 0 );
 }
 
+/* case-insensitive hash of a key name */
+static unsigned int hash_key_name( const WCHAR *name, data_size_t len )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < len / sizeof(WCHAR); i++) hash = hash * 31 + toupperW( name[i] );
+    return hash ^ (hash >> 15);
+}
+
+/* add a subkey to the hash index of its parent, which must have free entries */
+static void insert_subkey_hash( struct key *key, struct key *subkey )
+{
+    unsigned int mask = key->hash_size - 1;
+    unsigned int i = hash_key_name( subkey->name, subkey->namelen ) & mask;
+
+    while (key->subkey_hash[i]) i = (i + 1) & mask;
+    key->subkey_hash[i] = subkey;
+}
+
+/* (re)build the hash index of the subkeys; on failure the key simply keeps using the sorted array */
+static void build_subkey_hash( struct key *key )
+{
+    unsigned int size = 256;
+    int i;
+
+    while (size < 2 * (unsigned int)(key->last_subkey + 1)) size *= 2;
+    free( key->subkey_hash );
+    key->hash_size = 0;
+    if (!(key->subkey_hash = calloc( size, sizeof(*key->subkey_hash) ))) return;
+    key->hash_size = size;
+    for (i = 0; i <= key->last_subkey; i++) insert_subkey_hash( key, key->subkeys[i] );
+}
+
+/* remove a subkey from the hash index of its parent */
+static void remove_subkey_hash( struct key *key, struct key *subkey )
+{
+    unsigned int mask = key->hash_size - 1;
+    unsigned int i, j, k;
+
+    i = hash_key_name( subkey->name, subkey->namelen ) & mask;
+    while (key->subkey_hash[i] != subkey)
+    {
+        assert( key->subkey_hash[i] );
+        i = (i + 1) & mask;
+    }
+    /* move back the following entries of the probe sequence to fill the hole */
+    for (j = (i + 1) & mask; key->subkey_hash[j]; j = (j + 1) & mask)
+    {
+        k = hash_key_name( key->subkey_hash[j]->name, key->subkey_hash[j]->namelen ) & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+        key->subkey_hash[i] = key->subkey_hash[j];
+        i = j;
+    }
+    key->subkey_hash[i] = NULL;
+}
+
 /* try to grow the array of subkeys; return 1 if OK, 0 on error */
 static int grow_subkeys( struct key *key )
 {
@@ -581,7 +688,6 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
                                  int index, timeout_t modif )
 {
     struct key *key;
-    int i;
 
     if (name->len > MAX_NAME_LEN * sizeof(WCHAR))
     {
@@ -596,9 +702,13 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
     if ((key = alloc_key( name, modif )) != NULL)
     {
         key->parent = parent;
-        for (i = ++parent->last_subkey; i > index; i--)
-            parent->subkeys[i] = parent->subkeys[i-1];
+        memmove( parent->subkeys + index + 1, parent->subkeys + index,
+                 (++parent->last_subkey - index) * sizeof(*parent->subkeys) );
         parent->subkeys[index] = key;
+        if (parent->subkey_hash && 2 * (unsigned int)(parent->last_subkey + 1) <= parent->hash_size)
+            insert_subkey_hash( parent, key );
+        else if (parent->last_subkey + 1 >= SUBKEY_HASH_THRESHOLD)
+            build_subkey_hash( parent );
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
     }
@@ -609,16 +719,28 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
 static void free_subkey( struct key *parent, int index )
 {
     struct key *key;
-    int i, nb_subkeys;
+    int nb_subkeys;
 
     assert( index >= 0 );
     assert( index <= parent->last_subkey );
 
     key = parent->subkeys[index];
-    for (i = index; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
+    memmove( parent->subkeys + index, parent->subkeys + index + 1,
+             (parent->last_subkey - index) * sizeof(*parent->subkeys) );
     parent->last_subkey--;
+    if (parent->subkey_hash)
+    {
+        if (parent->last_subkey + 1 >= SUBKEY_HASH_THRESHOLD / 2) remove_subkey_hash( parent, key );
+        else
+        {
+            free( parent->subkey_hash );
+            parent->subkey_hash = NULL;
+            parent->hash_size = 0;
+        }
+    }
     key->flags |= KEY_DELETED;
     key->parent = NULL;
+    bump_key_generation( key );
     if (is_wow6432node( key->name, key->namelen )) parent->flags &= ~KEY_WOW64;
     release_object( key );
 
@@ -636,11 +758,30 @@ static void free_subkey( struct key *parent, int index )
 }
 
 /* find the named child of a given key and return its index */
+/* if the child is found through the hash index, the returned index is -1 */
 static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index )
 {
     int i, min, max, res;
     data_size_t len;
 
+    if (key->subkey_hash)
+    {
+        unsigned int mask = key->hash_size - 1;
+        struct key *subkey;
+
+        for (i = hash_key_name( name->str, name->len ) & mask; (subkey = key->subkey_hash[i]);
+             i = (i + 1) & mask)
+        {
+            if (subkey->namelen == name->len &&
+                !memicmpW( subkey->name, name->str, name->len / sizeof(WCHAR) ))
+            {
+                *index = -1;
+                return subkey;
+            }
+        }
+        /* not found, we still need the insertion index */
+    }
+
     min = 0;
     max = key->last_subkey;
     while (min <= max)
@@ -661,6 +802,26 @@ static struct key *find_subkey( const struct key *key, const struct unicode_str
     return NULL;
 }
 
+/* return the index of a child key in the sorted array of its parent */
+static int get_subkey_index( const struct key *parent, const struct key *key )
+{
+    int i, min = 0, max = parent->last_subkey, res;
+    data_size_t len;
+
+    while (min <= max)
+    {
+        i = (min + max) / 2;
+        if (parent->subkeys[i] == key) return i;
+        len = min( parent->subkeys[i]->namelen, key->namelen );
+        res = memicmpW( parent->subkeys[i]->name, key->name, len / sizeof(WCHAR) );
+        if (!res) res = parent->subkeys[i]->namelen - key->namelen;
+        if (res > 0) max = i - 1;
+        else min = i + 1;
+    }
+    assert( 0 );
+    return -1;
+}
+
 /* return the wow64 variant of the key, or the key itself if none */
 static struct key *find_wow64_subkey( struct key *key, const struct unicode_str *name )
 {
@@ -1000,9 +1161,7 @@ static int delete_key( struct key *key, int recurse )
         if (0 > delete_key(key->subkeys[key->last_subkey], 1))
             return -1;
 
-    for (index = 0; index <= parent->last_subkey; index++)
-        if (parent->subkeys[index] == key) break;
-    assert( index <= parent->last_subkey );
+    index = get_subkey_index( parent, key );
 
     /* we can only delete a key that has no subkeys */
     if (key->last_subkey >= 0)
@@ -1265,37 +1424,73 @@ static inline struct key *get_parent_hkey_obj( obj_handle_t hkey )
     return get_hkey_obj( hkey, 0 );
 }
 
-/* read a line from the input file */
-static int read_next_line( struct file_load_info *info )
+/* map or read the whole input file, so that lines can be parsed in place */
+static int load_file_data( struct file_load_info *info, int fd )
 {
-    char *newbuf;
-    int newlen, pos = 0;
+    struct stat st;
+    char *data, *new_data;
+    size_t size = 0, alloc = 65536;
+    ssize_t ret;
 
-    info->line++;
-    for (;;)
+    info->data   = NULL;
+    info->size   = 0;
+    info->mapped = 0;
+
+    if (!fstat( fd, &st ) && S_ISREG( st.st_mode ) && st.st_size > 0 && st.st_size == (size_t)st.st_size)
     {
-        if (!fgets( info->buffer + pos, info->len - pos, info->file ))
-            return (pos != 0);  /* EOF */
-        pos = strlen(info->buffer);
-        if (info->buffer[pos-1] == '\n')
+        /* a private writable mapping allows to terminate the lines in place; this requires
+         * the file to end with a newline, which is always the case for the files we write */
+        data = mmap( NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+        if (data != MAP_FAILED)
         {
-            /* got a full line */
-            info->buffer[--pos] = 0;
-            if (pos > 0 && info->buffer[pos-1] == '\r') info->buffer[pos-1] = 0;
-            return 1;
+            if (data[st.st_size - 1] == '\n')
+            {
+                info->data   = data;
+                info->size   = st.st_size;
+                info->mapped = 1;
+                return 1;
+            }
+            munmap( data, st.st_size );
         }
-        if (pos < info->len - 1) return 1;  /* EOF but something was read */
+        alloc = st.st_size + 1;
+    }
 
-        /* need to enlarge the buffer */
-        newlen = info->len + info->len / 2;
-        if (!(newbuf = realloc( info->buffer, newlen )))
+    if (!(data = mem_alloc( alloc ))) return 0;
+    for (;;)
+    {
+        if (size + 1 >= alloc)
         {
-            set_error( STATUS_NO_MEMORY );
-            return -1;
+            alloc += alloc / 2;
+            if (!(new_data = realloc( data, alloc ))) break;
+            data = new_data;
         }
-        info->buffer = newbuf;
-        info->len = newlen;
+        if ((ret = read( fd, data + size, alloc - size - 1 )) > 0) size += ret;
+        else if (!ret || errno != EINTR) break;
+    }
+    if (size + 1 >= alloc)
+    {
+        free( data );
+        set_error( STATUS_NO_MEMORY );
+        return 0;
     }
+    info->data = data;
+    info->size = size;
+    return 1;
+}
+
+/* read a line from the input file */
+static int read_next_line( struct file_load_info *info )
+{
+    char *end, *eof = info->data + info->size;
+
+    if (info->pos >= eof) return 0;
+    info->line++;
+    info->buffer = info->pos;
+    if ((end = memchr( info->pos, '\n', eof - info->pos ))) info->pos = end + 1;
+    else info->pos = end = eof;  /* there is always room for the null terminator */
+    *end = 0;
+    if (end > info->buffer && end[-1] == '\r') end[-1] = 0;
+    return 1;
 }
 
 /* make sure the temp buffer holds enough space */
@@ -1355,6 +1550,62 @@ static int get_data_type( const char *buffer, int *type, int *parse_type )
     return 0;
 }
 
+/* create a key while loading a file; since the keys are written in tree order, the lookup
+ * starts from the deepest key that the name has in common with the previously loaded one */
+static struct key *load_key_path( struct file_load_info *info, const struct unicode_str *name )
+{
+    const WCHAR *str = name->str;
+    data_size_t i, pos = 0, count = name->len / sizeof(WCHAR);
+    struct unicode_str rest;
+    struct key *key, *parent;
+    int depth = 0, new_depth;
+
+    for (i = 0; i < count && i < info->last_len && str[i] == info->last_name[i]; i++)
+        if (str[i] == '\\')
+        {
+            depth++;
+            pos = i + 1;
+        }
+    if (i > pos && (i == count || str[i] == '\\') &&
+        (i == info->last_len || info->last_name[i] == '\\'))
+    {
+        depth++;
+        pos = min( i + 1, count );
+    }
+    if (depth > info->path_depth)
+    {
+        /* restart from the deepest cached key */
+        for (depth = 0, pos = 0, i = 0; i < count && depth < info->path_depth; i++)
+            if (str[i] == '\\')
+            {
+                depth++;
+                pos = i + 1;
+            }
+    }
+
+    rest.str = str + pos;
+    rest.len = (count - pos) * sizeof(WCHAR);
+    if (!rest.len) key = (struct key *)grab_object( info->path[depth] );
+    else if (!(key = create_key_recursive( info->path[depth], &rest, 0 ))) return NULL;
+
+    /* remember the path of the new key, unless a symlink was followed on the way */
+    for (i = 0, new_depth = depth + 1; i < count - pos; i++) if (rest.str[i] == '\\') new_depth++;
+    if (!rest.len) new_depth = depth;
+    for (parent = key, i = new_depth; parent && i > depth; i--, parent = parent->parent)
+        if (i <= MAX_LOAD_DEPTH) info->path[i] = parent;
+    info->path_depth = (parent == info->path[depth]) ? min( new_depth, MAX_LOAD_DEPTH ) : depth;
+
+    if (info->last_size < count)
+    {
+        free( info->last_name );
+        info->last_size = max( count, 256 );
+        if (!(info->last_name = malloc( info->last_size * sizeof(WCHAR) ))) info->last_size = 0;
+    }
+    info->last_len = min( count, info->last_size );
+    memcpy( info->last_name, str, info->last_len * sizeof(WCHAR) );
+    return key;
+}
+
 /* load and create a key from the input file */
 static struct key *load_key( struct key *base, const char *buffer, int prefix_len,
                              struct file_load_info *info, timeout_t *modif )
@@ -1393,7 +1644,7 @@ static struct key *load_key( struct key *base, const char *buffer, int prefix_le
     }
     name.str = p;
     name.len = len - (p - info->tmp + 1) * sizeof(WCHAR);
-    return create_key_recursive( base, &name, 0 );
+    return load_key_path( info, &name );
 }
 
 /* update the modification time of a key (and its parents) after it has been loaded from a file */
@@ -1623,24 +1874,24 @@ static int get_prefix_len( struct key *key, const char *name, struct file_load_i
 
 /* load all the keys from the input file */
 /* prefix_len is the number of key name prefixes to skip, or -1 for autodetection */
-static void load_keys( struct key *key, const char *filename, FILE *f, int prefix_len )
+static void load_keys( struct key *key, const char *filename, int fd, int prefix_len )
 {
-    struct key *subkey = NULL;
+    struct key *subkey = NULL, *new_key;
     struct file_load_info info;
     timeout_t modif = current_time;
     char *p;
 
-    info.filename = filename;
-    info.file   = f;
-    info.len    = 4;
-    info.tmplen = 4;
-    info.line   = 0;
-    if (!(info.buffer = mem_alloc( info.len ))) return;
-    if (!(info.tmp = mem_alloc( info.tmplen )))
-    {
-        free( info.buffer );
-        return;
-    }
+    info.filename   = filename;
+    info.tmplen     = 256;
+    info.line       = 0;
+    info.last_name  = NULL;
+    info.last_len   = 0;
+    info.last_size  = 0;
+    info.path_depth = 0;
+    info.path[0]    = key;
+    if (!load_file_data( &info, fd )) return;
+    info.pos = info.data;
+    if (!(info.tmp = mem_alloc( info.tmplen ))) goto done;
 
     if ((read_next_line( &info ) != 1) ||
         strcmp( info.buffer, "WINE REGISTRY Version 2" ))
@@ -1656,14 +1907,16 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
         switch(*p)
         {
         case '[':   /* new key */
+            if (prefix_len == -1) prefix_len = get_prefix_len( key, p + 1, &info );
+            /* keep the previous key alive while the new one is looked up from its path */
+            if (!(new_key = load_key( key, p + 1, prefix_len, &info, &modif )))
+                file_read_error( "Error creating key", &info );
             if (subkey)
             {
                 update_key_time( subkey, modif );
                 release_object( subkey );
             }
-            if (prefix_len == -1) prefix_len = get_prefix_len( key, p + 1, &info );
-            if (!(subkey = load_key( key, p + 1, prefix_len, &info, &modif )))
-                file_read_error( "Error creating key", &info );
+            subkey = new_key;
             break;
         case '@':   /* default value */
         case '\"':  /* value */
@@ -1689,8 +1942,10 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
         update_key_time( subkey, modif );
         release_object( subkey );
     }
-    free( info.buffer );
+    if (info.mapped) munmap( info.data, info.size );
+    else free( info.data );
     free( info.tmp );
+    free( info.last_name );
 }
 
 /* load a part of the registry from a file */
@@ -1700,29 +1955,20 @@ static void load_registry( struct key *key, obj_handle_t handle )
     int fd;
 
     if (!(file = get_file_obj( current->process, handle, FILE_READ_DATA ))) return;
-    fd = dup( get_file_unix_fd( file ) );
+    fd = get_file_unix_fd( file );
+    if (fd != -1) load_keys( key, NULL, fd, -1 );
     release_object( file );
-    if (fd != -1)
-    {
-        FILE *f = fdopen( fd, "r" );
-        if (f)
-        {
-            load_keys( key, NULL, f, -1 );
-            fclose( f );
-        }
-        else file_set_error();
-    }
 }
 
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
-    FILE *f;
+    int fd;
 
-    if ((f = fopen( filename, "r" )))
+    if ((fd = open( filename, O_RDONLY )) != -1)
     {
-        load_keys( key, filename, f, 0 );
-        fclose( f );
+        load_keys( key, filename, fd, 0 );
+        close( fd );
         if (get_error() == STATUS_NOT_REGISTRY_FILE)
         {
             fprintf( stderr, "%s is not a valid registry file\n", filename );
@@ -1735,7 +1981,7 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
     save_branch_info[save_branch_count].path = filename;
     save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
     make_object_static( &key->obj );
-    return (f != NULL);
+    return (fd != -1);
 }
 
 static WCHAR *format_user_registry_path( const SID *sid, struct unicode_str *path )
@@ -1990,16 +2236,92 @@ done:
     return ret;
 }
 
+/* check the result of the save child; return 0 if it's still running */
+static int finish_save_child( int wait )
+{
+    char result = 0;
+    int i, ret;
+
+    if (save_child_pipe == -1) return 1;
+    if (!wait)
+    {
+        struct pollfd pfd;
+
+        pfd.fd = save_child_pipe;
+        pfd.events = POLLIN;
+        if (poll( &pfd, 1, 0 ) != 1) return 0;
+    }
+    while ((ret = read( save_child_pipe, &result, 1 )) == -1 && errno == EINTR);
+    close( save_child_pipe );
+    save_child_pipe = -1;
+
+    if (ret != 1 || !result)
+    {
+        /* the save failed, mark the branches dirty again so that they get saved next time */
+        fprintf( stderr, "wineserver: could not save the registry in the background\n" );
+        for (i = 0; i < save_branch_count; i++)
+            if (save_child_branches & (1 << i)) save_branch_info[i].key->flags |= KEY_DIRTY;
+    }
+    save_child_branches = 0;
+    return 1;
+}
+
+/* save the dirty branches from a child process, so that the server doesn't block on the writes */
+static int start_save_child(void)
+{
+    static const int signals[] = { SIGCHLD, SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGUSR1, SIGIO };
+    unsigned int branches = 0;
+    char result = 1;
+    int i, fd[2];
+    pid_t pid;
+
+    for (i = 0; i < save_branch_count; i++)
+        if (save_branch_info[i].key->flags & KEY_DIRTY) branches |= 1 << i;
+    if (!branches) return 1;
+
+    if (pipe( fd ) == -1) return 0;
+    if ((pid = fork()) == -1)
+    {
+        close( fd[0] );
+        close( fd[1] );
+        return 0;
+    }
+    if (!pid)
+    {
+        /* the signal handlers would wake up the server */
+        for (i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) signal( signals[i], SIG_DFL );
+        close( fd[0] );
+        if (fchdir( config_dir_fd ) == -1) result = 0;
+        for (i = 0; result && i < save_branch_count; i++)
+            if (branches & (1 << i)) result = save_branch( save_branch_info[i].key, save_branch_info[i].path );
+        write( fd[1], &result, 1 );
+        _exit( !result );
+    }
+
+    /* the child saves the current state, later changes will make the keys dirty again */
+    close( fd[1] );
+    fcntl( fd[0], F_SETFD, FD_CLOEXEC );
+    save_child_pipe = fd[0];
+    save_child_branches = branches;
+    for (i = 0; i < save_branch_count; i++)
+        if (branches & (1 << i)) make_clean( save_branch_info[i].key );
+    return 1;
+}
+
 /* periodic saving of the registry */
 static void periodic_save( void *arg )
 {
     int i;
 
-    if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
-    for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
-    if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+    if (finish_save_child( 0 ) && !start_save_child())
+    {
+        /* fall back to saving directly */
+        if (fchdir( config_dir_fd ) == -1) return;
+        for (i = 0; i < save_branch_count; i++)
+            save_branch( save_branch_info[i].key, save_branch_info[i].path );
+        if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
+    }
     set_periodic_save_timer();
 }
 
@@ -2015,6 +2337,7 @@ void flush_registry(void)
 {
     int i;
 
+    finish_save_child( 1 );
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
@@ -2163,11 +2486,40 @@ DECL_HANDLER(get_key_value)
     reply->total = 0;
     if ((key = get_hkey_obj( req->hkey, KEY_QUERY_VALUE )))
     {
+        reply->gen_slot = get_key_gen_slot( key );
+        if (key_generations) reply->generation = key_generations[reply->gen_slot];
         get_value( key, &name, &reply->type, &reply->total );
         release_object( key );
     }
 }
 
+/* get the shared area of the registry key generation counters */
+DECL_HANDLER(get_registry_generations)
+{
+    size_t size = REGISTRY_GENERATION_SLOTS * sizeof(*key_generations);
+    void *ptr;
+    int unix_fd;
+
+    if (!key_generations_file)
+    {
+        if ((unix_fd = create_temp_file( size )) == -1) return;
+        if ((ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, unix_fd, 0 )) == MAP_FAILED)
+        {
+            file_set_error();
+            close( unix_fd );
+            return;
+        }
+        if (!(key_generations_file = create_file_for_fd( unix_fd, FILE_GENERIC_READ, 0 )))
+        {
+            munmap( ptr, size );
+            return;
+        }
+        make_object_static( (struct object *)key_generations_file );
+        key_generations = ptr;
+    }
+    reply->file = alloc_handle( current->process, key_generations_file, GENERIC_READ, 0 );
+}
+
 /* enumerate the value of a registry key */
 DECL_HANDLER(enum_key_value)
 {
@@ -2222,6 +2574,7 @@ DECL_HANDLER(load_registry)
         if ((key = create_key( parent, &name, NULL, 0, KEY_WOW64_64KEY, 0, sd, &dummy )))
         {
             load_registry( key, req->file );
+            bump_all_key_generations();
             release_object( key );
         }
         release_object( parent );
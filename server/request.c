@@ -41,6 +41,12 @@
 #ifdef HAVE_SYS_WAIT_H
 # include <sys/wait.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#ifdef HAVE_SYS_SYSCALL_H
+# include <sys/syscall.h>
+#endif
 #ifdef HAVE_SYS_UIO_H
 #include <sys/uio.h>
 #endif
@@ -62,11 +68,13 @@
 #include "wincon.h"
 #include "winternl.h"
 #include "wine/library.h"
+#include "wine/servercapture.h"
 
 #include "file.h"
 #include "process.h"
 #include "thread.h"
 #include "security.h"
+#include "unicode.h"
 #define WANT_REQUEST_HANDLERS
 #include "request.h"
 
@@ -132,6 +140,26 @@ int config_dir_fd = -1;    /* file descriptor for the config dir */
 static struct master_socket *master_socket;  /* the master socket object */
 static struct timeout_user *master_timeout;
 
+static void doorbell_poll_event( struct fd *fd, int event );
+
+static const struct fd_ops doorbell_fd_ops =
+{
+    NULL,                          /* get_poll_events */
+    doorbell_poll_event,           /* poll_event */
+    NULL,                          /* flush */
+    NULL,                          /* get_fd_type */
+    NULL,                          /* ioctl */
+    NULL,                          /* queue_async */
+    NULL                           /* reselect_async */
+};
+
+/* threads that post their requests in a shared memory area */
+static struct list shm_request_threads = LIST_INIT(shm_request_threads);
+static unsigned int shm_request_count;   /* number of threads in the list */
+static int shm_request_busy;            /* did we handle a shared memory request recently? */
+
+#define SHM_REQUEST_SPIN_COUNT 1000      /* polling iterations before the main loop sleeps */
+
 /* complain about a protocol error and terminate the client connection */
 void fatal_protocol_error( struct thread *thread, const char *err, ... )
 {
@@ -286,11 +314,230 @@ static void send_reply( union generic_reply *reply )
         fatal_protocol_error( current, "reply write: %s\n", strerror( errno ));
 }
 
+static inline void shm_futex_wake( int *addr )
+{
+#if defined(__linux__) && defined(__NR_futex)
+    syscall( __NR_futex, addr, 1 /* FUTEX_WAKE */, 1, NULL, 0, 0 );
+#endif
+}
+
+/* store the reply to the current thread in its shared memory area */
+static void send_shm_reply( union generic_reply *reply )
+{
+    struct shm_request_area *area = current->shm_area;
+    char *buffer = (char *)(area + 1);
+
+    memcpy( buffer, reply, sizeof(*reply) );
+    if (current->reply_size)
+        memcpy( buffer + sizeof(*reply), current->reply_data, current->reply_size );
+    free( current->reply_data );
+    current->reply_data = NULL;
+
+    __sync_synchronize();
+    area->server_seq = current->shm_seq;
+    __sync_synchronize();
+    if (area->client_waiting) shm_futex_wake( &area->server_seq );
+}
+
+/* request statistics, dumped on SIGUSR1 or with wineserver --stats */
+struct request_stats
+{
+    unsigned int       count;        /* number of calls */
+    timeout_t          total_time;   /* total handling time */
+    timeout_t          max_time;     /* maximum handling time */
+    unsigned long long reply_bytes;  /* total variable reply data size */
+};
+
+static struct request_stats request_stats[REQ_NB_REQUESTS];
+static timeout_t stats_start_time;   /* time of the first request */
+static timeout_t loop_sleep_time;    /* time spent waiting in the main loop */
+static timeout_t loop_sleep_start;
+
+/* get a monotonic time in 100ns units for the statistics */
+static timeout_t get_stats_time(void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+    struct timespec ts;
+
+    if (!clock_gettime( CLOCK_MONOTONIC, &ts ))
+        return (timeout_t)ts.tv_sec * TICKS_PER_SEC + ts.tv_nsec / 100;
+#endif
+    return current_time;
+}
+
+/* request capture, see include/wine/servercapture.h */
+static FILE *capture_file;
+static timeout_t capture_start_time;
+
+static void close_request_capture(void)
+{
+    if (capture_file) fclose( capture_file );
+    capture_file = NULL;
+}
+
+/* start recording all the handled requests to a file */
+void open_request_capture( const char *name )
+{
+    static const char pad[8];
+    struct server_capture_header header;
+    unsigned int i, size = 0;
+
+    if (!(capture_file = fopen( name, "wb" )))
+    {
+        fprintf( stderr, "wineserver: cannot create capture file %s: %s\n", name, strerror( errno ));
+        exit(1);
+    }
+    setvbuf( capture_file, NULL, _IOFBF, 1024 * 1024 );
+
+    for (i = 0; i < REQ_NB_REQUESTS; i++) size += strlen( get_request_name( i )) + 1;
+
+    memset( &header, 0, sizeof(header) );
+    header.magic       = SERVER_CAPTURE_MAGIC;
+    header.version     = SERVER_CAPTURE_VERSION;
+    header.protocol    = SERVER_PROTOCOL_VERSION;
+    header.nb_requests = REQ_NB_REQUESTS;
+    header.names_size  = (size + 7) & ~7;
+    fwrite( &header, sizeof(header), 1, capture_file );
+    for (i = 0; i < REQ_NB_REQUESTS; i++)
+        fwrite( get_request_name( i ), strlen( get_request_name( i )) + 1, 1, capture_file );
+    fwrite( pad, header.names_size - size, 1, capture_file );
+
+    capture_start_time = get_stats_time();
+    atexit( close_request_capture );
+}
+
+static void capture_request( const union generic_request *req, const void *data, unsigned int pid,
+                             unsigned int tid, timeout_t start, timeout_t duration,
+                             unsigned int error, data_size_t reply_size )
+{
+    static const char pad[8];
+    struct server_capture_record record;
+    data_size_t size = sizeof(record) + sizeof(*req) + req->request_header.request_size;
+
+    record.size       = (size + 7) & ~7;
+    record.req        = req->request_header.req;
+    record.pid        = pid;
+    record.tid        = tid;
+    record.error      = error;
+    record.reply_size = reply_size;
+    record.time       = start - capture_start_time;
+    record.duration   = duration;
+    fwrite( &record, sizeof(record), 1, capture_file );
+    fwrite( req, sizeof(*req), 1, capture_file );
+    if (req->request_header.request_size)
+        fwrite( data, req->request_header.request_size, 1, capture_file );
+    fwrite( pad, record.size - size, 1, capture_file );
+}
+
+/* account for a request handled since 'start' */
+static timeout_t record_request_stats( enum request req, timeout_t start, data_size_t reply_size )
+{
+    timeout_t time = get_stats_time() - start;
+    struct request_stats *stats;
+
+    if (req >= REQ_NB_REQUESTS) return time;
+    stats = &request_stats[req];
+    stats->count++;
+    stats->total_time += time;
+    if (time > stats->max_time) stats->max_time = time;
+    stats->reply_bytes += reply_size;
+    return time;
+}
+
+/* called when the main loop goes to sleep */
+void stats_sleep_begin(void)
+{
+    loop_sleep_start = get_stats_time();
+}
+
+/* called when the main loop wakes up */
+void stats_sleep_end(void)
+{
+    loop_sleep_time += get_stats_time() - loop_sleep_start;
+}
+
+static int compare_request_stats( const void *p1, const void *p2 )
+{
+    const struct request_stats *s1 = &request_stats[*(const enum request *)p1];
+    const struct request_stats *s2 = &request_stats[*(const enum request *)p2];
+
+    if (s1->total_time > s2->total_time) return -1;
+    if (s1->total_time < s2->total_time) return 1;
+    return s2->count - s1->count;
+}
+
+static int dump_process_stats( struct process *process, void *arg )
+{
+    struct list *ptr = list_head( &process->dlls );
+    struct process_dll *exe;
+
+    if (!process->req_count) return 0;
+    fprintf( stderr, "%04x (unix pid %5d) %10u %10u ", process->id, process->unix_pid,
+             process->req_count, (unsigned int)(process->req_time / 10000) );
+    if (ptr && (exe = LIST_ENTRY( ptr, struct process_dll, entry ))->filename)
+        dump_strW( exe->filename, exe->namelen / sizeof(WCHAR), stderr, "\"\"" );
+    fputc( '\n', stderr );
+    return 0;
+}
+
+/* dump the request statistics, sorted by total handling time */
+void dump_request_stats(void)
+{
+    enum request order[REQ_NB_REQUESTS];
+    timeout_t total = 0, elapsed;
+    unsigned int i, count = 0;
+
+    if (!stats_start_time) return;
+    elapsed = get_stats_time() - stats_start_time;
+
+    for (i = 0; i < REQ_NB_REQUESTS; i++)
+    {
+        if (!request_stats[i].count) continue;
+        total += request_stats[i].total_time;
+        order[count++] = i;
+    }
+    qsort( order, count, sizeof(order[0]), compare_request_stats );
+
+    fprintf( stderr, "wineserver: %u.%03u s elapsed, %u.%03u s sleeping, %u.%03u s handling requests\n",
+             (unsigned int)(elapsed / TICKS_PER_SEC), (unsigned int)(elapsed % TICKS_PER_SEC / 10000),
+             (unsigned int)(loop_sleep_time / TICKS_PER_SEC),
+             (unsigned int)(loop_sleep_time % TICKS_PER_SEC / 10000),
+             (unsigned int)(total / TICKS_PER_SEC), (unsigned int)(total % TICKS_PER_SEC / 10000) );
+    fprintf( stderr, "%-32s %10s %10s %8s %8s %10s\n",
+             "request", "count", "total ms", "avg us", "max us", "reply KB" );
+    for (i = 0; i < count; i++)
+    {
+        const struct request_stats *stats = &request_stats[order[i]];
+        fprintf( stderr, "%-32s %10u %10u %8u %8u %10u\n", get_request_name( order[i] ), stats->count,
+                 (unsigned int)(stats->total_time / 10000),
+                 (unsigned int)(stats->total_time / stats->count / 10),
+                 (unsigned int)(stats->max_time / 10), (unsigned int)(stats->reply_bytes / 1024) );
+    }
+
+    fprintf( stderr, "%-21s %10s %10s %s\n", "process", "count", "total ms", "image" );
+    enum_processes( dump_process_stats, NULL );
+    dump_poll_stats();
+}
+
 /* call a request handler */
 static void call_req_handler( struct thread *thread )
 {
     union generic_reply reply;
+    union generic_request req_copy;
     enum request req = thread->req.request_header.req;
+    timeout_t time, start = get_stats_time();
+    unsigned int pid = thread->process->id, tid = thread->id;
+    void *data = NULL;
+
+    if (!stats_start_time) stats_start_time = start;
+
+    /* the handler may modify the request, e.g. for batches */
+    if (capture_file)
+    {
+        req_copy = thread->req;
+        if (thread->req.request_header.request_size)
+            data = memdup( thread->req_data, thread->req.request_header.request_size );
+    }
 
     current = thread;
     current->reply_size = 0;
@@ -311,7 +558,8 @@ static void call_req_handler( struct thread *thread )
             reply.reply_header.error = current->error;
             reply.reply_header.reply_size = current->reply_size;
             if (debug_level) trace_reply( req, &reply );
-            send_reply( &reply );
+            if (current->shm_request) send_shm_reply( &reply );
+            else send_reply( &reply );
         }
         else
         {
@@ -319,9 +567,113 @@ static void call_req_handler( struct thread *thread )
             kill_thread( current, 1 );  /* no way to continue without reply fd */
         }
     }
+    time = record_request_stats( req, start, reply.reply_header.reply_size );
+    if (capture_file)
+    {
+        if (req_copy.request_header.request_size && !data) req_copy.request_header.request_size = 0;
+        capture_request( &req_copy, data, pid, tid, start, time,
+                         reply.reply_header.error, reply.reply_header.reply_size );
+        free( data );
+    }
+    if (current)
+    {
+        current->process->req_count++;
+        current->process->req_time += time;
+    }
     current = NULL;
 }
 
+/* perform several requests in a single round-trip */
+DECL_HANDLER(batch)
+{
+    struct thread *thread = current;
+    unsigned int flags = req->flags;
+    data_size_t reply_max = get_reply_max_size(), pos = 0;
+    union generic_request batch_req = current->req;
+    char *batch_data = current->req_data, *replies = NULL;
+    const char *ptr = batch_data, *end = ptr + get_req_data_size();
+    unsigned int count = 0;
+    timeout_t start;
+
+    /* the batch data is released here, the sub-requests get their own copy */
+    current->req_data = NULL;
+
+    while (ptr < end)
+    {
+        union generic_reply sub_reply;
+        enum request sub;
+        data_size_t size;
+
+        if (end - ptr < sizeof(current->req))
+        {
+            set_error( STATUS_INVALID_PARAMETER );
+            break;
+        }
+        memcpy( &current->req, ptr, sizeof(current->req) );
+        ptr += sizeof(current->req);
+        sub  = current->req.request_header.req;
+        size = current->req.request_header.request_size;
+        if (end - ptr < size || reply_max - pos < sizeof(sub_reply) ||
+            reply_max - pos - sizeof(sub_reply) < current->req.request_header.reply_size)
+        {
+            set_error( STATUS_INVALID_PARAMETER );
+            break;
+        }
+        if (size && !(current->req_data = memdup( ptr, size ))) break;
+        ptr += size;
+
+        current->reply_size = 0;
+        clear_error();
+        memset( &sub_reply, 0, sizeof(sub_reply) );
+        if (debug_level) trace_request();
+
+        start = get_stats_time();
+        if (sub < REQ_NB_REQUESTS && sub != REQ_batch)
+            req_handlers[sub]( &current->req, &sub_reply );
+        else
+            set_error( STATUS_NOT_IMPLEMENTED );
+
+        if (!current) goto done;  /* the thread got killed */
+        record_request_stats( sub, start, current->reply_size );
+
+        free( current->req_data );
+        current->req_data = NULL;
+        sub_reply.reply_header.error = current->error;
+        sub_reply.reply_header.reply_size = current->reply_size;
+        if (debug_level) trace_reply( sub, &sub_reply );
+        clear_error();
+
+        if (!replies && !(replies = mem_alloc( reply_max ))) break;
+        memcpy( replies + pos, &sub_reply, sizeof(sub_reply) );
+        pos += sizeof(sub_reply);
+        if (current->reply_size)
+        {
+            memcpy( replies + pos, current->reply_data, current->reply_size );
+            pos += current->reply_size;
+        }
+        free( current->reply_data );
+        current->reply_data = NULL;
+        count++;
+
+        if (sub_reply.reply_header.error && (flags & BATCH_STOP_ON_ERROR)) break;
+    }
+
+    current->req = batch_req;
+    if (!get_error())
+    {
+        reply->count = count;
+        current->reply_data = replies;
+        current->reply_size = pos;
+        replies = NULL;
+    }
+    else current->reply_size = 0;
+
+done:
+    assert( !current || current == thread );
+    free( replies );
+    free( batch_data );
+}
+
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
@@ -371,6 +723,162 @@ error:
         fatal_protocol_error( thread, "read: %s\n", strerror( errno ));
 }
 
+/* handle the request posted in the shared memory area of a thread, if any */
+static int read_shm_request( struct thread *thread )
+{
+    struct shm_request_area *area = thread->shm_area;
+    const char *buffer = (const char *)(area + 1);
+    data_size_t size;
+    int seq = area->client_seq;
+
+    if (seq == thread->shm_seq) return 0;  /* nothing posted */
+    __sync_synchronize();
+
+    memcpy( &thread->req, buffer, sizeof(thread->req) );
+    size = thread->req.request_header.request_size;
+    if (size > SHM_REQUEST_MAX_DATA || thread->req.request_header.reply_size > SHM_REQUEST_MAX_DATA)
+    {
+        fatal_protocol_error( thread, "shared memory request too large (%u/%u)\n",
+                              size, thread->req.request_header.reply_size );
+        return 0;
+    }
+    if (size)
+    {
+        if (!(thread->req_data = malloc( size )))
+        {
+            fatal_protocol_error( thread, "no memory for %u bytes request %d\n",
+                                  size, thread->req.request_header.req );
+            return 0;
+        }
+        memcpy( thread->req_data, buffer + sizeof(thread->req), size );
+    }
+    thread->shm_seq = seq;
+    thread->shm_request = 1;
+    call_req_handler( thread );
+    thread->shm_request = 0;
+    free( thread->req_data );
+    thread->req_data = NULL;
+    return 1;
+}
+
+/* handle the pending requests of all threads using a shared memory area */
+static int read_shm_requests(void)
+{
+    static struct thread **threads;
+    static unsigned int size;
+    struct thread *thread;
+    unsigned int i, count = 0;
+    int ret = 0;
+
+    LIST_FOR_EACH_ENTRY( thread, &shm_request_threads, struct thread, shm_entry )
+    {
+        if (thread->shm_area->client_seq == thread->shm_seq) continue;
+        if (count == size)
+        {
+            unsigned int new_size = max( 16, size * 2 );
+            struct thread **new_threads = realloc( threads, new_size * sizeof(*threads) );
+            if (!new_threads) break;
+            threads = new_threads;
+            size = new_size;
+        }
+        threads[count++] = (struct thread *)grab_object( thread );
+    }
+
+    /* handlers may kill threads, so don't walk the list while calling them */
+    for (i = 0; i < count; i++)
+    {
+        if (threads[i]->shm_area) ret |= read_shm_request( threads[i] );
+        release_object( threads[i] );
+    }
+    return ret;
+}
+
+/* called before the main loop blocks; return 0 if it must not block */
+int shm_requests_prepare_sleep(void)
+{
+    struct thread *thread;
+    int i;
+
+    if (!shm_request_count) return 1;
+
+    /* a thread that just got a reply will likely post another request soon */
+    for (i = 0; shm_request_busy && i < SHM_REQUEST_SPIN_COUNT; i++)
+    {
+        if (read_shm_requests()) return 0;
+#if defined(__i386__) || defined(__x86_64__)
+        __asm__ __volatile__( "rep;nop" : : : "memory" );
+#endif
+    }
+    shm_request_busy = 0;
+
+    LIST_FOR_EACH_ENTRY( thread, &shm_request_threads, struct thread, shm_entry )
+        thread->shm_area->server_sleeping = 1;
+    __sync_synchronize();
+
+    if (!read_shm_requests()) return 1;
+    shm_requests_end_sleep();
+    shm_request_busy = 1;
+    return 0;
+}
+
+/* called when the main loop wakes up */
+void shm_requests_end_sleep(void)
+{
+    struct thread *thread;
+
+    LIST_FOR_EACH_ENTRY( thread, &shm_request_threads, struct thread, shm_entry )
+        thread->shm_area->server_sleeping = 0;
+}
+
+/* the client rang the doorbell of a sleeping server */
+static void doorbell_poll_event( struct fd *fd, int event )
+{
+    struct thread *thread = get_fd_user( fd );
+    char buffer[64];
+
+    if (event & (POLLERR | POLLHUP))
+    {
+        /* the thread is exiting, the request and reply pipes take care of it */
+        set_fd_events( fd, -1 );
+        return;
+    }
+    while (read( get_unix_fd( fd ), buffer, sizeof(buffer) ) > 0) /* nothing */;
+
+    grab_object( thread );
+    if (thread->shm_area && read_shm_request( thread )) shm_request_busy = 1;
+    release_object( thread );
+}
+
+/* start handling the requests a thread posts in a shared memory area */
+/* the doorbell fd is closed on failure */
+int init_shm_request_area( struct thread *thread, struct shm_request_area *area, int doorbell_fd )
+{
+    if (!(thread->doorbell_fd = create_anonymous_fd( &doorbell_fd_ops, doorbell_fd, &thread->obj, 0 )))
+        return 0;
+    thread->shm_area = area;
+    thread->shm_seq  = area->client_seq;
+    list_add_tail( &shm_request_threads, &thread->shm_entry );
+    shm_request_count++;
+    set_fd_events( thread->doorbell_fd, POLLIN );
+    return 1;
+}
+
+/* stop using the shared memory area of a dead thread */
+void cleanup_shm_request_area( struct thread *thread )
+{
+    struct shm_request_area *area = thread->shm_area;
+
+    area->dead = 1;
+    __sync_synchronize();
+    shm_futex_wake( &area->server_seq );
+    munmap( area, SHM_REQUEST_AREA_SIZE );
+    list_remove( &thread->shm_entry );
+    shm_request_count--;
+    if (thread->doorbell_fd) release_object( thread->doorbell_fd );
+    thread->doorbell_fd = NULL;
+    thread->shm_area = NULL;
+}
+
 /* receive a file descriptor on the process socket */
 int receive_fd( struct process *process )
 {
@@ -54,7 +54,16 @@ extern int receive_fd( struct process *process );
 extern int send_client_fd( struct process *process, int fd, obj_handle_t handle );
 extern void read_request( struct thread *thread );
 extern void write_reply( struct thread *thread );
+extern int init_shm_request_area( struct thread *thread, struct shm_request_area *area,
+                                  int doorbell_fd );
+extern void cleanup_shm_request_area( struct thread *thread );
+extern int shm_requests_prepare_sleep(void);
+extern void shm_requests_end_sleep(void);
 extern unsigned int get_tick_count(void);
+extern void stats_sleep_begin(void);
+extern void stats_sleep_end(void);
+extern void dump_request_stats(void);
+extern void dump_poll_stats(void);
 extern void open_master_socket(void);
 extern void close_master_socket( timeout_t timeout );
 extern void shutdown_master_socket(void);
@@ -64,6 +73,8 @@ extern int server_dir_fd, config_dir_fd;
 
 extern void trace_request(void);
 extern void trace_reply( enum request req, const union generic_reply *reply );
+extern const char *get_request_name( enum request req );
+extern void open_request_capture( const char *name );
 
 /* get the request vararg data */
 static inline const void *get_req_data(void)
@@ -118,6 +129,8 @@ DECL_HANDLER(new_thread);
 DECL_HANDLER(get_startup_info);
 DECL_HANDLER(init_process_done);
 DECL_HANDLER(init_thread);
+DECL_HANDLER(set_shm_request_area);
+DECL_HANDLER(batch);
 DECL_HANDLER(terminate_process);
 DECL_HANDLER(terminate_thread);
 DECL_HANDLER(get_process_info);
@@ -202,6 +215,9 @@ DECL_HANDLER(map_view);
 DECL_HANDLER(unmap_view);
 DECL_HANDLER(get_mapping_committed_range);
 DECL_HANDLER(add_mapping_committed_range);
+DECL_HANDLER(get_image_relocation);
+DECL_HANDLER(create_image_relocation);
+DECL_HANDLER(commit_image_relocation);
 DECL_HANDLER(is_same_mapping);
 DECL_HANDLER(create_snapshot);
 DECL_HANDLER(next_process);
@@ -222,6 +238,7 @@ DECL_HANDLER(flush_key);
 DECL_HANDLER(enum_key);
 DECL_HANDLER(set_key_value);
 DECL_HANDLER(get_key_value);
+DECL_HANDLER(get_registry_generations);
 DECL_HANDLER(enum_key_value);
 DECL_HANDLER(delete_key_value);
 DECL_HANDLER(load_registry);
@@ -244,6 +261,7 @@ DECL_HANDLER(set_atom_information);
 DECL_HANDLER(empty_atom_table);
 DECL_HANDLER(init_atom_table);
 DECL_HANDLER(get_msg_queue);
+DECL_HANDLER(get_queue_shared_memory);
 DECL_HANDLER(set_queue_fd);
 DECL_HANDLER(set_queue_mask);
 DECL_HANDLER(get_queue_status);
@@ -277,6 +295,7 @@ DECL_HANDLER(set_window_owner);
 DECL_HANDLER(get_window_info);
 DECL_HANDLER(set_window_info);
 DECL_HANDLER(set_parent);
+DECL_HANDLER(get_shared_windows);
 DECL_HANDLER(get_window_parents);
 DECL_HANDLER(get_window_children);
 DECL_HANDLER(get_window_children_from_point);
@@ -381,6 +400,7 @@ DECL_HANDLER(create_completion);
 DECL_HANDLER(open_completion);
 DECL_HANDLER(add_completion);
 DECL_HANDLER(remove_completion);
+DECL_HANDLER(remove_completions);
 DECL_HANDLER(query_completion);
 DECL_HANDLER(set_completion_info);
 DECL_HANDLER(add_fd_completion);
@@ -401,6 +421,9 @@ DECL_HANDLER(process_in_job);
 DECL_HANDLER(set_job_limits);
 DECL_HANDLER(set_job_completion_port);
 DECL_HANDLER(terminate_job);
+DECL_HANDLER(create_wait_set);
+DECL_HANDLER(set_wait_set_member);
+DECL_HANDLER(get_wait_set_events);
 
 #ifdef WANT_REQUEST_HANDLERS
 
@@ -413,6 +436,8 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_startup_info,
     (req_handler)req_init_process_done,
     (req_handler)req_init_thread,
+    (req_handler)req_set_shm_request_area,
+    (req_handler)req_batch,
     (req_handler)req_terminate_process,
     (req_handler)req_terminate_thread,
     (req_handler)req_get_process_info,
@@ -497,6 +522,9 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_unmap_view,
     (req_handler)req_get_mapping_committed_range,
     (req_handler)req_add_mapping_committed_range,
+    (req_handler)req_get_image_relocation,
+    (req_handler)req_create_image_relocation,
+    (req_handler)req_commit_image_relocation,
     (req_handler)req_is_same_mapping,
     (req_handler)req_create_snapshot,
     (req_handler)req_next_process,
@@ -517,6 +545,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_enum_key,
     (req_handler)req_set_key_value,
     (req_handler)req_get_key_value,
+    (req_handler)req_get_registry_generations,
     (req_handler)req_enum_key_value,
     (req_handler)req_delete_key_value,
     (req_handler)req_load_registry,
@@ -539,6 +568,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_empty_atom_table,
     (req_handler)req_init_atom_table,
     (req_handler)req_get_msg_queue,
+    (req_handler)req_get_queue_shared_memory,
     (req_handler)req_set_queue_fd,
     (req_handler)req_set_queue_mask,
     (req_handler)req_get_queue_status,
@@ -572,6 +602,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_window_info,
     (req_handler)req_set_window_info,
     (req_handler)req_set_parent,
+    (req_handler)req_get_shared_windows,
     (req_handler)req_get_window_parents,
     (req_handler)req_get_window_children,
     (req_handler)req_get_window_children_from_point,
@@ -676,6 +707,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_open_completion,
     (req_handler)req_add_completion,
     (req_handler)req_remove_completion,
+    (req_handler)req_remove_completions,
     (req_handler)req_query_completion,
     (req_handler)req_set_completion_info,
     (req_handler)req_add_fd_completion,
@@ -696,6 +728,9 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_set_job_limits,
     (req_handler)req_set_job_completion_port,
     (req_handler)req_terminate_job,
+    (req_handler)req_create_wait_set,
+    (req_handler)req_set_wait_set_member,
+    (req_handler)req_get_wait_set_events,
 };
 
 C_ASSERT( sizeof(affinity_t) == 8 );
@@ -786,6 +821,13 @@ C_ASSERT( FIELD_OFFSET(struct init_thread_reply, version) == 28 );
 C_ASSERT( FIELD_OFFSET(struct init_thread_reply, all_cpus) == 32 );
 C_ASSERT( FIELD_OFFSET(struct init_thread_reply, suspend) == 36 );
 C_ASSERT( sizeof(struct init_thread_reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct set_shm_request_area_request, area_fd) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_shm_request_area_request, doorbell_fd) == 16 );
+C_ASSERT( sizeof(struct set_shm_request_area_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct batch_request, flags) == 12 );
+C_ASSERT( sizeof(struct batch_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct batch_reply, count) == 8 );
+C_ASSERT( sizeof(struct batch_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct terminate_process_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct terminate_process_request, exit_code) == 16 );
 C_ASSERT( sizeof(struct terminate_process_request) == 24 );
@@ -1000,7 +1042,10 @@ C_ASSERT( FIELD_OFFSET(struct create_file_request, options) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_file_request, attrs) == 28 );
 C_ASSERT( sizeof(struct create_file_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_file_reply, handle) == 8 );
-C_ASSERT( sizeof(struct create_file_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_file_reply, fd_type) == 12 );
+C_ASSERT( FIELD_OFFSET(struct create_file_reply, fd_access) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_file_reply, fd_options) == 20 );
+C_ASSERT( sizeof(struct create_file_reply) == 24 );
 C_ASSERT( FIELD_OFFSET(struct open_file_object_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct open_file_object_request, attributes) == 16 );
 C_ASSERT( FIELD_OFFSET(struct open_file_object_request, rootdir) == 20 );
@@ -1299,6 +1344,17 @@ C_ASSERT( FIELD_OFFSET(struct add_mapping_committed_range_request, base) == 16 )
 C_ASSERT( FIELD_OFFSET(struct add_mapping_committed_range_request, offset) == 24 );
 C_ASSERT( FIELD_OFFSET(struct add_mapping_committed_range_request, size) == 32 );
 C_ASSERT( sizeof(struct add_mapping_committed_range_request) == 40 );
+C_ASSERT( FIELD_OFFSET(struct get_image_relocation_request, mapping) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_image_relocation_request, base) == 16 );
+C_ASSERT( sizeof(struct get_image_relocation_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_image_relocation_reply, file) == 8 );
+C_ASSERT( sizeof(struct get_image_relocation_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_image_relocation_request, base) == 16 );
+C_ASSERT( sizeof(struct create_image_relocation_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct create_image_relocation_reply, file) == 8 );
+C_ASSERT( sizeof(struct create_image_relocation_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct commit_image_relocation_request, base) == 16 );
+C_ASSERT( sizeof(struct commit_image_relocation_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct is_same_mapping_request, base1) == 16 );
 C_ASSERT( FIELD_OFFSET(struct is_same_mapping_request, base2) == 24 );
 C_ASSERT( sizeof(struct is_same_mapping_request) == 32 );
@@ -1403,7 +1459,12 @@ C_ASSERT( FIELD_OFFSET(struct get_key_value_request, hkey) == 12 );
 C_ASSERT( sizeof(struct get_key_value_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, type) == 8 );
 C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, total) == 12 );
-C_ASSERT( sizeof(struct get_key_value_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, gen_slot) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_key_value_reply, generation) == 20 );
+C_ASSERT( sizeof(struct get_key_value_reply) == 24 );
+C_ASSERT( sizeof(struct get_registry_generations_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_registry_generations_reply, file) == 8 );
+C_ASSERT( sizeof(struct get_registry_generations_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, hkey) == 12 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, index) == 16 );
 C_ASSERT( FIELD_OFFSET(struct enum_key_value_request, info_class) == 20 );
@@ -1504,6 +1565,9 @@ C_ASSERT( sizeof(struct init_atom_table_reply) == 16 );
 C_ASSERT( sizeof(struct get_msg_queue_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_msg_queue_reply, handle) == 8 );
 C_ASSERT( sizeof(struct get_msg_queue_reply) == 16 );
+C_ASSERT( sizeof(struct get_queue_shared_memory_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_queue_shared_memory_reply, file) == 8 );
+C_ASSERT( sizeof(struct get_queue_shared_memory_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_queue_fd_request, handle) == 12 );
 C_ASSERT( sizeof(struct set_queue_fd_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct set_queue_mask_request, wake_mask) == 12 );
@@ -1715,6 +1779,9 @@ C_ASSERT( sizeof(struct set_parent_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct set_parent_reply, old_parent) == 8 );
 C_ASSERT( FIELD_OFFSET(struct set_parent_reply, full_parent) == 12 );
 C_ASSERT( sizeof(struct set_parent_reply) == 16 );
+C_ASSERT( sizeof(struct get_shared_windows_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_shared_windows_reply, file) == 8 );
+C_ASSERT( sizeof(struct get_shared_windows_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_window_parents_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_window_parents_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_window_parents_reply, count) == 8 );
@@ -2307,6 +2374,9 @@ C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, cvalue) == 16 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, information) == 24 );
 C_ASSERT( FIELD_OFFSET(struct remove_completion_reply, status) == 32 );
 C_ASSERT( sizeof(struct remove_completion_reply) == 40 );
+C_ASSERT( FIELD_OFFSET(struct remove_completions_request, handle) == 12 );
+C_ASSERT( sizeof(struct remove_completions_request) == 16 );
+C_ASSERT( sizeof(struct remove_completions_reply) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_request, handle) == 12 );
 C_ASSERT( sizeof(struct query_completion_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct query_completion_reply, depth) == 8 );
@@ -2390,6 +2460,17 @@ C_ASSERT( sizeof(struct set_job_completion_port_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct terminate_job_request, handle) == 12 );
 C_ASSERT( FIELD_OFFSET(struct terminate_job_request, status) == 16 );
 C_ASSERT( sizeof(struct terminate_job_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct create_wait_set_request, access) == 12 );
+C_ASSERT( sizeof(struct create_wait_set_request) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_wait_set_reply, handle) == 8 );
+C_ASSERT( sizeof(struct create_wait_set_reply) == 16 );
+C_ASSERT( FIELD_OFFSET(struct set_wait_set_member_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_wait_set_member_request, object) == 16 );
+C_ASSERT( FIELD_OFFSET(struct set_wait_set_member_request, key) == 24 );
+C_ASSERT( sizeof(struct set_wait_set_member_request) == 32 );
+C_ASSERT( FIELD_OFFSET(struct get_wait_set_events_request, handle) == 12 );
+C_ASSERT( sizeof(struct get_wait_set_events_request) == 16 );
+C_ASSERT( sizeof(struct get_wait_set_events_reply) == 8 );
 
 #endif  /* WANT_REQUEST_HANDLERS */
 
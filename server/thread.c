@@ -38,6 +38,10 @@
 #ifdef HAVE_SCHED_H
 #include <sched.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#include <sys/stat.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -193,6 +197,10 @@ static inline void init_thread_structure( struct thread *thread )
     thread->request_fd      = NULL;
     thread->reply_fd        = NULL;
     thread->wait_fd         = NULL;
+    thread->shm_area        = NULL;
+    thread->doorbell_fd     = NULL;
+    thread->shm_seq         = 0;
+    thread->shm_request     = 0;
     thread->state           = RUNNING;
     thread->exit_code       = 0;
     thread->priority        = 0;
@@ -287,6 +295,7 @@ static void cleanup_thread( struct thread *thread )
     if (thread->request_fd) release_object( thread->request_fd );
     if (thread->reply_fd) release_object( thread->reply_fd );
     if (thread->wait_fd) release_object( thread->wait_fd );
+    if (thread->shm_area) cleanup_shm_request_area( thread );
     free( thread->suspend_context );
     cleanup_clipboard_thread(thread);
     destroy_thread_windows( thread );
@@ -600,6 +609,13 @@ static unsigned int end_wait( struct thread *thread, unsigned int status )
             for (i = 0, entry = wait->queues; i < wait->count; i++, entry++)
                 entry->obj->ops->satisfied( entry->obj, entry );
         }
+        else if (wait->select == SELECT_WAIT_SET)
+        {
+            /* all the signaled members are reported through the set */
+            wait_set_satisfied( wait->queues, wait->count );
+            status = STATUS_WAIT_0;
+            wait->abandoned = 0;
+        }
         else
         {
             entry = wait->queues + status;
@@ -809,7 +825,7 @@ static timeout_t select_on( const select_op_t *select_op, data_size_t op_size, c
 {
     int ret;
     unsigned int count;
-    struct object *object;
+    struct object *object, **objects;
 
     if (timeout <= 0) timeout = current_time - timeout;
 
@@ -857,6 +873,19 @@ static timeout_t select_on( const select_op_t *select_op, data_size_t op_size, c
         current->wait->key = select_op->keyed_event.key;
         break;
 
+    case SELECT_WAIT_SET:
+        if (op_size < sizeof(select_op->wait_set))
+        {
+            set_error( STATUS_INVALID_PARAMETER );
+            return 0;
+        }
+        if (!(objects = get_wait_set_objects( current->process, select_op->wait_set.handle, &count )))
+            return timeout;
+        ret = wait_on( select_op, count, objects, flags, timeout );
+        free( objects );
+        if (!ret) return timeout;
+        break;
+
     default:
         set_error( STATUS_INVALID_PARAMETER );
         return 0;
@@ -1347,6 +1376,50 @@ DECL_HANDLER(init_thread)
     if (wait_fd != -1) close( wait_fd );
 }
 
+/* switch the current thread to the shared memory request channel */
+DECL_HANDLER(set_shm_request_area)
+{
+    struct shm_request_area *area = MAP_FAILED;
+    struct stat st;
+    int area_fd, doorbell_fd;
+
+    if ((area_fd = thread_get_inflight_fd( current, req->area_fd )) == -1)
+    {
+        set_error( STATUS_INVALID_HANDLE );
+        return;
+    }
+    if ((doorbell_fd = thread_get_inflight_fd( current, req->doorbell_fd )) == -1)
+    {
+        set_error( STATUS_INVALID_HANDLE );
+        close( area_fd );
+        return;
+    }
+
+    if (current->shm_area)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto error;
+    }
+    if (fstat( area_fd, &st ) == -1 || st.st_size < SHM_REQUEST_AREA_SIZE ||
+        (area = mmap( NULL, SHM_REQUEST_AREA_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, area_fd, 0 )) == MAP_FAILED)
+    {
+        set_error( STATUS_INVALID_PARAMETER );
+        goto error;
+    }
+    close( area_fd );
+    area_fd = -1;
+
+    if (fcntl( doorbell_fd, F_SETFL, O_NONBLOCK ) == -1) goto error;
+    if (!init_shm_request_area( current, area, doorbell_fd )) munmap( area, SHM_REQUEST_AREA_SIZE );
+    return;
+
+ error:
+    if (area != MAP_FAILED) munmap( area, SHM_REQUEST_AREA_SIZE );
+    if (area_fd != -1) close( area_fd );
+    close( doorbell_fd );
+}
+
 /* terminate a thread */
 DECL_HANDLER(terminate_thread)
 {
@@ -73,6 +73,11 @@ struct thread
     struct fd             *request_fd;    /* fd for receiving client requests */
     struct fd             *reply_fd;      /* fd to send a reply to a client */
     struct fd             *wait_fd;       /* fd to use to wake a sleeping client */
+    struct shm_request_area *shm_area;    /* shared memory request area, if any */
+    struct fd             *doorbell_fd;   /* fd the client writes to when a shared memory request is posted */
+    struct list            shm_entry;     /* entry in list of threads using a shared memory area */
+    int                    shm_seq;       /* sequence number of the last shared memory request */
+    int                    shm_request;   /* is the current request from the shared memory area? */
     enum run_state         state;         /* running state */
     int                    exit_code;     /* thread exit code */
     int                    unix_pid;      /* Unix pid of client */
@@ -481,6 +481,9 @@ static void dump_varargs_select_op( const char *prefix, data_size_t size )
                  data.keyed_event.handle );
         dump_uint64( ",key=", &data.keyed_event.key );
         break;
+    case SELECT_WAIT_SET:
+        fprintf( stderr, "WAIT_SET,handle=%04x", data.wait_set.handle );
+        break;
     default:
         fprintf( stderr, "op=%u", data.op );
         break;
@@ -1202,6 +1205,25 @@ static void dump_varargs_rawinput_devices(const char *prefix, data_size_t size )
     fputc( '}', stderr );
 }
 
+static void dump_varargs_completion_entries( const char *prefix, data_size_t size )
+{
+    const struct completion_entry *entry;
+
+    fprintf( stderr, "%s{", prefix );
+    while (size >= sizeof(*entry))
+    {
+        entry = cur_data;
+        dump_uint64( "{ckey=", &entry->ckey );
+        dump_uint64( ",cvalue=", &entry->cvalue );
+        dump_uint64( ",information=", &entry->information );
+        fprintf( stderr, ",status=%08x}", entry->status );
+        size -= sizeof(*entry);
+        remove_data( sizeof(*entry) );
+        if (size) fputc( ',', stderr );
+    }
+    fputc( '}', stderr );
+}
+
 static void dump_varargs_handle_infos( const char *prefix, data_size_t size )
 {
     const struct handle_info *handle;
@@ -1322,6 +1344,24 @@ static void dump_init_thread_reply( const struct init_thread_reply *req )
     fprintf( stderr, ", suspend=%d", req->suspend );
 }
 
+static void dump_set_shm_request_area_request( const struct set_shm_request_area_request *req )
+{
+    fprintf( stderr, " area_fd=%d", req->area_fd );
+    fprintf( stderr, ", doorbell_fd=%d", req->doorbell_fd );
+}
+
+static void dump_batch_request( const struct batch_request *req )
+{
+    fprintf( stderr, " flags=%08x", req->flags );
+    dump_varargs_bytes( ", requests=", cur_size );
+}
+
+static void dump_batch_reply( const struct batch_reply *req )
+{
+    fprintf( stderr, " count=%08x", req->count );
+    dump_varargs_bytes( ", replies=", cur_size );
+}
+
 static void dump_terminate_process_request( const struct terminate_process_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -1747,6 +1787,9 @@ static void dump_create_file_request( const struct create_file_request *req )
 static void dump_create_file_reply( const struct create_file_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", fd_type=%d", req->fd_type );
+    fprintf( stderr, ", fd_access=%08x", req->fd_access );
+    fprintf( stderr, ", fd_options=%08x", req->fd_options );
 }
 
 static void dump_open_file_object_request( const struct open_file_object_request *req )
@@ -2308,6 +2351,32 @@ static void dump_add_mapping_committed_range_request( const struct add_mapping_c
     dump_uint64( ", size=", &req->size );
 }
 
+static void dump_get_image_relocation_request( const struct get_image_relocation_request *req )
+{
+    fprintf( stderr, " mapping=%04x", req->mapping );
+    dump_uint64( ", base=", &req->base );
+}
+
+static void dump_get_image_relocation_reply( const struct get_image_relocation_reply *req )
+{
+    fprintf( stderr, " file=%04x", req->file );
+}
+
+static void dump_create_image_relocation_request( const struct create_image_relocation_request *req )
+{
+    dump_uint64( " base=", &req->base );
+}
+
+static void dump_create_image_relocation_reply( const struct create_image_relocation_reply *req )
+{
+    fprintf( stderr, " file=%04x", req->file );
+}
+
+static void dump_commit_image_relocation_request( const struct commit_image_relocation_request *req )
+{
+    dump_uint64( " base=", &req->base );
+}
+
 static void dump_is_same_mapping_request( const struct is_same_mapping_request *req )
 {
     dump_uint64( " base1=", &req->base1 );
@@ -2522,9 +2591,20 @@ static void dump_get_key_value_reply( const struct get_key_value_reply *req )
 {
     fprintf( stderr, " type=%d", req->type );
     fprintf( stderr, ", total=%u", req->total );
+    fprintf( stderr, ", gen_slot=%08x", req->gen_slot );
+    fprintf( stderr, ", generation=%08x", req->generation );
     dump_varargs_bytes( ", data=", cur_size );
 }
 
+static void dump_get_registry_generations_request( const struct get_registry_generations_request *req )
+{
+}
+
+static void dump_get_registry_generations_reply( const struct get_registry_generations_reply *req )
+{
+    fprintf( stderr, " file=%04x", req->file );
+}
+
 static void dump_enum_key_value_request( const struct enum_key_value_request *req )
 {
     fprintf( stderr, " hkey=%04x", req->hkey );
@@ -2744,6 +2824,15 @@ static void dump_get_msg_queue_reply( const struct get_msg_queue_reply *req )
     fprintf( stderr, " handle=%04x", req->handle );
 }
 
+static void dump_get_queue_shared_memory_request( const struct get_queue_shared_memory_request *req )
+{
+}
+
+static void dump_get_queue_shared_memory_reply( const struct get_queue_shared_memory_reply *req )
+{
+    fprintf( stderr, " file=%04x", req->file );
+}
+
 static void dump_set_queue_fd_request( const struct set_queue_fd_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -3130,6 +3219,15 @@ static void dump_set_parent_reply( const struct set_parent_reply *req )
     fprintf( stderr, ", full_parent=%08x", req->full_parent );
 }
 
+static void dump_get_shared_windows_request( const struct get_shared_windows_request *req )
+{
+}
+
+static void dump_get_shared_windows_reply( const struct get_shared_windows_reply *req )
+{
+    fprintf( stderr, " file=%04x", req->file );
+}
+
 static void dump_get_window_parents_request( const struct get_window_parents_request *req )
 {
     fprintf( stderr, " handle=%08x", req->handle );
@@ -4350,6 +4448,16 @@ static void dump_remove_completion_reply( const struct remove_completion_reply *
     fprintf( stderr, ", status=%08x", req->status );
 }
 
+static void dump_remove_completions_request( const struct remove_completions_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_remove_completions_reply( const struct remove_completions_reply *req )
+{
+    dump_varargs_completion_entries( " entries=", cur_size );
+}
+
 static void dump_query_completion_request( const struct query_completion_request *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
@@ -4520,6 +4628,33 @@ static void dump_terminate_job_request( const struct terminate_job_request *req
     fprintf( stderr, ", status=%d", req->status );
 }
 
+static void dump_create_wait_set_request( const struct create_wait_set_request *req )
+{
+    fprintf( stderr, " access=%08x", req->access );
+}
+
+static void dump_create_wait_set_reply( const struct create_wait_set_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_set_wait_set_member_request( const struct set_wait_set_member_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", object=%04x", req->object );
+    dump_uint64( ", key=", &req->key );
+}
+
+static void dump_get_wait_set_events_request( const struct get_wait_set_events_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
+static void dump_get_wait_set_events_reply( const struct get_wait_set_events_reply *req )
+{
+    dump_varargs_uints64( " keys=", cur_size );
+}
+
 static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_new_process_request,
     (dump_func)dump_get_new_process_info_request,
@@ -4527,6 +4662,8 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_startup_info_request,
     (dump_func)dump_init_process_done_request,
     (dump_func)dump_init_thread_request,
+    (dump_func)dump_set_shm_request_area_request,
+    (dump_func)dump_batch_request,
     (dump_func)dump_terminate_process_request,
     (dump_func)dump_terminate_thread_request,
     (dump_func)dump_get_process_info_request,
@@ -4611,6 +4748,9 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_unmap_view_request,
     (dump_func)dump_get_mapping_committed_range_request,
     (dump_func)dump_add_mapping_committed_range_request,
+    (dump_func)dump_get_image_relocation_request,
+    (dump_func)dump_create_image_relocation_request,
+    (dump_func)dump_commit_image_relocation_request,
     (dump_func)dump_is_same_mapping_request,
     (dump_func)dump_create_snapshot_request,
     (dump_func)dump_next_process_request,
@@ -4631,6 +4771,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_enum_key_request,
     (dump_func)dump_set_key_value_request,
     (dump_func)dump_get_key_value_request,
+    (dump_func)dump_get_registry_generations_request,
     (dump_func)dump_enum_key_value_request,
     (dump_func)dump_delete_key_value_request,
     (dump_func)dump_load_registry_request,
@@ -4653,6 +4794,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_empty_atom_table_request,
     (dump_func)dump_init_atom_table_request,
     (dump_func)dump_get_msg_queue_request,
+    (dump_func)dump_get_queue_shared_memory_request,
     (dump_func)dump_set_queue_fd_request,
     (dump_func)dump_set_queue_mask_request,
     (dump_func)dump_get_queue_status_request,
@@ -4686,6 +4828,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_window_info_request,
     (dump_func)dump_set_window_info_request,
     (dump_func)dump_set_parent_request,
+    (dump_func)dump_get_shared_windows_request,
     (dump_func)dump_get_window_parents_request,
     (dump_func)dump_get_window_children_request,
     (dump_func)dump_get_window_children_from_point_request,
@@ -4790,6 +4933,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_request,
     (dump_func)dump_add_completion_request,
     (dump_func)dump_remove_completion_request,
+    (dump_func)dump_remove_completions_request,
     (dump_func)dump_query_completion_request,
     (dump_func)dump_set_completion_info_request,
     (dump_func)dump_add_fd_completion_request,
@@ -4810,6 +4954,9 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_job_limits_request,
     (dump_func)dump_set_job_completion_port_request,
     (dump_func)dump_terminate_job_request,
+    (dump_func)dump_create_wait_set_request,
+    (dump_func)dump_set_wait_set_member_request,
+    (dump_func)dump_get_wait_set_events_request,
 };
 
 static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
@@ -4819,6 +4966,8 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_startup_info_reply,
     (dump_func)dump_init_process_done_reply,
     (dump_func)dump_init_thread_reply,
+    NULL,
+    (dump_func)dump_batch_reply,
     (dump_func)dump_terminate_process_reply,
     (dump_func)dump_terminate_thread_reply,
     (dump_func)dump_get_process_info_reply,
@@ -4903,6 +5052,9 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_get_mapping_committed_range_reply,
     NULL,
+    (dump_func)dump_get_image_relocation_reply,
+    (dump_func)dump_create_image_relocation_reply,
+    NULL,
     NULL,
     (dump_func)dump_create_snapshot_reply,
     (dump_func)dump_next_process_reply,
@@ -4923,6 +5075,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_enum_key_reply,
     NULL,
     (dump_func)dump_get_key_value_reply,
+    (dump_func)dump_get_registry_generations_reply,
     (dump_func)dump_enum_key_value_reply,
     NULL,
     NULL,
@@ -4945,6 +5098,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     (dump_func)dump_init_atom_table_reply,
     (dump_func)dump_get_msg_queue_reply,
+    (dump_func)dump_get_queue_shared_memory_reply,
     NULL,
     (dump_func)dump_set_queue_mask_reply,
     (dump_func)dump_get_queue_status_reply,
@@ -4978,6 +5132,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_window_info_reply,
     (dump_func)dump_set_window_info_reply,
     (dump_func)dump_set_parent_reply,
+    (dump_func)dump_get_shared_windows_reply,
     (dump_func)dump_get_window_parents_reply,
     (dump_func)dump_get_window_children_reply,
     (dump_func)dump_get_window_children_from_point_reply,
@@ -5082,6 +5237,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_open_completion_reply,
     NULL,
     (dump_func)dump_remove_completion_reply,
+    (dump_func)dump_remove_completions_reply,
     (dump_func)dump_query_completion_reply,
     NULL,
     NULL,
@@ -5102,6 +5258,9 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     NULL,
     NULL,
     NULL,
+    (dump_func)dump_create_wait_set_reply,
+    NULL,
+    (dump_func)dump_get_wait_set_events_reply,
 };
 
 static const char * const req_names[REQ_NB_REQUESTS] = {
@@ -5111,6 +5270,8 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_startup_info",
     "init_process_done",
     "init_thread",
+    "set_shm_request_area",
+    "batch",
     "terminate_process",
     "terminate_thread",
     "get_process_info",
@@ -5195,6 +5356,9 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "unmap_view",
     "get_mapping_committed_range",
     "add_mapping_committed_range",
+    "get_image_relocation",
+    "create_image_relocation",
+    "commit_image_relocation",
     "is_same_mapping",
     "create_snapshot",
     "next_process",
@@ -5215,6 +5379,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "enum_key",
     "set_key_value",
     "get_key_value",
+    "get_registry_generations",
     "enum_key_value",
     "delete_key_value",
     "load_registry",
@@ -5237,6 +5402,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "empty_atom_table",
     "init_atom_table",
     "get_msg_queue",
+    "get_queue_shared_memory",
     "set_queue_fd",
     "set_queue_mask",
     "get_queue_status",
@@ -5270,6 +5436,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_window_info",
     "set_window_info",
     "set_parent",
+    "get_shared_windows",
     "get_window_parents",
     "get_window_children",
     "get_window_children_from_point",
@@ -5374,6 +5541,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "open_completion",
     "add_completion",
     "remove_completion",
+    "remove_completions",
     "query_completion",
     "set_completion_info",
     "add_fd_completion",
@@ -5394,6 +5562,9 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_job_limits",
     "set_job_completion_port",
     "terminate_job",
+    "create_wait_set",
+    "set_wait_set_member",
+    "get_wait_set_events",
 };
 
 static const struct
@@ -5470,6 +5641,7 @@ static const struct
     { "NAME_TOO_LONG",               STATUS_NAME_TOO_LONG },
     { "NETWORK_BUSY",                STATUS_NETWORK_BUSY },
     { "NETWORK_UNREACHABLE",         STATUS_NETWORK_UNREACHABLE },
+    { "NOTIFY_ENUM_DIR",             STATUS_NOTIFY_ENUM_DIR },
     { "NOT_ALL_ASSIGNED",            STATUS_NOT_ALL_ASSIGNED },
     { "NOT_A_DIRECTORY",             STATUS_NOT_A_DIRECTORY },
     { "NOT_FOUND",                   STATUS_NOT_FOUND },
@@ -5537,6 +5709,11 @@ static const char *get_status_name( unsigned int status )
     return buffer;
 }
 
+const char *get_request_name( enum request req )
+{
+    return req < REQ_NB_REQUESTS ? req_names[req] : "?";
+}
+
 void trace_request(void)
 {
     enum request req = current->req.request_header.req;
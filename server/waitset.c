@@ -0,0 +1,287 @@
+/*
+ * Server-side wait sets
+ *
+ * Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+/* A wait set is a collection of objects, each tagged with a client key,
+ * that a single thread can wait on with SELECT_WAIT_SET. The number of
+ * members is not limited to MAXIMUM_WAIT_OBJECTS. When the wait is
+ * satisfied, all the members that are signaled at that point are removed
+ * from the set and their keys are queued until the client retrieves them
+ * with get_wait_set_events.
+ *
+ * The thread wait structure is built from the member list when the wait
+ * starts, so any change of the membership wakes up the waiting thread,
+ * which is expected to start a new wait.
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ntstatus.h"
+#define WIN32_NO_STATUS
+#include "windef.h"
+#include "winternl.h"
+
+#include "handle.h"
+#include "thread.h"
+#include "request.h"
+
+struct wait_set_member
+{
+    struct object      *obj;          /* object to wait for */
+    client_ptr_t        key;          /* client key of the member */
+};
+
+struct wait_set
+{
+    struct object           obj;          /* object header */
+    struct wait_set_member *members;      /* members of the set */
+    unsigned int            count;        /* number of members */
+    unsigned int            size;         /* allocated size of the members array */
+    client_ptr_t           *events;       /* keys of the signaled members */
+    unsigned int            event_count;  /* number of pending events */
+    unsigned int            event_size;   /* allocated size of the events array */
+    int                     changed;      /* membership changed since the last wait started */
+};
+
+static void wait_set_dump( struct object *obj, int verbose );
+static int wait_set_signaled( struct object *obj, struct wait_queue_entry *entry );
+static void wait_set_destroy( struct object *obj );
+
+static const struct object_ops wait_set_ops =
+{
+    sizeof(struct wait_set),    /* size */
+    wait_set_dump,              /* dump */
+    no_get_type,                /* get_type */
+    add_queue,                  /* add_queue */
+    remove_queue,               /* remove_queue */
+    wait_set_signaled,          /* signaled */
+    no_satisfied,               /* satisfied */
+    no_signal,                  /* signal */
+    no_get_fd,                  /* get_fd */
+    no_map_access,              /* map_access */
+    default_get_sd,             /* get_sd */
+    default_set_sd,             /* set_sd */
+    no_lookup_name,             /* lookup_name */
+    no_link_name,               /* link_name */
+    NULL,                       /* unlink_name */
+    no_open_file,               /* open_file */
+    no_close_handle,            /* close_handle */
+    wait_set_destroy            /* destroy */
+};
+
+static void wait_set_dump( struct object *obj, int verbose )
+{
+    struct wait_set *set = (struct wait_set *)obj;
+
+    assert( obj->ops == &wait_set_ops );
+    fprintf( stderr, "Wait set members=%u events=%u changed=%d\n",
+             set->count, set->event_count, set->changed );
+}
+
+static int wait_set_signaled( struct object *obj, struct wait_queue_entry *entry )
+{
+    struct wait_set *set = (struct wait_set *)obj;
+
+    assert( obj->ops == &wait_set_ops );
+    return set->changed || set->event_count;
+}
+
+static void wait_set_destroy( struct object *obj )
+{
+    struct wait_set *set = (struct wait_set *)obj;
+    unsigned int i;
+
+    assert( obj->ops == &wait_set_ops );
+    for (i = 0; i < set->count; i++) release_object( set->members[i].obj );
+    free( set->members );
+    free( set->events );
+}
+
+static struct wait_set *get_wait_set_obj( struct process *process, obj_handle_t handle,
+                                          unsigned int access )
+{
+    return (struct wait_set *)get_handle_obj( process, handle, access, &wait_set_ops );
+}
+
+static void remove_wait_set_member( struct wait_set *set, unsigned int index )
+{
+    release_object( set->members[index].obj );
+    if (index != --set->count) set->members[index] = set->members[set->count];
+}
+
+static int add_wait_set_event( struct wait_set *set, client_ptr_t key )
+{
+    if (set->event_count == set->event_size)
+    {
+        unsigned int new_size = max( 16, set->event_size * 2 );
+        client_ptr_t *new_events = realloc( set->events, new_size * sizeof(*new_events) );
+
+        if (!new_events) return 0;
+        set->events = new_events;
+        set->event_size = new_size;
+    }
+    set->events[set->event_count++] = key;
+    return 1;
+}
+
+/* return the objects to wait for when starting a SELECT_WAIT_SET wait; the set itself comes first */
+struct object **get_wait_set_objects( struct process *process, obj_handle_t handle, unsigned int *count )
+{
+    struct wait_set *set;
+    struct object **objects;
+    unsigned int i;
+
+    if (!(set = get_wait_set_obj( process, handle, SYNCHRONIZE ))) return NULL;
+
+    /* don't bother with the members if there are pending events already */
+    *count = set->event_count ? 1 : set->count + 1;
+    if ((objects = mem_alloc( *count * sizeof(*objects) )))
+    {
+        objects[0] = &set->obj;
+        for (i = 1; i < *count; i++) objects[i] = set->members[i - 1].obj;
+        set->changed = 0;
+    }
+    release_object( set );
+    return objects;
+}
+
+/* collect the signaled members at the end of a SELECT_WAIT_SET wait */
+void wait_set_satisfied( struct wait_queue_entry *entries, unsigned int count )
+{
+    struct wait_set *set = (struct wait_set *)entries[0].obj;
+    unsigned int i;
+
+    assert( set->obj.ops == &wait_set_ops );
+
+    /* the entries no longer match the members, the client will start a new wait */
+    if (set->changed || count != set->count + 1) return;
+
+    /* walk backwards so that removing a member doesn't move the ones not checked yet */
+    for (i = count - 1; i > 0; i--)
+    {
+        struct wait_queue_entry *entry = entries + i;
+
+        assert( entry->obj == set->members[i - 1].obj );
+        if (!entry->obj->ops->signaled( entry->obj, entry )) continue;
+        if (!add_wait_set_event( set, set->members[i - 1].key )) break;
+        entry->obj->ops->satisfied( entry->obj, entry );
+        remove_wait_set_member( set, i - 1 );
+    }
+    set->changed = 0;
+}
+
+/* create a wait set */
+DECL_HANDLER(create_wait_set)
+{
+    struct wait_set *set;
+
+    if ((set = alloc_object( &wait_set_ops )))
+    {
+        set->members     = NULL;
+        set->count       = 0;
+        set->size        = 0;
+        set->events      = NULL;
+        set->event_count = 0;
+        set->event_size  = 0;
+        set->changed     = 0;
+        reply->handle = alloc_handle( current->process, set, req->access, 0 );
+        release_object( set );
+    }
+}
+
+/* add, replace or remove a member of a wait set */
+DECL_HANDLER(set_wait_set_member)
+{
+    struct wait_set *set;
+    struct object *obj = NULL;
+    unsigned int i;
+
+    if (!(set = get_wait_set_obj( current->process, req->handle, 0 ))) return;
+
+    if (req->object && !(obj = get_handle_obj( current->process, req->object, SYNCHRONIZE, NULL )))
+        goto done;
+
+    if (obj && set->count == set->size)
+    {
+        unsigned int new_size = max( 16, set->size * 2 );
+        struct wait_set_member *new_members = realloc( set->members, new_size * sizeof(*new_members) );
+
+        if (!new_members)
+        {
+            set_error( STATUS_NO_MEMORY );
+            release_object( obj );
+            goto done;
+        }
+        set->members = new_members;
+        set->size = new_size;
+    }
+
+    /* a key can only be used once, drop the previous member and its pending event */
+    for (i = 0; i < set->count; i++)
+    {
+        if (set->members[i].key != req->key) continue;
+        remove_wait_set_member( set, i );
+        break;
+    }
+    for (i = 0; i < set->event_count; i++)
+    {
+        if (set->events[i] != req->key) continue;
+        memmove( set->events + i, set->events + i + 1, (set->event_count - i - 1) * sizeof(*set->events) );
+        set->event_count--;
+        break;
+    }
+
+    if (obj)
+    {
+        set->members[set->count].obj = obj;
+        set->members[set->count].key = req->key;
+        set->count++;
+    }
+
+    set->changed = 1;
+    wake_up( &set->obj, 0 );
+
+done:
+    release_object( set );
+}
+
+/* retrieve the keys of the wait set members that have been signaled */
+DECL_HANDLER(get_wait_set_events)
+{
+    struct wait_set *set;
+    unsigned int count;
+
+    if (!(set = get_wait_set_obj( current->process, req->handle, 0 ))) return;
+
+    count = min( set->event_count, get_reply_max_size() / sizeof(*set->events) );
+    if (count)
+    {
+        set_reply_data( set->events, count * sizeof(*set->events) );
+        set->event_count -= count;
+        memmove( set->events, set->events + count, set->event_count * sizeof(*set->events) );
+    }
+    release_object( set );
+}
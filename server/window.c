@@ -23,6 +23,10 @@
 
 #include <assert.h>
 #include <stdarg.h>
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
+#include <unistd.h>
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -33,6 +37,8 @@
 #include "winternl.h"
 
 #include "object.h"
+#include "file.h"
+#include "handle.h"
 #include "request.h"
 #include "thread.h"
 #include "process.h"
@@ -138,6 +144,52 @@ static inline int is_desktop_window( const struct window *win )
     return !win->parent;  /* only desktop windows have no parent */
 }
 
+/* window information shared with the clients, indexed like the user handles */
+static struct shared_window_info *shared_windows;
+static struct file *shared_windows_file;
+
+static inline struct shared_window_info *get_shared_window_info( user_handle_t handle )
+{
+    return &shared_windows[((handle & 0xffff) - FIRST_USER_HANDLE) >> 1];
+}
+
+/* publish the current state of a window to the clients */
+static void update_shared_window( const struct window *win )
+{
+    struct shared_window_info *info;
+
+    if (!shared_windows) return;
+    info = get_shared_window_info( win->handle );
+    info->seq++;
+    __sync_synchronize();
+    info->handle      = win->handle;
+    info->parent      = win->parent ? win->parent->handle : 0;
+    info->owner       = win->owner;
+    info->style       = win->style;
+    info->ex_style    = win->ex_style;
+    info->id          = win->id;
+    info->instance    = win->instance;
+    info->user_data   = win->user_data;
+    info->window_rect = win->window_rect;
+    info->client_rect = win->client_rect;
+    __sync_synchronize();
+    info->seq++;
+}
+
+/* remove a destroyed window from the shared information */
+static void clear_shared_window( const struct window *win )
+{
+    struct shared_window_info *info;
+
+    if (!shared_windows) return;
+    info = get_shared_window_info( win->handle );
+    info->seq++;
+    __sync_synchronize();
+    info->handle = 0;
+    __sync_synchronize();
+    info->seq++;
+}
+
 /* get next window in Z-order list */
 static inline struct window *get_next_window( struct window *win )
 {
@@ -263,6 +315,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
     }
+    update_shared_window( win );
     return 1;
 }
 
@@ -496,6 +549,7 @@ static struct window *create_window( struct window *parent, struct window *owner
     memset( win->extra_bytes, 0, extra_bytes );
     list_init( &win->children );
     list_init( &win->unlinked );
+    update_shared_window( win );
 
     /* if parent belongs to a different thread and the window isn't */
     /* top-level, attach the two threads */
@@ -1670,8 +1724,10 @@ static void set_window_pos( struct window *win, struct window *previous,
             offset_rect( &child->window_rect, new_size - old_size, 0 );
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            update_shared_window( child );
         }
     }
+    update_shared_window( win );
 
     /* reset cursor clip rectangle when the desktop changes size */
     if (win == win->desktop->top_window) win->desktop->cursor.clip = *window_rect;
@@ -1856,6 +1912,7 @@ void destroy_window( struct window *win )
     if (win == taskman_window) taskman_window = NULL;
     free_hotkeys( win->desktop, win->handle );
     cleanup_clipboard_window( win->desktop, win->handle );
+    clear_shared_window( win );
     free_user_handle( win->handle );
     destroy_properties( win );
     list_remove( &win->entry );
@@ -1967,6 +2024,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shared_window( desktop->top_window );
         }
     }
 
@@ -1979,6 +2037,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shared_window( desktop->msg_window );
         }
     }
 
@@ -2014,6 +2073,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_shared_window( win );
 }
 
 
@@ -2089,6 +2149,7 @@ DECL_HANDLER(set_window_info)
 
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
+    if (req->flags) update_shared_window( win );
 }
 
 
@@ -2841,3 +2902,34 @@ DECL_HANDLER(set_window_layered_info)
     }
     else set_win32_error( ERROR_INVALID_WINDOW_HANDLE );
 }
+
+
+/* get the shared area of the window information */
+DECL_HANDLER(get_shared_windows)
+{
+    size_t size = SHARED_WINDOW_SLOTS * sizeof(*shared_windows);
+    struct window *win;
+    user_handle_t handle = 0;
+    void *ptr;
+    int unix_fd;
+
+    if (!shared_windows_file)
+    {
+        if ((unix_fd = create_temp_file( size )) == -1) return;
+        if ((ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, unix_fd, 0 )) == MAP_FAILED)
+        {
+            file_set_error();
+            close( unix_fd );
+            return;
+        }
+        if (!(shared_windows_file = create_file_for_fd( unix_fd, FILE_GENERIC_READ, 0 )))
+        {
+            munmap( ptr, size );
+            return;
+        }
+        make_object_static( (struct object *)shared_windows_file );
+        shared_windows = ptr;
+        while ((win = next_user_handle( &handle, USER_WINDOW ))) update_shared_window( win );
+    }
+    reply->file = alloc_handle( current->process, shared_windows_file, GENERIC_READ, 0 );
+}
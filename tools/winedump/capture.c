@@ -0,0 +1,159 @@
+/*
+ *  Dump a wineserver request capture
+ *
+ *  Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+#include "winedump.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "windef.h"
+#include "winbase.h"
+#include "wine/servercapture.h"
+
+struct request_stats
+{
+    unsigned int  req;
+    unsigned int  count;
+    unsigned int  errors;
+    ULONGLONG     total;
+    ULONGLONG    *durations;
+};
+
+static int cmp_duration( const void *p1, const void *p2 )
+{
+    const ULONGLONG *d1 = p1, *d2 = p2;
+    if (*d1 < *d2) return -1;
+    if (*d1 > *d2) return 1;
+    return 0;
+}
+
+static int cmp_total( const void *p1, const void *p2 )
+{
+    const struct request_stats *s1 = p1, *s2 = p2;
+    if (s1->total > s2->total) return -1;
+    if (s1->total < s2->total) return 1;
+    return 0;
+}
+
+/* durations are in 100ns units, print them in microseconds */
+static void print_usec( ULONGLONG duration )
+{
+    printf( " %10u.%u", (unsigned int)(duration / 10), (unsigned int)(duration % 10) );
+}
+
+enum FileSig get_kind_capture(void)
+{
+    const struct server_capture_header *header = PRD(0, sizeof(*header));
+
+    if (header && header->magic == SERVER_CAPTURE_MAGIC && header->version == SERVER_CAPTURE_VERSION &&
+        PRD(sizeof(*header), header->names_size))
+        return SIG_CAPTURE;
+    return SIG_UNKNOWN;
+}
+
+void capture_dump(void)
+{
+    const struct server_capture_header *header = PRD(0, sizeof(*header));
+    const char *names = PRD(sizeof(*header), header->names_size);
+    const char **req_names;
+    const struct server_capture_record *rec;
+    struct request_stats *stats;
+    unsigned int i, pos, total_count = 0;
+    ULONGLONG total_time = 0, last_time = 0;
+
+    if (!(req_names = calloc( header->nb_requests, sizeof(*req_names) ))) fatal( "Out of memory" );
+    if (!(stats = calloc( header->nb_requests, sizeof(*stats) ))) fatal( "Out of memory" );
+    for (i = 0, pos = 0; i < header->nb_requests && pos < header->names_size; i++)
+    {
+        req_names[i] = names + pos;
+        pos += strlen( names + pos ) + 1;
+    }
+    for (i = 0; i < header->nb_requests; i++) stats[i].req = i;
+
+    printf( "Wineserver request capture, protocol version %u\n\n", header->protocol );
+    if (globals.do_dump_rawdata)
+        printf( "%10s %4s %4s %-28s%13s   %s\n", "time", "pid", "tid", "request", "usec", "status" );
+
+    for (pos = sizeof(*header) + header->names_size; (rec = PRD(pos, sizeof(*rec))); pos += rec->size)
+    {
+        struct request_stats *s;
+
+        if (rec->size < sizeof(*rec) || !PRD(pos, rec->size))
+        {
+            printf( "\nCorrupted record at offset %u\n", pos );
+            break;
+        }
+        if (rec->req >= header->nb_requests)
+        {
+            printf( "\nUnknown request %u at offset %u\n", rec->req, pos );
+            break;
+        }
+        if (globals.do_dump_rawdata)
+        {
+            printf( "%3u.%06u %04x %04x %-28s", (unsigned int)(rec->time / 10000000),
+                    (unsigned int)(rec->time % 10000000) / 10, rec->pid, rec->tid,
+                    req_names[rec->req] ? req_names[rec->req] : "?" );
+            print_usec( rec->duration );
+            printf( "   %08x\n", rec->error );
+        }
+
+        s = &stats[rec->req];
+        if (!(s->count % 1024) &&
+            !(s->durations = realloc( s->durations, (s->count + 1024) * sizeof(*s->durations) )))
+            fatal( "Out of memory" );
+        s->durations[s->count++] = rec->duration;
+        s->total += rec->duration;
+        if (rec->error) s->errors++;
+        total_count++;
+        total_time += rec->duration;
+        if (rec->time + rec->duration > last_time) last_time = rec->time + rec->duration;
+    }
+
+    qsort( stats, header->nb_requests, sizeof(*stats), cmp_total );
+    printf( "\n%-28s   count  errors  total ms     avg usec     p50 usec     p99 usec     max usec\n",
+            "request" );
+    for (i = 0; i < header->nb_requests && stats[i].count; i++)
+    {
+        struct request_stats *s = &stats[i];
+
+        qsort( s->durations, s->count, sizeof(*s->durations), cmp_duration );
+        printf( "%-28s %7u %7u %9u", req_names[s->req] ? req_names[s->req] : "?",
+                s->count, s->errors, (unsigned int)(s->total / 10000) );
+        print_usec( s->total / s->count );
+        print_usec( s->durations[s->count / 2] );
+        print_usec( s->durations[(ULONGLONG)s->count * 99 / 100] );
+        print_usec( s->durations[s->count - 1] );
+        printf( "\n" );
+        free( s->durations );
+    }
+
+    printf( "\n%u requests in %u.%03u seconds, %u.%03u seconds in handlers",
+            total_count, (unsigned int)(last_time / 10000000), (unsigned int)(last_time % 10000000) / 10000,
+            (unsigned int)(total_time / 10000000), (unsigned int)(total_time % 10000000) / 10000 );
+    if (last_time) printf( ", %u requests per second", (unsigned int)(total_count * 10000000ULL / last_time) );
+    printf( "\n" );
+
+    free( stats );
+    free( req_names );
+}
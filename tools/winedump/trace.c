@@ -0,0 +1,357 @@
+/*
+ *  Dump a binary debug trace buffer
+ *
+ *  Copyright 2018 the Wine project authors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+#include "winedump.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+#include "windef.h"
+#include "winbase.h"
+#include "wine/debugtrace.h"
+
+struct string_entry
+{
+    ULONGLONG    addr;
+    const char  *str;
+    unsigned int len;
+};
+
+static struct string_entry *strings;
+static unsigned int nb_strings;
+static char *strings_data;
+
+static int cmp_string_entry( const void *p1, const void *p2 )
+{
+    const struct string_entry *e1 = p1, *e2 = p2;
+    if (e1->addr < e2->addr) return -1;
+    if (e1->addr > e2->addr) return 1;
+    return 0;
+}
+
+/* load the string file written by the traced process */
+static void load_strings( unsigned int unix_pid )
+{
+    const struct trace_string *entry;
+    const char *p;
+    char *name;
+    FILE *f;
+    long size, pos;
+
+    if (!(name = malloc( strlen(globals.input_name) + 32 ))) fatal( "Out of memory" );
+    strcpy( name, globals.input_name );
+    if ((p = strrchr( name, '/' ))) sprintf( name + (p + 1 - name), "wine-%u.str", unix_pid );
+    else sprintf( name, "wine-%u.str", unix_pid );
+
+    if (!(f = fopen( name, "rb" )))
+    {
+        printf( "Cannot open string file %s, messages will not be decoded\n", name );
+        free( name );
+        return;
+    }
+    free( name );
+    fseek( f, 0, SEEK_END );
+    size = ftell( f );
+    fseek( f, 0, SEEK_SET );
+    if (!(strings_data = malloc( size ))) fatal( "Out of memory" );
+    size = fread( strings_data, 1, size, f );
+    fclose( f );
+
+    for (pos = 0; pos + (long)sizeof(*entry) <= size; pos += sizeof(*entry) + entry->len)
+    {
+        entry = (const struct trace_string *)(strings_data + pos);
+        if (pos + (long)sizeof(*entry) + (long)entry->len > size) break;
+        if (!(nb_strings % 256) &&
+            !(strings = realloc( strings, (nb_strings + 256) * sizeof(*strings) )))
+            fatal( "Out of memory" );
+        strings[nb_strings].addr = entry->addr;
+        strings[nb_strings].str  = (const char *)(entry + 1);
+        strings[nb_strings].len  = entry->len;
+        nb_strings++;
+    }
+    qsort( strings, nb_strings, sizeof(*strings), cmp_string_entry );
+}
+
+static const char *get_string( ULONGLONG addr, unsigned int *len )
+{
+    struct string_entry key, *entry;
+
+    key.addr = addr;
+    if (!nb_strings || !(entry = bsearch( &key, strings, nb_strings, sizeof(*strings), cmp_string_entry )))
+        return NULL;
+    *len = entry->len;
+    return entry->str;
+}
+
+static BOOL get_arg( const unsigned char **args, const unsigned char *end, ULONGLONG *val )
+{
+    if (end - *args < 1 + (int)sizeof(*val) || **args == 's') return FALSE;
+    memcpy( val, *args + 1, sizeof(*val) );
+    *args += 1 + sizeof(*val);
+    return TRUE;
+}
+
+static BOOL get_str_arg( const unsigned char **args, const unsigned char *end, char *buffer )
+{
+    unsigned short len;
+
+    if (end - *args < 1 + (int)sizeof(len) || **args != 's') return FALSE;
+    memcpy( &len, *args + 1, sizeof(len) );
+    if (len > TRACE_MAX_STRING || end - *args < 1 + (int)sizeof(len) + len) return FALSE;
+    memcpy( buffer, *args + 1 + sizeof(len), len );
+    buffer[len] = 0;
+    *args += 1 + sizeof(len) + len;
+    return TRUE;
+}
+
+/* format a message again from its format string and stored arguments */
+static void print_message( const char *format, unsigned int format_len,
+                           const unsigned char *args, const unsigned char *end )
+{
+    const char *p = format, *format_end = format + format_len, *start;
+    char spec[64], str[TRACE_MAX_STRING + 1];
+    ULONGLONG val;
+    double dbl;
+    int len;
+
+    while (p < format_end)
+    {
+        if (*p != '%')
+        {
+            putchar( *p++ );
+            continue;
+        }
+        if (p + 1 < format_end && p[1] == '%')
+        {
+            putchar( '%' );
+            p += 2;
+            continue;
+        }
+
+        start = p++;
+        len = 0;
+        spec[len++] = '%';
+        while (p < format_end && strchr( "-+ #0'", *p ) && len < 8) spec[len++] = *p++;
+        if (p < format_end && *p == '*')
+        {
+            if (!get_arg( &args, end, &val )) goto missing;
+            len += sprintf( spec + len, "%d", (int)val );
+            p++;
+        }
+        else while (p < format_end && isdigit( *p ) && len < 16) spec[len++] = *p++;
+        if (p < format_end && *p == '.')
+        {
+            spec[len++] = *p++;
+            if (p < format_end && *p == '*')
+            {
+                if (!get_arg( &args, end, &val )) goto missing;
+                len += sprintf( spec + len, "%d", (int)val );
+                p++;
+            }
+            else while (p < format_end && isdigit( *p ) && len < 40) spec[len++] = *p++;
+        }
+        /* skip the length modifiers, all values are stored as 64-bit */
+        while (p < format_end && strchr( "hlLqjzt", *p )) p++;
+        if (p < format_end && *p == 'I')
+        {
+            p++;
+            while (p < format_end && isdigit( *p )) p++;
+        }
+        if (p >= format_end) goto missing;
+
+        switch (*p)
+        {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            if (!get_arg( &args, end, &val )) goto missing;
+            spec[len++] = 'l';
+            spec[len++] = 'l';
+            spec[len++] = *p;
+            spec[len] = 0;
+            printf( spec, val );
+            break;
+        case 'c':
+            if (!get_arg( &args, end, &val )) goto missing;
+            spec[len++] = 'c';
+            spec[len] = 0;
+            printf( spec, (int)val );
+            break;
+        case 'p':
+            if (!get_arg( &args, end, &val )) goto missing;
+            if (val >> 32) printf( "0x%x%08x", (unsigned int)(val >> 32), (unsigned int)val );
+            else if (val) printf( "%#x", (unsigned int)val );
+            else printf( "(nil)" );
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (!get_arg( &args, end, &val )) goto missing;
+            memcpy( &dbl, &val, sizeof(dbl) );
+            spec[len++] = *p;
+            spec[len] = 0;
+            printf( spec, dbl );
+            break;
+        case 's':
+            if (!get_str_arg( &args, end, str )) goto missing;
+            spec[len++] = 's';
+            spec[len] = 0;
+            printf( spec, str );
+            break;
+        case 'n':
+            break;
+        default:
+            goto missing;
+        }
+        p++;
+    }
+    return;
+
+missing:
+    /* print the rest of the format string as is */
+    printf( "%.*s", (int)(format_end - start), start );
+}
+
+/* print an ETW event record, the user data is dumped in hex */
+static void print_event( const struct trace_event *event, const unsigned char *end )
+{
+    const unsigned char *data = (const unsigned char *)(event + 1);
+    unsigned int i, size = event->data_size;
+
+    if (size > end - data) size = end - data;
+    printf( "event:{%08x-%04x-%04x-%02x%02x-%02x%02x%02x%02x%02x%02x} id %u ver %u level %u opcode %u "
+            "task %u keyword 0x%x%08x", event->provider.Data1, event->provider.Data2, event->provider.Data3,
+            event->provider.Data4[0], event->provider.Data4[1], event->provider.Data4[2],
+            event->provider.Data4[3], event->provider.Data4[4], event->provider.Data4[5],
+            event->provider.Data4[6], event->provider.Data4[7], event->id, event->version,
+            event->level, event->opcode, event->task, (unsigned int)(event->keyword >> 32),
+            (unsigned int)event->keyword );
+    if (event->activity.Data1 || event->activity.Data2 || event->activity.Data3)
+        printf( " activity %08x-%04x-%04x", event->activity.Data1, event->activity.Data2,
+                event->activity.Data3 );
+    printf( " size %u:", event->data_size );
+    for (i = 0; i < size; i++)
+    {
+        if (!globals.do_dump_rawdata && i == 64)
+        {
+            printf( " ..." );
+            break;
+        }
+        printf( " %02x", data[i] );
+    }
+    printf( "\n" );
+}
+
+enum FileSig get_kind_trace(void)
+{
+    const struct trace_ring_header *ring = PRD(0, sizeof(*ring));
+
+    if (ring && ring->magic == TRACE_RING_MAGIC && ring->version == TRACE_VERSION &&
+        PRD(sizeof(*ring), ring->size))
+        return SIG_TRACE;
+    return SIG_UNKNOWN;
+}
+
+void trace_dump(void)
+{
+    static const char * const classes[] = { "fixme", "err", "warn", "trace" };
+    const struct trace_ring_header *ring = PRD(0, sizeof(*ring));
+    const char *data = PRD(sizeof(*ring), ring->size);
+    const char *channel, *function, *format;
+    unsigned int channel_len, function_len, format_len;
+    ULONGLONG pos;
+
+    printf( "Trace buffer of process %04x thread %04x (unix pid %u)\n\n",
+            ring->pid, ring->tid, ring->unix_pid );
+    load_strings( ring->unix_pid );
+
+    for (pos = ring->tail; pos < ring->head; )
+    {
+        unsigned int offset = pos % ring->size;
+        const struct trace_record *rec = (const struct trace_record *)(data + offset);
+        const unsigned char *args = (const unsigned char *)(rec + 1);
+
+        if (ring->size - offset < sizeof(*rec) || !rec->size)  /* end of ring marker */
+        {
+            pos += ring->size - offset;
+            continue;
+        }
+        if (rec->size < sizeof(*rec) || rec->size > ring->size - offset)
+        {
+            printf( "\nCorrupted record at offset %u\n", offset );
+            break;
+        }
+
+        if (rec->cls == TRACE_CLASS_EVENT)
+        {
+            if (rec->size >= sizeof(*rec) + sizeof(struct trace_event))
+            {
+                printf( "%3u.%06u:%04x:", (unsigned int)(rec->time / 10000000),
+                        (unsigned int)(rec->time % 10000000) / 10, ring->tid );
+                print_event( (const struct trace_event *)args, (const unsigned char *)rec + rec->size );
+            }
+            pos += rec->size;
+            continue;
+        }
+        if (rec->cls != TRACE_CLASS_CONT)
+        {
+            printf( "%3u.%06u:%04x:", (unsigned int)(rec->time / 10000000),
+                    (unsigned int)(rec->time % 10000000) / 10, ring->tid );
+            if (!(rec->flags & TRACE_FLAG_NO_PREFIX))
+            {
+                if (!(channel = get_string( rec->channel, &channel_len )))
+                {
+                    channel = "?";
+                    channel_len = 1;
+                }
+                if (!(function = get_string( rec->function, &function_len )))
+                {
+                    function = "?";
+                    function_len = 1;
+                }
+                printf( "%s:%.*s:%.*s ", rec->cls < sizeof(classes)/sizeof(classes[0]) ? classes[rec->cls] : "?",
+                        channel_len, channel, function_len, function );
+            }
+        }
+        if (rec->format)
+        {
+            if ((format = get_string( rec->format, &format_len )))
+                print_message( format, format_len, args, (const unsigned char *)rec + rec->size );
+            else
+                printf( "<unknown format 0x%x%08x>\n", (unsigned int)(rec->format >> 32),
+                        (unsigned int)rec->format );
+        }
+        if (rec->flags & TRACE_FLAG_TRUNCATED) printf( " <truncated>" );
+        pos += rec->size;
+    }
+}